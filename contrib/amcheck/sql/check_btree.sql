@@ -77,6 +77,26 @@ TRUNCATE bttest_multi;
 INSERT INTO bttest_multi SELECT i, i%2  FROM generate_series(1, 100000) as i;
 SELECT bt_index_parent_check('bttest_multi_idx', true);
 
+--
+-- Test for suffix truncated pivot tuples, in an index built by CREATE INDEX
+-- and in an index built using insertions
+--
+CREATE TABLE bttest_trunc (a int4, b text);
+INSERT INTO bttest_trunc SELECT i / 10, repeat('x', 200) || i FROM generate_series(1, 20000) i;
+CREATE INDEX bttest_trunc_idx ON bttest_trunc (a, b);
+SELECT bt_index_parent_check('bttest_trunc_idx', true);
+TRUNCATE bttest_trunc;
+INSERT INTO bttest_trunc SELECT i / 10, repeat('x', 200) || i FROM generate_series(1, 20000) i;
+SELECT bt_index_parent_check('bttest_trunc_idx', true);
+
+-- Same again, with the heap scan performed by parallel workers
+SET max_parallel_maintenance_workers = 2;
+SET min_parallel_table_scan_size = 0;
+SELECT bt_index_check('bttest_trunc_idx', true);
+SELECT bt_index_parent_check('bttest_trunc_idx', true);
+RESET max_parallel_maintenance_workers;
+RESET min_parallel_table_scan_size;
+
 --
 -- Test for multilevel page deletion/downlink present checks
 --
@@ -92,6 +112,7 @@ SELECT bt_index_parent_check('delete_test_table_pkey', true);
 DROP TABLE bttest_a;
 DROP TABLE bttest_b;
 DROP TABLE bttest_multi;
+DROP TABLE bttest_trunc;
 DROP TABLE delete_test_table;
 DROP OWNED BY bttest_role; -- permissions
 DROP ROLE bttest_role;
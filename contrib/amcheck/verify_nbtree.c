@@ -25,6 +25,8 @@
 
 #include "access/htup_details.h"
 #include "access/nbtree.h"
+#include "access/parallel.h"
+#include "access/relscan.h"
 #include "access/transam.h"
 #include "access/xact.h"
 #include "catalog/index.h"
@@ -32,7 +34,9 @@
 #include "commands/tablecmds.h"
 #include "lib/bloomfilter.h"
 #include "miscadmin.h"
+#include "optimizer/planner.h"
 #include "storage/lmgr.h"
+#include "storage/spin.h"
 #include "utils/memutils.h"
 #include "utils/snapmgr.h"
 
@@ -45,6 +49,10 @@ PG_MODULE_MAGIC;
  */
 #define InvalidBtreeLevel	((uint32) InvalidBlockNumber)
 
+/* Magic numbers for parallel heapallindexed state sharing */
+#define PARALLEL_KEY_BTREE_CHECK_SHARED		UINT64CONST(0xA000000000000001)
+#define PARALLEL_KEY_BLOOM_FILTER			UINT64CONST(0xA000000000000002)
+
 /*
  * State associated with verifying a B-Tree index
  *
@@ -114,9 +122,44 @@ typedef struct BtreeLevel
 	bool		istruerootlevel;
 } BtreeLevel;
 
+/*
+ * Status for parallel heapallindexed verification, in shared memory
+ *
+ * The leader fingerprints the index, then copies the finished Bloom filter
+ * into shared memory.  The leader and workers then probe it in parallel,
+ * each taking a share of the blocks from a parallel heap scan.
+ */
+typedef struct BtreeCheckShared
+{
+	/*
+	 * These fields are not modified during the scan.  They primarily exist
+	 * for the benefit of worker processes that need to open relations.
+	 */
+	Oid			heaprelid;
+	Oid			indexrelid;
+	bool		readonly;
+
+	/*
+	 * mutex protects heaptuplespresent, which participants add to when they
+	 * are done.
+	 */
+	slock_t		mutex;
+	int64		heaptuplespresent;
+
+	/*
+	 * This variable-sized field must come last.
+	 *
+	 * See _bt_parallel_estimate_shared() in nbtsort.c.
+	 */
+	ParallelHeapScanDescData heapdesc;
+} BtreeCheckShared;
+
 PG_FUNCTION_INFO_V1(bt_index_check);
 PG_FUNCTION_INFO_V1(bt_index_parent_check);
 
+extern PGDLLEXPORT void bt_parallel_heap_check_main(dsm_segment *seg,
+							shm_toc *toc);
+
 static void bt_index_check_internal(Oid indrelid, bool parentcheck,
 						bool heapallindexed);
 static inline void btree_index_checkable(Relation rel);
@@ -125,24 +168,28 @@ static void bt_check_every_level(Relation rel, Relation heaprel,
 static BtreeLevel bt_check_level_from_leftmost(BtreeCheckState *state,
 							 BtreeLevel level);
 static void bt_target_page_check(BtreeCheckState *state);
-static ScanKey bt_right_page_check_scankey(BtreeCheckState *state);
+static ScanKey bt_right_page_check_scankey(BtreeCheckState *state,
+							int *keysz);
 static void bt_downlink_check(BtreeCheckState *state, BlockNumber childblock,
-				  ScanKey targetkey);
+				  ScanKey targetkey, int targetkeysz);
 static void bt_downlink_missing_check(BtreeCheckState *state);
+static void bt_heap_check(BtreeCheckState *state, HeapScanDesc scan);
+static bool bt_parallel_heap_check(BtreeCheckState *state, Snapshot snapshot);
 static void bt_tuple_present_callback(Relation index, HeapTuple htup,
 						  Datum *values, bool *isnull,
 						  bool tupleIsAlive, void *checkstate);
 static inline bool offset_is_negative_infinity(BTPageOpaque opaque,
 							OffsetNumber offset);
+static inline int scankey_natts(BtreeCheckState *state, IndexTuple itup);
 static inline bool invariant_leq_offset(BtreeCheckState *state,
-					 ScanKey key,
+					 ScanKey key, int keysz,
 					 OffsetNumber upperbound);
 static inline bool invariant_geq_offset(BtreeCheckState *state,
-					 ScanKey key,
+					 ScanKey key, int keysz,
 					 OffsetNumber lowerbound);
 static inline bool invariant_leq_nontarget_offset(BtreeCheckState *state,
 							   Page other,
-							   ScanKey key,
+							   ScanKey key, int keysz,
 							   OffsetNumber upperbound);
 static Page palloc_btree_page(BtreeCheckState *state, BlockNumber blocknum);
 
@@ -477,9 +524,6 @@ bt_check_every_level(Relation rel, Relation heaprel, bool readonly,
 	 */
 	if (state->heapallindexed)
 	{
-		IndexInfo  *indexinfo = BuildIndexInfo(state->rel);
-		HeapScanDesc scan;
-
 		/* Report on extra downlink checks performed in readonly case */
 		if (state->readonly)
 		{
@@ -490,49 +534,31 @@ bt_check_every_level(Relation rel, Relation heaprel, bool readonly,
 			bloom_free(state->downlinkfilter);
 		}
 
-		/*
-		 * Create our own scan for IndexBuildHeapScan(), rather than getting
-		 * it to do so for us.  This is required so that we can actually use
-		 * the MVCC snapshot registered earlier in !readonly case.
-		 *
-		 * Note that IndexBuildHeapScan() calls heap_endscan() for us.
-		 */
-		scan = heap_beginscan_strat(state->heaprel, /* relation */
-									snapshot,	/* snapshot */
-									0,	/* number of keys */
-									NULL,	/* scan key */
-									true,	/* buffer access strategy OK */
-									true);	/* syncscan OK? */
-
-		/*
-		 * Scan will behave as the first scan of a CREATE INDEX CONCURRENTLY
-		 * behaves in !readonly case.
-		 *
-		 * It's okay that we don't actually use the same lock strength for the
-		 * heap relation as any other ii_Concurrent caller would in !readonly
-		 * case.  We have no reason to care about a concurrent VACUUM
-		 * operation, since there isn't going to be a second scan of the heap
-		 * that needs to be sure that there was no concurrent recycling of
-		 * TIDs.
-		 */
-		indexinfo->ii_Concurrent = !state->readonly;
-
-		/*
-		 * Don't wait for uncommitted tuple xact commit/abort when index is a
-		 * unique index on a catalog (or an index used by an exclusion
-		 * constraint).  This could otherwise happen in the readonly case.
-		 */
-		indexinfo->ii_Unique = false;
-		indexinfo->ii_ExclusionOps = NULL;
-		indexinfo->ii_ExclusionProcs = NULL;
-		indexinfo->ii_ExclusionStrats = NULL;
-
 		elog(DEBUG1, "verifying that tuples from index \"%s\" are present in \"%s\"",
 			 RelationGetRelationName(state->rel),
 			 RelationGetRelationName(state->heaprel));
 
-		IndexBuildHeapScan(state->heaprel, state->rel, indexinfo, true,
-						   bt_tuple_present_callback, (void *) state, scan);
+		if (!bt_parallel_heap_check(state, snapshot))
+		{
+			HeapScanDesc scan;
+
+			/*
+			 * Create our own scan for IndexBuildHeapScan(), rather than
+			 * getting it to do so for us.  This is required so that we can
+			 * actually use the MVCC snapshot registered earlier in !readonly
+			 * case.
+			 *
+			 * Note that IndexBuildHeapScan() calls heap_endscan() for us.
+			 */
+			scan = heap_beginscan_strat(state->heaprel, /* relation */
+										snapshot,	/* snapshot */
+										0,	/* number of keys */
+										NULL,	/* scan key */
+										true,	/* buffer access strategy OK */
+										true);	/* syncscan OK? */
+
+			bt_heap_check(state, scan);
+		}
 
 		ereport(DEBUG1,
 				(errmsg_internal("finished verifying presence of " INT64_FORMAT " tuples from table \"%s\" with bitset %.2f%% set",
@@ -549,6 +575,167 @@ bt_check_every_level(Relation rel, Relation heaprel, bool readonly,
 	MemoryContextDelete(state->targetcontext);
 }
 
+/*
+ * Probe the Bloom filter for every tuple that a fresh CREATE INDEX would
+ * index, using caller's heap scan (which may be a parallel scan).
+ */
+static void
+bt_heap_check(BtreeCheckState *state, HeapScanDesc scan)
+{
+	IndexInfo  *indexinfo = BuildIndexInfo(state->rel);
+
+	/*
+	 * Scan will behave as the first scan of a CREATE INDEX CONCURRENTLY
+	 * behaves in !readonly case.
+	 *
+	 * It's okay that we don't actually use the same lock strength for the
+	 * heap relation as any other ii_Concurrent caller would in !readonly
+	 * case.  We have no reason to care about a concurrent VACUUM operation,
+	 * since there isn't going to be a second scan of the heap that needs to
+	 * be sure that there was no concurrent recycling of TIDs.
+	 */
+	indexinfo->ii_Concurrent = !state->readonly;
+
+	/*
+	 * Don't wait for uncommitted tuple xact commit/abort when index is a
+	 * unique index on a catalog (or an index used by an exclusion
+	 * constraint).  This could otherwise happen in the readonly case.
+	 */
+	indexinfo->ii_Unique = false;
+	indexinfo->ii_ExclusionOps = NULL;
+	indexinfo->ii_ExclusionProcs = NULL;
+	indexinfo->ii_ExclusionStrats = NULL;
+
+	IndexBuildHeapScan(state->heaprel, state->rel, indexinfo, true,
+					   bt_tuple_present_callback, (void *) state, scan);
+}
+
+/*
+ * Perform the heapallindexed heap scan with parallel workers, if the planner
+ * thinks that's worthwhile (the same way as for a parallel CREATE INDEX).
+ *
+ * Returns false if no workers could be used, in which case caller must
+ * perform a serial scan instead.  The leader participates in the scan.
+ */
+static bool
+bt_parallel_heap_check(BtreeCheckState *state, Snapshot snapshot)
+{
+	ParallelContext *pcxt;
+	BtreeCheckShared *shared;
+	bloom_filter *sharedfilter;
+	Size		estshared;
+	Size		filtersize;
+	HeapScanDesc scan;
+	int			request;
+
+	/* Nested parallelism isn't possible */
+	if (IsInParallelMode())
+		return false;
+
+	request = plan_create_index_workers(RelationGetRelid(state->heaprel),
+										RelationGetRelid(state->rel));
+	if (request <= 0)
+		return false;
+
+	EnterParallelMode();
+	pcxt = CreateParallelContext("amcheck", "bt_parallel_heap_check_main",
+								 request, true);
+
+	/* Estimate space for shared state, then for Bloom filter copy */
+	if (!IsMVCCSnapshot(snapshot))
+	{
+		Assert(snapshot == SnapshotAny);
+		estshared = sizeof(BtreeCheckShared);
+	}
+	else
+		estshared = add_size(offsetof(BtreeCheckShared, heapdesc) +
+							 offsetof(ParallelHeapScanDescData, phs_snapshot_data),
+							 EstimateSnapshotSpace(snapshot));
+	shm_toc_estimate_chunk(&pcxt->estimator, estshared);
+	filtersize = bloom_total_size(state->filter);
+	shm_toc_estimate_chunk(&pcxt->estimator, filtersize);
+	shm_toc_estimate_keys(&pcxt->estimator, 2);
+
+	InitializeParallelDSM(pcxt);
+
+	shared = (BtreeCheckShared *) shm_toc_allocate(pcxt->toc, estshared);
+	shared->heaprelid = RelationGetRelid(state->heaprel);
+	shared->indexrelid = RelationGetRelid(state->rel);
+	shared->readonly = state->readonly;
+	SpinLockInit(&shared->mutex);
+	shared->heaptuplespresent = 0;
+	heap_parallelscan_initialize(&shared->heapdesc, state->heaprel, snapshot);
+
+	sharedfilter = (bloom_filter *) shm_toc_allocate(pcxt->toc, filtersize);
+	memcpy(sharedfilter, state->filter, filtersize);
+
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_BTREE_CHECK_SHARED, shared);
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_BLOOM_FILTER, sharedfilter);
+
+	LaunchParallelWorkers(pcxt);
+
+	/* If no workers were successfully launched, back out (do serial scan) */
+	if (pcxt->nworkers_launched == 0)
+	{
+		WaitForParallelWorkersToFinish(pcxt);
+		DestroyParallelContext(pcxt);
+		ExitParallelMode();
+		return false;
+	}
+
+	elog(DEBUG1, "using %d parallel workers to verify table \"%s\"",
+		 pcxt->nworkers_launched, RelationGetRelationName(state->heaprel));
+
+	/* Join heap scan ourselves */
+	scan = heap_beginscan_parallel(state->heaprel, &shared->heapdesc);
+	bt_heap_check(state, scan);
+
+	/* Wait for workers; any ERROR they raised is rethrown here */
+	WaitForParallelWorkersToFinish(pcxt);
+	state->heaptuplespresent += shared->heaptuplespresent;
+
+	DestroyParallelContext(pcxt);
+	ExitParallelMode();
+
+	return true;
+}
+
+/*
+ * Perform work within a launched parallel worker, for heapallindexed
+ * verification.
+ */
+void
+bt_parallel_heap_check_main(dsm_segment *seg, shm_toc *toc)
+{
+	BtreeCheckShared *shared;
+	BtreeCheckState *state;
+	LOCKMODE	lockmode;
+	HeapScanDesc scan;
+
+	shared = shm_toc_lookup(toc, PARALLEL_KEY_BTREE_CHECK_SHARED, false);
+
+	/* Open relations using the same lock mode as the leader */
+	lockmode = shared->readonly ? ShareLock : AccessShareLock;
+
+	state = palloc0(sizeof(BtreeCheckState));
+	state->heaprel = heap_open(shared->heaprelid, lockmode);
+	state->rel = index_open(shared->indexrelid, lockmode);
+	state->readonly = shared->readonly;
+	state->heapallindexed = true;
+	state->filter = shm_toc_lookup(toc, PARALLEL_KEY_BLOOM_FILTER, false);
+	state->heaptuplespresent = 0;
+
+	scan = heap_beginscan_parallel(state->heaprel, &shared->heapdesc);
+	bt_heap_check(state, scan);
+
+	SpinLockAcquire(&shared->mutex);
+	shared->heaptuplespresent += state->heaptuplespresent;
+	SpinLockRelease(&shared->mutex);
+
+	index_close(state->rel, lockmode);
+	heap_close(state->heaprel, lockmode);
+}
+
 /*
  * Given a left-most block at some level, move right, verifying each page
  * individually (with more verification across pages for "readonly"
@@ -835,6 +1022,7 @@ bt_target_page_check(BtreeCheckState *state)
 		ItemId		itemid;
 		IndexTuple	itup;
 		ScanKey		skey;
+		int			skeysz;
 		size_t		tupsize;
 
 		CHECK_FOR_INTERRUPTS();
@@ -904,10 +1092,34 @@ bt_target_page_check(BtreeCheckState *state)
 
 		/* Build insertion scankey for current page offset */
 		skey = _bt_mkscankey(state->rel, itup);
+		skeysz = scankey_natts(state, itup);
 
 		/* Fingerprint leaf page tuples (those that point to the heap) */
 		if (state->heapallindexed && P_ISLEAF(topaque) && !ItemIdIsDead(itemid))
-			bloom_add_element(state->filter, (unsigned char *) itup, tupsize);
+		{
+			if (BTreeTupleIsPosting(itup))
+			{
+				int			i;
+
+				/*
+				 * Fingerprint each heap TID of a posting list tuple as the
+				 * plain tuple it stands for
+				 */
+				for (i = 0; i < BTreeTupleGetNPosting(itup); i++)
+				{
+					IndexTuple	plain;
+
+					plain = _bt_form_posting(itup,
+											 BTreeTupleGetPostingN(itup, i), 1);
+					bloom_add_element(state->filter, (unsigned char *) plain,
+									  IndexTupleSize(plain));
+					pfree(plain);
+				}
+			}
+			else
+				bloom_add_element(state->filter, (unsigned char *) itup,
+								  tupsize);
+		}
 
 		/*
 		 * * High key check *
@@ -930,7 +1142,7 @@ bt_target_page_check(BtreeCheckState *state)
 		 * and probably not markedly more effective in practice.
 		 */
 		if (!P_RIGHTMOST(topaque) &&
-			!invariant_leq_offset(state, skey, P_HIKEY))
+			!invariant_leq_offset(state, skey, skeysz, P_HIKEY))
 		{
 			char	   *itid,
 					   *htid;
@@ -959,7 +1171,7 @@ bt_target_page_check(BtreeCheckState *state)
 		 * current item is less than or equal to next item (if any).
 		 */
 		if (OffsetNumberNext(offset) <= max &&
-			!invariant_leq_offset(state, skey,
+			!invariant_leq_offset(state, skey, skeysz,
 								  OffsetNumberNext(offset)))
 		{
 			char	   *itid,
@@ -1018,12 +1230,13 @@ bt_target_page_check(BtreeCheckState *state)
 		else if (offset == max)
 		{
 			ScanKey		rightkey;
+			int			rightkeysz;
 
 			/* Get item in next/right page */
-			rightkey = bt_right_page_check_scankey(state);
+			rightkey = bt_right_page_check_scankey(state, &rightkeysz);
 
 			if (rightkey &&
-				!invariant_geq_offset(state, rightkey, max))
+				!invariant_geq_offset(state, rightkey, rightkeysz, max))
 			{
 				/*
 				 * As explained at length in bt_right_page_check_scankey(),
@@ -1069,7 +1282,7 @@ bt_target_page_check(BtreeCheckState *state)
 		{
 			BlockNumber childblock = BTreeInnerTupleGetDownLink(itup);
 
-			bt_downlink_check(state, childblock, skey);
+			bt_downlink_check(state, childblock, skey, skeysz);
 		}
 	}
 
@@ -1095,12 +1308,18 @@ bt_target_page_check(BtreeCheckState *state)
  * with different parent page).  If no such valid item is available, return
  * NULL instead.
  *
+ * The number of key attributes that may be compared using the scankey is
+ * returned in *keysz, since the first item of an internal page may be a
+ * suffix truncated pivot tuple.
+ *
  * Note that !readonly callers must reverify that target page has not
  * been concurrently deleted.
  */
 static ScanKey
-bt_right_page_check_scankey(BtreeCheckState *state)
+bt_right_page_check_scankey(BtreeCheckState *state, int *keysz)
 {
+	IndexTuple	firstitup;
+
 	BTPageOpaque opaque;
 	ItemId		rightitem;
 	BlockNumber targetnext;
@@ -1290,8 +1509,9 @@ bt_right_page_check_scankey(BtreeCheckState *state)
 	 * Return first real item scankey.  Note that this relies on right page
 	 * memory remaining allocated.
 	 */
-	return _bt_mkscankey(state->rel,
-						 (IndexTuple) PageGetItem(rightpage, rightitem));
+	firstitup = (IndexTuple) PageGetItem(rightpage, rightitem);
+	*keysz = scankey_natts(state, firstitup);
+	return _bt_mkscankey(state->rel, firstitup);
 }
 
 /*
@@ -1305,7 +1525,7 @@ bt_right_page_check_scankey(BtreeCheckState *state)
  */
 static void
 bt_downlink_check(BtreeCheckState *state, BlockNumber childblock,
-				  ScanKey targetkey)
+				  ScanKey targetkey, int targetkeysz)
 {
 	OffsetNumber offset;
 	OffsetNumber maxoffset;
@@ -1411,7 +1631,7 @@ bt_downlink_check(BtreeCheckState *state, BlockNumber childblock,
 			continue;
 
 		if (!invariant_leq_nontarget_offset(state, child,
-											targetkey, offset))
+											targetkey, targetkeysz, offset))
 			ereport(ERROR,
 					(errcode(ERRCODE_INDEX_CORRUPTED),
 					 errmsg("down-link lower bound invariant violated for index \"%s\"",
@@ -1751,6 +1971,20 @@ offset_is_negative_infinity(BTPageOpaque opaque, OffsetNumber offset)
 	return !P_ISLEAF(opaque) && offset == P_FIRSTDATAKEY(opaque);
 }
 
+/*
+ * How many key attributes can be compared using a scankey built from itup?
+ *
+ * Pivot tuples may have had trailing key attributes removed by suffix
+ * truncation.  Only the remaining attributes are compared, which makes the
+ * invariants below slightly weaker for such scankeys, but never wrong.
+ */
+static inline int
+scankey_natts(BtreeCheckState *state, IndexTuple itup)
+{
+	return Min(BTreeTupleGetNAtts(itup, state->rel),
+			   IndexRelationGetNumberOfKeyAttributes(state->rel));
+}
+
 /*
  * Does the invariant hold that the key is less than or equal to a given upper
  * bound offset item?
@@ -1759,13 +1993,12 @@ offset_is_negative_infinity(BTPageOpaque opaque, OffsetNumber offset)
  * to corruption.
  */
 static inline bool
-invariant_leq_offset(BtreeCheckState *state, ScanKey key,
+invariant_leq_offset(BtreeCheckState *state, ScanKey key, int keysz,
 					 OffsetNumber upperbound)
 {
-	int16		nkeyatts = IndexRelationGetNumberOfKeyAttributes(state->rel);
 	int32		cmp;
 
-	cmp = _bt_compare(state->rel, nkeyatts, key, state->target, upperbound);
+	cmp = _bt_compare(state->rel, keysz, key, state->target, upperbound);
 
 	return cmp <= 0;
 }
@@ -1778,13 +2011,12 @@ invariant_leq_offset(BtreeCheckState *state, ScanKey key,
  * to corruption.
  */
 static inline bool
-invariant_geq_offset(BtreeCheckState *state, ScanKey key,
+invariant_geq_offset(BtreeCheckState *state, ScanKey key, int keysz,
 					 OffsetNumber lowerbound)
 {
-	int16		nkeyatts = IndexRelationGetNumberOfKeyAttributes(state->rel);
 	int32		cmp;
 
-	cmp = _bt_compare(state->rel, nkeyatts, key, state->target, lowerbound);
+	cmp = _bt_compare(state->rel, keysz, key, state->target, lowerbound);
 
 	return cmp >= 0;
 }
@@ -1801,13 +2033,12 @@ invariant_geq_offset(BtreeCheckState *state, ScanKey key,
  */
 static inline bool
 invariant_leq_nontarget_offset(BtreeCheckState *state,
-							   Page nontarget, ScanKey key,
+							   Page nontarget, ScanKey key, int keysz,
 							   OffsetNumber upperbound)
 {
-	int16		nkeyatts = IndexRelationGetNumberOfKeyAttributes(state->rel);
 	int32		cmp;
 
-	cmp = _bt_compare(state->rel, nkeyatts, key, nontarget, upperbound);
+	cmp = _bt_compare(state->rel, keysz, key, nontarget, upperbound);
 
 	return cmp <= 0;
 }
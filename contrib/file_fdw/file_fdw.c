@@ -13,9 +13,11 @@
 #include "postgres.h"
 
 #include <sys/stat.h>
+#include <fcntl.h>
 #include <unistd.h>
 
 #include "access/htup_details.h"
+#include "access/parallel.h"
 #include "access/reloptions.h"
 #include "access/sysattr.h"
 #include "catalog/pg_authid.h"
@@ -26,13 +28,17 @@
 #include "commands/vacuum.h"
 #include "foreign/fdwapi.h"
 #include "foreign/foreign.h"
+#include "mb/pg_wchar.h"
 #include "miscadmin.h"
 #include "nodes/makefuncs.h"
 #include "optimizer/cost.h"
 #include "optimizer/pathnode.h"
+#include "optimizer/paths.h"
 #include "optimizer/planmain.h"
 #include "optimizer/restrictinfo.h"
 #include "optimizer/var.h"
+#include "port/atomics.h"
+#include "storage/fd.h"
 #include "utils/memutils.h"
 #include "utils/rel.h"
 #include "utils/sampling.h"
@@ -71,6 +77,8 @@ static const struct FileFdwOption valid_options[] = {
 	{"escape", ForeignTableRelationId},
 	{"null", ForeignTableRelationId},
 	{"encoding", ForeignTableRelationId},
+	/* not a COPY option; only used to decide whether to scan in parallel */
+	{"quoted_newlines", ForeignTableRelationId},
 	{"force_not_null", AttributeRelationId},
 	{"force_null", AttributeRelationId},
 
@@ -95,6 +103,21 @@ typedef struct FileFdwPlanState
 	double		ntuples;		/* estimate of number of data rows */
 } FileFdwPlanState;
 
+/*
+ * A parallel scan hands out the file in chunks of this many bytes.  Each
+ * participant reads the lines that begin within the chunks it claims.
+ */
+#define FILE_FDW_CHUNK_SIZE		(1024 * 1024)
+
+/*
+ * Shared state of a parallel scan, kept in the DSM segment.
+ */
+typedef struct FileFdwParallelState
+{
+	uint64		file_size;		/* size of the file when the scan started */
+	pg_atomic_uint64 next_chunk;	/* number of the next chunk to hand out */
+} FileFdwParallelState;
+
 /*
  * FDW-specific information for ForeignScanState.fdw_state.
  */
@@ -105,8 +128,29 @@ typedef struct FileFdwExecutionState
 	List	   *options;		/* merged COPY options, excluding filename and
 								 * is_program */
 	CopyState	cstate;			/* COPY execution state */
+
+	/*
+	 * A parallel-aware scan reads the file itself, in chunks, and feeds COPY
+	 * through file_read_chunks().
+	 */
+	bool		parallel;		/* is this a parallel-aware scan? */
+	bool		header;			/* skip the first line of the file? */
+	bool		csv;			/* CSV format, so backslash is no escape? */
+	FileFdwParallelState *pstate;	/* shared state, or NULL if none */
+	int			fd;				/* file descriptor, or -1 if not open yet */
+	uint64		file_size;		/* size of the file being scanned */
+	bool		exhausted;		/* no chunks left to claim? */
+	uint64		pos;			/* next byte of current chunk to hand over */
+	uint64		stop;			/* end of current chunk's lines */
 } FileFdwExecutionState;
 
+/*
+ * The scan whose data file_read_chunks() is reading.  COPY gives data source
+ * callbacks no argument, so fileIterateForeignScan sets this before reading
+ * each row.
+ */
+static FileFdwExecutionState *current_chunk_scan = NULL;
+
 /*
  * SQL functions
  */
@@ -139,6 +183,17 @@ static bool fileAnalyzeForeignTable(Relation relation,
 						BlockNumber *totalpages);
 static bool fileIsForeignScanParallelSafe(PlannerInfo *root, RelOptInfo *rel,
 							  RangeTblEntry *rte);
+static Size fileEstimateDSMForeignScan(ForeignScanState *node,
+						   ParallelContext *pcxt);
+static void fileInitializeDSMForeignScan(ForeignScanState *node,
+							 ParallelContext *pcxt,
+							 void *coordinate);
+static void fileReInitializeDSMForeignScan(ForeignScanState *node,
+							   ParallelContext *pcxt,
+							   void *coordinate);
+static void fileInitializeWorkerForeignScan(ForeignScanState *node,
+								shm_toc *toc,
+								void *coordinate);
 
 /*
  * Helper functions
@@ -160,6 +215,17 @@ static void estimate_costs(PlannerInfo *root, RelOptInfo *baserel,
 static int file_acquire_sample_rows(Relation onerel, int elevel,
 						 HeapTuple *rows, int targrows,
 						 double *totalrows, double *totaldeadrows);
+static bool file_is_splittable(Oid foreigntableid,
+				   FileFdwPlanState *fdw_private);
+static double file_parallel_divisor(int parallel_workers);
+static CopyState file_begin_copy(ForeignScanState *node,
+				FileFdwExecutionState *festate);
+static int	file_read_chunks(void *outbuf, int minread, int maxread);
+static bool file_claim_chunk(FileFdwExecutionState *festate);
+static uint64 file_line_start(FileFdwExecutionState *festate, uint64 pos);
+static bool file_newline_escaped(FileFdwExecutionState *festate, uint64 off);
+static int	file_read_at(FileFdwExecutionState *festate, char *buf, int len,
+			 uint64 off);
 
 
 /*
@@ -181,6 +247,10 @@ file_fdw_handler(PG_FUNCTION_ARGS)
 	fdwroutine->EndForeignScan = fileEndForeignScan;
 	fdwroutine->AnalyzeForeignTable = fileAnalyzeForeignTable;
 	fdwroutine->IsForeignScanParallelSafe = fileIsForeignScanParallelSafe;
+	fdwroutine->EstimateDSMForeignScan = fileEstimateDSMForeignScan;
+	fdwroutine->InitializeDSMForeignScan = fileInitializeDSMForeignScan;
+	fdwroutine->ReInitializeDSMForeignScan = fileReInitializeDSMForeignScan;
+	fdwroutine->InitializeWorkerForeignScan = fileInitializeWorkerForeignScan;
 
 	PG_RETURN_POINTER(fdwroutine);
 }
@@ -308,6 +378,9 @@ file_fdw_validator(PG_FUNCTION_ARGS)
 			force_null = def;
 			(void) defGetBoolean(def);
 		}
+		/* quoted_newlines is ours, not COPY's; just check it's a boolean */
+		else if (strcmp(def->defname, "quoted_newlines") == 0)
+			(void) defGetBoolean(def);
 		else
 			other_options = lappend(other_options, def);
 	}
@@ -408,6 +481,23 @@ fileGetOptions(Oid foreigntableid,
 		prev = lc;
 	}
 
+	/*
+	 * Likewise separate out quoted_newlines, which isn't a COPY option.  It's
+	 * only of interest to file_is_splittable(), which looks it up itself.
+	 */
+	prev = NULL;
+	foreach(lc, options)
+	{
+		DefElem    *def = (DefElem *) lfirst(lc);
+
+		if (strcmp(def->defname, "quoted_newlines") == 0)
+		{
+			options = list_delete_cell(options, lc, prev);
+			break;
+		}
+		prev = lc;
+	}
+
 	/*
 	 * The validator should have checked that filename or program was included
 	 * in the options, but check again, just in case.
@@ -528,7 +618,8 @@ fileGetForeignRelSize(PlannerInfo *root,
  *
  *		Currently we don't support any push-down feature, so there is only one
  *		possible access path, which simply returns all records in the order in
- *		the data file.
+ *		the data file; plus, if the file can be split at line boundaries, a
+ *		partial path that shares the reading among parallel workers.
  */
 static void
 fileGetForeignPaths(PlannerInfo *root,
@@ -568,6 +659,42 @@ fileGetForeignPaths(PlannerInfo *root,
 									 NULL,	/* no extra plan */
 									 coptions));
 
+	/*
+	 * Offer a parallel-aware partial path too, if the file is large enough
+	 * to be worth it.  The participants split the CPU work of parsing the
+	 * file between them, but each page still has to be read once.
+	 */
+	if (baserel->consider_parallel &&
+		file_is_splittable(foreigntableid, fdw_private))
+	{
+		int			parallel_workers;
+
+		parallel_workers = compute_parallel_worker(baserel,
+												   fdw_private->pages, -1,
+												   max_parallel_workers_per_gather);
+		if (parallel_workers > 0)
+		{
+			double		divisor = file_parallel_divisor(parallel_workers);
+			Cost		run_cost = total_cost - startup_cost;
+			Cost		disk_cost = seq_page_cost * fdw_private->pages;
+			ForeignPath *path;
+
+			path = create_foreignscan_path(root, baserel,
+										   NULL,	/* default pathtarget */
+										   clamp_row_est(baserel->rows / divisor),
+										   startup_cost,
+										   startup_cost + disk_cost +
+										   (run_cost - disk_cost) / divisor,
+										   NIL, /* no pathkeys */
+										   NULL,	/* no outer rel either */
+										   NULL,	/* no extra plan */
+										   coptions);
+			path->path.parallel_aware = true;
+			path->path.parallel_workers = parallel_workers;
+			add_partial_path(baserel, (Path *) path);
+		}
+	}
+
 	/*
 	 * If data file was sorted, and we knew it somehow, we could insert
 	 * appropriate pathkeys into the ForeignPath node to tell the planner
@@ -653,8 +780,8 @@ fileBeginForeignScan(ForeignScanState *node, int eflags)
 	char	   *filename;
 	bool		is_program;
 	List	   *options;
-	CopyState	cstate;
 	FileFdwExecutionState *festate;
+	ListCell   *lc;
 
 	/*
 	 * Do nothing in EXPLAIN (no ANALYZE) case.  node->fdw_state stays NULL.
@@ -669,27 +796,42 @@ fileBeginForeignScan(ForeignScanState *node, int eflags)
 	/* Add any options from the plan (currently only convert_selectively) */
 	options = list_concat(options, plan->fdw_private);
 
-	/*
-	 * Create CopyState from FDW options.  We always acquire all columns, so
-	 * as to match the expected ScanTupleSlot signature.
-	 */
-	cstate = BeginCopyFrom(NULL,
-						   node->ss.ss_currentRelation,
-						   filename,
-						   is_program,
-						   NULL,
-						   NIL,
-						   options);
-
 	/*
 	 * Save state in node->fdw_state.  We must save enough information to call
 	 * BeginCopyFrom() again.
 	 */
-	festate = (FileFdwExecutionState *) palloc(sizeof(FileFdwExecutionState));
+	festate = (FileFdwExecutionState *) palloc0(sizeof(FileFdwExecutionState));
 	festate->filename = filename;
 	festate->is_program = is_program;
+	festate->parallel = plan->scan.plan.parallel_aware;
+	festate->fd = -1;
+
+	/*
+	 * A parallel-aware scan skips the header line itself, since COPY would
+	 * take the first line of each participant's share of the file for it.
+	 */
+	if (festate->parallel)
+	{
+		List	   *copy_options = NIL;
+
+		foreach(lc, options)
+		{
+			DefElem    *def = (DefElem *) lfirst(lc);
+
+			if (strcmp(def->defname, "header") == 0)
+				festate->header = defGetBoolean(def);
+			else
+			{
+				if (strcmp(def->defname, "format") == 0)
+					festate->csv = (strcmp(defGetString(def), "csv") == 0);
+				copy_options = lappend(copy_options, def);
+			}
+		}
+		options = copy_options;
+	}
 	festate->options = options;
-	festate->cstate = cstate;
+
+	festate->cstate = file_begin_copy(node, festate);
 
 	node->fdw_state = (void *) festate;
 }
@@ -726,6 +868,7 @@ fileIterateForeignScan(ForeignScanState *node)
 	 * foreign tables.
 	 */
 	ExecClearTuple(slot);
+	current_chunk_scan = festate;
 	found = NextCopyFrom(festate->cstate, NULL,
 						 slot->tts_values, slot->tts_isnull);
 	if (found)
@@ -748,13 +891,11 @@ fileReScanForeignScan(ForeignScanState *node)
 
 	EndCopyFrom(festate->cstate);
 
-	festate->cstate = BeginCopyFrom(NULL,
-									node->ss.ss_currentRelation,
-									festate->filename,
-									festate->is_program,
-									NULL,
-									NIL,
-									festate->options);
+	/* Start over claiming chunks; the leader has reset the shared state */
+	festate->exhausted = false;
+	festate->pos = festate->stop = 0;
+
+	festate->cstate = file_begin_copy(node, festate);
 }
 
 /*
@@ -768,7 +909,11 @@ fileEndForeignScan(ForeignScanState *node)
 
 	/* if festate is NULL, we are in EXPLAIN; nothing to do */
 	if (festate)
+	{
 		EndCopyFrom(festate->cstate);
+		if (festate->fd >= 0)
+			CloseTransientFile(festate->fd);
+	}
 }
 
 /*
@@ -833,6 +978,68 @@ fileIsForeignScanParallelSafe(PlannerInfo *root, RelOptInfo *rel,
 	return true;
 }
 
+/*
+ * fileEstimateDSMForeignScan
+ *		Report the size of the shared state of a parallel scan
+ */
+static Size
+fileEstimateDSMForeignScan(ForeignScanState *node, ParallelContext *pcxt)
+{
+	return sizeof(FileFdwParallelState);
+}
+
+/*
+ * fileInitializeDSMForeignScan
+ *		Set up the shared state of a parallel scan
+ *
+ * The file's size is taken once, here, so that all participants agree on
+ * the chunks it's divided into.
+ */
+static void
+fileInitializeDSMForeignScan(ForeignScanState *node, ParallelContext *pcxt,
+							 void *coordinate)
+{
+	FileFdwExecutionState *festate = (FileFdwExecutionState *) node->fdw_state;
+	FileFdwParallelState *pstate = (FileFdwParallelState *) coordinate;
+	struct stat stat_buf;
+
+	if (stat(festate->filename, &stat_buf) < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not stat file \"%s\": %m",
+						festate->filename)));
+
+	pstate->file_size = (uint64) stat_buf.st_size;
+	pg_atomic_init_u64(&pstate->next_chunk, 0);
+	festate->pstate = pstate;
+}
+
+/*
+ * fileReInitializeDSMForeignScan
+ *		Reset the shared state of a parallel scan before a rescan
+ */
+static void
+fileReInitializeDSMForeignScan(ForeignScanState *node, ParallelContext *pcxt,
+							   void *coordinate)
+{
+	FileFdwParallelState *pstate = (FileFdwParallelState *) coordinate;
+
+	pg_atomic_write_u64(&pstate->next_chunk, 0);
+}
+
+/*
+ * fileInitializeWorkerForeignScan
+ *		Attach a parallel worker to the shared state of a parallel scan
+ */
+static void
+fileInitializeWorkerForeignScan(ForeignScanState *node, shm_toc *toc,
+								void *coordinate)
+{
+	FileFdwExecutionState *festate = (FileFdwExecutionState *) node->fdw_state;
+
+	festate->pstate = (FileFdwParallelState *) coordinate;
+}
+
 /*
  * check_selective_binary_conversion
  *
@@ -1215,3 +1422,278 @@ file_acquire_sample_rows(Relation onerel, int elevel,
 
 	return numrows;
 }
+
+/*
+ * Check whether a parallel scan may cut the file into chunks at line
+ * boundaries.  That takes a plain file in text or CSV format, in an encoding
+ * that doesn't hide ASCII bytes inside multibyte characters, since we find
+ * line ends without parsing the data.  In CSV format a quoted value can also
+ * contain newlines, so there we rely on the quoted_newlines option saying
+ * that none do.
+ */
+static bool
+file_is_splittable(Oid foreigntableid, FileFdwPlanState *fdw_private)
+{
+	ForeignTable *table;
+	ListCell   *lc;
+	int			encoding = pg_get_client_encoding();
+	bool		csv = false;
+	bool		quoted_newlines = true;
+
+	if (fdw_private->is_program)
+		return false;
+
+	table = GetForeignTable(foreigntableid);
+	foreach(lc, table->options)
+	{
+		DefElem    *def = (DefElem *) lfirst(lc);
+
+		if (strcmp(def->defname, "format") == 0)
+		{
+			char	   *format = defGetString(def);
+
+			if (strcmp(format, "binary") == 0)
+				return false;
+			csv = (strcmp(format, "csv") == 0);
+		}
+		else if (strcmp(def->defname, "encoding") == 0)
+			encoding = pg_char_to_encoding(defGetString(def));
+		else if (strcmp(def->defname, "quoted_newlines") == 0)
+			quoted_newlines = defGetBoolean(def);
+	}
+
+	if (encoding < 0 || PG_ENCODING_IS_CLIENT_ONLY(encoding))
+		return false;
+
+	return !csv || !quoted_newlines;
+}
+
+/*
+ * Estimate the share of the rows a participant of a parallel scan processes,
+ * in the same way as the core planner does for a parallel seqscan.
+ */
+static double
+file_parallel_divisor(int parallel_workers)
+{
+	double		parallel_divisor = parallel_workers;
+
+	if (parallel_leader_participation)
+	{
+		double		leader_contribution;
+
+		leader_contribution = 1.0 - (0.3 * parallel_workers);
+		if (leader_contribution > 0)
+			parallel_divisor += leader_contribution;
+	}
+
+	return parallel_divisor;
+}
+
+/*
+ * Create the CopyState of a scan.  We always acquire all columns, so as to
+ * match the expected ScanTupleSlot signature.
+ */
+static CopyState
+file_begin_copy(ForeignScanState *node, FileFdwExecutionState *festate)
+{
+	return BeginCopyFrom(NULL,
+						 node->ss.ss_currentRelation,
+						 festate->filename,
+						 festate->is_program,
+						 festate->parallel ? file_read_chunks : NULL,
+						 NIL,
+						 festate->options);
+}
+
+/*
+ * Data source callback of a parallel-aware scan: hand COPY the lines of the
+ * chunks we claim, one chunk after the other.  As each chunk's share ends at
+ * a line boundary, COPY sees a stream of whole lines.
+ *
+ * Without shared state, which happens when no DSM segment could be set up,
+ * we just read the whole file as one chunk.
+ */
+static int
+file_read_chunks(void *outbuf, int minread, int maxread)
+{
+	FileFdwExecutionState *festate = current_chunk_scan;
+	int			bytesread = 0;
+
+	Assert(festate != NULL && festate->parallel);
+
+	while (bytesread < minread)
+	{
+		int			nread;
+
+		if (festate->pos >= festate->stop)
+		{
+			if (festate->exhausted || !file_claim_chunk(festate))
+				break;
+			continue;
+		}
+
+		nread = file_read_at(festate, (char *) outbuf + bytesread,
+							 (int) Min((uint64) (maxread - bytesread),
+									   festate->stop - festate->pos),
+							 festate->pos);
+		if (nread == 0)
+		{
+			/* the file got truncated under us; nothing left in this chunk */
+			festate->pos = festate->stop;
+			continue;
+		}
+		festate->pos += nread;
+		bytesread += nread;
+	}
+
+	return bytesread;
+}
+
+/*
+ * Claim the next chunk of the file, and set pos and stop to cover the lines
+ * beginning within it.  Returns false once all chunks have been handed out.
+ */
+static bool
+file_claim_chunk(FileFdwExecutionState *festate)
+{
+	uint64		start;
+	uint64		end;
+
+	if (festate->fd < 0)
+	{
+		festate->fd = OpenTransientFile(festate->filename, O_RDONLY | PG_BINARY);
+		if (festate->fd < 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not open file \"%s\" for reading: %m",
+							festate->filename)));
+
+		if (festate->pstate)
+			festate->file_size = festate->pstate->file_size;
+		else
+		{
+			struct stat stat_buf;
+
+			if (fstat(festate->fd, &stat_buf) < 0)
+				ereport(ERROR,
+						(errcode_for_file_access(),
+						 errmsg("could not stat file \"%s\": %m",
+								festate->filename)));
+			festate->file_size = (uint64) stat_buf.st_size;
+		}
+	}
+
+	if (festate->pstate)
+	{
+		uint64		chunkno;
+
+		chunkno = pg_atomic_fetch_add_u64(&festate->pstate->next_chunk, 1);
+		start = chunkno * FILE_FDW_CHUNK_SIZE;
+		end = Min(start + FILE_FDW_CHUNK_SIZE, festate->file_size);
+	}
+	else
+	{
+		start = 0;
+		end = festate->file_size;
+		festate->exhausted = true;
+	}
+
+	if (start >= festate->file_size)
+	{
+		festate->exhausted = true;
+		return false;
+	}
+
+	/*
+	 * Every participant computes a chunk's boundaries the same way, so each
+	 * line is read by exactly one of them.
+	 */
+	festate->pos = file_line_start(festate,
+								   (start == 0 && festate->header) ? 1 : start);
+	festate->stop = file_line_start(festate, end);
+
+	return true;
+}
+
+/*
+ * Return the offset of the first line of the file beginning at or after pos,
+ * or the size of the file if there's none.  A line begins at offset 0 and
+ * after every newline, except one escaped by a backslash in text format.
+ */
+static uint64
+file_line_start(FileFdwExecutionState *festate, uint64 pos)
+{
+	char		buf[BLCKSZ];
+	uint64		off;
+
+	if (pos == 0)
+		return 0;
+
+	/* Look for a newline just before pos, or later */
+	off = pos - 1;
+	while (off < festate->file_size)
+	{
+		int			nread;
+		char	   *nl;
+
+		nread = file_read_at(festate, buf,
+							 (int) Min((uint64) sizeof(buf),
+									   festate->file_size - off),
+							 off);
+		if (nread == 0)
+			break;
+
+		nl = memchr(buf, '\n', nread);
+		if (nl == NULL)
+		{
+			off += nread;
+			continue;
+		}
+
+		off += nl - buf;
+		if (festate->csv || !file_newline_escaped(festate, off))
+			return off + 1;
+		off++;
+	}
+
+	return festate->file_size;
+}
+
+/*
+ * Is the newline at the given offset escaped, that is, preceded by an odd
+ * number of backslashes?
+ */
+static bool
+file_newline_escaped(FileFdwExecutionState *festate, uint64 off)
+{
+	bool		escaped = false;
+	char		c;
+
+	while (off > 0)
+	{
+		if (file_read_at(festate, &c, 1, --off) != 1 || c != '\\')
+			break;
+		escaped = !escaped;
+	}
+
+	return escaped;
+}
+
+/*
+ * Read up to len bytes of the file at the given offset.  Returns the number
+ * of bytes read, which is less than len only at the end of the file.
+ */
+static int
+file_read_at(FileFdwExecutionState *festate, char *buf, int len, uint64 off)
+{
+	int			nread;
+
+	nread = pg_pread(festate->fd, buf, len, (off_t) off);
+	if (nread < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read file \"%s\": %m",
+						festate->filename)));
+
+	return nread;
+}
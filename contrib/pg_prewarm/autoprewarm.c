@@ -10,11 +10,14 @@
  *		and we need to lock the relations so that we don't try to prewarm
  *		pages from a relation that is in the process of being dropped.
  *
- *		While prewarming, autoprewarm will use two workers.  There's a
- *		master worker that reads and sorts the list of blocks to be
- *		prewarmed and then launches a per-database worker for each
- *		relevant database in turn.  The former keeps running after the
- *		initial prewarm is complete to update the dump file periodically.
+ *		While prewarming, autoprewarm will use at least two workers.
+ *		There's a master worker that reads and sorts the list of blocks to
+ *		be prewarmed and then launches per-database workers for each
+ *		relevant database in turn.  Up to autoprewarm_workers of those run
+ *		at the same time; if there are fewer databases than that, the
+ *		blocks of a database are split into ranges loaded concurrently.
+ *		The master keeps running after the initial prewarm is complete to
+ *		update the dump file periodically.
  *
  *	Copyright (c) 2016-2019, PostgreSQL Global Development Group
  *
@@ -34,6 +37,7 @@
 #include "catalog/pg_type.h"
 #include "miscadmin.h"
 #include "pgstat.h"
+#include "port/atomics.h"
 #include "postmaster/bgworker.h"
 #include "storage/buf_internals.h"
 #include "storage/dsm.h"
@@ -54,6 +58,9 @@
 
 #define AUTOPREWARM_FILE "autoprewarm.blocks"
 
+/* Maximum number of concurrent per-database workers. */
+#define AUTOPREWARM_MAX_WORKERS 32
+
 /* Metadata for each block we dump. */
 typedef struct BlockInfoRecord
 {
@@ -64,6 +71,14 @@ typedef struct BlockInfoRecord
 	BlockNumber blocknum;
 } BlockInfoRecord;
 
+/* Range of blocks assigned to one per-database worker. */
+typedef struct AutoPrewarmWorkerSlot
+{
+	Oid			database;
+	int			prewarm_start_idx;
+	int			prewarm_stop_idx;
+} AutoPrewarmWorkerSlot;
+
 /* Shared state information for autoprewarm bgworker. */
 typedef struct AutoPrewarmSharedState
 {
@@ -71,12 +86,10 @@ typedef struct AutoPrewarmSharedState
 	pid_t		bgworker_pid;	/* for main bgworker */
 	pid_t		pid_using_dumpfile; /* for autoprewarm or block dump */
 
-	/* Following items are for communication with per-database worker */
+	/* Following items are for communication with per-database workers */
 	dsm_handle	block_info_handle;
-	Oid			database;
-	int			prewarm_start_idx;
-	int			prewarm_stop_idx;
-	int			prewarmed_blocks;
+	pg_atomic_uint32 prewarmed_blocks;
+	AutoPrewarmWorkerSlot workers[AUTOPREWARM_MAX_WORKERS];
 } AutoPrewarmSharedState;
 
 void		_PG_init(void);
@@ -89,7 +102,9 @@ PG_FUNCTION_INFO_V1(autoprewarm_dump_now);
 static void apw_load_buffers(void);
 static int	apw_dump_now(bool is_bgworker, bool dump_unlogged);
 static void apw_start_master_worker(void);
-static void apw_start_database_worker(void);
+static BackgroundWorkerHandle *apw_start_database_worker(int slot);
+static int	apw_wait_for_free_slot(BackgroundWorkerHandle **handles,
+					   int nslots);
 static bool apw_init_shmem(void);
 static void apw_detach_shmem(int code, Datum arg);
 static int	apw_compare_blockinfo(const void *p, const void *q);
@@ -106,6 +121,7 @@ static AutoPrewarmSharedState *apw_state = NULL;
 /* GUC variables. */
 static bool autoprewarm = true; /* start worker? */
 static int	autoprewarm_interval;	/* dump interval */
+static int	autoprewarm_workers;	/* concurrent per-database workers */
 
 /*
  * Module load callback.
@@ -125,6 +141,18 @@ _PG_init(void)
 							NULL,
 							NULL);
 
+	DefineCustomIntVariable("pg_prewarm.autoprewarm_workers",
+							"Sets the number of workers used to reload dumped blocks concurrently.",
+							NULL,
+							&autoprewarm_workers,
+							1,
+							1, AUTOPREWARM_MAX_WORKERS,
+							PGC_SIGHUP,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
 	if (!process_shared_preload_libraries_in_progress)
 		return;
 
@@ -264,8 +292,8 @@ autoprewarm_main(Datum main_arg)
 }
 
 /*
- * Read the dump file and launch per-database workers one at a time to
- * prewarm the buffers found there.
+ * Read the dump file and launch per-database workers, up to
+ * autoprewarm_workers at a time, to prewarm the buffers found there.
  */
 static void
 apw_load_buffers(void)
@@ -275,6 +303,10 @@ apw_load_buffers(void)
 				i;
 	BlockInfoRecord *blkinfo;
 	dsm_segment *seg;
+	BackgroundWorkerHandle *handles[AUTOPREWARM_MAX_WORKERS];
+	int			nworkers = autoprewarm_workers;
+	int			chunk_size;
+	int			start_idx = 0;
 
 	/*
 	 * Skip the prewarm if the dump file is in use; otherwise, prevent any
@@ -346,13 +378,22 @@ apw_load_buffers(void)
 
 	/* Populate shared memory state. */
 	apw_state->block_info_handle = dsm_segment_handle(seg);
-	apw_state->prewarm_start_idx = apw_state->prewarm_stop_idx = 0;
-	apw_state->prewarmed_blocks = 0;
+	pg_atomic_write_u32(&apw_state->prewarmed_blocks, 0);
+	memset(handles, 0, sizeof(handles));
+
+	/*
+	 * Workers are handed ranges of at most chunk_size blocks, so that with
+	 * several workers even a single database is loaded concurrently.  With
+	 * one worker, each database is loaded in one go by one worker, as
+	 * before.
+	 */
+	chunk_size = (num_elements + nworkers - 1) / nworkers;
 
 	/* Get the info position of the first block of the next database. */
-	while (apw_state->prewarm_start_idx < num_elements)
+	while (start_idx < num_elements)
 	{
-		int			j = apw_state->prewarm_start_idx;
+		int			j = start_idx;
+		int			chunk_start;
 		Oid			current_db = blkinfo[j].database;
 
 		/*
@@ -384,23 +425,41 @@ apw_load_buffers(void)
 		if (current_db == InvalidOid)
 			break;
 
-		/* Configure stop point and database for next per-database worker. */
-		apw_state->prewarm_stop_idx = j;
-		apw_state->database = current_db;
-		Assert(apw_state->prewarm_start_idx < apw_state->prewarm_stop_idx);
+		/* Hand out this database's blocks in chunks of chunk_size. */
+		Assert(start_idx < j);
+		for (chunk_start = start_idx; chunk_start < j; chunk_start += chunk_size)
+		{
+			int			slot;
+
+			/* If we've run out of free buffers, don't launch another worker. */
+			if (!have_free_buffer())
+				break;
 
-		/* If we've run out of free buffers, don't launch another worker. */
-		if (!have_free_buffer())
+			/* Configure range and database for next per-database worker. */
+			slot = apw_wait_for_free_slot(handles, nworkers);
+			apw_state->workers[slot].database = current_db;
+			apw_state->workers[slot].prewarm_start_idx = chunk_start;
+			apw_state->workers[slot].prewarm_stop_idx =
+				Min(chunk_start + chunk_size, j);
+
+			handles[slot] = apw_start_database_worker(slot);
+		}
+		if (chunk_start < j)
 			break;
 
+		/* Prepare for next database. */
+		start_idx = j;
+	}
+
+	/* Wait for all per-database workers to exit. */
+	for (i = 0; i < nworkers; i++)
+	{
 		/*
-		 * Start a per-database worker to load blocks for this database; this
-		 * function will return once the per-database worker exits.
+		 * Ignore return value; if it fails, postmaster has died, but we have
+		 * checks for that elsewhere.
 		 */
-		apw_start_database_worker();
-
-		/* Prepare for next database. */
-		apw_state->prewarm_start_idx = apw_state->prewarm_stop_idx;
+		if (handles[i] != NULL)
+			WaitForBackgroundWorkerShutdown(handles[i]);
 	}
 
 	/* Clean up. */
@@ -413,7 +472,8 @@ apw_load_buffers(void)
 	/* Report our success. */
 	ereport(LOG,
 			(errmsg("autoprewarm successfully prewarmed %d of %d previously-loaded blocks",
-					apw_state->prewarmed_blocks, num_elements)));
+					(int) pg_atomic_read_u32(&apw_state->prewarmed_blocks),
+					num_elements)));
 }
 
 /*
@@ -423,7 +483,9 @@ apw_load_buffers(void)
 void
 autoprewarm_database_main(Datum main_arg)
 {
+	AutoPrewarmWorkerSlot *slot;
 	int			pos;
+	int			prefetch_pos;
 	BlockInfoRecord *block_info;
 	Relation	rel = NULL;
 	BlockNumber nblocks = 0;
@@ -441,15 +503,16 @@ autoprewarm_database_main(Datum main_arg)
 		ereport(ERROR,
 				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
 				 errmsg("could not map dynamic shared memory segment")));
-	BackgroundWorkerInitializeConnectionByOid(apw_state->database, InvalidOid, 0);
+	slot = &apw_state->workers[DatumGetInt32(main_arg)];
+	BackgroundWorkerInitializeConnectionByOid(slot->database, InvalidOid, 0);
 	block_info = (BlockInfoRecord *) dsm_segment_address(seg);
-	pos = apw_state->prewarm_start_idx;
+	pos = prefetch_pos = slot->prewarm_start_idx;
 
 	/*
 	 * Loop until we run out of blocks to prewarm or until we run out of free
 	 * buffers.
 	 */
-	while (pos < apw_state->prewarm_stop_idx && have_free_buffer())
+	while (pos < slot->prewarm_stop_idx && have_free_buffer())
 	{
 		BlockInfoRecord *blk = &block_info[pos++];
 		Buffer		buf;
@@ -527,12 +590,37 @@ autoprewarm_database_main(Datum main_arg)
 			continue;
 		}
 
+#ifdef USE_PREFETCH
+
+		/*
+		 * Keep up to target_prefetch_pages read-ahead requests outstanding
+		 * for the following blocks of the same fork, so that the kernel can
+		 * fetch them while we wait for this one.
+		 */
+		if (prefetch_pos < pos)
+			prefetch_pos = pos;
+		while (prefetch_pos < slot->prewarm_stop_idx &&
+			   prefetch_pos < pos + target_prefetch_pages)
+		{
+			BlockInfoRecord *pblk = &block_info[prefetch_pos];
+
+			if (pblk->database != blk->database ||
+				pblk->tablespace != blk->tablespace ||
+				pblk->filenode != blk->filenode ||
+				pblk->forknum != blk->forknum)
+				break;
+			if (pblk->blocknum < nblocks)
+				PrefetchBuffer(rel, pblk->forknum, pblk->blocknum);
+			prefetch_pos++;
+		}
+#endif							/* USE_PREFETCH */
+
 		/* Prewarm buffer. */
 		buf = ReadBufferExtended(rel, blk->forknum, blk->blocknum, RBM_NORMAL,
 								 NULL);
 		if (BufferIsValid(buf))
 		{
-			apw_state->prewarmed_blocks++;
+			pg_atomic_fetch_add_u32(&apw_state->prewarmed_blocks, 1);
 			ReleaseBuffer(buf);
 		}
 
@@ -763,6 +851,7 @@ apw_init_shmem(void)
 		LWLockInitialize(&apw_state->lock, LWLockNewTrancheId());
 		apw_state->bgworker_pid = InvalidPid;
 		apw_state->pid_using_dumpfile = InvalidPid;
+		pg_atomic_init_u32(&apw_state->prewarmed_blocks, 0);
 	}
 	LWLockRelease(AddinShmemInitLock);
 
@@ -828,10 +917,11 @@ apw_start_master_worker(void)
 }
 
 /*
- * Start autoprewarm per-database worker process.
+ * Start autoprewarm per-database worker process for the given slot of the
+ * shared state, and return its handle.
  */
-static void
-apw_start_database_worker(void)
+static BackgroundWorkerHandle *
+apw_start_database_worker(int slot)
 {
 	BackgroundWorker worker;
 	BackgroundWorkerHandle *handle;
@@ -844,6 +934,7 @@ apw_start_database_worker(void)
 	strcpy(worker.bgw_function_name, "autoprewarm_database_main");
 	strcpy(worker.bgw_name, "autoprewarm worker");
 	strcpy(worker.bgw_type, "autoprewarm worker");
+	worker.bgw_main_arg = Int32GetDatum(slot);
 
 	/* must set notify PID to wait for shutdown */
 	worker.bgw_notify_pid = MyProcPid;
@@ -854,11 +945,39 @@ apw_start_database_worker(void)
 				 errmsg("registering dynamic bgworker autoprewarm failed"),
 				 errhint("Consider increasing configuration parameter \"max_worker_processes\".")));
 
-	/*
-	 * Ignore return value; if it fails, postmaster has died, but we have
-	 * checks for that elsewhere.
-	 */
-	WaitForBackgroundWorkerShutdown(handle);
+	return handle;
+}
+
+/*
+ * Return the index of a worker slot whose per-database worker has exited,
+ * or was never started, waiting for one if necessary.
+ */
+static int
+apw_wait_for_free_slot(BackgroundWorkerHandle **handles, int nslots)
+{
+	for (;;)
+	{
+		int			i;
+
+		for (i = 0; i < nslots; i++)
+		{
+			pid_t		pid;
+
+			if (handles[i] == NULL)
+				return i;
+			if (GetBackgroundWorkerPid(handles[i], &pid) == BGWH_STOPPED)
+			{
+				pfree(handles[i]);
+				handles[i] = NULL;
+				return i;
+			}
+		}
+
+		/* The postmaster sets our latch when a worker's state changes. */
+		(void) WaitLatch(MyLatch, WL_LATCH_SET | WL_EXIT_ON_PM_DEATH, -1L,
+						 PG_WAIT_EXTENSION);
+		ResetLatch(MyLatch);
+	}
 }
 
 /* Compare member elements to check whether they are not equal. */
@@ -33,12 +33,18 @@
  * these strings in a temporary external query-texts file.  Offsets into this
  * file are kept in shared memory.
  *
- * Note about locking issues: to create or delete an entry in the shared
- * hashtable, one must hold pgss->lock exclusively.  Modifying any field
- * in an entry except the counters requires the same.  To look up an entry,
- * one must hold the lock shared.  To read or update the counters within
- * an entry, one must hold the lock shared or exclusive (so the entry doesn't
- * disappear!) and also take the entry's mutex spinlock.
+ * Note about locking issues: the shared hashtable is partitioned, with one
+ * LWLock per partition, so that backends executing different statements
+ * don't all hammer on the same lock.  There is also a global lock,
+ * pgss->lock; "locking everything" below means taking pgss->lock and then
+ * all the partition locks, in order, in the same mode (see pgss_lock_all).
+ * To look up an entry, one must hold its partition lock in shared mode (or
+ * hold everything).  To read or update the counters within an entry, one must
+ * hold its partition lock in either mode (so the entry doesn't disappear!)
+ * and also take the entry's mutex spinlock.  To create an entry, one must
+ * hold pgss->lock at least shared, plus the partition lock exclusively.
+ * Deleting an entry, or modifying any field in an entry other than the
+ * counters, requires having locked everything exclusively.
  * The shared state variable pgss->extent (the next free spot in the external
  * query-text file) should be accessed only while holding either the
  * pgss->mutex spinlock, or exclusive lock on pgss->lock.  We use the mutex to
@@ -67,6 +73,7 @@
 #include "funcapi.h"
 #include "mb/pg_wchar.h"
 #include "miscadmin.h"
+#include "optimizer/planner.h"
 #include "parser/analyze.h"
 #include "parser/parsetree.h"
 #include "parser/scanner.h"
@@ -96,7 +103,7 @@ PG_MODULE_MAGIC;
 #define PGSS_TEXT_FILE	PG_STAT_TMP_DIR "/pgss_query_texts.stat"
 
 /* Magic number identifying the stats file format */
-static const uint32 PGSS_FILE_HEADER = 0x20171004;
+static const uint32 PGSS_FILE_HEADER = 0x20190120;
 
 /* PostgreSQL major version number, changes in which invalidate all entries */
 static const uint32 PGSS_PG_MAJOR_VERSION = PG_VERSION_NUM / 100;
@@ -110,6 +117,9 @@ static const uint32 PGSS_PG_MAJOR_VERSION = PG_VERSION_NUM / 100;
 #define STICKY_DECREASE_FACTOR	(0.50)	/* factor for sticky entries */
 #define USAGE_DEALLOC_PERCENT	5	/* free this % of entries at once */
 
+/* Number of partitions of the shared hashtable; must be a power of 2 */
+#define PGSS_NUM_PARTITIONS		16
+
 #define JUMBLE_SIZE				1024	/* query serialization buffer size */
 
 /*
@@ -120,7 +130,8 @@ typedef enum pgssVersion
 	PGSS_V1_0 = 0,
 	PGSS_V1_1,
 	PGSS_V1_2,
-	PGSS_V1_3
+	PGSS_V1_3,
+	PGSS_V1_7
 } pgssVersion;
 
 /*
@@ -163,6 +174,11 @@ typedef struct Counters
 	int64		temp_blks_written;	/* # of temp blocks written */
 	double		blk_read_time;	/* time spent reading, in msec */
 	double		blk_write_time; /* time spent writing, in msec */
+	int64		plans;			/* # of times planned */
+	double		total_plan_time;	/* total planning time, in msec */
+	int64		wal_records;	/* # of WAL records generated */
+	int64		wal_fpi;		/* # of WAL full page images generated */
+	uint64		wal_bytes;		/* total amount of WAL bytes generated */
 	double		usage;			/* usage factor */
 } Counters;
 
@@ -188,7 +204,8 @@ typedef struct pgssEntry
  */
 typedef struct pgssSharedState
 {
-	LWLock	   *lock;			/* protects hashtable search/modification */
+	LWLock	   *lock;			/* global lock, see notes at head of file */
+	LWLockPadded *partition_locks;	/* one per hashtable partition */
 	double		cur_median_usage;	/* current median usage in hashtable */
 	Size		mean_query_len; /* current mean entry text length */
 	slock_t		mutex;			/* protects following fields only: */
@@ -233,12 +250,13 @@ typedef struct pgssJumbleState
 
 /*---- Local variables ----*/
 
-/* Current nesting depth of ExecutorRun+ProcessUtility calls */
+/* Current nesting depth of planner+ExecutorRun+ProcessUtility calls */
 static int	nested_level = 0;
 
 /* Saved hook values in case of unload */
 static shmem_startup_hook_type prev_shmem_startup_hook = NULL;
 static post_parse_analyze_hook_type prev_post_parse_analyze_hook = NULL;
+static planner_hook_type prev_planner_hook = NULL;
 static ExecutorStart_hook_type prev_ExecutorStart = NULL;
 static ExecutorRun_hook_type prev_ExecutorRun = NULL;
 static ExecutorFinish_hook_type prev_ExecutorFinish = NULL;
@@ -269,6 +287,7 @@ static const struct config_enum_entry track_options[] =
 static int	pgss_max;			/* max # statements to track */
 static int	pgss_track;			/* tracking level */
 static bool pgss_track_utility; /* whether to track utility commands */
+static bool pgss_track_planning;	/* whether to track planning duration */
 static bool pgss_save;			/* whether to save stats across shutdown */
 
 
@@ -276,6 +295,9 @@ static bool pgss_save;			/* whether to save stats across shutdown */
 	(pgss_track == PGSS_TRACK_ALL || \
 	(pgss_track == PGSS_TRACK_TOP && nested_level == 0))
 
+#define PGSS_PARTITION_LOCK(hashcode) \
+	(&pgss->partition_locks[(hashcode) % PGSS_NUM_PARTITIONS].lock)
+
 #define record_gc_qtexts() \
 	do { \
 		volatile pgssSharedState *s = (volatile pgssSharedState *) pgss; \
@@ -292,11 +314,14 @@ void		_PG_fini(void);
 PG_FUNCTION_INFO_V1(pg_stat_statements_reset);
 PG_FUNCTION_INFO_V1(pg_stat_statements_1_2);
 PG_FUNCTION_INFO_V1(pg_stat_statements_1_3);
+PG_FUNCTION_INFO_V1(pg_stat_statements_1_7);
 PG_FUNCTION_INFO_V1(pg_stat_statements);
 
 static void pgss_shmem_startup(void);
 static void pgss_shmem_shutdown(int code, Datum arg);
 static void pgss_post_parse_analyze(ParseState *pstate, Query *query);
+static PlannedStmt *pgss_planner(Query *parse, int cursorOptions,
+			 ParamListInfo boundParams);
 static void pgss_ExecutorStart(QueryDesc *queryDesc, int eflags);
 static void pgss_ExecutorRun(QueryDesc *queryDesc,
 				 ScanDirection direction,
@@ -312,7 +337,9 @@ static void pgss_store(const char *query, uint64 queryId,
 		   int query_location, int query_len,
 		   double total_time, uint64 rows,
 		   const BufferUsage *bufusage,
+		   const WalUsage *walusage,
 		   pgssJumbleState *jstate);
+static void pgss_store_plan_time(uint64 queryId, double plan_time);
 static void pg_stat_statements_internal(FunctionCallInfo fcinfo,
 							pgssVersion api_version,
 							bool showtext);
@@ -320,6 +347,8 @@ static Size pgss_memsize(void);
 static pgssEntry *entry_alloc(pgssHashKey *key, Size query_offset, int query_len,
 			int encoding, bool sticky);
 static void entry_dealloc(void);
+static void pgss_lock_all(LWLockMode mode);
+static void pgss_unlock_all(void);
 static bool qtext_store(const char *query, int query_len,
 			Size *query_offset, int *gc_count);
 static char *qtext_load_file(Size *buffer_size);
@@ -397,6 +426,17 @@ _PG_init(void)
 							 NULL,
 							 NULL);
 
+	DefineCustomBoolVariable("pg_stat_statements.track_planning",
+							 "Selects whether planning duration is tracked by pg_stat_statements.",
+							 NULL,
+							 &pgss_track_planning,
+							 false,
+							 PGC_SUSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
 	DefineCustomBoolVariable("pg_stat_statements.save",
 							 "Save pg_stat_statements statistics across server shutdowns.",
 							 NULL,
@@ -416,7 +456,7 @@ _PG_init(void)
 	 * resources in pgss_shmem_startup().
 	 */
 	RequestAddinShmemSpace(pgss_memsize());
-	RequestNamedLWLockTranche("pg_stat_statements", 1);
+	RequestNamedLWLockTranche("pg_stat_statements", 1 + PGSS_NUM_PARTITIONS);
 
 	/*
 	 * Install hooks.
@@ -425,6 +465,8 @@ _PG_init(void)
 	shmem_startup_hook = pgss_shmem_startup;
 	prev_post_parse_analyze_hook = post_parse_analyze_hook;
 	post_parse_analyze_hook = pgss_post_parse_analyze;
+	prev_planner_hook = planner_hook;
+	planner_hook = pgss_planner;
 	prev_ExecutorStart = ExecutorStart_hook;
 	ExecutorStart_hook = pgss_ExecutorStart;
 	prev_ExecutorRun = ExecutorRun_hook;
@@ -446,6 +488,7 @@ _PG_fini(void)
 	/* Uninstall hooks. */
 	shmem_startup_hook = prev_shmem_startup_hook;
 	post_parse_analyze_hook = prev_post_parse_analyze_hook;
+	planner_hook = prev_planner_hook;
 	ExecutorStart_hook = prev_ExecutorStart;
 	ExecutorRun_hook = prev_ExecutorRun;
 	ExecutorFinish_hook = prev_ExecutorFinish;
@@ -492,7 +535,10 @@ pgss_shmem_startup(void)
 	if (!found)
 	{
 		/* First time through ... */
-		pgss->lock = &(GetNamedLWLockTranche("pg_stat_statements"))->lock;
+		LWLockPadded *locks = GetNamedLWLockTranche("pg_stat_statements");
+
+		pgss->lock = &locks[0].lock;
+		pgss->partition_locks = &locks[1];
 		pgss->cur_median_usage = ASSUMED_MEDIAN_INIT;
 		pgss->mean_query_len = ASSUMED_LENGTH_INIT;
 		SpinLockInit(&pgss->mutex);
@@ -504,10 +550,11 @@ pgss_shmem_startup(void)
 	memset(&info, 0, sizeof(info));
 	info.keysize = sizeof(pgssHashKey);
 	info.entrysize = sizeof(pgssEntry);
+	info.num_partitions = PGSS_NUM_PARTITIONS;
 	pgss_hash = ShmemInitHash("pg_stat_statements hash",
 							  pgss_max, pgss_max,
 							  &info,
-							  HASH_ELEM | HASH_BLOBS);
+							  HASH_ELEM | HASH_BLOBS | HASH_PARTITION);
 
 	LWLockRelease(AddinShmemInitLock);
 
@@ -609,10 +656,14 @@ pgss_shmem_startup(void)
 			goto write_error;
 		pgss->extent += temp.query_len + 1;
 
-		/* make the hashtable entry (discards old entries if too many) */
+		/* discard old entries if too many, and make the hashtable entry */
+		while (hash_get_num_entries(pgss_hash) >= pgss_max)
+			entry_dealloc();
 		entry = entry_alloc(&temp.key, query_offset, temp.query_len,
 							temp.encoding,
 							false);
+		if (entry == NULL)
+			break;
 
 		/* copy in the actual stats */
 		entry->counters = temp.counters;
@@ -839,9 +890,64 @@ pgss_post_parse_analyze(ParseState *pstate, Query *query)
 				   0,
 				   0,
 				   NULL,
+				   NULL,
 				   &jstate);
 }
 
+/*
+ * Planner hook: accumulate planning time if requested
+ *
+ * Planning time is only charged to entries that already exist, which is the
+ * case whenever parse analysis found constants to normalize, or the
+ * statement has been executed before.  Planning of never-executed statements
+ * is not worth creating an entry for.
+ */
+static PlannedStmt *
+pgss_planner(Query *parse, int cursorOptions, ParamListInfo boundParams)
+{
+	PlannedStmt *result;
+
+	if (pgss_enabled() && pgss_track_planning &&
+		parse->queryId != UINT64CONST(0))
+	{
+		instr_time	start;
+		instr_time	duration;
+
+		INSTR_TIME_SET_CURRENT(start);
+
+		nested_level++;
+		PG_TRY();
+		{
+			if (prev_planner_hook)
+				result = prev_planner_hook(parse, cursorOptions, boundParams);
+			else
+				result = standard_planner(parse, cursorOptions, boundParams);
+			nested_level--;
+		}
+		PG_CATCH();
+		{
+			nested_level--;
+			PG_RE_THROW();
+		}
+		PG_END_TRY();
+
+		INSTR_TIME_SET_CURRENT(duration);
+		INSTR_TIME_SUBTRACT(duration, start);
+
+		pgss_store_plan_time(parse->queryId,
+							 INSTR_TIME_GET_MILLISEC(duration));
+	}
+	else
+	{
+		if (prev_planner_hook)
+			result = prev_planner_hook(parse, cursorOptions, boundParams);
+		else
+			result = standard_planner(parse, cursorOptions, boundParams);
+	}
+
+	return result;
+}
+
 /*
  * ExecutorStart hook: start up tracking if needed
  */
@@ -946,6 +1052,7 @@ pgss_ExecutorEnd(QueryDesc *queryDesc)
 				   queryDesc->totaltime->total * 1000.0,	/* convert to msec */
 				   queryDesc->estate->es_processed,
 				   &queryDesc->totaltime->bufusage,
+				   &queryDesc->totaltime->walusage,
 				   NULL);
 	}
 
@@ -990,8 +1097,11 @@ pgss_ProcessUtility(PlannedStmt *pstmt, const char *queryString,
 		uint64		rows;
 		BufferUsage bufusage_start,
 					bufusage;
+		WalUsage	walusage_start,
+					walusage;
 
 		bufusage_start = pgBufferUsage;
+		walusage_start = pgWalUsage;
 		INSTR_TIME_SET_CURRENT(start);
 
 		nested_level++;
@@ -1050,6 +1160,10 @@ pgss_ProcessUtility(PlannedStmt *pstmt, const char *queryString,
 		bufusage.blk_write_time = pgBufferUsage.blk_write_time;
 		INSTR_TIME_SUBTRACT(bufusage.blk_write_time, bufusage_start.blk_write_time);
 
+		/* calc differences of WAL counters. */
+		memset(&walusage, 0, sizeof(WalUsage));
+		WalUsageAccumDiff(&walusage, &pgWalUsage, &walusage_start);
+
 		pgss_store(queryString,
 				   0,			/* signal that it's a utility stmt */
 				   pstmt->stmt_location,
@@ -1057,6 +1171,7 @@ pgss_ProcessUtility(PlannedStmt *pstmt, const char *queryString,
 				   INSTR_TIME_GET_MILLISEC(duration),
 				   rows,
 				   &bufusage,
+				   &walusage,
 				   NULL);
 	}
 	else
@@ -1092,16 +1207,21 @@ pgss_hash_string(const char *str, int len)
  *
  * If jstate is not NULL then we're trying to create an entry for which
  * we have no statistics as yet; we just want to record the normalized
- * query string.  total_time, rows, bufusage are ignored in this case.
+ * query string.  total_time, rows, bufusage, walusage are ignored in this case.
  */
 static void
 pgss_store(const char *query, uint64 queryId,
 		   int query_location, int query_len,
 		   double total_time, uint64 rows,
 		   const BufferUsage *bufusage,
+		   const WalUsage *walusage,
 		   pgssJumbleState *jstate)
 {
 	pgssHashKey key;
+	uint32		hashcode;
+	LWLock	   *partitionLock;
+	bool		locked_all = false;
+	bool		locked_global = false;
 	pgssEntry  *entry;
 	char	   *norm_query = NULL;
 	int			encoding = GetDatabaseEncoding();
@@ -1155,10 +1275,18 @@ pgss_store(const char *query, uint64 queryId,
 	key.dbid = MyDatabaseId;
 	key.queryid = queryId;
 
-	/* Lookup the hash table entry with shared lock. */
-	LWLockAcquire(pgss->lock, LW_SHARED);
+	/*
+	 * Lookup the hash table entry with shared lock on its partition.  This
+	 * is all the locking needed to bump the counters of an existing entry.
+	 */
+	hashcode = get_hash_value(pgss_hash, &key);
+	partitionLock = PGSS_PARTITION_LOCK(hashcode);
+
+	LWLockAcquire(partitionLock, LW_SHARED);
 
-	entry = (pgssEntry *) hash_search(pgss_hash, &key, HASH_FIND, NULL);
+	entry = (pgssEntry *) hash_search_with_hash_value(pgss_hash, &key,
+													  hashcode,
+													  HASH_FIND, NULL);
 
 	/* Create new entry, if not present */
 	if (!entry)
@@ -1168,24 +1296,25 @@ pgss_store(const char *query, uint64 queryId,
 		bool		stored;
 		bool		do_gc;
 
+		LWLockRelease(partitionLock);
+
 		/*
 		 * Create a new, normalized query string if caller asked.  We don't
-		 * need to hold the lock while doing this work.  (Note: in any case,
+		 * need to hold any lock while doing this work.  (Note: in any case,
 		 * it's possible that someone else creates a duplicate hashtable entry
-		 * in the interval where we don't hold the lock below.  That case is
-		 * handled by entry_alloc.)
+		 * in the interval where we don't hold the partition lock below.
+		 * That case is handled by entry_alloc.)
 		 */
 		if (jstate)
-		{
-			LWLockRelease(pgss->lock);
 			norm_query = generate_normalized_query(jstate, query,
 												   query_location,
 												   &query_len,
 												   encoding);
-			LWLockAcquire(pgss->lock, LW_SHARED);
-		}
 
 		/* Append new query text to file with only shared lock held */
+		LWLockAcquire(pgss->lock, LW_SHARED);
+		locked_global = true;
+
 		stored = qtext_store(norm_query ? norm_query : query, query_len,
 							 &query_offset, &gc_count);
 
@@ -1196,32 +1325,62 @@ pgss_store(const char *query, uint64 queryId,
 		 */
 		do_gc = need_gc_qtexts();
 
-		/* Need exclusive lock to make a new hashtable entry - promote */
-		LWLockRelease(pgss->lock);
-		LWLockAcquire(pgss->lock, LW_EXCLUSIVE);
+		if (stored && !do_gc && hash_get_num_entries(pgss_hash) < pgss_max)
+		{
+			/*
+			 * Common case: there's room in the hashtable, so we can make the
+			 * entry while holding just our partition's lock exclusively.
+			 * Since we kept the shared lock on pgss->lock, no garbage
+			 * collection can have invalidated the text we stored.  Other
+			 * backends may be filling up the table concurrently, so we might
+			 * overshoot pgss_max slightly; the next deallocation will take
+			 * care of that.
+			 */
+			LWLockAcquire(partitionLock, LW_EXCLUSIVE);
+			entry = entry_alloc(&key, query_offset, query_len, encoding,
+								jstate != NULL);
+		}
+		else
+		{
+			/*
+			 * We need to make space in the hashtable, retry storing the
+			 * text, or garbage collect the texts; all of that requires
+			 * locking everything exclusively.
+			 */
+			LWLockRelease(pgss->lock);
+			locked_global = false;
+			pgss_lock_all(LW_EXCLUSIVE);
+			locked_all = true;
 
-		/*
-		 * A garbage collection may have occurred while we weren't holding the
-		 * lock.  In the unlikely event that this happens, the query text we
-		 * stored above will have been garbage collected, so write it again.
-		 * This should be infrequent enough that doing it while holding
-		 * exclusive lock isn't a performance problem.
-		 */
-		if (!stored || pgss->gc_count != gc_count)
-			stored = qtext_store(norm_query ? norm_query : query, query_len,
-								 &query_offset, NULL);
+			/*
+			 * A garbage collection may have occurred while we weren't holding
+			 * the lock.  In the unlikely event that this happens, the query
+			 * text we stored above will have been garbage collected, so write
+			 * it again.  This should be infrequent enough that doing it while
+			 * holding exclusive lock isn't a performance problem.
+			 */
+			if (!stored || pgss->gc_count != gc_count)
+				stored = qtext_store(norm_query ? norm_query : query,
+									 query_len, &query_offset, NULL);
+
+			/* If we failed to write to the text file, give up */
+			if (!stored)
+				goto done;
+
+			/* OK to create a new hashtable entry, after making space */
+			while (hash_get_num_entries(pgss_hash) >= pgss_max)
+				entry_dealloc();
+			entry = entry_alloc(&key, query_offset, query_len, encoding,
+								jstate != NULL);
+
+			/* If needed, perform garbage collection while exclusive lock held */
+			if (do_gc)
+				gc_qtexts();
+		}
 
-		/* If we failed to write to the text file, give up */
-		if (!stored)
+		/* Out of shared memory for new entries; give up */
+		if (entry == NULL)
 			goto done;
-
-		/* OK to create a new hashtable entry */
-		entry = entry_alloc(&key, query_offset, query_len, encoding,
-							jstate != NULL);
-
-		/* If needed, perform garbage collection while exclusive lock held */
-		if (do_gc)
-			gc_qtexts();
 	}
 
 	/* Increment the counts, except when jstate is not NULL */
@@ -1279,19 +1438,72 @@ pgss_store(const char *query, uint64 queryId,
 		e->counters.temp_blks_written += bufusage->temp_blks_written;
 		e->counters.blk_read_time += INSTR_TIME_GET_MILLISEC(bufusage->blk_read_time);
 		e->counters.blk_write_time += INSTR_TIME_GET_MILLISEC(bufusage->blk_write_time);
+		e->counters.wal_records += walusage->wal_records;
+		e->counters.wal_fpi += walusage->wal_fpi;
+		e->counters.wal_bytes += walusage->wal_bytes;
 		e->counters.usage += USAGE_EXEC(total_time);
 
 		SpinLockRelease(&e->mutex);
 	}
 
 done:
-	LWLockRelease(pgss->lock);
+	if (locked_all)
+		pgss_unlock_all();
+	else
+	{
+		LWLockRelease(partitionLock);
+		if (locked_global)
+			LWLockRelease(pgss->lock);
+	}
 
 	/* We postpone this clean-up until we're out of the lock */
 	if (norm_query)
 		pfree(norm_query);
 }
 
+/*
+ * Add planning time to the statistics of an already-existing entry.
+ *
+ * queryId must be the one computed at parse analysis of the statement being
+ * planned.  If there is no entry yet, we do nothing; see pgss_planner.
+ */
+static void
+pgss_store_plan_time(uint64 queryId, double plan_time)
+{
+	pgssHashKey key;
+	uint32		hashcode;
+	LWLock	   *partitionLock;
+	pgssEntry  *entry;
+
+	/* Safety check... */
+	if (!pgss || !pgss_hash)
+		return;
+
+	key.userid = GetUserId();
+	key.dbid = MyDatabaseId;
+	key.queryid = queryId;
+
+	hashcode = get_hash_value(pgss_hash, &key);
+	partitionLock = PGSS_PARTITION_LOCK(hashcode);
+
+	LWLockAcquire(partitionLock, LW_SHARED);
+
+	entry = (pgssEntry *) hash_search_with_hash_value(pgss_hash, &key,
+													  hashcode,
+													  HASH_FIND, NULL);
+	if (entry)
+	{
+		volatile pgssEntry *e = (volatile pgssEntry *) entry;
+
+		SpinLockAcquire(&e->mutex);
+		e->counters.plans += 1;
+		e->counters.total_plan_time += plan_time;
+		SpinLockRelease(&e->mutex);
+	}
+
+	LWLockRelease(partitionLock);
+}
+
 /*
  * Reset all statement statistics.
  */
@@ -1311,7 +1523,8 @@ pg_stat_statements_reset(PG_FUNCTION_ARGS)
 #define PG_STAT_STATEMENTS_COLS_V1_1	18
 #define PG_STAT_STATEMENTS_COLS_V1_2	19
 #define PG_STAT_STATEMENTS_COLS_V1_3	23
-#define PG_STAT_STATEMENTS_COLS			23	/* maximum of above */
+#define PG_STAT_STATEMENTS_COLS_V1_7	28
+#define PG_STAT_STATEMENTS_COLS			28	/* maximum of above */
 
 /*
  * Retrieve statement statistics.
@@ -1323,6 +1536,16 @@ pg_stat_statements_reset(PG_FUNCTION_ARGS)
  * expected API version is identified by embedding it in the C name of the
  * function.  Unfortunately we weren't bright enough to do that for 1.1.
  */
+Datum
+pg_stat_statements_1_7(PG_FUNCTION_ARGS)
+{
+	bool		showtext = PG_GETARG_BOOL(0);
+
+	pg_stat_statements_internal(fcinfo, PGSS_V1_7, showtext);
+
+	return (Datum) 0;
+}
+
 Datum
 pg_stat_statements_1_3(PG_FUNCTION_ARGS)
 {
@@ -1429,6 +1652,10 @@ pg_stat_statements_internal(FunctionCallInfo fcinfo,
 			if (api_version != PGSS_V1_3)
 				elog(ERROR, "incorrect number of output arguments");
 			break;
+		case PG_STAT_STATEMENTS_COLS_V1_7:
+			if (api_version != PGSS_V1_7)
+				elog(ERROR, "incorrect number of output arguments");
+			break;
 		default:
 			elog(ERROR, "incorrect number of output arguments");
 	}
@@ -1471,17 +1698,15 @@ pg_stat_statements_internal(FunctionCallInfo fcinfo,
 	}
 
 	/*
-	 * Get shared lock, load or reload the query text file if we must, and
-	 * iterate over the hashtable entries.
+	 * Lock everything in shared mode, load or reload the query text file if
+	 * we must, and iterate over the hashtable entries.
 	 *
-	 * With a large hash table, we might be holding the lock rather longer
+	 * With a large hash table, we might be holding the locks rather longer
 	 * than one could wish.  However, this only blocks creation of new hash
 	 * table entries, and the larger the hash table the less likely that is to
-	 * be needed.  So we can hope this is okay.  Perhaps someday we'll decide
-	 * we need to partition the hash table to limit the time spent holding any
-	 * one lock.
+	 * be needed.  So we can hope this is okay.
 	 */
-	LWLockAcquire(pgss->lock, LW_SHARED);
+	pgss_lock_all(LW_SHARED);
 
 	if (showtext)
 	{
@@ -1625,18 +1850,38 @@ pg_stat_statements_internal(FunctionCallInfo fcinfo,
 			values[i++] = Float8GetDatumFast(tmp.blk_read_time);
 			values[i++] = Float8GetDatumFast(tmp.blk_write_time);
 		}
+		if (api_version >= PGSS_V1_7)
+		{
+			char		buf[256];
+			Datum		wal_bytes;
+
+			values[i++] = Int64GetDatumFast(tmp.plans);
+			values[i++] = Float8GetDatumFast(tmp.total_plan_time);
+			values[i++] = Int64GetDatumFast(tmp.wal_records);
+			values[i++] = Int64GetDatumFast(tmp.wal_fpi);
+
+			snprintf(buf, sizeof buf, UINT64_FORMAT, tmp.wal_bytes);
+
+			/* Convert to numeric, since wal_bytes is unsigned */
+			wal_bytes = DirectFunctionCall3(numeric_in,
+											CStringGetDatum(buf),
+											ObjectIdGetDatum(0),
+											Int32GetDatum(-1));
+			values[i++] = wal_bytes;
+		}
 
 		Assert(i == (api_version == PGSS_V1_0 ? PG_STAT_STATEMENTS_COLS_V1_0 :
 					 api_version == PGSS_V1_1 ? PG_STAT_STATEMENTS_COLS_V1_1 :
 					 api_version == PGSS_V1_2 ? PG_STAT_STATEMENTS_COLS_V1_2 :
 					 api_version == PGSS_V1_3 ? PG_STAT_STATEMENTS_COLS_V1_3 :
+					 api_version == PGSS_V1_7 ? PG_STAT_STATEMENTS_COLS_V1_7 :
 					 -1 /* fail if you forget to update this assert */ ));
 
 		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
 	}
 
 	/* clean up and return the tuplestore */
-	LWLockRelease(pgss->lock);
+	pgss_unlock_all();
 
 	if (qbuffer)
 		free(qbuffer);
@@ -1660,7 +1905,11 @@ pgss_memsize(void)
 
 /*
  * Allocate a new hashtable entry.
- * caller must hold an exclusive lock on pgss->lock
+ * caller must hold at least a shared lock on pgss->lock, and an exclusive
+ * lock on the entry's partition (or an exclusive lock on everything)
+ *
+ * The caller is also responsible for making space first if needed; we
+ * return NULL if we run out of shared memory for new entries.
  *
  * "query" need not be null-terminated; we rely on query_len instead
  *
@@ -1682,14 +1931,10 @@ entry_alloc(pgssHashKey *key, Size query_offset, int query_len, int encoding,
 	pgssEntry  *entry;
 	bool		found;
 
-	/* Make space if needed */
-	while (hash_get_num_entries(pgss_hash) >= pgss_max)
-		entry_dealloc();
-
 	/* Find or create an entry with desired hash code */
-	entry = (pgssEntry *) hash_search(pgss_hash, key, HASH_ENTER, &found);
+	entry = (pgssEntry *) hash_search(pgss_hash, key, HASH_ENTER_NULL, &found);
 
-	if (!found)
+	if (entry && !found)
 	{
 		/* New entry, initialize it */
 
@@ -1729,7 +1974,7 @@ entry_cmp(const void *lhs, const void *rhs)
 /*
  * Deallocate least-used entries.
  *
- * Caller must hold an exclusive lock on pgss->lock.
+ * Caller must hold an exclusive lock on everything.
  */
 static void
 entry_dealloc(void)
@@ -2041,7 +2286,7 @@ need_gc_qtexts(void)
  * becomes unreasonably large, with no other method of compaction likely to
  * occur in the foreseeable future.
  *
- * The caller must hold an exclusive lock on pgss->lock.
+ * The caller must hold an exclusive lock on everything.
  *
  * At the first sign of trouble we unlink the query text file to get a clean
  * slate (although existing statistics are retained), rather than risk
@@ -2238,7 +2483,7 @@ entry_reset(void)
 	pgssEntry  *entry;
 	FILE	   *qfile;
 
-	LWLockAcquire(pgss->lock, LW_EXCLUSIVE);
+	pgss_lock_all(LW_EXCLUSIVE);
 
 	hash_seq_init(&hash_seq, pgss_hash);
 	while ((entry = hash_seq_search(&hash_seq)) != NULL)
@@ -2274,6 +2519,33 @@ done:
 	/* This counts as a query text garbage collection for our purposes */
 	record_gc_qtexts();
 
+	pgss_unlock_all();
+}
+
+/*
+ * Lock everything: pgss->lock, then all the hashtable partition locks, in
+ * the given mode.  The fixed order avoids deadlocks.
+ */
+static void
+pgss_lock_all(LWLockMode mode)
+{
+	int			i;
+
+	LWLockAcquire(pgss->lock, mode);
+	for (i = 0; i < PGSS_NUM_PARTITIONS; i++)
+		LWLockAcquire(&pgss->partition_locks[i].lock, mode);
+}
+
+/*
+ * Release the locks taken by pgss_lock_all.
+ */
+static void
+pgss_unlock_all(void)
+{
+	int			i;
+
+	for (i = PGSS_NUM_PARTITIONS; --i >= 0;)
+		LWLockRelease(&pgss->partition_locks[i].lock);
 	LWLockRelease(pgss->lock);
 }
 
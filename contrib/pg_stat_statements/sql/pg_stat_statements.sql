@@ -195,4 +195,19 @@ DROP FUNCTION PLUS_TWO(INTEGER);
 
 SELECT query, calls, rows FROM pg_stat_statements ORDER BY query COLLATE "C";
 
+--
+-- WAL usage
+--
+SET pg_stat_statements.track_utility = FALSE;
+CREATE TABLE pgss_wal_tab (a int);
+SELECT pg_stat_statements_reset();
+
+INSERT INTO pgss_wal_tab VALUES (1), (2);
+UPDATE pgss_wal_tab SET a = a + 1;
+
+SELECT query, calls, rows, wal_records > 0 AS wal_records_generated
+  FROM pg_stat_statements ORDER BY query COLLATE "C";
+
+DROP TABLE pgss_wal_tab;
+
 DROP EXTENSION pg_stat_statements;
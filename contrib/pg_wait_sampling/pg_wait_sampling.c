@@ -0,0 +1,751 @@
+/*-------------------------------------------------------------------------
+ *
+ * pg_wait_sampling.c
+ *		Continuously sample the wait events of all server processes.
+ *
+ *		A background worker wakes up every pg_wait_sampling.sample_period
+ *		milliseconds and records, for every live PGPROC, the wait event the
+ *		process is currently blocked on (or none, meaning it is running on
+ *		CPU) together with the query identifier of its top-level statement.
+ *		Samples are kept in two places in shared memory: a fixed-size ring
+ *		buffer holding the most recent individual samples, and a hashtable
+ *		counting samples per (query identifier, wait event) pair.  With a
+ *		high enough sampling rate, the latter is a cheap, always-on profile
+ *		of where the server spends its time.
+ *
+ *		Query identifiers are only available when some other module, such
+ *		as pg_stat_statements, computes them during parse analysis; each
+ *		backend publishes the identifier of its running top-level statement
+ *		in a per-PGPROC slot from the executor hooks below.
+ *
+ *	Copyright (c) 2019, PostgreSQL Global Development Group
+ *
+ *	IDENTIFICATION
+ *		contrib/pg_wait_sampling/pg_wait_sampling.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/twophase.h"
+#include "access/xact.h"
+#include "executor/executor.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "pgstat.h"
+#include "port/atomics.h"
+#include "postmaster/autovacuum.h"
+#include "postmaster/bgworker.h"
+#include "storage/ipc.h"
+#include "storage/latch.h"
+#include "storage/lwlock.h"
+#include "storage/proc.h"
+#include "storage/procsignal.h"
+#include "storage/shmem.h"
+#include "utils/builtins.h"
+#include "utils/guc.h"
+#include "utils/hsearch.h"
+#include "utils/timestamp.h"
+
+PG_MODULE_MAGIC;
+
+#define UINT32_ACCESS_ONCE(var)		 ((uint32)(*((volatile uint32 *)&(var))))
+
+/* One entry of the sample history ring buffer. */
+typedef struct pgwsHistoryItem
+{
+	TimestampTz ts;				/* when the sample was taken */
+	uint64		queryid;		/* top-level query identifier, or 0 */
+	int			pid;			/* sampled process */
+	uint32		wait_event_info;	/* wait event, or 0 if not waiting */
+} pgwsHistoryItem;
+
+/*
+ * Hashtable key of the wait event profile.  The key contains padding, so
+ * callers must zero it before filling it in; the table uses HASH_BLOBS.
+ */
+typedef struct pgwsProfileKey
+{
+	uint64		queryid;		/* top-level query identifier, or 0 */
+	uint32		wait_event_info;	/* wait event, or 0 if not waiting */
+} pgwsProfileKey;
+
+typedef struct pgwsProfileEntry
+{
+	pgwsProfileKey key;			/* hash key of entry - MUST BE FIRST */
+	int64		count;			/* # of samples */
+} pgwsProfileEntry;
+
+/*
+ * Global shared state.  The lock protects the history ring buffer and the
+ * profile hashtable; only the collector takes it in exclusive mode, apart
+ * from pg_wait_sampling_reset_profile().
+ */
+typedef struct pgwsSharedState
+{
+	LWLock	   *lock;			/* protects history and profile */
+	pid_t		collector_pid;	/* PID of the collector, or InvalidPid */
+	uint64		history_next;	/* # of samples ever added to history */
+	int			num_procs;		/* length of queryids[] */
+	pg_atomic_uint64 *queryids; /* per-PGPROC current top-level queryid */
+	pgwsHistoryItem *history;	/* ring buffer of history_size items */
+} pgwsSharedState;
+
+void		_PG_init(void);
+void		_PG_fini(void);
+void		pg_wait_sampling_main(Datum main_arg);
+
+PG_FUNCTION_INFO_V1(pg_wait_sampling_get_history);
+PG_FUNCTION_INFO_V1(pg_wait_sampling_get_profile);
+PG_FUNCTION_INFO_V1(pg_wait_sampling_reset_profile);
+
+static void pgws_shmem_startup(void);
+static Size pgws_memsize(void);
+static int	pgws_max_procs(void);
+static void pgws_collect_samples(void);
+static void pgws_set_queryid(uint64 queryid);
+static void pgws_xact_callback(XactEvent event, void *arg);
+static void pgws_ExecutorStart(QueryDesc *queryDesc, int eflags);
+static void pgws_ExecutorRun(QueryDesc *queryDesc,
+				 ScanDirection direction,
+				 uint64 count, bool execute_once);
+static void pgws_ExecutorFinish(QueryDesc *queryDesc);
+static void pgws_ExecutorEnd(QueryDesc *queryDesc);
+static void pgws_sigterm_handler(SIGNAL_ARGS);
+static void pgws_sighup_handler(SIGNAL_ARGS);
+static void pgws_check_state(void);
+static void pgws_wait_event_values(uint32 wait_event_info, Datum *values,
+					   bool *nulls);
+static Tuplestorestate *pgws_init_tuplestore(FunctionCallInfo fcinfo,
+					 TupleDesc *tupdesc);
+
+/* Flags set by signal handlers */
+static volatile sig_atomic_t got_sigterm = false;
+static volatile sig_atomic_t got_sighup = false;
+
+/* Saved hook values in case of unload */
+static shmem_startup_hook_type prev_shmem_startup_hook = NULL;
+static ExecutorStart_hook_type prev_ExecutorStart = NULL;
+static ExecutorRun_hook_type prev_ExecutorRun = NULL;
+static ExecutorFinish_hook_type prev_ExecutorFinish = NULL;
+static ExecutorEnd_hook_type prev_ExecutorEnd = NULL;
+
+/* Current nesting depth of ExecutorRun+ExecutorFinish calls */
+static int	nested_level = 0;
+
+/* Links to shared memory state */
+static pgwsSharedState *pgws = NULL;
+static HTAB *pgws_profile = NULL;
+
+/* GUC variables */
+static int	pgws_sample_period;	/* sampling interval, in msec */
+static int	pgws_history_size;	/* # of samples kept in history */
+static int	pgws_profile_max;	/* max # of profile entries */
+
+/*
+ * Module load callback
+ */
+void
+_PG_init(void)
+{
+	BackgroundWorker worker;
+
+	/*
+	 * We need shared memory and a background worker, so we have to be loaded
+	 * via shared_preload_libraries.  As with pg_stat_statements, don't throw
+	 * an error if we're not, so that the SQL objects can still be created;
+	 * the functions complain when called.
+	 */
+	if (!process_shared_preload_libraries_in_progress)
+		return;
+
+	DefineCustomIntVariable("pg_wait_sampling.sample_period",
+							"Sets the interval between wait event samples.",
+							NULL,
+							&pgws_sample_period,
+							10,
+							1,
+							1000,
+							PGC_SIGHUP,
+							GUC_UNIT_MS,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable("pg_wait_sampling.history_size",
+							"Sets the number of recent samples kept in the history.",
+							NULL,
+							&pgws_history_size,
+							5000,
+							100,
+							INT_MAX / 2,
+							PGC_POSTMASTER,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable("pg_wait_sampling.profile_max",
+							"Sets the maximum number of entries in the wait event profile.",
+							NULL,
+							&pgws_profile_max,
+							5000,
+							100,
+							INT_MAX,
+							PGC_POSTMASTER,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	EmitWarningsOnPlaceholders("pg_wait_sampling");
+
+	RequestAddinShmemSpace(pgws_memsize());
+	RequestNamedLWLockTranche("pg_wait_sampling", 1);
+
+	/* Register the collector */
+	MemSet(&worker, 0, sizeof(BackgroundWorker));
+	worker.bgw_flags = BGWORKER_SHMEM_ACCESS;
+	worker.bgw_start_time = BgWorkerStart_PostmasterStart;
+	worker.bgw_restart_time = 10;
+	strcpy(worker.bgw_library_name, "pg_wait_sampling");
+	strcpy(worker.bgw_function_name, "pg_wait_sampling_main");
+	strcpy(worker.bgw_name, "pg_wait_sampling collector");
+	strcpy(worker.bgw_type, "pg_wait_sampling collector");
+	RegisterBackgroundWorker(&worker);
+
+	/*
+	 * Install hooks.
+	 */
+	prev_shmem_startup_hook = shmem_startup_hook;
+	shmem_startup_hook = pgws_shmem_startup;
+	prev_ExecutorStart = ExecutorStart_hook;
+	ExecutorStart_hook = pgws_ExecutorStart;
+	prev_ExecutorRun = ExecutorRun_hook;
+	ExecutorRun_hook = pgws_ExecutorRun;
+	prev_ExecutorFinish = ExecutorFinish_hook;
+	ExecutorFinish_hook = pgws_ExecutorFinish;
+	prev_ExecutorEnd = ExecutorEnd_hook;
+	ExecutorEnd_hook = pgws_ExecutorEnd;
+
+	RegisterXactCallback(pgws_xact_callback, NULL);
+}
+
+/*
+ * Module unload callback
+ */
+void
+_PG_fini(void)
+{
+	/* Uninstall hooks. */
+	shmem_startup_hook = prev_shmem_startup_hook;
+	ExecutorStart_hook = prev_ExecutorStart;
+	ExecutorRun_hook = prev_ExecutorRun;
+	ExecutorFinish_hook = prev_ExecutorFinish;
+	ExecutorEnd_hook = prev_ExecutorEnd;
+
+	UnregisterXactCallback(pgws_xact_callback, NULL);
+}
+
+/*
+ * Number of PGPROCs we may have to publish a query identifier for.
+ *
+ * This has to match ProcGlobal->allProcCount, but we need it in _PG_init(),
+ * before MaxBackends has been computed, so spell out the same formula.
+ */
+static int
+pgws_max_procs(void)
+{
+	/* the extra unit accounts for the autovacuum launcher */
+	return MaxConnections + autovacuum_max_workers + 1 +
+		max_worker_processes + NUM_AUXILIARY_PROCS + max_prepared_xacts;
+}
+
+/*
+ * Estimate shared memory space needed.
+ */
+static Size
+pgws_memsize(void)
+{
+	Size		size;
+
+	size = MAXALIGN(sizeof(pgwsSharedState));
+	size = add_size(size, MAXALIGN(mul_size(pgws_max_procs(),
+											sizeof(pg_atomic_uint64))));
+	size = add_size(size, mul_size(pgws_history_size,
+								   sizeof(pgwsHistoryItem)));
+	size = add_size(size, hash_estimate_size(pgws_profile_max,
+											 sizeof(pgwsProfileEntry)));
+
+	return size;
+}
+
+/*
+ * shmem_startup hook: allocate or attach to shared memory.
+ */
+static void
+pgws_shmem_startup(void)
+{
+	bool		found;
+	HASHCTL		info;
+
+	if (prev_shmem_startup_hook)
+		prev_shmem_startup_hook();
+
+	/* reset in case this is a restart within the postmaster */
+	pgws = NULL;
+	pgws_profile = NULL;
+
+	LWLockAcquire(AddinShmemInitLock, LW_EXCLUSIVE);
+
+	pgws = ShmemInitStruct("pg_wait_sampling",
+						   MAXALIGN(sizeof(pgwsSharedState)) +
+						   MAXALIGN(mul_size(pgws_max_procs(),
+											 sizeof(pg_atomic_uint64))) +
+						   mul_size(pgws_history_size,
+									sizeof(pgwsHistoryItem)),
+						   &found);
+
+	if (!found)
+	{
+		char	   *ptr = (char *) pgws;
+		int			i;
+
+		/* First time through ... */
+		pgws->lock = &(GetNamedLWLockTranche("pg_wait_sampling"))->lock;
+		pgws->collector_pid = InvalidPid;
+		pgws->history_next = 0;
+		pgws->num_procs = pgws_max_procs();
+
+		ptr += MAXALIGN(sizeof(pgwsSharedState));
+		pgws->queryids = (pg_atomic_uint64 *) ptr;
+		for (i = 0; i < pgws->num_procs; i++)
+			pg_atomic_init_u64(&pgws->queryids[i], 0);
+
+		ptr += MAXALIGN(mul_size(pgws->num_procs, sizeof(pg_atomic_uint64)));
+		pgws->history = (pgwsHistoryItem *) ptr;
+	}
+
+	memset(&info, 0, sizeof(info));
+	info.keysize = sizeof(pgwsProfileKey);
+	info.entrysize = sizeof(pgwsProfileEntry);
+	pgws_profile = ShmemInitHash("pg_wait_sampling profile",
+								 pgws_profile_max, pgws_profile_max,
+								 &info,
+								 HASH_ELEM | HASH_BLOBS);
+
+	LWLockRelease(AddinShmemInitLock);
+}
+
+/*
+ * Main entry point of the collector process.
+ */
+void
+pg_wait_sampling_main(Datum main_arg)
+{
+	/* Establish signal handlers; once that's done, unblock signals. */
+	pqsignal(SIGTERM, pgws_sigterm_handler);
+	pqsignal(SIGHUP, pgws_sighup_handler);
+	pqsignal(SIGUSR1, procsignal_sigusr1_handler);
+	BackgroundWorkerUnblockSignals();
+
+	/* Shared memory must have been set up by our shmem_startup hook */
+	if (!pgws || !pgws_profile)
+		elog(ERROR, "pg_wait_sampling shared memory is not initialized");
+
+	LWLockAcquire(pgws->lock, LW_EXCLUSIVE);
+	pgws->collector_pid = MyProcPid;
+	LWLockRelease(pgws->lock);
+
+	while (!got_sigterm)
+	{
+		/* In case of a SIGHUP, just reload the configuration. */
+		if (got_sighup)
+		{
+			got_sighup = false;
+			ProcessConfigFile(PGC_SIGHUP);
+		}
+
+		pgws_collect_samples();
+
+		(void) WaitLatch(&MyProc->procLatch,
+						 WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+						 pgws_sample_period,
+						 PG_WAIT_EXTENSION);
+		ResetLatch(&MyProc->procLatch);
+	}
+
+	LWLockAcquire(pgws->lock, LW_EXCLUSIVE);
+	pgws->collector_pid = InvalidPid;
+	LWLockRelease(pgws->lock);
+}
+
+/*
+ * Take one sample of every live process, other than ourselves.
+ *
+ * We read pid and wait_event_info without any lock, as pg_stat_activity
+ * does; a process that exits or changes state concurrently just yields a
+ * slightly stale sample.
+ */
+static void
+pgws_collect_samples(void)
+{
+	TimestampTz now = GetCurrentTimestamp();
+	int			num_procs = Min(ProcGlobal->allProcCount, pgws->num_procs);
+	int			i;
+
+	LWLockAcquire(pgws->lock, LW_EXCLUSIVE);
+
+	for (i = 0; i < num_procs; i++)
+	{
+		PGPROC	   *proc = &ProcGlobal->allProcs[i];
+		int			pid = proc->pid;
+		pgwsHistoryItem *item;
+		pgwsProfileKey key;
+		pgwsProfileEntry *entry;
+		bool		found;
+
+		if (pid == 0 || pid == MyProcPid)
+			continue;
+
+		item = &pgws->history[pgws->history_next % pgws_history_size];
+		item->ts = now;
+		item->pid = pid;
+		item->wait_event_info = UINT32_ACCESS_ONCE(proc->wait_event_info);
+		item->queryid = pg_atomic_read_u64(&pgws->queryids[i]);
+		pgws->history_next++;
+
+		memset(&key, 0, sizeof(key));
+		key.queryid = item->queryid;
+		key.wait_event_info = item->wait_event_info;
+
+		/* Once the profile is full, samples of new pairs are dropped */
+		entry = (pgwsProfileEntry *) hash_search(pgws_profile, &key,
+												 HASH_ENTER_NULL, &found);
+		if (entry == NULL)
+			continue;
+		if (!found)
+			entry->count = 0;
+		entry->count++;
+	}
+
+	LWLockRelease(pgws->lock);
+}
+
+/*
+ * Publish the query identifier of our running top-level statement.
+ */
+static void
+pgws_set_queryid(uint64 queryid)
+{
+	if (pgws && MyProc && MyProc->pgprocno < pgws->num_procs)
+		pg_atomic_write_u64(&pgws->queryids[MyProc->pgprocno], queryid);
+}
+
+/*
+ * Clear the published query identifier if the statement errored out.
+ */
+static void
+pgws_xact_callback(XactEvent event, void *arg)
+{
+	if (event == XACT_EVENT_ABORT || event == XACT_EVENT_PARALLEL_ABORT)
+		pgws_set_queryid(UINT64CONST(0));
+}
+
+/*
+ * ExecutorStart hook: publish the query identifier of top-level statements
+ */
+static void
+pgws_ExecutorStart(QueryDesc *queryDesc, int eflags)
+{
+	if (nested_level == 0)
+		pgws_set_queryid(queryDesc->plannedstmt->queryId);
+
+	if (prev_ExecutorStart)
+		prev_ExecutorStart(queryDesc, eflags);
+	else
+		standard_ExecutorStart(queryDesc, eflags);
+}
+
+/*
+ * ExecutorRun hook: all we need do is track nesting depth
+ */
+static void
+pgws_ExecutorRun(QueryDesc *queryDesc, ScanDirection direction, uint64 count,
+				 bool execute_once)
+{
+	nested_level++;
+	PG_TRY();
+	{
+		if (prev_ExecutorRun)
+			prev_ExecutorRun(queryDesc, direction, count, execute_once);
+		else
+			standard_ExecutorRun(queryDesc, direction, count, execute_once);
+		nested_level--;
+	}
+	PG_CATCH();
+	{
+		nested_level--;
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+}
+
+/*
+ * ExecutorFinish hook: all we need do is track nesting depth
+ */
+static void
+pgws_ExecutorFinish(QueryDesc *queryDesc)
+{
+	nested_level++;
+	PG_TRY();
+	{
+		if (prev_ExecutorFinish)
+			prev_ExecutorFinish(queryDesc);
+		else
+			standard_ExecutorFinish(queryDesc);
+		nested_level--;
+	}
+	PG_CATCH();
+	{
+		nested_level--;
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+}
+
+/*
+ * ExecutorEnd hook: top-level statement is done
+ */
+static void
+pgws_ExecutorEnd(QueryDesc *queryDesc)
+{
+	if (prev_ExecutorEnd)
+		prev_ExecutorEnd(queryDesc);
+	else
+		standard_ExecutorEnd(queryDesc);
+
+	if (nested_level == 0)
+		pgws_set_queryid(UINT64CONST(0));
+}
+
+/*
+ * Signal handler for SIGTERM
+ */
+static void
+pgws_sigterm_handler(SIGNAL_ARGS)
+{
+	int			save_errno = errno;
+
+	got_sigterm = true;
+
+	if (MyProc)
+		SetLatch(&MyProc->procLatch);
+
+	errno = save_errno;
+}
+
+/*
+ * Signal handler for SIGHUP
+ */
+static void
+pgws_sighup_handler(SIGNAL_ARGS)
+{
+	int			save_errno = errno;
+
+	got_sighup = true;
+
+	if (MyProc)
+		SetLatch(&MyProc->procLatch);
+
+	errno = save_errno;
+}
+
+/*
+ * Complain if we were not loaded via shared_preload_libraries.
+ */
+static void
+pgws_check_state(void)
+{
+	if (!pgws || !pgws_profile)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("pg_wait_sampling must be loaded via shared_preload_libraries")));
+}
+
+/*
+ * Set up a tuplestore to return the result of a set-returning function.
+ */
+static Tuplestorestate *
+pgws_init_tuplestore(FunctionCallInfo fcinfo, TupleDesc *tupdesc)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	Tuplestorestate *tupstore;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not " \
+						"allowed in this context")));
+
+	/* Switch into long-lived context to construct returned data structures */
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = *tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	return tupstore;
+}
+
+/*
+ * Fill in the wait event type and name columns for a sample.
+ */
+static void
+pgws_wait_event_values(uint32 wait_event_info, Datum *values, bool *nulls)
+{
+	const char *event_type = pgstat_get_wait_event_type(wait_event_info);
+	const char *event = pgstat_get_wait_event(wait_event_info);
+
+	/* A zero wait_event_info means that the process was not waiting */
+	if (event_type)
+		values[0] = CStringGetTextDatum(event_type);
+	else
+		nulls[0] = true;
+	if (event)
+		values[1] = CStringGetTextDatum(event);
+	else
+		nulls[1] = true;
+}
+
+/*
+ * Return the samples currently in the history ring buffer, oldest first.
+ */
+Datum
+pg_wait_sampling_get_history(PG_FUNCTION_ARGS)
+{
+#define PG_WAIT_SAMPLING_HISTORY_COLS	5
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	pgwsHistoryItem *items;
+	uint64		first;
+	uint64		next;
+	uint64		n;
+
+	pgws_check_state();
+
+	tupstore = pgws_init_tuplestore(fcinfo, &tupdesc);
+
+	/* Copy the ring buffer, so as not to hold the lock while building tuples */
+	items = palloc(mul_size(pgws_history_size, sizeof(pgwsHistoryItem)));
+
+	LWLockAcquire(pgws->lock, LW_SHARED);
+	next = pgws->history_next;
+	first = (next > pgws_history_size) ? next - pgws_history_size : 0;
+	for (n = first; n < next; n++)
+		items[n - first] = pgws->history[n % pgws_history_size];
+	LWLockRelease(pgws->lock);
+
+	for (n = 0; n < next - first; n++)
+	{
+		Datum		values[PG_WAIT_SAMPLING_HISTORY_COLS];
+		bool		nulls[PG_WAIT_SAMPLING_HISTORY_COLS];
+
+		memset(values, 0, sizeof(values));
+		memset(nulls, 0, sizeof(nulls));
+
+		values[0] = Int32GetDatum(items[n].pid);
+		values[1] = TimestampTzGetDatum(items[n].ts);
+		pgws_wait_event_values(items[n].wait_event_info, &values[2], &nulls[2]);
+		values[4] = Int64GetDatum((int64) items[n].queryid);
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	pfree(items);
+
+	/* clean up and return the tuplestore */
+	tuplestore_donestoring(tupstore);
+
+	return (Datum) 0;
+}
+
+/*
+ * Return the sample counts per query identifier and wait event.
+ */
+Datum
+pg_wait_sampling_get_profile(PG_FUNCTION_ARGS)
+{
+#define PG_WAIT_SAMPLING_PROFILE_COLS	4
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	HASH_SEQ_STATUS hash_seq;
+	pgwsProfileEntry *entry;
+
+	pgws_check_state();
+
+	tupstore = pgws_init_tuplestore(fcinfo, &tupdesc);
+
+	LWLockAcquire(pgws->lock, LW_SHARED);
+
+	hash_seq_init(&hash_seq, pgws_profile);
+	while ((entry = hash_seq_search(&hash_seq)) != NULL)
+	{
+		Datum		values[PG_WAIT_SAMPLING_PROFILE_COLS];
+		bool		nulls[PG_WAIT_SAMPLING_PROFILE_COLS];
+
+		memset(values, 0, sizeof(values));
+		memset(nulls, 0, sizeof(nulls));
+
+		pgws_wait_event_values(entry->key.wait_event_info, &values[0], &nulls[0]);
+		values[2] = Int64GetDatum((int64) entry->key.queryid);
+		values[3] = Int64GetDatum(entry->count);
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	LWLockRelease(pgws->lock);
+
+	/* clean up and return the tuplestore */
+	tuplestore_donestoring(tupstore);
+
+	return (Datum) 0;
+}
+
+/*
+ * Discard the accumulated profile.
+ */
+Datum
+pg_wait_sampling_reset_profile(PG_FUNCTION_ARGS)
+{
+	HASH_SEQ_STATUS hash_seq;
+	pgwsProfileEntry *entry;
+
+	pgws_check_state();
+
+	LWLockAcquire(pgws->lock, LW_EXCLUSIVE);
+
+	hash_seq_init(&hash_seq, pgws_profile);
+	while ((entry = hash_seq_search(&hash_seq)) != NULL)
+		hash_search(pgws_profile, &entry->key, HASH_REMOVE, NULL);
+
+	LWLockRelease(pgws->lock);
+
+	PG_RETURN_VOID();
+}
@@ -54,6 +54,7 @@
 #include "optimizer/var.h"
 #include "parser/parsetree.h"
 #include "utils/builtins.h"
+#include "utils/fmgroids.h"
 #include "utils/lsyscache.h"
 #include "utils/rel.h"
 #include "utils/syscache.h"
@@ -91,6 +92,17 @@ typedef struct foreign_loc_cxt
 	FDWCollateState state;		/* state of current collation choice */
 } foreign_loc_cxt;
 
+/*
+ * How the remote server can produce the transition state of a partial
+ * aggregate (see partial_agg_kind).
+ */
+typedef enum
+{
+	PARTIAL_AGG_UNSAFE,			/* state can't be computed remotely */
+	PARTIAL_AGG_PLAIN,			/* state is the plain aggregate's result */
+	PARTIAL_AGG_INT_AVG			/* avg(int2/int4): {count, sum} int8 array */
+} PartialAggKind;
+
 /*
  * Context for deparseExpr
  */
@@ -120,6 +132,7 @@ static bool foreign_expr_walker(Node *node,
 					foreign_glob_cxt *glob_cxt,
 					foreign_loc_cxt *outer_cxt);
 static char *deparse_type_name(Oid type_oid, int32 typemod);
+static PartialAggKind partial_agg_kind(Aggref *agg);
 
 /*
  * Functions to construct string representation of a node tree.
@@ -179,6 +192,8 @@ static void deparseRangeTblRef(StringInfo buf, PlannerInfo *root,
 				   RelOptInfo *foreignrel, bool make_subquery,
 				   Index ignore_rel, List **ignore_conds, List **params_list);
 static void deparseAggref(Aggref *node, deparse_expr_cxt *context);
+static void deparseAggCall(Aggref *node, const char *funcname,
+			   deparse_expr_cxt *context);
 static void appendGroupByClause(List *tlist, deparse_expr_cxt *context);
 static void appendAggOrderBy(List *orderList, List *targetList,
 				 deparse_expr_cxt *context);
@@ -684,8 +699,14 @@ foreign_expr_walker(Node *node,
 				if (!IS_UPPER_REL(glob_cxt->foreignrel))
 					return false;
 
-				/* Only non-split aggregates are pushable. */
-				if (agg->aggsplit != AGGSPLIT_SIMPLE)
+				/*
+				 * Only non-split aggregates are pushable, plus the partial
+				 * step of a split aggregate when the remote server knows how
+				 * to compute its transition state.
+				 */
+				if (agg->aggsplit != AGGSPLIT_SIMPLE &&
+					(agg->aggsplit != AGGSPLIT_INITIAL_SERIAL ||
+					 partial_agg_kind(agg) == PARTIAL_AGG_UNSAFE))
 					return false;
 
 				/* As usual, it must be shippable. */
@@ -862,6 +883,50 @@ deparse_type_name(Oid type_oid, int32 typemod)
 	return format_type_extended(type_oid, typemod, flags);
 }
 
+/*
+ * Determine whether, and how, the remote server can compute the transition
+ * state of the given partial aggregate.
+ *
+ * An aggregate without a final function whose transition type is its result
+ * type (count, sum of integers, min, max and the like) returns its state
+ * unchanged, so the plain aggregate can be sent.  avg() over int2 and int4
+ * keeps {count, sum} in an int8 array, which we build from count() and sum().
+ * Anything else, in particular aggregates with an internal state, has to be
+ * computed locally.
+ */
+static PartialAggKind
+partial_agg_kind(Aggref *agg)
+{
+	HeapTuple	aggtup;
+	Form_pg_aggregate aggform;
+	PartialAggKind kind = PARTIAL_AGG_UNSAFE;
+
+	/* The partial step is never generated for these, but be safe. */
+	if (agg->aggdistinct != NIL || agg->aggorder != NIL ||
+		AGGKIND_IS_ORDERED_SET(agg->aggkind))
+		return PARTIAL_AGG_UNSAFE;
+
+	aggtup = SearchSysCache1(AGGFNOID, ObjectIdGetDatum(agg->aggfnoid));
+	if (!HeapTupleIsValid(aggtup))
+		elog(ERROR, "cache lookup failed for aggregate %u", agg->aggfnoid);
+	aggform = (Form_pg_aggregate) GETSTRUCT(aggtup);
+
+	if (!OidIsValid(aggform->aggcombinefn))
+		kind = PARTIAL_AGG_UNSAFE;
+	else if (!OidIsValid(aggform->aggfinalfn) &&
+			 aggform->aggtranstype != INTERNALOID &&
+			 aggform->aggtranstype == get_func_rettype(agg->aggfnoid))
+		kind = PARTIAL_AGG_PLAIN;
+	else if ((aggform->aggtransfn == F_INT2_AVG_ACCUM ||
+			  aggform->aggtransfn == F_INT4_AVG_ACCUM) &&
+			 aggform->aggfinalfn == F_INT8_AVG)
+		kind = PARTIAL_AGG_INT_AVG;
+
+	ReleaseSysCache(aggtup);
+
+	return kind;
+}
+
 /*
  * Build the targetlist for given relation to be deparsed as SELECT clause.
  *
@@ -1637,7 +1702,7 @@ deparseInsertSql(StringInfo buf, RangeTblEntry *rte,
 				 Index rtindex, Relation rel,
 				 List *targetAttrs, bool doNothing,
 				 List *withCheckOptionList, List *returningList,
-				 List **retrieved_attrs)
+				 List **retrieved_attrs, int *values_end_len)
 {
 	AttrNumber	pindex;
 	bool		first;
@@ -1680,6 +1745,7 @@ deparseInsertSql(StringInfo buf, RangeTblEntry *rte,
 	}
 	else
 		appendStringInfoString(buf, " DEFAULT VALUES");
+	*values_end_len = buf->len;
 
 	if (doNothing)
 		appendStringInfoString(buf, " ON CONFLICT DO NOTHING");
@@ -1689,6 +1755,54 @@ deparseInsertSql(StringInfo buf, RangeTblEntry *rte,
 						 withCheckOptionList, returningList, retrieved_attrs);
 }
 
+/*
+ * rebuild remote INSERT statement
+ *
+ * Given an INSERT deparsed by deparseInsertSql for a single row, build the
+ * same statement with num_rows rows in its VALUES clause, numbering the
+ * parameters of each added row after those of the previous one.
+ * values_end_len is the length of orig_query up to the end of the VALUES
+ * clause, as reported by deparseInsertSql.
+ */
+void
+rebuildInsertSql(StringInfo buf, char *orig_query,
+				 int values_end_len, int num_cols,
+				 int num_rows)
+{
+	int			i;
+	int			j;
+	int			pindex;
+	bool		first;
+
+	Assert(values_end_len > 0 && values_end_len <= strlen(orig_query));
+
+	/* Copy the original query up to the end of the first row */
+	appendBinaryStringInfo(buf, orig_query, values_end_len);
+
+	/* Add the remaining rows; parameters of the first one are there */
+	pindex = num_cols + 1;
+	for (i = 1; i < num_rows; i++)
+	{
+		appendStringInfoString(buf, ", (");
+
+		first = true;
+		for (j = 0; j < num_cols; j++)
+		{
+			if (!first)
+				appendStringInfoString(buf, ", ");
+			first = false;
+
+			appendStringInfo(buf, "$%d", pindex);
+			pindex++;
+		}
+
+		appendStringInfoChar(buf, ')');
+	}
+
+	/* Copy whatever followed the VALUES clause */
+	appendStringInfoString(buf, orig_query + values_end_len);
+}
+
 /*
  * deparse remote UPDATE statement
  *
@@ -2881,21 +2995,55 @@ deparseArrayExpr(ArrayExpr *node, deparse_expr_cxt *context)
 
 /*
  * Deparse an Aggref node.
+ *
+ * For the partial step of a split aggregate, emit an expression producing
+ * its transition state; see partial_agg_kind.
  */
 static void
 deparseAggref(Aggref *node, deparse_expr_cxt *context)
 {
 	StringInfo	buf = context->buf;
-	bool		use_variadic;
 
-	/* Only basic, non-split aggregation accepted. */
-	Assert(node->aggsplit == AGGSPLIT_SIMPLE);
+	/* Only basic aggregation, or its partial step, accepted. */
+	Assert(node->aggsplit == AGGSPLIT_SIMPLE ||
+		   node->aggsplit == AGGSPLIT_INITIAL_SERIAL);
+
+	if (node->aggsplit == AGGSPLIT_INITIAL_SERIAL &&
+		partial_agg_kind(node) == PARTIAL_AGG_INT_AVG)
+	{
+		/*
+		 * The remote session runs with search_path = pg_catalog, so the
+		 * built-in count() and sum() need no qualification.  sum() yields
+		 * NULL for an empty group, whereas the state's sum starts at zero.
+		 */
+		appendStringInfoString(buf, "ARRAY[");
+		deparseAggCall(node, "count", context);
+		appendStringInfoString(buf, ", COALESCE(");
+		deparseAggCall(node, "sum", context);
+		appendStringInfoString(buf, ", 0)]");
+	}
+	else
+		deparseAggCall(node, NULL, context);
+}
+
+/*
+ * Deparse a call of the aggregate described by an Aggref node.  If funcname
+ * is not NULL, it is called in place of the Aggref's own aggregate.
+ */
+static void
+deparseAggCall(Aggref *node, const char *funcname, deparse_expr_cxt *context)
+{
+	StringInfo	buf = context->buf;
+	bool		use_variadic;
 
 	/* Check if need to print VARIADIC (cf. ruleutils.c) */
 	use_variadic = node->aggvariadic;
 
 	/* Find aggregate name from aggfnoid which is a pg_proc entry */
-	appendFunctionName(node->aggfnoid, context);
+	if (funcname)
+		appendStringInfoString(buf, funcname);
+	else
+		appendFunctionName(node->aggfnoid, context);
 	appendStringInfoChar(buf, '(');
 
 	/* Add DISTINCT */
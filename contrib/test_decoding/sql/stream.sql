@@ -0,0 +1,33 @@
+-- predictability
+SET synchronous_commit = on;
+SET logical_decoding_work_mem = '64kB';
+
+SELECT 'init' FROM pg_create_logical_replication_slot('regression_slot', 'test_decoding');
+
+CREATE TABLE stream_test(data text);
+
+-- consume DDL
+SELECT data FROM pg_logical_slot_get_changes('regression_slot', NULL, NULL, 'include-xids', '0', 'skip-empty-xacts', '1');
+
+-- streaming test with sub-transaction
+BEGIN;
+INSERT INTO stream_test SELECT 'stream-topbig--1:'||g.i FROM generate_series(1, 2000) g(i);
+SAVEPOINT s1;
+INSERT INTO stream_test SELECT 'stream-subbig--1:'||g.i FROM generate_series(1, 2000) g(i);
+ROLLBACK TO s1;
+INSERT INTO stream_test SELECT 'stream-topbig--2:'||g.i FROM generate_series(1, 2000) g(i);
+COMMIT;
+SELECT data FROM (
+  SELECT DISTINCT data FROM pg_logical_slot_get_changes('regression_slot', NULL, NULL,
+    'include-xids', '0', 'skip-empty-xacts', '1', 'stream-changes', '1')
+) s ORDER BY data;
+
+-- the changes of a transaction that isn't streamed are still decoded at commit
+BEGIN;
+INSERT INTO stream_test VALUES ('stream-small');
+COMMIT;
+SELECT data FROM pg_logical_slot_get_changes('regression_slot', NULL, NULL,
+  'include-xids', '0', 'skip-empty-xacts', '1', 'stream-changes', '1');
+
+DROP TABLE stream_test;
+SELECT pg_drop_replication_slot('regression_slot');
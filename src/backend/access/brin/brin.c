@@ -19,20 +19,35 @@
 #include "access/brin_page.h"
 #include "access/brin_pageops.h"
 #include "access/brin_xlog.h"
+#include "access/parallel.h"
 #include "access/reloptions.h"
 #include "access/relscan.h"
+#include "access/xact.h"
 #include "access/xloginsert.h"
 #include "catalog/index.h"
 #include "catalog/pg_am.h"
 #include "miscadmin.h"
 #include "pgstat.h"
+#include "port/atomics.h"
 #include "postmaster/autovacuum.h"
 #include "storage/bufmgr.h"
+#include "storage/buffile.h"
+#include "storage/condition_variable.h"
 #include "storage/freespace.h"
+#include "storage/sharedfileset.h"
+#include "storage/spin.h"
+#include "tcop/tcopprot.h"		/* pgrminclude ignore */
 #include "utils/builtins.h"
 #include "utils/index_selfuncs.h"
 #include "utils/memutils.h"
 #include "utils/rel.h"
+#include "utils/snapmgr.h"
+
+
+/* Magic numbers for parallel state sharing */
+#define PARALLEL_KEY_BRIN_SHARED		UINT64CONST(0xF000000000000001)
+#define PARALLEL_KEY_SNAPSHOT			UINT64CONST(0xF000000000000002)
+#define PARALLEL_KEY_QUERY_TEXT			UINT64CONST(0xF000000000000003)
 
 
 /*
@@ -49,8 +64,86 @@ typedef struct BrinBuildState
 	BrinRevmap *bs_rmAccess;
 	BrinDesc   *bs_bdesc;
 	BrinMemTuple *bs_dtuple;
+	BufFile    *bs_spool;		/* in a parallel worker, where tuples go */
 } BrinBuildState;
 
+/*
+ * Status for index builds performed in parallel.  This is allocated in a
+ * dynamic shared memory segment.
+ *
+ * Each participant repeatedly claims the next page range that hasn't been
+ * summarized yet, and summarizes it with a scan of just that range, so every
+ * range is summarized by exactly one participant.  Only the leader writes to
+ * the index: workers write the tuples they form to a temporary file of their
+ * own in the shared fileset, and the leader inserts them once all ranges are
+ * done.
+ */
+typedef struct BrinShared
+{
+	/*
+	 * These fields are not modified during the build.  They primarily exist
+	 * for the benefit of worker processes that need to create state
+	 * corresponding to that used by the leader.
+	 */
+	Oid			heaprelid;
+	Oid			indexrelid;
+	bool		isconcurrent;
+	BlockNumber pagesPerRange;
+	BlockNumber heapNumBlocks;
+	uint32		nranges;
+
+	/* Temporary files holding the tuples formed by workers */
+	SharedFileSet fileset;
+
+	/* Next page range to be claimed by a participant */
+	pg_atomic_uint32 nextrange;
+
+	/*
+	 * workersdonecv is used to monitor the progress of workers.  All parallel
+	 * participants must indicate that they are done before leader can insert
+	 * the workers' tuples.
+	 */
+	ConditionVariable workersdonecv;
+
+	/*
+	 * mutex protects the fields below, which are maintained by participants,
+	 * and reported back to leader at end of the build.
+	 *
+	 * nparticipantsdone is number of worker processes finished.
+	 *
+	 * reltuples is the total number of input heap tuples.
+	 *
+	 * brokenhotchain indicates if any worker detected a broken HOT chain
+	 * during build.
+	 */
+	slock_t		mutex;
+	int			nparticipantsdone;
+	double		reltuples;
+	bool		brokenhotchain;
+} BrinShared;
+
+/*
+ * Status for leader in parallel index build.
+ */
+typedef struct BrinLeader
+{
+	/* parallel context itself */
+	ParallelContext *pcxt;
+
+	/*
+	 * nparticipants is the exact number of worker processes successfully
+	 * launched, plus one leader process if it participates as a worker.
+	 */
+	int			nparticipants;
+
+	/*
+	 * Leader process convenience pointers to shared state (leader avoids TOC
+	 * lookups).
+	 */
+	BrinShared *brinshared;
+	Snapshot	snapshot;
+} BrinLeader;
+
 /*
  * Struct used as "opaque" during index scans
  */
@@ -72,6 +165,14 @@ static void form_and_insert_tuple(BrinBuildState *state);
 static void union_tuples(BrinDesc *bdesc, BrinMemTuple *a,
 			 BrinTuple *b);
 static void brin_vacuum_scan(Relation idxrel, BufferAccessStrategy strategy);
+static BrinLeader *_brin_begin_parallel(BrinBuildState *state, Relation heap,
+					 Relation index, bool isconcurrent, int request);
+static void _brin_end_parallel(BrinLeader *brinleader);
+static double _brin_parallel_merge(BrinBuildState *state,
+					 BrinLeader *brinleader, bool *brokenhotchain);
+static void _brin_parallel_scan_and_build(BrinBuildState *state,
+							  BrinShared *brinshared, Relation heap,
+							  Relation index, Snapshot snapshot);
 
 
 /*
@@ -98,6 +199,8 @@ brinhandler(PG_FUNCTION_ARGS)
 	amroutine->ampredlocks = false;
 	amroutine->amcanparallel = false;
 	amroutine->amcaninclude = false;
+	amroutine->amcanskip = false;
+	amroutine->amcanbuildparallel = true;
 	amroutine->amkeytype = InvalidOid;
 
 	amroutine->ambuild = brinbuild;
@@ -662,6 +765,7 @@ brinbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 	double		idxtuples;
 	BrinRevmap *revmap;
 	BrinBuildState *state;
+	BrinLeader *brinleader = NULL;
 	Buffer		meta;
 	BlockNumber pagesPerRange;
 
@@ -712,15 +816,31 @@ brinbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 	revmap = brinRevmapInitialize(index, &pagesPerRange, NULL);
 	state = initialize_brin_buildstate(index, revmap, pagesPerRange);
 
-	/*
-	 * Now scan the relation.  No syncscan allowed here because we want the
-	 * heap blocks in physical order.
-	 */
-	reltuples = IndexBuildHeapScan(heap, index, indexInfo, false,
-								   brinbuildCallback, (void *) state, NULL);
+	/* Attempt to launch parallel worker scan when required */
+	if (indexInfo->ii_ParallelWorkers > 0)
+		brinleader = _brin_begin_parallel(state, heap, index,
+										  indexInfo->ii_Concurrent,
+										  indexInfo->ii_ParallelWorkers);
+
+	if (brinleader)
+	{
+		/* insert the tuples formed by the workers */
+		reltuples = _brin_parallel_merge(state, brinleader,
+										 &indexInfo->ii_BrokenHotChain);
+		_brin_end_parallel(brinleader);
+	}
+	else
+	{
+		/*
+		 * Now scan the relation.  No syncscan allowed here because we want
+		 * the heap blocks in physical order.
+		 */
+		reltuples = IndexBuildHeapScan(heap, index, indexInfo, false,
+									   brinbuildCallback, (void *) state, NULL);
 
-	/* process the final batch */
-	form_and_insert_tuple(state);
+		/* process the final batch */
+		form_and_insert_tuple(state);
+	}
 
 	/* release resources */
 	idxtuples = state->bs_numtuples;
@@ -1122,6 +1242,7 @@ initialize_brin_buildstate(Relation idxRel, BrinRevmap *revmap,
 	state->bs_rmAccess = revmap;
 	state->bs_bdesc = brin_build_desc(idxRel);
 	state->bs_dtuple = brin_new_memtuple(state->bs_bdesc);
+	state->bs_spool = NULL;
 
 	brin_memtuple_initialize(state->bs_dtuple, state->bs_bdesc);
 
@@ -1398,6 +1519,9 @@ brinsummarize(Relation index, Relation heapRel, BlockNumber pageRange,
 /*
  * Given a deformed tuple in the build state, convert it into the on-disk
  * format and insert it into the index, making the revmap point to it.
+ *
+ * In a parallel worker, the tuple is written to the spool file instead, for
+ * the leader to insert.
  */
 static void
 form_and_insert_tuple(BrinBuildState *state)
@@ -1407,9 +1531,18 @@ form_and_insert_tuple(BrinBuildState *state)
 
 	tup = brin_form_tuple(state->bs_bdesc, state->bs_currRangeStart,
 						  state->bs_dtuple, &size);
-	brin_doinsert(state->bs_irel, state->bs_pagesPerRange, state->bs_rmAccess,
-				  &state->bs_currentInsertBuf, state->bs_currRangeStart,
-				  tup, size);
+	if (state->bs_spool)
+	{
+		if (BufFileWrite(state->bs_spool, &size, sizeof(Size)) != sizeof(Size) ||
+			BufFileWrite(state->bs_spool, tup, size) != size)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not write to temporary file: %m")));
+	}
+	else
+		brin_doinsert(state->bs_irel, state->bs_pagesPerRange,
+					  state->bs_rmAccess, &state->bs_currentInsertBuf,
+					  state->bs_currRangeStart, tup, size);
 	state->bs_numtuples++;
 
 	pfree(tup);
@@ -1493,3 +1626,377 @@ brin_vacuum_scan(Relation idxrel, BufferAccessStrategy strategy)
 	 */
 	FreeSpaceMapVacuum(idxrel);
 }
+
+/*
+ * Create parallel context, and launch workers for leader.
+ *
+ * state must be initialized; the leader uses it to insert the tuples of the
+ * page ranges it summarizes itself.
+ *
+ * isconcurrent indicates if operation is CREATE INDEX CONCURRENTLY.
+ *
+ * request is the target number of parallel worker processes to launch.
+ *
+ * Returns the BrinLeader, which caller must use to insert the workers'
+ * tuples and then shut down parallel mode by passing it to
+ * _brin_end_parallel().  If not even a single worker process can be
+ * launched, NULL is returned, and caller should proceed with a serial index
+ * build.
+ */
+static BrinLeader *
+_brin_begin_parallel(BrinBuildState *state, Relation heap, Relation index,
+					 bool isconcurrent, int request)
+{
+	ParallelContext *pcxt;
+	Snapshot	snapshot;
+	Size		estsnap = 0;
+	BrinShared *brinshared;
+	BrinLeader *brinleader = (BrinLeader *) palloc0(sizeof(BrinLeader));
+	bool		leaderparticipates = true;
+	char	   *sharedquery;
+	int			querylen;
+
+#ifdef DISABLE_LEADER_PARTICIPATION
+	leaderparticipates = false;
+#endif
+
+	/*
+	 * Enter parallel mode, and create context for parallel build of brin
+	 * index
+	 */
+	EnterParallelMode();
+	Assert(request > 0);
+	pcxt = CreateParallelContext("postgres", "_brin_parallel_build_main",
+								 request, true);
+
+	/*
+	 * Prepare for scan of the base relation.  In a normal index build, we use
+	 * SnapshotAny because we must retrieve all tuples and do our own time
+	 * qual checks (because we have to index RECENTLY_DEAD tuples).  In a
+	 * concurrent build, we take a regular MVCC snapshot and index whatever's
+	 * live according to that.  Each participant scans its ranges with a scan
+	 * of its own, so the snapshot is passed to workers separately.
+	 */
+	if (!isconcurrent)
+		snapshot = SnapshotAny;
+	else
+		snapshot = RegisterSnapshot(GetTransactionSnapshot());
+
+	/* Estimate size for PARALLEL_KEY_BRIN_SHARED and PARALLEL_KEY_SNAPSHOT */
+	shm_toc_estimate_chunk(&pcxt->estimator, sizeof(BrinShared));
+	if (IsMVCCSnapshot(snapshot))
+	{
+		estsnap = EstimateSnapshotSpace(snapshot);
+		shm_toc_estimate_chunk(&pcxt->estimator, estsnap);
+		shm_toc_estimate_keys(&pcxt->estimator, 1);
+	}
+
+	/* Finally, estimate PARALLEL_KEY_QUERY_TEXT space */
+	querylen = strlen(debug_query_string);
+	shm_toc_estimate_chunk(&pcxt->estimator, querylen + 1);
+	shm_toc_estimate_keys(&pcxt->estimator, 2);
+
+	/* Everyone's had a chance to ask for space, so now create the DSM */
+	InitializeParallelDSM(pcxt);
+
+	/* Store shared build state, for which we reserved space */
+	brinshared = (BrinShared *) shm_toc_allocate(pcxt->toc,
+												 sizeof(BrinShared));
+	/* Initialize immutable state */
+	brinshared->heaprelid = RelationGetRelid(heap);
+	brinshared->indexrelid = RelationGetRelid(index);
+	brinshared->isconcurrent = isconcurrent;
+	brinshared->pagesPerRange = state->bs_pagesPerRange;
+	brinshared->heapNumBlocks = RelationGetNumberOfBlocks(heap);
+	/* even an empty table gets a tuple for its first range */
+	brinshared->nranges = Max(1, (brinshared->heapNumBlocks +
+								  state->bs_pagesPerRange - 1) /
+							  state->bs_pagesPerRange);
+	SharedFileSetInit(&brinshared->fileset, pcxt->seg);
+	ConditionVariableInit(&brinshared->workersdonecv);
+	SpinLockInit(&brinshared->mutex);
+	/* Initialize mutable state */
+	pg_atomic_init_u32(&brinshared->nextrange, 0);
+	brinshared->nparticipantsdone = 0;
+	brinshared->reltuples = 0.0;
+	brinshared->brokenhotchain = false;
+
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_BRIN_SHARED, brinshared);
+
+	if (IsMVCCSnapshot(snapshot))
+	{
+		char	   *sharedsnap = shm_toc_allocate(pcxt->toc, estsnap);
+
+		SerializeSnapshot(snapshot, sharedsnap);
+		shm_toc_insert(pcxt->toc, PARALLEL_KEY_SNAPSHOT, sharedsnap);
+	}
+
+	/* Store query string for workers */
+	sharedquery = (char *) shm_toc_allocate(pcxt->toc, querylen + 1);
+	memcpy(sharedquery, debug_query_string, querylen + 1);
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_QUERY_TEXT, sharedquery);
+
+	/* Launch workers, saving status for leader/caller */
+	LaunchParallelWorkers(pcxt);
+	brinleader->pcxt = pcxt;
+	brinleader->nparticipants = pcxt->nworkers_launched;
+	if (leaderparticipates)
+		brinleader->nparticipants++;
+	brinleader->brinshared = brinshared;
+	brinleader->snapshot = snapshot;
+
+	/* If no workers were successfully launched, back out (do serial build) */
+	if (pcxt->nworkers_launched == 0)
+	{
+		_brin_end_parallel(brinleader);
+		return NULL;
+	}
+
+	/* Summarize ranges ourselves, inserting the tuples directly */
+	if (leaderparticipates)
+		_brin_parallel_scan_and_build(state, brinshared, heap, index,
+									  snapshot);
+
+	/*
+	 * Caller needs to wait for all launched workers when we return.  Make
+	 * sure that the failure-to-start case will not hang forever.
+	 */
+	WaitForParallelWorkersToAttach(pcxt);
+
+	return brinleader;
+}
+
+/*
+ * Shut down workers, destroy parallel context, and end parallel mode.
+ *
+ * This also removes the workers' temporary files.
+ */
+static void
+_brin_end_parallel(BrinLeader *brinleader)
+{
+	/* Shutdown worker processes */
+	WaitForParallelWorkersToFinish(brinleader->pcxt);
+	/* Free last reference to MVCC snapshot, if one was used */
+	if (IsMVCCSnapshot(brinleader->snapshot))
+		UnregisterSnapshot(brinleader->snapshot);
+	DestroyParallelContext(brinleader->pcxt);
+	ExitParallelMode();
+}
+
+/*
+ * Within leader, wait for all participants to finish, and then insert the
+ * tuples formed by the workers into the index.
+ *
+ * Fills in the index tuple count in state, and lets caller set field
+ * indicating that some worker encountered a broken HOT chain.
+ *
+ * Returns the total number of heap tuples scanned.
+ */
+static double
+_brin_parallel_merge(BrinBuildState *state, BrinLeader *brinleader,
+					 bool *brokenhotchain)
+{
+	BrinShared *brinshared = brinleader->brinshared;
+	double		reltuples;
+	BrinTuple  *tup = NULL;
+	Size		tupsize = 0;
+	int			i;
+
+	for (;;)
+	{
+		SpinLockAcquire(&brinshared->mutex);
+		if (brinshared->nparticipantsdone == brinleader->nparticipants)
+		{
+			*brokenhotchain = brinshared->brokenhotchain;
+			reltuples = brinshared->reltuples;
+			SpinLockRelease(&brinshared->mutex);
+			break;
+		}
+		SpinLockRelease(&brinshared->mutex);
+
+		ConditionVariableSleep(&brinshared->workersdonecv,
+							   WAIT_EVENT_PARALLEL_CREATE_INDEX_SCAN);
+	}
+
+	ConditionVariableCancelSleep();
+
+	for (i = 0; i < brinleader->pcxt->nworkers_launched; i++)
+	{
+		char		name[MAXPGPATH];
+		BufFile    *file;
+		Size		size;
+		size_t		nread;
+
+		snprintf(name, sizeof(name), "worker%d", i);
+		file = BufFileOpenShared(&brinshared->fileset, name);
+
+		while ((nread = BufFileRead(file, &size, sizeof(Size))) != 0)
+		{
+			CHECK_FOR_INTERRUPTS();
+
+			if (nread != sizeof(Size))
+				ereport(ERROR,
+						(errcode_for_file_access(),
+						 errmsg("could not read from temporary file: %m")));
+			if (size > tupsize)
+			{
+				if (tup)
+					pfree(tup);
+				tup = (BrinTuple *) palloc(size);
+				tupsize = size;
+			}
+			if (BufFileRead(file, tup, size) != size)
+				ereport(ERROR,
+						(errcode_for_file_access(),
+						 errmsg("could not read from temporary file: %m")));
+
+			brin_doinsert(state->bs_irel, state->bs_pagesPerRange,
+						  state->bs_rmAccess, &state->bs_currentInsertBuf,
+						  tup->bt_blkno, tup, size);
+			state->bs_numtuples++;
+		}
+
+		BufFileClose(file);
+	}
+
+	if (tup)
+		pfree(tup);
+
+	return reltuples;
+}
+
+/*
+ * Perform work within a launched parallel process.
+ */
+void
+_brin_parallel_build_main(dsm_segment *seg, shm_toc *toc)
+{
+	char	   *sharedquery;
+	BrinShared *brinshared;
+	BrinBuildState *state;
+	Relation	heapRel;
+	Relation	indexRel;
+	LOCKMODE	heapLockmode;
+	LOCKMODE	indexLockmode;
+	Snapshot	snapshot;
+	char		name[MAXPGPATH];
+
+	/* Set debug_query_string for individual workers first */
+	sharedquery = shm_toc_lookup(toc, PARALLEL_KEY_QUERY_TEXT, false);
+	debug_query_string = sharedquery;
+
+	/* Report the query string from leader */
+	pgstat_report_activity(STATE_RUNNING, debug_query_string);
+
+	/* Look up brin shared state */
+	brinshared = shm_toc_lookup(toc, PARALLEL_KEY_BRIN_SHARED, false);
+
+	/* Open relations using lock modes known to be obtained by index.c */
+	if (!brinshared->isconcurrent)
+	{
+		heapLockmode = ShareLock;
+		indexLockmode = AccessExclusiveLock;
+		snapshot = SnapshotAny;
+	}
+	else
+	{
+		heapLockmode = ShareUpdateExclusiveLock;
+		indexLockmode = RowExclusiveLock;
+		snapshot = RegisterSnapshot(RestoreSnapshot(shm_toc_lookup(toc,
+																   PARALLEL_KEY_SNAPSHOT,
+																   false)));
+	}
+
+	/* Open relations within worker */
+	heapRel = heap_open(brinshared->heaprelid, heapLockmode);
+	indexRel = index_open(brinshared->indexrelid, indexLockmode);
+
+	/* Our tuples go to a file of our own */
+	SharedFileSetAttach(&brinshared->fileset, seg);
+	state = initialize_brin_buildstate(indexRel, NULL,
+									   brinshared->pagesPerRange);
+	snprintf(name, sizeof(name), "worker%d", ParallelWorkerNumber);
+	state->bs_spool = BufFileCreateShared(&brinshared->fileset, name);
+
+	_brin_parallel_scan_and_build(state, brinshared, heapRel, indexRel,
+								  snapshot);
+
+	BufFileClose(state->bs_spool);
+	terminate_brin_buildstate(state);
+
+	if (IsMVCCSnapshot(snapshot))
+		UnregisterSnapshot(snapshot);
+	index_close(indexRel, indexLockmode);
+	heap_close(heapRel, heapLockmode);
+}
+
+/*
+ * Perform a participant's portion of a parallel build: claim page ranges
+ * until none are left, and summarize each of them.
+ *
+ * The tuples are inserted, or written to the spool, by
+ * form_and_insert_tuple as usual.
+ */
+static void
+_brin_parallel_scan_and_build(BrinBuildState *state, BrinShared *brinshared,
+							  Relation heap, Relation index,
+							  Snapshot snapshot)
+{
+	IndexInfo  *indexInfo;
+	double		reltuples = 0;
+
+	indexInfo = BuildIndexInfo(index);
+	indexInfo->ii_Concurrent = brinshared->isconcurrent;
+
+	for (;;)
+	{
+		uint32		range = pg_atomic_fetch_add_u32(&brinshared->nextrange, 1);
+		BlockNumber startblk;
+		BlockNumber numblks;
+
+		if (range >= brinshared->nranges)
+			break;
+
+		startblk = range * brinshared->pagesPerRange;
+		if (startblk < brinshared->heapNumBlocks)
+			numblks = Min(brinshared->pagesPerRange,
+						  brinshared->heapNumBlocks - startblk);
+		else
+			numblks = 0;
+
+		state->bs_currRangeStart = startblk;
+		brin_memtuple_initialize(state->bs_dtuple, state->bs_bdesc);
+
+		/*
+		 * Scan just this range.  The scan is ended by
+		 * IndexBuildHeapRangeScan.
+		 */
+		if (numblks > 0)
+		{
+			HeapScanDesc scan;
+
+			scan = heap_beginscan_strat(heap, snapshot, 0, NULL, true, false);
+			reltuples += IndexBuildHeapRangeScan(heap, index, indexInfo,
+												 false, false,
+												 startblk, numblks,
+												 brinbuildCallback,
+												 (void *) state, scan);
+		}
+
+		form_and_insert_tuple(state);
+	}
+
+	/*
+	 * Done.  Record ambuild statistics, and whether we encountered a broken
+	 * HOT chain.
+	 */
+	SpinLockAcquire(&brinshared->mutex);
+	brinshared->nparticipantsdone++;
+	brinshared->reltuples += reltuples;
+	if (indexInfo->ii_BrokenHotChain)
+		brinshared->brokenhotchain = true;
+	SpinLockRelease(&brinshared->mutex);
+
+	/* Notify leader */
+	ConditionVariableSignal(&brinshared->workersdonecv);
+}
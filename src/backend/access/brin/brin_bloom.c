@@ -0,0 +1,407 @@
+/*
+ * brin_bloom.c
+ *		Implementation of Bloom opclass for BRIN
+ *
+ * A bloom filter summarizes the set of values in a page range, so that
+ * equality searches can skip ranges that are known not to contain the
+ * value.  Unlike minmax, this does not depend on the values being
+ * physically correlated with the heap order, which makes it useful for
+ * columns like UUIDs or hashed keys, where each range would otherwise
+ * cover almost the whole domain.  Only equality searches are supported.
+ *
+ * The filter is stored as a bytea value, one per indexed column.  Its size
+ * is fixed when the index descriptor is built, based on the number of
+ * distinct values we expect in a page range and the desired false positive
+ * rate, and it is capped so that the summaries of all indexed columns fit
+ * in a BRIN tuple together.  All filters of a given index column therefore
+ * have the same size, which lets the union function simply OR them.
+ *
+ * Values are hashed with the data type's hash function (support procedure
+ * 11), and that hash is turned into the filter's bit positions by double
+ * hashing.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/access/brin/brin_bloom.c
+ */
+#include "postgres.h"
+
+#include <math.h>
+
+#include "access/brin.h"
+#include "access/brin_internal.h"
+#include "access/brin_tuple.h"
+#include "access/genam.h"
+#include "access/hash.h"
+#include "access/htup_details.h"
+#include "access/stratnum.h"
+#include "catalog/pg_type.h"
+#include "utils/builtins.h"
+#include "utils/lsyscache.h"
+#include "utils/rel.h"
+
+
+/* support procedure returning the hash of a value */
+#define		PROCNUM_HASH			11
+
+/*
+ * Sizing of the filters.  We expect the number of distinct values in a
+ * page range to be this fraction of the number of tuples that fit in it,
+ * and aim for the given false positive rate.  The filters of all columns
+ * of an index together may take at most BLOOM_MAX_TOTAL_BYTES.
+ */
+#define		BLOOM_NDISTINCT_FRACTION	0.1
+#define		BLOOM_FALSE_POSITIVE_RATE	0.01
+#define		BLOOM_MIN_NDISTINCT			16
+#define		BLOOM_MAX_TOTAL_BYTES		(BLCKSZ / 2)
+
+/* seeds for the two independent hashes used for double hashing */
+#define		BLOOM_SEED_1	0x71d924af
+#define		BLOOM_SEED_2	0xba48b2ae
+
+/*
+ * On-disk form of a bloom filter: a varlena with the filter's parameters
+ * followed by the bitmap.
+ */
+typedef struct BloomFilter
+{
+	int32		vl_len_;		/* varlena header (do not touch directly!) */
+	uint16		nhashes;		/* number of hash functions */
+	uint32		nbits;			/* number of bits in the bitmap */
+	char		data[FLEXIBLE_ARRAY_MEMBER];	/* the bitmap */
+} BloomFilter;
+
+typedef struct BloomOpaque
+{
+	uint16		nhashes;		/* filter parameters for this column */
+	uint32		nbits;
+} BloomOpaque;
+
+static void bloom_set_params(BrinDesc *bdesc, AttrNumber attno,
+				 BloomOpaque *opaque);
+static BloomFilter *bloom_init(uint16 nhashes, uint32 nbits);
+static bool bloom_add_value(BloomFilter *filter, uint32 value);
+static bool bloom_contains_value(BloomFilter *filter, uint32 value);
+static uint32 bloom_hash_value(BrinDesc *bdesc, AttrNumber attno,
+				 Oid colloid, Datum value);
+
+
+Datum
+brin_bloom_opcinfo(PG_FUNCTION_ARGS)
+{
+	BrinOpcInfo *result;
+
+	/*
+	 * The filter parameters in the opaque struct are computed lazily, since
+	 * we don't have the BrinDesc here; palloc0 marks them as not yet set.
+	 */
+	result = palloc0(MAXALIGN(SizeofBrinOpcInfo(1)) +
+					 sizeof(BloomOpaque));
+	result->oi_nstored = 1;
+	result->oi_opaque = (BloomOpaque *)
+		MAXALIGN((char *) result + SizeofBrinOpcInfo(1));
+	result->oi_typcache[0] = lookup_type_cache(BYTEAOID, 0);
+
+	PG_RETURN_POINTER(result);
+}
+
+/*
+ * Examine the given index tuple (which contains partial status of a certain
+ * page range) by comparing it to the given value that comes from another heap
+ * tuple.  If the new value is not yet represented in the range's bloom
+ * filter, add it and return true.  Otherwise, return false and do not modify
+ * in this case.
+ */
+Datum
+brin_bloom_add_value(PG_FUNCTION_ARGS)
+{
+	BrinDesc   *bdesc = (BrinDesc *) PG_GETARG_POINTER(0);
+	BrinValues *column = (BrinValues *) PG_GETARG_POINTER(1);
+	Datum		newval = PG_GETARG_DATUM(2);
+	bool		isnull = PG_GETARG_DATUM(3);
+	Oid			colloid = PG_GET_COLLATION();
+	AttrNumber	attno = column->bv_attno;
+	BloomFilter *filter;
+	bool		updated = false;
+
+	/*
+	 * If the new value is null, we record that we saw it if it's the first
+	 * one; otherwise, there's nothing to do.
+	 */
+	if (isnull)
+	{
+		if (column->bv_hasnulls)
+			PG_RETURN_BOOL(false);
+
+		column->bv_hasnulls = true;
+		PG_RETURN_BOOL(true);
+	}
+
+	/*
+	 * If the recorded value is null, start with an empty filter.  Otherwise
+	 * work on the existing one; detoasting it may make a copy, so store it
+	 * back into the column afterwards.
+	 */
+	if (column->bv_allnulls)
+	{
+		BloomOpaque *opaque;
+
+		opaque = (BloomOpaque *) bdesc->bd_info[attno - 1]->oi_opaque;
+		if (opaque->nbits == 0)
+			bloom_set_params(bdesc, attno, opaque);
+
+		filter = bloom_init(opaque->nhashes, opaque->nbits);
+		column->bv_allnulls = false;
+		updated = true;
+	}
+	else
+		filter = (BloomFilter *) PG_DETOAST_DATUM(column->bv_values[0]);
+
+	if (bloom_add_value(filter, bloom_hash_value(bdesc, attno, colloid, newval)))
+		updated = true;
+
+	column->bv_values[0] = PointerGetDatum(filter);
+
+	PG_RETURN_BOOL(updated);
+}
+
+/*
+ * Given an index tuple corresponding to a certain page range and a scan key,
+ * return whether the scan key is consistent with the index tuple's bloom
+ * filter.  Return true if so, false otherwise.
+ */
+Datum
+brin_bloom_consistent(PG_FUNCTION_ARGS)
+{
+	BrinDesc   *bdesc = (BrinDesc *) PG_GETARG_POINTER(0);
+	BrinValues *column = (BrinValues *) PG_GETARG_POINTER(1);
+	ScanKey		key = (ScanKey) PG_GETARG_POINTER(2);
+	Oid			colloid = PG_GET_COLLATION();
+	BloomFilter *filter;
+	uint32		hashValue;
+
+	Assert(key->sk_attno == column->bv_attno);
+
+	/* handle IS NULL/IS NOT NULL tests */
+	if (key->sk_flags & SK_ISNULL)
+	{
+		if (key->sk_flags & SK_SEARCHNULL)
+		{
+			if (column->bv_allnulls || column->bv_hasnulls)
+				PG_RETURN_BOOL(true);
+			PG_RETURN_BOOL(false);
+		}
+
+		/*
+		 * For IS NOT NULL, we can only skip ranges that are known to have
+		 * only nulls.
+		 */
+		if (key->sk_flags & SK_SEARCHNOTNULL)
+			PG_RETURN_BOOL(!column->bv_allnulls);
+
+		/*
+		 * Neither IS NULL nor IS NOT NULL was used; assume all indexable
+		 * operators are strict and return false.
+		 */
+		PG_RETURN_BOOL(false);
+	}
+
+	/* if the range is all empty, it cannot possibly be consistent */
+	if (column->bv_allnulls)
+		PG_RETURN_BOOL(false);
+
+	if (key->sk_strategy != BTEqualStrategyNumber)
+		elog(ERROR, "invalid strategy number %d", key->sk_strategy);
+
+	filter = (BloomFilter *) PG_DETOAST_DATUM(column->bv_values[0]);
+	hashValue = bloom_hash_value(bdesc, key->sk_attno, colloid,
+								 key->sk_argument);
+
+	PG_RETURN_BOOL(bloom_contains_value(filter, hashValue));
+}
+
+/*
+ * Given two BrinValues, update the first of them as a union of the summary
+ * values contained in both.  The second one is untouched.
+ */
+Datum
+brin_bloom_union(PG_FUNCTION_ARGS)
+{
+	BrinValues *col_a = (BrinValues *) PG_GETARG_POINTER(1);
+	BrinValues *col_b = (BrinValues *) PG_GETARG_POINTER(2);
+	BloomFilter *filter_a;
+	BloomFilter *filter_b;
+	uint32		nbytes;
+	uint32		i;
+
+	Assert(col_a->bv_attno == col_b->bv_attno);
+
+	/* Adjust "hasnulls" */
+	if (!col_a->bv_hasnulls && col_b->bv_hasnulls)
+		col_a->bv_hasnulls = true;
+
+	/* If there are no values in B, there's nothing left to do */
+	if (col_b->bv_allnulls)
+		PG_RETURN_VOID();
+
+	filter_b = (BloomFilter *) PG_DETOAST_DATUM(col_b->bv_values[0]);
+
+	/*
+	 * Adjust "allnulls".  If A doesn't have values, just copy the filter
+	 * from B into A, and we're done.
+	 */
+	if (col_a->bv_allnulls)
+	{
+		col_a->bv_allnulls = false;
+		col_a->bv_values[0] =
+			PointerGetDatum(PG_DETOAST_DATUM_COPY(col_b->bv_values[0]));
+		PG_RETURN_VOID();
+	}
+
+	filter_a = (BloomFilter *) PG_DETOAST_DATUM(col_a->bv_values[0]);
+
+	/* All filters of a column are built with the same parameters */
+	if (filter_a->nbits != filter_b->nbits ||
+		filter_a->nhashes != filter_b->nhashes)
+		elog(ERROR, "cannot merge bloom filters of different sizes");
+
+	nbytes = (filter_a->nbits + 7) / 8;
+	for (i = 0; i < nbytes; i++)
+		filter_a->data[i] |= filter_b->data[i];
+
+	col_a->bv_values[0] = PointerGetDatum(filter_a);
+
+	PG_RETURN_VOID();
+}
+
+/*
+ * Compute the filter parameters for the given index column.
+ *
+ * The number of bits follows the usual formula for the optimal size of a
+ * bloom filter, m = -n ln(p) / (ln 2)^2, and the number of hash functions
+ * k = (m / n) ln 2.  If the filter would be too large, it is capped, which
+ * raises the false positive rate accordingly.
+ */
+static void
+bloom_set_params(BrinDesc *bdesc, AttrNumber attno, BloomOpaque *opaque)
+{
+	double		ndistinct;
+	double		nbits;
+	double		maxbits;
+	double		nhashes;
+
+	ndistinct = BLOOM_NDISTINCT_FRACTION *
+		BrinGetPagesPerRange(bdesc->bd_index) * MaxHeapTuplesPerPage;
+	ndistinct = Max(ndistinct, BLOOM_MIN_NDISTINCT);
+
+	nbits = ceil(-ndistinct * log(BLOOM_FALSE_POSITIVE_RATE) /
+				 (M_LN2 * M_LN2));
+
+	maxbits = ((BLOOM_MAX_TOTAL_BYTES / bdesc->bd_tupdesc->natts) -
+			   offsetof(BloomFilter, data)) * 8;
+	nbits = Min(nbits, maxbits);
+
+	/* round up to whole bytes */
+	nbits = ceil(nbits / 8) * 8;
+
+	nhashes = rint(nbits / ndistinct * M_LN2);
+	nhashes = Max(nhashes, 1);
+	nhashes = Min(nhashes, 32);
+
+	opaque->nbits = (uint32) nbits;
+	opaque->nhashes = (uint16) nhashes;
+}
+
+/*
+ * Create an empty bloom filter with the given parameters.
+ */
+static BloomFilter *
+bloom_init(uint16 nhashes, uint32 nbits)
+{
+	BloomFilter *filter;
+	Size		len;
+
+	Assert(nbits > 0 && nbits % 8 == 0);
+
+	len = offsetof(BloomFilter, data) + nbits / 8;
+
+	filter = (BloomFilter *) palloc0(len);
+	SET_VARSIZE(filter, len);
+	filter->nhashes = nhashes;
+	filter->nbits = nbits;
+
+	return filter;
+}
+
+/*
+ * Add a hash value to the filter.  Return whether any bit changed.
+ */
+static bool
+bloom_add_value(BloomFilter *filter, uint32 value)
+{
+	uint32		h1;
+	uint32		h2;
+	bool		updated = false;
+	int			i;
+
+	h1 = DatumGetUInt32(hash_uint32_extended(value, BLOOM_SEED_1)) %
+		filter->nbits;
+	h2 = DatumGetUInt32(hash_uint32_extended(value, BLOOM_SEED_2)) %
+		filter->nbits;
+
+	for (i = 0; i < filter->nhashes; i++)
+	{
+		uint32		h = (h1 + (uint64) i * h2) % filter->nbits;
+		uint32		byte = h / 8;
+		uint32		bit = h % 8;
+
+		if (!(filter->data[byte] & (1 << bit)))
+		{
+			filter->data[byte] |= (1 << bit);
+			updated = true;
+		}
+	}
+
+	return updated;
+}
+
+/*
+ * Check whether the filter might contain the hash value.
+ */
+static bool
+bloom_contains_value(BloomFilter *filter, uint32 value)
+{
+	uint32		h1;
+	uint32		h2;
+	int			i;
+
+	h1 = DatumGetUInt32(hash_uint32_extended(value, BLOOM_SEED_1)) %
+		filter->nbits;
+	h2 = DatumGetUInt32(hash_uint32_extended(value, BLOOM_SEED_2)) %
+		filter->nbits;
+
+	for (i = 0; i < filter->nhashes; i++)
+	{
+		uint32		h = (h1 + (uint64) i * h2) % filter->nbits;
+
+		if (!(filter->data[h / 8] & (1 << (h % 8))))
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Hash a value of the indexed column using the opclass's hash function.
+ */
+static uint32
+bloom_hash_value(BrinDesc *bdesc, AttrNumber attno, Oid colloid, Datum value)
+{
+	FmgrInfo   *finfo;
+
+	finfo = index_getprocinfo(bdesc->bd_index, attno, PROCNUM_HASH);
+
+	return DatumGetUInt32(FunctionCall1Coll(finfo, colloid, value));
+}
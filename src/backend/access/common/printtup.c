@@ -19,6 +19,7 @@
 #include "libpq/libpq.h"
 #include "libpq/pqformat.h"
 #include "tcop/pquery.h"
+#include "utils/fmgroids.h"
 #include "utils/lsyscache.h"
 #include "utils/memdebug.h"
 #include "utils/memutils.h"
@@ -55,6 +56,8 @@ typedef struct
 	Oid			typsend;		/* Oid for the type's binary output fn */
 	bool		typisvarlena;	/* is it varlena (ie possibly toastable)? */
 	int16		format;			/* format code for this column */
+	bool		rawtext;		/* send text payload without calling fn? */
+	bool		rawbinary;		/* send byte payload without calling fn? */
 	FmgrInfo	finfo;			/* Precomputed call info for output fn */
 } PrinttupAttrInfo;
 
@@ -351,6 +354,14 @@ printtup_prepare_info(DR_printtup *myState, TupleDesc typeinfo, int numAttrs)
 							  &thisState->typoutput,
 							  &thisState->typisvarlena);
 			fmgr_info(thisState->typoutput, &thisState->finfo);
+
+			/*
+			 * The text output of these types is just the datum's payload, so
+			 * we can skip the function and its copy of the value.
+			 */
+			thisState->rawtext = (thisState->typoutput == F_TEXTOUT ||
+								  thisState->typoutput == F_VARCHAROUT ||
+								  thisState->typoutput == F_BPCHAROUT);
 		}
 		else if (format == 1)
 		{
@@ -358,6 +369,15 @@ printtup_prepare_info(DR_printtup *myState, TupleDesc typeinfo, int numAttrs)
 									&thisState->typsend,
 									&thisState->typisvarlena);
 			fmgr_info(thisState->typsend, &thisState->finfo);
+
+			/*
+			 * Likewise for the binary output of these types, which is the
+			 * payload (after encoding conversion, for the text types).
+			 */
+			thisState->rawtext = (thisState->typsend == F_TEXTSEND ||
+								  thisState->typsend == F_VARCHARSEND ||
+								  thisState->typsend == F_BPCHARSEND);
+			thisState->rawbinary = (thisState->typsend == F_BYTEASEND);
 		}
 		else
 			ereport(ERROR,
@@ -422,7 +442,24 @@ printtup(TupleTableSlot *slot, DestReceiver *self)
 			VALGRIND_CHECK_MEM_IS_DEFINED(DatumGetPointer(attr),
 										  VARSIZE_ANY(attr));
 
-		if (thisState->format == 0)
+		if (thisState->rawtext || thisState->rawbinary)
+		{
+			/*
+			 * Copy the payload straight into the message.  Text is converted
+			 * to the client encoding, as the output functions would have it.
+			 */
+			struct varlena *value = PG_DETOAST_DATUM_PACKED(attr);
+			int			len = VARSIZE_ANY_EXHDR(value);
+
+			if (thisState->rawtext)
+				pq_sendcountedtext(buf, VARDATA_ANY(value), len, false);
+			else
+			{
+				pq_sendint32(buf, len);
+				pq_sendbytes(buf, VARDATA_ANY(value), len);
+			}
+		}
+		else if (thisState->format == 0)
 		{
 			/* Text output */
 			char	   *outputstr;
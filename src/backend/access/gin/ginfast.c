@@ -226,6 +226,7 @@ ginHeapTupleFastInsert(GinState *ginstate, GinTupleCollector *collector)
 	ginxlogUpdateMeta data;
 	bool		separateList = false;
 	bool		needCleanup = false;
+	bool		mustCleanup = false;
 	int			cleanupSize;
 	bool		needWal;
 
@@ -448,17 +449,35 @@ ginHeapTupleFastInsert(GinState *ginstate, GinTupleCollector *collector)
 	cleanupSize = GinGetPendingListCleanupSize(index);
 	if (metadata->nPendingPages * GIN_PAGE_FREESIZE > cleanupSize * 1024L)
 		needCleanup = true;
+	if (metadata->nPendingPages * GIN_PAGE_FREESIZE >
+		cleanupSize * 1024L * GIN_PENDING_LIST_BACKPRESSURE)
+		mustCleanup = true;
 
 	UnlockReleaseBuffer(metabuffer);
 
 	END_CRIT_SECTION();
 
+	if (!needCleanup)
+		return;
+
+	/*
+	 * Hand the cleanup over to autovacuum if we can, so that this insert
+	 * isn't held up by it.  Autovacuum can't process temporary indexes, and
+	 * if the request can't be queued, or the list has grown far past the
+	 * limit without autovacuum getting to it, we do it ourselves.
+	 */
+	if (!mustCleanup &&
+		!RelationUsesLocalBuffers(index) &&
+		AutoVacuumingActive() &&
+		AutoVacuumRequestWork(AVW_GINCleanupPendingList,
+							  RelationGetRelid(index), InvalidBlockNumber))
+		return;
+
 	/*
 	 * Since it could contend with concurrent cleanup process we cleanup
 	 * pending list not forcibly.
 	 */
-	if (needCleanup)
-		ginInsertCleanup(ginstate, false, true, false, NULL);
+	ginInsertCleanup(ginstate, false, true, false, NULL);
 }
 
 /*
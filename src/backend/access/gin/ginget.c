@@ -326,6 +326,10 @@ restartScanEntry:
 		pfree(entry->list);
 	entry->list = NULL;
 	entry->nlist = 0;
+	if (entry->segbuf)
+		pfree(entry->segbuf);
+	entry->segbuf = NULL;
+	entry->nextseg = NULL;
 	entry->matchBitmap = NULL;
 	entry->matchResult = NULL;
 	entry->reduceResult = false;
@@ -626,11 +630,124 @@ startScan(IndexScanDesc scan)
 		startScanKey(ginstate, so, so->keys + i);
 }
 
+/*
+ * Return the index of the first item in list[offset .. nlist - 1] that is
+ * > advancePast, or nlist if there is none.
+ *
+ * When the entries of a key are intersected, the entry that lags behind is
+ * often asked to skip many items at once.  Rather than comparing against
+ * each of them in turn, we probe ahead in exponentially growing steps and
+ * then binary search within the last step, so skipping k items costs
+ * O(log k) comparisons, while moving on to the very next item still costs
+ * just one.
+ */
+static int
+gallopPastItem(ItemPointerData *list, int offset, int nlist,
+			   ItemPointerData advancePast)
+{
+	int			low;
+	int			high;
+	int			step = 1;
+
+	if (offset >= nlist ||
+		ginCompareItemPointers(&list[offset], &advancePast) > 0)
+		return offset;
+
+	/* Gallop until we overshoot; list[low] <= advancePast all along */
+	low = offset;
+	for (;;)
+	{
+		high = low + step;
+		if (high >= nlist)
+		{
+			high = nlist;
+			break;
+		}
+		if (ginCompareItemPointers(&list[high], &advancePast) > 0)
+			break;
+		low = high;
+		step *= 2;
+	}
+
+	/* The answer is in (low, high] */
+	while (high - low > 1)
+	{
+		int			mid = low + (high - low) / 2;
+
+		if (ginCompareItemPointers(&list[mid], &advancePast) <= 0)
+			low = mid;
+		else
+			high = mid;
+	}
+
+	return high;
+}
+
+/*
+ * Keep a copy of the compressed posting list segments of a posting tree
+ * leaf page, to be decoded by entryDecodeSegment as the scan reaches them.
+ */
+static void
+entryCopySegments(GinScanEntry entry, Page page)
+{
+	Size		len = GinDataLeafPageGetPostingListSize(page);
+
+	Assert(GinPageIsCompressed(page));
+
+	if (len == 0)
+		return;
+
+	entry->segbuf = palloc(len);
+	memcpy(entry->segbuf, GinDataLeafPageGetPostingList(page), len);
+	entry->nextseg = (GinPostingList *) entry->segbuf;
+	entry->segend = entry->segbuf + len;
+}
+
+/*
+ * Decode the next of the copied posting list segments that holds items
+ * > advancePast into entry->list, and set entry->offset to the first such
+ * item.  Returns false if there's none left.
+ *
+ * The first item of each segment is stored uncompressed, so these serve as
+ * a skip table: a segment whose successor begins at or before advancePast
+ * can be passed over without decoding it.
+ */
+static bool
+entryDecodeSegment(GinScanEntry entry, ItemPointerData advancePast)
+{
+	while (entry->nextseg != NULL)
+	{
+		GinPostingList *seg = entry->nextseg;
+		int			nitems;
+
+		entry->nextseg = GinNextPostingListSegment(seg);
+		if ((Pointer) entry->nextseg >= entry->segend)
+			entry->nextseg = NULL;
+
+		if (entry->nextseg != NULL &&
+			ginCompareItemPointers(&entry->nextseg->first, &advancePast) <= 0)
+			continue;
+
+		if (entry->list)
+			pfree(entry->list);
+		entry->list = ginPostingListDecode(seg, &nitems);
+		entry->nlist = nitems;
+		entry->offset = gallopPastItem(entry->list, 0, entry->nlist,
+									   advancePast);
+		if (entry->offset < entry->nlist)
+			return true;
+	}
+
+	return false;
+}
+
 /*
  * Load the next batch of item pointers from a posting tree.
  *
  * Note that we copy the page into GinScanEntry->list array and unlock it, but
- * keep it pinned to prevent interference with vacuum.
+ * keep it pinned to prevent interference with vacuum.  For a compressed page
+ * other than the rightmost one, we copy its segments instead, and decode
+ * them one at a time as needed; see entryDecodeSegment.
  */
 static void
 entryLoadMoreItems(GinState *ginstate, GinScanEntry entry,
@@ -703,6 +820,12 @@ entryLoadMoreItems(GinState *ginstate, GinScanEntry entry,
 			entry->list = NULL;
 			entry->nlist = 0;
 		}
+		if (entry->segbuf)
+		{
+			pfree(entry->segbuf);
+			entry->segbuf = NULL;
+			entry->nextseg = NULL;
+		}
 
 		if (stepright)
 		{
@@ -749,6 +872,22 @@ entryLoadMoreItems(GinState *ginstate, GinScanEntry entry,
 			continue;
 		}
 
+		/*
+		 * Decode the segments of a compressed page lazily, except on the
+		 * rightmost page: we release the buffer after that one, and
+		 * entryGetItem then only looks at entry->list.
+		 */
+		if (GinPageIsCompressed(page) && !GinPageRightMost(page))
+		{
+			entryCopySegments(entry, page);
+			if (entryDecodeSegment(entry, advancePast))
+			{
+				LockBuffer(entry->buffer, GIN_UNLOCK);
+				return;
+			}
+			continue;
+		}
+
 		entry->list = GinDataLeafPageGetItems(page, &entry->nlist, advancePast);
 
 		for (i = 0; i < entry->nlist; i++)
@@ -891,27 +1030,31 @@ entryGetItem(GinState *ginstate, GinScanEntry entry,
 		 * A posting list from an entry tuple, or the last page of a posting
 		 * tree.
 		 */
-		do
+		entry->offset = gallopPastItem(entry->list, entry->offset,
+									   entry->nlist, advancePast);
+		if (entry->offset >= entry->nlist)
 		{
-			if (entry->offset >= entry->nlist)
-			{
-				ItemPointerSetInvalid(&entry->curItem);
-				entry->isFinished = true;
-				break;
-			}
-
+			ItemPointerSetInvalid(&entry->curItem);
+			entry->isFinished = true;
+		}
+		else
 			entry->curItem = entry->list[entry->offset++];
-		} while (ginCompareItemPointers(&entry->curItem, &advancePast) <= 0);
 		/* XXX: shouldn't we apply the fuzzy search limit here? */
 	}
 	else
 	{
 		/* A posting tree */
-		do
+		for (;;)
 		{
-			/* If we've processed the current batch, load more items */
+			/*
+			 * If we've processed the current batch, decode the next segment
+			 * of the page, or else load more items
+			 */
 			while (entry->offset >= entry->nlist)
 			{
+				if (entryDecodeSegment(entry, advancePast))
+					break;
+
 				entryLoadMoreItems(ginstate, entry, advancePast, snapshot);
 
 				if (entry->isFinished)
@@ -921,10 +1064,16 @@ entryGetItem(GinState *ginstate, GinScanEntry entry,
 				}
 			}
 
+			entry->offset = gallopPastItem(entry->list, entry->offset,
+										   entry->nlist, advancePast);
+			if (entry->offset >= entry->nlist)
+				continue;
+
 			entry->curItem = entry->list[entry->offset++];
 
-		} while (ginCompareItemPointers(&entry->curItem, &advancePast) <= 0 ||
-				 (entry->reduceResult == true && dropItem(entry)));
+			if (!(entry->reduceResult == true && dropItem(entry)))
+				break;
+		}
 	}
 }
 
@@ -16,17 +16,127 @@
 
 #include "access/gin_private.h"
 #include "access/ginxlog.h"
+#include "access/parallel.h"
+#include "access/relscan.h"
+#include "access/xact.h"
 #include "access/xloginsert.h"
 #include "catalog/index.h"
+#include "lib/binaryheap.h"
 #include "miscadmin.h"
+#include "pgstat.h"
 #include "storage/bufmgr.h"
+#include "storage/buffile.h"
+#include "storage/condition_variable.h"
 #include "storage/smgr.h"
 #include "storage/indexfsm.h"
 #include "storage/predicate.h"
+#include "storage/sharedfileset.h"
+#include "storage/spin.h"
+#include "tcop/tcopprot.h"		/* pgrminclude ignore */
+#include "utils/datum.h"
 #include "utils/memutils.h"
 #include "utils/rel.h"
+#include "utils/snapmgr.h"
 
 
+/* Magic numbers for parallel state sharing */
+#define PARALLEL_KEY_GIN_SHARED			UINT64CONST(0xB000000000000001)
+#define PARALLEL_KEY_QUERY_TEXT			UINT64CONST(0xB000000000000002)
+
+/*
+ * Status for index builds performed in parallel.  This is allocated in a
+ * dynamic shared memory segment.
+ *
+ * Each participant scans its share of the heap into a private
+ * BuildAccumulator, exactly like a serial build does, but instead of
+ * inserting the accumulated entries into the index it writes them out as a
+ * sorted run to a temporary file in the shared fileset.  The leader merges
+ * all the runs once the scan is done, and is the only process that ever
+ * writes to the index.
+ */
+typedef struct GinShared
+{
+	/*
+	 * These fields are not modified during the build.  They primarily exist
+	 * for the benefit of worker processes that need to create state
+	 * corresponding to that used by the leader.
+	 */
+	Oid			heaprelid;
+	Oid			indexrelid;
+	bool		isconcurrent;
+	int			scanstates;
+
+	/* Temporary files holding the runs written by participants */
+	SharedFileSet fileset;
+
+	/*
+	 * workersdonecv is used to monitor the progress of workers.  All parallel
+	 * participants must indicate that they are done before leader can merge
+	 * the runs.
+	 */
+	ConditionVariable workersdonecv;
+
+	/*
+	 * mutex protects all fields before heapdesc.
+	 *
+	 * These fields contain status information of interest to GIN index
+	 * builds that must work just the same when an index is built in
+	 * parallel.
+	 */
+	slock_t		mutex;
+
+	/*
+	 * Mutable state that is maintained by workers, and reported back to
+	 * leader at end of parallel scan.
+	 *
+	 * nparticipantsdone is number of worker processes finished.
+	 *
+	 * nruns is the number of runs written so far; runs are named after
+	 * their number.
+	 *
+	 * reltuples is the total number of input heap tuples.
+	 *
+	 * indtuples is the total number of entries extracted from them.
+	 *
+	 * brokenhotchain indicates if any worker detected a broken HOT chain
+	 * during build.
+	 */
+	int			nparticipantsdone;
+	int			nruns;
+	double		reltuples;
+	double		indtuples;
+	bool		brokenhotchain;
+
+	/*
+	 * This variable-sized field must come last.
+	 *
+	 * See _gin_parallel_estimate_shared().
+	 */
+	ParallelHeapScanDescData heapdesc;
+} GinShared;
+
+/*
+ * Status for leader in parallel index build.
+ */
+typedef struct GinLeader
+{
+	/* parallel context itself */
+	ParallelContext *pcxt;
+
+	/*
+	 * nparticipants is the exact number of worker processes successfully
+	 * launched, plus one leader process if it participates as a worker.
+	 */
+	int			nparticipants;
+
+	/*
+	 * Leader process convenience pointers to shared state (leader avoids TOC
+	 * lookups).
+	 */
+	GinShared  *ginshared;
+	Snapshot	snapshot;
+} GinLeader;
+
 typedef struct
 {
 	GinState	ginstate;
@@ -35,8 +145,62 @@ typedef struct
 	MemoryContext tmpCtx;
 	MemoryContext funcCtx;
 	BuildAccumulator accum;
+
+	/* memory the accumulator may use before being dumped, in KB */
+	int			workmem;
+
+	/* in a parallel participant, the accumulator is dumped to a run */
+	GinShared  *ginshared;
+
+	/* set in the leader of a parallel build */
+	GinLeader  *ginleader;
 } GinBuildState;
 
+/*
+ * Header of one entry in a run file.  It is followed by the key's data, if
+ * the key is pass-by-reference, padded to a MAXALIGN boundary, and then by
+ * the entry's nitems heap TIDs.
+ */
+typedef struct GinRunEntry
+{
+	uint32		size;			/* total size, including this header */
+	uint32		nitems;
+	uint32		keylen;			/* 0 for pass-by-value and null keys */
+	OffsetNumber attnum;
+	GinNullCategory category;
+	Datum		key;			/* the key, if pass-by-value */
+} GinRunEntry;
+
+/*
+ * State of one input run while the leader merges them.  The current entry's
+ * key and items point into buf, and so are only valid until the next entry
+ * is read.
+ */
+typedef struct GinRunReader
+{
+	BufFile    *file;
+	char	   *buf;
+	Size		bufsize;
+	OffsetNumber attnum;
+	Datum		key;
+	GinNullCategory category;
+	ItemPointerData *items;
+	uint32		nitems;
+} GinRunReader;
+
+static void ginDumpAccum(GinBuildState *buildstate);
+static void ginWriteRun(GinBuildState *buildstate);
+static bool ginReadRunEntry(GinRunReader *reader);
+static int	ginRunReaderCompare(Datum a, Datum b, void *arg);
+static void _gin_begin_parallel(GinBuildState *buildstate, Relation heap,
+					Relation index, bool isconcurrent, int request);
+static void _gin_end_parallel(GinLeader *ginleader);
+static Size _gin_parallel_estimate_shared(Snapshot snapshot);
+static double _gin_parallel_merge(GinBuildState *buildstate,
+					bool *brokenhotchain);
+static void _gin_parallel_scan_and_build(Relation heap, Relation index,
+							 GinShared *ginshared, int workmem);
+
 
 /*
  * Adds array of item pointers to tuple's posting list, or
@@ -286,23 +450,9 @@ ginBuildCallback(Relation index, HeapTuple htup, Datum *values,
 							   &htup->t_self);
 
 	/* If we've maxed out our available memory, dump everything to the index */
-	if (buildstate->accum.allocatedMemory >= (Size) maintenance_work_mem * 1024L)
+	if (buildstate->accum.allocatedMemory >= (Size) buildstate->workmem * 1024L)
 	{
-		ItemPointerData *list;
-		Datum		key;
-		GinNullCategory category;
-		uint32		nlist;
-		OffsetNumber attnum;
-
-		ginBeginBAScan(&buildstate->accum);
-		while ((list = ginGetBAEntry(&buildstate->accum,
-									 &attnum, &key, &category, &nlist)) != NULL)
-		{
-			/* there could be many entries, so be willing to abort here */
-			CHECK_FOR_INTERRUPTS();
-			ginEntryInsert(&buildstate->ginstate, attnum, key, category,
-						   list, nlist, &buildstate->buildStats);
-		}
+		ginDumpAccum(buildstate);
 
 		MemoryContextReset(buildstate->tmpCtx);
 		ginInitBA(&buildstate->accum);
@@ -311,6 +461,176 @@ ginBuildCallback(Relation index, HeapTuple htup, Datum *values,
 	MemoryContextSwitchTo(oldCtx);
 }
 
+/*
+ * Dump the contents of the BuildAccumulator, either into the index or, in a
+ * parallel build, as one sorted run for the leader to merge.
+ */
+static void
+ginDumpAccum(GinBuildState *buildstate)
+{
+	ItemPointerData *list;
+	Datum		key;
+	GinNullCategory category;
+	uint32		nlist;
+	OffsetNumber attnum;
+
+	if (buildstate->ginshared)
+	{
+		ginWriteRun(buildstate);
+		return;
+	}
+
+	ginBeginBAScan(&buildstate->accum);
+	while ((list = ginGetBAEntry(&buildstate->accum,
+								 &attnum, &key, &category, &nlist)) != NULL)
+	{
+		/* there could be many entries, so be willing to abort here */
+		CHECK_FOR_INTERRUPTS();
+		ginEntryInsert(&buildstate->ginstate, attnum, key, category,
+					   list, nlist, &buildstate->buildStats);
+	}
+}
+
+/*
+ * Write the contents of the BuildAccumulator to a new run file.
+ *
+ * ginGetBAEntry returns the entries in ginCompareAttEntries order, so the
+ * run comes out sorted.  Nothing is written if the accumulator is empty.
+ */
+static void
+ginWriteRun(GinBuildState *buildstate)
+{
+	GinShared  *ginshared = buildstate->ginshared;
+	BufFile    *file = NULL;
+	ItemPointerData *list;
+	Datum		key;
+	GinNullCategory category;
+	uint32		nlist;
+	OffsetNumber attnum;
+
+	ginBeginBAScan(&buildstate->accum);
+	while ((list = ginGetBAEntry(&buildstate->accum,
+								 &attnum, &key, &category, &nlist)) != NULL)
+	{
+		Form_pg_attribute attr;
+		GinRunEntry entry;
+		Size		datalen;
+		char	   *data;
+
+		CHECK_FOR_INTERRUPTS();
+
+		if (file == NULL)
+		{
+			char		name[MAXPGPATH];
+			int			runno;
+
+			SpinLockAcquire(&ginshared->mutex);
+			runno = ginshared->nruns++;
+			SpinLockRelease(&ginshared->mutex);
+
+			snprintf(name, sizeof(name), "run%d", runno);
+			file = BufFileCreateShared(&ginshared->fileset, name);
+		}
+
+		attr = TupleDescAttr(buildstate->ginstate.origTupdesc, attnum - 1);
+
+		memset(&entry, 0, sizeof(GinRunEntry));
+		entry.nitems = nlist;
+		entry.attnum = attnum;
+		entry.category = category;
+		if (category != GIN_CAT_NORM_KEY)
+		{
+			entry.keylen = 0;
+			entry.key = (Datum) 0;
+		}
+		else if (attr->attbyval)
+		{
+			entry.keylen = 0;
+			entry.key = key;
+		}
+		else
+		{
+			entry.keylen = datumGetSize(key, false, attr->attlen);
+			entry.key = (Datum) 0;
+		}
+
+		datalen = MAXALIGN(entry.keylen) + nlist * sizeof(ItemPointerData);
+		entry.size = sizeof(GinRunEntry) + datalen;
+
+		data = palloc0(datalen);
+		if (entry.keylen > 0)
+			memcpy(data, DatumGetPointer(key), entry.keylen);
+		memcpy(data + MAXALIGN(entry.keylen), list,
+			   nlist * sizeof(ItemPointerData));
+
+		if (BufFileWrite(file, &entry, sizeof(GinRunEntry)) != sizeof(GinRunEntry) ||
+			BufFileWrite(file, data, datalen) != datalen)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not write to temporary file: %m")));
+		pfree(data);
+	}
+
+	if (file != NULL)
+		BufFileClose(file);
+}
+
+/*
+ * Read the next entry of a run into reader.  Returns false at end of run.
+ */
+static bool
+ginReadRunEntry(GinRunReader *reader)
+{
+	GinRunEntry entry;
+	size_t		nread;
+	Size		datalen;
+
+	nread = BufFileRead(reader->file, &entry, sizeof(GinRunEntry));
+	if (nread == 0)
+		return false;
+	if (nread != sizeof(GinRunEntry))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from temporary file: %m")));
+
+	datalen = entry.size - sizeof(GinRunEntry);
+	if (datalen > reader->bufsize)
+	{
+		if (reader->buf)
+			pfree(reader->buf);
+		reader->bufsize = Max(datalen, 2 * reader->bufsize);
+		reader->buf = palloc(reader->bufsize);
+	}
+	if (BufFileRead(reader->file, reader->buf, datalen) != datalen)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from temporary file: %m")));
+
+	reader->attnum = entry.attnum;
+	reader->category = entry.category;
+	reader->key = (entry.keylen > 0) ? PointerGetDatum(reader->buf) : entry.key;
+	reader->items = (ItemPointerData *) (reader->buf + MAXALIGN(entry.keylen));
+	reader->nitems = entry.nitems;
+
+	return true;
+}
+
+/*
+ * binaryheap comparator for run readers.  binaryheap is a max-heap, so the
+ * sense of the comparison is inverted to get the smallest entry first.
+ */
+static int
+ginRunReaderCompare(Datum a, Datum b, void *arg)
+{
+	GinState   *ginstate = (GinState *) arg;
+	GinRunReader *ra = (GinRunReader *) DatumGetPointer(a);
+	GinRunReader *rb = (GinRunReader *) DatumGetPointer(b);
+
+	return -ginCompareAttEntries(ginstate,
+								 ra->attnum, ra->key, ra->category,
+								 rb->attnum, rb->key, rb->category);
+}
+
 IndexBuildResult *
 ginbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 {
@@ -319,12 +639,7 @@ ginbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 	GinBuildState buildstate;
 	Buffer		RootBuffer,
 				MetaBuffer;
-	ItemPointerData *list;
-	Datum		key;
-	GinNullCategory category;
-	uint32		nlist;
 	MemoryContext oldCtx;
-	OffsetNumber attnum;
 
 	if (RelationGetNumberOfBlocks(index) != 0)
 		elog(ERROR, "index \"%s\" already contains data",
@@ -333,6 +648,9 @@ ginbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 	initGinState(&buildstate.ginstate, index);
 	buildstate.indtuples = 0;
 	memset(&buildstate.buildStats, 0, sizeof(GinStatsData));
+	buildstate.workmem = maintenance_work_mem;
+	buildstate.ginshared = NULL;
+	buildstate.ginleader = NULL;
 
 	/* initialize the meta page */
 	MetaBuffer = GinNewBuffer(index);
@@ -390,25 +708,33 @@ ginbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 	buildstate.accum.ginstate = &buildstate.ginstate;
 	ginInitBA(&buildstate.accum);
 
-	/*
-	 * Do the heap scan.  We disallow sync scan here because dataPlaceToPage
-	 * prefers to receive tuples in TID order.
-	 */
-	reltuples = IndexBuildHeapScan(heap, index, indexInfo, false,
-								   ginBuildCallback, (void *) &buildstate, NULL);
+	/* Attempt to launch parallel worker scan when required */
+	if (indexInfo->ii_ParallelWorkers > 0)
+		_gin_begin_parallel(&buildstate, heap, index, indexInfo->ii_Concurrent,
+							indexInfo->ii_ParallelWorkers);
 
-	/* dump remaining entries to the index */
-	oldCtx = MemoryContextSwitchTo(buildstate.tmpCtx);
-	ginBeginBAScan(&buildstate.accum);
-	while ((list = ginGetBAEntry(&buildstate.accum,
-								 &attnum, &key, &category, &nlist)) != NULL)
+	if (buildstate.ginleader)
 	{
-		/* there could be many entries, so be willing to abort here */
-		CHECK_FOR_INTERRUPTS();
-		ginEntryInsert(&buildstate.ginstate, attnum, key, category,
-					   list, nlist, &buildstate.buildStats);
+		/* merge the participants' runs into the index */
+		reltuples = _gin_parallel_merge(&buildstate,
+										&indexInfo->ii_BrokenHotChain);
+		_gin_end_parallel(buildstate.ginleader);
+	}
+	else
+	{
+		/*
+		 * Do the heap scan.  We disallow sync scan here because
+		 * dataPlaceToPage prefers to receive tuples in TID order.
+		 */
+		reltuples = IndexBuildHeapScan(heap, index, indexInfo, false,
+									   ginBuildCallback, (void *) &buildstate,
+									   NULL);
+
+		/* dump remaining entries to the index */
+		oldCtx = MemoryContextSwitchTo(buildstate.tmpCtx);
+		ginDumpAccum(&buildstate);
+		MemoryContextSwitchTo(oldCtx);
 	}
-	MemoryContextSwitchTo(oldCtx);
 
 	MemoryContextDelete(buildstate.funcCtx);
 	MemoryContextDelete(buildstate.tmpCtx);
@@ -430,6 +756,435 @@ ginbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 	return result;
 }
 
+/*
+ * Create parallel context, and launch workers for leader.
+ *
+ * buildstate argument should be initialized.
+ *
+ * isconcurrent indicates if operation is CREATE INDEX CONCURRENTLY.
+ *
+ * request is the target number of parallel worker processes to launch.
+ *
+ * Sets buildstate's GinLeader, which caller must use to shut down parallel
+ * mode by passing it to _gin_end_parallel() once it has merged the runs.
+ * If not even a single worker process can be launched, this is never set,
+ * and caller should proceed with a serial index build.
+ */
+static void
+_gin_begin_parallel(GinBuildState *buildstate, Relation heap, Relation index,
+					bool isconcurrent, int request)
+{
+	ParallelContext *pcxt;
+	int			scanstates;
+	Snapshot	snapshot;
+	Size		estginshared;
+	GinShared  *ginshared;
+	GinLeader  *ginleader = (GinLeader *) palloc0(sizeof(GinLeader));
+	bool		leaderparticipates = true;
+	char	   *sharedquery;
+	int			querylen;
+
+#ifdef DISABLE_LEADER_PARTICIPATION
+	leaderparticipates = false;
+#endif
+
+	/*
+	 * Enter parallel mode, and create context for parallel build of gin
+	 * index
+	 */
+	EnterParallelMode();
+	Assert(request > 0);
+	pcxt = CreateParallelContext("postgres", "_gin_parallel_build_main",
+								 request, true);
+	scanstates = leaderparticipates ? request + 1 : request;
+
+	/*
+	 * Prepare for scan of the base relation.  In a normal index build, we use
+	 * SnapshotAny because we must retrieve all tuples and do our own time
+	 * qual checks (because we have to index RECENTLY_DEAD tuples).  In a
+	 * concurrent build, we take a regular MVCC snapshot and index whatever's
+	 * live according to that.
+	 */
+	if (!isconcurrent)
+		snapshot = SnapshotAny;
+	else
+		snapshot = RegisterSnapshot(GetTransactionSnapshot());
+
+	/* Estimate size for our own PARALLEL_KEY_GIN_SHARED workspace */
+	estginshared = _gin_parallel_estimate_shared(snapshot);
+	shm_toc_estimate_chunk(&pcxt->estimator, estginshared);
+
+	/* Finally, estimate PARALLEL_KEY_QUERY_TEXT space */
+	querylen = strlen(debug_query_string);
+	shm_toc_estimate_chunk(&pcxt->estimator, querylen + 1);
+	shm_toc_estimate_keys(&pcxt->estimator, 2);
+
+	/* Everyone's had a chance to ask for space, so now create the DSM */
+	InitializeParallelDSM(pcxt);
+
+	/* Store shared build state, for which we reserved space */
+	ginshared = (GinShared *) shm_toc_allocate(pcxt->toc, estginshared);
+	/* Initialize immutable state */
+	ginshared->heaprelid = RelationGetRelid(heap);
+	ginshared->indexrelid = RelationGetRelid(index);
+	ginshared->isconcurrent = isconcurrent;
+	ginshared->scanstates = scanstates;
+	SharedFileSetInit(&ginshared->fileset, pcxt->seg);
+	ConditionVariableInit(&ginshared->workersdonecv);
+	SpinLockInit(&ginshared->mutex);
+	/* Initialize mutable state */
+	ginshared->nparticipantsdone = 0;
+	ginshared->nruns = 0;
+	ginshared->reltuples = 0.0;
+	ginshared->indtuples = 0.0;
+	ginshared->brokenhotchain = false;
+	heap_parallelscan_initialize(&ginshared->heapdesc, heap, snapshot);
+
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_GIN_SHARED, ginshared);
+
+	/* Store query string for workers */
+	sharedquery = (char *) shm_toc_allocate(pcxt->toc, querylen + 1);
+	memcpy(sharedquery, debug_query_string, querylen + 1);
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_QUERY_TEXT, sharedquery);
+
+	/* Launch workers, saving status for leader/caller */
+	LaunchParallelWorkers(pcxt);
+	ginleader->pcxt = pcxt;
+	ginleader->nparticipants = pcxt->nworkers_launched;
+	if (leaderparticipates)
+		ginleader->nparticipants++;
+	ginleader->ginshared = ginshared;
+	ginleader->snapshot = snapshot;
+
+	/* If no workers were successfully launched, back out (do serial build) */
+	if (pcxt->nworkers_launched == 0)
+	{
+		_gin_end_parallel(ginleader);
+		return;
+	}
+
+	/* Save leader state now that it's clear build will be parallel */
+	buildstate->ginleader = ginleader;
+
+	/*
+	 * Join heap scan ourselves.  Might as well use reliable figure when
+	 * doling out maintenance_work_mem (when requested number of workers were
+	 * not launched, this will be somewhat higher than it is for other
+	 * workers).
+	 */
+	if (leaderparticipates)
+		_gin_parallel_scan_and_build(heap, index, ginshared,
+									 maintenance_work_mem / ginleader->nparticipants);
+
+	/*
+	 * Caller needs to wait for all launched workers when we return.  Make
+	 * sure that the failure-to-start case will not hang forever.
+	 */
+	WaitForParallelWorkersToAttach(pcxt);
+}
+
+/*
+ * Shut down workers, destroy parallel context, and end parallel mode.
+ *
+ * This also removes the run files.
+ */
+static void
+_gin_end_parallel(GinLeader *ginleader)
+{
+	/* Shutdown worker processes */
+	WaitForParallelWorkersToFinish(ginleader->pcxt);
+	/* Free last reference to MVCC snapshot, if one was used */
+	if (IsMVCCSnapshot(ginleader->snapshot))
+		UnregisterSnapshot(ginleader->snapshot);
+	DestroyParallelContext(ginleader->pcxt);
+	ExitParallelMode();
+}
+
+/*
+ * Returns size of shared memory required to store state for a parallel
+ * gin index build based on the snapshot its parallel scan will use.
+ */
+static Size
+_gin_parallel_estimate_shared(Snapshot snapshot)
+{
+	if (!IsMVCCSnapshot(snapshot))
+	{
+		Assert(snapshot == SnapshotAny);
+		return sizeof(GinShared);
+	}
+
+	return add_size(offsetof(GinShared, heapdesc) +
+					offsetof(ParallelHeapScanDescData, phs_snapshot_data),
+					EstimateSnapshotSpace(snapshot));
+}
+
+/*
+ * Within leader, wait for end of heap scan, and then merge the runs written
+ * by all participants into the index.
+ *
+ * Equal keys coming from different runs are combined into one item list
+ * before being inserted, so each key is normally inserted only once; only
+ * a list that grows beyond maintenance_work_mem is inserted in pieces.
+ *
+ * Fills in fields needed for ambuild statistics, and lets caller set
+ * field indicating that some worker encountered a broken HOT chain.
+ *
+ * Returns the total number of heap tuples scanned.
+ */
+static double
+_gin_parallel_merge(GinBuildState *buildstate, bool *brokenhotchain)
+{
+	GinShared  *ginshared = buildstate->ginleader->ginshared;
+	GinState   *ginstate = &buildstate->ginstate;
+	int			nparticipants;
+	double		reltuples;
+	int			nruns;
+	GinRunReader *readers;
+	binaryheap *heap;
+	ItemPointerData *list = NULL;
+	uint32		nlist = 0;
+	OffsetNumber attnum = InvalidOffsetNumber;
+	Datum		key = (Datum) 0;
+	GinNullCategory category = GIN_CAT_NORM_KEY;
+	MemoryContext oldCtx;
+	int			i;
+
+	nparticipants = buildstate->ginleader->nparticipants;
+	for (;;)
+	{
+		SpinLockAcquire(&ginshared->mutex);
+		if (ginshared->nparticipantsdone == nparticipants)
+		{
+			buildstate->indtuples = ginshared->indtuples;
+			*brokenhotchain = ginshared->brokenhotchain;
+			reltuples = ginshared->reltuples;
+			nruns = ginshared->nruns;
+			SpinLockRelease(&ginshared->mutex);
+			break;
+		}
+		SpinLockRelease(&ginshared->mutex);
+
+		ConditionVariableSleep(&ginshared->workersdonecv,
+							   WAIT_EVENT_PARALLEL_CREATE_INDEX_SCAN);
+	}
+
+	ConditionVariableCancelSleep();
+
+	if (nruns == 0)
+		return reltuples;
+
+	/* Open all the runs, and order them by their first entry */
+	readers = (GinRunReader *) palloc0(nruns * sizeof(GinRunReader));
+	heap = binaryheap_allocate(nruns, ginRunReaderCompare, ginstate);
+	for (i = 0; i < nruns; i++)
+	{
+		char		name[MAXPGPATH];
+
+		snprintf(name, sizeof(name), "run%d", i);
+		readers[i].file = BufFileOpenShared(&ginshared->fileset, name);
+		if (ginReadRunEntry(&readers[i]))
+			binaryheap_add_unordered(heap, PointerGetDatum(&readers[i]));
+	}
+	binaryheap_build(heap);
+
+	while (!binaryheap_empty(heap))
+	{
+		GinRunReader *reader;
+
+		/* there could be many entries, so be willing to abort here */
+		CHECK_FOR_INTERRUPTS();
+
+		reader = (GinRunReader *) DatumGetPointer(binaryheap_first(heap));
+
+		/* Insert the list collected so far once we move on to the next key */
+		if (nlist > 0 &&
+			(ginCompareAttEntries(ginstate, attnum, key, category,
+								  reader->attnum, reader->key,
+								  reader->category) != 0 ||
+			 nlist * sizeof(ItemPointerData) >=
+			 (Size) maintenance_work_mem * 1024L))
+		{
+			oldCtx = MemoryContextSwitchTo(buildstate->tmpCtx);
+			ginEntryInsert(ginstate, attnum, key, category,
+						   list, nlist, &buildstate->buildStats);
+			MemoryContextSwitchTo(oldCtx);
+			MemoryContextReset(buildstate->tmpCtx);
+			nlist = 0;
+		}
+
+		oldCtx = MemoryContextSwitchTo(buildstate->tmpCtx);
+		if (nlist == 0)
+		{
+			Form_pg_attribute attr = TupleDescAttr(ginstate->origTupdesc,
+												   reader->attnum - 1);
+
+			attnum = reader->attnum;
+			category = reader->category;
+			if (category == GIN_CAT_NORM_KEY)
+				key = datumCopy(reader->key, attr->attbyval, attr->attlen);
+			else
+				key = (Datum) 0;
+			list = (ItemPointerData *)
+				palloc(reader->nitems * sizeof(ItemPointerData));
+			memcpy(list, reader->items, reader->nitems * sizeof(ItemPointerData));
+			nlist = reader->nitems;
+		}
+		else
+		{
+			ItemPointerData *merged;
+			int			nmerged;
+
+			merged = ginMergeItemPointers(list, nlist,
+										  reader->items, reader->nitems,
+										  &nmerged);
+			pfree(list);
+			list = merged;
+			nlist = nmerged;
+		}
+		MemoryContextSwitchTo(oldCtx);
+
+		if (ginReadRunEntry(reader))
+			binaryheap_replace_first(heap, PointerGetDatum(reader));
+		else
+			binaryheap_remove_first(heap);
+	}
+
+	if (nlist > 0)
+	{
+		oldCtx = MemoryContextSwitchTo(buildstate->tmpCtx);
+		ginEntryInsert(ginstate, attnum, key, category,
+					   list, nlist, &buildstate->buildStats);
+		MemoryContextSwitchTo(oldCtx);
+		MemoryContextReset(buildstate->tmpCtx);
+	}
+
+	for (i = 0; i < nruns; i++)
+	{
+		BufFileClose(readers[i].file);
+		if (readers[i].buf)
+			pfree(readers[i].buf);
+	}
+	pfree(readers);
+	binaryheap_free(heap);
+
+	return reltuples;
+}
+
+/*
+ * Perform work within a launched parallel process.
+ */
+void
+_gin_parallel_build_main(dsm_segment *seg, shm_toc *toc)
+{
+	char	   *sharedquery;
+	GinShared  *ginshared;
+	Relation	heapRel;
+	Relation	indexRel;
+	LOCKMODE	heapLockmode;
+	LOCKMODE	indexLockmode;
+
+	/* Set debug_query_string for individual workers first */
+	sharedquery = shm_toc_lookup(toc, PARALLEL_KEY_QUERY_TEXT, false);
+	debug_query_string = sharedquery;
+
+	/* Report the query string from leader */
+	pgstat_report_activity(STATE_RUNNING, debug_query_string);
+
+	/* Look up gin shared state */
+	ginshared = shm_toc_lookup(toc, PARALLEL_KEY_GIN_SHARED, false);
+
+	/* Open relations using lock modes known to be obtained by index.c */
+	if (!ginshared->isconcurrent)
+	{
+		heapLockmode = ShareLock;
+		indexLockmode = AccessExclusiveLock;
+	}
+	else
+	{
+		heapLockmode = ShareUpdateExclusiveLock;
+		indexLockmode = RowExclusiveLock;
+	}
+
+	/* Open relations within worker */
+	heapRel = heap_open(ginshared->heaprelid, heapLockmode);
+	indexRel = index_open(ginshared->indexrelid, indexLockmode);
+
+	/* Attach to the fileset the runs are written to */
+	SharedFileSetAttach(&ginshared->fileset, seg);
+
+	_gin_parallel_scan_and_build(heapRel, indexRel, ginshared,
+								 maintenance_work_mem / ginshared->scanstates);
+
+	index_close(indexRel, indexLockmode);
+	heap_close(heapRel, heapLockmode);
+}
+
+/*
+ * Perform a participant's portion of a parallel build: scan its share of
+ * the heap, and write the extracted entries out as sorted runs.
+ *
+ * workmem is the amount of memory the participant's BuildAccumulator may
+ * use before it is dumped to a run, expressed in KBs.
+ */
+static void
+_gin_parallel_scan_and_build(Relation heap, Relation index,
+							 GinShared *ginshared, int workmem)
+{
+	GinBuildState buildstate;
+	HeapScanDesc scan;
+	double		reltuples;
+	IndexInfo  *indexInfo;
+	MemoryContext oldCtx;
+
+	initGinState(&buildstate.ginstate, index);
+	buildstate.indtuples = 0;
+	memset(&buildstate.buildStats, 0, sizeof(GinStatsData));
+	buildstate.workmem = workmem;
+	buildstate.ginshared = ginshared;
+	buildstate.ginleader = NULL;
+
+	buildstate.tmpCtx = AllocSetContextCreate(CurrentMemoryContext,
+											  "Gin build temporary context",
+											  ALLOCSET_DEFAULT_SIZES);
+	buildstate.funcCtx = AllocSetContextCreate(CurrentMemoryContext,
+											   "Gin build temporary context for user-defined function",
+											   ALLOCSET_DEFAULT_SIZES);
+
+	buildstate.accum.ginstate = &buildstate.ginstate;
+	ginInitBA(&buildstate.accum);
+
+	/* Join parallel scan */
+	indexInfo = BuildIndexInfo(index);
+	indexInfo->ii_Concurrent = ginshared->isconcurrent;
+	scan = heap_beginscan_parallel(heap, &ginshared->heapdesc);
+	reltuples = IndexBuildHeapScan(heap, index, indexInfo, true,
+								   ginBuildCallback, (void *) &buildstate,
+								   scan);
+
+	/* write out the remaining entries as a final run */
+	oldCtx = MemoryContextSwitchTo(buildstate.tmpCtx);
+	ginDumpAccum(&buildstate);
+	MemoryContextSwitchTo(oldCtx);
+
+	MemoryContextDelete(buildstate.funcCtx);
+	MemoryContextDelete(buildstate.tmpCtx);
+
+	/*
+	 * Done.  Record ambuild statistics, and whether we encountered a broken
+	 * HOT chain.
+	 */
+	SpinLockAcquire(&ginshared->mutex);
+	ginshared->nparticipantsdone++;
+	ginshared->reltuples += reltuples;
+	ginshared->indtuples += buildstate.indtuples;
+	if (indexInfo->ii_BrokenHotChain)
+		ginshared->brokenhotchain = true;
+	SpinLockRelease(&ginshared->mutex);
+
+	/* Notify leader */
+	ConditionVariableSignal(&ginshared->workersdonecv);
+}
+
 /*
  *	ginbuildempty() -- build an empty gin index in the initialization fork
  */
@@ -110,6 +110,9 @@ ginFillScanEntry(GinScanOpaque so, OffsetNumber attnum,
 	scanEntry->list = NULL;
 	scanEntry->nlist = 0;
 	scanEntry->offset = InvalidOffsetNumber;
+	scanEntry->segbuf = NULL;
+	scanEntry->nextseg = NULL;
+	scanEntry->segend = NULL;
 	scanEntry->isFinished = false;
 	scanEntry->reduceResult = false;
 
@@ -244,6 +247,8 @@ ginFreeScanKeys(GinScanOpaque so)
 			ReleaseBuffer(entry->buffer);
 		if (entry->list)
 			pfree(entry->list);
+		if (entry->segbuf)
+			pfree(entry->segbuf);
 		if (entry->matchIterator)
 			tbm_end_iterate(entry->matchIterator);
 		if (entry->matchBitmap)
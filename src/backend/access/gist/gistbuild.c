@@ -3,6 +3,25 @@
  * gistbuild.c
  *	  build algorithm for GiST indexes implementation.
  *
+ * There are two different strategies:
+ *
+ * 1. Sort all input tuples, pack them into GiST leaf pages in the sorted
+ *	  order, and create downlinks and internal pages as we go.  This builds
+ *	  the index from the bottom up, similar to how B-tree index build
+ *	  works.
+ *
+ * 2. Start with an empty index, and insert all tuples one by one.
+ *
+ * The sorted method is used if the operator classes for all columns have
+ * a 'sortsupport' defined, and the "buffering" option was not given
+ * explicitly.  Otherwise, we resort to the second strategy.
+ *
+ * The second strategy can optionally use buffers at different levels of
+ * the tree to reduce I/O, see "Buffering build algorithm" in the README
+ * for a more detailed explanation.  It initially calls insert over and
+ * over, but switches to the buffered algorithm after a certain number of
+ * tuples (unless buffering mode is disabled).
+ *
  *
  * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
@@ -19,6 +38,7 @@
 #include "access/genam.h"
 #include "access/gist_private.h"
 #include "access/gistxlog.h"
+#include "access/xlog.h"
 #include "access/xloginsert.h"
 #include "catalog/index.h"
 #include "miscadmin.h"
@@ -27,6 +47,7 @@
 #include "storage/smgr.h"
 #include "utils/memutils.h"
 #include "utils/rel.h"
+#include "utils/tuplesort.h"
 
 /* Step of index tuples for check whether to switch to buffering build mode */
 #define BUFFERING_MODE_SWITCH_CHECK_STEP 256
@@ -49,7 +70,8 @@ typedef enum
 	GIST_BUFFERING_STATS,		/* gathering statistics of index tuple size
 								 * before switching to the buffering build
 								 * mode */
-	GIST_BUFFERING_ACTIVE		/* in buffering build mode */
+	GIST_BUFFERING_ACTIVE,		/* in buffering build mode */
+	GIST_SORTED_BUILD			/* bottom-up build by sorting */
 } GistBufferingMode;
 
 /* Working state for gistbuild and its callback */
@@ -73,9 +95,45 @@ typedef struct
 	HTAB	   *parentMap;
 
 	GistBufferingMode bufferingMode;
+
+	/*
+	 * Extra data structures used during a sorted build.  'sortstate' holds
+	 * the sorted input tuples; pages are written out directly in block order,
+	 * 'pages_allocated' being the next block number to use.
+	 */
+	Tuplesortstate *sortstate;
+	BlockNumber pages_allocated;
+	bool		use_wal;		/* must the written pages be WAL-logged? */
 } GISTBuildState;
 
+/*
+ * In a sorted build, we use a stack of these structs, one for each level,
+ * to hold an in-memory buffer of the rightmost page at the level.  When the
+ * page fills up, it is written out and a new page is started.
+ */
+typedef struct GistSortedBuildPageState
+{
+	Page		page;
+	struct GistSortedBuildPageState *parent;	/* upper level, if any */
+} GistSortedBuildPageState;
+
 /* prototypes for private functions */
+
+static void gistSortedBuildCallback(Relation index,
+						HeapTuple htup,
+						Datum *values,
+						bool *isnull,
+						bool tupleIsAlive,
+						void *state);
+static void gist_indexsortbuild(GISTBuildState *state);
+static void gist_indexsortbuild_pagestate_add(GISTBuildState *state,
+								  GistSortedBuildPageState *pagestate,
+								  IndexTuple itup);
+static void gist_indexsortbuild_pagestate_flush(GISTBuildState *state,
+									GistSortedBuildPageState *pagestate);
+static void gist_indexsortbuild_write_page(GISTBuildState *state, Page page,
+							   BlockNumber blkno);
+
 static void gistInitBuffering(GISTBuildState *buildstate);
 static int	calculatePagesPerBuffer(GISTBuildState *buildstate, int levelStep);
 static void gistBuildCallback(Relation index,
@@ -107,9 +165,7 @@ static void gistMemorizeAllDownlinks(GISTBuildState *buildstate, Buffer parent);
 static BlockNumber gistGetParent(GISTBuildState *buildstate, BlockNumber child);
 
 /*
- * Main entry point to GiST index build. Initially calls insert over and over,
- * but switches to more efficient buffering build algorithm after a certain
- * number of tuples (unless buffering mode is disabled).
+ * Main entry point to GiST index build.
  */
 IndexBuildResult *
 gistbuild(Relation heap, Relation index, IndexInfo *indexInfo)
@@ -148,6 +204,30 @@ gistbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 		buildstate.bufferingMode = GIST_BUFFERING_AUTO;
 		fillfactor = GIST_DEFAULT_FILLFACTOR;
 	}
+
+	/*
+	 * Unless buffering was explicitly turned on or off, build the index by
+	 * sorting if the opclasses of all the key columns support that.
+	 */
+	if (buildstate.bufferingMode == GIST_BUFFERING_AUTO)
+	{
+		bool		hasallsortsupports = true;
+		int			keyscount = IndexRelationGetNumberOfKeyAttributes(index);
+		int			i;
+
+		for (i = 0; i < keyscount; i++)
+		{
+			if (!OidIsValid(index_getprocid(index, i + 1,
+											GIST_SORTSUPPORT_PROC)))
+			{
+				hasallsortsupports = false;
+				break;
+			}
+		}
+		if (hasallsortsupports)
+			buildstate.bufferingMode = GIST_SORTED_BUILD;
+	}
+
 	/* Calculate target amount of free space to leave on pages */
 	buildstate.freespace = BLCKSZ * (100 - fillfactor) / 100;
 
@@ -169,53 +249,86 @@ gistbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 	 */
 	buildstate.giststate->tempCxt = createTempGistContext();
 
-	/* initialize the root page */
-	buffer = gistNewBuffer(index);
-	Assert(BufferGetBlockNumber(buffer) == GIST_ROOT_BLKNO);
-	page = BufferGetPage(buffer);
+	/* build the index */
+	buildstate.indtuples = 0;
+	buildstate.indtuplesSize = 0;
 
-	START_CRIT_SECTION();
+	if (buildstate.bufferingMode == GIST_SORTED_BUILD)
+	{
+		/*
+		 * Sort all data, then build the index from the bottom up.  As in a
+		 * B-tree build, the pages are written out directly rather than
+		 * through shared buffers, so they only need to be WAL-logged if WAL
+		 * archiving or streaming is enabled.
+		 */
+		buildstate.use_wal = XLogIsNeeded() && RelationNeedsWAL(index);
+		buildstate.sortstate = tuplesort_begin_index_gist(heap,
+														  index,
+														  maintenance_work_mem,
+														  NULL,
+														  false);
+
+		/* Scan the table, adding all tuples to the tuplesort */
+		reltuples = IndexBuildHeapScan(heap, index, indexInfo, true,
+									   gistSortedBuildCallback,
+									   (void *) &buildstate, NULL);
 
-	GISTInitBuffer(buffer, F_LEAF);
+		/*
+		 * Perform the sort and build index pages.
+		 */
+		tuplesort_performsort(buildstate.sortstate);
 
-	MarkBufferDirty(buffer);
+		gist_indexsortbuild(&buildstate);
 
-	if (RelationNeedsWAL(index))
+		tuplesort_end(buildstate.sortstate);
+	}
+	else
 	{
-		XLogRecPtr	recptr;
+		/* initialize the root page */
+		buffer = gistNewBuffer(index);
+		Assert(BufferGetBlockNumber(buffer) == GIST_ROOT_BLKNO);
+		page = BufferGetPage(buffer);
 
-		XLogBeginInsert();
-		XLogRegisterBuffer(0, buffer, REGBUF_WILL_INIT);
+		START_CRIT_SECTION();
 
-		recptr = XLogInsert(RM_GIST_ID, XLOG_GIST_CREATE_INDEX);
-		PageSetLSN(page, recptr);
-	}
-	else
-		PageSetLSN(page, gistGetFakeLSN(heap));
+		GISTInitBuffer(buffer, F_LEAF);
 
-	UnlockReleaseBuffer(buffer);
+		MarkBufferDirty(buffer);
 
-	END_CRIT_SECTION();
+		if (RelationNeedsWAL(index))
+		{
+			XLogRecPtr	recptr;
 
-	/* build the index */
-	buildstate.indtuples = 0;
-	buildstate.indtuplesSize = 0;
+			XLogBeginInsert();
+			XLogRegisterBuffer(0, buffer, REGBUF_WILL_INIT);
 
-	/*
-	 * Do the heap scan.
-	 */
-	reltuples = IndexBuildHeapScan(heap, index, indexInfo, true,
-								   gistBuildCallback, (void *) &buildstate, NULL);
+			recptr = XLogInsert(RM_GIST_ID, XLOG_GIST_CREATE_INDEX);
+			PageSetLSN(page, recptr);
+		}
+		else
+			PageSetLSN(page, gistGetFakeLSN(heap));
 
-	/*
-	 * If buffering was used, flush out all the tuples that are still in the
-	 * buffers.
-	 */
-	if (buildstate.bufferingMode == GIST_BUFFERING_ACTIVE)
-	{
-		elog(DEBUG1, "all tuples processed, emptying buffers");
-		gistEmptyAllBuffers(&buildstate);
-		gistFreeBuildBuffers(buildstate.gfbb);
+		UnlockReleaseBuffer(buffer);
+
+		END_CRIT_SECTION();
+
+		/*
+		 * Do the heap scan.
+		 */
+		reltuples = IndexBuildHeapScan(heap, index, indexInfo, true,
+									   gistBuildCallback,
+									   (void *) &buildstate, NULL);
+
+		/*
+		 * If buffering was used, flush out all the tuples that are still in
+		 * the buffers.
+		 */
+		if (buildstate.bufferingMode == GIST_BUFFERING_ACTIVE)
+		{
+			elog(DEBUG1, "all tuples processed, emptying buffers");
+			gistEmptyAllBuffers(&buildstate);
+			gistFreeBuildBuffers(buildstate.gfbb);
+		}
 	}
 
 	/* okay, all heap tuples are indexed */
@@ -254,6 +367,219 @@ gistValidateBufferingOption(const char *value)
 	}
 }
 
+/*
+ * Per-tuple callback for IndexBuildHeapScan, in sorted build mode.
+ */
+static void
+gistSortedBuildCallback(Relation index,
+						HeapTuple htup,
+						Datum *values,
+						bool *isnull,
+						bool tupleIsAlive,
+						void *state)
+{
+	GISTBuildState *buildstate = (GISTBuildState *) state;
+	MemoryContext oldCtx;
+	Datum		compressed_values[INDEX_MAX_KEYS];
+
+	oldCtx = MemoryContextSwitchTo(buildstate->giststate->tempCxt);
+
+	/* Form an index tuple and point it at the heap tuple */
+	gistCompressValues(buildstate->giststate, index,
+					   values, isnull,
+					   true, compressed_values);
+
+	tuplesort_putindextuplevalues(buildstate->sortstate,
+								  buildstate->indexrel,
+								  &htup->t_self,
+								  compressed_values, isnull);
+
+	MemoryContextSwitchTo(oldCtx);
+	MemoryContextReset(buildstate->giststate->tempCxt);
+
+	/* Update tuple count. */
+	buildstate->indtuples += 1;
+}
+
+/*
+ * Build GiST index from bottom up from pre-sorted tuples.
+ */
+static void
+gist_indexsortbuild(GISTBuildState *state)
+{
+	IndexTuple	itup;
+	GistSortedBuildPageState *leafstate;
+	GistSortedBuildPageState *pagestate;
+	Page		page;
+
+	/*
+	 * Write an empty page as a placeholder for the root page.  It will be
+	 * overwritten with the real root page at the end, once we know which
+	 * page that is.
+	 */
+	page = (Page) palloc0(BLCKSZ);
+	RelationOpenSmgr(state->indexrel);
+	/* don't set checksum for all-zero page */
+	smgrextend(state->indexrel->rd_smgr, MAIN_FORKNUM, GIST_ROOT_BLKNO,
+			   (char *) page, true);
+	state->pages_allocated = GIST_ROOT_BLKNO + 1;
+
+	/* Use that buffer for the first leaf page */
+	leafstate = (GistSortedBuildPageState *)
+		palloc(sizeof(GistSortedBuildPageState));
+	leafstate->page = page;
+	leafstate->parent = NULL;
+	gistinitpage(page, F_LEAF);
+
+	/*
+	 * Fill index pages with tuples in the sorted order.
+	 */
+	while ((itup = tuplesort_getindextuple(state->sortstate, true)) != NULL)
+	{
+		gist_indexsortbuild_pagestate_add(state, leafstate, itup);
+		MemoryContextReset(state->giststate->tempCxt);
+	}
+
+	/*
+	 * Write out the partially full non-root pages.  Keep in mind that
+	 * flushing a page can start a new level above it.  The page at the top
+	 * level is the root.
+	 */
+	pagestate = leafstate;
+	while (pagestate->parent != NULL)
+	{
+		GistSortedBuildPageState *parent;
+
+		gist_indexsortbuild_pagestate_flush(state, pagestate);
+		parent = pagestate->parent;
+		pfree(pagestate->page);
+		pfree(pagestate);
+		pagestate = parent;
+	}
+
+	/* Write out the root */
+	gist_indexsortbuild_write_page(state, pagestate->page, GIST_ROOT_BLKNO);
+	pfree(pagestate->page);
+	pfree(pagestate);
+
+	/*
+	 * If the index is WAL-logged, we must fsync it down to disk before it's
+	 * safe to commit the transaction, since the pages did not go through
+	 * shared buffers.  See the comments at the end of _bt_load().
+	 */
+	if (RelationNeedsWAL(state->indexrel))
+	{
+		RelationOpenSmgr(state->indexrel);
+		smgrimmedsync(state->indexrel->rd_smgr, MAIN_FORKNUM);
+	}
+}
+
+/*
+ * Add a tuple to a page.  If the page is full, write it out and start a new
+ * one on the same level.
+ */
+static void
+gist_indexsortbuild_pagestate_add(GISTBuildState *state,
+								  GistSortedBuildPageState *pagestate,
+								  IndexTuple itup)
+{
+	if (gistnospace(pagestate->page, &itup, 1, InvalidOffsetNumber,
+					state->freespace))
+	{
+		/* A tuple that doesn't fit on an empty page can never be stored */
+		if (PageIsEmpty(pagestate->page))
+			ereport(ERROR,
+					(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+					 errmsg("index row size %zu exceeds maximum %zu for index \"%s\"",
+							IndexTupleSize(itup), GiSTPageSize,
+							RelationGetRelationName(state->indexrel))));
+
+		gist_indexsortbuild_pagestate_flush(state, pagestate);
+	}
+
+	gistfillbuffer(pagestate->page, &itup, 1, InvalidOffsetNumber);
+}
+
+/*
+ * Write out a page, add its downlink to the parent level, which is created
+ * if it doesn't exist yet, and reinitialize the page as an empty page of the
+ * same level.
+ */
+static void
+gist_indexsortbuild_pagestate_flush(GISTBuildState *state,
+									GistSortedBuildPageState *pagestate)
+{
+	GistSortedBuildPageState *parent;
+	IndexTuple *itvec;
+	IndexTuple	union_tuple;
+	int			vect_len;
+	bool		isleaf;
+	BlockNumber blkno;
+	MemoryContext oldCtx;
+
+	/* Compute the downlink for the page, before it is written */
+	oldCtx = MemoryContextSwitchTo(state->giststate->tempCxt);
+
+	itvec = gistextractpage(pagestate->page, &vect_len);
+	union_tuple = gistunion(state->indexrel, itvec, vect_len,
+							state->giststate);
+
+	MemoryContextSwitchTo(oldCtx);
+
+	isleaf = GistPageIsLeaf(pagestate->page);
+	blkno = state->pages_allocated++;
+	gist_indexsortbuild_write_page(state, pagestate->page, blkno);
+
+	ItemPointerSetBlockNumber(&(union_tuple->t_tid), blkno);
+	GistTupleSetValid(union_tuple);
+
+	/* Add the downlink to the parent, starting a new level if needed */
+	parent = pagestate->parent;
+	if (parent == NULL)
+	{
+		parent = (GistSortedBuildPageState *)
+			palloc(sizeof(GistSortedBuildPageState));
+		parent->page = (Page) palloc(BLCKSZ);
+		parent->parent = NULL;
+		gistinitpage(parent->page, 0);
+
+		pagestate->parent = parent;
+	}
+	gist_indexsortbuild_pagestate_add(state, parent, union_tuple);
+
+	/* Start over with an empty page */
+	gistinitpage(pagestate->page, isleaf ? F_LEAF : 0);
+}
+
+/*
+ * Write a finished page to disk, WAL-logging it if needed.  Apart from the
+ * root, pages are written in block number order, so they extend the file.
+ */
+static void
+gist_indexsortbuild_write_page(GISTBuildState *state, Page page,
+							   BlockNumber blkno)
+{
+	Relation	index = state->indexrel;
+
+	/* Ensure rd_smgr is open (could have been closed by relcache flush!) */
+	RelationOpenSmgr(index);
+
+	/* We use the heap NEWPAGE record type for this */
+	if (state->use_wal)
+		log_newpage(&index->rd_node, MAIN_FORKNUM, blkno, page, true);
+
+	PageSetChecksumInplace(page, blkno);
+
+	/*
+	 * There's no need for smgr to schedule an fsync for this write; we'll do
+	 * it ourselves before ending the build.
+	 */
+	if (blkno == GIST_ROOT_BLKNO)
+		smgrwrite(index->rd_smgr, MAIN_FORKNUM, blkno, (char *) page, true);
+	else
+		smgrextend(index->rd_smgr, MAIN_FORKNUM, blkno, (char *) page, true);
+}
+
 /*
  * Attempt to switch to buffering mode.
  *
@@ -535,6 +535,122 @@ getNextGISTSearchItem(GISTScanOpaque so)
 	return item;
 }
 
+/*
+ * Begin a parallel scan.
+ *
+ * The first participant to get here reads the root page with gistScanPage()
+ * as a serial scan would (so tbm and ntids are as for that), then moves the child pages that it queued into the
+ * shared state so that all participants can claim them.  Everyone else waits
+ * until that is done.
+ */
+static void
+gistParallelStart(IndexScanDesc scan, TIDBitmap *tbm, int64 *ntids)
+{
+	GISTScanOpaque so = (GISTScanOpaque) scan->opaque;
+	ParallelIndexScanDesc parallel_scan = scan->parallel_scan;
+	GISTParallelScanDesc gistscan;
+	bool		read_root = false;
+
+	gistscan = (GISTParallelScanDesc) OffsetToPointer((void *) parallel_scan,
+													  parallel_scan->ps_offset);
+
+	SpinLockAcquire(&gistscan->gps_mutex);
+	if (gistscan->gps_state == GISTPARALLEL_NOT_STARTED)
+	{
+		gistscan->gps_state = GISTPARALLEL_READING_ROOT;
+		read_root = true;
+	}
+	SpinLockRelease(&gistscan->gps_mutex);
+
+	if (read_root)
+	{
+		GISTSearchItem fakeItem;
+		GISTSearchItem *item;
+		GistNSN		rootlsn = InvalidXLogRecPtr;
+		int			nsubtrees = 0;
+
+		fakeItem.blkno = GIST_ROOT_BLKNO;
+		memset(&fakeItem.data.parentlsn, 0, sizeof(GistNSN));
+		gistScanPage(scan, &fakeItem, NULL, tbm, ntids);
+
+		/*
+		 * Nobody else looks at gps_subtrees until we change the state, so
+		 * it's safe to fill it without holding the spinlock.  All the pages
+		 * queued came from the root, so they have the same parentlsn.
+		 */
+		while ((item = getNextGISTSearchItem(so)) != NULL)
+		{
+			Assert(!GISTSearchItemIsHeap(*item));
+			Assert(nsubtrees < MaxIndexTuplesPerPage);
+			gistscan->gps_subtrees[nsubtrees++] = item->blkno;
+			rootlsn = item->data.parentlsn;
+			pfree(item);
+		}
+
+		SpinLockAcquire(&gistscan->gps_mutex);
+		gistscan->gps_rootlsn = rootlsn;
+		gistscan->gps_nsubtrees = nsubtrees;
+		gistscan->gps_nextsubtree = 0;
+		gistscan->gps_state = GISTPARALLEL_ROOT_DONE;
+		SpinLockRelease(&gistscan->gps_mutex);
+		ConditionVariableBroadcast(&gistscan->gps_cv);
+	}
+	else
+	{
+		for (;;)
+		{
+			GISTPS_State state;
+
+			SpinLockAcquire(&gistscan->gps_mutex);
+			state = gistscan->gps_state;
+			SpinLockRelease(&gistscan->gps_mutex);
+			if (state == GISTPARALLEL_ROOT_DONE)
+				break;
+			ConditionVariableSleep(&gistscan->gps_cv, WAIT_EVENT_GIST_ROOT);
+		}
+		ConditionVariableCancelSleep();
+	}
+}
+
+/*
+ * Claim the next unscanned child of the root in a parallel scan.
+ *
+ * Returns a GISTSearchItem for it, or NULL if all of them have been claimed.
+ * Caller must pfree item when done with it.
+ */
+static GISTSearchItem *
+gistParallelNextSubtree(IndexScanDesc scan)
+{
+	GISTScanOpaque so = (GISTScanOpaque) scan->opaque;
+	ParallelIndexScanDesc parallel_scan = scan->parallel_scan;
+	GISTParallelScanDesc gistscan;
+	GISTSearchItem *item;
+	BlockNumber blkno = InvalidBlockNumber;
+	GistNSN		rootlsn = InvalidXLogRecPtr;
+
+	gistscan = (GISTParallelScanDesc) OffsetToPointer((void *) parallel_scan,
+													  parallel_scan->ps_offset);
+
+	SpinLockAcquire(&gistscan->gps_mutex);
+	Assert(gistscan->gps_state == GISTPARALLEL_ROOT_DONE);
+	if (gistscan->gps_nextsubtree < gistscan->gps_nsubtrees)
+	{
+		blkno = gistscan->gps_subtrees[gistscan->gps_nextsubtree++];
+		rootlsn = gistscan->gps_rootlsn;
+	}
+	SpinLockRelease(&gistscan->gps_mutex);
+
+	if (blkno == InvalidBlockNumber)
+		return NULL;
+
+	item = MemoryContextAlloc(so->queueCxt,
+							  SizeOfGISTSearchItem(scan->numberOfOrderBys));
+	item->blkno = blkno;
+	item->data.parentlsn = rootlsn;
+
+	return item;
+}
+
 /*
  * Fetch next heap tuple in an ordered search
  */
@@ -614,13 +730,21 @@ gistgettuple(IndexScanDesc scan, ScanDirection dir)
 		if (so->pageDataCxt)
 			MemoryContextReset(so->pageDataCxt);
 
-		fakeItem.blkno = GIST_ROOT_BLKNO;
-		memset(&fakeItem.data.parentlsn, 0, sizeof(GistNSN));
-		gistScanPage(scan, &fakeItem, NULL, NULL, NULL);
+		if (scan->parallel_scan)
+			gistParallelStart(scan, NULL, NULL);
+		else
+		{
+			fakeItem.blkno = GIST_ROOT_BLKNO;
+			memset(&fakeItem.data.parentlsn, 0, sizeof(GistNSN));
+			gistScanPage(scan, &fakeItem, NULL, NULL, NULL);
+		}
 	}
 
 	if (scan->numberOfOrderBys > 0)
 	{
+		/* Parallel scans can't promise distance order, see gist_private.h */
+		Assert(scan->parallel_scan == NULL);
+
 		/* Must fetch tuples in strict distance order */
 		return getNextNearest(scan);
 	}
@@ -696,6 +820,10 @@ gistgettuple(IndexScanDesc scan, ScanDirection dir)
 
 				item = getNextGISTSearchItem(so);
 
+				/* In a parallel scan, move on to another subtree of the root */
+				if (!item && scan->parallel_scan)
+					item = gistParallelNextSubtree(scan);
+
 				if (!item)
 					return false;
 
@@ -739,18 +867,27 @@ gistgetbitmap(IndexScanDesc scan, TIDBitmap *tbm)
 	if (so->pageDataCxt)
 		MemoryContextReset(so->pageDataCxt);
 
-	fakeItem.blkno = GIST_ROOT_BLKNO;
-	memset(&fakeItem.data.parentlsn, 0, sizeof(GistNSN));
-	gistScanPage(scan, &fakeItem, NULL, tbm, &ntids);
+	if (scan->parallel_scan)
+		gistParallelStart(scan, tbm, &ntids);
+	else
+	{
+		fakeItem.blkno = GIST_ROOT_BLKNO;
+		memset(&fakeItem.data.parentlsn, 0, sizeof(GistNSN));
+		gistScanPage(scan, &fakeItem, NULL, tbm, &ntids);
+	}
 
 	/*
 	 * While scanning a leaf page, ItemPointers of matching heap tuples will
 	 * be stored directly into tbm, so we don't need to deal with them here.
+	 * In a parallel scan, tbm only gets the TIDs of the subtrees we claim.
 	 */
 	for (;;)
 	{
 		GISTSearchItem *item = getNextGISTSearchItem(so);
 
+		if (!item && scan->parallel_scan)
+			item = gistParallelNextSubtree(scan);
+
 		if (!item)
 			break;
 
@@ -24,6 +24,7 @@
 #include "utils/builtins.h"
 #include "utils/float.h"
 #include "utils/geo_decls.h"
+#include "utils/sortsupport.h"
 
 
 static bool gist_box_leaf_consistent(BOX *key, BOX *query,
@@ -1530,3 +1531,150 @@ gist_poly_distance(PG_FUNCTION_ARGS)
 
 	PG_RETURN_FLOAT8(distance);
 }
+
+/*
+ * Z-order routines for sorted index build
+ *
+ * A sorted build packs the leaf pages in the order of the sort, so the sort
+ * order needs to keep points that are close to each other in the plane close
+ * to each other in the sort.  Z-order (also known as Morton code) does that
+ * well enough and is cheap to compute: the bits of the X and Y coordinates
+ * are interleaved into a single integer.
+ */
+
+/*
+ * Map a float8 to a uint64 in a way that preserves the ordering.
+ *
+ * The IEEE 754 bit pattern of a non-negative double, read as an integer,
+ * sorts the same way as the double itself; for negative values the order is
+ * reversed.  So we flip all bits of negative values and just the sign bit of
+ * positive ones, which gives negative values the lower half of the range and
+ * positive ones the upper half.  Both zeroes map to the same value, and all
+ * NaNs sort after everything else.
+ */
+static uint64
+ieee_float64_to_uint64(float8 f)
+{
+	union
+	{
+		float8		f;
+		uint64		i;
+	}			u;
+
+	if (isnan(f))
+		return PG_UINT64_MAX;
+	if (f == 0.0)
+		return UINT64CONST(0x8000000000000000);
+
+	u.f = f;
+	if (u.i & UINT64CONST(0x8000000000000000))
+		u.i = ~u.i;
+	else
+		u.i |= UINT64CONST(0x8000000000000000);
+
+	return u.i;
+}
+
+/* Spread the 32 bits of x out to the even bits of a 64-bit integer */
+static uint64
+part_bits32_by2(uint32 x)
+{
+	uint64		n = x;
+
+	n = (n | (n << 16)) & UINT64CONST(0x0000FFFF0000FFFF);
+	n = (n | (n << 8)) & UINT64CONST(0x00FF00FF00FF00FF);
+	n = (n | (n << 4)) & UINT64CONST(0x0F0F0F0F0F0F0F0F);
+	n = (n | (n << 2)) & UINT64CONST(0x3333333333333333);
+	n = (n | (n << 1)) & UINT64CONST(0x5555555555555555);
+
+	return n;
+}
+
+/*
+ * Compute the Z-value of a point, from the high 32 bits of the order
+ * preserving representations of its coordinates.
+ */
+static uint64
+point_zorder_internal(float8 x, float8 y)
+{
+	uint32		ix = (uint32) (ieee_float64_to_uint64(x) >> 32);
+	uint32		iy = (uint32) (ieee_float64_to_uint64(y) >> 32);
+
+	return part_bits32_by2(ix) | (part_bits32_by2(iy) << 1);
+}
+
+/*
+ * Compare two compressed points, ie. boxes with both corners equal, in
+ * Z-order.
+ */
+static int
+gist_bbox_zorder_cmp(Datum a, Datum b, SortSupport ssup)
+{
+	Point	   *p1 = &(DatumGetBoxP(a)->low);
+	Point	   *p2 = &(DatumGetBoxP(b)->low);
+	uint64		z1;
+	uint64		z2;
+
+	/* Do a quick check for equality first */
+	if (p1->x == p2->x && p1->y == p2->y)
+		return 0;
+
+	z1 = point_zorder_internal(p1->x, p1->y);
+	z2 = point_zorder_internal(p2->x, p2->y);
+	if (z1 > z2)
+		return 1;
+	else if (z1 < z2)
+		return -1;
+	else
+		return 0;
+}
+
+/*
+ * Abbreviated key conversion: the Z-value itself, truncated to the width of
+ * a Datum.
+ */
+static Datum
+gist_bbox_zorder_abbrev_convert(Datum original, SortSupport ssup)
+{
+	Point	   *p = &(DatumGetBoxP(original)->low);
+	uint64		z;
+
+	z = point_zorder_internal(p->x, p->y);
+
+#if SIZEOF_DATUM == 8
+	return (Datum) z;
+#else
+	return (Datum) (z >> 32);
+#endif
+}
+
+/*
+ * We never abort abbreviation: computing the Z-value is cheap, and the full
+ * comparator has to compute it anyway.
+ */
+static bool
+gist_bbox_zorder_abbrev_abort(int memtupcount, SortSupport ssup)
+{
+	return false;
+}
+
+/*
+ * Sort support routine for a sorted build of an index using point_ops.
+ */
+Datum
+gist_point_sortsupport(PG_FUNCTION_ARGS)
+{
+	SortSupport ssup = (SortSupport) PG_GETARG_POINTER(0);
+
+	if (ssup->abbreviate)
+	{
+		ssup->comparator = ssup_datum_unsigned_cmp;
+		ssup->abbrev_converter = gist_bbox_zorder_abbrev_convert;
+		ssup->abbrev_abort = gist_bbox_zorder_abbrev_abort;
+		ssup->abbrev_full_comparator = gist_bbox_zorder_cmp;
+	}
+	else
+		ssup->comparator = gist_bbox_zorder_cmp;
+
+	PG_RETURN_VOID();
+}
@@ -329,3 +329,55 @@ gistendscan(IndexScanDesc scan)
 	 */
 	freeGISTstate(so->giststate);
 }
+
+/*
+ * gistestimateparallelscan -- estimate storage for GISTParallelScanDescData
+ */
+Size
+gistestimateparallelscan(void)
+{
+	return sizeof(GISTParallelScanDescData);
+}
+
+/*
+ * gistinitparallelscan -- initialize GISTParallelScanDesc for parallel GiST
+ * scan
+ */
+void
+gistinitparallelscan(void *target)
+{
+	GISTParallelScanDesc gist_target = (GISTParallelScanDesc) target;
+
+	SpinLockInit(&gist_target->gps_mutex);
+	gist_target->gps_state = GISTPARALLEL_NOT_STARTED;
+	gist_target->gps_rootlsn = InvalidXLogRecPtr;
+	gist_target->gps_nsubtrees = 0;
+	gist_target->gps_nextsubtree = 0;
+	ConditionVariableInit(&gist_target->gps_cv);
+}
+
+/*
+ * gistparallelrescan() -- reset parallel scan
+ */
+void
+gistparallelrescan(IndexScanDesc scan)
+{
+	GISTParallelScanDesc gistscan;
+	ParallelIndexScanDesc parallel_scan = scan->parallel_scan;
+
+	Assert(parallel_scan);
+
+	gistscan = (GISTParallelScanDesc) OffsetToPointer((void *) parallel_scan,
+													  parallel_scan->ps_offset);
+
+	/*
+	 * No other participant should be running at this point, but take the
+	 * spinlock anyway, for consistency with btparallelrescan().
+	 */
+	SpinLockAcquire(&gistscan->gps_mutex);
+	gistscan->gps_state = GISTPARALLEL_NOT_STARTED;
+	gistscan->gps_rootlsn = InvalidXLogRecPtr;
+	gistscan->gps_nsubtrees = 0;
+	gistscan->gps_nextsubtree = 0;
+	SpinLockRelease(&gistscan->gps_mutex);
+}
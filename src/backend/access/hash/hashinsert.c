@@ -105,9 +105,15 @@ restart_insert:
 	 * It's only interesting to finish the split if we're trying to insert
 	 * into the bucket from which we're removing tuples (the "old" bucket),
 	 * not if we're trying to insert into the bucket into which tuples are
-	 * being moved (the "new" bucket).
+	 * being moved (the "new" bucket).  Also, finishing the split means
+	 * moving a whole bucket's worth of tuples, so don't saddle this insert
+	 * with it when the primary bucket page has room for the new tuple
+	 * anyway; the split will be finished by a later insert that needs the
+	 * room, or by the next attempt to split this bucket.
 	 */
-	if (H_BUCKET_BEING_SPLIT(pageopaque) && IsBufferCleanupOK(buf))
+	if (H_BUCKET_BEING_SPLIT(pageopaque) &&
+		PageGetFreeSpace(page) < itemsz &&
+		IsBufferCleanupOK(buf))
 	{
 		/* release the lock on bucket buffer, before completing the split. */
 		LockBuffer(buf, BUFFER_LOCK_UNLOCK);
@@ -65,6 +65,7 @@
 #include "storage/lmgr.h"
 #include "storage/predicate.h"
 #include "storage/procarray.h"
+#include "storage/read_stream.h"
 #include "storage/smgr.h"
 #include "storage/spin.h"
 #include "storage/standby.h"
@@ -95,6 +96,9 @@ static HeapScanDesc heap_beginscan_internal(Relation relation,
 						bool temp_snap);
 static void heap_parallelscan_startblock_init(HeapScanDesc scan);
 static BlockNumber heap_parallelscan_nextpage(HeapScanDesc scan);
+static void heap_scan_stream_begin(HeapScanDesc scan, BlockNumber startpage);
+static BlockNumber heap_scan_stream_next_block(ReadStream *stream,
+							void *callback_private_data);
 static HeapTuple heap_prepare_insert(Relation relation, HeapTuple tup,
 					TransactionId xid, CommandId cid, int options);
 static XLogRecPtr log_heap_update(Relation reln, Buffer oldbuf,
@@ -238,6 +242,16 @@ initscan(HeapScanDesc scan, ScanKey key, bool keep_startblock)
 	else
 		scan->rs_nblocks = RelationGetNumberOfBlocks(scan->rs_rd);
 
+	/*
+	 * Any read stream from a previous scan refers to the old access strategy
+	 * and scan limits; a new one is set up when the scan starts moving.
+	 */
+	if (scan->rs_stream != NULL)
+	{
+		read_stream_end(scan->rs_stream);
+		scan->rs_stream = NULL;
+	}
+
 	/*
 	 * If the table is large relative to NBuffers, use a bulk-read access
 	 * strategy and enable synchronized scanning (see syncscan.c).  Although
@@ -340,6 +354,71 @@ heap_setscanlimits(HeapScanDesc scan, BlockNumber startBlk, BlockNumber numBlks)
 	scan->rs_numblocks = numBlks;
 }
 
+/*
+ * heap_scan_stream_begin - set up look-ahead reading for a forward scan
+ *
+ * Called when a forward, non-parallel scan is about to read startpage.  We
+ * only bother for relations large enough to be using a bulk-read strategy;
+ * smaller tables are likely to be cached anyway, and the extra buffer
+ * mapping lookups done by prefetching would then be pure overhead.
+ */
+static void
+heap_scan_stream_begin(HeapScanDesc scan, BlockNumber startpage)
+{
+	if (scan->rs_strategy == NULL ||
+		scan->rs_bitmapscan || scan->rs_samplescan ||
+		scan->rs_parallel != NULL)
+		return;
+
+	scan->rs_stream_next = startpage;
+	scan->rs_stream_remaining = scan->rs_numblocks;
+
+	if (scan->rs_stream != NULL)
+		read_stream_reset(scan->rs_stream);
+	else
+	{
+		MemoryContext oldcxt;
+
+		/* the stream must live as long as the scan descriptor itself */
+		oldcxt = MemoryContextSwitchTo(GetMemoryChunkContext(scan));
+		scan->rs_stream = read_stream_begin_relation(scan->rs_rd,
+													 MAIN_FORKNUM,
+													 scan->rs_strategy,
+													 heap_scan_stream_next_block,
+													 scan);
+		MemoryContextSwitchTo(oldcxt);
+	}
+}
+
+/*
+ * heap_scan_stream_next_block - read stream callback for heap scans
+ *
+ * Produces the same sequence of pages as a forward scan does, including
+ * the wraparound of synchronized scans and any limits set with
+ * heap_setscanlimits.
+ */
+static BlockNumber
+heap_scan_stream_next_block(ReadStream *stream, void *callback_private_data)
+{
+	HeapScanDesc scan = (HeapScanDesc) callback_private_data;
+	BlockNumber page = scan->rs_stream_next;
+	BlockNumber next;
+
+	if (page == InvalidBlockNumber)
+		return InvalidBlockNumber;
+
+	next = page + 1;
+	if (next >= scan->rs_nblocks)
+		next = 0;
+	if (next == scan->rs_startblock ||
+		(scan->rs_stream_remaining != InvalidBlockNumber ?
+		 --scan->rs_stream_remaining == 0 : false))
+		next = InvalidBlockNumber;
+	scan->rs_stream_next = next;
+
+	return page;
+}
+
 /*
  * heapgetpage - subroutine for heapgettup()
  *
@@ -375,9 +454,16 @@ heapgetpage(HeapScanDesc scan, BlockNumber page)
 	 */
 	CHECK_FOR_INTERRUPTS();
 
-	/* read page using selected strategy */
-	scan->rs_cbuf = ReadBufferExtended(scan->rs_rd, MAIN_FORKNUM, page,
-									   RBM_NORMAL, scan->rs_strategy);
+	/*
+	 * read page using selected strategy, through the read stream if we have
+	 * one; it copes with pages it didn't expect, as after a change of
+	 * direction
+	 */
+	if (scan->rs_stream != NULL)
+		scan->rs_cbuf = read_stream_get_buffer(scan->rs_stream, page);
+	else
+		scan->rs_cbuf = ReadBufferExtended(scan->rs_rd, MAIN_FORKNUM, page,
+										   RBM_NORMAL, scan->rs_strategy);
 	scan->rs_cblock = page;
 
 	if (!scan->rs_pageatatime)
@@ -529,7 +615,10 @@ heapgettup(HeapScanDesc scan,
 				}
 			}
 			else
+			{
 				page = scan->rs_startblock; /* first page */
+				heap_scan_stream_begin(scan, page);
+			}
 			heapgetpage(scan, page);
 			lineoff = FirstOffsetNumber;	/* first offnum */
 			scan->rs_inited = true;
@@ -833,7 +922,10 @@ heapgettup_pagemode(HeapScanDesc scan,
 				}
 			}
 			else
+			{
 				page = scan->rs_startblock; /* first page */
+				heap_scan_stream_begin(scan, page);
+			}
 			heapgetpage(scan, page);
 			lineindex = 0;
 			scan->rs_inited = true;
@@ -1491,6 +1583,7 @@ heap_beginscan_internal(Relation relation, Snapshot snapshot,
 	scan->rs_bitmapscan = is_bitmapscan;
 	scan->rs_samplescan = is_samplescan;
 	scan->rs_strategy = NULL;	/* set in initscan */
+	scan->rs_stream = NULL;		/* set when the scan starts moving */
 	scan->rs_allow_strat = allow_strat;
 	scan->rs_allow_sync = allow_sync;
 	scan->rs_temp_snap = temp_snap;
@@ -1599,6 +1692,9 @@ heap_endscan(HeapScanDesc scan)
 	if (scan->rs_key)
 		pfree(scan->rs_key);
 
+	if (scan->rs_stream != NULL)
+		read_stream_end(scan->rs_stream);
+
 	if (scan->rs_strategy != NULL)
 		FreeAccessStrategy(scan->rs_strategy);
 
@@ -2752,6 +2848,7 @@ heap_multi_insert(Relation relation, HeapTuple *tuples, int ntuples,
 		Buffer		buffer;
 		Buffer		vmbuffer = InvalidBuffer;
 		bool		all_visible_cleared = false;
+		bool		all_frozen_set = false;
 		int			nthispage;
 
 		CHECK_FOR_INTERRUPTS();
@@ -2765,6 +2862,19 @@ heap_multi_insert(Relation relation, HeapTuple *tuples, int ntuples,
 										   &vmbuffer, NULL);
 		page = BufferGetPage(buffer);
 
+		/*
+		 * If we're inserting frozen tuples into an empty page, the page will
+		 * contain only tuples that are visible to everyone, so we can mark
+		 * it all-visible and all-frozen right away and spare VACUUM from
+		 * visiting it again.  RelationGetBufferForTuple has pinned the
+		 * visibility map page for a newly extended page in this case.
+		 */
+		if ((options & HEAP_INSERT_FROZEN) &&
+			PageGetMaxOffsetNumber(page) == 0 &&
+			BufferIsValid(vmbuffer) &&
+			visibilitymap_pin_ok(BufferGetBlockNumber(buffer), vmbuffer))
+			all_frozen_set = true;
+
 		/* NO EREPORT(ERROR) from here till changes are logged */
 		START_CRIT_SECTION();
 
@@ -2790,7 +2900,11 @@ heap_multi_insert(Relation relation, HeapTuple *tuples, int ntuples,
 				log_heap_new_cid(relation, heaptup);
 		}
 
-		if (PageIsAllVisible(page))
+		/*
+		 * A page that we marked all-visible while loading frozen tuples
+		 * stays that way when more frozen tuples are added to it.
+		 */
+		if (PageIsAllVisible(page) && !(options & HEAP_INSERT_FROZEN))
 		{
 			all_visible_cleared = true;
 			PageClearAllVisible(page);
@@ -2798,6 +2912,8 @@ heap_multi_insert(Relation relation, HeapTuple *tuples, int ntuples,
 								BufferGetBlockNumber(buffer),
 								vmbuffer, VISIBILITYMAP_VALID_BITS);
 		}
+		else if (all_frozen_set)
+			PageSetAllVisible(page);
 
 		/*
 		 * XXX Should we set PageSetPrunable on this page ? See heap_insert()
@@ -2840,7 +2956,11 @@ heap_multi_insert(Relation relation, HeapTuple *tuples, int ntuples,
 			/* the rest of the scratch space is used for tuple data */
 			tupledata = scratchptr;
 
-			xlrec->flags = all_visible_cleared ? XLH_INSERT_ALL_VISIBLE_CLEARED : 0;
+			xlrec->flags = 0;
+			if (all_visible_cleared)
+				xlrec->flags |= XLH_INSERT_ALL_VISIBLE_CLEARED;
+			if (all_frozen_set)
+				xlrec->flags |= XLH_INSERT_ALL_FROZEN_SET;
 			xlrec->ntuples = nthispage;
 
 			/*
@@ -2914,6 +3034,20 @@ heap_multi_insert(Relation relation, HeapTuple *tuples, int ntuples,
 
 		END_CRIT_SECTION();
 
+		/*
+		 * If we've frozen everything on the page, update the visibility map.
+		 * We're already holding a pin on the map page.  There is no cutoff
+		 * XID to report: frozen tuples conflict with no snapshot.
+		 */
+		if (all_frozen_set)
+		{
+			Assert(PageIsAllVisible(page));
+			visibilitymap_set(relation, BufferGetBlockNumber(buffer), buffer,
+							  InvalidXLogRecPtr, vmbuffer,
+							  InvalidTransactionId,
+							  VISIBILITYMAP_ALL_VISIBLE | VISIBILITYMAP_ALL_FROZEN);
+		}
+
 		UnlockReleaseBuffer(buffer);
 		if (vmbuffer != InvalidBuffer)
 			ReleaseBuffer(vmbuffer);
@@ -8750,6 +8884,10 @@ heap_xlog_multi_insert(XLogReaderState *record)
 		if (xlrec->flags & XLH_INSERT_ALL_VISIBLE_CLEARED)
 			PageClearAllVisible(page);
 
+		/* XLH_INSERT_ALL_FROZEN_SET implies that all tuples are frozen */
+		if (xlrec->flags & XLH_INSERT_ALL_FROZEN_SET)
+			PageSetAllVisible(page);
+
 		MarkBufferDirty(buffer);
 	}
 	if (BufferIsValid(buffer))
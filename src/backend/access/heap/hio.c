@@ -178,7 +178,7 @@ static void
 RelationAddExtraBlocks(Relation relation, BulkInsertState bistate)
 {
 	BlockNumber blockNum,
-				firstBlock = InvalidBlockNumber;
+				firstBlock;
 	int			extraBlocks;
 	int			lockWaiters;
 
@@ -195,27 +195,34 @@ RelationAddExtraBlocks(Relation relation, BulkInsertState bistate)
 	 */
 	extraBlocks = Min(512, lockWaiters * 20);
 
-	do
+	/*
+	 * Extend the file by all of the blocks in one go, rather than writing out
+	 * a page image for each of them while other backends wait for the lock.
+	 * The new blocks read as zeroes, so below we only need to initialize them
+	 * in shared buffers, without any I/O.  We hold the relation extension
+	 * lock, so nobody else can be extending the relation concurrently.
+	 */
+	RelationOpenSmgr(relation);
+	firstBlock = smgrnblocks(relation->rd_smgr, MAIN_FORKNUM);
+	smgrzeroextend(relation->rd_smgr, MAIN_FORKNUM, firstBlock, extraBlocks,
+				   false);
+
+	for (blockNum = firstBlock; blockNum < firstBlock + extraBlocks; blockNum++)
 	{
 		Buffer		buffer;
 		Page		page;
 		Size		freespace;
 
 		/*
-		 * Extend by one page.  This should generally match the main-line
+		 * Initialize the page.  This should generally match the main-line
 		 * extension code in RelationGetBufferForTuple, except that we hold
 		 * the relation extension lock throughout.
 		 */
-		buffer = ReadBufferBI(relation, P_NEW, bistate);
-
-		LockBuffer(buffer, BUFFER_LOCK_EXCLUSIVE);
+		buffer = ReadBufferExtended(relation, MAIN_FORKNUM, blockNum,
+									RBM_ZERO_AND_LOCK,
+									bistate ? bistate->strategy : NULL);
 		page = BufferGetPage(buffer);
 
-		if (!PageIsNew(page))
-			elog(ERROR, "page %u of relation \"%s\" should be empty but is not",
-				 BufferGetBlockNumber(buffer),
-				 RelationGetRelationName(relation));
-
 		PageInit(page, BufferGetPageSize(buffer), 0);
 
 		/*
@@ -226,15 +233,10 @@ RelationAddExtraBlocks(Relation relation, BulkInsertState bistate)
 		MarkBufferDirty(buffer);
 
 		/* we'll need this info below */
-		blockNum = BufferGetBlockNumber(buffer);
 		freespace = PageGetHeapFreeSpace(page);
 
 		UnlockReleaseBuffer(buffer);
 
-		/* Remember first block number thus added. */
-		if (firstBlock == InvalidBlockNumber)
-			firstBlock = blockNum;
-
 		/*
 		 * Immediately update the bottom level of the FSM.  This has a good
 		 * chance of making this page visible to other concurrently inserting
@@ -242,7 +244,6 @@ RelationAddExtraBlocks(Relation relation, BulkInsertState bistate)
 		 */
 		RecordPageWithFreeSpace(relation, blockNum, freespace);
 	}
-	while (--extraBlocks > 0);
 
 	/*
 	 * Updating the upper levels of the free space map is too expensive to do
@@ -250,7 +251,7 @@ RelationAddExtraBlocks(Relation relation, BulkInsertState bistate)
 	 * subsequent insertion activity sees all of those nifty free pages we
 	 * just inserted.
 	 */
-	FreeSpaceMapVacuumRange(relation, firstBlock, blockNum + 1);
+	FreeSpaceMapVacuumRange(relation, firstBlock, blockNum);
 }
 
 /*
@@ -543,9 +544,12 @@ loop:
 
 			/*
 			 * Check if some other backend has extended a block for us while
-			 * we were waiting on the lock.
+			 * we were waiting on the lock.  The other waiters are likely
+			 * doing the same right now, so ask the FSM to steer us away from
+			 * the page they're being handed.
 			 */
-			targetBlock = GetPageWithFreeSpace(relation, len + saveFreeSpace);
+			targetBlock = GetPageWithFreeSpaceAffinity(relation,
+													   len + saveFreeSpace);
 
 			/*
 			 * If some other waiter has already extended the relation, we
@@ -608,6 +612,13 @@ loop:
 
 	PageInit(page, BufferGetPageSize(buffer), 0);
 
+	/*
+	 * The page is empty; if the caller is loading frozen tuples, pin the
+	 * visibility map page so that it can mark the page all-frozen.
+	 */
+	if ((options & HEAP_INSERT_FROZEN) && vmbuffer != NULL)
+		visibilitymap_pin(relation, BufferGetBlockNumber(buffer), vmbuffer);
+
 	if (len > PageGetHeapFreeSpace(page))
 	{
 		/* We should not get here given the test at the top */
@@ -22,6 +22,7 @@
 #include "catalog/catalog.h"
 #include "miscadmin.h"
 #include "pgstat.h"
+#include "postmaster/autovacuum.h"
 #include "storage/bufmgr.h"
 #include "utils/snapmgr.h"
 #include "utils/rel.h"
@@ -54,13 +55,24 @@ static void heap_prune_record_redirect(PruneState *prstate,
 static void heap_prune_record_dead(PruneState *prstate, OffsetNumber offnum);
 static void heap_prune_record_unused(PruneState *prstate, OffsetNumber offnum);
 
+/*
+ * The page we last asked autovacuum to prune.  A contended page tends to be
+ * visited again and again, and there's no need to take AutovacuumLock each
+ * time just to find the request already queued.
+ */
+static Oid	lastPruneRequestRelid = InvalidOid;
+static BlockNumber lastPruneRequestBlock = InvalidBlockNumber;
+
 
 /*
  * Optionally prune and repair fragmentation in the specified page.
  *
  * This is an opportunistic function.  It will perform housekeeping
  * only if the page heuristically looks like a candidate for pruning and we
- * can acquire buffer cleanup lock without blocking.
+ * can acquire buffer cleanup lock without blocking.  If the lock is not
+ * available, the page is handed to autovacuum to be pruned later, since a
+ * page that is pinned all the time would otherwise never get pruned, and
+ * every further UPDATE of it would have to go elsewhere as a non-HOT update.
  *
  * Note: this is called quite often.  It's important that it fall out quickly
  * if there's not any use in pruning.
@@ -138,7 +150,25 @@ heap_page_prune_opt(Relation relation, Buffer buffer)
 	{
 		/* OK, try to get exclusive buffer lock */
 		if (!ConditionalLockBufferForCleanup(buffer))
+		{
+			/*
+			 * Ask autovacuum to try again later.  Autovacuum can't process
+			 * temporary relations, and it doesn't queue work for itself.
+			 */
+			if (!RelationUsesLocalBuffers(relation) &&
+				!IsAutoVacuumWorkerProcess() &&
+				AutoVacuumingActive() &&
+				(RelationGetRelid(relation) != lastPruneRequestRelid ||
+				 BufferGetBlockNumber(buffer) != lastPruneRequestBlock))
+			{
+				lastPruneRequestRelid = RelationGetRelid(relation);
+				lastPruneRequestBlock = BufferGetBlockNumber(buffer);
+				(void) AutoVacuumRequestWork(AVW_HeapPrunePage,
+											 lastPruneRequestRelid,
+											 lastPruneRequestBlock);
+			}
 			return;
+		}
 
 		/*
 		 * Now that we have buffer lock, get accurate information about the
@@ -161,6 +191,43 @@ heap_page_prune_opt(Relation relation, Buffer buffer)
 }
 
 
+/*
+ * Prune a heap page on behalf of a backend that couldn't.
+ *
+ * This is the autovacuum work item queued by heap_page_prune_opt.  The
+ * relation may have been dropped or truncated since, in which case there is
+ * nothing to do.  We still take the buffer cleanup lock only if it is free,
+ * so that a page that stays pinned can't hold up the worker.
+ */
+void
+heap_page_prune_workitem(Oid relid, BlockNumber blkno)
+{
+	Relation	relation;
+	Buffer		buffer;
+
+	relation = try_relation_open(relid, AccessShareLock);
+	if (relation == NULL)
+		return;
+
+	if ((relation->rd_rel->relkind == RELKIND_RELATION ||
+		 relation->rd_rel->relkind == RELKIND_MATVIEW ||
+		 relation->rd_rel->relkind == RELKIND_TOASTVALUE) &&
+		blkno < RelationGetNumberOfBlocks(relation))
+	{
+		/* heap_page_prune_opt needs an up-to-date RecentGlobalXmin */
+		PushActiveSnapshot(GetTransactionSnapshot());
+
+		buffer = ReadBuffer(relation, blkno);
+		heap_page_prune_opt(relation, buffer);
+		ReleaseBuffer(buffer);
+
+		PopActiveSnapshot();
+	}
+
+	relation_close(relation, AccessShareLock);
+}
+
+
 /*
  * Prune and repair fragmentation in the specified page.
  *
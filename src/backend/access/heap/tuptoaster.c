@@ -29,6 +29,12 @@
 
 #include <unistd.h>
 #include <fcntl.h>
+#ifdef USE_LZ4
+#include <lz4.h>
+#endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
 
 #include "access/genam.h"
 #include "access/heapam.h"
@@ -37,6 +43,7 @@
 #include "catalog/catalog.h"
 #include "common/pg_lzcompress.h"
 #include "miscadmin.h"
+#include "utils/attoptcache.h"
 #include "utils/expandeddatum.h"
 #include "utils/fmgroids.h"
 #include "utils/rel.h"
@@ -47,13 +54,16 @@
 
 #undef TOAST_DEBUG
 
+/* GUC variable */
+int			default_toast_compression = TOAST_PGLZ_COMPRESSION_ID;
+
 /*
  *	The information at the start of the compressed toast data.
  */
 typedef struct toast_compress_header
 {
 	int32		vl_len_;		/* varlena header (do not touch directly!) */
-	int32		rawsize;
+	uint32		tcinfo;			/* raw size and compression method */
 } toast_compress_header;
 
 /*
@@ -61,11 +71,22 @@ typedef struct toast_compress_header
  * toast entries.
  */
 #define TOAST_COMPRESS_HDRSZ		((int32) sizeof(toast_compress_header))
-#define TOAST_COMPRESS_RAWSIZE(ptr) (((toast_compress_header *) (ptr))->rawsize)
+#define TOAST_COMPRESS_RAWSIZE(ptr) \
+	((int32) (((toast_compress_header *) (ptr))->tcinfo & VARLENA_RAWSIZE_MASK))
+#define TOAST_COMPRESS_METHOD(ptr) \
+	((int) (((toast_compress_header *) (ptr))->tcinfo >> VARLENA_RAWSIZE_BITS))
 #define TOAST_COMPRESS_RAWDATA(ptr) \
 	(((char *) (ptr)) + TOAST_COMPRESS_HDRSZ)
-#define TOAST_COMPRESS_SET_RAWSIZE(ptr, len) \
-	(((toast_compress_header *) (ptr))->rawsize = (len))
+#define TOAST_COMPRESS_SET_RAWSIZE_AND_METHOD(ptr, len, cmid) \
+	(((toast_compress_header *) (ptr))->tcinfo = \
+	 ((uint32) (len) | ((uint32) (cmid) << VARLENA_RAWSIZE_BITS)))
+
+#define NO_COMPRESSION_SUPPORT(method) \
+	ereport(ERROR, \
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED), \
+			 errmsg("compression method %s not supported", method), \
+			 errdetail("This functionality requires the server to be built with %s support.", \
+					   method)))
 
 static void toast_delete_datum(Relation rel, Datum value, bool is_speculative);
 static Datum toast_save_datum(Relation rel, Datum value,
@@ -421,7 +442,7 @@ toast_datum_size(Datum value)
 		struct varatt_external toast_pointer;
 
 		VARATT_EXTERNAL_GET_POINTER(toast_pointer, attr);
-		result = toast_pointer.va_extsize;
+		result = VARATT_EXTERNAL_GET_EXTSIZE(toast_pointer);
 	}
 	else if (VARATT_IS_EXTERNAL_INDIRECT(attr))
 	{
@@ -771,7 +792,8 @@ toast_insert_or_update(Relation rel, HeapTuple newtup, HeapTuple oldtup,
 		if (TupleDescAttr(tupleDesc, i)->attstorage == 'x')
 		{
 			old_value = toast_values[i];
-			new_value = toast_compress_datum(old_value);
+			new_value = toast_compress_datum(old_value,
+											 toast_get_compression_method(rel, i + 1));
 
 			if (DatumGetPointer(new_value) != NULL)
 			{
@@ -912,7 +934,8 @@ toast_insert_or_update(Relation rel, HeapTuple newtup, HeapTuple oldtup,
 		 */
 		i = biggest_attno;
 		old_value = toast_values[i];
-		new_value = toast_compress_datum(old_value);
+		new_value = toast_compress_datum(old_value,
+										 toast_get_compression_method(rel, i + 1));
 
 		if (DatumGetPointer(new_value) != NULL)
 		{
@@ -1352,14 +1375,16 @@ toast_build_flattened_tuple(TupleDesc tupleDesc,
  *
  *	We use VAR{SIZE,DATA}_ANY so we can handle short varlenas here without
  *	copying them.  But we can't handle external or compressed datums.
+ *
+ *	cmethod is one of the ToastCompressionId values.
  * ----------
  */
 Datum
-toast_compress_datum(Datum value)
+toast_compress_datum(Datum value, int cmethod)
 {
 	struct varlena *tmp;
 	int32		valsize = VARSIZE_ANY_EXHDR(DatumGetPointer(value));
-	int32		len;
+	int32		len = -1;
 
 	Assert(!VARATT_IS_EXTERNAL(DatumGetPointer(value)));
 	Assert(!VARATT_IS_COMPRESSED(DatumGetPointer(value)));
@@ -1376,7 +1401,7 @@ toast_compress_datum(Datum value)
 									TOAST_COMPRESS_HDRSZ);
 
 	/*
-	 * We recheck the actual size even if pglz_compress() reports success,
+	 * We recheck the actual size even if the compressor reports success,
 	 * because it might be satisfied with having saved as little as one byte
 	 * in the compressed data --- which could turn into a net loss once you
 	 * consider header and alignment padding.  Worst case, the compressed
@@ -1384,15 +1409,54 @@ toast_compress_datum(Datum value)
 	 * included in VARSIZE(tmp)), whereas the uncompressed format would take
 	 * only one header byte and no padding if the value is short enough.  So
 	 * we insist on a savings of more than 2 bytes to ensure we have a gain.
+	 *
+	 * LZ4 and zstd are simply given no more output space than that, so that
+	 * they can give up early on incompressible data.
 	 */
-	len = pglz_compress(VARDATA_ANY(DatumGetPointer(value)),
-						valsize,
-						TOAST_COMPRESS_RAWDATA(tmp),
-						PGLZ_strategy_default);
+	switch (cmethod)
+	{
+		case TOAST_PGLZ_COMPRESSION_ID:
+			len = pglz_compress(VARDATA_ANY(DatumGetPointer(value)),
+								valsize,
+								TOAST_COMPRESS_RAWDATA(tmp),
+								PGLZ_strategy_default);
+			break;
+		case TOAST_LZ4_COMPRESSION_ID:
+#ifdef USE_LZ4
+			len = LZ4_compress_default(VARDATA_ANY(DatumGetPointer(value)),
+									   TOAST_COMPRESS_RAWDATA(tmp),
+									   valsize,
+									   valsize - TOAST_COMPRESS_HDRSZ - 3);
+			if (len <= 0)
+				len = -1;
+#else
+			NO_COMPRESSION_SUPPORT("lz4");
+#endif
+			break;
+		case TOAST_ZSTD_COMPRESSION_ID:
+#ifdef USE_ZSTD
+			{
+				size_t		zlen;
+
+				zlen = ZSTD_compress(TOAST_COMPRESS_RAWDATA(tmp),
+									 valsize - TOAST_COMPRESS_HDRSZ - 3,
+									 VARDATA_ANY(DatumGetPointer(value)),
+									 valsize,
+									 ZSTD_CLEVEL_DEFAULT);
+				len = ZSTD_isError(zlen) ? -1 : (int32) zlen;
+			}
+#else
+			NO_COMPRESSION_SUPPORT("zstd");
+#endif
+			break;
+		default:
+			elog(ERROR, "invalid compression method %d", cmethod);
+	}
+
 	if (len >= 0 &&
 		len + TOAST_COMPRESS_HDRSZ < valsize - 2)
 	{
-		TOAST_COMPRESS_SET_RAWSIZE(tmp, valsize);
+		TOAST_COMPRESS_SET_RAWSIZE_AND_METHOD(tmp, valsize, cmethod);
 		SET_VARSIZE_COMPRESSED(tmp, len + TOAST_COMPRESS_HDRSZ);
 		/* successful compression */
 		return PointerGetDatum(tmp);
@@ -1517,7 +1581,8 @@ toast_save_datum(Relation rel, Datum value,
 		data_todo = VARSIZE(dval) - VARHDRSZ;
 		/* rawsize in a compressed datum is just the size of the payload */
 		toast_pointer.va_rawsize = VARRAWSIZE_4B_C(dval) + VARHDRSZ;
-		toast_pointer.va_extsize = data_todo;
+		VARATT_EXTERNAL_SET_SIZE_AND_COMPRESSION(toast_pointer, data_todo,
+												 VARCOMPRESS_4B_C(dval));
 		/* Assert that the numbers look like it's compressed */
 		Assert(VARATT_EXTERNAL_IS_COMPRESSED(toast_pointer));
 	}
@@ -1886,7 +1951,7 @@ toast_fetch_datum(struct varlena *attr)
 	/* Must copy to access aligned fields */
 	VARATT_EXTERNAL_GET_POINTER(toast_pointer, attr);
 
-	ressize = toast_pointer.va_extsize;
+	ressize = VARATT_EXTERNAL_GET_EXTSIZE(toast_pointer);
 	numchunks = ((ressize - 1) / TOAST_MAX_CHUNK_SIZE) + 1;
 
 	result = (struct varlena *) palloc(ressize + VARHDRSZ);
@@ -2073,7 +2138,7 @@ toast_fetch_datum_slice(struct varlena *attr, int32 sliceoffset, int32 length)
 	 */
 	Assert(!VARATT_EXTERNAL_IS_COMPRESSED(toast_pointer));
 
-	attrsize = toast_pointer.va_extsize;
+	attrsize = VARATT_EXTERNAL_GET_EXTSIZE(toast_pointer);
 	totalchunks = ((attrsize - 1) / TOAST_MAX_CHUNK_SIZE) + 1;
 
 	if (sliceoffset >= attrsize)
@@ -2263,23 +2328,193 @@ static struct varlena *
 toast_decompress_datum(struct varlena *attr)
 {
 	struct varlena *result;
+	int32		rawsize = TOAST_COMPRESS_RAWSIZE(attr);
+	int32		compsize = VARSIZE(attr) - TOAST_COMPRESS_HDRSZ;
+	bool		corrupted = false;
 
 	Assert(VARATT_IS_COMPRESSED(attr));
 
-	result = (struct varlena *)
-		palloc(TOAST_COMPRESS_RAWSIZE(attr) + VARHDRSZ);
-	SET_VARSIZE(result, TOAST_COMPRESS_RAWSIZE(attr) + VARHDRSZ);
+	result = (struct varlena *) palloc(rawsize + VARHDRSZ);
+	SET_VARSIZE(result, rawsize + VARHDRSZ);
+
+	switch (TOAST_COMPRESS_METHOD(attr))
+	{
+		case TOAST_PGLZ_COMPRESSION_ID:
+			if (pglz_decompress(TOAST_COMPRESS_RAWDATA(attr), compsize,
+								VARDATA(result), rawsize) < 0)
+				corrupted = true;
+			break;
+		case TOAST_LZ4_COMPRESSION_ID:
+#ifdef USE_LZ4
+			if (LZ4_decompress_safe(TOAST_COMPRESS_RAWDATA(attr),
+									VARDATA(result),
+									compsize, rawsize) != rawsize)
+				corrupted = true;
+#else
+			NO_COMPRESSION_SUPPORT("lz4");
+#endif
+			break;
+		case TOAST_ZSTD_COMPRESSION_ID:
+#ifdef USE_ZSTD
+			{
+				size_t		zlen;
+
+				zlen = ZSTD_decompress(VARDATA(result), rawsize,
+									   TOAST_COMPRESS_RAWDATA(attr), compsize);
+				if (ZSTD_isError(zlen) || zlen != (size_t) rawsize)
+					corrupted = true;
+			}
+#else
+			NO_COMPRESSION_SUPPORT("zstd");
+#endif
+			break;
+		default:
+			corrupted = true;
+			break;
+	}
 
-	if (pglz_decompress(TOAST_COMPRESS_RAWDATA(attr),
-						VARSIZE(attr) - TOAST_COMPRESS_HDRSZ,
-						VARDATA(result),
-						TOAST_COMPRESS_RAWSIZE(attr)) < 0)
+	if (corrupted)
 		elog(ERROR, "compressed data is corrupted");
 
 	return result;
 }
 
 
+/* ----------
+ * toast_get_compression_method -
+ *
+ *	Return the compression method to use for attribute "attnum" of "rel":
+ *	the column's "compression" option if it has one, otherwise
+ *	default_toast_compression.
+ * ----------
+ */
+int
+toast_get_compression_method(Relation rel, int attnum)
+{
+	AttributeOpts *aopts;
+	int			cmethod = default_toast_compression;
+
+	/* no catalog access during bootstrap */
+	if (IsBootstrapProcessingMode())
+		return cmethod;
+
+	aopts = get_attribute_options(RelationGetRelid(rel), attnum);
+	if (aopts != NULL)
+	{
+		if (aopts->compressionOffset != 0)
+			cmethod = toast_compression_method_from_name((char *) aopts +
+														 aopts->compressionOffset);
+		pfree(aopts);
+	}
+
+	return cmethod;
+}
+
+
+/* ----------
+ * toast_get_compression_id -
+ *
+ *	Return the compression method a varlena datum was compressed with,
+ *	without detoasting it, or TOAST_INVALID_COMPRESSION_ID if the datum is
+ *	not compressed.
+ * ----------
+ */
+int
+toast_get_compression_id(struct varlena *attr)
+{
+	if (VARATT_IS_EXTERNAL_ONDISK(attr))
+	{
+		struct varatt_external toast_pointer;
+
+		VARATT_EXTERNAL_GET_POINTER(toast_pointer, attr);
+		if (VARATT_EXTERNAL_IS_COMPRESSED(toast_pointer))
+			return VARATT_EXTERNAL_GET_COMPRESSION(toast_pointer);
+	}
+	else if (VARATT_IS_EXTERNAL_INDIRECT(attr))
+	{
+		struct varatt_indirect redirect;
+
+		VARATT_EXTERNAL_GET_POINTER(redirect, attr);
+
+		/* nested indirect Datums aren't allowed */
+		Assert(!VARATT_IS_EXTERNAL_INDIRECT(redirect.pointer));
+
+		return toast_get_compression_id(redirect.pointer);
+	}
+	else if (VARATT_IS_COMPRESSED(attr))
+		return VARCOMPRESS_4B_C(attr);
+
+	return TOAST_INVALID_COMPRESSION_ID;
+}
+
+
+/* ----------
+ * toast_compression_method_from_name -
+ * toast_compression_method_name -
+ *
+ *	Map between compression method names and ToastCompressionId values.
+ *	Methods the server wasn't built with are still recognized here; trying
+ *	to use them raises an error.
+ * ----------
+ */
+int
+toast_compression_method_from_name(const char *name)
+{
+	if (strcmp(name, "pglz") == 0)
+		return TOAST_PGLZ_COMPRESSION_ID;
+	if (strcmp(name, "lz4") == 0)
+		return TOAST_LZ4_COMPRESSION_ID;
+	if (strcmp(name, "zstd") == 0)
+		return TOAST_ZSTD_COMPRESSION_ID;
+	return TOAST_INVALID_COMPRESSION_ID;
+}
+
+const char *
+toast_compression_method_name(int cmethod)
+{
+	switch (cmethod)
+	{
+		case TOAST_PGLZ_COMPRESSION_ID:
+			return "pglz";
+		case TOAST_LZ4_COMPRESSION_ID:
+			return "lz4";
+		case TOAST_ZSTD_COMPRESSION_ID:
+			return "zstd";
+	}
+	return "unknown";
+}
+
+
+/* ----------
+ * toast_validate_compression_option -
+ *
+ *	Validator for the "compression" attribute option.
+ * ----------
+ */
+void
+toast_validate_compression_option(const char *value)
+{
+	int			cmethod;
+
+	cmethod = (value != NULL) ? toast_compression_method_from_name(value) :
+		TOAST_INVALID_COMPRESSION_ID;
+
+	if (cmethod == TOAST_INVALID_COMPRESSION_ID)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid value for \"compression\" option"),
+				 errdetail("Valid values are \"pglz\", \"lz4\", and \"zstd\".")));
+#ifndef USE_LZ4
+	if (cmethod == TOAST_LZ4_COMPRESSION_ID)
+		NO_COMPRESSION_SUPPORT("lz4");
+#endif
+#ifndef USE_ZSTD
+	if (cmethod == TOAST_ZSTD_COMPRESSION_ID)
+		NO_COMPRESSION_SUPPORT("zstd");
+#endif
+}
+
+
 /* ----------
  * toast_open_indexes
  *
@@ -397,6 +397,89 @@ visibilitymap_get_status(Relation rel, BlockNumber heapBlk, Buffer *buf)
 	return result;
 }
 
+/*
+ *	visibilitymap_find_unset - find the next heap block lacking some VM bits
+ *
+ * Returns the first heap block in [heapBlk, endBlk) whose visibility map
+ * status does not include all of the given flags, or endBlk if every block
+ * in the range has them.  Blocks beyond the end of the map have no bits set.
+ *
+ * This is equivalent to calling visibilitymap_get_status on each block in
+ * turn, but the map is examined a 64-bit word (32 heap blocks) at a time,
+ * which makes stepping over long runs of all-visible or all-frozen pages
+ * cheap.  As with visibilitymap_get_status, *buf is used to keep a map page
+ * pinned across calls, and the result can be stale by the time the caller
+ * looks at the heap pages.
+ */
+BlockNumber
+visibilitymap_find_unset(Relation rel, BlockNumber heapBlk, BlockNumber endBlk,
+						 uint8 flags, Buffer *buf)
+{
+	/* the flags repeated for each of the 32 heap blocks in a word */
+	uint64		mask = UINT64CONST(0x5555555555555555) * flags;
+
+	Assert(flags != 0 && (flags & ~VISIBILITYMAP_VALID_BITS) == 0);
+
+	while (heapBlk < endBlk)
+	{
+		BlockNumber mapBlock = HEAPBLK_TO_MAPBLOCK(heapBlk);
+		BlockNumber pageEnd;
+		uint8	   *map;
+
+		/* Reuse the old pinned buffer if possible */
+		if (BufferIsValid(*buf))
+		{
+			if (BufferGetBlockNumber(*buf) != mapBlock)
+			{
+				ReleaseBuffer(*buf);
+				*buf = InvalidBuffer;
+			}
+		}
+
+		if (!BufferIsValid(*buf))
+		{
+			*buf = vm_readbuf(rel, mapBlock, false);
+			if (!BufferIsValid(*buf))
+				return heapBlk;
+		}
+
+		map = (uint8 *) PageGetContents(BufferGetPage(*buf));
+
+		/* Don't look past the heap blocks covered by this map page */
+		pageEnd = Min(endBlk, (mapBlock + 1) * HEAPBLOCKS_PER_PAGE);
+
+		while (heapBlk < pageEnd)
+		{
+			uint32		mapByte = HEAPBLK_TO_MAPBYTE(heapBlk);
+
+			/*
+			 * At a word boundary, skip the whole word if every heap block in
+			 * it has the flags.  PageGetContents() is MAXALIGN'd, so the
+			 * word is suitably aligned.  Like visibilitymap_get_status, we
+			 * don't lock the map page.
+			 */
+			if (HEAPBLK_TO_OFFSET(heapBlk) == 0 &&
+				mapByte % sizeof(uint64) == 0 &&
+				pageEnd - heapBlk >= HEAPBLOCKS_PER_BYTE * sizeof(uint64))
+			{
+				uint64		word = *(uint64 *) (map + mapByte);
+
+				if ((word & mask) == mask)
+				{
+					heapBlk += HEAPBLOCKS_PER_BYTE * sizeof(uint64);
+					continue;
+				}
+			}
+
+			if (((map[mapByte] >> HEAPBLK_TO_OFFSET(heapBlk)) & flags) != flags)
+				return heapBlk;
+			heapBlk++;
+		}
+	}
+
+	return endBlk;
+}
+
 /*
  *	visibilitymap_count  - count number of bits set in visibility map
  *
@@ -24,6 +24,9 @@
  *		index_parallelscan_initialize - initialize parallel scan
  *		index_parallelrescan  - (re)start a parallel scan of an index
  *		index_beginscan_parallel - join parallel index scan
+ *		index_beginscan_bitmap_parallel - join parallel index scan with
+ *			amgetbitmap
+ *		index_set_prefetch	- read ahead in the index, prefetching heap pages
  *		index_getnext_tid	- get the next TID from a scan
  *		index_fetch_heap		- get the scan's next heap tuple
  *		index_getnext	- get the next heap tuple from a scan
@@ -72,6 +75,7 @@
 #include "access/amapi.h"
 #include "access/relscan.h"
 #include "access/transam.h"
+#include "access/visibilitymap.h"
 #include "access/xlog.h"
 #include "catalog/index.h"
 #include "catalog/pg_type.h"
@@ -79,10 +83,48 @@
 #include "storage/bufmgr.h"
 #include "storage/lmgr.h"
 #include "storage/predicate.h"
+#include "utils/memutils.h"
 #include "utils/snapmgr.h"
 #include "utils/tqual.h"
 
 
+/*
+ * An index entry read ahead of the one the caller is working on, with what
+ * the AM told us about it.  The index tuples are copies, since the AM's own
+ * are only valid until its next amgettuple call.
+ */
+typedef struct IndexPrefetchEntry
+{
+	ItemPointerData tid;		/* heap TID */
+	bool		recheck;		/* xs_recheck for this entry */
+	IndexTuple	itup;			/* copy of xs_itup, or NULL */
+	HeapTuple	hitup;			/* copy of xs_hitup, or NULL */
+} IndexPrefetchEntry;
+
+/*
+ * State of an index scan that reads ahead in the index, see
+ * index_set_prefetch().  The queue is a ring buffer of maximum + 1 entries:
+ * the one about to be returned and up to 'maximum' more.
+ */
+typedef struct IndexPrefetchData
+{
+	MemoryContext context;		/* holds the copies of index tuples */
+	int			maximum;		/* how far ahead we may read */
+	int			distance;		/* how far ahead we're currently reading */
+	int			head;			/* queue position of the next entry */
+	int			nqueued;		/* number of entries in the queue */
+	bool		exhausted;		/* has the AM returned all its entries? */
+	BlockNumber last_block;		/* heap block most recently prefetched */
+	Buffer		vmbuffer;		/* visibility map buffer, index-only scans */
+	IndexPrefetchEntry returned;	/* the entry most recently returned */
+	IndexPrefetchEntry queue[FLEXIBLE_ARRAY_MEMBER];
+} IndexPrefetchData;
+
+static void index_prefetch_reset(IndexScanDesc scan);
+static ItemPointer index_getnext_tid_prefetch(IndexScanDesc scan,
+						   ScanDirection direction);
+
+
 /* ----------------------------------------------------------------
  *					macros used in index_ routines
  *
@@ -329,6 +371,9 @@ index_rescan(IndexScanDesc scan,
 
 	scan->kill_prior_tuple = false; /* for safety */
 
+	if (scan->xs_prefetch != NULL)
+		index_prefetch_reset(scan);
+
 	scan->indexRelation->rd_amroutine->amrescan(scan, keys, nkeys,
 												orderbys, norderbys);
 }
@@ -350,6 +395,16 @@ index_endscan(IndexScanDesc scan)
 		scan->xs_cbuf = InvalidBuffer;
 	}
 
+	if (scan->xs_prefetch != NULL)
+	{
+		index_prefetch_reset(scan);
+		if (BufferIsValid(scan->xs_prefetch->vmbuffer))
+			ReleaseBuffer(scan->xs_prefetch->vmbuffer);
+		MemoryContextDelete(scan->xs_prefetch->context);
+		pfree(scan->xs_prefetch);
+		scan->xs_prefetch = NULL;
+	}
+
 	/* End the AM's scan */
 	scan->indexRelation->rd_amroutine->amendscan(scan);
 
@@ -373,6 +428,9 @@ index_markpos(IndexScanDesc scan)
 	SCAN_CHECKS;
 	CHECK_SCAN_PROCEDURE(ammarkpos);
 
+	/* The AM's position would be ahead of the caller's */
+	Assert(scan->xs_prefetch == NULL);
+
 	scan->indexRelation->rd_amroutine->ammarkpos(scan);
 }
 
@@ -516,6 +574,204 @@ index_beginscan_parallel(Relation heaprel, Relation indexrel, int nkeys,
 	return scan;
 }
 
+/*
+ * index_beginscan_bitmap_parallel - join parallel index scan with amgetbitmap
+ *
+ * Each participant gets the TIDs of its own share of the index, so the caller
+ * is responsible for combining the participants' bitmaps.  As for
+ * index_beginscan_bitmap, caller had better be holding some lock on the
+ * parent heap relation.
+ */
+IndexScanDesc
+index_beginscan_bitmap_parallel(Relation indexrel, int nkeys,
+								ParallelIndexScanDesc pscan)
+{
+	Snapshot	snapshot;
+	IndexScanDesc scan;
+
+	Assert(RelationGetRelid(indexrel) == pscan->ps_indexid);
+	snapshot = RestoreSnapshot(pscan->ps_snapshot_data);
+	RegisterSnapshot(snapshot);
+	scan = index_beginscan_internal(indexrel, nkeys, 0, snapshot,
+									pscan, true);
+
+	/*
+	 * Save additional parameters into the scandesc.  Everything else was set
+	 * up by index_beginscan_internal.
+	 */
+	scan->xs_snapshot = snapshot;
+
+	return scan;
+}
+
+/* ----------------
+ * index_set_prefetch - read ahead in the index, prefetching heap pages
+ *
+ * After this, index_getnext_tid reads up to 'maximum' entries ahead of the
+ * one it returns, and issues PrefetchBuffer calls for the heap pages they
+ * point to, so that fetching the heap tuples one at a time doesn't wait for
+ * every single read.  The order in which entries are returned is unchanged.
+ * In an index-only scan, only pages that are not all-visible are prefetched,
+ * since the others won't be read at all.  As in bitmap heap scans, the
+ * distance starts small and grows with every entry returned, so that a scan
+ * that is stopped early doesn't do a lot of useless work.
+ *
+ * The caller must only scan in one direction, and can't use index_markpos.
+ * Nor can the AM learn which entries point to dead tuples: when the
+ * caller reports one through kill_prior_tuple, the AM has already moved on.
+ * Hence this is for executor scans that are expected to do real I/O, which
+ * is what effective_io_concurrency says.
+ * ----------------
+ */
+void
+index_set_prefetch(IndexScanDesc scan, int maximum)
+{
+	IndexPrefetchData *prefetch;
+
+	SCAN_CHECKS;
+	Assert(scan->xs_prefetch == NULL);
+	Assert(scan->heapRelation != NULL);
+
+	/* The ORDER BY values of entries read ahead would have to be saved too */
+	if (maximum <= 0 || scan->numberOfOrderBys > 0)
+		return;
+
+	prefetch = (IndexPrefetchData *)
+		palloc0(offsetof(IndexPrefetchData, queue) +
+				(maximum + 1) * sizeof(IndexPrefetchEntry));
+	prefetch->context = AllocSetContextCreate(CurrentMemoryContext,
+											  "index prefetch",
+											  ALLOCSET_SMALL_SIZES);
+	prefetch->maximum = maximum;
+	prefetch->last_block = InvalidBlockNumber;
+	prefetch->vmbuffer = InvalidBuffer;
+
+	scan->xs_prefetch = prefetch;
+}
+
+/*
+ * Forget about all entries read ahead, e.g. because the scan is restarted.
+ */
+static void
+index_prefetch_reset(IndexScanDesc scan)
+{
+	IndexPrefetchData *prefetch = scan->xs_prefetch;
+
+	prefetch->distance = 0;
+	prefetch->head = 0;
+	prefetch->nqueued = 0;
+	prefetch->exhausted = false;
+	prefetch->last_block = InvalidBlockNumber;
+	MemSet(&prefetch->returned, 0, sizeof(IndexPrefetchEntry));
+	MemoryContextReset(prefetch->context);
+
+	/* The index tuples were ours, so don't leave dangling pointers */
+	if (scan->xs_want_itup)
+	{
+		scan->xs_itup = NULL;
+		scan->xs_hitup = NULL;
+	}
+}
+
+/*
+ * index_getnext_tid for scans that read ahead in the index.
+ */
+static ItemPointer
+index_getnext_tid_prefetch(IndexScanDesc scan, ScanDirection direction)
+{
+	IndexPrefetchData *prefetch = scan->xs_prefetch;
+	IndexPrefetchEntry *entry;
+	MemoryContext oldcontext;
+
+	/* We're done with the copies made for the previous entry */
+	if (prefetch->returned.itup != NULL)
+		pfree(prefetch->returned.itup);
+	if (prefetch->returned.hitup != NULL)
+		pfree(prefetch->returned.hitup);
+
+	/* The AM can't kill an entry it has already moved past */
+	scan->kill_prior_tuple = false;
+
+	/* Fill the queue up to the current distance */
+	while (!prefetch->exhausted && prefetch->nqueued <= prefetch->distance)
+	{
+		BlockNumber block;
+
+		if (!scan->indexRelation->rd_amroutine->amgettuple(scan, direction))
+		{
+			prefetch->exhausted = true;
+			break;
+		}
+
+		pgstat_count_index_tuples(scan->indexRelation, 1);
+
+		entry = &prefetch->queue[(prefetch->head + prefetch->nqueued) %
+								 (prefetch->maximum + 1)];
+		entry->tid = scan->xs_ctup.t_self;
+		entry->recheck = scan->xs_recheck;
+		entry->itup = NULL;
+		entry->hitup = NULL;
+		if (scan->xs_want_itup)
+		{
+			oldcontext = MemoryContextSwitchTo(prefetch->context);
+			if (scan->xs_hitup != NULL)
+				entry->hitup = heap_copytuple(scan->xs_hitup);
+			else if (scan->xs_itup != NULL)
+				entry->itup = CopyIndexTuple(scan->xs_itup);
+			MemoryContextSwitchTo(oldcontext);
+		}
+
+		/*
+		 * There's no point in prefetching the page of the entry we're about
+		 * to return, nor the same page twice in a row, nor, in an index-only
+		 * scan, a page we won't visit.
+		 */
+		block = ItemPointerGetBlockNumber(&entry->tid);
+		if (prefetch->nqueued > 0 && block != prefetch->last_block &&
+			(!scan->xs_want_itup ||
+			 !VM_ALL_VISIBLE(scan->heapRelation, block, &prefetch->vmbuffer)))
+		{
+			PrefetchBuffer(scan->heapRelation, MAIN_FORKNUM, block);
+			prefetch->last_block = block;
+		}
+
+		prefetch->nqueued++;
+	}
+
+	/* If we're out of index entries, we're done */
+	if (prefetch->nqueued == 0)
+	{
+		MemSet(&prefetch->returned, 0, sizeof(IndexPrefetchEntry));
+
+		/* ... but first, release any held pin on a heap page */
+		if (BufferIsValid(scan->xs_cbuf))
+		{
+			ReleaseBuffer(scan->xs_cbuf);
+			scan->xs_cbuf = InvalidBuffer;
+		}
+		return NULL;
+	}
+
+	/* Hand out the oldest entry, as if the AM had just returned it */
+	entry = &prefetch->queue[prefetch->head];
+	prefetch->head = (prefetch->head + 1) % (prefetch->maximum + 1);
+	prefetch->nqueued--;
+	prefetch->returned = *entry;
+
+	scan->xs_ctup.t_self = entry->tid;
+	scan->xs_recheck = entry->recheck;
+	if (scan->xs_want_itup)
+	{
+		scan->xs_itup = entry->itup;
+		scan->xs_hitup = entry->hitup;
+	}
+
+	if (prefetch->distance < prefetch->maximum)
+		prefetch->distance++;
+
+	return &scan->xs_ctup.t_self;
+}
+
 /* ----------------
  * index_getnext_tid - get the next TID from a scan
  *
@@ -533,6 +789,9 @@ index_getnext_tid(IndexScanDesc scan, ScanDirection direction)
 
 	Assert(TransactionIdIsValid(RecentGlobalXmin));
 
+	if (scan->xs_prefetch != NULL)
+		return index_getnext_tid_prefetch(scan, direction);
+
 	/*
 	 * The AM's amgettuple proc finds the next index entry matching the scan
 	 * keys, and puts the TID into scan->xs_ctup.t_self.  It should also set
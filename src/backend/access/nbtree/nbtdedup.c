@@ -0,0 +1,367 @@
+/*-------------------------------------------------------------------------
+ *
+ * nbtdedup.c
+ *	  Deduplication of leaf tuples in Postgres btrees.
+ *
+ * An index with many duplicates of the same key stores every one of them as
+ * a separate leaf tuple, each with its own copy of the key.  Deduplication
+ * merges runs of such tuples into a single posting list tuple, which holds
+ * the key once, followed by a sorted array of heap TIDs.  This is done
+ * lazily, when a leaf page would otherwise have to be split, and while
+ * building an index (see nbtsort.c).  See the nbtree README for details.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/access/nbtree/nbtdedup.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/nbtree.h"
+#include "access/nbtxlog.h"
+#include "access/xloginsert.h"
+#include "miscadmin.h"
+#include "storage/bufpage.h"
+#include "utils/rel.h"
+
+/*
+ * Posting list tuples are kept to half the maximum size of an index tuple
+ * (see BTMaxItemSize), so that a page that is split still has room for
+ * several of them on either side.  Btree pages are always BLCKSZ bytes.
+ */
+#define BTMaxPostingSize \
+	(MAXALIGN_DOWN((BLCKSZ - \
+					MAXALIGN(SizeOfPageHeaderData + 3 * sizeof(ItemIdData)) - \
+					MAXALIGN(sizeof(BTPageOpaqueData))) / 3) / 2)
+
+static Size _bt_dedup_key_size(IndexTuple itup);
+static int	_bt_dedup_ntids(IndexTuple itup);
+static int	_bt_dedup_cmp_tids(const void *a, const void *b);
+
+
+/*
+ *	_bt_dedup_is_possible() -- May duplicates be merged in this index?
+ *
+ * Unique indexes are left alone, since _bt_check_unique wants to visit every
+ * heap tuple of a key on its own, and they seldom have many duplicates
+ * anyway.  Indexes with INCLUDE columns are left alone too, since tuples
+ * with equal keys need not have equal non-key columns.
+ */
+bool
+_bt_dedup_is_possible(Relation rel)
+{
+	if (rel->rd_index->indisunique)
+		return false;
+	if (IndexRelationGetNumberOfKeyAttributes(rel) !=
+		IndexRelationGetNumberOfAttributes(rel))
+		return false;
+
+	return rel->rd_options == NULL ||
+		((StdRdOptions *) rel->rd_options)->deduplicate_items;
+}
+
+/*
+ * Size of the part of itup that holds its key, without any posting list.
+ */
+static Size
+_bt_dedup_key_size(IndexTuple itup)
+{
+	if (BTreeTupleIsPosting(itup))
+		return BTreeTupleGetPostingOffset(itup);
+	return IndexTupleSize(itup);
+}
+
+/*
+ * Number of heap TIDs that itup stands for.
+ */
+static int
+_bt_dedup_ntids(IndexTuple itup)
+{
+	if (BTreeTupleIsPosting(itup))
+		return BTreeTupleGetNPosting(itup);
+	return 1;
+}
+
+/*
+ *	_bt_dedup_keys_equal() -- Are the keys of two leaf tuples identical?
+ *
+ * We only merge tuples whose keys are bitwise identical, rather than equal
+ * according to the index's operators.  Tuples that are equal but not
+ * identical (say, numeric 1.0 and 1.00) are simply not merged, which is
+ * safe, and it means that a posting list tuple can be returned to the scan
+ * as if it were the original tuples, for index-only scans too.
+ */
+bool
+_bt_dedup_keys_equal(IndexTuple itup1, IndexTuple itup2)
+{
+	Size		keysize = _bt_dedup_key_size(itup1);
+
+	if (keysize != _bt_dedup_key_size(itup2))
+		return false;
+	if ((itup1->t_info & (INDEX_NULL_MASK | INDEX_VAR_MASK)) !=
+		(itup2->t_info & (INDEX_NULL_MASK | INDEX_VAR_MASK)))
+		return false;
+
+	return memcmp((char *) itup1 + sizeof(IndexTupleData),
+				  (char *) itup2 + sizeof(IndexTupleData),
+				  keysize - sizeof(IndexTupleData)) == 0;
+}
+
+/*
+ *	_bt_dedup_max_htids() -- How many heap TIDs may a posting list tuple with
+ *	the key of base hold?
+ */
+int
+_bt_dedup_max_htids(IndexTuple base)
+{
+	Size		keysize = _bt_dedup_key_size(base);
+
+	if (keysize + 2 * sizeof(ItemPointerData) > BTMaxPostingSize)
+		return 1;
+
+	return Min((int) ((BTMaxPostingSize - keysize) / sizeof(ItemPointerData)),
+			   BT_N_KEYS_OFFSET_MASK);
+}
+
+/*
+ *	_bt_form_posting() -- Make a leaf tuple with the key of base for the
+ *	given heap TIDs, which must be in ascending order.
+ *
+ * base may be a plain tuple or a posting list tuple.  If there is just one
+ * heap TID, the result is a plain tuple.  The result is palloc'd.
+ */
+IndexTuple
+_bt_form_posting(IndexTuple base, ItemPointer htids, int nhtids)
+{
+	Size		keysize = _bt_dedup_key_size(base);
+	Size		newsize;
+	IndexTuple	itup;
+
+	Assert(nhtids > 0 && nhtids <= BT_N_KEYS_OFFSET_MASK);
+	Assert(keysize == MAXALIGN(keysize));
+
+	if (nhtids > 1)
+		newsize = MAXALIGN(keysize + nhtids * sizeof(ItemPointerData));
+	else
+		newsize = keysize;
+
+	itup = (IndexTuple) palloc0(newsize);
+	memcpy(itup, base, keysize);
+	itup->t_info &= ~(INDEX_SIZE_MASK | INDEX_ALT_TID_MASK);
+	itup->t_info |= newsize;
+
+	if (nhtids > 1)
+	{
+		BTreeTupleSetPosting(itup, nhtids, keysize);
+		memcpy(BTreeTupleGetPosting(itup), htids,
+			   nhtids * sizeof(ItemPointerData));
+	}
+	else
+		itup->t_tid = *htids;
+
+	return itup;
+}
+
+static int
+_bt_dedup_cmp_tids(const void *a, const void *b)
+{
+	return ItemPointerCompare((ItemPointer) a, (ItemPointer) b);
+}
+
+/*
+ *	_bt_dedup_apply() -- Build a copy of a leaf page with the given intervals
+ *	of items merged into posting list tuples.
+ *
+ * The intervals must be in ascending order and must not overlap.  The new
+ * page is returned in palloc'd memory, so that the caller can put it in
+ * place inside a critical section.  This is also used by WAL replay, so it
+ * must produce the same page from the same input.
+ */
+Page
+_bt_dedup_apply(Page page, BTDedupInterval *intervals, int nintervals)
+{
+	BTPageOpaque opaque = (BTPageOpaque) PageGetSpecialPointer(page);
+	Page		newpage = PageGetTempPageCopySpecial(page);
+	OffsetNumber offnum,
+				maxoff = PageGetMaxOffsetNumber(page);
+	ItemPointer htids;
+	int			interval = 0;
+
+	Assert(P_ISLEAF(opaque));
+
+	htids = (ItemPointer) palloc(MaxTIDsPerBTreePage * sizeof(ItemPointerData));
+
+	/* The high key, if any, is copied first, as are all unmerged items */
+	for (offnum = FirstOffsetNumber; offnum <= maxoff;)
+	{
+		ItemId		itemid = PageGetItemId(page, offnum);
+		IndexTuple	itup = (IndexTuple) PageGetItem(page, itemid);
+		OffsetNumber newoff;
+
+		if (interval < nintervals && intervals[interval].baseoff == offnum)
+		{
+			IndexTuple	posting;
+			int			nhtids = 0;
+			int			i;
+
+			for (i = 0; i < intervals[interval].nitems; i++)
+			{
+				IndexTuple	cur;
+
+				cur = (IndexTuple) PageGetItem(page,
+											   PageGetItemId(page, offnum + i));
+				if (BTreeTupleIsPosting(cur))
+				{
+					memcpy(htids + nhtids, BTreeTupleGetPosting(cur),
+						   BTreeTupleGetNPosting(cur) * sizeof(ItemPointerData));
+					nhtids += BTreeTupleGetNPosting(cur);
+				}
+				else
+					htids[nhtids++] = cur->t_tid;
+			}
+
+			/* duplicates inserted later may have lower TIDs */
+			qsort(htids, nhtids, sizeof(ItemPointerData), _bt_dedup_cmp_tids);
+
+			posting = _bt_form_posting(itup, htids, nhtids);
+			newoff = PageAddItem(newpage, (Item) posting,
+								 IndexTupleSize(posting), InvalidOffsetNumber,
+								 false, false);
+			pfree(posting);
+
+			offnum += intervals[interval].nitems;
+			interval++;
+		}
+		else
+		{
+			newoff = PageAddItem(newpage, (Item) itup, ItemIdGetLength(itemid),
+								 InvalidOffsetNumber, false, false);
+			if (newoff != InvalidOffsetNumber && ItemIdIsDead(itemid))
+				ItemIdMarkDead(PageGetItemId(newpage, newoff));
+			offnum++;
+		}
+
+		if (newoff == InvalidOffsetNumber)
+			elog(PANIC, "failed to add item to the deduplicated page");
+	}
+
+	pfree(htids);
+
+	return newpage;
+}
+
+/*
+ *	_bt_dedup_one_page() -- Try to make room on a leaf page by merging
+ *	duplicates.
+ *
+ * Called by _bt_findinsertloc when the page has no room for a new item, just
+ * before it would be split.  The caller must hold an exclusive lock on buf.
+ * Returns true if any items were merged, so that the page has changed.
+ *
+ * Items marked LP_DEAD are never merged, so _bt_vacuum_one_page should have
+ * been given a chance to remove them first.
+ */
+bool
+_bt_dedup_one_page(Relation rel, Buffer buf)
+{
+	Page		page = BufferGetPage(buf);
+	BTPageOpaque opaque = (BTPageOpaque) PageGetSpecialPointer(page);
+	BTDedupInterval intervals[MaxIndexTuplesPerPage];
+	int			nintervals = 0;
+	OffsetNumber offnum,
+				minoff = P_FIRSTDATAKEY(opaque),
+				maxoff = PageGetMaxOffsetNumber(page);
+	Page		newpage;
+
+	Assert(P_ISLEAF(opaque));
+
+	/*
+	 * Find the runs of consecutive items with identical keys.  A run is cut
+	 * short when its posting list would grow too large; the rest of it may
+	 * then start a run of its own.
+	 */
+	for (offnum = minoff; offnum <= maxoff;)
+	{
+		ItemId		itemid = PageGetItemId(page, offnum);
+		IndexTuple	base = (IndexTuple) PageGetItem(page, itemid);
+		OffsetNumber next = OffsetNumberNext(offnum);
+		int			nhtids;
+		int			maxhtids;
+
+		if (ItemIdIsDead(itemid))
+		{
+			offnum = next;
+			continue;
+		}
+
+		nhtids = _bt_dedup_ntids(base);
+		maxhtids = _bt_dedup_max_htids(base);
+
+		for (; next <= maxoff; next = OffsetNumberNext(next))
+		{
+			ItemId		nextid = PageGetItemId(page, next);
+			IndexTuple	itup = (IndexTuple) PageGetItem(page, nextid);
+
+			if (ItemIdIsDead(nextid) ||
+				nhtids + _bt_dedup_ntids(itup) > maxhtids ||
+				!_bt_dedup_keys_equal(base, itup))
+				break;
+			nhtids += _bt_dedup_ntids(itup);
+		}
+
+		if (next - offnum > 1)
+		{
+			intervals[nintervals].baseoff = offnum;
+			intervals[nintervals].nitems = next - offnum;
+			nintervals++;
+		}
+
+		offnum = next;
+	}
+
+	if (nintervals == 0)
+		return false;
+
+	/* Build the new page outside of the critical section */
+	newpage = _bt_dedup_apply(page, intervals, nintervals);
+
+	/* No ereport(ERROR) until changes are logged */
+	START_CRIT_SECTION();
+
+	PageRestoreTempPage(newpage, page);
+	MarkBufferDirty(buf);
+
+	/* XLOG stuff */
+	if (RelationNeedsWAL(rel))
+	{
+		XLogRecPtr	recptr;
+		xl_btree_dedup xlrec_dedup;
+
+		xlrec_dedup.nintervals = nintervals;
+
+		XLogBeginInsert();
+		XLogRegisterBuffer(0, buf, REGBUF_STANDARD);
+		XLogRegisterData((char *) &xlrec_dedup, SizeOfBtreeDedup);
+
+		/*
+		 * The intervals array is not in the buffer, but pretend that it is.
+		 * When XLogInsert stores the whole buffer, the array need not be
+		 * stored too.
+		 */
+		XLogRegisterBufData(0, (char *) intervals,
+							nintervals * sizeof(BTDedupInterval));
+
+		recptr = XLogInsert(RM_BTREE_ID, XLOG_BTREE_DEDUP);
+
+		PageSetLSN(page, recptr);
+	}
+
+	END_CRIT_SECTION();
+
+	return true;
+}
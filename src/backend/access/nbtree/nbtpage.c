@@ -942,6 +942,10 @@ _bt_page_recyclable(Page page)
  * This routine assumes that the caller has pinned and locked the buffer.
  * Also, the given itemnos *must* appear in increasing order in the array.
  *
+ * updatednos and updated give posting list tuples that only some of the heap
+ * TIDs were removed from, and their replacements.  These are overwritten in
+ * place before the items in itemnos are deleted.
+ *
  * We record VACUUMs and b-tree deletes differently in WAL. InHotStandby
  * we need to be able to pin all of the blocks in the btree in physical
  * order when replaying the effects of a VACUUM, just as we do for the
@@ -955,15 +959,50 @@ _bt_page_recyclable(Page page)
 void
 _bt_delitems_vacuum(Relation rel, Buffer buf,
 					OffsetNumber *itemnos, int nitems,
-					BlockNumber lastBlockVacuumed)
+					OffsetNumber *updatednos, IndexTuple *updated,
+					int nupdated, BlockNumber lastBlockVacuumed)
 {
 	Page		page = BufferGetPage(buf);
 	BTPageOpaque opaque;
+	char	   *updatedbuf = NULL;
+	Size		updatedbuflen = 0;
+	int			i;
+
+	/*
+	 * Put the offsets and the updated tuples together for the WAL record,
+	 * while we're still allowed to allocate memory.
+	 */
+	if (nupdated > 0 && RelationNeedsWAL(rel))
+	{
+		char	   *ptr;
+
+		updatedbuflen = nupdated * sizeof(OffsetNumber);
+		for (i = 0; i < nupdated; i++)
+			updatedbuflen += MAXALIGN(IndexTupleSize(updated[i]));
+
+		ptr = updatedbuf = palloc(updatedbuflen);
+		memcpy(ptr, updatednos, nupdated * sizeof(OffsetNumber));
+		ptr += nupdated * sizeof(OffsetNumber);
+		for (i = 0; i < nupdated; i++)
+		{
+			Size		itemsz = MAXALIGN(IndexTupleSize(updated[i]));
+
+			memcpy(ptr, updated[i], itemsz);
+			ptr += itemsz;
+		}
+	}
 
 	/* No ereport(ERROR) until changes are logged */
 	START_CRIT_SECTION();
 
 	/* Fix the page */
+	for (i = 0; i < nupdated; i++)
+	{
+		if (!PageIndexTupleOverwrite(page, updatednos[i], (Item) updated[i],
+									 MAXALIGN(IndexTupleSize(updated[i]))))
+			elog(PANIC, "failed to update posting list tuple in index \"%s\"",
+				 RelationGetRelationName(rel));
+	}
 	if (nitems > 0)
 		PageIndexMultiDelete(page, itemnos, nitems);
 
@@ -992,6 +1031,8 @@ _bt_delitems_vacuum(Relation rel, Buffer buf,
 		xl_btree_vacuum xlrec_vacuum;
 
 		xlrec_vacuum.lastBlockVacuumed = lastBlockVacuumed;
+		xlrec_vacuum.ndeleted = nitems;
+		xlrec_vacuum.nupdated = nupdated;
 
 		XLogBeginInsert();
 		XLogRegisterBuffer(0, buf, REGBUF_STANDARD);
@@ -1000,10 +1041,12 @@ _bt_delitems_vacuum(Relation rel, Buffer buf,
 		/*
 		 * The target-offsets array is not in the buffer, but pretend that it
 		 * is.  When XLogInsert stores the whole buffer, the offsets array
-		 * need not be stored too.
+		 * need not be stored too.  The same goes for the updated tuples.
 		 */
 		if (nitems > 0)
 			XLogRegisterBufData(0, (char *) itemnos, nitems * sizeof(OffsetNumber));
+		if (nupdated > 0)
+			XLogRegisterBufData(0, updatedbuf, updatedbuflen);
 
 		recptr = XLogInsert(RM_BTREE_ID, XLOG_BTREE_VACUUM);
 
@@ -1011,6 +1054,9 @@ _bt_delitems_vacuum(Relation rel, Buffer buf,
 	}
 
 	END_CRIT_SECTION();
+
+	if (updatedbuf != NULL)
+		pfree(updatedbuf);
 }
 
 /*
@@ -1421,9 +1467,16 @@ _bt_pagedel(Relation rel, Buffer buf)
 
 				/* we need an insertion scan key for the search, so build one */
 				itup_scankey = _bt_mkscankey(rel, targetkey);
-				/* find the leftmost leaf page containing this key */
+
+				/*
+				 * Find the leftmost leaf page containing this key.  The high
+				 * key may have been suffix truncated, in which case we only
+				 * search on its remaining attributes.  That still leads us
+				 * to our parent or someplace to its left.
+				 */
 				stack = _bt_search(rel,
-								   IndexRelationGetNumberOfKeyAttributes(rel),
+								   Min(BTreeTupleGetNAtts(targetkey, rel),
+									   IndexRelationGetNumberOfKeyAttributes(rel)),
 								   itup_scankey, false, &lbuf, BT_READ, NULL);
 				/* don't need a pin on the page */
 				_bt_relbuf(rel, lbuf);
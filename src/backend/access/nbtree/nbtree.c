@@ -96,6 +96,9 @@ static void btvacuumscan(IndexVacuumInfo *info, IndexBulkDeleteResult *stats,
 			 BTCycleId cycleid, TransactionId *oldestBtpoXact);
 static void btvacuumpage(BTVacState *vstate, BlockNumber blkno,
 			 BlockNumber orig_blkno);
+static IndexTuple btvacuumposting(IndexTuple itup,
+				IndexBulkDeleteCallback callback, void *callback_state,
+				int *nremoved);
 
 
 /*
@@ -122,6 +125,8 @@ bthandler(PG_FUNCTION_ARGS)
 	amroutine->ampredlocks = true;
 	amroutine->amcanparallel = true;
 	amroutine->amcaninclude = true;
+	amroutine->amcanskip = true;
+	amroutine->amcanbuildparallel = true;
 	amroutine->amkeytype = InvalidOid;
 
 	amroutine->ambuild = btbuild;
@@ -233,7 +238,20 @@ btgettuple(IndexScanDesc scan, ScanDirection dir)
 		_bt_start_array_keys(scan, dir);
 	}
 
-	/* This loop handles advancing to the next array elements, if any */
+	/*
+	 * Likewise, a skip scan must find the first value of the leading column
+	 * before its first descent.
+	 */
+	if (so->skipScan && !so->skipHaveValue && !BTScanPosIsValid(so->currPos))
+	{
+		if (!_bt_skip_advance(scan, dir))
+			return false;
+	}
+
+	/*
+	 * This loop handles advancing to the next array elements, and to the next
+	 * value of the leading column in a skip scan, if any
+	 */
 	do
 	{
 		/*
@@ -261,8 +279,8 @@ btgettuple(IndexScanDesc scan, ScanDirection dir)
 				 */
 				if (so->killedItems == NULL)
 					so->killedItems = (int *)
-						palloc(MaxIndexTuplesPerPage * sizeof(int));
-				if (so->numKilled < MaxIndexTuplesPerPage)
+						palloc(MaxTIDsPerBTreePage * sizeof(int));
+				if (so->numKilled < MaxTIDsPerBTreePage)
 					so->killedItems[so->numKilled++] = so->currPos.itemIndex;
 			}
 
@@ -275,8 +293,9 @@ btgettuple(IndexScanDesc scan, ScanDirection dir)
 		/* If we have a tuple, return it ... */
 		if (res)
 			break;
-		/* ... otherwise see if we have more array keys to deal with */
-	} while (so->numArrayKeys && _bt_advance_array_keys(scan, dir));
+		/* ... otherwise see if we have more array keys or values to deal with */
+	} while ((so->numArrayKeys && _bt_advance_array_keys(scan, dir)) ||
+			 (so->skipScan && _bt_skip_advance(scan, dir)));
 
 	return res;
 }
@@ -358,8 +377,10 @@ btbeginscan(Relation rel, int nkeys, int norderbys)
 	so = (BTScanOpaque) palloc(sizeof(BTScanOpaqueData));
 	BTScanPosInvalidate(so->currPos);
 	BTScanPosInvalidate(so->markPos);
+	/* leave room for the extra key of a skip scan */
 	if (scan->numberOfKeys > 0)
-		so->keyData = (ScanKey) palloc(scan->numberOfKeys * sizeof(ScanKeyData));
+		so->keyData = (ScanKey) palloc((scan->numberOfKeys + 1) *
+									   sizeof(ScanKeyData));
 	else
 		so->keyData = NULL;
 
@@ -368,12 +389,18 @@ btbeginscan(Relation rel, int nkeys, int norderbys)
 	so->arrayKeys = NULL;
 	so->arrayContext = NULL;
 
+	so->skipScan = false;		/* decided in btrescan */
+	so->skipHaveValue = false;
+	so->skipProbe = false;
+	so->skipKeyData = NULL;
+	so->skipContext = NULL;
+
 	so->killedItems = NULL;		/* until needed */
 	so->numKilled = 0;
 
 	/*
-	 * We don't know yet whether the scan will be index-only, so we do not
-	 * allocate the tuple workspace arrays until btrescan.  However, we set up
+	 * We don't know yet whether the scan will be index-only or a skip scan,
+	 * so we do not allocate the tuple workspace arrays until btrescan.  However, we set up
 	 * scan->xs_itupdesc whether we'll need it or not, since that's so cheap.
 	 */
 	so->currTuples = so->markTuples = NULL;
@@ -410,8 +437,21 @@ btrescan(IndexScanDesc scan, ScanKey scankey, int nscankeys,
 	BTScanPosInvalidate(so->markPos);
 
 	/*
-	 * Allocate tuple workspace arrays, if needed for an index-only scan and
-	 * not already done in a previous rescan call.  To save on palloc
+	 * Reset the scan keys. Note that keys ordering stuff moved to _bt_first.
+	 * - vadim 05/05/97
+	 */
+	if (scankey && scan->numberOfKeys > 0)
+		memmove(scan->keyData,
+				scankey,
+				scan->numberOfKeys * sizeof(ScanKeyData));
+	so->numberOfKeys = 0;		/* until _bt_preprocess_keys sets it */
+
+	/* Decide whether we can do a skip scan, if asked for one */
+	_bt_setup_skip_scan(scan);
+
+	/*
+	 * Allocate tuple workspace arrays, if needed for an index-only scan or a
+	 * skip scan and not already done in a previous rescan call.  To save on palloc
 	 * overhead, both workspaces are allocated as one palloc block; only this
 	 * function and btendscan know that.
 	 *
@@ -425,22 +465,12 @@ btrescan(IndexScanDesc scan, ScanKey scankey, int nscankeys,
 	 * a SIGSEGV is not possible.  Yeah, this is ugly as sin, but it beats
 	 * adding special-case treatment for name_ops elsewhere.
 	 */
-	if (scan->xs_want_itup && so->currTuples == NULL)
+	if ((scan->xs_want_itup || so->skipScan) && so->currTuples == NULL)
 	{
 		so->currTuples = (char *) palloc(BLCKSZ * 2);
 		so->markTuples = so->currTuples + BLCKSZ;
 	}
 
-	/*
-	 * Reset the scan keys. Note that keys ordering stuff moved to _bt_first.
-	 * - vadim 05/05/97
-	 */
-	if (scankey && scan->numberOfKeys > 0)
-		memmove(scan->keyData,
-				scankey,
-				scan->numberOfKeys * sizeof(ScanKeyData));
-	so->numberOfKeys = 0;		/* until _bt_preprocess_keys sets it */
-
 	/* If any keys are SK_SEARCHARRAY type, set up array-key info */
 	_bt_preprocess_array_keys(scan);
 }
@@ -473,6 +503,9 @@ btendscan(IndexScanDesc scan)
 	/* so->arrayKeyData and so->arrayKeys are in arrayContext */
 	if (so->arrayContext != NULL)
 		MemoryContextDelete(so->arrayContext);
+	/* so->skipKeyData and the skip value are in skipContext */
+	if (so->skipContext != NULL)
+		MemoryContextDelete(so->skipContext);
 	if (so->killedItems != NULL)
 		pfree(so->killedItems);
 	if (so->currTuples != NULL)
@@ -1060,7 +1093,8 @@ btvacuumscan(IndexVacuumInfo *info, IndexBulkDeleteResult *stats,
 								 RBM_NORMAL, info->strategy);
 		LockBufferForCleanup(buf);
 		_bt_checkpage(rel, buf);
-		_bt_delitems_vacuum(rel, buf, NULL, 0, vstate.lastBlockVacuumed);
+		_bt_delitems_vacuum(rel, buf, NULL, 0, NULL, NULL, 0,
+							vstate.lastBlockVacuumed);
 		_bt_relbuf(rel, buf);
 	}
 
@@ -1181,6 +1215,10 @@ restart:
 	{
 		OffsetNumber deletable[MaxOffsetNumber];
 		int			ndeletable;
+		OffsetNumber updatable[MaxOffsetNumber];
+		IndexTuple	updated[MaxOffsetNumber];
+		int			nupdatable;
+		int			nremovedtids;
 		OffsetNumber offnum,
 					minoff,
 					maxoff;
@@ -1220,6 +1258,8 @@ restart:
 		 * callback function.
 		 */
 		ndeletable = 0;
+		nupdatable = 0;
+		nremovedtids = 0;
 		minoff = P_FIRSTDATAKEY(opaque);
 		maxoff = PageGetMaxOffsetNumber(page);
 		if (callback)
@@ -1233,6 +1273,25 @@ restart:
 
 				itup = (IndexTuple) PageGetItem(page,
 												PageGetItemId(page, offnum));
+
+				if (BTreeTupleIsPosting(itup))
+				{
+					IndexTuple	newitup;
+
+					newitup = btvacuumposting(itup, callback, callback_state,
+											  &nremovedtids);
+					if (newitup == itup)
+						continue;	/* no heap TIDs removed */
+					else if (newitup == NULL)
+						deletable[ndeletable++] = offnum;
+					else
+					{
+						updatable[nupdatable] = offnum;
+						updated[nupdatable++] = newitup;
+					}
+					continue;
+				}
+
 				htup = &(itup->t_tid);
 
 				/*
@@ -1257,16 +1316,22 @@ restart:
 				 * killed.
 				 */
 				if (callback(htup, callback_state))
+				{
 					deletable[ndeletable++] = offnum;
+					nremovedtids++;
+				}
 			}
 		}
 
 		/*
-		 * Apply any needed deletes.  We issue just one _bt_delitems_vacuum()
-		 * call per page, so as to minimize WAL traffic.
+		 * Apply any needed deletes and updates of posting list tuples.  We
+		 * issue just one _bt_delitems_vacuum() call per page, so as to
+		 * minimize WAL traffic.
 		 */
-		if (ndeletable > 0)
+		if (ndeletable > 0 || nupdatable > 0)
 		{
+			int			i;
+
 			/*
 			 * Notice that the issued XLOG_BTREE_VACUUM WAL record includes
 			 * all information to the replay code to allow it to get a cleanup
@@ -1282,6 +1347,7 @@ restart:
 			 * that.
 			 */
 			_bt_delitems_vacuum(rel, buf, deletable, ndeletable,
+								updatable, updated, nupdatable,
 								vstate->lastBlockVacuumed);
 
 			/*
@@ -1291,7 +1357,10 @@ restart:
 			if (blkno > vstate->lastBlockVacuumed)
 				vstate->lastBlockVacuumed = blkno;
 
-			stats->tuples_removed += ndeletable;
+			for (i = 0; i < nupdatable; i++)
+				pfree(updated[i]);
+
+			stats->tuples_removed += nremovedtids;
 			/* must recompute maxoff */
 			maxoff = PageGetMaxOffsetNumber(page);
 		}
@@ -1323,7 +1392,22 @@ restart:
 		if (minoff > maxoff)
 			delete_now = (blkno == orig_blkno);
 		else
-			stats->num_index_tuples += maxoff - minoff + 1;
+		{
+			/* count heap TIDs rather than index tuples */
+			for (offnum = minoff;
+				 offnum <= maxoff;
+				 offnum = OffsetNumberNext(offnum))
+			{
+				IndexTuple	itup;
+
+				itup = (IndexTuple) PageGetItem(page,
+												PageGetItemId(page, offnum));
+				if (BTreeTupleIsPosting(itup))
+					stats->num_index_tuples += BTreeTupleGetNPosting(itup);
+				else
+					stats->num_index_tuples += 1;
+			}
+		}
 	}
 
 	if (delete_now)
@@ -1366,6 +1450,58 @@ restart:
 	}
 }
 
+/*
+ * btvacuumposting --- determine which heap TIDs of a posting list tuple
+ * VACUUM removes
+ *
+ * Returns itup itself if none are removed, or NULL if all of them are.
+ * Otherwise, returns a palloc'd replacement tuple with the remaining heap
+ * TIDs.  *nremoved is incremented by the number of heap TIDs removed.
+ */
+static IndexTuple
+btvacuumposting(IndexTuple itup, IndexBulkDeleteCallback callback,
+				void *callback_state, int *nremoved)
+{
+	int			nposting = BTreeTupleGetNPosting(itup);
+	ItemPointer remaining = NULL;
+	int			nremaining = 0;
+	int			i;
+	IndexTuple	newitup;
+
+	for (i = 0; i < nposting; i++)
+	{
+		ItemPointer htid = BTreeTupleGetPostingN(itup, i);
+
+		if (callback(htid, callback_state))
+		{
+			/* first removed TID, so start collecting the ones we keep */
+			if (remaining == NULL)
+			{
+				remaining = (ItemPointer) palloc(nposting * sizeof(ItemPointerData));
+				memcpy(remaining, BTreeTupleGetPosting(itup),
+					   i * sizeof(ItemPointerData));
+				nremaining = i;
+			}
+			(*nremoved)++;
+		}
+		else if (remaining != NULL)
+			remaining[nremaining++] = *htid;
+	}
+
+	if (remaining == NULL)
+		return itup;
+	if (nremaining == 0)
+	{
+		pfree(remaining);
+		return NULL;
+	}
+
+	newitup = _bt_form_posting(itup, remaining, nremaining);
+	pfree(remaining);
+
+	return newitup;
+}
+
 /*
  *	btcanreturn() -- Check whether btree indexes support index-only scans.
  *
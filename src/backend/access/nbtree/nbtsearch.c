@@ -20,6 +20,7 @@
 #include "miscadmin.h"
 #include "pgstat.h"
 #include "storage/predicate.h"
+#include "utils/datum.h"
 #include "utils/lsyscache.h"
 #include "utils/rel.h"
 #include "utils/tqual.h"
@@ -29,6 +30,12 @@ static bool _bt_readpage(IndexScanDesc scan, ScanDirection dir,
 			 OffsetNumber offnum);
 static void _bt_saveitem(BTScanOpaque so, int itemIndex,
 			 OffsetNumber offnum, IndexTuple itup);
+static int _bt_setuppostingitems(BTScanOpaque so, int itemIndex,
+					  OffsetNumber offnum, ItemPointer heapTid,
+					  IndexTuple itup);
+static void _bt_savepostingitem(BTScanOpaque so, int itemIndex,
+					OffsetNumber offnum, ItemPointer heapTid,
+					int tupleOffset);
 static bool _bt_steppage(IndexScanDesc scan, ScanDirection dir);
 static bool _bt_readnextpage(IndexScanDesc scan, BlockNumber blkno, ScanDirection dir);
 static bool _bt_parallel_readpage(IndexScanDesc scan, BlockNumber blkno,
@@ -452,6 +459,11 @@ _bt_binsrch(Relation rel,
  * does not matter.  This convention allows us to implement the Lehman and
  * Yao convention that the first down-link pointer is before the first key.
  * See backend/access/nbtree/README for details.
+ *
+ * Pivot tuples (high keys and downlinks) may have had some of their trailing
+ * key attributes truncated away by suffix truncation.  A truncated attribute
+ * is treated as "minus infinity", so the scankey is greater than the tuple
+ * once all of the tuple's untruncated attributes compare equal.
  *----------
  */
 int32
@@ -464,6 +476,7 @@ _bt_compare(Relation rel,
 	TupleDesc	itupdesc = RelationGetDescr(rel);
 	BTPageOpaque opaque = (BTPageOpaque) PageGetSpecialPointer(page);
 	IndexTuple	itup;
+	int			ntupatts;
 	int			i;
 
 	Assert(_bt_check_natts(rel, page, offnum));
@@ -476,6 +489,7 @@ _bt_compare(Relation rel,
 		return 1;
 
 	itup = (IndexTuple) PageGetItem(page, PageGetItemId(page, offnum));
+	ntupatts = BTreeTupleGetNAtts(itup, rel);
 
 	/*
 	 * The scan key is set up with the attribute number associated with each
@@ -495,6 +509,10 @@ _bt_compare(Relation rel,
 		bool		isNull;
 		int32		result;
 
+		/* truncated attributes are "minus infinity", see NOTE above */
+		if (scankey->sk_attno > ntupatts)
+			return 1;
+
 		datum = index_getattr(itup, scankey->sk_attno, itupdesc, &isNull);
 
 		/* see comments about NULLs handling in btbuild */
@@ -1193,6 +1211,110 @@ _bt_next(IndexScanDesc scan, ScanDirection dir)
 	return true;
 }
 
+/*
+ *	_bt_skip_advance() -- Move a skip scan on to the next value of the
+ *		first index column.
+ *
+ *		The next distinct value after the current one in the given direction
+ *		is found with a separate descent, see _bt_setup_skip_scan.  NULLs
+ *		form a group of their own, at whichever end of the index they sort
+ *		at.  On success, the new value is what the next _bt_first will
+ *		search for.  If there are no more values, we return false, and the
+ *		scan starts over if it is called again.
+ *
+ *		so->currPos must not be valid on entry, and is left that way.
+ */
+bool
+_bt_skip_advance(IndexScanDesc scan, ScanDirection dir)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	Relation	rel = scan->indexRelation;
+	int16		indoption = rel->rd_indoption[0];
+	bool		nullsBefore;
+	bool		found;
+
+	Assert(so->skipScan && !BTScanPosIsValid(so->currPos));
+
+	/*
+	 * The first column has no keys of its own, so if the other keys can't be
+	 * satisfied for one value they can't be for any.  (With array keys, that
+	 * might only be true of the last set of array elements tried.)
+	 */
+	if (so->skipHaveValue && !so->qual_ok && so->numArrayKeys == 0)
+	{
+		_bt_skip_forget_value(scan);
+		return false;
+	}
+
+	/* Do NULLs come before the other values, in this scan direction? */
+	nullsBefore = (ScanDirectionIsForward(dir) ==
+				   ((indoption & INDOPTION_NULLS_FIRST) != 0));
+
+	if (so->skipHaveValue && so->skipIsNull && !nullsBefore)
+	{
+		/* The NULLs were the last group */
+		_bt_skip_forget_value(scan);
+		return false;
+	}
+
+	/*
+	 * Look for the first entry after the current value.  For a DESC column,
+	 * the index order is the reverse of the operators' order.
+	 */
+	so->skipProbe = true;
+	so->skipProbeStrategy =
+		(ScanDirectionIsForward(dir) == ((indoption & INDOPTION_DESC) == 0)) ?
+		BTGreaterStrategyNumber : BTLessStrategyNumber;
+	found = _bt_first(scan, dir);
+	so->skipProbe = false;
+
+	if (found)
+	{
+		BTScanPosItem *currItem = &so->currPos.items[so->currPos.itemIndex];
+		IndexTuple	itup = (IndexTuple) (so->currTuples + currItem->tupleOffset);
+		TupleDesc	itupdesc = RelationGetDescr(rel);
+		Form_pg_attribute attr = TupleDescAttr(itupdesc, 0);
+		Datum		value;
+		bool		isnull;
+
+		value = index_getattr(itup, 1, itupdesc, &isnull);
+
+		_bt_skip_forget_value(scan);
+		so->skipIsNull = isnull;
+		if (isnull)
+			so->skipValue = (Datum) 0;
+		else
+		{
+			MemoryContext oldContext = MemoryContextSwitchTo(so->skipContext);
+
+			so->skipValue = datumCopy(value, attr->attbyval, attr->attlen);
+			MemoryContextSwitchTo(oldContext);
+		}
+		so->skipHaveValue = true;
+
+		/* Forget the probe's position */
+		BTScanPosUnpinIfPinned(so->currPos);
+		BTScanPosInvalidate(so->currPos);
+	}
+	else if (so->skipHaveValue && !so->skipIsNull && !nullsBefore)
+	{
+		/*
+		 * The probe doesn't see NULLs, so they may still follow.  We don't
+		 * bother to check; if there are none, the search for them will just
+		 * come up empty.
+		 */
+		_bt_skip_forget_value(scan);
+		so->skipIsNull = true;
+		so->skipValue = (Datum) 0;
+		so->skipHaveValue = true;
+		found = true;
+	}
+	else
+		_bt_skip_forget_value(scan);
+
+	return found;
+}
+
 /*
  *	_bt_readpage() -- Load data from current index page into so->currPos
  *
@@ -1284,12 +1406,31 @@ _bt_readpage(IndexScanDesc scan, ScanDirection dir, OffsetNumber offnum)
 		while (offnum <= maxoff)
 		{
 			itup = _bt_checkkeys(scan, page, offnum, dir, &continuescan);
-			if (itup != NULL)
+			if (itup != NULL && !BTreeTupleIsPosting(itup))
 			{
 				/* tuple passes all scan key conditions, so remember it */
 				_bt_saveitem(so, itemIndex, offnum, itup);
 				itemIndex++;
 			}
+			else if (itup != NULL)
+			{
+				int			tupleOffset;
+				int			i;
+
+				/* remember each of the heap TIDs of a posting list tuple */
+				tupleOffset =
+					_bt_setuppostingitems(so, itemIndex, offnum,
+										  BTreeTupleGetPostingN(itup, 0),
+										  itup);
+				itemIndex++;
+				for (i = 1; i < BTreeTupleGetNPosting(itup); i++)
+				{
+					_bt_savepostingitem(so, itemIndex, offnum,
+										BTreeTupleGetPostingN(itup, i),
+										tupleOffset);
+					itemIndex++;
+				}
+			}
 			if (!continuescan)
 			{
 				/* there can't be any more matches, so stop */
@@ -1300,7 +1441,7 @@ _bt_readpage(IndexScanDesc scan, ScanDirection dir, OffsetNumber offnum)
 			offnum = OffsetNumberNext(offnum);
 		}
 
-		Assert(itemIndex <= MaxIndexTuplesPerPage);
+		Assert(itemIndex <= MaxTIDsPerBTreePage);
 		so->currPos.firstItem = 0;
 		so->currPos.lastItem = itemIndex - 1;
 		so->currPos.itemIndex = 0;
@@ -1308,19 +1449,42 @@ _bt_readpage(IndexScanDesc scan, ScanDirection dir, OffsetNumber offnum)
 	else
 	{
 		/* load items[] in descending order */
-		itemIndex = MaxIndexTuplesPerPage;
+		itemIndex = MaxTIDsPerBTreePage;
 
 		offnum = Min(offnum, maxoff);
 
 		while (offnum >= minoff)
 		{
 			itup = _bt_checkkeys(scan, page, offnum, dir, &continuescan);
-			if (itup != NULL)
+			if (itup != NULL && !BTreeTupleIsPosting(itup))
 			{
 				/* tuple passes all scan key conditions, so remember it */
 				itemIndex--;
 				_bt_saveitem(so, itemIndex, offnum, itup);
 			}
+			else if (itup != NULL)
+			{
+				int			nposting = BTreeTupleGetNPosting(itup);
+				int			tupleOffset;
+				int			i;
+
+				/*
+				 * remember each of the heap TIDs of a posting list tuple,
+				 * keeping them in ascending order within items[]
+				 */
+				itemIndex--;
+				tupleOffset =
+					_bt_setuppostingitems(so, itemIndex, offnum,
+										  BTreeTupleGetPostingN(itup, nposting - 1),
+										  itup);
+				for (i = nposting - 2; i >= 0; i--)
+				{
+					itemIndex--;
+					_bt_savepostingitem(so, itemIndex, offnum,
+										BTreeTupleGetPostingN(itup, i),
+										tupleOffset);
+				}
+			}
 			if (!continuescan)
 			{
 				/* there can't be any more matches, so stop */
@@ -1333,8 +1497,8 @@ _bt_readpage(IndexScanDesc scan, ScanDirection dir, OffsetNumber offnum)
 
 		Assert(itemIndex >= 0);
 		so->currPos.firstItem = itemIndex;
-		so->currPos.lastItem = MaxIndexTuplesPerPage - 1;
-		so->currPos.itemIndex = MaxIndexTuplesPerPage - 1;
+		so->currPos.lastItem = MaxTIDsPerBTreePage - 1;
+		so->currPos.itemIndex = MaxTIDsPerBTreePage - 1;
 	}
 
 	return (so->currPos.firstItem <= so->currPos.lastItem);
@@ -1359,6 +1523,55 @@ _bt_saveitem(BTScanOpaque so, int itemIndex,
 	}
 }
 
+/*
+ * Save the first heap TID of a posting list tuple into
+ * so->currPos.items[itemIndex], and return the offset in tuple storage of
+ * the tuple that all of its items share.  For an index-only scan, that's a
+ * copy of the key alone, which looks just like a plain leaf tuple.
+ */
+static int
+_bt_setuppostingitems(BTScanOpaque so, int itemIndex, OffsetNumber offnum,
+					  ItemPointer heapTid, IndexTuple itup)
+{
+	BTScanPosItem *currItem = &so->currPos.items[itemIndex];
+
+	currItem->heapTid = *heapTid;
+	currItem->indexOffset = offnum;
+	if (so->currTuples)
+	{
+		Size		itupsz = BTreeTupleGetPostingOffset(itup);
+		IndexTuple	base;
+
+		currItem->tupleOffset = so->currPos.nextTupleOffset;
+		base = (IndexTuple) (so->currTuples + so->currPos.nextTupleOffset);
+		memcpy(base, itup, itupsz);
+		base->t_info &= ~(INDEX_SIZE_MASK | INDEX_ALT_TID_MASK);
+		base->t_info |= itupsz;
+		base->t_tid = *heapTid;
+		so->currPos.nextTupleOffset += MAXALIGN(itupsz);
+		return currItem->tupleOffset;
+	}
+
+	return 0;
+}
+
+/*
+ * Save another heap TID of a posting list tuple into
+ * so->currPos.items[itemIndex], sharing the tuple saved for the first one
+ * by _bt_setuppostingitems.
+ */
+static void
+_bt_savepostingitem(BTScanOpaque so, int itemIndex, OffsetNumber offnum,
+					ItemPointer heapTid, int tupleOffset)
+{
+	BTScanPosItem *currItem = &so->currPos.items[itemIndex];
+
+	currItem->heapTid = *heapTid;
+	currItem->indexOffset = offnum;
+	if (so->currTuples)
+		currItem->tupleOffset = tupleOffset;
+}
+
 /*
  *	_bt_steppage() -- Step to next page containing valid data for scan
  *
@@ -57,6 +57,11 @@ static bool _bt_check_rowcompare(ScanKey skey,
  *		as well as comparator routines appropriate to the key datatypes.
  *
  *		The result is intended for use with _bt_compare().
+ *
+ *		itup may be a pivot tuple whose trailing key attributes were removed
+ *		by suffix truncation.  Scan key entries for those attributes are
+ *		set up as NULLs; callers must not pass more than
+ *		BTreeTupleGetNAtts(itup) keys to _bt_compare() in that case.
  */
 ScanKey
 _bt_mkscankey(Relation rel, IndexTuple itup)
@@ -65,6 +70,7 @@ _bt_mkscankey(Relation rel, IndexTuple itup)
 	TupleDesc	itupdesc;
 	int			indnatts PG_USED_FOR_ASSERTS_ONLY;
 	int			indnkeyatts;
+	int			tupnatts;
 	int16	   *indoption;
 	int			i;
 
@@ -72,11 +78,11 @@ _bt_mkscankey(Relation rel, IndexTuple itup)
 	indnatts = IndexRelationGetNumberOfAttributes(rel);
 	indnkeyatts = IndexRelationGetNumberOfKeyAttributes(rel);
 	indoption = rel->rd_indoption;
+	tupnatts = BTreeTupleGetNAtts(itup, rel);
 
 	Assert(indnkeyatts > 0);
 	Assert(indnkeyatts <= indnatts);
-	Assert(BTreeTupleGetNAtts(itup, rel) == indnatts ||
-		   BTreeTupleGetNAtts(itup, rel) == indnkeyatts);
+	Assert(tupnatts > 0 && tupnatts <= indnatts);
 
 	/*
 	 * We'll execute search using scan key constructed on key columns. Non-key
@@ -96,7 +102,13 @@ _bt_mkscankey(Relation rel, IndexTuple itup)
 		 * comparison can be needed.
 		 */
 		procinfo = index_getprocinfo(rel, i + 1, BTORDER_PROC);
-		arg = index_getattr(itup, i + 1, itupdesc, &null);
+		if (i < tupnatts)
+			arg = index_getattr(itup, i + 1, itupdesc, &null);
+		else
+		{
+			arg = (Datum) 0;
+			null = true;
+		}
 		flags = (null ? SK_ISNULL : 0) | (indoption[i] << SK_BT_INDOPTION_SHIFT);
 		ScanKeyEntryInitializeWithInfo(&skey[i],
 									   flags,
@@ -668,13 +680,152 @@ _bt_restore_array_keys(IndexScanDesc scan)
 }
 
 
+/*
+ * _bt_setup_skip_scan() -- Decide whether to do a skip scan
+ *
+ * The caller may ask for a skip scan, by setting xs_want_skip, when there
+ * are scan keys on later index columns but none on the first one.  Instead
+ * of reading the whole index, a skip scan then finds each distinct value of
+ * the first column in turn ("probing" for it with a scan key like "> value"
+ * or "IS NOT NULL" on the first column alone), and searches for the matching
+ * entries with that value, as if the scan had an "=" key for it.  With that
+ * key in place the keys on the next column become required, so each search
+ * only reads the range of entries they allow.  This pays off when the first
+ * column has few distinct values.
+ *
+ * The extra key is put in front of the regular scan keys whenever
+ * _bt_preprocess_keys is called; we just set up the workspace for it here.
+ * Skip scans are not done in parallel scans, where the participants would
+ * have to agree on the current value.
+ */
+void
+_bt_setup_skip_scan(IndexScanDesc scan)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	Relation	rel = scan->indexRelation;
+	MemoryContext oldContext;
+	StrategyNumber strat;
+
+	_bt_skip_forget_value(scan);
+	so->skipScan = false;
+	so->skipProbe = false;
+
+	if (!scan->xs_want_skip || scan->parallel_scan != NULL ||
+		scan->numberOfKeys < 1 || scan->keyData[0].sk_attno == 1 ||
+		IndexRelationGetNumberOfKeyAttributes(rel) < 2)
+		return;
+
+	/* Set up the workspace, if not already done in a previous rescan */
+	if (so->skipContext == NULL)
+	{
+		so->skipContext = AllocSetContextCreate(CurrentMemoryContext,
+												"BTree skip scan",
+												ALLOCSET_SMALL_SIZES);
+		oldContext = MemoryContextSwitchTo(so->skipContext);
+
+		for (strat = 1; strat <= BTMaxStrategyNumber; strat++)
+		{
+			Oid			opr;
+
+			opr = get_opfamily_member(rel->rd_opfamily[0],
+									  rel->rd_opcintype[0],
+									  rel->rd_opcintype[0],
+									  strat);
+			if (!OidIsValid(opr))
+				elog(ERROR, "missing operator %d(%u,%u) in opfamily %u",
+					 strat, rel->rd_opcintype[0], rel->rd_opcintype[0],
+					 rel->rd_opfamily[0]);
+			fmgr_info_cxt(get_opcode(opr), &so->skipProcs[strat - 1],
+						  so->skipContext);
+		}
+
+		so->skipKeyData = (ScanKey)
+			palloc((scan->numberOfKeys + 1) * sizeof(ScanKeyData));
+
+		MemoryContextSwitchTo(oldContext);
+	}
+
+	so->skipScan = true;
+}
+
+/*
+ * _bt_skip_forget_value() -- Forget the current value of a skip scan
+ */
+void
+_bt_skip_forget_value(IndexScanDesc scan)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+
+	if (so->skipHaveValue && !so->skipIsNull &&
+		!TupleDescAttr(RelationGetDescr(scan->indexRelation), 0)->attbyval)
+		pfree(DatumGetPointer(so->skipValue));
+	so->skipHaveValue = false;
+}
+
+/*
+ * _bt_skip_keys() -- Get the input keys of a skip scan
+ *
+ * Returns the extra key on the first index column for the current state of
+ * the scan, followed by the regular input keys unless we are probing for
+ * the next value of the column.  *numberOfKeys is updated accordingly.
+ */
+static ScanKey
+_bt_skip_keys(IndexScanDesc scan, ScanKey inkeys, int *numberOfKeys)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	Relation	rel = scan->indexRelation;
+	ScanKey		skey = &so->skipKeyData[0];
+
+	if (so->skipProbe)
+	{
+		/* Without a current value we look for the first one of all */
+		if (!so->skipHaveValue)
+		{
+			*numberOfKeys = 0;
+			return so->skipKeyData;
+		}
+
+		if (so->skipIsNull)
+			ScanKeyEntryInitialize(skey, SK_ISNULL | SK_SEARCHNOTNULL, 1,
+								   InvalidStrategy, InvalidOid, InvalidOid,
+								   InvalidOid, (Datum) 0);
+		else
+			ScanKeyEntryInitializeWithInfo(skey, 0, 1,
+										   so->skipProbeStrategy,
+										   rel->rd_opcintype[0],
+										   rel->rd_indcollation[0],
+										   &so->skipProcs[so->skipProbeStrategy - 1],
+										   so->skipValue);
+		*numberOfKeys = 1;
+		return so->skipKeyData;
+	}
+
+	Assert(so->skipHaveValue);
+	if (so->skipIsNull)
+		ScanKeyEntryInitialize(skey, SK_ISNULL | SK_SEARCHNULL, 1,
+							   InvalidStrategy, InvalidOid, InvalidOid,
+							   InvalidOid, (Datum) 0);
+	else
+		ScanKeyEntryInitializeWithInfo(skey, 0, 1,
+									   BTEqualStrategyNumber,
+									   rel->rd_opcintype[0],
+									   rel->rd_indcollation[0],
+									   &so->skipProcs[BTEqualStrategyNumber - 1],
+									   so->skipValue);
+	memcpy(&so->skipKeyData[1], inkeys, *numberOfKeys * sizeof(ScanKeyData));
+	(*numberOfKeys)++;
+	return so->skipKeyData;
+}
+
 /*
  *	_bt_preprocess_keys() -- Preprocess scan keys
  *
  * The given search-type keys (in scan->keyData[] or so->arrayKeyData[])
  * are copied to so->keyData[] with possible transformation.
  * scan->numberOfKeys is the number of input keys, so->numberOfKeys gets
- * the number of output keys (possibly less, never greater).
+ * the number of output keys (possibly less, never greater).  In a skip
+ * scan, the key on the first column from _bt_skip_keys is added to the
+ * input keys.
  *
  * The output keys are marked with additional sk_flag bits beyond the
  * system-standard bits supplied by the caller.  The DESC and NULLS_FIRST
@@ -773,9 +924,6 @@ _bt_preprocess_keys(IndexScanDesc scan)
 	so->qual_ok = true;
 	so->numberOfKeys = 0;
 
-	if (numberOfKeys < 1)
-		return;					/* done if qual-less scan */
-
 	/*
 	 * Read so->arrayKeyData if array keys are present, else scan->keyData
 	 */
@@ -784,6 +932,12 @@ _bt_preprocess_keys(IndexScanDesc scan)
 	else
 		inkeys = scan->keyData;
 
+	if (so->skipScan)
+		inkeys = _bt_skip_keys(scan, inkeys, &numberOfKeys);
+
+	if (numberOfKeys < 1)
+		return;					/* done if qual-less scan */
+
 	outkeys = so->keyData;
 	cur = &inkeys[0];
 	/* we check that input keys are correctly ordered */
@@ -1813,7 +1967,13 @@ _bt_killitems(IndexScanDesc scan)
 			ItemId		iid = PageGetItemId(page, offnum);
 			IndexTuple	ituple = (IndexTuple) PageGetItem(page, iid);
 
-			if (ItemPointerEquals(&ituple->t_tid, &kitem->heapTid))
+			/*
+			 * A posting list tuple can only be marked dead as a whole, which
+			 * needs all of its heap TIDs to be dead.  We don't bother, and
+			 * leave them to VACUUM.
+			 */
+			if (!BTreeTupleIsPosting(ituple) &&
+				ItemPointerEquals(&ituple->t_tid, &kitem->heapTid))
 			{
 				/* found the item */
 				ItemIdMarkDead(iid);
@@ -2083,36 +2243,104 @@ btproperty(Oid index_oid, int attno,
 }
 
 /*
- *	_bt_nonkey_truncate() -- create tuple without non-key suffix attributes.
+ *	_bt_keep_natts() -- how many key attributes must a pivot tuple keep?
+ *
+ * Returns the number of leading key attributes that a new pivot tuple placed
+ * between lastleft and firstright needs, so that it is greater than lastleft
+ * and no greater than firstright: up to and including the first attribute
+ * whose values differ, or all of the key attributes when the keys are equal.
+ * The values are compared with the index's ordering support functions, and
+ * NULLs are equal to each other only.
+ */
+static int
+_bt_keep_natts(Relation rel, IndexTuple lastleft, IndexTuple firstright)
+{
+	int			nkeyatts = IndexRelationGetNumberOfKeyAttributes(rel);
+	TupleDesc	itupdesc = RelationGetDescr(rel);
+	int			keepnatts;
+
+	for (keepnatts = 1; keepnatts < nkeyatts; keepnatts++)
+	{
+		Datum		datum1,
+					datum2;
+		bool		isNull1,
+					isNull2;
+
+		datum1 = index_getattr(lastleft, keepnatts, itupdesc, &isNull1);
+		datum2 = index_getattr(firstright, keepnatts, itupdesc, &isNull2);
+
+		if (isNull1 != isNull2)
+			break;
+		if (!isNull1 &&
+			DatumGetInt32(FunctionCall2Coll(index_getprocinfo(rel, keepnatts,
+															  BTORDER_PROC),
+											rel->rd_indcollation[keepnatts - 1],
+											datum1, datum2)) != 0)
+			break;
+	}
+
+	return keepnatts;
+}
+
+/*
+ *	_bt_truncate() -- create pivot tuple for a leaf page split.
  *
- * Returns truncated index tuple allocated in caller's memory context, with key
- * attributes copied from caller's itup argument.  Currently, suffix truncation
- * is only performed to create pivot tuples in INCLUDE indexes, but some day it
- * could be generalized to remove suffix attributes after the first
- * distinguishing key attribute.
+ * Returns a new pivot tuple, allocated in caller's memory context, that
+ * separates lastleft, the last tuple on the left half of the split, from
+ * firstright, the first tuple on the right half.  It holds the key values
+ * of firstright, minus its non-key (INCLUDE) attributes, its posting list
+ * if it is a posting list tuple, and any trailing key attributes that are
+ * not needed to tell it apart from lastleft (suffix truncation).  Searches
+ * treat truncated attributes as "minus infinity", see _bt_compare().
  *
- * Truncated tuple is guaranteed to be no larger than the original, which is
- * important for staying under the 1/3 of a page restriction on tuple size.
+ * Truncated tuple is guaranteed to be no larger than firstright, which is
+ * important for staying under the 1/3 of a page restriction on tuple size,
+ * and for the free space accounting of _bt_findsplitloc().
  *
  * Note that returned tuple's t_tid offset will hold the number of attributes
  * present, so the original item pointer offset is not represented.  Caller
  * should only change truncated tuple's downlink.
  */
 IndexTuple
-_bt_nonkey_truncate(Relation rel, IndexTuple itup)
+_bt_truncate(Relation rel, IndexTuple lastleft, IndexTuple firstright)
 {
-	int			nkeyattrs = IndexRelationGetNumberOfKeyAttributes(rel);
+	int			natts = IndexRelationGetNumberOfAttributes(rel);
+	int			keepnatts;
+	IndexTuple	pivot;
 	IndexTuple	truncated;
 
 	/*
-	 * We should only ever truncate leaf index tuples, which must have both
-	 * key and non-key attributes.  It's never okay to truncate a second time.
+	 * We should only ever truncate leaf index tuples.  It's never okay to
+	 * truncate a second time.
 	 */
-	Assert(BTreeTupleGetNAtts(itup, rel) ==
-		   IndexRelationGetNumberOfAttributes(rel));
+	Assert(BTreeTupleGetNAtts(lastleft, rel) == natts);
+	Assert(BTreeTupleGetNAtts(firstright, rel) == natts);
+
+	keepnatts = _bt_keep_natts(rel, lastleft, firstright);
+
+	/* Strip the posting list first, leaving a plain tuple */
+	pivot = firstright;
+	if (BTreeTupleIsPosting(firstright))
+	{
+		Size		newsize = BTreeTupleGetPostingOffset(firstright);
+
+		pivot = (IndexTuple) palloc(newsize);
+		memcpy(pivot, firstright, newsize);
+		pivot->t_info &= ~(INDEX_SIZE_MASK | INDEX_ALT_TID_MASK);
+		pivot->t_info |= newsize;
+		/* keep the first heap TID, as a truncated plain tuple would */
+		pivot->t_tid = *BTreeTupleGetPosting(firstright);
+	}
+
+	if (keepnatts < natts)
+		truncated = index_truncate_tuple(RelationGetDescr(rel), pivot,
+										 keepnatts);
+	else
+		truncated = CopyIndexTuple(pivot);
+	BTreeTupleSetNAtts(truncated, keepnatts);
 
-	truncated = index_truncate_tuple(RelationGetDescr(rel), itup, nkeyattrs);
-	BTreeTupleSetNAtts(truncated, nkeyattrs);
+	if (pivot != firstright)
+		pfree(pivot);
 
 	return truncated;
 }
@@ -2175,8 +2403,12 @@ _bt_check_natts(Relation rel, Page page, OffsetNumber offnum)
 			 */
 			Assert(!P_RIGHTMOST(opaque));
 
-			/* Page high key tuple contains only key attributes */
-			return BTreeTupleGetNAtts(itup, rel) == nkeyatts;
+			/*
+			 * Page high key tuple contains only key attributes, possibly
+			 * fewer than all of them after suffix truncation
+			 */
+			return BTreeTupleGetNAtts(itup, rel) > 0 &&
+				BTreeTupleGetNAtts(itup, rel) <= nkeyatts;
 		}
 	}
 	else						/* !P_ISLEAF(opaque) */
@@ -2207,9 +2439,11 @@ _bt_check_natts(Relation rel, Page page, OffsetNumber offnum)
 		{
 			/*
 			 * Tuple contains only key attributes despite on is it page high
-			 * key or not
+			 * key or not, possibly fewer than all of them after suffix
+			 * truncation
 			 */
-			return BTreeTupleGetNAtts(itup, rel) == nkeyatts;
+			return BTreeTupleGetNAtts(itup, rel) > 0 &&
+				BTreeTupleGetNAtts(itup, rel) <= nkeyatts;
 		}
 
 	}
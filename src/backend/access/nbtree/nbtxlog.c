@@ -402,8 +402,8 @@ btree_xlog_vacuum(XLogReaderState *record)
 	Buffer		buffer;
 	Page		page;
 	BTPageOpaque opaque;
-#ifdef UNUSED
 	xl_btree_vacuum *xlrec = (xl_btree_vacuum *) XLogRecGetData(record);
+#ifdef UNUSED
 
 	/*
 	 * This section of code is thought to be no longer needed, after analysis
@@ -494,14 +494,28 @@ btree_xlog_vacuum(XLogReaderState *record)
 
 		if (len > 0)
 		{
-			OffsetNumber *unused;
-			OffsetNumber *unend;
+			OffsetNumber *deleted;
+			OffsetNumber *updatednos;
+			IndexTuple	updated;
+			int			i;
+
+			deleted = (OffsetNumber *) ptr;
+			updatednos = deleted + xlrec->ndeleted;
+			updated = (IndexTuple) (updatednos + xlrec->nupdated);
 
-			unused = (OffsetNumber *) ptr;
-			unend = (OffsetNumber *) ((char *) ptr + len);
+			/* Posting list tuples are updated first, as in the original */
+			for (i = 0; i < xlrec->nupdated; i++)
+			{
+				Size		itemsz = MAXALIGN(IndexTupleSize(updated));
+
+				if (!PageIndexTupleOverwrite(page, updatednos[i],
+											 (Item) updated, itemsz))
+					elog(PANIC, "btree_xlog_vacuum: failed to update posting list tuple");
+				updated = (IndexTuple) ((char *) updated + itemsz);
+			}
 
-			if ((unend - unused) > 0)
-				PageIndexMultiDelete(page, unused, unend - unused);
+			if (xlrec->ndeleted > 0)
+				PageIndexMultiDelete(page, deleted, xlrec->ndeleted);
 		}
 
 		/*
@@ -986,6 +1000,33 @@ btree_xlog_reuse_page(XLogReaderState *record)
 	}
 }
 
+static void
+btree_xlog_dedup(XLogReaderState *record)
+{
+	XLogRecPtr	lsn = record->EndRecPtr;
+	xl_btree_dedup *xlrec = (xl_btree_dedup *) XLogRecGetData(record);
+	Buffer		buffer;
+
+	if (XLogReadBufferForRedo(record, 0, &buffer) == BLK_NEEDS_REDO)
+	{
+		Page		page = (Page) BufferGetPage(buffer);
+		BTDedupInterval *intervals;
+		Size		len;
+		Page		newpage;
+
+		intervals = (BTDedupInterval *) XLogRecGetBlockData(record, 0, &len);
+		Assert(len == xlrec->nintervals * sizeof(BTDedupInterval));
+
+		newpage = _bt_dedup_apply(page, intervals, xlrec->nintervals);
+		PageRestoreTempPage(newpage, page);
+
+		PageSetLSN(page, lsn);
+		MarkBufferDirty(buffer);
+	}
+	if (BufferIsValid(buffer))
+		UnlockReleaseBuffer(buffer);
+}
+
 void
 btree_redo(XLogReaderState *record)
 {
@@ -1036,6 +1077,9 @@ btree_redo(XLogReaderState *record)
 		case XLOG_BTREE_META_CLEANUP:
 			_bt_restore_meta(record, 0);
 			break;
+		case XLOG_BTREE_DEDUP:
+			btree_xlog_dedup(record);
+			break;
 		default:
 			elog(PANIC, "btree_redo: unknown op code %u", info);
 	}
@@ -88,6 +88,7 @@
 #include "storage/proc.h"
 #include "storage/procarray.h"
 #include "utils/builtins.h"
+#include "utils/hsearch.h"
 #include "utils/memutils.h"
 #include "utils/snapmgr.h"
 
@@ -187,6 +188,10 @@
 static SlruCtlData MultiXactOffsetCtlData;
 static SlruCtlData MultiXactMemberCtlData;
 
+/* GUC variables: number of SLRU buffers for the two MultiXact SLRUs */
+int			multixact_offset_buffers = NUM_MXACTOFFSET_BUFFERS;
+int			multixact_member_buffers = NUM_MXACTMEMBER_BUFFERS;
+
 #define MultiXactOffsetCtl	(&MultiXactOffsetCtlData)
 #define MultiXactMemberCtl	(&MultiXactMemberCtlData)
 
@@ -309,6 +314,10 @@ static MultiXactId *OldestVisibleMXactId;
  *
  * We allocate the cache entries in a memory context that is deleted at
  * transaction end, so we don't need to do retail freeing of entries.
+ *
+ * Besides the LRU list, entries are indexed by MultiXactId in a hash table
+ * living in the same context, so that GetMultiXactIdMembers() lookups in a
+ * well-populated cache don't have to walk the whole list.
  */
 typedef struct mXactCacheEnt
 {
@@ -318,9 +327,16 @@ typedef struct mXactCacheEnt
 	MultiXactMember members[FLEXIBLE_ARRAY_MEMBER];
 } mXactCacheEnt;
 
-#define MAX_CACHE_ENTRIES	256
+typedef struct mXactCacheIdEnt
+{
+	MultiXactId multi;			/* hash key */
+	mXactCacheEnt *entry;
+} mXactCacheIdEnt;
+
+#define MAX_CACHE_ENTRIES	1024
 static dlist_head MXactCache = DLIST_STATIC_INIT(MXactCache);
 static int	MXactCacheMembers = 0;
+static HTAB *MXactCacheById = NULL;
 static MemoryContext MXactContext = NULL;
 
 #ifdef MULTIXACT_DEBUG
@@ -1514,39 +1530,33 @@ mXactCacheGetBySet(int nmembers, MultiXactMember *members)
 static int
 mXactCacheGetById(MultiXactId multi, MultiXactMember **members)
 {
-	dlist_iter	iter;
+	mXactCacheIdEnt *hentry;
+	mXactCacheEnt *entry;
+	MultiXactMember *ptr;
+	Size		size;
 
 	debug_elog3(DEBUG2, "CacheGet: looking for %u", multi);
 
-	dlist_foreach(iter, &MXactCache)
+	if (MXactCacheById != NULL &&
+		(hentry = (mXactCacheIdEnt *) hash_search(MXactCacheById, &multi,
+												  HASH_FIND, NULL)) != NULL)
 	{
-		mXactCacheEnt *entry = dlist_container(mXactCacheEnt, node, iter.cur);
+		entry = hentry->entry;
 
-		if (entry->multi == multi)
-		{
-			MultiXactMember *ptr;
-			Size		size;
+		size = sizeof(MultiXactMember) * entry->nmembers;
+		ptr = (MultiXactMember *) palloc(size);
+		*members = ptr;
 
-			size = sizeof(MultiXactMember) * entry->nmembers;
-			ptr = (MultiXactMember *) palloc(size);
-			*members = ptr;
+		memcpy(ptr, entry->members, size);
 
-			memcpy(ptr, entry->members, size);
+		debug_elog3(DEBUG2, "CacheGet: found %s",
+					mxid_to_string(multi,
+								   entry->nmembers,
+								   entry->members));
 
-			debug_elog3(DEBUG2, "CacheGet: found %s",
-						mxid_to_string(multi,
-									   entry->nmembers,
-									   entry->members));
+		dlist_move_head(&MXactCache, &entry->node);
 
-			/*
-			 * Note we modify the list while not using a modifiable iterator.
-			 * This is acceptable only because we exit the iteration
-			 * immediately afterwards.
-			 */
-			dlist_move_head(&MXactCache, iter.cur);
-
-			return entry->nmembers;
-		}
+		return entry->nmembers;
 	}
 
 	debug_elog2(DEBUG2, "CacheGet: not found");
@@ -1567,11 +1577,21 @@ mXactCachePut(MultiXactId multi, int nmembers, MultiXactMember *members)
 
 	if (MXactContext == NULL)
 	{
+		HASHCTL		hash_ctl;
+
 		/* The cache only lives as long as the current transaction */
 		debug_elog2(DEBUG2, "CachePut: initializing memory context");
 		MXactContext = AllocSetContextCreate(TopTransactionContext,
 											 "MultiXact cache context",
 											 ALLOCSET_SMALL_SIZES);
+
+		memset(&hash_ctl, 0, sizeof(hash_ctl));
+		hash_ctl.keysize = sizeof(MultiXactId);
+		hash_ctl.entrysize = sizeof(mXactCacheIdEnt);
+		hash_ctl.hcxt = MXactContext;
+		MXactCacheById = hash_create("MultiXact cache by id",
+									 MAX_CACHE_ENTRIES, &hash_ctl,
+									 HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
 	}
 
 	entry = (mXactCacheEnt *)
@@ -1587,10 +1607,13 @@ mXactCachePut(MultiXactId multi, int nmembers, MultiXactMember *members)
 	qsort(entry->members, nmembers, sizeof(MultiXactMember), mxactMemberComparator);
 
 	dlist_push_head(&MXactCache, &entry->node);
+	((mXactCacheIdEnt *) hash_search(MXactCacheById, &multi, HASH_ENTER,
+									 NULL))->entry = entry;
 	if (MXactCacheMembers++ >= MAX_CACHE_ENTRIES)
 	{
 		dlist_node *node;
 		mXactCacheEnt *entry;
+		mXactCacheIdEnt *hentry;
 
 		node = dlist_tail_node(&MXactCache);
 		dlist_delete(node);
@@ -1599,6 +1622,11 @@ mXactCachePut(MultiXactId multi, int nmembers, MultiXactMember *members)
 		entry = dlist_container(mXactCacheEnt, node, node);
 		debug_elog3(DEBUG2, "CachePut: pruning cached multi %u",
 					entry->multi);
+		/* the hash may point to a newer entry for the same multi */
+		hentry = (mXactCacheIdEnt *) hash_search(MXactCacheById, &entry->multi,
+												 HASH_FIND, NULL);
+		if (hentry != NULL && hentry->entry == entry)
+			hash_search(MXactCacheById, &entry->multi, HASH_REMOVE, NULL);
 
 		pfree(entry);
 	}
@@ -1676,6 +1704,7 @@ AtEOXact_MultiXact(void)
 	 * a child of TopTransactionContext, we needn't delete it explicitly.
 	 */
 	MXactContext = NULL;
+	MXactCacheById = NULL;
 	dlist_init(&MXactCache);
 	MXactCacheMembers = 0;
 }
@@ -1743,6 +1772,7 @@ PostPrepare_MultiXact(TransactionId xid)
 	 * Discard the local MultiXactId cache like in AtEOX_MultiXact
 	 */
 	MXactContext = NULL;
+	MXactCacheById = NULL;
 	dlist_init(&MXactCache);
 	MXactCacheMembers = 0;
 }
@@ -1810,8 +1840,10 @@ MultiXactShmemSize(void)
 			 mul_size(sizeof(MultiXactId) * 2, MaxOldestSlot))
 
 	size = SHARED_MULTIXACT_STATE_SIZE;
-	size = add_size(size, SimpleLruShmemSize(NUM_MXACTOFFSET_BUFFERS, 0));
-	size = add_size(size, SimpleLruShmemSize(NUM_MXACTMEMBER_BUFFERS, 0));
+	size = add_size(size,
+					SimpleLruShmemSize(SimpleLruAdjustBuffers(multixact_offset_buffers), 0));
+	size = add_size(size,
+					SimpleLruShmemSize(SimpleLruAdjustBuffers(multixact_member_buffers), 0));
 
 	return size;
 }
@@ -1827,11 +1859,13 @@ MultiXactShmemInit(void)
 	MultiXactMemberCtl->PagePrecedes = MultiXactMemberPagePrecedes;
 
 	SimpleLruInit(MultiXactOffsetCtl,
-				  "multixact_offset", NUM_MXACTOFFSET_BUFFERS, 0,
+				  "multixact_offset",
+				  SimpleLruAdjustBuffers(multixact_offset_buffers), 0,
 				  MultiXactOffsetControlLock, "pg_multixact/offsets",
 				  LWTRANCHE_MXACTOFFSET_BUFFERS);
 	SimpleLruInit(MultiXactMemberCtl,
-				  "multixact_member", NUM_MXACTMEMBER_BUFFERS, 0,
+				  "multixact_member",
+				  SimpleLruAdjustBuffers(multixact_member_buffers), 0,
 				  MultiXactMemberControlLock, "pg_multixact/members",
 				  LWTRANCHE_MXACTMEMBER_BUFFERS);
 
@@ -14,6 +14,8 @@
 
 #include "postgres.h"
 
+#include "access/brin_internal.h"
+#include "access/gin_private.h"
 #include "access/nbtree.h"
 #include "access/parallel.h"
 #include "access/session.h"
@@ -23,6 +25,9 @@
 #include "catalog/index.h"
 #include "catalog/namespace.h"
 #include "commands/async.h"
+#include "commands/cluster.h"
+#include "commands/copy.h"
+#include "commands/vacuum.h"
 #include "executor/execParallel.h"
 #include "libpq/libpq.h"
 #include "libpq/pqformat.h"
@@ -138,6 +143,21 @@ static const struct
 	},
 	{
 		"_bt_parallel_build_main", _bt_parallel_build_main
+	},
+	{
+		"ParallelCopyMain", ParallelCopyMain
+	},
+	{
+		"lazy_parallel_vacuum_main", lazy_parallel_vacuum_main
+	},
+	{
+		"_gin_parallel_build_main", _gin_parallel_build_main
+	},
+	{
+		"_brin_parallel_build_main", _brin_parallel_build_main
+	},
+	{
+		"cluster_parallel_main", cluster_parallel_main
 	}
 };
 
@@ -570,6 +590,9 @@ LaunchParallelWorkers(ParallelContext *pcxt)
 		}
 	}
 
+	/* Let the statistics show how often we fell short of our request. */
+	pgstat_count_parallel_workers(pcxt->nworkers, pcxt->nworkers_launched);
+
 	/*
 	 * Now that nworkers_launched has taken its final value, we can initialize
 	 * known_attached_workers.
@@ -8,10 +8,13 @@
  * traffic will occur mostly to the latest page (and to the just-prior
  * page, soon after a page transition).  Read traffic will probably touch
  * a larger span of pages, but in any case a fairly small number of page
- * buffers should be sufficient.  So, we just search the buffers using plain
- * linear search; there's no need for a hashtable or anything fancy.
- * The management algorithm is straight LRU except that we will never swap
- * out the latest page (since we know it's going to be hit again eventually).
+ * buffers should be sufficient.  Some pools can be made large by
+ * configuration, though, so the buffers are divided into banks of
+ * SLRU_BANK_SIZE slots and each page number maps to exactly one bank.  We
+ * just search the buffers of that bank using plain linear search; there's
+ * no need for a hashtable or anything fancy.  The management algorithm is
+ * straight LRU within the bank except that we will never swap out the
+ * latest page (since we know it's going to be hit again eventually).
  *
  * We use a control LWLock to protect the shared data structures, plus
  * per-buffer LWLocks that synchronize I/O for each buffer.  The control lock
@@ -109,6 +112,15 @@ typedef struct SlruFlushData *SlruFlush;
 		} \
 	} while (0)
 
+/*
+ * Macros to find the range of slots [start, end) in the bank that the given
+ * page maps to.  A page can only ever be stored in its own bank.
+ */
+#define SlruBankStart(shared, pageno) \
+	(((uint32) (pageno) % (shared)->num_banks) * (shared)->bank_size)
+#define SlruBankEnd(shared, pageno) \
+	(SlruBankStart(shared, pageno) + (shared)->bank_size)
+
 /* Saved info for SlruReportIOError */
 typedef enum
 {
@@ -141,6 +153,20 @@ static void SlruInternalDeleteSegment(SlruCtl ctl, char *filename);
  * Initialization of shared memory
  */
 
+/*
+ * Round a requested number of buffers so that it can be divided into banks.
+ *
+ * Pools no larger than one bank are used as they are; larger ones are
+ * rounded up to a multiple of SLRU_BANK_SIZE.
+ */
+int
+SimpleLruAdjustBuffers(int nslots)
+{
+	if (nslots <= SLRU_BANK_SIZE)
+		return nslots;
+	return TYPEALIGN(SLRU_BANK_SIZE, nslots);
+}
+
 Size
 SimpleLruShmemSize(int nslots, int nlsns)
 {
@@ -186,6 +212,11 @@ SimpleLruInit(SlruCtl ctl, const char *name, int nslots, int nlsns,
 		shared->ControlLock = ctllock;
 
 		shared->num_slots = nslots;
+		if (nslots % SLRU_BANK_SIZE == 0)
+			shared->num_banks = nslots / SLRU_BANK_SIZE;
+		else
+			shared->num_banks = 1;
+		shared->bank_size = nslots / shared->num_banks;
 		shared->lsn_groups_per_page = nlsns;
 
 		shared->cur_lru_count = 0;
@@ -472,8 +503,9 @@ SimpleLruReadPage_ReadOnly(SlruCtl ctl, int pageno, TransactionId xid)
 	/* Try to find the page while holding only shared lock */
 	LWLockAcquire(shared->ControlLock, LW_SHARED);
 
-	/* See if page is already in a buffer */
-	for (slotno = 0; slotno < shared->num_slots; slotno++)
+	/* See if page is already in a buffer of its bank */
+	for (slotno = SlruBankStart(shared, pageno);
+		 slotno < SlruBankEnd(shared, pageno); slotno++)
 	{
 		if (shared->page_number[slotno] == pageno &&
 			shared->page_status[slotno] != SLRU_PAGE_EMPTY &&
@@ -971,6 +1003,8 @@ SlruSelectLRUPage(SlruCtl ctl, int pageno)
 	for (;;)
 	{
 		int			slotno;
+		int			bankstart = SlruBankStart(shared, pageno);
+		int			bankend = SlruBankEnd(shared, pageno);
 		int			cur_count;
 		int			bestvalidslot = 0;	/* keep compiler quiet */
 		int			best_valid_delta = -1;
@@ -980,7 +1014,7 @@ SlruSelectLRUPage(SlruCtl ctl, int pageno)
 		int			best_invalid_page_number = 0;	/* keep compiler quiet */
 
 		/* See if page already has a buffer assigned */
-		for (slotno = 0; slotno < shared->num_slots; slotno++)
+		for (slotno = bankstart; slotno < bankend; slotno++)
 		{
 			if (shared->page_number[slotno] == pageno &&
 				shared->page_status[slotno] != SLRU_PAGE_EMPTY)
@@ -988,8 +1022,8 @@ SlruSelectLRUPage(SlruCtl ctl, int pageno)
 		}
 
 		/*
-		 * If we find any EMPTY slot, just select that one. Else choose a
-		 * victim page to replace.  We normally take the least recently used
+		 * If we find any EMPTY slot in the page's bank, just select that one.
+		 * Else choose a victim page in the bank to replace.  We normally take the least recently used
 		 * valid page, but we will never take the slot containing
 		 * latest_page_number, even if it appears least recently used.  We
 		 * will select a slot that is already I/O busy only if there is no
@@ -1015,7 +1049,7 @@ SlruSelectLRUPage(SlruCtl ctl, int pageno)
 		 * multiple pages with the same lru_count.
 		 */
 		cur_count = (shared->cur_lru_count)++;
-		for (slotno = 0; slotno < shared->num_slots; slotno++)
+		for (slotno = bankstart; slotno < bankend; slotno++)
 		{
 			int			this_delta;
 			int			this_page_number;
@@ -31,6 +31,7 @@
 #include "access/slru.h"
 #include "access/subtrans.h"
 #include "access/transam.h"
+#include "access/xlog.h"
 #include "pg_trace.h"
 #include "utils/snapmgr.h"
 
@@ -60,6 +61,24 @@
  */
 static SlruCtlData SubTransCtlData;
 
+/* GUC variable: number of SLRU buffers for SUBTRANS */
+int			subtrans_buffers = NUM_SUBTRANS_BUFFERS;
+
+/*
+ * Single-item cache for the result of the last SubTransGetTopmostTransaction
+ * call.  Once a subtransaction's XID has been assigned, its parent never
+ * changes, so the cached answer stays valid.  Scans of tuples written by one
+ * subtransaction ask the same question over and over when snapshots have
+ * overflowed, and this saves a pg_subtrans lookup for each of them.
+ *
+ * We only fill the cache when a parent was actually found, since an xid with
+ * no pg_subtrans entry yet may still get one, and never during recovery,
+ * where the parent links of a standby's known-assigned xids are set by
+ * XLOG_XACT_ASSIGNMENT replay at some unpredictable later point.
+ */
+static TransactionId cachedSubXid = InvalidTransactionId;
+static TransactionId cachedTopmostXid = InvalidTransactionId;
+
 #define SubTransCtl  (&SubTransCtlData)
 
 
@@ -145,6 +164,9 @@ SubTransGetParent(TransactionId xid)
  * we only care about detecting whether the topmost parent is still running
  * or is part of a current snapshot's list of still-running transactions.
  * Therefore, any XID before TransactionXmin is as good as any other.
+ * For the same reason it is fine to return a cached answer that was computed
+ * when TransactionXmin was older, and so may be closer to the true topmost
+ * parent than what a fresh lookup would return.
  */
 TransactionId
 SubTransGetTopmostTransaction(TransactionId xid)
@@ -155,6 +177,9 @@ SubTransGetTopmostTransaction(TransactionId xid)
 	/* Can't ask about stuff that might not be around anymore */
 	Assert(TransactionIdFollowsOrEquals(xid, TransactionXmin));
 
+	if (TransactionIdEquals(xid, cachedSubXid))
+		return cachedTopmostXid;
+
 	while (TransactionIdIsValid(parentXid))
 	{
 		previousXid = parentXid;
@@ -174,6 +199,12 @@ SubTransGetTopmostTransaction(TransactionId xid)
 
 	Assert(TransactionIdIsValid(previousXid));
 
+	if (!TransactionIdEquals(previousXid, xid) && !RecoveryInProgress())
+	{
+		cachedSubXid = xid;
+		cachedTopmostXid = previousXid;
+	}
+
 	return previousXid;
 }
 
@@ -184,14 +215,15 @@ SubTransGetTopmostTransaction(TransactionId xid)
 Size
 SUBTRANSShmemSize(void)
 {
-	return SimpleLruShmemSize(NUM_SUBTRANS_BUFFERS, 0);
+	return SimpleLruShmemSize(SimpleLruAdjustBuffers(subtrans_buffers), 0);
 }
 
 void
 SUBTRANSShmemInit(void)
 {
 	SubTransCtl->PagePrecedes = SubTransPagePrecedes;
-	SimpleLruInit(SubTransCtl, "subtrans", NUM_SUBTRANS_BUFFERS, 0,
+	SimpleLruInit(SubTransCtl, "subtrans",
+				  SimpleLruAdjustBuffers(subtrans_buffers), 0,
 				  SubtransControlLock, "pg_subtrans",
 				  LWTRANCHE_SUBTRANS_BUFFERS);
 	/* Override default assumption that writes should be fsync'd */
@@ -77,6 +77,7 @@
 #include <unistd.h>
 
 #include "access/commit_ts.h"
+#include "access/hash.h"
 #include "access/htup_details.h"
 #include "access/subtrans.h"
 #include "access/transam.h"
@@ -149,6 +150,8 @@ int			max_prepared_xacts = 0;
 typedef struct GlobalTransactionData
 {
 	GlobalTransaction next;		/* list link for free list */
+	GlobalTransaction gidnext;	/* next entry in same GID hash bucket */
+	int			arrayindex;		/* index in TwoPhaseState->prepXacts */
 	int			pgprocno;		/* ID of associated dummy PGPROC */
 	BackendId	dummyBackendId; /* similar to backend id for backends */
 	TimestampTz prepared_at;	/* time of preparation */
@@ -184,6 +187,15 @@ typedef struct TwoPhaseStateData
 	/* Number of valid prepXacts entries. */
 	int			numPrepXacts;
 
+	/*
+	 * Hash table of the prepXacts entries by GID, so that PREPARE and COMMIT
+	 * PREPARED needn't scan the whole array while holding TwoPhaseStateLock.
+	 * Each bucket is a list linked through gidnext.  The number of buckets
+	 * is a power of 2.
+	 */
+	GlobalTransaction *gidBuckets;
+	int			numGidBuckets;
+
 	/* There are max_prepared_xacts items in this array */
 	GlobalTransaction prepXacts[FLEXIBLE_ARRAY_MEMBER];
 } TwoPhaseStateData;
@@ -217,6 +229,7 @@ static void RecordTransactionAbortPrepared(TransactionId xid,
 							   const char *gid);
 static void ProcessRecords(char *bufptr, TransactionId xid,
 			   const TwoPhaseCallback callbacks[]);
+static void AddGXact(GlobalTransaction gxact);
 static void RemoveGXact(GlobalTransaction gxact);
 
 static void XlogReadTwoPhaseData(XLogRecPtr lsn, char **buf, int *len);
@@ -229,6 +242,25 @@ static void MarkAsPreparingGuts(GlobalTransaction gxact, TransactionId xid,
 static void RemoveTwoPhaseFile(TransactionId xid, bool giveWarning);
 static void RecreateTwoPhaseFile(TransactionId xid, void *content, int len);
 
+/*
+ * Number of buckets in the GID hash table
+ */
+static int
+TwoPhaseNumGidBuckets(void)
+{
+	int			nbuckets = 1;
+
+	while (nbuckets < max_prepared_xacts)
+		nbuckets <<= 1;
+
+	return nbuckets;
+}
+
+#define GidBucket(gid) \
+	(&TwoPhaseState->gidBuckets[hash_any((const unsigned char *) (gid), \
+										 strlen(gid)) & \
+								(TwoPhaseState->numGidBuckets - 1)])
+
 /*
  * Initialization of shared memory
  */
@@ -237,13 +269,18 @@ TwoPhaseShmemSize(void)
 {
 	Size		size;
 
-	/* Need the fixed struct, the array of pointers, and the GTD structs */
+	/*
+	 * Need the fixed struct, the array of pointers, the GTD structs, and the
+	 * GID hash buckets
+	 */
 	size = offsetof(TwoPhaseStateData, prepXacts);
 	size = add_size(size, mul_size(max_prepared_xacts,
 								   sizeof(GlobalTransaction)));
 	size = MAXALIGN(size);
 	size = add_size(size, mul_size(max_prepared_xacts,
 								   sizeof(GlobalTransactionData)));
+	size = add_size(size, mul_size(TwoPhaseNumGidBuckets(),
+								   sizeof(GlobalTransaction)));
 
 	return size;
 }
@@ -272,6 +309,13 @@ TwoPhaseShmemInit(void)
 			((char *) TwoPhaseState +
 			 MAXALIGN(offsetof(TwoPhaseStateData, prepXacts) +
 					  sizeof(GlobalTransaction) * max_prepared_xacts));
+
+		/* The GID hash buckets follow the GTD structs, all empty */
+		TwoPhaseState->numGidBuckets = TwoPhaseNumGidBuckets();
+		TwoPhaseState->gidBuckets = (GlobalTransaction *)
+			(gxacts + max_prepared_xacts);
+		for (i = 0; i < TwoPhaseState->numGidBuckets; i++)
+			TwoPhaseState->gidBuckets[i] = NULL;
 		for (i = 0; i < max_prepared_xacts; i++)
 		{
 			/* insert into linked list */
@@ -373,7 +417,6 @@ MarkAsPreparing(TransactionId xid, const char *gid,
 				TimestampTz prepared_at, Oid owner, Oid databaseid)
 {
 	GlobalTransaction gxact;
-	int			i;
 
 	if (strlen(gid) >= GIDSIZE)
 		ereport(ERROR,
@@ -398,9 +441,8 @@ MarkAsPreparing(TransactionId xid, const char *gid,
 	LWLockAcquire(TwoPhaseStateLock, LW_EXCLUSIVE);
 
 	/* Check for conflicting GID */
-	for (i = 0; i < TwoPhaseState->numPrepXacts; i++)
+	for (gxact = *GidBucket(gid); gxact != NULL; gxact = gxact->gidnext)
 	{
-		gxact = TwoPhaseState->prepXacts[i];
 		if (strcmp(gxact->gid, gid) == 0)
 		{
 			ereport(ERROR,
@@ -425,8 +467,7 @@ MarkAsPreparing(TransactionId xid, const char *gid,
 	gxact->ondisk = false;
 
 	/* And insert it into the active array */
-	Assert(TwoPhaseState->numPrepXacts < max_prepared_xacts);
-	TwoPhaseState->prepXacts[TwoPhaseState->numPrepXacts++] = gxact;
+	AddGXact(gxact);
 
 	LWLockRelease(TwoPhaseStateLock);
 
@@ -448,6 +489,8 @@ MarkAsPreparingGuts(GlobalTransaction gxact, TransactionId xid, const char *gid,
 {
 	PGPROC	   *proc;
 	PGXACT	   *pgxact;
+	uint64	   *fpLockBits;
+	Oid		   *fpRelId;
 	int			i;
 
 	Assert(LWLockHeldByMeInMode(TwoPhaseStateLock, LW_EXCLUSIVE));
@@ -456,8 +499,16 @@ MarkAsPreparingGuts(GlobalTransaction gxact, TransactionId xid, const char *gid,
 	proc = &ProcGlobal->allProcs[gxact->pgprocno];
 	pgxact = &ProcGlobal->allPgXact[gxact->pgprocno];
 
-	/* Initialize the PGPROC entry */
+	/*
+	 * Initialize the PGPROC entry, keeping the pointers to its fast-path lock
+	 * arrays, which are set up once by InitProcGlobal.  A prepared
+	 * transaction never has any fast-path lock slots in use.
+	 */
+	fpLockBits = proc->fpLockBits;
+	fpRelId = proc->fpRelId;
 	MemSet(proc, 0, sizeof(PGPROC));
+	proc->fpLockBits = fpLockBits;
+	proc->fpRelId = fpRelId;
 	proc->pgprocno = gxact->pgprocno;
 	SHMQueueElemInit(&(proc->links));
 	proc->waitStatus = STATUS_OK;
@@ -472,6 +523,7 @@ MarkAsPreparingGuts(GlobalTransaction gxact, TransactionId xid, const char *gid,
 	proc->databaseId = databaseid;
 	proc->roleId = owner;
 	proc->tempNamespaceId = InvalidOid;
+	proc->xminDatabaseId = InvalidOid;
 	proc->isBackgroundWorker = false;
 	proc->lwWaiting = false;
 	proc->lwWaitMode = 0;
@@ -557,7 +609,7 @@ MarkAsPrepared(GlobalTransaction gxact, bool lock_held)
 static GlobalTransaction
 LockGXact(const char *gid, Oid user)
 {
-	int			i;
+	GlobalTransaction gxact;
 
 	/* on first call, register the exit hook */
 	if (!twophaseExitRegistered)
@@ -568,9 +620,8 @@ LockGXact(const char *gid, Oid user)
 
 	LWLockAcquire(TwoPhaseStateLock, LW_EXCLUSIVE);
 
-	for (i = 0; i < TwoPhaseState->numPrepXacts; i++)
+	for (gxact = *GidBucket(gid); gxact != NULL; gxact = gxact->gidnext)
 	{
-		GlobalTransaction gxact = TwoPhaseState->prepXacts[i];
 		PGPROC	   *proc = &ProcGlobal->allProcs[gxact->pgprocno];
 
 		/* Ignore not-yet-valid GIDs */
@@ -624,6 +675,26 @@ LockGXact(const char *gid, Oid user)
 	return NULL;
 }
 
+/*
+ * AddGXact
+ *		Add the prepared transaction to the shared memory array, and to the
+ *		GID hash table.  Its gid must already be set.
+ */
+static void
+AddGXact(GlobalTransaction gxact)
+{
+	GlobalTransaction *bucket = GidBucket(gxact->gid);
+
+	Assert(LWLockHeldByMeInMode(TwoPhaseStateLock, LW_EXCLUSIVE));
+	Assert(TwoPhaseState->numPrepXacts < max_prepared_xacts);
+
+	gxact->arrayindex = TwoPhaseState->numPrepXacts;
+	TwoPhaseState->prepXacts[TwoPhaseState->numPrepXacts++] = gxact;
+
+	gxact->gidnext = *bucket;
+	*bucket = gxact;
+}
+
 /*
  * RemoveGXact
  *		Remove the prepared transaction from the shared memory array.
@@ -633,27 +704,33 @@ LockGXact(const char *gid, Oid user)
 static void
 RemoveGXact(GlobalTransaction gxact)
 {
-	int			i;
+	int			i = gxact->arrayindex;
+	GlobalTransaction *link;
 
 	Assert(LWLockHeldByMeInMode(TwoPhaseStateLock, LW_EXCLUSIVE));
 
-	for (i = 0; i < TwoPhaseState->numPrepXacts; i++)
-	{
-		if (gxact == TwoPhaseState->prepXacts[i])
-		{
-			/* remove from the active array */
-			TwoPhaseState->numPrepXacts--;
-			TwoPhaseState->prepXacts[i] = TwoPhaseState->prepXacts[TwoPhaseState->numPrepXacts];
+	if (i < 0 || i >= TwoPhaseState->numPrepXacts ||
+		TwoPhaseState->prepXacts[i] != gxact)
+		elog(ERROR, "failed to find %p in GlobalTransaction array", gxact);
 
-			/* and put it back in the freelist */
-			gxact->next = TwoPhaseState->freeGXacts;
-			TwoPhaseState->freeGXacts = gxact;
+	/* remove from the active array */
+	TwoPhaseState->numPrepXacts--;
+	TwoPhaseState->prepXacts[i] = TwoPhaseState->prepXacts[TwoPhaseState->numPrepXacts];
+	TwoPhaseState->prepXacts[i]->arrayindex = i;
 
-			return;
-		}
+	/* unlink it from its GID hash bucket */
+	link = GidBucket(gxact->gid);
+	while (*link != gxact)
+	{
+		if (*link == NULL)
+			elog(ERROR, "failed to find %p in GlobalTransaction hash", gxact);
+		link = &(*link)->gidnext;
 	}
+	*link = gxact->gidnext;
 
-	elog(ERROR, "failed to find %p in GlobalTransaction array", gxact);
+	/* and put it back in the freelist */
+	gxact->next = TwoPhaseState->freeGXacts;
+	TwoPhaseState->freeGXacts = gxact;
 }
 
 /*
@@ -2433,8 +2510,7 @@ PrepareRedoAdd(char *buf, XLogRecPtr start_lsn,
 	strcpy(gxact->gid, gid);
 
 	/* And insert it into the active array */
-	Assert(TwoPhaseState->numPrepXacts < max_prepared_xacts);
-	TwoPhaseState->prepXacts[TwoPhaseState->numPrepXacts++] = gxact;
+	AddGXact(gxact);
 
 	if (origin_id != InvalidRepOriginId)
 	{
@@ -188,6 +188,8 @@ typedef struct TransactionStateData
 	bool		prevXactReadOnly;	/* entry-time xact r/o state */
 	bool		startedInRecovery;	/* did we start in recovery? */
 	bool		didLogXid;		/* has xid been included in WAL record? */
+	bool		topXidLogged;	/* has top-level xid been logged along with
+								 * this subxact's xid? */
 	int			parallelModeLevel;	/* Enter/ExitParallelMode counter */
 	struct TransactionStateData *parent;	/* back link to parent */
 } TransactionStateData;
@@ -430,6 +432,44 @@ MarkCurrentTransactionIdLoggedIfAny(void)
 		CurrentTransactionState->didLogXid = true;
 }
 
+/*
+ *	IsSubTransactionAssignmentPending
+ *
+ * With wal_level = logical, the first WAL record written by a subtransaction
+ * with an xid also carries the xid of its top-level transaction, so that
+ * logical decoding learns about the relationship before the transaction ends
+ * and can stream the transaction while it's still in progress.  Returns true
+ * if the record about to be written needs to.
+ */
+bool
+IsSubTransactionAssignmentPending(void)
+{
+	if (!XLogLogicalInfoActive())
+		return false;
+
+	if (!IsSubTransaction())
+		return false;
+
+	if (!TransactionIdIsValid(CurrentTransactionState->transactionId))
+		return false;
+
+	return !CurrentTransactionState->topXidLogged;
+}
+
+/*
+ *	MarkSubTransactionAssigned
+ *
+ * Remember that the top-level xid has been logged along with the current
+ * subtransaction's xid.
+ */
+void
+MarkSubTransactionAssigned(void)
+{
+	Assert(IsSubTransactionAssignmentPending());
+
+	CurrentTransactionState->topXidLogged = true;
+}
+
 
 /*
  *	GetStableLatestTransactionId
@@ -34,16 +34,19 @@
 #include "access/xact.h"
 #include "access/xlog_internal.h"
 #include "access/xloginsert.h"
+#include "access/xlogprefetch.h"
 #include "access/xlogreader.h"
 #include "access/xlogutils.h"
 #include "catalog/catversion.h"
 #include "catalog/pg_control.h"
 #include "catalog/pg_database.h"
 #include "commands/tablespace.h"
+#include "executor/instrument.h"
 #include "miscadmin.h"
 #include "pgstat.h"
 #include "port/atomics.h"
 #include "postmaster/bgwriter.h"
+#include "postmaster/pgarch.h"
 #include "postmaster/walwriter.h"
 #include "postmaster/startup.h"
 #include "replication/basebackup.h"
@@ -54,6 +57,7 @@
 #include "replication/walreceiver.h"
 #include "replication/walsender.h"
 #include "storage/bufmgr.h"
+#include "storage/doublewrite.h"
 #include "storage/fd.h"
 #include "storage/ipc.h"
 #include "storage/large_object.h"
@@ -91,7 +95,7 @@ char	   *XLogArchiveCommand = NULL;
 bool		EnableHotStandby = false;
 bool		fullPageWrites = true;
 bool		wal_log_hints = false;
-bool		wal_compression = false;
+int			wal_compression = WAL_COMPRESSION_NONE;
 char	   *wal_consistency_checking_string = NULL;
 bool	   *wal_consistency_checking = NULL;
 bool		log_checkpoints = false;
@@ -262,6 +266,7 @@ static char *master_image_masked = NULL;
 
 /* options formerly taken from recovery.conf for archive recovery */
 char	   *recoveryRestoreCommand = NULL;
+int			recoveryRestorePrefetchSegments = 0;
 char	   *recoveryEndCommand = NULL;
 char	   *archiveCleanupCommand = NULL;
 RecoveryTargetType recoveryTarget = RECOVERY_TARGET_UNSET;
@@ -610,6 +615,22 @@ typedef struct XLogCtlData
 	 */
 	XLogwrtResult LogwrtResult;
 
+	/*
+	 * Group flushing.  A backend about to wait for WALWriteLock in
+	 * XLogFlush() first advances groupFlushRqst to the position up to which
+	 * it has seen all insertions finish, so that whichever backend gets the
+	 * lock next flushes on behalf of everyone queued behind it.  Since the
+	 * insertions are known to be finished, the flushing backend can write
+	 * them without calling WaitXLogInsertionsToFinish() under the lock.
+	 *
+	 * groupFlushes counts the flushes done by XLogFlush(), and
+	 * groupFollowers the XLogFlush() calls that were satisfied by another
+	 * backend's flush after waiting for it.
+	 */
+	pg_atomic_uint64 groupFlushRqst;
+	pg_atomic_uint64 groupFlushes;
+	pg_atomic_uint64 groupFollowers;
+
 	/*
 	 * Latest initialized page in the cache (last byte position + 1).
 	 *
@@ -931,6 +952,7 @@ static void ReserveXLogInsertLocation(int size, XLogRecPtr *StartPos,
 static bool ReserveXLogSwitch(XLogRecPtr *StartPos, XLogRecPtr *EndPos,
 				  XLogRecPtr *PrevPtr);
 static XLogRecPtr WaitXLogInsertionsToFinish(XLogRecPtr upto);
+static void XLogGroupFlushRequest(XLogRecPtr upto);
 static char *GetXLogBuffer(XLogRecPtr ptr);
 static XLogRecPtr XLogBytePosToRecPtr(uint64 bytepos);
 static XLogRecPtr XLogBytePosToEndRecPtr(uint64 bytepos);
@@ -957,6 +979,9 @@ static void WALInsertLockUpdateInsertingAt(XLogRecPtr insertingAt);
  * 'flags' gives more in-depth control on the record being inserted. See
  * XLogSetRecordFlags() for details.
  *
+ * 'num_fpi' is the number of full-page images included in the record; it is
+ * only used to account for WAL volume in pgWalUsage.
+ *
  * The first XLogRecData in the chain must be for the record header, and its
  * data must be MAXALIGNed.  XLogInsertRecord fills in the xl_prev and
  * xl_crc fields in the header, the rest of the header must already be filled
@@ -971,7 +996,8 @@ static void WALInsertLockUpdateInsertingAt(XLogRecPtr insertingAt);
 XLogRecPtr
 XLogInsertRecord(XLogRecData *rdata,
 				 XLogRecPtr fpw_lsn,
-				 uint8 flags)
+				 uint8 flags,
+				 int num_fpi)
 {
 	XLogCtlInsert *Insert = &XLogCtl->Insert;
 	pg_crc32c	rdata_crc;
@@ -1226,6 +1252,14 @@ XLogInsertRecord(XLogRecData *rdata,
 	ProcLastRecPtr = StartPos;
 	XactLastRecEnd = EndPos;
 
+	/* Report WAL traffic to the instrumentation */
+	if (inserted)
+	{
+		pgWalUsage.wal_bytes += rechdr->xl_tot_len;
+		pgWalUsage.wal_records++;
+		pgWalUsage.wal_fpi += num_fpi;
+	}
+
 	return EndPos;
 }
 
@@ -2793,6 +2827,24 @@ UpdateMinRecoveryPoint(XLogRecPtr lsn, bool force)
 	LWLockRelease(ControlFileLock);
 }
 
+/*
+ * Advance XLogCtl->groupFlushRqst to "upto", if it's not there already.
+ *
+ * All insertions up to "upto" must have finished.
+ */
+static void
+XLogGroupFlushRequest(XLogRecPtr upto)
+{
+	uint64		cur = pg_atomic_read_u64(&XLogCtl->groupFlushRqst);
+
+	while (cur < upto)
+	{
+		if (pg_atomic_compare_exchange_u64(&XLogCtl->groupFlushRqst,
+										   &cur, upto))
+			break;
+	}
+}
+
 /*
  * Ensure that all XLOG data through the given position is flushed to disk.
  *
@@ -2804,6 +2856,7 @@ XLogFlush(XLogRecPtr record)
 {
 	XLogRecPtr	WriteRqstPtr;
 	XLogwrtRqst WriteRqst;
+	bool		waited = false;
 
 	/*
 	 * During REDO, we are reading not writing WAL.  Therefore, instead of
@@ -2860,7 +2913,11 @@ XLogFlush(XLogRecPtr record)
 
 		/* done already? */
 		if (record <= LogwrtResult.Flush)
+		{
+			if (waited)
+				pg_atomic_fetch_add_u64(&XLogCtl->groupFollowers, 1);
 			break;
+		}
 
 		/*
 		 * Before actually performing the write, wait for all in-flight
@@ -2868,6 +2925,9 @@ XLogFlush(XLogRecPtr record)
 		 */
 		insertpos = WaitXLogInsertionsToFinish(WriteRqstPtr);
 
+		/* Ask whoever flushes next to include our insertions */
+		XLogGroupFlushRequest(insertpos);
+
 		/*
 		 * Try to get the write lock. If we can't get it immediately, wait
 		 * until it's released, and recheck if we still need to do the flush
@@ -2882,6 +2942,7 @@ XLogFlush(XLogRecPtr record)
 			 * do, loop back to check if someone else flushed the record for
 			 * us already.
 			 */
+			waited = true;
 			continue;
 		}
 
@@ -2890,6 +2951,8 @@ XLogFlush(XLogRecPtr record)
 		if (record <= LogwrtResult.Flush)
 		{
 			LWLockRelease(WALWriteLock);
+			if (waited)
+				pg_atomic_fetch_add_u64(&XLogCtl->groupFollowers, 1);
 			break;
 		}
 
@@ -2920,6 +2983,13 @@ XLogFlush(XLogRecPtr record)
 			insertpos = WaitXLogInsertionsToFinish(insertpos);
 		}
 
+		/*
+		 * Include the insertions of everyone waiting for us.  We needn't
+		 * wait for them; see comments for XLogCtlData.groupFlushRqst.
+		 */
+		insertpos = Max(insertpos,
+						pg_atomic_read_u64(&XLogCtl->groupFlushRqst));
+
 		/* try to write/flush later additions to XLOG as well */
 		WriteRqst.Write = insertpos;
 		WriteRqst.Flush = insertpos;
@@ -2927,6 +2997,7 @@ XLogFlush(XLogRecPtr record)
 		XLogWrite(WriteRqst, false);
 
 		LWLockRelease(WALWriteLock);
+		pg_atomic_fetch_add_u64(&XLogCtl->groupFlushes, 1);
 		/* done */
 		break;
 	}
@@ -5087,6 +5158,10 @@ XLOGShmemInit(void)
 	SpinLockInit(&XLogCtl->info_lck);
 	SpinLockInit(&XLogCtl->ulsn_lck);
 	InitSharedLatch(&XLogCtl->recoveryWakeupLatch);
+
+	pg_atomic_init_u64(&XLogCtl->groupFlushRqst, InvalidXLogRecPtr);
+	pg_atomic_init_u64(&XLogCtl->groupFlushes, 0);
+	pg_atomic_init_u64(&XLogCtl->groupFollowers, 0);
 }
 
 /*
@@ -5471,6 +5546,9 @@ exitArchiveRecovery(TimeLineID endTLI, XLogRecPtr endOfLog)
 	 */
 	InArchiveRecovery = false;
 
+	/* Nothing more will be restored from the archive */
+	RestorePrefetchShutdown();
+
 	/*
 	 * Update min recovery point one last time.
 	 */
@@ -6728,6 +6806,12 @@ StartupXLOG(void)
 		InRecovery = true;
 	}
 
+	/*
+	 * Repair any torn pages from the double-write files before redo looks at
+	 * them, and start a fresh file.
+	 */
+	DoubleWriteStartup(InRecovery);
+
 	/* REDO */
 	if (InRecovery)
 	{
@@ -7012,6 +7096,7 @@ StartupXLOG(void)
 		{
 			ErrorContextCallback errcallback;
 			TimestampTz xtime;
+			XLogPrefetcher *prefetcher;
 
 			InRedo = true;
 
@@ -7019,6 +7104,8 @@ StartupXLOG(void)
 					(errmsg("redo starts at %X/%X",
 							(uint32) (ReadRecPtr >> 32), (uint32) ReadRecPtr)));
 
+			prefetcher = XLogPrefetcherAllocate();
+
 			/*
 			 * main redo apply loop
 			 */
@@ -7048,6 +7135,9 @@ StartupXLOG(void)
 				/* Handle interrupt signals of startup process */
 				HandleStartupProcInterrupts();
 
+				/* Get the blocks of upcoming records on their way */
+				XLogPrefetcherReadAhead(prefetcher, ReadRecPtr, curFileTLI);
+
 				/*
 				 * Pause WAL replay, if requested by a hot-standby session via
 				 * SetRecoveryPause().
@@ -7246,6 +7336,8 @@ StartupXLOG(void)
 			 * end of main redo apply loop
 			 */
 
+			XLogPrefetcherFree(prefetcher);
+
 			if (reachedStopPoint)
 			{
 				if (!reachedConsistency)
@@ -7305,6 +7397,14 @@ StartupXLOG(void)
 					(errmsg("redo is not required")));
 		}
 	}
+	else
+	{
+		/*
+		 * No recovery was needed, so the table and function stats saved at
+		 * the last shutdown are still valid.
+		 */
+		pgstat_restore_object_stats();
+	}
 
 	/*
 	 * Kill WAL receiver, if it's still running, before we continue to write
@@ -8232,6 +8332,18 @@ GetFlushRecPtr(void)
 	return LogwrtResult.Flush;
 }
 
+/*
+ * GetXLogGroupFlushStats -- Returns the number of WAL flushes done by
+ * XLogFlush(), and the number of XLogFlush() calls that were satisfied by
+ * waiting for another backend's flush.
+ */
+void
+GetXLogGroupFlushStats(uint64 *flushes, uint64 *followers)
+{
+	*flushes = pg_atomic_read_u64(&XLogCtl->groupFlushes);
+	*followers = pg_atomic_read_u64(&XLogCtl->groupFollowers);
+}
+
 /*
  * GetLastImportantRecPtr -- Returns the LSN of the last important record
  * inserted. All records not explicitly marked as unimportant are considered
@@ -8358,7 +8470,8 @@ ShutdownXLOG(int code, Datum arg)
 		 * process one more time at the end of shutdown). The checkpoint
 		 * record will go to the next XLOG file and won't be archived (yet).
 		 */
-		if (XLogArchivingActive() && XLogArchiveCommandSet())
+		if (XLogArchivingActive() &&
+			(XLogArchiveCommandSet() || archive_file_hook != NULL))
 			RequestXLogSwitch(false);
 
 		CreateCheckPoint(CHECKPOINT_IS_SHUTDOWN | CHECKPOINT_IMMEDIATE);
@@ -9506,6 +9619,9 @@ XLogReportParameters(void)
  * Update full_page_writes in shared memory, and write an
  * XLOG_FPW_CHANGE record if necessary.
  *
+ * double_write protects against torn pages by itself, so full-page images
+ * are then taken only while a backup is in progress.
+ *
  * Note: this function assumes there is no other process running
  * concurrently that could update it.
  */
@@ -9514,6 +9630,7 @@ UpdateFullPageWrites(void)
 {
 	XLogCtlInsert *Insert = &XLogCtl->Insert;
 	bool		recoveryInProgress;
+	bool		fullPageWritesNeeded = fullPageWrites && !double_write;
 
 	/*
 	 * Do nothing if full_page_writes has not been changed.
@@ -9522,7 +9639,7 @@ UpdateFullPageWrites(void)
 	 * because we assume that there is no concurrently running process which
 	 * can update it.
 	 */
-	if (fullPageWrites == Insert->fullPageWrites)
+	if (fullPageWritesNeeded == Insert->fullPageWrites)
 		return;
 
 	/*
@@ -9541,7 +9658,7 @@ UpdateFullPageWrites(void)
 	 * setting it to false, first write the WAL record and then set the global
 	 * flag.
 	 */
-	if (fullPageWrites)
+	if (fullPageWritesNeeded)
 	{
 		WALInsertLockAcquireExclusive();
 		Insert->fullPageWrites = true;
@@ -9555,12 +9672,12 @@ UpdateFullPageWrites(void)
 	if (XLogStandbyInfoActive() && !recoveryInProgress)
 	{
 		XLogBeginInsert();
-		XLogRegisterData((char *) (&fullPageWrites), sizeof(bool));
+		XLogRegisterData((char *) (&fullPageWritesNeeded), sizeof(bool));
 
 		XLogInsert(RM_XLOG_ID, XLOG_FPW_CHANGE);
 	}
 
-	if (!fullPageWrites)
+	if (!fullPageWritesNeeded)
 	{
 		WALInsertLockAcquireExclusive();
 		Insert->fullPageWrites = false;
@@ -29,6 +29,42 @@
 #include "storage/lwlock.h"
 #include "storage/pmsignal.h"
 
+/*
+ * Directory that restore_command fetches segments into ahead of time, when
+ * restore_prefetch_segments is set.
+ */
+#define RESTORE_PREFETCH_DIR	XLOGDIR "/restore_prefetch"
+
+/* Upper limit of restore_prefetch_segments, also in guc.c */
+#define MAX_RESTORE_PREFETCH	64
+
+typedef enum
+{
+	PREFETCH_RUNNING,			/* restore_command still running */
+	PREFETCH_FINISHED			/* exited, with the given status */
+} RestorePrefetchState;
+
+typedef struct RestorePrefetchSlot
+{
+	char		xlogfname[MAXFNAMELEN];
+	TimeLineID	tli;
+	XLogSegNo	segno;
+	RestorePrefetchState state;
+	pid_t		pid;
+	int			status;			/* exit status, if finished */
+} RestorePrefetchSlot;
+
+static RestorePrefetchSlot prefetchSlots[MAX_RESTORE_PREFETCH];
+static int	numPrefetchSlots = 0;
+static bool prefetchDirReady = false;
+
+static void BuildRestoreCommand(char *cmd, const char *xlogpath,
+					const char *xlogfname, const char *lastRestartPointFname);
+static bool RestorePrefetchedFile(const char *xlogfname, const char *xlogpath,
+					  off_t expectedSize);
+static void StartRestorePrefetch(const char *xlogfname,
+					 const char *lastRestartPointFname);
+
 /*
  * Attempt to retrieve the specified file from off-line archival storage.
  * If successful, fill "path" with its complete path (note that this will be
@@ -55,9 +91,6 @@ RestoreArchivedFile(char *path, const char *xlogfname,
 	char		xlogpath[MAXPGPATH];
 	char		xlogRestoreCmd[MAXPGPATH];
 	char		lastRestartPointFname[MAXPGPATH];
-	char	   *dp;
-	char	   *endp;
-	const char *sp;
 	int			rc;
 	struct stat stat_buf;
 	XLogSegNo	restartSegNo;
@@ -143,57 +176,24 @@ RestoreArchivedFile(char *path, const char *xlogfname,
 		XLogFileName(lastRestartPointFname, 0, 0L, wal_segment_size);
 
 	/*
-	 * construct the command to be executed
+	 * If restore_command already fetched the file in the background, use
+	 * that copy, and keep the following segments coming.
 	 */
-	dp = xlogRestoreCmd;
-	endp = xlogRestoreCmd + MAXPGPATH - 1;
-	*endp = '\0';
-
-	for (sp = recoveryRestoreCommand; *sp; sp++)
+	if (RestorePrefetchedFile(xlogfname, xlogpath, expectedSize))
 	{
-		if (*sp == '%')
-		{
-			switch (sp[1])
-			{
-				case 'p':
-					/* %p: relative path of target file */
-					sp++;
-					StrNCpy(dp, xlogpath, endp - dp);
-					make_native_path(dp);
-					dp += strlen(dp);
-					break;
-				case 'f':
-					/* %f: filename of desired file */
-					sp++;
-					StrNCpy(dp, xlogfname, endp - dp);
-					dp += strlen(dp);
-					break;
-				case 'r':
-					/* %r: filename of last restartpoint */
-					sp++;
-					StrNCpy(dp, lastRestartPointFname, endp - dp);
-					dp += strlen(dp);
-					break;
-				case '%':
-					/* convert %% to a single % */
-					sp++;
-					if (dp < endp)
-						*dp++ = *sp;
-					break;
-				default:
-					/* otherwise treat the % as not special */
-					if (dp < endp)
-						*dp++ = *sp;
-					break;
-			}
-		}
-		else
-		{
-			if (dp < endp)
-				*dp++ = *sp;
-		}
+		ereport(LOG,
+				(errmsg("restored log file \"%s\" from archive",
+						xlogfname)));
+		strcpy(path, xlogpath);
+		StartRestorePrefetch(xlogfname, lastRestartPointFname);
+		return true;
 	}
-	*dp = '\0';
+
+	/*
+	 * construct the command to be executed
+	 */
+	BuildRestoreCommand(xlogRestoreCmd, xlogpath, xlogfname,
+						lastRestartPointFname);
 
 	ereport(DEBUG3,
 			(errmsg_internal("executing restore command \"%s\"",
@@ -252,6 +252,7 @@ RestoreArchivedFile(char *path, const char *xlogfname,
 						(errmsg("restored log file \"%s\" from archive",
 								xlogfname)));
 				strcpy(path, xlogpath);
+				StartRestorePrefetch(xlogfname, lastRestartPointFname);
 				return true;
 			}
 		}
@@ -310,6 +311,321 @@ not_available:
 	return false;
 }
 
+/*
+ * Construct the restore_command to fetch xlogfname into xlogpath.
+ * cmd must have room for MAXPGPATH bytes.
+ */
+static void
+BuildRestoreCommand(char *cmd, const char *xlogpath, const char *xlogfname,
+					const char *lastRestartPointFname)
+{
+	char	   *dp;
+	char	   *endp;
+	const char *sp;
+
+	dp = cmd;
+	endp = cmd + MAXPGPATH - 1;
+	*endp = '\0';
+
+	for (sp = recoveryRestoreCommand; *sp; sp++)
+	{
+		if (*sp == '%')
+		{
+			switch (sp[1])
+			{
+				case 'p':
+					/* %p: relative path of target file */
+					sp++;
+					StrNCpy(dp, xlogpath, endp - dp);
+					make_native_path(dp);
+					dp += strlen(dp);
+					break;
+				case 'f':
+					/* %f: filename of desired file */
+					sp++;
+					StrNCpy(dp, xlogfname, endp - dp);
+					dp += strlen(dp);
+					break;
+				case 'r':
+					/* %r: filename of last restartpoint */
+					sp++;
+					StrNCpy(dp, lastRestartPointFname, endp - dp);
+					dp += strlen(dp);
+					break;
+				case '%':
+					/* convert %% to a single % */
+					sp++;
+					if (dp < endp)
+						*dp++ = *sp;
+					break;
+				default:
+					/* otherwise treat the % as not special */
+					if (dp < endp)
+						*dp++ = *sp;
+					break;
+			}
+		}
+		else
+		{
+			if (dp < endp)
+				*dp++ = *sp;
+		}
+	}
+	*dp = '\0';
+}
+
+/*
+ * Wait for the restore_command of a prefetch slot to exit.
+ */
+static void
+WaitRestorePrefetch(RestorePrefetchSlot *slot)
+{
+	int			status;
+
+	if (slot->state != PREFETCH_RUNNING)
+		return;
+
+	while (waitpid(slot->pid, &status, 0) < 0)
+	{
+		if (errno != EINTR)
+		{
+			status = -1;
+			break;
+		}
+	}
+	slot->state = PREFETCH_FINISHED;
+	slot->status = status;
+}
+
+/*
+ * Forget a prefetch slot, stopping its restore_command if it's still
+ * running and removing whatever it fetched.
+ */
+static void
+ReleaseRestorePrefetch(int slotno)
+{
+	RestorePrefetchSlot *slot = &prefetchSlots[slotno];
+	char		stagedpath[MAXPGPATH];
+
+	if (slot->state == PREFETCH_RUNNING)
+	{
+		(void) kill(slot->pid, SIGTERM);
+		WaitRestorePrefetch(slot);
+	}
+
+	snprintf(stagedpath, MAXPGPATH, RESTORE_PREFETCH_DIR "/%s",
+			 slot->xlogfname);
+	if (unlink(stagedpath) != 0 && errno != ENOENT)
+		ereport(LOG,
+				(errcode_for_file_access(),
+				 errmsg("could not remove file \"%s\": %m", stagedpath)));
+
+	prefetchSlots[slotno] = prefetchSlots[--numPrefetchSlots];
+}
+
+/*
+ * Stop all prefetching when the startup process exits.
+ */
+static void
+RestorePrefetchExit(int code, Datum arg)
+{
+	int			i;
+
+	for (i = 0; i < numPrefetchSlots; i++)
+	{
+		if (prefetchSlots[i].state == PREFETCH_RUNNING)
+			(void) kill(prefetchSlots[i].pid, SIGTERM);
+	}
+	numPrefetchSlots = 0;
+}
+
+/*
+ * If xlogfname has been fetched by a background restore_command, wait for
+ * it to finish if necessary, and move the file to xlogpath.
+ *
+ * Returns false if the file wasn't prefetched, or the prefetch failed, in
+ * which case the caller runs restore_command itself.  Failures are not
+ * reported here; in particular, a segment that was not yet in the archive
+ * when the prefetch ran might well be there now.  Prefetched segments that
+ * precede xlogfname are no longer of use and are released.
+ */
+static bool
+RestorePrefetchedFile(const char *xlogfname, const char *xlogpath,
+					  off_t expectedSize)
+{
+	TimeLineID	tli;
+	XLogSegNo	segno;
+	int			i;
+
+	if (numPrefetchSlots == 0 || !IsXLogFileName(xlogfname))
+		return false;
+
+	XLogFromFileName(xlogfname, &tli, &segno, wal_segment_size);
+
+	i = 0;
+	while (i < numPrefetchSlots)
+	{
+		RestorePrefetchSlot *slot = &prefetchSlots[i];
+		char		stagedpath[MAXPGPATH];
+		struct stat stat_buf;
+
+		if (slot->segno < segno)
+		{
+			ReleaseRestorePrefetch(i);
+			continue;
+		}
+		if (slot->tli != tli || slot->segno != segno)
+		{
+			i++;
+			continue;
+		}
+
+		/* Found it.  Allow SIGTERM to end the wait, as for restore_command */
+		PreRestoreCommand();
+		WaitRestorePrefetch(slot);
+		PostRestoreCommand();
+
+		snprintf(stagedpath, MAXPGPATH, RESTORE_PREFETCH_DIR "/%s",
+				 slot->xlogfname);
+		if (slot->status != 0 ||
+			stat(stagedpath, &stat_buf) != 0 ||
+			(expectedSize > 0 && stat_buf.st_size != expectedSize))
+		{
+			ReleaseRestorePrefetch(i);
+			return false;
+		}
+
+		if (rename(stagedpath, xlogpath) != 0)
+			ereport(FATAL,
+					(errcode_for_file_access(),
+					 errmsg("could not rename file \"%s\" to \"%s\": %m",
+							stagedpath, xlogpath)));
+
+		ReleaseRestorePrefetch(i);
+		return true;
+	}
+
+	return false;
+}
+
+/*
+ * Start restore_command in the background for the restore_prefetch_segments
+ * segments following xlogfname, except those already being fetched, so that
+ * they are ready by the time replay gets to them.
+ *
+ * The commands are run through the shell like system(3) would, from a
+ * forked child, and fetch into RESTORE_PREFETCH_DIR.  Not supported on
+ * Windows, which lacks fork().
+ */
+static void
+StartRestorePrefetch(const char *xlogfname, const char *lastRestartPointFname)
+{
+#ifndef WIN32
+	TimeLineID	tli;
+	XLogSegNo	segno;
+	XLogSegNo	nextsegno;
+	int			i;
+
+	if (recoveryRestorePrefetchSegments <= 0 || !IsXLogFileName(xlogfname))
+		return;
+
+	XLogFromFileName(xlogfname, &tli, &segno, wal_segment_size);
+
+	/* Start with an empty directory, in case of leftovers from a crash */
+	if (!prefetchDirReady)
+	{
+		struct stat stat_buf;
+
+		if (stat(RESTORE_PREFETCH_DIR, &stat_buf) == 0 &&
+			!rmtree(RESTORE_PREFETCH_DIR, true))
+			return;
+		if (MakePGDirectory(RESTORE_PREFETCH_DIR) < 0)
+		{
+			ereport(LOG,
+					(errcode_for_file_access(),
+					 errmsg("could not create directory \"%s\": %m",
+							RESTORE_PREFETCH_DIR)));
+			return;
+		}
+		on_proc_exit(RestorePrefetchExit, 0);
+		prefetchDirReady = true;
+	}
+
+	for (nextsegno = segno + 1;
+		 nextsegno <= segno + recoveryRestorePrefetchSegments &&
+		 numPrefetchSlots < MAX_RESTORE_PREFETCH;
+		 nextsegno++)
+	{
+		RestorePrefetchSlot *slot;
+		char		stagedpath[MAXPGPATH];
+		char		cmd[MAXPGPATH];
+		pid_t		pid;
+
+		for (i = 0; i < numPrefetchSlots; i++)
+		{
+			if (prefetchSlots[i].tli == tli &&
+				prefetchSlots[i].segno == nextsegno)
+				break;
+		}
+		if (i < numPrefetchSlots)
+			continue;
+
+		slot = &prefetchSlots[numPrefetchSlots];
+		XLogFileName(slot->xlogfname, tli, nextsegno, wal_segment_size);
+		slot->tli = tli;
+		slot->segno = nextsegno;
+
+		snprintf(stagedpath, MAXPGPATH, RESTORE_PREFETCH_DIR "/%s",
+				 slot->xlogfname);
+		BuildRestoreCommand(cmd, stagedpath, slot->xlogfname,
+							lastRestartPointFname);
+
+		ereport(DEBUG3,
+				(errmsg_internal("executing restore command \"%s\" in background",
+								 cmd)));
+
+		fflush(stdout);
+		fflush(stderr);
+		pid = fork();
+		if (pid == 0)
+		{
+			execl("/bin/sh", "sh", "-c", cmd, (char *) NULL);
+			_exit(127);
+		}
+		if (pid < 0)
+		{
+			ereport(LOG,
+					(errmsg("could not fork restore command process: %m")));
+			break;
+		}
+
+		slot->pid = pid;
+		slot->state = PREFETCH_RUNNING;
+		numPrefetchSlots++;
+	}
+#endif							/* !WIN32 */
+}
+
+/*
+ * Stop prefetching from the archive, at the end of archive recovery, and
+ * remove the prefetch directory.
+ */
+void
+RestorePrefetchShutdown(void)
+{
+	while (numPrefetchSlots > 0)
+		ReleaseRestorePrefetch(numPrefetchSlots - 1);
+
+	if (prefetchDirReady)
+	{
+		if (!rmtree(RESTORE_PREFETCH_DIR, true))
+			ereport(LOG,
+					(errmsg("could not remove directory \"%s\"",
+							RESTORE_PREFETCH_DIR)));
+		prefetchDirReady = false;
+	}
+}
+
 /*
  * Attempt to execute an external shell command during recovery.
  *
@@ -0,0 +1,342 @@
+/*-------------------------------------------------------------------------
+ *
+ * xlogprefetch.c
+ *		Prefetching support for recovery.
+ *
+ * Replaying a WAL record usually means reading the data blocks it refers
+ * to, one at a time and synchronously.  When the blocks are not in the
+ * buffer pool or the kernel's page cache, recovery spends most of its time
+ * waiting for those reads.  To avoid that, the startup process decodes WAL
+ * records ahead of the one being replayed, with an XLogReader of its own,
+ * and tells the kernel about the blocks they refer to with
+ * PrefetchSharedBuffer(), so that the reads are already under way by the
+ * time replay gets there.
+ *
+ * Only WAL that is present in pg_wal can be read ahead; that covers crash
+ * recovery and streaming replication, but not segments restored from the
+ * archive one at a time.  Since prefetching is just a hint, we never raise
+ * an error here: whenever the WAL can't be read or decoded, e.g. because we
+ * have caught up with what has been received so far, we give up until
+ * replay gets to the same point, and then start over from there.
+ *
+ * Blocks that replay will restore from a full page image, or initialize
+ * from scratch, aren't prefetched, nor are blocks that are in the buffer
+ * pool already, nor blocks that were referenced by one of the last few
+ * records.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *		src/backend/access/transam/xlogprefetch.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include <unistd.h>
+
+#include "access/xlog.h"
+#include "access/xlog_internal.h"
+#include "access/xlogprefetch.h"
+#include "access/xlogreader.h"
+#include "access/xlogrecord.h"
+#include "storage/bufmgr.h"
+#include "storage/fd.h"
+#include "storage/smgr.h"
+
+/* GUC variable */
+int			max_recovery_prefetch_distance = 256;
+
+/*
+ * How many recently prefetched blocks we remember, to avoid asking for the
+ * same block over and over when consecutive records touch it.
+ */
+#define XLOGPREFETCHER_RECENT_BLOCKS	16
+
+/* A block we have issued a prefetch for */
+typedef struct XLogPrefetchBlock
+{
+	RelFileNode rnode;
+	ForkNumber	forknum;
+	BlockNumber blkno;
+} XLogPrefetchBlock;
+
+struct XLogPrefetcher
+{
+	XLogReaderState *reader;	/* decodes records ahead of replay */
+	bool		active;			/* is 'reader' positioned and usable? */
+	XLogRecPtr	retry_lsn;		/* if not, when to start over */
+	TimeLineID	tli;			/* timeline we're reading from */
+
+	/* WAL segment currently open for reading */
+	int			readFile;
+	XLogSegNo	readSegNo;
+	bool		open_failed;	/* did the last attempt to open one fail? */
+
+	/* ring of recently prefetched blocks */
+	XLogPrefetchBlock recent[XLOGPREFETCHER_RECENT_BLOCKS];
+	int			next_recent;
+
+	/* statistics, reported at the end of recovery */
+	uint64		prefetched;		/* prefetches issued */
+	uint64		skip_fpw;		/* blocks restored from a page image */
+	uint64		skip_init;		/* blocks initialized by replay */
+	uint64		skip_hit;		/* blocks already in the buffer pool */
+	uint64		skip_recent;	/* blocks prefetched a moment ago */
+};
+
+static int XLogPrefetcherPageRead(XLogReaderState *reader,
+					   XLogRecPtr targetPagePtr, int reqLen,
+					   XLogRecPtr targetRecPtr, char *readBuf,
+					   TimeLineID *pageTLI);
+static void XLogPrefetcherStop(XLogPrefetcher *prefetcher,
+				   XLogRecPtr retry_lsn);
+static void XLogPrefetcherScanBlocks(XLogPrefetcher *prefetcher);
+
+/*
+ * Create a prefetcher, for use by the startup process during redo.
+ */
+XLogPrefetcher *
+XLogPrefetcherAllocate(void)
+{
+	XLogPrefetcher *prefetcher;
+
+	prefetcher = (XLogPrefetcher *) palloc0(sizeof(XLogPrefetcher));
+	prefetcher->readFile = -1;
+	prefetcher->retry_lsn = InvalidXLogRecPtr;
+
+	return prefetcher;
+}
+
+/*
+ * Release a prefetcher, after reporting what it has done.
+ */
+void
+XLogPrefetcherFree(XLogPrefetcher *prefetcher)
+{
+	ereport(DEBUG1,
+			(errmsg("recovery issued " UINT64_FORMAT " prefetches, skipped " UINT64_FORMAT " blocks with full page images, " UINT64_FORMAT " initialized blocks, " UINT64_FORMAT " cached blocks and " UINT64_FORMAT " repeated blocks",
+					prefetcher->prefetched, prefetcher->skip_fpw,
+					prefetcher->skip_init, prefetcher->skip_hit,
+					prefetcher->skip_recent)));
+
+	if (prefetcher->readFile >= 0)
+		close(prefetcher->readFile);
+	if (prefetcher->reader != NULL)
+		XLogReaderFree(prefetcher->reader);
+	pfree(prefetcher);
+}
+
+/*
+ * Read ahead of the record about to be replayed, which starts at replay_lsn
+ * in a WAL file of timeline tli, and prefetch the blocks referenced by the
+ * records up to max_recovery_prefetch_distance further on.
+ */
+void
+XLogPrefetcherReadAhead(XLogPrefetcher *prefetcher, XLogRecPtr replay_lsn,
+						TimeLineID tli)
+{
+	XLogRecPtr	limit;
+
+	if (max_recovery_prefetch_distance <= 0 || tli == 0)
+	{
+		if (prefetcher->active)
+			XLogPrefetcherStop(prefetcher, InvalidXLogRecPtr);
+		return;
+	}
+
+	/* Start over if replay has overtaken us or moved to another timeline */
+	if (prefetcher->active &&
+		(prefetcher->reader->EndRecPtr <= replay_lsn || prefetcher->tli != tli))
+		XLogPrefetcherStop(prefetcher, InvalidXLogRecPtr);
+
+	if (!prefetcher->active)
+	{
+		char	   *errormsg;
+
+		/* Wait for replay to get past wherever we got stuck last time */
+		if (replay_lsn < prefetcher->retry_lsn)
+			return;
+
+		if (prefetcher->reader == NULL)
+		{
+			prefetcher->reader = XLogReaderAllocate(wal_segment_size,
+													&XLogPrefetcherPageRead,
+													prefetcher);
+			if (prefetcher->reader == NULL)
+				return;			/* out of memory; prefetching is optional */
+		}
+
+		prefetcher->tli = tli;
+
+		/* Position the reader at the record being replayed */
+		XLogReaderInvalReadState(prefetcher->reader);
+		prefetcher->open_failed = false;
+		if (XLogReadRecord(prefetcher->reader, replay_lsn, &errormsg) == NULL)
+		{
+			XLogSegNo	segno;
+
+			/*
+			 * If the segment isn't in pg_wal, e.g. because replay restored it
+			 * from the archive under a different name, don't try again until
+			 * the next one.  Otherwise try again at the next page.
+			 */
+			if (prefetcher->open_failed)
+			{
+				XLByteToSeg(replay_lsn, segno, wal_segment_size);
+				XLogSegNoOffsetToRecPtr(segno + 1, 0, wal_segment_size,
+										prefetcher->retry_lsn);
+			}
+			else
+				prefetcher->retry_lsn =
+					replay_lsn - replay_lsn % XLOG_BLCKSZ + XLOG_BLCKSZ;
+			XLogPrefetcherStop(prefetcher, prefetcher->retry_lsn);
+			return;
+		}
+		prefetcher->active = true;
+
+		/* replay reads the blocks of this one right away, so skip them */
+	}
+
+	limit = replay_lsn + (XLogRecPtr) max_recovery_prefetch_distance * 1024;
+
+	while (prefetcher->reader->EndRecPtr < limit)
+	{
+		XLogRecPtr	next_lsn = prefetcher->reader->EndRecPtr;
+		char	   *errormsg;
+
+		if (XLogReadRecord(prefetcher->reader, InvalidXLogRecPtr,
+						   &errormsg) == NULL)
+		{
+			/* Probably the end of the WAL received so far */
+			XLogPrefetcherStop(prefetcher, next_lsn);
+			return;
+		}
+
+		XLogPrefetcherScanBlocks(prefetcher);
+	}
+}
+
+/*
+ * Stop reading ahead until replay gets to retry_lsn.
+ */
+static void
+XLogPrefetcherStop(XLogPrefetcher *prefetcher, XLogRecPtr retry_lsn)
+{
+	prefetcher->active = false;
+	prefetcher->retry_lsn = retry_lsn;
+
+	if (prefetcher->readFile >= 0)
+	{
+		close(prefetcher->readFile);
+		prefetcher->readFile = -1;
+	}
+}
+
+/*
+ * Issue prefetches for the blocks referenced by the record just decoded.
+ */
+static void
+XLogPrefetcherScanBlocks(XLogPrefetcher *prefetcher)
+{
+	XLogReaderState *reader = prefetcher->reader;
+	int			block_id;
+
+	for (block_id = 0; block_id <= reader->max_block_id; block_id++)
+	{
+		DecodedBkpBlock *block = &reader->blocks[block_id];
+		SMgrRelation reln;
+		int			i;
+
+		if (!block->in_use)
+			continue;
+
+		/* Replay won't read blocks it restores or initializes */
+		if (block->apply_image)
+		{
+			prefetcher->skip_fpw++;
+			continue;
+		}
+		if (block->flags & BKPBLOCK_WILL_INIT)
+		{
+			prefetcher->skip_init++;
+			continue;
+		}
+
+		for (i = 0; i < XLOGPREFETCHER_RECENT_BLOCKS; i++)
+		{
+			XLogPrefetchBlock *recent = &prefetcher->recent[i];
+
+			if (recent->blkno == block->blkno &&
+				recent->forknum == block->forknum &&
+				RelFileNodeEquals(recent->rnode, block->rnode))
+				break;
+		}
+		if (i < XLOGPREFETCHER_RECENT_BLOCKS)
+		{
+			prefetcher->skip_recent++;
+			continue;
+		}
+
+		reln = smgropen(block->rnode, InvalidBackendId);
+		if (PrefetchSharedBuffer(reln, block->forknum, block->blkno))
+			prefetcher->prefetched++;
+		else
+			prefetcher->skip_hit++;
+
+		prefetcher->recent[prefetcher->next_recent].rnode = block->rnode;
+		prefetcher->recent[prefetcher->next_recent].forknum = block->forknum;
+		prefetcher->recent[prefetcher->next_recent].blkno = block->blkno;
+		prefetcher->next_recent =
+			(prefetcher->next_recent + 1) % XLOGPREFETCHER_RECENT_BLOCKS;
+	}
+}
+
+/*
+ * XLogReader page read callback of the prefetcher.
+ *
+ * Reads straight from the files in pg_wal, without waiting for anything.
+ * Returns -1 if the page isn't there (yet); xlogreader's page header and
+ * record CRC checks catch data that hasn't been completely written yet.
+ */
+static int
+XLogPrefetcherPageRead(XLogReaderState *reader, XLogRecPtr targetPagePtr,
+					   int reqLen, XLogRecPtr targetRecPtr, char *readBuf,
+					   TimeLineID *pageTLI)
+{
+	XLogPrefetcher *prefetcher = (XLogPrefetcher *) reader->private_data;
+	XLogSegNo	segno;
+	uint32		offset;
+
+	XLByteToSeg(targetPagePtr, segno, wal_segment_size);
+	offset = XLogSegmentOffset(targetPagePtr, wal_segment_size);
+
+	if (prefetcher->readFile >= 0 && segno != prefetcher->readSegNo)
+	{
+		close(prefetcher->readFile);
+		prefetcher->readFile = -1;
+	}
+
+	if (prefetcher->readFile < 0)
+	{
+		char		path[MAXPGPATH];
+
+		XLogFilePath(path, prefetcher->tli, segno, wal_segment_size);
+		prefetcher->readFile = BasicOpenFile(path, O_RDONLY | PG_BINARY);
+		if (prefetcher->readFile < 0)
+		{
+			prefetcher->open_failed = true;
+			return -1;
+		}
+		prefetcher->readSegNo = segno;
+	}
+
+	if (pg_pread(prefetcher->readFile, readBuf, XLOG_BLCKSZ,
+				 (off_t) offset) != XLOG_BLCKSZ)
+		return -1;
+
+	*pageTLI = prefetcher->tli;
+	return XLOG_BLCKSZ;
+}
@@ -134,6 +134,9 @@ static void IndexCheckExclusion(Relation heapRelation,
 static inline int64 itemptr_encode(ItemPointer itemptr);
 static inline void itemptr_decode(ItemPointer itemptr, int64 encoded);
 static bool validate_index_callback(ItemPointer itemptr, void *opaque);
+static bool validate_index_next_range(Relation heapRelation,
+						  BlockNumber nblocks, BlockNumber *startblk,
+						  BlockNumber *numblks, Buffer *vmbuffer);
 static void validate_index_heapscan(Relation heapRelation,
 						Relation indexRelation,
 						IndexInfo *indexInfo,
@@ -2254,13 +2257,13 @@ index_build(Relation heapRelation,
 	Assert(PointerIsValid(indexRelation->rd_amroutine->ambuildempty));
 
 	/*
-	 * Determine worker process details for parallel CREATE INDEX.  Currently,
-	 * only btree has support for parallel builds.
+	 * Determine worker process details for parallel CREATE INDEX, if the
+	 * access method supports parallel builds.
 	 *
 	 * Note that planner considers parallel safety for us.
 	 */
 	if (parallel && IsNormalProcessingMode() &&
-		indexRelation->rd_rel->relam == BTREE_AM_OID)
+		indexRelation->rd_amroutine->amcanbuildparallel)
 		indexInfo->ii_ParallelWorkers =
 			plan_create_index_workers(RelationGetRelid(heapRelation),
 									  RelationGetRelid(indexRelation));
@@ -2550,11 +2553,14 @@ IndexBuildHeapRangeScan(Relation heapRelation,
 		 * Parallel index build.
 		 *
 		 * Parallel case never registers/unregisters own snapshot.  Snapshot
-		 * is taken from parallel heap scan, and is SnapshotAny or an MVCC
-		 * snapshot, based on same criteria as serial case.
+		 * is taken from the caller's scan, and is SnapshotAny or an MVCC
+		 * snapshot, based on same criteria as serial case.  The scan is
+		 * usually a parallel heap scan; access methods that divide the heap
+		 * among participants by block ranges instead pass a plain scan,
+		 * which may be restricted to the given range.
 		 */
 		Assert(!IsBootstrapProcessingMode());
-		Assert(allow_sync);
+		Assert(allow_sync || scan->rs_parallel == NULL);
 		snapshot = scan->rs_snapshot;
 	}
 
@@ -3265,11 +3271,58 @@ validate_index_callback(ItemPointer itemptr, void *opaque)
 	return false;				/* never actually delete anything */
 }
 
+/*
+ * validate_index_next_range - find the next run of blocks to validate
+ *
+ * Starting at *startblk, skip over blocks that are marked all-visible in the
+ * visibility map, and return the following run of blocks that are not in
+ * *startblk and *numblks.  Returns false if no blocks are left.
+ *
+ * All-visible blocks cannot contain tuples missing from the index.  We have
+ * held ShareUpdateExclusiveLock on the table since before the index was
+ * built, which keeps VACUUM from setting any visibility map bits meanwhile,
+ * so an all-visible block was already all-visible when the build's snapshot
+ * was taken and has not been modified since; any modification would have
+ * cleared the bit.  Every tuple on it was therefore indexed by the build.
+ * If the bit is cleared by a concurrent insert just after we look at it,
+ * the inserting transaction will make its own index entries, since it
+ * started after the index was marked ready for inserts.
+ */
+static bool
+validate_index_next_range(Relation heapRelation, BlockNumber nblocks,
+						  BlockNumber *startblk, BlockNumber *numblks,
+						  Buffer *vmbuffer)
+{
+	BlockNumber blkno = *startblk;
+	BlockNumber endblk;
+
+	while (blkno < nblocks &&
+		   VM_ALL_VISIBLE(heapRelation, blkno, vmbuffer))
+		blkno++;
+
+	if (blkno >= nblocks)
+		return false;
+
+	endblk = blkno + 1;
+	while (endblk < nblocks &&
+		   !VM_ALL_VISIBLE(heapRelation, endblk, vmbuffer))
+		endblk++;
+
+	*startblk = blkno;
+	*numblks = endblk - blkno;
+	return true;
+}
+
 /*
  * validate_index_heapscan - second table scan for concurrent index build
  *
  * This has much code in common with IndexBuildHeapScan, but it's enough
  * different that it seems cleaner to have two routines not one.
+ *
+ * Only blocks that are not all-visible are scanned; see
+ * validate_index_next_range.  The heap scan is restarted for each run of
+ * such blocks, always moving forward, so the merge against the sorted index
+ * TIDs still sees heap TIDs in ascending order.
  */
 static void
 validate_index_heapscan(Relation heapRelation,
@@ -3289,6 +3342,9 @@ validate_index_heapscan(Relation heapRelation,
 	BlockNumber root_blkno = InvalidBlockNumber;
 	OffsetNumber root_offsets[MaxHeapTuplesPerPage];
 	bool		in_index[MaxHeapTuplesPerPage];
+	BlockNumber startblk;
+	BlockNumber numblks;
+	Buffer		vmbuffer = InvalidBuffer;
 
 	/* state variables for the merge */
 	ItemPointer indexcursor = NULL;
@@ -3329,169 +3385,185 @@ validate_index_heapscan(Relation heapRelation,
 								false); /* syncscan not OK */
 
 	/*
-	 * Scan all tuples matching the snapshot.
+	 * Scan all tuples matching the snapshot, a run of blocks at a time,
+	 * skipping blocks that are all-visible.
 	 */
-	while ((heapTuple = heap_getnext(scan, ForwardScanDirection)) != NULL)
+	startblk = 0;
+	while (validate_index_next_range(heapRelation, scan->rs_nblocks,
+									 &startblk, &numblks, &vmbuffer))
 	{
-		ItemPointer heapcursor = &heapTuple->t_self;
-		ItemPointerData rootTuple;
-		OffsetNumber root_offnum;
+		heap_rescan(scan, NULL);
+		heap_setscanlimits(scan, startblk, numblks);
 
-		CHECK_FOR_INTERRUPTS();
-
-		state->htups += 1;
-
-		/*
-		 * As commented in IndexBuildHeapScan, we should index heap-only
-		 * tuples under the TIDs of their root tuples; so when we advance onto
-		 * a new heap page, build a map of root item offsets on the page.
-		 *
-		 * This complicates merging against the tuplesort output: we will
-		 * visit the live tuples in order by their offsets, but the root
-		 * offsets that we need to compare against the index contents might be
-		 * ordered differently.  So we might have to "look back" within the
-		 * tuplesort output, but only within the current page.  We handle that
-		 * by keeping a bool array in_index[] showing all the
-		 * already-passed-over tuplesort output TIDs of the current page. We
-		 * clear that array here, when advancing onto a new heap page.
-		 */
-		if (scan->rs_cblock != root_blkno)
+		while ((heapTuple = heap_getnext(scan, ForwardScanDirection)) != NULL)
 		{
-			Page		page = BufferGetPage(scan->rs_cbuf);
+			ItemPointer heapcursor = &heapTuple->t_self;
+			ItemPointerData rootTuple;
+			OffsetNumber root_offnum;
 
-			LockBuffer(scan->rs_cbuf, BUFFER_LOCK_SHARE);
-			heap_get_root_tuples(page, root_offsets);
-			LockBuffer(scan->rs_cbuf, BUFFER_LOCK_UNLOCK);
+			CHECK_FOR_INTERRUPTS();
 
-			memset(in_index, 0, sizeof(in_index));
+			state->htups += 1;
 
-			root_blkno = scan->rs_cblock;
-		}
-
-		/* Convert actual tuple TID to root TID */
-		rootTuple = *heapcursor;
-		root_offnum = ItemPointerGetOffsetNumber(heapcursor);
+			/*
+			 * As commented in IndexBuildHeapScan, we should index heap-only
+			 * tuples under the TIDs of their root tuples; so when we advance
+			 * onto a new heap page, build a map of root item offsets on the
+			 * page.
+			 *
+			 * This complicates merging against the tuplesort output: we will
+			 * visit the live tuples in order by their offsets, but the root
+			 * offsets that we need to compare against the index contents
+			 * might be ordered differently.  So we might have to "look back"
+			 * within the tuplesort output, but only within the current page.
+			 * We handle that by keeping a bool array in_index[] showing all
+			 * the already-passed-over tuplesort output TIDs of the current
+			 * page. We clear that array here, when advancing onto a new heap
+			 * page.
+			 */
+			if (scan->rs_cblock != root_blkno)
+			{
+				Page		page = BufferGetPage(scan->rs_cbuf);
 
-		if (HeapTupleIsHeapOnly(heapTuple))
-		{
-			root_offnum = root_offsets[root_offnum - 1];
-			if (!OffsetNumberIsValid(root_offnum))
-				ereport(ERROR,
-						(errcode(ERRCODE_DATA_CORRUPTED),
-						 errmsg_internal("failed to find parent tuple for heap-only tuple at (%u,%u) in table \"%s\"",
-										 ItemPointerGetBlockNumber(heapcursor),
-										 ItemPointerGetOffsetNumber(heapcursor),
-										 RelationGetRelationName(heapRelation))));
-			ItemPointerSetOffsetNumber(&rootTuple, root_offnum);
-		}
+				LockBuffer(scan->rs_cbuf, BUFFER_LOCK_SHARE);
+				heap_get_root_tuples(page, root_offsets);
+				LockBuffer(scan->rs_cbuf, BUFFER_LOCK_UNLOCK);
 
-		/*
-		 * "merge" by skipping through the index tuples until we find or pass
-		 * the current root tuple.
-		 */
-		while (!tuplesort_empty &&
-			   (!indexcursor ||
-				ItemPointerCompare(indexcursor, &rootTuple) < 0))
-		{
-			Datum		ts_val;
-			bool		ts_isnull;
+				memset(in_index, 0, sizeof(in_index));
 
-			if (indexcursor)
-			{
-				/*
-				 * Remember index items seen earlier on the current heap page
-				 */
-				if (ItemPointerGetBlockNumber(indexcursor) == root_blkno)
-					in_index[ItemPointerGetOffsetNumber(indexcursor) - 1] = true;
+				root_blkno = scan->rs_cblock;
 			}
 
-			tuplesort_empty = !tuplesort_getdatum(state->tuplesort, true,
-												  &ts_val, &ts_isnull, NULL);
-			Assert(tuplesort_empty || !ts_isnull);
-			if (!tuplesort_empty)
-			{
-				itemptr_decode(&decoded, DatumGetInt64(ts_val));
-				indexcursor = &decoded;
+			/* Convert actual tuple TID to root TID */
+			rootTuple = *heapcursor;
+			root_offnum = ItemPointerGetOffsetNumber(heapcursor);
 
-				/* If int8 is pass-by-ref, free (encoded) TID Datum memory */
-#ifndef USE_FLOAT8_BYVAL
-				pfree(DatumGetPointer(ts_val));
-#endif
-			}
-			else
+			if (HeapTupleIsHeapOnly(heapTuple))
 			{
-				/* Be tidy */
-				indexcursor = NULL;
+				root_offnum = root_offsets[root_offnum - 1];
+				if (!OffsetNumberIsValid(root_offnum))
+					ereport(ERROR,
+							(errcode(ERRCODE_DATA_CORRUPTED),
+							 errmsg_internal("failed to find parent tuple for heap-only tuple at (%u,%u) in table \"%s\"",
+											 ItemPointerGetBlockNumber(heapcursor),
+											 ItemPointerGetOffsetNumber(heapcursor),
+											 RelationGetRelationName(heapRelation))));
+				ItemPointerSetOffsetNumber(&rootTuple, root_offnum);
 			}
-		}
-
-		/*
-		 * If the tuplesort has overshot *and* we didn't see a match earlier,
-		 * then this tuple is missing from the index, so insert it.
-		 */
-		if ((tuplesort_empty ||
-			 ItemPointerCompare(indexcursor, &rootTuple) > 0) &&
-			!in_index[root_offnum - 1])
-		{
-			MemoryContextReset(econtext->ecxt_per_tuple_memory);
-
-			/* Set up for predicate or expression evaluation */
-			ExecStoreHeapTuple(heapTuple, slot, false);
 
 			/*
-			 * In a partial index, discard tuples that don't satisfy the
-			 * predicate.
+			 * "merge" by skipping through the index tuples until we find or pass
+			 * the current root tuple.
 			 */
-			if (predicate != NULL)
+			while (!tuplesort_empty &&
+				   (!indexcursor ||
+					ItemPointerCompare(indexcursor, &rootTuple) < 0))
 			{
-				if (!ExecQual(predicate, econtext))
-					continue;
+				Datum		ts_val;
+				bool		ts_isnull;
+
+				if (indexcursor)
+				{
+					/*
+					 * Remember index items seen earlier on the current heap page
+					 */
+					if (ItemPointerGetBlockNumber(indexcursor) == root_blkno)
+						in_index[ItemPointerGetOffsetNumber(indexcursor) - 1] = true;
+				}
+
+				tuplesort_empty = !tuplesort_getdatum(state->tuplesort, true,
+													  &ts_val, &ts_isnull, NULL);
+				Assert(tuplesort_empty || !ts_isnull);
+				if (!tuplesort_empty)
+				{
+					itemptr_decode(&decoded, DatumGetInt64(ts_val));
+					indexcursor = &decoded;
+
+					/* If int8 is pass-by-ref, free (encoded) TID Datum memory */
+	#ifndef USE_FLOAT8_BYVAL
+					pfree(DatumGetPointer(ts_val));
+	#endif
+				}
+				else
+				{
+					/* Be tidy */
+					indexcursor = NULL;
+				}
 			}
 
 			/*
-			 * For the current heap tuple, extract all the attributes we use
-			 * in this index, and note which are null.  This also performs
-			 * evaluation of any expressions needed.
+			 * If the tuplesort has overshot *and* we didn't see a match earlier,
+			 * then this tuple is missing from the index, so insert it.
 			 */
-			FormIndexDatum(indexInfo,
-						   slot,
-						   estate,
-						   values,
-						   isnull);
+			if ((tuplesort_empty ||
+				 ItemPointerCompare(indexcursor, &rootTuple) > 0) &&
+				!in_index[root_offnum - 1])
+			{
+				MemoryContextReset(econtext->ecxt_per_tuple_memory);
 
-			/*
-			 * You'd think we should go ahead and build the index tuple here,
-			 * but some index AMs want to do further processing on the data
-			 * first. So pass the values[] and isnull[] arrays, instead.
-			 */
+				/* Set up for predicate or expression evaluation */
+				ExecStoreHeapTuple(heapTuple, slot, false);
 
-			/*
-			 * If the tuple is already committed dead, you might think we
-			 * could suppress uniqueness checking, but this is no longer true
-			 * in the presence of HOT, because the insert is actually a proxy
-			 * for a uniqueness check on the whole HOT-chain.  That is, the
-			 * tuple we have here could be dead because it was already
-			 * HOT-updated, and if so the updating transaction will not have
-			 * thought it should insert index entries.  The index AM will
-			 * check the whole HOT-chain and correctly detect a conflict if
-			 * there is one.
-			 */
+				/*
+				 * In a partial index, discard tuples that don't satisfy the
+				 * predicate.
+				 */
+				if (predicate != NULL)
+				{
+					if (!ExecQual(predicate, econtext))
+						continue;
+				}
+
+				/*
+				 * For the current heap tuple, extract all the attributes we use
+				 * in this index, and note which are null.  This also performs
+				 * evaluation of any expressions needed.
+				 */
+				FormIndexDatum(indexInfo,
+							   slot,
+							   estate,
+							   values,
+							   isnull);
 
-			index_insert(indexRelation,
-						 values,
-						 isnull,
-						 &rootTuple,
-						 heapRelation,
-						 indexInfo->ii_Unique ?
-						 UNIQUE_CHECK_YES : UNIQUE_CHECK_NO,
-						 indexInfo);
+				/*
+				 * You'd think we should go ahead and build the index tuple here,
+				 * but some index AMs want to do further processing on the data
+				 * first. So pass the values[] and isnull[] arrays, instead.
+				 */
 
-			state->tups_inserted += 1;
+				/*
+				 * If the tuple is already committed dead, you might think we
+				 * could suppress uniqueness checking, but this is no longer true
+				 * in the presence of HOT, because the insert is actually a proxy
+				 * for a uniqueness check on the whole HOT-chain.  That is, the
+				 * tuple we have here could be dead because it was already
+				 * HOT-updated, and if so the updating transaction will not have
+				 * thought it should insert index entries.  The index AM will
+				 * check the whole HOT-chain and correctly detect a conflict if
+				 * there is one.
+				 */
+
+				index_insert(indexRelation,
+							 values,
+							 isnull,
+							 &rootTuple,
+							 heapRelation,
+							 indexInfo->ii_Unique ?
+							 UNIQUE_CHECK_YES : UNIQUE_CHECK_NO,
+							 indexInfo);
+
+				state->tups_inserted += 1;
+			}
 		}
+
+		startblk += numblks;
 	}
 
 	heap_endscan(scan);
 
+	if (BufferIsValid(vmbuffer))
+		ReleaseBuffer(vmbuffer);
+
 	ExecDropSingleTupleTableSlot(slot);
 
 	FreeExecutorState(estate);
@@ -268,6 +268,12 @@ CREATE VIEW pg_locks AS
 CREATE VIEW pg_cursors AS
     SELECT * FROM pg_cursor() AS C;
 
+CREATE VIEW pg_catalog_cache_stats AS
+    SELECT * FROM pg_catalog_cache_stats() AS S;
+
+CREATE VIEW pg_relation_cache_stats AS
+    SELECT * FROM pg_relation_cache_stats() AS S;
+
 CREATE VIEW pg_available_extensions AS
     SELECT E.name, E.default_version, X.extversion AS installed_version,
            E.comment
@@ -494,6 +500,12 @@ CREATE VIEW pg_hba_file_rules AS
 REVOKE ALL on pg_hba_file_rules FROM PUBLIC;
 REVOKE EXECUTE ON FUNCTION pg_hba_file_rules() FROM PUBLIC;
 
+CREATE VIEW pg_shmem_numa AS
+    SELECT * FROM pg_get_shmem_numa();
+
+REVOKE ALL ON pg_shmem_numa FROM PUBLIC;
+REVOKE EXECUTE ON FUNCTION pg_get_shmem_numa() FROM PUBLIC;
+
 CREATE VIEW pg_timezone_abbrevs AS
     SELECT * FROM pg_timezone_abbrevs();
 
@@ -525,6 +537,7 @@ CREATE VIEW pg_stat_all_tables AS
             pg_stat_get_live_tuples(C.oid) AS n_live_tup,
             pg_stat_get_dead_tuples(C.oid) AS n_dead_tup,
             pg_stat_get_mod_since_analyze(C.oid) AS n_mod_since_analyze,
+            pg_stat_get_ins_since_vacuum(C.oid) AS n_ins_since_vacuum,
             pg_stat_get_last_vacuum_time(C.oid) as last_vacuum,
             pg_stat_get_last_autovacuum_time(C.oid) as last_autovacuum,
             pg_stat_get_last_analyze_time(C.oid) as last_analyze,
@@ -709,7 +722,11 @@ CREATE VIEW pg_stat_activity AS
             S.backend_xid,
             s.backend_xmin,
             S.query,
-            S.backend_type
+            S.backend_type,
+            S.bytes_sent,
+            S.bytes_received,
+            S.send_calls,
+            S.recv_calls
     FROM pg_stat_get_activity(NULL) AS S
         LEFT JOIN pg_database AS D ON (S.datid = D.oid)
         LEFT JOIN pg_authid AS U ON (S.usesysid = U.oid);
@@ -735,7 +752,9 @@ CREATE VIEW pg_stat_replication AS
             W.replay_lag,
             W.sync_priority,
             W.sync_state,
-            W.reply_time
+            W.reply_time,
+            W.compression,
+            W.compression_ratio
     FROM pg_stat_get_activity(NULL) AS S
         JOIN pg_stat_get_wal_senders() AS W ON (S.pid = W.pid)
         LEFT JOIN pg_authid AS U ON (S.usesysid = U.oid);
@@ -823,6 +842,10 @@ CREATE VIEW pg_stat_database AS
             pg_stat_get_db_deadlocks(D.oid) AS deadlocks,
             pg_stat_get_db_blk_read_time(D.oid) AS blk_read_time,
             pg_stat_get_db_blk_write_time(D.oid) AS blk_write_time,
+            pg_stat_get_db_parallel_workers_to_launch(D.oid)
+                AS parallel_workers_to_launch,
+            pg_stat_get_db_parallel_workers_launched(D.oid)
+                AS parallel_workers_launched,
             pg_stat_get_db_stat_reset_time(D.oid) AS stats_reset
     FROM pg_database D;
 
@@ -872,6 +895,35 @@ CREATE VIEW pg_stat_archiver AS
         s.stats_reset
     FROM pg_stat_get_archiver() s;
 
+CREATE VIEW pg_stat_wal_group_commit AS
+    SELECT
+        s.flushes,
+        s.followers
+    FROM pg_stat_get_wal_group_commit() s;
+
+CREATE VIEW pg_stat_lwlocks AS
+    SELECT
+        s.tranche,
+        s.acquires,
+        s.waits,
+        s.spin_delays,
+        s.wait_time,
+        s.wait_histogram
+    FROM pg_stat_get_lwlocks() s;
+
+CREATE VIEW pg_stat_io AS
+    SELECT
+        s.backend_type,
+        s.io_context,
+        s.reads,
+        s.read_time,
+        s.hits,
+        s.writes,
+        s.write_time,
+        s.extends,
+        s.fsyncs
+    FROM pg_stat_get_io() s;
+
 CREATE VIEW pg_stat_bgwriter AS
     SELECT
         pg_stat_get_bgwriter_timed_checkpoints() AS checkpoints_timed,
@@ -900,7 +952,9 @@ CREATE VIEW pg_stat_progress_vacuum AS
 					  END AS phase,
 		S.param2 AS heap_blks_total, S.param3 AS heap_blks_scanned,
 		S.param4 AS heap_blks_vacuumed, S.param5 AS index_vacuum_count,
-		S.param6 AS max_dead_tuples, S.param7 AS num_dead_tuples
+		S.param6 AS max_dead_tuples, S.param7 AS num_dead_tuples,
+		S.param8 AS indexes_total, S.param9 AS indexes_processed,
+		NULLIF(S.param10, 0)::integer AS leader_pid
     FROM pg_stat_get_progress_info('VACUUM') AS S
 		LEFT JOIN pg_database D ON S.datid = D.oid;
 
@@ -936,7 +990,8 @@ REVOKE ALL ON pg_replication_origin_status FROM public;
 
 -- All columns of pg_subscription except subconninfo are readable.
 REVOKE ALL ON pg_subscription FROM public;
-GRANT SELECT (subdbid, subname, subowner, subenabled, subslotname, subpublications)
+GRANT SELECT (subdbid, subname, subowner, subenabled, substream,
+              subbinary, subslotname, subpublications)
     ON pg_subscription TO public;
 
 
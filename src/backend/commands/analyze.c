@@ -47,6 +47,7 @@
 #include "storage/lmgr.h"
 #include "storage/proc.h"
 #include "storage/procarray.h"
+#include "storage/read_stream.h"
 #include "utils/acl.h"
 #include "utils/attoptcache.h"
 #include "utils/builtins.h"
@@ -94,6 +95,8 @@ static VacAttrStats *examine_attribute(Relation onerel, int attnum,
 static int acquire_sample_rows(Relation onerel, int elevel,
 					HeapTuple *rows, int targrows,
 					double *totalrows, double *totaldeadrows);
+static BlockNumber acquire_sample_rows_next_block(ReadStream *stream,
+							   void *callback_private_data);
 static int	compare_rows(const void *a, const void *b);
 static int acquire_inherited_sample_rows(Relation onerel, int elevel,
 							  HeapTuple *rows, int targrows,
@@ -1011,6 +1014,7 @@ acquire_sample_rows(Relation onerel, int elevel,
 	TransactionId OldestXmin;
 	BlockSamplerData bs;
 	ReservoirStateData rstate;
+	ReadStream *stream;
 
 	Assert(targrows > 0);
 
@@ -1024,10 +1028,14 @@ acquire_sample_rows(Relation onerel, int elevel,
 	/* Prepare for sampling rows */
 	reservoir_init_selection_state(&rstate, targrows);
 
+	/* Read the sampled blocks through a stream, to prefetch them */
+	stream = read_stream_begin_relation(onerel, MAIN_FORKNUM, vac_strategy,
+										acquire_sample_rows_next_block, &bs);
+
 	/* Outer loop over blocks to sample */
-	while (BlockSampler_HasMore(&bs))
+	for (;;)
 	{
-		BlockNumber targblock = BlockSampler_Next(&bs);
+		BlockNumber targblock;
 		Buffer		targbuffer;
 		Page		targpage;
 		OffsetNumber targoffset,
@@ -1044,8 +1052,10 @@ acquire_sample_rows(Relation onerel, int elevel,
 		 * tuple, but since we aren't doing much work per tuple, the extra
 		 * lock traffic is probably better avoided.
 		 */
-		targbuffer = ReadBufferExtended(onerel, MAIN_FORKNUM, targblock,
-										RBM_NORMAL, vac_strategy);
+		targbuffer = read_stream_next_buffer(stream);
+		if (!BufferIsValid(targbuffer))
+			break;
+		targblock = BufferGetBlockNumber(targbuffer);
 		LockBuffer(targbuffer, BUFFER_LOCK_SHARE);
 		targpage = BufferGetPage(targbuffer);
 		maxoffset = PageGetMaxOffsetNumber(targpage);
@@ -1211,6 +1221,8 @@ acquire_sample_rows(Relation onerel, int elevel,
 		UnlockReleaseBuffer(targbuffer);
 	}
 
+	read_stream_end(stream);
+
 	/*
 	 * If we didn't find as many tuples as we wanted then we're done. No sort
 	 * is needed, since they're already in order.
@@ -1255,6 +1267,20 @@ acquire_sample_rows(Relation onerel, int elevel,
 	return numrows;
 }
 
+/*
+ * Read stream callback for acquire_sample_rows: hand out the blocks chosen
+ * by the block sampler.
+ */
+static BlockNumber
+acquire_sample_rows_next_block(ReadStream *stream, void *callback_private_data)
+{
+	BlockSampler bs = (BlockSampler) callback_private_data;
+
+	if (!BlockSampler_HasMore(bs))
+		return InvalidBlockNumber;
+	return BlockSampler_Next(bs);
+}
+
 /*
  * qsort comparator for sorting rows[] array
  */
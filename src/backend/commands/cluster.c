@@ -19,6 +19,7 @@
 
 #include "access/amapi.h"
 #include "access/multixact.h"
+#include "access/parallel.h"
 #include "access/relscan.h"
 #include "access/rewriteheap.h"
 #include "access/transam.h"
@@ -30,6 +31,7 @@
 #include "catalog/dependency.h"
 #include "catalog/heap.h"
 #include "catalog/index.h"
+#include "catalog/indexing.h"
 #include "catalog/namespace.h"
 #include "catalog/objectaccess.h"
 #include "catalog/toasting.h"
@@ -42,6 +44,7 @@
 #include "storage/lmgr.h"
 #include "storage/predicate.h"
 #include "storage/smgr.h"
+#include "storage/spin.h"
 #include "utils/acl.h"
 #include "utils/fmgroids.h"
 #include "utils/inval.h"
@@ -66,16 +69,65 @@ typedef struct
 	Oid			indexOid;
 } RelToCluster;
 
+/* Magic numbers for parallel state sharing */
+#define PARALLEL_KEY_CLUSTER_SHARED		UINT64CONST(0xA000000000000001)
+#define PARALLEL_KEY_TUPLESORT			UINT64CONST(0xA000000000000002)
+
+/*
+ * Status for a parallel seqscan-and-sort CLUSTER, in shared memory
+ *
+ * Each participant scans a share of the old heap's blocks, sorting the
+ * tuples that must be kept into its own worker tuplesort.  The leader then
+ * merges the sorted runs and writes the new heap, as in the serial case.
+ */
+typedef struct ClusterShared
+{
+	/*
+	 * These fields are not modified during the scan.  They primarily exist
+	 * for the benefit of worker processes that need to open relations or
+	 * set up worker tuplesorts.
+	 */
+	Oid			heaprelid;
+	Oid			indexrelid;
+	TransactionId OldestXmin;
+	int			scantuplesortstates;
+
+	/*
+	 * mutex protects all fields below, which participants add their own
+	 * counts to when they're done.
+	 */
+	slock_t		mutex;
+	double		num_tuples;
+	double		tups_vacuumed;
+	double		tups_recently_dead;
+
+	/*
+	 * The old heap is always scanned with SnapshotAny, so this must come
+	 * last but needs no space for a serialized snapshot.
+	 */
+	ParallelHeapScanDescData heapdesc;
+} ClusterShared;
+
 
 static void rebuild_relation(Relation OldHeap, Oid indexOid, bool verbose);
 static void copy_heap_data(Oid OIDNewHeap, Oid OIDOldHeap, Oid OIDOldIndex,
 			   bool verbose, bool *pSwapToastByContent,
 			   TransactionId *pFreezeXid, MultiXactId *pCutoffMulti);
 static List *get_tables_to_cluster(MemoryContext cluster_context);
+static void copy_attribute_options(Relation OldHeap, Oid OIDNewHeap);
 static void reform_and_rewrite_tuple(HeapTuple tuple,
 						 TupleDesc oldTupDesc, TupleDesc newTupDesc,
-						 Datum *values, bool *isnull,
+						 Datum *values, bool *isnull, int *cmethods,
 						 RewriteState rwstate);
+static bool cluster_tuple_is_dead(Relation OldHeap, HeapTuple tuple,
+					  Buffer buf, TransactionId OldestXmin,
+					  bool is_system_catalog, double *tups_recently_dead);
+static ParallelContext *cluster_begin_parallel(Relation OldHeap,
+					   Relation OldIndex, TransactionId OldestXmin,
+					   ClusterShared **shared, Sharedsort **sharedsort);
+static void cluster_parallel_scan_and_sort(Relation OldHeap,
+							   Relation OldIndex, ClusterShared *shared,
+							   Sharedsort *sharedsort, int sortmem);
 
 
 /*---------------------------------------------------------------------------
@@ -705,6 +757,12 @@ make_new_heap(Oid OIDOldHeap, Oid NewTableSpace, char relpersistence,
 	 */
 	CommandCounterIncrement();
 
+	/*
+	 * Per-column options are needed too, so that values toasted while the
+	 * new heap is being filled get the column's compression method.
+	 */
+	copy_attribute_options(OldHeap, OIDNewHeap);
+
 	/*
 	 * If necessary, create a TOAST table for the new relation.
 	 *
@@ -738,6 +796,73 @@ make_new_heap(Oid OIDOldHeap, Oid NewTableSpace, char relpersistence,
 	return OIDNewHeap;
 }
 
+/*
+ * Copy the per-column options (pg_attribute.attoptions) of OldHeap to the
+ * transient heap built to replace it.
+ */
+static void
+copy_attribute_options(Relation OldHeap, Oid OIDNewHeap)
+{
+	TupleDesc	tupdesc = RelationGetDescr(OldHeap);
+	Relation	attrelation = NULL;
+	int			attnum;
+
+	for (attnum = 1; attnum <= tupdesc->natts; attnum++)
+	{
+		HeapTuple	oldtuple;
+		HeapTuple	tuple;
+		HeapTuple	newtuple;
+		Datum		attoptions;
+		bool		isnull;
+		Datum		repl_val[Natts_pg_attribute];
+		bool		repl_null[Natts_pg_attribute];
+		bool		repl_repl[Natts_pg_attribute];
+
+		if (TupleDescAttr(tupdesc, attnum - 1)->attisdropped)
+			continue;
+
+		oldtuple = SearchSysCache2(ATTNUM,
+								   ObjectIdGetDatum(RelationGetRelid(OldHeap)),
+								   Int16GetDatum(attnum));
+		if (!HeapTupleIsValid(oldtuple))
+			elog(ERROR, "cache lookup failed for attribute %d of relation %u",
+				 attnum, RelationGetRelid(OldHeap));
+		attoptions = SysCacheGetAttr(ATTNUM, oldtuple,
+									 Anum_pg_attribute_attoptions, &isnull);
+		if (isnull)
+		{
+			ReleaseSysCache(oldtuple);
+			continue;
+		}
+
+		if (attrelation == NULL)
+			attrelation = heap_open(AttributeRelationId, RowExclusiveLock);
+
+		tuple = SearchSysCacheCopyAttNum(OIDNewHeap, attnum);
+		if (!HeapTupleIsValid(tuple))
+			elog(ERROR, "cache lookup failed for attribute %d of relation %u",
+				 attnum, OIDNewHeap);
+
+		memset(repl_null, false, sizeof(repl_null));
+		memset(repl_repl, false, sizeof(repl_repl));
+		repl_val[Anum_pg_attribute_attoptions - 1] = attoptions;
+		repl_repl[Anum_pg_attribute_attoptions - 1] = true;
+		newtuple = heap_modify_tuple(tuple, RelationGetDescr(attrelation),
+									 repl_val, repl_null, repl_repl);
+		CatalogTupleUpdate(attrelation, &newtuple->t_self, newtuple);
+
+		heap_freetuple(newtuple);
+		heap_freetuple(tuple);
+		ReleaseSysCache(oldtuple);
+	}
+
+	if (attrelation != NULL)
+	{
+		heap_close(attrelation, RowExclusiveLock);
+		CommandCounterIncrement();
+	}
+}
+
 /*
  * Do the physical copying of heap data.
  *
@@ -762,6 +887,8 @@ copy_heap_data(Oid OIDNewHeap, Oid OIDOldHeap, Oid OIDOldIndex, bool verbose,
 	int			natts;
 	Datum	   *values;
 	bool	   *isnull;
+	int		   *cmethods;
+	int			i;
 	IndexScanDesc indexScan;
 	HeapScanDesc heapScan;
 	bool		use_wal;
@@ -772,6 +899,9 @@ copy_heap_data(Oid OIDNewHeap, Oid OIDOldHeap, Oid OIDOldIndex, bool verbose,
 	RewriteState rwstate;
 	bool		use_sort;
 	Tuplesortstate *tuplesort;
+	ParallelContext *pcxt = NULL;
+	ClusterShared *cshared = NULL;
+	Sharedsort *sharedsort = NULL;
 	double		num_tuples = 0,
 				tups_vacuumed = 0,
 				tups_recently_dead = 0;
@@ -804,6 +934,22 @@ copy_heap_data(Oid OIDNewHeap, Oid OIDOldHeap, Oid OIDOldIndex, bool verbose,
 	values = (Datum *) palloc(natts * sizeof(Datum));
 	isnull = (bool *) palloc(natts * sizeof(bool));
 
+	/*
+	 * Look up the compression method each varlena column's values should
+	 * have, so that values compressed with some other method can be
+	 * recompressed on the way.
+	 */
+	cmethods = (int *) palloc(natts * sizeof(int));
+	for (i = 0; i < natts; i++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(newTupDesc, i);
+
+		if (attr->attlen == -1 && !attr->attisdropped)
+			cmethods[i] = toast_get_compression_method(NewHeap, i + 1);
+		else
+			cmethods[i] = TOAST_INVALID_COMPRESSION_ID;
+	}
+
 	/*
 	 * If the OldHeap has a toast table, get lock on the toast table to keep
 	 * it from being vacuumed.  This is needed because autovacuum processes
@@ -908,8 +1054,33 @@ copy_heap_data(Oid OIDNewHeap, Oid OIDOldHeap, Oid OIDOldIndex, bool verbose,
 	else
 		use_sort = false;
 
+	/*
+	 * When sorting, try to have parallel workers scan and sort the OldHeap,
+	 * if the planner thinks a parallel build of the index would be useful.
+	 * We don't try that for system catalogs, which are expected to be small
+	 * anyway.  If workers are launched, they and we have already scanned the
+	 * whole heap into the shared tuplesort when this returns.
+	 */
+	if (use_sort && !is_system_catalog)
+		pcxt = cluster_begin_parallel(OldHeap, OldIndex, OldestXmin,
+									  &cshared, &sharedsort);
+
 	/* Set up sorting if wanted */
-	if (use_sort)
+	if (pcxt != NULL)
+	{
+		SortCoordinate coordinate;
+
+		/* Leader tuplesort merges the participants' sorted runs */
+		coordinate = (SortCoordinate) palloc0(sizeof(SortCoordinateData));
+		coordinate->isWorker = false;
+		coordinate->nParticipants = pcxt->nworkers_launched + 1;
+		coordinate->sharedsort = sharedsort;
+
+		tuplesort = tuplesort_begin_cluster(oldTupDesc, OldIndex,
+											maintenance_work_mem,
+											coordinate, false);
+	}
+	else if (use_sort)
 		tuplesort = tuplesort_begin_cluster(oldTupDesc, OldIndex,
 											maintenance_work_mem,
 											NULL, false);
@@ -921,7 +1092,12 @@ copy_heap_data(Oid OIDNewHeap, Oid OIDOldHeap, Oid OIDOldIndex, bool verbose,
 	 * that still need to be copied, we scan with SnapshotAny and use
 	 * HeapTupleSatisfiesVacuum for the visibility test.
 	 */
-	if (OldIndex != NULL && !use_sort)
+	if (pcxt != NULL)
+	{
+		heapScan = NULL;
+		indexScan = NULL;
+	}
+	else if (OldIndex != NULL && !use_sort)
 	{
 		heapScan = NULL;
 		indexScan = index_beginscan(OldHeap, OldIndex, SnapshotAny, 0, 0);
@@ -940,6 +1116,12 @@ copy_heap_data(Oid OIDNewHeap, Oid OIDOldHeap, Oid OIDOldIndex, bool verbose,
 						get_namespace_name(RelationGetNamespace(OldHeap)),
 						RelationGetRelationName(OldHeap),
 						RelationGetRelationName(OldIndex))));
+	else if (pcxt != NULL)
+		ereport(elevel,
+				(errmsg("clustering \"%s.%s\" using parallel sequential scan and sort with %d workers",
+						get_namespace_name(RelationGetNamespace(OldHeap)),
+						RelationGetRelationName(OldHeap),
+						pcxt->nworkers_launched)));
 	else if (tuplesort != NULL)
 		ereport(elevel,
 				(errmsg("clustering \"%s.%s\" using sequential scan and sort",
@@ -951,13 +1133,26 @@ copy_heap_data(Oid OIDNewHeap, Oid OIDOldHeap, Oid OIDOldIndex, bool verbose,
 						get_namespace_name(RelationGetNamespace(OldHeap)),
 						RelationGetRelationName(OldHeap))));
 
+	/*
+	 * In parallel mode, wait for the workers to finish their sorts, and
+	 * collect their and our counts.  Any error raised by a worker is
+	 * rethrown here.
+	 */
+	if (pcxt != NULL)
+	{
+		WaitForParallelWorkersToFinish(pcxt);
+		num_tuples = cshared->num_tuples;
+		tups_vacuumed = cshared->tups_vacuumed;
+		tups_recently_dead = cshared->tups_recently_dead;
+	}
+
 	/*
 	 * Scan through the OldHeap, either in OldIndex order or sequentially;
 	 * copy each tuple into the NewHeap, or transiently to the tuplesort
 	 * module.  Note that we don't bother sorting dead tuples (they won't get
 	 * to the new table anyway).
 	 */
-	for (;;)
+	while (heapScan != NULL || indexScan != NULL)
 	{
 		HeapTuple	tuple;
 		Buffer		buf;
@@ -986,58 +1181,8 @@ copy_heap_data(Oid OIDNewHeap, Oid OIDOldHeap, Oid OIDOldIndex, bool verbose,
 			buf = heapScan->rs_cbuf;
 		}
 
-		LockBuffer(buf, BUFFER_LOCK_SHARE);
-
-		switch (HeapTupleSatisfiesVacuum(tuple, OldestXmin, buf))
-		{
-			case HEAPTUPLE_DEAD:
-				/* Definitely dead */
-				isdead = true;
-				break;
-			case HEAPTUPLE_RECENTLY_DEAD:
-				tups_recently_dead += 1;
-				/* fall through */
-			case HEAPTUPLE_LIVE:
-				/* Live or recently dead, must copy it */
-				isdead = false;
-				break;
-			case HEAPTUPLE_INSERT_IN_PROGRESS:
-
-				/*
-				 * Since we hold exclusive lock on the relation, normally the
-				 * only way to see this is if it was inserted earlier in our
-				 * own transaction.  However, it can happen in system
-				 * catalogs, since we tend to release write lock before commit
-				 * there.  Give a warning if neither case applies; but in any
-				 * case we had better copy it.
-				 */
-				if (!is_system_catalog &&
-					!TransactionIdIsCurrentTransactionId(HeapTupleHeaderGetXmin(tuple->t_data)))
-					elog(WARNING, "concurrent insert in progress within table \"%s\"",
-						 RelationGetRelationName(OldHeap));
-				/* treat as live */
-				isdead = false;
-				break;
-			case HEAPTUPLE_DELETE_IN_PROGRESS:
-
-				/*
-				 * Similar situation to INSERT_IN_PROGRESS case.
-				 */
-				if (!is_system_catalog &&
-					!TransactionIdIsCurrentTransactionId(HeapTupleHeaderGetUpdateXid(tuple->t_data)))
-					elog(WARNING, "concurrent delete in progress within table \"%s\"",
-						 RelationGetRelationName(OldHeap));
-				/* treat as recently dead */
-				tups_recently_dead += 1;
-				isdead = false;
-				break;
-			default:
-				elog(ERROR, "unexpected HeapTupleSatisfiesVacuum result");
-				isdead = false; /* keep compiler quiet */
-				break;
-		}
-
-		LockBuffer(buf, BUFFER_LOCK_UNLOCK);
+		isdead = cluster_tuple_is_dead(OldHeap, tuple, buf, OldestXmin,
+									   is_system_catalog, &tups_recently_dead);
 
 		if (isdead)
 		{
@@ -1058,7 +1203,7 @@ copy_heap_data(Oid OIDNewHeap, Oid OIDOldHeap, Oid OIDOldIndex, bool verbose,
 		else
 			reform_and_rewrite_tuple(tuple,
 									 oldTupDesc, newTupDesc,
-									 values, isnull,
+									 values, isnull, cmethods,
 									 rwstate);
 	}
 
@@ -1087,13 +1232,20 @@ copy_heap_data(Oid OIDNewHeap, Oid OIDOldHeap, Oid OIDOldIndex, bool verbose,
 
 			reform_and_rewrite_tuple(tuple,
 									 oldTupDesc, newTupDesc,
-									 values, isnull,
+									 values, isnull, cmethods,
 									 rwstate);
 		}
 
 		tuplesort_end(tuplesort);
 	}
 
+	/* Shut down parallel workers' context now that the sort is consumed */
+	if (pcxt != NULL)
+	{
+		DestroyParallelContext(pcxt);
+		ExitParallelMode();
+	}
+
 	/* Write out any remaining tuples, and fsync if needed */
 	end_heap_rewrite(rwstate);
 
@@ -1147,6 +1299,259 @@ copy_heap_data(Oid OIDNewHeap, Oid OIDOldHeap, Oid OIDOldIndex, bool verbose,
 	CommandCounterIncrement();
 }
 
+/*
+ * Decide whether a tuple of the old heap, seen by a CLUSTER or VACUUM FULL
+ * scan, is dead and can be dropped.  Caller must hold a pin on buf.
+ *
+ * Also counts recently-dead tuples into *tups_recently_dead.
+ */
+static bool
+cluster_tuple_is_dead(Relation OldHeap, HeapTuple tuple, Buffer buf,
+					  TransactionId OldestXmin, bool is_system_catalog,
+					  double *tups_recently_dead)
+{
+	bool		isdead;
+
+	LockBuffer(buf, BUFFER_LOCK_SHARE);
+
+	switch (HeapTupleSatisfiesVacuum(tuple, OldestXmin, buf))
+	{
+		case HEAPTUPLE_DEAD:
+			/* Definitely dead */
+			isdead = true;
+			break;
+		case HEAPTUPLE_RECENTLY_DEAD:
+			*tups_recently_dead += 1;
+			/* fall through */
+		case HEAPTUPLE_LIVE:
+			/* Live or recently dead, must copy it */
+			isdead = false;
+			break;
+		case HEAPTUPLE_INSERT_IN_PROGRESS:
+
+			/*
+			 * Since we hold exclusive lock on the relation, normally the only
+			 * way to see this is if it was inserted earlier in our own
+			 * transaction.  However, it can happen in system catalogs, since
+			 * we tend to release write lock before commit there.  Give a
+			 * warning if neither case applies; but in any case we had better
+			 * copy it.
+			 */
+			if (!is_system_catalog &&
+				!TransactionIdIsCurrentTransactionId(HeapTupleHeaderGetXmin(tuple->t_data)))
+				elog(WARNING, "concurrent insert in progress within table \"%s\"",
+					 RelationGetRelationName(OldHeap));
+			/* treat as live */
+			isdead = false;
+			break;
+		case HEAPTUPLE_DELETE_IN_PROGRESS:
+
+			/*
+			 * Similar situation to INSERT_IN_PROGRESS case.
+			 */
+			if (!is_system_catalog &&
+				!TransactionIdIsCurrentTransactionId(HeapTupleHeaderGetUpdateXid(tuple->t_data)))
+				elog(WARNING, "concurrent delete in progress within table \"%s\"",
+					 RelationGetRelationName(OldHeap));
+			/* treat as recently dead */
+			*tups_recently_dead += 1;
+			isdead = false;
+			break;
+		default:
+			elog(ERROR, "unexpected HeapTupleSatisfiesVacuum result");
+			isdead = false;		/* keep compiler quiet */
+			break;
+	}
+
+	LockBuffer(buf, BUFFER_LOCK_UNLOCK);
+
+	return isdead;
+}
+
+/*
+ * Try to launch parallel workers to scan and sort OldHeap for a
+ * seqscan-and-sort CLUSTER.  The number of workers is chosen as for a
+ * parallel CREATE INDEX of OldIndex, so max_parallel_maintenance_workers
+ * applies.
+ *
+ * If workers were launched, the leader has taken its own share of the scan
+ * by the time this returns, and the shared state is returned in *shared and
+ * *sharedsort.  Caller must then wait for the workers, merge their sorted
+ * runs with a leader tuplesort, and finally destroy the returned context
+ * and exit parallel mode.  Returns NULL (and leaves parallel mode) if no
+ * workers could be used.
+ *
+ * Unlike the serial scan, this does not tell the heap rewrite module about
+ * dead tuples.  That only allows it to discard recently-dead tuples whose
+ * successors turn out to be dead; end_heap_rewrite() still copies any such
+ * tuples left over, which is safe.
+ */
+static ParallelContext *
+cluster_begin_parallel(Relation OldHeap, Relation OldIndex,
+					   TransactionId OldestXmin,
+					   ClusterShared **shared, Sharedsort **sharedsort)
+{
+	ParallelContext *pcxt;
+	ClusterShared *cshared;
+	Sharedsort *csharedsort;
+	Size		estsort;
+	int			request;
+
+	/* Nested parallelism isn't possible */
+	if (IsInParallelMode())
+		return NULL;
+
+	request = plan_create_index_workers(RelationGetRelid(OldHeap),
+										RelationGetRelid(OldIndex));
+	if (request <= 0)
+		return NULL;
+
+	EnterParallelMode();
+	pcxt = CreateParallelContext("postgres", "cluster_parallel_main",
+								 request, true);
+
+	/* Estimate space for shared state and for the shared tuplesort */
+	shm_toc_estimate_chunk(&pcxt->estimator, sizeof(ClusterShared));
+	estsort = tuplesort_estimate_shared(request + 1);
+	shm_toc_estimate_chunk(&pcxt->estimator, estsort);
+	shm_toc_estimate_keys(&pcxt->estimator, 2);
+
+	InitializeParallelDSM(pcxt);
+
+	cshared = (ClusterShared *) shm_toc_allocate(pcxt->toc,
+												 sizeof(ClusterShared));
+	cshared->heaprelid = RelationGetRelid(OldHeap);
+	cshared->indexrelid = RelationGetRelid(OldIndex);
+	cshared->OldestXmin = OldestXmin;
+	cshared->scantuplesortstates = request + 1;
+	SpinLockInit(&cshared->mutex);
+	cshared->num_tuples = 0;
+	cshared->tups_vacuumed = 0;
+	cshared->tups_recently_dead = 0;
+	heap_parallelscan_initialize(&cshared->heapdesc, OldHeap, SnapshotAny);
+
+	csharedsort = (Sharedsort *) shm_toc_allocate(pcxt->toc, estsort);
+	tuplesort_initialize_shared(csharedsort, request + 1, pcxt->seg);
+
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_CLUSTER_SHARED, cshared);
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_TUPLESORT, csharedsort);
+
+	LaunchParallelWorkers(pcxt);
+
+	/* If no workers were successfully launched, back out (do serial sort) */
+	if (pcxt->nworkers_launched == 0)
+	{
+		WaitForParallelWorkersToFinish(pcxt);
+		DestroyParallelContext(pcxt);
+		ExitParallelMode();
+		return NULL;
+	}
+
+	/* Join heap scan ourselves */
+	cluster_parallel_scan_and_sort(OldHeap, OldIndex, cshared, csharedsort,
+								   maintenance_work_mem /
+								   cshared->scantuplesortstates);
+
+	/*
+	 * Caller needs to wait for all launched workers.  Make sure that the
+	 * failure-to-start case will not hang forever.
+	 */
+	WaitForParallelWorkersToAttach(pcxt);
+
+	*shared = cshared;
+	*sharedsort = csharedsort;
+	return pcxt;
+}
+
+/*
+ * Perform work within a launched parallel process, for a parallel
+ * seqscan-and-sort CLUSTER.
+ */
+void
+cluster_parallel_main(dsm_segment *seg, shm_toc *toc)
+{
+	ClusterShared *shared;
+	Sharedsort *sharedsort;
+	Relation	OldHeap;
+	Relation	OldIndex;
+
+	shared = shm_toc_lookup(toc, PARALLEL_KEY_CLUSTER_SHARED, false);
+
+	/*
+	 * The leader holds AccessExclusiveLock on both relations; thanks to
+	 * group locking, a weaker lock is all we need to open them here.
+	 */
+	OldHeap = heap_open(shared->heaprelid, AccessShareLock);
+	OldIndex = index_open(shared->indexrelid, AccessShareLock);
+
+	sharedsort = shm_toc_lookup(toc, PARALLEL_KEY_TUPLESORT, false);
+	tuplesort_attach_shared(sharedsort, seg);
+
+	cluster_parallel_scan_and_sort(OldHeap, OldIndex, shared, sharedsort,
+								   maintenance_work_mem /
+								   shared->scantuplesortstates);
+
+	index_close(OldIndex, AccessShareLock);
+	heap_close(OldHeap, AccessShareLock);
+}
+
+/*
+ * Perform a participant's share of a parallel seqscan-and-sort CLUSTER:
+ * scan blocks from the parallel heap scan, and sort the tuples that must be
+ * kept into a worker tuplesort.  sortmem is in KB.
+ */
+static void
+cluster_parallel_scan_and_sort(Relation OldHeap, Relation OldIndex,
+							   ClusterShared *shared, Sharedsort *sharedsort,
+							   int sortmem)
+{
+	SortCoordinate coordinate;
+	Tuplesortstate *tuplesort;
+	HeapScanDesc heapScan;
+	HeapTuple	tuple;
+	double		num_tuples = 0,
+				tups_vacuumed = 0,
+				tups_recently_dead = 0;
+
+	coordinate = (SortCoordinate) palloc0(sizeof(SortCoordinateData));
+	coordinate->isWorker = true;
+	coordinate->nParticipants = -1;
+	coordinate->sharedsort = sharedsort;
+
+	tuplesort = tuplesort_begin_cluster(RelationGetDescr(OldHeap), OldIndex,
+										Max(sortmem, 64), coordinate, false);
+
+	heapScan = heap_beginscan_parallel(OldHeap, &shared->heapdesc);
+
+	while ((tuple = heap_getnext(heapScan, ForwardScanDirection)) != NULL)
+	{
+		CHECK_FOR_INTERRUPTS();
+
+		if (cluster_tuple_is_dead(OldHeap, tuple, heapScan->rs_cbuf,
+								  shared->OldestXmin, false,
+								  &tups_recently_dead))
+		{
+			tups_vacuumed += 1;
+			continue;
+		}
+
+		num_tuples += 1;
+		tuplesort_putheaptuple(tuplesort, tuple);
+	}
+
+	heap_endscan(heapScan);
+
+	/* Sort our runs, and leave them for the leader to merge */
+	tuplesort_performsort(tuplesort);
+	tuplesort_end(tuplesort);
+
+	SpinLockAcquire(&shared->mutex);
+	shared->num_tuples += num_tuples;
+	shared->tups_vacuumed += tups_vacuumed;
+	shared->tups_recently_dead += tups_recently_dead;
+	SpinLockRelease(&shared->mutex);
+}
+
 /*
  * Swap the physical files of two given relations.
  *
@@ -1756,27 +2161,56 @@ get_tables_to_cluster(MemoryContext cluster_context)
  * SET WITHOUT OIDS (in an older version, via pg_upgrade).
  *
  * So, we must reconstruct the tuple from component Datums.
+ *
+ * While at it, values compressed with a method other than their column's
+ * current one (cmethods[]) are decompressed, so that the toaster compresses
+ * them afresh when the new tuple is stored.  That is how a change of a
+ * column's compression option gets applied to existing data.
  */
 static void
 reform_and_rewrite_tuple(HeapTuple tuple,
 						 TupleDesc oldTupDesc, TupleDesc newTupDesc,
-						 Datum *values, bool *isnull,
+						 Datum *values, bool *isnull, int *cmethods,
 						 RewriteState rwstate)
 {
 	HeapTuple	copiedTuple;
+	bool		decompressed[MaxTupleAttributeNumber];
+	bool		any_decompressed = false;
 	int			i;
 
 	heap_deform_tuple(tuple, oldTupDesc, values, isnull);
 
-	/* Be sure to null out any dropped columns */
 	for (i = 0; i < newTupDesc->natts; i++)
 	{
+		decompressed[i] = false;
+
+		/* Be sure to null out any dropped columns */
 		if (TupleDescAttr(newTupDesc, i)->attisdropped)
 			isnull[i] = true;
+		else if (!isnull[i] && cmethods[i] != TOAST_INVALID_COMPRESSION_ID)
+		{
+			struct varlena *attr = (struct varlena *) DatumGetPointer(values[i]);
+			int			cmid = toast_get_compression_id(attr);
+
+			if (cmid != TOAST_INVALID_COMPRESSION_ID && cmid != cmethods[i])
+			{
+				values[i] = PointerGetDatum(heap_tuple_untoast_attr(attr));
+				decompressed[i] = any_decompressed = true;
+			}
+		}
 	}
 
 	copiedTuple = heap_form_tuple(newTupDesc, values, isnull);
 
+	if (any_decompressed)
+	{
+		for (i = 0; i < newTupDesc->natts; i++)
+		{
+			if (decompressed[i])
+				pfree(DatumGetPointer(values[i]));
+		}
+	}
+
 	/* The heap rewrite module does the rest */
 	rewrite_heap_tuple(rwstate, tuple, copiedTuple);
 
@@ -20,17 +20,20 @@
 
 #include "access/heapam.h"
 #include "access/htup_details.h"
+#include "access/parallel.h"
 #include "access/sysattr.h"
 #include "access/xact.h"
 #include "access/xlog.h"
 #include "catalog/dependency.h"
 #include "catalog/pg_authid.h"
+#include "catalog/pg_proc.h"
 #include "catalog/pg_type.h"
 #include "commands/copy.h"
 #include "commands/defrem.h"
 #include "commands/trigger.h"
 #include "executor/execPartition.h"
 #include "executor/executor.h"
+#include "executor/nodeModifyTable.h"
 #include "executor/tuptable.h"
 #include "foreign/fdwapi.h"
 #include "libpq/libpq.h"
@@ -41,11 +44,15 @@
 #include "optimizer/planner.h"
 #include "nodes/makefuncs.h"
 #include "parser/parse_relation.h"
+#include "pgstat.h"
 #include "port/pg_bswap.h"
+#include "port/simd.h"
+#include "postmaster/bgworker_internals.h"
 #include "rewrite/rewriteHandler.h"
 #include "storage/fd.h"
 #include "tcop/tcopprot.h"
 #include "utils/builtins.h"
+#include "utils/fmgroids.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/partcache.h"
@@ -91,6 +98,44 @@ typedef enum CopyInsertMethod
 	CIM_MULTI_CONDITIONAL		/* use heap_multi_insert only if valid */
 } CopyInsertMethod;
 
+/*
+ * Limits on the tuples buffered for heap_multi_insert.  All buffers are
+ * flushed together once MAX_BUFFERED_TUPLES tuples or MAX_BUFFERED_BYTES
+ * bytes of tuple data have been buffered across them, and when a buffer is
+ * needed for a partition after MAX_PARTITION_BUFFERS partitions already have
+ * one.
+ */
+#define MAX_BUFFERED_TUPLES		1000
+#define MAX_BUFFERED_BYTES		65535
+#define MAX_PARTITION_BUFFERS	32
+
+/*
+ * Tuples waiting to be inserted into one relation with heap_multi_insert.
+ */
+typedef struct CopyMultiInsertBuffer
+{
+	ResultRelInfo *resultRelInfo;	/* relation the tuples go into */
+	int			ntuples;		/* number of tuples buffered */
+	HeapTuple	tuples[MAX_BUFFERED_TUPLES];	/* buffered tuples */
+	uint64		linenos[MAX_BUFFERED_TUPLES];	/* their input line numbers */
+} CopyMultiInsertBuffer;
+
+/*
+ * The set of multi-insert buffers of a COPY FROM.  A plain table has just one
+ * buffer.  When loading a partitioned table, each partition that tuples are
+ * routed to gets a buffer of its own, so that interleaved input still leads
+ * to reasonably large batches; routed tuples are copied into 'context' so
+ * that they survive the per-tuple memory context being reset.
+ */
+typedef struct CopyMultiInsertInfo
+{
+	CopyMultiInsertBuffer *buffers[MAX_PARTITION_BUFFERS];
+	int			nbuffers;		/* number of buffers in use */
+	int			ntuples;		/* tuples buffered, over all buffers */
+	Size		nbytes;			/* size of those tuples */
+	MemoryContext context;		/* holds routed tuples, or NULL */
+} CopyMultiInsertInfo;
+
 /*
  * This struct contains all the state variables used throughout a COPY
  * operation. For simplicity, we use the same struct for all variants of COPY,
@@ -149,6 +194,7 @@ typedef struct CopyStateData
 	bool		convert_selectively;	/* do selective binary conversion? */
 	List	   *convert_select; /* list of column names (can be NIL) */
 	bool	   *convert_select_flags;	/* per-column CSV/TEXT CS flags */
+	int			parallel_workers;	/* # of workers for PARALLEL, 0 if none */
 
 	/* these are just for error messages, see CopyFromErrorCallback */
 	const char *cur_relname;	/* table name for error messages */
@@ -179,6 +225,8 @@ typedef struct CopyStateData
 	ExprState **defexprs;		/* array of default att expressions */
 	bool		volatile_defexprs;	/* is any of defexprs volatile? */
 	List	   *range_table;
+	char	   *worker_options; /* column list and options for parallel
+								 * workers, as a node string */
 
 	TransitionCaptureState *transition_capture;
 
@@ -221,6 +269,65 @@ typedef struct CopyStateData
 	int			raw_buf_len;	/* total # of bytes stored */
 } CopyStateData;
 
+/*
+ * Parallel COPY FROM.
+ *
+ * The leader reads the input and cuts it into chunks of whole records, which
+ * it hands out to the workers in turn through one shm_mq per worker.  Each
+ * worker runs the usual COPY FROM input code over the concatenation of its
+ * chunks, forms heap tuples and sends them back through a second shm_mq,
+ * preceded by their line number.  The leader inserts them into the table;
+ * workers can't, since tuples can't be inserted in a parallel worker.  The
+ * leader doesn't need to understand the input format beyond finding record
+ * boundaries, which it can do byte by byte as long as the client encoding
+ * does not embed ASCII bytes in multibyte characters.
+ */
+#define PARALLEL_COPY_KEY_SHARED		UINT64CONST(0xC000000000000001)
+#define PARALLEL_COPY_KEY_OPTIONS		UINT64CONST(0xC000000000000002)
+#define PARALLEL_COPY_KEY_QUEUES		UINT64CONST(0xC000000000000003)
+#define PARALLEL_COPY_KEY_QUERY_TEXT	UINT64CONST(0xC000000000000004)
+
+/* target size of the chunks of input handed to workers */
+#define PARALLEL_COPY_CHUNK_SIZE		65536
+/* size of each input and output queue */
+#define PARALLEL_COPY_QUEUE_SIZE		(4 * PARALLEL_COPY_CHUNK_SIZE)
+
+/* Shared state for parallel COPY FROM */
+typedef struct ParallelCopyShared
+{
+	Oid			relid;			/* relation being loaded */
+} ParallelCopyShared;
+
+/* Leader's state for parallel COPY FROM */
+typedef struct ParallelCopyLeader
+{
+	ParallelContext *pcxt;
+	int			nworkers;		/* number of workers launched */
+	shm_mq_handle **inqh;		/* per-worker queues of input chunks */
+	shm_mq_handle **outqh;		/* per-worker queues of formed tuples */
+	bool	   *worker_done;	/* has worker detached from its output? */
+	int			nworkers_done;
+	int			nextreader;		/* worker to try for the next tuple */
+	int			nextwriter;		/* worker to send the next chunk to */
+
+	/* the next chunk: its first line number, followed by the input data */
+	StringInfoData chunk;
+	bool		chunk_ready;	/* chunk waiting to be sent? */
+	bool		input_done;		/* no more chunks to make? */
+	bool		inputs_closed;	/* detached from all input queues? */
+
+	/* state of the scan for record boundaries */
+	uint64		lineno;			/* lines seen so far */
+	bool		skip_header;	/* header line not skipped yet? */
+	bool		line_start;		/* at the start of a record? */
+	bool		after_cr;		/* just saw a CR that may end a record? */
+	bool		in_quote;		/* CSV: inside a quoted field? */
+	bool		last_was_esc;	/* CSV: last byte was an escape in quotes? */
+	bool		escaped;		/* text: last byte was a backslash? */
+	int			marker_state;	/* CSV: bytes of "\." seen at record start */
+	bool		seen_marker;	/* found the end-of-copy marker \. ? */
+} ParallelCopyLeader;
+
 /* DestReceiver for COPY (query) TO */
 typedef struct
 {
@@ -312,12 +419,23 @@ static uint64 DoCopyTo(CopyState cstate);
 static uint64 CopyTo(CopyState cstate);
 static void CopyOneRowTo(CopyState cstate,
 			 Datum *values, bool *nulls);
+static bool CopyFromParallelOK(CopyState cstate);
+static ParallelCopyLeader *BeginParallelCopy(CopyState cstate);
+static HeapTuple ParallelCopyNextTuple(CopyState cstate,
+					  ParallelCopyLeader *pcl);
+static void EndParallelCopy(ParallelCopyLeader *pcl);
 static void CopyFromInsertBatch(CopyState cstate, EState *estate,
 					CommandId mycid, int hi_options,
 					ResultRelInfo *resultRelInfo, TupleTableSlot *myslot,
 					BulkInsertState bistate,
 					int nBufferedTuples, HeapTuple *bufferedTuples,
-					uint64 firstBufferedLineNo);
+					uint64 *bufferedLineNos);
+static CopyMultiInsertBuffer *CopyMultiInsertInfoGetBuffer(CopyMultiInsertInfo *minfo,
+							 ResultRelInfo *resultRelInfo);
+static void CopyMultiInsertInfoFlush(CopyState cstate, EState *estate,
+						 CommandId mycid, int hi_options,
+						 TupleTableSlot *myslot, BulkInsertState bistate,
+						 CopyMultiInsertInfo *minfo);
 static bool CopyReadLine(CopyState cstate);
 static bool CopyReadLineText(CopyState cstate);
 static int	CopyReadAttributesText(CopyState cstate);
@@ -326,6 +444,7 @@ static Datum CopyReadBinaryAttribute(CopyState cstate,
 						int column_no, FmgrInfo *flinfo,
 						Oid typioparam, int32 typmod,
 						bool *isnull);
+static void CopyReadBinaryData(CopyState cstate, char *dest, int size);
 static void CopyAttributeOutText(CopyState cstate, char *string);
 static void CopyAttributeOutCSV(CopyState cstate, char *string,
 					bool use_quote, bool single_attr);
@@ -1046,6 +1165,7 @@ ProcessCopyOptions(ParseState *pstate,
 				   List *options)
 {
 	bool		format_specified = false;
+	bool		parallel_specified = false;
 	ListCell   *option;
 
 	/* Support external use for option sanity checking */
@@ -1208,6 +1328,23 @@ ProcessCopyOptions(ParseState *pstate,
 								defel->defname),
 						 parser_errposition(pstate, defel->location)));
 		}
+		else if (strcmp(defel->defname, "parallel") == 0)
+		{
+			if (parallel_specified)
+				ereport(ERROR,
+						(errcode(ERRCODE_SYNTAX_ERROR),
+						 errmsg("conflicting or redundant options"),
+						 parser_errposition(pstate, defel->location)));
+			parallel_specified = true;
+			cstate->parallel_workers = defGetInt32(defel);
+			if (cstate->parallel_workers < 0 ||
+				cstate->parallel_workers > MAX_PARALLEL_WORKER_LIMIT)
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+						 errmsg("argument to option \"%s\" must be between %d and %d",
+								defel->defname, 0, MAX_PARALLEL_WORKER_LIMIT),
+						 parser_errposition(pstate, defel->location)));
+		}
 		else if (strcmp(defel->defname, "encoding") == 0)
 		{
 			if (cstate->file_encoding >= 0)
@@ -1361,6 +1498,12 @@ ProcessCopyOptions(ParseState *pstate,
 				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
 				 errmsg("COPY force null only available using COPY FROM")));
 
+	/* Check parallel */
+	if (cstate->parallel_workers > 0 && !is_from)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("COPY parallel only available using COPY FROM")));
+
 	/* Don't allow the delimiter to appear in the null string. */
 	if (strchr(cstate->null_print, cstate->delim[0]) != NULL)
 		ereport(ERROR,
@@ -2297,26 +2440,18 @@ CopyFrom(CopyState cstate)
 	MemoryContext oldcontext = CurrentMemoryContext;
 
 	PartitionTupleRouting *proute = NULL;
-	ExprContext *secondaryExprContext = NULL;
 	ErrorContextCallback errcallback;
 	CommandId	mycid = GetCurrentCommandId(true);
 	int			hi_options = 0; /* start with default heap_insert options */
 	BulkInsertState bistate;
 	CopyInsertMethod insertMethod;
 	uint64		processed = 0;
-	int			nBufferedTuples = 0;
 	bool		has_before_insert_row_trig;
 	bool		has_instead_insert_row_trig;
 	bool		leafpart_use_multi_insert = false;
-
-#define MAX_BUFFERED_TUPLES 1000
-#define RECHECK_MULTI_INSERT_THRESHOLD 1000
-	HeapTuple  *bufferedTuples = NULL;	/* initialize to silence warning */
-	Size		bufferedTuplesSize = 0;
-	uint64		firstBufferedLineNo = 0;
-	uint64		lastPartitionSampleLineNo = 0;
-	uint64		nPartitionChanges = 0;
-	double		avgTuplesPerPartChange = 0;
+	ParallelCopyLeader *pcl = NULL;
+	CopyMultiInsertInfo minfo;
+	CopyMultiInsertBuffer *curbuffer = NULL;
 
 	Assert(cstate->rel);
 
@@ -2528,6 +2663,11 @@ CopyFrom(CopyState cstate)
 								   RelationGetRelid(cstate->rel),
 								   CMD_INSERT);
 
+	/* A foreign table may take the rows in batches */
+	if (resultRelInfo->ri_FdwRoutine != NULL)
+		resultRelInfo->ri_BatchSize = ExecForeignBatchSize(mtstate,
+														   resultRelInfo);
+
 	/*
 	 * If the named relation is a partitioned table, initialize state for
 	 * CopyFrom tuple routing.
@@ -2595,29 +2735,26 @@ CopyFrom(CopyState cstate)
 		 * flag that we must later determine if we can use bulk-inserts for
 		 * the partition being inserted into.
 		 *
-		 * Normally, when performing bulk inserts we just flush the insert
-		 * buffer whenever it becomes full, but for the partitioned table
-		 * case, we flush it whenever the current tuple does not belong to the
-		 * same partition as the previous tuple, and since we flush the
-		 * previous partition's buffer once the new tuple has already been
-		 * built, we're unable to reset the estate since we'd free the memory
-		 * in which the new tuple is stored.  To work around this we maintain
-		 * a secondary expression context and alternate between these when the
-		 * partition changes.  This does mean we do store the first new tuple
-		 * in a different context than subsequent tuples, but that does not
-		 * matter, providing we don't free anything while it's still needed.
+		 * Each partition gets a buffer of its own, and all of them are
+		 * flushed together, so the tuples buffered for one partition must
+		 * outlive the per-tuple memory context, which is reset for every
+		 * tuple when loading a partitioned table.  They are copied into a
+		 * separate memory context, which is reset after each flush.
 		 */
 		if (proute)
-		{
 			insertMethod = CIM_MULTI_CONDITIONAL;
-			secondaryExprContext = CreateExprContext(estate);
-		}
 		else
 			insertMethod = CIM_MULTI;
-
-		bufferedTuples = palloc(MAX_BUFFERED_TUPLES * sizeof(HeapTuple));
 	}
 
+	memset(&minfo, 0, sizeof(minfo));
+	if (insertMethod == CIM_MULTI)
+		curbuffer = CopyMultiInsertInfoGetBuffer(&minfo, resultRelInfo);
+	else if (insertMethod == CIM_MULTI_CONDITIONAL)
+		minfo.context = AllocSetContextCreate(CurrentMemoryContext,
+											  "COPY multi-insert buffers",
+											  ALLOCSET_DEFAULT_SIZES);
+
 	has_before_insert_row_trig = (resultRelInfo->ri_TrigDesc &&
 								  resultRelInfo->ri_TrigDesc->trig_insert_before_row);
 
@@ -2644,6 +2781,15 @@ CopyFrom(CopyState cstate)
 	errcallback.previous = error_context_stack;
 	error_context_stack = &errcallback;
 
+	/*
+	 * If asked to, hand the parsing of the input over to parallel workers.
+	 * This is only done for plain multi-inserts into a table, since that
+	 * way the leader needs nothing from the input but the formed tuples.
+	 */
+	if (cstate->parallel_workers > 0 && insertMethod == CIM_MULTI &&
+		CopyFromParallelOK(cstate))
+		pcl = BeginParallelCopy(cstate);
+
 	for (;;)
 	{
 		TupleTableSlot *slot;
@@ -2651,12 +2797,13 @@ CopyFrom(CopyState cstate)
 
 		CHECK_FOR_INTERRUPTS();
 
-		if (nBufferedTuples == 0)
+		if (minfo.ntuples == 0 || minfo.context != NULL)
 		{
 			/*
-			 * Reset the per-tuple exprcontext. We can only do this if the
-			 * tuple buffer is empty. (Calling the context the per-tuple
-			 * memory context is a bit of a misnomer now.)
+			 * Reset the per-tuple exprcontext. Unless buffered tuples are
+			 * copied elsewhere, we can only do this if the tuple buffer is
+			 * empty. (Calling the context the per-tuple memory context is a
+			 * bit of a misnomer now.)
 			 */
 			ResetPerTupleExprContext(estate);
 		}
@@ -2664,11 +2811,21 @@ CopyFrom(CopyState cstate)
 		/* Switch into its memory context */
 		MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
 
-		if (!NextCopyFrom(cstate, econtext, values, nulls))
-			break;
+		if (pcl != NULL)
+		{
+			/* The workers have already formed the tuple for us */
+			tuple = ParallelCopyNextTuple(cstate, pcl);
+			if (tuple == NULL)
+				break;
+		}
+		else
+		{
+			if (!NextCopyFrom(cstate, econtext, values, nulls))
+				break;
 
-		/* And now we can form the input tuple. */
-		tuple = heap_form_tuple(tupDesc, values, nulls);
+			/* And now we can form the input tuple. */
+			tuple = heap_form_tuple(tupDesc, values, nulls);
+		}
 
 		/*
 		 * Constraints might reference the tableoid column, so initialize
@@ -2698,76 +2855,6 @@ CopyFrom(CopyState cstate)
 
 			if (prevResultRelInfo != resultRelInfo)
 			{
-				/* Check if we can multi-insert into this partition */
-				if (insertMethod == CIM_MULTI_CONDITIONAL)
-				{
-					/*
-					 * When performing bulk-inserts into partitioned tables we
-					 * must insert the tuples seen so far to the heap whenever
-					 * the partition changes.
-					 */
-					if (nBufferedTuples > 0)
-					{
-						ExprContext *swapcontext;
-
-						CopyFromInsertBatch(cstate, estate, mycid, hi_options,
-											prevResultRelInfo, myslot, bistate,
-											nBufferedTuples, bufferedTuples,
-											firstBufferedLineNo);
-						nBufferedTuples = 0;
-						bufferedTuplesSize = 0;
-
-						Assert(secondaryExprContext);
-
-						/*
-						 * Normally we reset the per-tuple context whenever
-						 * the bufferedTuples array is empty at the beginning
-						 * of the loop, however, it is possible since we flush
-						 * the buffer here that the buffer is never empty at
-						 * the start of the loop.  To prevent the per-tuple
-						 * context from never being reset we maintain a second
-						 * context and alternate between them when the
-						 * partition changes.  We can now reset
-						 * secondaryExprContext as this is no longer needed,
-						 * since we just flushed any tuples stored in it.  We
-						 * also now switch over to the other context.  This
-						 * does mean that the first tuple in the buffer won't
-						 * be in the same context as the others, but that does
-						 * not matter since we only reset it after the flush.
-						 */
-						ReScanExprContext(secondaryExprContext);
-
-						swapcontext = secondaryExprContext;
-						secondaryExprContext = estate->es_per_tuple_exprcontext;
-						estate->es_per_tuple_exprcontext = swapcontext;
-					}
-
-					nPartitionChanges++;
-
-					/*
-					 * Here we adaptively enable multi-inserts based on the
-					 * average number of tuples from recent multi-insert
-					 * batches.  We recalculate the average every
-					 * RECHECK_MULTI_INSERT_THRESHOLD tuples instead of taking
-					 * the average over the whole copy.  This allows us to
-					 * enable multi-inserts when we get periods in the copy
-					 * stream that have tuples commonly belonging to the same
-					 * partition, and disable when the partition is changing
-					 * too often.
-					 */
-					if (unlikely(lastPartitionSampleLineNo <= (cstate->cur_lineno -
-															   RECHECK_MULTI_INSERT_THRESHOLD)
-								 && cstate->cur_lineno >= RECHECK_MULTI_INSERT_THRESHOLD))
-					{
-						avgTuplesPerPartChange =
-							(cstate->cur_lineno - lastPartitionSampleLineNo) /
-							(double) nPartitionChanges;
-
-						lastPartitionSampleLineNo = cstate->cur_lineno;
-						nPartitionChanges = 0;
-					}
-				}
-
 				/* Determine which triggers exist on this partition */
 				has_before_insert_row_trig = (resultRelInfo->ri_TrigDesc &&
 											  resultRelInfo->ri_TrigDesc->trig_insert_before_row);
@@ -2775,19 +2862,32 @@ CopyFrom(CopyState cstate)
 				has_instead_insert_row_trig = (resultRelInfo->ri_TrigDesc &&
 											   resultRelInfo->ri_TrigDesc->trig_insert_instead_row);
 
-				/*
-				 * Tests have shown that using multi-inserts when the
-				 * partition changes on every tuple slightly decreases the
-				 * performance, however, there are benefits even when only
-				 * some batches have just 2 tuples, so let's enable
-				 * multi-inserts even when the average is quite low.
-				 */
+				/* Check if we can multi-insert into this partition */
 				leafpart_use_multi_insert = insertMethod == CIM_MULTI_CONDITIONAL &&
-					avgTuplesPerPartChange >= 1.3 &&
 					!has_before_insert_row_trig &&
 					!has_instead_insert_row_trig &&
 					resultRelInfo->ri_FdwRoutine == NULL;
 
+				if (leafpart_use_multi_insert)
+				{
+					/*
+					 * Find this partition's buffer.  If we have run out of
+					 * buffers, flush them all and start over.
+					 */
+					curbuffer = CopyMultiInsertInfoGetBuffer(&minfo,
+															 resultRelInfo);
+					if (curbuffer == NULL)
+					{
+						CopyMultiInsertInfoFlush(cstate, estate, mycid,
+												 hi_options, myslot, bistate,
+												 &minfo);
+						while (minfo.nbuffers > 0)
+							pfree(minfo.buffers[--minfo.nbuffers]);
+						curbuffer = CopyMultiInsertInfoGetBuffer(&minfo,
+																 resultRelInfo);
+					}
+				}
+
 				/*
 				 * We'd better make the bulk insert mechanism gets a new
 				 * buffer when the partition being inserted into changes.
@@ -2904,34 +3004,49 @@ CopyFrom(CopyState cstate)
 				if (insertMethod == CIM_MULTI || leafpart_use_multi_insert)
 				{
 					/* Add this tuple to the tuple buffer */
-					if (nBufferedTuples == 0)
-						firstBufferedLineNo = cstate->cur_lineno;
-					bufferedTuples[nBufferedTuples++] = tuple;
-					bufferedTuplesSize += tuple->t_len;
+					if (minfo.context != NULL)
+					{
+						MemoryContext oldcontext;
+
+						oldcontext = MemoryContextSwitchTo(minfo.context);
+						tuple = heap_copytuple(tuple);
+						MemoryContextSwitchTo(oldcontext);
+					}
+					curbuffer->linenos[curbuffer->ntuples] = cstate->cur_lineno;
+					curbuffer->tuples[curbuffer->ntuples++] = tuple;
+					minfo.ntuples++;
+					minfo.nbytes += tuple->t_len;
 
 					/*
-					 * If the buffer filled up, flush it.  Also flush if the
-					 * total size of all the tuples in the buffer becomes
+					 * If the buffers filled up, flush them.  Also flush if
+					 * the total size of all the tuples in the buffers becomes
 					 * large, to avoid using large amounts of memory for the
-					 * buffer when the tuples are exceptionally wide.
+					 * buffers when the tuples are exceptionally wide.
 					 */
-					if (nBufferedTuples == MAX_BUFFERED_TUPLES ||
-						bufferedTuplesSize > 65535)
-					{
-						CopyFromInsertBatch(cstate, estate, mycid, hi_options,
-											resultRelInfo, myslot, bistate,
-											nBufferedTuples, bufferedTuples,
-											firstBufferedLineNo);
-						nBufferedTuples = 0;
-						bufferedTuplesSize = 0;
-					}
+					if (minfo.ntuples == MAX_BUFFERED_TUPLES ||
+						minfo.nbytes > MAX_BUFFERED_BYTES)
+						CopyMultiInsertInfoFlush(cstate, estate, mycid,
+												 hi_options, myslot, bistate,
+												 &minfo);
 				}
 				else
 				{
 					List	   *recheckIndexes = NIL;
 
 					/* OK, store the tuple */
-					if (resultRelInfo->ri_FdwRoutine != NULL)
+					if (resultRelInfo->ri_FdwRoutine != NULL &&
+						resultRelInfo->ri_BatchSize > 1)
+					{
+						/*
+						 * Add it to the FDW's batch; rows are counted once
+						 * the batch gets inserted.
+						 */
+						processed += ExecBufferForeignInsert(mtstate,
+															 resultRelInfo,
+															 slot, NULL);
+						continue;
+					}
+					else if (resultRelInfo->ri_FdwRoutine != NULL)
 					{
 						slot = resultRelInfo->ri_FdwRoutine->ExecForeignInsert(estate,
 																			   resultRelInfo,
@@ -2981,22 +3096,21 @@ CopyFrom(CopyState cstate)
 		}
 	}
 
+	if (pcl != NULL)
+		EndParallelCopy(pcl);
+
+	/* Insert the rows still waiting in foreign tables' batches */
+	if (mtstate->mt_pending_inserts != NIL)
+		processed += ExecPendingInserts(mtstate);
+
 	/* Flush any remaining buffered tuples */
-	if (nBufferedTuples > 0)
-	{
-		if (insertMethod == CIM_MULTI_CONDITIONAL)
-		{
-			CopyFromInsertBatch(cstate, estate, mycid, hi_options,
-								prevResultRelInfo, myslot, bistate,
-								nBufferedTuples, bufferedTuples,
-								firstBufferedLineNo);
-		}
-		else
-			CopyFromInsertBatch(cstate, estate, mycid, hi_options,
-								resultRelInfo, myslot, bistate,
-								nBufferedTuples, bufferedTuples,
-								firstBufferedLineNo);
-	}
+	if (minfo.ntuples > 0)
+		CopyMultiInsertInfoFlush(cstate, estate, mycid, hi_options, myslot,
+								 bistate, &minfo);
+	while (minfo.nbuffers > 0)
+		pfree(minfo.buffers[--minfo.nbuffers]);
+	if (minfo.context != NULL)
+		MemoryContextDelete(minfo.context);
 
 	/* Done, clean up */
 	error_context_stack = errcallback.previous;
@@ -3060,7 +3174,7 @@ CopyFromInsertBatch(CopyState cstate, EState *estate, CommandId mycid,
 					int hi_options, ResultRelInfo *resultRelInfo,
 					TupleTableSlot *myslot, BulkInsertState bistate,
 					int nBufferedTuples, HeapTuple *bufferedTuples,
-					uint64 firstBufferedLineNo)
+					uint64 *bufferedLineNos)
 {
 	MemoryContext oldcontext;
 	int			i;
@@ -3097,7 +3211,7 @@ CopyFromInsertBatch(CopyState cstate, EState *estate, CommandId mycid,
 		{
 			List	   *recheckIndexes;
 
-			cstate->cur_lineno = firstBufferedLineNo + i;
+			cstate->cur_lineno = bufferedLineNos[i];
 			ExecStoreHeapTuple(bufferedTuples[i], myslot, false);
 			recheckIndexes =
 				ExecInsertIndexTuples(myslot, &(bufferedTuples[i]->t_self),
@@ -3119,7 +3233,7 @@ CopyFromInsertBatch(CopyState cstate, EState *estate, CommandId mycid,
 	{
 		for (i = 0; i < nBufferedTuples; i++)
 		{
-			cstate->cur_lineno = firstBufferedLineNo + i;
+			cstate->cur_lineno = bufferedLineNos[i];
 			ExecARInsertTriggers(estate, resultRelInfo,
 								 bufferedTuples[i],
 								 NIL, cstate->transition_capture);
@@ -3131,6 +3245,686 @@ CopyFromInsertBatch(CopyState cstate, EState *estate, CommandId mycid,
 	cstate->cur_lineno = save_cur_lineno;
 }
 
+/*
+ * Return the multi-insert buffer for resultRelInfo, setting one up if it
+ * doesn't have one yet.  Returns NULL if all MAX_PARTITION_BUFFERS buffers
+ * are already taken by other relations.
+ */
+static CopyMultiInsertBuffer *
+CopyMultiInsertInfoGetBuffer(CopyMultiInsertInfo *minfo,
+							 ResultRelInfo *resultRelInfo)
+{
+	CopyMultiInsertBuffer *buffer;
+	int			i;
+
+	for (i = 0; i < minfo->nbuffers; i++)
+	{
+		if (minfo->buffers[i]->resultRelInfo == resultRelInfo)
+			return minfo->buffers[i];
+	}
+
+	if (minfo->nbuffers >= MAX_PARTITION_BUFFERS)
+		return NULL;
+
+	buffer = (CopyMultiInsertBuffer *) palloc(sizeof(CopyMultiInsertBuffer));
+	buffer->resultRelInfo = resultRelInfo;
+	buffer->ntuples = 0;
+	minfo->buffers[minfo->nbuffers++] = buffer;
+
+	return buffer;
+}
+
+/*
+ * Write out the tuples in all the multi-insert buffers of a COPY FROM.
+ *
+ * The buffers themselves stay assigned to their relations.  When loading a
+ * partitioned table, the bulk insert state is made to let go of its buffer
+ * before moving on to another partition, and once more at the end, since the
+ * caller may be about to insert into yet another one.
+ */
+static void
+CopyMultiInsertInfoFlush(CopyState cstate, EState *estate, CommandId mycid,
+						 int hi_options, TupleTableSlot *myslot,
+						 BulkInsertState bistate, CopyMultiInsertInfo *minfo)
+{
+	ResultRelInfo *saveResultRelInfo = estate->es_result_relation_info;
+	int			i;
+
+	for (i = 0; i < minfo->nbuffers; i++)
+	{
+		CopyMultiInsertBuffer *buffer = minfo->buffers[i];
+
+		if (buffer->ntuples == 0)
+			continue;
+
+		if (minfo->context != NULL)
+			ReleaseBulkInsertStatePin(bistate);
+
+		/* For ExecInsertIndexTuples() to work on this relation's indexes */
+		estate->es_result_relation_info = buffer->resultRelInfo;
+
+		CopyFromInsertBatch(cstate, estate, mycid, hi_options,
+							buffer->resultRelInfo, myslot, bistate,
+							buffer->ntuples, buffer->tuples,
+							buffer->linenos);
+		buffer->ntuples = 0;
+	}
+
+	estate->es_result_relation_info = saveResultRelInfo;
+	minfo->ntuples = 0;
+	minfo->nbytes = 0;
+
+	if (minfo->context != NULL)
+	{
+		ReleaseBulkInsertStatePin(bistate);
+		MemoryContextReset(minfo->context);
+	}
+}
+
+/*
+ * Can the input of this COPY FROM be parsed by parallel workers?
+ *
+ * The caller has already checked that the target is a plain table with no
+ * BEFORE or INSTEAD OF row triggers and no volatile default expressions.
+ * Since rows are inserted in no particular order, we refuse to go parallel
+ * if there are any row triggers at all, which covers foreign keys as well.
+ * CHECK constraints are also best evaluated without parallel mode in
+ * effect, so we let them force a serial load too.  Everything the workers
+ * do themselves, that is input functions and default expressions, must be
+ * parallel safe.
+ */
+static bool
+CopyFromParallelOK(CopyState cstate)
+{
+	Relation	rel = cstate->rel;
+	TupleDesc	tupDesc = RelationGetDescr(rel);
+	ListCell   *cur;
+	int			i;
+
+	if (cstate->binary || cstate->copy_dest == COPY_OLD_FE ||
+		cstate->encoding_embeds_ascii)
+		return false;
+
+	if (rel->rd_rel->relkind != RELKIND_RELATION)
+		return false;
+
+	if (rel->trigdesc != NULL &&
+		(rel->trigdesc->trig_insert_before_row ||
+		 rel->trigdesc->trig_insert_after_row ||
+		 rel->trigdesc->trig_insert_instead_row ||
+		 rel->trigdesc->trig_insert_new_table))
+		return false;
+
+	if (tupDesc->constr != NULL && tupDesc->constr->num_check > 0)
+		return false;
+
+	/* Parallel mode doesn't support serializable transactions */
+	if (IsolationIsSerializable() || IsInParallelMode())
+		return false;
+
+	foreach(cur, cstate->attnumlist)
+	{
+		int			attnum = lfirst_int(cur);
+
+		if (func_parallel(cstate->in_functions[attnum - 1].fn_oid) !=
+			PROPARALLEL_SAFE)
+			return false;
+	}
+
+	for (i = 0; i < cstate->num_defaults; i++)
+	{
+		if (!is_parallel_safe_expr((Node *) cstate->defexprs[i]->expr))
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Launch workers for parallel COPY FROM.  Returns NULL if no workers could
+ * be launched, in which case the caller should go on serially.
+ */
+static ParallelCopyLeader *
+BeginParallelCopy(CopyState cstate)
+{
+	ParallelCopyLeader *pcl;
+	ParallelContext *pcxt;
+	ParallelCopyShared *shared;
+	int			request;
+	Size		optionslen;
+	Size		queueslen;
+	Size		querylen;
+	char	   *sharedoptions;
+	char	   *queuespace;
+	char	   *sharedquery;
+	int			i;
+
+	request = Min(cstate->parallel_workers, max_parallel_maintenance_workers);
+	if (request <= 0)
+		return NULL;
+
+	/*
+	 * We will insert the tuples ourselves, and a transaction ID can't be
+	 * assigned once we're in parallel mode; so make sure we have one now.
+	 */
+	(void) GetCurrentTransactionId();
+
+	EnterParallelMode();
+	pcxt = CreateParallelContext("postgres", "ParallelCopyMain", request, true);
+
+	/* Estimate space for the shared state, options, queues and query text */
+	optionslen = strlen(cstate->worker_options) + 1;
+	queueslen = mul_size(2 * request, PARALLEL_COPY_QUEUE_SIZE);
+	querylen = strlen(debug_query_string) + 1;
+	shm_toc_estimate_chunk(&pcxt->estimator, sizeof(ParallelCopyShared));
+	shm_toc_estimate_chunk(&pcxt->estimator, optionslen);
+	shm_toc_estimate_chunk(&pcxt->estimator, queueslen);
+	shm_toc_estimate_chunk(&pcxt->estimator, querylen);
+	shm_toc_estimate_keys(&pcxt->estimator, 4);
+
+	InitializeParallelDSM(pcxt);
+
+	shared = (ParallelCopyShared *) shm_toc_allocate(pcxt->toc,
+													 sizeof(ParallelCopyShared));
+	shared->relid = RelationGetRelid(cstate->rel);
+	shm_toc_insert(pcxt->toc, PARALLEL_COPY_KEY_SHARED, shared);
+
+	sharedoptions = (char *) shm_toc_allocate(pcxt->toc, optionslen);
+	memcpy(sharedoptions, cstate->worker_options, optionslen);
+	shm_toc_insert(pcxt->toc, PARALLEL_COPY_KEY_OPTIONS, sharedoptions);
+
+	sharedquery = (char *) shm_toc_allocate(pcxt->toc, querylen);
+	memcpy(sharedquery, debug_query_string, querylen);
+	shm_toc_insert(pcxt->toc, PARALLEL_COPY_KEY_QUERY_TEXT, sharedquery);
+
+	/* Each worker gets an input queue, followed by an output queue */
+	pcl = (ParallelCopyLeader *) palloc0(sizeof(ParallelCopyLeader));
+	pcl->inqh = (shm_mq_handle **) palloc(request * sizeof(shm_mq_handle *));
+	pcl->outqh = (shm_mq_handle **) palloc(request * sizeof(shm_mq_handle *));
+	queuespace = (char *) shm_toc_allocate(pcxt->toc, queueslen);
+	for (i = 0; i < request; i++)
+	{
+		shm_mq	   *inq;
+		shm_mq	   *outq;
+
+		inq = shm_mq_create(queuespace + (Size) (2 * i) * PARALLEL_COPY_QUEUE_SIZE,
+							PARALLEL_COPY_QUEUE_SIZE);
+		shm_mq_set_sender(inq, MyProc);
+		pcl->inqh[i] = shm_mq_attach(inq, pcxt->seg, NULL);
+
+		outq = shm_mq_create(queuespace + (Size) (2 * i + 1) * PARALLEL_COPY_QUEUE_SIZE,
+							 PARALLEL_COPY_QUEUE_SIZE);
+		shm_mq_set_receiver(outq, MyProc);
+		pcl->outqh[i] = shm_mq_attach(outq, pcxt->seg, NULL);
+	}
+	shm_toc_insert(pcxt->toc, PARALLEL_COPY_KEY_QUEUES, queuespace);
+
+	LaunchParallelWorkers(pcxt);
+	pcl->pcxt = pcxt;
+	pcl->nworkers = pcxt->nworkers_launched;
+
+	/* If no workers were launched, back out and load serially */
+	if (pcl->nworkers == 0)
+	{
+		EndParallelCopy(pcl);
+		return NULL;
+	}
+
+	/* Let the queues find out if a worker dies before attaching */
+	for (i = 0; i < pcl->nworkers; i++)
+	{
+		shm_mq_set_handle(pcl->inqh[i], pcxt->worker[i].bgwhandle);
+		shm_mq_set_handle(pcl->outqh[i], pcxt->worker[i].bgwhandle);
+	}
+
+	pcl->worker_done = (bool *) palloc0(pcl->nworkers * sizeof(bool));
+	initStringInfo(&pcl->chunk);
+	pcl->skip_header = cstate->header_line;
+	pcl->line_start = true;
+
+	return pcl;
+}
+
+/*
+ * Wait for the workers of a parallel COPY FROM to exit, and leave parallel
+ * mode.
+ */
+static void
+EndParallelCopy(ParallelCopyLeader *pcl)
+{
+	WaitForParallelWorkersToFinish(pcl->pcxt);
+	DestroyParallelContext(pcl->pcxt);
+	ExitParallelMode();
+}
+
+/*
+ * Update the record boundary scan with the next input byte.
+ *
+ * Returns 1 if the byte ends a record, 0 if it doesn't, and -1 if we found
+ * that the record ended just before it, with a lone CR; in that last case
+ * the byte itself has not been looked at yet, and the caller must pass it
+ * in again.  The rules follow CopyReadLineText, and so does the counting of
+ * lines.
+ */
+static int
+ParallelCopyScanByte(CopyState cstate, ParallelCopyLeader *pcl, char c)
+{
+	bool		eol = false;
+
+	if (pcl->after_cr)
+	{
+		pcl->after_cr = false;
+		if (c != '\n')
+		{
+			pcl->lineno++;
+			if (!pcl->in_quote)
+			{
+				pcl->line_start = true;
+				return -1;
+			}
+		}
+	}
+
+	if (cstate->csv_mode)
+	{
+		char		quotec = cstate->quote[0];
+		char		escapec = cstate->escape[0];
+
+		/* ignore special escape processing if it's the same as quotec */
+		if (quotec == escapec)
+			escapec = '\0';
+
+		/* recognize \. alone on a line */
+		if (pcl->marker_state == 2)
+		{
+			if (c == '\n' || c == '\r')
+				pcl->seen_marker = true;
+			pcl->marker_state = 0;
+		}
+		else if (pcl->marker_state == 1)
+			pcl->marker_state = (c == '.') ? 2 : 0;
+		else if (pcl->line_start && c == '\\')
+			pcl->marker_state = 1;
+
+		if (pcl->in_quote && c == escapec)
+			pcl->last_was_esc = !pcl->last_was_esc;
+		if (c == quotec && !pcl->last_was_esc)
+			pcl->in_quote = !pcl->in_quote;
+		if (c != escapec)
+			pcl->last_was_esc = false;
+
+		/* line breaks within quotes are counted, but don't end the record */
+		if (c == '\r')
+			pcl->after_cr = true;
+		else if (c == '\n')
+		{
+			pcl->lineno++;
+			eol = !pcl->in_quote;
+		}
+	}
+	else
+	{
+		if (pcl->escaped)
+		{
+			/* anything after a backslash is data, except for \. */
+			if (c == '.')
+				pcl->seen_marker = true;
+			pcl->escaped = false;
+		}
+		else if (c == '\\')
+			pcl->escaped = true;
+		else if (c == '\r')
+			pcl->after_cr = true;
+		else if (c == '\n')
+		{
+			pcl->lineno++;
+			eol = true;
+		}
+	}
+
+	pcl->line_start = eol;
+	return eol ? 1 : 0;
+}
+
+/*
+ * Move input from the raw buffer to "dest", or just discard it if "dest" is
+ * NULL, up to the first record boundary by which at least "size" bytes have
+ * been moved, or up to the end-of-copy marker's line.  Returns false if the
+ * input ran out first.
+ */
+static bool
+ParallelCopyScanInput(CopyState cstate, ParallelCopyLeader *pcl,
+					  StringInfo dest, int size)
+{
+	int			moved = 0;
+
+	for (;;)
+	{
+		char	   *buf = cstate->raw_buf;
+		int			start;
+		int			pos;
+		bool		stop = false;
+
+		if (cstate->raw_buf_index >= cstate->raw_buf_len &&
+			!CopyLoadRawBuf(cstate))
+			return false;
+
+		start = pos = cstate->raw_buf_index;
+		while (pos < cstate->raw_buf_len)
+		{
+			int			r = ParallelCopyScanByte(cstate, pcl, buf[pos]);
+
+			if (r >= 0)
+				pos++;
+			if (r != 0 &&
+				(moved + pos - start >= size || pcl->seen_marker))
+			{
+				stop = true;
+				break;
+			}
+		}
+
+		if (dest != NULL)
+			appendBinaryStringInfo(dest, buf + start, pos - start);
+		moved += pos - start;
+		cstate->raw_buf_index = pos;
+
+		if (stop)
+			return true;
+	}
+}
+
+/*
+ * Cut the next chunk of input for the workers into pcl->chunk.  Returns
+ * false if there is no more input.
+ */
+static bool
+ParallelCopyFillChunk(CopyState cstate, ParallelCopyLeader *pcl)
+{
+	StringInfo	chunk = &pcl->chunk;
+	uint64		first_lineno;
+	bool		more;
+
+	if (pcl->input_done)
+		return false;
+
+	if (pcl->skip_header)
+	{
+		pcl->skip_header = false;
+		if (!ParallelCopyScanInput(cstate, pcl, NULL, 0))
+		{
+			pcl->input_done = true;
+			return false;
+		}
+	}
+
+	first_lineno = pcl->lineno + 1;
+	resetStringInfo(chunk);
+	appendBinaryStringInfo(chunk, (char *) &first_lineno, sizeof(uint64));
+	more = ParallelCopyScanInput(cstate, pcl, chunk, PARALLEL_COPY_CHUNK_SIZE);
+
+	if (!more || pcl->seen_marker)
+	{
+		pcl->input_done = true;
+
+		/* As in CopyReadLine, ignore anything after \. in protocol 3 */
+		if (pcl->seen_marker && cstate->copy_dest == COPY_NEW_FE)
+		{
+			do
+			{
+				cstate->raw_buf_index = cstate->raw_buf_len;
+			} while (CopyLoadRawBuf(cstate));
+		}
+	}
+
+	return chunk->len > sizeof(uint64);
+}
+
+/*
+ * Get the next tuple formed by the workers of a parallel COPY FROM, feeding
+ * them input as they need it.  The tuple is allocated in the current memory
+ * context, and cstate->cur_lineno is set to its line number.  Returns NULL
+ * once all the input has been processed.
+ */
+static HeapTuple
+ParallelCopyNextTuple(CopyState cstate, ParallelCopyLeader *pcl)
+{
+	for (;;)
+	{
+		shm_mq_result res;
+		bool		sent = false;
+		int			i;
+
+		CHECK_FOR_INTERRUPTS();
+
+		/* Pass on more input, if there is room for it */
+		if (!pcl->chunk_ready && !pcl->input_done)
+			pcl->chunk_ready = ParallelCopyFillChunk(cstate, pcl);
+
+		if (pcl->chunk_ready)
+		{
+			res = shm_mq_send(pcl->inqh[pcl->nextwriter],
+							  pcl->chunk.len, pcl->chunk.data, true);
+			if (res == SHM_MQ_DETACHED && !pcl->input_done)
+			{
+				/*
+				 * A worker only stops reading early if it fails, or if it
+				 * has seen the end-of-copy marker, which must be in the last
+				 * chunk.  Report the worker's error, if it has sent one.
+				 */
+				HandleParallelMessages();
+				ereport(ERROR,
+						(errcode(ERRCODE_INTERNAL_ERROR),
+						 errmsg("parallel COPY worker exited unexpectedly")));
+			}
+			if (res != SHM_MQ_WOULD_BLOCK)
+			{
+				pcl->chunk_ready = false;
+				pcl->nextwriter = (pcl->nextwriter + 1) % pcl->nworkers;
+				sent = true;
+			}
+		}
+		else if (pcl->input_done && !pcl->inputs_closed)
+		{
+			/* Let the workers know that no more input is coming */
+			for (i = 0; i < pcl->nworkers; i++)
+				shm_mq_detach(pcl->inqh[i]);
+			pcl->inputs_closed = true;
+		}
+
+		/* Look for a tuple, trying the workers in turn */
+		for (i = 0; i < pcl->nworkers; i++)
+		{
+			int			w = pcl->nextreader;
+			Size		nbytes;
+			void	   *data;
+
+			pcl->nextreader = (w + 1) % pcl->nworkers;
+			if (pcl->worker_done[w])
+				continue;
+
+			res = shm_mq_receive(pcl->outqh[w], &nbytes, &data, true);
+			if (res == SHM_MQ_SUCCESS)
+			{
+				HeapTupleData htup;
+
+				Assert(nbytes > sizeof(uint64));
+				memcpy(&cstate->cur_lineno, data, sizeof(uint64));
+				htup.t_len = nbytes - sizeof(uint64);
+				htup.t_data = (HeapTupleHeader) ((char *) data + sizeof(uint64));
+				ItemPointerSetInvalid(&htup.t_self);
+				htup.t_tableOid = InvalidOid;
+				return heap_copytuple(&htup);
+			}
+			if (res == SHM_MQ_DETACHED)
+			{
+				pcl->worker_done[w] = true;
+				pcl->nworkers_done++;
+			}
+		}
+
+		if (pcl->nworkers_done == pcl->nworkers)
+			return NULL;
+
+		/* Nothing to do until a worker makes progress */
+		if (!sent)
+		{
+			(void) WaitLatch(MyLatch, WL_LATCH_SET | WL_EXIT_ON_PM_DEATH, 0,
+							 WAIT_EVENT_PARALLEL_COPY);
+			ResetLatch(MyLatch);
+		}
+	}
+}
+
+/*
+ * Worker's state for parallel COPY FROM, for use by the data source
+ * callback.
+ */
+static struct
+{
+	CopyState	cstate;
+	shm_mq_handle *inqh;
+	char	   *data;			/* current chunk, in the queue's memory */
+	Size		len;			/* length of the chunk */
+	Size		offset;			/* bytes of it consumed so far */
+}			ParallelCopyInput;
+
+/*
+ * Data source callback for workers: read from the input chunks sent by the
+ * leader.
+ *
+ * Chunks always start at a record boundary, and CopyReadLine asks for more
+ * data at the start of a line when the previous chunk is used up, so we can
+ * simply set the line number for error messages whenever we fetch a chunk.
+ */
+static int
+ParallelCopyReadData(void *outbuf, int minread, int maxread)
+{
+	Size		nbytes;
+
+	if (ParallelCopyInput.offset >= ParallelCopyInput.len)
+	{
+		void	   *data;
+		uint64		lineno;
+
+		if (shm_mq_receive(ParallelCopyInput.inqh, &nbytes, &data, false) !=
+			SHM_MQ_SUCCESS)
+			return 0;			/* no more input */
+
+		Assert(nbytes > sizeof(uint64));
+		memcpy(&lineno, data, sizeof(uint64));
+		ParallelCopyInput.cstate->cur_lineno = lineno;
+		ParallelCopyInput.data = (char *) data + sizeof(uint64);
+		ParallelCopyInput.len = nbytes - sizeof(uint64);
+		ParallelCopyInput.offset = 0;
+	}
+
+	nbytes = Min(maxread, ParallelCopyInput.len - ParallelCopyInput.offset);
+	memcpy(outbuf, ParallelCopyInput.data + ParallelCopyInput.offset, nbytes);
+	ParallelCopyInput.offset += nbytes;
+
+	return (int) nbytes;
+}
+
+/*
+ * Entry point for parallel COPY FROM workers.
+ */
+void
+ParallelCopyMain(dsm_segment *seg, shm_toc *toc)
+{
+	ParallelCopyShared *shared;
+	List	   *lists;
+	char	   *queuespace;
+	shm_mq	   *inq;
+	shm_mq	   *outq;
+	shm_mq_handle *outqh;
+	Relation	rel;
+	CopyState	cstate;
+	TupleDesc	tupDesc;
+	EState	   *estate;
+	ExprContext *econtext;
+	Datum	   *values;
+	bool	   *nulls;
+	ErrorContextCallback errcallback;
+
+	/* Set debug_query_string for individual workers first */
+	debug_query_string = shm_toc_lookup(toc, PARALLEL_COPY_KEY_QUERY_TEXT,
+										false);
+	pgstat_report_activity(STATE_RUNNING, debug_query_string);
+
+	shared = shm_toc_lookup(toc, PARALLEL_COPY_KEY_SHARED, false);
+	lists = (List *) stringToNode(shm_toc_lookup(toc, PARALLEL_COPY_KEY_OPTIONS,
+												 false));
+
+	queuespace = shm_toc_lookup(toc, PARALLEL_COPY_KEY_QUEUES, false);
+	inq = (shm_mq *) (queuespace +
+					  (Size) (2 * ParallelWorkerNumber) * PARALLEL_COPY_QUEUE_SIZE);
+	outq = (shm_mq *) (queuespace +
+					   (Size) (2 * ParallelWorkerNumber + 1) * PARALLEL_COPY_QUEUE_SIZE);
+	shm_mq_set_receiver(inq, MyProc);
+	shm_mq_set_sender(outq, MyProc);
+	ParallelCopyInput.inqh = shm_mq_attach(inq, seg, NULL);
+	outqh = shm_mq_attach(outq, seg, NULL);
+
+	/* The leader holds the same lock already */
+	rel = heap_open(shared->relid, RowExclusiveLock);
+
+	cstate = BeginCopyFrom(NULL, rel, NULL, false, ParallelCopyReadData,
+						   (List *) linitial(lists), (List *) lsecond(lists));
+	ParallelCopyInput.cstate = cstate;
+
+	tupDesc = RelationGetDescr(rel);
+	values = (Datum *) palloc(tupDesc->natts * sizeof(Datum));
+	nulls = (bool *) palloc(tupDesc->natts * sizeof(bool));
+
+	estate = CreateExecutorState();
+	econtext = GetPerTupleExprContext(estate);
+
+	/* Set up callback to identify error line number */
+	errcallback.callback = CopyFromErrorCallback;
+	errcallback.arg = (void *) cstate;
+	errcallback.previous = error_context_stack;
+	error_context_stack = &errcallback;
+
+	for (;;)
+	{
+		MemoryContext oldcontext;
+		HeapTuple	tuple;
+		shm_mq_iovec iov[2];
+		shm_mq_result res;
+
+		CHECK_FOR_INTERRUPTS();
+
+		ResetPerTupleExprContext(estate);
+		oldcontext = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
+
+		if (!NextCopyFrom(cstate, econtext, values, nulls))
+		{
+			MemoryContextSwitchTo(oldcontext);
+			break;
+		}
+
+		tuple = heap_form_tuple(tupDesc, values, nulls);
+
+		iov[0].data = (const char *) &cstate->cur_lineno;
+		iov[0].len = sizeof(uint64);
+		iov[1].data = (const char *) tuple->t_data;
+		iov[1].len = tuple->t_len;
+		res = shm_mq_sendv(outqh, iov, 2, false);
+
+		MemoryContextSwitchTo(oldcontext);
+
+		if (res != SHM_MQ_SUCCESS)
+			break;				/* leader is gone */
+	}
+
+	error_context_stack = errcallback.previous;
+
+	FreeExecutorState(estate);
+	EndCopyFrom(cstate);
+	heap_close(rel, RowExclusiveLock);
+}
+
 /*
  * Setup to read tuples from a file for COPY FROM.
  *
@@ -3167,6 +3961,34 @@ BeginCopyFrom(ParseState *pstate,
 	cstate = BeginCopy(pstate, true, rel, NULL, InvalidOid, attnamelist, options);
 	oldcontext = MemoryContextSwitchTo(cstate->copycontext);
 
+	/*
+	 * Parallel workers set up their own copy state from the same options,
+	 * except that the leader deals with the header line, and the file
+	 * encoding must be spelled out since workers don't use our client
+	 * encoding.
+	 */
+	if (cstate->parallel_workers > 0)
+	{
+		List	   *worker_options = NIL;
+		ListCell   *option;
+
+		foreach(option, options)
+		{
+			DefElem    *defel = lfirst_node(DefElem, option);
+
+			if (strcmp(defel->defname, "header") != 0 &&
+				strcmp(defel->defname, "parallel") != 0 &&
+				strcmp(defel->defname, "encoding") != 0)
+				worker_options = lappend(worker_options, defel);
+		}
+		worker_options = lappend(worker_options,
+								 makeDefElem("encoding",
+											 (Node *) makeString((char *) pg_encoding_to_char(cstate->file_encoding)),
+											 -1));
+		cstate->worker_options = nodeToString(list_make2(attnamelist,
+														 worker_options));
+	}
+
 	/* Initialize state variables */
 	cstate->reached_eof = false;
 	cstate->eol_type = EOL_UNKNOWN;
@@ -3829,6 +4651,33 @@ CopyReadLineText(CopyState cstate)
 			need_data = false;
 		}
 
+		/*
+		 * Step over bytes that can't be special all at once, which is most
+		 * of them.  We can't do that if ASCII bytes may be part of multibyte
+		 * characters, and the first byte of a line always needs a look of
+		 * its own, since that's where CSV mode recognizes \.
+		 */
+		if (!cstate->encoding_embeds_ascii && !first_char_in_line)
+		{
+			int			skip;
+
+			if (cstate->csv_mode)
+				skip = pg_find_bytes(copy_raw_buf + raw_buf_ptr,
+									 copy_buf_len - raw_buf_ptr,
+									 quotec, escapec, '\n', '\r');
+			else
+				skip = pg_find_bytes(copy_raw_buf + raw_buf_ptr,
+									 copy_buf_len - raw_buf_ptr,
+									 '\\', '\n', '\r', '\r');
+			if (skip > 0)
+			{
+				raw_buf_ptr += skip;
+				last_was_esc = false;
+				if (raw_buf_ptr >= copy_buf_len)
+					continue;
+			}
+		}
+
 		/* OK to fetch a character */
 		prev_raw_ptr = raw_buf_ptr;
 		c = copy_raw_buf[raw_buf_ptr++];
@@ -4197,6 +5046,14 @@ CopyReadAttributesText(CopyState cstate)
 		for (;;)
 		{
 			char		c;
+			int			n;
+
+			/* Copy any run of ordinary characters in one go */
+			n = pg_find_bytes(cur_ptr, line_end_ptr - cur_ptr,
+							  delimc, '\\', '\\', '\\');
+			memcpy(output_ptr, cur_ptr, n);
+			output_ptr += n;
+			cur_ptr += n;
 
 			end_ptr = cur_ptr;
 			if (cur_ptr >= line_end_ptr)
@@ -4423,10 +5280,18 @@ CopyReadAttributesCSV(CopyState cstate)
 		for (;;)
 		{
 			char		c;
+			int			n;
 
 			/* Not in quote */
 			for (;;)
 			{
+				/* Copy any run of ordinary characters in one go */
+				n = pg_find_bytes(cur_ptr, line_end_ptr - cur_ptr,
+								  delimc, quotec, quotec, quotec);
+				memcpy(output_ptr, cur_ptr, n);
+				output_ptr += n;
+				cur_ptr += n;
+
 				end_ptr = cur_ptr;
 				if (cur_ptr >= line_end_ptr)
 					goto endfield;
@@ -4450,6 +5315,13 @@ CopyReadAttributesCSV(CopyState cstate)
 			/* In quote */
 			for (;;)
 			{
+				/* Likewise */
+				n = pg_find_bytes(cur_ptr, line_end_ptr - cur_ptr,
+								  escapec, quotec, quotec, quotec);
+				memcpy(output_ptr, cur_ptr, n);
+				output_ptr += n;
+				cur_ptr += n;
+
 				end_ptr = cur_ptr;
 				if (cur_ptr >= line_end_ptr)
 					ereport(ERROR,
@@ -4542,6 +5414,99 @@ CopyReadBinaryAttribute(CopyState cstate,
 				(errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
 				 errmsg("invalid field size")));
 
+	/*
+	 * For the common fixed-width types, and for bytea, whose binary format is
+	 * just its contents, decode the field straight from the input instead of
+	 * going through attribute_buf and the receive function.  What we do must
+	 * match the receive functions exactly.  A field of the wrong size is left
+	 * to the receive function to complain about.
+	 */
+	switch (flinfo->fn_oid)
+	{
+		case F_BOOLRECV:
+			if (fld_size == 1)
+			{
+				uint8		buf;
+
+				CopyReadBinaryData(cstate, (char *) &buf, 1);
+				*isnull = false;
+				return BoolGetDatum(buf != 0);
+			}
+			break;
+		case F_INT2RECV:
+			if (fld_size == sizeof(int16))
+			{
+				uint16		buf;
+
+				CopyReadBinaryData(cstate, (char *) &buf, sizeof(buf));
+				*isnull = false;
+				return Int16GetDatum((int16) pg_ntoh16(buf));
+			}
+			break;
+		case F_INT4RECV:
+			if (fld_size == sizeof(int32))
+			{
+				uint32		buf;
+
+				CopyReadBinaryData(cstate, (char *) &buf, sizeof(buf));
+				*isnull = false;
+				return Int32GetDatum((int32) pg_ntoh32(buf));
+			}
+			break;
+		case F_INT8RECV:
+			if (fld_size == sizeof(int64))
+			{
+				uint64		buf;
+
+				CopyReadBinaryData(cstate, (char *) &buf, sizeof(buf));
+				*isnull = false;
+				return Int64GetDatum((int64) pg_ntoh64(buf));
+			}
+			break;
+		case F_FLOAT4RECV:
+			if (fld_size == sizeof(float4))
+			{
+				union
+				{
+					float4		f;
+					uint32		i;
+				}			swap;
+
+				CopyReadBinaryData(cstate, (char *) &swap.i, sizeof(swap.i));
+				swap.i = pg_ntoh32(swap.i);
+				*isnull = false;
+				return Float4GetDatum(swap.f);
+			}
+			break;
+		case F_FLOAT8RECV:
+			if (fld_size == sizeof(float8))
+			{
+				union
+				{
+					float8		f;
+					uint64		i;
+				}			swap;
+
+				CopyReadBinaryData(cstate, (char *) &swap.i, sizeof(swap.i));
+				swap.i = pg_ntoh64(swap.i);
+				*isnull = false;
+				return Float8GetDatum(swap.f);
+			}
+			break;
+		case F_BYTEARECV:
+			{
+				bytea	   *value;
+
+				value = (bytea *) palloc(fld_size + VARHDRSZ);
+				SET_VARSIZE(value, fld_size + VARHDRSZ);
+				CopyReadBinaryData(cstate, VARDATA(value), fld_size);
+				*isnull = false;
+				return PointerGetDatum(value);
+			}
+		default:
+			break;
+	}
+
 	/* reset attribute_buf to empty, and load raw data in it */
 	resetStringInfo(&cstate->attribute_buf);
 
@@ -4569,6 +5534,18 @@ CopyReadBinaryAttribute(CopyState cstate,
 	return result;
 }
 
+/*
+ * Read exactly size bytes of a binary-format field into dest.
+ */
+static void
+CopyReadBinaryData(CopyState cstate, char *dest, int size)
+{
+	if (CopyGetData(cstate, dest, size, size) != size)
+		ereport(ERROR,
+				(errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+				 errmsg("unexpected EOF in COPY data")));
+}
+
 /*
  * Send text representation of one attribute, with conversion and escaping
  */
@@ -4667,9 +5644,17 @@ CopyAttributeOutText(CopyState cstate, char *string)
 	}
 	else
 	{
+		char	   *end = ptr + strlen(ptr);
+
 		start = ptr;
-		while ((c = *ptr) != '\0')
+		for (;;)
 		{
+			/* skip quickly to the next byte that might need escaping */
+			ptr += pg_find_bytes_or_control(ptr, end - ptr, '\\', delimc);
+			if (ptr >= end)
+				break;
+			c = *ptr;
+
 			if ((unsigned char) c < (unsigned char) 0x20)
 			{
 				/*
@@ -4766,17 +5751,28 @@ CopyAttributeOutCSV(CopyState cstate, char *string,
 		{
 			char	   *tptr = ptr;
 
-			while ((c = *tptr) != '\0')
+			if (!cstate->encoding_embeds_ascii)
 			{
-				if (c == delimc || c == quotec || c == '\n' || c == '\r')
-				{
+				int			len = strlen(tptr);
+
+				if (pg_find_bytes(tptr, len,
+								  delimc, quotec, '\n', '\r') < len)
 					use_quote = true;
-					break;
+			}
+			else
+			{
+				while ((c = *tptr) != '\0')
+				{
+					if (c == delimc || c == quotec || c == '\n' || c == '\r')
+					{
+						use_quote = true;
+						break;
+					}
+					if (IS_HIGHBIT_SET(c))
+						tptr += pg_encoding_mblen(cstate->file_encoding, tptr);
+					else
+						tptr++;
 				}
-				if (IS_HIGHBIT_SET(c) && cstate->encoding_embeds_ascii)
-					tptr += pg_encoding_mblen(cstate->file_encoding, tptr);
-				else
-					tptr++;
 			}
 		}
 	}
@@ -4789,18 +5785,36 @@ CopyAttributeOutCSV(CopyState cstate, char *string,
 		 * We adopt the same optimization strategy as in CopyAttributeOutText
 		 */
 		start = ptr;
-		while ((c = *ptr) != '\0')
+		if (!cstate->encoding_embeds_ascii)
 		{
-			if (c == quotec || c == escapec)
+			char	   *end = ptr + strlen(ptr);
+
+			for (;;)
 			{
+				ptr += pg_find_bytes(ptr, end - ptr,
+									 quotec, escapec, quotec, quotec);
+				if (ptr >= end)
+					break;
 				DUMPSOFAR();
 				CopySendChar(cstate, escapec);
-				start = ptr;	/* we include char in next run */
+				start = ptr++;	/* we include char in next run */
+			}
+		}
+		else
+		{
+			while ((c = *ptr) != '\0')
+			{
+				if (c == quotec || c == escapec)
+				{
+					DUMPSOFAR();
+					CopySendChar(cstate, escapec);
+					start = ptr;	/* we include char in next run */
+				}
+				if (IS_HIGHBIT_SET(c))
+					ptr += pg_encoding_mblen(cstate->file_encoding, ptr);
+				else
+					ptr++;
 			}
-			if (IS_HIGHBIT_SET(c) && cstate->encoding_embeds_ascii)
-				ptr += pg_encoding_mblen(cstate->file_encoding, ptr);
-			else
-				ptr++;
 		}
 		DUMPSOFAR();
 
@@ -29,6 +29,7 @@
 #include "parser/parse_collate.h"
 #include "parser/parse_expr.h"
 #include "parser/parse_type.h"
+#include "portability/instr_time.h"
 #include "rewrite/rewriteHandler.h"
 #include "tcop/pquery.h"
 #include "tcop/utility.h"
@@ -210,6 +211,7 @@ ExecuteQuery(ExecuteStmt *stmt, IntoClause *intoClause,
 	char	   *query_string;
 	int			eflags;
 	long		count;
+	instr_time	starttime;
 
 	/* Look it up in the hash table */
 	entry = FetchPreparedStatement(stmt->name, true);
@@ -296,6 +298,9 @@ ExecuteQuery(ExecuteStmt *stmt, IntoClause *intoClause,
 					  plan_list,
 					  cplan);
 
+	if (plan_cache_runtime_feedback)
+		INSTR_TIME_SET_CURRENT(starttime);
+
 	/*
 	 * Run the portal as appropriate.
 	 */
@@ -303,6 +308,17 @@ ExecuteQuery(ExecuteStmt *stmt, IntoClause *intoClause,
 
 	(void) PortalRun(portal, count, false, true, dest, dest, completionTag);
 
+	/* Let the plan cache know how long that took */
+	if (plan_cache_runtime_feedback)
+	{
+		instr_time	endtime;
+
+		INSTR_TIME_SET_CURRENT(endtime);
+		INSTR_TIME_SUBTRACT(endtime, starttime);
+		CachedPlanRecordRuntime(entry->plansource, cplan,
+								INSTR_TIME_GET_MILLISEC(endtime));
+	}
+
 	PortalDrop(portal, false);
 
 	if (estate)
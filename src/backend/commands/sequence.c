@@ -37,9 +37,12 @@
 #include "parser/parse_type.h"
 #include "storage/lmgr.h"
 #include "storage/proc.h"
+#include "storage/shmem.h"
 #include "storage/smgr.h"
+#include "storage/spin.h"
 #include "utils/acl.h"
 #include "utils/builtins.h"
+#include "utils/hashutils.h"
 #include "utils/lsyscache.h"
 #include "utils/resowner.h"
 #include "utils/syscache.h"
@@ -92,12 +95,49 @@ static HTAB *seqhashtab = NULL; /* hash table for SeqTable items */
  */
 static SeqTableData *last_used_seq = NULL;
 
+/*
+ * Values preallocated for a sequence with a CACHE setting greater than one
+ * are kept in shared memory rather than in the backend's SeqTable entry, so
+ * that all sessions draw from one range and unused values are not lost when
+ * a session exits.  A session that finds the shared range empty takes the
+ * sequence's buffer lock and reserves the next range exactly as a local
+ * cache fill would, WAL-logging only then.
+ *
+ * The cache is a small direct-mapped array; a sequence hashing to a slot
+ * held by another sequence simply evicts it, losing the remaining values
+ * just as a session exit loses a local cache.  Slots are keyed by the
+ * sequence's relfilenode as well as its OID, so entries left behind by a
+ * dropped or rewritten sequence are never matched.  Temporary sequences
+ * are not shared.
+ */
+#define SEQ_SHARED_CACHE_SLOTS	128
+
+typedef struct SeqSharedCacheSlot
+{
+	slock_t		mutex;			/* protects the fields below */
+	Oid			dbid;			/* database of the sequence, or InvalidOid */
+	Oid			relid;			/* pg_class OID of the sequence */
+	Oid			filenode;		/* relfilenode the range was reserved in */
+	int64		next;			/* next value to hand out */
+	int64		increment;		/* sequence's increment */
+	int64		remaining;		/* number of values left, starting at next */
+	XLogRecPtr	lsn;			/* WAL position covering the range */
+} SeqSharedCacheSlot;
+
+static SeqSharedCacheSlot *seqSharedCache = NULL;
+
 static void fill_seq_with_data(Relation rel, HeapTuple tuple);
 static Relation lock_and_open_sequence(SeqTable seq);
 static void create_seq_hashtable(void);
 static void init_sequence(Oid relid, SeqTable *p_elm, Relation *p_rel);
 static Form_pg_sequence_data read_seq_tuple(Relation rel,
 			   Buffer *buf, HeapTuple seqdatatuple);
+static SeqSharedCacheSlot *seq_shared_slot(Oid relid);
+static bool seq_shared_fetch(Relation seqrel, int64 *result,
+				 int64 *increment);
+static void seq_shared_store(Relation seqrel, int64 next, int64 increment,
+				 int64 count, XLogRecPtr lsn);
+static void seq_shared_clear(Oid relid);
 static void init_params(ParseState *pstate, List *options, bool for_identity,
 			bool isInit,
 			Form_pg_sequence seqform,
@@ -285,6 +325,9 @@ ResetSequence(Oid seq_relid)
 	init_sequence(seq_relid, &elm, &seq_rel);
 	(void) read_seq_tuple(seq_rel, &buf, &seqdatatuple);
 
+	/* Forget any values preallocated in shared memory */
+	seq_shared_clear(seq_relid);
+
 	pgstuple = SearchSysCache1(SEQRELID, ObjectIdGetDatum(seq_relid));
 	if (!HeapTupleIsValid(pgstuple))
 		elog(ERROR, "cache lookup failed for sequence %u", seq_relid);
@@ -471,6 +514,9 @@ AlterSequence(ParseState *pstate, AlterSeqStmt *stmt)
 	/* Note that we do not change the currval() state */
 	elm->cached = elm->last;
 
+	/* Likewise forget any values preallocated in shared memory */
+	seq_shared_clear(relid);
+
 	/* If needed, rewrite the sequence relation itself */
 	if (need_seq_rewrite)
 	{
@@ -526,6 +572,12 @@ DeleteSequenceTuple(Oid relid)
 
 	ReleaseSysCache(tuple);
 	heap_close(rel, RowExclusiveLock);
+
+	/*
+	 * Forget any values preallocated in shared memory.  A new sequence could
+	 * be given the same OID, and with it the same relfilenode.
+	 */
+	seq_shared_clear(relid);
 }
 
 /*
@@ -585,6 +637,8 @@ nextval_internal(Oid relid, bool check_permissions)
 				next,
 				rescnt = 0;
 	bool		cycle;
+	bool		wrapped = false;
+	bool		share_range;
 	bool		logit = false;
 
 	/* open and lock sequence */
@@ -619,6 +673,17 @@ nextval_internal(Oid relid, bool check_permissions)
 		return elm->last;
 	}
 
+	/* Try values preallocated in shared memory by any session */
+	if (seq_shared_fetch(seqrel, &result, &incby))
+	{
+		elm->increment = incby;
+		elm->last = elm->cached = result;
+		elm->last_valid = true;
+		relation_close(seqrel, NoLock);
+		last_used_seq = elm;
+		return result;
+	}
+
 	pgstuple = SearchSysCache1(SEQRELID, ObjectIdGetDatum(relid));
 	if (!HeapTupleIsValid(pgstuple))
 		elog(ERROR, "cache lookup failed for sequence %u", relid);
@@ -634,6 +699,21 @@ nextval_internal(Oid relid, bool check_permissions)
 	seq = read_seq_tuple(seqrel, &buf, &seqdatatuple);
 	page = BufferGetPage(buf);
 
+	/*
+	 * Someone else may have reserved a new shared range while we waited for
+	 * the buffer lock; if so, use it rather than reserving another.
+	 */
+	if (seq_shared_fetch(seqrel, &result, &incby))
+	{
+		UnlockReleaseBuffer(buf);
+		elm->increment = incby;
+		elm->last = elm->cached = result;
+		elm->last_valid = true;
+		relation_close(seqrel, NoLock);
+		last_used_seq = elm;
+		return result;
+	}
+
 	elm->increment = incby;
 	last = next = result = seq->last_value;
 	fetch = cache;
@@ -698,6 +778,7 @@ nextval_internal(Oid relid, bool check_permissions)
 									RelationGetRelationName(seqrel), buf)));
 				}
 				next = minv;
+				wrapped = true;
 			}
 			else
 				next += incby;
@@ -721,6 +802,7 @@ nextval_internal(Oid relid, bool check_permissions)
 									RelationGetRelationName(seqrel), buf)));
 				}
 				next = maxv;
+				wrapped = true;
 			}
 			else
 				next += incby;
@@ -739,9 +821,14 @@ nextval_internal(Oid relid, bool check_permissions)
 	log -= fetch;				/* adjust for any unfetched numbers */
 	Assert(log >= 0);
 
-	/* save info in local cache */
+	/*
+	 * Save info in local cache.  If the fetched values form a plain run that
+	 * other sessions can use, they go to the shared cache below instead.
+	 */
+	share_range = (rescnt > 1 && !wrapped &&
+				   seqrel->rd_rel->relpersistence != RELPERSISTENCE_TEMP);
 	elm->last = result;			/* last returned number */
-	elm->cached = last;			/* last fetched number */
+	elm->cached = share_range ? result : last;	/* last fetched number */
 	elm->last_valid = true;
 
 	last_used_seq = elm;
@@ -807,6 +894,11 @@ nextval_internal(Oid relid, bool check_permissions)
 
 	END_CRIT_SECTION();
 
+	/* Publish the rest of the range while we still hold the buffer lock */
+	if (share_range)
+		seq_shared_store(seqrel, result + incby, incby, rescnt - 1,
+						 PageGetLSN(page));
+
 	UnlockReleaseBuffer(buf);
 
 	relation_close(seqrel, NoLock);
@@ -962,6 +1054,7 @@ do_setval(Oid relid, int64 next, bool iscalled)
 
 	/* In any case, forget any future cached numbers */
 	elm->cached = elm->last;
+	seq_shared_clear(relid);
 
 	/* check the comment above nextval_internal()'s equivalent call. */
 	if (RelationNeedsWAL(seqrel))
@@ -1145,6 +1238,101 @@ init_sequence(Oid relid, SeqTable *p_elm, Relation *p_rel)
 }
 
 
+/*
+ * seq_shared_slot: find the shared cache slot a sequence maps to
+ */
+static SeqSharedCacheSlot *
+seq_shared_slot(Oid relid)
+{
+	uint32		h;
+
+	h = hash_combine(murmurhash32((uint32) MyDatabaseId),
+					 murmurhash32((uint32) relid));
+	return &seqSharedCache[h % SEQ_SHARED_CACHE_SLOTS];
+}
+
+/*
+ * seq_shared_fetch: take the next value from the sequence's shared range
+ *
+ * Returns false if no preallocated value is available.
+ */
+static bool
+seq_shared_fetch(Relation seqrel, int64 *result, int64 *increment)
+{
+	SeqSharedCacheSlot *slot;
+	XLogRecPtr	lsn = InvalidXLogRecPtr;
+	bool		found = false;
+
+	if (seqrel->rd_rel->relpersistence == RELPERSISTENCE_TEMP)
+		return false;
+
+	slot = seq_shared_slot(RelationGetRelid(seqrel));
+	SpinLockAcquire(&slot->mutex);
+	if (slot->dbid == MyDatabaseId &&
+		slot->relid == RelationGetRelid(seqrel) &&
+		slot->filenode == seqrel->rd_node.relNode &&
+		slot->remaining > 0)
+	{
+		*result = slot->next;
+		*increment = slot->increment;
+		lsn = slot->lsn;
+		if (--slot->remaining > 0)
+			slot->next += slot->increment;
+		found = true;
+	}
+	SpinLockRelease(&slot->mutex);
+
+	/*
+	 * The WAL record that reserved the range may not have been flushed yet,
+	 * since the reserving transaction need not have committed.  Make sure
+	 * it is durable before handing out a value covered by it, else a crash
+	 * could cause the value to be issued again.
+	 */
+	if (found && RelationNeedsWAL(seqrel))
+		XLogFlush(lsn);
+
+	return found;
+}
+
+/*
+ * seq_shared_store: publish a range of preallocated values
+ *
+ * The caller must hold the sequence's buffer lock, which serializes this
+ * against other reservations and against seq_shared_clear callers.
+ */
+static void
+seq_shared_store(Relation seqrel, int64 next, int64 increment, int64 count,
+				 XLogRecPtr lsn)
+{
+	SeqSharedCacheSlot *slot = seq_shared_slot(RelationGetRelid(seqrel));
+
+	SpinLockAcquire(&slot->mutex);
+	slot->dbid = MyDatabaseId;
+	slot->relid = RelationGetRelid(seqrel);
+	slot->filenode = seqrel->rd_node.relNode;
+	slot->next = next;
+	slot->increment = increment;
+	slot->remaining = count;
+	slot->lsn = lsn;
+	SpinLockRelease(&slot->mutex);
+}
+
+/*
+ * seq_shared_clear: forget any shared preallocated values of a sequence
+ *
+ * Used when the sequence's state or parameters are changed underneath it.
+ */
+static void
+seq_shared_clear(Oid relid)
+{
+	SeqSharedCacheSlot *slot = seq_shared_slot(relid);
+
+	SpinLockAcquire(&slot->mutex);
+	if (slot->dbid == MyDatabaseId && slot->relid == relid)
+		slot->remaining = 0;
+	SpinLockRelease(&slot->mutex);
+}
+
 /*
  * Given an opened sequence relation, lock the page buffer and find the tuple
  *
@@ -1932,6 +2120,42 @@ ResetSequenceCaches(void)
 	last_used_seq = NULL;
 }
 
+/*
+ * Report shared-memory space needed by the shared sequence cache
+ */
+Size
+SequenceShmemSize(void)
+{
+	return mul_size(SEQ_SHARED_CACHE_SLOTS, sizeof(SeqSharedCacheSlot));
+}
+
+/*
+ * Initialize the shared sequence cache
+ */
+void
+SequenceShmemInit(void)
+{
+	bool		found;
+	int			i;
+
+	seqSharedCache = (SeqSharedCacheSlot *)
+		ShmemInitStruct("Sequence Cache", SequenceShmemSize(), &found);
+
+	if (!found)
+	{
+		for (i = 0; i < SEQ_SHARED_CACHE_SLOTS; i++)
+		{
+			SeqSharedCacheSlot *slot = &seqSharedCache[i];
+
+			SpinLockInit(&slot->mutex);
+			slot->dbid = InvalidOid;
+			slot->relid = InvalidOid;
+			slot->filenode = InvalidOid;
+			slot->remaining = 0;
+		}
+	}
+}
+
 /*
  * Mask a Sequence page before performing consistency checks on it.
  */
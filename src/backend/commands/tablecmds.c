@@ -79,6 +79,7 @@
 #include "parser/parser.h"
 #include "partitioning/partbounds.h"
 #include "pgstat.h"
+#include "port/pg_iovec.h"
 #include "rewrite/rewriteDefine.h"
 #include "rewrite/rewriteHandler.h"
 #include "rewrite/rewriteManip.h"
@@ -11224,14 +11225,18 @@ static void
 copy_relation_data(SMgrRelation src, SMgrRelation dst,
 				   ForkNumber forkNum, char relpersistence)
 {
-	PGAlignedBlock buf;
-	Page		page;
+	PGAlignedBlock *bufs;
+	char	   *bufptrs[PG_IOV_MAX];
 	bool		use_wal;
 	bool		copying_initfork;
 	BlockNumber nblocks;
 	BlockNumber blkno;
+	int			i;
 
-	page = (Page) buf.data;
+	/* Source blocks are read in runs of up to PG_IOV_MAX at a time */
+	bufs = (PGAlignedBlock *) palloc(sizeof(PGAlignedBlock) * PG_IOV_MAX);
+	for (i = 0; i < PG_IOV_MAX; i++)
+		bufptrs[i] = bufs[i].data;
 
 	/*
 	 * The init fork for an unlogged relation in many respects has to be
@@ -11250,40 +11255,49 @@ copy_relation_data(SMgrRelation src, SMgrRelation dst,
 
 	nblocks = smgrnblocks(src, forkNum);
 
-	for (blkno = 0; blkno < nblocks; blkno++)
+	for (blkno = 0; blkno < nblocks;)
 	{
+		BlockNumber nread = Min(nblocks - blkno, PG_IOV_MAX);
+
 		/* If we got a cancel signal during the copy of the data, quit */
 		CHECK_FOR_INTERRUPTS();
 
-		smgrread(src, forkNum, blkno, buf.data);
+		smgrreadv(src, forkNum, blkno, bufptrs, nread);
 
-		if (!PageIsVerified(page, blkno))
-			ereport(ERROR,
-					(errcode(ERRCODE_DATA_CORRUPTED),
-					 errmsg("invalid page in block %u of relation %s",
-							blkno,
-							relpathbackend(src->smgr_rnode.node,
-										   src->smgr_rnode.backend,
-										   forkNum))));
+		for (i = 0; i < nread; i++, blkno++)
+		{
+			Page		page = (Page) bufptrs[i];
 
-		/*
-		 * WAL-log the copied page. Unfortunately we don't know what kind of a
-		 * page this is, so we have to log the full page including any unused
-		 * space.
-		 */
-		if (use_wal)
-			log_newpage(&dst->smgr_rnode.node, forkNum, blkno, page, false);
+			if (!PageIsVerified(page, blkno))
+				ereport(ERROR,
+						(errcode(ERRCODE_DATA_CORRUPTED),
+						 errmsg("invalid page in block %u of relation %s",
+								blkno,
+								relpathbackend(src->smgr_rnode.node,
+											   src->smgr_rnode.backend,
+											   forkNum))));
+
+			/*
+			 * WAL-log the copied page. Unfortunately we don't know what kind
+			 * of a page this is, so we have to log the full page including
+			 * any unused space.
+			 */
+			if (use_wal)
+				log_newpage(&dst->smgr_rnode.node, forkNum, blkno, page, false);
 
-		PageSetChecksumInplace(page, blkno);
+			PageSetChecksumInplace(page, blkno);
 
-		/*
-		 * Now write the page.  We say isTemp = true even if it's not a temp
-		 * rel, because there's no need for smgr to schedule an fsync for this
-		 * write; we'll do it ourselves below.
-		 */
-		smgrextend(dst, forkNum, blkno, buf.data, true);
+			/*
+			 * Now write the page.  We say isTemp = true even if it's not a
+			 * temp rel, because there's no need for smgr to schedule an fsync
+			 * for this write; we'll do it ourselves below.
+			 */
+			smgrextend(dst, forkNum, blkno, bufptrs[i], true);
+		}
 	}
 
+	pfree(bufs);
+
 	/*
 	 * If the rel is WAL-logged, must fsync before commit.  We use heap_sync
 	 * to ensure that the toast table gets fsync'd too.  (For a temp or
@@ -31,8 +31,10 @@
 #include "catalog/pg_type.h"
 #include "commands/dbcommands.h"
 #include "commands/defrem.h"
+#include "commands/tablespace.h"
 #include "commands/trigger.h"
 #include "executor/executor.h"
+#include "lib/ilist.h"
 #include "miscadmin.h"
 #include "nodes/bitmapset.h"
 #include "nodes/makefuncs.h"
@@ -45,6 +47,7 @@
 #include "parser/parsetree.h"
 #include "pgstat.h"
 #include "rewrite/rewriteManip.h"
+#include "storage/buffile.h"
 #include "storage/bufmgr.h"
 #include "storage/lmgr.h"
 #include "tcop/utility.h"
@@ -56,6 +59,7 @@
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/rel.h"
+#include "utils/resowner.h"
 #include "utils/snapmgr.h"
 #include "utils/syscache.h"
 #include "utils/tqual.h"
@@ -3712,35 +3716,55 @@ typedef struct AfterTriggerEventDataZeroCtids
 /*
  * To avoid palloc overhead, we keep trigger events in arrays in successively-
  * larger chunks (a slightly more sophisticated version of an expansible
- * array).  The space between CHUNK_DATA_START and freeptr is occupied by
- * AfterTriggerEventData records; the space between endfree and endptr is
- * occupied by AfterTriggerSharedData records.
+ * array).  The space between the start of a chunk's data and freeoff is
+ * occupied by AfterTriggerEventData records; the space between endfree and
+ * the end of the data is occupied by AfterTriggerSharedData records.  Since
+ * those are found by offset from their events, a chunk's data can be moved
+ * around freely.
+ *
+ * Once the event chunks held in memory exceed work_mem, chunks that are
+ * neither the tail of their list nor being scanned are written out to a
+ * temporary file, keeping only the chunk header in memory.  Scans using the
+ * for_each_chunk macros read such chunks back in (and pin them, so that
+ * they stay put until the scan moves on), and a chunk read back in is
+ * written out again if memory is needed for another one.  We don't track
+ * whether a chunk was changed while in memory; scans usually change flags
+ * in most of the events they pass over anyway.
  */
 typedef struct AfterTriggerEventChunk
 {
 	struct AfterTriggerEventChunk *next;	/* list link */
-	char	   *freeptr;		/* start of free space in chunk */
-	char	   *endfree;		/* end of free space in chunk */
-	char	   *endptr;			/* end of chunk */
-	/* event data follows here */
+	char	   *data;			/* chunk contents, or NULL if only on disk */
+	Size		size;			/* size of contents */
+	Size		freeoff;		/* start of free space in contents */
+	Size		endfree;		/* end of free space in contents */
+	int			pincount;		/* number of scans positioned on chunk */
+	int			spill_fileno;	/* position of copy in temporary file, */
+	off_t		spill_offset;	/* if spill_fileno isn't -1 */
+	dlist_node	resident_link;	/* link in list of chunks in memory */
 } AfterTriggerEventChunk;
 
-#define CHUNK_DATA_START(cptr) ((char *) (cptr) + MAXALIGN(sizeof(AfterTriggerEventChunk)))
+#define CHUNK_DATA_START(cptr) ((cptr)->data)
+#define CHUNK_FREEPTR(cptr) ((cptr)->data + (cptr)->freeoff)
 
 /* A list of events */
 typedef struct AfterTriggerEventList
 {
 	AfterTriggerEventChunk *head;
 	AfterTriggerEventChunk *tail;
-	char	   *tailfree;		/* freeptr of tail chunk */
+	Size		tailfree;		/* freeoff of tail chunk */
 } AfterTriggerEventList;
 
-/* Macros to help in iterating over a list of events */
+/*
+ * Macros to help in iterating over a list of events.  Note that a loop over
+ * chunks must not be left early without calling afterTriggerUnpinChunk.
+ */
 #define for_each_chunk(cptr, evtlist) \
-	for (cptr = (evtlist).head; cptr != NULL; cptr = cptr->next)
+	for (cptr = afterTriggerPinChunk((evtlist).head); cptr != NULL; \
+		 cptr = afterTriggerPinNextChunk(cptr))
 #define for_each_event(eptr, cptr) \
 	for (eptr = (AfterTriggerEvent) CHUNK_DATA_START(cptr); \
-		 (char *) eptr < (cptr)->freeptr; \
+		 (char *) eptr < CHUNK_FREEPTR(cptr); \
 		 eptr = (AfterTriggerEvent) (((char *) eptr) + SizeofTriggerEvent(eptr)))
 /* Use this if no special per-chunk processing is needed */
 #define for_each_event_chunk(eptr, cptr, evtlist) \
@@ -3748,10 +3772,11 @@ typedef struct AfterTriggerEventList
 
 /* Macros for iterating from a start point that might not be list start */
 #define for_each_chunk_from(cptr) \
-	for (; cptr != NULL; cptr = cptr->next)
+	for (cptr = afterTriggerPinChunk(cptr); cptr != NULL; \
+		 cptr = afterTriggerPinNextChunk(cptr))
 #define for_each_event_from(eptr, cptr) \
 	for (; \
-		 (char *) eptr < (cptr)->freeptr; \
+		 (char *) eptr < CHUNK_FREEPTR(cptr); \
 		 eptr = (AfterTriggerEvent) (((char *) eptr) + SizeofTriggerEvent(eptr)))
 
 
@@ -3775,6 +3800,11 @@ typedef struct AfterTriggerEventList
  * end of the list, so it is relatively easy to discard them.  The event
  * list chunks themselves are stored in event_cxt.
  *
+ * resident_chunks lists the event chunks of all lists whose data is in
+ * memory, oldest first, and resident_size is the total size of their data.
+ * event_file is the temporary file chunks are spilled to when that exceeds
+ * work_mem, created on first use; event_file_endno/endoff is its end.
+ *
  * query_depth is the current depth of nested AfterTriggerBeginQuery calls
  * (-1 when the stack is empty).
  *
@@ -3840,6 +3870,11 @@ typedef struct AfterTriggersData
 	SetConstraintState state;	/* the active S C state */
 	AfterTriggerEventList events;	/* deferred-event list */
 	MemoryContext event_cxt;	/* memory context for events, if any */
+	dlist_head	resident_chunks;	/* event chunks with data in memory */
+	Size		resident_size;	/* total size of their data */
+	BufFile    *event_file;		/* spilled event chunks, if any */
+	int			event_file_endno;	/* end of event_file */
+	off_t		event_file_endoff;
 
 	/* per-query-level data: */
 	AfterTriggersQueryData *query_stack;	/* array of structs shown below */
@@ -3882,6 +3917,10 @@ struct AfterTriggersTableData
 
 static AfterTriggersData afterTriggers;
 
+static AfterTriggerEventChunk *afterTriggerPinChunk(AfterTriggerEventChunk *chunk);
+static AfterTriggerEventChunk *afterTriggerPinNextChunk(AfterTriggerEventChunk *chunk);
+static void afterTriggerUnpinChunk(AfterTriggerEventChunk *chunk);
+static void afterTriggerFreeChunk(AfterTriggerEventChunk *chunk);
 static void AfterTriggerExecute(AfterTriggerEvent event,
 					Relation rel, TriggerDesc *trigdesc,
 					FmgrInfo *finfo,
@@ -3978,6 +4017,190 @@ afterTriggerCheckState(AfterTriggerShared evtshared)
 }
 
 
+/* ----------
+ * afterTriggerSpillChunk()
+ *
+ *	Write out the data of an event chunk to the temporary file, and release
+ *	its memory.  A chunk that was spilled before goes back to the same place.
+ * ----------
+ */
+static void
+afterTriggerSpillChunk(AfterTriggerEventChunk *chunk)
+{
+	Assert(chunk->data != NULL && chunk->pincount == 0);
+
+	if (afterTriggers.event_file == NULL)
+	{
+		MemoryContext oldcxt;
+		ResourceOwner saveResourceOwner;
+
+		/*
+		 * Deferred events can outlive the subtransaction that queued them,
+		 * so make the file belong to the top-level transaction.
+		 */
+		oldcxt = MemoryContextSwitchTo(afterTriggers.event_cxt);
+		saveResourceOwner = CurrentResourceOwner;
+		CurrentResourceOwner = TopTransactionResourceOwner;
+
+		PrepareTempTablespaces();
+		afterTriggers.event_file = BufFileCreateTemp(false);
+		afterTriggers.event_file_endno = 0;
+		afterTriggers.event_file_endoff = 0;
+
+		CurrentResourceOwner = saveResourceOwner;
+		MemoryContextSwitchTo(oldcxt);
+	}
+
+	if (chunk->spill_fileno < 0)
+	{
+		chunk->spill_fileno = afterTriggers.event_file_endno;
+		chunk->spill_offset = afterTriggers.event_file_endoff;
+	}
+	if (BufFileSeek(afterTriggers.event_file, chunk->spill_fileno,
+					chunk->spill_offset, SEEK_SET) != 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not seek in after-trigger event temporary file: %m")));
+	if (BufFileWrite(afterTriggers.event_file, chunk->data,
+					 chunk->size) != chunk->size)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not write to after-trigger event temporary file: %m")));
+	if (chunk->spill_fileno == afterTriggers.event_file_endno &&
+		chunk->spill_offset == afterTriggers.event_file_endoff)
+		BufFileTell(afterTriggers.event_file,
+					&afterTriggers.event_file_endno,
+					&afterTriggers.event_file_endoff);
+
+	pfree(chunk->data);
+	chunk->data = NULL;
+	dlist_delete(&chunk->resident_link);
+	afterTriggers.resident_size -= chunk->size;
+}
+
+/* ----------
+ * afterTriggerSpillChunks()
+ *
+ *	Spill event chunks, oldest first, until the data of those left in memory
+ *	plus "needed" more bytes fits in work_mem, or none can be spilled.
+ *	A chunk is kept in memory while it's pinned, or while it's a list's tail
+ *	chunk, since new events are added there.
+ * ----------
+ */
+static void
+afterTriggerSpillChunks(Size needed)
+{
+	Size		limit = (Size) work_mem * 1024;
+	dlist_mutable_iter iter;
+
+	dlist_foreach_modify(iter, &afterTriggers.resident_chunks)
+	{
+		AfterTriggerEventChunk *chunk;
+
+		if (afterTriggers.resident_size + needed <= limit)
+			break;
+
+		chunk = dlist_container(AfterTriggerEventChunk, resident_link,
+								iter.cur);
+		if (chunk->pincount == 0 && chunk->next != NULL)
+			afterTriggerSpillChunk(chunk);
+	}
+}
+
+/* ----------
+ * afterTriggerLoadChunk()
+ *
+ *	Read the data of a spilled event chunk back into memory.
+ * ----------
+ */
+static void
+afterTriggerLoadChunk(AfterTriggerEventChunk *chunk)
+{
+	Assert(chunk->data == NULL && chunk->spill_fileno >= 0);
+
+	afterTriggerSpillChunks(chunk->size);
+
+	chunk->data = MemoryContextAlloc(afterTriggers.event_cxt, chunk->size);
+	if (BufFileSeek(afterTriggers.event_file, chunk->spill_fileno,
+					chunk->spill_offset, SEEK_SET) != 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not seek in after-trigger event temporary file: %m")));
+	if (BufFileRead(afterTriggers.event_file, chunk->data,
+					chunk->size) != chunk->size)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from after-trigger event temporary file: %m")));
+
+	dlist_push_tail(&afterTriggers.resident_chunks, &chunk->resident_link);
+	afterTriggers.resident_size += chunk->size;
+}
+
+/* ----------
+ * afterTriggerPinChunk()
+ *
+ *	Make sure an event chunk's data is in memory, and keep it there until
+ *	afterTriggerUnpinChunk is called.  Returns the chunk, which may be NULL.
+ * ----------
+ */
+static AfterTriggerEventChunk *
+afterTriggerPinChunk(AfterTriggerEventChunk *chunk)
+{
+	if (chunk != NULL)
+	{
+		if (chunk->data == NULL)
+			afterTriggerLoadChunk(chunk);
+		chunk->pincount++;
+	}
+	return chunk;
+}
+
+/* ----------
+ * afterTriggerUnpinChunk()
+ *
+ *	Release a pin taken by afterTriggerPinChunk.
+ * ----------
+ */
+static void
+afterTriggerUnpinChunk(AfterTriggerEventChunk *chunk)
+{
+	Assert(chunk->pincount > 0);
+	chunk->pincount--;
+}
+
+/* ----------
+ * afterTriggerPinNextChunk()
+ *
+ *	Step for the for_each_chunk macros: unpin an event chunk, and pin and
+ *	return the next one in its list, or NULL if there is none.
+ * ----------
+ */
+static AfterTriggerEventChunk *
+afterTriggerPinNextChunk(AfterTriggerEventChunk *chunk)
+{
+	afterTriggerUnpinChunk(chunk);
+	return afterTriggerPinChunk(chunk->next);
+}
+
+/* ----------
+ * afterTriggerFreeChunk()
+ *
+ *	Release the memory of an event chunk.  Its space in the temporary file,
+ *	if any, is not reused.
+ * ----------
+ */
+static void
+afterTriggerFreeChunk(AfterTriggerEventChunk *chunk)
+{
+	if (chunk->data != NULL)
+	{
+		pfree(chunk->data);
+		dlist_delete(&chunk->resident_link);
+		afterTriggers.resident_size -= chunk->size;
+	}
+	pfree(chunk);
+}
+
 /* ----------
  * afterTriggerAddEvent()
  *
@@ -3997,11 +4220,15 @@ afterTriggerAddEvent(AfterTriggerEventList *events,
 
 	/*
 	 * If empty list or not enough room in the tail chunk, make a new chunk.
-	 * We assume here that a new shared record will always be needed.
+	 * We assume here that a new shared record will always be needed.  The
+	 * tail chunk is normally in memory, but it may have been spilled while
+	 * it wasn't the tail, if the list was cut back at subtransaction abort.
 	 */
 	chunk = events->tail;
+	if (chunk != NULL && chunk->data == NULL)
+		afterTriggerLoadChunk(chunk);
 	if (chunk == NULL ||
-		chunk->endfree - chunk->freeptr < needed)
+		chunk->endfree - chunk->freeoff < needed)
 	{
 		Size		chunksize;
 
@@ -4039,20 +4266,28 @@ afterTriggerAddEvent(AfterTriggerEventList *events,
 		else
 		{
 			/* preceding chunk size... */
-			chunksize = chunk->endptr - (char *) chunk;
+			chunksize = chunk->size;
 			/* check number of shared records in preceding chunk */
-			if ((chunk->endptr - chunk->endfree) <=
+			if ((chunk->size - chunk->endfree) <=
 				(100 * sizeof(AfterTriggerSharedData)))
 				chunksize *= 2; /* okay, double it */
 			else
 				chunksize /= 2; /* too many shared records */
 			chunksize = Min(chunksize, MAX_CHUNK_SIZE);
 		}
-		chunk = MemoryContextAlloc(afterTriggers.event_cxt, chunksize);
+		chunk = MemoryContextAlloc(afterTriggers.event_cxt,
+								   sizeof(AfterTriggerEventChunk));
 		chunk->next = NULL;
-		chunk->freeptr = CHUNK_DATA_START(chunk);
-		chunk->endptr = chunk->endfree = (char *) chunk + chunksize;
-		Assert(chunk->endfree - chunk->freeptr >= needed);
+		chunk->data = MemoryContextAlloc(afterTriggers.event_cxt, chunksize);
+		chunk->size = chunksize;
+		chunk->freeoff = 0;
+		chunk->endfree = chunksize;
+		chunk->pincount = 0;
+		chunk->spill_fileno = -1;
+		chunk->spill_offset = 0;
+		dlist_push_tail(&afterTriggers.resident_chunks, &chunk->resident_link);
+		afterTriggers.resident_size += chunksize;
+		Assert(chunk->endfree - chunk->freeoff >= needed);
 
 		if (events->head == NULL)
 			events->head = chunk;
@@ -4060,14 +4295,17 @@ afterTriggerAddEvent(AfterTriggerEventList *events,
 			events->tail->next = chunk;
 		events->tail = chunk;
 		/* events->tailfree is now out of sync, but we'll fix it below */
+
+		/* The former tail chunk can go to disk now, if need be */
+		afterTriggerSpillChunks(0);
 	}
 
 	/*
 	 * Try to locate a matching shared-data record already in the chunk. If
 	 * none, make a new one.
 	 */
-	for (newshared = ((AfterTriggerShared) chunk->endptr) - 1;
-		 (char *) newshared >= chunk->endfree;
+	for (newshared = ((AfterTriggerShared) (chunk->data + chunk->size)) - 1;
+		 (char *) newshared >= chunk->data + chunk->endfree;
 		 newshared--)
 	{
 		if (newshared->ats_tgoid == evtshared->ats_tgoid &&
@@ -4077,22 +4315,22 @@ afterTriggerAddEvent(AfterTriggerEventList *events,
 			newshared->ats_firing_id == 0)
 			break;
 	}
-	if ((char *) newshared < chunk->endfree)
+	if ((char *) newshared < chunk->data + chunk->endfree)
 	{
 		*newshared = *evtshared;
 		newshared->ats_firing_id = 0;	/* just to be sure */
-		chunk->endfree = (char *) newshared;
+		chunk->endfree = (char *) newshared - chunk->data;
 	}
 
 	/* Insert the data */
-	newevent = (AfterTriggerEvent) chunk->freeptr;
+	newevent = (AfterTriggerEvent) CHUNK_FREEPTR(chunk);
 	memcpy(newevent, event, eventsize);
 	/* ... and link the new event to its shared record */
 	newevent->ate_flags &= ~AFTER_TRIGGER_OFFSET;
 	newevent->ate_flags |= (char *) newshared - (char *) newevent;
 
-	chunk->freeptr += eventsize;
-	events->tailfree = chunk->freeptr;
+	chunk->freeoff += eventsize;
+	events->tailfree = chunk->freeoff;
 }
 
 /* ----------
@@ -4109,10 +4347,10 @@ afterTriggerFreeEventList(AfterTriggerEventList *events)
 	while ((chunk = events->head) != NULL)
 	{
 		events->head = chunk->next;
-		pfree(chunk);
+		afterTriggerFreeChunk(chunk);
 	}
 	events->tail = NULL;
-	events->tailfree = NULL;
+	events->tailfree = 0;
 }
 
 /* ----------
@@ -4141,11 +4379,11 @@ afterTriggerRestoreEventList(AfterTriggerEventList *events,
 		for (chunk = events->tail->next; chunk != NULL; chunk = next_chunk)
 		{
 			next_chunk = chunk->next;
-			pfree(chunk);
+			afterTriggerFreeChunk(chunk);
 		}
 		/* and clean up the tail chunk to be the right length */
 		events->tail->next = NULL;
-		events->tail->freeptr = events->tailfree;
+		events->tail->freeoff = events->tailfree;
 
 		/*
 		 * We don't make any effort to remove now-unused shared data records.
@@ -4184,13 +4422,13 @@ afterTriggerDeleteHeadEventChunk(AfterTriggersQueryData *qs)
 		{
 			table->after_trig_events.head = NULL;
 			table->after_trig_events.tail = NULL;
-			table->after_trig_events.tailfree = NULL;
+			table->after_trig_events.tailfree = 0;
 		}
 	}
 
 	/* Now we can flush the head chunk */
 	qs->events.head = target->next;
-	pfree(target);
+	afterTriggerFreeChunk(target);
 }
 
 
@@ -4581,8 +4819,8 @@ afterTriggerInvokeEvents(AfterTriggerEventList *events,
 		/* Clear the chunk if delete_ok and nothing left of interest */
 		if (delete_ok && all_fired_in_chunk)
 		{
-			chunk->freeptr = CHUNK_DATA_START(chunk);
-			chunk->endfree = chunk->endptr;
+			chunk->freeoff = 0;
+			chunk->endfree = chunk->size;
 
 			/*
 			 * If it's last chunk, must sync event list's tailfree too.  Note
@@ -4591,7 +4829,7 @@ afterTriggerInvokeEvents(AfterTriggerEventList *events,
 			 * list, since we'd fail to fix their copies of tailfree.
 			 */
 			if (chunk == events->tail)
-				events->tailfree = chunk->freeptr;
+				events->tailfree = chunk->freeoff;
 		}
 	}
 	if (slot1 != NULL)
@@ -4781,6 +5019,8 @@ AfterTriggerBeginXact(void)
 	 */
 	afterTriggers.firing_counter = (CommandId) 1;	/* mustn't be 0 */
 	afterTriggers.query_depth = -1;
+	dlist_init(&afterTriggers.resident_chunks);
+	afterTriggers.resident_size = 0;
 
 	/*
 	 * Verify that there is no leftover state remaining.  If these assertions
@@ -4791,6 +5031,7 @@ AfterTriggerBeginXact(void)
 	Assert(afterTriggers.query_stack == NULL);
 	Assert(afterTriggers.maxquerydepth == 0);
 	Assert(afterTriggers.event_cxt == NULL);
+	Assert(afterTriggers.event_file == NULL);
 	Assert(afterTriggers.events.head == NULL);
 	Assert(afterTriggers.trans_stack == NULL);
 	Assert(afterTriggers.maxtransdepth == 0);
@@ -5039,11 +5280,20 @@ AfterTriggerEndXact(bool isCommit)
 	 */
 	if (afterTriggers.event_cxt)
 	{
+		/*
+		 * At abort, leave closing the spill file to resource owner cleanup,
+		 * which doesn't need the BufFile struct.
+		 */
+		if (afterTriggers.event_file && isCommit)
+			BufFileClose(afterTriggers.event_file);
+		afterTriggers.event_file = NULL;
 		MemoryContextDelete(afterTriggers.event_cxt);
 		afterTriggers.event_cxt = NULL;
 		afterTriggers.events.head = NULL;
 		afterTriggers.events.tail = NULL;
-		afterTriggers.events.tailfree = NULL;
+		afterTriggers.events.tailfree = 0;
+		dlist_init(&afterTriggers.resident_chunks);
+		afterTriggers.resident_size = 0;
 	}
 
 	/*
@@ -5259,7 +5509,7 @@ AfterTriggerEnlargeQueryState(void)
 
 		qs->events.head = NULL;
 		qs->events.tail = NULL;
-		qs->events.tailfree = NULL;
+		qs->events.tailfree = 0;
 		qs->fdw_tuplestore = NULL;
 		qs->tables = NIL;
 
@@ -5691,7 +5941,10 @@ AfterTriggerPendingOnRel(Oid relid)
 			continue;
 
 		if (evtshared->ats_relid == relid)
+		{
+			afterTriggerUnpinChunk(chunk);
 			return true;
+		}
 	}
 
 	/*
@@ -5709,7 +5962,10 @@ AfterTriggerPendingOnRel(Oid relid)
 				continue;
 
 			if (evtshared->ats_relid == relid)
+			{
+				afterTriggerUnpinChunk(chunk);
 				return true;
+			}
 		}
 	}
 
@@ -6124,22 +6380,19 @@ cancel_prior_stmt_triggers(Oid relid, CmdType cmdType, int tgevent)
 		 */
 		AfterTriggerEvent event;
 		AfterTriggerEventChunk *chunk;
+		Size		startoff = 0;
 
 		if (table->after_trig_events.tail)
 		{
 			chunk = table->after_trig_events.tail;
-			event = (AfterTriggerEvent) table->after_trig_events.tailfree;
+			startoff = table->after_trig_events.tailfree;
 		}
 		else
-		{
 			chunk = qs->events.head;
-			event = NULL;
-		}
 
 		for_each_chunk_from(chunk)
 		{
-			if (event == NULL)
-				event = (AfterTriggerEvent) CHUNK_DATA_START(chunk);
+			event = (AfterTriggerEvent) (CHUNK_DATA_START(chunk) + startoff);
 			for_each_event_from(event, chunk)
 			{
 				AfterTriggerShared evtshared = GetTriggerSharedData(event);
@@ -6148,20 +6401,20 @@ cancel_prior_stmt_triggers(Oid relid, CmdType cmdType, int tgevent)
 				 * Exit loop when we reach events that aren't AS triggers for
 				 * the target relation.
 				 */
-				if (evtshared->ats_relid != relid)
-					goto done;
-				if ((evtshared->ats_event & TRIGGER_EVENT_OPMASK) != tgevent)
-					goto done;
-				if (!TRIGGER_FIRED_FOR_STATEMENT(evtshared->ats_event))
-					goto done;
-				if (!TRIGGER_FIRED_AFTER(evtshared->ats_event))
+				if (evtshared->ats_relid != relid ||
+					(evtshared->ats_event & TRIGGER_EVENT_OPMASK) != tgevent ||
+					!TRIGGER_FIRED_FOR_STATEMENT(evtshared->ats_event) ||
+					!TRIGGER_FIRED_AFTER(evtshared->ats_event))
+				{
+					afterTriggerUnpinChunk(chunk);
 					goto done;
+				}
 				/* OK, mark it DONE */
 				event->ate_flags &= ~AFTER_TRIGGER_IN_PROGRESS;
 				event->ate_flags |= AFTER_TRIGGER_DONE;
 			}
-			/* signal we must reinitialize event ptr for next chunk */
-			event = NULL;
+			/* later chunks are scanned from the start */
+			startoff = 0;
 		}
 	}
 done:
@@ -40,6 +40,7 @@
 #include "nodes/makefuncs.h"
 #include "pgstat.h"
 #include "postmaster/autovacuum.h"
+#include "postmaster/bgworker_internals.h"
 #include "storage/bufmgr.h"
 #include "storage/lmgr.h"
 #include "storage/proc.h"
@@ -47,6 +48,7 @@
 #include "utils/acl.h"
 #include "utils/fmgroids.h"
 #include "utils/guc.h"
+#include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/snapmgr.h"
 #include "utils/syscache.h"
@@ -61,6 +63,16 @@ int			vacuum_freeze_table_age;
 int			vacuum_multixact_freeze_min_age;
 int			vacuum_multixact_freeze_table_age;
 
+/*
+ * During parallel index vacuuming, these point to the cost balance shared
+ * by the leader and its workers and to the number of participants currently
+ * doing I/O, and VacuumCostBalanceLocal is the part of the shared balance
+ * this process has accumulated since it last slept.
+ */
+pg_atomic_uint32 *VacuumSharedCostBalance = NULL;
+pg_atomic_uint32 *VacuumActiveNWorkers = NULL;
+int			VacuumCostBalanceLocal = 0;
+
 
 /* A few variables that don't seem worth passing around as parameters */
 static MemoryContext vac_context = NULL;
@@ -69,6 +81,7 @@ static BufferAccessStrategy vac_strategy;
 
 /* non-export function prototypes */
 static List *expand_vacuum_rel(VacuumRelation *vrel, int options);
+static bool partition_is_unchanged(Oid relid);
 static List *get_all_vacuum_rels(int options);
 static void vac_truncate_clog(TransactionId frozenXID,
 				  MultiXactId minMulti,
@@ -76,6 +89,7 @@ static void vac_truncate_clog(TransactionId frozenXID,
 				  MultiXactId lastSaneMinMulti);
 static bool vacuum_rel(Oid relid, RangeVar *relation, int options,
 		   VacuumParams *params);
+static int	compute_parallel_delay(void);
 
 /*
  * Primary entry point for manual VACUUM and ANALYZE commands
@@ -137,6 +151,21 @@ ExecVacuum(VacuumStmt *vacstmt, bool isTopLevel)
 	/* user-invoked vacuum never uses this parameter */
 	params.log_min_duration = -1;
 
+	/*
+	 * Check the PARALLEL option.  Parallel vacuuming of indexes only makes
+	 * sense for lazy vacuum; VACUUM FULL rebuilds the indexes instead.
+	 */
+	if (vacstmt->nworkers > MAX_PARALLEL_WORKER_LIMIT)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("parallel vacuum degree must be between 0 and %d",
+						MAX_PARALLEL_WORKER_LIMIT)));
+	if ((vacstmt->options & VACOPT_FULL) && vacstmt->nworkers > 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("VACUUM option PARALLEL cannot be used with FULL")));
+	params.nworkers = vacstmt->nworkers;
+
 	/* Now go through the common routine */
 	vacuum(vacstmt->options, vacstmt->rels, &params, NULL, isTopLevel);
 }
@@ -327,6 +356,9 @@ vacuum(int options, List *relations, VacuumParams *params,
 		VacuumPageHit = 0;
 		VacuumPageMiss = 0;
 		VacuumPageDirty = 0;
+		VacuumSharedCostBalance = NULL;
+		VacuumActiveNWorkers = NULL;
+		VacuumCostBalanceLocal = 0;
 
 		/*
 		 * Loop to process each selected relation.
@@ -707,6 +739,16 @@ expand_vacuum_rel(VacuumRelation *vrel, int options)
 				if (part_oid == relid)
 					continue;	/* ignore original table */
 
+				/*
+				 * With SKIP_UNCHANGED, leave leaf partitions alone if their
+				 * existing statistics are still current.  The partitioned
+				 * table itself is still processed, so its statistics are
+				 * rebuilt from a fresh sample of all partitions.
+				 */
+				if ((options & VACOPT_SKIP_UNCHANGED) &&
+					partition_is_unchanged(part_oid))
+					continue;
+
 				/*
 				 * We omit a RangeVar since it wouldn't be appropriate to
 				 * complain about failure to open one of these relations
@@ -737,6 +779,30 @@ expand_vacuum_rel(VacuumRelation *vrel, int options)
 	return vacrels;
 }
 
+/*
+ * partition_is_unchanged
+ *
+ * Check whether a leaf partition has been analyzed before and has not been
+ * modified since, according to the statistics collector.  If the collector
+ * has no data for it, assume it has changed.
+ */
+static bool
+partition_is_unchanged(Oid relid)
+{
+	PgStat_StatTabEntry *tabentry;
+
+	if (get_rel_relkind(relid) != RELKIND_RELATION)
+		return false;
+
+	tabentry = pgstat_fetch_stat_tabentry(relid);
+	if (tabentry == NULL)
+		return false;
+
+	return tabentry->changes_since_analyze == 0 &&
+		(tabentry->analyze_timestamp != 0 ||
+		 tabentry->autovac_analyze_timestamp != 0);
+}
+
 /*
  * Construct a list of VacuumRelations for all vacuumable rels in
  * the current database.  The list is built in vac_context.
@@ -1828,16 +1894,26 @@ vac_close_indexes(int nindexes, Relation *Irel, LOCKMODE lockmode)
 void
 vacuum_delay_point(void)
 {
+	int			msec = 0;
+
 	/* Always check for interrupts */
 	CHECK_FOR_INTERRUPTS();
 
-	/* Nap if appropriate */
-	if (VacuumCostActive && !InterruptPending &&
-		VacuumCostBalance >= VacuumCostLimit)
-	{
-		int			msec;
+	if (!VacuumCostActive || InterruptPending)
+		return;
 
+	/*
+	 * In a parallel vacuum the participants share one cost balance, so that
+	 * all of them together stay within VacuumCostLimit.
+	 */
+	if (VacuumSharedCostBalance != NULL)
+		msec = compute_parallel_delay();
+	else if (VacuumCostBalance >= VacuumCostLimit)
 		msec = VacuumCostDelay * VacuumCostBalance / VacuumCostLimit;
+
+	/* Nap if appropriate */
+	if (msec > 0)
+	{
 		if (msec > VacuumCostDelay * 4)
 			msec = VacuumCostDelay * 4;
 
@@ -1852,3 +1928,39 @@ vacuum_delay_point(void)
 		CHECK_FOR_INTERRUPTS();
 	}
 }
+
+/*
+ * compute_parallel_delay --- cost-based delay of a parallel vacuum participant
+ *
+ * Our own cost balance is moved into the shared one.  Once that reaches
+ * VacuumCostLimit, a participant sleeps if it has done at least half its
+ * fair share of the I/O since it last slept, in proportion to that I/O, so
+ * that the heavy hitters are the ones slowed down.  Returns the time to
+ * sleep in milliseconds, or 0.
+ */
+static int
+compute_parallel_delay(void)
+{
+	int			msec = 0;
+	uint32		shared_balance;
+	int			nworkers;
+
+	/* at least this process is active */
+	nworkers = Max(pg_atomic_read_u32(VacuumActiveNWorkers), 1);
+
+	shared_balance = pg_atomic_add_fetch_u32(VacuumSharedCostBalance,
+											 VacuumCostBalance);
+	VacuumCostBalanceLocal += VacuumCostBalance;
+	VacuumCostBalance = 0;
+
+	if (shared_balance >= VacuumCostLimit &&
+		VacuumCostBalanceLocal > 0.5 * ((double) VacuumCostLimit / nworkers))
+	{
+		msec = VacuumCostDelay * VacuumCostBalanceLocal / VacuumCostLimit;
+		pg_atomic_sub_fetch_u32(VacuumSharedCostBalance,
+								VacuumCostBalanceLocal);
+		VacuumCostBalanceLocal = 0;
+	}
+
+	return msec;
+}
@@ -4,23 +4,34 @@
  *	  Concurrent ("lazy") vacuuming.
  *
  *
- * The major space usage for LAZY VACUUM is storage for the array of dead tuple
- * TIDs.  We want to ensure we can vacuum even the very largest relations with
+ * The major space usage for LAZY VACUUM is storage for the dead tuple TIDs.
+ * We want to ensure we can vacuum even the very largest relations with
  * finite memory space usage.  To do that, we set upper bounds on the number of
  * tuples we will keep track of at once.
  *
  * We are willing to use at most maintenance_work_mem (or perhaps
  * autovacuum_work_mem) memory space to keep track of dead tuples.  We
- * initially allocate an array of TIDs of that size, with an upper limit that
- * depends on table size (this limit ensures we don't allocate a huge area
- * uselessly for vacuuming small tables).  If the array threatens to overflow,
- * we suspend the heap scan phase and perform a pass of index cleanup and page
- * compaction, then resume the heap scan with an empty TID array.
+ * initially allocate a dead tuple store of that size, with an upper limit
+ * that depends on table size (this limit ensures we don't allocate a huge
+ * area uselessly for vacuuming small tables).  The store keeps a bitmap of
+ * dead offsets per heap block, see LVDeadTuples, so pages with many dead
+ * tuples take much less space than they would as an array of TIDs.  If the
+ * store threatens to overflow, we suspend the heap scan phase and perform a
+ * pass of index cleanup and page compaction, then resume the heap scan with
+ * an empty store.
  *
  * If we're processing a table with no indexes, we can just vacuum each page
  * as we go; there's no need to save up multiple tuples to minimize the number
  * of index scans performed.  So we don't use maintenance_work_mem memory for
- * the TID array, just enough to hold as many heap tuples as fit on one page.
+ * the store, just enough to hold as many heap tuples as fit on one page.
+ *
+ * A table with several large indexes can have its indexes vacuumed in
+ * parallel.  In that case the dead tuple store is placed in a dynamic shared memory
+ * segment, and at each round of index vacuuming, and again for index
+ * cleanup, we launch parallel workers that, together with the leader, take
+ * the indexes one at a time until all are done.  Each index is processed by
+ * a single process, so the index AMs need no changes.  The heap itself is
+ * only ever processed by the leader, outside of parallel mode.
  *
  *
  * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
@@ -41,20 +52,26 @@
 #include "access/heapam_xlog.h"
 #include "access/htup_details.h"
 #include "access/multixact.h"
+#include "access/parallel.h"
 #include "access/transam.h"
 #include "access/visibilitymap.h"
+#include "access/xact.h"
 #include "access/xlog.h"
 #include "catalog/storage.h"
 #include "commands/dbcommands.h"
 #include "commands/progress.h"
 #include "commands/vacuum.h"
 #include "miscadmin.h"
+#include "optimizer/paths.h"
 #include "pgstat.h"
 #include "portability/instr_time.h"
 #include "postmaster/autovacuum.h"
 #include "storage/bufmgr.h"
 #include "storage/freespace.h"
 #include "storage/lmgr.h"
+#include "storage/proc.h"
+#include "storage/read_stream.h"
+#include "tcop/tcopprot.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/pg_rusage.h"
@@ -92,13 +109,6 @@
 #define VACUUM_FSM_EVERY_PAGES \
 	((BlockNumber) (((uint64) 8 * 1024 * 1024 * 1024) / BLCKSZ))
 
-/*
- * Guesstimation of number of dead tuples per page.  This is used to
- * provide an upper limit to memory allocated when vacuuming small
- * tables.
- */
-#define LAZY_ALLOC_TUPLES		MaxHeapTuplesPerPage
-
 /*
  * Before we consider skipping a page that's marked as clean in
  * visibility map, we must've seen at least this many clean pages.
@@ -111,6 +121,118 @@
  */
 #define PREFETCH_SIZE			((BlockNumber) 32)
 
+/* DSM keys for parallel index vacuuming */
+#define PARALLEL_VACUUM_KEY_SHARED			UINT64CONST(0xD000000000000001)
+#define PARALLEL_VACUUM_KEY_DEAD_TUPLES		UINT64CONST(0xD000000000000002)
+#define PARALLEL_VACUUM_KEY_QUERY_TEXT		UINT64CONST(0xD000000000000003)
+
+/*
+ * Per-index state shared between the participants of a parallel index
+ * vacuum.  The statistics returned by the index AM are kept here between
+ * rounds, since the next round may well be done by a different process.
+ */
+typedef struct LVSharedIndStats
+{
+	Oid			indexoid;
+	bool		updated;		/* is stats valid? */
+	IndexBulkDeleteResult stats;
+} LVSharedIndStats;
+
+/*
+ * Shared state of one round of parallel index vacuuming or cleanup, stored
+ * in the parallel context's DSM segment.
+ */
+typedef struct LVShared
+{
+	Oid			relid;
+	int			elevel;
+	int			leader_pid;
+	int			cost_delay;		/* VacuumCostDelay for the workers */
+	int			cost_limit;		/* VacuumCostLimit for the workers */
+
+	/*
+	 * Cost balance shared by the leader and the workers, and the number of
+	 * them currently processing indexes; see vacuum_delay_point.
+	 */
+	pg_atomic_uint32 cost_balance;
+	pg_atomic_uint32 active_nworkers;
+
+	bool		for_cleanup;
+	double		reltuples;		/* num_heap_tuples to give the index AMs */
+	bool		estimated_count;
+	dsm_handle	dead_tuples_handle; /* segment holding the dead tuples */
+
+	/* Index to be processed next, and number of indexes done */
+	pg_atomic_uint32 nextidx;
+	pg_atomic_uint32 nprocessed;
+
+	int			nindexes;
+	LVSharedIndStats indstats[FLEXIBLE_ARRAY_MEMBER];
+} LVShared;
+
+/*
+ * Dead tuple store
+ *
+ * The TIDs of the dead tuples are kept per heap block: one LVDeadBlock entry
+ * for each block that has any, pointing to a bitmap of its dead offsets.
+ * The heap is scanned in physical order, so entries are only ever appended,
+ * and the bitmap of a block is only as long as its highest dead offset
+ * requires.  A block with a few dead tuples thus takes 16 bytes, and one
+ * full of them about a bit per tuple, where an array of TIDs takes 6 bytes
+ * per tuple.
+ *
+ * Index vacuuming looks up every index tuple in the store, in no particular
+ * order.  To make that cheap, before each round of index vacuuming we build
+ * a directory with a bitmap word for each group of 64 heap blocks, telling
+ * which blocks of the group have an entry, and the number of the first entry
+ * of the group.  The entry of a block is then found by counting bits, with
+ * no searching.
+ *
+ * Everything lives in a single chunk of memory without pointers, so that it
+ * can be placed in a DSM segment for parallel index vacuuming.  Bitmap words
+ * are allocated upward from the start of data[] and block entries downward
+ * from its end; the directory goes in the space left between them, which
+ * lazy_dead_tuples_full makes sure is large enough.
+ */
+#define LV_BITS_PER_WORD		64
+#define LV_BLOCKS_PER_GROUP		LV_BITS_PER_WORD
+
+/* bitmap words needed for a page full of dead tuples */
+#define LV_MAX_PAGE_WORDS \
+	((MaxHeapTuplesPerPage + LV_BITS_PER_WORD - 1) / LV_BITS_PER_WORD)
+
+/* data[] words taken by a directory of ngroups groups */
+#define LV_DIRECTORY_WORDS(ngroups) \
+	((uint64) (ngroups) + ((uint64) (ngroups) + 1) / 2)
+
+/* data[] words needed to store one page full of dead tuples */
+#define LV_MIN_WORDS \
+	(1 + LV_MAX_PAGE_WORDS + LV_DIRECTORY_WORDS(1))
+
+typedef struct LVDeadBlock
+{
+	BlockNumber blkno;
+	uint32		wordno;			/* first bitmap word of the block */
+} LVDeadBlock;
+
+typedef struct LVDeadTuples
+{
+	uint64		nwords;			/* size of data[] */
+	int64		num_tuples;		/* # of dead tuples stored */
+	uint32		num_blocks;		/* # of LVDeadBlock entries */
+	uint32		num_bitmap_words;	/* # of bitmap words in use */
+
+	/* The directory, set up by lazy_build_dead_tuple_directory */
+	BlockNumber dir_start;		/* first block covered, multiple of 64 */
+	uint32		dir_ngroups;	/* # of groups of 64 blocks covered */
+
+	uint64		data[FLEXIBLE_ARRAY_MEMBER];
+} LVDeadTuples;
+
+/* The i'th block entry */
+#define LVDeadBlockAt(dt, i) \
+	((LVDeadBlock *) &(dt)->data[(dt)->nwords - 1 - (i)])
+
 typedef struct LVRelStats
 {
 	/* hasindex = true means two-pass strategy; false means one-pass */
@@ -129,16 +251,34 @@ typedef struct LVRelStats
 	BlockNumber pages_removed;
 	double		tuples_deleted;
 	BlockNumber nonempty_pages; /* actually, last nonempty page + 1 */
-	/* List of TIDs of tuples we intend to delete */
-	/* NB: this list is ordered by TID address */
-	int			num_dead_tuples;	/* current # of entries */
-	int			max_dead_tuples;	/* # slots allocated in array */
-	ItemPointer dead_tuples;	/* array of ItemPointerData */
+	/* TIDs of tuples we intend to delete */
+	LVDeadTuples *dead_tuples;
+	int64		max_dead_tuples;	/* capacity estimate, for progress reports */
+	/* Workers for vacuuming indexes in parallel, if any */
+	int			nworkers;
+	dsm_segment *dead_tuples_seg;	/* holds dead_tuples if nworkers > 0 */
 	int			num_index_scans;
 	TransactionId latestRemovedXid;
 	bool		lock_waiter_detected;
 } LVRelStats;
 
+/*
+ * State for forecasting which heap pages lazy_scan_heap will read, so that
+ * they can be prefetched through a read stream.  This mirrors the page
+ * skipping rules of lazy_scan_heap, using its own visibility map pin; a
+ * wrong forecast only costs a wasted prefetch.
+ */
+typedef struct LVReadAheadState
+{
+	Relation	rel;
+	BlockNumber nblocks;
+	uint8		skipflags;		/* VM bits that make a page skippable */
+	bool		skip_pages;		/* false under DISABLE_PAGE_SKIPPING */
+	BlockNumber next_block;		/* next block to consider */
+	BlockNumber run_end;		/* end of the run containing next_block - 1 */
+	bool		run_skipped;	/* will blocks before run_end be skipped? */
+	Buffer		vmbuffer;
+} LVReadAheadState;
 
 /* A few variables that don't seem worth passing around as parameters */
 static int	elevel = -1;
@@ -153,26 +293,45 @@ static BufferAccessStrategy vac_strategy;
 /* non-export function prototypes */
 static void lazy_scan_heap(Relation onerel, int options,
 			   LVRelStats *vacrelstats, Relation *Irel, int nindexes,
-			   bool aggressive);
+			   bool aggressive, int nrequested);
 static void lazy_vacuum_heap(Relation onerel, LVRelStats *vacrelstats);
 static bool lazy_check_needs_freeze(Buffer buf, bool *hastup);
+static void lazy_vacuum_all_indexes(Relation onerel, Relation *Irel,
+						IndexBulkDeleteResult **stats, int nindexes,
+						LVRelStats *vacrelstats);
+static void lazy_cleanup_all_indexes(Relation onerel, Relation *Irel,
+						 IndexBulkDeleteResult **stats, int nindexes,
+						 LVRelStats *vacrelstats);
 static void lazy_vacuum_index(Relation indrel,
 				  IndexBulkDeleteResult **stats,
-				  LVRelStats *vacrelstats);
+				  LVRelStats *vacrelstats, double reltuples);
 static void lazy_cleanup_index(Relation indrel,
-				   IndexBulkDeleteResult *stats,
-				   LVRelStats *vacrelstats);
+				   IndexBulkDeleteResult **stats,
+				   double reltuples, bool estimated_count);
+static void update_index_statistics(Relation *Irel,
+						IndexBulkDeleteResult **stats, int nindexes);
+static int compute_parallel_workers(Relation onerel, Relation *Irel,
+						 int nindexes, int nrequested);
+static void lazy_parallel_vacuum_indexes(Relation onerel, Relation *Irel,
+							 IndexBulkDeleteResult **stats, int nindexes,
+							 LVRelStats *vacrelstats, bool for_cleanup);
+static void lazy_parallel_process_indexes(Relation *Irel, LVShared *lvshared,
+							  LVRelStats *vacrelstats);
 static int lazy_vacuum_page(Relation onerel, BlockNumber blkno, Buffer buffer,
-				 int tupindex, LVRelStats *vacrelstats, Buffer *vmbuffer);
+				 uint32 blockidx, LVRelStats *vacrelstats, Buffer *vmbuffer);
 static bool should_attempt_truncation(LVRelStats *vacrelstats);
 static void lazy_truncate_heap(Relation onerel, LVRelStats *vacrelstats);
 static BlockNumber count_nondeletable_pages(Relation onerel,
 						 LVRelStats *vacrelstats);
 static void lazy_space_alloc(LVRelStats *vacrelstats, BlockNumber relblocks);
+static void lazy_reset_dead_tuples(LVDeadTuples *dt);
+static bool lazy_dead_tuples_full(LVDeadTuples *dt, BlockNumber blkno);
 static void lazy_record_dead_tuple(LVRelStats *vacrelstats,
 					   ItemPointer itemptr);
+static void lazy_build_dead_tuple_directory(LVDeadTuples *dt);
 static bool lazy_tid_reaped(ItemPointer itemptr, void *state);
-static int	vac_cmp_itemptr(const void *left, const void *right);
+static BlockNumber lazy_scan_heap_next_block(ReadStream *stream,
+						  void *callback_private_data);
 static bool heap_page_is_all_visible(Relation rel, Buffer buf,
 						 TransactionId *visibility_cutoff_xid, bool *all_frozen);
 
@@ -262,7 +421,8 @@ lazy_vacuum_rel(Relation onerel, int options, VacuumParams *params,
 	vacrelstats->hasindex = (nindexes > 0);
 
 	/* Do the vacuuming */
-	lazy_scan_heap(onerel, options, vacrelstats, Irel, nindexes, aggressive);
+	lazy_scan_heap(onerel, options, vacrelstats, Irel, nindexes, aggressive,
+				   params->nworkers);
 
 	/* Done with indexes */
 	vac_close_indexes(nindexes, Irel, NoLock);
@@ -471,7 +631,7 @@ vacuum_log_cleanup_info(Relation rel, LVRelStats *vacrelstats)
  */
 static void
 lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
-			   Relation *Irel, int nindexes, bool aggressive)
+			   Relation *Irel, int nindexes, bool aggressive, int nrequested)
 {
 	BlockNumber nblocks,
 				blkno;
@@ -492,7 +652,10 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 	PGRUsage	ru0;
 	Buffer		vmbuffer = InvalidBuffer;
 	BlockNumber next_unskippable_block;
+	uint8		skipflags;
 	bool		skipping_blocks;
+	LVReadAheadState readahead;
+	ReadStream *stream;
 	xl_heap_freeze_tuple *frozen;
 	StringInfoData buf;
 	const int	initprog_index[] = {
@@ -530,6 +693,13 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 	vacrelstats->nonempty_pages = 0;
 	vacrelstats->latestRemovedXid = InvalidTransactionId;
 
+	/*
+	 * Vacuum the indexes in parallel if there are enough of them worth it.
+	 * This puts the dead tuple array into shared memory, so it must be
+	 * decided now.
+	 */
+	vacrelstats->nworkers = compute_parallel_workers(onerel, Irel, nindexes,
+													 nrequested);
 	lazy_space_alloc(vacrelstats, nblocks);
 	frozen = palloc(sizeof(xl_heap_freeze_tuple) * MaxHeapTuplesPerPage);
 
@@ -583,28 +753,14 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 	 * the last page.  This is worth avoiding mainly because such a lock must
 	 * be replayed on any hot standby, where it can be disruptive.
 	 */
+	skipflags = aggressive ? VISIBILITYMAP_ALL_FROZEN : VISIBILITYMAP_ALL_VISIBLE;
 	next_unskippable_block = 0;
 	if ((options & VACOPT_DISABLE_PAGE_SKIPPING) == 0)
 	{
-		while (next_unskippable_block < nblocks)
-		{
-			uint8		vmstatus;
-
-			vmstatus = visibilitymap_get_status(onerel, next_unskippable_block,
-												&vmbuffer);
-			if (aggressive)
-			{
-				if ((vmstatus & VISIBILITYMAP_ALL_FROZEN) == 0)
-					break;
-			}
-			else
-			{
-				if ((vmstatus & VISIBILITYMAP_ALL_VISIBLE) == 0)
-					break;
-			}
-			vacuum_delay_point();
-			next_unskippable_block++;
-		}
+		next_unskippable_block = visibilitymap_find_unset(onerel, 0, nblocks,
+														  skipflags,
+														  &vmbuffer);
+		vacuum_delay_point();
 	}
 
 	if (next_unskippable_block >= SKIP_PAGES_THRESHOLD)
@@ -612,6 +768,19 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 	else
 		skipping_blocks = false;
 
+	/* Set up look-ahead reading of the pages we expect not to skip */
+	readahead.rel = onerel;
+	readahead.nblocks = nblocks;
+	readahead.skipflags = skipflags;
+	readahead.skip_pages = (options & VACOPT_DISABLE_PAGE_SKIPPING) == 0;
+	readahead.next_block = 0;
+	readahead.run_end = 0;
+	readahead.run_skipped = false;
+	readahead.vmbuffer = InvalidBuffer;
+	stream = read_stream_begin_relation(onerel, MAIN_FORKNUM, vac_strategy,
+										lazy_scan_heap_next_block,
+										&readahead);
+
 	for (blkno = 0; blkno < nblocks; blkno++)
 	{
 		Buffer		buf;
@@ -620,7 +789,7 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 					maxoff;
 		bool		tupgone,
 					hastup;
-		int			prev_dead_count;
+		int64		prev_dead_count;
 		int			nfrozen;
 		Size		freespace;
 		bool		all_visible_according_to_vm = false;
@@ -641,26 +810,10 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 			next_unskippable_block++;
 			if ((options & VACOPT_DISABLE_PAGE_SKIPPING) == 0)
 			{
-				while (next_unskippable_block < nblocks)
-				{
-					uint8		vmskipflags;
-
-					vmskipflags = visibilitymap_get_status(onerel,
-														   next_unskippable_block,
-														   &vmbuffer);
-					if (aggressive)
-					{
-						if ((vmskipflags & VISIBILITYMAP_ALL_FROZEN) == 0)
-							break;
-					}
-					else
-					{
-						if ((vmskipflags & VISIBILITYMAP_ALL_VISIBLE) == 0)
-							break;
-					}
-					vacuum_delay_point();
-					next_unskippable_block++;
-				}
+				next_unskippable_block =
+					visibilitymap_find_unset(onerel, next_unskippable_block,
+											 nblocks, skipflags, &vmbuffer);
+				vacuum_delay_point();
 			}
 
 			/*
@@ -714,8 +867,7 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 		 * If we are close to overrunning the available space for dead-tuple
 		 * TIDs, pause and do a cycle of vacuuming before we tackle this page.
 		 */
-		if ((vacrelstats->max_dead_tuples - vacrelstats->num_dead_tuples) < MaxHeapTuplesPerPage &&
-			vacrelstats->num_dead_tuples > 0)
+		if (lazy_dead_tuples_full(vacrelstats->dead_tuples, blkno))
 		{
 			const int	hvp_index[] = {
 				PROGRESS_VACUUM_PHASE,
@@ -743,10 +895,8 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 										 PROGRESS_VACUUM_PHASE_VACUUM_INDEX);
 
 			/* Remove index entries */
-			for (i = 0; i < nindexes; i++)
-				lazy_vacuum_index(Irel[i],
-								  &indstats[i],
-								  vacrelstats);
+			lazy_vacuum_all_indexes(onerel, Irel, indstats, nindexes,
+									vacrelstats);
 
 			/*
 			 * Report that we are now vacuuming the heap.  We also increase
@@ -766,7 +916,7 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 			 * not to reset latestRemovedXid since we want that value to be
 			 * valid.
 			 */
-			vacrelstats->num_dead_tuples = 0;
+			lazy_reset_dead_tuples(vacrelstats->dead_tuples);
 			vacrelstats->num_index_scans++;
 
 			/*
@@ -792,8 +942,7 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 		 */
 		visibilitymap_pin(onerel, blkno, &vmbuffer);
 
-		buf = ReadBufferExtended(onerel, MAIN_FORKNUM, blkno,
-								 RBM_NORMAL, vac_strategy);
+		buf = read_stream_get_buffer(stream, blkno);
 
 		/* We need buffer cleanup lock so that we can prune HOT chains. */
 		if (!ConditionalLockBufferForCleanup(buf))
@@ -956,7 +1105,7 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 		has_dead_tuples = false;
 		nfrozen = 0;
 		hastup = false;
-		prev_dead_count = vacrelstats->num_dead_tuples;
+		prev_dead_count = vacrelstats->dead_tuples->num_tuples;
 		maxoff = PageGetMaxOffsetNumber(page);
 
 		/*
@@ -1205,7 +1354,7 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 		 * instead of doing a second scan.
 		 */
 		if (nindexes == 0 &&
-			vacrelstats->num_dead_tuples > 0)
+			vacrelstats->dead_tuples->num_tuples > 0)
 		{
 			/* Remove tuples from heap */
 			lazy_vacuum_page(onerel, blkno, buf, 0, vacrelstats, &vmbuffer);
@@ -1216,7 +1365,7 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 			 * not to reset latestRemovedXid since we want that value to be
 			 * valid.
 			 */
-			vacrelstats->num_dead_tuples = 0;
+			lazy_reset_dead_tuples(vacrelstats->dead_tuples);
 			vacuumed_pages++;
 
 			/*
@@ -1332,7 +1481,7 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 		 * page, so remember its free space as-is.  (This path will always be
 		 * taken if there are no indexes.)
 		 */
-		if (vacrelstats->num_dead_tuples == prev_dead_count)
+		if (vacrelstats->dead_tuples->num_tuples == prev_dead_count)
 			RecordPageWithFreeSpace(onerel, blkno, freespace);
 	}
 
@@ -1364,9 +1513,13 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 		vmbuffer = InvalidBuffer;
 	}
 
+	read_stream_end(stream);
+	if (BufferIsValid(readahead.vmbuffer))
+		ReleaseBuffer(readahead.vmbuffer);
+
 	/* If any tuples need to be deleted, perform final vacuum cycle */
 	/* XXX put a threshold on min number of tuples here? */
-	if (vacrelstats->num_dead_tuples > 0)
+	if (vacrelstats->dead_tuples->num_tuples > 0)
 	{
 		const int	hvp_index[] = {
 			PROGRESS_VACUUM_PHASE,
@@ -1382,10 +1535,7 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 									 PROGRESS_VACUUM_PHASE_VACUUM_INDEX);
 
 		/* Remove index entries */
-		for (i = 0; i < nindexes; i++)
-			lazy_vacuum_index(Irel[i],
-							  &indstats[i],
-							  vacrelstats);
+		lazy_vacuum_all_indexes(onerel, Irel, indstats, nindexes, vacrelstats);
 
 		/* Report that we are now vacuuming the heap */
 		hvp_val[0] = PROGRESS_VACUUM_PHASE_VACUUM_HEAP;
@@ -1411,9 +1561,16 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 	pgstat_progress_update_param(PROGRESS_VACUUM_PHASE,
 								 PROGRESS_VACUUM_PHASE_INDEX_CLEANUP);
 
-	/* Do post-vacuum cleanup and statistics update for each index */
-	for (i = 0; i < nindexes; i++)
-		lazy_cleanup_index(Irel[i], indstats[i], vacrelstats);
+	/* Do post-vacuum cleanup for each index */
+	lazy_cleanup_all_indexes(onerel, Irel, indstats, nindexes, vacrelstats);
+	update_index_statistics(Irel, indstats, nindexes);
+
+	if (vacrelstats->dead_tuples_seg != NULL)
+	{
+		dsm_detach(vacrelstats->dead_tuples_seg);
+		vacrelstats->dead_tuples_seg = NULL;
+		vacrelstats->dead_tuples = NULL;
+	}
 
 	/* If no indexes, make log report that lazy_vacuum_heap would've made */
 	if (vacuumed_pages)
@@ -1456,6 +1613,61 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 }
 
 
+/*
+ *	lazy_scan_heap_next_block() -- read stream callback for lazy_scan_heap
+ *
+ * Returns the next block lazy_scan_heap is expected to read.  Runs of
+ * skippable blocks are only skipped when at least SKIP_PAGES_THRESHOLD
+ * long, and the last page is always returned, since lazy_scan_heap may be
+ * forced to check it for truncation.
+ */
+static BlockNumber
+lazy_scan_heap_next_block(ReadStream *stream, void *callback_private_data)
+{
+	LVReadAheadState *state = (LVReadAheadState *) callback_private_data;
+
+	while (state->next_block < state->nblocks)
+	{
+		BlockNumber blkno = state->next_block++;
+
+		if (blkno >= state->run_end)
+		{
+			BlockNumber end = blkno;
+
+			/*
+			 * Classify the run of blocks starting here, using the same
+			 * visibility map test as lazy_scan_heap applies for
+			 * next_unskippable_block.
+			 */
+			if (state->skip_pages)
+			{
+				end = visibilitymap_find_unset(state->rel, blkno,
+											   state->nblocks,
+											   state->skipflags,
+											   &state->vmbuffer);
+				vacuum_delay_point();
+			}
+
+			if (end == blkno)
+			{
+				state->run_end = blkno + 1;
+				state->run_skipped = false;
+			}
+			else
+			{
+				state->run_end = end;
+				state->run_skipped = (end - blkno >= SKIP_PAGES_THRESHOLD);
+			}
+		}
+
+		if (!state->run_skipped || blkno == state->nblocks - 1)
+			return blkno;
+	}
+
+	return InvalidBlockNumber;
+}
+
+
 /*
  *	lazy_vacuum_heap() -- second pass over the heap
  *
@@ -1470,16 +1682,18 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 static void
 lazy_vacuum_heap(Relation onerel, LVRelStats *vacrelstats)
 {
-	int			tupindex;
+	LVDeadTuples *dt = vacrelstats->dead_tuples;
+	uint32		blockidx;
+	double		ntuples;
 	int			npages;
 	PGRUsage	ru0;
 	Buffer		vmbuffer = InvalidBuffer;
 
 	pg_rusage_init(&ru0);
+	ntuples = 0;
 	npages = 0;
 
-	tupindex = 0;
-	while (tupindex < vacrelstats->num_dead_tuples)
+	for (blockidx = 0; blockidx < dt->num_blocks; blockidx++)
 	{
 		BlockNumber tblk;
 		Buffer		buf;
@@ -1488,16 +1702,21 @@ lazy_vacuum_heap(Relation onerel, LVRelStats *vacrelstats)
 
 		vacuum_delay_point();
 
-		tblk = ItemPointerGetBlockNumber(&vacrelstats->dead_tuples[tupindex]);
+		tblk = LVDeadBlockAt(dt, blockidx)->blkno;
 		buf = ReadBufferExtended(onerel, MAIN_FORKNUM, tblk, RBM_NORMAL,
 								 vac_strategy);
+
+		/*
+		 * If someone else has the page pinned, leave its dead tuples for the
+		 * next vacuum.  Their index entries are gone already, so all that's
+		 * left to do then is to mark them unused.
+		 */
 		if (!ConditionalLockBufferForCleanup(buf))
 		{
 			ReleaseBuffer(buf);
-			++tupindex;
 			continue;
 		}
-		tupindex = lazy_vacuum_page(onerel, tblk, buf, tupindex, vacrelstats,
+		ntuples += lazy_vacuum_page(onerel, tblk, buf, blockidx, vacrelstats,
 									&vmbuffer);
 
 		/* Now that we've compacted the page, record its available space */
@@ -1516,9 +1735,9 @@ lazy_vacuum_heap(Relation onerel, LVRelStats *vacrelstats)
 	}
 
 	ereport(elevel,
-			(errmsg("\"%s\": removed %d row versions in %d pages",
+			(errmsg("\"%s\": removed %.0f row versions in %d pages",
 					RelationGetRelationName(onerel),
-					tupindex, npages),
+					ntuples, npages),
 			 errdetail_internal("%s", pg_rusage_show(&ru0))));
 }
 
@@ -1528,37 +1747,48 @@ lazy_vacuum_heap(Relation onerel, LVRelStats *vacrelstats)
  *
  * Caller must hold pin and buffer cleanup lock on the buffer.
  *
- * tupindex is the index in vacrelstats->dead_tuples of the first dead
- * tuple for this page.  We assume the rest follow sequentially.
- * The return value is the first tupindex after the tuples of this page.
+ * blockidx is the number of the entry of this page in vacrelstats->dead_tuples.
+ * The return value is the number of tuples removed.
  */
 static int
 lazy_vacuum_page(Relation onerel, BlockNumber blkno, Buffer buffer,
-				 int tupindex, LVRelStats *vacrelstats, Buffer *vmbuffer)
+				 uint32 blockidx, LVRelStats *vacrelstats, Buffer *vmbuffer)
 {
+	LVDeadTuples *dt = vacrelstats->dead_tuples;
+	LVDeadBlock *block = LVDeadBlockAt(dt, blockidx);
+	uint32		endword;
+	uint32		wordno;
 	Page		page = BufferGetPage(buffer);
 	OffsetNumber unused[MaxOffsetNumber];
 	int			uncnt = 0;
 	TransactionId visibility_cutoff_xid;
 	bool		all_frozen;
 
+	Assert(block->blkno == blkno);
+	endword = (blockidx + 1 < dt->num_blocks) ?
+		LVDeadBlockAt(dt, blockidx + 1)->wordno : dt->num_bitmap_words;
+
 	pgstat_progress_update_param(PROGRESS_VACUUM_HEAP_BLKS_VACUUMED, blkno);
 
 	START_CRIT_SECTION();
 
-	for (; tupindex < vacrelstats->num_dead_tuples; tupindex++)
+	for (wordno = block->wordno; wordno < endword; wordno++)
 	{
-		BlockNumber tblk;
-		OffsetNumber toff;
-		ItemId		itemid;
+		uint64		word = dt->data[wordno];
+		int			bitno = (wordno - block->wordno) * LV_BITS_PER_WORD;
 
-		tblk = ItemPointerGetBlockNumber(&vacrelstats->dead_tuples[tupindex]);
-		if (tblk != blkno)
-			break;				/* past end of tuples for this block */
-		toff = ItemPointerGetOffsetNumber(&vacrelstats->dead_tuples[tupindex]);
-		itemid = PageGetItemId(page, toff);
-		ItemIdSetUnused(itemid);
-		unused[uncnt++] = toff;
+		for (; word != 0; word >>= 1, bitno++)
+		{
+			OffsetNumber toff;
+			ItemId		itemid;
+
+			if ((word & 1) == 0)
+				continue;
+			toff = (OffsetNumber) (bitno + 1);
+			itemid = PageGetItemId(page, toff);
+			ItemIdSetUnused(itemid);
+			unused[uncnt++] = toff;
+		}
 	}
 
 	PageRepairFragmentation(page);
@@ -1620,7 +1850,7 @@ lazy_vacuum_page(Relation onerel, BlockNumber blkno, Buffer buffer,
 							  *vmbuffer, visibility_cutoff_xid, flags);
 	}
 
-	return tupindex;
+	return uncnt;
 }
 
 /*
@@ -1676,16 +1906,91 @@ lazy_check_needs_freeze(Buffer buf, bool *hastup)
 }
 
 
+/*
+ *	lazy_vacuum_all_indexes() -- vacuum all indexes of the relation.
+ *
+ *		Delete the index entries pointing to the tuples in
+ *		vacrelstats->dead_tuples from every index, in parallel if
+ *		possible.
+ */
+static void
+lazy_vacuum_all_indexes(Relation onerel, Relation *Irel,
+						IndexBulkDeleteResult **stats, int nindexes,
+						LVRelStats *vacrelstats)
+{
+	int			i;
+
+	pgstat_progress_update_param(PROGRESS_VACUUM_INDEXES_TOTAL, nindexes);
+	pgstat_progress_update_param(PROGRESS_VACUUM_INDEXES_PROCESSED, 0);
+
+	/* Prepare for lookups, before any workers see the store */
+	lazy_build_dead_tuple_directory(vacrelstats->dead_tuples);
+
+	if (vacrelstats->nworkers > 0)
+	{
+		lazy_parallel_vacuum_indexes(onerel, Irel, stats, nindexes,
+									 vacrelstats, false);
+		return;
+	}
+
+	for (i = 0; i < nindexes; i++)
+	{
+		/* We can only provide an approximate value of num_heap_tuples here */
+		lazy_vacuum_index(Irel[i], &stats[i], vacrelstats,
+						  vacrelstats->old_live_tuples);
+		pgstat_progress_update_param(PROGRESS_VACUUM_INDEXES_PROCESSED, i + 1);
+	}
+}
+
+/*
+ *	lazy_cleanup_all_indexes() -- do post-vacuum cleanup for all indexes.
+ *
+ *		The resulting statistics are left in stats[], for the caller to
+ *		pass to update_index_statistics.
+ */
+static void
+lazy_cleanup_all_indexes(Relation onerel, Relation *Irel,
+						 IndexBulkDeleteResult **stats, int nindexes,
+						 LVRelStats *vacrelstats)
+{
+	bool		estimated_count;
+	int			i;
+
+	pgstat_progress_update_param(PROGRESS_VACUUM_INDEXES_TOTAL, nindexes);
+	pgstat_progress_update_param(PROGRESS_VACUUM_INDEXES_PROCESSED, 0);
+
+	if (vacrelstats->nworkers > 0)
+	{
+		lazy_parallel_vacuum_indexes(onerel, Irel, stats, nindexes,
+									 vacrelstats, true);
+		return;
+	}
+
+	/*
+	 * Now we can provide a better estimate of total number of surviving
+	 * tuples (we assume indexes are more interested in that than in the
+	 * number of nominally live tuples).
+	 */
+	estimated_count = (vacrelstats->tupcount_pages < vacrelstats->rel_pages);
+	for (i = 0; i < nindexes; i++)
+	{
+		lazy_cleanup_index(Irel[i], &stats[i], vacrelstats->new_rel_tuples,
+						   estimated_count);
+		pgstat_progress_update_param(PROGRESS_VACUUM_INDEXES_PROCESSED, i + 1);
+	}
+}
+
 /*
  *	lazy_vacuum_index() -- vacuum one index relation.
  *
  *		Delete all the index entries pointing to tuples listed in
  *		vacrelstats->dead_tuples, and update running statistics.
+ *		reltuples is the number of heap tuples to report to the index AM.
  */
 static void
 lazy_vacuum_index(Relation indrel,
 				  IndexBulkDeleteResult **stats,
-				  LVRelStats *vacrelstats)
+				  LVRelStats *vacrelstats, double reltuples)
 {
 	IndexVacuumInfo ivinfo;
 	PGRUsage	ru0;
@@ -1696,8 +2001,7 @@ lazy_vacuum_index(Relation indrel,
 	ivinfo.analyze_only = false;
 	ivinfo.estimated_count = true;
 	ivinfo.message_level = elevel;
-	/* We can only provide an approximate value of num_heap_tuples here */
-	ivinfo.num_heap_tuples = vacrelstats->old_live_tuples;
+	ivinfo.num_heap_tuples = reltuples;
 	ivinfo.strategy = vac_strategy;
 
 	/* Do bulk deletion */
@@ -1705,19 +2009,22 @@ lazy_vacuum_index(Relation indrel,
 							   lazy_tid_reaped, (void *) vacrelstats);
 
 	ereport(elevel,
-			(errmsg("scanned index \"%s\" to remove %d row versions",
+			(errmsg("scanned index \"%s\" to remove %.0f row versions",
 					RelationGetRelationName(indrel),
-					vacrelstats->num_dead_tuples),
+					(double) vacrelstats->dead_tuples->num_tuples),
 			 errdetail_internal("%s", pg_rusage_show(&ru0))));
 }
 
 /*
  *	lazy_cleanup_index() -- do post-vacuum cleanup for one index relation.
+ *
+ *		The statistics in pg_class are not updated here, since that can't be
+ *		done from a parallel worker; see update_index_statistics.
  */
 static void
 lazy_cleanup_index(Relation indrel,
-				   IndexBulkDeleteResult *stats,
-				   LVRelStats *vacrelstats)
+				   IndexBulkDeleteResult **stats,
+				   double reltuples, bool estimated_count)
 {
 	IndexVacuumInfo ivinfo;
 	PGRUsage	ru0;
@@ -1726,49 +2033,372 @@ lazy_cleanup_index(Relation indrel,
 
 	ivinfo.index = indrel;
 	ivinfo.analyze_only = false;
-	ivinfo.estimated_count = (vacrelstats->tupcount_pages < vacrelstats->rel_pages);
+	ivinfo.estimated_count = estimated_count;
 	ivinfo.message_level = elevel;
-
-	/*
-	 * Now we can provide a better estimate of total number of surviving
-	 * tuples (we assume indexes are more interested in that than in the
-	 * number of nominally live tuples).
-	 */
-	ivinfo.num_heap_tuples = vacrelstats->new_rel_tuples;
+	ivinfo.num_heap_tuples = reltuples;
 	ivinfo.strategy = vac_strategy;
 
-	stats = index_vacuum_cleanup(&ivinfo, stats);
+	*stats = index_vacuum_cleanup(&ivinfo, *stats);
 
-	if (!stats)
+	if (!*stats)
 		return;
 
-	/*
-	 * Now update statistics in pg_class, but only if the index says the count
-	 * is accurate.
-	 */
-	if (!stats->estimated_count)
-		vac_update_relstats(indrel,
-							stats->num_pages,
-							stats->num_index_tuples,
-							0,
-							false,
-							InvalidTransactionId,
-							InvalidMultiXactId,
-							false);
-
 	ereport(elevel,
 			(errmsg("index \"%s\" now contains %.0f row versions in %u pages",
 					RelationGetRelationName(indrel),
-					stats->num_index_tuples,
-					stats->num_pages),
+					(*stats)->num_index_tuples,
+					(*stats)->num_pages),
 			 errdetail("%.0f index row versions were removed.\n"
 					   "%u index pages have been deleted, %u are currently reusable.\n"
 					   "%s.",
-					   stats->tuples_removed,
-					   stats->pages_deleted, stats->pages_free,
+					   (*stats)->tuples_removed,
+					   (*stats)->pages_deleted, (*stats)->pages_free,
 					   pg_rusage_show(&ru0))));
+}
 
-	pfree(stats);
+/*
+ *	update_index_statistics() -- update index statistics in pg_class,
+ *		but only for the indexes that say their count is accurate.
+ */
+static void
+update_index_statistics(Relation *Irel, IndexBulkDeleteResult **stats,
+						int nindexes)
+{
+	int			i;
+
+	Assert(!IsInParallelMode());
+
+	for (i = 0; i < nindexes; i++)
+	{
+		if (stats[i] == NULL)
+			continue;
+
+		if (!stats[i]->estimated_count)
+			vac_update_relstats(Irel[i],
+								stats[i]->num_pages,
+								stats[i]->num_index_tuples,
+								0,
+								false,
+								InvalidTransactionId,
+								InvalidMultiXactId,
+								false);
+		pfree(stats[i]);
+		stats[i] = NULL;
+	}
+}
+
+/*
+ * compute_parallel_workers - how many workers should vacuum the indexes?
+ *
+ * nrequested is the PARALLEL option of VACUUM: the number of workers asked
+ * for, 0 to choose automatically, or -1 to use no workers at all.  Only
+ * indexes of at least min_parallel_index_scan_size count, and the leader
+ * takes one of them itself.  The result is limited by
+ * max_parallel_maintenance_workers.
+ */
+static int
+compute_parallel_workers(Relation onerel, Relation *Irel, int nindexes,
+						 int nrequested)
+{
+	int			nindexes_parallel = 0;
+	int			parallel_workers;
+	int			i;
+
+	/* Workers can't access the local buffers of temporary tables */
+	if (nrequested < 0 || nindexes <= 1 ||
+		max_parallel_maintenance_workers == 0 ||
+		RelationUsesLocalBuffers(onerel))
+		return 0;
+
+	for (i = 0; i < nindexes; i++)
+	{
+		if (RelationGetNumberOfBlocks(Irel[i]) >=
+			(BlockNumber) min_parallel_index_scan_size)
+			nindexes_parallel++;
+	}
+
+	/* The leader vacuums one index itself */
+	nindexes_parallel--;
+	if (nindexes_parallel <= 0)
+		return 0;
+
+	parallel_workers = (nrequested > 0) ?
+		Min(nrequested, nindexes_parallel) : nindexes_parallel;
+
+	return Min(parallel_workers, max_parallel_maintenance_workers);
+}
+
+/*
+ * lazy_parallel_vacuum_indexes - do one round of index vacuuming or cleanup
+ * with the help of parallel workers
+ *
+ * We only stay in parallel mode for the duration of the round, since the
+ * heap scan may need to do things not allowed in parallel mode, such as
+ * creating MultiXactIds while freezing; that's why the dead tuple array
+ * lives in a DSM segment of its own.  The statistics in stats[] are passed
+ * to the workers through the parallel context, and updated on return.
+ */
+static void
+lazy_parallel_vacuum_indexes(Relation onerel, Relation *Irel,
+							 IndexBulkDeleteResult **stats, int nindexes,
+							 LVRelStats *vacrelstats, bool for_cleanup)
+{
+	ParallelContext *pcxt;
+	LVShared   *lvshared;
+	Size		estshared;
+	char	   *sharedquery;
+	int			querylen;
+	int			i;
+
+	EnterParallelMode();
+	pcxt = CreateParallelContext("postgres", "lazy_parallel_vacuum_main",
+								 vacrelstats->nworkers, true);
+
+	/* Estimate size for PARALLEL_VACUUM_KEY_SHARED */
+	estshared = add_size(offsetof(LVShared, indstats),
+						 mul_size(sizeof(LVSharedIndStats), nindexes));
+	shm_toc_estimate_chunk(&pcxt->estimator, estshared);
+
+	/* Finally, estimate PARALLEL_VACUUM_KEY_QUERY_TEXT space */
+	querylen = strlen(debug_query_string);
+	shm_toc_estimate_chunk(&pcxt->estimator, querylen + 1);
+	shm_toc_estimate_keys(&pcxt->estimator, 2);
+
+	InitializeParallelDSM(pcxt);
+
+	lvshared = (LVShared *) shm_toc_allocate(pcxt->toc, estshared);
+	lvshared->relid = RelationGetRelid(onerel);
+	lvshared->elevel = elevel;
+	lvshared->leader_pid = MyProcPid;
+
+	/*
+	 * The leader and the workers draw on one cost balance, starting from
+	 * what the leader has accumulated, so that together they stay within
+	 * the cost limit.
+	 */
+	lvshared->cost_delay = VacuumCostDelay;
+	lvshared->cost_limit = VacuumCostLimit;
+	pg_atomic_init_u32(&lvshared->cost_balance, VacuumCostBalance);
+	pg_atomic_init_u32(&lvshared->active_nworkers, 0);
+
+	lvshared->for_cleanup = for_cleanup;
+	if (for_cleanup)
+	{
+		lvshared->reltuples = vacrelstats->new_rel_tuples;
+		lvshared->estimated_count =
+			(vacrelstats->tupcount_pages < vacrelstats->rel_pages);
+	}
+	else
+	{
+		/* We can only provide an approximate value of num_heap_tuples here */
+		lvshared->reltuples = vacrelstats->old_live_tuples;
+		lvshared->estimated_count = true;
+	}
+	lvshared->dead_tuples_handle = dsm_segment_handle(vacrelstats->dead_tuples_seg);
+	pg_atomic_init_u32(&lvshared->nextidx, 0);
+	pg_atomic_init_u32(&lvshared->nprocessed, 0);
+
+	lvshared->nindexes = nindexes;
+	for (i = 0; i < nindexes; i++)
+	{
+		LVSharedIndStats *shstats = &lvshared->indstats[i];
+
+		shstats->indexoid = RelationGetRelid(Irel[i]);
+		shstats->updated = (stats[i] != NULL);
+		if (shstats->updated)
+			memcpy(&shstats->stats, stats[i], sizeof(IndexBulkDeleteResult));
+	}
+	shm_toc_insert(pcxt->toc, PARALLEL_VACUUM_KEY_SHARED, lvshared);
+
+	/* Store query string for workers */
+	sharedquery = (char *) shm_toc_allocate(pcxt->toc, querylen + 1);
+	memcpy(sharedquery, debug_query_string, querylen + 1);
+	shm_toc_insert(pcxt->toc, PARALLEL_VACUUM_KEY_QUERY_TEXT, sharedquery);
+
+	LaunchParallelWorkers(pcxt);
+
+	ereport(elevel,
+			(errmsg(for_cleanup ?
+					ngettext("launched %d parallel vacuum worker for index cleanup (planned: %d)",
+							 "launched %d parallel vacuum workers for index cleanup (planned: %d)",
+							 pcxt->nworkers_launched) :
+					ngettext("launched %d parallel vacuum worker for index vacuuming (planned: %d)",
+							 "launched %d parallel vacuum workers for index vacuuming (planned: %d)",
+							 pcxt->nworkers_launched),
+					pcxt->nworkers_launched, vacrelstats->nworkers)));
+
+	/* Join the work ourselves, which also covers the case of no workers */
+	VacuumCostBalance = 0;
+	VacuumCostBalanceLocal = 0;
+	VacuumSharedCostBalance = &lvshared->cost_balance;
+	VacuumActiveNWorkers = &lvshared->active_nworkers;
+
+	lazy_parallel_process_indexes(Irel, lvshared, vacrelstats);
+
+	WaitForParallelWorkersToFinish(pcxt);
+
+	/* Carry over what's left of the shared balance to the heap scan */
+	VacuumCostBalance = pg_atomic_read_u32(&lvshared->cost_balance);
+	VacuumCostBalanceLocal = 0;
+	VacuumSharedCostBalance = NULL;
+	VacuumActiveNWorkers = NULL;
+
+	/* Copy back the statistics before the DSM segment goes away */
+	for (i = 0; i < nindexes; i++)
+	{
+		LVSharedIndStats *shstats = &lvshared->indstats[i];
+
+		if (!shstats->updated)
+			continue;
+		if (stats[i] == NULL)
+			stats[i] = (IndexBulkDeleteResult *)
+				palloc(sizeof(IndexBulkDeleteResult));
+		memcpy(stats[i], &shstats->stats, sizeof(IndexBulkDeleteResult));
+	}
+
+	DestroyParallelContext(pcxt);
+	ExitParallelMode();
+}
+
+/*
+ * lazy_parallel_process_indexes - vacuum or clean up indexes until none are
+ * left, in the leader or in a worker
+ *
+ * Each participant claims the next unprocessed index, so that the indexes
+ * are spread over the participants as they become free.
+ */
+static void
+lazy_parallel_process_indexes(Relation *Irel, LVShared *lvshared,
+							  LVRelStats *vacrelstats)
+{
+	pgstat_progress_update_param(PROGRESS_VACUUM_PHASE,
+								 lvshared->for_cleanup ?
+								 PROGRESS_VACUUM_PHASE_INDEX_CLEANUP :
+								 PROGRESS_VACUUM_PHASE_VACUUM_INDEX);
+
+	pg_atomic_add_fetch_u32(&lvshared->active_nworkers, 1);
+
+	for (;;)
+	{
+		uint32		idx = pg_atomic_fetch_add_u32(&lvshared->nextidx, 1);
+		LVSharedIndStats *shstats;
+		IndexBulkDeleteResult *stats;
+
+		if (idx >= (uint32) lvshared->nindexes)
+			break;
+
+		shstats = &lvshared->indstats[idx];
+		stats = shstats->updated ? &shstats->stats : NULL;
+
+		if (lvshared->for_cleanup)
+			lazy_cleanup_index(Irel[idx], &stats, lvshared->reltuples,
+							   lvshared->estimated_count);
+		else
+			lazy_vacuum_index(Irel[idx], &stats, vacrelstats,
+							  lvshared->reltuples);
+
+		/*
+		 * If the index AM allocated the statistics itself, move them into
+		 * shared memory, for the leader.
+		 */
+		if (stats != NULL && stats != &shstats->stats)
+		{
+			memcpy(&shstats->stats, stats, sizeof(IndexBulkDeleteResult));
+			shstats->updated = true;
+			pfree(stats);
+		}
+
+		pgstat_progress_update_param(PROGRESS_VACUUM_INDEXES_PROCESSED,
+									 pg_atomic_add_fetch_u32(&lvshared->nprocessed, 1));
+	}
+
+	pg_atomic_sub_fetch_u32(&lvshared->active_nworkers, 1);
+}
+
+/*
+ * Perform work within a launched parallel process.
+ */
+void
+lazy_parallel_vacuum_main(dsm_segment *seg, shm_toc *toc)
+{
+	char	   *sharedquery;
+	LVShared   *lvshared;
+	LVRelStats	vacrelstats;
+	dsm_segment *dead_tuples_seg = NULL;
+	Relation	onerel;
+	Relation   *Irel;
+	int			i;
+
+	/* Set debug_query_string for individual workers first */
+	sharedquery = shm_toc_lookup(toc, PARALLEL_VACUUM_KEY_QUERY_TEXT, false);
+	debug_query_string = sharedquery;
+
+	/* Report the query string from leader */
+	pgstat_report_activity(STATE_RUNNING, debug_query_string);
+
+	lvshared = (LVShared *) shm_toc_lookup(toc, PARALLEL_VACUUM_KEY_SHARED,
+										   false);
+	elevel = lvshared->elevel;
+
+	/*
+	 * Like the leader, don't let our snapshot hold back the xmin horizon of
+	 * other vacuums.  We never look at heap tuples.
+	 */
+	LWLockAcquire(ProcArrayLock, LW_EXCLUSIVE);
+	MyPgXact->vacuumFlags |= PROC_IN_VACUUM;
+	LWLockRelease(ProcArrayLock);
+
+	/* Open relations using the lock modes the leader holds */
+	onerel = heap_open(lvshared->relid, ShareUpdateExclusiveLock);
+	Irel = (Relation *) palloc(lvshared->nindexes * sizeof(Relation));
+	for (i = 0; i < lvshared->nindexes; i++)
+		Irel[i] = index_open(lvshared->indstats[i].indexoid,
+							 RowExclusiveLock);
+
+	/* Only the dead tuple store is used by lazy_vacuum_index */
+	MemSet(&vacrelstats, 0, sizeof(LVRelStats));
+	if (!lvshared->for_cleanup)
+	{
+		dead_tuples_seg = dsm_attach(lvshared->dead_tuples_handle);
+		if (dead_tuples_seg == NULL)
+			ereport(ERROR,
+					(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+					 errmsg("could not map dynamic shared memory segment")));
+		vacrelstats.dead_tuples = (LVDeadTuples *)
+			dsm_segment_address(dead_tuples_seg);
+	}
+
+	/* Set up cost-based vacuum delay, as vacuum() does */
+	VacuumCostDelay = lvshared->cost_delay;
+	VacuumCostLimit = lvshared->cost_limit;
+	VacuumCostActive = (VacuumCostDelay > 0);
+	VacuumCostBalance = 0;
+	VacuumPageHit = 0;
+	VacuumPageMiss = 0;
+	VacuumPageDirty = 0;
+	VacuumSharedCostBalance = &lvshared->cost_balance;
+	VacuumActiveNWorkers = &lvshared->active_nworkers;
+	VacuumCostBalanceLocal = 0;
+
+	vac_strategy = GetAccessStrategy(BAS_VACUUM);
+
+	/* Report progress in a row of our own, pointing at the leader */
+	pgstat_progress_start_command(PROGRESS_COMMAND_VACUUM, lvshared->relid);
+	pgstat_progress_update_param(PROGRESS_VACUUM_LEADER_PID,
+								 lvshared->leader_pid);
+	pgstat_progress_update_param(PROGRESS_VACUUM_INDEXES_TOTAL,
+								 lvshared->nindexes);
+
+	lazy_parallel_process_indexes(Irel, lvshared, &vacrelstats);
+
+	pgstat_progress_end_command();
+
+	if (dead_tuples_seg != NULL)
+		dsm_detach(dead_tuples_seg);
+	for (i = 0; i < lvshared->nindexes; i++)
+		index_close(Irel[i], RowExclusiveLock);
+	heap_close(onerel, ShareUpdateExclusiveLock);
+	FreeAccessStrategy(vac_strategy);
 }
 
 /*
@@ -2081,106 +2711,267 @@ count_nondeletable_pages(Relation onerel, LVRelStats *vacrelstats)
 static void
 lazy_space_alloc(LVRelStats *vacrelstats, BlockNumber relblocks)
 {
-	long		maxtuples;
+	uint64		nwords;
+	Size		size;
 	int			vac_work_mem = IsAutoVacuumWorkerProcess() &&
 	autovacuum_work_mem != -1 ?
 	autovacuum_work_mem : maintenance_work_mem;
 
 	if (vacrelstats->hasindex)
 	{
-		maxtuples = (vac_work_mem * 1024L) / sizeof(ItemPointerData);
-		maxtuples = Min(maxtuples, INT_MAX);
-		maxtuples = Min(maxtuples, MaxAllocSize / sizeof(ItemPointerData));
+		uint64		maxwords;
+
+		nwords = ((uint64) vac_work_mem * 1024) / sizeof(uint64);
 
-		/* curious coding here to ensure the multiplication can't overflow */
-		if ((BlockNumber) (maxtuples / LAZY_ALLOC_TUPLES) > relblocks)
-			maxtuples = relblocks * LAZY_ALLOC_TUPLES;
+		/* block entries can only address 2^32 bitmap words */
+		nwords = Min(nwords, (uint64) PG_UINT32_MAX);
+
+		/* no need for more than every page full of dead tuples would take */
+		maxwords = (uint64) relblocks * (1 + LV_MAX_PAGE_WORDS) +
+			LV_DIRECTORY_WORDS(relblocks / LV_BLOCKS_PER_GROUP + 1);
+		nwords = Min(nwords, maxwords);
 
 		/* stay sane if small maintenance_work_mem */
-		maxtuples = Max(maxtuples, MaxHeapTuplesPerPage);
+		nwords = Max(nwords, LV_MIN_WORDS);
+
+		/*
+		 * For progress reporting, the number of dead tuples that fit if they
+		 * are packed as densely as they can be.
+		 */
+		vacrelstats->max_dead_tuples =
+			Min((int64) (nwords / (1 + LV_MAX_PAGE_WORDS)),
+				(int64) relblocks) * MaxHeapTuplesPerPage;
+		vacrelstats->max_dead_tuples = Max(vacrelstats->max_dead_tuples,
+										   MaxHeapTuplesPerPage);
 	}
 	else
 	{
-		maxtuples = MaxHeapTuplesPerPage;
+		nwords = LV_MIN_WORDS;
+		vacrelstats->max_dead_tuples = MaxHeapTuplesPerPage;
 	}
 
-	vacrelstats->num_dead_tuples = 0;
-	vacrelstats->max_dead_tuples = (int) maxtuples;
-	vacrelstats->dead_tuples = (ItemPointer)
-		palloc(maxtuples * sizeof(ItemPointerData));
+	size = add_size(offsetof(LVDeadTuples, data),
+					mul_size(sizeof(uint64), (Size) nwords));
+
+	/*
+	 * Parallel workers need to see the store.  If we can't get a DSM segment
+	 * for it, just vacuum the indexes serially.
+	 */
+	vacrelstats->dead_tuples = NULL;
+	if (vacrelstats->nworkers > 0)
+	{
+		vacrelstats->dead_tuples_seg =
+			dsm_create(size, DSM_CREATE_NULL_IF_MAXSEGMENTS);
+		if (vacrelstats->dead_tuples_seg != NULL)
+			vacrelstats->dead_tuples = (LVDeadTuples *)
+				dsm_segment_address(vacrelstats->dead_tuples_seg);
+		else
+			vacrelstats->nworkers = 0;
+	}
+
+	if (vacrelstats->dead_tuples == NULL)
+		vacrelstats->dead_tuples = (LVDeadTuples *)
+			MemoryContextAllocHuge(CurrentMemoryContext, size);
+
+	vacrelstats->dead_tuples->nwords = nwords;
+	lazy_reset_dead_tuples(vacrelstats->dead_tuples);
+}
+
+/*
+ * lazy_reset_dead_tuples - forget all the dead tuples in the store
+ */
+static void
+lazy_reset_dead_tuples(LVDeadTuples *dt)
+{
+	dt->num_tuples = 0;
+	dt->num_blocks = 0;
+	dt->num_bitmap_words = 0;
+	dt->dir_start = 0;
+	dt->dir_ngroups = 0;
+}
+
+/*
+ * lazy_dead_tuples_full - must we vacuum the indexes before block blkno?
+ *
+ * That's the case if the store might not hold all the dead tuples of the
+ * block, together with the directory that is needed once it's added.
+ */
+static bool
+lazy_dead_tuples_full(LVDeadTuples *dt, BlockNumber blkno)
+{
+	BlockNumber first_blkno;
+	uint64		ngroups;
+	uint64		freewords;
+
+	if (dt->num_blocks == 0)
+		return false;
+
+	first_blkno = LVDeadBlockAt(dt, 0)->blkno;
+	ngroups = blkno / LV_BLOCKS_PER_GROUP -
+		first_blkno / LV_BLOCKS_PER_GROUP + 1;
+	freewords = dt->nwords - dt->num_bitmap_words - dt->num_blocks;
+
+	return freewords < 1 + LV_MAX_PAGE_WORDS + LV_DIRECTORY_WORDS(ngroups);
 }
 
 /*
  * lazy_record_dead_tuple - remember one deletable tuple
+ *
+ * Tuples must be recorded in TID order.
  */
 static void
 lazy_record_dead_tuple(LVRelStats *vacrelstats,
 					   ItemPointer itemptr)
 {
+	LVDeadTuples *dt = vacrelstats->dead_tuples;
+	BlockNumber blkno = ItemPointerGetBlockNumber(itemptr);
+	int			bitno = ItemPointerGetOffsetNumber(itemptr) - 1;
+	LVDeadBlock *block;
+	uint32		wordno;
+
+	StaticAssertStmt(sizeof(LVDeadBlock) == sizeof(uint64),
+					 "LVDeadBlock must take one word of data[]");
+
 	/*
-	 * The array shouldn't overflow under normal behavior, but perhaps it
-	 * could if we are given a really small maintenance_work_mem. In that
-	 * case, just forget the last few tuples (we'll get 'em next time).
+	 * The store shouldn't overflow under normal behavior, since
+	 * lazy_dead_tuples_full leaves room for a full page, but perhaps it could
+	 * if we are given a really small maintenance_work_mem. In that case, just
+	 * forget the last few tuples (we'll get 'em next time).
 	 */
-	if (vacrelstats->num_dead_tuples < vacrelstats->max_dead_tuples)
+	if (dt->num_blocks > 0 &&
+		LVDeadBlockAt(dt, dt->num_blocks - 1)->blkno == blkno)
+		block = LVDeadBlockAt(dt, dt->num_blocks - 1);
+	else
 	{
-		vacrelstats->dead_tuples[vacrelstats->num_dead_tuples] = *itemptr;
-		vacrelstats->num_dead_tuples++;
-		pgstat_progress_update_param(PROGRESS_VACUUM_NUM_DEAD_TUPLES,
-									 vacrelstats->num_dead_tuples);
+		Assert(dt->num_blocks == 0 ||
+			   LVDeadBlockAt(dt, dt->num_blocks - 1)->blkno < blkno);
+
+		if (dt->num_bitmap_words + dt->num_blocks >= dt->nwords)
+			return;
+		block = LVDeadBlockAt(dt, dt->num_blocks);
+		block->blkno = blkno;
+		block->wordno = dt->num_bitmap_words;
+		dt->num_blocks++;
 	}
+
+	/* The bitmap of the last block can be extended as needed */
+	wordno = block->wordno + bitno / LV_BITS_PER_WORD;
+	while (dt->num_bitmap_words <= wordno)
+	{
+		if (dt->num_bitmap_words + dt->num_blocks >= dt->nwords)
+			return;
+		dt->data[dt->num_bitmap_words++] = 0;
+	}
+
+	dt->data[wordno] |= UINT64CONST(1) << (bitno % LV_BITS_PER_WORD);
+	dt->num_tuples++;
+	pgstat_progress_update_param(PROGRESS_VACUUM_NUM_DEAD_TUPLES,
+								 dt->num_tuples);
 }
 
 /*
- *	lazy_tid_reaped() -- is a particular tid deletable?
- *
- *		This has the right signature to be an IndexBulkDeleteCallback.
+ * lazy_build_dead_tuple_directory - set up the store for lookups
  *
- *		Assumes dead_tuples array is in sorted order.
+ * This must be called after the last tuple has been recorded and before the
+ * first call of lazy_tid_reaped.
  */
-static bool
-lazy_tid_reaped(ItemPointer itemptr, void *state)
+static void
+lazy_build_dead_tuple_directory(LVDeadTuples *dt)
 {
-	LVRelStats *vacrelstats = (LVRelStats *) state;
-	ItemPointer res;
+	BlockNumber first_blkno;
+	BlockNumber last_blkno;
+	uint64	   *dirbits;
+	uint32	   *dirbase;
+	uint32		i;
+
+	if (dt->num_blocks == 0)
+	{
+		dt->dir_ngroups = 0;
+		return;
+	}
+
+	first_blkno = LVDeadBlockAt(dt, 0)->blkno;
+	last_blkno = LVDeadBlockAt(dt, dt->num_blocks - 1)->blkno;
+	dt->dir_start = first_blkno - first_blkno % LV_BLOCKS_PER_GROUP;
+	dt->dir_ngroups = last_blkno / LV_BLOCKS_PER_GROUP -
+		first_blkno / LV_BLOCKS_PER_GROUP + 1;
+	Assert(dt->num_bitmap_words + LV_DIRECTORY_WORDS(dt->dir_ngroups) +
+		   dt->num_blocks <= dt->nwords);
+
+	dirbits = &dt->data[dt->num_bitmap_words];
+	dirbase = (uint32 *) &dt->data[dt->num_bitmap_words + dt->dir_ngroups];
+	memset(dirbits, 0, dt->dir_ngroups * sizeof(uint64));
 
-	res = (ItemPointer) bsearch((void *) itemptr,
-								(void *) vacrelstats->dead_tuples,
-								vacrelstats->num_dead_tuples,
-								sizeof(ItemPointerData),
-								vac_cmp_itemptr);
+	for (i = 0; i < dt->num_blocks; i++)
+	{
+		BlockNumber blkno = LVDeadBlockAt(dt, i)->blkno;
+		uint32		group = (blkno - dt->dir_start) / LV_BLOCKS_PER_GROUP;
 
-	return (res != NULL);
+		if (dirbits[group] == 0)
+			dirbase[group] = i;
+		dirbits[group] |= UINT64CONST(1) << (blkno % LV_BLOCKS_PER_GROUP);
+	}
 }
 
 /*
- * Comparator routines for use with qsort() and bsearch().
+ * Number of one bits in a word.
  */
-static int
-vac_cmp_itemptr(const void *left, const void *right)
+static inline int
+vac_popcount64(uint64 word)
 {
-	BlockNumber lblk,
-				rblk;
-	OffsetNumber loff,
-				roff;
+	word -= (word >> 1) & UINT64CONST(0x5555555555555555);
+	word = (word & UINT64CONST(0x3333333333333333)) +
+		((word >> 2) & UINT64CONST(0x3333333333333333));
+	word = (word + (word >> 4)) & UINT64CONST(0x0F0F0F0F0F0F0F0F);
+	return (int) ((word * UINT64CONST(0x0101010101010101)) >> 56);
+}
 
-	lblk = ItemPointerGetBlockNumber((ItemPointer) left);
-	rblk = ItemPointerGetBlockNumber((ItemPointer) right);
+/*
+ *	lazy_tid_reaped() -- is a particular tid deletable?
+ *
+ *		This has the right signature to be an IndexBulkDeleteCallback.
+ *
+ *		Assumes lazy_build_dead_tuple_directory has been called.
+ */
+static bool
+lazy_tid_reaped(ItemPointer itemptr, void *state)
+{
+	LVRelStats *vacrelstats = (LVRelStats *) state;
+	LVDeadTuples *dt = vacrelstats->dead_tuples;
+	BlockNumber blkno = ItemPointerGetBlockNumber(itemptr);
+	int			bitno = ItemPointerGetOffsetNumber(itemptr) - 1;
+	uint32		group;
+	uint64		groupbits;
+	uint64		blockbit;
+	uint32	   *dirbase;
+	uint32		blockidx;
+	uint32		wordno;
+	uint32		endword;
+
+	if (blkno < dt->dir_start)
+		return false;
+	group = (blkno - dt->dir_start) / LV_BLOCKS_PER_GROUP;
+	if (group >= dt->dir_ngroups)
+		return false;
 
-	if (lblk < rblk)
-		return -1;
-	if (lblk > rblk)
-		return 1;
+	/* Does the block have any dead tuples? */
+	groupbits = dt->data[dt->num_bitmap_words + group];
+	blockbit = UINT64CONST(1) << (blkno % LV_BLOCKS_PER_GROUP);
+	if ((groupbits & blockbit) == 0)
+		return false;
 
-	loff = ItemPointerGetOffsetNumber((ItemPointer) left);
-	roff = ItemPointerGetOffsetNumber((ItemPointer) right);
+	/* Its entry comes after those of the blocks before it in the group */
+	dirbase = (uint32 *) &dt->data[dt->num_bitmap_words + dt->dir_ngroups];
+	blockidx = dirbase[group] + vac_popcount64(groupbits & (blockbit - 1));
 
-	if (loff < roff)
-		return -1;
-	if (loff > roff)
-		return 1;
+	wordno = LVDeadBlockAt(dt, blockidx)->wordno + bitno / LV_BITS_PER_WORD;
+	endword = (blockidx + 1 < dt->num_blocks) ?
+		LVDeadBlockAt(dt, blockidx + 1)->wordno : dt->num_bitmap_words;
+	if (wordno >= endword)
+		return false;
 
-	return 0;
+	return (dt->data[wordno] &
+			(UINT64CONST(1) << (bitno % LV_BITS_PER_WORD))) != 0;
 }
 
 /*
@@ -43,8 +43,10 @@
 #include "optimizer/clauses.h"
 #include "optimizer/planner.h"
 #include "pgstat.h"
+#include "utils/array.h"
 #include "utils/builtins.h"
 #include "utils/datum.h"
+#include "utils/fmgroids.h"
 #include "utils/lsyscache.h"
 #include "utils/typcache.h"
 
@@ -56,12 +58,20 @@ typedef struct LastAttnumInfo
 	AttrNumber	last_scan;
 } LastAttnumInfo;
 
+/*
+ * Minimum number of elements a constant array must have before "= ANY" is
+ * evaluated through a hash table rather than by a linear search.
+ */
+#define MIN_ARRAY_SIZE_FOR_HASHED_SAOP 9
+
 static void ExecReadyExpr(ExprState *state);
 static void ExecInitExprRec(Expr *node, ExprState *state,
 				Datum *resv, bool *resnull);
 static void ExecInitFunc(ExprEvalStep *scratch, Expr *node, List *args,
 			 Oid funcid, Oid inputcollid,
 			 ExprState *state);
+static bool ExecSaopUseHashing(ExprState *state, ScalarArrayOpExpr *opexpr,
+				   FmgrInfo *finfo, Oid *hashfuncid);
 static void ExecInitExprSlots(ExprState *state, Node *node);
 static void ExecPushExprSlots(ExprState *state, LastAttnumInfo *info);
 static bool get_last_attnums_walker(Node *node, LastAttnumInfo *info);
@@ -78,7 +88,8 @@ static void ExecInitCoerceToDomain(ExprEvalStep *scratch, CoerceToDomain *ctest,
 static void ExecBuildAggTransCall(ExprState *state, AggState *aggstate,
 					  ExprEvalStep *scratch,
 					  FunctionCallInfo fcinfo, AggStatePerTrans pertrans,
-					  int transno, int setno, int setoff, bool ishash);
+					  int transno, int setno, int setoff, bool ishash,
+					  bool nullcheck);
 
 
 /*
@@ -950,6 +961,7 @@ ExecInitExprRec(Expr *node, ExprState *state,
 				FmgrInfo   *finfo;
 				FunctionCallInfo fcinfo;
 				AclResult	aclresult;
+				Oid			hashfuncid;
 
 				Assert(list_length(opexpr->args) == 2);
 				scalararg = (Expr *) linitial(opexpr->args);
@@ -985,12 +997,38 @@ ExecInitExprRec(Expr *node, ExprState *state,
 				ExecInitExprRec(arrayarg, state, resv, resnull);
 
 				/* And perform the operation */
-				scratch.opcode = EEOP_SCALARARRAYOP;
-				scratch.d.scalararrayop.element_type = InvalidOid;
-				scratch.d.scalararrayop.useOr = opexpr->useOr;
-				scratch.d.scalararrayop.finfo = finfo;
-				scratch.d.scalararrayop.fcinfo_data = fcinfo;
-				scratch.d.scalararrayop.fn_addr = finfo->fn_addr;
+				if (ExecSaopUseHashing(state, opexpr, finfo, &hashfuncid))
+				{
+					FmgrInfo   *hash_finfo;
+					FunctionCallInfo hash_fcinfo;
+
+					/* Set up the hash function lookup information */
+					hash_finfo = palloc0(sizeof(FmgrInfo));
+					hash_fcinfo = palloc0(sizeof(FunctionCallInfoData));
+					fmgr_info(hashfuncid, hash_finfo);
+					fmgr_info_set_expr((Node *) node, hash_finfo);
+					InitFunctionCallInfoData(*hash_fcinfo, hash_finfo, 1,
+											 opexpr->inputcollid, NULL, NULL);
+
+					scratch.opcode = EEOP_HASHED_SCALARARRAYOP;
+					scratch.d.hashedscalararrayop.has_nulls = false;
+					scratch.d.hashedscalararrayop.elements_tab = NULL;
+					scratch.d.hashedscalararrayop.finfo = finfo;
+					scratch.d.hashedscalararrayop.fcinfo_data = fcinfo;
+					scratch.d.hashedscalararrayop.fn_addr = finfo->fn_addr;
+					scratch.d.hashedscalararrayop.hash_finfo = hash_finfo;
+					scratch.d.hashedscalararrayop.hash_fcinfo_data = hash_fcinfo;
+					scratch.d.hashedscalararrayop.hash_fn_addr = hash_finfo->fn_addr;
+				}
+				else
+				{
+					scratch.opcode = EEOP_SCALARARRAYOP;
+					scratch.d.scalararrayop.element_type = InvalidOid;
+					scratch.d.scalararrayop.useOr = opexpr->useOr;
+					scratch.d.scalararrayop.finfo = finfo;
+					scratch.d.scalararrayop.fcinfo_data = fcinfo;
+					scratch.d.scalararrayop.fn_addr = finfo->fn_addr;
+				}
 				ExprEvalPushStep(state, &scratch);
 				break;
 			}
@@ -2244,6 +2282,52 @@ ExecInitFunc(ExprEvalStep *scratch, Expr *node, List *args, Oid funcid,
 			scratch->opcode = EEOP_FUNCEXPR_STRICT;
 		else
 			scratch->opcode = EEOP_FUNCEXPR;
+
+		/*
+		 * Comparisons of some common builtin types are evaluated inline by
+		 * the interpreter, saving the function call.
+		 */
+		switch (funcid)
+		{
+			case F_INT4EQ:
+				scratch->opcode = EEOP_FUNCEXPR_STRICT_INT4EQ;
+				break;
+			case F_INT4NE:
+				scratch->opcode = EEOP_FUNCEXPR_STRICT_INT4NE;
+				break;
+			case F_INT4LT:
+				scratch->opcode = EEOP_FUNCEXPR_STRICT_INT4LT;
+				break;
+			case F_INT4LE:
+				scratch->opcode = EEOP_FUNCEXPR_STRICT_INT4LE;
+				break;
+			case F_INT4GT:
+				scratch->opcode = EEOP_FUNCEXPR_STRICT_INT4GT;
+				break;
+			case F_INT4GE:
+				scratch->opcode = EEOP_FUNCEXPR_STRICT_INT4GE;
+				break;
+			case F_INT8EQ:
+				scratch->opcode = EEOP_FUNCEXPR_STRICT_INT8EQ;
+				break;
+			case F_INT8NE:
+				scratch->opcode = EEOP_FUNCEXPR_STRICT_INT8NE;
+				break;
+			case F_INT8LT:
+				scratch->opcode = EEOP_FUNCEXPR_STRICT_INT8LT;
+				break;
+			case F_INT8LE:
+				scratch->opcode = EEOP_FUNCEXPR_STRICT_INT8LE;
+				break;
+			case F_INT8GT:
+				scratch->opcode = EEOP_FUNCEXPR_STRICT_INT8GT;
+				break;
+			case F_INT8GE:
+				scratch->opcode = EEOP_FUNCEXPR_STRICT_INT8GE;
+				break;
+			default:
+				break;
+		}
 	}
 	else
 	{
@@ -2254,6 +2338,72 @@ ExecInitFunc(ExprEvalStep *scratch, Expr *node, List *args, Oid funcid,
 	}
 }
 
+/*
+ * Decide whether a ScalarArrayOpExpr can be evaluated by probing a hash table
+ * built from the array's elements, rather than by comparing the scalar with
+ * each element in turn.  If so, return true and set *hashfuncid to the hash
+ * function to use for both the elements and the scalar.
+ *
+ * The hash table is built once per ExprState, so the array must not change
+ * while the ExprState is in use.  That holds for a Const, and for an external
+ * Param of a plan being executed by the executor proper; it does not hold for
+ * expressions compiled with ext_params (e.g. PL/pgSQL simple expressions),
+ * which are re-evaluated with different parameter values.  Only "= ANY"
+ * style operators qualify: the operator must be strict, and must use the
+ * same hash function for both of its inputs.
+ */
+static bool
+ExecSaopUseHashing(ExprState *state, ScalarArrayOpExpr *opexpr,
+				   FmgrInfo *finfo, Oid *hashfuncid)
+{
+	Expr	   *arrayarg = (Expr *) lsecond(opexpr->args);
+	Oid			lefthashfunc;
+	Oid			righthashfunc;
+
+	if (!opexpr->useOr || !finfo->fn_strict)
+		return false;
+
+	if (IsA(arrayarg, Const))
+	{
+		Const	   *arrayconst = (Const *) arrayarg;
+		ArrayType  *arr;
+
+		/* A NULL array yields NULL anyway, so don't bother */
+		if (arrayconst->constisnull)
+			return false;
+
+		/* Small arrays are as fast to search linearly */
+		arr = DatumGetArrayTypeP(arrayconst->constvalue);
+		if (ArrayGetNItems(ARR_NDIM(arr), ARR_DIMS(arr)) <
+			MIN_ARRAY_SIZE_FOR_HASHED_SAOP)
+			return false;
+	}
+	else if (IsA(arrayarg, Param))
+	{
+		Param	   *param = (Param *) arrayarg;
+		ParamListInfo params;
+
+		if (param->paramkind != PARAM_EXTERN || state->ext_params != NULL)
+			return false;
+
+		/* Must be evaluated as a plain EEOP_PARAM_EXTERN step */
+		if (state->parent == NULL || state->parent->state == NULL)
+			return false;
+		params = state->parent->state->es_param_list_info;
+		if (params && params->paramCompile)
+			return false;
+	}
+	else
+		return false;
+
+	if (!get_op_hash_functions(opexpr->opno, &lefthashfunc, &righthashfunc) ||
+		lefthashfunc != righthashfunc)
+		return false;
+
+	*hashfuncid = lefthashfunc;
+	return true;
+}
+
 /*
  * Add expression steps deforming the ExprState's inner/outer/scan slots
  * as much as required by the expression.
@@ -2913,10 +3063,15 @@ ExecInitCoerceToDomain(ExprEvalStep *scratch, CoerceToDomain *ctest,
  * check for filters, evaluate aggregate input, check that that input is not
  * NULL for a strict transition function, and then finally invoke the
  * transition for each of the concurrently computed grouping sets.
+ *
+ * If nullcheck is true, the hash based transitions of a grouping set are
+ * skipped when its per-group state pointer is NULL; nodeAgg.c uses that for
+ * input tuples that it has spilled to disk rather than entered into the
+ * hash table.
  */
 ExprState *
 ExecBuildAggTrans(AggState *aggstate, AggStatePerPhase phase,
-				  bool doSort, bool doHash)
+				  bool doSort, bool doHash, bool nullcheck)
 {
 	ExprState  *state = makeNode(ExprState);
 	PlanState  *parent = &aggstate->ss.ps;
@@ -3144,7 +3299,8 @@ ExecBuildAggTrans(AggState *aggstate, AggStatePerPhase phase,
 			for (setno = 0; setno < processGroupingSets; setno++)
 			{
 				ExecBuildAggTransCall(state, aggstate, &scratch, trans_fcinfo,
-									  pertrans, transno, setno, setoff, false);
+									  pertrans, transno, setno, setoff, false,
+									  false);
 				setoff++;
 			}
 		}
@@ -3162,7 +3318,8 @@ ExecBuildAggTrans(AggState *aggstate, AggStatePerPhase phase,
 			for (setno = 0; setno < numHashes; setno++)
 			{
 				ExecBuildAggTransCall(state, aggstate, &scratch, trans_fcinfo,
-									  pertrans, transno, setno, setoff, true);
+									  pertrans, transno, setno, setoff, true,
+									  nullcheck);
 				setoff++;
 			}
 		}
@@ -3209,10 +3366,12 @@ static void
 ExecBuildAggTransCall(ExprState *state, AggState *aggstate,
 					  ExprEvalStep *scratch,
 					  FunctionCallInfo fcinfo, AggStatePerTrans pertrans,
-					  int transno, int setno, int setoff, bool ishash)
+					  int transno, int setno, int setoff, bool ishash,
+					  bool nullcheck)
 {
 	int			adjust_init_jumpnull = -1;
 	int			adjust_strict_jumpnull = -1;
+	int			adjust_pergroup_jumpnull = -1;
 	ExprContext *aggcontext;
 
 	if (ishash)
@@ -3220,6 +3379,18 @@ ExecBuildAggTransCall(ExprState *state, AggState *aggstate,
 	else
 		aggcontext = aggstate->aggcontexts[setno];
 
+	/* skip the whole transition if there's no per-group state to update */
+	if (nullcheck)
+	{
+		scratch->opcode = EEOP_AGG_PLAIN_PERGROUP_NULLCHECK;
+		scratch->d.agg_plain_pergroup_nullcheck.aggstate = aggstate;
+		scratch->d.agg_plain_pergroup_nullcheck.setoff = setoff;
+		scratch->d.agg_plain_pergroup_nullcheck.jumpnull = -1;	/* adjust later */
+		ExprEvalPushStep(state, scratch);
+
+		adjust_pergroup_jumpnull = state->steps_len - 1;
+	}
+
 	/*
 	 * If the initial value for the transition state doesn't exist in the
 	 * pg_aggregate table then we will let the first non-NULL value returned
@@ -3297,6 +3468,13 @@ ExecBuildAggTransCall(ExprState *state, AggState *aggstate,
 		Assert(as->d.agg_strict_trans_check.jumpnull == -1);
 		as->d.agg_strict_trans_check.jumpnull = state->steps_len;
 	}
+	if (adjust_pergroup_jumpnull != -1)
+	{
+		ExprEvalStep *as = &state->steps[adjust_pergroup_jumpnull];
+
+		Assert(as->d.agg_plain_pergroup_nullcheck.jumpnull == -1);
+		as->d.agg_plain_pergroup_nullcheck.jumpnull = state->steps_len;
+	}
 }
 
 /*
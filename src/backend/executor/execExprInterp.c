@@ -137,6 +137,60 @@ static ExprEvalOpLookup reverse_dispatch_table[EEOP_LAST];
 		EEO_DISPATCH(); \
 	} while (0)
 
+/*
+ * Evaluate a strict two-argument comparison inline, for the
+ * EEOP_FUNCEXPR_STRICT_<type><cmp> opcodes.  The arguments have been
+ * evaluated into the step's fcinfo, as for EEOP_FUNCEXPR_STRICT.
+ */
+#define EEO_STRICT_CMP(getter, cmpop) \
+	do { \
+		FunctionCallInfo fcinfo_ = op->d.func.fcinfo_data; \
+		if (fcinfo_->argnull[0] || fcinfo_->argnull[1]) \
+			*op->resnull = true; \
+		else \
+		{ \
+			*op->resvalue = BoolGetDatum(getter(fcinfo_->arg[0]) cmpop \
+										 getter(fcinfo_->arg[1])); \
+			*op->resnull = false; \
+		} \
+	} while (0)
+
+
+/*
+ * Hash table used by EEOP_HASHED_SCALARARRAYOP to look up the scalar among
+ * the array's elements.  Only the non-NULL elements are stored.
+ */
+typedef struct ScalarArrayOpExprHashEntry
+{
+	Datum		key;
+	uint32		status;			/* hash status */
+	uint32		hash;			/* hash value (cached) */
+} ScalarArrayOpExprHashEntry;
+
+struct saophash_hash;
+static uint32 saop_element_hash(struct saophash_hash *tb, Datum key);
+static bool saop_hash_element_match(struct saophash_hash *tb, Datum key1,
+						Datum key2);
+
+#define SH_PREFIX saophash
+#define SH_ELEMENT_TYPE ScalarArrayOpExprHashEntry
+#define SH_KEY_TYPE Datum
+#define SH_KEY key
+#define SH_HASH_KEY(tb, key) saop_element_hash(tb, key)
+#define SH_EQUAL(tb, a, b) saop_hash_element_match(tb, a, b)
+#define SH_SCOPE static inline
+#define SH_STORE_HASH
+#define SH_GET_HASH(tb, a) a->hash
+#define SH_DEFINE
+#define SH_DECLARE
+#include "lib/simplehash.h"
+
+typedef struct ScalarArrayOpExprHashTable
+{
+	saophash_hash *hashtab;		/* underlying hash table */
+	struct ExprEvalStep *op;	/* step owning the table */
+} ScalarArrayOpExprHashTable;
+
 
 static Datum ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull);
 static void ExecInitInterpreter(void);
@@ -247,7 +301,9 @@ ExecReadyInterpretedExpr(ExprState *state)
 			return;
 		}
 		else if (step0 == EEOP_CASE_TESTVAL &&
-				 step1 == EEOP_FUNCEXPR_STRICT &&
+				 (step1 == EEOP_FUNCEXPR_STRICT ||
+				  (step1 >= EEOP_FUNCEXPR_STRICT_INT4EQ &&
+				   step1 <= EEOP_FUNCEXPR_STRICT_INT8GE)) &&
 				 state->steps[0].d.casetest.value)
 		{
 			state->evalfunc_private = (void *) ExecJustApplyFuncToCase;
@@ -329,6 +385,18 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 		&&CASE_EEOP_FUNCEXPR_STRICT,
 		&&CASE_EEOP_FUNCEXPR_FUSAGE,
 		&&CASE_EEOP_FUNCEXPR_STRICT_FUSAGE,
+		&&CASE_EEOP_FUNCEXPR_STRICT_INT4EQ,
+		&&CASE_EEOP_FUNCEXPR_STRICT_INT4NE,
+		&&CASE_EEOP_FUNCEXPR_STRICT_INT4LT,
+		&&CASE_EEOP_FUNCEXPR_STRICT_INT4LE,
+		&&CASE_EEOP_FUNCEXPR_STRICT_INT4GT,
+		&&CASE_EEOP_FUNCEXPR_STRICT_INT4GE,
+		&&CASE_EEOP_FUNCEXPR_STRICT_INT8EQ,
+		&&CASE_EEOP_FUNCEXPR_STRICT_INT8NE,
+		&&CASE_EEOP_FUNCEXPR_STRICT_INT8LT,
+		&&CASE_EEOP_FUNCEXPR_STRICT_INT8LE,
+		&&CASE_EEOP_FUNCEXPR_STRICT_INT8GT,
+		&&CASE_EEOP_FUNCEXPR_STRICT_INT8GE,
 		&&CASE_EEOP_BOOL_AND_STEP_FIRST,
 		&&CASE_EEOP_BOOL_AND_STEP,
 		&&CASE_EEOP_BOOL_AND_STEP_LAST,
@@ -379,6 +447,7 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 		&&CASE_EEOP_DOMAIN_CHECK,
 		&&CASE_EEOP_CONVERT_ROWTYPE,
 		&&CASE_EEOP_SCALARARRAYOP,
+		&&CASE_EEOP_HASHED_SCALARARRAYOP,
 		&&CASE_EEOP_XMLEXPR,
 		&&CASE_EEOP_AGGREF,
 		&&CASE_EEOP_GROUPING_FUNC,
@@ -388,6 +457,7 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 		&&CASE_EEOP_AGG_STRICT_DESERIALIZE,
 		&&CASE_EEOP_AGG_DESERIALIZE,
 		&&CASE_EEOP_AGG_STRICT_INPUT_CHECK,
+		&&CASE_EEOP_AGG_PLAIN_PERGROUP_NULLCHECK,
 		&&CASE_EEOP_AGG_INIT_TRANS,
 		&&CASE_EEOP_AGG_STRICT_TRANS_CHECK,
 		&&CASE_EEOP_AGG_PLAIN_TRANS_BYVAL,
@@ -653,6 +723,95 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 			EEO_NEXT();
 		}
 
+		/*
+		 * Strict comparisons of common builtin types.  These do exactly what
+		 * the corresponding functions (int4eq() and so on) would do, but
+		 * without the call through fmgr.
+		 */
+		EEO_CASE(EEOP_FUNCEXPR_STRICT_INT4EQ)
+		{
+			EEO_STRICT_CMP(DatumGetInt32, ==);
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_FUNCEXPR_STRICT_INT4NE)
+		{
+			EEO_STRICT_CMP(DatumGetInt32, !=);
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_FUNCEXPR_STRICT_INT4LT)
+		{
+			EEO_STRICT_CMP(DatumGetInt32, <);
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_FUNCEXPR_STRICT_INT4LE)
+		{
+			EEO_STRICT_CMP(DatumGetInt32, <=);
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_FUNCEXPR_STRICT_INT4GT)
+		{
+			EEO_STRICT_CMP(DatumGetInt32, >);
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_FUNCEXPR_STRICT_INT4GE)
+		{
+			EEO_STRICT_CMP(DatumGetInt32, >=);
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_FUNCEXPR_STRICT_INT8EQ)
+		{
+			EEO_STRICT_CMP(DatumGetInt64, ==);
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_FUNCEXPR_STRICT_INT8NE)
+		{
+			EEO_STRICT_CMP(DatumGetInt64, !=);
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_FUNCEXPR_STRICT_INT8LT)
+		{
+			EEO_STRICT_CMP(DatumGetInt64, <);
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_FUNCEXPR_STRICT_INT8LE)
+		{
+			EEO_STRICT_CMP(DatumGetInt64, <=);
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_FUNCEXPR_STRICT_INT8GT)
+		{
+			EEO_STRICT_CMP(DatumGetInt64, >);
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_FUNCEXPR_STRICT_INT8GE)
+		{
+			EEO_STRICT_CMP(DatumGetInt64, >=);
+
+			EEO_NEXT();
+		}
+
 		EEO_CASE(EEOP_FUNCEXPR_FUSAGE)
 		{
 			/* not common enough to inline */
@@ -1414,6 +1573,14 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 			EEO_NEXT();
 		}
 
+		EEO_CASE(EEOP_HASHED_SCALARARRAYOP)
+		{
+			/* too complex for an inline implementation */
+			ExecEvalHashedScalarArrayOp(state, op, econtext);
+
+			EEO_NEXT();
+		}
+
 		EEO_CASE(EEOP_DOMAIN_NOTNULL)
 		{
 			/* too complex for an inline implementation */
@@ -1543,6 +1710,21 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 			EEO_NEXT();
 		}
 
+		/*
+		 * Check for a NULL pointer to the per-group states of a grouping set,
+		 * which means that the input tuple doesn't take part in that set.
+		 */
+		EEO_CASE(EEOP_AGG_PLAIN_PERGROUP_NULLCHECK)
+		{
+			AggState   *aggstate = op->d.agg_plain_pergroup_nullcheck.aggstate;
+			int			setoff = op->d.agg_plain_pergroup_nullcheck.setoff;
+
+			if (aggstate->all_pergroups[setoff] == NULL)
+				EEO_JUMP(op->d.agg_plain_pergroup_nullcheck.jumpnull);
+
+			EEO_NEXT();
+		}
+
 		/*
 		 * Initialize an aggregate's first value if necessary.
 		 */
@@ -3478,6 +3660,187 @@ ExecEvalScalarArrayOp(ExprState *state, ExprEvalStep *op)
 	*op->resnull = resultnull;
 }
 
+/*
+ * Hash function for scalar array hash op elements.
+ *
+ * We use the element type's default hash opclass, and the column collation
+ * if the type is collation-sensitive.
+ */
+static uint32
+saop_element_hash(struct saophash_hash *tb, Datum key)
+{
+	ScalarArrayOpExprHashTable *elements_tab = (ScalarArrayOpExprHashTable *) tb->private_data;
+	FunctionCallInfo fcinfo = elements_tab->op->d.hashedscalararrayop.hash_fcinfo_data;
+	Datum		hash;
+
+	fcinfo->arg[0] = key;
+	fcinfo->argnull[0] = false;
+	fcinfo->isnull = false;
+
+	hash = elements_tab->op->d.hashedscalararrayop.hash_fn_addr(fcinfo);
+
+	return DatumGetUInt32(hash);
+}
+
+/*
+ * Matching function for scalar array hash op elements, to be used in hashtable
+ * lookups.
+ */
+static bool
+saop_hash_element_match(struct saophash_hash *tb, Datum key1, Datum key2)
+{
+	ScalarArrayOpExprHashTable *elements_tab = (ScalarArrayOpExprHashTable *) tb->private_data;
+	FunctionCallInfo fcinfo = elements_tab->op->d.hashedscalararrayop.fcinfo_data;
+	Datum		result;
+
+	fcinfo->arg[0] = key1;
+	fcinfo->argnull[0] = false;
+	fcinfo->arg[1] = key2;
+	fcinfo->argnull[1] = false;
+	fcinfo->isnull = false;
+
+	result = elements_tab->op->d.hashedscalararrayop.fn_addr(fcinfo);
+
+	return !fcinfo->isnull && DatumGetBool(result);
+}
+
+/*
+ * Evaluate "scalar op ANY (array)" using a hash table of the array elements.
+ *
+ * Source array is in our result area, scalar arg is already evaluated into
+ * fcinfo->arg[0]/argnull[0], exactly as for EEOP_SCALARARRAYOP.
+ *
+ * ExecInitExprRec only emits this step when the array is known not to change
+ * for the lifetime of the ExprState (a Const, or an external Param of a plan
+ * being executed), so the hash table is built on the first call and reused
+ * for all subsequent rows.  The operator is strict and has the same hash
+ * function on both sides, which makes a hash probe equivalent to comparing
+ * the scalar against every element in turn.
+ */
+void
+ExecEvalHashedScalarArrayOp(ExprState *state, ExprEvalStep *op,
+							ExprContext *econtext)
+{
+	ScalarArrayOpExprHashTable *elements_tab = op->d.hashedscalararrayop.elements_tab;
+	FunctionCallInfo fcinfo = op->d.hashedscalararrayop.fcinfo_data;
+	Datum		scalar = fcinfo->arg[0];
+	bool		scalar_isnull = fcinfo->argnull[0];
+	bool		hashfound;
+
+	/* If the array is NULL then we return NULL, as ExecEvalScalarArrayOp */
+	if (*op->resnull)
+		return;
+
+	/* Build the hash table on first evaluation */
+	if (elements_tab == NULL)
+	{
+		MemoryContext oldcontext;
+		ArrayType  *arr;
+		int			nitems;
+		int16		typlen;
+		bool		typbyval;
+		char		typalign;
+		char	   *s;
+		bits8	   *bitmap;
+		int			bitmask;
+		int			i;
+
+		/*
+		 * The table and the (possibly detoasted) array it points into must
+		 * survive as long as the ExprState does, so build both in the
+		 * per-query context.
+		 */
+		oldcontext = MemoryContextSwitchTo(econtext->ecxt_per_query_memory);
+
+		arr = DatumGetArrayTypeP(*op->resvalue);
+		nitems = ArrayGetNItems(ARR_NDIM(arr), ARR_DIMS(arr));
+
+		get_typlenbyvalalign(ARR_ELEMTYPE(arr),
+							 &typlen,
+							 &typbyval,
+							 &typalign);
+
+		elements_tab = (ScalarArrayOpExprHashTable *)
+			palloc(sizeof(ScalarArrayOpExprHashTable));
+		op->d.hashedscalararrayop.elements_tab = elements_tab;
+		elements_tab->op = op;
+
+		elements_tab->hashtab = saophash_create(CurrentMemoryContext,
+												Max(nitems, 1),
+												elements_tab);
+
+		MemoryContextSwitchTo(oldcontext);
+
+		s = (char *) ARR_DATA_PTR(arr);
+		bitmap = ARR_NULLBITMAP(arr);
+		bitmask = 1;
+		for (i = 0; i < nitems; i++)
+		{
+			/* NULL elements aren't stored, but do affect the result */
+			if (bitmap && (*bitmap & bitmask) == 0)
+				op->d.hashedscalararrayop.has_nulls = true;
+			else
+			{
+				Datum		element;
+
+				element = fetch_att(s, typbyval, typlen);
+				s = att_addlength_pointer(s, typlen, s);
+				s = (char *) att_align_nominal(s, typalign);
+
+				saophash_insert(elements_tab->hashtab, element, &hashfound);
+			}
+
+			/* advance bitmap pointer if any */
+			if (bitmap)
+			{
+				bitmask <<= 1;
+				if (bitmask == 0x100)
+				{
+					bitmap++;
+					bitmask = 1;
+				}
+			}
+		}
+	}
+
+	/*
+	 * An empty array yields FALSE, even if the scalar is NULL, as in
+	 * ExecEvalScalarArrayOp.
+	 */
+	if (elements_tab->hashtab->members == 0 &&
+		!op->d.hashedscalararrayop.has_nulls)
+	{
+		*op->resvalue = BoolGetDatum(false);
+		*op->resnull = false;
+		return;
+	}
+
+	/* The operator is strict, so a NULL scalar yields NULL */
+	if (scalar_isnull)
+	{
+		*op->resvalue = (Datum) 0;
+		*op->resnull = true;
+		return;
+	}
+
+	hashfound = (saophash_lookup(elements_tab->hashtab, scalar) != NULL);
+
+	/*
+	 * If we didn't find a match but the array contained NULLs, the result of
+	 * the ANY per SQL semantics is NULL rather than FALSE.
+	 */
+	if (!hashfound && op->d.hashedscalararrayop.has_nulls)
+	{
+		*op->resvalue = (Datum) 0;
+		*op->resnull = true;
+	}
+	else
+	{
+		*op->resvalue = BoolGetDatum(hashfound);
+		*op->resnull = false;
+	}
+}
+
 /*
  * Evaluate a NOT NULL domain constraint.
  */
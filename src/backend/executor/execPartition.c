@@ -18,6 +18,7 @@
 #include "catalog/pg_type.h"
 #include "executor/execPartition.h"
 #include "executor/executor.h"
+#include "executor/nodeModifyTable.h"
 #include "foreign/fdwapi.h"
 #include "mb/pg_wchar.h"
 #include "miscadmin.h"
@@ -131,6 +132,16 @@ struct PartitionTupleRouting
  *		the index corresponds to the PartitionDispatch for it in its
  *		partition_dispatch_info array.  -1 indicates we've not yet allocated
  *		anything in PartitionTupleRouting for the partition.
+ *
+ * last_bound_offset
+ *		For LIST and RANGE partitioning, the offset into boundinfo->datums of
+ *		the bound that routed the most recent tuple, or -1 if that tuple went
+ *		to the NULL or the default partition.
+ *
+ * last_bound_hits
+ *		The number of consecutive tuples routed through last_bound_offset.
+ *		Once this reaches PARTITION_CACHED_FIND_THRESHOLD, the bound is
+ *		checked before falling back to a binary search.
  *-----------------------
  */
 typedef struct PartitionDispatchData
@@ -141,9 +152,20 @@ typedef struct PartitionDispatchData
 	PartitionDesc partdesc;
 	TupleTableSlot *tupslot;
 	AttrNumber *tupmap;
+	int			last_bound_offset;
+	int			last_bound_hits;
 	int			indexes[FLEXIBLE_ARRAY_MEMBER];
 } PartitionDispatchData;
 
+/*
+ * Number of consecutive tuples that must be routed through the same bound of
+ * a LIST or RANGE partitioned table before get_partition_for_tuple() starts
+ * checking that bound first.  Data loaded in (roughly) partition key order
+ * then needs one or two comparisons per tuple instead of a binary search,
+ * while randomly ordered data pays nothing extra.
+ */
+#define PARTITION_CACHED_FIND_THRESHOLD	16
+
 /* struct to hold result relations coming from UPDATE subplans */
 typedef struct SubplanResultRelHashElem
 {
@@ -928,6 +950,10 @@ ExecInitRoutingInfo(ModifyTableState *mtstate,
 		partRelInfo->ri_FdwRoutine->BeginForeignInsert != NULL)
 		partRelInfo->ri_FdwRoutine->BeginForeignInsert(mtstate, partRelInfo);
 
+	/* Find out whether rows routed to a foreign partition can be batched */
+	if (mtstate && partRelInfo->ri_FdwRoutine != NULL)
+		partRelInfo->ri_BatchSize = ExecForeignBatchSize(mtstate, partRelInfo);
+
 	partRelInfo->ri_PartitionInfo = partrouteinfo;
 
 	/*
@@ -1025,6 +1051,9 @@ ExecInitPartitionDispatchInfo(PartitionTupleRouting *proute, Oid partoid,
 	 */
 	memset(pd->indexes, -1, sizeof(int) * partdesc->nparts);
 
+	pd->last_bound_offset = -1;
+	pd->last_bound_hits = 0;
+
 	/* Track in PartitionTupleRouting for later use */
 	dispatchidx = proute->num_dispatch++;
 
@@ -1196,12 +1225,17 @@ FormPartitionKeyDatum(PartitionDispatch pd,
  *
  * Return value is index of the partition (>= 0 and < partdesc->nparts) if one
  * found or -1 if none found.
+ *
+ * Consecutive tuples often go to the same partition, so for LIST and RANGE
+ * partitioning we keep track of the bound that routed the previous tuples,
+ * and once it has been used often enough, check it before searching.
  */
 static int
 get_partition_for_tuple(PartitionDispatch pd, Datum *values, bool *isnull)
 {
 	int			bound_offset;
 	int			part_index = -1;
+	int			cache_offset = -2;	/* -2 means nothing to cache */
 	PartitionKey key = pd->key;
 	PartitionDesc partdesc = pd->partdesc;
 	PartitionBoundInfo boundinfo = partdesc->boundinfo;
@@ -1233,12 +1267,26 @@ get_partition_for_tuple(PartitionDispatch pd, Datum *values, bool *isnull)
 			{
 				bool		equal = false;
 
+				/* Try the bound that routed the last few tuples first */
+				if (pd->last_bound_hits >= PARTITION_CACHED_FIND_THRESHOLD &&
+					DatumGetInt32(FunctionCall2Coll(&key->partsupfunc[0],
+													key->partcollation[0],
+													boundinfo->datums[pd->last_bound_offset][0],
+													values[0])) == 0)
+				{
+					pd->last_bound_hits++;
+					return boundinfo->indexes[pd->last_bound_offset];
+				}
+
 				bound_offset = partition_list_bsearch(key->partsupfunc,
 													  key->partcollation,
 													  boundinfo,
 													  values[0], &equal);
 				if (bound_offset >= 0 && equal)
+				{
 					part_index = boundinfo->indexes[bound_offset];
+					cache_offset = bound_offset;
+				}
 			}
 			break;
 
@@ -1263,6 +1311,40 @@ get_partition_for_tuple(PartitionDispatch pd, Datum *values, bool *isnull)
 
 				if (!range_partkey_has_null)
 				{
+					/*
+					 * Try the partition that the last few tuples went to
+					 * first.  Its lower bound, if any, must be less than or
+					 * equal to the tuple, and its upper bound, if any,
+					 * greater than it.
+					 */
+					if (pd->last_bound_hits >= PARTITION_CACHED_FIND_THRESHOLD)
+					{
+						int			off = pd->last_bound_offset;
+
+						if ((off < 0 ||
+							 partition_rbound_datum_cmp(key->partsupfunc,
+														key->partcollation,
+														boundinfo->datums[off],
+														boundinfo->kind[off],
+														values,
+														key->partnatts) <= 0) &&
+							(off + 1 >= boundinfo->ndatums ||
+							 partition_rbound_datum_cmp(key->partsupfunc,
+														key->partcollation,
+														boundinfo->datums[off + 1],
+														boundinfo->kind[off + 1],
+														values,
+														key->partnatts) > 0))
+						{
+							part_index = boundinfo->indexes[off + 1];
+							if (part_index >= 0)
+							{
+								pd->last_bound_hits++;
+								return part_index;
+							}
+						}
+					}
+
 					bound_offset = partition_range_datum_bsearch(key->partsupfunc,
 																 key->partcollation,
 																 boundinfo,
@@ -1277,6 +1359,8 @@ get_partition_for_tuple(PartitionDispatch pd, Datum *values, bool *isnull)
 					 * actually exists one.
 					 */
 					part_index = boundinfo->indexes[bound_offset + 1];
+					if (part_index >= 0)
+						cache_offset = bound_offset;
 				}
 			}
 			break;
@@ -1286,6 +1370,24 @@ get_partition_for_tuple(PartitionDispatch pd, Datum *values, bool *isnull)
 				 (int) key->strategy);
 	}
 
+	/*
+	 * Remember which bound routed this tuple.  For RANGE partitioning, an
+	 * offset of -1 is a valid bound (the partition with no lower bound), so
+	 * whether there's anything to remember is tracked separately.
+	 */
+	if (part_index >= 0 && cache_offset != -2)
+	{
+		if (cache_offset == pd->last_bound_offset)
+			pd->last_bound_hits++;
+		else
+		{
+			pd->last_bound_offset = cache_offset;
+			pd->last_bound_hits = 1;
+		}
+	}
+	else
+		pd->last_bound_hits = 0;
+
 	/*
 	 * part_index < 0 means we failed to find a partition of this parent. Use
 	 * the default partition, if there is one.
@@ -1500,6 +1602,11 @@ adjust_partition_tlist(List *tlist, TupleConversionMap *map)
  *		expressions.  This function can only be called during execution and
  *		must be called again each time the value of a Param listed in
  *		PartitionPruneState's 'execparamids' changes.
+ *
+ * ExecPrunableRelidsToLock:
+ *		Returns the RT indexes of the prunable leaf partitions of a cached
+ *		plan that survive initial pruning, which is done outside of any
+ *		executor run; plancache.c uses this to avoid locking the others.
  *-------------------------------------------------------------------------
  */
 
@@ -1921,6 +2028,112 @@ ExecFindMatchingSubPlans(PartitionPruneState *prunestate)
 	return result;
 }
 
+/*
+ * ExecPrunableRelidsToLock
+ *		Determine which of plannedstmt->prunableRelids survive the initial
+ *		pruning of the plan's partPruneInfos with the given external Params.
+ *
+ * The caller must already hold the locks on all the other relations of the
+ * plan, including the partitioned tables, and have checked that the plan is
+ * still valid; so the partition descriptors are the ones the plan was made
+ * for.  Since the planner only lists PartitionPruneInfos whose initial
+ * pruning depends on nothing but the Params, ExecInitAppend and
+ * ExecInitMergeAppend are certain to come up with the same subplans later.
+ */
+Bitmapset *
+ExecPrunableRelidsToLock(PlannedStmt *plannedstmt, ParamListInfo params)
+{
+	EState	   *estate;
+	PlanState  *planstate;
+	MemoryContext oldcontext;
+	Bitmapset  *result = NULL;
+	ListCell   *lc;
+	int			i;
+
+	/*
+	 * Build just enough of an executor state to evaluate the pruning
+	 * expressions in.
+	 */
+	estate = CreateExecutorState();
+	estate->es_param_list_info = params;
+
+	oldcontext = MemoryContextSwitchTo(estate->es_query_cxt);
+
+	ExecInitRangeTable(estate, plannedstmt->rtable);
+	planstate = makeNode(PlanState);
+	planstate->state = estate;
+	planstate->ps_ExprContext = CreateExprContext(estate);
+
+	foreach(lc, plannedstmt->partPruneInfos)
+	{
+		PartitionPruneInfo *pruneinfo = lfirst_node(PartitionPruneInfo, lc);
+		PartitionPruneState *prunestate;
+		Bitmapset  *validsubplans;
+		ListCell   *lc2;
+		int			nsubplans;
+
+		Assert(pruneinfo->prune_before_locking);
+
+		/* Every subplan is either mapped or in other_subplans */
+		nsubplans = 0;
+		i = -1;
+		while ((i = bms_next_member(pruneinfo->other_subplans, i)) >= 0)
+			nsubplans = Max(nsubplans, i + 1);
+		foreach(lc2, pruneinfo->prune_infos)
+		{
+			ListCell   *lc3;
+
+			foreach(lc3, lfirst_node(List, lc2))
+			{
+				PartitionedRelPruneInfo *pinfo = lfirst(lc3);
+
+				for (i = 0; i < pinfo->nparts; i++)
+					nsubplans = Max(nsubplans, pinfo->subplan_map[i] + 1);
+			}
+		}
+
+		prunestate = ExecCreatePartitionPruneState(planstate, pruneinfo);
+		validsubplans = ExecFindInitialMatchingSubPlans(prunestate, nsubplans);
+
+		/* The executor initializes the first subplan if none survive */
+		if (bms_is_empty(validsubplans))
+			validsubplans = bms_make_singleton(0);
+
+		/* Translate the surviving subplans to RT indexes */
+		foreach(lc2, pruneinfo->prune_infos)
+		{
+			ListCell   *lc3;
+
+			foreach(lc3, lfirst_node(List, lc2))
+			{
+				PartitionedRelPruneInfo *pinfo = lfirst(lc3);
+
+				for (i = 0; i < pinfo->nparts; i++)
+				{
+					if (pinfo->leafpart_rti_map[i] != 0 &&
+						bms_is_member(pinfo->subplan_map[i], validsubplans))
+						result = bms_add_member(result,
+												pinfo->leafpart_rti_map[i]);
+				}
+			}
+		}
+	}
+
+	/* Copy the result out before we throw away the executor state */
+	MemoryContextSwitchTo(oldcontext);
+	result = bms_intersect(result, plannedstmt->prunableRelids);
+
+	/* Close the partitioned tables opened by ExecCreatePartitionPruneState */
+	for (i = 0; i < estate->es_range_table_size; i++)
+	{
+		if (estate->es_relations[i])
+			heap_close(estate->es_relations[i], NoLock);
+	}
+	FreeExecutorState(estate);
+
+	return result;
+}
+
 /*
  * find_matching_subplans_recurse
  *		Recursive worker function for ExecFindMatchingSubPlans and
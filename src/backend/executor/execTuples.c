@@ -829,6 +829,38 @@ tts_buffer_heap_store_tuple(TupleTableSlot *slot, HeapTuple tuple, Buffer buffer
 	}
 }
 
+/*
+ * slot_first_null_attr
+ *		Return the number of the first attribute at or after start, and before
+ *		natts, that the null bitmap bp marks as null; natts if there is none.
+ *
+ * Whole bytes of the bitmap are skipped at a time while all their bits are
+ * set, which matters for wide tuples with only a few nulls.
+ */
+static inline int
+slot_first_null_attr(bits8 *bp, int start, int natts)
+{
+	int			attnum = start;
+
+	/* Check bits individually up to the next byte boundary */
+	while (attnum < natts && (attnum & 7) != 0)
+	{
+		if (att_isnull(attnum, bp))
+			return attnum;
+		attnum++;
+	}
+
+	/* Skip over bytes that have no nulls */
+	while (attnum + 8 <= natts && bp[attnum >> 3] == 0xFF)
+		attnum += 8;
+
+	/* And locate the null, if any, in the remaining bits */
+	while (attnum < natts && !att_isnull(attnum, bp))
+		attnum++;
+
+	return attnum;
+}
+
 /*
  * slot_deform_heap_tuple
  *		Given a TupleTableSlot, extract data from the slot's physical tuple
@@ -857,6 +889,7 @@ slot_deform_heap_tuple(TupleTableSlot *slot, HeapTuple tuple, uint32 *offp,
 	uint32		off;			/* offset in tuple data */
 	bits8	   *bp = tup->t_bits;	/* ptr to null bitmap in tuple */
 	bool		slow;			/* can we use/set attcacheoff? */
+	int			firstnull;		/* first null attribute to fetch, or natts */
 
 	/* We can only fetch as many attributes as the tuple has. */
 	natts = Min(HeapTupleHeaderGetNatts(tuple->t_data), natts);
@@ -881,6 +914,38 @@ slot_deform_heap_tuple(TupleTableSlot *slot, HeapTuple tuple, uint32 *offp,
 
 	tp = (char *) tup + tup->t_hoff;
 
+	/*
+	 * As long as attributes are known not null and have a cached offset,
+	 * there is nothing to check or compute per attribute; fetch them in a
+	 * tight loop first.  This typically covers the fixed-width prefix of the
+	 * tuple, up to and including the first varlena.
+	 */
+	if (!slow)
+	{
+		firstnull = hasnulls ? slot_first_null_attr(bp, attnum, natts) : natts;
+
+		for (; attnum < firstnull; attnum++)
+		{
+			Form_pg_attribute thisatt = TupleDescAttr(tupleDesc, attnum);
+
+			if (thisatt->attcacheoff < 0)
+				break;
+
+			off = thisatt->attcacheoff;
+			isnull[attnum] = false;
+			values[attnum] = fetchatt(thisatt, tp + off);
+			off = att_addlength_pointer(off, thisatt->attlen, tp + off);
+
+			if (thisatt->attlen <= 0)
+			{
+				/* can't use attcacheoff anymore */
+				slow = true;
+				attnum++;
+				break;
+			}
+		}
+	}
+
 	for (; attnum < natts; attnum++)
 	{
 		Form_pg_attribute thisatt = TupleDescAttr(tupleDesc, attnum);
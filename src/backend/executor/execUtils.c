@@ -257,6 +257,8 @@ CreateExprContext(EState *estate)
 
 	/*
 	 * Create working memory for expression evaluation in this context.
+	 * This must not be a bump context: nodeAgg.c and nodeWindowAgg.c pfree()
+	 * pass-by-ref transition values here, and expect that space to be reused.
 	 */
 	econtext->ecxt_per_tuple_memory =
 		AllocSetContextCreate(estate->es_query_cxt,
@@ -26,6 +26,7 @@
 #include "parser/parse_coerce.h"
 #include "parser/parse_func.h"
 #include "storage/proc.h"
+#include "tcop/tcopprot.h"
 #include "tcop/utility.h"
 #include "utils/builtins.h"
 #include "utils/datum.h"
@@ -142,6 +143,25 @@ typedef struct SQLFunctionParseInfo
 	Oid			collation;		/* function's input collation, if known */
 }			SQLFunctionParseInfo;
 
+/*
+ * Per-backend cache of SQL function bodies in raw-parsetree form, keyed by
+ * function OID.  Raw parsing depends on nothing but the source text, so an
+ * entry stays usable as long as the pg_proc tuple it was made from is still
+ * current; like PL/pgSQL, we check that by comparing the tuple's xmin and
+ * TID.  This saves re-parsing the body each time a query is planned that
+ * inlines the function, and each time its execution cache is rebuilt.
+ */
+typedef struct SQLFunctionParseCacheEntry
+{
+	Oid			fn_oid;			/* hash key: OID of the function */
+	TransactionId fn_xmin;		/* xmin of the pg_proc tuple we parsed */
+	ItemPointerData fn_tid;		/* TID of the pg_proc tuple we parsed */
+	MemoryContext context;		/* holds raw_parsetree_list, or NULL */
+	List	   *raw_parsetree_list; /* list of RawStmt */
+} SQLFunctionParseCacheEntry;
+
+static HTAB *sql_fn_parse_cache = NULL;
+
 
 /* non-export function prototypes */
 static Node *sql_fn_param_ref(ParseState *pstate, ParamRef *pref);
@@ -266,6 +286,72 @@ prepare_sql_fn_parse_info(HeapTuple procedureTuple,
 	return pinfo;
 }
 
+/*
+ * Get the raw parse trees for a SQL function body
+ *
+ * src must be the prosrc text of procedureTuple.  The result is freshly
+ * allocated in the caller's memory context, so the caller may hand it to
+ * parse analysis (which tends to scribble on its input) without harming the
+ * cached copy.
+ */
+List *
+get_sql_fn_raw_parsetrees(HeapTuple procedureTuple, const char *src)
+{
+	Oid			foid = ((Form_pg_proc) GETSTRUCT(procedureTuple))->oid;
+	SQLFunctionParseCacheEntry *entry;
+	List	   *raw_parsetree_list;
+	MemoryContext context;
+	MemoryContext oldcontext;
+	bool		found;
+
+	if (sql_fn_parse_cache == NULL)
+	{
+		HASHCTL		ctl;
+
+		memset(&ctl, 0, sizeof(ctl));
+		ctl.keysize = sizeof(Oid);
+		ctl.entrysize = sizeof(SQLFunctionParseCacheEntry);
+		sql_fn_parse_cache = hash_create("SQL function parse cache", 64,
+										 &ctl, HASH_ELEM | HASH_BLOBS);
+	}
+
+	entry = (SQLFunctionParseCacheEntry *)
+		hash_search(sql_fn_parse_cache, &foid, HASH_ENTER, &found);
+
+	if (found && entry->context != NULL)
+	{
+		if (entry->fn_xmin == HeapTupleHeaderGetRawXmin(procedureTuple->t_data) &&
+			ItemPointerEquals(&entry->fn_tid, &procedureTuple->t_self))
+			return copyObject(entry->raw_parsetree_list);
+
+		/* Function was changed since we parsed it; discard the old trees */
+		context = entry->context;
+		entry->context = NULL;
+		MemoryContextDelete(context);
+	}
+	else if (!found)
+		entry->context = NULL;
+
+	raw_parsetree_list = pg_parse_query(src);
+
+	/*
+	 * Save a copy in a context of its own.  The entry becomes valid only once
+	 * that has succeeded.
+	 */
+	context = AllocSetContextCreate(CacheMemoryContext,
+									"SQL function parse trees",
+									ALLOCSET_SMALL_SIZES);
+	oldcontext = MemoryContextSwitchTo(context);
+	entry->raw_parsetree_list = copyObject(raw_parsetree_list);
+	MemoryContextSwitchTo(oldcontext);
+
+	entry->fn_xmin = HeapTupleHeaderGetRawXmin(procedureTuple->t_data);
+	entry->fn_tid = procedureTuple->t_self;
+	entry->context = context;
+
+	return raw_parsetree_list;
+}
+
 /*
  * Parser setup hook for parsing a SQL function body.
  */
@@ -704,7 +790,7 @@ init_sql_fcache(FmgrInfo *finfo, Oid collation, bool lazyEvalOK)
 	 * but we'll not worry about it until the module is rewritten to use
 	 * plancache.c.
 	 */
-	raw_parsetree_list = pg_parse_query(fcache->src);
+	raw_parsetree_list = get_sql_fn_raw_parsetrees(procedureTuple, fcache->src);
 
 	queryTree_list = NIL;
 	flat_query_list = NIL;
@@ -14,15 +14,47 @@
 #include "postgres.h"
 
 #include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
 
 #include "executor/instrument.h"
 
+#if defined(__linux__) && defined(SYS_perf_event_open)
+#define USE_PERF_EVENTS
+#endif
+
 BufferUsage pgBufferUsage;
 static BufferUsage save_pgBufferUsage;
+WalUsage	pgWalUsage;
+
+#ifdef USE_PERF_EVENTS
+/*
+ * Hardware counters are opened on first use as one perf_event group, so a
+ * single read() returns all of them consistently, and are kept open and
+ * counting for the rest of the process's life.  The order of the group
+ * members must match the fields of CpuUsage.
+ */
+#define NUM_CPU_COUNTERS	4
+static const uint64 cpu_counter_config[NUM_CPU_COUNTERS] = {
+	PERF_COUNT_HW_CPU_CYCLES,
+	PERF_COUNT_HW_INSTRUCTIONS,
+	PERF_COUNT_HW_CACHE_MISSES,
+	PERF_COUNT_HW_BRANCH_MISSES
+};
+static int	cpu_counter_fd = -1;	/* group leader, or -1 */
+static bool cpu_counters_tried = false;
+#endif
 
 static void BufferUsageAdd(BufferUsage *dst, const BufferUsage *add);
 static void BufferUsageAccumDiff(BufferUsage *dst,
 					 const BufferUsage *add, const BufferUsage *sub);
+static void WalUsageAdd(WalUsage *dst, const WalUsage *add);
+static void CpuUsageGet(CpuUsage *usage);
+static void CpuUsageAdd(CpuUsage *dst, const CpuUsage *add);
+static void CpuUsageAccumDiff(CpuUsage *dst,
+				  const CpuUsage *add, const CpuUsage *sub);
 
 
 /* Allocate new instrumentation structure(s) */
@@ -33,15 +65,21 @@ InstrAlloc(int n, int instrument_options)
 
 	/* initialize all fields to zeroes, then modify as needed */
 	instr = palloc0(n * sizeof(Instrumentation));
-	if (instrument_options & (INSTRUMENT_BUFFERS | INSTRUMENT_TIMER))
+	if (instrument_options & (INSTRUMENT_BUFFERS | INSTRUMENT_TIMER |
+							  INSTRUMENT_WAL | INSTRUMENT_CPU))
 	{
 		bool		need_buffers = (instrument_options & INSTRUMENT_BUFFERS) != 0;
+		bool		need_wal = (instrument_options & INSTRUMENT_WAL) != 0;
+		bool		need_cpu = (instrument_options & INSTRUMENT_CPU) != 0 &&
+			InstrCpuCountersAvailable();
 		bool		need_timer = (instrument_options & INSTRUMENT_TIMER) != 0;
 		int			i;
 
 		for (i = 0; i < n; i++)
 		{
 			instr[i].need_bufusage = need_buffers;
+			instr[i].need_walusage = need_wal;
+			instr[i].need_cpuusage = need_cpu;
 			instr[i].need_timer = need_timer;
 		}
 	}
@@ -55,6 +93,9 @@ InstrInit(Instrumentation *instr, int instrument_options)
 {
 	memset(instr, 0, sizeof(Instrumentation));
 	instr->need_bufusage = (instrument_options & INSTRUMENT_BUFFERS) != 0;
+	instr->need_walusage = (instrument_options & INSTRUMENT_WAL) != 0;
+	instr->need_cpuusage = (instrument_options & INSTRUMENT_CPU) != 0 &&
+		InstrCpuCountersAvailable();
 	instr->need_timer = (instrument_options & INSTRUMENT_TIMER) != 0;
 }
 
@@ -69,6 +110,12 @@ InstrStartNode(Instrumentation *instr)
 	/* save buffer usage totals at node entry, if needed */
 	if (instr->need_bufusage)
 		instr->bufusage_start = pgBufferUsage;
+
+	if (instr->need_walusage)
+		instr->walusage_start = pgWalUsage;
+
+	if (instr->need_cpuusage)
+		CpuUsageGet(&instr->cpuusage_start);
 }
 
 /* Exit from a plan node */
@@ -97,6 +144,18 @@ InstrStopNode(Instrumentation *instr, double nTuples)
 		BufferUsageAccumDiff(&instr->bufusage,
 							 &pgBufferUsage, &instr->bufusage_start);
 
+	if (instr->need_walusage)
+		WalUsageAccumDiff(&instr->walusage,
+						  &pgWalUsage, &instr->walusage_start);
+
+	if (instr->need_cpuusage)
+	{
+		CpuUsage	cpuusage;
+
+		CpuUsageGet(&cpuusage);
+		CpuUsageAccumDiff(&instr->cpuusage, &cpuusage, &instr->cpuusage_start);
+	}
+
 	/* Is this the first tuple of this cycle? */
 	if (!instr->running)
 	{
@@ -160,6 +219,12 @@ InstrAggNode(Instrumentation *dst, Instrumentation *add)
 	/* Add delta of buffer usage since entry to node's totals */
 	if (dst->need_bufusage)
 		BufferUsageAdd(&dst->bufusage, &add->bufusage);
+
+	if (dst->need_walusage)
+		WalUsageAdd(&dst->walusage, &add->walusage);
+
+	if (dst->need_cpuusage)
+		CpuUsageAdd(&dst->cpuusage, &add->cpuusage);
 }
 
 /* note current values during parallel executor startup */
@@ -223,3 +288,115 @@ BufferUsageAccumDiff(BufferUsage *dst,
 	INSTR_TIME_ACCUM_DIFF(dst->blk_write_time,
 						  add->blk_write_time, sub->blk_write_time);
 }
+
+/* dst += add */
+static void
+WalUsageAdd(WalUsage *dst, const WalUsage *add)
+{
+	dst->wal_records += add->wal_records;
+	dst->wal_fpi += add->wal_fpi;
+	dst->wal_bytes += add->wal_bytes;
+}
+
+/* dst += add - sub */
+void
+WalUsageAccumDiff(WalUsage *dst, const WalUsage *add, const WalUsage *sub)
+{
+	dst->wal_records += add->wal_records - sub->wal_records;
+	dst->wal_fpi += add->wal_fpi - sub->wal_fpi;
+	dst->wal_bytes += add->wal_bytes - sub->wal_bytes;
+}
+
+/*
+ * Can this process read hardware CPU counters?
+ *
+ * The first call tries to open the counters.  That fails on platforms
+ * other than Linux, on hardware or virtual machines without a PMU, and when
+ * kernel.perf_event_paranoid forbids unprivileged access to them; the
+ * counters only ever cover user-space execution of this process.
+ */
+bool
+InstrCpuCountersAvailable(void)
+{
+#ifdef USE_PERF_EVENTS
+	if (!cpu_counters_tried)
+	{
+		int			i;
+
+		cpu_counters_tried = true;
+
+		for (i = 0; i < NUM_CPU_COUNTERS; i++)
+		{
+			struct perf_event_attr attr;
+			int			fd;
+
+			memset(&attr, 0, sizeof(attr));
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.size = sizeof(attr);
+			attr.config = cpu_counter_config[i];
+			attr.read_format = PERF_FORMAT_GROUP;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+
+			fd = syscall(SYS_perf_event_open, &attr, 0, -1,
+						 cpu_counter_fd, 0);
+			if (fd < 0)
+			{
+				elog(DEBUG1, "could not open CPU performance counter: %m");
+				/* closing the leader releases the whole group */
+				if (cpu_counter_fd >= 0)
+					close(cpu_counter_fd);
+				cpu_counter_fd = -1;
+				break;
+			}
+			if (cpu_counter_fd < 0)
+				cpu_counter_fd = fd;
+		}
+	}
+
+	return cpu_counter_fd >= 0;
+#else
+	return false;
+#endif
+}
+
+/* read current values of the CPU counters */
+static void
+CpuUsageGet(CpuUsage *usage)
+{
+#ifdef USE_PERF_EVENTS
+	uint64		buf[1 + NUM_CPU_COUNTERS];
+
+	if (cpu_counter_fd >= 0 &&
+		read(cpu_counter_fd, buf, sizeof(buf)) == sizeof(buf) &&
+		buf[0] == NUM_CPU_COUNTERS)
+	{
+		usage->cycles = buf[1];
+		usage->instructions = buf[2];
+		usage->cache_misses = buf[3];
+		usage->branch_misses = buf[4];
+		return;
+	}
+#endif
+	memset(usage, 0, sizeof(CpuUsage));
+}
+
+/* dst += add */
+static void
+CpuUsageAdd(CpuUsage *dst, const CpuUsage *add)
+{
+	dst->cycles += add->cycles;
+	dst->instructions += add->instructions;
+	dst->cache_misses += add->cache_misses;
+	dst->branch_misses += add->branch_misses;
+}
+
+/* dst += add - sub */
+static void
+CpuUsageAccumDiff(CpuUsage *dst, const CpuUsage *add, const CpuUsage *sub)
+{
+	dst->cycles += add->cycles - sub->cycles;
+	dst->instructions += add->instructions - sub->instructions;
+	dst->cache_misses += add->cache_misses - sub->cache_misses;
+	dst->branch_misses += add->branch_misses - sub->branch_misses;
+}
@@ -194,6 +194,22 @@
  *	  transition values.  hashcontext is the single context created to support
  *	  all hash tables.
  *
+ *	  Spilling to disk:
+ *
+ *	  When hashing, everything in hashcontext counts against work_mem.  Once
+ *	  creating a new group has pushed the hash tables past that limit, we
+ *	  enter "spill mode": tuples belonging to groups that are already in
+ *	  memory are still aggregated, but tuples that would start a new group are
+ *	  written out instead, divided between a number of spill files by their
+ *	  hash value, and the pointer to their per-group state is left NULL so
+ *	  that the transition expression skips them (see the nullcheck argument of
+ *	  ExecBuildAggTrans).  After the in-memory groups have been emitted, the
+ *	  hash table is emptied and each spill file is processed in turn as a
+ *	  "batch" of its own, for one grouping set only.  A batch that still
+ *	  doesn't fit is spilled again, using the next bits of the hash value to
+ *	  partition it.  Every pass creates at least one group before it can
+ *	  start spilling, so this terminates even when the hash bits run out.
+ *
  *    Transition / Combine function invocation:
  *
  *    For performance reasons transition functions, including combine
@@ -230,8 +246,10 @@
 #include "optimizer/tlist.h"
 #include "parser/parse_agg.h"
 #include "parser/parse_coerce.h"
+#include "storage/buffile.h"
 #include "utils/acl.h"
 #include "utils/builtins.h"
+#include "utils/dynahash.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/syscache.h"
@@ -239,6 +257,45 @@
 #include "utils/datum.h"
 
 
+/*
+ * Limits on the number of partitions a spilling hashed aggregate divides its
+ * input into.  We aim for partitions that will each fit in work_mem with
+ * some room to spare, given the estimated number of groups.
+ */
+#define HASHAGG_PARTITION_FACTOR 1.50
+#define HASHAGG_MIN_PARTITIONS 4
+#define HASHAGG_MAX_PARTITIONS 256
+
+/*
+ * Spill state for one grouping set while its input is being read: the files
+ * that tuples belonging to groups not in memory are written to, selected by
+ * some bits of the tuple's hash value.
+ */
+typedef struct HashAggSpill
+{
+	int			npartitions;	/* number of partitions */
+	BufFile   **partitions;		/* spill file per partition, or NULL */
+	int64	   *ntuples;		/* number of tuples in each partition */
+	uint32		mask;			/* mask to find partition from hash value */
+	int			shift;			/* after masking, shift by this amount */
+	int			used_bits;		/* hash bits used once partitioned */
+	double		input_groups;	/* estimated number of groups spilled */
+} HashAggSpill;
+
+/*
+ * A spill file waiting to be processed.  Each batch holds the input tuples of
+ * one grouping set, along with their hash values.
+ */
+typedef struct HashAggBatch
+{
+	int			setno;			/* grouping set */
+	int			used_bits;		/* number of bits of hash already used */
+	BufFile    *input_file;		/* spilled tuples */
+	int64		input_tuples;	/* number of tuples in the file */
+	double		input_groups;	/* estimated number of groups in the file */
+} HashAggBatch;
+
+
 static void select_current_set(AggState *aggstate, int setno, bool is_hash);
 static void initialize_phase(AggState *aggstate, int newphase);
 static TupleTableSlot *fetch_input_tuple(AggState *aggstate);
@@ -272,12 +329,31 @@ static void finalize_aggregates(AggState *aggstate,
 static TupleTableSlot *project_aggregates(AggState *aggstate);
 static Bitmapset *find_unaggregated_cols(AggState *aggstate);
 static bool find_unaggregated_cols_walker(Node *node, Bitmapset **colnos);
-static void build_hash_table(AggState *aggstate);
-static TupleHashEntryData *lookup_hash_entry(AggState *aggstate);
+static void build_hash_tables(AggState *aggstate);
+static void build_hash_table(AggState *aggstate, int setno, long nbuckets);
+static long hash_choose_num_buckets(AggState *aggstate, double ngroups);
+static void prepare_hash_slot(AggState *aggstate);
+static TupleHashEntryData *lookup_hash_entry(AggState *aggstate, uint32 hash);
 static void lookup_hash_entries(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_direct(AggState *aggstate);
 static void agg_fill_hash_table(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_hash_table(AggState *aggstate);
+static void hashagg_recompile_expressions(AggState *aggstate, bool minslot,
+							  bool nullcheck);
+static void hash_agg_check_limits(AggState *aggstate);
+static void hash_agg_update_metrics(AggState *aggstate);
+static int	hash_choose_partition_bits(AggState *aggstate, double input_groups,
+						   int used_bits);
+static void hashagg_spill_init(AggState *aggstate, HashAggSpill *spill,
+				   int used_bits, double input_groups);
+static void hashagg_spill_tuple(AggState *aggstate, HashAggSpill *spill,
+					TupleTableSlot *slot, uint32 hash);
+static void hashagg_spill_finish(AggState *aggstate, HashAggSpill *spill,
+					 int setno);
+static void hashagg_finish_initial_spills(AggState *aggstate);
+static MinimalTuple hashagg_batch_read(HashAggBatch *batch, uint32 *hashp);
+static bool agg_refill_hash_table(AggState *aggstate);
+static void hashagg_reset_spill_state(AggState *aggstate);
 static Datum GetAggInitVal(Datum textInitVal, Oid transtype);
 static void build_pertrans_for_aggref(AggStatePerTrans pertrans,
 						  AggState *aggstate, EState *estate,
@@ -1261,36 +1337,71 @@ find_unaggregated_cols_walker(Node *node, Bitmapset **colnos)
  * reset at the same time).
  */
 static void
-build_hash_table(AggState *aggstate)
+build_hash_tables(AggState *aggstate)
 {
-	MemoryContext tmpmem = aggstate->tmpcontext->ecxt_per_tuple_memory;
-	Size		additionalsize;
 	int			i;
 
 	Assert(aggstate->aggstrategy == AGG_HASHED || aggstate->aggstrategy == AGG_MIXED);
 
-	additionalsize = aggstate->numtrans * sizeof(AggStatePerGroupData);
-
 	for (i = 0; i < aggstate->num_hashes; ++i)
 	{
 		AggStatePerHash perhash = &aggstate->perhash[i];
 
 		Assert(perhash->aggnode->numGroups > 0);
 
-		perhash->hashtable = BuildTupleHashTable(&aggstate->ss.ps,
-												 perhash->hashslot->tts_tupleDescriptor,
-												 perhash->numCols,
-												 perhash->hashGrpColIdxHash,
-												 perhash->eqfuncoids,
-												 perhash->hashfunctions,
-												 perhash->aggnode->numGroups,
-												 additionalsize,
-												 aggstate->hashcontext->ecxt_per_tuple_memory,
-												 tmpmem,
-												 DO_AGGSPLIT_SKIPFINAL(aggstate->aggsplit));
+		build_hash_table(aggstate, i,
+						 hash_choose_num_buckets(aggstate,
+												 perhash->aggnode->numGroups));
 	}
 }
 
+/*
+ * Choose the initial size of a hash table expected to hold ngroups groups.
+ *
+ * There's no point in making room for more groups than fit in the memory
+ * limit, since we'll spill rather than create them.  That matters most when
+ * the planner's estimate is large, which it may be now that it doesn't
+ * avoid hashing when the table won't fit.
+ */
+static long
+hash_choose_num_buckets(AggState *aggstate, double ngroups)
+{
+	double		max_nbuckets;
+
+	max_nbuckets = aggstate->hash_mem_limit / aggstate->hashentrysize;
+	if (ngroups > max_nbuckets)
+		ngroups = max_nbuckets;
+
+	/* make sure the value fits in a long, and isn't silly small */
+	ngroups = Min(ngroups, (double) LONG_MAX);
+	return Max((long) ngroups, 1);
+}
+
+/*
+ * Build the hash table for one grouping set, sized for nbuckets entries.
+ */
+static void
+build_hash_table(AggState *aggstate, int setno, long nbuckets)
+{
+	AggStatePerHash perhash = &aggstate->perhash[setno];
+	MemoryContext tmpmem = aggstate->tmpcontext->ecxt_per_tuple_memory;
+	Size		additionalsize;
+
+	additionalsize = aggstate->numtrans * sizeof(AggStatePerGroupData);
+
+	perhash->hashtable = BuildTupleHashTable(&aggstate->ss.ps,
+											 perhash->hashslot->tts_tupleDescriptor,
+											 perhash->numCols,
+											 perhash->hashGrpColIdxHash,
+											 perhash->eqfuncoids,
+											 perhash->hashfunctions,
+											 Max(nbuckets, 1),
+											 additionalsize,
+											 aggstate->hashcontext->ecxt_per_tuple_memory,
+											 tmpmem,
+											 DO_AGGSPLIT_SKIPFINAL(aggstate->aggsplit));
+}
+
 /*
  * Compute columns that actually need to be stored in hashtable entries.  The
  * incoming tuples from the child plan node will contain grouping columns,
@@ -1435,24 +1546,18 @@ hash_agg_entry_size(int numAggs)
 }
 
 /*
- * Find or create a hashtable entry for the tuple group containing the current
- * tuple (already set in tmpcontext's outertuple slot), in the current grouping
- * set (which the caller must have selected - note that initialize_aggregate
- * depends on this).
- *
- * When called, CurrentMemoryContext should be the per-query context.
+ * Transfer just the columns needed by the current grouping set's hash table
+ * from the current tuple (already set in tmpcontext's outertuple slot) into
+ * its hashslot.
  */
-static TupleHashEntryData *
-lookup_hash_entry(AggState *aggstate)
+static void
+prepare_hash_slot(AggState *aggstate)
 {
 	TupleTableSlot *inputslot = aggstate->tmpcontext->ecxt_outertuple;
 	AggStatePerHash perhash = &aggstate->perhash[aggstate->current_set];
 	TupleTableSlot *hashslot = perhash->hashslot;
-	TupleHashEntryData *entry;
-	bool		isnew;
 	int			i;
 
-	/* transfer just the needed columns into hashslot */
 	slot_getsomeattrs(inputslot, perhash->largestGrpColIdx);
 	ExecClearTuple(hashslot);
 
@@ -1464,9 +1569,31 @@ lookup_hash_entry(AggState *aggstate)
 		hashslot->tts_isnull[i] = inputslot->tts_isnull[varNumber];
 	}
 	ExecStoreVirtualTuple(hashslot);
+}
+
+/*
+ * Find or create a hashtable entry for the tuple group containing the current
+ * tuple, in the current grouping set (which the caller must have selected -
+ * note that initialize_aggregate depends on this).  The caller must have
+ * called prepare_hash_slot() and computed the tuple's hash value.
+ *
+ * In spill mode no new entries are created; NULL is returned if the tuple's
+ * group is not in memory already, and the caller must spill the tuple.
+ *
+ * When called, CurrentMemoryContext should be the per-query context.
+ */
+static TupleHashEntryData *
+lookup_hash_entry(AggState *aggstate, uint32 hash)
+{
+	AggStatePerHash perhash = &aggstate->perhash[aggstate->current_set];
+	TupleTableSlot *hashslot = perhash->hashslot;
+	TupleHashEntryData *entry;
+	bool		isnew = false;
 
 	/* find or create the hashtable entry using the filtered tuple */
-	entry = LookupTupleHashEntry(perhash->hashtable, hashslot, &isnew);
+	entry = LookupTupleHashEntryHash(perhash->hashtable, hashslot,
+									 aggstate->hash_spill_mode ? NULL : &isnew,
+									 hash);
 
 	if (isnew)
 	{
@@ -1489,6 +1616,9 @@ lookup_hash_entry(AggState *aggstate)
 
 			initialize_aggregate(aggstate, pertrans, pergroupstate);
 		}
+
+		aggstate->hash_ngroups_current++;
+		hash_agg_check_limits(aggstate);
 	}
 
 	return entry;
@@ -1497,6 +1627,8 @@ lookup_hash_entry(AggState *aggstate)
 /*
  * Look up hash entries for the current tuple in all hashed grouping sets,
  * returning an array of pergroup pointers suitable for advance_aggregates.
+ * In spill mode, tuples whose group is not in memory are written to the
+ * grouping set's spill files, and their pergroup pointer is set to NULL.
  *
  * Be aware that lookup_hash_entry can reset the tmpcontext.
  */
@@ -1509,8 +1641,29 @@ lookup_hash_entries(AggState *aggstate)
 
 	for (setno = 0; setno < numHashes; setno++)
 	{
+		AggStatePerHash perhash = &aggstate->perhash[setno];
+		TupleHashEntryData *entry;
+		uint32		hash;
+
 		select_current_set(aggstate, setno, true);
-		pergroup[setno] = lookup_hash_entry(aggstate)->additional;
+		prepare_hash_slot(aggstate);
+		hash = TupleHashTableHash(perhash->hashtable, perhash->hashslot);
+
+		entry = lookup_hash_entry(aggstate, hash);
+		if (entry != NULL)
+			pergroup[setno] = entry->additional;
+		else
+		{
+			HashAggSpill *spill = &aggstate->hash_spills[setno];
+
+			if (spill->partitions == NULL)
+				hashagg_spill_init(aggstate, spill, 0,
+								   perhash->aggnode->numGroups);
+
+			hashagg_spill_tuple(aggstate, spill,
+								aggstate->tmpcontext->ecxt_outertuple, hash);
+			pergroup[setno] = NULL;
+		}
 	}
 }
 
@@ -1665,6 +1818,7 @@ agg_retrieve_direct(AggState *aggstate)
 				 */
 				initialize_phase(aggstate, 0);
 				aggstate->table_filled = true;
+				hashagg_finish_initial_spills(aggstate);
 				ResetTupleHashIterator(aggstate->perhash[0].hashtable,
 									   &aggstate->perhash[0].hashiter);
 				select_current_set(aggstate, 0, true);
@@ -1936,6 +2090,8 @@ agg_fill_hash_table(AggState *aggstate)
 	}
 
 	aggstate->table_filled = true;
+	hashagg_finish_initial_spills(aggstate);
+
 	/* Initialize to walk the first hash table */
 	select_current_set(aggstate, 0, true);
 	ResetTupleHashIterator(aggstate->perhash[0].hashtable,
@@ -1990,11 +2146,13 @@ agg_retrieve_hash_table(AggState *aggstate)
 		{
 			int			nextset = aggstate->current_set + 1;
 
-			if (nextset < aggstate->num_hashes)
+			if (aggstate->hash_batches_used == 1 &&
+				nextset < aggstate->num_hashes)
 			{
 				/*
 				 * Switch to next grouping set, reinitialize, and restart the
-				 * loop.
+				 * loop.  (This only applies to the first pass; a spilled
+				 * batch has only one grouping set in memory.)
 				 */
 				select_current_set(aggstate, nextset, true);
 
@@ -2004,6 +2162,13 @@ agg_retrieve_hash_table(AggState *aggstate)
 
 				continue;
 			}
+			else if (agg_refill_hash_table(aggstate))
+			{
+				/* Load the next spilled batch, and restart the loop */
+				perhash = &aggstate->perhash[aggstate->current_set];
+
+				continue;
+			}
 			else
 			{
 				/* No more hashtables, so done */
@@ -2064,6 +2229,503 @@ agg_retrieve_hash_table(AggState *aggstate)
 	return NULL;
 }
 
+/*
+ * Switch the hashing phase's transition expression to the variant needed for
+ * the input at hand, building it the first time it's needed.
+ *
+ * minslot means that the input tuples are read back from spill files, in
+ * MinimalTuple slots, rather than coming from the outer plan; only the
+ * hashed grouping sets are advanced then.  nullcheck means that the
+ * per-group state of some hashed grouping sets may be NULL, because the
+ * tuple has been spilled for them.
+ */
+static void
+hashagg_recompile_expressions(AggState *aggstate, bool minslot, bool nullcheck)
+{
+	AggStatePerPhase phase;
+	int			i = minslot ? 1 : 0;
+	int			j = nullcheck ? 1 : 0;
+
+	Assert(aggstate->aggstrategy == AGG_HASHED ||
+		   aggstate->aggstrategy == AGG_MIXED);
+
+	if (aggstate->aggstrategy == AGG_HASHED)
+		phase = &aggstate->phases[0];
+	else						/* AGG_MIXED */
+		phase = &aggstate->phases[1];
+
+	if (phase->evaltrans_cache[i][j] == NULL)
+	{
+		PlanState  *ps = &aggstate->ss.ps;
+		const TupleTableSlotOps *outerops = ps->outerops;
+		bool		outeropsfixed = ps->outeropsfixed;
+		bool		outeropsset = ps->outeropsset;
+		MemoryContext oldcontext;
+
+		/* temporarily change the outer slot type while compiling */
+		if (minslot)
+		{
+			ps->outerops = &TTSOpsMinimalTuple;
+			ps->outeropsfixed = true;
+			ps->outeropsset = true;
+		}
+
+		oldcontext = MemoryContextSwitchTo(ps->state->es_query_cxt);
+		phase->evaltrans_cache[i][j] =
+			ExecBuildAggTrans(aggstate, phase,
+							  aggstate->aggstrategy == AGG_MIXED && !minslot,
+							  true, nullcheck);
+		MemoryContextSwitchTo(oldcontext);
+
+		ps->outerops = outerops;
+		ps->outeropsfixed = outeropsfixed;
+		ps->outeropsset = outeropsset;
+	}
+
+	phase->evaltrans = phase->evaltrans_cache[i][j];
+}
+
+/*
+ * Called after a new group has been created: if the hash tables have grown
+ * past the memory limit, stop creating groups and start spilling.
+ *
+ * We don't spill unless there's at least one group in memory, so that every
+ * pass makes progress.
+ */
+static void
+hash_agg_check_limits(AggState *aggstate)
+{
+	Size		mem;
+
+	mem = MemoryContextMemAllocated(aggstate->hashcontext->ecxt_per_tuple_memory,
+									true);
+	if (mem <= aggstate->hash_mem_limit || aggstate->hash_ngroups_current == 0)
+		return;
+
+	hash_agg_update_metrics(aggstate);
+
+	aggstate->hash_spill_mode = true;
+	aggstate->hash_ever_spilled = true;
+
+	/* spill state is set up for each grouping set once it's needed */
+	if (!aggstate->table_filled && aggstate->hash_spills == NULL)
+		aggstate->hash_spills = (HashAggSpill *)
+			MemoryContextAllocZero(aggstate->ss.ps.state->es_query_cxt,
+								   sizeof(HashAggSpill) * aggstate->num_hashes);
+
+	/* once the first pass is over, input comes from the spill files */
+	hashagg_recompile_expressions(aggstate, aggstate->table_filled, true);
+}
+
+/*
+ * Remember the peak memory usage of the hash tables, and revise our estimate
+ * of the memory needed per group based on what they hold right now.
+ */
+static void
+hash_agg_update_metrics(AggState *aggstate)
+{
+	Size		mem;
+
+	mem = MemoryContextMemAllocated(aggstate->hashcontext->ecxt_per_tuple_memory,
+									true);
+	if (mem > aggstate->hash_mem_peak)
+		aggstate->hash_mem_peak = mem;
+
+	if (aggstate->hash_ngroups_current > 0)
+		aggstate->hashentrysize =
+			(double) mem / (double) aggstate->hash_ngroups_current;
+}
+
+/*
+ * Choose how many bits of the hash value to use for partitioning input that
+ * is expected to contain input_groups groups, given that used_bits bits have
+ * been used by earlier passes already.
+ */
+static int
+hash_choose_partition_bits(AggState *aggstate, double input_groups,
+						   int used_bits)
+{
+	double		mem_wanted;
+	double		npartitions;
+	int			max_partitions;
+	int			partition_bits;
+
+	mem_wanted = HASHAGG_PARTITION_FACTOR * input_groups *
+		aggstate->hashentrysize;
+	npartitions = 1 + mem_wanted / aggstate->hash_mem_limit;
+
+	/* don't let the spill files' buffers use more than a quarter of work_mem */
+	max_partitions = aggstate->hash_mem_limit / (4 * BLCKSZ);
+	npartitions = Min(npartitions, max_partitions);
+
+	npartitions = Max(npartitions, HASHAGG_MIN_PARTITIONS);
+	npartitions = Min(npartitions, HASHAGG_MAX_PARTITIONS);
+
+	partition_bits = my_log2((long) npartitions);
+
+	/* make sure that we don't run out of hash bits */
+	if (partition_bits + used_bits >= 32)
+		partition_bits = 32 - used_bits;
+
+	return partition_bits;
+}
+
+/*
+ * Prepare to spill tuples of one grouping set, of which used_bits hash bits
+ * have been used up already.
+ */
+static void
+hashagg_spill_init(AggState *aggstate, HashAggSpill *spill, int used_bits,
+				   double input_groups)
+{
+	int			partition_bits;
+
+	partition_bits = hash_choose_partition_bits(aggstate, input_groups,
+												used_bits);
+
+	spill->npartitions = 1 << partition_bits;
+	spill->partitions = (BufFile **)
+		palloc0(sizeof(BufFile *) * spill->npartitions);
+	spill->ntuples = (int64 *) palloc0(sizeof(int64) * spill->npartitions);
+	spill->used_bits = used_bits + partition_bits;
+	spill->input_groups = input_groups;
+
+	if (partition_bits == 0)
+	{
+		spill->shift = 0;
+		spill->mask = 0;
+	}
+	else
+	{
+		spill->shift = 32 - used_bits - partition_bits;
+		spill->mask = (spill->npartitions - 1) << spill->shift;
+	}
+}
+
+/*
+ * Write a tuple to the spill file of its partition.
+ *
+ * The data recorded in the file for each tuple is its hash value, then the
+ * tuple in MinimalTuple format, as for hash join batch files.  This must be
+ * called in the per-query context, else the temp file buffers will get
+ * messed up.
+ */
+static void
+hashagg_spill_tuple(AggState *aggstate, HashAggSpill *spill,
+					TupleTableSlot *slot, uint32 hash)
+{
+	MinimalTuple tuple;
+	bool		shouldFree;
+	int			partition;
+	BufFile    *file;
+	size_t		written;
+
+	partition = (hash & spill->mask) >> spill->shift;
+	file = spill->partitions[partition];
+	if (file == NULL)
+	{
+		file = BufFileCreateTemp(false);
+		spill->partitions[partition] = file;
+	}
+
+	tuple = ExecFetchSlotMinimalTuple(slot, &shouldFree);
+
+	written = BufFileWrite(file, (void *) &hash, sizeof(uint32));
+	if (written != sizeof(uint32))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not write to hash-aggregate temporary file: %m")));
+
+	written = BufFileWrite(file, (void *) tuple, tuple->t_len);
+	if (written != tuple->t_len)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not write to hash-aggregate temporary file: %m")));
+
+	spill->ntuples[partition]++;
+	aggstate->hash_disk_used += sizeof(uint32) + tuple->t_len;
+
+	if (shouldFree)
+		pfree(tuple);
+}
+
+/*
+ * Turn the partitions of a grouping set's spill into batches to be
+ * processed later.
+ */
+static void
+hashagg_spill_finish(AggState *aggstate, HashAggSpill *spill, int setno)
+{
+	MemoryContext oldcontext;
+	int			i;
+
+	oldcontext = MemoryContextSwitchTo(aggstate->ss.ps.state->es_query_cxt);
+
+	for (i = 0; i < spill->npartitions; i++)
+	{
+		BufFile    *file = spill->partitions[i];
+		HashAggBatch *batch;
+
+		if (file == NULL)
+			continue;
+
+		if (BufFileSeek(file, 0, 0L, SEEK_SET))
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not rewind hash-aggregate temporary file: %m")));
+
+		batch = (HashAggBatch *) palloc(sizeof(HashAggBatch));
+		batch->setno = setno;
+		batch->used_bits = spill->used_bits;
+		batch->input_file = file;
+		batch->input_tuples = spill->ntuples[i];
+
+		/*
+		 * Assume the groups were spread evenly over the partitions; a batch
+		 * can't hold more groups than tuples, in any case.
+		 */
+		batch->input_groups = spill->input_groups / spill->npartitions;
+		if (batch->input_groups > (double) batch->input_tuples)
+			batch->input_groups = (double) batch->input_tuples;
+
+		aggstate->hash_batches = lcons(batch, aggstate->hash_batches);
+	}
+
+	MemoryContextSwitchTo(oldcontext);
+
+	pfree(spill->partitions);
+	pfree(spill->ntuples);
+	spill->partitions = NULL;
+	spill->ntuples = NULL;
+	spill->npartitions = 0;
+}
+
+/*
+ * Called once all input has been read in the first pass: record the
+ * tuples spilled for each grouping set as batches, and leave spill mode.
+ */
+static void
+hashagg_finish_initial_spills(AggState *aggstate)
+{
+	int			setno;
+
+	hash_agg_update_metrics(aggstate);
+	aggstate->hash_batches_used = 1;
+
+	if (aggstate->hash_spills != NULL)
+	{
+		for (setno = 0; setno < aggstate->num_hashes; setno++)
+		{
+			HashAggSpill *spill = &aggstate->hash_spills[setno];
+
+			if (spill->partitions != NULL)
+				hashagg_spill_finish(aggstate, spill, setno);
+		}
+
+		pfree(aggstate->hash_spills);
+		aggstate->hash_spills = NULL;
+	}
+
+	aggstate->hash_spill_mode = false;
+}
+
+/*
+ * Read the next tuple from a batch file.  Returns NULL at the end of the
+ * file; otherwise *hashp is set to the tuple's hash value.
+ */
+static MinimalTuple
+hashagg_batch_read(HashAggBatch *batch, uint32 *hashp)
+{
+	uint32		header[2];
+	size_t		nread;
+	MinimalTuple tuple;
+
+	/*
+	 * Since both the hash value and the MinimalTuple length word are uint32,
+	 * we can read them both in one BufFileRead() call without any type
+	 * cheating.
+	 */
+	nread = BufFileRead(batch->input_file, (void *) header, sizeof(header));
+	if (nread == 0)				/* end of file */
+		return NULL;
+	if (nread != sizeof(header))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from hash-aggregate temporary file: %m")));
+	*hashp = header[0];
+	tuple = (MinimalTuple) palloc(header[1]);
+	tuple->t_len = header[1];
+	nread = BufFileRead(batch->input_file,
+						(void *) ((char *) tuple + sizeof(uint32)),
+						header[1] - sizeof(uint32));
+	if (nread != header[1] - sizeof(uint32))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from hash-aggregate temporary file: %m")));
+
+	return tuple;
+}
+
+/*
+ * Empty the hash tables and aggregate the next spilled batch into the hash
+ * table of its grouping set, spilling again whatever doesn't fit.  Returns
+ * false if there are no batches left.
+ */
+static bool
+agg_refill_hash_table(AggState *aggstate)
+{
+	HashAggBatch *batch;
+	AggStatePerPhase savephase = aggstate->phase;
+	AggStatePerHash perhash;
+	HashAggSpill spill;
+	bool		spill_initialized = false;
+	int			setno;
+
+	if (aggstate->hash_batches == NIL)
+		return false;
+
+	batch = (HashAggBatch *) linitial(aggstate->hash_batches);
+	aggstate->hash_batches = list_delete_first(aggstate->hash_batches);
+
+	/*
+	 * Free the memory of all hash tables, and rebuild only the one we need.
+	 * The others won't be looked at again.
+	 */
+	ReScanExprContext(aggstate->hashcontext);
+	for (setno = 0; setno < aggstate->num_hashes; setno++)
+		aggstate->perhash[setno].hashtable = NULL;
+	build_hash_table(aggstate, batch->setno,
+					 hash_choose_num_buckets(aggstate, batch->input_groups));
+	aggstate->hash_ngroups_current = 0;
+	aggstate->hash_batches_used++;
+
+	/*
+	 * Each batch only processes one grouping set; set the rest to NULL so
+	 * that advance_aggregates() skips them.
+	 */
+	MemSet(aggstate->hash_pergroup, 0,
+		   sizeof(AggStatePerGroup) * aggstate->num_hashes);
+
+	/* In AGG_MIXED mode, the hashed grouping sets are advanced in phase 1 */
+	if (aggstate->aggstrategy == AGG_MIXED)
+		aggstate->phase = &aggstate->phases[1];
+	hashagg_recompile_expressions(aggstate, true, true);
+
+	select_current_set(aggstate, batch->setno, true);
+	perhash = &aggstate->perhash[batch->setno];
+
+	for (;;)
+	{
+		TupleTableSlot *spillslot = aggstate->hash_spill_rslot;
+		TupleHashEntryData *entry;
+		MinimalTuple tuple;
+		uint32		hash;
+
+		CHECK_FOR_INTERRUPTS();
+
+		tuple = hashagg_batch_read(batch, &hash);
+		if (tuple == NULL)
+			break;
+
+		ExecStoreMinimalTuple(tuple, spillslot, true);
+		aggstate->tmpcontext->ecxt_outertuple = spillslot;
+
+		prepare_hash_slot(aggstate);
+		entry = lookup_hash_entry(aggstate, hash);
+
+		if (entry != NULL)
+		{
+			aggstate->hash_pergroup[batch->setno] = entry->additional;
+			advance_aggregates(aggstate);
+		}
+		else
+		{
+			/* no memory for a new group, spill it again */
+			if (!spill_initialized)
+			{
+				hashagg_spill_init(aggstate, &spill, batch->used_bits,
+								   batch->input_groups);
+				spill_initialized = true;
+			}
+			hashagg_spill_tuple(aggstate, &spill, spillslot, hash);
+		}
+
+		/*
+		 * Reset per-input-tuple context after each tuple, but note that the
+		 * hash lookups do this too
+		 */
+		ResetExprContext(aggstate->tmpcontext);
+	}
+
+	ExecClearTuple(aggstate->hash_spill_rslot);
+	BufFileClose(batch->input_file);
+	aggstate->phase = savephase;
+
+	if (spill_initialized)
+		hashagg_spill_finish(aggstate, &spill, batch->setno);
+	hash_agg_update_metrics(aggstate);
+	aggstate->hash_spill_mode = false;
+
+	/* prepare to walk the hash table */
+	ResetTupleHashIterator(perhash->hashtable, &perhash->hashiter);
+
+	pfree(batch);
+
+	return true;
+}
+
+/*
+ * Release all spill files and forget about spilling, so that the hash tables
+ * can be filled afresh.
+ */
+static void
+hashagg_reset_spill_state(AggState *aggstate)
+{
+	ListCell   *lc;
+	int			i;
+
+	if (aggstate->hash_spills != NULL)
+	{
+		int			setno;
+
+		for (setno = 0; setno < aggstate->num_hashes; setno++)
+		{
+			HashAggSpill *spill = &aggstate->hash_spills[setno];
+
+			for (i = 0; i < spill->npartitions; i++)
+			{
+				if (spill->partitions[i] != NULL)
+					BufFileClose(spill->partitions[i]);
+			}
+		}
+		pfree(aggstate->hash_spills);
+		aggstate->hash_spills = NULL;
+	}
+
+	foreach(lc, aggstate->hash_batches)
+	{
+		HashAggBatch *batch = (HashAggBatch *) lfirst(lc);
+
+		BufFileClose(batch->input_file);
+	}
+	list_free_deep(aggstate->hash_batches);
+	aggstate->hash_batches = NIL;
+
+	aggstate->hash_spill_mode = false;
+	aggstate->hash_ever_spilled = false;
+	aggstate->hash_ngroups_current = 0;
+	aggstate->hash_batches_used = 0;
+
+	/* go back to the transition expressions we started with */
+	for (i = 0; i < Min(aggstate->numphases, 2); i++)
+	{
+		AggStatePerPhase phase = &aggstate->phases[i];
+
+		if (phase->evaltrans_cache[0][0] != NULL)
+			phase->evaltrans = phase->evaltrans_cache[0][0];
+	}
+}
+
 /* -----------------
  * ExecInitAgg
  *
@@ -2126,6 +2788,15 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 	aggstate->grp_firstTuple = NULL;
 	aggstate->sort_in = NULL;
 	aggstate->sort_out = NULL;
+	aggstate->hash_spill_mode = false;
+	aggstate->hash_ever_spilled = false;
+	aggstate->hash_mem_limit = work_mem * 1024L;
+	aggstate->hash_ngroups_current = 0;
+	aggstate->hash_spills = NULL;
+	aggstate->hash_batches = NIL;
+	aggstate->hash_batches_used = 0;
+	aggstate->hash_mem_peak = 0;
+	aggstate->hash_disk_used = 0;
 
 	/*
 	 * phases[0] always exists, but is dummy in sorted/plain mode
@@ -2217,6 +2888,9 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 	if (node->chain)
 		aggstate->sort_slot = ExecInitExtraTupleSlot(estate, scanDesc,
 													 &TTSOpsMinimalTuple);
+	if (use_hashing)
+		aggstate->hash_spill_rslot = ExecInitExtraTupleSlot(estate, scanDesc,
+															&TTSOpsMinimalTuple);
 
 	/*
 	 * Initialize result type, slot and projection.
@@ -2445,7 +3119,18 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 		aggstate->hash_pergroup = pergroups;
 
 		find_hash_columns(aggstate);
-		build_hash_table(aggstate);
+
+		/*
+		 * Initial estimate of the memory needed per group, using the same
+		 * formula as the planner; it is revised once groups have been
+		 * created.
+		 */
+		aggstate->hashentrysize =
+			MAXALIGN(outerPlan->plan_width) +
+			MAXALIGN(SizeofMinimalTupleHeader) +
+			hash_agg_entry_size(numaggs);
+
+		build_hash_tables(aggstate);
 		aggstate->table_filled = false;
 	}
 
@@ -2851,7 +3536,9 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 		else
 			Assert(false);
 
-		phase->evaltrans = ExecBuildAggTrans(aggstate, phase, dosort, dohash);
+		phase->evaltrans = ExecBuildAggTrans(aggstate, phase, dosort, dohash,
+											 false);
+		phase->evaltrans_cache[0][0] = phase->evaltrans;
 
 	}
 
@@ -3322,6 +4009,10 @@ ExecEndAgg(AggState *node)
 	if (node->sort_out)
 		tuplesort_end(node->sort_out);
 
+	/* ... and any spill files of hashed aggregation */
+	if (node->aggstrategy == AGG_HASHED || node->aggstrategy == AGG_MIXED)
+		hashagg_reset_spill_state(node);
+
 	for (transno = 0; transno < node->numtrans; transno++)
 	{
 		AggStatePerTrans pertrans = &node->pertrans[transno];
@@ -3382,7 +4073,7 @@ ExecReScanAgg(AggState *node)
 		 * input expressions of the aggregated functions, then we can just
 		 * rescan the existing hash table; no need to build it again.
 		 */
-		if (outerPlan->chgParam == NULL &&
+		if (outerPlan->chgParam == NULL && !node->hash_ever_spilled &&
 			!bms_overlap(node->ss.ps.chgParam, aggnode->aggParams))
 		{
 			ResetTupleHashIterator(node->perhash[0].hashtable,
@@ -3439,9 +4130,11 @@ ExecReScanAgg(AggState *node)
 	 */
 	if (node->aggstrategy == AGG_HASHED || node->aggstrategy == AGG_MIXED)
 	{
+		hashagg_reset_spill_state(node);
+
 		ReScanExprContext(node->hashcontext);
 		/* Rebuild an empty hash table */
-		build_hash_table(node);
+		build_hash_tables(node);
 		node->table_filled = false;
 		/* iterator will be reset when the table is filled */
 	}
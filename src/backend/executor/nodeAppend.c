@@ -60,6 +60,7 @@
 #include "executor/execdebug.h"
 #include "executor/execPartition.h"
 #include "executor/nodeAppend.h"
+#include "executor/nodeForeignscan.h"
 #include "miscadmin.h"
 
 /* Shared state for parallel-aware Append. */
@@ -85,6 +86,7 @@ static bool choose_next_subplan_locally(AppendState *node);
 static bool choose_next_subplan_for_leader(AppendState *node);
 static bool choose_next_subplan_for_worker(AppendState *node);
 static void mark_invalid_subplans_as_finished(AppendState *node);
+static void ExecAppendAsyncRequest(AppendState *node);
 
 /* ----------------------------------------------------------------
  *		ExecInitAppend
@@ -480,6 +482,8 @@ choose_next_subplan_locally(AppendState *node)
 			node->as_valid_subplans =
 				ExecFindMatchingSubPlans(node->as_prune_state);
 
+		ExecAppendAsyncRequest(node);
+
 		whichplan = -1;
 	}
 
@@ -734,3 +738,32 @@ mark_invalid_subplans_as_finished(AppendState *node)
 			node->as_pstate->pa_finished[i] = true;
 	}
 }
+
+/* ----------------------------------------------------------------
+ *		ExecAppendAsyncRequest
+ *
+ *		Before we start pulling tuples from the first subplan, let
+ *		every foreign scan among the valid subplans start fetching
+ *		in the background.  If the subplans are foreign tables on
+ *		several remote servers, the remote queries then run
+ *		concurrently, rather than each one only once we get to it.
+ * ----------------------------------------------------------------
+ */
+static void
+ExecAppendAsyncRequest(AppendState *node)
+{
+	int			i;
+
+	/* Nothing to overlap if there is only one subplan */
+	if (bms_membership(node->as_valid_subplans) != BMS_MULTIPLE)
+		return;
+
+	i = -1;
+	while ((i = bms_next_member(node->as_valid_subplans, i)) >= 0)
+	{
+		PlanState  *subnode = node->appendplans[i];
+
+		if (IsA(subnode, ForeignScanState))
+			ExecAsyncForeignScanRequest((ForeignScanState *) subnode);
+	}
+}
@@ -55,6 +55,8 @@
 
 static TupleTableSlot *BitmapHeapNext(BitmapHeapScanState *node);
 static void bitgetpage(HeapScanDesc scan, TBMIterateResult *tbmres);
+static TIDBitmap *BitmapParallelBuild(BitmapHeapScanState *node);
+static bool BitmapQualIsParallelAware(Plan *plan);
 static inline void BitmapDoneInitializingSharedState(
 								  ParallelBitmapHeapState *pstate);
 static inline void BitmapAdjustPrefetchIterator(BitmapHeapScanState *node,
@@ -138,14 +140,23 @@ BitmapHeapNext(BitmapHeapScanState *node)
 			/*
 			 * The leader will immediately come out of the function, but
 			 * others will be blocked until leader populates the TBM and wakes
-			 * them up.
+			 * them up.  With a parallel build, everyone who arrives in time
+			 * helps to populate it, and the last of those to finish gets to
+			 * initialize the shared state.
 			 */
-			if (BitmapShouldInitializeSharedState(pstate))
+			if (node->parallel_build)
+				tbm = BitmapParallelBuild(node);
+			else if (BitmapShouldInitializeSharedState(pstate))
 			{
 				tbm = (TIDBitmap *) MultiExecProcNode(outerPlanState(node));
 				if (!tbm || !IsA(tbm, TIDBitmap))
 					elog(ERROR, "unrecognized result from subplan");
+			}
+			else
+				tbm = NULL;
 
+			if (tbm)
+			{
 				node->tbm = tbm;
 
 				/*
@@ -881,6 +892,8 @@ ExecInitBitmapHeapScan(BitmapHeapScan *node, EState *estate, int eflags)
 	scanstate->shared_tbmiterator = NULL;
 	scanstate->shared_prefetch_iterator = NULL;
 	scanstate->pstate = NULL;
+	scanstate->parallel_build = node->scan.plan.parallel_aware &&
+		BitmapQualIsParallelAware(outerPlan(node));
 
 	/*
 	 * We can potentially skip fetching heap pages if we do not need any
@@ -999,6 +1012,121 @@ BitmapShouldInitializeSharedState(ParallelBitmapHeapState *pstate)
 	return (state == BM_INITIAL);
 }
 
+/* ----------------
+ *	BitmapParallelBuild - Build the shared TIDBitmap in parallel
+ *
+ *		If the bitmap isn't being merged yet, build a bitmap from our share
+ *		of the parallel index scans and hand it over in the shared state.
+ *		The last process to finish merges all of them into one TIDBitmap in
+ *		the DSA area and returns it; it must then initialize the shared
+ *		iteration state.  Everyone else waits until that is done, then
+ *		returns NULL.
+ *
+ *		Since the merged bitmap is subject to work_mem, the decision to make
+ *		pages lossy is made once for the whole scan rather than separately
+ *		in each process.
+ * ---------------
+ */
+static TIDBitmap *
+BitmapParallelBuild(BitmapHeapScanState *node)
+{
+	ParallelBitmapHeapState *pstate = node->pstate;
+	dsa_area   *dsa = node->ss.ps.state->es_query_dsa;
+	bool		build = false;
+	bool		merge = false;
+
+	SpinLockAcquire(&pstate->mutex);
+	if ((pstate->state == BM_INITIAL || pstate->state == BM_INPROGRESS) &&
+		pstate->nbuilders < pstate->maxbuilders)
+	{
+		pstate->state = BM_INPROGRESS;
+		pstate->nbuilders++;
+		build = true;
+	}
+	SpinLockRelease(&pstate->mutex);
+
+	if (build)
+	{
+		TIDBitmap  *tbm;
+		dsa_pointer exported;
+		dsa_pointer *partial_bitmaps;
+
+		tbm = (TIDBitmap *) MultiExecProcNode(outerPlanState(node));
+		if (!tbm || !IsA(tbm, TIDBitmap))
+			elog(ERROR, "unrecognized result from subplan");
+
+		exported = tbm_export(tbm, dsa);
+		tbm_free(tbm);
+
+		partial_bitmaps = dsa_get_address(dsa, pstate->partial_bitmaps);
+
+		SpinLockAcquire(&pstate->mutex);
+		partial_bitmaps[pstate->nbuilt++] = exported;
+		if (pstate->nbuilt == pstate->nbuilders)
+		{
+			pstate->state = BM_MERGING;
+			merge = true;
+		}
+		SpinLockRelease(&pstate->mutex);
+	}
+
+	if (merge)
+	{
+		TIDBitmap  *tbm;
+		dsa_pointer *partial_bitmaps;
+		int			i;
+
+		/*
+		 * Nobody can add to partial_bitmaps any more, so it's safe to read it
+		 * without the spinlock.
+		 */
+		partial_bitmaps = dsa_get_address(dsa, pstate->partial_bitmaps);
+		tbm = tbm_create(work_mem * 1024L, dsa);
+		for (i = 0; i < pstate->nbuilt; i++)
+		{
+			CHECK_FOR_INTERRUPTS();
+			tbm_union_exported(tbm, dsa, partial_bitmaps[i]);
+			partial_bitmaps[i] = InvalidDsaPointer;
+		}
+
+		return tbm;
+	}
+
+	/* Wait for the merged bitmap to be ready. */
+	for (;;)
+	{
+		SharedBitmapState state;
+
+		SpinLockAcquire(&pstate->mutex);
+		state = pstate->state;
+		SpinLockRelease(&pstate->mutex);
+
+		if (state == BM_FINISHED)
+			break;
+
+		ConditionVariableSleep(&pstate->cv, WAIT_EVENT_PARALLEL_BITMAP_SCAN);
+	}
+	ConditionVariableCancelSleep();
+
+	return NULL;
+}
+
+/*
+ * BitmapQualIsParallelAware
+ *		Are the index scans below a BitmapHeapScan parallel-aware?
+ *
+ * The planner marks either all of them or none, and only ever below a
+ * BitmapOr, so looking at the first one is enough.
+ */
+static bool
+BitmapQualIsParallelAware(Plan *plan)
+{
+	if (IsA(plan, BitmapOr))
+		return BitmapQualIsParallelAware(linitial(((BitmapOr *) plan)->bitmapplans));
+
+	return IsA(plan, BitmapIndexScan) && plan->parallel_aware;
+}
+
 /* ----------------------------------------------------------------
  *		ExecBitmapHeapEstimate
  *
@@ -1049,6 +1177,18 @@ ExecBitmapHeapInitializeDSM(BitmapHeapScanState *node,
 	pstate->prefetch_target = 0;
 	pstate->state = BM_INITIAL;
 
+	/* With a parallel build, the leader and each worker may add a bitmap */
+	pstate->nbuilders = 0;
+	pstate->nbuilt = 0;
+	pstate->maxbuilders = 0;
+	pstate->partial_bitmaps = InvalidDsaPointer;
+	if (node->parallel_build)
+	{
+		pstate->maxbuilders = pcxt->nworkers + 1;
+		pstate->partial_bitmaps =
+			dsa_allocate(dsa, pstate->maxbuilders * sizeof(dsa_pointer));
+	}
+
 	ConditionVariableInit(&pstate->cv);
 	SerializeSnapshot(estate->es_snapshot, pstate->phs_snapshot_data);
 
@@ -1074,6 +1214,8 @@ ExecBitmapHeapReInitializeDSM(BitmapHeapScanState *node,
 		return;
 
 	pstate->state = BM_INITIAL;
+	pstate->nbuilders = 0;
+	pstate->nbuilt = 0;
 
 	if (DsaPointerIsValid(pstate->tbmiterator))
 		tbm_free_shared_area(dsa, pstate->tbmiterator);
@@ -18,9 +18,18 @@
  *		ExecInitBitmapIndexScan		creates and initializes state info.
  *		ExecReScanBitmapIndexScan	prepares to rescan the plan.
  *		ExecEndBitmapIndexScan		releases all storage.
+ *		ExecBitmapIndexScanEstimate	estimates DSM space needed for
+ *						parallel bitmap index scan
+ *		ExecBitmapIndexScanInitializeDSM initialize DSM for parallel
+ *						bitmap index scan
+ *		ExecBitmapIndexScanReInitializeDSM reinitialize DSM for fresh scan
+ *		ExecBitmapIndexScanInitializeWorker attach to DSM info in parallel
+ *						worker
  */
 #include "postgres.h"
 
+#include "access/genam.h"
+#include "access/relscan.h"
 #include "executor/execdebug.h"
 #include "executor/nodeBitmapIndexscan.h"
 #include "executor/nodeIndexscan.h"
@@ -57,11 +66,6 @@ MultiExecBitmapIndexScan(BitmapIndexScanState *node)
 	if (node->ss.ps.instrument)
 		InstrStartNode(node->ss.ps.instrument);
 
-	/*
-	 * extract necessary information from index scan node
-	 */
-	scandesc = node->biss_ScanDesc;
-
 	/*
 	 * If we have runtime keys and they've not already been set up, do it now.
 	 * Array keys are also treated as runtime keys; note that if ExecReScan
@@ -77,6 +81,28 @@ MultiExecBitmapIndexScan(BitmapIndexScanState *node)
 	else
 		doscan = true;
 
+	/*
+	 * A parallel-aware scan gets its scan descriptor when the parallel
+	 * context is set up.  If that didn't happen because no workers could be
+	 * used, just scan the whole index here.
+	 */
+	if (node->biss_ScanDesc == NULL)
+	{
+		node->biss_ScanDesc =
+			index_beginscan_bitmap(node->biss_RelationDesc,
+								   node->ss.ps.state->es_snapshot,
+								   node->biss_NumScanKeys);
+		if (doscan)
+			index_rescan(node->biss_ScanDesc,
+						 node->biss_ScanKeys, node->biss_NumScanKeys,
+						 NULL, 0);
+	}
+
+	/*
+	 * extract necessary information from index scan node
+	 */
+	scandesc = node->biss_ScanDesc;
+
 	/*
 	 * Prepare the result bitmap.  Normally we just create a new one to pass
 	 * back; however, our parent node is allowed to store a pre-made one into
@@ -161,7 +187,7 @@ ExecReScanBitmapIndexScan(BitmapIndexScanState *node)
 		node->biss_RuntimeKeysReady = true;
 
 	/* reset index scan */
-	if (node->biss_RuntimeKeysReady)
+	if (node->biss_RuntimeKeysReady && node->biss_ScanDesc)
 		index_rescan(node->biss_ScanDesc,
 					 node->biss_ScanKeys, node->biss_NumScanKeys,
 					 NULL, 0);
@@ -312,25 +338,148 @@ ExecInitBitmapIndexScan(BitmapIndexScan *node, EState *estate, int eflags)
 	}
 
 	/*
-	 * Initialize scan descriptor.
+	 * Initialize scan descriptor.  For a parallel-aware scan, that's done in
+	 * ExecBitmapIndexScanInitializeDSM or ExecBitmapIndexScanInitializeWorker
+	 * instead.
 	 */
-	indexstate->biss_ScanDesc =
-		index_beginscan_bitmap(indexstate->biss_RelationDesc,
-							   estate->es_snapshot,
-							   indexstate->biss_NumScanKeys);
+	if (!node->scan.plan.parallel_aware)
+	{
+		indexstate->biss_ScanDesc =
+			index_beginscan_bitmap(indexstate->biss_RelationDesc,
+								   estate->es_snapshot,
+								   indexstate->biss_NumScanKeys);
+
+		/*
+		 * If no run-time keys to calculate, go ahead and pass the scankeys to
+		 * the index AM.
+		 */
+		if (indexstate->biss_NumRuntimeKeys == 0 &&
+			indexstate->biss_NumArrayKeys == 0)
+			index_rescan(indexstate->biss_ScanDesc,
+						 indexstate->biss_ScanKeys, indexstate->biss_NumScanKeys,
+						 NULL, 0);
+	}
 
 	/*
-	 * If no run-time keys to calculate, go ahead and pass the scankeys to the
-	 * index AM.
+	 * all done.
 	 */
-	if (indexstate->biss_NumRuntimeKeys == 0 &&
-		indexstate->biss_NumArrayKeys == 0)
-		index_rescan(indexstate->biss_ScanDesc,
-					 indexstate->biss_ScanKeys, indexstate->biss_NumScanKeys,
+	return indexstate;
+}
+
+/* ----------------------------------------------------------------
+ *						Parallel Scan Support
+ *
+ * A parallel-aware bitmap index scan appears only below a parallel bitmap
+ * heap scan whose participants build the bitmap together.  Each participant
+ * gets the TIDs of its own share of the index, and the BitmapHeapScan node
+ * merges the resulting bitmaps.
+ * ----------------------------------------------------------------
+ */
+
+/* ----------------------------------------------------------------
+ *		ExecBitmapIndexScanEstimate
+ *
+ *		Compute the amount of space we'll need in the parallel
+ *		query DSM, and inform pcxt->estimator about our needs.
+ * ----------------------------------------------------------------
+ */
+void
+ExecBitmapIndexScanEstimate(BitmapIndexScanState *node,
+							ParallelContext *pcxt)
+{
+	EState	   *estate = node->ss.ps.state;
+
+	node->biss_PscanLen = index_parallelscan_estimate(node->biss_RelationDesc,
+													  estate->es_snapshot);
+	shm_toc_estimate_chunk(&pcxt->estimator, node->biss_PscanLen);
+	shm_toc_estimate_keys(&pcxt->estimator, 1);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecBitmapIndexScanInitializeDSM
+ *
+ *		Set up a parallel index scan descriptor.
+ * ----------------------------------------------------------------
+ */
+void
+ExecBitmapIndexScanInitializeDSM(BitmapIndexScanState *node,
+								 ParallelContext *pcxt)
+{
+	EState	   *estate = node->ss.ps.state;
+	Index		scanrelid = ((Scan *) node->ss.ps.plan)->scanrelid;
+	ParallelIndexScanDesc piscan;
+
+	/*
+	 * If there's no DSA, there are no workers, and the parent bitmap heap
+	 * scan won't merge bitmaps either; leave it to MultiExecBitmapIndexScan
+	 * to scan the whole index.
+	 */
+	if (estate->es_query_dsa == NULL)
+		return;
+
+	Assert(node->biss_ScanDesc == NULL);
+
+	piscan = shm_toc_allocate(pcxt->toc, node->biss_PscanLen);
+	index_parallelscan_initialize(ExecGetRangeTableRelation(estate, scanrelid),
+								  node->biss_RelationDesc,
+								  estate->es_snapshot,
+								  piscan);
+	shm_toc_insert(pcxt->toc, node->ss.ps.plan->plan_node_id, piscan);
+	node->biss_ScanDesc =
+		index_beginscan_bitmap_parallel(node->biss_RelationDesc,
+										node->biss_NumScanKeys,
+										piscan);
+
+	/*
+	 * If no run-time keys to calculate or they are ready, go ahead and pass
+	 * the scankeys to the index AM.
+	 */
+	if ((node->biss_NumRuntimeKeys == 0 && node->biss_NumArrayKeys == 0) ||
+		node->biss_RuntimeKeysReady)
+		index_rescan(node->biss_ScanDesc,
+					 node->biss_ScanKeys, node->biss_NumScanKeys,
 					 NULL, 0);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecBitmapIndexScanReInitializeDSM
+ *
+ *		Reset shared state before beginning a fresh scan.
+ * ----------------------------------------------------------------
+ */
+void
+ExecBitmapIndexScanReInitializeDSM(BitmapIndexScanState *node,
+								   ParallelContext *pcxt)
+{
+	if (node->biss_ScanDesc && node->biss_ScanDesc->parallel_scan)
+		index_parallelrescan(node->biss_ScanDesc);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecBitmapIndexScanInitializeWorker
+ *
+ *		Copy relevant information from TOC into planstate.
+ * ----------------------------------------------------------------
+ */
+void
+ExecBitmapIndexScanInitializeWorker(BitmapIndexScanState *node,
+									ParallelWorkerContext *pwcxt)
+{
+	ParallelIndexScanDesc piscan;
+
+	piscan = shm_toc_lookup(pwcxt->toc, node->ss.ps.plan->plan_node_id, false);
+	node->biss_ScanDesc =
+		index_beginscan_bitmap_parallel(node->biss_RelationDesc,
+										node->biss_NumScanKeys,
+										piscan);
 
 	/*
-	 * all done.
+	 * If no run-time keys to calculate or they are ready, go ahead and pass
+	 * the scankeys to the index AM.
 	 */
-	return indexstate;
+	if ((node->biss_NumRuntimeKeys == 0 && node->biss_NumArrayKeys == 0) ||
+		node->biss_RuntimeKeysReady)
+		index_rescan(node->biss_ScanDesc,
+					 node->biss_ScanKeys, node->biss_NumScanKeys,
+					 NULL, 0);
 }
@@ -15,10 +15,25 @@
 
 #include "postgres.h"
 
+#include "access/htup_details.h"
 #include "executor/execdebug.h"
 #include "executor/nodeCtescan.h"
 #include "miscadmin.h"
 
+/*
+ * Shared state of a parallel CTE scan, in the DSM segment: the file set
+ * holding the leader's copy of the CTE rows, followed by the shared
+ * tuplestore through which all participants read them.
+ */
+typedef struct ParallelCteScanState
+{
+	SharedFileSet fileset;
+} ParallelCteScanState;
+
+#define ParallelCteScanTuplestore(pstate)	\
+	((SharedTuplestore *) ((char *) (pstate) + \
+						   MAXALIGN(sizeof(ParallelCteScanState))))
+
 static TupleTableSlot *CteScanNext(CteScanState *node);
 
 /* ----------------------------------------------------------------
@@ -37,6 +52,20 @@ CteScanNext(CteScanState *node)
 	bool		eof_tuplestore;
 	TupleTableSlot *slot;
 
+	/*
+	 * In a parallel scan, each participant gets whatever rows it can grab
+	 * from the shared tuplestore.
+	 */
+	if (node->sts != NULL)
+	{
+		MinimalTuple tuple = sts_parallel_scan_next(node->sts, NULL);
+
+		slot = node->ss.ss_ScanTupleSlot;
+		if (tuple == NULL)
+			return ExecClearTuple(slot);
+		return ExecStoreMinimalTuple(tuple, slot, false);
+	}
+
 	/*
 	 * get state info from node
 	 */
@@ -176,6 +205,7 @@ ExecInitCteScan(CteScan *node, EState *estate, int eflags)
 {
 	CteScanState *scanstate;
 	ParamExecData *prmdata;
+	TupleDesc	scandesc;
 
 	/* check for unsupported flags */
 	Assert(!(eflags & EXEC_FLAG_MARK));
@@ -210,6 +240,27 @@ ExecInitCteScan(CteScan *node, EState *estate, int eflags)
 	scanstate->eflags = eflags;
 	scanstate->cte_table = NULL;
 	scanstate->eof_cte = false;
+	scanstate->sts = NULL;
+
+	if (IsParallelWorker())
+	{
+		RangeTblEntry *rte = exec_rt_fetch(node->scan.scanrelid, estate);
+
+		/*
+		 * In a worker, we can only be a parallel CTE scan, which reads the
+		 * rows the leader put in the shared tuplestore; the CTE query itself
+		 * never runs here, and may not even be available.  Take the row type
+		 * from the RTE, since we have no plan to get it from.
+		 */
+		Assert(node->scan.plan.parallel_aware);
+		scanstate->cteplanstate = NULL;
+		scanstate->leader = scanstate;
+		scandesc = BuildDescFromLists(rte->eref->colnames,
+									  rte->coltypes,
+									  rte->coltypmods,
+									  rte->colcollations);
+		goto init_scan;
+	}
 
 	/*
 	 * Find the already-initialized plan for the CTE query.
@@ -248,6 +299,14 @@ ExecInitCteScan(CteScan *node, EState *estate, int eflags)
 		tuplestore_rescan(scanstate->leader->cte_table);
 	}
 
+	/*
+	 * The scan tuple type (ie, the rowtype we expect to find in the work
+	 * table) is the same as the result rowtype of the CTE query.
+	 */
+	scandesc = ExecGetResultType(scanstate->cteplanstate);
+
+init_scan:
+
 	/*
 	 * Miscellaneous initialization
 	 *
@@ -255,12 +314,7 @@ ExecInitCteScan(CteScan *node, EState *estate, int eflags)
 	 */
 	ExecAssignExprContext(estate, &scanstate->ss.ps);
 
-	/*
-	 * The scan tuple type (ie, the rowtype we expect to find in the work
-	 * table) is the same as the result rowtype of the CTE query.
-	 */
-	ExecInitScanTupleSlot(estate, &scanstate->ss,
-						  ExecGetResultType(scanstate->cteplanstate),
+	ExecInitScanTupleSlot(estate, &scanstate->ss, scandesc,
 						  &TTSOpsMinimalTuple);
 
 	/*
@@ -299,10 +353,15 @@ ExecEndCteScan(CteScanState *node)
 		ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
 	ExecClearTuple(node->ss.ss_ScanTupleSlot);
 
+	/* Close our read file of the shared tuplestore, if any */
+	if (node->sts != NULL)
+		sts_end_parallel_scan(node->sts);
+
 	/*
-	 * If I am the leader, free the tuplestore.
+	 * If I am the leader, free the tuplestore.  (In a parallel worker, there
+	 * is none.)
 	 */
-	if (node->leader == node)
+	if (node->leader == node && node->cte_table != NULL)
 	{
 		tuplestore_end(node->cte_table);
 		node->cte_table = NULL;
@@ -325,6 +384,13 @@ ExecReScanCteScan(CteScanState *node)
 
 	ExecScanReScan(&node->ss);
 
+	/*
+	 * A parallel scan is restarted by ExecCteScanReInitializeDSM instead,
+	 * and a worker has no tuplestore of its own.
+	 */
+	if (node->sts != NULL || node->cteplanstate == NULL)
+		return;
+
 	/*
 	 * Clear the tuplestore if a new scan of the underlying CTE is required.
 	 * This implicitly resets all the tuplestore's read pointers.  Note that
@@ -349,3 +415,130 @@ ExecReScanCteScan(CteScanState *node)
 		tuplestore_rescan(tuplestorestate);
 	}
 }
+
+/* ----------------------------------------------------------------
+ *						Parallel Scan Support
+ * ----------------------------------------------------------------
+ */
+
+/* ----------------------------------------------------------------
+ *		ExecCteScanEstimate
+ *
+ *		Compute the amount of space we'll need in the parallel
+ *		query DSM, and inform pcxt->estimator about our needs.
+ * ----------------------------------------------------------------
+ */
+void
+ExecCteScanEstimate(CteScanState *node, ParallelContext *pcxt)
+{
+	shm_toc_estimate_chunk(&pcxt->estimator,
+						   add_size(MAXALIGN(sizeof(ParallelCteScanState)),
+									sts_estimate(pcxt->nworkers + 1)));
+	shm_toc_estimate_keys(&pcxt->estimator, 1);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecCteScanInitializeDSM
+ *
+ *		Read the whole CTE into a shared tuplestore, for the workers
+ *		and ourselves to scan in parallel.
+ *
+ * This happens before the workers are launched, so they can begin reading
+ * as soon as they attach.  Without a DSM segment, there won't be any
+ * workers, and we simply read the CTE as usual.
+ * ----------------------------------------------------------------
+ */
+void
+ExecCteScanInitializeDSM(CteScanState *node, ParallelContext *pcxt)
+{
+	ParallelCteScanState *pstate;
+	SharedTuplestoreAccessor *accessor;
+	Tuplestorestate *tuplestorestate = node->leader->cte_table;
+
+	/* Forget any tuplestore belonging to an earlier parallel context */
+	if (node->sts != NULL)
+	{
+		sts_end_parallel_scan(node->sts);
+		node->sts = NULL;
+	}
+
+	/* Start reading the CTE from the beginning */
+	tuplestore_select_read_pointer(tuplestorestate, node->readptr);
+	tuplestore_rescan(tuplestorestate);
+
+	if (pcxt->seg == NULL)
+		return;
+
+	pstate = shm_toc_allocate(pcxt->toc,
+							  add_size(MAXALIGN(sizeof(ParallelCteScanState)),
+									   sts_estimate(pcxt->nworkers + 1)));
+	SharedFileSetInit(&pstate->fileset, pcxt->seg);
+	accessor = sts_initialize(ParallelCteScanTuplestore(pstate),
+							  pcxt->nworkers + 1,
+							  0,	/* the leader's participant number */
+							  0,
+							  0,
+							  &pstate->fileset,
+							  "cte");
+
+	for (;;)
+	{
+		TupleTableSlot *slot = CteScanNext(node);
+		MinimalTuple tuple;
+		bool		shouldFree;
+
+		if (TupIsNull(slot))
+			break;
+		tuple = ExecFetchSlotMinimalTuple(slot, &shouldFree);
+		sts_puttuple(accessor, NULL, tuple);
+		if (shouldFree)
+			heap_free_minimal_tuple(tuple);
+
+		CHECK_FOR_INTERRUPTS();
+	}
+	ExecClearTuple(node->ss.ss_ScanTupleSlot);
+
+	sts_end_write(accessor);
+	sts_begin_parallel_scan(accessor);
+	node->sts = accessor;
+
+	shm_toc_insert(pcxt->toc, node->ss.ps.plan->plan_node_id, pstate);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecCteScanReInitializeDSM
+ *
+ *		Reset shared state before beginning a fresh scan.  The rows of
+ *		the CTE can't have changed (see set_rel_consider_parallel), so
+ *		we just read the same ones again.
+ * ----------------------------------------------------------------
+ */
+void
+ExecCteScanReInitializeDSM(CteScanState *node, ParallelContext *pcxt)
+{
+	if (node->sts == NULL)
+		return;
+
+	sts_reinitialize(node->sts);
+	sts_begin_parallel_scan(node->sts);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecCteScanInitializeWorker
+ *
+ *		Attach to the shared tuplestore the leader filled.
+ * ----------------------------------------------------------------
+ */
+void
+ExecCteScanInitializeWorker(CteScanState *node,
+							ParallelWorkerContext *pwcxt)
+{
+	ParallelCteScanState *pstate;
+
+	pstate = shm_toc_lookup(pwcxt->toc, node->ss.ps.plan->plan_node_id, false);
+	SharedFileSetAttach(&pstate->fileset, pwcxt->seg);
+	node->sts = sts_attach(ParallelCteScanTuplestore(pstate),
+						   ParallelWorkerNumber + 1,
+						   &pstate->fileset);
+	sts_begin_parallel_scan(node->sts);
+}
@@ -390,3 +390,23 @@ ExecShutdownForeignScan(ForeignScanState *node)
 	if (fdwroutine->ShutdownForeignScan)
 		fdwroutine->ShutdownForeignScan(node);
 }
+
+/* ----------------------------------------------------------------
+ *		ExecAsyncForeignScanRequest
+ *
+ *		Gives FDW chance to start producing the first tuples of the
+ *		scan in the background, before anyone asks for them.
+ * ----------------------------------------------------------------
+ */
+void
+ExecAsyncForeignScanRequest(ForeignScanState *node)
+{
+	FdwRoutine *fdwroutine = node->fdwroutine;
+
+	/*
+	 * If chgParam is set, the node will be rescanned by its first
+	 * ExecProcNode call, which would throw away anything requested now.
+	 */
+	if (fdwroutine->ForeignAsyncRequest && node->ss.ps.chgParam == NULL)
+		fdwroutine->ForeignAsyncRequest(node);
+}
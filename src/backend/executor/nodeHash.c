@@ -34,6 +34,7 @@
 #include "executor/hashjoin.h"
 #include "executor/nodeHash.h"
 #include "executor/nodeHashjoin.h"
+#include "lib/bloomfilter.h"
 #include "miscadmin.h"
 #include "pgstat.h"
 #include "port/atomics.h"
@@ -54,6 +55,9 @@ static void ExecHashSkewTableInsert(HashJoinTable hashtable,
 						uint32 hashvalue,
 						int bucketNumber);
 static void ExecHashRemoveNextSkewBucket(HashJoinTable hashtable);
+static bool ExecHashFindHotValue(HashJoinTable hashtable, uint32 *hashvalue);
+static int	ExecHashAddDetectedSkewBucket(HashJoinTable hashtable,
+							  uint32 hashvalue);
 
 static void *dense_alloc(HashJoinTable hashtable, Size size);
 static HashJoinTuple ExecParallelHashTupleAlloc(HashJoinTable hashtable,
@@ -143,6 +147,7 @@ MultiExecPrivateHash(HashState *node)
 	TupleTableSlot *slot;
 	ExprContext *econtext;
 	uint32		hashvalue;
+	bloom_filter *bloomfilter = NULL;
 
 	/*
 	 * get state info from node
@@ -156,6 +161,20 @@ MultiExecPrivateHash(HashState *node)
 	hashkeys = node->hashkeys;
 	econtext = node->ps.ps_ExprContext;
 
+	/*
+	 * If the parent join pushed a runtime filter into its outer scan, collect
+	 * the hash values of the inner tuples in a Bloom filter.  It covers all
+	 * batches, not only the one in memory.
+	 */
+	if (node->build_runtime_filter)
+	{
+		MemoryContext oldcxt = MemoryContextSwitchTo(hashtable->hashCxt);
+
+		bloomfilter = bloom_create((int64) Max(node->ps.plan->plan_rows, 1.0),
+								   work_mem, 0);
+		MemoryContextSwitchTo(oldcxt);
+	}
+
 	/*
 	 * get all inner tuples and insert into the hash table (or temp files)
 	 */
@@ -172,6 +191,10 @@ MultiExecPrivateHash(HashState *node)
 		{
 			int			bucketNumber;
 
+			if (bloomfilter != NULL)
+				bloom_add_element(bloomfilter, (unsigned char *) &hashvalue,
+								  sizeof(hashvalue));
+
 			bucketNumber = ExecHashGetSkewBucket(hashtable, hashvalue);
 			if (bucketNumber != INVALID_SKEW_BUCKET_NO)
 			{
@@ -189,6 +212,9 @@ MultiExecPrivateHash(HashState *node)
 		}
 	}
 
+	/* The filter can be used only now that it is complete */
+	hashtable->bloomfilter = bloomfilter;
+
 	/* resize the hash table if needed (NTUP_PER_BUCKET exceeded) */
 	if (hashtable->nbuckets != hashtable->nbuckets_optimal)
 		ExecHashIncreaseNumBuckets(hashtable);
@@ -498,12 +524,14 @@ ExecHashTableCreate(HashState *state, List *hashOperators, bool keepNulls)
 	hashtable->skewTuples = 0;
 	hashtable->innerBatchFile = NULL;
 	hashtable->outerBatchFile = NULL;
+	hashtable->bloomfilter = NULL;
 	hashtable->spaceUsed = 0;
 	hashtable->spacePeak = 0;
 	hashtable->spaceAllowed = space_allowed;
 	hashtable->spaceUsedSkew = 0;
 	hashtable->spaceAllowedSkew =
 		hashtable->spaceAllowed * SKEW_WORK_MEM_PERCENT / 100;
+	hashtable->spaceUsedDetected = 0;
 	hashtable->chunks = NULL;
 	hashtable->current_chunk = NULL;
 	hashtable->parallel_state = state->parallel_state;
@@ -887,7 +915,10 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 	MemoryContext oldcxt;
 	long		ninmemory;
 	long		nfreed;
+	long		npromoted;
 	HashMemoryChunk oldchunks;
+	uint32		hotvalue = 0;
+	int			hotbucket = INVALID_SKEW_BUCKET_NO;
 
 	/* do nothing if we've decided to shut off growth */
 	if (!hashtable->growEnabled)
@@ -934,11 +965,22 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 
 	hashtable->nbatch = nbatch;
 
+	/*
+	 * While building the first batch, check whether a single hash value
+	 * holds most of the tuples in memory.  Increasing nbatch can't split such
+	 * a group, so move its tuples to a skew bucket instead, as if the
+	 * planner's statistics had told us about it.  (In later batches the
+	 * outer tuples have already been sent to their batch files, so it's too
+	 * late for that.)
+	 */
+	if (curbatch == 0 && ExecHashFindHotValue(hashtable, &hotvalue))
+		hotbucket = ExecHashAddDetectedSkewBucket(hashtable, hotvalue);
+
 	/*
 	 * Scan through the existing hash table entries and dump out any that are
 	 * no longer of the current batch.
 	 */
-	ninmemory = nfreed = 0;
+	ninmemory = nfreed = npromoted = 0;
 
 	/* If know we need to resize nbuckets, we can do it while rebatching. */
 	if (hashtable->nbuckets_optimal != hashtable->nbuckets)
@@ -985,7 +1027,26 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 			ExecHashGetBucketAndBatch(hashtable, hashTuple->hashvalue,
 									  &bucketno, &batchno);
 
-			if (batchno == curbatch)
+			if (hotbucket != INVALID_SKEW_BUCKET_NO &&
+				hashTuple->hashvalue == hotvalue)
+			{
+				/* move it to the detected skew bucket */
+				HashSkewBucket *bucket = hashtable->skewBucket[hotbucket];
+				HashJoinTuple copyTuple;
+
+				copyTuple = (HashJoinTuple)
+					MemoryContextAlloc(hashtable->batchCxt, hashTupleSize);
+				memcpy(copyTuple, hashTuple, hashTupleSize);
+
+				copyTuple->next.unshared = bucket->tuples;
+				bucket->tuples = copyTuple;
+
+				/* still in use, but no longer counted against spaceAllowed */
+				hashtable->spaceAllowed += hashTupleSize;
+				hashtable->spaceUsedDetected += hashTupleSize;
+				npromoted++;
+			}
+			else if (batchno == curbatch)
 			{
 				/* keep tuple in memory - copy it into the new chunk */
 				HashJoinTuple copyTuple;
@@ -1022,19 +1083,22 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 	}
 
 #ifdef HJDEBUG
-	printf("Hashjoin %p: freed %ld of %ld tuples, space now %zu\n",
-		   hashtable, nfreed, ninmemory, hashtable->spaceUsed);
+	printf("Hashjoin %p: freed %ld of %ld tuples, moved %ld to skew bucket, space now %zu\n",
+		   hashtable, nfreed, ninmemory, npromoted, hashtable->spaceUsed);
 #endif
 
+	hashtable->skewTuples += npromoted;
+
 	/*
 	 * If we dumped out either all or none of the tuples in the table, disable
 	 * further expansion of nbatch.  This situation implies that we have
 	 * enough tuples of identical hashvalues to overflow spaceAllowed.
 	 * Increasing nbatch will not fix it since there's no way to subdivide the
 	 * group any more finely. We have to just gut it out and hope the server
-	 * has enough RAM.
+	 * has enough RAM.  That doesn't apply if we just set such a group aside
+	 * in a skew bucket, since what's left is likely to split normally.
 	 */
-	if (nfreed == 0 || nfreed == ninmemory)
+	if (npromoted == 0 && (nfreed == 0 || nfreed == ninmemory))
 	{
 		hashtable->growEnabled = false;
 #ifdef HJDEBUG
@@ -2330,6 +2394,7 @@ ExecHashBuildSkewHash(HashJoinTable hashtable, Hash *node, int mcvsToUse)
 								   sizeof(HashSkewBucket));
 			hashtable->skewBucket[bucket]->hashvalue = hashvalue;
 			hashtable->skewBucket[bucket]->tuples = NULL;
+			hashtable->skewBucket[bucket]->detected = false;
 			hashtable->skewBucketNums[hashtable->nSkewBuckets] = bucket;
 			hashtable->nSkewBuckets++;
 			hashtable->spaceUsed += SKEW_BUCKET_OVERHEAD;
@@ -2405,6 +2470,7 @@ ExecHashSkewTableInsert(HashJoinTable hashtable,
 {
 	bool		shouldFree;
 	MinimalTuple tuple = ExecFetchSlotMinimalTuple(slot, &shouldFree);
+	HashSkewBucket *bucket = hashtable->skewBucket[bucketNumber];
 	HashJoinTuple hashTuple;
 	int			hashTupleSize;
 
@@ -2417,16 +2483,26 @@ ExecHashSkewTableInsert(HashJoinTable hashtable,
 	HeapTupleHeaderClearMatch(HJTUPLE_MINTUPLE(hashTuple));
 
 	/* Push it onto the front of the skew bucket's list */
-	hashTuple->next.unshared = hashtable->skewBucket[bucketNumber]->tuples;
-	hashtable->skewBucket[bucketNumber]->tuples = hashTuple;
+	hashTuple->next.unshared = bucket->tuples;
+	bucket->tuples = hashTuple;
 	Assert(hashTuple != hashTuple->next.unshared);
 
-	/* Account for space used, and back off if we've used too much */
+	/*
+	 * Account for space used, and back off if we've used too much.  Detected
+	 * buckets are never removed, and don't count against either limit.
+	 */
 	hashtable->spaceUsed += hashTupleSize;
-	hashtable->spaceUsedSkew += hashTupleSize;
+	if (bucket->detected)
+	{
+		hashtable->spaceAllowed += hashTupleSize;
+		hashtable->spaceUsedDetected += hashTupleSize;
+	}
+	else
+		hashtable->spaceUsedSkew += hashTupleSize;
 	if (hashtable->spaceUsed > hashtable->spacePeak)
 		hashtable->spacePeak = hashtable->spaceUsed;
-	while (hashtable->spaceUsedSkew > hashtable->spaceAllowedSkew)
+	while (hashtable->spaceUsedSkew > hashtable->spaceAllowedSkew &&
+		   !hashtable->skewBucket[hashtable->skewBucketNums[hashtable->nSkewBuckets - 1]]->detected)
 		ExecHashRemoveNextSkewBucket(hashtable);
 
 	/* Check we are not over the total spaceAllowed, either */
@@ -2441,7 +2517,8 @@ ExecHashSkewTableInsert(HashJoinTable hashtable,
  *		ExecHashRemoveNextSkewBucket
  *
  *		Remove the least valuable skew bucket by pushing its tuples into
- *		the main hash table.
+ *		the main hash table.  Detected buckets come first in skewBucketNums,
+ *		and the caller must not ask us to remove them.
  */
 static void
 ExecHashRemoveNextSkewBucket(HashJoinTable hashtable)
@@ -2456,6 +2533,7 @@ ExecHashRemoveNextSkewBucket(HashJoinTable hashtable)
 	/* Locate the bucket to remove */
 	bucketToRemove = hashtable->skewBucketNums[hashtable->nSkewBuckets - 1];
 	bucket = hashtable->skewBucket[bucketToRemove];
+	Assert(!bucket->detected);
 
 	/*
 	 * Calculate which bucket and batch the tuples belong to in the main
@@ -2553,6 +2631,179 @@ ExecHashRemoveNextSkewBucket(HashJoinTable hashtable)
 	}
 }
 
+/*
+ * ExecHashFindHotValue
+ *
+ *		Look for a hash value shared by more than half of the tuples in the
+ *		main hash table, and return true and the value if there is one.
+ *
+ * We find the only possible candidate with the Boyer-Moore majority vote,
+ * then count its tuples in a second pass.  That's two sequential scans of
+ * the chunks, which is cheap next to the repartitioning our caller is about
+ * to do.
+ */
+static bool
+ExecHashFindHotValue(HashJoinTable hashtable, uint32 *hashvalue)
+{
+	HashMemoryChunk chunk;
+	uint32		candidate = 0;
+	long		votes = 0;
+	long		ntuples = 0;
+	long		nmatches = 0;
+
+	for (chunk = hashtable->chunks; chunk != NULL; chunk = chunk->next.unshared)
+	{
+		size_t		idx = 0;
+
+		while (idx < chunk->used)
+		{
+			HashJoinTuple hashTuple = (HashJoinTuple) (HASH_CHUNK_DATA(chunk) + idx);
+
+			if (votes == 0)
+			{
+				candidate = hashTuple->hashvalue;
+				votes = 1;
+			}
+			else if (hashTuple->hashvalue == candidate)
+				votes++;
+			else
+				votes--;
+			ntuples++;
+
+			idx += MAXALIGN(HJTUPLE_OVERHEAD +
+							HJTUPLE_MINTUPLE(hashTuple)->t_len);
+		}
+	}
+
+	if (votes == 0)
+		return false;
+
+	for (chunk = hashtable->chunks; chunk != NULL; chunk = chunk->next.unshared)
+	{
+		size_t		idx = 0;
+
+		while (idx < chunk->used)
+		{
+			HashJoinTuple hashTuple = (HashJoinTuple) (HASH_CHUNK_DATA(chunk) + idx);
+
+			if (hashTuple->hashvalue == candidate)
+				nmatches++;
+
+			idx += MAXALIGN(HJTUPLE_OVERHEAD +
+							HJTUPLE_MINTUPLE(hashTuple)->t_len);
+		}
+	}
+
+	/* a lone tuple isn't worth a skew bucket */
+	if (nmatches <= 1 || nmatches * 2 <= ntuples)
+		return false;
+
+	*hashvalue = candidate;
+	return true;
+}
+
+/*
+ * ExecHashAddDetectedSkewBucket
+ *
+ *		Create a skew bucket for a hash value found to be very common while
+ *		building the first batch, and return its index in skewBucket[].
+ *		Its tuples are the caller's business.
+ *
+ * Buckets must be removed in reverse order of creation (see notes in
+ * ExecHashRemoveNextSkewBucket), and detected buckets are never removed, so
+ * we rebuild the skew hashtable with the new bucket entered after any other
+ * detected ones but before all the MCV ones.  The table is small, so this is
+ * cheap.  The old arrays' space stays charged to spaceUsed, which is
+ * conservative; the new arrays are accounted like detected tuples.
+ */
+static int
+ExecHashAddDetectedSkewBucket(HashJoinTable hashtable, uint32 hashvalue)
+{
+	HashSkewBucket **oldSkewBucket = hashtable->skewBucket;
+	int		   *oldSkewBucketNums = hashtable->skewBucketNums;
+	int			oldnSkewBuckets = hashtable->nSkewBuckets;
+	HashSkewBucket *newBucket;
+	int			ndetected;
+	int			nbuckets;
+	int			result = INVALID_SKEW_BUCKET_NO;
+	Size		space;
+	int			i;
+
+	newBucket = (HashSkewBucket *)
+		MemoryContextAlloc(hashtable->batchCxt, sizeof(HashSkewBucket));
+	newBucket->hashvalue = hashvalue;
+	newBucket->tuples = NULL;
+	newBucket->detected = true;
+
+	ndetected = 0;
+	while (ndetected < oldnSkewBuckets &&
+		   oldSkewBucket[oldSkewBucketNums[ndetected]]->detected)
+		ndetected++;
+
+	/* size the table the same way ExecHashBuildSkewHash does */
+	nbuckets = 2;
+	while (nbuckets <= oldnSkewBuckets + 1)
+		nbuckets <<= 1;
+	nbuckets <<= 2;
+	nbuckets = Max(nbuckets, hashtable->skewBucketLen);
+
+	hashtable->skewBucket = (HashSkewBucket **)
+		MemoryContextAllocZero(hashtable->batchCxt,
+							   nbuckets * sizeof(HashSkewBucket *));
+	hashtable->skewBucketNums = (int *)
+		MemoryContextAllocZero(hashtable->batchCxt,
+							   (oldnSkewBuckets + 1) * sizeof(int));
+	hashtable->skewBucketLen = nbuckets;
+
+	for (i = 0; i <= oldnSkewBuckets; i++)
+	{
+		HashSkewBucket *bucket;
+		int			b;
+
+		if (i < ndetected)
+			bucket = oldSkewBucket[oldSkewBucketNums[i]];
+		else if (i == ndetected)
+			bucket = newBucket;
+		else
+			bucket = oldSkewBucket[oldSkewBucketNums[i - 1]];
+
+		/* NB: this code must match ExecHashGetSkewBucket */
+		b = bucket->hashvalue & (nbuckets - 1);
+		while (hashtable->skewBucket[b] != NULL)
+		{
+			Assert(hashtable->skewBucket[b]->hashvalue != bucket->hashvalue);
+			b = (b + 1) & (nbuckets - 1);
+		}
+		hashtable->skewBucket[b] = bucket;
+		hashtable->skewBucketNums[i] = b;
+		if (bucket == newBucket)
+			result = b;
+	}
+	hashtable->nSkewBuckets = oldnSkewBuckets + 1;
+	hashtable->skewEnabled = true;
+
+	if (oldSkewBucket != NULL)
+	{
+		pfree(oldSkewBucket);
+		pfree(oldSkewBucketNums);
+	}
+
+	space = nbuckets * sizeof(HashSkewBucket *) +
+		(oldnSkewBuckets + 1) * sizeof(int) + SKEW_BUCKET_OVERHEAD;
+	hashtable->spaceUsed += space;
+	hashtable->spaceAllowed += space;
+	hashtable->spaceUsedDetected += space;
+	if (hashtable->spaceUsed > hashtable->spacePeak)
+		hashtable->spacePeak = hashtable->spaceUsed;
+
+#ifdef HJDEBUG
+	printf("Hashjoin %p: detected skew on hash value %u\n",
+		   hashtable, hashvalue);
+#endif
+
+	return result;
+}
+
 /*
  * Reserve space in the DSM segment for instrumentation data.
  */
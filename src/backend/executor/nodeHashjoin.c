@@ -112,7 +112,9 @@
 #include "executor/hashjoin.h"
 #include "executor/nodeHash.h"
 #include "executor/nodeHashjoin.h"
+#include "lib/bloomfilter.h"
 #include "miscadmin.h"
+#include "parser/parsetree.h"
 #include "pgstat.h"
 #include "utils/memutils.h"
 #include "utils/sharedtuplestore.h"
@@ -133,6 +135,17 @@
 /* Returns true if doing null-fill on inner relation */
 #define HJ_FILL_INNER(hjstate)	((hjstate)->hj_NullOuterTupleSlot != NULL)
 
+/*
+ * A runtime filter is given up on if fewer than one in
+ * RUNTIME_FILTER_MIN_REJECT_RATIO of the first RUNTIME_FILTER_SAMPLE tuples
+ * it tests are rejected; probing it would then cost more than it saves.
+ */
+#define RUNTIME_FILTER_SAMPLE			1024
+#define RUNTIME_FILTER_MIN_REJECT_RATIO	8
+
+/* GUC parameter */
+bool		enable_runtime_filter = true;
+
 static TupleTableSlot *ExecHashJoinOuterGetTuple(PlanState *outerNode,
 						  HashJoinState *hjstate,
 						  uint32 *hashvalue);
@@ -146,6 +159,8 @@ static TupleTableSlot *ExecHashJoinGetSavedTuple(HashJoinState *hjstate,
 static bool ExecHashJoinNewBatch(HashJoinState *hjstate);
 static bool ExecParallelHashJoinNewBatch(HashJoinState *hjstate);
 static void ExecParallelHashJoinPartitionOuter(HashJoinState *node);
+static void ExecHashJoinInitRuntimeFilter(HashJoinState *hjstate,
+							  HashJoin *node);
 
 
 /* ----------------------------------------------------------------
@@ -760,9 +775,113 @@ ExecInitHashJoin(HashJoin *node, EState *estate, int eflags)
 	hjstate->hj_MatchedOuter = false;
 	hjstate->hj_OuterNotEmpty = false;
 
+	if (enable_runtime_filter)
+		ExecHashJoinInitRuntimeFilter(hjstate, node);
+
 	return hjstate;
 }
 
+/*
+ * ExecHashJoinInitRuntimeFilter
+ *
+ * If the outer side of the join is a sequential scan, and every outer hash
+ * key is simply a column of the scanned relation, ask the Hash node for a
+ * Bloom filter over the inner hash values and push it into the scan.  The
+ * scan then throws away tuples that cannot have a join partner before they
+ * are even projected, and an outer tuple that does reach us has still to be
+ * checked against the hash table as usual.
+ *
+ * This is only possible for join types that discard unmatched outer tuples.
+ * Parallel Hash is excluded because each participant would only see a part
+ * of the inner relation; with a private hash table in each worker, every
+ * worker builds its own complete filter.
+ */
+static void
+ExecHashJoinInitRuntimeFilter(HashJoinState *hjstate, HashJoin *node)
+{
+	PlanState  *outerState = outerPlanState(hjstate);
+	HashState  *hashstate = (HashState *) innerPlanState(hjstate);
+	ScanState  *scanstate;
+	RuntimeJoinFilter *filter;
+	List	   *hashkeys = NIL;
+	ListCell   *l;
+
+	if (node->join.jointype != JOIN_INNER &&
+		node->join.jointype != JOIN_SEMI &&
+		node->join.jointype != JOIN_RIGHT)
+		return;
+	if (innerPlan(node)->parallel_aware)
+		return;
+	if (!IsA(outerState, SeqScanState))
+		return;
+	scanstate = (ScanState *) outerState;
+
+	foreach(l, node->hashclauses)
+	{
+		OpExpr	   *hclause = lfirst_node(OpExpr, l);
+		Expr	   *outerkey = (Expr *) linitial(hclause->args);
+		TargetEntry *tle;
+
+		while (IsA(outerkey, RelabelType))
+			outerkey = ((RelabelType *) outerkey)->arg;
+		if (!IsA(outerkey, Var) ||
+			((Var *) outerkey)->varno != OUTER_VAR)
+			return;
+
+		/*
+		 * Look through the scan's targetlist to the column it projects.
+		 * Dropping the relabeling doesn't change the value that's hashed.
+		 */
+		tle = get_tle_by_resno(outerState->plan->targetlist,
+							   ((Var *) outerkey)->varattno);
+		if (tle == NULL || !IsA(tle->expr, Var))
+			return;
+		hashkeys = lappend(hashkeys, ExecInitExpr(tle->expr, outerState));
+	}
+
+	filter = (RuntimeJoinFilter *) palloc0(sizeof(RuntimeJoinFilter));
+	filter->hjstate = hjstate;
+	filter->hashkeys = hashkeys;
+	scanstate->ss_RuntimeFilter = filter;
+	hashstate->build_runtime_filter = true;
+}
+
+/*
+ * ExecRuntimeJoinFilterPasses
+ *
+ * Test the current scan tuple of "econtext" against a runtime filter pushed
+ * down by a hash join.  Returns false only if the tuple certainly has no
+ * join partner.  Note that the expression context is reset.
+ */
+bool
+ExecRuntimeJoinFilterPasses(RuntimeJoinFilter *filter, ExprContext *econtext)
+{
+	HashJoinTable hashtable = filter->hjstate->hj_HashTable;
+	uint32		hashvalue;
+
+	/* let everything through until the hash table has been built */
+	if (filter->disabled || hashtable == NULL ||
+		hashtable->bloomfilter == NULL)
+		return true;
+
+	filter->ntested++;
+	if (!ExecHashGetHashValue(hashtable, econtext, filter->hashkeys,
+							  true, false, &hashvalue) ||
+		bloom_lacks_element(hashtable->bloomfilter,
+							(unsigned char *) &hashvalue, sizeof(hashvalue)))
+	{
+		filter->nrejected++;
+		return false;
+	}
+
+	/* give up on a filter that doesn't pay off */
+	if (filter->ntested == RUNTIME_FILTER_SAMPLE &&
+		filter->nrejected * RUNTIME_FILTER_MIN_REJECT_RATIO < filter->ntested)
+		filter->disabled = true;
+
+	return true;
+}
+
 /* ----------------------------------------------------------------
  *		ExecEndHashJoin
  *
@@ -987,6 +1106,8 @@ ExecHashJoinNewBatch(HashJoinState *hjstate)
 		hashtable->skewBucketNums = NULL;
 		hashtable->nSkewBuckets = 0;
 		hashtable->spaceUsedSkew = 0;
+		hashtable->spaceAllowed -= hashtable->spaceUsedDetected;
+		hashtable->spaceUsedDetected = 0;
 	}
 
 	/*
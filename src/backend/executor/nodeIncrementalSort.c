@@ -0,0 +1,367 @@
+/*-------------------------------------------------------------------------
+ *
+ * nodeIncrementalSort.c
+ *	  Routines to handle incremental sorting of relations.
+ *
+ * Incremental sort is an optimized variant of plain sort for the case where
+ * the input is already sorted on a leading subset of the sort keys (the
+ * "presorted" keys).  Given, for example, input sorted on (a) and a required
+ * ordering of (a, b), the input consists of runs of tuples with equal values
+ * of a, and it is enough to sort each run on b and emit the runs in input
+ * order.  Compared with a full sort, this needs much less memory when the
+ * runs are small, and it can return the first tuple as soon as the first run
+ * has been read, which matters a lot under a LIMIT.
+ *
+ * Each run is sorted with tuplesort.c.  Since starting a sort has some
+ * fixed overhead, very short runs are merged: we always collect at least
+ * MIN_GROUP_SIZE tuples into a batch, and then go on until the presorted
+ * keys change.  Batches are sorted on all of the sort keys, so they may
+ * contain several runs.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/executor/nodeIncrementalSort.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "executor/execdebug.h"
+#include "executor/nodeIncrementalSort.h"
+#include "miscadmin.h"
+#include "utils/lsyscache.h"
+#include "utils/tuplesort.h"
+
+/*
+ * Minimum number of tuples sorted together, see the file header comment.
+ */
+#define MIN_GROUP_SIZE 32
+
+
+/*
+ * Does the tuple in "slot" have the same presorted keys as the group pivot?
+ */
+static bool
+isCurrentGroup(IncrementalSortState *node, TupleTableSlot *slot)
+{
+	ExprContext *econtext = node->ss.ps.ps_ExprContext;
+
+	econtext->ecxt_outertuple = node->group_pivot;
+	econtext->ecxt_innertuple = slot;
+	return ExecQualAndReset(node->eqfunction, econtext);
+}
+
+/*
+ * Remember the statistics of the batch just sorted, if it is the largest
+ * one so far.
+ */
+static void
+instrumentSortedBatch(IncrementalSortState *node)
+{
+	TuplesortInstrumentation stats;
+
+	tuplesort_get_stats((Tuplesortstate *) node->tuplesortstate, &stats);
+
+	/* a batch that went to disk counts as larger than any in-memory one */
+	if (node->groupsCount == 0 ||
+		(stats.spaceType == node->sinstrument.spaceType &&
+		 stats.spaceUsed > node->sinstrument.spaceUsed) ||
+		(stats.spaceType == SORT_SPACE_TYPE_DISK &&
+		 node->sinstrument.spaceType == SORT_SPACE_TYPE_MEMORY))
+		node->sinstrument = stats;
+	node->groupsCount++;
+}
+
+/*
+ * Read the next batch of tuples from the outer plan and sort it.
+ */
+static void
+sortNextBatch(IncrementalSortState *node)
+{
+	IncrementalSort *plannode = (IncrementalSort *) node->ss.ps.plan;
+	PlanState  *outerNode = outerPlanState(node);
+	Tuplesortstate *tuplesortstate;
+	int64		nTuples = 0;
+
+	/* Release the previous batch, if any */
+	if (node->tuplesortstate != NULL)
+		tuplesort_end((Tuplesortstate *) node->tuplesortstate);
+
+	tuplesortstate = tuplesort_begin_heap(ExecGetResultType(outerNode),
+										  plannode->sort.numCols,
+										  plannode->sort.sortColIdx,
+										  plannode->sort.sortOperators,
+										  plannode->sort.collations,
+										  plannode->sort.nullsFirst,
+										  work_mem,
+										  NULL, false);
+	node->tuplesortstate = (void *) tuplesortstate;
+
+	/*
+	 * The tuplesort only ever needs to produce as many tuples as are still
+	 * wanted by the consumer.
+	 */
+	if (node->bounded)
+		tuplesort_set_bound(tuplesortstate,
+							Max(node->bound - node->bound_Done, 1));
+
+	/* The first tuple of this batch was read while finishing the last one */
+	if (!TupIsNull(node->group_pivot))
+	{
+		tuplesort_puttupleslot(tuplesortstate, node->group_pivot);
+		nTuples++;
+	}
+
+	for (;;)
+	{
+		TupleTableSlot *slot = ExecProcNode(outerNode);
+
+		if (TupIsNull(slot))
+		{
+			node->outerNodeDone = true;
+			ExecClearTuple(node->group_pivot);
+			break;
+		}
+
+		if (nTuples < MIN_GROUP_SIZE)
+		{
+			tuplesort_puttupleslot(tuplesortstate, slot);
+			nTuples++;
+
+			/*
+			 * Once the batch is big enough, the last tuple added becomes the
+			 * pivot: the batch extends as long as the following tuples have
+			 * the same presorted keys.
+			 */
+			if (nTuples == MIN_GROUP_SIZE)
+				ExecCopySlot(node->group_pivot, slot);
+		}
+		else if (isCurrentGroup(node, slot))
+		{
+			tuplesort_puttupleslot(tuplesortstate, slot);
+			nTuples++;
+		}
+		else
+		{
+			/* First tuple of the next batch; keep it for later */
+			ExecCopySlot(node->group_pivot, slot);
+			break;
+		}
+	}
+
+	SO1_printf("ExecIncrementalSort: sorting batch of " INT64_FORMAT " tuples\n",
+			   nTuples);
+
+	tuplesort_performsort(tuplesortstate);
+	instrumentSortedBatch(node);
+	node->batch_sorted = true;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecIncrementalSort
+ *
+ *		Returns the next tuple of the current sorted batch, reading and
+ *		sorting the next batch from the outer subtree when the current one
+ *		is exhausted.
+ *
+ *		Conditions:
+ *		  -- none.
+ *
+ *		Initial States:
+ *		  -- the outer child is prepared to return the first tuple.
+ * ----------------------------------------------------------------
+ */
+static TupleTableSlot *
+ExecIncrementalSort(PlanState *pstate)
+{
+	IncrementalSortState *node = castNode(IncrementalSortState, pstate);
+	EState	   *estate = node->ss.ps.state;
+	ScanDirection dir = estate->es_direction;
+	TupleTableSlot *slot = node->ss.ps.ps_ResultTupleSlot;
+
+	CHECK_FOR_INTERRUPTS();
+
+	/* We don't support backward scans, see ExecSupportsBackwardScan */
+	Assert(ScanDirectionIsForward(dir));
+
+	for (;;)
+	{
+		if (node->batch_sorted)
+		{
+			if (tuplesort_gettupleslot((Tuplesortstate *) node->tuplesortstate,
+									   true, false, slot, NULL))
+			{
+				node->bound_Done++;
+				return slot;
+			}
+			node->batch_sorted = false;
+		}
+
+		if (node->outerNodeDone)
+			return ExecClearTuple(slot);
+
+		sortNextBatch(node);
+	}
+}
+
+/* ----------------------------------------------------------------
+ *		ExecInitIncrementalSort
+ *
+ *		Creates the run-time state information for the incremental sort
+ *		node produced by the planner and initializes its outer subtree.
+ * ----------------------------------------------------------------
+ */
+IncrementalSortState *
+ExecInitIncrementalSort(IncrementalSort *node, EState *estate, int eflags)
+{
+	IncrementalSortState *incrsortstate;
+	TupleDesc	outerDesc;
+	Oid		   *eqOperators;
+	int			i;
+
+	SO1_printf("ExecInitIncrementalSort: %s\n",
+			   "initializing sort node");
+
+	/*
+	 * Incremental sort can't be used with EXEC_FLAG_BACKWARD or
+	 * EXEC_FLAG_MARK, because the current batch is all we keep.
+	 */
+	Assert((eflags & (EXEC_FLAG_BACKWARD | EXEC_FLAG_MARK)) == 0);
+
+	/*
+	 * create state structure
+	 */
+	incrsortstate = makeNode(IncrementalSortState);
+	incrsortstate->ss.ps.plan = (Plan *) node;
+	incrsortstate->ss.ps.state = estate;
+	incrsortstate->ss.ps.ExecProcNode = ExecIncrementalSort;
+
+	incrsortstate->bounded = false;
+	incrsortstate->bound_Done = 0;
+	incrsortstate->batch_sorted = false;
+	incrsortstate->outerNodeDone = false;
+	incrsortstate->tuplesortstate = NULL;
+	incrsortstate->groupsCount = 0;
+
+	/*
+	 * Miscellaneous initialization
+	 *
+	 * We need an expression context to compare the presorted columns.
+	 */
+	ExecAssignExprContext(estate, &incrsortstate->ss.ps);
+
+	/*
+	 * initialize child nodes
+	 *
+	 * We shield the child node from the need to support REWIND.
+	 */
+	eflags &= ~EXEC_FLAG_REWIND;
+
+	outerPlanState(incrsortstate) = ExecInitNode(outerPlan(node), estate, eflags);
+	outerDesc = ExecGetResultType(outerPlanState(incrsortstate));
+
+	/*
+	 * Initialize scan slot and type.
+	 */
+	ExecCreateScanSlotFromOuterPlan(estate, &incrsortstate->ss, &TTSOpsVirtual);
+
+	/*
+	 * Initialize return slot and type. No need to initialize projection info
+	 * because this node doesn't do projections.
+	 */
+	ExecInitResultTupleSlotTL(&incrsortstate->ss.ps, &TTSOpsMinimalTuple);
+	incrsortstate->ss.ps.ps_ProjInfo = NULL;
+
+	incrsortstate->group_pivot =
+		ExecInitExtraTupleSlot(estate, outerDesc, &TTSOpsMinimalTuple);
+
+	/*
+	 * Prepare to compare the presorted columns, using the equality operators
+	 * that go with the sort operators.
+	 */
+	eqOperators = (Oid *) palloc(node->presortedCols * sizeof(Oid));
+	for (i = 0; i < node->presortedCols; i++)
+	{
+		eqOperators[i] = get_equality_op_for_ordering_op(node->sort.sortOperators[i],
+														 NULL);
+		if (!OidIsValid(eqOperators[i]))
+			elog(ERROR, "missing equality operator for ordering operator %u",
+				 node->sort.sortOperators[i]);
+	}
+	incrsortstate->eqfunction =
+		execTuplesMatchPrepare(outerDesc,
+							   node->presortedCols,
+							   node->sort.sortColIdx,
+							   eqOperators,
+							   &incrsortstate->ss.ps);
+
+	SO1_printf("ExecInitIncrementalSort: %s\n",
+			   "sort node initialized");
+
+	return incrsortstate;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecEndIncrementalSort(node)
+ * ----------------------------------------------------------------
+ */
+void
+ExecEndIncrementalSort(IncrementalSortState *node)
+{
+	SO1_printf("ExecEndIncrementalSort: %s\n",
+			   "shutting down sort node");
+
+	/*
+	 * clean out the tuple table
+	 */
+	ExecClearTuple(node->ss.ss_ScanTupleSlot);
+	/* must drop pointer to sort result tuple */
+	ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
+	ExecClearTuple(node->group_pivot);
+
+	/*
+	 * Release tuplesort resources
+	 */
+	if (node->tuplesortstate != NULL)
+		tuplesort_end((Tuplesortstate *) node->tuplesortstate);
+	node->tuplesortstate = NULL;
+
+	/*
+	 * shut down the subplan
+	 */
+	ExecEndNode(outerPlanState(node));
+
+	SO1_printf("ExecEndIncrementalSort: %s\n",
+			   "sort node shutdown");
+}
+
+void
+ExecReScanIncrementalSort(IncrementalSortState *node)
+{
+	PlanState  *outerPlan = outerPlanState(node);
+
+	/*
+	 * Only the current batch is kept, so we always have to re-read the
+	 * subplan and re-sort.
+	 */
+	ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
+	ExecClearTuple(node->group_pivot);
+
+	if (node->tuplesortstate != NULL)
+		tuplesort_end((Tuplesortstate *) node->tuplesortstate);
+	node->tuplesortstate = NULL;
+	node->batch_sorted = false;
+	node->outerNodeDone = false;
+	node->bound_Done = 0;
+
+	/*
+	 * if chgParam of subnode is not null then plan will be re-scanned by
+	 * first ExecProcNode.
+	 */
+	if (outerPlan->chgParam == NULL)
+		ExecReScan(outerPlan);
+}
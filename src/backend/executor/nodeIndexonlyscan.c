@@ -98,7 +98,10 @@ IndexOnlyNext(IndexOnlyScanState *node)
 
 		/* Set it up for index-only scan */
 		node->ioss_ScanDesc->xs_want_itup = true;
+		node->ioss_ScanDesc->xs_want_skip =
+			((IndexOnlyScan *) node->ss.ps.plan)->indexskip;
 		node->ioss_VMBuffer = InvalidBuffer;
+		index_set_prefetch(scandesc, node->ioss_PrefetchMaximum);
 
 		/*
 		 * If no run-time keys to calculate or they are ready, go ahead and
@@ -572,6 +575,8 @@ ExecInitIndexOnlyScan(IndexOnlyScan *node, EState *estate, int eflags)
 	indexstate->ioss_RuntimeKeysReady = false;
 	indexstate->ioss_RuntimeKeys = NULL;
 	indexstate->ioss_NumRuntimeKeys = 0;
+	indexstate->ioss_PrefetchMaximum =
+		ExecIndexPrefetchMaximum(currentRelation, eflags);
 
 	/*
 	 * build the index scan keys from the index qualification
@@ -677,6 +682,7 @@ ExecIndexOnlyScanInitializeDSM(IndexOnlyScanState *node,
 								 piscan);
 	node->ioss_ScanDesc->xs_want_itup = true;
 	node->ioss_VMBuffer = InvalidBuffer;
+	index_set_prefetch(node->ioss_ScanDesc, node->ioss_PrefetchMaximum);
 
 	/*
 	 * If no run-time keys to calculate or they are ready, go ahead and pass
@@ -721,6 +727,7 @@ ExecIndexOnlyScanInitializeWorker(IndexOnlyScanState *node,
 								 node->ioss_NumOrderByKeys,
 								 piscan);
 	node->ioss_ScanDesc->xs_want_itup = true;
+	index_set_prefetch(node->ioss_ScanDesc, node->ioss_PrefetchMaximum);
 
 	/*
 	 * If no run-time keys to calculate or they are ready, go ahead and pass
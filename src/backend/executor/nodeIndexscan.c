@@ -29,6 +29,8 @@
  */
 #include "postgres.h"
 
+#include <math.h>
+
 #include "access/nbtree.h"
 #include "access/relscan.h"
 #include "catalog/pg_am.h"
@@ -38,11 +40,13 @@
 #include "miscadmin.h"
 #include "nodes/nodeFuncs.h"
 #include "optimizer/clauses.h"
+#include "storage/bufmgr.h"
 #include "utils/array.h"
 #include "utils/datum.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/rel.h"
+#include "utils/spccache.h"
 
 /*
  * When an ordering operator is used, tuples fetched from the index that
@@ -117,6 +121,8 @@ IndexNext(IndexScanState *node)
 								   node->iss_NumOrderByKeys);
 
 		node->iss_ScanDesc = scandesc;
+		scandesc->xs_want_skip = ((IndexScan *) node->ss.ps.plan)->indexskip;
+		index_set_prefetch(scandesc, node->iss_PrefetchMaximum);
 
 		/*
 		 * If no run-time keys to calculate or they are ready, go ahead and
@@ -795,6 +801,34 @@ ExecIndexAdvanceArrayKeys(IndexArrayKeyInfo *arrayKeys, int numArrayKeys)
 	return found;
 }
 
+/*
+ * ExecIndexPrefetchMaximum
+ *		How many index entries should an index scan read ahead, prefetching
+ *		the heap pages they point to?
+ *
+ * This is the same as the number of pages a bitmap heap scan would prefetch.
+ * We can't read ahead at all if the scan may have to move backwards or be
+ * marked and restored, see index_set_prefetch().
+ */
+int
+ExecIndexPrefetchMaximum(Relation heapRelation, int eflags)
+{
+	int			io_concurrency;
+	double		maximum;
+
+	if (eflags & (EXEC_FLAG_BACKWARD | EXEC_FLAG_MARK))
+		return 0;
+
+	/* Consider the tablespace's setting, as in ExecInitBitmapHeapScan */
+	io_concurrency =
+		get_tablespace_io_concurrency(heapRelation->rd_rel->reltablespace);
+	if (io_concurrency == effective_io_concurrency)
+		return target_prefetch_pages;
+	if (ComputeIoConcurrency(io_concurrency, &maximum))
+		return (int) rint(maximum);
+	return target_prefetch_pages;
+}
+
 
 /* ----------------------------------------------------------------
  *		ExecEndIndexScan
@@ -1000,6 +1034,8 @@ ExecInitIndexScan(IndexScan *node, EState *estate, int eflags)
 	indexstate->iss_RuntimeKeysReady = false;
 	indexstate->iss_RuntimeKeys = NULL;
 	indexstate->iss_NumRuntimeKeys = 0;
+	indexstate->iss_PrefetchMaximum =
+		ExecIndexPrefetchMaximum(currentRelation, eflags);
 
 	/*
 	 * build the index scan keys from the index qualification
@@ -1724,6 +1760,7 @@ ExecIndexScanInitializeDSM(IndexScanState *node,
 								 node->iss_NumScanKeys,
 								 node->iss_NumOrderByKeys,
 								 piscan);
+	index_set_prefetch(node->iss_ScanDesc, node->iss_PrefetchMaximum);
 
 	/*
 	 * If no run-time keys to calculate or they are ready, go ahead and pass
@@ -1767,6 +1804,7 @@ ExecIndexScanInitializeWorker(IndexScanState *node,
 								 node->iss_NumScanKeys,
 								 node->iss_NumOrderByKeys,
 								 piscan);
+	index_set_prefetch(node->iss_ScanDesc, node->iss_PrefetchMaximum);
 
 	/*
 	 * If no run-time keys to calculate or they are ready, go ahead and pass
@@ -89,6 +89,15 @@
  *		proceed to another state.  This state is stored in the node's
  *		execution state information and is preserved across calls to
  *		ExecMergeJoin. -cim 10/31/89
+ *
+ *		When the inner input is a btree index scan on the first merge key,
+ *		the planner may instead ask us to "skip ahead" over long runs of
+ *		inner tuples that are smaller than the current outer tuple: after
+ *		MJ_SKIP_INNER_THRESHOLD consecutive SKIPINNER_ADVANCE steps, we pass
+ *		the current outer key down to the index scan through a PARAM_EXEC
+ *		Param appearing in an "indexkey >= $n" index qual, and rescan it.
+ *		This turns a sparse outer joined to a large inner into a series of
+ *		index descents, without giving up the merge join's ordered output.
  */
 #include "postgres.h"
 
@@ -96,6 +105,8 @@
 #include "executor/execdebug.h"
 #include "executor/nodeMergejoin.h"
 #include "miscadmin.h"
+#include "nodes/nodeFuncs.h"
+#include "utils/datum.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 
@@ -445,6 +456,54 @@ MJCompare(MergeJoinState *mergestate)
 }
 
 
+/*
+ * MJSeekInner
+ *
+ * Rescan the inner index scan so that it resumes at the first inner tuple
+ * whose leading merge key is >= the current outer tuple's.  The planner sets
+ * skipParam only when the inner plan is a forward btree index scan carrying
+ * an "indexkey >= $skipParam" qual on the first merge key, so the inner
+ * tuples we jump over could not have joined to the current outer tuple or
+ * to any later one.
+ *
+ * The index scan keeps referencing the key value until it is next rescanned,
+ * while we move on through the outer input, so a pass-by-reference key must
+ * be copied out of the outer tuple's memory.
+ */
+static void
+MJSeekInner(MergeJoinState *mergestate)
+{
+	MergeJoinClause clause = &mergestate->mj_Clauses[0];
+	EState	   *estate = mergestate->js.ps.state;
+	PlanState  *innerPlan = innerPlanState(mergestate);
+	ParamExecData *prm;
+	Datum		oldvalue = mergestate->mj_SkipValue;
+	Datum		newvalue;
+	MemoryContext oldContext;
+
+	Assert(mergestate->mj_SkipParam >= 0);
+	Assert(!clause->lisnull);
+
+	oldContext = MemoryContextSwitchTo(estate->es_query_cxt);
+	newvalue = datumCopy(clause->ldatum,
+						 mergestate->mj_SkipTypByVal,
+						 mergestate->mj_SkipTypLen);
+	MemoryContextSwitchTo(oldContext);
+
+	prm = &(estate->es_param_exec_vals[mergestate->mj_SkipParam]);
+	prm->value = newvalue;
+	prm->isnull = false;
+	innerPlan->chgParam = bms_add_member(innerPlan->chgParam,
+										 mergestate->mj_SkipParam);
+	ExecReScan(innerPlan);
+
+	/* the index scan no longer references the previous key */
+	if (!mergestate->mj_SkipTypByVal && DatumGetPointer(oldvalue) != NULL)
+		pfree(DatumGetPointer(oldvalue));
+	mergestate->mj_SkipValue = newvalue;
+	mergestate->mj_SkipCount = 0;
+}
+
 /*
  * Generate a fake join tuple with nulls for the inner tuple,
  * and return it if it passes the non-join quals.
@@ -660,6 +719,9 @@ ExecMergeJoin(PlanState *pstate)
 				switch (MJEvalOuterValues(node))
 				{
 					case MJEVAL_MATCHABLE:
+						/* Position a skip-ahead inner scan at the outer key */
+						if (node->mj_SkipParam >= 0)
+							MJSeekInner(node);
 						/* OK to go get the first inner tuple */
 						node->mj_JoinState = EXEC_MJ_INITIALIZE_INNER;
 						break;
@@ -1189,10 +1251,14 @@ ExecMergeJoin(PlanState *pstate)
 
 					MarkInnerTuple(node->mj_InnerTupleSlot, node);
 
+					node->mj_SkipCount = 0;
 					node->mj_JoinState = EXEC_MJ_JOINTUPLES;
 				}
 				else if (compareResult < 0)
+				{
+					node->mj_SkipCount = 0;
 					node->mj_JoinState = EXEC_MJ_SKIPOUTER_ADVANCE;
+				}
 				else
 					/* compareResult > 0 */
 					node->mj_JoinState = EXEC_MJ_SKIPINNER_ADVANCE;
@@ -1289,6 +1355,25 @@ ExecMergeJoin(PlanState *pstate)
 				if (node->mj_ExtraMarks)
 					ExecMarkPos(innerPlan);
 
+				/*
+				 * If we have stepped over enough inner tuples in a row,
+				 * re-seek the inner scan to the current outer key instead of
+				 * plodding on.  Insist that the current inner's leading key
+				 * be strictly smaller, else the re-seek could land us back at
+				 * the start of the same key group and we'd never get past it.
+				 */
+				if (node->mj_SkipParam >= 0 &&
+					++node->mj_SkipCount >= MJ_SKIP_INNER_THRESHOLD)
+				{
+					MergeJoinClause clause = &node->mj_Clauses[0];
+
+					if (!clause->lisnull && !clause->risnull &&
+						ApplySortComparator(clause->ldatum, false,
+											clause->rdatum, false,
+											&clause->ssup) > 0)
+						MJSeekInner(node);
+				}
+
 				/*
 				 * now we get the next inner tuple, if any
 				 */
@@ -1603,6 +1688,22 @@ ExecInitMergeJoin(MergeJoin *node, EState *estate, int eflags)
 											node->mergeNullsFirst,
 											(PlanState *) mergestate);
 
+	/*
+	 * set up for re-seeking the inner scan, if the planner asked for that
+	 */
+	Assert(node->skipParam < 0 || !mergestate->mj_FillInner);
+	mergestate->mj_SkipParam = node->skipParam;
+	mergestate->mj_SkipCount = 0;
+	mergestate->mj_SkipValue = (Datum) 0;
+	if (node->skipParam >= 0)
+	{
+		OpExpr	   *qual = linitial_node(OpExpr, node->mergeclauses);
+
+		get_typlenbyval(exprType(linitial(qual->args)),
+						&mergestate->mj_SkipTypLen,
+						&mergestate->mj_SkipTypByVal);
+	}
+
 	/*
 	 * initialize join state
 	 */
@@ -1665,6 +1766,7 @@ ExecReScanMergeJoin(MergeJoinState *node)
 	node->mj_MatchedInner = false;
 	node->mj_OuterTupleSlot = NULL;
 	node->mj_InnerTupleSlot = NULL;
+	node->mj_SkipCount = 0;
 
 	/*
 	 * if chgParam of subnodes is not null then plans will be re-scanned by
@@ -72,6 +72,7 @@ static ResultRelInfo *getTargetResultRelInfo(ModifyTableState *node);
 static void ExecSetupChildParentMapForSubplan(ModifyTableState *mtstate);
 static TupleConversionMap *tupconv_map_for_subplan(ModifyTableState *node,
 						int whichplan);
+static uint64 ExecBatchInsert(EState *estate, ResultRelInfo *resultRelInfo);
 
 /*
  * Verify that the tuples to be produced by INSERT or UPDATE match the
@@ -316,6 +317,21 @@ ExecInsert(ModifyTableState *mtstate,
 	}
 	else if (resultRelInfo->ri_FdwRoutine)
 	{
+		/*
+		 * If the FDW inserts in batches, just add the row to the current
+		 * batch.  Rows are counted when the batch actually gets inserted.
+		 */
+		if (resultRelInfo->ri_BatchSize > 1)
+		{
+			uint64		inserted;
+
+			inserted = ExecBufferForeignInsert(mtstate, resultRelInfo,
+											   slot, planSlot);
+			if (canSetTag)
+				estate->es_processed += inserted;
+			return NULL;
+		}
+
 		/*
 		 * insert into foreign table: let the FDW do it
 		 */
@@ -2076,6 +2092,15 @@ ExecModifyTable(PlanState *pstate)
 	/* Restore es_result_relation_info before exiting */
 	estate->es_result_relation_info = saved_resultRelInfo;
 
+	/* Insert any rows still waiting in batches */
+	if (node->mt_pending_inserts != NIL)
+	{
+		uint64		inserted = ExecPendingInserts(node);
+
+		if (node->canSetTag)
+			estate->es_processed += inserted;
+	}
+
 	/*
 	 * We're done, but fire AFTER STATEMENT triggers before exiting.
 	 */
@@ -2238,6 +2263,20 @@ ExecInitModifyTable(ModifyTable *node, EState *estate, int eflags)
 	if (!(eflags & EXEC_FLAG_EXPLAIN_ONLY))
 		ExecSetupTransitionCaptureState(mtstate, estate);
 
+	/*
+	 * Ask the FDWs of foreign result rels how many rows to insert at once.
+	 * This has to wait until we know whether transition tuples are needed.
+	 */
+	resultRelInfo = mtstate->resultRelInfo;
+	for (i = 0; i < nplans; i++)
+	{
+		if (!resultRelInfo->ri_usesFdwDirectModify &&
+			resultRelInfo->ri_FdwRoutine != NULL)
+			resultRelInfo->ri_BatchSize =
+				ExecForeignBatchSize(mtstate, resultRelInfo);
+		resultRelInfo++;
+	}
+
 	/*
 	 * Construct mapping from each of the per-subplan partition attnos to the
 	 * root attno.  This is required when during update row movement the tuple
@@ -2637,3 +2676,159 @@ ExecReScanModifyTable(ModifyTableState *node)
 	 */
 	elog(ERROR, "ExecReScanModifyTable is not implemented");
 }
+
+/*
+ * ExecForeignBatchSize
+ *		Decide how many rows to collect for a foreign result relation before
+ *		handing them to the FDW's ExecForeignBatchInsert in one call.
+ *
+ * Returns 1 if rows have to be inserted one at a time.  Since buffered rows
+ * are inserted only when the batch is full, we can't batch if anything has
+ * to see each row as soon as it is inserted, or might look for the rows
+ * inserted before it: RETURNING, WITH CHECK OPTION, row-level triggers and
+ * transition tables all rule batching out.
+ */
+int
+ExecForeignBatchSize(ModifyTableState *mtstate, ResultRelInfo *resultRelInfo)
+{
+	FdwRoutine *fdwroutine = resultRelInfo->ri_FdwRoutine;
+	TriggerDesc *trigdesc = resultRelInfo->ri_TrigDesc;
+
+	if (fdwroutine == NULL ||
+		fdwroutine->ExecForeignBatchInsert == NULL ||
+		fdwroutine->GetForeignModifyBatchSize == NULL)
+		return 1;
+
+	if (mtstate->operation != CMD_INSERT ||
+		mtstate->mt_transition_capture != NULL ||
+		resultRelInfo->ri_returningList != NIL ||
+		resultRelInfo->ri_WithCheckOptions != NIL)
+		return 1;
+
+	if (trigdesc &&
+		(trigdesc->trig_insert_before_row ||
+		 trigdesc->trig_insert_after_row ||
+		 trigdesc->trig_insert_new_table))
+		return 1;
+
+	return Max(fdwroutine->GetForeignModifyBatchSize(resultRelInfo), 1);
+}
+
+/*
+ * ExecBufferForeignInsert
+ *		Add a row to the batch being collected for a foreign result relation
+ *
+ * If the batch is already full, it is inserted first, and the number of rows
+ * the FDW reports as inserted is returned; otherwise we return 0.
+ */
+uint64
+ExecBufferForeignInsert(ModifyTableState *mtstate,
+						ResultRelInfo *resultRelInfo,
+						TupleTableSlot *slot,
+						TupleTableSlot *planSlot)
+{
+	EState	   *estate = mtstate->ps.state;
+	uint64		inserted = 0;
+	int			n;
+	MemoryContext oldcontext;
+
+	Assert(resultRelInfo->ri_BatchSize > 1);
+
+	if (resultRelInfo->ri_NumSlots == resultRelInfo->ri_BatchSize)
+		inserted = ExecBatchInsert(estate, resultRelInfo);
+
+	oldcontext = MemoryContextSwitchTo(estate->es_query_cxt);
+
+	if (resultRelInfo->ri_Slots == NULL)
+	{
+		resultRelInfo->ri_Slots = (TupleTableSlot **)
+			palloc0(sizeof(TupleTableSlot *) * resultRelInfo->ri_BatchSize);
+		resultRelInfo->ri_PlanSlots = (TupleTableSlot **)
+			palloc0(sizeof(TupleTableSlot *) * resultRelInfo->ri_BatchSize);
+	}
+
+	/*
+	 * The caller's slots get overwritten by the next row, so we keep a copy
+	 * of each buffered row in slots of our own, made on first use.
+	 */
+	n = resultRelInfo->ri_NumSlots;
+	if (resultRelInfo->ri_Slots[n] == NULL)
+		resultRelInfo->ri_Slots[n] =
+			ExecInitExtraTupleSlot(estate,
+								   RelationGetDescr(resultRelInfo->ri_RelationDesc),
+								   &TTSOpsHeapTuple);
+	ExecCopySlot(resultRelInfo->ri_Slots[n], slot);
+
+	if (planSlot != NULL)
+	{
+		if (resultRelInfo->ri_PlanSlots[n] == NULL)
+			resultRelInfo->ri_PlanSlots[n] =
+				ExecInitExtraTupleSlot(estate, planSlot->tts_tupleDescriptor,
+									   &TTSOpsVirtual);
+		ExecCopySlot(resultRelInfo->ri_PlanSlots[n], planSlot);
+	}
+
+	if (n == 0)
+		mtstate->mt_pending_inserts =
+			list_append_unique_ptr(mtstate->mt_pending_inserts, resultRelInfo);
+	resultRelInfo->ri_NumSlots++;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	return inserted;
+}
+
+/*
+ * ExecPendingInserts
+ *		Insert the rows remaining in all the batches being collected
+ *
+ * Returns the number of rows the FDWs report as inserted.
+ */
+uint64
+ExecPendingInserts(ModifyTableState *mtstate)
+{
+	EState	   *estate = mtstate->ps.state;
+	uint64		inserted = 0;
+	ListCell   *lc;
+
+	foreach(lc, mtstate->mt_pending_inserts)
+	{
+		ResultRelInfo *resultRelInfo = (ResultRelInfo *) lfirst(lc);
+
+		if (resultRelInfo->ri_NumSlots > 0)
+			inserted += ExecBatchInsert(estate, resultRelInfo);
+	}
+
+	list_free(mtstate->mt_pending_inserts);
+	mtstate->mt_pending_inserts = NIL;
+
+	return inserted;
+}
+
+/*
+ * Pass the collected rows of a foreign result relation to its FDW, and empty
+ * the batch.
+ */
+static uint64
+ExecBatchInsert(EState *estate, ResultRelInfo *resultRelInfo)
+{
+	int			numSlots = resultRelInfo->ri_NumSlots;
+	int			numInserted = numSlots;
+	int			i;
+
+	(void) resultRelInfo->ri_FdwRoutine->ExecForeignBatchInsert(estate,
+																resultRelInfo,
+																resultRelInfo->ri_Slots,
+																resultRelInfo->ri_PlanSlots,
+																&numInserted);
+
+	for (i = 0; i < numSlots; i++)
+	{
+		ExecClearTuple(resultRelInfo->ri_Slots[i]);
+		if (resultRelInfo->ri_PlanSlots[i] != NULL)
+			ExecClearTuple(resultRelInfo->ri_PlanSlots[i]);
+	}
+	resultRelInfo->ri_NumSlots = 0;
+
+	return numInserted;
+}
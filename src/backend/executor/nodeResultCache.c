@@ -0,0 +1,807 @@
+/*-------------------------------------------------------------------------
+ *
+ * nodeResultCache.c
+ *	  Routines to handle caching of results from parameterized nodes
+ *
+ * A Result Cache sits above the inner side of a parameterized nested loop
+ * join.  Each rescan of the subplan is done for some values of the cache
+ * key parameters; the tuples it produces are remembered in a hash table
+ * keyed by those values, so that when the same values come around again,
+ * the tuples can be returned from the cache without running the subplan.
+ * This pays off when the outer side of the join has many duplicate join
+ * keys.
+ *
+ * The memory used by the cache is bounded by work_mem.  When the limit is
+ * reached, we evict the least recently used entries.  If the entry being
+ * filled doesn't fit even on its own, we give up on caching it and just
+ * pass through the subplan's tuples for the rest of that scan.
+ *
+ * An entry is only usable once it is complete, i.e. once the subplan has
+ * been run to completion for its parameters.  A scan that the parent node
+ * stops early leaves an incomplete entry behind, which is filled again on
+ * the next lookup.  When the planner knows that the inner side can produce
+ * at most one matching row (singlerow), the entry is complete after its
+ * first tuple.
+ *
+ * The cache keys are compared by their binary image, with datumIsEqual().
+ * Values that are equal according to the type's equality operator but are
+ * represented differently just miss the cache.  That way, the cache is
+ * correct whatever the subplan does with the parameter values.
+ *
+ * If a parameter that the subplan depends on, but which is not part of the
+ * cache key, changes, all cached results are thrown away.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/executor/nodeResultCache.c
+ *
+ *-------------------------------------------------------------------------
+ */
+/*
+ * INTERFACE ROUTINES
+ *		ExecResultCache			- lookup cache, exec subplan when not found
+ *		ExecInitResultCache		- initialize node and subnodes
+ *		ExecEndResultCache		- shutdown node and subnodes
+ *		ExecReScanResultCache	- rescan the result cache
+ */
+#include "postgres.h"
+
+#include "access/hash.h"
+#include "access/htup_details.h"
+#include "executor/executor.h"
+#include "executor/nodeResultCache.h"
+#include "lib/ilist.h"
+#include "miscadmin.h"
+#include "utils/datum.h"
+#include "utils/hashutils.h"
+
+/* States of the ExecResultCache state machine */
+#define RC_CACHE_LOOKUP				1	/* Attempt to perform a cache lookup */
+#define RC_CACHE_FETCH_NEXT_TUPLE	2	/* Get another tuple from the cache */
+#define RC_FILLING_CACHE			3	/* Read outer node to fill cache */
+#define RC_CACHE_BYPASS_MODE		4	/* Read outer node without caching */
+#define RC_END_OF_SCAN				5	/* Ready for rescan */
+
+/* Memory accounted to an entry without tuples, and to a cached tuple */
+#define EMPTY_ENTRY_MEMORY_BYTES(e)		(sizeof(ResultCacheEntry) + \
+										 sizeof(ResultCacheKey) + \
+										 (e)->key->params->t_len)
+#define CACHE_TUPLE_BYTES(t)			(sizeof(ResultCacheTuple) + \
+										 (t)->mintuple->t_len)
+
+/* ResultCacheTuple stores an individual tuple of a cache entry */
+typedef struct ResultCacheTuple
+{
+	MinimalTuple mintuple;		/* Cached tuple */
+	struct ResultCacheTuple *next;	/* The next tuple with the same parameter
+									 * values or NULL if it's the last one */
+} ResultCacheTuple;
+
+/*
+ * ResultCacheKey
+ *		The hash table key for cached entries plus the LRU list link
+ */
+typedef struct ResultCacheKey
+{
+	MinimalTuple params;		/* values of the cache key params */
+	uint32		hash;			/* hash value of params */
+	dlist_node	lru_node;		/* Pointer to next/prev key in LRU list */
+} ResultCacheKey;
+
+/*
+ * ResultCacheEntry
+ *		The data struct that the cache hash table stores
+ */
+typedef struct ResultCacheEntry
+{
+	ResultCacheKey *key;		/* Hash key for hash table lookups */
+	ResultCacheTuple *tuplehead;	/* Pointer to the first tuple or NULL if
+									 * no tuples are cached for this entry */
+	uint32		hash;			/* Hash value (cached) */
+	char		status;			/* Hash status */
+	bool		complete;		/* Did we read the outer plan to completion? */
+} ResultCacheEntry;
+
+static bool ResultCacheHash_equal(struct resultcache_hash *tb,
+					  const ResultCacheKey *key1,
+					  const ResultCacheKey *key2);
+
+/*
+ * Lookups for the parameter values in the probe slot are done with a NULL
+ * key and an explicitly computed hash value.  A non-NULL key is only used
+ * to find the entry for that very key, for which we can use the hash value
+ * stored in it.
+ */
+#define SH_PREFIX resultcache
+#define SH_ELEMENT_TYPE ResultCacheEntry
+#define SH_KEY_TYPE ResultCacheKey *
+#define SH_KEY key
+#define SH_HASH_KEY(tb, key) ((key)->hash)
+#define SH_EQUAL(tb, a, b) ResultCacheHash_equal(tb, a, b)
+#define SH_SCOPE static inline
+#define SH_STORE_HASH
+#define SH_GET_HASH(tb, a) a->hash
+#define SH_DEFINE
+#define SH_DECLARE
+#include "lib/simplehash.h"
+
+
+/*
+ * ResultCacheHash_hash
+ *		Hash function for the cache key values in the probe slot
+ */
+static uint32
+ResultCacheHash_hash(ResultCacheState *rcstate)
+{
+	TupleTableSlot *pslot = rcstate->probeslot;
+	TupleDesc	desc = rcstate->hashkeydesc;
+	uint32		hashkey = 0;
+	int			i;
+
+	for (i = 0; i < rcstate->nkeys; i++)
+	{
+		/* rotate hashkey left 1 bit at each step */
+		hashkey = (hashkey << 1) | ((hashkey & 0x80000000) ? 1 : 0);
+
+		if (!pslot->tts_isnull[i])	/* treat nulls as having hash key 0 */
+		{
+			Form_pg_attribute attr = TupleDescAttr(desc, i);
+			Datum		value = pslot->tts_values[i];
+			uint32		hkey;
+
+			/* hash the same bytes that datumIsEqual() compares */
+			if (attr->attbyval)
+				hkey = DatumGetUInt32(hash_any((unsigned char *) &value,
+											   sizeof(Datum)));
+			else
+				hkey = DatumGetUInt32(hash_any((unsigned char *) DatumGetPointer(value),
+											   datumGetSize(value, false,
+															attr->attlen)));
+			hashkey ^= hkey;
+		}
+	}
+
+	return murmurhash32(hashkey);
+}
+
+/*
+ * ResultCacheHash_equal
+ *		Equality function for cache keys
+ *
+ * If key2 is NULL, compare key1 with the values in the probe slot.
+ * Otherwise key1 matches only if it is the same key.
+ */
+static bool
+ResultCacheHash_equal(struct resultcache_hash *tb, const ResultCacheKey *key1,
+					  const ResultCacheKey *key2)
+{
+	ResultCacheState *rcstate = (ResultCacheState *) tb->private_data;
+	TupleTableSlot *tslot = rcstate->tableslot;
+	TupleTableSlot *pslot = rcstate->probeslot;
+	TupleDesc	desc = rcstate->hashkeydesc;
+	int			i;
+
+	if (key2 != NULL)
+		return key1 == key2;
+
+	ExecStoreMinimalTuple(key1->params, tslot, false);
+	slot_getallattrs(tslot);
+
+	for (i = 0; i < rcstate->nkeys; i++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(desc, i);
+
+		if (tslot->tts_isnull[i] != pslot->tts_isnull[i])
+			return false;
+
+		/* both NULL? they're equal */
+		if (tslot->tts_isnull[i])
+			continue;
+
+		if (!datumIsEqual(tslot->tts_values[i], pslot->tts_values[i],
+						  attr->attbyval, attr->attlen))
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Initialize the hash table to empty.
+ */
+static void
+build_hash_table(ResultCacheState *rcstate, uint32 size)
+{
+	/* Make a guess at a good size when we're not given a valid size. */
+	if (size == 0)
+		size = 1024;
+
+	/* resultcache_create will convert the size to a power of 2 */
+	rcstate->hashtable = resultcache_create(rcstate->tableContext, size,
+											rcstate);
+}
+
+/*
+ * prepare_probe_slot
+ *		Evaluate the cache key params for the current scan into the probe
+ *		slot.
+ */
+static void
+prepare_probe_slot(ResultCacheState *rcstate)
+{
+	TupleTableSlot *pslot = rcstate->probeslot;
+	ExprContext *econtext = rcstate->ss.ps.ps_ExprContext;
+	MemoryContext oldcontext;
+	int			i;
+
+	ResetExprContext(econtext);
+	oldcontext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+
+	ExecClearTuple(pslot);
+
+	for (i = 0; i < rcstate->nkeys; i++)
+		pslot->tts_values[i] = ExecEvalExpr(rcstate->param_exprs[i],
+											econtext,
+											&pslot->tts_isnull[i]);
+
+	ExecStoreVirtualTuple(pslot);
+
+	MemoryContextSwitchTo(oldcontext);
+}
+
+/*
+ * entry_purge_tuples
+ *		Remove all tuples from the cache entry, leaving it incomplete.
+ */
+static void
+entry_purge_tuples(ResultCacheState *rcstate, ResultCacheEntry *entry)
+{
+	ResultCacheTuple *tuple = entry->tuplehead;
+
+	while (tuple != NULL)
+	{
+		ResultCacheTuple *next = tuple->next;
+
+		rcstate->mem_used -= CACHE_TUPLE_BYTES(tuple);
+
+		pfree(tuple->mintuple);
+		pfree(tuple);
+
+		tuple = next;
+	}
+
+	entry->complete = false;
+	entry->tuplehead = NULL;
+}
+
+/*
+ * remove_cache_entry
+ *		Remove 'entry' from the cache and free its memory.
+ *
+ * Deleting from the hash table may move other entries around, so any
+ * pointers to entries are invalid afterwards.
+ */
+static void
+remove_cache_entry(ResultCacheState *rcstate, ResultCacheEntry *entry)
+{
+	ResultCacheKey *key = entry->key;
+
+	dlist_delete(&key->lru_node);
+
+	entry_purge_tuples(rcstate, entry);
+	rcstate->mem_used -= EMPTY_ENTRY_MEMORY_BYTES(entry);
+
+	resultcache_delete(rcstate->hashtable, key);
+
+	pfree(key->params);
+	pfree(key);
+}
+
+/*
+ * cache_purge_all
+ *		Remove all entries from the cache.
+ */
+static void
+cache_purge_all(ResultCacheState *rcstate)
+{
+	uint64		evictions = rcstate->hashtable->members;
+
+	/* The slots may point into memory we're about to free */
+	ExecClearTuple(rcstate->ss.ps.ps_ResultTupleSlot);
+	ExecClearTuple(rcstate->tableslot);
+
+	/*
+	 * Just resetting the memory context is faster than freeing each entry,
+	 * but we need to build a new hash table afterwards.
+	 */
+	MemoryContextReset(rcstate->tableContext);
+	build_hash_table(rcstate, ((ResultCache *) rcstate->ss.ps.plan)->est_entries);
+
+	dlist_init(&rcstate->lru_list);
+	rcstate->mem_used = 0;
+	rcstate->entry = NULL;
+	rcstate->last_tuple = NULL;
+
+	rcstate->stats.cache_evictions += evictions;
+}
+
+/*
+ * cache_reduce_memory
+ *		Evict least recently used entries until the cache fits in its memory
+ *		limit.
+ *
+ * 'specialkey' is the key of the entry being looked up or filled.  Being the
+ * most recently used, it is evicted last; we return false if that happened.
+ */
+static bool
+cache_reduce_memory(ResultCacheState *rcstate, ResultCacheKey *specialkey)
+{
+	bool		specialkey_intact = true;
+	dlist_mutable_iter iter;
+
+	dlist_foreach_modify(iter, &rcstate->lru_list)
+	{
+		ResultCacheKey *key = dlist_container(ResultCacheKey, lru_node,
+											  iter.cur);
+		ResultCacheEntry *entry;
+
+		entry = resultcache_lookup_hash(rcstate->hashtable, key, key->hash);
+		Assert(entry != NULL);
+
+		if (key == specialkey)
+			specialkey_intact = false;
+		else
+			rcstate->stats.cache_evictions += 1;
+
+		remove_cache_entry(rcstate, entry);
+
+		if (rcstate->mem_used <= rcstate->mem_limit)
+			break;
+	}
+
+	return specialkey_intact;
+}
+
+/*
+ * cache_lookup
+ *		Look up the entry for the parameter values of the current scan,
+ *		creating an empty one if there is none.  *found tells which.
+ *
+ * Returns NULL if there isn't enough memory for even an empty entry.
+ */
+static ResultCacheEntry *
+cache_lookup(ResultCacheState *rcstate, bool *found)
+{
+	ResultCacheKey *key;
+	ResultCacheEntry *entry;
+	MemoryContext oldcontext;
+	uint32		hash;
+
+	prepare_probe_slot(rcstate);
+	hash = ResultCacheHash_hash(rcstate);
+
+	entry = resultcache_insert_hash(rcstate->hashtable, NULL, hash, found);
+
+	if (*found)
+	{
+		/* It's now the most recently used entry */
+		dlist_delete(&entry->key->lru_node);
+		dlist_push_tail(&rcstate->lru_list, &entry->key->lru_node);
+
+		return entry;
+	}
+
+	oldcontext = MemoryContextSwitchTo(rcstate->tableContext);
+
+	key = (ResultCacheKey *) palloc(sizeof(ResultCacheKey));
+	key->params = ExecCopySlotMinimalTuple(rcstate->probeslot);
+	key->hash = hash;
+
+	entry->key = key;
+	entry->tuplehead = NULL;
+	entry->complete = false;
+
+	dlist_push_tail(&rcstate->lru_list, &key->lru_node);
+
+	rcstate->mem_used += EMPTY_ENTRY_MEMORY_BYTES(entry);
+	if (rcstate->mem_used > rcstate->stats.mem_peak)
+		rcstate->stats.mem_peak = rcstate->mem_used;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	if (rcstate->mem_used > rcstate->mem_limit)
+	{
+		if (!cache_reduce_memory(rcstate, key))
+			return NULL;
+
+		/* Evictions may have moved the entry, so look it up again */
+		entry = resultcache_lookup_hash(rcstate->hashtable, key, hash);
+		Assert(entry != NULL);
+	}
+
+	return entry;
+}
+
+/*
+ * cache_store_tuple
+ *		Add the tuple in 'slot' to the end of the entry being filled.
+ *
+ * Returns false if the entry no longer fits in the cache, in which case it
+ * has been removed.
+ */
+static bool
+cache_store_tuple(ResultCacheState *rcstate, TupleTableSlot *slot)
+{
+	ResultCacheEntry *entry = rcstate->entry;
+	ResultCacheTuple *tuple;
+	MemoryContext oldcontext;
+
+	Assert(entry != NULL);
+
+	oldcontext = MemoryContextSwitchTo(rcstate->tableContext);
+
+	tuple = (ResultCacheTuple *) palloc(sizeof(ResultCacheTuple));
+	tuple->mintuple = ExecCopySlotMinimalTuple(slot);
+	tuple->next = NULL;
+
+	rcstate->mem_used += CACHE_TUPLE_BYTES(tuple);
+	if (rcstate->mem_used > rcstate->stats.mem_peak)
+		rcstate->stats.mem_peak = rcstate->mem_used;
+
+	if (entry->tuplehead == NULL)
+		entry->tuplehead = tuple;
+	else
+		rcstate->last_tuple->next = tuple;
+	rcstate->last_tuple = tuple;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	if (rcstate->mem_used > rcstate->mem_limit)
+	{
+		ResultCacheKey *key = entry->key;
+
+		if (!cache_reduce_memory(rcstate, key))
+			return false;
+
+		/* Evictions may have moved the entry, so look it up again */
+		entry = resultcache_lookup_hash(rcstate->hashtable, key, key->hash);
+		Assert(entry != NULL);
+		rcstate->entry = entry;
+	}
+
+	return true;
+}
+
+/*
+ * fill_cache_entry
+ *		Cache the subplan's tuple in 'outerslot' and return it.
+ *
+ * If the entry doesn't fit in the cache anymore, we stop caching for the
+ * rest of this scan.
+ */
+static TupleTableSlot *
+fill_cache_entry(ResultCacheState *node, TupleTableSlot *outerslot)
+{
+	TupleTableSlot *slot = node->ss.ps.ps_ResultTupleSlot;
+
+	if (!cache_store_tuple(node, outerslot))
+	{
+		node->stats.cache_overflows += 1;
+		node->rc_status = RC_CACHE_BYPASS_MODE;
+		node->entry = NULL;
+		node->last_tuple = NULL;
+
+		ExecCopySlot(slot, outerslot);
+		return slot;
+	}
+
+	/* A single-row scan doesn't need to be read to completion */
+	if (node->singlerow)
+		node->entry->complete = true;
+
+	ExecStoreMinimalTuple(node->last_tuple->mintuple, slot, false);
+	return slot;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecResultCache
+ *
+ *		On the first call after a rescan, look up the current parameter
+ *		values in the cache.  If there's a complete entry for them, return
+ *		its tuples; otherwise run the subplan, and remember the tuples it
+ *		returns.
+ * ----------------------------------------------------------------
+ */
+static TupleTableSlot *
+ExecResultCache(PlanState *pstate)
+{
+	ResultCacheState *node = castNode(ResultCacheState, pstate);
+	PlanState  *outerNode = outerPlanState(node);
+	TupleTableSlot *outerslot;
+	TupleTableSlot *slot;
+
+	CHECK_FOR_INTERRUPTS();
+
+	switch (node->rc_status)
+	{
+		case RC_CACHE_LOOKUP:
+			{
+				ResultCacheEntry *entry;
+				bool		found;
+
+				Assert(node->entry == NULL);
+
+				entry = cache_lookup(node, &found);
+
+				if (found && entry->complete)
+				{
+					node->stats.cache_hits += 1;
+
+					node->entry = entry;
+					node->last_tuple = entry->tuplehead;
+
+					/* The subplan may have returned no rows at all */
+					if (entry->tuplehead == NULL)
+					{
+						node->rc_status = RC_END_OF_SCAN;
+						return NULL;
+					}
+
+					node->rc_status = RC_CACHE_FETCH_NEXT_TUPLE;
+
+					slot = node->ss.ps.ps_ResultTupleSlot;
+					ExecStoreMinimalTuple(entry->tuplehead->mintuple, slot,
+										  false);
+					return slot;
+				}
+
+				/* Handle cache miss */
+				node->stats.cache_misses += 1;
+
+				if (entry == NULL)
+				{
+					/* Not even an empty entry fits, don't cache anything */
+					node->stats.cache_overflows += 1;
+					node->rc_status = RC_CACHE_BYPASS_MODE;
+
+					outerslot = ExecProcNode(outerNode);
+					if (TupIsNull(outerslot))
+					{
+						node->rc_status = RC_END_OF_SCAN;
+						return NULL;
+					}
+
+					slot = node->ss.ps.ps_ResultTupleSlot;
+					ExecCopySlot(slot, outerslot);
+					return slot;
+				}
+
+				node->entry = entry;
+				node->last_tuple = NULL;
+
+				/*
+				 * An incomplete entry was left behind by an earlier scan that
+				 * was stopped before the end.  Start it again.
+				 */
+				if (found)
+					entry_purge_tuples(node, entry);
+
+				outerslot = ExecProcNode(outerNode);
+				if (TupIsNull(outerslot))
+				{
+					/* The subplan returned no rows, which we cache too */
+					entry->complete = true;
+					node->rc_status = RC_END_OF_SCAN;
+					return NULL;
+				}
+
+				node->rc_status = RC_FILLING_CACHE;
+				return fill_cache_entry(node, outerslot);
+			}
+
+		case RC_CACHE_FETCH_NEXT_TUPLE:
+			{
+				Assert(node->entry->complete);
+
+				node->last_tuple = node->last_tuple->next;
+				if (node->last_tuple == NULL)
+				{
+					node->rc_status = RC_END_OF_SCAN;
+					return NULL;
+				}
+
+				slot = node->ss.ps.ps_ResultTupleSlot;
+				ExecStoreMinimalTuple(node->last_tuple->mintuple, slot,
+									  false);
+				return slot;
+			}
+
+		case RC_FILLING_CACHE:
+			{
+				Assert(node->entry != NULL);
+
+				outerslot = ExecProcNode(outerNode);
+				if (TupIsNull(outerslot))
+				{
+					/* The entry now holds all the subplan's tuples */
+					node->entry->complete = true;
+					node->rc_status = RC_END_OF_SCAN;
+					return NULL;
+				}
+
+				return fill_cache_entry(node, outerslot);
+			}
+
+		case RC_CACHE_BYPASS_MODE:
+			{
+				outerslot = ExecProcNode(outerNode);
+				if (TupIsNull(outerslot))
+				{
+					node->rc_status = RC_END_OF_SCAN;
+					return NULL;
+				}
+
+				slot = node->ss.ps.ps_ResultTupleSlot;
+				ExecCopySlot(slot, outerslot);
+				return slot;
+			}
+
+		case RC_END_OF_SCAN:
+
+			/* We've already returned NULL for this scan */
+			return NULL;
+
+		default:
+			elog(ERROR, "unrecognized resultcache state: %d",
+				 (int) node->rc_status);
+			return NULL;		/* keep compiler quiet */
+	}
+}
+
+/* ----------------------------------------------------------------
+ *		ExecInitResultCache
+ * ----------------------------------------------------------------
+ */
+ResultCacheState *
+ExecInitResultCache(ResultCache *node, EState *estate, int eflags)
+{
+	ResultCacheState *rcstate;
+	ListCell   *lc;
+	int			i;
+
+	/* check for unsupported flags */
+	Assert(!(eflags & (EXEC_FLAG_BACKWARD | EXEC_FLAG_MARK)));
+
+	/*
+	 * create state structure
+	 */
+	rcstate = makeNode(ResultCacheState);
+	rcstate->ss.ps.plan = (Plan *) node;
+	rcstate->ss.ps.state = estate;
+	rcstate->ss.ps.ExecProcNode = ExecResultCache;
+
+	/*
+	 * Miscellaneous initialization
+	 *
+	 * We need an expression context to evaluate the cache keys.
+	 */
+	ExecAssignExprContext(estate, &rcstate->ss.ps);
+
+	/*
+	 * initialize child nodes
+	 */
+	outerPlanState(rcstate) = ExecInitNode(outerPlan(node), estate, eflags);
+
+	/*
+	 * Initialize return slot and type. No need to initialize projection info
+	 * because this node doesn't do projections.
+	 */
+	ExecInitResultTupleSlotTL(&rcstate->ss.ps, &TTSOpsMinimalTuple);
+	rcstate->ss.ps.ps_ProjInfo = NULL;
+
+	/*
+	 * Set up the slots for the cache keys, and the expressions that compute
+	 * them.
+	 */
+	rcstate->nkeys = node->numKeys;
+	rcstate->hashkeydesc = ExecTypeFromExprList(node->param_exprs);
+	rcstate->tableslot = MakeSingleTupleTableSlot(rcstate->hashkeydesc,
+												  &TTSOpsMinimalTuple);
+	rcstate->probeslot = MakeSingleTupleTableSlot(rcstate->hashkeydesc,
+												  &TTSOpsVirtual);
+
+	rcstate->param_exprs = (ExprState **)
+		palloc(rcstate->nkeys * sizeof(ExprState *));
+	i = 0;
+	foreach(lc, node->param_exprs)
+		rcstate->param_exprs[i++] = ExecInitExpr((Expr *) lfirst(lc),
+												 (PlanState *) rcstate);
+
+	rcstate->tableContext = AllocSetContextCreate(CurrentMemoryContext,
+												  "ResultCacheHashTable",
+												  ALLOCSET_DEFAULT_SIZES);
+	dlist_init(&rcstate->lru_list);
+	rcstate->entry = NULL;
+	rcstate->last_tuple = NULL;
+	rcstate->mem_used = 0;
+	rcstate->mem_limit = work_mem * 1024L;
+	rcstate->singlerow = node->singlerow;
+	rcstate->keyparamids = node->keyparamids;
+	memset(&rcstate->stats, 0, sizeof(ResultCacheInstrumentation));
+
+	build_hash_table(rcstate, node->est_entries);
+
+	rcstate->rc_status = RC_CACHE_LOOKUP;
+
+	return rcstate;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecEndResultCache
+ * ----------------------------------------------------------------
+ */
+void
+ExecEndResultCache(ResultCacheState *node)
+{
+	/*
+	 * clean out the tuple table, the result slot may point into the cache
+	 */
+	ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
+	ExecDropSingleTupleTableSlot(node->tableslot);
+	ExecDropSingleTupleTableSlot(node->probeslot);
+
+	/* Release the cache */
+	MemoryContextDelete(node->tableContext);
+
+	/*
+	 * free exprcontext
+	 */
+	ExecFreeExprContext(&node->ss.ps);
+
+	/*
+	 * shut down the subplan
+	 */
+	ExecEndNode(outerPlanState(node));
+}
+
+void
+ExecReScanResultCache(ResultCacheState *node)
+{
+	PlanState  *outerPlan = outerPlanState(node);
+
+	/* Look up the new parameter values on the next call */
+	node->rc_status = RC_CACHE_LOOKUP;
+	node->entry = NULL;
+	node->last_tuple = NULL;
+	ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
+
+	/*
+	 * if chgParam of subnode is not null then plan will be re-scanned by
+	 * first ExecProcNode.
+	 */
+	if (outerPlan->chgParam == NULL)
+		ExecReScan(outerPlan);
+
+	/*
+	 * The cached results are only valid for the values of the parameters
+	 * outside the cache key that they were computed with.  If any of those
+	 * changed, forget everything.
+	 */
+	if (bms_nonempty_difference(outerPlan->chgParam, node->keyparamids))
+		cache_purge_all(node);
+}
+
+/*
+ * ExecEstimateCacheEntryOverheadBytes
+ *		For use in the query planner to help it estimate the amount of memory
+ *		required to store a single entry in the cache.
+ */
+double
+ExecEstimateCacheEntryOverheadBytes(double ntuples)
+{
+	return sizeof(ResultCacheEntry) + sizeof(ResultCacheKey) +
+		sizeof(ResultCacheTuple) * ntuples;
+}
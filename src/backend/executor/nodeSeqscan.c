@@ -27,12 +27,73 @@
  */
 #include "postgres.h"
 
+#include "access/htup_details.h"
 #include "access/relscan.h"
+#include "access/stratnum.h"
+#include "catalog/pg_opfamily.h"
+#include "catalog/pg_type.h"
 #include "executor/execdebug.h"
 #include "executor/nodeSeqscan.h"
+#include "miscadmin.h"
+#include "utils/float.h"
+#include "utils/lsyscache.h"
 #include "utils/rel.h"
 
+/* GUC parameter */
+bool		enable_vectorized_scan = false;
+
+/*
+ * Batch quals
+ *
+ * When enable_vectorized_scan is on, quals of the form "column op constant"
+ * on integer or floating-point columns, using the standard comparison
+ * operators, are not evaluated through the expression machinery.  Instead,
+ * whenever the heap scan moves to a new page, each such column is extracted
+ * for all visible tuples of the page into a dense array, and the comparison
+ * is done for the whole array in a simple loop that the compiler can
+ * vectorize.  The result is remembered per tuple, and the tuples rejected
+ * are skipped as the scan goes through the page.  Integers are compared as
+ * int64 and floats as float8, which gives the same answers as the cross-type
+ * operators.  All of these operators are strict and can't fail, so it does
+ * no harm to evaluate them ahead of the other quals.
+ */
+typedef enum SeqBatchCmp
+{
+	SEQ_BATCH_EQ,
+	SEQ_BATCH_NE,
+	SEQ_BATCH_LT,
+	SEQ_BATCH_LE,
+	SEQ_BATCH_GT,
+	SEQ_BATCH_GE
+} SeqBatchCmp;
+
+typedef struct SeqScanBatchQual
+{
+	AttrNumber	attno;			/* column compared */
+	Oid			atttype;		/* its type */
+	bool		isfloat;		/* compare as float8, else as int64 */
+	SeqBatchCmp cmp;			/* column cmp constant */
+	int64		ivalue;			/* the constant, if !isfloat */
+	float8		fvalue;			/* the constant, if isfloat */
+} SeqScanBatchQual;
+
+struct SeqScanBatchState
+{
+	int			nquals;
+	SeqScanBatchQual *quals;
+	BlockNumber	block;			/* page "pass" applies to, if valid */
+	bool		pass[MaxHeapTuplesPerPage];
+
+	/* workspace for one column of the current page */
+	bool		nulls[MaxHeapTuplesPerPage];
+	int64		ivalues[MaxHeapTuplesPerPage];
+	float8		fvalues[MaxHeapTuplesPerPage];
+};
+
 static TupleTableSlot *SeqNext(SeqScanState *node);
+static SeqScanBatchState *SeqBatchInit(SeqScan *node, List **residual);
+static void SeqBatchEvalPage(SeqScanState *node, HeapScanDesc scan);
+static bool SeqBatchEvalSlot(SeqScanState *node, TupleTableSlot *slot);
 
 /* ----------------------------------------------------------------
  *						Scan Support
@@ -77,7 +138,37 @@ SeqNext(SeqScanState *node)
 	/*
 	 * get the next tuple from the table
 	 */
-	tuple = heap_getnext(scandesc, direction);
+	if (node->batch == NULL)
+		tuple = heap_getnext(scandesc, direction);
+	else
+	{
+		/* skip over the tuples that fail the batch quals */
+		for (;;)
+		{
+			tuple = heap_getnext(scandesc, direction);
+			if (tuple == NULL)
+				break;
+
+			if (scandesc->rs_pageatatime)
+			{
+				if (scandesc->rs_cblock != node->batch->block)
+				{
+					CHECK_FOR_INTERRUPTS();
+					SeqBatchEvalPage(node, scandesc);
+				}
+				if (node->batch->pass[scandesc->rs_cindex])
+					break;
+			}
+			else
+			{
+				/* no page-at-a-time visibility checks, so one at a time */
+				ExecStoreBufferHeapTuple(tuple, slot, scandesc->rs_cbuf);
+				if (SeqBatchEvalSlot(node, slot))
+					break;
+			}
+			InstrCountFiltered1(node, 1);
+		}
+	}
 
 	/*
 	 * save the tuple and the buffer returned to us by the access methods in
@@ -107,10 +198,386 @@ SeqRecheck(SeqScanState *node, TupleTableSlot *slot)
 	/*
 	 * Note that unlike IndexScan, SeqScan never use keys in heap_beginscan
 	 * (and this is very bad) - so, here we do not check are keys ok or not.
+	 * The batch quals are not part of ps.qual, though, so check those.
 	 */
+	if (node->batch != NULL)
+		return SeqBatchEvalSlot(node, slot);
 	return true;
 }
 
+/*
+ * Compare a column value with a batch qual's constant.  SeqBatchEvalPage
+ * has the same logic, spelled out as loops over a page's worth of values.
+ */
+static inline bool
+SeqBatchCompare(SeqScanBatchQual *q, int64 ivalue, float8 fvalue)
+{
+	if (q->isfloat)
+	{
+		switch (q->cmp)
+		{
+			case SEQ_BATCH_EQ:
+				return float8_eq(fvalue, q->fvalue);
+			case SEQ_BATCH_NE:
+				return float8_ne(fvalue, q->fvalue);
+			case SEQ_BATCH_LT:
+				return float8_lt(fvalue, q->fvalue);
+			case SEQ_BATCH_LE:
+				return float8_le(fvalue, q->fvalue);
+			case SEQ_BATCH_GT:
+				return float8_gt(fvalue, q->fvalue);
+			case SEQ_BATCH_GE:
+				return float8_ge(fvalue, q->fvalue);
+		}
+	}
+	else
+	{
+		switch (q->cmp)
+		{
+			case SEQ_BATCH_EQ:
+				return ivalue == q->ivalue;
+			case SEQ_BATCH_NE:
+				return ivalue != q->ivalue;
+			case SEQ_BATCH_LT:
+				return ivalue < q->ivalue;
+			case SEQ_BATCH_LE:
+				return ivalue <= q->ivalue;
+			case SEQ_BATCH_GT:
+				return ivalue > q->ivalue;
+			case SEQ_BATCH_GE:
+				return ivalue >= q->ivalue;
+		}
+	}
+	return false;				/* keep compiler quiet */
+}
+
+/*
+ * Convert a non-null column value to the representation it is compared in.
+ */
+static inline void
+SeqBatchConvert(SeqScanBatchQual *q, Datum value,
+				int64 *ivalue, float8 *fvalue)
+{
+	switch (q->atttype)
+	{
+		case INT2OID:
+			*ivalue = DatumGetInt16(value);
+			break;
+		case INT4OID:
+			*ivalue = DatumGetInt32(value);
+			break;
+		case INT8OID:
+			*ivalue = DatumGetInt64(value);
+			break;
+		case FLOAT4OID:
+			*fvalue = DatumGetFloat4(value);
+			break;
+		case FLOAT8OID:
+			*fvalue = DatumGetFloat8(value);
+			break;
+		default:
+			elog(ERROR, "unexpected type %u in batch qual", q->atttype);
+	}
+}
+
+/*
+ * Check the batch quals for the tuple in "slot".
+ */
+static bool
+SeqBatchEvalSlot(SeqScanState *node, TupleTableSlot *slot)
+{
+	SeqScanBatchState *batch = node->batch;
+	int			i;
+
+	for (i = 0; i < batch->nquals; i++)
+	{
+		SeqScanBatchQual *q = &batch->quals[i];
+		Datum		value;
+		bool		isnull;
+		int64		ivalue = 0;
+		float8		fvalue = 0;
+
+		value = slot_getattr(slot, q->attno, &isnull);
+		if (isnull)
+			return false;
+		SeqBatchConvert(q, value, &ivalue, &fvalue);
+		if (!SeqBatchCompare(q, ivalue, fvalue))
+			return false;
+	}
+
+	return true;
+}
+
+/* AND the result of "value OP const" into pass[], for all n values */
+#define SEQ_BATCH_LOOP(expr) \
+	do { \
+		for (i = 0; i < n; i++) \
+			pass[i] &= !nulls[i] & (expr); \
+	} while (0)
+
+/*
+ * Check the batch quals for all the visible tuples of the page the heap
+ * scan has just moved to.  The results are left in batch->pass, indexed the
+ * same as the scan's rs_vistuples.
+ */
+static void
+SeqBatchEvalPage(SeqScanState *node, HeapScanDesc scan)
+{
+	SeqScanBatchState *batch = node->batch;
+	TupleDesc	tupdesc = RelationGetDescr(scan->rs_rd);
+	Page		page = BufferGetPage(scan->rs_cbuf);
+	int			n = scan->rs_ntuples;
+	bool	   *pass = batch->pass;
+	bool	   *nulls = batch->nulls;
+	int64	   *ivalues = batch->ivalues;
+	float8	   *fvalues = batch->fvalues;
+	int			qualno;
+	int			i;
+
+	memset(pass, true, n * sizeof(bool));
+
+	for (qualno = 0; qualno < batch->nquals; qualno++)
+	{
+		SeqScanBatchQual *q = &batch->quals[qualno];
+		HeapTupleData tuple;
+
+		/* gather the column, not bothering with tuples already rejected */
+		for (i = 0; i < n; i++)
+		{
+			ItemId		lpp;
+			Datum		value;
+
+			nulls[i] = true;
+			if (!pass[i])
+				continue;
+
+			lpp = PageGetItemId(page, scan->rs_vistuples[i]);
+			tuple.t_data = (HeapTupleHeader) PageGetItem(page, lpp);
+			tuple.t_len = ItemIdGetLength(lpp);
+			value = heap_getattr(&tuple, q->attno, tupdesc, &nulls[i]);
+			if (!nulls[i])
+				SeqBatchConvert(q, value, &ivalues[i], &fvalues[i]);
+		}
+
+		/* and compare */
+		if (q->isfloat)
+		{
+			float8		c = q->fvalue;
+
+			switch (q->cmp)
+			{
+				case SEQ_BATCH_EQ:
+					SEQ_BATCH_LOOP(float8_eq(fvalues[i], c));
+					break;
+				case SEQ_BATCH_NE:
+					SEQ_BATCH_LOOP(float8_ne(fvalues[i], c));
+					break;
+				case SEQ_BATCH_LT:
+					SEQ_BATCH_LOOP(float8_lt(fvalues[i], c));
+					break;
+				case SEQ_BATCH_LE:
+					SEQ_BATCH_LOOP(float8_le(fvalues[i], c));
+					break;
+				case SEQ_BATCH_GT:
+					SEQ_BATCH_LOOP(float8_gt(fvalues[i], c));
+					break;
+				case SEQ_BATCH_GE:
+					SEQ_BATCH_LOOP(float8_ge(fvalues[i], c));
+					break;
+			}
+		}
+		else
+		{
+			int64		c = q->ivalue;
+
+			switch (q->cmp)
+			{
+				case SEQ_BATCH_EQ:
+					SEQ_BATCH_LOOP(ivalues[i] == c);
+					break;
+				case SEQ_BATCH_NE:
+					SEQ_BATCH_LOOP(ivalues[i] != c);
+					break;
+				case SEQ_BATCH_LT:
+					SEQ_BATCH_LOOP(ivalues[i] < c);
+					break;
+				case SEQ_BATCH_LE:
+					SEQ_BATCH_LOOP(ivalues[i] <= c);
+					break;
+				case SEQ_BATCH_GT:
+					SEQ_BATCH_LOOP(ivalues[i] > c);
+					break;
+				case SEQ_BATCH_GE:
+					SEQ_BATCH_LOOP(ivalues[i] >= c);
+					break;
+			}
+		}
+	}
+
+	batch->block = scan->rs_cblock;
+}
+
+/*
+ * If "clause" is a comparison we can evaluate as a batch qual, fill in *q
+ * and return true.
+ */
+static bool
+SeqBatchQualFromClause(Expr *clause, Index scanrelid, SeqScanBatchQual *q)
+{
+	OpExpr	   *opexpr;
+	Oid			opno;
+	Var		   *var;
+	Const	   *con;
+	Oid			opfamily;
+	int			strategy;
+	bool		negated = false;
+
+	if (!IsA(clause, OpExpr))
+		return false;
+	opexpr = (OpExpr *) clause;
+	if (list_length(opexpr->args) != 2)
+		return false;
+	opno = opexpr->opno;
+
+	if (IsA(linitial(opexpr->args), Var) && IsA(lsecond(opexpr->args), Const))
+	{
+		var = (Var *) linitial(opexpr->args);
+		con = (Const *) lsecond(opexpr->args);
+	}
+	else if (IsA(linitial(opexpr->args), Const) &&
+			 IsA(lsecond(opexpr->args), Var))
+	{
+		/* put the column on the left */
+		con = (Const *) linitial(opexpr->args);
+		var = (Var *) lsecond(opexpr->args);
+		opno = get_commutator(opno);
+		if (!OidIsValid(opno))
+			return false;
+	}
+	else
+		return false;
+
+	if (var->varno != scanrelid || var->varattno <= 0 ||
+		var->varlevelsup != 0 || con->constisnull)
+		return false;
+
+	switch (var->vartype)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+			opfamily = INTEGER_BTREE_FAM_OID;
+			q->isfloat = false;
+			break;
+		case FLOAT4OID:
+		case FLOAT8OID:
+			opfamily = FLOAT_BTREE_FAM_OID;
+			q->isfloat = true;
+			break;
+		default:
+			return false;
+	}
+
+	strategy = get_op_opfamily_strategy(opno, opfamily);
+	if (strategy == 0)
+	{
+		/* <> isn't a btree operator, but its negator is */
+		opno = get_negator(opno);
+		if (!OidIsValid(opno))
+			return false;
+		strategy = get_op_opfamily_strategy(opno, opfamily);
+		if (strategy != BTEqualStrategyNumber)
+			return false;
+		negated = true;
+	}
+
+	switch (strategy)
+	{
+		case BTLessStrategyNumber:
+			q->cmp = SEQ_BATCH_LT;
+			break;
+		case BTLessEqualStrategyNumber:
+			q->cmp = SEQ_BATCH_LE;
+			break;
+		case BTEqualStrategyNumber:
+			q->cmp = negated ? SEQ_BATCH_NE : SEQ_BATCH_EQ;
+			break;
+		case BTGreaterEqualStrategyNumber:
+			q->cmp = SEQ_BATCH_GE;
+			break;
+		case BTGreaterStrategyNumber:
+			q->cmp = SEQ_BATCH_GT;
+			break;
+		default:
+			return false;
+	}
+
+	/* any member of the family has its inputs in the family */
+	switch (con->consttype)
+	{
+		case INT2OID:
+			q->ivalue = DatumGetInt16(con->constvalue);
+			break;
+		case INT4OID:
+			q->ivalue = DatumGetInt32(con->constvalue);
+			break;
+		case INT8OID:
+			q->ivalue = DatumGetInt64(con->constvalue);
+			break;
+		case FLOAT4OID:
+			q->fvalue = DatumGetFloat4(con->constvalue);
+			break;
+		case FLOAT8OID:
+			q->fvalue = DatumGetFloat8(con->constvalue);
+			break;
+		default:
+			return false;
+	}
+
+	q->attno = var->varattno;
+	q->atttype = var->vartype;
+	return true;
+}
+
+/*
+ * Split the quals of a SeqScan into batch quals, returned as a new batch
+ * state, and the rest, returned in *residual.  Returns NULL if none of the
+ * quals qualifies.
+ */
+static SeqScanBatchState *
+SeqBatchInit(SeqScan *node, List **residual)
+{
+	SeqScanBatchState *batch;
+	ListCell   *lc;
+
+	batch = (SeqScanBatchState *) palloc(sizeof(SeqScanBatchState));
+	batch->nquals = 0;
+	batch->quals = (SeqScanBatchQual *)
+		palloc(list_length(node->plan.qual) * sizeof(SeqScanBatchQual));
+	batch->block = InvalidBlockNumber;
+
+	*residual = NIL;
+	foreach(lc, node->plan.qual)
+	{
+		Expr	   *clause = (Expr *) lfirst(lc);
+
+		if (SeqBatchQualFromClause(clause, node->scanrelid,
+								   &batch->quals[batch->nquals]))
+			batch->nquals++;
+		else
+			*residual = lappend(*residual, clause);
+	}
+
+	if (batch->nquals == 0)
+	{
+		pfree(batch->quals);
+		pfree(batch);
+		return NULL;
+	}
+
+	return batch;
+}
+
 /* ----------------------------------------------------------------
  *		ExecSeqScan(node)
  *
@@ -182,10 +649,24 @@ ExecInitSeqScan(SeqScan *node, EState *estate, int eflags)
 	ExecAssignScanProjectionInfo(&scanstate->ss);
 
 	/*
-	 * initialize child expressions
+	 * initialize child expressions, taking out the quals that can be checked
+	 * a page at a time if enabled
 	 */
-	scanstate->ss.ps.qual =
-		ExecInitQual(node->plan.qual, (PlanState *) scanstate);
+	if (enable_vectorized_scan && node->plan.qual != NIL)
+	{
+		List	   *residual;
+
+		scanstate->batch = SeqBatchInit(node, &residual);
+		if (scanstate->batch != NULL)
+			scanstate->ss.ps.qual =
+				ExecInitQual(residual, (PlanState *) scanstate);
+		else
+			scanstate->ss.ps.qual =
+				ExecInitQual(node->plan.qual, (PlanState *) scanstate);
+	}
+	else
+		scanstate->ss.ps.qual =
+			ExecInitQual(node->plan.qual, (PlanState *) scanstate);
 
 	return scanstate;
 }
@@ -247,6 +728,10 @@ ExecReScanSeqScan(SeqScanState *node)
 		heap_rescan(scan,		/* scan desc */
 					NULL);		/* new scan keys */
 
+	/* the first page may be visible differently this time */
+	if (node->batch != NULL)
+		node->batch->block = InvalidBlockNumber;
+
 	ExecScanReScan((ScanState *) node);
 }
 
@@ -24,6 +24,7 @@
 #include "executor/executor.h"
 #include "executor/spi_priv.h"
 #include "miscadmin.h"
+#include "portability/instr_time.h"
 #include "tcop/pquery.h"
 #include "tcop/utility.h"
 #include "utils/builtins.h"
@@ -2099,6 +2100,7 @@ _SPI_execute_plan(SPIPlanPtr plan, ParamListInfo paramLI,
 		CachedPlanSource *plansource = (CachedPlanSource *) lfirst(lc1);
 		List	   *stmt_list;
 		ListCell   *lc2;
+		instr_time	starttime;
 
 		spierrcontext.arg = (void *) plansource->query_string;
 
@@ -2154,6 +2156,9 @@ _SPI_execute_plan(SPIPlanPtr plan, ParamListInfo paramLI,
 		cplan = GetCachedPlan(plansource, paramLI, plan->saved, _SPI_current->queryEnv);
 		stmt_list = cplan->stmt_list;
 
+		if (plan_cache_runtime_feedback)
+			INSTR_TIME_SET_CURRENT(starttime);
+
 		/*
 		 * In the default non-read-only case, get a new snapshot, replacing
 		 * any that we pushed in a previous cycle.
@@ -2330,6 +2335,17 @@ _SPI_execute_plan(SPIPlanPtr plan, ParamListInfo paramLI,
 			}
 		}
 
+		/* Let the plan cache know how long that took, unless it's one-shot */
+		if (plan_cache_runtime_feedback && !plan->oneshot)
+		{
+			instr_time	endtime;
+
+			INSTR_TIME_SET_CURRENT(endtime);
+			INSTR_TIME_SUBTRACT(endtime, starttime);
+			CachedPlanRecordRuntime(plansource, cplan,
+									INSTR_TIME_GET_MILLISEC(endtime));
+		}
+
 		/* Done with this plan, so release refcount */
 		ReleaseCachedPlan(cplan, plan->saved);
 		cplan = NULL;
@@ -20,11 +20,13 @@
 
 #include <llvm-c/Core.h>
 
+#include "access/hash.h"
 #include "access/htup_details.h"
 #include "access/tupdesc_details.h"
 #include "executor/tuptable.h"
 #include "jit/llvmjit.h"
 #include "jit/llvmjit_emit.h"
+#include "utils/memutils.h"
 
 
 /*
@@ -751,3 +753,193 @@ slot_compile_deform(LLVMJitContext *context, TupleDesc desc,
 
 	return v_deform_fn;
 }
+
+
+/*
+ * Per-backend cache of deforming functions.
+ *
+ * The code slot_compile_deform() generates depends only on the slot type,
+ * the number of attributes to deform and on the physical properties of the
+ * tuple descriptor's attributes; in particular it contains no pointers to
+ * query-specific data.  That makes it possible to keep such functions around
+ * after the JIT context they were created for is gone, and to call them from
+ * the code generated for later queries against tables of the same layout,
+ * instead of generating, optimizing and emitting the same function again.
+ *
+ * Cached functions are emitted in modules of their own, which are never
+ * removed from the ORC stack, so the function pointers stay valid for the
+ * lifetime of the backend.  jit_deform_cache_size limits how many functions
+ * we keep.
+ */
+typedef struct DeformCacheKeyAttr
+{
+	int16		attlen;
+	char		attalign;
+	bool		attbyval;
+	bool		attnotnull;
+	bool		atthasmissing;
+} DeformCacheKeyAttr;
+
+typedef struct DeformCacheKey
+{
+	const TupleTableSlotOps *ops;
+	int			natts;			/* number of attributes to deform */
+	int			desc_natts;		/* number of attributes in descriptor */
+	DeformCacheKeyAttr attrs[FLEXIBLE_ARRAY_MEMBER];
+} DeformCacheKey;
+
+typedef struct DeformCacheEntry
+{
+	uint32		hash;			/* hash of key */
+	DeformCacheKey *key;
+	Size		keylen;
+	bool		optimized;		/* was the function emitted with PGJIT_OPT3 */
+	void	   *fn;				/* the emitted function */
+} DeformCacheEntry;
+
+static DeformCacheEntry *deform_cache = NULL;
+static int	deform_cache_used = 0;
+static int	deform_cache_allocated = 0;
+
+/*
+ * Return a pointer to a deforming function for the given tuple descriptor,
+ * slot type and number of attributes, generating and emitting it if it's not
+ * in the cache yet.  Returns NULL if the function can't be cached, in which
+ * case the caller should generate it in its own module.
+ */
+void *
+slot_get_cached_deform(LLVMJitContext *context, TupleDesc desc,
+					   const TupleTableSlotOps *ops, int natts)
+{
+	DeformCacheKey *key;
+	Size		keylen;
+	uint32		hash;
+	bool		optimized = (context->base.flags & PGJIT_OPT3) != 0;
+	DeformCacheEntry *entry = NULL;
+	LLVMJitContext tmpcontext;
+	LLVMValueRef v_deform_fn;
+	char	   *funcname;
+	void	   *fn;
+	int			i;
+
+	if (jit_deform_cache_size <= 0)
+		return NULL;
+
+	/* virtual tuples never need deforming, and other types aren't JITed */
+	if (ops != &TTSOpsHeapTuple && ops != &TTSOpsBufferHeapTuple &&
+		ops != &TTSOpsMinimalTuple)
+		return NULL;
+
+	/* build the key; zeroed so padding doesn't get in the way of memcmp */
+	keylen = offsetof(DeformCacheKey, attrs) +
+		desc->natts * sizeof(DeformCacheKeyAttr);
+	key = (DeformCacheKey *) palloc0(keylen);
+	key->ops = ops;
+	key->natts = natts;
+	key->desc_natts = desc->natts;
+	for (i = 0; i < desc->natts; i++)
+	{
+		Form_pg_attribute att = TupleDescAttr(desc, i);
+
+		key->attrs[i].attlen = att->attlen;
+		key->attrs[i].attalign = att->attalign;
+		key->attrs[i].attbyval = att->attbyval;
+		key->attrs[i].attnotnull = att->attnotnull;
+		key->attrs[i].atthasmissing = att->atthasmissing;
+	}
+	hash = DatumGetUInt32(hash_any((unsigned char *) key, keylen));
+
+	for (i = 0; i < deform_cache_used; i++)
+	{
+		DeformCacheEntry *e = &deform_cache[i];
+
+		if (e->hash == hash && e->keylen == keylen &&
+			memcmp(e->key, key, keylen) == 0)
+		{
+			entry = e;
+			break;
+		}
+	}
+
+	/* an optimized function serves unoptimized callers as well */
+	if (entry != NULL && (entry->optimized || !optimized))
+	{
+		pfree(key);
+		return entry->fn;
+	}
+
+	if (entry == NULL && deform_cache_used >= jit_deform_cache_size)
+	{
+		pfree(key);
+		return NULL;
+	}
+
+	/*
+	 * Generate the function in a module of its own, using a context that's
+	 * not registered with any resource owner and thus never releases it.
+	 * Time spent is charged to the caller's context.
+	 */
+	memset(&tmpcontext, 0, sizeof(tmpcontext));
+	tmpcontext.base.flags = context->base.flags & PGJIT_OPT3;
+
+	v_deform_fn = slot_compile_deform(&tmpcontext, desc, ops, natts);
+	if (v_deform_fn == NULL)
+	{
+		pfree(key);
+		return NULL;
+	}
+
+	/* it has to be visible to be looked up, and not optimized away */
+	LLVMSetLinkage(v_deform_fn, LLVMExternalLinkage);
+	LLVMSetVisibility(v_deform_fn, LLVMDefaultVisibility);
+	funcname = pstrdup(LLVMGetValueName(v_deform_fn));
+
+	fn = llvm_get_function(&tmpcontext, funcname);
+	pfree(funcname);
+
+	context->base.instr.created_functions +=
+		tmpcontext.base.instr.created_functions;
+	INSTR_TIME_ADD(context->base.instr.inlining_counter,
+				   tmpcontext.base.instr.inlining_counter);
+	INSTR_TIME_ADD(context->base.instr.optimization_counter,
+				   tmpcontext.base.instr.optimization_counter);
+	INSTR_TIME_ADD(context->base.instr.emission_counter,
+				   tmpcontext.base.instr.emission_counter);
+
+	/*
+	 * Remember the function.  An unoptimized one that we're replacing stays
+	 * emitted, expressions compiled earlier may still be using it.
+	 */
+	if (entry != NULL)
+	{
+		pfree(key);
+		entry->optimized = optimized;
+		entry->fn = fn;
+		return fn;
+	}
+
+	if (deform_cache_used >= deform_cache_allocated)
+	{
+		int			newsize = Max(16, deform_cache_allocated * 2);
+
+		if (deform_cache == NULL)
+			deform_cache = (DeformCacheEntry *)
+				MemoryContextAlloc(TopMemoryContext,
+								   newsize * sizeof(DeformCacheEntry));
+		else
+			deform_cache = (DeformCacheEntry *)
+				repalloc(deform_cache, newsize * sizeof(DeformCacheEntry));
+		deform_cache_allocated = newsize;
+	}
+
+	entry = &deform_cache[deform_cache_used++];
+	entry->hash = hash;
+	entry->key = (DeformCacheKey *) MemoryContextAlloc(TopMemoryContext, keylen);
+	memcpy(entry->key, key, keylen);
+	entry->keylen = keylen;
+	entry->optimized = optimized;
+	entry->fn = fn;
+	pfree(key);
+
+	return fn;
+}
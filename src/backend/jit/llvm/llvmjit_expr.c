@@ -322,10 +322,35 @@ llvm_compile_expr(ExprState *state)
 					 */
 					if (tts_ops && desc && (context->base.flags & PGJIT_DEFORM))
 					{
-						l_jit_deform =
-							slot_compile_deform(context, desc,
-												tts_ops,
-												op->d.fetch.last_var);
+						void	   *cached_deform;
+
+						/*
+						 * Prefer a function shared with earlier queries, see
+						 * slot_get_cached_deform(); it is called through a
+						 * pointer, as it lives in a different module.
+						 */
+						cached_deform =
+							slot_get_cached_deform(context, desc,
+												   tts_ops,
+												   op->d.fetch.last_var);
+						if (cached_deform)
+						{
+							LLVMTypeRef param_types[1];
+							LLVMTypeRef deform_sig;
+
+							param_types[0] = l_ptr(StructTupleTableSlot);
+							deform_sig = LLVMFunctionType(LLVMVoidType(),
+														  param_types,
+														  lengthof(param_types),
+														  0);
+							l_jit_deform = l_ptr_const(cached_deform,
+													   l_ptr(deform_sig));
+						}
+						else
+							l_jit_deform =
+								slot_compile_deform(context, desc,
+													tts_ops,
+													op->d.fetch.last_var);
 					}
 
 					if (l_jit_deform)
@@ -564,6 +589,22 @@ llvm_compile_expr(ExprState *state)
 					break;
 				}
 
+			/*
+			 * The inlined comparisons are just compiled as calls to their
+			 * functions; LLVM can inline those itself.
+			 */
+			case EEOP_FUNCEXPR_STRICT_INT4EQ:
+			case EEOP_FUNCEXPR_STRICT_INT4NE:
+			case EEOP_FUNCEXPR_STRICT_INT4LT:
+			case EEOP_FUNCEXPR_STRICT_INT4LE:
+			case EEOP_FUNCEXPR_STRICT_INT4GT:
+			case EEOP_FUNCEXPR_STRICT_INT4GE:
+			case EEOP_FUNCEXPR_STRICT_INT8EQ:
+			case EEOP_FUNCEXPR_STRICT_INT8NE:
+			case EEOP_FUNCEXPR_STRICT_INT8LT:
+			case EEOP_FUNCEXPR_STRICT_INT8LE:
+			case EEOP_FUNCEXPR_STRICT_INT8GT:
+			case EEOP_FUNCEXPR_STRICT_INT8GE:
 			case EEOP_FUNCEXPR_STRICT:
 				{
 					FunctionCallInfo fcinfo = op->d.func.fcinfo_data;
@@ -1934,6 +1975,12 @@ llvm_compile_expr(ExprState *state)
 				LLVMBuildBr(b, opblocks[i + 1]);
 				break;
 
+			case EEOP_HASHED_SCALARARRAYOP:
+				build_EvalXFunc(b, mod, "ExecEvalHashedScalarArrayOp",
+								v_state, v_econtext, op);
+				LLVMBuildBr(b, opblocks[i + 1]);
+				break;
+
 			case EEOP_XMLEXPR:
 				build_EvalXFunc(b, mod, "ExecEvalXmlExpr",
 								v_state, v_econtext, op);
@@ -2134,6 +2181,36 @@ llvm_compile_expr(ExprState *state)
 					break;
 				}
 
+			case EEOP_AGG_PLAIN_PERGROUP_NULLCHECK:
+				{
+					int			jumpnull;
+					LLVMValueRef v_aggstatep;
+					LLVMValueRef v_allpergroupsp;
+					LLVMValueRef v_pergroup_allaggs;
+					LLVMValueRef v_setoff;
+
+					jumpnull = op->d.agg_plain_pergroup_nullcheck.jumpnull;
+
+					/*
+					 * pergroup_allaggs = aggstate->all_pergroups
+					 * [op->d.agg_plain_pergroup_nullcheck.setoff];
+					 */
+					v_aggstatep = l_ptr_const(op->d.agg_plain_pergroup_nullcheck.aggstate,
+											  l_ptr(StructAggState));
+					v_allpergroupsp =
+						l_load_struct_gep(b, v_aggstatep,
+										  FIELDNO_AGGSTATE_ALL_PERGROUPS,
+										  "aggstate.all_pergroups");
+					v_setoff = l_int32_const(op->d.agg_plain_pergroup_nullcheck.setoff);
+					v_pergroup_allaggs = l_load_gep1(b, v_allpergroupsp, v_setoff, "");
+
+					LLVMBuildCondBr(b,
+									LLVMBuildIsNull(b, v_pergroup_allaggs, ""),
+									opblocks[jumpnull],
+									opblocks[i + 1]);
+					break;
+				}
+
 			case EEOP_AGG_INIT_TRANS:
 				{
 					AggState   *aggstate;
@@ -128,6 +128,18 @@ bloom_free(bloom_filter *filter)
 	pfree(filter);
 }
 
+/*
+ * Size of Bloom filter in bytes
+ *
+ * A filter is a single flat allocation, so a caller may copy this many bytes
+ * elsewhere (e.g. into shared memory) and probe the copy.
+ */
+Size
+bloom_total_size(bloom_filter *filter)
+{
+	return offsetof(bloom_filter, bitset) + filter->m / BITS_PER_BYTE;
+}
+
 /*
  * Add element to Bloom filter
  */
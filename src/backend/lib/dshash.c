@@ -17,8 +17,10 @@
  * is only expected to happen a small number of times until a stable size is
  * found, since growth is geometric.
  *
- * Future versions may support iterators and incremental resizing; for now
- * the implementation is minimalist.
+ * Sequential scans visit one partition at a time, holding only that
+ * partition's lock, so they don't block concurrent operations on the rest of
+ * the table.  Future versions may support incremental resizing; for now the
+ * implementation is minimalist.
  *
  * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
@@ -574,6 +576,133 @@ dshash_release_lock(dshash_table *hash_table, void *entry)
 	LWLockRelease(PARTITION_LOCK(hash_table, partition_index));
 }
 
+/*
+ * Initialize a sequential scan of the hash table.  If 'exclusive' is true,
+ * the partition locks are taken in exclusive mode, which allows
+ * dshash_delete_current to be used.
+ *
+ * The scan visits the partitions in order, holding the lock of the partition
+ * being scanned.  Entries inserted or deleted by other backends in partitions
+ * not yet visited may or may not be returned, but no entry is returned twice,
+ * even if the table is resized in between.  The caller must not use any other
+ * dshash operation on the same table until dshash_seq_term is called.
+ */
+void
+dshash_seq_init(dshash_seq_status *status, dshash_table *hash_table,
+				bool exclusive)
+{
+	Assert(hash_table->control->magic == DSHASH_MAGIC);
+	Assert(!hash_table->find_locked);
+
+	status->hash_table = hash_table;
+	status->curpartition = -1;
+	status->curbucket = 0;
+	status->endbucket = 0;
+	status->curitem = NULL;
+	status->pnextitem = InvalidDsaPointer;
+	status->exclusive = exclusive;
+}
+
+/*
+ * Return the next entry of a sequential scan, or NULL when the scan is done.
+ * The returned entry is locked until the next call; the lock is released
+ * when the scan moves on to another partition.
+ */
+void *
+dshash_seq_next(dshash_seq_status *status)
+{
+	dshash_table *hash_table = status->hash_table;
+
+	for (;;)
+	{
+		/* Return the next item in the current bucket, if any */
+		if (DsaPointerIsValid(status->pnextitem))
+		{
+			status->curitem = dsa_get_address(hash_table->area,
+											  status->pnextitem);
+
+			/* Remember the follower, in case the caller deletes this one */
+			status->pnextitem = status->curitem->next;
+			return ENTRY_FROM_ITEM(status->curitem);
+		}
+		status->curitem = NULL;
+
+		/* Move on to the next bucket of the current partition */
+		if (status->curbucket < status->endbucket)
+		{
+			status->pnextitem = hash_table->buckets[status->curbucket++];
+			continue;
+		}
+
+		/* This partition is done, so move on to the next one */
+		if (status->curpartition >= DSHASH_NUM_PARTITIONS)
+			return NULL;
+		if (status->curpartition >= 0)
+			LWLockRelease(PARTITION_LOCK(hash_table, status->curpartition));
+		hash_table->find_locked = false;
+		hash_table->find_exclusively_locked = false;
+
+		if (++status->curpartition >= DSHASH_NUM_PARTITIONS)
+			return NULL;
+
+		LWLockAcquire(PARTITION_LOCK(hash_table, status->curpartition),
+					  status->exclusive ? LW_EXCLUSIVE : LW_SHARED);
+		hash_table->find_locked = true;
+		hash_table->find_exclusively_locked = status->exclusive;
+
+		/*
+		 * The table can have been resized since we looked at the previous
+		 * partition, but a partition always covers the same set of hash
+		 * values, whatever the number of buckets it is split into.
+		 */
+		ensure_valid_bucket_pointers(hash_table);
+		status->curbucket =
+			BUCKET_INDEX_FOR_PARTITION(status->curpartition,
+									   hash_table->size_log2);
+		status->endbucket =
+			BUCKET_INDEX_FOR_PARTITION(status->curpartition + 1,
+									   hash_table->size_log2);
+	}
+}
+
+/*
+ * End a sequential scan, releasing the lock it holds, if any.  This must be
+ * called even if dshash_seq_next has returned NULL.
+ */
+void
+dshash_seq_term(dshash_seq_status *status)
+{
+	dshash_table *hash_table = status->hash_table;
+
+	if (status->curpartition >= 0 &&
+		status->curpartition < DSHASH_NUM_PARTITIONS)
+		LWLockRelease(PARTITION_LOCK(hash_table, status->curpartition));
+	status->curpartition = DSHASH_NUM_PARTITIONS;
+	hash_table->find_locked = false;
+	hash_table->find_exclusively_locked = false;
+}
+
+/*
+ * Remove the entry last returned by dshash_seq_next.  The scan must have
+ * been started in exclusive mode.
+ */
+void
+dshash_delete_current(dshash_seq_status *status)
+{
+	dshash_table *hash_table = status->hash_table;
+	dshash_table_item *item = status->curitem;
+
+	Assert(status->exclusive);
+	Assert(item != NULL);
+	Assert(PARTITION_FOR_HASH(item->hash) == status->curpartition);
+	Assert(LWLockHeldByMeInMode(PARTITION_LOCK(hash_table,
+											   status->curpartition),
+								LW_EXCLUSIVE));
+
+	delete_item(hash_table, item);
+	status->curitem = NULL;
+}
+
 /*
  * A compare function that forwards to memcmp.
  */
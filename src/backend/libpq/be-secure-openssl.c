@@ -225,6 +225,22 @@ be_tls_init(bool isServerStart)
 	if (SSLPreferServerCiphers)
 		SSL_CTX_set_options(context, SSL_OP_CIPHER_SERVER_PREFERENCE);
 
+	/*
+	 * Ask OpenSSL to hand the record layer over to the kernel after the
+	 * handshake, if the cipher and the kernel allow.  It silently falls back
+	 * to userspace encryption otherwise.
+	 */
+	if (ssl_ktls)
+	{
+#ifdef SSL_OP_ENABLE_KTLS
+		SSL_CTX_set_options(context, SSL_OP_ENABLE_KTLS);
+#else
+		ereport(isServerStart ? WARNING : LOG,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("\"ssl_ktls\" is ignored because the SSL library does not support kernel TLS")));
+#endif
+	}
+
 	/*
 	 * Load CA store, so we can verify client certificates if needed.
 	 */
@@ -672,6 +688,17 @@ my_sock_read(BIO *h, char *buf, int size)
 {
 	int			res = 0;
 
+#ifdef SSL_OP_ENABLE_KTLS
+
+	/*
+	 * Once the kernel does the decryption, non-data records have to be
+	 * received with recvmsg(), which only OpenSSL's own socket BIO knows how
+	 * to do.
+	 */
+	if (BIO_get_ktls_recv(h))
+		return BIO_meth_get_read(BIO_s_socket()) (h, buf, size);
+#endif
+
 	if (buf != NULL)
 	{
 		res = secure_raw_read(((Port *) BIO_get_data(h)), buf, size);
@@ -694,6 +721,12 @@ my_sock_write(BIO *h, const char *buf, int size)
 {
 	int			res = 0;
 
+#ifdef SSL_OP_ENABLE_KTLS
+	/* Likewise, sending alerts through the kernel needs a control message */
+	if (BIO_get_ktls_send(h))
+		return BIO_meth_get_write(BIO_s_socket()) (h, buf, size);
+#endif
+
 	res = secure_raw_write(((Port *) BIO_get_data(h)), buf, size);
 	BIO_clear_retry_flags(h);
 	if (res <= 0)
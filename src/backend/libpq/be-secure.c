@@ -60,6 +60,9 @@ char	   *SSLECDHCurve;
 /* GUC variable: if false, prefer client ciphers */
 bool		SSLPreferServerCiphers;
 
+/* GUC variable: try to hand record encryption to the kernel? */
+bool		ssl_ktls;
+
 int			ssl_min_protocol_version;
 int			ssl_max_protocol_version;
 
@@ -91,6 +91,7 @@
 #include "common/ip.h"
 #include "libpq/libpq.h"
 #include "miscadmin.h"
+#include "pgstat.h"
 #include "port/pg_bswap.h"
 #include "storage/ipc.h"
 #include "utils/guc.h"
@@ -127,17 +128,25 @@ static List *sock_paths = NIL;
 /*
  * Buffers for low-level I/O.
  *
- * The receive buffer is fixed size. Send buffer is usually 8k, but can be
+ * The receive buffer is fixed size. Send buffer starts out at 8k, but can be
  * enlarged by pq_putmessage_noblock() if the message doesn't fit otherwise.
+ * It is also doubled, up to PQ_SEND_BUFFER_MAX_SIZE, whenever a single
+ * stream of output (say, a big SELECT or COPY TO result) has filled it
+ * PQ_SEND_BUFFER_GROW_FLUSHES times without an explicit flush, so that such
+ * streams are written with fewer, larger send() calls.
  */
 
 #define PQ_SEND_BUFFER_SIZE 8192
-#define PQ_RECV_BUFFER_SIZE 8192
+#define PQ_SEND_BUFFER_MAX_SIZE (128 * 1024)
+#define PQ_SEND_BUFFER_GROW_FLUSHES 4
+#define PQ_RECV_BUFFER_SIZE 32768
 
 static char *PqSendBuffer;
 static int	PqSendBufferSize;	/* Size send buffer */
 static int	PqSendPointer;		/* Next index to store a byte in PqSendBuffer */
 static int	PqSendStart;		/* Next index to send a byte in PqSendBuffer */
+static int	PqSendFullFlushes;	/* # of flushes of a full buffer since the
+								 * last explicit flush */
 
 static char PqRecvBuffer[PQ_RECV_BUFFER_SIZE];
 static int	PqRecvPointer;		/* Next index to read a byte from PqRecvBuffer */
@@ -164,6 +173,7 @@ static void socket_startcopyout(void);
 static void socket_endcopyout(bool errorAbort);
 static int	internal_putbytes(const char *s, size_t len);
 static int	internal_flush(void);
+static int	internal_flush_buffer(const char *buf, size_t *start, size_t *end);
 
 #ifdef HAVE_UNIX_SOCKETS
 static int	Lock_AF_UNIX(char *unixSocketDir, char *unixSocketPath);
@@ -962,6 +972,7 @@ pq_recvbuf(void)
 
 		r = secure_read(MyProcPort, PqRecvBuffer + PqRecvLength,
 						PQ_RECV_BUFFER_SIZE - PqRecvLength);
+		pgstat_report_network(false, r);
 
 		if (r < 0)
 		{
@@ -1053,6 +1064,7 @@ pq_getbyte_if_available(unsigned char *c)
 	socket_set_nonblocking(true);
 
 	r = secure_read(MyProcPort, c, 1);
+	pgstat_report_network(false, r);
 	if (r < 0)
 	{
 		/*
@@ -1372,13 +1384,46 @@ internal_putbytes(const char *s, size_t len)
 
 	while (len > 0)
 	{
-		/* If buffer is full, then flush it out */
+		/* If buffer is full, then flush it out, and maybe enlarge it */
 		if (PqSendPointer >= PqSendBufferSize)
 		{
 			socket_set_nonblocking(false);
 			if (internal_flush())
 				return EOF;
+
+			if (++PqSendFullFlushes >= PQ_SEND_BUFFER_GROW_FLUSHES &&
+				PqSendBufferSize < PQ_SEND_BUFFER_MAX_SIZE)
+			{
+				/* The buffer is empty now, so there's nothing to copy */
+				pfree(PqSendBuffer);
+				PqSendBufferSize = Min(PqSendBufferSize * 2,
+									   PQ_SEND_BUFFER_MAX_SIZE);
+				PqSendBuffer = MemoryContextAlloc(TopMemoryContext,
+												  PqSendBufferSize);
+				PqSendFullFlushes = 0;
+			}
+		}
+
+		/*
+		 * If the buffer is empty and the data is at least a bufferful, send
+		 * it straight from the caller's memory rather than copying it
+		 * through the buffer piece by piece.
+		 */
+		if (PqSendPointer == PqSendStart && len >= (size_t) PqSendBufferSize)
+		{
+			size_t		start = 0;
+			size_t		end = len;
+
+			socket_set_nonblocking(false);
+			if (internal_flush_buffer(s, &start, &end))
+				return EOF;
+			if (end == 0)
+				break;			/* all sent */
+			s += start;
+			len -= start;
+			continue;
 		}
+
 		amount = PqSendBufferSize - PqSendPointer;
 		if (amount > len)
 			amount = len;
@@ -1407,6 +1452,7 @@ socket_flush(void)
 	PqCommBusy = true;
 	socket_set_nonblocking(false);
 	res = internal_flush();
+	PqSendFullFlushes = 0;
 	PqCommBusy = false;
 	return res;
 }
@@ -1420,17 +1466,40 @@ socket_flush(void)
  */
 static int
 internal_flush(void)
+{
+	size_t		start = PqSendStart;
+	size_t		end = PqSendPointer;
+	int			res;
+
+	res = internal_flush_buffer(PqSendBuffer, &start, &end);
+	PqSendStart = start;
+	PqSendPointer = end;
+	return res;
+}
+
+/* --------------------------------
+ *		internal_flush_buffer - flush the given data
+ *
+ * Sends buf[*start .. *end), advancing *start as data is sent.  If it all
+ * gets sent, or on trouble, *start and *end are both reset to 0.  Return
+ * conventions are as for internal_flush().
+ * --------------------------------
+ */
+static int
+internal_flush_buffer(const char *buf, size_t *start, size_t *end)
 {
 	static int	last_reported_send_errno = 0;
 
-	char	   *bufptr = PqSendBuffer + PqSendStart;
-	char	   *bufend = PqSendBuffer + PqSendPointer;
+	const char *bufptr = buf + *start;
+	const char *bufend = buf + *end;
 
 	while (bufptr < bufend)
 	{
 		int			r;
 
-		r = secure_write(MyProcPort, bufptr, bufend - bufptr);
+		r = secure_write(MyProcPort, unconstify(char *, bufptr),
+						 bufend - bufptr);
+		pgstat_report_network(true, r);
 
 		if (r <= 0)
 		{
@@ -1470,7 +1539,7 @@ internal_flush(void)
 			 * flag that'll cause the next CHECK_FOR_INTERRUPTS to terminate
 			 * the connection.
 			 */
-			PqSendStart = PqSendPointer = 0;
+			*start = *end = 0;
 			ClientConnectionLost = 1;
 			InterruptPending = 1;
 			return EOF;
@@ -1478,10 +1547,10 @@ internal_flush(void)
 
 		last_reported_send_errno = 0;	/* reset after any successful send */
 		bufptr += r;
-		PqSendStart += r;
+		*start += r;
 	}
 
-	PqSendStart = PqSendPointer = 0;
+	*start = *end = 0;
 	return 0;
 }
 
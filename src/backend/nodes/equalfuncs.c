@@ -1668,6 +1668,7 @@ static bool
 _equalVacuumStmt(const VacuumStmt *a, const VacuumStmt *b)
 {
 	COMPARE_SCALAR_FIELD(options);
+	COMPARE_SCALAR_FIELD(nworkers);
 	COMPARE_NODE_FIELD(rels);
 
 	return true;
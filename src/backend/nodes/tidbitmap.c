@@ -105,6 +105,26 @@ typedef struct PagetableEntry
 	bitmapword	words[Max(WORDS_PER_PAGE, WORDS_PER_CHUNK)];
 } PagetableEntry;
 
+/*
+ * tbm_lossify decides which exact pages to give up on chunk by chunk.  These
+ * structs describe an exact page that could be made lossy, and a lossy chunk
+ * that a group of such pages would be folded into.
+ */
+typedef struct LossifyPage
+{
+	BlockNumber blockno;		/* exact page that could be made lossy */
+	int			nbits;			/* number of tuple bits set for it */
+} LossifyPage;
+
+typedef struct LossifyChunk
+{
+	int			first;			/* index of its first page in LossifyPage
+								 * array */
+	int			npages;			/* number of pages from that array */
+	int			saving;			/* net reduction in nentries, if lossified */
+	float4		density;		/* average tuple bits set per page */
+} LossifyChunk;
+
 /*
  * Holds array of pagetable entries.
  */
@@ -156,7 +176,6 @@ struct TIDBitmap
 	int			npages;			/* number of exact entries in pagetable */
 	int			nchunks;		/* number of lossy entries in pagetable */
 	TBMIteratingState iterating;	/* tbm_begin_iterate called? */
-	uint32		lossify_start;	/* offset to start lossifying hashtable at */
 	PagetableEntry entry1;		/* used when status == TBM_ONE_PAGE */
 	/* these are valid when iterating is true: */
 	PagetableEntry **spages;	/* sorted exact-page list, or NULL */
@@ -211,6 +230,16 @@ typedef struct PTIterationArray
 	int			index[FLEXIBLE_ARRAY_MEMBER];	/* index array */
 } PTIterationArray;
 
+/*
+ * A bitmap's entries flattened into a single DSA chunk by tbm_export(), so
+ * that another process can merge them into a bitmap of its own.
+ */
+typedef struct TBMExportedBitmap
+{
+	int			nentries;		/* number of valid entries below */
+	PagetableEntry entries[FLEXIBLE_ARRAY_MEMBER];
+} TBMExportedBitmap;
+
 /*
  * same as TBMIterator, but it is used for joint iteration, therefore this
  * also holds a reference to the shared state.
@@ -235,6 +264,8 @@ static bool tbm_page_is_lossy(const TIDBitmap *tbm, BlockNumber pageno);
 static void tbm_mark_page_lossy(TIDBitmap *tbm, BlockNumber pageno);
 static void tbm_lossify(TIDBitmap *tbm);
 static int	tbm_comparator(const void *left, const void *right);
+static int	lossify_page_comparator(const void *left, const void *right);
+static int	lossify_chunk_comparator(const void *left, const void *right);
 static int tbm_shared_comparator(const void *left, const void *right,
 					  void *arg);
 
@@ -273,7 +304,6 @@ tbm_create(long maxbytes, dsa_area *dsa)
 	tbm->status = TBM_EMPTY;
 
 	tbm->maxentries = (int) tbm_calculate_entries(maxbytes);
-	tbm->lossify_start = 0;
 	tbm->dsa = dsa;
 	tbm->dsapagetable = InvalidDsaPointer;
 	tbm->dsapagetableold = InvalidDsaPointer;
@@ -475,6 +505,63 @@ tbm_union(TIDBitmap *a, const TIDBitmap *b)
 	}
 }
 
+/*
+ * tbm_export - copy a bitmap's entries into the given DSA area
+ *
+ * This is used by parallel bitmap heap scans, in which each participant
+ * builds a bitmap for its share of the index scan in private memory.  The
+ * result is passed to tbm_union_exported() by whichever process merges the
+ * bitmaps.  tbm itself is not changed.
+ */
+dsa_pointer
+tbm_export(const TIDBitmap *tbm, dsa_area *dsa)
+{
+	dsa_pointer dp;
+	TBMExportedBitmap *exported;
+	int			n = 0;
+
+	Assert(!tbm->iterating);
+
+	dp = dsa_allocate(dsa, offsetof(TBMExportedBitmap, entries) +
+					  tbm->nentries * sizeof(PagetableEntry));
+	exported = dsa_get_address(dsa, dp);
+
+	if (tbm->status == TBM_ONE_PAGE)
+		exported->entries[n++] = tbm->entry1;
+	else if (tbm->status == TBM_HASH)
+	{
+		pagetable_iterator i;
+		PagetableEntry *page;
+
+		pagetable_start_iterate(tbm->pagetable, &i);
+		while ((page = pagetable_iterate(tbm->pagetable, &i)) != NULL)
+			exported->entries[n++] = *page;
+	}
+	Assert(n == tbm->nentries);
+	exported->nentries = n;
+
+	return dp;
+}
+
+/*
+ * tbm_union_exported - set union with a bitmap made by tbm_export
+ *
+ * a is modified in-place, and may be lossified if it runs out of space.  The
+ * exported copy is freed.
+ */
+void
+tbm_union_exported(TIDBitmap *a, dsa_area *dsa, dsa_pointer dp)
+{
+	TBMExportedBitmap *exported = dsa_get_address(dsa, dp);
+	int			i;
+
+	Assert(!a->iterating);
+	for (i = 0; i < exported->nentries; i++)
+		tbm_union_page(a, &exported->entries[i]);
+
+	dsa_free(dsa, dp);
+}
+
 /* Process one page of b during a union op */
 static void
 tbm_union_page(TIDBitmap *a, const PagetableEntry *bpage)
@@ -1349,28 +1436,42 @@ tbm_mark_page_lossy(TIDBitmap *tbm, BlockNumber pageno)
 
 /*
  * tbm_lossify - lose some information to get back under the memory limit
+ *
+ * Turning an exact page into a bit of a lossy chunk saves an entry only if
+ * other pages of the same chunk are converted along with it, and it costs us
+ * a recheck of every tuple on the page when the heap is scanned.  So rather
+ * than lossifying pages in hashtable order, we group the exact pages by
+ * chunk and lossify whole chunks, preferring those that free the most
+ * entries and, among equals, those whose pages have the most tuple bits set
+ * already (for which a full-page recheck costs the least extra work).
+ * Chunks that would not free any entries at all are never lossified.
+ *
+ * Since we are called as soon as nentries exceeds maxentries, we should push
+ * nentries down to significantly less than maxentries, or else we'll just
+ * end up doing this again very soon.  We shoot for maxentries/2.
  */
 static void
 tbm_lossify(TIDBitmap *tbm)
 {
 	pagetable_iterator i;
 	PagetableEntry *page;
+	LossifyPage *pages;
+	LossifyChunk *chunks;
+	int			npages = 0;
+	int			nchunks = 0;
+	int			k;
 
-	/*
-	 * XXX Really stupid implementation: this just lossifies pages in
-	 * essentially random order.  We should be paying some attention to the
-	 * number of bits set in each page, instead.
-	 *
-	 * Since we are called as soon as nentries exceeds maxentries, we should
-	 * push nentries down to significantly less than maxentries, or else we'll
-	 * just end up doing this again very soon.  We shoot for maxentries/2.
-	 */
 	Assert(tbm->iterating == TBM_NOT_ITERATING);
 	Assert(tbm->status == TBM_HASH);
 
-	pagetable_start_iterate_at(tbm->pagetable, &i, tbm->lossify_start);
+	/* Collect the exact pages that a lossy chunk could absorb */
+	pages = (LossifyPage *) palloc(Max(tbm->nentries, 1) * sizeof(LossifyPage));
+	pagetable_start_iterate(tbm->pagetable, &i);
 	while ((page = pagetable_iterate(tbm->pagetable, &i)) != NULL)
 	{
+		int			nbits = 0;
+		int			wordnum;
+
 		if (page->ischunk)
 			continue;			/* already a chunk header */
 
@@ -1381,27 +1482,67 @@ tbm_lossify(TIDBitmap *tbm)
 		if ((page->blockno % PAGES_PER_CHUNK) == 0)
 			continue;
 
+		for (wordnum = 0; wordnum < WORDS_PER_PAGE; wordnum++)
+		{
+			bitmapword	w = page->words[wordnum];
+
+			while (w != 0)
+			{
+				w &= w - 1;
+				nbits++;
+			}
+		}
+
+		Assert(npages < tbm->nentries);
+		pages[npages].blockno = page->blockno;
+		pages[npages].nbits = nbits;
+		npages++;
+	}
+
+	/* Group them by chunk, and work out what each chunk would save */
+	qsort(pages, npages, sizeof(LossifyPage), lossify_page_comparator);
+	chunks = (LossifyChunk *) palloc(Max(npages, 1) * sizeof(LossifyChunk));
+	k = 0;
+	while (k < npages)
+	{
+		BlockNumber chunk_pageno = pages[k].blockno -
+		pages[k].blockno % PAGES_PER_CHUNK;
+		LossifyChunk *chunk = &chunks[nchunks];
+		double		nbits = 0;
+
+		chunk->first = k;
+		while (k < npages &&
+			   pages[k].blockno - pages[k].blockno % PAGES_PER_CHUNK == chunk_pageno)
+			nbits += pages[k++].nbits;
+		chunk->npages = k - chunk->first;
+
+		/* Lossifying adds a chunk header entry, unless one exists already */
+		chunk->saving = chunk->npages;
+		if (pagetable_lookup(tbm->pagetable, chunk_pageno) == NULL)
+			chunk->saving--;
+		if (chunk->saving <= 0)
+			continue;
+		chunk->density = (float4) (nbits / chunk->npages);
+		nchunks++;
+	}
+
+	/* Lossify the most profitable chunks until we've made enough room */
+	qsort(chunks, nchunks, sizeof(LossifyChunk), lossify_chunk_comparator);
+	for (k = 0; k < nchunks; k++)
+	{
+		int			j;
+
 		/* This does the dirty work ... */
-		tbm_mark_page_lossy(tbm, page->blockno);
+		for (j = chunks[k].first; j < chunks[k].first + chunks[k].npages; j++)
+			tbm_mark_page_lossy(tbm, pages[j].blockno);
 
 		if (tbm->nentries <= tbm->maxentries / 2)
-		{
-			/*
-			 * We have made enough room. Remember where to start lossifying
-			 * next round, so we evenly iterate over the hashtable.
-			 */
-			tbm->lossify_start = i.cur;
 			break;
-		}
-
-		/*
-		 * Note: tbm_mark_page_lossy may have inserted a lossy chunk into the
-		 * hashtable and may have deleted the non-lossy chunk.  We can
-		 * continue the same hash table scan, since failure to visit one
-		 * element or visiting the newly inserted element, isn't fatal.
-		 */
 	}
 
+	pfree(chunks);
+	pfree(pages);
+
 	/*
 	 * With a big bitmap and small work_mem, it's possible that we cannot get
 	 * under maxentries.  Again, if that happens, we'd end up uselessly
@@ -1416,6 +1557,42 @@ tbm_lossify(TIDBitmap *tbm)
 		tbm->maxentries = Min(tbm->nentries, (INT_MAX - 1) / 2) * 2;
 }
 
+/*
+ * qsort comparator for LossifyPages: order by block number.
+ */
+static int
+lossify_page_comparator(const void *left, const void *right)
+{
+	BlockNumber l = ((const LossifyPage *) left)->blockno;
+	BlockNumber r = ((const LossifyPage *) right)->blockno;
+
+	if (l < r)
+		return -1;
+	else if (l > r)
+		return 1;
+	return 0;
+}
+
+/*
+ * qsort comparator for LossifyChunks: biggest saving first, then densest.
+ */
+static int
+lossify_chunk_comparator(const void *left, const void *right)
+{
+	const LossifyChunk *l = (const LossifyChunk *) left;
+	const LossifyChunk *r = (const LossifyChunk *) right;
+
+	if (l->saving > r->saving)
+		return -1;
+	else if (l->saving < r->saving)
+		return 1;
+	if (l->density > r->density)
+		return -1;
+	else if (l->density < r->density)
+		return 1;
+	return 0;
+}
+
 /*
  * qsort comparator to handle PagetableEntry pointers.
  */
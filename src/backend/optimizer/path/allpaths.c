@@ -33,6 +33,7 @@
 #include "optimizer/clauses.h"
 #include "optimizer/cost.h"
 #include "optimizer/geqo.h"
+#include "optimizer/joininfo.h"
 #include "optimizer/pathnode.h"
 #include "optimizer/paths.h"
 #include "optimizer/plancat.h"
@@ -56,8 +57,17 @@ typedef struct pushdown_safety_info
 	bool		unsafeLeaky;	/* don't push down leaky quals */
 } pushdown_safety_info;
 
+/* A join of two clumps considered by greedy_join_search() */
+typedef struct GreedyJoinCandidate
+{
+	RelOptInfo *rel1;			/* the clumps being joined */
+	RelOptInfo *rel2;
+	RelOptInfo *joinrel;		/* their join, with paths */
+} GreedyJoinCandidate;
+
 /* These parameters are set by GUC */
 bool		enable_geqo = false;	/* just in case GUC doesn't set it */
+bool		enable_greedy_join_search = false;
 int			geqo_threshold;
 int			min_parallel_table_scan_size;
 int			min_parallel_index_scan_size;
@@ -119,6 +129,9 @@ static void set_namedtuplestore_pathlist(PlannerInfo *root, RelOptInfo *rel,
 static void set_worktable_pathlist(PlannerInfo *root, RelOptInfo *rel,
 					   RangeTblEntry *rte);
 static RelOptInfo *make_rel_from_joinlist(PlannerInfo *root, List *joinlist);
+static List *greedy_add_candidate(PlannerInfo *root, List *candidates,
+					 RelOptInfo *rel1, RelOptInfo *rel2,
+					 int nclumps, bool force);
 static bool subquery_is_pushdown_safe(Query *subquery, Query *topquery,
 						  pushdown_safety_info *safetyInfo);
 static bool recurse_pushdown_safe(Node *setOp, Query *topquery,
@@ -696,13 +709,21 @@ set_rel_consider_parallel(PlannerInfo *root, RelOptInfo *rel,
 		case RTE_CTE:
 
 			/*
-			 * CTE tuplestores aren't shared among parallel workers, so we
-			 * force all CTE scans to happen in the leader.  Also, populating
-			 * the CTE would require executing a subplan that's not available
-			 * in the worker, might be parallel-restricted, and must get
-			 * executed only once.
+			 * Populating a CTE would require executing a subplan that's not
+			 * available in the worker, might be parallel-restricted, and must
+			 * get executed only once, so ordinary CTE scans have to happen in
+			 * the leader.  But a parallel CTE scan reads rows that the leader
+			 * has copied into a shared tuplestore before starting the
+			 * workers, so it's fine; see set_cte_pathlist.  Since the
+			 * workers would keep seeing the same rows across rescans, allow
+			 * that only for CTEs of the top query level, whose contents
+			 * can't change during execution, and not for the worktable of a
+			 * recursive CTE.
 			 */
-			return;
+			if (rte->self_reference ||
+				root->query_level - rte->ctelevelsup != 1)
+				return;
+			break;
 
 		case RTE_NAMEDTUPLESTORE:
 
@@ -1016,6 +1037,21 @@ set_append_rel_size(PlannerInfo *root, RelOptInfo *rel,
 		childrel = find_base_rel(root, childRTindex);
 		Assert(childrel->reloptkind == RELOPT_OTHER_MEMBER_REL);
 
+		/*
+		 * If this partition was pruned, and we're not going to consider
+		 * partitionwise joins with the parent, there's nothing more we need
+		 * to know about it.  Skip it right away, without setting up its
+		 * targetlist, equivalence class members and quals: with thousands of
+		 * partitions, mostly pruned, that work dominates planning.
+		 */
+		if (did_pruning &&
+			!bms_is_member(childRTindex, live_children) &&
+			!rel->consider_partitionwise_join)
+		{
+			set_dummy_rel_pathlist(childrel);
+			continue;
+		}
+
 		/*
 		 * Copy/Modify targetlist. Even if this child is deemed empty, we need
 		 * its targetlist in case it falls on nullable side in a child-join
@@ -1169,7 +1205,7 @@ set_append_rel_size(PlannerInfo *root, RelOptInfo *rel,
 			continue;
 		}
 
-		if (did_pruning && !bms_is_member(appinfo->child_relid, live_children))
+		if (did_pruning && !bms_is_member(childRTindex, live_children))
 		{
 			/* This partition was pruned; skip it. */
 			set_dummy_rel_pathlist(childrel);
@@ -2475,7 +2511,26 @@ set_cte_pathlist(PlannerInfo *root, RelOptInfo *rel, RangeTblEntry *rte)
 	required_outer = rel->lateral_relids;
 
 	/* Generate appropriate path */
-	add_path(rel, create_ctescan_path(root, rel, required_outer));
+	add_path(rel, create_ctescan_path(root, rel, required_outer, 0));
+
+	/*
+	 * Consider a parallel CTE scan too, if possible.  create_ctescan_path
+	 * marks only that one as parallel-safe, since an ordinary CTE scan must
+	 * run in the leader.  We size it like a heap of the CTE's estimated
+	 * size.
+	 */
+	if (rel->consider_parallel && required_outer == NULL)
+	{
+		double		pages;
+		int			parallel_workers;
+
+		pages = ceil(cteplan->plan_rows * cteplan->plan_width / BLCKSZ);
+		parallel_workers = compute_parallel_worker(rel, pages, -1,
+												   max_parallel_workers_per_gather);
+		if (parallel_workers > 0)
+			add_partial_path(rel, create_ctescan_path(root, rel, NULL,
+													  parallel_workers));
+	}
 }
 
 /*
@@ -2699,6 +2754,8 @@ make_rel_from_joinlist(PlannerInfo *root, List *joinlist)
 
 		if (join_search_hook)
 			return (*join_search_hook) (root, levels_needed, initial_rels);
+		else if (enable_greedy_join_search && levels_needed >= geqo_threshold)
+			return greedy_join_search(root, levels_needed, initial_rels);
 		else if (enable_geqo && levels_needed >= geqo_threshold)
 			return geqo(root, levels_needed, initial_rels);
 		else
@@ -2820,6 +2877,177 @@ standard_join_search(PlannerInfo *root, int levels_needed, List *initial_rels)
 	return rel;
 }
 
+/*
+ * greedy_join_search
+ *	  Find a join order for a query with too many relations for
+ *	  standard_join_search(), by joining the pair of relations with the
+ *	  smallest result first.
+ *
+ * This is Greedy Operator Ordering.  We keep a list of "clumps" of relations
+ * joined so far, initially the initial_rels.  At each step we build every
+ * join of two clumps that are linked by a join clause or a join order
+ * restriction, pick the one estimated to produce the fewest rows (or, among
+ * equals, the one that is cheapest to compute), and replace the two clumps
+ * by it.  Joins built in earlier steps that don't involve either of the two
+ * clumps stay valid, so each step only needs to build the joins of the new
+ * clump.  If no such join is possible, we also consider clauseless joins.
+ *
+ * Unlike GEQO, this is deterministic, and it takes O(N^2) join rels for N
+ * relations, each of them considering all the usual join methods.  The
+ * plans aren't as good as an exhaustive search would find, since each join
+ * rel is only built from the one pair of inputs it was picked for.
+ *
+ * Arguments and result are as for standard_join_search().
+ */
+RelOptInfo *
+greedy_join_search(PlannerInfo *root, int levels_needed, List *initial_rels)
+{
+	List	   *clumps = list_copy(initial_rels);
+	List	   *candidates = NIL;
+	ListCell   *lc1;
+	ListCell   *lc2;
+
+	/* We don't use join_rel_level[], just like GEQO */
+	Assert(root->join_rel_level == NULL);
+
+	/* Start with all the desirable joins between two of the initial rels */
+	foreach(lc1, clumps)
+	{
+		for_each_cell(lc2, lnext(lc1))
+			candidates = greedy_add_candidate(root, candidates,
+											  (RelOptInfo *) lfirst(lc1),
+											  (RelOptInfo *) lfirst(lc2),
+											  list_length(clumps), false);
+	}
+
+	while (list_length(clumps) > 1)
+	{
+		GreedyJoinCandidate *best = NULL;
+		RelOptInfo *rel1;
+		RelOptInfo *rel2;
+		RelOptInfo *joinrel;
+		List	   *remaining = NIL;
+
+		/*
+		 * If no remaining clumps can be joined by a join clause, force a
+		 * join between any two that may legally be joined.
+		 */
+		if (candidates == NIL)
+		{
+			foreach(lc1, clumps)
+			{
+				for_each_cell(lc2, lnext(lc1))
+					candidates = greedy_add_candidate(root, candidates,
+													  (RelOptInfo *) lfirst(lc1),
+													  (RelOptInfo *) lfirst(lc2),
+													  list_length(clumps), true);
+			}
+			if (candidates == NIL)
+				elog(ERROR, "failed to build any %d-way joins", levels_needed);
+		}
+
+		/* Pick the join with the smallest result */
+		foreach(lc1, candidates)
+		{
+			GreedyJoinCandidate *cand = (GreedyJoinCandidate *) lfirst(lc1);
+
+			if (best == NULL ||
+				cand->joinrel->rows < best->joinrel->rows ||
+				(cand->joinrel->rows == best->joinrel->rows &&
+				 cand->joinrel->cheapest_total_path->total_cost <
+				 best->joinrel->cheapest_total_path->total_cost))
+				best = cand;
+		}
+		rel1 = best->rel1;
+		rel2 = best->rel2;
+		joinrel = best->joinrel;
+
+		/*
+		 * Replace the two clumps by their join, forgetting the other joins
+		 * either of them took part in.
+		 */
+		clumps = list_delete_ptr(clumps, rel1);
+		clumps = list_delete_ptr(clumps, rel2);
+
+		foreach(lc1, candidates)
+		{
+			GreedyJoinCandidate *cand = (GreedyJoinCandidate *) lfirst(lc1);
+
+			if (cand->rel1 == rel1 || cand->rel1 == rel2 ||
+				cand->rel2 == rel1 || cand->rel2 == rel2)
+				pfree(cand);
+			else
+				remaining = lappend(remaining, cand);
+		}
+		list_free(candidates);
+		candidates = remaining;
+
+		/* Now consider the joins of the new clump with the others */
+		foreach(lc1, clumps)
+			candidates = greedy_add_candidate(root, candidates,
+											  joinrel,
+											  (RelOptInfo *) lfirst(lc1),
+											  list_length(clumps) + 1, false);
+
+		clumps = lappend(clumps, joinrel);
+	}
+
+	return (RelOptInfo *) linitial(clumps);
+}
+
+/*
+ * greedy_add_candidate
+ *	  Subroutine for greedy_join_search(): build the join of two clumps, and
+ *	  add it to the list of candidates if it is legal.
+ *
+ * Unless 'force' is true, we only consider joins that have a join clause or
+ * are required by a join order restriction.  'nclumps' is the current number
+ * of clumps; when it's two, this is the topmost join rel.
+ */
+static List *
+greedy_add_candidate(PlannerInfo *root, List *candidates,
+					 RelOptInfo *rel1, RelOptInfo *rel2,
+					 int nclumps, bool force)
+{
+	GreedyJoinCandidate *cand;
+	RelOptInfo *joinrel;
+
+	if (!force &&
+		!have_relevant_joinclause(root, rel1, rel2) &&
+		!have_join_order_restriction(root, rel1, rel2))
+		return candidates;
+
+	/*
+	 * The join rel can't exist yet: the clumps partition the set of initial
+	 * rels, and only ever grow, so the union of two of them can't be the
+	 * union of two earlier ones.  Hence its paths all come from this pair.
+	 */
+	joinrel = make_join_rel(root, rel1, rel2);
+	if (joinrel == NULL)
+		return candidates;		/* join order is not valid */
+
+	/* Create paths for partitionwise joins. */
+	generate_partitionwise_join_paths(root, joinrel);
+
+	/*
+	 * Except for the topmost scan/join rel, consider gathering partial
+	 * paths.  We'll do the same for the topmost scan/join rel once we know
+	 * the final targetlist (see grouping_planner).
+	 */
+	if (nclumps > 2)
+		generate_gather_paths(root, joinrel, false);
+
+	/* Find and save the cheapest paths for this joinrel */
+	set_cheapest(joinrel);
+
+	cand = (GreedyJoinCandidate *) palloc(sizeof(GreedyJoinCandidate));
+	cand->rel1 = rel1;
+	cand->rel2 = rel2;
+	cand->joinrel = joinrel;
+
+	return lappend(candidates, cand);
+}
+
 /*****************************************************************************
  *			PUSHING QUALS DOWN INTO SUBQUERIES
  *****************************************************************************/
@@ -3748,6 +3976,10 @@ print_path(PlannerInfo *root, Path *path, int indent)
 			ptype = "Material";
 			subpath = ((MaterialPath *) path)->subpath;
 			break;
+		case T_ResultCachePath:
+			ptype = "ResultCache";
+			subpath = ((ResultCachePath *) path)->subpath;
+			break;
 		case T_UniquePath:
 			ptype = "Unique";
 			subpath = ((UniquePath *) path)->subpath;
@@ -3772,6 +4004,10 @@ print_path(PlannerInfo *root, Path *path, int indent)
 			ptype = "Sort";
 			subpath = ((SortPath *) path)->subpath;
 			break;
+		case T_IncrementalSortPath:
+			ptype = "IncrementalSort";
+			subpath = ((SortPath *) path)->subpath;
+			break;
 		case T_GroupPath:
 			ptype = "Group";
 			subpath = ((GroupPath *) path)->subpath;
@@ -76,8 +76,12 @@
 #include "access/amapi.h"
 #include "access/htup_details.h"
 #include "access/tsmapi.h"
+#include "catalog/pg_am.h"
 #include "executor/executor.h"
+#include "executor/nodeAgg.h"
 #include "executor/nodeHash.h"
+#include "executor/nodeMergejoin.h"
+#include "executor/nodeResultCache.h"
 #include "miscadmin.h"
 #include "nodes/nodeFuncs.h"
 #include "optimizer/clauses.h"
@@ -122,13 +126,17 @@ int			max_parallel_workers_per_gather = 2;
 bool		enable_seqscan = true;
 bool		enable_indexscan = true;
 bool		enable_indexonlyscan = true;
+bool		enable_indexskipscan = true;
 bool		enable_bitmapscan = true;
 bool		enable_tidscan = true;
 bool		enable_sort = true;
+bool		enable_incrementalsort = true;
 bool		enable_hashagg = true;
 bool		enable_nestloop = true;
 bool		enable_material = true;
+bool		enable_resultcache = true;
 bool		enable_mergejoin = true;
+bool		enable_mergejoin_skip = false;
 bool		enable_hashjoin = true;
 bool		enable_gathermerge = true;
 bool		enable_partitionwise_join = false;
@@ -147,6 +155,7 @@ static List *extract_nonindex_conditions(List *qual_clauses, List *indexquals);
 static MergeScanSelCache *cached_scansel(PlannerInfo *root,
 			   RestrictInfo *rinfo,
 			   PathKey *pathkey);
+static bool mergejoin_inner_skippable(MergePath *path);
 static void cost_rescan(PlannerInfo *root, Path *path,
 			Cost *rescan_startup_cost, Cost *rescan_total_cost);
 static bool cost_qual_eval_walker(Node *node, cost_qual_eval_context *context);
@@ -174,6 +183,10 @@ static Cost append_nonpartial_cost(List *subpaths, int numpaths,
 static void set_rel_width(PlannerInfo *root, RelOptInfo *rel);
 static double relation_byte_size(double tuples, int width);
 static double page_size(double tuples, int width);
+static void cost_tuplesort(Cost *startup_cost, Cost *run_cost,
+			   double tuples, int width,
+			   Cost comparison_cost, int sort_mem,
+			   double limit_tuples);
 static double get_parallel_divisor(Path *path);
 
 
@@ -1529,6 +1542,20 @@ cost_ctescan(Path *path, PlannerInfo *root,
 	startup_cost += path->pathtarget->cost.startup;
 	run_cost += path->pathtarget->cost.per_tuple * path->rows;
 
+	/*
+	 * In a parallel CTE scan the rows are divided among the participants,
+	 * as in cost_seqscan.  The leader copying the rows into the shared
+	 * tuplestore costs about as much as the tuplestore manipulation charged
+	 * above, so we don't add anything for it.
+	 */
+	if (path->parallel_workers > 0)
+	{
+		double		parallel_divisor = get_parallel_divisor(path);
+
+		run_cost /= parallel_divisor;
+		path->rows = clamp_row_est(path->rows / parallel_divisor);
+	}
+
 	path->startup_cost = startup_cost;
 	path->total_cost = startup_cost + run_cost;
 }
@@ -1664,17 +1691,41 @@ cost_sort(Path *path, PlannerInfo *root,
 		  double limit_tuples)
 {
 	Cost		startup_cost = input_cost;
-	Cost		run_cost = 0;
-	double		input_bytes = relation_byte_size(tuples, width);
-	double		output_bytes;
-	double		output_tuples;
-	long		sort_mem_bytes = sort_mem * 1024L;
+	Cost		sort_startup_cost;
+	Cost		sort_run_cost;
 
 	if (!enable_sort)
 		startup_cost += disable_cost;
 
 	path->rows = tuples;
 
+	cost_tuplesort(&sort_startup_cost, &sort_run_cost,
+				   tuples, width, comparison_cost, sort_mem, limit_tuples);
+
+	path->startup_cost = startup_cost + sort_startup_cost;
+	path->total_cost = path->startup_cost + sort_run_cost;
+}
+
+/*
+ * cost_tuplesort
+ *	  Determines the cost of sorting "tuples" tuples with tuplesort.c, not
+ *	  including the cost of obtaining them.  The arguments are as for
+ *	  cost_sort.
+ */
+static void
+cost_tuplesort(Cost *startup_cost, Cost *run_cost,
+			   double tuples, int width,
+			   Cost comparison_cost, int sort_mem,
+			   double limit_tuples)
+{
+	double		input_bytes = relation_byte_size(tuples, width);
+	double		output_bytes;
+	double		output_tuples;
+	long		sort_mem_bytes = sort_mem * 1024L;
+
+	*startup_cost = 0;
+	*run_cost = 0;
+
 	/*
 	 * We want to be sure the cost of a sort is never estimated as zero, even
 	 * if passed-in tuple count is zero.  Besides, mustn't do log(0)...
@@ -1713,7 +1764,7 @@ cost_sort(Path *path, PlannerInfo *root,
 		 *
 		 * Assume about N log2 N comparisons
 		 */
-		startup_cost += comparison_cost * tuples * LOG2(tuples);
+		*startup_cost += comparison_cost * tuples * LOG2(tuples);
 
 		/* Disk costs */
 
@@ -1724,7 +1775,7 @@ cost_sort(Path *path, PlannerInfo *root,
 			log_runs = 1.0;
 		npageaccesses = 2.0 * npages * log_runs;
 		/* Assume 3/4ths of accesses are sequential, 1/4th are not */
-		startup_cost += npageaccesses *
+		*startup_cost += npageaccesses *
 			(seq_page_cost * 0.75 + random_page_cost * 0.25);
 	}
 	else if (tuples > 2 * output_tuples || input_bytes > sort_mem_bytes)
@@ -1735,12 +1786,12 @@ cost_sort(Path *path, PlannerInfo *root,
 		 * factor is a bit higher than for quicksort.  Tweak it so that the
 		 * cost curve is continuous at the crossover point.
 		 */
-		startup_cost += comparison_cost * tuples * LOG2(2.0 * output_tuples);
+		*startup_cost += comparison_cost * tuples * LOG2(2.0 * output_tuples);
 	}
 	else
 	{
 		/* We'll use plain quicksort on all the input tuples */
-		startup_cost += comparison_cost * tuples * LOG2(tuples);
+		*startup_cost += comparison_cost * tuples * LOG2(tuples);
 	}
 
 	/*
@@ -1751,7 +1802,95 @@ cost_sort(Path *path, PlannerInfo *root,
 	 * here --- the upper LIMIT will pro-rate the run cost so we'd be double
 	 * counting the LIMIT otherwise.
 	 */
-	run_cost += cpu_operator_cost * tuples;
+	*run_cost += cpu_operator_cost * tuples;
+}
+
+/*
+ * cost_incremental_sort
+ *	  Determines and returns the cost of sorting a relation that is already
+ *	  sorted on the first 'presorted_keys' of 'pathkeys', including the cost
+ *	  of reading the input data.
+ *
+ * The executor sorts each run of tuples with equal presorted keys
+ * separately, so we estimate the cost of sorting a single run of average
+ * size, and charge it once per run.  Only the first run has to be read and
+ * sorted before the first tuple can be returned, which makes for a much
+ * lower startup cost than a full sort.  The other arguments are as for
+ * cost_sort.
+ */
+void
+cost_incremental_sort(Path *path, PlannerInfo *root,
+					  List *pathkeys, int presorted_keys,
+					  Cost input_startup_cost, Cost input_total_cost,
+					  double input_tuples, int width,
+					  Cost comparison_cost, int sort_mem,
+					  double limit_tuples)
+{
+	Cost		startup_cost = 0;
+	Cost		run_cost = 0;
+	Cost		input_run_cost = input_total_cost - input_startup_cost;
+	Cost		group_startup_cost;
+	Cost		group_run_cost;
+	List	   *presortedExprs = NIL;
+	ListCell   *lc;
+	double		input_groups;
+	double		group_tuples;
+	double		nbatches;
+
+	Assert(presorted_keys > 0 && presorted_keys < list_length(pathkeys));
+
+	if (!enable_incrementalsort)
+		startup_cost += disable_cost;
+
+	path->rows = input_tuples;
+
+	/* Estimate the number of runs with equal presorted keys */
+	foreach(lc, pathkeys)
+	{
+		PathKey    *key = (PathKey *) lfirst(lc);
+		EquivalenceMember *member = (EquivalenceMember *)
+		linitial(key->pk_eclass->ec_members);
+
+		presortedExprs = lappend(presortedExprs, member->em_expr);
+		if (list_length(presortedExprs) >= presorted_keys)
+			break;
+	}
+	if (input_tuples < 1.0)
+		input_tuples = 1.0;
+	input_groups = estimate_num_groups(root, presortedExprs, input_tuples,
+									   NULL);
+
+	/*
+	 * Our assumptions about the distribution of tuples among the runs are
+	 * rough, so be pessimistic and take the runs to be half again as large
+	 * as on average.  Also, the executor never sorts fewer than 32 tuples at
+	 * a time (see nodeIncrementalSort.c).
+	 */
+	group_tuples = 1.5 * input_tuples / input_groups;
+	group_tuples = Max(group_tuples, Min(32.0, input_tuples));
+	group_tuples = Min(group_tuples, input_tuples);
+	nbatches = input_tuples / group_tuples;
+
+	cost_tuplesort(&group_startup_cost, &group_run_cost,
+				   group_tuples, width, comparison_cost, sort_mem,
+				   limit_tuples);
+
+	/* Startup requires reading and sorting the first batch */
+	startup_cost += input_startup_cost + input_run_cost / nbatches +
+		group_startup_cost;
+
+	/* The remaining batches are read and sorted as we go */
+	run_cost += input_run_cost * (nbatches - 1) / nbatches;
+	run_cost += group_startup_cost * (nbatches - 1);
+	run_cost += group_run_cost * nbatches;
+
+	/*
+	 * Charge for comparing the presorted keys of each tuple with those of
+	 * the current batch, and for setting up and tearing down each batch's
+	 * sort.
+	 */
+	run_cost += cpu_operator_cost * presorted_keys * input_tuples;
+	run_cost += 2.0 * cpu_tuple_cost * nbatches;
 
 	path->startup_cost = startup_cost;
 	path->total_cost = startup_cost + run_cost;
@@ -2051,7 +2190,9 @@ cost_material(Path *path,
  *		including the cost of its input.
  *
  * aggcosts can be NULL when there are no actual aggregate functions (i.e.,
- * we are using a hashed Agg node just to do grouping).
+ * we are using a hashed Agg node just to do grouping).  input_width is the
+ * width of the input tuples, which is needed to estimate the cost of
+ * spilling them to disk when the hash table would not fit in work_mem.
  *
  * Note: when aggstrategy == AGG_SORTED, caller must ensure that input costs
  * are for appropriately-sorted input.
@@ -2062,7 +2203,7 @@ cost_agg(Path *path, PlannerInfo *root,
 		 int numGroupCols, double numGroups,
 		 List *quals,
 		 Cost input_startup_cost, Cost input_total_cost,
-		 double input_tuples)
+		 double input_tuples, int input_width)
 {
 	double		output_tuples;
 	Cost		startup_cost;
@@ -2142,6 +2283,49 @@ cost_agg(Path *path, PlannerInfo *root,
 		output_tuples = numGroups;
 	}
 
+	/*
+	 * If the hash table is expected to exceed work_mem, the executor will
+	 * spill input tuples to disk and read them back in later batches,
+	 * possibly recursively.  Charge for writing and reading the spilled
+	 * tuples once per level of recursion.  When hashing is combined with
+	 * sorting (AGG_MIXED), the hashed output is only produced at the end, so
+	 * only the total cost is affected.
+	 */
+	if (aggstrategy == AGG_HASHED || aggstrategy == AGG_MIXED)
+	{
+		double		hashentrysize;
+		double		mem_limit = work_mem * 1024.0;
+
+		hashentrysize = MAXALIGN(input_width) +
+			MAXALIGN(SizeofMinimalTupleHeader) +
+			hash_agg_entry_size(aggcosts ? aggcosts->numAggs : 0);
+
+		if (hashentrysize * numGroups > mem_limit)
+		{
+			double		nbatches = hashentrysize * numGroups / mem_limit;
+			double		npartitions;
+			double		depth;
+			double		spill_pages;
+			Cost		spill_cost;
+
+			/* same limits the executor applies when choosing partitions */
+			npartitions = mem_limit / (4 * BLCKSZ);
+			npartitions = Max(npartitions, 4);
+			npartitions = Min(npartitions, 256);
+
+			depth = ceil(log(nbatches) / log(npartitions));
+			depth = Max(depth, 1.0);
+
+			spill_pages = page_size(input_tuples, input_width);
+			spill_cost = depth * (2.0 * seq_page_cost * spill_pages +
+								  2.0 * cpu_tuple_cost * input_tuples);
+
+			if (aggstrategy == AGG_HASHED)
+				startup_cost += spill_cost;
+			total_cost += spill_cost;
+		}
+	}
+
 	/*
 	 * If there are quals (HAVING quals), account for their cost and
 	 * selectivity.
@@ -2803,15 +2987,17 @@ initial_cost_mergejoin(PlannerInfo *root, JoinCostWorkspace *workspace,
  * final_cost_mergejoin
  *	  Final estimate of the cost and result size of a mergejoin path.
  *
- * Unlike other costsize functions, this routine makes two actual decisions:
- * whether the executor will need to do mark/restore, and whether we should
- * materialize the inner path.  It would be logically cleaner to build
- * separate paths testing these alternatives, but that would require repeating
- * most of the cost calculations, which are not all that cheap.  Since the
- * choice will not affect output pathkeys or startup cost, only total cost,
- * there is no possibility of wanting to keep more than one path.  So it seems
- * best to make the decisions here and record them in the path's
- * skip_mark_restore and materialize_inner fields.
+ * Unlike other costsize functions, this routine makes three actual decisions:
+ * whether the executor will need to do mark/restore, whether we should
+ * materialize the inner path, and whether the executor should re-seek the
+ * inner index scan forward rather than step through it.  It would be
+ * logically cleaner to build separate paths testing these alternatives, but
+ * that would require repeating most of the cost calculations, which are not
+ * all that cheap.  Since the choice will not affect output pathkeys or
+ * startup cost, only total cost, there is no possibility of wanting to keep
+ * more than one path.  So it seems best to make the decisions here and record
+ * them in the path's skip_mark_restore, materialize_inner and skip_inner
+ * fields.
  *
  * Mark/restore overhead is usually required, but can be skipped if we know
  * that the executor need find only one match per outer tuple, and that the
@@ -2821,8 +3007,12 @@ initial_cost_mergejoin(PlannerInfo *root, JoinCostWorkspace *workspace,
  * path can't support mark/restore, or it's cheaper to use an interposed
  * Material node to handle mark/restore.
  *
+ * We re-seek the inner path if enable_mergejoin_skip is on, the inner path
+ * is a suitable index scan (see mergejoin_inner_skippable), and jumping over
+ * non-matching inner tuples looks cheaper than reading them.
+ *
  * 'path' is already filled in except for the rows and cost fields and
- *		skip_mark_restore and materialize_inner
+ *		skip_mark_restore, materialize_inner and skip_inner
  * 'workspace' is the result from initial_cost_mergejoin
  * 'extra' contains miscellaneous information about the join
  */
@@ -2845,12 +3035,14 @@ final_cost_mergejoin(PlannerInfo *root, MergePath *path,
 	double		inner_skip_rows = workspace->inner_skip_rows;
 	Cost		cpu_per_tuple,
 				bare_inner_cost,
-				mat_inner_cost;
+				mat_inner_cost,
+				skip_inner_cost = 0;
 	QualCost	merge_qual_cost;
 	QualCost	qp_qual_cost;
 	double		mergejointuples,
 				rescannedtuples;
 	double		rescanratio;
+	double		inner_scan_frac = 1.0;
 
 	/* Protect some assumptions below that rowcounts aren't zero or NaN */
 	if (inner_path_rows <= 0 || isnan(inner_path_rows))
@@ -3031,8 +3223,57 @@ final_cost_mergejoin(PlannerInfo *root, MergePath *path,
 	else
 		path->materialize_inner = false;
 
+	/*
+	 * Consider re-seeking the inner index scan to the current outer key
+	 * whenever the executor has stepped over MJ_SKIP_INNER_THRESHOLD
+	 * non-matching inner tuples in a row.  Our model is that there is at most
+	 * one re-seek per outer row, each costing an index descent plus a random
+	 * page fetch, and that after each one we still read MJ_SKIP_INNER_THRESHOLD
+	 * inner tuples, besides those that actually join, before the next.  This
+	 * wins when the outer side is much sparser than the inner.  We need not
+	 * consider materialization here, since the index scan supports
+	 * mark/restore itself.
+	 */
+	path->skip_inner = false;
+	if (enable_mergejoin_skip && mergejoin_inner_skippable(path))
+	{
+		IndexOptInfo *index = ((IndexPath *) inner_path)->indexinfo;
+		double		inner_scan_rows = Max(inner_rows - inner_skip_rows, 1.0);
+		double		nseeks;
+		double		fetched;
+		Cost		descent_cost;
+		Cost		spc_random_page_cost;
+
+		nseeks = Min(outer_rows - outer_skip_rows,
+					 inner_scan_rows / MJ_SKIP_INNER_THRESHOLD);
+		fetched = Min(mergejointuples, inner_scan_rows) +
+			nseeks * MJ_SKIP_INNER_THRESHOLD;
+		inner_scan_frac = Min(fetched / inner_scan_rows, 1.0);
+
+		/* this matches the descent charge made by btcostestimate */
+		descent_cost = cpu_operator_cost *
+			(ceil(log(Max(index->tuples, 2.0)) / log(2.0)) +
+			 (Max(index->tree_height, 0) + 1) * 50.0);
+		get_tablespace_page_costs(index->reltablespace,
+								  &spc_random_page_cost, NULL);
+
+		skip_inner_cost = bare_inner_cost * inner_scan_frac +
+			nseeks * (descent_cost + spc_random_page_cost);
+
+		if (skip_inner_cost < (path->materialize_inner ?
+							   mat_inner_cost : bare_inner_cost))
+		{
+			path->skip_inner = true;
+			path->materialize_inner = false;
+		}
+		else
+			inner_scan_frac = 1.0;
+	}
+
 	/* Charge the right incremental cost for the chosen case */
-	if (path->materialize_inner)
+	if (path->skip_inner)
+		run_cost += skip_inner_cost;
+	else if (path->materialize_inner)
 		run_cost += mat_inner_cost;
 	else
 		run_cost += bare_inner_cost;
@@ -3049,7 +3290,7 @@ final_cost_mergejoin(PlannerInfo *root, MergePath *path,
 		(outer_skip_rows + inner_skip_rows * rescanratio);
 	run_cost += merge_qual_cost.per_tuple *
 		((outer_rows - outer_skip_rows) +
-		 (inner_rows - inner_skip_rows) * rescanratio);
+		 (inner_rows - inner_skip_rows) * rescanratio * inner_scan_frac);
 
 	/*
 	 * For each tuple that gets through the mergejoin proper, we charge
@@ -3072,6 +3313,97 @@ final_cost_mergejoin(PlannerInfo *root, MergePath *path,
 	path->jpath.path.total_cost = startup_cost + run_cost;
 }
 
+/*
+ * mergejoin_inner_skippable
+ *	  Could the executor re-seek the inner input of this mergejoin forward to
+ *	  the current outer key, rather than stepping through non-matching inner
+ *	  tuples one at a time?
+ *
+ * This needs the inner path to be a plain forward btree index scan, without
+ * a Sort on top, whose leading column is the inner side of the first
+ * mergeclause, sorted ascending with nulls last; and the index's opfamily
+ * must provide a ">=" operator comparing that column with the outer key.
+ * Right and full joins are out, since they must null-extend the inner tuples
+ * that a re-seek would jump over.
+ */
+static bool
+mergejoin_inner_skippable(MergePath *path)
+{
+	Path	   *inner_path = path->jpath.innerjoinpath;
+	IndexPath  *ipath;
+	IndexOptInfo *index;
+	RestrictInfo *rinfo;
+	EquivalenceClass *ieclass;
+	PathKey    *ipathkey;
+	Node	   *innerexpr;
+	Oid			outertype;
+	Oid			innertype;
+
+	if (path->jpath.jointype != JOIN_INNER &&
+		path->jpath.jointype != JOIN_LEFT &&
+		path->jpath.jointype != JOIN_SEMI &&
+		path->jpath.jointype != JOIN_ANTI)
+		return false;
+	if (path->innersortkeys != NIL || path->path_mergeclauses == NIL)
+		return false;
+	if (!IsA(inner_path, IndexPath) || inner_path->parallel_aware ||
+		inner_path->pathkeys == NIL)
+		return false;
+
+	ipath = (IndexPath *) inner_path;
+	index = ipath->indexinfo;
+	if (index->relam != BTREE_AM_OID ||
+		ipath->indexscandir != ForwardScanDirection ||
+		ipath->indexskip ||
+		ipath->indexorderbys != NIL ||
+		index->indexkeys[0] == 0)
+		return false;
+
+	/* Identify the inner side of the first mergeclause */
+	rinfo = linitial_node(RestrictInfo, path->path_mergeclauses);
+	if (!is_opclause(rinfo->clause) ||
+		list_length(((OpExpr *) rinfo->clause)->args) != 2)
+		return false;
+	op_input_types(((OpExpr *) rinfo->clause)->opno, &outertype, &innertype);
+	if (bms_is_subset(rinfo->left_relids,
+					  path->jpath.outerjoinpath->parent->relids))
+	{
+		innerexpr = get_rightop(rinfo->clause);
+		ieclass = rinfo->right_ec;
+	}
+	else
+	{
+		Oid			tmptype = outertype;
+
+		outertype = innertype;
+		innertype = tmptype;
+		innerexpr = get_leftop(rinfo->clause);
+		ieclass = rinfo->left_ec;
+	}
+
+	/* It must be the index's leading column, scanned in ascending order */
+	if (IsA(innerexpr, RelabelType))
+		innerexpr = (Node *) ((RelabelType *) innerexpr)->arg;
+	if (!IsA(innerexpr, Var) ||
+		((Var *) innerexpr)->varno != index->rel->relid ||
+		((Var *) innerexpr)->varattno != index->indexkeys[0])
+		return false;
+
+	ipathkey = (PathKey *) linitial(inner_path->pathkeys);
+	if (ipathkey->pk_eclass != ieclass ||
+		ipathkey->pk_opfamily != index->opfamily[0] ||
+		ipathkey->pk_strategy != BTLessStrategyNumber ||
+		ipathkey->pk_nulls_first ||
+		ieclass->ec_collation != index->indexcollations[0])
+		return false;
+
+	if (innertype != index->opcintype[0])
+		return false;
+	return OidIsValid(get_opfamily_member(index->opfamily[0],
+										  innertype, outertype,
+										  BTGreaterEqualStrategyNumber));
+}
+
 /*
  * run mergejoinscansel() with caching
  */
@@ -3596,6 +3928,128 @@ cost_subplan(PlannerInfo *root, SubPlan *subplan, Plan *plan)
 }
 
 
+/*
+ * cost_resultcache_rescan
+ *	  Determines the estimated cost of rescanning a ResultCache node.
+ *
+ * In order to estimate this, we must gain knowledge of how often we expect to
+ * be called and how many distinct sets of parameters we are likely to be
+ * called with.  If we expect a good cache hit ratio, then we can set our
+ * costs to account for that hit ratio, plus a little bit of cost for the
+ * caching itself.  Caching will not work out well if we expect to be called
+ * with too many distinct parameter values.  The worst-case here is that we
+ * never see the same parameter values twice, in which case we'd never get a
+ * cache hit and caching would be a complete waste of effort.
+ *
+ * As a side effect, this sets rcpath->est_entries, the number of entries we
+ * expect the cache to hold at once.
+ */
+static void
+cost_resultcache_rescan(PlannerInfo *root, ResultCachePath *rcpath,
+						Cost *rescan_startup_cost, Cost *rescan_total_cost)
+{
+	Cost		input_startup_cost = rcpath->subpath->startup_cost;
+	Cost		input_total_cost = rcpath->subpath->total_cost;
+	double		tuples = rcpath->subpath->rows;
+	double		calls = rcpath->calls;
+	int			width = rcpath->subpath->pathtarget->width;
+	double		work_mem_bytes = work_mem * 1024.0;
+	double		est_entry_bytes;
+	double		est_cache_entries;
+	double		ndistinct;
+	double		evict_ratio;
+	double		hit_ratio;
+	Cost		startup_cost;
+	Cost		total_cost;
+
+	/* available cache space */
+	est_entry_bytes = relation_byte_size(tuples, width) +
+		ExecEstimateCacheEntryOverheadBytes(tuples);
+
+	/* estimate on the upper limit of cache entries we can hold at once */
+	est_cache_entries = floor(work_mem_bytes / est_entry_bytes);
+
+	/* estimate on the distinct number of parameter values */
+	ndistinct = estimate_num_groups(root, rcpath->param_exprs, calls, NULL);
+
+	/* can't have more distinct values than calls, nor fewer than one */
+	ndistinct = clamp_row_est(Min(ndistinct, calls));
+
+	/*
+	 * Since we've already estimated the maximum number of entries we can
+	 * store at once and know the estimated number of distinct values we'll
+	 * be called with, we'll take this opportunity to set the path's
+	 * est_entries.  This will ultimately determine the hash table size that
+	 * the executor will use.  If we leave this at zero, the executor will
+	 * just choose the size itself.  Really this is not the right place to do
+	 * this, but it's convenient since everything is already calculated.
+	 */
+	rcpath->est_entries = Min(Min(ndistinct, est_cache_entries),
+							  PG_UINT32_MAX);
+
+	/*
+	 * When the number of distinct parameter values is above the amount we
+	 * can store in the cache, then we'll have to evict some entries from the
+	 * cache.  This is not free.  Here we estimate how often we'll incur the
+	 * cost of that eviction.
+	 */
+	evict_ratio = 1.0 - Min(est_cache_entries, ndistinct) / ndistinct;
+
+	/*
+	 * In order to estimate how costly a single scan will be, we need to
+	 * attempt to estimate what the cache hit ratio will be.  To do that we
+	 * must look at how many scans are estimated in total for this node and
+	 * how many of those scans we expect to get a cache hit: the first call
+	 * for each distinct value is always a miss, and of the others, only those
+	 * whose entry still fits in the cache can hit.
+	 */
+	hit_ratio = ((calls - ndistinct) / calls) *
+		(Min(est_cache_entries, ndistinct) / ndistinct);
+
+	/*
+	 * Set the total_cost accounting for the expected cache hit ratio.  We
+	 * also add on a cpu_operator_cost to account for a cache lookup.  This
+	 * will happen regardless of whether it's a cache hit or not.
+	 */
+	total_cost = input_total_cost * (1.0 - hit_ratio) + cpu_operator_cost;
+
+	/* Now adjust the total cost to account for cache evictions */
+
+	/* Charge a cpu_tuple_cost for evicting the actual cache entry */
+	total_cost += cpu_tuple_cost * evict_ratio;
+
+	/*
+	 * Charge a 10th of cpu_operator_cost to evict every tuple in that entry.
+	 * The per-tuple eviction is really just a pfree, so charging a whole
+	 * cpu_operator_cost seems a little excessive.
+	 */
+	total_cost += cpu_operator_cost / 10.0 * evict_ratio * tuples;
+
+	/*
+	 * Now adjust for storing things in the cache, since that's not free
+	 * either.  Everything must go in the cache.  We don't proportion this
+	 * over any ratio, just apply it once for the scan.  We charge a
+	 * cpu_tuple_cost for the creation of the cache entry and also a
+	 * cpu_operator_cost for each tuple we expect to cache.
+	 */
+	total_cost += cpu_tuple_cost + cpu_operator_cost * tuples;
+
+	/*
+	 * Getting the first row must be also be proportioned according to the
+	 * expected cache hit ratio.
+	 */
+	startup_cost = input_startup_cost * (1.0 - hit_ratio);
+
+	/*
+	 * Additionally we charge a cpu_tuple_cost to account for cache lookups,
+	 * which we'll do regardless of whether it was a cache hit or not.
+	 */
+	startup_cost += cpu_tuple_cost;
+
+	*rescan_startup_cost = startup_cost;
+	*rescan_total_cost = total_cost;
+}
+
 /*
  * cost_rescan
  *		Given a finished Path, estimate the costs of rescanning it after
@@ -3700,6 +4154,11 @@ cost_rescan(PlannerInfo *root, Path *path,
 				*rescan_total_cost = run_cost;
 			}
 			break;
+		case T_ResultCache:
+			/* All the hard work is done by cost_resultcache_rescan */
+			cost_resultcache_rescan(root, (ResultCachePath *) path,
+									rescan_startup_cost, rescan_total_cost);
+			break;
 		default:
 			*rescan_startup_cost = path->startup_cost;
 			*rescan_total_cost = path->total_cost;
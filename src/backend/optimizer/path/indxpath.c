@@ -791,7 +791,7 @@ get_index_paths(PlannerInfo *root, RelOptInfo *rel,
 		if (index->amhasgettuple)
 			add_path(rel, (Path *) ipath);
 
-		if (index->amhasgetbitmap &&
+		if (index->amhasgetbitmap && !ipath->indexskip &&
 			(ipath->path.pathkeys == NIL ||
 			 ipath->indexselectivity < 1.0))
 			*bitindexpaths = lappend(*bitindexpaths, ipath);
@@ -1045,6 +1045,7 @@ build_index_paths(PlannerInfo *root, RelOptInfo *rel,
 								  ForwardScanDirection :
 								  NoMovementScanDirection,
 								  index_only_scan,
+								  false,
 								  outer_relids,
 								  loop_count,
 								  false);
@@ -1052,11 +1053,13 @@ build_index_paths(PlannerInfo *root, RelOptInfo *rel,
 
 		/*
 		 * If appropriate, consider parallel index scan.  We don't allow
-		 * parallel index scan for bitmap index scans.
+		 * parallel index scan for bitmap index scans, nor for scans ordered
+		 * by operator: the participants divide the index between them, so
+		 * none of them would see the nearest entries first.
 		 */
 		if (index->amcanparallel &&
 			rel->consider_parallel && outer_relids == NULL &&
-			scantype != ST_BITMAPSCAN)
+			scantype != ST_BITMAPSCAN && orderbyclauses == NIL)
 		{
 			ipath = create_index_path(root, index,
 									  index_clauses,
@@ -1068,6 +1071,7 @@ build_index_paths(PlannerInfo *root, RelOptInfo *rel,
 									  ForwardScanDirection :
 									  NoMovementScanDirection,
 									  index_only_scan,
+									  false,
 									  outer_relids,
 									  loop_count,
 									  true);
@@ -1081,6 +1085,34 @@ build_index_paths(PlannerInfo *root, RelOptInfo *rel,
 			else
 				pfree(ipath);
 		}
+
+		/*
+		 * If there are clauses on later columns only, consider a skip scan,
+		 * which searches for them separately within each distinct value of
+		 * the first column.  That can beat a full index scan by a wide margin
+		 * when the first column has few distinct values.
+		 */
+		if (index->amcanskip && enable_indexskipscan &&
+			scantype != ST_BITMAPSCAN &&
+			index_clauses != NIL && linitial_int(clause_columns) > 0 &&
+			index->nkeycolumns > 1)
+		{
+			ipath = create_index_path(root, index,
+									  index_clauses,
+									  clause_columns,
+									  orderbyclauses,
+									  orderbyclausecols,
+									  useful_pathkeys,
+									  index_is_ordered ?
+									  ForwardScanDirection :
+									  NoMovementScanDirection,
+									  index_only_scan,
+									  true,
+									  outer_relids,
+									  loop_count,
+									  false);
+			result = lappend(result, ipath);
+		}
 	}
 
 	/*
@@ -1102,6 +1134,7 @@ build_index_paths(PlannerInfo *root, RelOptInfo *rel,
 									  useful_pathkeys,
 									  BackwardScanDirection,
 									  index_only_scan,
+									  false,
 									  outer_relids,
 									  loop_count,
 									  false);
@@ -1120,6 +1153,7 @@ build_index_paths(PlannerInfo *root, RelOptInfo *rel,
 										  useful_pathkeys,
 										  BackwardScanDirection,
 										  index_only_scan,
+										  false,
 										  outer_relids,
 										  loop_count,
 										  true);
@@ -18,10 +18,14 @@
 
 #include "executor/executor.h"
 #include "foreign/fdwapi.h"
+#include "optimizer/clauses.h"
 #include "optimizer/cost.h"
 #include "optimizer/pathnode.h"
 #include "optimizer/paths.h"
+#include "optimizer/placeholder.h"
 #include "optimizer/planmain.h"
+#include "optimizer/var.h"
+#include "parser/parsetree.h"
 
 /* Hook for plugins to get control in add_paths_to_joinrel() */
 set_join_pathlist_hook_type set_join_pathlist_hook = NULL;
@@ -354,6 +358,195 @@ allow_star_schema_join(PlannerInfo *root,
 			bms_nonempty_difference(inner_paramrels, outerrelids));
 }
 
+/*
+ * resultcache_add_param_exprs
+ *	  Add the Vars and PlaceHolderVars of the outer rel in 'clause' to the
+ *	  list of cache keys *param_exprs.
+ *
+ * Returns false if we can't tell which parameters these are; see
+ * get_resultcache_path.
+ */
+static bool
+resultcache_add_param_exprs(PlannerInfo *root, Node *clause,
+							Relids outerrelids, List **param_exprs)
+{
+	List	   *vars;
+	ListCell   *lc;
+
+	vars = pull_var_clause(clause,
+						   PVC_RECURSE_AGGREGATES |
+						   PVC_RECURSE_WINDOWFUNCS |
+						   PVC_INCLUDE_PLACEHOLDERS);
+
+	foreach(lc, vars)
+	{
+		Node	   *node = (Node *) lfirst(lc);
+
+		if (IsA(node, Var))
+		{
+			if (!bms_is_member(((Var *) node)->varno, outerrelids))
+				continue;
+		}
+		else
+		{
+			PlaceHolderVar *phv = castNode(PlaceHolderVar, node);
+
+			if (!bms_overlap(phv->phrels, outerrelids))
+				continue;
+
+			/*
+			 * A PHV of the outer rel becomes a nestloop parameter only if
+			 * it is computed there.
+			 */
+			if (!bms_is_subset(find_placeholder_info(root, phv, false)->ph_eval_at,
+							   outerrelids))
+				return false;
+		}
+
+		*param_exprs = list_append_unique(*param_exprs, node);
+	}
+
+	list_free(vars);
+
+	return true;
+}
+
+/*
+ * get_resultcache_path
+ *	  If possible, make and return a ResultCache path atop of 'inner_path'.
+ *	  Otherwise return NULL.
+ *
+ * The cache keys are the outer rel's Vars and PHVs used by the join
+ * clauses that were pushed into the inner path, plus those referenced
+ * laterally by the inner rel.  Those are the values of the nestloop
+ * parameters that inner_path depends on.  Should we have missed any
+ * parameter, the executor throws away the cache whenever it changes, so
+ * that's only a matter of efficiency.
+ *
+ * The inner path must not contain volatile functions, since we assume that
+ * rescanning it with the same parameter values produces the same rows.
+ */
+static Path *
+get_resultcache_path(PlannerInfo *root, RelOptInfo *innerrel,
+					 RelOptInfo *outerrel, Path *inner_path,
+					 Path *outer_path, JoinType jointype,
+					 JoinPathExtraData *extra)
+{
+	RangeTblEntry *rte;
+	List	   *param_exprs = NIL;
+	ListCell   *lc;
+
+	/* Obviously not if it's disabled */
+	if (!enable_resultcache)
+		return NULL;
+
+	/*
+	 * We can safely not bother with all this unless we expect to perform
+	 * more than one inner scan.  The first scan is always going to be a
+	 * cache miss.  This would likely fail later anyway based on costs, so
+	 * this is really just to save some wasted effort.
+	 */
+	if (outer_path->parent->rows < 2)
+		return NULL;
+
+	/*
+	 * We can only have a result cache when there's some kind of cache key,
+	 * i.e. the inner path is parameterized, and only by the outer rel, so
+	 * that all of its parameters are set by this join.
+	 */
+	if (inner_path->param_info == NULL ||
+		!bms_is_subset(inner_path->param_info->ppi_req_outer,
+					   outerrel->relids))
+		return NULL;
+
+	/* Keep to plain base relations, whose lateral references we know */
+	if (innerrel->reloptkind != RELOPT_BASEREL)
+		return NULL;
+
+	/*
+	 * When the nestloop stops at the first match of each outer row, the
+	 * cache entries can only be completed if we know that there is at most
+	 * one such row.  That is the case when inner_path is unique for the
+	 * join clauses, as long as all of them are checked by inner_path: a row
+	 * rejected by a join qual at the nestloop makes it ask for another one.
+	 */
+	if (extra->inner_unique)
+	{
+		foreach(lc, extra->restrictlist)
+		{
+			if (!list_member_ptr(inner_path->param_info->ppi_clauses,
+								 lfirst(lc)))
+				return NULL;
+		}
+	}
+	else if (jointype == JOIN_SEMI || jointype == JOIN_ANTI)
+		return NULL;
+
+	/* Check for volatile functions anywhere in the inner rel */
+	if (contain_volatile_functions((Node *) innerrel->reltarget->exprs))
+		return NULL;
+
+	foreach(lc, innerrel->baserestrictinfo)
+	{
+		RestrictInfo *rinfo = (RestrictInfo *) lfirst(lc);
+
+		if (contain_volatile_functions((Node *) rinfo->clause))
+			return NULL;
+	}
+
+	rte = planner_rt_fetch(innerrel->relid, root);
+	switch (rte->rtekind)
+	{
+		case RTE_RELATION:
+			if (rte->tablesample != NULL)
+				return NULL;
+			break;
+		case RTE_SUBQUERY:
+			if (contain_volatile_functions((Node *) rte->subquery))
+				return NULL;
+			break;
+		case RTE_FUNCTION:
+			if (contain_volatile_functions((Node *) rte->functions))
+				return NULL;
+			break;
+		case RTE_TABLEFUNC:
+			if (contain_volatile_functions((Node *) rte->tablefunc))
+				return NULL;
+			break;
+		case RTE_VALUES:
+			if (contain_volatile_functions((Node *) rte->values_lists))
+				return NULL;
+			break;
+		default:
+			return NULL;
+	}
+
+	/* Collect the cache keys */
+	foreach(lc, inner_path->param_info->ppi_clauses)
+	{
+		RestrictInfo *rinfo = (RestrictInfo *) lfirst(lc);
+
+		if (contain_volatile_functions((Node *) rinfo->clause) ||
+			!resultcache_add_param_exprs(root, (Node *) rinfo->clause,
+										 outerrel->relids, &param_exprs))
+			return NULL;
+	}
+
+	if (!resultcache_add_param_exprs(root, (Node *) innerrel->lateral_vars,
+									 outerrel->relids, &param_exprs))
+		return NULL;
+
+	if (param_exprs == NIL)
+		return NULL;
+
+	return (Path *) create_resultcache_path(root,
+											innerrel,
+											inner_path,
+											param_exprs,
+											extra->inner_unique,
+											outer_path->rows);
+}
+
 /*
  * try_nestloop_path
  *	  Consider a nestloop join path; if it appears useful, push it into
@@ -1471,6 +1664,7 @@ match_unsorted_outer(PlannerInfo *root,
 			foreach(lc2, innerrel->cheapest_parameterized_paths)
 			{
 				Path	   *innerpath = (Path *) lfirst(lc2);
+				Path	   *rcpath;
 
 				try_nestloop_path(root,
 								  joinrel,
@@ -1479,6 +1673,22 @@ match_unsorted_outer(PlannerInfo *root,
 								  merge_pathkeys,
 								  jointype,
 								  extra);
+
+				/*
+				 * Also consider caching the results of the inner path, in
+				 * case the outer path has many repeated join keys.
+				 */
+				rcpath = get_resultcache_path(root, innerrel, outerrel,
+											  innerpath, outerpath, jointype,
+											  extra);
+				if (rcpath != NULL)
+					try_nestloop_path(root,
+									  joinrel,
+									  outerpath,
+									  rcpath,
+									  merge_pathkeys,
+									  jointype,
+									  extra);
 			}
 
 			/* Also consider materialized form of the cheapest inner path */
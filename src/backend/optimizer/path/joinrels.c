@@ -40,6 +40,8 @@ static bool restriction_is_constant_false(List *restrictlist,
 static void populate_joinrel_with_paths(PlannerInfo *root, RelOptInfo *rel1,
 							RelOptInfo *rel2, RelOptInfo *joinrel,
 							SpecialJoinInfo *sjinfo, List *restrictlist);
+static bool match_join_partitions(RelOptInfo *joinrel, RelOptInfo *rel,
+					  int **part_map);
 static void try_partitionwise_join(PlannerInfo *root, RelOptInfo *rel1,
 					   RelOptInfo *rel2, RelOptInfo *joinrel,
 					   SpecialJoinInfo *parent_sjinfo,
@@ -1314,6 +1316,8 @@ try_partitionwise_join(PlannerInfo *root, RelOptInfo *rel1, RelOptInfo *rel2,
 {
 	int			nparts;
 	int			cnt_parts;
+	int		   *part_map1;
+	int		   *part_map2;
 
 	/* Guard against stack overflow due to overly deep partition hierarchy. */
 	check_stack_depth();
@@ -1345,18 +1349,19 @@ try_partitionwise_join(PlannerInfo *root, RelOptInfo *rel1, RelOptInfo *rel2,
 		   joinrel->part_scheme == rel2->part_scheme);
 
 	/*
-	 * Since we allow partitionwise join only when the partition bounds of the
-	 * joining relations exactly match, the partition bounds of the join
-	 * should match those of the joining relations.
+	 * Find the partitions of the joining relations that make up each
+	 * partition of the join.  The join's partition bounds were taken from
+	 * one of the relations of the pair that first formed it; for another
+	 * pair, there may be no matching partitions, or they may be matched the
+	 * wrong way round for an outer join (see build_joinrel_partition_info).
+	 * Don't consider partitionwise join for this pair in that case.
 	 */
-	Assert(partition_bounds_equal(joinrel->part_scheme->partnatts,
-								  joinrel->part_scheme->parttyplen,
-								  joinrel->part_scheme->parttypbyval,
-								  joinrel->boundinfo, rel1->boundinfo));
-	Assert(partition_bounds_equal(joinrel->part_scheme->partnatts,
-								  joinrel->part_scheme->parttyplen,
-								  joinrel->part_scheme->parttypbyval,
-								  joinrel->boundinfo, rel2->boundinfo));
+	if (!match_join_partitions(joinrel, rel1, &part_map1) ||
+		!match_join_partitions(joinrel, rel2, &part_map2))
+		return;
+	if ((part_map1 != NULL && parent_sjinfo->jointype != JOIN_INNER) ||
+		(part_map2 != NULL && parent_sjinfo->jointype == JOIN_FULL))
+		return;
 
 	nparts = joinrel->nparts;
 
@@ -1367,8 +1372,8 @@ try_partitionwise_join(PlannerInfo *root, RelOptInfo *rel1, RelOptInfo *rel2,
 	 */
 	for (cnt_parts = 0; cnt_parts < nparts; cnt_parts++)
 	{
-		RelOptInfo *child_rel1 = rel1->part_rels[cnt_parts];
-		RelOptInfo *child_rel2 = rel2->part_rels[cnt_parts];
+		RelOptInfo *child_rel1;
+		RelOptInfo *child_rel2;
 		SpecialJoinInfo *child_sjinfo;
 		List	   *child_restrictlist;
 		RelOptInfo *child_joinrel;
@@ -1376,6 +1381,11 @@ try_partitionwise_join(PlannerInfo *root, RelOptInfo *rel1, RelOptInfo *rel2,
 		AppendRelInfo **appinfos;
 		int			nappinfos;
 
+		child_rel1 = rel1->part_rels[part_map1 ?
+									 part_map1[cnt_parts] : cnt_parts];
+		child_rel2 = rel2->part_rels[part_map2 ?
+									 part_map2[cnt_parts] : cnt_parts];
+
 		/* We should never try to join two overlapping sets of rels. */
 		Assert(!bms_overlap(child_rel1->relids, child_rel2->relids));
 		child_joinrelids = bms_union(child_rel1->relids, child_rel2->relids);
@@ -1417,6 +1427,45 @@ try_partitionwise_join(PlannerInfo *root, RelOptInfo *rel1, RelOptInfo *rel2,
 	}
 }
 
+/*
+ * match_join_partitions
+ *		Match the partitions of a partitioned join to those of one of the
+ *		relations being joined.
+ *
+ * If the relation's partition bounds are the same as the join's, each
+ * partition of the join is made from the relation's partition with the same
+ * index, and *part_map is set to NULL.  Otherwise, for range partitioning,
+ * each partition of the join may lie within a single partition of the
+ * relation, which *part_map is then set to map it to.  Returns false if
+ * neither applies.
+ */
+static bool
+match_join_partitions(RelOptInfo *joinrel, RelOptInfo *rel, int **part_map)
+{
+	PartitionScheme part_scheme = joinrel->part_scheme;
+
+	*part_map = NULL;
+
+	if (rel->boundinfo == joinrel->boundinfo ||
+		(rel->nparts == joinrel->nparts &&
+		 partition_bounds_equal(part_scheme->partnatts,
+								part_scheme->parttyplen,
+								part_scheme->parttypbyval,
+								joinrel->boundinfo, rel->boundinfo)))
+		return true;
+
+	if (part_scheme->strategy != PARTITION_STRATEGY_RANGE)
+		return false;
+
+	*part_map = partition_bounds_nested_map(part_scheme->partnatts,
+											part_scheme->partsupfunc,
+											part_scheme->partcollation,
+											joinrel->boundinfo,
+											joinrel->nparts,
+											rel->boundinfo);
+	return *part_map != NULL;
+}
+
 /*
  * Returns true if there exists an equi-join condition for each pair of
  * partition keys from given relations being joined.
@@ -22,6 +22,7 @@
 #include "access/stratnum.h"
 #include "access/sysattr.h"
 #include "catalog/pg_class.h"
+#include "catalog/pg_type.h"
 #include "foreign/fdwapi.h"
 #include "miscadmin.h"
 #include "nodes/extensible.h"
@@ -89,6 +90,8 @@ static Result *create_result_plan(PlannerInfo *root, ResultPath *best_path);
 static ProjectSet *create_project_set_plan(PlannerInfo *root, ProjectSetPath *best_path);
 static Material *create_material_plan(PlannerInfo *root, MaterialPath *best_path,
 					 int flags);
+static ResultCache *create_resultcache_plan(PlannerInfo *root,
+						ResultCachePath *best_path, int flags);
 static Plan *create_unique_plan(PlannerInfo *root, UniquePath *best_path,
 				   int flags);
 static Gather *create_gather_plan(PlannerInfo *root, GatherPath *best_path);
@@ -97,6 +100,8 @@ static Plan *create_projection_plan(PlannerInfo *root,
 					   int flags);
 static Plan *inject_projection_plan(Plan *subplan, List *tlist, bool parallel_safe);
 static Sort *create_sort_plan(PlannerInfo *root, SortPath *best_path, int flags);
+static IncrementalSort *create_incrementalsort_plan(PlannerInfo *root,
+							IncrementalSortPath *best_path, int flags);
 static Group *create_group_plan(PlannerInfo *root, GroupPath *best_path);
 static Unique *create_upper_unique_plan(PlannerInfo *root, UpperUniquePath *best_path,
 						 int flags);
@@ -124,6 +129,8 @@ static BitmapHeapScan *create_bitmap_scan_plan(PlannerInfo *root,
 static Plan *create_bitmap_subplan(PlannerInfo *root, Path *bitmapqual,
 					  List **qual, List **indexqual, List **indexECs);
 static void bitmap_subplan_mark_shared(Plan *plan);
+static bool bitmap_qual_can_build_parallel(Path *bitmapqual);
+static void bitmap_subplan_mark_parallel_aware(Plan *plan);
 static TidScan *create_tidscan_plan(PlannerInfo *root, TidPath *best_path,
 					List *tlist, List *scan_clauses);
 static SubqueryScan *create_subqueryscan_plan(PlannerInfo *root,
@@ -148,6 +155,8 @@ static CustomScan *create_customscan_plan(PlannerInfo *root,
 					   List *tlist, List *scan_clauses);
 static NestLoop *create_nestloop_plan(PlannerInfo *root, NestPath *best_path);
 static MergeJoin *create_mergejoin_plan(PlannerInfo *root, MergePath *best_path);
+static int add_mergejoin_skip_qual(PlannerInfo *root, MergePath *best_path,
+						Plan *inner_plan, OpExpr *mergeclause);
 static HashJoin *create_hashjoin_plan(PlannerInfo *root, HashPath *best_path);
 static Node *replace_nestloop_params(PlannerInfo *root, Node *expr);
 static Node *replace_nestloop_params_mutator(Node *node, PlannerInfo *root);
@@ -169,12 +178,12 @@ static IndexScan *make_indexscan(List *qptlist, List *qpqual, Index scanrelid,
 			   Oid indexid, List *indexqual, List *indexqualorig,
 			   List *indexorderby, List *indexorderbyorig,
 			   List *indexorderbyops,
-			   ScanDirection indexscandir);
+			   ScanDirection indexscandir, bool indexskip);
 static IndexOnlyScan *make_indexonlyscan(List *qptlist, List *qpqual,
 				   Index scanrelid, Oid indexid,
 				   List *indexqual, List *indexorderby,
 				   List *indextlist,
-				   ScanDirection indexscandir);
+				   ScanDirection indexscandir, bool indexskip);
 static BitmapIndexScan *make_bitmap_indexscan(Index scanrelid, Oid indexid,
 					  List *indexqual,
 					  List *indexqualorig);
@@ -237,6 +246,10 @@ static MergeJoin *make_mergejoin(List *tlist,
 static Sort *make_sort(Plan *lefttree, int numCols,
 		  AttrNumber *sortColIdx, Oid *sortOperators,
 		  Oid *collations, bool *nullsFirst);
+static IncrementalSort *make_incrementalsort(Plan *lefttree,
+					 int numCols, int presortedCols,
+					 AttrNumber *sortColIdx, Oid *sortOperators,
+					 Oid *collations, bool *nullsFirst);
 static Plan *prepare_sort_from_pathkeys(Plan *lefttree, List *pathkeys,
 						   Relids relids,
 						   const AttrNumber *reqColIdx,
@@ -251,10 +264,16 @@ static EquivalenceMember *find_ec_member_for_tle(EquivalenceClass *ec,
 					   Relids relids);
 static Sort *make_sort_from_pathkeys(Plan *lefttree, List *pathkeys,
 						Relids relids);
+static IncrementalSort *make_incrementalsort_from_pathkeys(Plan *lefttree,
+								   List *pathkeys, Relids relids,
+								   int presortedCols);
 static Sort *make_sort_from_groupcols(List *groupcls,
 						 AttrNumber *grpColIdx,
 						 Plan *lefttree);
 static Material *make_material(Plan *lefttree);
+static ResultCache *make_resultcache(Plan *lefttree, List *param_exprs,
+				 bool singlerow, uint32 est_entries,
+				 Bitmapset *keyparamids);
 static WindowAgg *make_windowagg(List *tlist, Index winref,
 			   int partNumCols, AttrNumber *partColIdx, Oid *partOperators,
 			   int ordNumCols, AttrNumber *ordColIdx, Oid *ordOperators,
@@ -422,6 +441,11 @@ create_plan_recurse(PlannerInfo *root, Path *best_path, int flags)
 												 (MaterialPath *) best_path,
 												 flags);
 			break;
+		case T_ResultCache:
+			plan = (Plan *) create_resultcache_plan(root,
+													(ResultCachePath *) best_path,
+													flags);
+			break;
 		case T_Unique:
 			if (IsA(best_path, UpperUniquePath))
 			{
@@ -446,6 +470,11 @@ create_plan_recurse(PlannerInfo *root, Path *best_path, int flags)
 											 (SortPath *) best_path,
 											 flags);
 			break;
+		case T_IncrementalSort:
+			plan = (Plan *) create_incrementalsort_plan(root,
+														(IncrementalSortPath *) best_path,
+														flags);
+			break;
 		case T_Group:
 			plan = (Plan *) create_group_plan(root,
 											  (GroupPath *) best_path);
@@ -1336,6 +1365,38 @@ create_material_plan(PlannerInfo *root, MaterialPath *best_path, int flags)
 	return plan;
 }
 
+/*
+ * create_resultcache_plan
+ *	  Create a ResultCache plan for 'best_path' and (recursively) plans
+ *	  for its subpaths.
+ *
+ *	  Returns a Plan node.
+ */
+static ResultCache *
+create_resultcache_plan(PlannerInfo *root, ResultCachePath *best_path, int flags)
+{
+	ResultCache *plan;
+	Plan	   *subplan;
+	List	   *param_exprs;
+	Bitmapset  *keyparamids;
+
+	/* As for Material, we want no excess columns in the cached tuples */
+	subplan = create_plan_recurse(root, best_path->subpath,
+								  flags | CP_SMALL_TLIST);
+
+	/* The cache keys are nestloop params set by the enclosing nestloop */
+	param_exprs = (List *) replace_nestloop_params(root, (Node *)
+												   best_path->param_exprs);
+	keyparamids = pull_paramids((Expr *) param_exprs);
+
+	plan = make_resultcache(subplan, param_exprs, best_path->singlerow,
+							best_path->est_entries, keyparamids);
+
+	copy_generic_path_info(&plan->plan, (Path *) best_path);
+
+	return plan;
+}
+
 /*
  * create_unique_plan
  *	  Create a Unique plan for 'best_path' and (recursively) plans
@@ -1821,6 +1882,33 @@ create_sort_plan(PlannerInfo *root, SortPath *best_path, int flags)
 	return plan;
 }
 
+/*
+ * create_incrementalsort_plan
+ *
+ *	  Create an IncrementalSort plan for 'best_path' and (recursively) plans
+ *	  for its subpaths.
+ */
+static IncrementalSort *
+create_incrementalsort_plan(PlannerInfo *root, IncrementalSortPath *best_path,
+							int flags)
+{
+	IncrementalSort *plan;
+	Plan	   *subplan;
+
+	/* See comments in create_sort_plan() above */
+	subplan = create_plan_recurse(root, best_path->spath.subpath,
+								  flags | CP_SMALL_TLIST);
+	plan = make_incrementalsort_from_pathkeys(subplan,
+											  best_path->spath.path.pathkeys,
+											  IS_OTHER_REL(best_path->spath.subpath->parent) ?
+											  best_path->spath.path.parent->relids : NULL,
+											  best_path->presortedCols);
+
+	copy_generic_path_info(&plan->sort.plan, (Path *) best_path);
+
+	return plan;
+}
+
 /*
  * create_group_plan
  *
@@ -2725,7 +2813,8 @@ create_indexscan_plan(PlannerInfo *root,
 												fixed_indexquals,
 												fixed_indexorderbys,
 												best_path->indexinfo->indextlist,
-												best_path->indexscandir);
+												best_path->indexscandir,
+												best_path->indexskip);
 	else
 		scan_plan = (Scan *) make_indexscan(tlist,
 											qpqual,
@@ -2736,7 +2825,8 @@ create_indexscan_plan(PlannerInfo *root,
 											fixed_indexorderbys,
 											indexorderbys,
 											indexorderbyops,
-											best_path->indexscandir);
+											best_path->indexscandir,
+											best_path->indexskip);
 
 	copy_generic_path_info(&scan_plan->plan, &best_path->path);
 
@@ -2772,8 +2862,19 @@ create_bitmap_scan_plan(PlannerInfo *root,
 										   &bitmapqualorig, &indexquals,
 										   &indexECs);
 
+	/*
+	 * In a parallel bitmap heap scan, either one process builds the bitmap
+	 * in shared memory, or, if every index scan can be divided between the
+	 * processes, they all build bitmaps for their share and the executor
+	 * merges them.
+	 */
 	if (best_path->path.parallel_aware)
-		bitmap_subplan_mark_shared(bitmapqualplan);
+	{
+		if (bitmap_qual_can_build_parallel(best_path->bitmapqual))
+			bitmap_subplan_mark_parallel_aware(bitmapqualplan);
+		else
+			bitmap_subplan_mark_shared(bitmapqualplan);
+	}
 
 	/*
 	 * The qpqual list must contain all restrictions not automatically handled
@@ -4168,12 +4269,90 @@ create_mergejoin_plan(PlannerInfo *root,
 							   best_path->jpath.inner_unique,
 							   best_path->skip_mark_restore);
 
+	/*
+	 * If final_cost_mergejoin decided that the executor should re-seek the
+	 * inner index scan forward, give that scan the qual it needs for it.
+	 */
+	if (best_path->skip_inner)
+		join_plan->skipParam = add_mergejoin_skip_qual(root, best_path,
+													   inner_plan,
+													   linitial_node(OpExpr, mergeclauses));
+
 	/* Costs of sort and material steps are included in path cost already */
 	copy_generic_path_info(&join_plan->join.plan, &best_path->jpath.path);
 
 	return join_plan;
 }
 
+/*
+ * add_mergejoin_skip_qual
+ *	  Add an "indexkey >= $n" qual on the leading column of a mergejoin's
+ *	  inner index scan, where $n is a new PARAM_EXEC Param through which the
+ *	  MergeJoin node passes down its current outer key before rescanning the
+ *	  inner side.  Returns the Param's ID.
+ *
+ * final_cost_mergejoin has already checked that the inner path is a suitable
+ * btree index scan, and that 'mergeclause' (which has the outer expression
+ * on the left) is on the index's leading column.  Since the new qual is on
+ * the first index column, we put it at the front of the index qual list, as
+ * btree wants index quals ordered by column.
+ */
+static int
+add_mergejoin_skip_qual(PlannerInfo *root, MergePath *best_path,
+						Plan *inner_plan, OpExpr *mergeclause)
+{
+	IndexOptInfo *index = ((IndexPath *) best_path->jpath.innerjoinpath)->indexinfo;
+	Node	   *outerexpr = (Node *) linitial(mergeclause->args);
+	Node	   *innerexpr = (Node *) lsecond(mergeclause->args);
+	Oid			outertype;
+	Oid			innertype;
+	Oid			geop;
+	Param	   *param;
+	Expr	   *indexqual;
+
+	op_input_types(mergeclause->opno, &outertype, &innertype);
+	geop = get_opfamily_member(index->opfamily[0], innertype, outertype,
+							   BTGreaterEqualStrategyNumber);
+	if (!OidIsValid(geop))		/* should not happen */
+		elog(ERROR, "missing operator %d(%u,%u) in opfamily %u",
+			 BTGreaterEqualStrategyNumber, innertype, outertype,
+			 index->opfamily[0]);
+
+	param = SS_make_runtime_param(root,
+								  exprType(outerexpr),
+								  exprTypmod(outerexpr),
+								  exprCollation(outerexpr));
+
+	indexqual = make_opclause(geop, BOOLOID, false,
+							  (Expr *) fix_indexqual_operand(innerexpr, index, 0),
+							  (Expr *) param,
+							  InvalidOid, index->indexcollations[0]);
+
+	if (IsA(inner_plan, IndexScan))
+	{
+		IndexScan  *iscan = (IndexScan *) inner_plan;
+
+		iscan->indexqual = lcons(indexqual, iscan->indexqual);
+		iscan->indexqualorig =
+			lcons(make_opclause(geop, BOOLOID, false,
+								(Expr *) copyObject(innerexpr),
+								(Expr *) copyObject(param),
+								InvalidOid, index->indexcollations[0]),
+				  iscan->indexqualorig);
+	}
+	else if (IsA(inner_plan, IndexOnlyScan))
+	{
+		IndexOnlyScan *ioscan = (IndexOnlyScan *) inner_plan;
+
+		ioscan->indexqual = lcons(indexqual, ioscan->indexqual);
+	}
+	else
+		elog(ERROR, "unrecognized node type: %d",
+			 (int) nodeTag(inner_plan));
+
+	return param->paramid;
+}
+
 static HashJoin *
 create_hashjoin_plan(PlannerInfo *root,
 					 HashPath *best_path)
@@ -5069,6 +5248,76 @@ bitmap_subplan_mark_shared(Plan *plan)
 		elog(ERROR, "unrecognized node type: %d", nodeTag(plan));
 }
 
+/*
+ * bitmap_qual_can_build_parallel
+ *	 Can the processes of a parallel bitmap heap scan build its bitmap
+ *	 together?
+ *
+ * Each process gets the TIDs from its share of every index scan, so that only
+ * works if the bitmap is a union of index scans: intersecting partial results
+ * would lose matches.  The index AMs must support parallel scans, and we
+ * can't have array keys that are processed by the executor, since it rescans
+ * the index for each element.
+ */
+static bool
+bitmap_qual_can_build_parallel(Path *bitmapqual)
+{
+	if (IsA(bitmapqual, BitmapOrPath))
+	{
+		ListCell   *l;
+
+		foreach(l, ((BitmapOrPath *) bitmapqual)->bitmapquals)
+		{
+			if (!bitmap_qual_can_build_parallel((Path *) lfirst(l)))
+				return false;
+		}
+		return true;
+	}
+	else if (IsA(bitmapqual, IndexPath))
+	{
+		IndexPath  *ipath = (IndexPath *) bitmapqual;
+		ListCell   *l;
+
+		if (!ipath->indexinfo->amcanparallel)
+			return false;
+
+		if (!ipath->indexinfo->amsearcharray)
+		{
+			foreach(l, ipath->indexquals)
+			{
+				RestrictInfo *rinfo = lfirst_node(RestrictInfo, l);
+
+				if (IsA(rinfo->clause, ScalarArrayOpExpr))
+					return false;
+			}
+		}
+		return true;
+	}
+
+	return false;
+}
+
+/*
+ * bitmap_subplan_mark_parallel_aware
+ *	 Mark the index scans in bitmap subplan as parallel-aware, so that each
+ *	 process scans only part of every index.
+ */
+static void
+bitmap_subplan_mark_parallel_aware(Plan *plan)
+{
+	if (IsA(plan, BitmapOr))
+	{
+		ListCell   *l;
+
+		foreach(l, ((BitmapOr *) plan)->bitmapplans)
+			bitmap_subplan_mark_parallel_aware((Plan *) lfirst(l));
+	}
+	else if (IsA(plan, BitmapIndexScan))
+		plan->parallel_aware = true;
+	else
+		elog(ERROR, "unrecognized node type: %d", nodeTag(plan));
+}
+
 /*****************************************************************************
  *
  *	PLAN NODE BUILDING ROUTINES
@@ -5129,7 +5378,8 @@ make_indexscan(List *qptlist,
 			   List *indexorderby,
 			   List *indexorderbyorig,
 			   List *indexorderbyops,
-			   ScanDirection indexscandir)
+			   ScanDirection indexscandir,
+			   bool indexskip)
 {
 	IndexScan  *node = makeNode(IndexScan);
 	Plan	   *plan = &node->scan.plan;
@@ -5146,6 +5396,7 @@ make_indexscan(List *qptlist,
 	node->indexorderbyorig = indexorderbyorig;
 	node->indexorderbyops = indexorderbyops;
 	node->indexorderdir = indexscandir;
+	node->indexskip = indexskip;
 
 	return node;
 }
@@ -5158,7 +5409,8 @@ make_indexonlyscan(List *qptlist,
 				   List *indexqual,
 				   List *indexorderby,
 				   List *indextlist,
-				   ScanDirection indexscandir)
+				   ScanDirection indexscandir,
+				   bool indexskip)
 {
 	IndexOnlyScan *node = makeNode(IndexOnlyScan);
 	Plan	   *plan = &node->scan.plan;
@@ -5173,6 +5425,7 @@ make_indexonlyscan(List *qptlist,
 	node->indexorderby = indexorderby;
 	node->indextlist = indextlist;
 	node->indexorderdir = indexscandir;
+	node->indexskip = indexskip;
 
 	return node;
 }
@@ -5602,6 +5855,7 @@ make_mergejoin(List *tlist,
 	plan->lefttree = lefttree;
 	plan->righttree = righttree;
 	node->skip_mark_restore = skip_mark_restore;
+	node->skipParam = -1;
 	node->mergeclauses = mergeclauses;
 	node->mergeFamilies = mergefamilies;
 	node->mergeCollations = mergecollations;
@@ -5641,6 +5895,34 @@ make_sort(Plan *lefttree, int numCols,
 	return node;
 }
 
+/*
+ * make_incrementalsort --- basic routine to build an IncrementalSort plan node
+ *
+ * Caller must have built the sortColIdx, sortOperators, collations, and
+ * nullsFirst arrays already.
+ */
+static IncrementalSort *
+make_incrementalsort(Plan *lefttree, int numCols, int presortedCols,
+					 AttrNumber *sortColIdx, Oid *sortOperators,
+					 Oid *collations, bool *nullsFirst)
+{
+	IncrementalSort *node = makeNode(IncrementalSort);
+	Plan	   *plan = &node->sort.plan;
+
+	plan->targetlist = lefttree->targetlist;
+	plan->qual = NIL;
+	plan->lefttree = lefttree;
+	plan->righttree = NULL;
+	node->presortedCols = presortedCols;
+	node->sort.numCols = numCols;
+	node->sort.sortColIdx = sortColIdx;
+	node->sort.sortOperators = sortOperators;
+	node->sort.collations = collations;
+	node->sort.nullsFirst = nullsFirst;
+
+	return node;
+}
+
 /*
  * prepare_sort_from_pathkeys
  *	  Prepare to sort according to given pathkeys
@@ -5987,6 +6269,43 @@ make_sort_from_pathkeys(Plan *lefttree, List *pathkeys, Relids relids)
 					 collations, nullsFirst);
 }
 
+/*
+ * make_incrementalsort_from_pathkeys
+ *	  Create incremental sort plan to sort according to given pathkeys
+ *
+ *	  'lefttree' is the node which yields input tuples
+ *	  'pathkeys' is the list of pathkeys by which the result is to be sorted
+ *	  'relids' is the set of relations required by prepare_sort_from_pathkeys()
+ *	  'presortedCols' is the number of presorted columns in input tuples
+ */
+static IncrementalSort *
+make_incrementalsort_from_pathkeys(Plan *lefttree, List *pathkeys,
+								   Relids relids, int presortedCols)
+{
+	int			numsortkeys;
+	AttrNumber *sortColIdx;
+	Oid		   *sortOperators;
+	Oid		   *collations;
+	bool	   *nullsFirst;
+
+	/* Compute sort column info, and adjust lefttree as needed */
+	lefttree = prepare_sort_from_pathkeys(lefttree, pathkeys,
+										  relids,
+										  NULL,
+										  false,
+										  &numsortkeys,
+										  &sortColIdx,
+										  &sortOperators,
+										  &collations,
+										  &nullsFirst);
+	Assert(presortedCols > 0 && presortedCols < numsortkeys);
+
+	/* Now build the IncrementalSort node */
+	return make_incrementalsort(lefttree, numsortkeys, presortedCols,
+								sortColIdx, sortOperators,
+								collations, nullsFirst);
+}
+
 /*
  * make_sort_from_sortclauses
  *	  Create sort plan to sort according to given sortclauses
@@ -6098,6 +6417,27 @@ make_material(Plan *lefttree)
 	return node;
 }
 
+static ResultCache *
+make_resultcache(Plan *lefttree, List *param_exprs, bool singlerow,
+				 uint32 est_entries, Bitmapset *keyparamids)
+{
+	ResultCache *node = makeNode(ResultCache);
+	Plan	   *plan = &node->plan;
+
+	plan->targetlist = lefttree->targetlist;
+	plan->qual = NIL;
+	plan->lefttree = lefttree;
+	plan->righttree = NULL;
+
+	node->numKeys = list_length(param_exprs);
+	node->param_exprs = param_exprs;
+	node->singlerow = singlerow;
+	node->est_entries = est_entries;
+	node->keyparamids = keyparamids;
+
+	return node;
+}
+
 /*
  * materialize_finished_plan: stick a Material node atop a completed plan
  *
@@ -6701,7 +7041,9 @@ is_projection_capable_path(Path *path)
 	{
 		case T_Hash:
 		case T_Material:
+		case T_ResultCache:
 		case T_Sort:
+		case T_IncrementalSort:
 		case T_Unique:
 		case T_SetOp:
 		case T_LockRows:
@@ -6746,7 +7088,9 @@ is_projection_capable_plan(Plan *plan)
 	{
 		case T_Hash:
 		case T_Material:
+		case T_ResultCache:
 		case T_Sort:
+		case T_IncrementalSort:
 		case T_Unique:
 		case T_SetOp:
 		case T_LockRows:
@@ -96,6 +96,9 @@ static bool trivial_subqueryscan(SubqueryScan *plan);
 static void set_foreignscan_references(PlannerInfo *root,
 						   ForeignScan *fscan,
 						   int rtoffset);
+static void set_part_prune_info_references(PlannerInfo *root,
+							   PartitionPruneInfo *pruneinfo,
+							   int rtoffset);
 static void set_customscan_references(PlannerInfo *root,
 						  CustomScan *cscan,
 						  int rtoffset);
@@ -637,6 +640,7 @@ set_plan_refs(PlannerInfo *root, Plan *plan, int rtoffset)
 		case T_Hash:
 		case T_Material:
 		case T_Sort:
+		case T_IncrementalSort:
 		case T_Unique:
 		case T_SetOp:
 
@@ -655,6 +659,21 @@ set_plan_refs(PlannerInfo *root, Plan *plan, int rtoffset)
 			 */
 			Assert(plan->qual == NIL);
 			break;
+		case T_ResultCache:
+			{
+				ResultCache *rcplan = (ResultCache *) plan;
+
+				/*
+				 * Like the plan types above, ResultCache doesn't evaluate its
+				 * tlist or quals.  But its cache keys may need fixing.
+				 */
+				set_dummy_tlist_references(plan, rtoffset);
+				Assert(plan->qual == NIL);
+
+				rcplan->param_exprs = fix_scan_list(root, rcplan->param_exprs,
+													rtoffset);
+			}
+			break;
 		case T_LockRows:
 			{
 				LockRows   *splan = (LockRows *) plan;
@@ -912,20 +931,9 @@ set_plan_refs(PlannerInfo *root, Plan *plan, int rtoffset)
 											  rtoffset);
 				}
 				if (splan->part_prune_info)
-				{
-					foreach(l, splan->part_prune_info->prune_infos)
-					{
-						List	   *prune_infos = lfirst(l);
-						ListCell   *l2;
-
-						foreach(l2, prune_infos)
-						{
-							PartitionedRelPruneInfo *pinfo = lfirst(l2);
-
-							pinfo->rtindex += rtoffset;
-						}
-					}
-				}
+					set_part_prune_info_references(root,
+												   splan->part_prune_info,
+												   rtoffset);
 			}
 			break;
 		case T_MergeAppend:
@@ -945,20 +953,9 @@ set_plan_refs(PlannerInfo *root, Plan *plan, int rtoffset)
 											  rtoffset);
 				}
 				if (splan->part_prune_info)
-				{
-					foreach(l, splan->part_prune_info->prune_infos)
-					{
-						List	   *prune_infos = lfirst(l);
-						ListCell   *l2;
-
-						foreach(l2, prune_infos)
-						{
-							PartitionedRelPruneInfo *pinfo = lfirst(l2);
-
-							pinfo->rtindex += rtoffset;
-						}
-					}
-				}
+					set_part_prune_info_references(root,
+												   splan->part_prune_info,
+												   rtoffset);
 			}
 			break;
 		case T_RecursiveUnion:
@@ -1339,6 +1336,52 @@ set_customscan_references(PlannerInfo *root,
 	}
 }
 
+/*
+ * set_part_prune_info_references
+ *	   Do set_plan_references processing on the PartitionPruneInfo of an
+ *	   Append or MergeAppend
+ *
+ * Besides adjusting RT indexes, remember the PartitionPruneInfo if its
+ * initial pruning can be done before the executor locks are taken, along with
+ * the leaf partitions it may prune.
+ */
+static void
+set_part_prune_info_references(PlannerInfo *root,
+							   PartitionPruneInfo *pruneinfo,
+							   int rtoffset)
+{
+	PlannerGlobal *glob = root->glob;
+	ListCell   *l;
+
+	foreach(l, pruneinfo->prune_infos)
+	{
+		List	   *prune_infos = lfirst(l);
+		ListCell   *l2;
+
+		foreach(l2, prune_infos)
+		{
+			PartitionedRelPruneInfo *pinfo = lfirst(l2);
+			int			i;
+
+			pinfo->rtindex += rtoffset;
+
+			for (i = 0; i < pinfo->nparts; i++)
+			{
+				if (pinfo->leafpart_rti_map[i] == 0)
+					continue;
+				pinfo->leafpart_rti_map[i] += rtoffset;
+				if (pruneinfo->prune_before_locking)
+					glob->prunableRelids =
+						bms_add_member(glob->prunableRelids,
+									   pinfo->leafpart_rti_map[i]);
+			}
+		}
+	}
+
+	if (pruneinfo->prune_before_locking)
+		glob->partPruneInfos = lappend(glob->partPruneInfos, pruneinfo);
+}
+
 /*
  * copyVar
  *		Copy a Var node.
@@ -2688,6 +2688,10 @@ finalize_plan(PlannerInfo *root, Plan *plan,
 							  &context);
 			finalize_primnode((Node *) ((MergeJoin *) plan)->mergeclauses,
 							  &context);
+			/* a skip-ahead param is passed to the right child, as above */
+			if (((MergeJoin *) plan)->skipParam >= 0)
+				nestloop_params = bms_add_member(nestloop_params,
+												 ((MergeJoin *) plan)->skipParam);
 			break;
 
 		case T_HashJoin:
@@ -2791,10 +2795,16 @@ finalize_plan(PlannerInfo *root, Plan *plan,
 			/* rescan_param does *not* get added to scan_params */
 			break;
 
+		case T_ResultCache:
+			finalize_primnode((Node *) ((ResultCache *) plan)->param_exprs,
+							  &context);
+			break;
+
 		case T_ProjectSet:
 		case T_Hash:
 		case T_Material:
 		case T_Sort:
+		case T_IncrementalSort:
 		case T_Unique:
 		case T_SetOp:
 		case T_Group:
@@ -2986,6 +2996,22 @@ SS_make_initplan_output_param(PlannerInfo *root,
 	return generate_new_param(root, resulttype, resulttypmod, resultcollation);
 }
 
+/*
+ * SS_make_runtime_param - make a Param that one plan node will use to pass a
+ * value computed at run time down to a node below it
+ *
+ * This is for communication other than NestLoop parameterization, which has
+ * its own machinery.  Presently it is used only for the outer key that a
+ * skip-ahead MergeJoin hands to its inner index scan.
+ */
+Param *
+SS_make_runtime_param(PlannerInfo *root,
+					  Oid paramtype, int32 paramtypmod,
+					  Oid paramcollation)
+{
+	return generate_new_param(root, paramtype, paramtypmod, paramcollation);
+}
+
 /*
  * SS_make_initplan_from_plan - given a plan tree, make it an InitPlan
  *
@@ -108,6 +108,7 @@ static bool max_parallel_hazard_walker(Node *node,
 						   max_parallel_hazard_context *context);
 static bool contain_nonstrict_functions_walker(Node *node, void *context);
 static bool contain_context_dependent_node(Node *clause);
+static bool pull_paramids_walker(Node *node, Bitmapset **context);
 static bool contain_context_dependent_node_walker(Node *node, int *flags);
 static bool contain_leaked_vars_walker(Node *node, void *context);
 static Relids find_nonnullable_rels_walker(Node *node, bool top_level);
@@ -1126,6 +1127,26 @@ is_parallel_safe(PlannerInfo *root, Node *node)
 	return !max_parallel_hazard_walker(node, &context);
 }
 
+/*
+ * is_parallel_safe_expr
+ *		Detect whether the given expr, which is not part of any query being
+ *		planned, contains only parallel-safe functions.
+ *
+ * This is for callers that want to evaluate expressions in parallel workers
+ * of their own, without going through the planner.
+ */
+bool
+is_parallel_safe_expr(Node *node)
+{
+	max_parallel_hazard_context context;
+
+	context.max_hazard = PROPARALLEL_SAFE;
+	context.max_interesting = PROPARALLEL_RESTRICTED;
+	context.safe_param_ids = NIL;
+
+	return !max_parallel_hazard_walker(node, &context);
+}
+
 /* core logic for all parallel-hazard checks */
 static bool
 max_parallel_hazard_test(char proparallel, max_parallel_hazard_context *context)
@@ -2341,6 +2362,38 @@ NumRelids(Node *clause)
 	return result;
 }
 
+/*
+ * pull_paramids
+ *		Returns a Bitmapset containing the paramids of all PARAM_EXEC Params
+ *		in 'expr'.
+ */
+Bitmapset *
+pull_paramids(Expr *expr)
+{
+	Bitmapset  *result = NULL;
+
+	(void) pull_paramids_walker((Node *) expr, &result);
+
+	return result;
+}
+
+static bool
+pull_paramids_walker(Node *node, Bitmapset **context)
+{
+	if (node == NULL)
+		return false;
+	if (IsA(node, Param))
+	{
+		Param	   *param = (Param *) node;
+
+		if (param->paramkind == PARAM_EXEC)
+			*context = bms_add_member(*context, param->paramid);
+		return false;
+	}
+	return expression_tree_walker(node, pull_paramids_walker,
+								  (void *) context);
+}
+
 /*
  * CommuteOpExpr: commute a binary operator clause
  *
@@ -4767,7 +4820,7 @@ inline_function(Oid funcid, Oid result_type, Oid result_collid,
 	 * care about.  Also, we can punt as soon as we detect more than one
 	 * command in the function body.
 	 */
-	raw_parsetree_list = pg_parse_query(src);
+	raw_parsetree_list = get_sql_fn_raw_parsetrees(func_tuple, src);
 	if (list_length(raw_parsetree_list) != 1)
 		goto fail;
 
@@ -5312,7 +5365,7 @@ inline_set_returning_function(PlannerInfo *root, RangeTblEntry *rte)
 	 * rewriting here).  We can fail as soon as we find more than one query,
 	 * though.
 	 */
-	raw_parsetree_list = pg_parse_query(src);
+	raw_parsetree_list = get_sql_fn_raw_parsetrees(func_tuple, src);
 	if (list_length(raw_parsetree_list) != 1)
 		goto fail;
 
@@ -1588,6 +1588,7 @@ build_joinrel_partition_info(RelOptInfo *joinrel, RelOptInfo *outer_rel,
 	int			partnatts;
 	int			cnt;
 	PartitionScheme part_scheme;
+	RelOptInfo *bound_rel;
 
 	/* Nothing to do if partitionwise join technique is disabled. */
 	if (!enable_partitionwise_join)
@@ -1624,15 +1625,42 @@ build_joinrel_partition_info(RelOptInfo *joinrel, RelOptInfo *outer_rel,
 		   REL_HAS_ALL_PART_PROPS(inner_rel));
 
 	/*
-	 * For now, our partition matching algorithm can match partitions only
-	 * when the partition bounds of the joining relations are exactly same.
-	 * So, bail out otherwise.
+	 * Our partition matching algorithm can match partitions when the
+	 * partition bounds of the joining relations are exactly same.  For range
+	 * partitioning, it can also match them when each partition of one
+	 * relation lies within a single partition of the other; the join is then
+	 * partitioned like the relation with the smaller partitions, each of
+	 * which joins to the containing partition of the other relation.  Except
+	 * for an inner join, that only works if the smaller partitions are on
+	 * the outer side, since a row of a larger partition might otherwise need
+	 * to be joined in several child joins; and not at all for a full join.
+	 * Bail out if none of these cases applies.
 	 */
-	if (outer_rel->nparts != inner_rel->nparts ||
-		!partition_bounds_equal(part_scheme->partnatts,
-								part_scheme->parttyplen,
-								part_scheme->parttypbyval,
-								outer_rel->boundinfo, inner_rel->boundinfo))
+	if (outer_rel->nparts == inner_rel->nparts &&
+		partition_bounds_equal(part_scheme->partnatts,
+							   part_scheme->parttyplen,
+							   part_scheme->parttypbyval,
+							   outer_rel->boundinfo, inner_rel->boundinfo))
+		bound_rel = outer_rel;
+	else if (part_scheme->strategy == PARTITION_STRATEGY_RANGE &&
+			 jointype != JOIN_FULL &&
+			 partition_bounds_nested_map(part_scheme->partnatts,
+										 part_scheme->partsupfunc,
+										 part_scheme->partcollation,
+										 outer_rel->boundinfo,
+										 outer_rel->nparts,
+										 inner_rel->boundinfo) != NULL)
+		bound_rel = outer_rel;
+	else if (part_scheme->strategy == PARTITION_STRATEGY_RANGE &&
+			 jointype == JOIN_INNER &&
+			 partition_bounds_nested_map(part_scheme->partnatts,
+										 part_scheme->partsupfunc,
+										 part_scheme->partcollation,
+										 inner_rel->boundinfo,
+										 inner_rel->nparts,
+										 outer_rel->boundinfo) != NULL)
+		bound_rel = inner_rel;
+	else
 	{
 		Assert(!IS_PARTITIONED_REL(joinrel));
 		return;
@@ -1649,15 +1677,15 @@ build_joinrel_partition_info(RelOptInfo *joinrel, RelOptInfo *outer_rel,
 
 	/*
 	 * Join relation is partitioned using the same partitioning scheme as the
-	 * joining relations and has same bounds.
+	 * joining relations and has the bounds chosen above.
 	 */
 	joinrel->part_scheme = part_scheme;
-	joinrel->boundinfo = outer_rel->boundinfo;
+	joinrel->boundinfo = bound_rel->boundinfo;
 	partnatts = joinrel->part_scheme->partnatts;
 	joinrel->partexprs = (List **) palloc0(sizeof(List *) * partnatts);
 	joinrel->nullable_partexprs =
 		(List **) palloc0(sizeof(List *) * partnatts);
-	joinrel->nparts = outer_rel->nparts;
+	joinrel->nparts = bound_rel->nparts;
 	joinrel->part_rels =
 		(RelOptInfo **) palloc0(sizeof(RelOptInfo *) * joinrel->nparts);
 
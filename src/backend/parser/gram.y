@@ -186,6 +186,8 @@ static void SplitColQualList(List *qualList,
 static void processCASbits(int cas_bits, int location, const char *constrType,
 			   bool *deferrable, bool *initdeferred, bool *not_valid,
 			   bool *no_inherit, core_yyscan_t yyscanner);
+static void processVacuumOptions(List *optlist, int *options, int *nworkers,
+					 core_yyscan_t yyscanner);
 static Node *makeRecursiveViewSelect(char *relname, List *aliases, Node *query);
 
 %}
@@ -305,8 +307,9 @@ static Node *makeRecursiveViewSelect(char *relname, List *aliases, Node *query);
 				create_extension_opt_item alter_extension_opt_item
 
 %type <ival>	opt_lock lock_type cast_context
-%type <ival>	vacuum_option_list vacuum_option_elem
-				analyze_option_list analyze_option_elem
+%type <list>	vacuum_option_list
+%type <defelt>	vacuum_option_elem
+%type <ival>	analyze_option_list analyze_option_elem
 %type <boolean>	opt_or_replace
 				opt_grant_grant_option opt_grant_admin_option
 				opt_nowait opt_if_exists opt_with_data
@@ -10491,34 +10494,27 @@ VacuumStmt: VACUUM opt_full opt_freeze opt_verbose opt_analyze opt_vacuum_relati
 			| VACUUM '(' vacuum_option_list ')' opt_vacuum_relation_list
 				{
 					VacuumStmt *n = makeNode(VacuumStmt);
-					n->options = VACOPT_VACUUM | $3;
+					n->options = VACOPT_VACUUM;
+					processVacuumOptions($3, &n->options, &n->nworkers,
+										 yyscanner);
 					n->rels = $5;
 					$$ = (Node *) n;
 				}
 		;
 
 vacuum_option_list:
-			vacuum_option_elem								{ $$ = $1; }
-			| vacuum_option_list ',' vacuum_option_elem		{ $$ = $1 | $3; }
+			vacuum_option_elem								{ $$ = list_make1($1); }
+			| vacuum_option_list ',' vacuum_option_elem		{ $$ = lappend($1, $3); }
 		;
 
 vacuum_option_elem:
-			analyze_keyword		{ $$ = VACOPT_ANALYZE; }
-			| VERBOSE			{ $$ = VACOPT_VERBOSE; }
-			| FREEZE			{ $$ = VACOPT_FREEZE; }
-			| FULL				{ $$ = VACOPT_FULL; }
-			| IDENT
-				{
-					if (strcmp($1, "disable_page_skipping") == 0)
-						$$ = VACOPT_DISABLE_PAGE_SKIPPING;
-					else if (strcmp($1, "skip_locked") == 0)
-						$$ = VACOPT_SKIP_LOCKED;
-					else
-						ereport(ERROR,
-								(errcode(ERRCODE_SYNTAX_ERROR),
-							 errmsg("unrecognized VACUUM option \"%s\"", $1),
-									 parser_errposition(@1)));
-				}
+			analyze_keyword		{ $$ = makeDefElem("analyze", NULL, @1); }
+			| VERBOSE			{ $$ = makeDefElem("verbose", NULL, @1); }
+			| FREEZE			{ $$ = makeDefElem("freeze", NULL, @1); }
+			| FULL				{ $$ = makeDefElem("full", NULL, @1); }
+			| PARALLEL Iconst
+				{ $$ = makeDefElem("parallel", (Node *) makeInteger($2), @1); }
+			| IDENT				{ $$ = makeDefElem($1, NULL, @1); }
 		;
 
 AnalyzeStmt: analyze_keyword opt_verbose opt_vacuum_relation_list
@@ -10550,6 +10546,8 @@ analyze_option_elem:
 				{
 					if (strcmp($1, "skip_locked") == 0)
 						$$ = VACOPT_SKIP_LOCKED;
+					else if (strcmp($1, "skip_unchanged") == 0)
+						$$ = VACOPT_SKIP_UNCHANGED;
 					else
 						ereport(ERROR,
 								(errcode(ERRCODE_SYNTAX_ERROR),
@@ -16231,6 +16229,47 @@ processCASbits(int cas_bits, int location, const char *constrType,
 	}
 }
 
+/*
+ * Process the options of the parenthesized form of VACUUM into the flags and
+ * parallel degree of the VacuumStmt.
+ */
+static void
+processVacuumOptions(List *optlist, int *options, int *nworkers,
+					 core_yyscan_t yyscanner)
+{
+	ListCell   *lc;
+
+	foreach(lc, optlist)
+	{
+		DefElem    *opt = (DefElem *) lfirst(lc);
+
+		if (strcmp(opt->defname, "analyze") == 0)
+			*options |= VACOPT_ANALYZE;
+		else if (strcmp(opt->defname, "verbose") == 0)
+			*options |= VACOPT_VERBOSE;
+		else if (strcmp(opt->defname, "freeze") == 0)
+			*options |= VACOPT_FREEZE;
+		else if (strcmp(opt->defname, "full") == 0)
+			*options |= VACOPT_FULL;
+		else if (strcmp(opt->defname, "disable_page_skipping") == 0)
+			*options |= VACOPT_DISABLE_PAGE_SKIPPING;
+		else if (strcmp(opt->defname, "skip_locked") == 0)
+			*options |= VACOPT_SKIP_LOCKED;
+		else if (strcmp(opt->defname, "parallel") == 0)
+		{
+			/* PARALLEL 0 means no parallelism, not the default choice */
+			*nworkers = intVal(opt->arg);
+			if (*nworkers == 0)
+				*nworkers = -1;
+		}
+		else
+			ereport(ERROR,
+					(errcode(ERRCODE_SYNTAX_ERROR),
+					 errmsg("unrecognized VACUUM option \"%s\"", opt->defname),
+					 parser_errposition(opt->location)));
+	}
+}
+
 /*----------
  * Recursive view transformation
  *
@@ -769,6 +769,107 @@ partition_bounds_equal(int partnatts, int16 *parttyplen, bool *parttypbyval,
 	return true;
 }
 
+/*
+ * partition_bounds_nested_map
+ *
+ * For two collections of range partition bounds, check whether each of the
+ * nparts1 partitions of b1 lies entirely within a single partition of b2.
+ * If so, return an array mapping each partition index of b1 to the index of
+ * the b2 partition containing it; otherwise return NULL.  This is the case
+ * for, say, a table partitioned by day and one partitioned by month, so that
+ * all join partners of a row in a partition of the first table are in the
+ * containing partition of the other.
+ *
+ * We don't try to handle default partitions, whose contents are defined by
+ * what the other partitions leave over.
+ */
+int *
+partition_bounds_nested_map(int partnatts, FmgrInfo *partsupfunc,
+							Oid *partcollation,
+							PartitionBoundInfo b1, int nparts1,
+							PartitionBoundInfo b2)
+{
+	int		   *map;
+	PartitionRangeBound bound2;
+	int			i;
+	int			j;
+
+	Assert(b1->strategy == PARTITION_STRATEGY_RANGE &&
+		   b2->strategy == PARTITION_STRATEGY_RANGE);
+
+	if (partition_bound_has_default(b1) || partition_bound_has_default(b2))
+		return NULL;
+
+	map = (int *) palloc(sizeof(int) * nparts1);
+	for (i = 0; i < nparts1; i++)
+		map[i] = -1;
+
+	/*
+	 * Walk through b1's bounds in order.  Each one that has a valid index is
+	 * the upper bound of that partition, and the bound before it is the
+	 * partition's lower bound.  Since both arrays are sorted, the b2 bound
+	 * at or above the current upper bound only ever moves forward.  Since
+	 * all the bounds are either inclusive lower or exclusive upper bounds of
+	 * their partitions, we compare them as plain values.
+	 */
+	bound2.index = -1;
+	bound2.lower = false;
+	j = 0;
+	for (i = 1; i < b1->ndatums; i++)
+	{
+		int			part1 = b1->indexes[i];
+
+		/* Skip over gaps between b1's partitions */
+		if (part1 < 0)
+			continue;
+
+		/* Find the first b2 bound that is not less than the upper bound */
+		for (; j < b2->ndatums; j++)
+		{
+			bound2.datums = b2->datums[j];
+			bound2.kind = b2->kind[j];
+			if (partition_rbound_cmp(partnatts, partsupfunc, partcollation,
+									 b1->datums[i], b1->kind[i], false,
+									 &bound2) <= 0)
+				break;
+		}
+
+		/*
+		 * That must be the upper bound of some b2 partition, and that
+		 * partition's lower bound must not be above b1's partition's.  Note
+		 * that b2->indexes[0] is always -1, so j - 1 is valid below.
+		 */
+		if (j >= b2->ndatums || b2->indexes[j] < 0)
+		{
+			pfree(map);
+			return NULL;
+		}
+		bound2.datums = b2->datums[j - 1];
+		bound2.kind = b2->kind[j - 1];
+		if (partition_rbound_cmp(partnatts, partsupfunc, partcollation,
+								 b1->datums[i - 1], b1->kind[i - 1], false,
+								 &bound2) < 0)
+		{
+			pfree(map);
+			return NULL;
+		}
+
+		map[part1] = b2->indexes[j];
+	}
+
+	/* Every partition of b1 should have been seen */
+	for (i = 0; i < nparts1; i++)
+	{
+		if (map[i] < 0)
+		{
+			pfree(map);
+			return NULL;
+		}
+	}
+
+	return map;
+}
+
 /*
  * Return a copy of given PartitionBoundInfo structure. The data types of bounds
  * are described by given partition key specification.
@@ -167,6 +167,7 @@ static Bitmapset *pull_exec_paramids(Expr *expr);
 static bool pull_exec_paramids_walker(Node *node, Bitmapset **context);
 static bool analyze_partkey_exprs(PartitionedRelPruneInfo *pinfo, List *steps,
 					  int partnatts);
+static bool initial_pruning_is_immutable(List *prunerelinfos);
 static PruneStepResult *perform_pruning_base_step(PartitionPruneContext *context,
 						  PartitionPruneStepOp *opstep);
 static PruneStepResult *perform_pruning_combine_step(PartitionPruneContext *context,
@@ -271,6 +272,8 @@ make_partition_pruneinfo(PlannerInfo *root, RelOptInfo *parentrel,
 	/* Else build the result data structure */
 	pruneinfo = makeNode(PartitionPruneInfo);
 	pruneinfo->prune_infos = prunerelinfos;
+	pruneinfo->prune_before_locking =
+		initial_pruning_is_immutable(prunerelinfos);
 
 	/*
 	 * Some subplans may not belong to any of the listed partitioned rels.
@@ -362,6 +365,7 @@ make_partitionedrel_pruneinfo(PlannerInfo *root, RelOptInfo *parentrel,
 		int			partnatts = subpart->part_scheme->partnatts;
 		int		   *subplan_map;
 		int		   *subpart_map;
+		int		   *leafpart_rti_map;
 		List	   *partprunequal;
 		List	   *pruning_steps;
 		bool		contradictory;
@@ -437,6 +441,7 @@ make_partitionedrel_pruneinfo(PlannerInfo *root, RelOptInfo *parentrel,
 		 */
 		subplan_map = (int *) palloc(nparts * sizeof(int));
 		subpart_map = (int *) palloc(nparts * sizeof(int));
+		leafpart_rti_map = (int *) palloc0(nparts * sizeof(int));
 		present_parts = NULL;
 
 		for (i = 0; i < nparts; i++)
@@ -450,6 +455,7 @@ make_partitionedrel_pruneinfo(PlannerInfo *root, RelOptInfo *parentrel,
 			if (subplanidx >= 0)
 			{
 				present_parts = bms_add_member(present_parts, i);
+				leafpart_rti_map[i] = (int) partrel->relid;
 
 				/* Record finding this subplan  */
 				subplansfound = bms_add_member(subplansfound, subplanidx);
@@ -465,6 +471,7 @@ make_partitionedrel_pruneinfo(PlannerInfo *root, RelOptInfo *parentrel,
 		pinfo->nparts = nparts;
 		pinfo->subplan_map = subplan_map;
 		pinfo->subpart_map = subpart_map;
+		pinfo->leafpart_rti_map = leafpart_rti_map;
 
 		/* Determine which pruning types should be enabled at this level */
 		doruntimeprune |= analyze_partkey_exprs(pinfo, pruning_steps,
@@ -2965,6 +2972,64 @@ analyze_partkey_exprs(PartitionedRelPruneInfo *pinfo, List *steps,
 	return doruntimeprune;
 }
 
+/*
+ * initial_pruning_is_immutable
+ *		Is initial pruning worth doing, and does its result depend on nothing
+ *		but the plan and the values of external Params?
+ *
+ * If so, plancache.c may run it before taking the executor locks, and lock
+ * only the partitions that survive it, knowing that the executor will reach
+ * the same result later.  Stable functions could change their result in
+ * between, so expressions that aren't Consts must be immutable; those
+ * containing PARAM_EXEC Params don't matter, since they aren't used for
+ * initial pruning at all.
+ */
+static bool
+initial_pruning_is_immutable(List *prunerelinfos)
+{
+	bool		do_initial_prune = false;
+	ListCell   *lc;
+
+	foreach(lc, prunerelinfos)
+	{
+		List	   *pinfolist = lfirst_node(List, lc);
+		ListCell   *lc2;
+
+		foreach(lc2, pinfolist)
+		{
+			PartitionedRelPruneInfo *pinfo = lfirst(lc2);
+			ListCell   *lc3;
+
+			if (!pinfo->do_initial_prune)
+				continue;
+			do_initial_prune = true;
+
+			foreach(lc3, pinfo->pruning_steps)
+			{
+				PartitionPruneStepOp *step = lfirst(lc3);
+				ListCell   *lc4;
+
+				if (!IsA(step, PartitionPruneStepOp))
+					continue;
+
+				foreach(lc4, step->exprs)
+				{
+					Node	   *expr = lfirst(lc4);
+
+					if (IsA(expr, Const) ||
+						!bms_is_empty(pull_exec_paramids((Expr *) expr)))
+						continue;
+					if (contain_mutable_functions(expr) ||
+						contain_subplans(expr))
+						return false;
+				}
+			}
+		}
+	}
+
+	return do_initial_prune;
+}
+
 /*
  * perform_pruning_base_step
  *		Determines the indexes of datums that satisfy conditions specified in
@@ -0,0 +1,256 @@
+/*-------------------------------------------------------------------------
+ *
+ * pg_numa.c
+ *	  NUMA placement of shared memory.
+ *
+ * Only Linux is supported at present.  We call the mbind(2) and
+ * move_pages(2) system calls directly rather than through libnuma, since
+ * we need very little of what that library offers; the set of memory nodes
+ * is read from sysfs.  Memory policies set with mbind() on a shared mapping
+ * belong to the underlying shared memory object, so a policy applied by the
+ * postmaster before it touches a range governs wherever the pages of that
+ * range are eventually faulted in, by any process.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/port/pg_numa.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#include "storage/pg_numa.h"
+#include "storage/pg_shmem.h"
+
+#if defined(__linux__) && defined(SYS_mbind) && defined(SYS_move_pages)
+#define USE_LINUX_NUMA
+#endif
+
+#ifdef USE_LINUX_NUMA
+
+/* from <linux/mempolicy.h>, which we'd rather not depend on */
+#define PG_MPOL_BIND		2
+#define PG_MPOL_INTERLEAVE	3
+#define PG_MPOL_MF_MOVE		(1 << 1)
+
+#define NODEMASK_WORDS	(PG_NUMA_MAX_NODES / (8 * sizeof(unsigned long)) + 1)
+
+static bool numa_initialized = false;
+static int	numa_nnodes = 0;
+static Size numa_page_size = 0;
+static int	numa_node_ids[PG_NUMA_MAX_NODES];
+
+/*
+ * Read the list of online memory nodes, which sysfs presents in the usual
+ * kernel list format, e.g. "0-1,4".  Machines with a single node are
+ * treated as having no NUMA support at all, since there is nothing to place.
+ */
+static void
+pg_numa_init(void)
+{
+	FILE	   *fp;
+	char		buf[256];
+	char	   *p;
+
+	numa_initialized = true;
+
+	fp = fopen("/sys/devices/system/node/online", "r");
+	if (fp == NULL)
+		return;
+	if (fgets(buf, sizeof(buf), fp) == NULL)
+		buf[0] = '\0';
+	fclose(fp);
+
+	p = buf;
+	while (*p >= '0' && *p <= '9')
+	{
+		long		first,
+					last;
+
+		first = last = strtol(p, &p, 10);
+		if (*p == '-')
+			last = strtol(p + 1, &p, 10);
+		for (; first <= last && first < PG_NUMA_MAX_NODES; first++)
+			numa_node_ids[numa_nnodes++] = (int) first;
+		if (*p == ',')
+			p++;
+	}
+
+	if (numa_nnodes < 2)
+		numa_nnodes = 0;
+}
+
+/*
+ * Shrink [ptr, ptr + size) to whole pages, since mbind() insists on a
+ * page-aligned start.  Returns false if no complete page is left.
+ */
+static bool
+pg_numa_align_range(void **ptr, Size *size)
+{
+	uintptr_t	pagesize = (uintptr_t) pg_numa_page_size();
+	uintptr_t	start = (uintptr_t) *ptr;
+	uintptr_t	end = start + *size;
+
+	start = (start + pagesize - 1) & ~(pagesize - 1);
+	end &= ~(pagesize - 1);
+	if (end <= start)
+		return false;
+
+	*ptr = (void *) start;
+	*size = end - start;
+	return true;
+}
+
+static bool
+pg_numa_mbind(void *ptr, Size size, int mode, unsigned long *nodemask)
+{
+	if (!pg_numa_align_range(&ptr, &size))
+		return true;			/* nothing to do */
+
+	return syscall(SYS_mbind, ptr, (unsigned long) size, mode, nodemask,
+				   (unsigned long) PG_NUMA_MAX_NODES + 1,
+				   (unsigned int) PG_MPOL_MF_MOVE) == 0;
+}
+
+static void
+pg_numa_set_node(unsigned long *nodemask, int node_id)
+{
+	nodemask[node_id / (8 * sizeof(unsigned long))] |=
+		1UL << (node_id % (8 * sizeof(unsigned long)));
+}
+
+int
+pg_numa_num_nodes(void)
+{
+	if (!numa_initialized)
+		pg_numa_init();
+	return numa_nnodes;
+}
+
+/*
+ * The size of the pages backing the main shared memory segment.  When that
+ * got huge pages, mbind() ranges have to be aligned to the huge page size,
+ * or the kernel rejects them with EINVAL.
+ */
+Size
+pg_numa_page_size(void)
+{
+	if (numa_page_size == 0)
+	{
+		int			mmap_flags;
+
+		if (UsedShmemHugePages)
+			GetHugePageSize(&numa_page_size, &mmap_flags);
+		if (numa_page_size == 0)
+			numa_page_size = (Size) sysconf(_SC_PAGESIZE);
+	}
+	return numa_page_size;
+}
+
+bool
+pg_numa_interleave(void *ptr, Size size)
+{
+	unsigned long nodemask[NODEMASK_WORDS];
+	int			i;
+
+	if (pg_numa_num_nodes() == 0)
+		return false;
+
+	memset(nodemask, 0, sizeof(nodemask));
+	for (i = 0; i < numa_nnodes; i++)
+		pg_numa_set_node(nodemask, numa_node_ids[i]);
+
+	return pg_numa_mbind(ptr, size, PG_MPOL_INTERLEAVE, nodemask);
+}
+
+bool
+pg_numa_bind(void *ptr, Size size, int node)
+{
+	unsigned long nodemask[NODEMASK_WORDS];
+
+	if (node < 0 || node >= pg_numa_num_nodes())
+	{
+		errno = EINVAL;
+		return false;
+	}
+
+	memset(nodemask, 0, sizeof(nodemask));
+	pg_numa_set_node(nodemask, numa_node_ids[node]);
+
+	return pg_numa_mbind(ptr, size, PG_MPOL_BIND, nodemask);
+}
+
+bool
+pg_numa_query_nodes(void *ptr, int npages, int *nodes)
+{
+	void	   *pages[1024];
+	Size		pagesize = pg_numa_page_size();
+	int			done = 0;
+
+	if (pg_numa_num_nodes() == 0)
+		return false;
+
+	/* move_pages(2) with no target nodes only reports where pages are */
+	while (done < npages)
+	{
+		int			count = Min(npages - done, lengthof(pages));
+		int			i;
+
+		for (i = 0; i < count; i++)
+			pages[i] = (char *) ptr + (Size) (done + i) * pagesize;
+		if (syscall(SYS_move_pages, 0, (unsigned long) count, pages, NULL,
+					nodes + done, 0) != 0)
+			return false;
+		done += count;
+	}
+
+	/* pages never faulted in are reported with a negative errno */
+	for (done = 0; done < npages; done++)
+	{
+		if (nodes[done] < 0)
+			nodes[done] = -1;
+	}
+
+	return true;
+}
+
+#else							/* !USE_LINUX_NUMA */
+
+int
+pg_numa_num_nodes(void)
+{
+	return 0;
+}
+
+Size
+pg_numa_page_size(void)
+{
+	return BLCKSZ;
+}
+
+bool
+pg_numa_interleave(void *ptr, Size size)
+{
+	return false;
+}
+
+bool
+pg_numa_bind(void *ptr, Size size, int node)
+{
+	return false;
+}
+
+bool
+pg_numa_query_nodes(void *ptr, int npages, int *nodes)
+{
+	return false;
+}
+
+#endif							/* USE_LINUX_NUMA */
@@ -74,6 +74,7 @@ typedef int IpcMemoryId;		/* shared memory ID returned by shmget(2) */
 
 unsigned long UsedShmemSegID = 0;
 void	   *UsedShmemSegAddr = NULL;
+bool		UsedShmemHugePages = false;
 
 #ifdef USE_ANONYMOUS_SHMEM
 static Size AnonymousShmemSize;
@@ -370,10 +371,6 @@ PGSharedMemoryIsInUse(unsigned long id1, unsigned long id2)
 	return true;
 }
 
-#ifdef USE_ANONYMOUS_SHMEM
-
-#ifdef MAP_HUGETLB
-
 /*
  * Identify the huge page size to use.
  *
@@ -397,10 +394,13 @@ PGSharedMemoryIsInUse(unsigned long id1, unsigned long id2)
  * Currently *mmap_flags is always just MAP_HUGETLB.  Someday, on systems
  * that support it, we might OR in additional bits to specify a particular
  * non-default huge page size.
+ *
+ * Where huge pages aren't supported, both are returned as zero.
  */
-static void
+void
 GetHugePageSize(Size *hugepagesize, int *mmap_flags)
 {
+#ifdef MAP_HUGETLB
 	/*
 	 * If we fail to find out the system's default huge page size, assume it
 	 * is 2MB.  This will work fine when the actual size is less.  If it's
@@ -442,9 +442,13 @@ GetHugePageSize(Size *hugepagesize, int *mmap_flags)
 		}
 	}
 #endif							/* __linux__ */
+#else
+	*hugepagesize = 0;
+	*mmap_flags = 0;
+#endif							/* MAP_HUGETLB */
 }
 
-#endif							/* MAP_HUGETLB */
+#ifdef USE_ANONYMOUS_SHMEM
 
 /*
  * Creates an anonymous mmap()ed shared memory segment.
@@ -480,6 +484,8 @@ CreateAnonymousSegment(Size *size)
 		ptr = mmap(NULL, allocsize, PROT_READ | PROT_WRITE,
 				   PG_MMAP_FLAGS | mmap_flags, -1, 0);
 		mmap_errno = errno;
+		if (ptr != MAP_FAILED)
+			UsedShmemHugePages = true;
 		if (huge_pages == HUGE_PAGES_TRY && ptr == MAP_FAILED)
 			elog(DEBUG1, "mmap(%zu) with MAP_HUGETLB failed, huge pages disabled: %m",
 				 allocsize);
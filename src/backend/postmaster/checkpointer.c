@@ -382,6 +382,8 @@ CheckpointerMain(void)
 			ExitOnAnyError = true;
 			/* Close down the database */
 			ShutdownXLOG(0, 0);
+			/* Save the table and function stats for the next startup */
+			pgstat_write_object_stats();
 			/* Normal exit from the checkpointer is here */
 			proc_exit(0);		/* done */
 		}
@@ -687,12 +689,17 @@ CheckpointWriteDelay(int flags, double progress)
 		pgstat_send_bgwriter();
 
 		/*
+		 * If there are files we're done writing, use the slack to sync one
+		 * of them rather than napping, so that fewer fsyncs pile up at the
+		 * end of the checkpoint.
+		 *
 		 * This sleep used to be connected to bgwriter_delay, typically 200ms.
 		 * That resulted in more frequent wakeups if not much work to do.
 		 * Checkpointer and bgwriter are no longer related so take the Big
 		 * Sleep.
 		 */
-		pg_usleep(100000L);
+		if (!smgrsyncstep())
+			pg_usleep(100000L);
 	}
 	else if (--absorb_counter <= 0)
 	{
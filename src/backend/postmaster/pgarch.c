@@ -35,6 +35,7 @@
 
 #include "access/xlog.h"
 #include "access/xlog_internal.h"
+#include "lib/binaryheap.h"
 #include "libpq/pqsignal.h"
 #include "miscadmin.h"
 #include "pgstat.h"
@@ -72,6 +73,12 @@
  */
 #define NUM_ORPHAN_CLEANUP_RETRIES 3
 
+/*
+ * Maximum number of .ready files to gather from one scan of the archive
+ * status directory.
+ */
+#define NUM_FILES_PER_DIRECTORY_SCAN 64
+
 
 /* ----------
  * Local data
@@ -88,6 +95,19 @@ static volatile sig_atomic_t got_SIGTERM = false;
 static volatile sig_atomic_t wakened = false;
 static volatile sig_atomic_t ready_to_stop = false;
 
+/*
+ * Files gathered by the last scan of the archive status directory, stored
+ * from newest to oldest so that the next file to archive is the last one.
+ * arch_heap is only used while scanning.
+ */
+static binaryheap *arch_heap = NULL;
+static char arch_filenames[NUM_FILES_PER_DIRECTORY_SCAN][MAX_XFN_CHARS + 1];
+static char *arch_files[NUM_FILES_PER_DIRECTORY_SCAN];
+static int	arch_files_size = 0;
+
+/* Hook for archiving files in-process, instead of with archive_command */
+archive_file_hook_type archive_file_hook = NULL;
+
 /* ----------
  * Local function forward declarations
  * ----------
@@ -106,6 +126,7 @@ static void pgarch_MainLoop(void);
 static void pgarch_ArchiverCopyLoop(void);
 static bool pgarch_archiveXlog(char *xlog);
 static bool pgarch_readyXlog(char *xlog);
+static int	ready_file_comparator(Datum a, Datum b, void *arg);
 static void pgarch_archiveDone(char *xlog);
 
 
@@ -246,6 +267,10 @@ PgArchiverMain(int argc, char *argv[])
 	 */
 	init_ps_display("archiver", "", "", "");
 
+	/* Set up the heap used to gather files to archive */
+	arch_heap = binaryheap_allocate(NUM_FILES_PER_DIRECTORY_SCAN,
+									ready_file_comparator, NULL);
+
 	pgarch_MainLoop();
 
 	exit(0);
@@ -426,6 +451,13 @@ pgarch_ArchiverCopyLoop(void)
 {
 	char		xlog[MAX_XFN_CHARS + 1];
 
+	/*
+	 * Always start with a fresh scan of the archive status directory.  That
+	 * picks up a history file written since the files we still had were
+	 * gathered, and retries the file that made us give up last time.
+	 */
+	arch_files_size = 0;
+
 	/*
 	 * loop through all xlogs with archive_status of .ready and archive
 	 * them...mostly we expect this to be a single file, though it is possible
@@ -464,7 +496,7 @@ pgarch_ArchiverCopyLoop(void)
 			}
 
 			/* can't do anything if no command ... */
-			if (!XLogArchiveCommandSet())
+			if (!XLogArchiveCommandSet() && archive_file_hook == NULL)
 			{
 				ereport(WARNING,
 						(errmsg("archive_mode enabled, yet archive_command is not set")));
@@ -548,7 +580,8 @@ pgarch_ArchiverCopyLoop(void)
 /*
  * pgarch_archiveXlog
  *
- * Invokes system(3) to copy one archive file to wherever it should go
+ * Invokes archive_file_hook, or system(3) to run archive_command, to copy
+ * one archive file to wherever it should go
  *
  * Returns true if successful
  */
@@ -565,6 +598,30 @@ pgarch_archiveXlog(char *xlog)
 
 	snprintf(pathname, MAXPGPATH, XLOGDIR "/%s", xlog);
 
+	if (archive_file_hook)
+	{
+		/* Report archive activity in PS display */
+		snprintf(activitymsg, sizeof(activitymsg), "archiving %s", xlog);
+		set_ps_display(activitymsg, false);
+
+		if (!(*archive_file_hook) (xlog, pathname))
+		{
+			ereport(LOG,
+					(errmsg("archive hook failed for file \"%s\"", xlog)));
+
+			snprintf(activitymsg, sizeof(activitymsg), "failed on %s", xlog);
+			set_ps_display(activitymsg, false);
+
+			return false;
+		}
+		elog(DEBUG1, "archived write-ahead log file \"%s\"", xlog);
+
+		snprintf(activitymsg, sizeof(activitymsg), "last was %s", xlog);
+		set_ps_display(activitymsg, false);
+
+		return true;
+	}
+
 	/*
 	 * construct the command to be executed
 	 */
@@ -695,6 +752,15 @@ pgarch_archiveXlog(char *xlog)
  * 2) because the oldest ones will sooner become candidates for
  * recycling at time of checkpoint
  *
+ * Rather than scanning the archive status directory for every file, which
+ * gets expensive once many files have piled up, one scan gathers up to
+ * NUM_FILES_PER_DIRECTORY_SCAN of the oldest, and later calls hand them out
+ * until they run out.  Files that become ready in the meantime are all newer
+ * than those, except for a history file, which pgarch_ArchiverCopyLoop()
+ * picks up by rescanning whenever it is woken.  A history file is always
+ * written before any segment of its timeline, so the segments gathered
+ * together with an older history file never jump ahead of it.
+ *
  * NOTE: the "oldest" comparison will consider any .history file to be older
  * than any other file except another .history file.  Segments on a timeline
  * with a smaller ID will be older than all segments on a timeline with a
@@ -705,17 +771,39 @@ pgarch_archiveXlog(char *xlog)
 static bool
 pgarch_readyXlog(char *xlog)
 {
-	/*
-	 * open xlog status directory and read through list of xlogs that have the
-	 * .ready suffix, looking for earliest file. It is possible to optimise
-	 * this code, though only a single file is expected on the vast majority
-	 * of calls, so....
-	 */
 	char		XLogArchiveStatusDir[MAXPGPATH];
 	DIR		   *rldir;
 	struct dirent *rlde;
-	bool		found = false;
-	bool		historyFound = false;
+
+	/*
+	 * Hand out the next gathered file, skipping any whose status file has
+	 * disappeared since we scanned.
+	 */
+	while (arch_files_size > 0)
+	{
+		struct stat st;
+		char		status_file[MAXPGPATH];
+		char	   *arch_file;
+
+		arch_file = arch_files[--arch_files_size];
+		StatusFilePath(status_file, arch_file, ".ready");
+		if (stat(status_file, &st) == 0)
+		{
+			strcpy(xlog, arch_file);
+			return true;
+		}
+		else if (errno != ENOENT)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not stat file \"%s\": %m", status_file)));
+	}
+
+	/*
+	 * open xlog status directory and read through list of xlogs that have the
+	 * .ready suffix, keeping the oldest NUM_FILES_PER_DIRECTORY_SCAN in a
+	 * max-heap, so that the entry at its top is the one to replace.
+	 */
+	binaryheap_reset(arch_heap);
 
 	snprintf(XLogArchiveStatusDir, MAXPGPATH, XLOGDIR "/archive_status");
 	rldir = AllocateDir(XLogArchiveStatusDir);
@@ -724,7 +812,7 @@ pgarch_readyXlog(char *xlog)
 	{
 		int			basenamelen = (int) strlen(rlde->d_name) - 6;
 		char		basename[MAX_XFN_CHARS + 1];
-		bool		ishistory;
+		char	   *arch_file;
 
 		/* Ignore entries with unexpected number of characters */
 		if (basenamelen < MIN_XFN_CHARS ||
@@ -743,32 +831,62 @@ pgarch_readyXlog(char *xlog)
 		memcpy(basename, rlde->d_name, basenamelen);
 		basename[basenamelen] = '\0';
 
-		/* Is this a history file? */
-		ishistory = IsTLHistoryFileName(basename);
-
-		/*
-		 * Consume the file to archive.  History files have the highest
-		 * priority.  If this is the first file or the first history file
-		 * ever, copy it.  In the presence of a history file already chosen as
-		 * target, ignore all other files except history files which have been
-		 * generated for an older timeline than what is already chosen as
-		 * target to archive.
-		 */
-		if (!found || (ishistory && !historyFound))
+		if (arch_heap->bh_size < NUM_FILES_PER_DIRECTORY_SCAN)
 		{
-			strcpy(xlog, basename);
-			found = true;
-			historyFound = ishistory;
+			/* Heap not full yet, so just add it */
+			arch_file = arch_filenames[arch_heap->bh_size];
+			strcpy(arch_file, basename);
+			binaryheap_add_unordered(arch_heap, CStringGetDatum(arch_file));
+
+			/* Once it is full, give it the heap property */
+			if (arch_heap->bh_size == NUM_FILES_PER_DIRECTORY_SCAN)
+				binaryheap_build(arch_heap);
 		}
-		else if (ishistory || !historyFound)
+		else if (ready_file_comparator(binaryheap_first(arch_heap),
+									   CStringGetDatum(basename), NULL) > 0)
 		{
-			if (strcmp(basename, xlog) < 0)
-				strcpy(xlog, basename);
+			/* Replace the newest file we have so far */
+			arch_file = DatumGetCString(binaryheap_remove_first(arch_heap));
+			strcpy(arch_file, basename);
+			binaryheap_add(arch_heap, CStringGetDatum(arch_file));
 		}
 	}
 	FreeDir(rldir);
 
-	return found;
+	if (binaryheap_empty(arch_heap))
+		return false;
+
+	/* Newest first, so that the oldest is handed out first */
+	if (arch_heap->bh_size < NUM_FILES_PER_DIRECTORY_SCAN)
+		binaryheap_build(arch_heap);
+	while (!binaryheap_empty(arch_heap))
+		arch_files[arch_files_size++] =
+			DatumGetCString(binaryheap_remove_first(arch_heap));
+
+	strcpy(xlog, arch_files[--arch_files_size]);
+	return true;
+}
+
+/*
+ * ready_file_comparator
+ *
+ * Orders the names of files to archive from oldest to newest, as described
+ * for pgarch_readyXlog().  Used as the comparator of the max-heap gathering
+ * the oldest files, which keeps the newest of them at its top.
+ */
+static int
+ready_file_comparator(Datum a, Datum b, void *arg)
+{
+	char	   *a_str = DatumGetCString(a);
+	char	   *b_str = DatumGetCString(b);
+	bool		a_history = IsTLHistoryFileName(a_str);
+	bool		b_history = IsTLHistoryFileName(b_str);
+
+	/* History files come first */
+	if (a_history != b_history)
+		return a_history ? -1 : 1;
+
+	return strcmp(a_str, b_str);
 }
 
 /*
@@ -42,6 +42,7 @@
 #include "catalog/pg_database.h"
 #include "catalog/pg_proc.h"
 #include "common/ip.h"
+#include "lib/dshash.h"
 #include "libpq/libpq.h"
 #include "libpq/pqsignal.h"
 #include "mb/pg_wchar.h"
@@ -58,10 +59,13 @@
 #include "storage/latch.h"
 #include "storage/lmgr.h"
 #include "storage/pg_shmem.h"
+#include "storage/proc.h"
 #include "storage/procsignal.h"
 #include "storage/sinvaladt.h"
 #include "utils/ascii.h"
+#include "utils/dsa.h"
 #include "utils/guc.h"
+#include "utils/hashutils.h"
 #include "utils/memutils.h"
 #include "utils/ps_status.h"
 #include "utils/rel.h"
@@ -183,12 +187,26 @@ typedef struct TabStatHashEntry
 {
 	Oid			t_id;
 	PgStat_TableStatus *tsa_entry;
+	char		status;			/* hash status */
 } TabStatHashEntry;
 
 /*
- * Hash table for O(1) t_id -> tsa_entry lookup
- */
-static HTAB *pgStatTabHash = NULL;
+ * Hash table for O(1) t_id -> tsa_entry lookup.  This is probed every time
+ * a relation is opened, so it uses simplehash's open addressing rather than
+ * dynahash.
+ */
+#define SH_PREFIX tabstathash
+#define SH_ELEMENT_TYPE TabStatHashEntry
+#define SH_KEY_TYPE Oid
+#define SH_KEY t_id
+#define SH_HASH_KEY(tb, key) murmurhash32(key)
+#define SH_EQUAL(tb, a, b) ((a) == (b))
+#define SH_SCOPE static inline
+#define SH_DEFINE
+#define SH_DECLARE
+#include "lib/simplehash.h"
+
+static tabstathash_hash *pgStatTabHash = NULL;
 
 /*
  * Backends store per-function info that's waiting to be sent to the collector
@@ -202,6 +220,85 @@ static HTAB *pgStatFunctions = NULL;
  */
 static bool have_function_stats = false;
 
+/*
+ * Per-table and per-function statistics are kept in shared memory, in two
+ * dshash tables allocated from a DSA area whose first segment lies in the
+ * main shared memory segment.  Backends add their counts to them directly
+ * rather than sending them to the collector, so reading them never has to
+ * wait for the collector to write out a stats file.  They are only written
+ * to disk at shutdown, see pgstat_write_object_stats().
+ *
+ * Both kinds of entries start with a PgStat_ObjectKey, so that code which
+ * doesn't look at the statistics themselves can handle either table.
+ */
+typedef struct PgStat_ObjectKey
+{
+	Oid			databaseid;		/* InvalidOid for shared catalogs */
+	Oid			objectid;		/* OID of the table or function */
+} PgStat_ObjectKey;
+
+typedef struct PgStat_SharedTabEntry
+{
+	PgStat_ObjectKey key;
+	PgStat_StatTabEntry stats;
+} PgStat_SharedTabEntry;
+
+typedef struct PgStat_SharedFuncEntry
+{
+	PgStat_ObjectKey key;
+	PgStat_StatFuncEntry stats;
+} PgStat_SharedFuncEntry;
+
+typedef struct PgStat_ShmemControl
+{
+	dshash_table_handle tables_handle;
+	dshash_table_handle functions_handle;
+	/* the in-place DSA area follows, at MAXALIGN offset */
+} PgStat_ShmemControl;
+
+/* Size of the part of the DSA area that is in the main shared memory */
+#define PGSTAT_SHMEM_DSA_SIZE	(256 * 1024)
+
+static const dshash_parameters pgstat_tab_params = {
+	sizeof(PgStat_ObjectKey),
+	sizeof(PgStat_SharedTabEntry),
+	dshash_memcmp,
+	dshash_memhash,
+	LWTRANCHE_STATS_HASH
+};
+
+static const dshash_parameters pgstat_func_params = {
+	sizeof(PgStat_ObjectKey),
+	sizeof(PgStat_SharedFuncEntry),
+	dshash_memcmp,
+	dshash_memhash,
+	LWTRANCHE_STATS_HASH
+};
+
+static PgStat_ShmemControl *pgStatShmem = NULL;
+static dsa_area *pgStatArea = NULL;
+static dshash_table *pgStatSharedTables = NULL;
+static dshash_table *pgStatSharedFunctions = NULL;
+
+/*
+ * Backend-local copies of the shared entries looked up in the current
+ * transaction, so that repeated reads give consistent results.  A lookup
+ * that found nothing is remembered, too.
+ */
+typedef struct PgStat_SnapshotTabEntry
+{
+	PgStat_ObjectKey key;
+	bool		valid;			/* does the entry exist? */
+	PgStat_StatTabEntry stats;
+} PgStat_SnapshotTabEntry;
+
+typedef struct PgStat_SnapshotFuncEntry
+{
+	PgStat_ObjectKey key;
+	bool		valid;			/* does the entry exist? */
+	PgStat_StatFuncEntry stats;
+} PgStat_SnapshotFuncEntry;
+
 /*
  * Tuple insertion/deletion counts for an open transaction can't be propagated
  * into PgStat_TableStatus counters until we know if it is going to commit
@@ -222,6 +319,20 @@ static int	pgStatXactCommit = 0;
 static int	pgStatXactRollback = 0;
 PgStat_Counter pgStatBlockReadTime = 0;
 PgStat_Counter pgStatBlockWriteTime = 0;
+PgStat_Counter pgStatParallelWorkersToLaunch = 0;
+PgStat_Counter pgStatParallelWorkersLaunched = 0;
+
+/*
+ * Shared-buffer I/O counters for pg_stat_io.  As for the LWLock statistics,
+ * each PGPROC slot has its own counters in shared memory, one set per backend
+ * type and I/O context, so a process only writes to its own and needs no
+ * locking.  Slots are never cleared; readers sum over all of them.
+ */
+static PgStat_IOCounters *pgStatIOArray = NULL;
+PgStat_IOCounters *pgStatMyIO = NULL;
+
+#define IOStatsNumProcs()	(MaxBackends + NUM_AUXILIARY_PROCS)
+#define IOStatsPerProc		(BACKEND_NUM_TYPES * IOCONTEXT_NUM_TYPES)
 
 /* Record that's written to 2PC state file when pgstat state is persisted */
 typedef struct TwoPhasePgStatRecord
@@ -242,6 +353,8 @@ typedef struct TwoPhasePgStatRecord
  */
 static MemoryContext pgStatLocalContext = NULL;
 static HTAB *pgStatDBHash = NULL;
+static HTAB *pgStatTabSnapshot = NULL;
+static HTAB *pgStatFuncSnapshot = NULL;
 
 /* Status for backends including auxiliary */
 static LocalPgBackendStatus *localBackendStatusTable = NULL;
@@ -258,9 +371,8 @@ static PgStat_ArchiverStats archiverStats;
 static PgStat_GlobalStats globalStats;
 
 /*
- * List of OIDs of databases we need to write out.  If an entry is InvalidOid,
- * it means to write only the shared-catalog stats ("DB 0"); otherwise, we
- * will write both that DB's data and the shared stats.
+ * List of OIDs of databases whose stats backends have asked for.  Any entry
+ * means that the stats file has to be written.
  */
 static List *pending_write_requests = NIL;
 
@@ -286,24 +398,28 @@ static pid_t pgstat_forkexec(void);
 
 NON_EXEC_STATIC void PgstatCollectorMain(int argc, char *argv[]) pg_attribute_noreturn();
 static void pgstat_exit(SIGNAL_ARGS);
+static void pgstat_shutdown_hook(int code, Datum arg);
 static void pgstat_beshutdown_hook(int code, Datum arg);
 static void pgstat_sighup_handler(SIGNAL_ARGS);
 
 static PgStat_StatDBEntry *pgstat_get_db_entry(Oid databaseid, bool create);
-static PgStat_StatTabEntry *pgstat_get_tab_entry(PgStat_StatDBEntry *dbentry,
-					 Oid tableoid, bool create);
-static void pgstat_write_statsfiles(bool permanent, bool allDbs);
-static void pgstat_write_db_statsfile(PgStat_StatDBEntry *dbentry, bool permanent);
-static HTAB *pgstat_read_statsfiles(Oid onlydb, bool permanent, bool deep);
-static void pgstat_read_db_statsfile(Oid databaseid, HTAB *tabhash, HTAB *funchash, bool permanent);
+static void pgstat_write_statsfiles(bool permanent);
+static HTAB *pgstat_read_statsfiles(bool permanent);
 static void backend_read_statsfile(void);
 static void pgstat_read_current_status(void);
 
 static bool pgstat_write_statsfile_needed(void);
-static bool pgstat_db_requested(Oid databaseid);
 
+static void pgstat_attach_shared_stats(void);
+static PgStat_SharedTabEntry *pgstat_get_shared_tabentry(Oid databaseid,
+						   Oid tableoid);
+static void pgstat_remove_shared_entries(dshash_table *hash, Oid databaseid,
+							 HTAB *keep_oids);
+static bool pgstat_shared_entries_exist(dshash_table *hash, Oid databaseid);
+static void pgstat_flush_tabstat(PgStat_TableStatus *entry,
+					 PgStat_MsgTabstat *tsmsg);
 static void pgstat_send_tabstat(PgStat_MsgTabstat *tsmsg);
-static void pgstat_send_funcstats(void);
+static void pgstat_flush_funcstats(void);
 static HTAB *pgstat_collect_oids(Oid catalogid, AttrNumber anum_oid);
 
 static PgStat_TableStatus *get_tabstat_entry(Oid rel_id, bool isshared);
@@ -321,18 +437,13 @@ static void pgstat_send(void *msg, int len);
 
 static void pgstat_recv_inquiry(PgStat_MsgInquiry *msg, int len);
 static void pgstat_recv_tabstat(PgStat_MsgTabstat *msg, int len);
-static void pgstat_recv_tabpurge(PgStat_MsgTabpurge *msg, int len);
 static void pgstat_recv_dropdb(PgStat_MsgDropdb *msg, int len);
 static void pgstat_recv_resetcounter(PgStat_MsgResetcounter *msg, int len);
 static void pgstat_recv_resetsharedcounter(PgStat_MsgResetsharedcounter *msg, int len);
 static void pgstat_recv_resetsinglecounter(PgStat_MsgResetsinglecounter *msg, int len);
 static void pgstat_recv_autovac(PgStat_MsgAutovacStart *msg, int len);
-static void pgstat_recv_vacuum(PgStat_MsgVacuum *msg, int len);
-static void pgstat_recv_analyze(PgStat_MsgAnalyze *msg, int len);
 static void pgstat_recv_archiver(PgStat_MsgArchiver *msg, int len);
 static void pgstat_recv_bgwriter(PgStat_MsgBgWriter *msg, int len);
-static void pgstat_recv_funcstat(PgStat_MsgFuncstat *msg, int len);
-static void pgstat_recv_funcpurge(PgStat_MsgFuncpurge *msg, int len);
 static void pgstat_recv_recoveryconflict(PgStat_MsgRecoveryConflict *msg, int len);
 static void pgstat_recv_deadlock(PgStat_MsgDeadlock *msg, int len);
 static void pgstat_recv_tempfile(PgStat_MsgTempFile *msg, int len);
@@ -648,10 +759,13 @@ pgstat_reset_remove_files(const char *directory)
 
 		/*
 		 * Skip directory entries that don't match the file names we write.
-		 * See get_dbstat_filename for the database-specific pattern.
+		 * Database-specific files were written by older releases, but they
+		 * are removed too.
 		 */
 		if (strncmp(entry->d_name, "global.", 7) == 0)
 			nchars = 7;
+		else if (strncmp(entry->d_name, "objects.", 8) == 0)
+			nchars = 8;
 		else
 		{
 			nchars = 0;
@@ -802,10 +916,12 @@ allow_immediate_pgstat_restart(void)
  * pgstat_report_stat() -
  *
  *	Must be called by processes that performs DML: tcop/postgres.c, logical
- *	receiver processes, SPI worker, etc. to send the so far collected
- *	per-table and function usage statistics to the collector.  Note that this
- *	is called only when not within a transaction, so it is fair to use
- *	transaction stop time as an approximation of current time.
+ *	receiver processes, SPI worker, etc. to report the so far collected
+ *	per-table and function usage statistics.  The per-table and per-function
+ *	counts are added to the shared-memory statistics, and the database-wide
+ *	totals are sent to the collector.  Note that this is called only when not
+ *	within a transaction, so it is fair to use transaction stop time as an
+ *	approximation of current time.
  * ----------
  */
 void
@@ -818,6 +934,8 @@ pgstat_report_stat(bool force)
 	TimestampTz now;
 	PgStat_MsgTabstat regular_msg;
 	PgStat_MsgTabstat shared_msg;
+	bool		have_regular = false;
+	bool		have_shared = false;
 	TabStatusArray *tsa;
 	int			i;
 
@@ -828,8 +946,8 @@ pgstat_report_stat(bool force)
 		return;
 
 	/*
-	 * Don't send a message unless it's been at least PGSTAT_STAT_INTERVAL
-	 * msec since we last sent one, or the caller wants to force stats out.
+	 * Don't report unless it's been at least PGSTAT_STAT_INTERVAL msec since
+	 * we last did, or the caller wants to force stats out.
 	 */
 	now = GetCurrentTransactionStopTimestamp();
 	if (!force &&
@@ -845,27 +963,25 @@ pgstat_report_stat(bool force)
 	 * pgStatTabList, and that's safe.)
 	 */
 	if (pgStatTabHash)
-		hash_destroy(pgStatTabHash);
+		tabstathash_destroy(pgStatTabHash);
 	pgStatTabHash = NULL;
 
 	/*
 	 * Scan through the TabStatusArray struct(s) to find tables that actually
-	 * have counts, and build messages to send.  We have to separate shared
-	 * relations from regular ones because the databaseid field in the message
-	 * header has to depend on that.
+	 * have counts, and add them to the shared statistics.  The database-wide
+	 * sums go into two messages, because shared relations are counted under
+	 * the entry of the "database" with OID 0.
 	 */
+	MemSet(&regular_msg, 0, sizeof(regular_msg));
+	MemSet(&shared_msg, 0, sizeof(shared_msg));
 	regular_msg.m_databaseid = MyDatabaseId;
 	shared_msg.m_databaseid = InvalidOid;
-	regular_msg.m_nentries = 0;
-	shared_msg.m_nentries = 0;
 
 	for (tsa = pgStatTabList; tsa != NULL; tsa = tsa->tsa_next)
 	{
 		for (i = 0; i < tsa->tsa_used; i++)
 		{
 			PgStat_TableStatus *entry = &tsa->tsa_entries[i];
-			PgStat_MsgTabstat *this_msg;
-			PgStat_TableEntry *this_ent;
 
 			/* Shouldn't have any pending transaction-dependent counts */
 			Assert(entry->trans == NULL);
@@ -878,18 +994,15 @@ pgstat_report_stat(bool force)
 					   sizeof(PgStat_TableCounts)) == 0)
 				continue;
 
-			/*
-			 * OK, insert data into the appropriate message, and send if full.
-			 */
-			this_msg = entry->t_shared ? &shared_msg : &regular_msg;
-			this_ent = &this_msg->m_entry[this_msg->m_nentries];
-			this_ent->t_id = entry->t_id;
-			memcpy(&this_ent->t_counts, &entry->t_counts,
-				   sizeof(PgStat_TableCounts));
-			if (++this_msg->m_nentries >= PGSTAT_NUM_TABENTRIES)
+			if (entry->t_shared)
 			{
-				pgstat_send_tabstat(this_msg);
-				this_msg->m_nentries = 0;
+				pgstat_flush_tabstat(entry, &shared_msg);
+				have_shared = true;
+			}
+			else
+			{
+				pgstat_flush_tabstat(entry, &regular_msg);
+				have_regular = true;
 			}
 		}
 		/* zero out TableStatus structs after use */
@@ -899,17 +1012,73 @@ pgstat_report_stat(bool force)
 	}
 
 	/*
-	 * Send partial messages.  Make sure that any pending xact commit/abort
+	 * Send the database totals.  Make sure that any pending xact commit/abort
 	 * gets counted, even if there are no table stats to send.
 	 */
-	if (regular_msg.m_nentries > 0 ||
-		pgStatXactCommit > 0 || pgStatXactRollback > 0)
+	if (have_regular || pgStatXactCommit > 0 || pgStatXactRollback > 0)
 		pgstat_send_tabstat(&regular_msg);
-	if (shared_msg.m_nentries > 0)
+	if (have_shared)
 		pgstat_send_tabstat(&shared_msg);
 
-	/* Now, send function statistics */
-	pgstat_send_funcstats();
+	/* Now, add up function statistics */
+	pgstat_flush_funcstats();
+}
+
+/*
+ * Subroutine for pgstat_report_stat: add one table's counts to its
+ * shared-memory entry, and to the database totals in *tsmsg
+ */
+static void
+pgstat_flush_tabstat(PgStat_TableStatus *entry, PgStat_MsgTabstat *tsmsg)
+{
+	PgStat_TableCounts *counts = &entry->t_counts;
+	PgStat_SharedTabEntry *shent;
+	PgStat_StatTabEntry *tabentry;
+
+	/* It's unlikely we'd get here with no socket, but maybe not impossible */
+	if (pgStatSock == PGINVALID_SOCKET)
+		return;
+
+	shent = pgstat_get_shared_tabentry(tsmsg->m_databaseid, entry->t_id);
+	tabentry = &shent->stats;
+
+	tabentry->numscans += counts->t_numscans;
+	tabentry->tuples_returned += counts->t_tuples_returned;
+	tabentry->tuples_fetched += counts->t_tuples_fetched;
+	tabentry->tuples_inserted += counts->t_tuples_inserted;
+	tabentry->tuples_updated += counts->t_tuples_updated;
+	tabentry->tuples_deleted += counts->t_tuples_deleted;
+	tabentry->tuples_hot_updated += counts->t_tuples_hot_updated;
+	/* If table was truncated, first reset the live/dead counters */
+	if (counts->t_truncated)
+	{
+		tabentry->n_live_tuples = 0;
+		tabentry->n_dead_tuples = 0;
+	}
+	tabentry->n_live_tuples += counts->t_delta_live_tuples;
+	tabentry->n_dead_tuples += counts->t_delta_dead_tuples;
+	tabentry->changes_since_analyze += counts->t_changed_tuples;
+	tabentry->inserts_since_vacuum += counts->t_tuples_inserted;
+	tabentry->blocks_fetched += counts->t_blocks_fetched;
+	tabentry->blocks_hit += counts->t_blocks_hit;
+
+	/* Clamp n_live_tuples in case of negative delta_live_tuples */
+	tabentry->n_live_tuples = Max(tabentry->n_live_tuples, 0);
+	/* Likewise for n_dead_tuples */
+	tabentry->n_dead_tuples = Max(tabentry->n_dead_tuples, 0);
+
+	dshash_release_lock(pgStatSharedTables, shent);
+
+	/*
+	 * Add per-table stats to the per-database totals, too.
+	 */
+	tsmsg->m_tuples_returned += counts->t_tuples_returned;
+	tsmsg->m_tuples_fetched += counts->t_tuples_fetched;
+	tsmsg->m_tuples_inserted += counts->t_tuples_inserted;
+	tsmsg->m_tuples_updated += counts->t_tuples_updated;
+	tsmsg->m_tuples_deleted += counts->t_tuples_deleted;
+	tsmsg->m_blocks_fetched += counts->t_blocks_fetched;
+	tsmsg->m_blocks_hit += counts->t_blocks_hit;
 }
 
 /*
@@ -918,16 +1087,13 @@ pgstat_report_stat(bool force)
 static void
 pgstat_send_tabstat(PgStat_MsgTabstat *tsmsg)
 {
-	int			n;
-	int			len;
-
 	/* It's unlikely we'd get here with no socket, but maybe not impossible */
 	if (pgStatSock == PGINVALID_SOCKET)
 		return;
 
 	/*
-	 * Report and reset accumulated xact commit/rollback and I/O timings
-	 * whenever we send a normal tabstat message
+	 * Report and reset accumulated xact commit/rollback, I/O timings and
+	 * parallel worker counts whenever we send a normal tabstat message
 	 */
 	if (OidIsValid(tsmsg->m_databaseid))
 	{
@@ -935,10 +1101,14 @@ pgstat_send_tabstat(PgStat_MsgTabstat *tsmsg)
 		tsmsg->m_xact_rollback = pgStatXactRollback;
 		tsmsg->m_block_read_time = pgStatBlockReadTime;
 		tsmsg->m_block_write_time = pgStatBlockWriteTime;
+		tsmsg->m_parallel_workers_to_launch = pgStatParallelWorkersToLaunch;
+		tsmsg->m_parallel_workers_launched = pgStatParallelWorkersLaunched;
 		pgStatXactCommit = 0;
 		pgStatXactRollback = 0;
 		pgStatBlockReadTime = 0;
 		pgStatBlockWriteTime = 0;
+		pgStatParallelWorkersToLaunch = 0;
+		pgStatParallelWorkersLaunched = 0;
 	}
 	else
 	{
@@ -946,68 +1116,72 @@ pgstat_send_tabstat(PgStat_MsgTabstat *tsmsg)
 		tsmsg->m_xact_rollback = 0;
 		tsmsg->m_block_read_time = 0;
 		tsmsg->m_block_write_time = 0;
+		tsmsg->m_parallel_workers_to_launch = 0;
+		tsmsg->m_parallel_workers_launched = 0;
 	}
 
-	n = tsmsg->m_nentries;
-	len = offsetof(PgStat_MsgTabstat, m_entry[0]) +
-		n * sizeof(PgStat_TableEntry);
-
 	pgstat_setheader(&tsmsg->m_hdr, PGSTAT_MTYPE_TABSTAT);
-	pgstat_send(tsmsg, len);
+	pgstat_send(tsmsg, sizeof(PgStat_MsgTabstat));
 }
 
 /*
- * Subroutine for pgstat_report_stat: populate and send a function stat message
+ * Subroutine for pgstat_report_stat: add the function counts to the
+ * shared-memory statistics
  */
 static void
-pgstat_send_funcstats(void)
+pgstat_flush_funcstats(void)
 {
 	/* we assume this inits to all zeroes: */
 	static const PgStat_FunctionCounts all_zeroes;
 
-	PgStat_MsgFuncstat msg;
 	PgStat_BackendFunctionEntry *entry;
 	HASH_SEQ_STATUS fstat;
 
 	if (pgStatFunctions == NULL)
 		return;
 
-	pgstat_setheader(&msg.m_hdr, PGSTAT_MTYPE_FUNCSTAT);
-	msg.m_databaseid = MyDatabaseId;
-	msg.m_nentries = 0;
-
 	hash_seq_init(&fstat, pgStatFunctions);
 	while ((entry = (PgStat_BackendFunctionEntry *) hash_seq_search(&fstat)) != NULL)
 	{
-		PgStat_FunctionEntry *m_ent;
+		PgStat_ObjectKey key;
+		PgStat_SharedFuncEntry *shent;
+		bool		found;
 
 		/* Skip it if no counts accumulated since last time */
 		if (memcmp(&entry->f_counts, &all_zeroes,
 				   sizeof(PgStat_FunctionCounts)) == 0)
 			continue;
 
-		/* need to convert format of time accumulators */
-		m_ent = &msg.m_entry[msg.m_nentries];
-		m_ent->f_id = entry->f_id;
-		m_ent->f_numcalls = entry->f_counts.f_numcalls;
-		m_ent->f_total_time = INSTR_TIME_GET_MICROSEC(entry->f_counts.f_total_time);
-		m_ent->f_self_time = INSTR_TIME_GET_MICROSEC(entry->f_counts.f_self_time);
-
-		if (++msg.m_nentries >= PGSTAT_NUM_FUNCENTRIES)
+		if (pgStatSock != PGINVALID_SOCKET)
 		{
-			pgstat_send(&msg, offsetof(PgStat_MsgFuncstat, m_entry[0]) +
-						msg.m_nentries * sizeof(PgStat_FunctionEntry));
-			msg.m_nentries = 0;
+			pgstat_attach_shared_stats();
+
+			key.databaseid = MyDatabaseId;
+			key.objectid = entry->f_id;
+			shent = (PgStat_SharedFuncEntry *)
+				dshash_find_or_insert(pgStatSharedFunctions, &key, &found);
+			if (!found)
+			{
+				shent->stats.functionid = entry->f_id;
+				shent->stats.f_numcalls = 0;
+				shent->stats.f_total_time = 0;
+				shent->stats.f_self_time = 0;
+			}
+
+			/* need to convert format of time accumulators */
+			shent->stats.f_numcalls += entry->f_counts.f_numcalls;
+			shent->stats.f_total_time +=
+				INSTR_TIME_GET_MICROSEC(entry->f_counts.f_total_time);
+			shent->stats.f_self_time +=
+				INSTR_TIME_GET_MICROSEC(entry->f_counts.f_self_time);
+
+			dshash_release_lock(pgStatSharedFunctions, shent);
 		}
 
 		/* reset the entry's counts */
 		MemSet(&entry->f_counts, 0, sizeof(PgStat_FunctionCounts));
 	}
 
-	if (msg.m_nentries > 0)
-		pgstat_send(&msg, offsetof(PgStat_MsgFuncstat, m_entry[0]) +
-					msg.m_nentries * sizeof(PgStat_FunctionEntry));
-
 	have_function_stats = false;
 }
 
@@ -1015,20 +1189,17 @@ pgstat_send_funcstats(void)
 /* ----------
  * pgstat_vacuum_stat() -
  *
- *	Will tell the collector about objects he can get rid of.
+ *	Get rid of the statistics of dropped objects: tell the collector about
+ *	dead databases, and remove the shared-memory entries of dead tables and
+ *	functions of our database.
  * ----------
  */
 void
 pgstat_vacuum_stat(void)
 {
 	HTAB	   *htab;
-	PgStat_MsgTabpurge msg;
-	PgStat_MsgFuncpurge f_msg;
 	HASH_SEQ_STATUS hstat;
 	PgStat_StatDBEntry *dbentry;
-	PgStat_StatTabEntry *tabentry;
-	PgStat_StatFuncEntry *funcentry;
-	int			len;
 
 	if (pgStatSock == PGINVALID_SOCKET)
 		return;
@@ -1045,8 +1216,7 @@ pgstat_vacuum_stat(void)
 	htab = pgstat_collect_oids(DatabaseRelationId, Anum_pg_database_oid);
 
 	/*
-	 * Search the database hash table for dead databases and tell the
-	 * collector to drop them.
+	 * Search the database hash table for dead databases and drop them.
 	 */
 	hash_seq_init(&hstat, pgStatDBHash);
 	while ((dbentry = (PgStat_StatDBEntry *) hash_seq_search(&hstat)) != NULL)
@@ -1065,129 +1235,81 @@ pgstat_vacuum_stat(void)
 	hash_destroy(htab);
 
 	/*
-	 * Lookup our own database entry; if not found, nothing more to do.
+	 * Similarly to above, make a list of all known relations in this DB, and
+	 * remove the entries of the tables that are not there anymore.
 	 */
-	dbentry = (PgStat_StatDBEntry *) hash_search(pgStatDBHash,
-												 (void *) &MyDatabaseId,
-												 HASH_FIND, NULL);
-	if (dbentry == NULL || dbentry->tables == NULL)
-		return;
+	pgstat_attach_shared_stats();
 
-	/*
-	 * Similarly to above, make a list of all known relations in this DB.
-	 */
 	htab = pgstat_collect_oids(RelationRelationId, Anum_pg_class_oid);
+	pgstat_remove_shared_entries(pgStatSharedTables, MyDatabaseId, htab);
+	hash_destroy(htab);
 
 	/*
-	 * Initialize our messages table counter to zero
-	 */
-	msg.m_nentries = 0;
-
-	/*
-	 * Check for all tables listed in stats hashtable if they still exist.
+	 * Now repeat the above steps for functions.  However, we needn't bother
+	 * in the common case where no function stats are being collected.
 	 */
-	hash_seq_init(&hstat, dbentry->tables);
-	while ((tabentry = (PgStat_StatTabEntry *) hash_seq_search(&hstat)) != NULL)
-	{
-		Oid			tabid = tabentry->tableid;
-
-		CHECK_FOR_INTERRUPTS();
-
-		if (hash_search(htab, (void *) &tabid, HASH_FIND, NULL) != NULL)
-			continue;
-
-		/*
-		 * Not there, so add this table's Oid to the message
-		 */
-		msg.m_tableid[msg.m_nentries++] = tabid;
-
-		/*
-		 * If the message is full, send it out and reinitialize to empty
-		 */
-		if (msg.m_nentries >= PGSTAT_NUM_TABPURGE)
-		{
-			len = offsetof(PgStat_MsgTabpurge, m_tableid[0])
-				+ msg.m_nentries * sizeof(Oid);
+	if (!pgstat_shared_entries_exist(pgStatSharedFunctions, MyDatabaseId))
+		return;
 
-			pgstat_setheader(&msg.m_hdr, PGSTAT_MTYPE_TABPURGE);
-			msg.m_databaseid = MyDatabaseId;
-			pgstat_send(&msg, len);
+	htab = pgstat_collect_oids(ProcedureRelationId, Anum_pg_proc_oid);
+	pgstat_remove_shared_entries(pgStatSharedFunctions, MyDatabaseId, htab);
+	hash_destroy(htab);
+}
 
-			msg.m_nentries = 0;
-		}
-	}
+/*
+ * Remove the shared-memory entries of the given database from a stats hash
+ * table.  If keep_oids is not NULL, the entries of the objects whose OIDs it
+ * lists are kept.
+ */
+static void
+pgstat_remove_shared_entries(dshash_table *hash, Oid databaseid,
+							 HTAB *keep_oids)
+{
+	dshash_seq_status hstat;
+	PgStat_ObjectKey *key;
 
 	/*
-	 * Send the rest
+	 * We hold a partition lock all along, so we must not do anything that
+	 * could throw an error in here.
 	 */
-	if (msg.m_nentries > 0)
+	dshash_seq_init(&hstat, hash, true);
+	while ((key = (PgStat_ObjectKey *) dshash_seq_next(&hstat)) != NULL)
 	{
-		len = offsetof(PgStat_MsgTabpurge, m_tableid[0])
-			+ msg.m_nentries * sizeof(Oid);
+		if (key->databaseid != databaseid)
+			continue;
 
-		pgstat_setheader(&msg.m_hdr, PGSTAT_MTYPE_TABPURGE);
-		msg.m_databaseid = MyDatabaseId;
-		pgstat_send(&msg, len);
+		if (keep_oids != NULL &&
+			hash_search(keep_oids, (void *) &key->objectid,
+						HASH_FIND, NULL) != NULL)
+			continue;
+
+		dshash_delete_current(&hstat);
 	}
+	dshash_seq_term(&hstat);
+}
 
-	/* Clean up */
-	hash_destroy(htab);
+/*
+ * Does a stats hash table have any entries belonging to the given database?
+ */
+static bool
+pgstat_shared_entries_exist(dshash_table *hash, Oid databaseid)
+{
+	dshash_seq_status hstat;
+	PgStat_ObjectKey *key;
+	bool		found = false;
 
-	/*
-	 * Now repeat the above steps for functions.  However, we needn't bother
-	 * in the common case where no function stats are being collected.
-	 */
-	if (dbentry->functions != NULL &&
-		hash_get_num_entries(dbentry->functions) > 0)
+	dshash_seq_init(&hstat, hash, false);
+	while ((key = (PgStat_ObjectKey *) dshash_seq_next(&hstat)) != NULL)
 	{
-		htab = pgstat_collect_oids(ProcedureRelationId, Anum_pg_proc_oid);
-
-		pgstat_setheader(&f_msg.m_hdr, PGSTAT_MTYPE_FUNCPURGE);
-		f_msg.m_databaseid = MyDatabaseId;
-		f_msg.m_nentries = 0;
-
-		hash_seq_init(&hstat, dbentry->functions);
-		while ((funcentry = (PgStat_StatFuncEntry *) hash_seq_search(&hstat)) != NULL)
-		{
-			Oid			funcid = funcentry->functionid;
-
-			CHECK_FOR_INTERRUPTS();
-
-			if (hash_search(htab, (void *) &funcid, HASH_FIND, NULL) != NULL)
-				continue;
-
-			/*
-			 * Not there, so add this function's Oid to the message
-			 */
-			f_msg.m_functionid[f_msg.m_nentries++] = funcid;
-
-			/*
-			 * If the message is full, send it out and reinitialize to empty
-			 */
-			if (f_msg.m_nentries >= PGSTAT_NUM_FUNCPURGE)
-			{
-				len = offsetof(PgStat_MsgFuncpurge, m_functionid[0])
-					+ f_msg.m_nentries * sizeof(Oid);
-
-				pgstat_send(&f_msg, len);
-
-				f_msg.m_nentries = 0;
-			}
-		}
-
-		/*
-		 * Send the rest
-		 */
-		if (f_msg.m_nentries > 0)
+		if (key->databaseid == databaseid)
 		{
-			len = offsetof(PgStat_MsgFuncpurge, m_functionid[0])
-				+ f_msg.m_nentries * sizeof(Oid);
-
-			pgstat_send(&f_msg, len);
+			found = true;
+			break;
 		}
-
-		hash_destroy(htab);
 	}
+	dshash_seq_term(&hstat);
+
+	return found;
 }
 
 
@@ -1245,7 +1367,8 @@ pgstat_collect_oids(Oid catalogid, AttrNumber anum_oid)
 /* ----------
  * pgstat_drop_database() -
  *
- *	Tell the collector that we just dropped a database.
+ *	Remove the table and function stats of a database we just dropped, and
+ *	tell the collector about it.
  *	(If the message gets lost, we will still clean the dead DB eventually
  *	via future invocations of pgstat_vacuum_stat().)
  * ----------
@@ -1258,6 +1381,10 @@ pgstat_drop_database(Oid databaseid)
 	if (pgStatSock == PGINVALID_SOCKET)
 		return;
 
+	pgstat_attach_shared_stats();
+	pgstat_remove_shared_entries(pgStatSharedTables, databaseid, NULL);
+	pgstat_remove_shared_entries(pgStatSharedFunctions, databaseid, NULL);
+
 	pgstat_setheader(&msg.m_hdr, PGSTAT_MTYPE_DROPDB);
 	msg.m_databaseid = databaseid;
 	pgstat_send(&msg, sizeof(msg));
@@ -1267,9 +1394,7 @@ pgstat_drop_database(Oid databaseid)
 /* ----------
  * pgstat_drop_relation() -
  *
- *	Tell the collector that we just dropped a relation.
- *	(If the message gets lost, we will still clean the dead entry eventually
- *	via future invocations of pgstat_vacuum_stat().)
+ *	Remove the stats of a relation we just dropped.
  *
  *	Currently not used for lack of any good place to call it; we rely
  *	entirely on pgstat_vacuum_stat() to clean out stats for dead rels.
@@ -1279,20 +1404,16 @@ pgstat_drop_database(Oid databaseid)
 void
 pgstat_drop_relation(Oid relid)
 {
-	PgStat_MsgTabpurge msg;
-	int			len;
+	PgStat_ObjectKey key;
 
 	if (pgStatSock == PGINVALID_SOCKET)
 		return;
 
-	msg.m_tableid[0] = relid;
-	msg.m_nentries = 1;
-
-	len = offsetof(PgStat_MsgTabpurge, m_tableid[0]) + sizeof(Oid);
+	pgstat_attach_shared_stats();
 
-	pgstat_setheader(&msg.m_hdr, PGSTAT_MTYPE_TABPURGE);
-	msg.m_databaseid = MyDatabaseId;
-	pgstat_send(&msg, len);
+	key.databaseid = MyDatabaseId;
+	key.objectid = relid;
+	(void) dshash_delete_key(pgStatSharedTables, &key);
 }
 #endif							/* NOT_USED */
 
@@ -1300,7 +1421,9 @@ pgstat_drop_relation(Oid relid)
 /* ----------
  * pgstat_reset_counters() -
  *
- *	Tell the statistics collector to reset counters for our database.
+ *	Reset counters for our database: remove the stats of its tables and
+ *	functions, and tell the statistics collector to reset the database-wide
+ *	counters.
  *
  *	Permission checking for this function is managed through the normal
  *	GRANT system.
@@ -1314,6 +1437,10 @@ pgstat_reset_counters(void)
 	if (pgStatSock == PGINVALID_SOCKET)
 		return;
 
+	pgstat_attach_shared_stats();
+	pgstat_remove_shared_entries(pgStatSharedTables, MyDatabaseId, NULL);
+	pgstat_remove_shared_entries(pgStatSharedFunctions, MyDatabaseId, NULL);
+
 	pgstat_setheader(&msg.m_hdr, PGSTAT_MTYPE_RESETCOUNTER);
 	msg.m_databaseid = MyDatabaseId;
 	pgstat_send(&msg, sizeof(msg));
@@ -1353,7 +1480,8 @@ pgstat_reset_shared_counters(const char *target)
 /* ----------
  * pgstat_reset_single_counter() -
  *
- *	Tell the statistics collector to reset a single counter.
+ *	Reset the stats of a single table or function, and tell the statistics
+ *	collector, which keeps the reset timestamp of the database.
  *
  *	Permission checking for this function is managed through the normal
  *	GRANT system.
@@ -1363,10 +1491,21 @@ void
 pgstat_reset_single_counter(Oid objoid, PgStat_Single_Reset_Type type)
 {
 	PgStat_MsgResetsinglecounter msg;
+	PgStat_ObjectKey key;
 
 	if (pgStatSock == PGINVALID_SOCKET)
 		return;
 
+	pgstat_attach_shared_stats();
+
+	/* Remove object if it exists, ignore it if not */
+	key.databaseid = MyDatabaseId;
+	key.objectid = objoid;
+	if (type == RESET_TABLE)
+		(void) dshash_delete_key(pgStatSharedTables, &key);
+	else if (type == RESET_FUNCTION)
+		(void) dshash_delete_key(pgStatSharedFunctions, &key);
+
 	pgstat_setheader(&msg.m_hdr, PGSTAT_MTYPE_RESETSINGLECOUNTER);
 	msg.m_databaseid = MyDatabaseId;
 	msg.m_resettype = type;
@@ -1402,32 +1541,54 @@ pgstat_report_autovac(Oid dboid)
 /* ---------
  * pgstat_report_vacuum() -
  *
- *	Tell the collector about the table we just vacuumed.
+ *	Record the results of the VACUUM of a table.
  * ---------
  */
 void
 pgstat_report_vacuum(Oid tableoid, bool shared,
 					 PgStat_Counter livetuples, PgStat_Counter deadtuples)
 {
-	PgStat_MsgVacuum msg;
+	PgStat_SharedTabEntry *shent;
+	PgStat_StatTabEntry *tabentry;
+	TimestampTz vacuumtime;
 
 	if (pgStatSock == PGINVALID_SOCKET || !pgstat_track_counts)
 		return;
 
-	pgstat_setheader(&msg.m_hdr, PGSTAT_MTYPE_VACUUM);
-	msg.m_databaseid = shared ? InvalidOid : MyDatabaseId;
-	msg.m_tableoid = tableoid;
-	msg.m_autovacuum = IsAutoVacuumWorkerProcess();
-	msg.m_vacuumtime = GetCurrentTimestamp();
-	msg.m_live_tuples = livetuples;
-	msg.m_dead_tuples = deadtuples;
-	pgstat_send(&msg, sizeof(msg));
+	vacuumtime = GetCurrentTimestamp();
+
+	shent = pgstat_get_shared_tabentry(shared ? InvalidOid : MyDatabaseId,
+									   tableoid);
+	tabentry = &shent->stats;
+
+	tabentry->n_live_tuples = livetuples;
+	tabentry->n_dead_tuples = deadtuples;
+
+	/*
+	 * The inserted tuples have now been seen by VACUUM, which set their pages
+	 * all-visible as far as it could.  Like changes_since_analyze for
+	 * ANALYZE, this forgets inserts committed while the VACUUM was running.
+	 */
+	tabentry->inserts_since_vacuum = 0;
+
+	if (IsAutoVacuumWorkerProcess())
+	{
+		tabentry->autovac_vacuum_timestamp = vacuumtime;
+		tabentry->autovac_vacuum_count++;
+	}
+	else
+	{
+		tabentry->vacuum_timestamp = vacuumtime;
+		tabentry->vacuum_count++;
+	}
+
+	dshash_release_lock(pgStatSharedTables, shent);
 }
 
 /* --------
  * pgstat_report_analyze() -
  *
- *	Tell the collector about the table we just analyzed.
+ *	Record the results of the ANALYZE of a table.
  *
  * Caller must provide new live- and dead-tuples estimates, as well as a
  * flag indicating whether to reset the changes_since_analyze counter.
@@ -1438,7 +1599,9 @@ pgstat_report_analyze(Relation rel,
 					  PgStat_Counter livetuples, PgStat_Counter deadtuples,
 					  bool resetcounter)
 {
-	PgStat_MsgAnalyze msg;
+	PgStat_SharedTabEntry *shent;
+	PgStat_StatTabEntry *tabentry;
+	TimestampTz analyzetime;
 
 	if (pgStatSock == PGINVALID_SOCKET || !pgstat_track_counts)
 		return;
@@ -1448,10 +1611,9 @@ pgstat_report_analyze(Relation rel,
 	 * already inserted and/or deleted rows in the target table. ANALYZE will
 	 * have counted such rows as live or dead respectively. Because we will
 	 * report our counts of such rows at transaction end, we should subtract
-	 * off these counts from what we send to the collector now, else they'll
-	 * be double-counted after commit.  (This approach also ensures that the
-	 * collector ends up with the right numbers if we abort instead of
-	 * committing.)
+	 * off these counts from what we store now, else they'll be double-counted
+	 * after commit.  (This approach also ensures that the shared stats end up
+	 * with the right numbers if we abort instead of committing.)
 	 */
 	if (rel->pgstat_info != NULL)
 	{
@@ -1469,15 +1631,36 @@ pgstat_report_analyze(Relation rel,
 		deadtuples = Max(deadtuples, 0);
 	}
 
-	pgstat_setheader(&msg.m_hdr, PGSTAT_MTYPE_ANALYZE);
-	msg.m_databaseid = rel->rd_rel->relisshared ? InvalidOid : MyDatabaseId;
-	msg.m_tableoid = RelationGetRelid(rel);
-	msg.m_autovacuum = IsAutoVacuumWorkerProcess();
-	msg.m_resetcounter = resetcounter;
-	msg.m_analyzetime = GetCurrentTimestamp();
-	msg.m_live_tuples = livetuples;
-	msg.m_dead_tuples = deadtuples;
-	pgstat_send(&msg, sizeof(msg));
+	analyzetime = GetCurrentTimestamp();
+
+	shent = pgstat_get_shared_tabentry(rel->rd_rel->relisshared ?
+									   InvalidOid : MyDatabaseId,
+									   RelationGetRelid(rel));
+	tabentry = &shent->stats;
+
+	tabentry->n_live_tuples = livetuples;
+	tabentry->n_dead_tuples = deadtuples;
+
+	/*
+	 * If commanded, reset changes_since_analyze to zero.  This forgets any
+	 * changes that were committed while the ANALYZE was in progress, but we
+	 * have no good way to estimate how many of those there were.
+	 */
+	if (resetcounter)
+		tabentry->changes_since_analyze = 0;
+
+	if (IsAutoVacuumWorkerProcess())
+	{
+		tabentry->autovac_analyze_timestamp = analyzetime;
+		tabentry->autovac_analyze_count++;
+	}
+	else
+	{
+		tabentry->analyze_timestamp = analyzetime;
+		tabentry->analyze_count++;
+	}
+
+	dshash_release_lock(pgStatSharedTables, shent);
 }
 
 /* --------
@@ -1761,23 +1944,13 @@ get_tabstat_entry(Oid rel_id, bool isshared)
 	 * Create hash table if we don't have it already.
 	 */
 	if (pgStatTabHash == NULL)
-	{
-		HASHCTL		ctl;
-
-		memset(&ctl, 0, sizeof(ctl));
-		ctl.keysize = sizeof(Oid);
-		ctl.entrysize = sizeof(TabStatHashEntry);
-
-		pgStatTabHash = hash_create("pgstat TabStatusArray lookup hash table",
-									TABSTAT_QUANTUM,
-									&ctl,
-									HASH_ELEM | HASH_BLOBS);
-	}
+		pgStatTabHash = tabstathash_create(TopMemoryContext, TABSTAT_QUANTUM,
+										   NULL);
 
 	/*
 	 * Find an entry or create a new one.
 	 */
-	hash_entry = hash_search(pgStatTabHash, &rel_id, HASH_ENTER, &found);
+	hash_entry = tabstathash_insert(pgStatTabHash, rel_id, &found);
 	if (!found)
 	{
 		/* initialize new entry with null pointer */
@@ -1847,7 +2020,7 @@ find_tabstat_entry(Oid rel_id)
 	if (!pgStatTabHash)
 		return NULL;
 
-	hash_entry = hash_search(pgStatTabHash, &rel_id, HASH_FIND, NULL);
+	hash_entry = tabstathash_lookup(pgStatTabHash, rel_id);
 	if (!hash_entry)
 		return NULL;
 
@@ -2417,49 +2590,79 @@ pgstat_fetch_stat_dbentry(Oid dbid)
 PgStat_StatTabEntry *
 pgstat_fetch_stat_tabentry(Oid relid)
 {
-	Oid			dbid;
-	PgStat_StatDBEntry *dbentry;
 	PgStat_StatTabEntry *tabentry;
 
-	/*
-	 * If not done for this transaction, read the statistics collector stats
-	 * file into some hash tables.
-	 */
-	backend_read_statsfile();
+	tabentry = pgstat_fetch_stat_tabentry_ext(false, relid);
+	if (tabentry != NULL)
+		return tabentry;
 
 	/*
-	 * Lookup our database, then look in its table hash table.
+	 * If we didn't find it, maybe it's a shared table.
 	 */
-	dbid = MyDatabaseId;
-	dbentry = (PgStat_StatDBEntry *) hash_search(pgStatDBHash,
-												 (void *) &dbid,
-												 HASH_FIND, NULL);
-	if (dbentry != NULL && dbentry->tables != NULL)
+	return pgstat_fetch_stat_tabentry_ext(true, relid);
+}
+
+
+/* ----------
+ * pgstat_fetch_stat_tabentry_ext() -
+ *
+ *	Like pgstat_fetch_stat_tabentry, but for callers that know whether the
+ *	table is a shared catalog.  The entry is copied from shared memory the
+ *	first time it is asked for in a transaction, and the copy is returned
+ *	until pgstat_clear_snapshot() is called.
+ * ----------
+ */
+PgStat_StatTabEntry *
+pgstat_fetch_stat_tabentry_ext(bool shared, Oid relid)
+{
+	PgStat_ObjectKey key;
+	PgStat_SnapshotTabEntry *snapent;
+	PgStat_SharedTabEntry *shent;
+	PgStat_StatTabEntry tabbuf;
+	bool		valid = false;
+
+	key.databaseid = shared ? InvalidOid : MyDatabaseId;
+	key.objectid = relid;
+
+	if (pgStatTabSnapshot == NULL)
 	{
-		tabentry = (PgStat_StatTabEntry *) hash_search(dbentry->tables,
-													   (void *) &relid,
-													   HASH_FIND, NULL);
-		if (tabentry)
-			return tabentry;
+		HASHCTL		hash_ctl;
+
+		pgstat_setup_memcxt();
+
+		memset(&hash_ctl, 0, sizeof(hash_ctl));
+		hash_ctl.keysize = sizeof(PgStat_ObjectKey);
+		hash_ctl.entrysize = sizeof(PgStat_SnapshotTabEntry);
+		hash_ctl.hcxt = pgStatLocalContext;
+		pgStatTabSnapshot = hash_create("Table stats snapshot",
+										PGSTAT_TAB_HASH_SIZE,
+										&hash_ctl,
+										HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
 	}
 
-	/*
-	 * If we didn't find it, maybe it's a shared table.
-	 */
-	dbid = InvalidOid;
-	dbentry = (PgStat_StatDBEntry *) hash_search(pgStatDBHash,
-												 (void *) &dbid,
-												 HASH_FIND, NULL);
-	if (dbentry != NULL && dbentry->tables != NULL)
+	snapent = (PgStat_SnapshotTabEntry *)
+		hash_search(pgStatTabSnapshot, (void *) &key, HASH_FIND, NULL);
+	if (snapent == NULL)
 	{
-		tabentry = (PgStat_StatTabEntry *) hash_search(dbentry->tables,
-													   (void *) &relid,
-													   HASH_FIND, NULL);
-		if (tabentry)
-			return tabentry;
+		pgstat_attach_shared_stats();
+
+		shent = (PgStat_SharedTabEntry *)
+			dshash_find(pgStatSharedTables, &key, false);
+		if (shent != NULL)
+		{
+			memcpy(&tabbuf, &shent->stats, sizeof(PgStat_StatTabEntry));
+			dshash_release_lock(pgStatSharedTables, shent);
+			valid = true;
+		}
+
+		snapent = (PgStat_SnapshotTabEntry *)
+			hash_search(pgStatTabSnapshot, (void *) &key, HASH_ENTER, NULL);
+		snapent->valid = valid;
+		if (valid)
+			memcpy(&snapent->stats, &tabbuf, sizeof(PgStat_StatTabEntry));
 	}
 
-	return NULL;
+	return snapent->valid ? &snapent->stats : NULL;
 }
 
 
@@ -2473,22 +2676,55 @@ pgstat_fetch_stat_tabentry(Oid relid)
 PgStat_StatFuncEntry *
 pgstat_fetch_stat_funcentry(Oid func_id)
 {
-	PgStat_StatDBEntry *dbentry;
-	PgStat_StatFuncEntry *funcentry = NULL;
+	PgStat_ObjectKey key;
+	PgStat_SnapshotFuncEntry *snapent;
+	PgStat_SharedFuncEntry *shent;
+	PgStat_StatFuncEntry funcbuf;
+	bool		valid = false;
 
-	/* load the stats file if needed */
-	backend_read_statsfile();
+	key.databaseid = MyDatabaseId;
+	key.objectid = func_id;
+
+	if (pgStatFuncSnapshot == NULL)
+	{
+		HASHCTL		hash_ctl;
+
+		pgstat_setup_memcxt();
+
+		memset(&hash_ctl, 0, sizeof(hash_ctl));
+		hash_ctl.keysize = sizeof(PgStat_ObjectKey);
+		hash_ctl.entrysize = sizeof(PgStat_SnapshotFuncEntry);
+		hash_ctl.hcxt = pgStatLocalContext;
+		pgStatFuncSnapshot = hash_create("Function stats snapshot",
+										 PGSTAT_FUNCTION_HASH_SIZE,
+										 &hash_ctl,
+										 HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	}
 
-	/* Lookup our database, then find the requested function.  */
-	dbentry = pgstat_fetch_stat_dbentry(MyDatabaseId);
-	if (dbentry != NULL && dbentry->functions != NULL)
+	/* As for tables, the first lookup in a transaction goes to shmem */
+	snapent = (PgStat_SnapshotFuncEntry *)
+		hash_search(pgStatFuncSnapshot, (void *) &key, HASH_FIND, NULL);
+	if (snapent == NULL)
 	{
-		funcentry = (PgStat_StatFuncEntry *) hash_search(dbentry->functions,
-														 (void *) &func_id,
-														 HASH_FIND, NULL);
+		pgstat_attach_shared_stats();
+
+		shent = (PgStat_SharedFuncEntry *)
+			dshash_find(pgStatSharedFunctions, &key, false);
+		if (shent != NULL)
+		{
+			memcpy(&funcbuf, &shent->stats, sizeof(PgStat_StatFuncEntry));
+			dshash_release_lock(pgStatSharedFunctions, shent);
+			valid = true;
+		}
+
+		snapent = (PgStat_SnapshotFuncEntry *)
+			hash_search(pgStatFuncSnapshot, (void *) &key, HASH_ENTER, NULL);
+		snapent->valid = valid;
+		if (valid)
+			memcpy(&snapent->stats, &funcbuf, sizeof(PgStat_StatFuncEntry));
 	}
 
-	return funcentry;
+	return snapent->valid ? &snapent->stats : NULL;
 }
 
 
@@ -2734,32 +2970,459 @@ CreateSharedBackendStatus(void)
 }
 
 
-/* ----------
- * pgstat_initialize() -
- *
- *	Initialize pgstats state, and set up our on-proc-exit hook.
- *	Called from InitPostgres and AuxiliaryProcessMain. For auxiliary process,
- *	MyBackendId is invalid. Otherwise, MyBackendId must be set,
- *	but we must not have started any transaction yet (since the
- *	exit hook must run after the last transaction exit).
- *	NOTE: MyDatabaseId isn't set yet; so the shutdown hook has to be careful.
- * ----------
+/*
+ * Report shared-memory space needed by CreateSharedIOStats.
+ */
+Size
+IOStatsShmemSize(void)
+{
+	return mul_size(mul_size(IOStatsNumProcs(), IOStatsPerProc),
+					sizeof(PgStat_IOCounters));
+}
+
+/*
+ * Initialize the shared I/O counters during postmaster startup.
  */
 void
-pgstat_initialize(void)
+CreateSharedIOStats(void)
 {
-	/* Initialize MyBEEntry */
-	if (MyBackendId != InvalidBackendId)
-	{
-		Assert(MyBackendId >= 1 && MyBackendId <= MaxBackends);
-		MyBEEntry = &BackendStatusArray[MyBackendId - 1];
-	}
-	else
-	{
-		/* Must be an auxiliary process */
-		Assert(MyAuxProcType != NotAnAuxProcess);
+	bool		found;
 
-		/*
+	pgStatIOArray = (PgStat_IOCounters *)
+		ShmemInitStruct("I/O Stats", IOStatsShmemSize(), &found);
+
+	if (!found)
+		MemSet(pgStatIOArray, 0, IOStatsShmemSize());
+}
+
+/*
+ * pgstat_get_io_stats() -
+ *
+ *	Sum the I/O counters of all processes for one backend type and context.
+ *	No locks are taken, so the result is only approximate while other
+ *	processes are busy.
+ */
+void
+pgstat_get_io_stats(BackendType backendType, IOContext context,
+					PgStat_IOCounters *counters)
+{
+	int			procno;
+
+	MemSet(counters, 0, sizeof(PgStat_IOCounters));
+
+	if (pgStatIOArray == NULL)
+		return;
+
+	for (procno = 0; procno < IOStatsNumProcs(); procno++)
+	{
+		volatile PgStat_IOCounters *entry;
+
+		entry = &pgStatIOArray[procno * IOStatsPerProc +
+							   backendType * IOCONTEXT_NUM_TYPES + context];
+
+		counters->reads += entry->reads;
+		counters->read_time += entry->read_time;
+		counters->hits += entry->hits;
+		counters->writes += entry->writes;
+		counters->write_time += entry->write_time;
+		counters->extends += entry->extends;
+		counters->fsyncs += entry->fsyncs;
+	}
+}
+
+
+/* ------------------------------------------------------------
+ * Functions for management of the shared-memory table and function stats
+ * ------------------------------------------------------------
+ */
+
+/*
+ * Report shared-memory space needed by CreateSharedObjectStats.
+ */
+Size
+ObjectStatsShmemSize(void)
+{
+	Size		size;
+
+	size = MAXALIGN(sizeof(PgStat_ShmemControl));
+	size = add_size(size, PGSTAT_SHMEM_DSA_SIZE);
+
+	return size;
+}
+
+/*
+ * Initialize the DSA area and the hash tables holding the table and function
+ * stats during postmaster startup.
+ */
+void
+CreateSharedObjectStats(void)
+{
+	bool		found;
+
+	pgStatShmem = (PgStat_ShmemControl *)
+		ShmemInitStruct("Object Stats", ObjectStatsShmemSize(), &found);
+
+	if (!found)
+	{
+		dsa_area   *area;
+		dshash_table *tables;
+		dshash_table *functions;
+
+		/*
+		 * We're the first - initialize.  The DSA area is limited to its
+		 * in-place part while the hash tables are created, so that no DSM
+		 * segment gets created by the postmaster.
+		 */
+		Assert(!IsUnderPostmaster);
+
+		area = dsa_create_in_place((char *) pgStatShmem +
+								   MAXALIGN(sizeof(PgStat_ShmemControl)),
+								   PGSTAT_SHMEM_DSA_SIZE,
+								   LWTRANCHE_STATS_DSA, NULL);
+		dsa_pin(area);
+		dsa_set_size_limit(area, PGSTAT_SHMEM_DSA_SIZE);
+
+		tables = dshash_create(area, &pgstat_tab_params, NULL);
+		functions = dshash_create(area, &pgstat_func_params, NULL);
+		pgStatShmem->tables_handle = dshash_get_hash_table_handle(tables);
+		pgStatShmem->functions_handle = dshash_get_hash_table_handle(functions);
+
+		dsa_set_size_limit(area, -1);
+
+		/* The postmaster never looks at the stats again */
+		dshash_detach(tables);
+		dshash_detach(functions);
+		dsa_detach(area);
+	}
+}
+
+/*
+ * Attach to the shared table and function stats, if not done yet.  Must not
+ * be called in the collector, which has no PGPROC to take LWLocks with.
+ */
+static void
+pgstat_attach_shared_stats(void)
+{
+	MemoryContext oldcontext;
+
+	if (pgStatSharedTables != NULL)
+		return;
+
+	Assert(!pgStatRunningInCollector);
+	Assert(pgStatShmem != NULL);
+
+	oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+
+	pgStatArea = dsa_attach_in_place((char *) pgStatShmem +
+									 MAXALIGN(sizeof(PgStat_ShmemControl)),
+									 NULL);
+	dsa_pin_mapping(pgStatArea);
+
+	pgStatSharedTables = dshash_attach(pgStatArea, &pgstat_tab_params,
+									   pgStatShmem->tables_handle, NULL);
+	pgStatSharedFunctions = dshash_attach(pgStatArea, &pgstat_func_params,
+										  pgStatShmem->functions_handle,
+										  NULL);
+
+	MemoryContextSwitchTo(oldcontext);
+}
+
+/*
+ * Find or create the shared entry of a table, returning it exclusively
+ * locked.  The caller must release it with dshash_release_lock.
+ */
+static PgStat_SharedTabEntry *
+pgstat_get_shared_tabentry(Oid databaseid, Oid tableoid)
+{
+	PgStat_ObjectKey key;
+	PgStat_SharedTabEntry *shent;
+	bool		found;
+
+	pgstat_attach_shared_stats();
+
+	key.databaseid = databaseid;
+	key.objectid = tableoid;
+	shent = (PgStat_SharedTabEntry *)
+		dshash_find_or_insert(pgStatSharedTables, &key, &found);
+
+	/* If not found, initialize the new one. */
+	if (!found)
+	{
+		MemSet(&shent->stats, 0, sizeof(PgStat_StatTabEntry));
+		shent->stats.tableid = tableoid;
+	}
+
+	return shent;
+}
+
+/* ----------
+ * pgstat_write_object_stats() -
+ *
+ *	Save the shared-memory table and function stats to the permanent stats
+ *	directory.  This is done by the checkpointer when the server shuts down;
+ *	the file is read back by pgstat_restore_object_stats() at the next
+ *	startup.
+ * ----------
+ */
+void
+pgstat_write_object_stats(void)
+{
+	dshash_seq_status hstat;
+	PgStat_SharedTabEntry *tabent;
+	PgStat_SharedFuncEntry *funcent;
+	FILE	   *fpout;
+	int32		format_id;
+	const char *tmpfile = PGSTAT_STAT_PERMANENT_OBJTMPFILE;
+	const char *statfile = PGSTAT_STAT_PERMANENT_OBJFILE;
+	int			rc;
+
+	elog(DEBUG2, "writing stats file \"%s\"", statfile);
+
+	/*
+	 * Open the statistics temp file to write out the current values.
+	 */
+	fpout = AllocateFile(tmpfile, PG_BINARY_W);
+	if (fpout == NULL)
+	{
+		ereport(LOG,
+				(errcode_for_file_access(),
+				 errmsg("could not open temporary statistics file \"%s\": %m",
+						tmpfile)));
+		return;
+	}
+
+	/*
+	 * Write the file header --- currently just a format ID.
+	 */
+	format_id = PGSTAT_FILE_FORMAT_ID;
+	rc = fwrite(&format_id, sizeof(format_id), 1, fpout);
+	(void) rc;					/* we'll check for error with ferror */
+
+	pgstat_attach_shared_stats();
+
+	/*
+	 * Walk through the table stats, then the function stats.
+	 */
+	dshash_seq_init(&hstat, pgStatSharedTables, false);
+	while ((tabent = (PgStat_SharedTabEntry *) dshash_seq_next(&hstat)) != NULL)
+	{
+		fputc('T', fpout);
+		rc = fwrite(tabent, sizeof(PgStat_SharedTabEntry), 1, fpout);
+		(void) rc;				/* we'll check for error with ferror */
+	}
+	dshash_seq_term(&hstat);
+
+	dshash_seq_init(&hstat, pgStatSharedFunctions, false);
+	while ((funcent = (PgStat_SharedFuncEntry *) dshash_seq_next(&hstat)) != NULL)
+	{
+		fputc('F', fpout);
+		rc = fwrite(funcent, sizeof(PgStat_SharedFuncEntry), 1, fpout);
+		(void) rc;				/* we'll check for error with ferror */
+	}
+	dshash_seq_term(&hstat);
+
+	/*
+	 * No more output to be done. Close the temp file and replace the old
+	 * file with it.  The ferror() check replaces testing for error after each
+	 * individual fputc or fwrite above.
+	 */
+	fputc('E', fpout);
+
+	if (ferror(fpout))
+	{
+		ereport(LOG,
+				(errcode_for_file_access(),
+				 errmsg("could not write temporary statistics file \"%s\": %m",
+						tmpfile)));
+		FreeFile(fpout);
+		unlink(tmpfile);
+	}
+	else if (FreeFile(fpout) < 0)
+	{
+		ereport(LOG,
+				(errcode_for_file_access(),
+				 errmsg("could not close temporary statistics file \"%s\": %m",
+						tmpfile)));
+		unlink(tmpfile);
+	}
+	else if (rename(tmpfile, statfile) < 0)
+	{
+		ereport(LOG,
+				(errcode_for_file_access(),
+				 errmsg("could not rename temporary statistics file \"%s\" to \"%s\": %m",
+						tmpfile, statfile)));
+		unlink(tmpfile);
+	}
+}
+
+/* ----------
+ * pgstat_restore_object_stats() -
+ *
+ *	Load the table and function stats saved at the last shutdown into shared
+ *	memory, and remove the file; the shared-memory data is now authoritative.
+ *	Called by the startup process when no recovery was needed.  In
+ *	single-user mode no stats are collected, so the file is left alone for
+ *	the next normal startup.
+ * ----------
+ */
+void
+pgstat_restore_object_stats(void)
+{
+	PgStat_SharedTabEntry tabbuf;
+	PgStat_SharedFuncEntry funcbuf;
+	FILE	   *fpin;
+	int32		format_id;
+	bool		found;
+	const char *statfile = PGSTAT_STAT_PERMANENT_OBJFILE;
+
+	if (!IsUnderPostmaster)
+		return;
+
+	/*
+	 * Try to open the stats file.  If it doesn't exist, we simply start from
+	 * scratch with empty counters.
+	 */
+	if ((fpin = AllocateFile(statfile, PG_BINARY_R)) == NULL)
+	{
+		if (errno != ENOENT)
+			ereport(LOG,
+					(errcode_for_file_access(),
+					 errmsg("could not open statistics file \"%s\": %m",
+							statfile)));
+		return;
+	}
+
+	/*
+	 * Verify it's of the expected format.
+	 */
+	if (fread(&format_id, 1, sizeof(format_id), fpin) != sizeof(format_id) ||
+		format_id != PGSTAT_FILE_FORMAT_ID)
+	{
+		ereport(LOG,
+				(errmsg("corrupted statistics file \"%s\"", statfile)));
+		goto done;
+	}
+
+	pgstat_attach_shared_stats();
+
+	for (;;)
+	{
+		switch (fgetc(fpin))
+		{
+				/*
+				 * 'T'	A PgStat_SharedTabEntry follows.
+				 */
+			case 'T':
+				{
+					PgStat_SharedTabEntry *tabent;
+
+					if (fread(&tabbuf, 1, sizeof(PgStat_SharedTabEntry),
+							  fpin) != sizeof(PgStat_SharedTabEntry))
+					{
+						ereport(LOG,
+								(errmsg("corrupted statistics file \"%s\"",
+										statfile)));
+						goto done;
+					}
+
+					tabent = (PgStat_SharedTabEntry *)
+						dshash_find_or_insert(pgStatSharedTables,
+											  &tabbuf.key, &found);
+					if (!found)
+						memcpy(tabent, &tabbuf, sizeof(tabbuf));
+					dshash_release_lock(pgStatSharedTables, tabent);
+
+					if (found)
+					{
+						ereport(LOG,
+								(errmsg("corrupted statistics file \"%s\"",
+										statfile)));
+						goto done;
+					}
+					break;
+				}
+
+				/*
+				 * 'F'	A PgStat_SharedFuncEntry follows.
+				 */
+			case 'F':
+				{
+					PgStat_SharedFuncEntry *funcent;
+
+					if (fread(&funcbuf, 1, sizeof(PgStat_SharedFuncEntry),
+							  fpin) != sizeof(PgStat_SharedFuncEntry))
+					{
+						ereport(LOG,
+								(errmsg("corrupted statistics file \"%s\"",
+										statfile)));
+						goto done;
+					}
+
+					funcent = (PgStat_SharedFuncEntry *)
+						dshash_find_or_insert(pgStatSharedFunctions,
+											  &funcbuf.key, &found);
+					if (!found)
+						memcpy(funcent, &funcbuf, sizeof(funcbuf));
+					dshash_release_lock(pgStatSharedFunctions, funcent);
+
+					if (found)
+					{
+						ereport(LOG,
+								(errmsg("corrupted statistics file \"%s\"",
+										statfile)));
+						goto done;
+					}
+					break;
+				}
+
+				/*
+				 * 'E'	The EOF marker of a complete stats file.
+				 */
+			case 'E':
+				goto done;
+
+			default:
+				ereport(LOG,
+						(errmsg("corrupted statistics file \"%s\"",
+								statfile)));
+				goto done;
+		}
+	}
+
+done:
+	FreeFile(fpin);
+
+	elog(DEBUG2, "removing permanent stats file \"%s\"", statfile);
+	unlink(statfile);
+}
+
+
+/* ----------
+ * pgstat_initialize() -
+ *
+ *	Initialize pgstats state, and set up our on-proc-exit hook.
+ *	Called from InitPostgres and AuxiliaryProcessMain. For auxiliary process,
+ *	MyBackendId is invalid. Otherwise, MyBackendId must be set,
+ *	but we must not have started any transaction yet (since the
+ *	exit hook must run after the last transaction exit).
+ *	NOTE: MyDatabaseId isn't set yet; so the shutdown hook has to be careful.
+ * ----------
+ */
+void
+pgstat_initialize(void)
+{
+	/* Initialize MyBEEntry */
+	if (MyBackendId != InvalidBackendId)
+	{
+		Assert(MyBackendId >= 1 && MyBackendId <= MaxBackends);
+		MyBEEntry = &BackendStatusArray[MyBackendId - 1];
+	}
+	else
+	{
+		/* Must be an auxiliary process */
+		Assert(MyAuxProcType != NotAnAuxProcess);
+
+		/*
 		 * Assign the MyBEEntry for an auxiliary process.  Since it doesn't
 		 * have a BackendId, the slot is statically allocated based on the
 		 * auxiliary process type (MyAuxProcType).  Backends use slots indexed
@@ -2770,7 +3433,11 @@ pgstat_initialize(void)
 		MyBEEntry = &BackendStatusArray[MaxBackends + MyAuxProcType];
 	}
 
-	/* Set up a process-exit hook to clean up */
+	/*
+	 * Set up process-exit hooks to clean up.  Remaining counts have to be
+	 * flushed before dynamic shared memory is detached.
+	 */
+	before_shmem_exit(pgstat_shutdown_hook, 0);
 	on_shmem_exit(pgstat_beshutdown_hook, 0);
 }
 
@@ -2873,6 +3540,12 @@ pgstat_bestart(void)
 		}
 	}
 
+	/* From now on, count our I/O under our backend type */
+	if (pgStatIOArray != NULL && MyProc != NULL &&
+		MyProc->pgprocno < IOStatsNumProcs())
+		pgStatMyIO = &pgStatIOArray[MyProc->pgprocno * IOStatsPerProc +
+									beentry->st_backendType * IOCONTEXT_NUM_TYPES];
+
 	do
 	{
 		pgstat_increment_changecount_before(beentry);
@@ -2925,6 +3598,10 @@ pgstat_bestart(void)
 	beentry->st_activity_raw[pgstat_track_activity_query_size - 1] = '\0';
 	beentry->st_progress_command = PROGRESS_COMMAND_INVALID;
 	beentry->st_progress_command_target = InvalidOid;
+	beentry->st_net_bytes_sent = 0;
+	beentry->st_net_bytes_received = 0;
+	beentry->st_net_send_calls = 0;
+	beentry->st_net_recv_calls = 0;
 
 	/*
 	 * we don't zero st_progress_param here to save cycles; nobody should
@@ -2940,27 +3617,32 @@ pgstat_bestart(void)
 }
 
 /*
- * Shut down a single backend's statistics reporting at process exit.
- *
- * Flush any remaining statistics counts out to the collector.
+ * Flush any remaining statistics counts at process exit.
  * Without this, operations triggered during backend exit (such as
  * temp table deletions) won't be counted.
- *
- * Lastly, clear out our entry in the PgBackendStatus array.
  */
 static void
-pgstat_beshutdown_hook(int code, Datum arg)
+pgstat_shutdown_hook(int code, Datum arg)
 {
-	volatile PgBackendStatus *beentry = MyBEEntry;
-
 	/*
 	 * If we got as far as discovering our own database ID, we can report what
-	 * we did to the collector.  Otherwise, we'd be sending an invalid
-	 * database ID, so forget it.  (This means that accesses to pg_database
-	 * during failed backend starts might never get counted.)
+	 * we did.  Otherwise, we'd be using an invalid database ID, so forget it.
+	 * (This means that accesses to pg_database during failed backend starts
+	 * might never get counted.)
 	 */
 	if (OidIsValid(MyDatabaseId))
 		pgstat_report_stat(true);
+}
+
+/*
+ * Shut down a single backend's statistics reporting at process exit.
+ *
+ * Clear out our entry in the PgBackendStatus array.
+ */
+static void
+pgstat_beshutdown_hook(int code, Datum arg)
+{
+	volatile PgBackendStatus *beentry = MyBEEntry;
 
 	/*
 	 * Clear my status entry, following the protocol of bumping st_changecount
@@ -3206,6 +3888,34 @@ pgstat_report_xact_timestamp(TimestampTz tstamp)
 	pgstat_increment_changecount_after(beentry);
 }
 
+/*
+ * Report a send() or recv() call on the client connection, which returned
+ * the given value.  Failed calls are counted too, but of course move no data.
+ */
+void
+pgstat_report_network(bool send, ssize_t nbytes)
+{
+	volatile PgBackendStatus *beentry = MyBEEntry;
+
+	if (!pgstat_track_activities || !beentry)
+		return;
+
+	pgstat_increment_changecount_before(beentry);
+	if (send)
+	{
+		beentry->st_net_send_calls++;
+		if (nbytes > 0)
+			beentry->st_net_bytes_sent += nbytes;
+	}
+	else
+	{
+		beentry->st_net_recv_calls++;
+		if (nbytes > 0)
+			beentry->st_net_bytes_received += nbytes;
+	}
+	pgstat_increment_changecount_after(beentry);
+}
+
 /* ----------
  * pgstat_read_current_status() -
  *
@@ -3592,6 +4302,9 @@ pgstat_get_wait_ipc(WaitEventIPC w)
 		case WAIT_EVENT_EXECUTE_GATHER:
 			event_name = "ExecuteGather";
 			break;
+		case WAIT_EVENT_GIST_ROOT:
+			event_name = "GistRoot";
+			break;
 		case WAIT_EVENT_HASH_BATCH_ALLOCATING:
 			event_name = "Hash/Batch/Allocating";
 			break;
@@ -3637,6 +4350,9 @@ pgstat_get_wait_ipc(WaitEventIPC w)
 		case WAIT_EVENT_HASH_GROW_BUCKETS_REINSERTING:
 			event_name = "Hash/GrowBuckets/Reinserting";
 			break;
+		case WAIT_EVENT_LOGICAL_PARALLEL_APPLY_STATE_CHANGE:
+			event_name = "LogicalParallelApplyStateChange";
+			break;
 		case WAIT_EVENT_LOGICAL_SYNC_DATA:
 			event_name = "LogicalSyncData";
 			break;
@@ -3658,6 +4374,9 @@ pgstat_get_wait_ipc(WaitEventIPC w)
 		case WAIT_EVENT_PARALLEL_BITMAP_SCAN:
 			event_name = "ParallelBitmapScan";
 			break;
+		case WAIT_EVENT_PARALLEL_COPY:
+			event_name = "ParallelCopy";
+			break;
 		case WAIT_EVENT_PARALLEL_CREATE_INDEX_SCAN:
 			event_name = "ParallelCreateIndexScan";
 			break;
@@ -3780,6 +4499,15 @@ pgstat_get_wait_io(WaitEventIO w)
 		case WAIT_EVENT_DATA_FILE_WRITE:
 			event_name = "DataFileWrite";
 			break;
+		case WAIT_EVENT_DOUBLE_WRITE_READ:
+			event_name = "DoubleWriteRead";
+			break;
+		case WAIT_EVENT_DOUBLE_WRITE_SYNC:
+			event_name = "DoubleWriteSync";
+			break;
+		case WAIT_EVENT_DOUBLE_WRITE_WRITE:
+			event_name = "DoubleWriteWrite";
+			break;
 		case WAIT_EVENT_DSM_FILL_ZERO_WRITE:
 			event_name = "DSMFillZeroWrite";
 			break;
@@ -4139,6 +4867,30 @@ pgstat_get_backend_desc(BackendType backendType)
 	return backendDesc;
 }
 
+/* ----------
+ * pgstat_get_io_context_desc() -
+ *
+ *	Return a string representing the I/O context, as shown in pg_stat_io.
+ * ----------
+ */
+const char *
+pgstat_get_io_context_desc(IOContext context)
+{
+	switch (context)
+	{
+		case IOCONTEXT_NORMAL:
+			return "normal";
+		case IOCONTEXT_BULKREAD:
+			return "bulkread";
+		case IOCONTEXT_BULKWRITE:
+			return "bulkwrite";
+		case IOCONTEXT_VACUUM:
+			return "vacuum";
+	}
+
+	return "unknown";
+}
+
 /* ------------------------------------------------------------
  * Local support functions follow
  * ------------------------------------------------------------
@@ -4284,7 +5036,7 @@ PgstatCollectorMain(int argc, char *argv[])
 	 * Read in existing stats files or initialize the stats to zero.
 	 */
 	pgStatRunningInCollector = true;
-	pgStatDBHash = pgstat_read_statsfiles(InvalidOid, true, true);
+	pgStatDBHash = pgstat_read_statsfiles(true);
 
 	/*
 	 * Loop to process messages until we get SIGQUIT or detect ungraceful
@@ -4331,7 +5083,7 @@ PgstatCollectorMain(int argc, char *argv[])
 			 * not satisfied by existing file(s).
 			 */
 			if (pgstat_write_statsfile_needed())
-				pgstat_write_statsfiles(false, false);
+				pgstat_write_statsfiles(false);
 
 			/*
 			 * Try to receive and process a message.  This will not block,
@@ -4389,10 +5141,6 @@ PgstatCollectorMain(int argc, char *argv[])
 					pgstat_recv_tabstat((PgStat_MsgTabstat *) &msg, len);
 					break;
 
-				case PGSTAT_MTYPE_TABPURGE:
-					pgstat_recv_tabpurge((PgStat_MsgTabpurge *) &msg, len);
-					break;
-
 				case PGSTAT_MTYPE_DROPDB:
 					pgstat_recv_dropdb((PgStat_MsgDropdb *) &msg, len);
 					break;
@@ -4418,14 +5166,6 @@ PgstatCollectorMain(int argc, char *argv[])
 					pgstat_recv_autovac((PgStat_MsgAutovacStart *) &msg, len);
 					break;
 
-				case PGSTAT_MTYPE_VACUUM:
-					pgstat_recv_vacuum((PgStat_MsgVacuum *) &msg, len);
-					break;
-
-				case PGSTAT_MTYPE_ANALYZE:
-					pgstat_recv_analyze((PgStat_MsgAnalyze *) &msg, len);
-					break;
-
 				case PGSTAT_MTYPE_ARCHIVER:
 					pgstat_recv_archiver((PgStat_MsgArchiver *) &msg, len);
 					break;
@@ -4434,14 +5174,6 @@ PgstatCollectorMain(int argc, char *argv[])
 					pgstat_recv_bgwriter((PgStat_MsgBgWriter *) &msg, len);
 					break;
 
-				case PGSTAT_MTYPE_FUNCSTAT:
-					pgstat_recv_funcstat((PgStat_MsgFuncstat *) &msg, len);
-					break;
-
-				case PGSTAT_MTYPE_FUNCPURGE:
-					pgstat_recv_funcpurge((PgStat_MsgFuncpurge *) &msg, len);
-					break;
-
 				case PGSTAT_MTYPE_RECOVERYCONFLICT:
 					pgstat_recv_recoveryconflict((PgStat_MsgRecoveryConflict *) &msg, len);
 					break;
@@ -4495,7 +5227,7 @@ PgstatCollectorMain(int argc, char *argv[])
 	/*
 	 * Save the final stats to reuse at next startup.
 	 */
-	pgstat_write_statsfiles(true, true);
+	pgstat_write_statsfiles(true);
 
 	exit(0);
 }
@@ -4527,14 +5259,10 @@ pgstat_sighup_handler(SIGNAL_ARGS)
 
 /*
  * Subroutine to clear stats in a database entry
- *
- * Tables and functions hashes are initialized to empty.
  */
 static void
 reset_dbentry_counters(PgStat_StatDBEntry *dbentry)
 {
-	HASHCTL		hash_ctl;
-
 	dbentry->n_xact_commit = 0;
 	dbentry->n_xact_rollback = 0;
 	dbentry->n_blocks_fetched = 0;
@@ -4552,104 +5280,39 @@ reset_dbentry_counters(PgStat_StatDBEntry *dbentry)
 	dbentry->n_conflict_startup_deadlock = 0;
 	dbentry->n_temp_files = 0;
 	dbentry->n_temp_bytes = 0;
-	dbentry->n_deadlocks = 0;
-	dbentry->n_block_read_time = 0;
-	dbentry->n_block_write_time = 0;
-
-	dbentry->stat_reset_timestamp = GetCurrentTimestamp();
-	dbentry->stats_timestamp = 0;
-
-	memset(&hash_ctl, 0, sizeof(hash_ctl));
-	hash_ctl.keysize = sizeof(Oid);
-	hash_ctl.entrysize = sizeof(PgStat_StatTabEntry);
-	dbentry->tables = hash_create("Per-database table",
-								  PGSTAT_TAB_HASH_SIZE,
-								  &hash_ctl,
-								  HASH_ELEM | HASH_BLOBS);
-
-	hash_ctl.keysize = sizeof(Oid);
-	hash_ctl.entrysize = sizeof(PgStat_StatFuncEntry);
-	dbentry->functions = hash_create("Per-database function",
-									 PGSTAT_FUNCTION_HASH_SIZE,
-									 &hash_ctl,
-									 HASH_ELEM | HASH_BLOBS);
-}
-
-/*
- * Lookup the hash table entry for the specified database. If no hash
- * table entry exists, initialize it, if the create parameter is true.
- * Else, return NULL.
- */
-static PgStat_StatDBEntry *
-pgstat_get_db_entry(Oid databaseid, bool create)
-{
-	PgStat_StatDBEntry *result;
-	bool		found;
-	HASHACTION	action = (create ? HASH_ENTER : HASH_FIND);
-
-	/* Lookup or create the hash table entry for this database */
-	result = (PgStat_StatDBEntry *) hash_search(pgStatDBHash,
-												&databaseid,
-												action, &found);
-
-	if (!create && !found)
-		return NULL;
-
-	/*
-	 * If not found, initialize the new one.  This creates empty hash tables
-	 * for tables and functions, too.
-	 */
-	if (!found)
-		reset_dbentry_counters(result);
+	dbentry->n_deadlocks = 0;
+	dbentry->n_block_read_time = 0;
+	dbentry->n_block_write_time = 0;
+	dbentry->n_parallel_workers_to_launch = 0;
+	dbentry->n_parallel_workers_launched = 0;
 
-	return result;
+	dbentry->stat_reset_timestamp = GetCurrentTimestamp();
+	dbentry->stats_timestamp = 0;
 }
 
-
 /*
- * Lookup the hash table entry for the specified table. If no hash
+ * Lookup the hash table entry for the specified database. If no hash
  * table entry exists, initialize it, if the create parameter is true.
  * Else, return NULL.
  */
-static PgStat_StatTabEntry *
-pgstat_get_tab_entry(PgStat_StatDBEntry *dbentry, Oid tableoid, bool create)
+static PgStat_StatDBEntry *
+pgstat_get_db_entry(Oid databaseid, bool create)
 {
-	PgStat_StatTabEntry *result;
+	PgStat_StatDBEntry *result;
 	bool		found;
 	HASHACTION	action = (create ? HASH_ENTER : HASH_FIND);
 
-	/* Lookup or create the hash table entry for this table */
-	result = (PgStat_StatTabEntry *) hash_search(dbentry->tables,
-												 &tableoid,
-												 action, &found);
+	/* Lookup or create the hash table entry for this database */
+	result = (PgStat_StatDBEntry *) hash_search(pgStatDBHash,
+												&databaseid,
+												action, &found);
 
 	if (!create && !found)
 		return NULL;
 
 	/* If not found, initialize the new one. */
 	if (!found)
-	{
-		result->numscans = 0;
-		result->tuples_returned = 0;
-		result->tuples_fetched = 0;
-		result->tuples_inserted = 0;
-		result->tuples_updated = 0;
-		result->tuples_deleted = 0;
-		result->tuples_hot_updated = 0;
-		result->n_live_tuples = 0;
-		result->n_dead_tuples = 0;
-		result->changes_since_analyze = 0;
-		result->blocks_fetched = 0;
-		result->blocks_hit = 0;
-		result->vacuum_timestamp = 0;
-		result->vacuum_count = 0;
-		result->autovac_vacuum_timestamp = 0;
-		result->autovac_vacuum_count = 0;
-		result->analyze_timestamp = 0;
-		result->analyze_count = 0;
-		result->autovac_analyze_timestamp = 0;
-		result->autovac_analyze_count = 0;
-	}
+		reset_dbentry_counters(result);
 
 	return result;
 }
@@ -4657,20 +5320,16 @@ pgstat_get_tab_entry(PgStat_StatDBEntry *dbentry, Oid tableoid, bool create)
 
 /* ----------
  * pgstat_write_statsfiles() -
- *		Write the global statistics file, as well as requested DB files.
+ *		Write the global statistics file, including the database entries.
  *
  *	'permanent' specifies writing to the permanent files not temporary ones.
  *	When true (happens only when the collector is shutting down), also remove
  *	the temporary files so that backends starting up under a new postmaster
  *	can't read old data before the new collector is ready.
- *
- *	When 'allDbs' is false, only the requested databases (listed in
- *	pending_write_requests) will be written; otherwise, all databases
- *	will be written.
  * ----------
  */
 static void
-pgstat_write_statsfiles(bool permanent, bool allDbs)
+pgstat_write_statsfiles(bool permanent)
 {
 	HASH_SEQ_STATUS hstat;
 	PgStat_StatDBEntry *dbentry;
@@ -4725,24 +5384,14 @@ pgstat_write_statsfiles(bool permanent, bool allDbs)
 	hash_seq_init(&hstat, pgStatDBHash);
 	while ((dbentry = (PgStat_StatDBEntry *) hash_seq_search(&hstat)) != NULL)
 	{
-		/*
-		 * Write out the table and function stats for this DB into the
-		 * appropriate per-DB stat file, if required.
-		 */
-		if (allDbs || pgstat_db_requested(dbentry->databaseid))
-		{
-			/* Make DB's timestamp consistent with the global stats */
-			dbentry->stats_timestamp = globalStats.stats_timestamp;
-
-			pgstat_write_db_statsfile(dbentry, permanent);
-		}
+		/* Make DB's timestamp consistent with the global stats */
+		dbentry->stats_timestamp = globalStats.stats_timestamp;
 
 		/*
-		 * Write out the DB entry. We don't write the tables or functions
-		 * pointers, since they're of no use to any other process.
+		 * Write out the DB entry.
 		 */
 		fputc('D', fpout);
-		rc = fwrite(dbentry, offsetof(PgStat_StatDBEntry, tables), 1, fpout);
+		rc = fwrite(dbentry, sizeof(PgStat_StatDBEntry), 1, fpout);
 		(void) rc;				/* we'll check for error with ferror */
 	}
 
@@ -4790,161 +5439,20 @@ pgstat_write_statsfiles(bool permanent, bool allDbs)
 	pending_write_requests = NIL;
 }
 
-/*
- * return the filename for a DB stat file; filename is the output buffer,
- * of length len.
- */
-static void
-get_dbstat_filename(bool permanent, bool tempname, Oid databaseid,
-					char *filename, int len)
-{
-	int			printed;
-
-	/* NB -- pgstat_reset_remove_files knows about the pattern this uses */
-	printed = snprintf(filename, len, "%s/db_%u.%s",
-					   permanent ? PGSTAT_STAT_PERMANENT_DIRECTORY :
-					   pgstat_stat_directory,
-					   databaseid,
-					   tempname ? "tmp" : "stat");
-	if (printed >= len)
-		elog(ERROR, "overlength pgstat path");
-}
-
-/* ----------
- * pgstat_write_db_statsfile() -
- *		Write the stat file for a single database.
- *
- *	If writing to the permanent file (happens when the collector is
- *	shutting down only), remove the temporary file so that backends
- *	starting up under a new postmaster can't read the old data before
- *	the new collector is ready.
- * ----------
- */
-static void
-pgstat_write_db_statsfile(PgStat_StatDBEntry *dbentry, bool permanent)
-{
-	HASH_SEQ_STATUS tstat;
-	HASH_SEQ_STATUS fstat;
-	PgStat_StatTabEntry *tabentry;
-	PgStat_StatFuncEntry *funcentry;
-	FILE	   *fpout;
-	int32		format_id;
-	Oid			dbid = dbentry->databaseid;
-	int			rc;
-	char		tmpfile[MAXPGPATH];
-	char		statfile[MAXPGPATH];
-
-	get_dbstat_filename(permanent, true, dbid, tmpfile, MAXPGPATH);
-	get_dbstat_filename(permanent, false, dbid, statfile, MAXPGPATH);
-
-	elog(DEBUG2, "writing stats file \"%s\"", statfile);
-
-	/*
-	 * Open the statistics temp file to write out the current values.
-	 */
-	fpout = AllocateFile(tmpfile, PG_BINARY_W);
-	if (fpout == NULL)
-	{
-		ereport(LOG,
-				(errcode_for_file_access(),
-				 errmsg("could not open temporary statistics file \"%s\": %m",
-						tmpfile)));
-		return;
-	}
-
-	/*
-	 * Write the file header --- currently just a format ID.
-	 */
-	format_id = PGSTAT_FILE_FORMAT_ID;
-	rc = fwrite(&format_id, sizeof(format_id), 1, fpout);
-	(void) rc;					/* we'll check for error with ferror */
-
-	/*
-	 * Walk through the database's access stats per table.
-	 */
-	hash_seq_init(&tstat, dbentry->tables);
-	while ((tabentry = (PgStat_StatTabEntry *) hash_seq_search(&tstat)) != NULL)
-	{
-		fputc('T', fpout);
-		rc = fwrite(tabentry, sizeof(PgStat_StatTabEntry), 1, fpout);
-		(void) rc;				/* we'll check for error with ferror */
-	}
-
-	/*
-	 * Walk through the database's function stats table.
-	 */
-	hash_seq_init(&fstat, dbentry->functions);
-	while ((funcentry = (PgStat_StatFuncEntry *) hash_seq_search(&fstat)) != NULL)
-	{
-		fputc('F', fpout);
-		rc = fwrite(funcentry, sizeof(PgStat_StatFuncEntry), 1, fpout);
-		(void) rc;				/* we'll check for error with ferror */
-	}
-
-	/*
-	 * No more output to be done. Close the temp file and replace the old
-	 * pgstat.stat with it.  The ferror() check replaces testing for error
-	 * after each individual fputc or fwrite above.
-	 */
-	fputc('E', fpout);
-
-	if (ferror(fpout))
-	{
-		ereport(LOG,
-				(errcode_for_file_access(),
-				 errmsg("could not write temporary statistics file \"%s\": %m",
-						tmpfile)));
-		FreeFile(fpout);
-		unlink(tmpfile);
-	}
-	else if (FreeFile(fpout) < 0)
-	{
-		ereport(LOG,
-				(errcode_for_file_access(),
-				 errmsg("could not close temporary statistics file \"%s\": %m",
-						tmpfile)));
-		unlink(tmpfile);
-	}
-	else if (rename(tmpfile, statfile) < 0)
-	{
-		ereport(LOG,
-				(errcode_for_file_access(),
-				 errmsg("could not rename temporary statistics file \"%s\" to \"%s\": %m",
-						tmpfile, statfile)));
-		unlink(tmpfile);
-	}
-
-	if (permanent)
-	{
-		get_dbstat_filename(false, false, dbid, statfile, MAXPGPATH);
-
-		elog(DEBUG2, "removing temporary stats file \"%s\"", statfile);
-		unlink(statfile);
-	}
-}
-
 /* ----------
  * pgstat_read_statsfiles() -
  *
- *	Reads in some existing statistics collector files and returns the
- *	databases hash table that is the top level of the data.
- *
- *	If 'onlydb' is not InvalidOid, it means we only want data for that DB
- *	plus the shared catalogs ("DB 0").  We'll still populate the DB hash
- *	table for all databases, but we don't bother even creating table/function
- *	hash tables for other databases.
- *
- *	'permanent' specifies reading from the permanent files not temporary ones.
- *	When true (happens only when the collector is starting up), remove the
- *	files after reading; the in-memory status is now authoritative, and the
- *	files would be out of date in case somebody else reads them.
+ *	Reads in the existing statistics collector file and returns the
+ *	databases hash table.
  *
- *	If a 'deep' read is requested, table/function stats are read, otherwise
- *	the table/function hash tables remain empty.
+ *	'permanent' specifies reading from the permanent file not the temporary
+ *	one.  When true (happens only when the collector is starting up), remove
+ *	the file after reading; the in-memory status is now authoritative, and
+ *	the file would be out of date in case somebody else reads it.
  * ----------
  */
 static HTAB *
-pgstat_read_statsfiles(Oid onlydb, bool permanent, bool deep)
+pgstat_read_statsfiles(bool permanent)
 {
 	PgStat_StatDBEntry *dbentry;
 	PgStat_StatDBEntry dbbuf;
@@ -5017,206 +5525,32 @@ pgstat_read_statsfiles(Oid onlydb, bool permanent, bool deep)
 	/*
 	 * Read global stats struct
 	 */
-	if (fread(&globalStats, 1, sizeof(globalStats), fpin) != sizeof(globalStats))
-	{
-		ereport(pgStatRunningInCollector ? LOG : WARNING,
-				(errmsg("corrupted statistics file \"%s\"", statfile)));
-		memset(&globalStats, 0, sizeof(globalStats));
-		goto done;
-	}
-
-	/*
-	 * In the collector, disregard the timestamp we read from the permanent
-	 * stats file; we should be willing to write a temp stats file immediately
-	 * upon the first request from any backend.  This only matters if the old
-	 * file's timestamp is less than PGSTAT_STAT_INTERVAL ago, but that's not
-	 * an unusual scenario.
-	 */
-	if (pgStatRunningInCollector)
-		globalStats.stats_timestamp = 0;
-
-	/*
-	 * Read archiver stats struct
-	 */
-	if (fread(&archiverStats, 1, sizeof(archiverStats), fpin) != sizeof(archiverStats))
-	{
-		ereport(pgStatRunningInCollector ? LOG : WARNING,
-				(errmsg("corrupted statistics file \"%s\"", statfile)));
-		memset(&archiverStats, 0, sizeof(archiverStats));
-		goto done;
-	}
-
-	/*
-	 * We found an existing collector stats file. Read it and put all the
-	 * hashtable entries into place.
-	 */
-	for (;;)
-	{
-		switch (fgetc(fpin))
-		{
-				/*
-				 * 'D'	A PgStat_StatDBEntry struct describing a database
-				 * follows.
-				 */
-			case 'D':
-				if (fread(&dbbuf, 1, offsetof(PgStat_StatDBEntry, tables),
-						  fpin) != offsetof(PgStat_StatDBEntry, tables))
-				{
-					ereport(pgStatRunningInCollector ? LOG : WARNING,
-							(errmsg("corrupted statistics file \"%s\"",
-									statfile)));
-					goto done;
-				}
-
-				/*
-				 * Add to the DB hash
-				 */
-				dbentry = (PgStat_StatDBEntry *) hash_search(dbhash,
-															 (void *) &dbbuf.databaseid,
-															 HASH_ENTER,
-															 &found);
-				if (found)
-				{
-					ereport(pgStatRunningInCollector ? LOG : WARNING,
-							(errmsg("corrupted statistics file \"%s\"",
-									statfile)));
-					goto done;
-				}
-
-				memcpy(dbentry, &dbbuf, sizeof(PgStat_StatDBEntry));
-				dbentry->tables = NULL;
-				dbentry->functions = NULL;
-
-				/*
-				 * In the collector, disregard the timestamp we read from the
-				 * permanent stats file; we should be willing to write a temp
-				 * stats file immediately upon the first request from any
-				 * backend.
-				 */
-				if (pgStatRunningInCollector)
-					dbentry->stats_timestamp = 0;
-
-				/*
-				 * Don't create tables/functions hashtables for uninteresting
-				 * databases.
-				 */
-				if (onlydb != InvalidOid)
-				{
-					if (dbbuf.databaseid != onlydb &&
-						dbbuf.databaseid != InvalidOid)
-						break;
-				}
-
-				memset(&hash_ctl, 0, sizeof(hash_ctl));
-				hash_ctl.keysize = sizeof(Oid);
-				hash_ctl.entrysize = sizeof(PgStat_StatTabEntry);
-				hash_ctl.hcxt = pgStatLocalContext;
-				dbentry->tables = hash_create("Per-database table",
-											  PGSTAT_TAB_HASH_SIZE,
-											  &hash_ctl,
-											  HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
-
-				hash_ctl.keysize = sizeof(Oid);
-				hash_ctl.entrysize = sizeof(PgStat_StatFuncEntry);
-				hash_ctl.hcxt = pgStatLocalContext;
-				dbentry->functions = hash_create("Per-database function",
-												 PGSTAT_FUNCTION_HASH_SIZE,
-												 &hash_ctl,
-												 HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
-
-				/*
-				 * If requested, read the data from the database-specific
-				 * file.  Otherwise we just leave the hashtables empty.
-				 */
-				if (deep)
-					pgstat_read_db_statsfile(dbentry->databaseid,
-											 dbentry->tables,
-											 dbentry->functions,
-											 permanent);
-
-				break;
-
-			case 'E':
-				goto done;
-
-			default:
-				ereport(pgStatRunningInCollector ? LOG : WARNING,
-						(errmsg("corrupted statistics file \"%s\"",
-								statfile)));
-				goto done;
-		}
-	}
-
-done:
-	FreeFile(fpin);
-
-	/* If requested to read the permanent file, also get rid of it. */
-	if (permanent)
-	{
-		elog(DEBUG2, "removing permanent stats file \"%s\"", statfile);
-		unlink(statfile);
-	}
-
-	return dbhash;
-}
-
-
-/* ----------
- * pgstat_read_db_statsfile() -
- *
- *	Reads in the existing statistics collector file for the given database,
- *	filling the passed-in tables and functions hash tables.
- *
- *	As in pgstat_read_statsfiles, if the permanent file is requested, it is
- *	removed after reading.
- *
- *	Note: this code has the ability to skip storing per-table or per-function
- *	data, if NULL is passed for the corresponding hashtable.  That's not used
- *	at the moment though.
- * ----------
- */
-static void
-pgstat_read_db_statsfile(Oid databaseid, HTAB *tabhash, HTAB *funchash,
-						 bool permanent)
-{
-	PgStat_StatTabEntry *tabentry;
-	PgStat_StatTabEntry tabbuf;
-	PgStat_StatFuncEntry funcbuf;
-	PgStat_StatFuncEntry *funcentry;
-	FILE	   *fpin;
-	int32		format_id;
-	bool		found;
-	char		statfile[MAXPGPATH];
-
-	get_dbstat_filename(permanent, false, databaseid, statfile, MAXPGPATH);
-
-	/*
-	 * Try to open the stats file. If it doesn't exist, the backends simply
-	 * return zero for anything and the collector simply starts from scratch
-	 * with empty counters.
-	 *
-	 * ENOENT is a possibility if the stats collector is not running or has
-	 * not yet written the stats file the first time.  Any other failure
-	 * condition is suspicious.
-	 */
-	if ((fpin = AllocateFile(statfile, PG_BINARY_R)) == NULL)
+	if (fread(&globalStats, 1, sizeof(globalStats), fpin) != sizeof(globalStats))
 	{
-		if (errno != ENOENT)
-			ereport(pgStatRunningInCollector ? LOG : WARNING,
-					(errcode_for_file_access(),
-					 errmsg("could not open statistics file \"%s\": %m",
-							statfile)));
-		return;
+		ereport(pgStatRunningInCollector ? LOG : WARNING,
+				(errmsg("corrupted statistics file \"%s\"", statfile)));
+		memset(&globalStats, 0, sizeof(globalStats));
+		goto done;
 	}
 
 	/*
-	 * Verify it's of the expected format.
+	 * In the collector, disregard the timestamp we read from the permanent
+	 * stats file; we should be willing to write a temp stats file immediately
+	 * upon the first request from any backend.  This only matters if the old
+	 * file's timestamp is less than PGSTAT_STAT_INTERVAL ago, but that's not
+	 * an unusual scenario.
 	 */
-	if (fread(&format_id, 1, sizeof(format_id), fpin) != sizeof(format_id) ||
-		format_id != PGSTAT_FILE_FORMAT_ID)
+	if (pgStatRunningInCollector)
+		globalStats.stats_timestamp = 0;
+
+	/*
+	 * Read archiver stats struct
+	 */
+	if (fread(&archiverStats, 1, sizeof(archiverStats), fpin) != sizeof(archiverStats))
 	{
 		ereport(pgStatRunningInCollector ? LOG : WARNING,
 				(errmsg("corrupted statistics file \"%s\"", statfile)));
+		memset(&archiverStats, 0, sizeof(archiverStats));
 		goto done;
 	}
 
@@ -5229,11 +5563,12 @@ pgstat_read_db_statsfile(Oid databaseid, HTAB *tabhash, HTAB *funchash,
 		switch (fgetc(fpin))
 		{
 				/*
-				 * 'T'	A PgStat_StatTabEntry follows.
+				 * 'D'	A PgStat_StatDBEntry struct describing a database
+				 * follows.
 				 */
-			case 'T':
-				if (fread(&tabbuf, 1, sizeof(PgStat_StatTabEntry),
-						  fpin) != sizeof(PgStat_StatTabEntry))
+			case 'D':
+				if (fread(&dbbuf, 1, sizeof(PgStat_StatDBEntry),
+						  fpin) != sizeof(PgStat_StatDBEntry))
 				{
 					ereport(pgStatRunningInCollector ? LOG : WARNING,
 							(errmsg("corrupted statistics file \"%s\"",
@@ -5242,15 +5577,12 @@ pgstat_read_db_statsfile(Oid databaseid, HTAB *tabhash, HTAB *funchash,
 				}
 
 				/*
-				 * Skip if table data not wanted.
+				 * Add to the DB hash
 				 */
-				if (tabhash == NULL)
-					break;
-
-				tabentry = (PgStat_StatTabEntry *) hash_search(tabhash,
-															   (void *) &tabbuf.tableid,
-															   HASH_ENTER, &found);
-
+				dbentry = (PgStat_StatDBEntry *) hash_search(dbhash,
+															 (void *) &dbbuf.databaseid,
+															 HASH_ENTER,
+															 &found);
 				if (found)
 				{
 					ereport(pgStatRunningInCollector ? LOG : WARNING,
@@ -5259,46 +5591,19 @@ pgstat_read_db_statsfile(Oid databaseid, HTAB *tabhash, HTAB *funchash,
 					goto done;
 				}
 
-				memcpy(tabentry, &tabbuf, sizeof(tabbuf));
-				break;
-
-				/*
-				 * 'F'	A PgStat_StatFuncEntry follows.
-				 */
-			case 'F':
-				if (fread(&funcbuf, 1, sizeof(PgStat_StatFuncEntry),
-						  fpin) != sizeof(PgStat_StatFuncEntry))
-				{
-					ereport(pgStatRunningInCollector ? LOG : WARNING,
-							(errmsg("corrupted statistics file \"%s\"",
-									statfile)));
-					goto done;
-				}
+				memcpy(dbentry, &dbbuf, sizeof(PgStat_StatDBEntry));
 
 				/*
-				 * Skip if function data not wanted.
+				 * In the collector, disregard the timestamp we read from the
+				 * permanent stats file; we should be willing to write a temp
+				 * stats file immediately upon the first request from any
+				 * backend.
 				 */
-				if (funchash == NULL)
-					break;
-
-				funcentry = (PgStat_StatFuncEntry *) hash_search(funchash,
-																 (void *) &funcbuf.functionid,
-																 HASH_ENTER, &found);
-
-				if (found)
-				{
-					ereport(pgStatRunningInCollector ? LOG : WARNING,
-							(errmsg("corrupted statistics file \"%s\"",
-									statfile)));
-					goto done;
-				}
+				if (pgStatRunningInCollector)
+					dbentry->stats_timestamp = 0;
 
-				memcpy(funcentry, &funcbuf, sizeof(funcbuf));
 				break;
 
-				/*
-				 * 'E'	The EOF marker of a complete stats file.
-				 */
 			case 'E':
 				goto done;
 
@@ -5313,21 +5618,23 @@ pgstat_read_db_statsfile(Oid databaseid, HTAB *tabhash, HTAB *funchash,
 done:
 	FreeFile(fpin);
 
+	/* If requested to read the permanent file, also get rid of it. */
 	if (permanent)
 	{
 		elog(DEBUG2, "removing permanent stats file \"%s\"", statfile);
 		unlink(statfile);
 	}
+
+	return dbhash;
 }
 
+
 /* ----------
  * pgstat_read_db_statsfile_timestamp() -
  *
- *	Attempt to determine the timestamp of the last db statfile write.
- *	Returns true if successful; the timestamp is stored in *ts.
- *
- *	This needs to be careful about handling databases for which no stats file
- *	exists, such as databases without a stat entry or those not yet written:
+ *	Attempt to determine the timestamp of the last write of a database's
+ *	entry in the statfile.  Returns true if successful; the timestamp is
+ *	stored in *ts.
  *
  *	- if there's a database entry in the global file, return the corresponding
  *	stats_timestamp value.
@@ -5414,8 +5721,8 @@ pgstat_read_db_statsfile_timestamp(Oid databaseid, bool permanent,
 				 * follows.
 				 */
 			case 'D':
-				if (fread(&dbentry, 1, offsetof(PgStat_StatDBEntry, tables),
-						  fpin) != offsetof(PgStat_StatDBEntry, tables))
+				if (fread(&dbentry, 1, sizeof(PgStat_StatDBEntry),
+						  fpin) != sizeof(PgStat_StatDBEntry))
 				{
 					ereport(pgStatRunningInCollector ? LOG : WARNING,
 							(errmsg("corrupted statistics file \"%s\"",
@@ -5572,15 +5879,7 @@ backend_read_statsfile(void)
 				(errmsg("using stale statistics instead of current ones "
 						"because stats collector is not responding")));
 
-	/*
-	 * Autovacuum launcher wants stats about all databases, but a shallow read
-	 * is sufficient.  Regular backends want a deep read for just the tables
-	 * they can see (MyDatabaseId + shared catalogs).
-	 */
-	if (IsAutoVacuumLauncherProcess())
-		pgStatDBHash = pgstat_read_statsfiles(InvalidOid, false, false);
-	else
-		pgStatDBHash = pgstat_read_statsfiles(MyDatabaseId, false, true);
+	pgStatDBHash = pgstat_read_statsfiles(false);
 }
 
 
@@ -5620,6 +5919,8 @@ pgstat_clear_snapshot(void)
 	/* Reset variables */
 	pgStatLocalContext = NULL;
 	pgStatDBHash = NULL;
+	pgStatTabSnapshot = NULL;
+	pgStatFuncSnapshot = NULL;
 	localBackendStatusTable = NULL;
 	localNumBackends = 0;
 }
@@ -5728,9 +6029,6 @@ static void
 pgstat_recv_tabstat(PgStat_MsgTabstat *msg, int len)
 {
 	PgStat_StatDBEntry *dbentry;
-	PgStat_StatTabEntry *tabentry;
-	int			i;
-	bool		found;
 
 	dbentry = pgstat_get_db_entry(msg->m_databaseid, true);
 
@@ -5741,120 +6039,20 @@ pgstat_recv_tabstat(PgStat_MsgTabstat *msg, int len)
 	dbentry->n_xact_rollback += (PgStat_Counter) (msg->m_xact_rollback);
 	dbentry->n_block_read_time += msg->m_block_read_time;
 	dbentry->n_block_write_time += msg->m_block_write_time;
+	dbentry->n_parallel_workers_to_launch += msg->m_parallel_workers_to_launch;
+	dbentry->n_parallel_workers_launched += msg->m_parallel_workers_launched;
 
 	/*
-	 * Process all table entries in the message.
-	 */
-	for (i = 0; i < msg->m_nentries; i++)
-	{
-		PgStat_TableEntry *tabmsg = &(msg->m_entry[i]);
-
-		tabentry = (PgStat_StatTabEntry *) hash_search(dbentry->tables,
-													   (void *) &(tabmsg->t_id),
-													   HASH_ENTER, &found);
-
-		if (!found)
-		{
-			/*
-			 * If it's a new table entry, initialize counters to the values we
-			 * just got.
-			 */
-			tabentry->numscans = tabmsg->t_counts.t_numscans;
-			tabentry->tuples_returned = tabmsg->t_counts.t_tuples_returned;
-			tabentry->tuples_fetched = tabmsg->t_counts.t_tuples_fetched;
-			tabentry->tuples_inserted = tabmsg->t_counts.t_tuples_inserted;
-			tabentry->tuples_updated = tabmsg->t_counts.t_tuples_updated;
-			tabentry->tuples_deleted = tabmsg->t_counts.t_tuples_deleted;
-			tabentry->tuples_hot_updated = tabmsg->t_counts.t_tuples_hot_updated;
-			tabentry->n_live_tuples = tabmsg->t_counts.t_delta_live_tuples;
-			tabentry->n_dead_tuples = tabmsg->t_counts.t_delta_dead_tuples;
-			tabentry->changes_since_analyze = tabmsg->t_counts.t_changed_tuples;
-			tabentry->blocks_fetched = tabmsg->t_counts.t_blocks_fetched;
-			tabentry->blocks_hit = tabmsg->t_counts.t_blocks_hit;
-
-			tabentry->vacuum_timestamp = 0;
-			tabentry->vacuum_count = 0;
-			tabentry->autovac_vacuum_timestamp = 0;
-			tabentry->autovac_vacuum_count = 0;
-			tabentry->analyze_timestamp = 0;
-			tabentry->analyze_count = 0;
-			tabentry->autovac_analyze_timestamp = 0;
-			tabentry->autovac_analyze_count = 0;
-		}
-		else
-		{
-			/*
-			 * Otherwise add the values to the existing entry.
-			 */
-			tabentry->numscans += tabmsg->t_counts.t_numscans;
-			tabentry->tuples_returned += tabmsg->t_counts.t_tuples_returned;
-			tabentry->tuples_fetched += tabmsg->t_counts.t_tuples_fetched;
-			tabentry->tuples_inserted += tabmsg->t_counts.t_tuples_inserted;
-			tabentry->tuples_updated += tabmsg->t_counts.t_tuples_updated;
-			tabentry->tuples_deleted += tabmsg->t_counts.t_tuples_deleted;
-			tabentry->tuples_hot_updated += tabmsg->t_counts.t_tuples_hot_updated;
-			/* If table was truncated, first reset the live/dead counters */
-			if (tabmsg->t_counts.t_truncated)
-			{
-				tabentry->n_live_tuples = 0;
-				tabentry->n_dead_tuples = 0;
-			}
-			tabentry->n_live_tuples += tabmsg->t_counts.t_delta_live_tuples;
-			tabentry->n_dead_tuples += tabmsg->t_counts.t_delta_dead_tuples;
-			tabentry->changes_since_analyze += tabmsg->t_counts.t_changed_tuples;
-			tabentry->blocks_fetched += tabmsg->t_counts.t_blocks_fetched;
-			tabentry->blocks_hit += tabmsg->t_counts.t_blocks_hit;
-		}
-
-		/* Clamp n_live_tuples in case of negative delta_live_tuples */
-		tabentry->n_live_tuples = Max(tabentry->n_live_tuples, 0);
-		/* Likewise for n_dead_tuples */
-		tabentry->n_dead_tuples = Max(tabentry->n_dead_tuples, 0);
-
-		/*
-		 * Add per-table stats to the per-database entry, too.
-		 */
-		dbentry->n_tuples_returned += tabmsg->t_counts.t_tuples_returned;
-		dbentry->n_tuples_fetched += tabmsg->t_counts.t_tuples_fetched;
-		dbentry->n_tuples_inserted += tabmsg->t_counts.t_tuples_inserted;
-		dbentry->n_tuples_updated += tabmsg->t_counts.t_tuples_updated;
-		dbentry->n_tuples_deleted += tabmsg->t_counts.t_tuples_deleted;
-		dbentry->n_blocks_fetched += tabmsg->t_counts.t_blocks_fetched;
-		dbentry->n_blocks_hit += tabmsg->t_counts.t_blocks_hit;
-	}
-}
-
-
-/* ----------
- * pgstat_recv_tabpurge() -
- *
- *	Arrange for dead table removal.
- * ----------
- */
-static void
-pgstat_recv_tabpurge(PgStat_MsgTabpurge *msg, int len)
-{
-	PgStat_StatDBEntry *dbentry;
-	int			i;
-
-	dbentry = pgstat_get_db_entry(msg->m_databaseid, false);
-
-	/*
-	 * No need to purge if we don't even know the database.
-	 */
-	if (!dbentry || !dbentry->tables)
-		return;
-
-	/*
-	 * Process all table entries in the message.
+	 * The per-table stats have already been added to the shared-memory
+	 * entries; the database entry gets their sums.
 	 */
-	for (i = 0; i < msg->m_nentries; i++)
-	{
-		/* Remove from hashtable if present; we don't care if it's not. */
-		(void) hash_search(dbentry->tables,
-						   (void *) &(msg->m_tableid[i]),
-						   HASH_REMOVE, NULL);
-	}
+	dbentry->n_tuples_returned += msg->m_tuples_returned;
+	dbentry->n_tuples_fetched += msg->m_tuples_fetched;
+	dbentry->n_tuples_inserted += msg->m_tuples_inserted;
+	dbentry->n_tuples_updated += msg->m_tuples_updated;
+	dbentry->n_tuples_deleted += msg->m_tuples_deleted;
+	dbentry->n_blocks_fetched += msg->m_blocks_fetched;
+	dbentry->n_blocks_hit += msg->m_blocks_hit;
 }
 
 
@@ -5876,22 +6074,10 @@ pgstat_recv_dropdb(PgStat_MsgDropdb *msg, int len)
 	dbentry = pgstat_get_db_entry(dbid, false);
 
 	/*
-	 * If found, remove it (along with the db statfile).
+	 * If found, remove it.
 	 */
 	if (dbentry)
 	{
-		char		statfile[MAXPGPATH];
-
-		get_dbstat_filename(false, false, dbid, statfile, MAXPGPATH);
-
-		elog(DEBUG2, "removing stats file \"%s\"", statfile);
-		unlink(statfile);
-
-		if (dbentry->tables != NULL)
-			hash_destroy(dbentry->tables);
-		if (dbentry->functions != NULL)
-			hash_destroy(dbentry->functions);
-
 		if (hash_search(pgStatDBHash,
 						(void *) &dbid,
 						HASH_REMOVE, NULL) == NULL)
@@ -5921,20 +6107,8 @@ pgstat_recv_resetcounter(PgStat_MsgResetcounter *msg, int len)
 		return;
 
 	/*
-	 * We simply throw away all the database's table entries by recreating a
-	 * new hash table for them.
-	 */
-	if (dbentry->tables != NULL)
-		hash_destroy(dbentry->tables);
-	if (dbentry->functions != NULL)
-		hash_destroy(dbentry->functions);
-
-	dbentry->tables = NULL;
-	dbentry->functions = NULL;
-
-	/*
-	 * Reset database-level stats, too.  This creates empty hash tables for
-	 * tables and functions.
+	 * The backend has already thrown away the database's table and function
+	 * entries; reset the database-level stats.
 	 */
 	reset_dbentry_counters(dbentry);
 }
@@ -5970,7 +6144,8 @@ pgstat_recv_resetsharedcounter(PgStat_MsgResetsharedcounter *msg, int len)
 /* ----------
  * pgstat_recv_resetsinglecounter() -
  *
- *	Reset a statistics for a single object
+ *	Note the reset of the statistics for a single object.  The backend has
+ *	already removed the object's entry.
  * ----------
  */
 static void
@@ -5985,14 +6160,6 @@ pgstat_recv_resetsinglecounter(PgStat_MsgResetsinglecounter *msg, int len)
 
 	/* Set the reset timestamp for the whole database */
 	dbentry->stat_reset_timestamp = GetCurrentTimestamp();
-
-	/* Remove object if it exists, ignore it if not */
-	if (msg->m_resettype == RESET_TABLE)
-		(void) hash_search(dbentry->tables, (void *) &(msg->m_objectid),
-						   HASH_REMOVE, NULL);
-	else if (msg->m_resettype == RESET_FUNCTION)
-		(void) hash_search(dbentry->functions, (void *) &(msg->m_objectid),
-						   HASH_REMOVE, NULL);
 }
 
 /* ----------
@@ -6014,83 +6181,6 @@ pgstat_recv_autovac(PgStat_MsgAutovacStart *msg, int len)
 	dbentry->last_autovac_time = msg->m_start_time;
 }
 
-/* ----------
- * pgstat_recv_vacuum() -
- *
- *	Process a VACUUM message.
- * ----------
- */
-static void
-pgstat_recv_vacuum(PgStat_MsgVacuum *msg, int len)
-{
-	PgStat_StatDBEntry *dbentry;
-	PgStat_StatTabEntry *tabentry;
-
-	/*
-	 * Store the data in the table's hashtable entry.
-	 */
-	dbentry = pgstat_get_db_entry(msg->m_databaseid, true);
-
-	tabentry = pgstat_get_tab_entry(dbentry, msg->m_tableoid, true);
-
-	tabentry->n_live_tuples = msg->m_live_tuples;
-	tabentry->n_dead_tuples = msg->m_dead_tuples;
-
-	if (msg->m_autovacuum)
-	{
-		tabentry->autovac_vacuum_timestamp = msg->m_vacuumtime;
-		tabentry->autovac_vacuum_count++;
-	}
-	else
-	{
-		tabentry->vacuum_timestamp = msg->m_vacuumtime;
-		tabentry->vacuum_count++;
-	}
-}
-
-/* ----------
- * pgstat_recv_analyze() -
- *
- *	Process an ANALYZE message.
- * ----------
- */
-static void
-pgstat_recv_analyze(PgStat_MsgAnalyze *msg, int len)
-{
-	PgStat_StatDBEntry *dbentry;
-	PgStat_StatTabEntry *tabentry;
-
-	/*
-	 * Store the data in the table's hashtable entry.
-	 */
-	dbentry = pgstat_get_db_entry(msg->m_databaseid, true);
-
-	tabentry = pgstat_get_tab_entry(dbentry, msg->m_tableoid, true);
-
-	tabentry->n_live_tuples = msg->m_live_tuples;
-	tabentry->n_dead_tuples = msg->m_dead_tuples;
-
-	/*
-	 * If commanded, reset changes_since_analyze to zero.  This forgets any
-	 * changes that were committed while the ANALYZE was in progress, but we
-	 * have no good way to estimate how many of those there were.
-	 */
-	if (msg->m_resetcounter)
-		tabentry->changes_since_analyze = 0;
-
-	if (msg->m_autovacuum)
-	{
-		tabentry->autovac_analyze_timestamp = msg->m_analyzetime;
-		tabentry->autovac_analyze_count++;
-	}
-	else
-	{
-		tabentry->analyze_timestamp = msg->m_analyzetime;
-		tabentry->analyze_count++;
-	}
-}
-
-
 /* ----------
  * pgstat_recv_archiver() -
  *
@@ -6212,86 +6302,6 @@ pgstat_recv_tempfile(PgStat_MsgTempFile *msg, int len)
 	dbentry->n_temp_files += 1;
 }
 
-/* ----------
- * pgstat_recv_funcstat() -
- *
- *	Count what the backend has done.
- * ----------
- */
-static void
-pgstat_recv_funcstat(PgStat_MsgFuncstat *msg, int len)
-{
-	PgStat_FunctionEntry *funcmsg = &(msg->m_entry[0]);
-	PgStat_StatDBEntry *dbentry;
-	PgStat_StatFuncEntry *funcentry;
-	int			i;
-	bool		found;
-
-	dbentry = pgstat_get_db_entry(msg->m_databaseid, true);
-
-	/*
-	 * Process all function entries in the message.
-	 */
-	for (i = 0; i < msg->m_nentries; i++, funcmsg++)
-	{
-		funcentry = (PgStat_StatFuncEntry *) hash_search(dbentry->functions,
-														 (void *) &(funcmsg->f_id),
-														 HASH_ENTER, &found);
-
-		if (!found)
-		{
-			/*
-			 * If it's a new function entry, initialize counters to the values
-			 * we just got.
-			 */
-			funcentry->f_numcalls = funcmsg->f_numcalls;
-			funcentry->f_total_time = funcmsg->f_total_time;
-			funcentry->f_self_time = funcmsg->f_self_time;
-		}
-		else
-		{
-			/*
-			 * Otherwise add the values to the existing entry.
-			 */
-			funcentry->f_numcalls += funcmsg->f_numcalls;
-			funcentry->f_total_time += funcmsg->f_total_time;
-			funcentry->f_self_time += funcmsg->f_self_time;
-		}
-	}
-}
-
-/* ----------
- * pgstat_recv_funcpurge() -
- *
- *	Arrange for dead function removal.
- * ----------
- */
-static void
-pgstat_recv_funcpurge(PgStat_MsgFuncpurge *msg, int len)
-{
-	PgStat_StatDBEntry *dbentry;
-	int			i;
-
-	dbentry = pgstat_get_db_entry(msg->m_databaseid, false);
-
-	/*
-	 * No need to purge if we don't even know the database.
-	 */
-	if (!dbentry || !dbentry->functions)
-		return;
-
-	/*
-	 * Process all function entries in the message.
-	 */
-	for (i = 0; i < msg->m_nentries; i++)
-	{
-		/* Remove from hashtable if present; we don't care if it's not. */
-		(void) hash_search(dbentry->functions,
-						   (void *) &(msg->m_functionid[i]),
-						   HASH_REMOVE, NULL);
-	}
-}
-
 /* ----------
  * pgstat_write_statsfile_needed() -
  *
@@ -6308,31 +6318,6 @@ pgstat_write_statsfile_needed(void)
 	return false;
 }
 
-/* ----------
- * pgstat_db_requested() -
- *
- *	Checks whether stats for a particular DB need to be written to a file.
- * ----------
- */
-static bool
-pgstat_db_requested(Oid databaseid)
-{
-	/*
-	 * If any requests are outstanding at all, we should write the stats for
-	 * shared catalogs (the "database" with OID 0).  This ensures that
-	 * backends will see up-to-date stats for shared catalogs, even though
-	 * they send inquiry messages mentioning only their own DB.
-	 */
-	if (databaseid == InvalidOid && pending_write_requests != NIL)
-		return true;
-
-	/* Search to see if there's an open request to write this database. */
-	if (list_member_oid(pending_write_requests, databaseid))
-		return true;
-
-	return false;
-}
-
 /*
  * Convert a potentially unsafely truncated activity string (see
  * PgBackendStatus.st_activity_raw's documentation) into a correctly truncated
@@ -17,8 +17,10 @@
 #include <time.h>
 
 #include "access/xlog_internal.h"	/* for pg_start/stop_backup */
+#include "catalog/pg_tablespace_d.h"
 #include "catalog/pg_type.h"
 #include "common/file_perm.h"
+#include "common/replcompress.h"
 #include "lib/stringinfo.h"
 #include "libpq/libpq.h"
 #include "libpq/pqformat.h"
@@ -27,6 +29,7 @@
 #include "pgtar.h"
 #include "pgstat.h"
 #include "port.h"
+#include "port/pg_bswap.h"
 #include "postmaster/syslogger.h"
 #include "replication/basebackup.h"
 #include "replication/walsender.h"
@@ -38,9 +41,12 @@
 #include "storage/ipc.h"
 #include "storage/reinit.h"
 #include "utils/builtins.h"
+#include "utils/memutils.h"
+#include "utils/pg_lsn.h"
 #include "utils/ps_status.h"
 #include "utils/relcache.h"
 #include "utils/timestamp.h"
+#include "utils/varlena.h"
 
 
 typedef struct
@@ -52,6 +58,9 @@ typedef struct
 	bool		includewal;
 	uint32		maxrate;
 	bool		sendtblspcmapfile;
+	ReplCompressionMethod compression;
+	XLogRecPtr	incremental_lsn;
+	List	   *incremental_dbs;
 } basebackup_options;
 
 
@@ -73,6 +82,11 @@ static void SendXlogRecPtrResult(XLogRecPtr ptr, TimeLineID tli);
 static int	compareWalFileNames(const void *a, const void *b);
 static void throttle(size_t increment);
 static bool is_checksummed_file(const char *fullpath, const char *filename);
+static int	send_tar_data(const char *data, size_t len);
+static bool is_incremental_file(const char *readfilename,
+					const char *tarfilename, struct stat *statbuf);
+static void sendIncrementalFile(FILE *fp, const char *readfilename,
+					const char *tarfilename, struct stat *statbuf);
 
 /* Was the backup currently in-progress initiated in recovery mode? */
 static bool backup_started_in_recovery = false;
@@ -111,6 +125,23 @@ static int64 total_checksum_failures;
 /* Do not verify checksums. */
 static bool noverify_checksums = false;
 
+/*
+ * Compression of the tar streams requested by the client, and the buffer to
+ * compress in.
+ */
+static ReplCompressionMethod backup_compression = REPL_COMPRESSION_NONE;
+static char *compress_buf = NULL;
+static size_t compress_buf_size = 0;
+
+/*
+ * For an incremental backup, the LSN since which changed blocks are sent,
+ * and the databases, as "tablespace/database" strings, whose relation files
+ * the client can reconstruct.  current_spcoid is the tablespace being sent.
+ */
+static XLogRecPtr incremental_lsn = InvalidXLogRecPtr;
+static List *incremental_dbs = NIL;
+static Oid	current_spcoid = InvalidOid;
+
 /*
  * The contents of these directories are removed or recreated during server
  * start so they are not included in backups.  The directories themselves are
@@ -153,6 +184,9 @@ static const char *excludeDirContents[] =
 	/* Contents zeroed on startup, see StartupSUBTRANS(). */
 	"pg_subtrans",
 
+	/* Contents removed on startup, see DoubleWriteStartup(). */
+	"pg_dblwr",
+
 	/* end of list */
 	NULL
 };
@@ -241,6 +275,9 @@ perform_base_backup(basebackup_options *opt)
 	tblspc_map_file = makeStringInfo();
 
 	total_checksum_failures = 0;
+	backup_compression = opt->compression;
+	incremental_lsn = opt->incremental_lsn;
+	incremental_dbs = opt->incremental_dbs;
 
 	startptr = do_pg_start_backup(opt->label, opt->fastcheckpoint, &starttli,
 								  labelfile, &tablespaces,
@@ -261,6 +298,13 @@ perform_base_backup(basebackup_options *opt)
 
 		SendXlogRecPtrResult(startptr, starttli);
 
+		if (incremental_lsn > startptr)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("incremental backup LSN %X/%X is later than the start of the backup",
+							(uint32) (incremental_lsn >> 32),
+							(uint32) incremental_lsn)));
+
 		/*
 		 * Calculate the relative path of temporary statistics directory in
 		 * order to skip the files which are located in that directory later.
@@ -317,6 +361,8 @@ perform_base_backup(basebackup_options *opt)
 			pq_sendint16(&buf, 0);	/* natts */
 			pq_endmessage(&buf);
 
+			current_spcoid = ti->path ? atooid(ti->oid) : DEFAULTTABLESPACE_OID;
+
 			if (ti->path == NULL)
 			{
 				struct stat statbuf;
@@ -539,7 +585,7 @@ perform_base_backup(basebackup_options *opt)
 			{
 				CheckXLogRemoved(segno, tli);
 				/* Send the chunk as a CopyData message */
-				if (pq_putmessage('d', buf, cnt))
+				if (send_tar_data(buf, cnt))
 					ereport(ERROR,
 							(errmsg("base backup could not send data, aborting backup")));
 
@@ -650,8 +696,12 @@ parse_basebackup_options(List *options, basebackup_options *opt)
 	bool		o_maxrate = false;
 	bool		o_tablespace_map = false;
 	bool		o_noverify_checksums = false;
+	bool		o_compression = false;
+	bool		o_incremental = false;
+	bool		o_incremental_dbs = false;
 
 	MemSet(opt, 0, sizeof(*opt));
+	opt->compression = REPL_COMPRESSION_NONE;
 	foreach(lopt, options)
 	{
 		DefElem    *defel = (DefElem *) lfirst(lopt);
@@ -738,12 +788,63 @@ parse_basebackup_options(List *options, basebackup_options *opt)
 			noverify_checksums = true;
 			o_noverify_checksums = true;
 		}
+		else if (strcmp(defel->defname, "compression") == 0)
+		{
+			char	   *method = strVal(defel->arg);
+
+			if (o_compression)
+				ereport(ERROR,
+						(errcode(ERRCODE_SYNTAX_ERROR),
+						 errmsg("duplicate option \"%s\"", defel->defname)));
+			if (!repl_compression_parse(method, &opt->compression))
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+						 errmsg("unrecognized compression method \"%s\"",
+								method)));
+			if (!repl_compression_supported(opt->compression))
+				ereport(ERROR,
+						(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+						 errmsg("compression method \"%s\" is not supported by this build",
+								method)));
+			o_compression = true;
+		}
+		else if (strcmp(defel->defname, "incremental") == 0)
+		{
+			if (o_incremental)
+				ereport(ERROR,
+						(errcode(ERRCODE_SYNTAX_ERROR),
+						 errmsg("duplicate option \"%s\"", defel->defname)));
+			opt->incremental_lsn =
+				DatumGetLSN(DirectFunctionCall1(pg_lsn_in,
+												CStringGetDatum(strVal(defel->arg))));
+			o_incremental = true;
+		}
+		else if (strcmp(defel->defname, "incremental_databases") == 0)
+		{
+			char	   *rawstring = pstrdup(strVal(defel->arg));
+
+			if (o_incremental_dbs)
+				ereport(ERROR,
+						(errcode(ERRCODE_SYNTAX_ERROR),
+						 errmsg("duplicate option \"%s\"", defel->defname)));
+			if (!SplitIdentifierString(rawstring, ',', &opt->incremental_dbs))
+				ereport(ERROR,
+						(errcode(ERRCODE_SYNTAX_ERROR),
+						 errmsg("invalid list syntax in parameter \"%s\"",
+								defel->defname)));
+			o_incremental_dbs = true;
+		}
 		else
 			elog(ERROR, "option \"%s\" not recognized",
 				 defel->defname);
 	}
 	if (opt->label == NULL)
 		opt->label = "base backup";
+	if (o_incremental_dbs && !o_incremental)
+		ereport(ERROR,
+				(errcode(ERRCODE_SYNTAX_ERROR),
+				 errmsg("option \"%s\" requires option \"%s\"",
+						"incremental_databases", "incremental")));
 }
 
 
@@ -945,7 +1046,7 @@ sendFileWithContent(const char *filename, const char *content)
 
 	_tarWriteHeader(filename, NULL, &statbuf, false);
 	/* Send the contents as a CopyData message */
-	pq_putmessage('d', content, len);
+	send_tar_data(content, len);
 
 	/* Pad to 512 byte boundary, per tar format requirements */
 	pad = ((len + 511) & ~511) - len;
@@ -954,7 +1055,7 @@ sendFileWithContent(const char *filename, const char *content)
 		char		buf[512];
 
 		MemSet(buf, 0, pad);
-		pq_putmessage('d', buf, pad);
+		send_tar_data(buf, pad);
 	}
 }
 
@@ -1391,6 +1492,13 @@ sendFile(const char *readfilename, const char *tarfilename, struct stat *statbuf
 				 errmsg("could not open file \"%s\": %m", readfilename)));
 	}
 
+	if (is_incremental_file(readfilename, tarfilename, statbuf))
+	{
+		sendIncrementalFile(fp, readfilename, tarfilename, statbuf);
+		FreeFile(fp);
+		return true;
+	}
+
 	_tarWriteHeader(tarfilename, NULL, statbuf, false);
 
 	if (!noverify_checksums && DataChecksumsEnabled())
@@ -1531,7 +1639,7 @@ sendFile(const char *readfilename, const char *tarfilename, struct stat *statbuf
 		}
 
 		/* Send the chunk as a CopyData message */
-		if (pq_putmessage('d', buf, cnt))
+		if (send_tar_data(buf, cnt))
 			ereport(ERROR,
 					(errmsg("base backup could not send data, aborting backup")));
 
@@ -1556,7 +1664,7 @@ sendFile(const char *readfilename, const char *tarfilename, struct stat *statbuf
 		while (len < statbuf->st_size)
 		{
 			cnt = Min(sizeof(buf), statbuf->st_size - len);
-			pq_putmessage('d', buf, cnt);
+			send_tar_data(buf, cnt);
 			len += cnt;
 			throttle(cnt);
 		}
@@ -1570,7 +1678,7 @@ sendFile(const char *readfilename, const char *tarfilename, struct stat *statbuf
 	if (pad > 0)
 	{
 		MemSet(buf, 0, pad);
-		pq_putmessage('d', buf, pad);
+		send_tar_data(buf, pad);
 	}
 
 	FreeFile(fp);
@@ -1587,6 +1695,199 @@ sendFile(const char *readfilename, const char *tarfilename, struct stat *statbuf
 }
 
 
+/*
+ * Should this file be sent as an incremental file?
+ *
+ * Only main and init fork segments of relations are: the free space map is
+ * updated without WAL-logging, so its pages don't carry reliable LSNs, and
+ * the visibility map can have bits cleared without its LSN advancing.  Both
+ * are small enough to always send in full.  Relation files in databases the
+ * client doesn't have in the prior backup are sent in full too, as those can
+ * have been copied by CREATE DATABASE with their old LSNs.
+ */
+static bool
+is_incremental_file(const char *readfilename, const char *tarfilename,
+					struct stat *statbuf)
+{
+	const char *filename;
+	char		dbkey[2 * 11 + 2];
+	const char *p;
+	ListCell   *lc;
+
+	if (XLogRecPtrIsInvalid(incremental_lsn))
+		return false;
+
+	filename = last_dir_separator(readfilename) + 1;
+	if (!is_checksummed_file(readfilename, filename) ||
+		!isdigit((unsigned char) filename[0]) ||
+		strstr(filename, "_fsm") != NULL ||
+		strstr(filename, "_vm") != NULL)
+		return false;
+
+	if (statbuf->st_size == 0 || statbuf->st_size % BLCKSZ != 0)
+		return false;
+
+	/* Shared relations are always in the prior backup */
+	if (strncmp(tarfilename, "global/", 7) == 0)
+		return true;
+
+	/*
+	 * Find the database directory: "base/<dboid>/..." in the main tablespace,
+	 * "<version directory>/<dboid>/..." in others.
+	 */
+	p = strchr(tarfilename, '/');
+	if (p == NULL)
+		return false;
+	snprintf(dbkey, sizeof(dbkey), "%u/%u", current_spcoid, atooid(p + 1));
+
+	foreach(lc, incremental_dbs)
+	{
+		if (strcmp((char *) lfirst(lc), dbkey) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Send a relation file as an incremental file, containing only the blocks
+ * that have changed since incremental_lsn, see basebackup.h.
+ *
+ * A block counts as changed if its page LSN is at or past incremental_lsn,
+ * or if it's new.  Pages that are modified concurrently may be read torn,
+ * with a stale LSN; that's OK, since replaying the WAL from the start of this
+ * backup restores them from full page images anyway, just like torn pages in
+ * a full backup.
+ *
+ * The file is read twice, first to find the changed blocks, since the tar
+ * header must give the size of the member up front.  Checksums are not
+ * verified.
+ */
+static void
+sendIncrementalFile(FILE *fp, const char *readfilename,
+					const char *tarfilename, struct stat *statbuf)
+{
+	BlockNumber nblocks = statbuf->st_size / BLCKSZ;
+	BlockNumber *changed;
+	BlockNumber nchanged = 0;
+	BlockNumber blkno = 0;
+	char		buf[TAR_SEND_SIZE];
+	char		incrname[MAXPGPATH];
+	const char *lastsep;
+	struct stat incrstat;
+	StringInfoData hdr;
+	pgoff_t		len;
+	size_t		cnt;
+	size_t		pad;
+	BlockNumber i;
+
+	/* Pass 1: collect the block numbers of the changed blocks */
+	changed = (BlockNumber *) palloc(sizeof(BlockNumber) * nblocks);
+	while (blkno < nblocks)
+	{
+		int			nread;
+		int			j;
+
+		cnt = fread(buf, 1, Min(sizeof(buf), (nblocks - blkno) * BLCKSZ), fp);
+		if (cnt < BLCKSZ)
+		{
+			if (ferror(fp))
+				ereport(ERROR,
+						(errcode_for_file_access(),
+						 errmsg("could not read file \"%s\": %m",
+								readfilename)));
+
+			/*
+			 * Truncated while we're reading it.  Send the rest as zeroes; WAL
+			 * replay will truncate the file again.
+			 */
+			while (blkno < nblocks)
+				changed[nchanged++] = blkno++;
+			break;
+		}
+
+		nread = cnt / BLCKSZ;
+		for (j = 0; j < nread; j++)
+		{
+			Page		page = (Page) (buf + j * BLCKSZ);
+
+			if (PageIsNew(page) || PageGetLSN(page) >= incremental_lsn)
+				changed[nchanged++] = blkno;
+			blkno++;
+		}
+	}
+
+	/* Build the header and the block list */
+	initStringInfo(&hdr);
+	pq_sendint32(&hdr, INCREMENTAL_MAGIC);
+	pq_sendint32(&hdr, nchanged);
+	pq_sendint32(&hdr, nblocks);
+	for (i = 0; i < nchanged; i++)
+		pq_sendint32(&hdr, changed[i]);
+
+	lastsep = last_dir_separator(tarfilename);
+	snprintf(incrname, sizeof(incrname), "%.*s%s%s",
+			 (int) (lastsep + 1 - tarfilename), tarfilename,
+			 INCREMENTAL_PREFIX, lastsep + 1);
+
+	incrstat = *statbuf;
+	incrstat.st_size = hdr.len + (pgoff_t) nchanged * BLCKSZ;
+	_tarWriteHeader(incrname, NULL, &incrstat, false);
+
+	if (send_tar_data(hdr.data, hdr.len))
+		ereport(ERROR,
+				(errmsg("base backup could not send data, aborting backup")));
+	len = hdr.len;
+	pfree(hdr.data);
+
+	/* Pass 2: send the changed blocks, in runs of consecutive blocks */
+	i = 0;
+	while (i < nchanged)
+	{
+		BlockNumber start = changed[i];
+		int			nrun = 1;
+
+		while (i + nrun < nchanged && nrun < TAR_SEND_SIZE / BLCKSZ &&
+			   changed[i + nrun] == start + nrun)
+			nrun++;
+
+		if (fseeko(fp, (pgoff_t) start * BLCKSZ, SEEK_SET) != 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not seek in file \"%s\": %m",
+							readfilename)));
+		cnt = fread(buf, 1, nrun * BLCKSZ, fp);
+		if (cnt < nrun * BLCKSZ)
+		{
+			if (ferror(fp))
+				ereport(ERROR,
+						(errcode_for_file_access(),
+						 errmsg("could not read file \"%s\": %m",
+								readfilename)));
+			/* truncated concurrently, see above */
+			MemSet(buf + cnt, 0, nrun * BLCKSZ - cnt);
+		}
+
+		if (send_tar_data(buf, nrun * BLCKSZ))
+			ereport(ERROR,
+					(errmsg("base backup could not send data, aborting backup")));
+
+		len += nrun * BLCKSZ;
+		throttle(nrun * BLCKSZ);
+		i += nrun;
+	}
+
+	pfree(changed);
+
+	/* Pad to 512 byte boundary, per tar format requirements */
+	pad = ((len + 511) & ~511) - len;
+	if (pad > 0)
+	{
+		MemSet(buf, 0, pad);
+		send_tar_data(buf, pad);
+	}
+}
+
 static int64
 _tarWriteHeader(const char *filename, const char *linktarget,
 				struct stat *statbuf, bool sizeonly)
@@ -1619,7 +1920,7 @@ _tarWriteHeader(const char *filename, const char *linktarget,
 				elog(ERROR, "unrecognized tar error: %d", rc);
 		}
 
-		pq_putmessage('d', h, sizeof(h));
+		send_tar_data(h, sizeof(h));
 	}
 
 	return sizeof(h);
@@ -1717,3 +2018,44 @@ throttle(size_t increment)
 	 */
 	throttled_last = GetCurrentTimestamp();
 }
+
+/*
+ * Send a chunk of a tar stream as a CopyData message.
+ *
+ * If the client asked for compression, the message starts with the length of
+ * the chunk as an Int32, followed by the chunk compressed, or by the chunk as
+ * it is if compressing it doesn't make it smaller.  Either way one message is
+ * sent per chunk, so the client sees the same chunks as without compression.
+ *
+ * Returns the result of pq_putmessage().
+ */
+static int
+send_tar_data(const char *data, size_t len)
+{
+	uint32		rawlen;
+	int32		clen;
+
+	if (backup_compression == REPL_COMPRESSION_NONE)
+		return pq_putmessage('d', data, len);
+
+	if (compress_buf_size < sizeof(uint32) + REPL_COMPRESS_BOUND(len))
+	{
+		if (compress_buf)
+			pfree(compress_buf);
+		compress_buf_size = sizeof(uint32) + REPL_COMPRESS_BOUND(len);
+		compress_buf = MemoryContextAlloc(TopMemoryContext, compress_buf_size);
+	}
+
+	rawlen = pg_hton32((uint32) len);
+	memcpy(compress_buf, &rawlen, sizeof(uint32));
+
+	clen = repl_compress(backup_compression, data, len,
+						 compress_buf + sizeof(uint32));
+	if (clen < 0)
+	{
+		memcpy(compress_buf + sizeof(uint32), data, len);
+		clen = len;
+	}
+
+	return pq_putmessage('d', compress_buf, sizeof(uint32) + clen);
+}
@@ -0,0 +1,1087 @@
+/*-------------------------------------------------------------------------
+ * applyparallelworker.c
+ *	   Apply transactions of a subscription in parallel
+ *
+ * Copyright (c) 2016-2019, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *	  src/backend/replication/logical/applyparallelworker.c
+ *
+ * NOTES
+ *	  With max_parallel_apply_workers_per_subscription > 0, the apply worker
+ *	  of a subscription (the "leader" here) doesn't apply the transactions it
+ *	  receives itself, but passes the protocol messages of each of them on to
+ *	  an idle parallel apply worker, through a shm_mq.  The parallel apply
+ *	  workers apply the messages with the same code as the leader would.
+ *
+ *	  All the workers of a subscription share a single DSM segment, which
+ *	  holds their queues and a ParallelApplyShared struct.  The segment is
+ *	  created when we first hand a transaction over; the workers are
+ *	  launched as needed, up to max_parallel_apply_workers_per_subscription.
+ *
+ *	  Transactions are handed over in the order in which they were committed
+ *	  on the publisher, and a parallel apply worker doesn't commit before the
+ *	  transaction handed over before its own has committed, so that the
+ *	  subscriber goes through the same states as the publisher.  The commit
+ *	  LSN of the last transaction committed is kept in shared memory; the
+ *	  leader uses it to report how far we have got to the publisher.
+ *
+ *	  Transactions that modify the same rows must also apply their changes in
+ *	  the right order.  For that, the leader remembers a hash of the replica
+ *	  identity key of each row modified by a transaction that hasn't
+ *	  committed yet, and before passing on a change to a row that an earlier
+ *	  transaction still in progress has modified, waits for that transaction
+ *	  to commit.  TRUNCATE, and changes we can't identify the rows of, wait
+ *	  for all earlier transactions instead.  The keys are those of the
+ *	  publisher; transactions that conflict only on other unique constraints
+ *	  of the subscriber wait for each other in the lock manager, and a
+ *	  parallel apply worker waits for its predecessor to commit on its
+ *	  transaction ID, so the deadlock detector can see that.
+ *
+ *	  Schema messages (RELATION and TYPE) are applied by the leader, which
+ *	  remembers the latest of each and passes them on to all the parallel
+ *	  apply workers, including those launched later.
+ *
+ *	  Transactions are applied by the leader itself whenever we can't use
+ *	  parallel apply: while the initial synchronization of a table is in
+ *	  progress, or no parallel apply worker could be started.  Streamed
+ *	  transactions are always applied by the leader.  Before that, it waits
+ *	  for all the transactions handed over to commit.
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "miscadmin.h"
+#include "pgstat.h"
+
+#include "access/hash.h"
+#include "access/xact.h"
+
+#include "libpq/pqformat.h"
+#include "libpq/pqsignal.h"
+
+#include "postmaster/bgworker.h"
+
+#include "replication/logicallauncher.h"
+#include "replication/logicalproto.h"
+#include "replication/logicalrelation.h"
+#include "replication/logicalworker.h"
+#include "replication/origin.h"
+#include "replication/worker_internal.h"
+
+#include "storage/dsm.h"
+#include "storage/ipc.h"
+#include "storage/lmgr.h"
+#include "storage/proc.h"
+#include "storage/shm_mq.h"
+#include "storage/shm_toc.h"
+#include "storage/spin.h"
+
+#include "tcop/tcopprot.h"
+
+#include "utils/guc.h"
+#include "utils/hashutils.h"
+#include "utils/hsearch.h"
+#include "utils/memutils.h"
+
+#define PARALLEL_APPLY_MAGIC			0x787ca067
+
+#define PARALLEL_APPLY_KEY_SHARED		1
+#define PARALLEL_APPLY_KEY_QUEUES		2
+
+/* Size of the queue of each parallel apply worker */
+#define PARALLEL_APPLY_QUEUE_SIZE		(4 * 1024 * 1024)
+
+/* Forget about the keys of committed transactions when there are this many */
+#define PARALLEL_APPLY_MAX_KEYS			65536
+
+/* What the leader and each parallel apply worker know about each other */
+typedef struct ParallelApplyWorkerShared
+{
+	PGPROC	   *proc;			/* the worker, once it has started */
+	bool		exited;			/* has it exited? */
+
+	/*
+	 * Commit LSN of the transaction the worker is applying, or
+	 * InvalidXLogRecPtr when it's idle, and the commit LSN of the transaction
+	 * handed over before, which must commit first.  Set by the leader.
+	 */
+	XLogRecPtr	final_lsn;
+	XLogRecPtr	wait_lsn;
+
+	/* local transaction ID of the transaction, once it has one */
+	TransactionId xid;
+} ParallelApplyWorkerShared;
+
+typedef struct ParallelApplyShared
+{
+	slock_t		mutex;			/* protects everything below */
+
+	PGPROC	   *leader_proc;
+	bool		shutdown;		/* has the leader gone away? */
+
+	/*
+	 * The last transaction committed: its commit LSN and the end of its
+	 * commit record on the publisher, and the end of the last commit record
+	 * we have written.
+	 */
+	XLogRecPtr	last_commit_lsn;
+	XLogRecPtr	last_end_lsn;
+	XLogRecPtr	last_local_end;
+
+	int			nworkers;
+	ParallelApplyWorkerShared workers[FLEXIBLE_ARRAY_MEMBER];
+} ParallelApplyShared;
+
+/* Leader's private state for each parallel apply worker */
+typedef struct ParallelApplyWorkerInfo
+{
+	shm_mq_handle *mqh;
+	bool		launched;		/* has it been started? */
+	bool		failed;			/* couldn't start it, don't try again */
+} ParallelApplyWorkerInfo;
+
+/* A row modified by a transaction, see pa_depend_on_key() */
+typedef struct ParallelApplyKey
+{
+	LogicalRepRelId relid;
+	uint32		hash;			/* hash of the replica identity key */
+} ParallelApplyKey;
+
+typedef struct ParallelApplyKeyEntry
+{
+	ParallelApplyKey key;
+	XLogRecPtr	lsn;			/* commit LSN of the last transaction */
+} ParallelApplyKeyEntry;
+
+/* The latest RELATION or TYPE message about an object */
+typedef struct ParallelApplySchemaKey
+{
+	char		action;
+	Oid			id;
+} ParallelApplySchemaKey;
+
+typedef struct ParallelApplySchemaEntry
+{
+	ParallelApplySchemaKey key;
+	char	   *data;
+	int			len;
+} ParallelApplySchemaEntry;
+
+static dsm_segment *pa_seg = NULL;
+static ParallelApplyShared *pa_shared = NULL;
+
+/* Leader state */
+static ParallelApplyWorkerInfo *pa_workers = NULL;
+static int	pa_current = -1;	/* worker the current transaction goes to */
+static XLogRecPtr pa_last_dispatched_lsn = InvalidXLogRecPtr;
+static XLogRecPtr pa_last_collected_lsn = InvalidXLogRecPtr;
+static HTAB *pa_keys = NULL;
+static HTAB *pa_schema = NULL;
+static bool pa_exit_registered = false;
+
+/* Parallel apply worker state */
+static ParallelApplyWorkerShared *pa_me = NULL;
+static volatile sig_atomic_t got_SIGHUP = false;
+
+static void pa_setup(int nworkers);
+static void pa_shutdown(void);
+static void pa_leader_exit(int code, Datum arg);
+static bool pa_launch_worker(int i);
+static int	pa_get_free_worker(void);
+static void pa_check_workers(void);
+static void pa_send(int i, const char *data, int len);
+static void pa_wait_for_commit(XLogRecPtr lsn);
+static void pa_wait_for_all(void);
+static void pa_remember_schema(StringInfo s);
+static void pa_depend_on_change(StringInfo s);
+static bool pa_depend_on_tuple(LogicalRepRelId relid,
+				   LogicalRepTupleData *tuple);
+static void pa_depend_on_key(LogicalRepRelId relid, uint32 hash);
+static void pa_wakeup_all(ParallelApplyShared *shared);
+
+/*
+ * Called by the leader for each message received outside of a streamed
+ * transaction.  Passes the message on to a parallel apply worker if we can,
+ * and returns true if the caller needn't apply it itself.
+ */
+bool
+pa_dispatch(StringInfo s)
+{
+	char		action;
+
+	if (s->cursor >= s->len)
+		return false;
+	action = s->data[s->cursor];
+
+	/*
+	 * Schema messages go to everyone, and the leader applies them too.  The
+	 * publisher sends them only once, so remember them even if parallel apply
+	 * isn't enabled yet.
+	 */
+	if (action == 'R' || action == 'Y')
+	{
+		pa_remember_schema(s);
+		return false;
+	}
+
+	if (pa_current < 0)
+	{
+		StringInfoData copy;
+		LogicalRepBeginData begin_data;
+		ParallelApplyWorkerShared *w;
+		int			i;
+
+		/*
+		 * A streamed transaction committed before the transactions handed
+		 * over so far can't be.
+		 */
+		if (action == 'c')
+		{
+			pa_wait_for_all();
+			return false;
+		}
+
+		if (action != 'B')
+			return false;
+
+		i = pa_get_free_worker();
+		if (i < 0)
+		{
+			pa_wait_for_all();
+			return false;
+		}
+
+		copy = *s;
+		copy.cursor++;
+		logicalrep_read_begin(&copy, &begin_data);
+
+		w = &pa_shared->workers[i];
+		SpinLockAcquire(&pa_shared->mutex);
+		w->final_lsn = begin_data.final_lsn;
+		w->wait_lsn = pa_last_dispatched_lsn;
+		w->xid = InvalidTransactionId;
+		SpinLockRelease(&pa_shared->mutex);
+
+		pa_last_dispatched_lsn = begin_data.final_lsn;
+		pa_current = i;
+		in_remote_transaction = true;
+
+		pa_send(i, s->data + s->cursor, s->len - s->cursor);
+		return true;
+	}
+
+	switch (action)
+	{
+		case 'I':
+		case 'U':
+		case 'D':
+			pa_depend_on_change(s);
+			break;
+
+		case 'T':
+			pa_wait_for_commit(pa_shared->workers[pa_current].wait_lsn);
+			break;
+
+		default:
+			break;
+	}
+
+	pa_send(pa_current, s->data + s->cursor, s->len - s->cursor);
+
+	if (action == 'C')
+	{
+		pa_current = -1;
+		in_remote_transaction = false;
+	}
+
+	return true;
+}
+
+/*
+ * Are there transactions handed over that haven't committed yet?
+ */
+bool
+pa_in_flight(void)
+{
+	XLogRecPtr	committed;
+
+	if (pa_shared == NULL)
+		return false;
+	if (pa_current >= 0)
+		return true;
+
+	SpinLockAcquire(&pa_shared->mutex);
+	committed = pa_shared->last_commit_lsn;
+	SpinLockRelease(&pa_shared->mutex);
+
+	return committed < pa_last_dispatched_lsn;
+}
+
+/*
+ * Tell the flush position tracking of the leader about the transactions the
+ * parallel apply workers have committed since we last looked.
+ */
+void
+pa_collect_commits(void)
+{
+	XLogRecPtr	commit_lsn;
+	XLogRecPtr	end_lsn;
+	XLogRecPtr	local_end;
+
+	if (pa_shared == NULL)
+		return;
+
+	SpinLockAcquire(&pa_shared->mutex);
+	commit_lsn = pa_shared->last_commit_lsn;
+	end_lsn = pa_shared->last_end_lsn;
+	local_end = pa_shared->last_local_end;
+	SpinLockRelease(&pa_shared->mutex);
+
+	if (commit_lsn > pa_last_collected_lsn && !XLogRecPtrIsInvalid(end_lsn))
+	{
+		store_flush_position(end_lsn, local_end);
+		pa_last_collected_lsn = commit_lsn;
+	}
+}
+
+/*
+ * Create the shared memory segment for up to nworkers parallel apply
+ * workers, shutting down the workers using the old one, if any.
+ */
+static void
+pa_setup(int nworkers)
+{
+	shm_toc_estimator e;
+	Size		shared_size;
+	Size		segsize;
+	shm_toc    *toc;
+	ParallelApplyShared *shared;
+	char	   *queues;
+	MemoryContext oldctx;
+	int			i;
+
+	Assert(!pa_in_flight());
+
+	if (pa_shared != NULL)
+		pa_shutdown();
+
+	if (!pa_exit_registered)
+	{
+		before_shmem_exit(pa_leader_exit, (Datum) 0);
+		pa_exit_registered = true;
+	}
+
+	shared_size = add_size(offsetof(ParallelApplyShared, workers),
+						   mul_size(nworkers,
+									sizeof(ParallelApplyWorkerShared)));
+
+	shm_toc_initialize_estimator(&e);
+	shm_toc_estimate_chunk(&e, shared_size);
+	shm_toc_estimate_chunk(&e, mul_size(nworkers, PARALLEL_APPLY_QUEUE_SIZE));
+	shm_toc_estimate_keys(&e, 2);
+	segsize = shm_toc_estimate(&e);
+
+	pa_seg = dsm_create(segsize, 0);
+	toc = shm_toc_create(PARALLEL_APPLY_MAGIC, dsm_segment_address(pa_seg),
+						 segsize);
+
+	shared = shm_toc_allocate(toc, shared_size);
+	SpinLockInit(&shared->mutex);
+	shared->leader_proc = MyProc;
+	shared->shutdown = false;
+	/* everything handed over before has committed */
+	shared->last_commit_lsn = pa_last_dispatched_lsn;
+	shared->last_end_lsn = InvalidXLogRecPtr;
+	shared->last_local_end = InvalidXLogRecPtr;
+	shared->nworkers = nworkers;
+	memset(shared->workers, 0, nworkers * sizeof(ParallelApplyWorkerShared));
+	shm_toc_insert(toc, PARALLEL_APPLY_KEY_SHARED, shared);
+
+	queues = shm_toc_allocate(toc, mul_size(nworkers,
+											PARALLEL_APPLY_QUEUE_SIZE));
+	shm_toc_insert(toc, PARALLEL_APPLY_KEY_QUEUES, queues);
+
+	oldctx = MemoryContextSwitchTo(ApplyContext);
+	pa_workers = palloc0(nworkers * sizeof(ParallelApplyWorkerInfo));
+	for (i = 0; i < nworkers; i++)
+	{
+		shm_mq	   *mq;
+
+		mq = shm_mq_create(queues + i * PARALLEL_APPLY_QUEUE_SIZE,
+						   PARALLEL_APPLY_QUEUE_SIZE);
+		shm_mq_set_sender(mq, MyProc);
+		pa_workers[i].mqh = shm_mq_attach(mq, pa_seg, NULL);
+	}
+	MemoryContextSwitchTo(oldctx);
+
+	/* The segment lives as long as we do, not just the current transaction */
+	dsm_pin_mapping(pa_seg);
+
+	pa_shared = shared;
+}
+
+/*
+ * Let the parallel apply workers go, and forget about the segment.
+ */
+static void
+pa_shutdown(void)
+{
+	SpinLockAcquire(&pa_shared->mutex);
+	pa_shared->shutdown = true;
+	SpinLockRelease(&pa_shared->mutex);
+	pa_wakeup_all(pa_shared);
+
+	/* Detaching from the queues makes idle workers exit. */
+	dsm_detach(pa_seg);
+
+	pfree(pa_workers);
+	pa_workers = NULL;
+	pa_seg = NULL;
+	pa_shared = NULL;
+}
+
+/*
+ * before_shmem_exit callback of the leader: tell the parallel apply workers
+ * that we're gone, so that they don't wait for us.
+ */
+static void
+pa_leader_exit(int code, Datum arg)
+{
+	if (pa_shared == NULL)
+		return;
+
+	SpinLockAcquire(&pa_shared->mutex);
+	pa_shared->shutdown = true;
+	SpinLockRelease(&pa_shared->mutex);
+	pa_wakeup_all(pa_shared);
+}
+
+/*
+ * Start parallel apply worker i.  Returns false if that's not possible.
+ */
+static bool
+pa_launch_worker(int i)
+{
+	HASH_SEQ_STATUS status;
+	ParallelApplySchemaEntry *entry;
+
+	if (!logicalrep_worker_launch(MyLogicalRepWorker->dbid,
+								  MySubscription->oid,
+								  MySubscription->name,
+								  MyLogicalRepWorker->userid,
+								  InvalidOid,
+								  dsm_segment_handle(pa_seg), i))
+	{
+		pa_workers[i].failed = true;
+		return false;
+	}
+
+	pa_workers[i].launched = true;
+
+	/* Tell it about the relations and types we know of. */
+	if (pa_schema != NULL)
+	{
+		hash_seq_init(&status, pa_schema);
+		while ((entry = hash_seq_search(&status)) != NULL)
+			pa_send(i, entry->data, entry->len);
+	}
+
+	return true;
+}
+
+/*
+ * Find an idle parallel apply worker to hand the next transaction over to,
+ * starting one if needed, and waiting for one to finish if they're all busy.
+ *
+ * Returns -1 if the leader should apply the transaction itself.
+ */
+static int
+pa_get_free_worker(void)
+{
+	int			nworkers = max_parallel_apply_workers_per_subscription;
+
+	if (nworkers <= 0 || am_tablesync_worker() || !AllTablesyncsReady())
+		return -1;
+
+	/*
+	 * Grow the segment if the setting has been increased, once all the
+	 * transactions handed over have committed.
+	 */
+	if (pa_shared == NULL || pa_shared->nworkers < nworkers)
+	{
+		if (!pa_in_flight())
+			pa_setup(nworkers);
+		else
+			nworkers = pa_shared->nworkers;
+	}
+
+	for (;;)
+	{
+		int			unused = -1;
+		bool		any_launched = false;
+		int			i;
+
+		pa_check_workers();
+
+		for (i = 0; i < nworkers; i++)
+		{
+			if (pa_workers[i].launched)
+			{
+				bool		idle;
+
+				SpinLockAcquire(&pa_shared->mutex);
+				idle = XLogRecPtrIsInvalid(pa_shared->workers[i].final_lsn);
+				SpinLockRelease(&pa_shared->mutex);
+
+				if (idle)
+					return i;
+				any_launched = true;
+			}
+			else if (!pa_workers[i].failed && unused < 0)
+				unused = i;
+		}
+
+		if (unused >= 0)
+		{
+			if (pa_launch_worker(unused))
+				return unused;
+			continue;
+		}
+
+		if (!any_launched)
+			return -1;
+
+		(void) WaitLatch(MyLatch, WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+						 1000L, WAIT_EVENT_LOGICAL_PARALLEL_APPLY_STATE_CHANGE);
+		ResetLatch(MyLatch);
+		CHECK_FOR_INTERRUPTS();
+	}
+}
+
+/*
+ * Error out if a parallel apply worker has gone away; whatever it was doing
+ * is lost, so we must start over.
+ */
+static void
+pa_check_workers(void)
+{
+	int			i;
+
+	for (i = 0; i < pa_shared->nworkers; i++)
+	{
+		bool		exited;
+
+		if (!pa_workers[i].launched)
+			continue;
+
+		SpinLockAcquire(&pa_shared->mutex);
+		exited = pa_shared->workers[i].exited;
+		SpinLockRelease(&pa_shared->mutex);
+
+		if (exited)
+			ereport(ERROR,
+					(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+					 errmsg("logical replication parallel apply worker exited unexpectedly")));
+	}
+}
+
+/*
+ * Send a message to parallel apply worker i.
+ */
+static void
+pa_send(int i, const char *data, int len)
+{
+	shm_mq_result res;
+
+	res = shm_mq_send(pa_workers[i].mqh, len, data, false);
+	if (res != SHM_MQ_SUCCESS)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("logical replication parallel apply worker exited unexpectedly")));
+}
+
+/*
+ * Wait until the transaction committed at lsn on the publisher, and all the
+ * ones before it, have committed here.
+ */
+static void
+pa_wait_for_commit(XLogRecPtr lsn)
+{
+	for (;;)
+	{
+		XLogRecPtr	committed;
+
+		SpinLockAcquire(&pa_shared->mutex);
+		committed = pa_shared->last_commit_lsn;
+		SpinLockRelease(&pa_shared->mutex);
+
+		if (committed >= lsn)
+			break;
+
+		pa_check_workers();
+
+		(void) WaitLatch(MyLatch, WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+						 1000L, WAIT_EVENT_LOGICAL_PARALLEL_APPLY_STATE_CHANGE);
+		ResetLatch(MyLatch);
+		CHECK_FOR_INTERRUPTS();
+	}
+}
+
+/*
+ * Wait for all the transactions handed over so far to commit.
+ */
+static void
+pa_wait_for_all(void)
+{
+	if (!pa_in_flight())
+		return;
+
+	pa_wait_for_commit(pa_last_dispatched_lsn);
+	pa_collect_commits();
+}
+
+/*
+ * Remember the RELATION or TYPE message in s, and pass it on to all the
+ * parallel apply workers started so far.
+ */
+static void
+pa_remember_schema(StringInfo s)
+{
+	ParallelApplySchemaKey key;
+	ParallelApplySchemaEntry *entry;
+	StringInfoData copy;
+	bool		found;
+	int			i;
+
+	memset(&key, 0, sizeof(key));
+	key.action = s->data[s->cursor];
+
+	/* Both start with the ID of the object, see logicalrep_write_rel(). */
+	copy = *s;
+	copy.cursor++;
+	key.id = pq_getmsgint(&copy, 4);
+
+	if (pa_schema == NULL)
+	{
+		HASHCTL		ctl;
+
+		memset(&ctl, 0, sizeof(ctl));
+		ctl.keysize = sizeof(ParallelApplySchemaKey);
+		ctl.entrysize = sizeof(ParallelApplySchemaEntry);
+		ctl.hcxt = ApplyContext;
+		pa_schema = hash_create("logical replication parallel apply schema",
+								64, &ctl, HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	}
+
+	entry = hash_search(pa_schema, &key, HASH_ENTER, &found);
+	if (found)
+		pfree(entry->data);
+	entry->len = s->len - s->cursor;
+	entry->data = MemoryContextAlloc(ApplyContext, entry->len);
+	memcpy(entry->data, s->data + s->cursor, entry->len);
+
+	if (pa_shared == NULL)
+		return;
+
+	pa_check_workers();
+	for (i = 0; i < pa_shared->nworkers; i++)
+	{
+		if (pa_workers[i].launched)
+			pa_send(i, entry->data, entry->len);
+	}
+}
+
+/*
+ * Before passing on the INSERT, UPDATE or DELETE in s, make sure that the
+ * transactions still in progress that modified the same rows commit first.
+ */
+static void
+pa_depend_on_change(StringInfo s)
+{
+	StringInfoData copy;
+	LogicalRepRelId relid;
+	LogicalRepTupleData oldtup;
+	LogicalRepTupleData newtup;
+	bool		has_oldtup = false;
+	bool		ok;
+
+	copy = *s;
+	switch (pq_getmsgbyte(&copy))
+	{
+		case 'I':
+			relid = logicalrep_read_insert(&copy, &newtup);
+			ok = pa_depend_on_tuple(relid, &newtup);
+			break;
+		case 'U':
+			relid = logicalrep_read_update(&copy, &has_oldtup, &oldtup,
+										   &newtup);
+			ok = pa_depend_on_tuple(relid, &newtup);
+			if (ok && has_oldtup)
+				ok = pa_depend_on_tuple(relid, &oldtup);
+			break;
+		case 'D':
+			relid = logicalrep_read_delete(&copy, &oldtup);
+			ok = pa_depend_on_tuple(relid, &oldtup);
+			break;
+		default:
+			Assert(false);
+			ok = false;
+			break;
+	}
+
+	/* If we can't tell which rows it modifies, wait for everybody. */
+	if (!ok)
+		pa_wait_for_commit(pa_shared->workers[pa_current].wait_lsn);
+}
+
+/*
+ * Compute the hash of the replica identity key of tuple, and wait for the
+ * transactions still in progress that modified it.  Returns false if the
+ * tuple isn't identified by its key.
+ */
+static bool
+pa_depend_on_tuple(LogicalRepRelId relid, LogicalRepTupleData *tuple)
+{
+	LogicalRepRelation *remoterel;
+	uint32		hash = relid;
+	int			i;
+
+	remoterel = logicalrep_rel_get_remote(relid);
+	if (remoterel == NULL || bms_is_empty(remoterel->attkeys))
+		return false;
+
+	i = -1;
+	while ((i = bms_next_member(remoterel->attkeys, i)) >= 0)
+	{
+		char	   *value;
+
+		/* The key of an updated row only comes with the old tuple. */
+		if (!tuple->changed[i])
+			return false;
+
+		value = tuple->values[i];
+		if (value == NULL)
+			hash = hash_combine(hash, 0);
+		else
+			hash = hash_combine(hash,
+								DatumGetUInt32(hash_any((unsigned char *) value,
+														tuple->lengths[i])));
+	}
+
+	pa_depend_on_key(relid, hash);
+	return true;
+}
+
+/*
+ * Wait for the transaction in progress that last modified the row with the
+ * given key hash, if any, and remember that the current transaction does.
+ */
+static void
+pa_depend_on_key(LogicalRepRelId relid, uint32 hash)
+{
+	ParallelApplyKey key;
+	ParallelApplyKeyEntry *entry;
+	XLogRecPtr	final_lsn = pa_last_dispatched_lsn;
+	bool		found;
+
+	if (pa_keys == NULL)
+	{
+		HASHCTL		ctl;
+
+		memset(&ctl, 0, sizeof(ctl));
+		ctl.keysize = sizeof(ParallelApplyKey);
+		ctl.entrysize = sizeof(ParallelApplyKeyEntry);
+		ctl.hcxt = ApplyContext;
+		pa_keys = hash_create("logical replication parallel apply keys",
+							  1024, &ctl, HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	}
+	else if (hash_get_num_entries(pa_keys) >= PARALLEL_APPLY_MAX_KEYS)
+	{
+		HASH_SEQ_STATUS status;
+		XLogRecPtr	committed;
+
+		SpinLockAcquire(&pa_shared->mutex);
+		committed = pa_shared->last_commit_lsn;
+		SpinLockRelease(&pa_shared->mutex);
+
+		/* Forget about the committed transactions. */
+		hash_seq_init(&status, pa_keys);
+		while ((entry = hash_seq_search(&status)) != NULL)
+		{
+			if (entry->lsn <= committed)
+				hash_search(pa_keys, &entry->key, HASH_REMOVE, NULL);
+		}
+	}
+
+	memset(&key, 0, sizeof(key));
+	key.relid = relid;
+	key.hash = hash;
+
+	entry = hash_search(pa_keys, &key, HASH_ENTER, &found);
+	if (found && entry->lsn != final_lsn)
+		pa_wait_for_commit(entry->lsn);
+	entry->lsn = final_lsn;
+}
+
+/*
+ * Wake up the leader and all the parallel apply workers.
+ */
+static void
+pa_wakeup_all(ParallelApplyShared *shared)
+{
+	PGPROC	   *proc;
+	int			i;
+
+	/* Don't set latches while holding the spinlock. */
+	SpinLockAcquire(&shared->mutex);
+	proc = shared->leader_proc;
+	SpinLockRelease(&shared->mutex);
+	if (proc != NULL && proc != MyProc)
+		SetLatch(&proc->procLatch);
+
+	for (i = 0; i < shared->nworkers; i++)
+	{
+		SpinLockAcquire(&shared->mutex);
+		proc = shared->workers[i].exited ? NULL : shared->workers[i].proc;
+		SpinLockRelease(&shared->mutex);
+
+		if (proc != NULL && proc != MyProc)
+			SetLatch(&proc->procLatch);
+	}
+}
+
+/*
+ * Called by a parallel apply worker once it has a local transaction ID, so
+ * that the next one can wait for it in the lock manager.
+ */
+void
+pa_set_xact_id(TransactionId xid)
+{
+	SpinLockAcquire(&pa_shared->mutex);
+	pa_me->xid = xid;
+	SpinLockRelease(&pa_shared->mutex);
+}
+
+/*
+ * Called by a parallel apply worker before committing its transaction: wait
+ * for the transaction handed over before it to commit.
+ */
+void
+pa_wait_for_turn(void)
+{
+	TransactionId waited_xid = InvalidTransactionId;
+
+	for (;;)
+	{
+		XLogRecPtr	committed;
+		XLogRecPtr	wait_lsn;
+		TransactionId xid = InvalidTransactionId;
+		bool		shutdown;
+		int			i;
+
+		SpinLockAcquire(&pa_shared->mutex);
+		committed = pa_shared->last_commit_lsn;
+		wait_lsn = pa_me->wait_lsn;
+		shutdown = pa_shared->shutdown;
+		for (i = 0; i < pa_shared->nworkers; i++)
+		{
+			if (pa_shared->workers[i].final_lsn == wait_lsn)
+				xid = pa_shared->workers[i].xid;
+		}
+		SpinLockRelease(&pa_shared->mutex);
+
+		if (committed >= wait_lsn)
+			break;
+
+		if (shutdown)
+			ereport(ERROR,
+					(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+					 errmsg("lost connection to the logical replication apply worker")));
+
+		/*
+		 * Wait for the transaction of our predecessor where the deadlock
+		 * detector can see us.  It has still to wait for its own predecessor
+		 * though, so we may have to come back.
+		 */
+		if (TransactionIdIsValid(xid) && xid != waited_xid &&
+			IsTransactionState())
+		{
+			XactLockTableWait(xid, NULL, NULL, XLTW_None);
+			waited_xid = xid;
+			continue;
+		}
+
+		(void) WaitLatch(MyLatch, WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+						 1000L, WAIT_EVENT_LOGICAL_PARALLEL_APPLY_STATE_CHANGE);
+		ResetLatch(MyLatch);
+		CHECK_FOR_INTERRUPTS();
+	}
+}
+
+/*
+ * Called by a parallel apply worker once it has committed its transaction,
+ * with the end of the commit record on the publisher and here.
+ */
+void
+pa_commit_done(XLogRecPtr end_lsn, XLogRecPtr local_end)
+{
+	SpinLockAcquire(&pa_shared->mutex);
+	Assert(pa_shared->last_commit_lsn <= pa_me->final_lsn);
+	pa_shared->last_commit_lsn = pa_me->final_lsn;
+	pa_shared->last_end_lsn = end_lsn;
+	if (!XLogRecPtrIsInvalid(local_end))
+		pa_shared->last_local_end = local_end;
+	pa_me->final_lsn = InvalidXLogRecPtr;
+	pa_me->wait_lsn = InvalidXLogRecPtr;
+	pa_me->xid = InvalidTransactionId;
+	SpinLockRelease(&pa_shared->mutex);
+
+	pa_wakeup_all(pa_shared);
+}
+
+/*
+ * before_shmem_exit callback of a parallel apply worker.
+ */
+static void
+pa_worker_exit(int code, Datum arg)
+{
+	SpinLockAcquire(&pa_shared->mutex);
+	pa_me->exited = true;
+	SpinLockRelease(&pa_shared->mutex);
+
+	pa_wakeup_all(pa_shared);
+}
+
+/* SIGHUP: set flag to reload configuration at next convenient time */
+static void
+pa_worker_sighup(SIGNAL_ARGS)
+{
+	int			save_errno = errno;
+
+	got_SIGHUP = true;
+
+	/* Waken anything waiting on the process latch */
+	SetLatch(MyLatch);
+
+	errno = save_errno;
+}
+
+/* Logical Replication parallel apply worker entry point */
+void
+ParallelApplyWorkerMain(Datum main_arg)
+{
+	int			worker_slot = DatumGetInt32(main_arg);
+	dsm_handle	handle;
+	int			index;
+	shm_toc    *toc;
+	char	   *queues;
+	shm_mq	   *mq;
+	shm_mq_handle *mqh;
+	char		originname[NAMEDATALEN];
+	RepOriginId originid;
+
+	memcpy(&handle, MyBgworkerEntry->bgw_extra, sizeof(dsm_handle));
+	memcpy(&index, MyBgworkerEntry->bgw_extra + sizeof(dsm_handle),
+		   sizeof(int));
+
+	pa_seg = dsm_attach(handle);
+	if (pa_seg == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("could not map dynamic shared memory segment")));
+	dsm_pin_mapping(pa_seg);
+
+	toc = shm_toc_attach(PARALLEL_APPLY_MAGIC, dsm_segment_address(pa_seg));
+	if (toc == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("invalid magic number in dynamic shared memory segment")));
+
+	pa_shared = shm_toc_lookup(toc, PARALLEL_APPLY_KEY_SHARED, false);
+	queues = shm_toc_lookup(toc, PARALLEL_APPLY_KEY_QUEUES, false);
+	pa_me = &pa_shared->workers[index];
+
+	mq = (shm_mq *) (queues + index * PARALLEL_APPLY_QUEUE_SIZE);
+	shm_mq_set_receiver(mq, MyProc);
+	mqh = shm_mq_attach(mq, pa_seg, NULL);
+
+	SpinLockAcquire(&pa_shared->mutex);
+	pa_me->proc = MyProc;
+	SpinLockRelease(&pa_shared->mutex);
+	before_shmem_exit(pa_worker_exit, (Datum) 0);
+
+	/*
+	 * Attach to slot.  The leader knows we have started once we have, so do
+	 * it only now that we're ready to receive.
+	 */
+	logicalrep_worker_attach(worker_slot);
+
+	/* Setup signal handling */
+	pqsignal(SIGHUP, pa_worker_sighup);
+	pqsignal(SIGTERM, die);
+	BackgroundWorkerUnblockSignals();
+
+	/* Run as replica session replication role. */
+	SetConfigOption("session_replication_role", "replica",
+					PGC_SUSET, PGC_S_OVERRIDE);
+
+	/* Connect to our database. */
+	BackgroundWorkerInitializeConnectionByOid(MyLogicalRepWorker->dbid,
+											  MyLogicalRepWorker->userid,
+											  0);
+
+	/* Load the subscription. */
+	InitializeApplyWorker();
+
+	/* Share the replication origin of the leader. */
+	snprintf(originname, sizeof(originname), "pg_%u", MySubscription->oid);
+	StartTransactionCommand();
+	originid = replorigin_by_name(originname, false);
+	CommitTransactionCommand();
+	replorigin_session_setup(originid, MyLogicalRepWorker->leader_pid);
+	replorigin_session_origin = originid;
+
+	ApplyMessageContext = AllocSetContextCreate(ApplyContext,
+												"ApplyMessageContext",
+												ALLOCSET_DEFAULT_SIZES);
+
+	for (;;)
+	{
+		shm_mq_result res;
+		Size		len;
+		void	   *data;
+		StringInfoData s;
+		MemoryContext oldctx;
+
+		CHECK_FOR_INTERRUPTS();
+
+		res = shm_mq_receive(mqh, &len, &data, false);
+
+		/* The leader has gone away, or let us go. */
+		if (res != SHM_MQ_SUCCESS)
+			break;
+
+		if (got_SIGHUP)
+		{
+			got_SIGHUP = false;
+			ProcessConfigFile(PGC_SIGHUP);
+		}
+
+		oldctx = MemoryContextSwitchTo(ApplyMessageContext);
+
+		s.data = data;
+		s.len = len;
+		s.cursor = 0;
+		s.maxlen = -1;
+
+		apply_dispatch(&s);
+
+		MemoryContextSwitchTo(oldctx);
+		MemoryContextReset(ApplyMessageContext);
+	}
+
+	proc_exit(0);
+}
@@ -97,11 +97,24 @@ void
 LogicalDecodingProcessRecord(LogicalDecodingContext *ctx, XLogReaderState *record)
 {
 	XLogRecordBuffer buf;
+	TransactionId txid;
 
 	buf.origptr = ctx->reader->ReadRecPtr;
 	buf.endptr = ctx->reader->EndRecPtr;
 	buf.record = record;
 
+	/*
+	 * The first record of a subtransaction carries the xid of its top-level
+	 * transaction.  Make note of the relationship right away, rather than
+	 * only at commit, so that the changes of the subtransaction can be
+	 * streamed along with the rest of the transaction while it's in
+	 * progress.
+	 */
+	txid = XLogRecGetTopXid(record);
+	if (TransactionIdIsValid(txid))
+		ReorderBufferAssignChild(ctx->reorder, txid, XLogRecGetXid(record),
+								 buf.origptr);
+
 	/* cast so we get a warning when new rmgrs are added */
 	switch ((RmgrIds) XLogRecGetRmid(record))
 	{
@@ -361,6 +361,26 @@ logicalrep_rel_open(LogicalRepRelId remoteid, LOCKMODE lockmode)
 	return entry;
 }
 
+/*
+ * Look up what the publisher told us about a remote relation, without
+ * opening the local one.
+ *
+ * Returns NULL if we haven't heard of the relation.
+ */
+LogicalRepRelation *
+logicalrep_rel_get_remote(LogicalRepRelId remoteid)
+{
+	LogicalRepRelMapEntry *entry;
+
+	if (LogicalRepRelMap == NULL)
+		return NULL;
+
+	entry = hash_search(LogicalRepRelMap, (void *) &remoteid,
+						HASH_FIND, NULL);
+
+	return entry ? &entry->remoterel : NULL;
+}
+
 /*
  * Close the previously opened logical relation.
  */
@@ -36,6 +36,15 @@
  *	  contents of individual (sub-)transactions will be read from disk in
  *	  chunks.
  *
+ *	  The memory used for changes of all transactions is limited by
+ *	  logical_decoding_work_mem.  When it's exceeded, the largest transaction
+ *	  is evicted from memory: if the output plugin supports it, its changes
+ *	  so far are streamed to the plugin right away (cf. ReorderBufferStreamTXN())
+ *	  and then forgotten, otherwise they're spilled to disk.  Only
+ *	  transactions that haven't modified the catalog can be streamed while
+ *	  in progress, as decoding them needs nothing but committed catalog
+ *	  contents.
+ *
  *	  This module also has to deal with reassembling toast records from the
  *	  individual chunks stored in WAL. When a new (or initial) version of a
  *	  tuple is stored in WAL it will always be preceded by the toast chunks
@@ -68,7 +77,7 @@
 #include "replication/logical.h"
 #include "replication/reorderbuffer.h"
 #include "replication/slot.h"
-#include "replication/snapbuild.h"	/* just for SnapBuildSnapDecRefcount */
+#include "replication/snapbuild.h"
 #include "storage/bufmgr.h"
 #include "storage/fd.h"
 #include "storage/sinval.h"
@@ -143,19 +152,14 @@ typedef struct ReorderBufferDiskChange
 } ReorderBufferDiskChange;
 
 /*
- * Maximum number of changes kept in memory, per transaction. After that,
- * changes are spooled to disk.
- *
- * The current value should be sufficient to decode the entire transaction
- * without hitting disk in OLTP workloads, while starting to spool to disk in
- * other workloads reasonably fast.
- *
- * At some point in the future it probably makes sense to have a more elaborate
- * resource management here, but it's not entirely clear what that would look
- * like.
+ * Maximum number of changes restored from disk into memory at a time, per
+ * transaction, when replaying a transaction that has been spilled to disk.
  */
 static const Size max_changes_in_memory = 4096;
 
+/* GUC variable: memory limit for the changes of all transactions, in kB */
+int			logical_decoding_work_mem;
+
 /* ---------------------------------------
  * primary reorderbuffer support routines
  * ---------------------------------------
@@ -189,7 +193,7 @@ static void ReorderBufferExecuteInvalidations(ReorderBuffer *rb, ReorderBufferTX
  * Disk serialization support functions
  * ---------------------------------------
  */
-static void ReorderBufferCheckSerializeTXN(ReorderBuffer *rb, ReorderBufferTXN *txn);
+static void ReorderBufferCheckMemoryLimit(ReorderBuffer *rb);
 static void ReorderBufferSerializeTXN(ReorderBuffer *rb, ReorderBufferTXN *txn);
 static void ReorderBufferSerializeChange(ReorderBuffer *rb, ReorderBufferTXN *txn,
 							 int fd, ReorderBufferChange *change);
@@ -206,6 +210,24 @@ static void ReorderBufferFreeSnap(ReorderBuffer *rb, Snapshot snap);
 static Snapshot ReorderBufferCopySnap(ReorderBuffer *rb, Snapshot orig_snap,
 					  ReorderBufferTXN *txn, CommandId cid);
 
+/*
+ * ---------------------------------------
+ * Memory accounting and streaming of in-progress transactions
+ * ---------------------------------------
+ */
+static Size ReorderBufferChangeSize(ReorderBufferChange *change);
+static void ReorderBufferChangeMemoryUpdate(ReorderBuffer *rb,
+								ReorderBufferChange *change, bool addition);
+static ReorderBufferTXN *ReorderBufferLargestTXN(ReorderBuffer *rb);
+static bool ReorderBufferCanStartStreaming(ReorderBuffer *rb);
+static ReorderBufferTXN *ReorderBufferLargestStreamableTXN(ReorderBuffer *rb);
+static bool ReorderBufferTXNHasChanges(ReorderBufferTXN *txn);
+static void ReorderBufferStreamTXN(ReorderBuffer *rb, ReorderBufferTXN *txn);
+static void ReorderBufferTruncateTXN(ReorderBuffer *rb, ReorderBufferTXN *txn);
+static void ReorderBufferProcessTXN(ReorderBuffer *rb, ReorderBufferTXN *txn,
+						XLogRecPtr commit_lsn, Snapshot snapshot_now,
+						CommandId command_id, bool streaming);
+
 /* ---------------------------------------
  * toast reassembly support
  * ---------------------------------------
@@ -269,6 +291,7 @@ ReorderBufferAllocate(void)
 
 	buffer->outbuf = NULL;
 	buffer->outbufsize = 0;
+	buffer->size = 0;
 
 	buffer->current_restart_decoding_lsn = InvalidXLogRecPtr;
 
@@ -350,6 +373,12 @@ ReorderBufferReturnTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
 		txn->invalidations = NULL;
 	}
 
+	if (txn->snapshot_now != NULL)
+	{
+		ReorderBufferFreeSnap(rb, txn->snapshot_now);
+		txn->snapshot_now = NULL;
+	}
+
 	pfree(txn);
 }
 
@@ -374,6 +403,9 @@ ReorderBufferGetChange(ReorderBuffer *rb)
 void
 ReorderBufferReturnChange(ReorderBuffer *rb, ReorderBufferChange *change)
 {
+	/* update memory accounting info */
+	ReorderBufferChangeMemoryUpdate(rb, change, false);
+
 	/* free contained data */
 	switch (change->action)
 	{
@@ -585,12 +617,17 @@ ReorderBufferQueueChange(ReorderBuffer *rb, TransactionId xid, XLogRecPtr lsn,
 	txn = ReorderBufferTXNByXid(rb, xid, true, NULL, lsn, true);
 
 	change->lsn = lsn;
+	change->txn = txn;
 	Assert(InvalidXLogRecPtr != lsn);
 	dlist_push_tail(&txn->changes, &change->node);
 	txn->nentries++;
 	txn->nentries_mem++;
 
-	ReorderBufferCheckSerializeTXN(rb, txn);
+	/* update memory accounting information */
+	ReorderBufferChangeMemoryUpdate(rb, change, true);
+
+	/* check the memory limits and evict something if needed */
+	ReorderBufferCheckMemoryLimit(rb);
 }
 
 /*
@@ -1192,6 +1229,14 @@ ReorderBufferCleanupTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
 	bool		found;
 	dlist_mutable_iter iter;
 
+	/* state left behind by streaming */
+	ReorderBufferToastReset(rb, txn);
+	if (txn->specinsert != NULL)
+	{
+		ReorderBufferReturnChange(rb, txn->specinsert);
+		txn->specinsert = NULL;
+	}
+
 	/* cleanup subtransactions & their changes */
 	dlist_foreach_modify(iter, &txn->subtxns)
 	{
@@ -1424,7 +1469,8 @@ ReorderBufferFreeSnap(ReorderBuffer *rb, Snapshot snap)
  * record is read because that's the only place where we know about cache
  * invalidations. Thus, once a toplevel commit is read, we iterate over the top
  * and subtransactions (using a k-way merge) and replay the changes in lsn
- * order.
+ * order.  (The exception are transactions without catalog changes, which may
+ * have been streamed in part while in progress, see ReorderBufferStreamTXN.)
  */
 void
 ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
@@ -1433,10 +1479,6 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 					RepOriginId origin_id, XLogRecPtr origin_lsn)
 {
 	ReorderBufferTXN *txn;
-	volatile Snapshot snapshot_now;
-	volatile CommandId command_id = FirstCommandId;
-	bool		using_subtxn;
-	ReorderBufferIterTXNState *volatile iterstate = NULL;
 
 	txn = ReorderBufferTXNByXid(rb, xid, false, NULL, InvalidXLogRecPtr,
 								false);
@@ -1464,7 +1506,50 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 		return;
 	}
 
-	snapshot_now = txn->base_snapshot;
+	/*
+	 * If parts of the transaction have been streamed already, stream the rest
+	 * and tell the output plugin about the commit, continuing with the state
+	 * the last block streamed left behind.
+	 */
+	if (txn->streamed)
+	{
+		Snapshot	snapshot_now;
+
+		snapshot_now = ReorderBufferCopySnap(rb, txn->snapshot_now,
+											 txn, txn->command_id);
+		ReorderBufferFreeSnap(rb, txn->snapshot_now);
+		txn->snapshot_now = NULL;
+
+		ReorderBufferProcessTXN(rb, txn, commit_lsn, snapshot_now,
+								txn->command_id, false);
+		return;
+	}
+
+	ReorderBufferProcessTXN(rb, txn, commit_lsn, txn->base_snapshot,
+							FirstCommandId, false);
+}
+
+/*
+ * Replay the changes of a transaction and its subtransactions, passing them
+ * to the output plugin, starting with the given snapshot and command id.
+ *
+ * If 'streaming', the transaction is still in progress, and the changes it
+ * has so far are passed as a block of a streamed transaction; they are then
+ * forgotten, and the state needed to continue with the next block is
+ * remembered.  Otherwise the transaction has committed, and is cleaned up
+ * after passing it to the output plugin, which happens in a last streamed
+ * block followed by the commit if parts of it have been streamed before.
+ */
+static void
+ReorderBufferProcessTXN(ReorderBuffer *rb, ReorderBufferTXN *txn,
+						XLogRecPtr commit_lsn, volatile Snapshot snapshot_now,
+						volatile CommandId command_id, bool streaming)
+{
+	bool		using_subtxn;
+	ReorderBufferIterTXNState *volatile iterstate = NULL;
+	bool		stream_output = streaming || txn->streamed;
+	bool		stream_block = streaming ||
+	(txn->streamed && ReorderBufferTXNHasChanges(txn));
 
 	/* build data to be able to lookup the CommandIds of catalog tuples */
 	ReorderBufferBuildTupleCidHash(rb, txn);
@@ -1487,14 +1572,19 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 	PG_TRY();
 	{
 		ReorderBufferChange *change;
-		ReorderBufferChange *specinsert = NULL;
+		ReorderBufferChange *specinsert = txn->specinsert;
+
+		txn->specinsert = NULL;
 
 		if (using_subtxn)
 			BeginInternalSubTransaction("replay");
 		else
 			StartTransactionCommand();
 
-		rb->begin(rb, txn);
+		if (stream_block)
+			rb->stream_start(rb, txn);
+		else if (!stream_output)
+			rb->begin(rb, txn);
 
 		iterstate = ReorderBufferIterTXNInit(rb, txn);
 		while ((change = ReorderBufferIterTXNNext(rb, iterstate)) != NULL)
@@ -1514,6 +1604,14 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 					if (specinsert == NULL)
 						elog(ERROR, "invalid ordering of speculative insertion changes");
 					Assert(specinsert->data.tp.oldtuple == NULL);
+
+					/*
+					 * Account for the insertion again, as part of the
+					 * (sub)transaction of the confirmation, until it gets
+					 * cleaned up below.
+					 */
+					specinsert->txn = change->txn;
+					ReorderBufferChangeMemoryUpdate(rb, specinsert, true);
 					change = specinsert;
 					change->action = REORDER_BUFFER_CHANGE_INSERT;
 
@@ -1577,8 +1675,15 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 					/* user-triggered change */
 					if (!IsToastRelation(relation))
 					{
+						/* the change may grow when toast gets reassembled */
+						ReorderBufferChangeMemoryUpdate(rb, change, false);
 						ReorderBufferToastReplace(rb, txn, relation, change);
-						rb->apply_change(rb, txn, relation, change);
+						ReorderBufferChangeMemoryUpdate(rb, change, true);
+
+						if (stream_output)
+							rb->stream_change(rb, txn, relation, change);
+						else
+							rb->apply_change(rb, txn, relation, change);
 
 						/*
 						 * Only clear reassembled toast chunks if we're sure
@@ -1601,6 +1706,14 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 						 */
 						Assert(change->data.tp.newtuple != NULL);
 
+						/*
+						 * The chunk may outlive the block of a streamed
+						 * transaction it was part of, so stop accounting for
+						 * it.
+						 */
+						ReorderBufferChangeMemoryUpdate(rb, change, false);
+						change->txn = NULL;
+
 						dlist_delete(&change->node);
 						ReorderBufferToastAppendChunk(rb, txn, relation,
 													  change);
@@ -1648,6 +1761,8 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 					}
 
 					/* and memorize the pending insertion */
+					ReorderBufferChangeMemoryUpdate(rb, change, false);
+					change->txn = NULL;
 					dlist_delete(&change->node);
 					specinsert = change;
 					break;
@@ -1676,7 +1791,12 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 							relations[nrelations++] = relation;
 						}
 
-						rb->apply_truncate(rb, txn, nrelations, relations, change);
+						if (stream_output)
+							rb->stream_truncate(rb, txn, nrelations,
+												relations, change);
+						else
+							rb->apply_truncate(rb, txn, nrelations,
+											   relations, change);
 
 						for (i = 0; i < nrelations; i++)
 							RelationClose(relations[i]);
@@ -1685,10 +1805,16 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 					}
 
 				case REORDER_BUFFER_CHANGE_MESSAGE:
-					rb->message(rb, txn, change->lsn, true,
-								change->data.msg.prefix,
-								change->data.msg.message_size,
-								change->data.msg.message);
+					if (stream_output)
+						rb->stream_message(rb, txn, change->lsn, true,
+										   change->data.msg.prefix,
+										   change->data.msg.message_size,
+										   change->data.msg.message);
+					else
+						rb->message(rb, txn, change->lsn, true,
+									change->data.msg.prefix,
+									change->data.msg.message_size,
+									change->data.msg.message);
 					break;
 
 				case REORDER_BUFFER_CHANGE_INTERNAL_SNAPSHOT:
@@ -1760,22 +1886,28 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 		}
 
 		/*
-		 * There's a speculative insertion remaining, just clean in up, it
-		 * can't have been successful, otherwise we'd gotten a confirmation
-		 * record.
+		 * There's a speculative insertion remaining.  If the transaction is
+		 * still in progress, its confirmation may yet come, in the next block
+		 * of changes.  Otherwise just clean it up, it can't have been
+		 * successful, otherwise we'd gotten a confirmation record.
 		 */
-		if (specinsert)
-		{
+		if (specinsert && streaming)
+			txn->specinsert = specinsert;
+		else if (specinsert)
 			ReorderBufferReturnChange(rb, specinsert);
-			specinsert = NULL;
-		}
+		specinsert = NULL;
 
 		/* clean up the iterator */
 		ReorderBufferIterTXNFinish(rb, iterstate);
 		iterstate = NULL;
 
-		/* call commit callback */
-		rb->commit(rb, txn, commit_lsn);
+		/* call stop and commit callbacks */
+		if (stream_block)
+			rb->stream_stop(rb, txn);
+		if (!streaming && txn->streamed)
+			rb->stream_commit(rb, txn, commit_lsn);
+		else if (!streaming)
+			rb->commit(rb, txn, commit_lsn);
 
 		/* this is just a sanity check against bad output plugin behaviour */
 		if (GetCurrentTransactionIdIfAny() != InvalidTransactionId)
@@ -1799,11 +1931,29 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 		if (using_subtxn)
 			RollbackAndReleaseCurrentSubTransaction();
 
-		if (snapshot_now->copied)
-			ReorderBufferFreeSnap(rb, snapshot_now);
+		if (streaming)
+		{
+			/*
+			 * Remember where to continue decoding with the next block, and
+			 * forget about the changes streamed.  The snapshot may belong
+			 * to one of those, so make sure to keep a copy of our own.
+			 */
+			if (!snapshot_now->copied)
+				snapshot_now = ReorderBufferCopySnap(rb, snapshot_now,
+													 txn, command_id);
+			txn->snapshot_now = snapshot_now;
+			txn->command_id = command_id;
 
-		/* remove potential on-disk data, and deallocate */
-		ReorderBufferCleanupTXN(rb, txn);
+			ReorderBufferTruncateTXN(rb, txn);
+		}
+		else
+		{
+			if (snapshot_now->copied)
+				ReorderBufferFreeSnap(rb, snapshot_now);
+
+			/* remove potential on-disk data, and deallocate */
+			ReorderBufferCleanupTXN(rb, txn);
+		}
 	}
 	PG_CATCH();
 	{
@@ -1863,6 +2013,10 @@ ReorderBufferAbort(ReorderBuffer *rb, TransactionId xid, XLogRecPtr lsn)
 	/* cosmetic... */
 	txn->final_lsn = lsn;
 
+	/* have the output plugin discard what has been streamed of it */
+	if (txn->streamed)
+		rb->stream_abort(rb, txn, lsn);
+
 	/* remove potential on-disk data, and deallocate */
 	ReorderBufferCleanupTXN(rb, txn);
 }
@@ -1911,6 +2065,10 @@ ReorderBufferAbortOld(ReorderBuffer *rb, TransactionId oldestRunningXid)
 
 			elog(DEBUG2, "aborting old transaction %u", txn->xid);
 
+			if (txn->streamed)
+				rb->stream_abort(rb, txn, txn->final_lsn != InvalidXLogRecPtr ?
+								 txn->final_lsn : txn->first_lsn);
+
 			/* remove potential on-disk data, and deallocate this tx */
 			ReorderBufferCleanupTXN(rb, txn);
 		}
@@ -1947,6 +2105,10 @@ ReorderBufferForget(ReorderBuffer *rb, TransactionId xid, XLogRecPtr lsn)
 	/* cosmetic... */
 	txn->final_lsn = lsn;
 
+	/* have the output plugin discard what has been streamed of it */
+	if (txn->streamed)
+		rb->stream_abort(rb, txn, lsn);
+
 	/*
 	 * Process cache invalidation messages if there are any. Even if we're not
 	 * interested in the transaction's contents, it could have manipulated the
@@ -2226,22 +2388,322 @@ ReorderBufferSerializeReserve(ReorderBuffer *rb, Size sz)
 }
 
 /*
- * Check whether the transaction tx should spill its data to disk.
+ * Check whether the changes in memory exceed logical_decoding_work_mem, and
+ * if so, evict the largest transactions until they don't: stream them to the
+ * output plugin if possible, or spill them to disk.
  */
 static void
-ReorderBufferCheckSerializeTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
+ReorderBufferCheckMemoryLimit(ReorderBuffer *rb)
 {
-	/*
-	 * TODO: improve accounting so we cheaply can take subtransactions into
-	 * account here.
-	 */
-	if (txn->nentries_mem >= max_changes_in_memory)
+	while (rb->size >= logical_decoding_work_mem * 1024L)
+	{
+		ReorderBufferTXN *txn;
+		Size		before = rb->size;
+
+		txn = ReorderBufferLargestStreamableTXN(rb);
+		if (txn != NULL)
+			ReorderBufferStreamTXN(rb, txn);
+		else
+		{
+			txn = ReorderBufferLargestTXN(rb);
+			ReorderBufferSerializeTXN(rb, txn);
+			Assert(txn->size == 0);
+		}
+
+		/* shouldn't happen, but don't loop forever */
+		if (rb->size >= before)
+			break;
+	}
+}
+
+/*
+ * Amount of memory used by a change, for the purposes of
+ * logical_decoding_work_mem.
+ */
+static Size
+ReorderBufferChangeSize(ReorderBufferChange *change)
+{
+	Size		sz = sizeof(ReorderBufferChange);
+
+	switch (change->action)
+	{
+			/* fall through these, they're all similar enough */
+		case REORDER_BUFFER_CHANGE_INSERT:
+		case REORDER_BUFFER_CHANGE_UPDATE:
+		case REORDER_BUFFER_CHANGE_DELETE:
+		case REORDER_BUFFER_CHANGE_INTERNAL_SPEC_INSERT:
+			if (change->data.tp.oldtuple)
+				sz += sizeof(ReorderBufferTupleBuf) +
+					change->data.tp.oldtuple->tuple.t_len;
+			if (change->data.tp.newtuple)
+				sz += sizeof(ReorderBufferTupleBuf) +
+					change->data.tp.newtuple->tuple.t_len;
+			break;
+		case REORDER_BUFFER_CHANGE_MESSAGE:
+			sz += strlen(change->data.msg.prefix) + 1 +
+				change->data.msg.message_size;
+			break;
+		case REORDER_BUFFER_CHANGE_INTERNAL_SNAPSHOT:
+			{
+				Snapshot	snap = change->data.snapshot;
+
+				sz += sizeof(SnapshotData) +
+					sizeof(TransactionId) * snap->xcnt +
+					sizeof(TransactionId) * snap->subxcnt;
+				break;
+			}
+		case REORDER_BUFFER_CHANGE_TRUNCATE:
+			sz += sizeof(Oid) * change->data.truncate.nrelids;
+			break;
+		case REORDER_BUFFER_CHANGE_INTERNAL_SPEC_CONFIRM:
+		case REORDER_BUFFER_CHANGE_INTERNAL_COMMAND_ID:
+		case REORDER_BUFFER_CHANGE_INTERNAL_TUPLECID:
+			/* ReorderBufferChange contains everything important */
+			break;
+	}
+
+	return sz;
+}
+
+/*
+ * Add or subtract the size of a change to the memory used by its transaction
+ * and by the whole reorder buffer.
+ *
+ * Changes that aren't queued in a transaction's list of changes, i.e. those
+ * with change->txn == NULL, aren't accounted.
+ */
+static void
+ReorderBufferChangeMemoryUpdate(ReorderBuffer *rb,
+								ReorderBufferChange *change, bool addition)
+{
+	ReorderBufferTXN *txn = change->txn;
+	Size		sz;
+
+	if (txn == NULL)
+		return;
+
+	sz = ReorderBufferChangeSize(change);
+
+	if (addition)
+	{
+		txn->size += sz;
+		rb->size += sz;
+	}
+	else
 	{
-		ReorderBufferSerializeTXN(rb, txn);
-		Assert(txn->nentries_mem == 0);
+		Assert(txn->size >= sz && rb->size >= sz);
+		txn->size -= sz;
+		rb->size -= sz;
 	}
 }
 
+/*
+ * Find the (sub)transaction using the most memory, to spill it to disk.
+ */
+static ReorderBufferTXN *
+ReorderBufferLargestTXN(ReorderBuffer *rb)
+{
+	HASH_SEQ_STATUS hash_seq;
+	ReorderBufferTXNByIdEnt *ent;
+	ReorderBufferTXN *largest = NULL;
+
+	hash_seq_init(&hash_seq, rb->by_txn);
+	while ((ent = hash_seq_search(&hash_seq)) != NULL)
+	{
+		ReorderBufferTXN *txn = ent->txn;
+
+		if (largest == NULL || txn->size > largest->size)
+			largest = txn;
+	}
+
+	Assert(largest != NULL);
+
+	return largest;
+}
+
+/*
+ * Can the output plugin be sent in-progress transactions now?
+ *
+ * Besides the plugin supporting it, the snapshot builder has to have reached
+ * a consistent state, and we must be past the point from which on the client
+ * wants changes; otherwise we might stream changes of transactions that are
+ * not going to be decoded after all.
+ */
+static bool
+ReorderBufferCanStartStreaming(ReorderBuffer *rb)
+{
+	LogicalDecodingContext *ctx = rb->private_data;
+	SnapBuild  *builder = ctx->snapshot_builder;
+
+	if (!ctx->streaming)
+		return false;
+
+	if (SnapBuildCurrentState(builder) < SNAPBUILD_CONSISTENT)
+		return false;
+
+	if (SnapBuildXactNeedsSkip(builder, ctx->reader->EndRecPtr))
+		return false;
+
+	return true;
+}
+
+/*
+ * Find the largest toplevel transaction, counting its subtransactions, that
+ * can be streamed to the output plugin before it commits.
+ *
+ * Transactions that modified the catalog are never streamed, since decoding
+ * their later changes would require the catalog contents as of those
+ * changes, which we only know about once the commit has been decoded; they
+ * are spilled to disk instead.
+ */
+static ReorderBufferTXN *
+ReorderBufferLargestStreamableTXN(ReorderBuffer *rb)
+{
+	dlist_iter	iter;
+	ReorderBufferTXN *largest = NULL;
+	Size		largest_size = 0;
+
+	if (!ReorderBufferCanStartStreaming(rb))
+		return NULL;
+
+	dlist_foreach(iter, &rb->toplevel_by_lsn)
+	{
+		ReorderBufferTXN *txn;
+		dlist_iter	subtxn_i;
+		Size		size;
+		bool		catalog_changes;
+
+		txn = dlist_container(ReorderBufferTXN, node, iter.cur);
+
+		if (txn->base_snapshot == NULL || !ReorderBufferTXNHasChanges(txn))
+			continue;
+
+		size = txn->size;
+		catalog_changes = txn->has_catalog_changes;
+		dlist_foreach(subtxn_i, &txn->subtxns)
+		{
+			ReorderBufferTXN *subtxn;
+
+			subtxn = dlist_container(ReorderBufferTXN, node, subtxn_i.cur);
+			size += subtxn->size;
+			catalog_changes |= subtxn->has_catalog_changes;
+		}
+
+		if (catalog_changes)
+			continue;
+
+		if (largest == NULL || size > largest_size)
+		{
+			largest = txn;
+			largest_size = size;
+		}
+	}
+
+	return largest;
+}
+
+/*
+ * Does the transaction or one of its subtransactions have changes that
+ * haven't been sent to the output plugin yet?
+ */
+static bool
+ReorderBufferTXNHasChanges(ReorderBufferTXN *txn)
+{
+	dlist_iter	iter;
+
+	if (txn->nentries > 0)
+		return true;
+
+	dlist_foreach(iter, &txn->subtxns)
+	{
+		ReorderBufferTXN *subtxn;
+
+		subtxn = dlist_container(ReorderBufferTXN, node, iter.cur);
+		if (subtxn->nentries > 0)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Send the changes of an in-progress toplevel transaction decoded so far to
+ * the output plugin, as one block of a streamed transaction, and throw them
+ * away.
+ *
+ * The snapshot and command id reached by the end of the block are kept with
+ * the transaction, to continue from there with the next block or at commit.
+ */
+static void
+ReorderBufferStreamTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
+{
+	Snapshot	snapshot_now;
+	CommandId	command_id;
+
+	Assert(txn->toplevel_xid == InvalidTransactionId);
+	Assert(txn->base_snapshot != NULL);
+
+	if (txn->snapshot_now == NULL)
+	{
+		command_id = FirstCommandId;
+		snapshot_now = ReorderBufferCopySnap(rb, txn->base_snapshot,
+											 txn, command_id);
+	}
+	else
+	{
+		command_id = txn->command_id;
+		snapshot_now = ReorderBufferCopySnap(rb, txn->snapshot_now,
+											 txn, command_id);
+		ReorderBufferFreeSnap(rb, txn->snapshot_now);
+		txn->snapshot_now = NULL;
+	}
+
+	ReorderBufferProcessTXN(rb, txn, InvalidXLogRecPtr, snapshot_now,
+							command_id, true);
+
+	txn->streamed = true;
+}
+
+/*
+ * Throw away the changes of a transaction and its subtransactions that have
+ * been streamed, keeping the transactions themselves around until they end.
+ */
+static void
+ReorderBufferTruncateTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
+{
+	dlist_mutable_iter iter;
+
+	dlist_foreach_modify(iter, &txn->subtxns)
+	{
+		ReorderBufferTXN *subtxn;
+
+		subtxn = dlist_container(ReorderBufferTXN, node, iter.cur);
+		ReorderBufferTruncateTXN(rb, subtxn);
+	}
+
+	dlist_foreach_modify(iter, &txn->changes)
+	{
+		ReorderBufferChange *change;
+
+		change = dlist_container(ReorderBufferChange, node, iter.cur);
+		dlist_delete(&change->node);
+		ReorderBufferReturnChange(rb, change);
+	}
+
+	/* the changes spilled to disk have been streamed, too */
+	if (txn->serialized)
+	{
+		ReorderBufferRestoreCleanup(rb, txn);
+		txn->serialized = false;
+	}
+
+	if (txn->nentries > 0)
+		txn->streamed = true;
+
+	txn->nentries = 0;
+	txn->nentries_mem = 0;
+}
+
 /*
  * Spill data of a large transaction (and its subtransactions) to disk.
  */
@@ -2306,6 +2768,15 @@ ReorderBufferSerializeTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
 
 		ReorderBufferSerializeChange(rb, txn, fd, change);
 		dlist_delete(&change->node);
+
+		/*
+		 * Remember up to where changes have been spilled, in case the
+		 * transaction is still in progress; this is where the files have to
+		 * be read or removed up to.
+		 */
+		if (change->lsn > txn->final_lsn)
+			txn->final_lsn = change->lsn;
+
 		ReorderBufferReturnChange(rb, change);
 
 		spilled++;
@@ -2780,6 +3251,10 @@ ReorderBufferRestoreChange(ReorderBuffer *rb, ReorderBufferTXN *txn,
 
 	dlist_push_tail(&txn->changes, &change->node);
 	txn->nentries_mem++;
+
+	/* update memory accounting information */
+	change->txn = txn;
+	ReorderBufferChangeMemoryUpdate(rb, change, true);
 }
 
 /*
@@ -3118,7 +3593,7 @@ ReorderBufferToastReplace(ReorderBuffer *rb, ReorderBufferTXN *txn,
 				   VARSIZE(chunk) - VARHDRSZ);
 			data_done += VARSIZE(chunk) - VARHDRSZ;
 		}
-		Assert(data_done == toast_pointer.va_extsize);
+		Assert(data_done == VARATT_EXTERNAL_GET_EXTSIZE(toast_pointer));
 
 		/* make sure its marked as compressed or not */
 		if (VARATT_EXTERNAL_IS_COMPRESSED(toast_pointer))
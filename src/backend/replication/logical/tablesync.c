@@ -111,6 +111,9 @@
 
 static bool table_states_valid = false;
 
+/* Tables of the subscription that are not ready, for the apply worker */
+static List *table_states = NIL;
+
 StringInfo	copybuf = NULL;
 
 /*
@@ -330,7 +333,6 @@ process_syncing_tables_for_apply(XLogRecPtr current_lsn)
 		Oid			relid;
 		TimestampTz last_start_time;
 	};
-	static List *table_states = NIL;
 	static HTAB *last_start_times = NULL;
 	ListCell   *lc;
 	bool		started_tx = false;
@@ -513,7 +515,8 @@ process_syncing_tables_for_apply(XLogRecPtr current_lsn)
 												 MySubscription->oid,
 												 MySubscription->name,
 												 MyLogicalRepWorker->userid,
-												 rstate->relid);
+												 rstate->relid,
+												 DSM_HANDLE_INVALID, 0);
 						hentry->last_start_time = now;
 					}
 				}
@@ -540,6 +543,21 @@ process_syncing_tables(XLogRecPtr current_lsn)
 		process_syncing_tables_for_apply(current_lsn);
 }
 
+/*
+ * Are all tables of the subscription ready, i.e. replicated by the apply
+ * worker alone?
+ *
+ * This only looks at what process_syncing_tables() saw last time; if the
+ * table states have changed since, we don't know, and say no.
+ */
+bool
+AllTablesyncsReady(void)
+{
+	Assert(!am_tablesync_worker());
+
+	return table_states_valid && table_states == NIL;
+}
+
 /*
  * Create list of columns for COPY based on logical relation mapping.
  */
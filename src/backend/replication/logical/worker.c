@@ -18,6 +18,19 @@
  *	  This module includes server facing code and shares libpqwalreceiver
  *	  module with walreceiver for providing the libpq specific functionality.
  *
+ *	  If the subscription has streaming enabled, the publisher may send the
+ *	  changes of large transactions before they commit, in blocks enclosed in
+ *	  STREAM START and STREAM STOP messages.  We can't apply those right away,
+ *	  since the transaction may still abort, so they are spooled to a
+ *	  temporary file, one per streamed transaction, and applied when STREAM
+ *	  COMMIT arrives.  The changes of each subtransaction are tagged with its
+ *	  xid, so that they can be discarded if it aborts.
+ *
+ *	  With max_parallel_apply_workers_per_subscription > 0, the apply worker
+ *	  hands transactions over to parallel apply workers instead of applying
+ *	  them itself where it can; see applyparallelworker.c.  The parallel apply
+ *	  workers run the same code below on the messages passed on to them.
+ *
  *-------------------------------------------------------------------------
  */
 
@@ -69,6 +82,7 @@
 
 #include "rewrite/rewriteHandler.h"
 
+#include "storage/buffile.h"
 #include "storage/bufmgr.h"
 #include "storage/ipc.h"
 #include "storage/lmgr.h"
@@ -108,7 +122,7 @@ typedef struct SlotErrCallbackArg
 	int			remote_attnum;
 } SlotErrCallbackArg;
 
-static MemoryContext ApplyMessageContext = NULL;
+MemoryContext ApplyMessageContext = NULL;
 MemoryContext ApplyContext = NULL;
 
 WalReceiverConn *wrconn = NULL;
@@ -119,12 +133,42 @@ bool		MySubscriptionValid = false;
 bool		in_remote_transaction = false;
 static XLogRecPtr remote_final_lsn = InvalidXLogRecPtr;
 
-static void send_feedback(XLogRecPtr recvpos, bool force, bool requestReply);
+/* First change of a subtransaction in the spool file of a streamed xact */
+typedef struct StreamSubXact
+{
+	TransactionId xid;			/* xid of the subtransaction */
+	int			fileno;			/* where its changes start */
+	off_t		offset;
+	int			nchanges;		/* number of changes before it */
+} StreamSubXact;
+
+/* Spool file of a transaction being streamed to us */
+typedef struct StreamXact
+{
+	TransactionId xid;			/* xid of the toplevel transaction */
+	BufFile    *file;			/* changes received so far */
+	int			nchanges;		/* number of valid changes in 'file' */
+
+	/* subtransactions seen, in the order of their first change */
+	StreamSubXact *subxacts;
+	int			nsubxacts;
+	int			maxsubxacts;
+} StreamXact;
 
-static void store_flush_position(XLogRecPtr remote_lsn);
+/* streamed transactions in progress, in ApplyContext */
+static List *stream_xacts = NIL;
+
+/* the streamed transaction a block of changes is being received for */
+static StreamXact *stream_xact = NULL;
+
+static void send_feedback(XLogRecPtr recvpos, bool force, bool requestReply);
 
 static void maybe_reread_subscription(void);
 
+static StreamXact *stream_xact_lookup(TransactionId xid);
+static void stream_xact_discard(StreamXact *sxact);
+static void stream_write_change(char action, StringInfo s);
+
 /* Flags set by signal handlers */
 static volatile sig_atomic_t got_SIGHUP = false;
 
@@ -173,6 +217,13 @@ ensure_transaction(void)
 	SetCurrentStatementStartTimestamp();
 	StartTransactionCommand();
 
+	/*
+	 * Let the parallel apply worker that is to commit next wait for us, see
+	 * pa_wait_for_turn().
+	 */
+	if (am_parallel_apply_worker())
+		pa_set_xact_id(GetCurrentTransactionId());
+
 	maybe_reread_subscription();
 
 	MemoryContextSwitchTo(ApplyMessageContext);
@@ -315,13 +366,60 @@ slot_store_error_callback(void *arg)
 }
 
 /*
- * Store data in C string form into slot.
+ * Convert the value of remote column remoteattnum in tupleData to a Datum of
+ * the type of att, with the input function of the type or, if the value was
+ * sent in binary, with its receive function.
+ */
+static Datum
+slot_convert_value(Form_pg_attribute att, LogicalRepTupleData *tupleData,
+				   int remoteattnum)
+{
+	Datum		value;
+
+	if (tupleData->binary[remoteattnum])
+	{
+		Oid			typreceive;
+		Oid			typioparam;
+		StringInfoData buf;
+
+		getTypeBinaryInputInfo(att->atttypid, &typreceive, &typioparam);
+
+		buf.data = tupleData->values[remoteattnum];
+		buf.len = tupleData->lengths[remoteattnum];
+		buf.maxlen = buf.len + 1;
+		buf.cursor = 0;
+
+		value = OidReceiveFunctionCall(typreceive, &buf, typioparam,
+									   att->atttypmod);
+
+		/* Trouble if it didn't eat the whole buffer */
+		if (buf.cursor != buf.len)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+					 errmsg("incorrect binary data format in logical replication column %d",
+							remoteattnum + 1)));
+	}
+	else
+	{
+		Oid			typinput;
+		Oid			typioparam;
+
+		getTypeInputInfo(att->atttypid, &typinput, &typioparam);
+		value = OidInputFunctionCall(typinput, tupleData->values[remoteattnum],
+									 typioparam, att->atttypmod);
+	}
+
+	return value;
+}
+
+/*
+ * Store data received from the publisher into slot.
  * This is similar to BuildTupleFromCStrings but TupleTableSlot fits our
  * use better.
  */
 static void
-slot_store_cstrings(TupleTableSlot *slot, LogicalRepRelMapEntry *rel,
-					char **values)
+slot_store_data(TupleTableSlot *slot, LogicalRepRelMapEntry *rel,
+				LogicalRepTupleData *tupleData)
 {
 	int			natts = slot->tts_tupleDescriptor->natts;
 	int			i;
@@ -346,18 +444,13 @@ slot_store_cstrings(TupleTableSlot *slot, LogicalRepRelMapEntry *rel,
 		int			remoteattnum = rel->attrmap[i];
 
 		if (!att->attisdropped && remoteattnum >= 0 &&
-			values[remoteattnum] != NULL)
+			tupleData->values[remoteattnum] != NULL)
 		{
-			Oid			typinput;
-			Oid			typioparam;
-
 			errarg.local_attnum = i;
 			errarg.remote_attnum = remoteattnum;
 
-			getTypeInputInfo(att->atttypid, &typinput, &typioparam);
-			slot->tts_values[i] =
-				OidInputFunctionCall(typinput, values[remoteattnum],
-									 typioparam, att->atttypmod);
+			slot->tts_values[i] = slot_convert_value(att, tupleData,
+													 remoteattnum);
 			slot->tts_isnull[i] = false;
 
 			errarg.local_attnum = -1;
@@ -382,14 +475,15 @@ slot_store_cstrings(TupleTableSlot *slot, LogicalRepRelMapEntry *rel,
 }
 
 /*
- * Modify slot with user data provided as C strings.
+ * Modify slot with the changed columns of the data received from the
+ * publisher.
  * This is somewhat similar to heap_modify_tuple but also calls the type
- * input function on the user data as the input is the text representation
- * of the types.
+ * input or receive function on the user data, as it comes in the text or
+ * binary representation of the types.
  */
 static void
-slot_modify_cstrings(TupleTableSlot *slot, LogicalRepRelMapEntry *rel,
-					 char **values, bool *replaces)
+slot_modify_data(TupleTableSlot *slot, LogicalRepRelMapEntry *rel,
+				 LogicalRepTupleData *tupleData)
 {
 	int			natts = slot->tts_tupleDescriptor->natts;
 	int			i;
@@ -417,21 +511,16 @@ slot_modify_cstrings(TupleTableSlot *slot, LogicalRepRelMapEntry *rel,
 		if (remoteattnum < 0)
 			continue;
 
-		if (!replaces[remoteattnum])
+		if (!tupleData->changed[remoteattnum])
 			continue;
 
-		if (values[remoteattnum] != NULL)
+		if (tupleData->values[remoteattnum] != NULL)
 		{
-			Oid			typinput;
-			Oid			typioparam;
-
 			errarg.local_attnum = i;
 			errarg.remote_attnum = remoteattnum;
 
-			getTypeInputInfo(att->atttypid, &typinput, &typioparam);
-			slot->tts_values[i] =
-				OidInputFunctionCall(typinput, values[remoteattnum],
-									 typioparam, att->atttypmod);
+			slot->tts_values[i] = slot_convert_value(att, tupleData,
+													 remoteattnum);
 			slot->tts_isnull[i] = false;
 
 			errarg.local_attnum = -1;
@@ -468,18 +557,18 @@ apply_handle_begin(StringInfo s)
 }
 
 /*
- * Handle COMMIT message.
+ * Commit the remote transaction being applied.
  *
  * TODO, support tracking of multiple origins
  */
 static void
-apply_handle_commit(StringInfo s)
+apply_commit(LogicalRepCommitData *commit_data)
 {
-	LogicalRepCommitData commit_data;
+	XLogRecPtr	local_end = InvalidXLogRecPtr;
 
-	logicalrep_read_commit(s, &commit_data);
-
-	Assert(commit_data.commit_lsn == remote_final_lsn);
+	/* Transactions applied in parallel still commit in the original order. */
+	if (am_parallel_apply_worker())
+		pa_wait_for_turn();
 
 	/* The synchronization worker runs in single transaction. */
 	if (IsTransactionState() && !am_tablesync_worker())
@@ -488,13 +577,15 @@ apply_handle_commit(StringInfo s)
 		 * Update origin state so we can restart streaming from correct
 		 * position in case of crash.
 		 */
-		replorigin_session_origin_lsn = commit_data.end_lsn;
-		replorigin_session_origin_timestamp = commit_data.committime;
+		replorigin_session_origin_lsn = commit_data->end_lsn;
+		replorigin_session_origin_timestamp = commit_data->committime;
 
 		CommitTransactionCommand();
 		pgstat_report_stat(false);
 
-		store_flush_position(commit_data.end_lsn);
+		local_end = XactLastCommitEnd;
+		if (!am_parallel_apply_worker())
+			store_flush_position(commit_data->end_lsn, local_end);
 	}
 	else
 	{
@@ -505,12 +596,33 @@ apply_handle_commit(StringInfo s)
 
 	in_remote_transaction = false;
 
-	/* Process any tables that are being synchronized in parallel. */
-	process_syncing_tables(commit_data.end_lsn);
+	/*
+	 * Let the leader know, or process any tables that are being synchronized
+	 * in parallel.
+	 */
+	if (am_parallel_apply_worker())
+		pa_commit_done(commit_data->end_lsn, local_end);
+	else
+		process_syncing_tables(commit_data->end_lsn);
 
 	pgstat_report_activity(STATE_IDLE, NULL);
 }
 
+/*
+ * Handle COMMIT message.
+ */
+static void
+apply_handle_commit(StringInfo s)
+{
+	LogicalRepCommitData commit_data;
+
+	logicalrep_read_commit(s, &commit_data);
+
+	Assert(commit_data.commit_lsn == remote_final_lsn);
+
+	apply_commit(&commit_data);
+}
+
 /*
  * Handle ORIGIN message.
  *
@@ -530,6 +642,305 @@ apply_handle_origin(StringInfo s)
 				 errmsg("ORIGIN message sent out of order")));
 }
 
+/*
+ * Find the spool file of a streamed transaction, if we have one.
+ */
+static StreamXact *
+stream_xact_lookup(TransactionId xid)
+{
+	ListCell   *lc;
+
+	foreach(lc, stream_xacts)
+	{
+		StreamXact *sxact = (StreamXact *) lfirst(lc);
+
+		if (sxact->xid == xid)
+			return sxact;
+	}
+
+	return NULL;
+}
+
+/*
+ * Forget about a streamed transaction, and remove its spool file.
+ */
+static void
+stream_xact_discard(StreamXact *sxact)
+{
+	BufFileClose(sxact->file);
+	if (sxact->subxacts)
+		pfree(sxact->subxacts);
+
+	stream_xacts = list_delete_ptr(stream_xacts, sxact);
+	pfree(sxact);
+}
+
+/*
+ * Spool a change of the streamed transaction, received within a block of
+ * changes.
+ *
+ * The message is written to the file as its length, followed by the action
+ * and the rest of the message after the xid of the (sub)transaction the
+ * change belongs to, so that it can be fed to apply_dispatch() as is.
+ */
+static void
+stream_write_change(char action, StringInfo s)
+{
+	StreamXact *sxact = stream_xact;
+	TransactionId subxid;
+	int			len;
+
+	Assert(sxact != NULL);
+
+	subxid = pq_getmsgint(s, 4);
+
+	/* remember where the changes of a new subtransaction start */
+	if (subxid != sxact->xid)
+	{
+		int			i;
+
+		for (i = sxact->nsubxacts - 1; i >= 0; i--)
+		{
+			if (sxact->subxacts[i].xid == subxid)
+				break;
+		}
+
+		if (i < 0)
+		{
+			StreamSubXact *subxact;
+
+			if (sxact->nsubxacts >= sxact->maxsubxacts)
+			{
+				MemoryContext oldctx = MemoryContextSwitchTo(ApplyContext);
+
+				if (sxact->maxsubxacts == 0)
+				{
+					sxact->maxsubxacts = 16;
+					sxact->subxacts = palloc(sizeof(StreamSubXact) *
+											 sxact->maxsubxacts);
+				}
+				else
+				{
+					sxact->maxsubxacts *= 2;
+					sxact->subxacts = repalloc(sxact->subxacts,
+											   sizeof(StreamSubXact) *
+											   sxact->maxsubxacts);
+				}
+				MemoryContextSwitchTo(oldctx);
+			}
+
+			subxact = &sxact->subxacts[sxact->nsubxacts++];
+			subxact->xid = subxid;
+			BufFileTell(sxact->file, &subxact->fileno, &subxact->offset);
+			subxact->nchanges = sxact->nchanges;
+		}
+	}
+
+	/* the length doesn't include itself */
+	len = (s->len - s->cursor) + sizeof(char);
+
+	if (BufFileWrite(sxact->file, &len, sizeof(len)) != sizeof(len) ||
+		BufFileWrite(sxact->file, &action, sizeof(action)) != sizeof(action) ||
+		BufFileWrite(sxact->file, &s->data[s->cursor], len - sizeof(char)) !=
+		len - sizeof(char))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not write to changes file of streamed transaction %u: %m",
+						sxact->xid)));
+
+	sxact->nchanges++;
+}
+
+/*
+ * Handle STREAM START message: a block of changes of an in-progress
+ * transaction follows.
+ */
+static void
+apply_handle_stream_start(StringInfo s)
+{
+	TransactionId xid;
+	bool		first_segment;
+	StreamXact *sxact;
+
+	if (in_remote_transaction || stream_xact != NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROTOCOL_VIOLATION),
+				 errmsg("STREAM START message sent out of order")));
+
+	xid = logicalrep_read_stream_start(s, &first_segment);
+
+	/*
+	 * The first block starts the transaction from scratch, e.g. when the
+	 * publisher decodes it again after a reconnect.
+	 */
+	sxact = stream_xact_lookup(xid);
+	if (sxact != NULL && first_segment)
+	{
+		stream_xact_discard(sxact);
+		sxact = NULL;
+	}
+
+	if (sxact == NULL)
+	{
+		MemoryContext oldctx;
+
+		if (!first_segment)
+			ereport(ERROR,
+					(errcode(ERRCODE_PROTOCOL_VIOLATION),
+					 errmsg("received changes of unknown streamed transaction %u",
+							xid)));
+
+		oldctx = MemoryContextSwitchTo(ApplyContext);
+		sxact = palloc0(sizeof(StreamXact));
+		sxact->xid = xid;
+		sxact->file = BufFileCreateTemp(true);
+		stream_xacts = lappend(stream_xacts, sxact);
+		MemoryContextSwitchTo(oldctx);
+	}
+
+	stream_xact = sxact;
+}
+
+/*
+ * Handle STREAM STOP message.
+ */
+static void
+apply_handle_stream_stop(StringInfo s)
+{
+	if (stream_xact == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROTOCOL_VIOLATION),
+				 errmsg("STREAM STOP message sent out of order")));
+
+	stream_xact = NULL;
+}
+
+/*
+ * Handle STREAM ABORT message: throw away the changes of the streamed
+ * transaction, or of the aborted subtransaction and those after it, which
+ * must be subtransactions of it.
+ */
+static void
+apply_handle_stream_abort(StringInfo s)
+{
+	TransactionId xid;
+	TransactionId subxid;
+	StreamXact *sxact;
+	int			i;
+
+	if (stream_xact != NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROTOCOL_VIOLATION),
+				 errmsg("STREAM ABORT message sent out of order")));
+
+	logicalrep_read_stream_abort(s, &xid, &subxid);
+
+	sxact = stream_xact_lookup(xid);
+	if (sxact == NULL)
+		return;
+
+	if (subxid == xid)
+	{
+		stream_xact_discard(sxact);
+		return;
+	}
+
+	for (i = sxact->nsubxacts - 1; i >= 0; i--)
+	{
+		StreamSubXact *subxact = &sxact->subxacts[i];
+
+		if (subxact->xid == subxid)
+		{
+			if (BufFileSeek(sxact->file, subxact->fileno, subxact->offset,
+							SEEK_SET) != 0)
+				ereport(ERROR,
+						(errcode_for_file_access(),
+						 errmsg("could not seek in changes file of streamed transaction %u: %m",
+								xid)));
+			sxact->nchanges = subxact->nchanges;
+			sxact->nsubxacts = i;
+			break;
+		}
+	}
+}
+
+/*
+ * Handle STREAM COMMIT message: apply all the changes spooled for the
+ * streamed transaction, and commit it.
+ */
+static void
+apply_handle_stream_commit(StringInfo s)
+{
+	TransactionId xid;
+	LogicalRepCommitData commit_data;
+	StreamXact *sxact;
+	StringInfoData change;
+	MemoryContext oldctx;
+	int			i;
+
+	if (in_remote_transaction || stream_xact != NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROTOCOL_VIOLATION),
+				 errmsg("STREAM COMMIT message sent out of order")));
+
+	xid = logicalrep_read_stream_commit(s, &commit_data);
+
+	sxact = stream_xact_lookup(xid);
+	if (sxact == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROTOCOL_VIOLATION),
+				 errmsg("received commit of unknown streamed transaction %u",
+						xid)));
+
+	/* the same as BEGIN */
+	remote_final_lsn = commit_data.commit_lsn;
+	in_remote_transaction = true;
+	pgstat_report_activity(STATE_RUNNING, NULL);
+
+	oldctx = MemoryContextSwitchTo(ApplyContext);
+	initStringInfo(&change);
+	MemoryContextSwitchTo(oldctx);
+
+	if (BufFileSeek(sxact->file, 0, 0, SEEK_SET) != 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not seek in changes file of streamed transaction %u: %m",
+						xid)));
+
+	for (i = 0; i < sxact->nchanges; i++)
+	{
+		int			len;
+
+		CHECK_FOR_INTERRUPTS();
+
+		if (BufFileRead(sxact->file, &len, sizeof(len)) != sizeof(len))
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not read from changes file of streamed transaction %u: %m",
+							xid)));
+
+		resetStringInfo(&change);
+		enlargeStringInfo(&change, len);
+
+		if (BufFileRead(sxact->file, change.data, len) != len)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not read from changes file of streamed transaction %u: %m",
+							xid)));
+		change.len = len;
+		change.cursor = 0;
+
+		apply_dispatch(&change);
+
+		MemoryContextReset(ApplyMessageContext);
+	}
+
+	pfree(change.data);
+	stream_xact_discard(sxact);
+
+	apply_commit(&commit_data);
+}
+
 /*
  * Handle RELATION message.
  *
@@ -618,7 +1029,7 @@ apply_handle_insert(StringInfo s)
 
 	/* Process and store remote tuple in the slot */
 	oldctx = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
-	slot_store_cstrings(remoteslot, rel, newtup.values);
+	slot_store_data(remoteslot, rel, &newtup);
 	slot_fill_defaults(rel, estate, remoteslot);
 	MemoryContextSwitchTo(oldctx);
 
@@ -729,8 +1140,7 @@ apply_handle_update(StringInfo s)
 
 	/* Build the search tuple. */
 	oldctx = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
-	slot_store_cstrings(remoteslot, rel,
-						has_oldtup ? oldtup.values : newtup.values);
+	slot_store_data(remoteslot, rel, has_oldtup ? &oldtup : &newtup);
 	MemoryContextSwitchTo(oldctx);
 
 	/*
@@ -761,7 +1171,7 @@ apply_handle_update(StringInfo s)
 		/* Process and store remote tuple in the slot */
 		oldctx = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
 		ExecCopySlot(remoteslot, localslot);
-		slot_modify_cstrings(remoteslot, rel, newtup.values, newtup.changed);
+		slot_modify_data(remoteslot, rel, &newtup);
 		MemoryContextSwitchTo(oldctx);
 
 		EvalPlanQualSetSlot(&epqstate, remoteslot);
@@ -849,7 +1259,7 @@ apply_handle_delete(StringInfo s)
 
 	/* Find the tuple using the replica identity index. */
 	oldctx = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
-	slot_store_cstrings(remoteslot, rel, oldtup.values);
+	slot_store_data(remoteslot, rel, &oldtup);
 	MemoryContextSwitchTo(oldctx);
 
 	/*
@@ -965,11 +1375,32 @@ apply_handle_truncate(StringInfo s)
 /*
  * Logical replication protocol message dispatcher.
  */
-static void
+void
 apply_dispatch(StringInfo s)
 {
 	char		action = pq_getmsgbyte(s);
 
+	/*
+	 * Within a block of changes of a streamed transaction, spool the changes
+	 * instead of applying them.
+	 */
+	if (stream_xact != NULL)
+	{
+		switch (action)
+		{
+			case 'I':
+			case 'U':
+			case 'D':
+			case 'T':
+			case 'R':
+			case 'Y':
+				stream_write_change(action, s);
+				return;
+			default:
+				break;
+		}
+	}
+
 	switch (action)
 	{
 			/* BEGIN */
@@ -1008,6 +1439,22 @@ apply_dispatch(StringInfo s)
 		case 'O':
 			apply_handle_origin(s);
 			break;
+			/* STREAM START */
+		case 'S':
+			apply_handle_stream_start(s);
+			break;
+			/* STREAM STOP */
+		case 'E':
+			apply_handle_stream_stop(s);
+			break;
+			/* STREAM ABORT */
+		case 'A':
+			apply_handle_stream_abort(s);
+			break;
+			/* STREAM COMMIT */
+		case 'c':
+			apply_handle_stream_commit(s);
+			break;
 		default:
 			ereport(ERROR,
 					(errcode(ERRCODE_PROTOCOL_VIOLATION),
@@ -1033,7 +1480,12 @@ get_flush_position(XLogRecPtr *write, XLogRecPtr *flush,
 				   bool *have_pending_txes)
 {
 	dlist_mutable_iter iter;
-	XLogRecPtr	local_flush = GetFlushRecPtr();
+	XLogRecPtr	local_flush;
+
+	/* Add the transactions committed by parallel apply workers meanwhile. */
+	pa_collect_commits();
+
+	local_flush = GetFlushRecPtr();
 
 	*write = InvalidXLogRecPtr;
 	*flush = InvalidXLogRecPtr;
@@ -1066,14 +1518,18 @@ get_flush_position(XLogRecPtr *write, XLogRecPtr *flush,
 		}
 	}
 
-	*have_pending_txes = !dlist_is_empty(&lsn_mapping);
+	/*
+	 * Transactions still being applied in parallel are pending too, even if
+	 * we can't say where they will end locally yet.
+	 */
+	*have_pending_txes = !dlist_is_empty(&lsn_mapping) || pa_in_flight();
 }
 
 /*
- * Store current remote/local lsn pair in the tracking list.
+ * Store remote/local lsn pair of a commit in the tracking list.
  */
-static void
-store_flush_position(XLogRecPtr remote_lsn)
+void
+store_flush_position(XLogRecPtr remote_lsn, XLogRecPtr local_lsn)
 {
 	FlushPosition *flushpos;
 
@@ -1082,7 +1538,7 @@ store_flush_position(XLogRecPtr remote_lsn)
 
 	/* Track commit lsn  */
 	flushpos = (FlushPosition *) palloc(sizeof(FlushPosition));
-	flushpos->local_end = XactLastCommitEnd;
+	flushpos->local_end = local_lsn;
 	flushpos->remote_end = remote_lsn;
 
 	dlist_push_tail(&lsn_mapping, &flushpos->node);
@@ -1193,7 +1649,12 @@ LogicalRepApplyLoop(XLogRecPtr last_received)
 
 						UpdateWorkerStats(last_received, send_time, false);
 
-						apply_dispatch(&s);
+						/*
+						 * Hand it over to a parallel apply worker if we can,
+						 * except within blocks of a streamed transaction.
+						 */
+						if (stream_xact != NULL || !pa_dispatch(&s))
+							apply_dispatch(&s);
 					}
 					else if (c == 'k')
 					{
@@ -1233,8 +1694,12 @@ LogicalRepApplyLoop(XLogRecPtr last_received)
 			AcceptInvalidationMessages();
 			maybe_reread_subscription();
 
-			/* Process any table synchronization changes. */
-			process_syncing_tables(last_received);
+			/*
+			 * Process any table synchronization changes, unless parallel
+			 * apply workers are still busy with what we've received.
+			 */
+			if (!pa_in_flight())
+				process_syncing_tables(last_received);
 		}
 
 		/* Cleanup the memory. */
@@ -1257,7 +1722,7 @@ LogicalRepApplyLoop(XLogRecPtr last_received)
 		 * no particular urgency about waking up unless we get data or a
 		 * signal.
 		 */
-		if (!dlist_is_empty(&lsn_mapping))
+		if (!dlist_is_empty(&lsn_mapping) || pa_in_flight())
 			wait_time = WalWriterDelay;
 		else
 			wait_time = NAPTIME_PER_CYCLE;
@@ -1535,6 +2000,31 @@ maybe_reread_subscription(void)
 		proc_exit(0);
 	}
 
+	/*
+	 * Exit if the streaming option was changed, it's passed to the publisher
+	 * when connecting. The launcher will start new worker.
+	 */
+	if (newsub->stream != MySubscription->stream)
+	{
+		ereport(LOG,
+				(errmsg("logical replication apply worker for subscription \"%s\" will "
+						"restart because the streaming option was changed",
+						MySubscription->name)));
+
+		proc_exit(0);
+	}
+
+	/* Same for the binary option. */
+	if (newsub->binary != MySubscription->binary)
+	{
+		ereport(LOG,
+				(errmsg("logical replication apply worker for subscription \"%s\" will "
+						"restart because the binary option was changed",
+						MySubscription->name)));
+
+		proc_exit(0);
+	}
+
 	/* Check for other changes that should never happen too. */
 	if (newsub->dbid != MySubscription->dbid)
 	{
@@ -1581,47 +2071,17 @@ logicalrep_worker_sighup(SIGNAL_ARGS)
 	errno = save_errno;
 }
 
-/* Logical Replication Apply worker entry point */
+/*
+ * Initialization shared by apply workers of all kinds: load the subscription
+ * into persistent memory context, and keep track of changes to it.
+ *
+ * The caller must have connected to the database already.
+ */
 void
-ApplyWorkerMain(Datum main_arg)
+InitializeApplyWorker(void)
 {
-	int			worker_slot = DatumGetInt32(main_arg);
 	MemoryContext oldctx;
-	char		originname[NAMEDATALEN];
-	XLogRecPtr	origin_startpos;
-	char	   *myslotname;
-	WalRcvStreamOptions options;
-
-	/* Attach to slot */
-	logicalrep_worker_attach(worker_slot);
-
-	/* Setup signal handling */
-	pqsignal(SIGHUP, logicalrep_worker_sighup);
-	pqsignal(SIGTERM, die);
-	BackgroundWorkerUnblockSignals();
-
-	/*
-	 * We don't currently need any ResourceOwner in a walreceiver process, but
-	 * if we did, we could call CreateAuxProcessResourceOwner here.
-	 */
 
-	/* Initialise stats to a sanish value */
-	MyLogicalRepWorker->last_send_time = MyLogicalRepWorker->last_recv_time =
-		MyLogicalRepWorker->reply_time = GetCurrentTimestamp();
-
-	/* Load the libpq-specific functions */
-	load_file("libpqwalreceiver", false);
-
-	/* Run as replica session replication role. */
-	SetConfigOption("session_replication_role", "replica",
-					PGC_SUSET, PGC_S_OVERRIDE);
-
-	/* Connect to our database. */
-	BackgroundWorkerInitializeConnectionByOid(MyLogicalRepWorker->dbid,
-											  MyLogicalRepWorker->userid,
-											  0);
-
-	/* Load the subscription into persistent memory context. */
 	ApplyContext = AllocSetContextCreate(TopMemoryContext,
 										 "ApplyContext",
 										 ALLOCSET_DEFAULT_SIZES);
@@ -1664,12 +2124,60 @@ ApplyWorkerMain(Datum main_arg)
 		ereport(LOG,
 				(errmsg("logical replication table synchronization worker for subscription \"%s\", table \"%s\" has started",
 						MySubscription->name, get_rel_name(MyLogicalRepWorker->relid))));
+	else if (am_parallel_apply_worker())
+		ereport(LOG,
+				(errmsg("logical replication parallel apply worker for subscription \"%s\" has started",
+						MySubscription->name)));
 	else
 		ereport(LOG,
 				(errmsg("logical replication apply worker for subscription \"%s\" has started",
 						MySubscription->name)));
 
 	CommitTransactionCommand();
+}
+
+/* Logical Replication Apply worker entry point */
+void
+ApplyWorkerMain(Datum main_arg)
+{
+	int			worker_slot = DatumGetInt32(main_arg);
+	MemoryContext oldctx;
+	char		originname[NAMEDATALEN];
+	XLogRecPtr	origin_startpos;
+	char	   *myslotname;
+	WalRcvStreamOptions options;
+
+	/* Attach to slot */
+	logicalrep_worker_attach(worker_slot);
+
+	/* Setup signal handling */
+	pqsignal(SIGHUP, logicalrep_worker_sighup);
+	pqsignal(SIGTERM, die);
+	BackgroundWorkerUnblockSignals();
+
+	/*
+	 * We don't currently need any ResourceOwner in a walreceiver process, but
+	 * if we did, we could call CreateAuxProcessResourceOwner here.
+	 */
+
+	/* Initialise stats to a sanish value */
+	MyLogicalRepWorker->last_send_time = MyLogicalRepWorker->last_recv_time =
+		MyLogicalRepWorker->reply_time = GetCurrentTimestamp();
+
+	/* Load the libpq-specific functions */
+	load_file("libpqwalreceiver", false);
+
+	/* Run as replica session replication role. */
+	SetConfigOption("session_replication_role", "replica",
+					PGC_SUSET, PGC_S_OVERRIDE);
+
+	/* Connect to our database. */
+	BackgroundWorkerInitializeConnectionByOid(MyLogicalRepWorker->dbid,
+											  MyLogicalRepWorker->userid,
+											  0);
+
+	/* Load the subscription. */
+	InitializeApplyWorker();
 
 	/* Connect to the origin and start the replication. */
 	elog(DEBUG1, "connecting to publisher using connection string \"%s\"",
@@ -1714,7 +2222,7 @@ ApplyWorkerMain(Datum main_arg)
 		originid = replorigin_by_name(originname, true);
 		if (!OidIsValid(originid))
 			originid = replorigin_create(originname);
-		replorigin_session_setup(originid);
+		replorigin_session_setup(originid, 0);
 		replorigin_session_origin = originid;
 		origin_startpos = replorigin_session_get_progress(false);
 		CommitTransactionCommand();
@@ -1746,8 +2254,13 @@ ApplyWorkerMain(Datum main_arg)
 	options.logical = true;
 	options.startpoint = origin_startpos;
 	options.slotname = myslotname;
-	options.proto.logical.proto_version = LOGICALREP_PROTO_VERSION_NUM;
 	options.proto.logical.publication_names = MySubscription->publications;
+	options.proto.logical.streaming = MySubscription->stream;
+	options.proto.logical.binary = MySubscription->binary;
+
+	/* Stick to the original protocol unless we need the newer one */
+	options.proto.logical.proto_version = MySubscription->stream ?
+		LOGICALREP_PROTO_STREAM_VERSION_NUM : LOGICALREP_PROTO_MIN_VERSION_NUM;
 
 	/* Start normal logical streaming replication. */
 	walrcv_startstreaming(wrconn, &options);
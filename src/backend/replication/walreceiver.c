@@ -65,6 +65,7 @@
 #include "storage/procarray.h"
 #include "utils/builtins.h"
 #include "utils/guc.h"
+#include "utils/memutils.h"
 #include "utils/pg_lsn.h"
 #include "utils/ps_status.h"
 #include "utils/resowner.h"
@@ -75,6 +76,8 @@
 int			wal_receiver_status_interval;
 int			wal_receiver_timeout;
 bool		hot_standby_feedback;
+bool		hot_standby_feedback_per_database;
+int			wal_receiver_compression = REPL_COMPRESSION_NONE;
 
 /* libpqwalreceiver connection */
 static WalReceiverConn *wrconn = NULL;
@@ -112,6 +115,14 @@ static struct
 static StringInfoData reply_message;
 static StringInfoData incoming_message;
 
+/*
+ * Compression asked of the primary for the current stream, and the buffer to
+ * decompress compressed XLogData messages in.
+ */
+static ReplCompressionMethod streamCompression = REPL_COMPRESSION_NONE;
+static char *decompressBuf = NULL;
+static int32 decompressBufSize = 0;
+
 /*
  * About SIGTERM handling:
  *
@@ -389,6 +400,8 @@ WalReceiverMain(void)
 		options.startpoint = startpoint;
 		options.slotname = slotname[0] != '\0' ? slotname : NULL;
 		options.proto.physical.startpointTLI = startpointTLI;
+		options.proto.physical.compression = streamCompression =
+			(ReplCompressionMethod) wal_receiver_compression;
 		ThisTimeLineID = startpointTLI;
 		if (walrcv_startstreaming(wrconn, &options))
 		{
@@ -888,6 +901,49 @@ XLogWalRcvProcessMsg(unsigned char type, char *buf, Size len)
 				XLogWalRcvWrite(buf, len, dataStart);
 				break;
 			}
+		case 'z':				/* compressed WAL records */
+			{
+				int32		rawlen;
+
+				/* copy message to StringInfo */
+				hdrlen = sizeof(int64) + sizeof(int64) + sizeof(int64) +
+					sizeof(int32);
+				if (len < hdrlen || streamCompression == REPL_COMPRESSION_NONE)
+					ereport(ERROR,
+							(errcode(ERRCODE_PROTOCOL_VIOLATION),
+							 errmsg_internal("invalid WAL message received from primary")));
+				appendBinaryStringInfo(&incoming_message, buf, hdrlen);
+
+				/* read the fields */
+				dataStart = pq_getmsgint64(&incoming_message);
+				walEnd = pq_getmsgint64(&incoming_message);
+				sendTime = pq_getmsgint64(&incoming_message);
+				rawlen = pq_getmsgint(&incoming_message, 4);
+				ProcessWalSndrMessage(walEnd, sendTime);
+
+				if (rawlen <= 0 || rawlen > MaxAllocSize)
+					ereport(ERROR,
+							(errcode(ERRCODE_PROTOCOL_VIOLATION),
+							 errmsg_internal("invalid WAL message received from primary")));
+
+				if (rawlen > decompressBufSize)
+				{
+					if (decompressBuf)
+						pfree(decompressBuf);
+					decompressBuf = MemoryContextAlloc(TopMemoryContext, rawlen);
+					decompressBufSize = rawlen;
+				}
+
+				buf += hdrlen;
+				len -= hdrlen;
+				if (repl_decompress(streamCompression, buf, len,
+									decompressBuf, rawlen) < 0)
+					ereport(ERROR,
+							(errcode(ERRCODE_DATA_CORRUPTED),
+							 errmsg("could not decompress WAL data received from primary")));
+				XLogWalRcvWrite(decompressBuf, rawlen, dataStart);
+				break;
+			}
 		case 'k':				/* Keepalive */
 			{
 				/* copy message to StringInfo */
@@ -1167,6 +1223,7 @@ XLogWalRcvSendHSFeedback(bool immed)
 				catalog_xmin_epoch;
 	TransactionId xmin,
 				catalog_xmin;
+	Oid			xmin_dbid = InvalidOid;
 	static TimestampTz sendTime = 0;
 
 	/* initially true so we always send at least one feedback message */
@@ -1229,6 +1286,17 @@ XLogWalRcvSendHSFeedback(bool immed)
 		if (TransactionIdIsValid(slot_xmin) &&
 			TransactionIdPrecedes(slot_xmin, xmin))
 			xmin = slot_xmin;
+
+		/*
+		 * If all the queries holding back our xmin run in one database, tell
+		 * the master so that it only needs to apply our xmin there.  Slots
+		 * on this server may serve other databases, so they keep the
+		 * feedback global.
+		 */
+		if (hot_standby_feedback_per_database &&
+			!TransactionIdIsValid(slot_xmin) &&
+			!TransactionIdIsValid(catalog_xmin))
+			xmin_dbid = GetOldestXminDatabaseId();
 	}
 	else
 	{
@@ -1247,8 +1315,8 @@ XLogWalRcvSendHSFeedback(bool immed)
 	if (nextXid < catalog_xmin)
 		catalog_xmin_epoch--;
 
-	elog(DEBUG2, "sending hot standby feedback xmin %u epoch %u catalog_xmin %u catalog_xmin_epoch %u",
-		 xmin, xmin_epoch, catalog_xmin, catalog_xmin_epoch);
+	elog(DEBUG2, "sending hot standby feedback xmin %u epoch %u catalog_xmin %u catalog_xmin_epoch %u database %u",
+		 xmin, xmin_epoch, catalog_xmin, catalog_xmin_epoch, xmin_dbid);
 
 	/* Construct the message and send it. */
 	resetStringInfo(&reply_message);
@@ -1258,6 +1326,7 @@ XLogWalRcvSendHSFeedback(bool immed)
 	pq_sendint32(&reply_message, xmin_epoch);
 	pq_sendint32(&reply_message, catalog_xmin);
 	pq_sendint32(&reply_message, catalog_xmin_epoch);
+	pq_sendint32(&reply_message, xmin_dbid);
 	walrcv_send(wrconn, reply_message.data, reply_message.len);
 	if (TransactionIdIsValid(xmin) || TransactionIdIsValid(catalog_xmin))
 		master_has_standby_xmin = true;
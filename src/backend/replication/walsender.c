@@ -60,6 +60,7 @@
 #include "catalog/pg_type.h"
 #include "commands/dbcommands.h"
 #include "commands/defrem.h"
+#include "common/replcompress.h"
 #include "funcapi.h"
 #include "libpq/libpq.h"
 #include "libpq/pqformat.h"
@@ -161,6 +162,13 @@ static StringInfoData output_message;
 static StringInfoData reply_message;
 static StringInfoData tmpbuf;
 
+/*
+ * Compression of XLogData messages asked for with the "compression" option
+ * of START_REPLICATION, and the buffer to compress them in.
+ */
+static ReplCompressionMethod sendCompression = REPL_COMPRESSION_NONE;
+static char *compressBuf = NULL;
+
 /* Timestamp of last ProcessRepliesIfAny(). */
 static TimestampTz last_processing = 0;
 
@@ -537,12 +545,50 @@ StartReplication(StartReplicationCmd *cmd)
 {
 	StringInfoData buf;
 	XLogRecPtr	FlushPtr;
+	ListCell   *lc;
 
 	if (ThisTimeLineID == 0)
 		ereport(ERROR,
 				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
 				 errmsg("IDENTIFY_SYSTEM has not been run before START_REPLICATION")));
 
+	sendCompression = REPL_COMPRESSION_NONE;
+	foreach(lc, cmd->options)
+	{
+		DefElem    *defel = (DefElem *) lfirst(lc);
+
+		if (strcmp(defel->defname, "compression") == 0)
+		{
+			char	   *method = defGetString(defel);
+
+			if (!repl_compression_parse(method, &sendCompression))
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+						 errmsg("unrecognized compression method \"%s\"",
+								method)));
+			if (!repl_compression_supported(sendCompression))
+				ereport(ERROR,
+						(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+						 errmsg("compression method \"%s\" is not supported by this build",
+								method)));
+		}
+		else
+			ereport(ERROR,
+					(errcode(ERRCODE_SYNTAX_ERROR),
+					 errmsg("unrecognized option \"%s\" for START_REPLICATION",
+							defel->defname)));
+	}
+
+	if (sendCompression != REPL_COMPRESSION_NONE && compressBuf == NULL)
+		compressBuf = MemoryContextAlloc(TopMemoryContext,
+										 REPL_COMPRESS_BOUND(MAX_SEND_SIZE));
+
+	SpinLockAcquire(&MyWalSnd->mutex);
+	MyWalSnd->compression = sendCompression;
+	MyWalSnd->rawBytes = 0;
+	MyWalSnd->wireBytes = 0;
+	SpinLockRelease(&MyWalSnd->mutex);
+
 	/*
 	 * We assume here that we're logging enough information in the WAL for
 	 * log-shipping, since this is checked in PostmasterMain().
@@ -1940,6 +1986,7 @@ ProcessStandbyHSFeedbackMessage(void)
 	uint32		feedbackEpoch;
 	TransactionId feedbackCatalogXmin;
 	uint32		feedbackCatalogEpoch;
+	Oid			feedbackDatabaseId = InvalidOid;
 	TimestampTz replyTime;
 
 	/*
@@ -1953,6 +2000,10 @@ ProcessStandbyHSFeedbackMessage(void)
 	feedbackCatalogXmin = pq_getmsgint(&reply_message, 4);
 	feedbackCatalogEpoch = pq_getmsgint(&reply_message, 4);
 
+	/* Standbys older than v12 don't send the database field */
+	if (reply_message.cursor < reply_message.len)
+		feedbackDatabaseId = pq_getmsgint(&reply_message, 4);
+
 	if (log_min_messages <= DEBUG2)
 	{
 		char	   *replyTimeStr;
@@ -1960,11 +2011,12 @@ ProcessStandbyHSFeedbackMessage(void)
 		/* Copy because timestamptz_to_str returns a static buffer */
 		replyTimeStr = pstrdup(timestamptz_to_str(replyTime));
 
-		elog(DEBUG2, "hot standby feedback xmin %u epoch %u, catalog_xmin %u epoch %u reply_time %s",
+		elog(DEBUG2, "hot standby feedback xmin %u epoch %u, catalog_xmin %u epoch %u database %u reply_time %s",
 			 feedbackXmin,
 			 feedbackEpoch,
 			 feedbackCatalogXmin,
 			 feedbackCatalogEpoch,
+			 feedbackDatabaseId,
 			 replyTimeStr);
 
 		pfree(replyTimeStr);
@@ -1990,6 +2042,7 @@ ProcessStandbyHSFeedbackMessage(void)
 		&& !TransactionIdIsNormal(feedbackCatalogXmin))
 	{
 		MyPgXact->xmin = InvalidTransactionId;
+		MyProc->xminDatabaseId = InvalidOid;
 		if (MyReplicationSlot != NULL)
 			PhysicalReplicationSlotNewXmin(feedbackXmin, feedbackCatalogXmin);
 		return;
@@ -2036,16 +2089,41 @@ ProcessStandbyHSFeedbackMessage(void)
 	 *
 	 * XXX: It might make sense to generalize the ephemeral slot concept and
 	 * always use the slot mechanism to handle the feedback xmin.
+	 *
+	 * Without a slot, the standby may also have told us that only queries in
+	 * one database need protecting, in which case GetOldestXmin ignores our
+	 * xmin when computing the horizon for other databases.  Slot xmins are
+	 * always global.  While switching the database, clear it before moving
+	 * the xmin, so that a concurrent GetOldestXmin never applies the new
+	 * xmin to only the old database.
 	 */
 	if (MyReplicationSlot != NULL)	/* XXX: persistency configurable? */
+	{
+		MyProc->xminDatabaseId = InvalidOid;
 		PhysicalReplicationSlotNewXmin(feedbackXmin, feedbackCatalogXmin);
+	}
 	else
 	{
+		if (TransactionIdIsNormal(feedbackCatalogXmin))
+			feedbackDatabaseId = InvalidOid;
+
+		if (MyProc->xminDatabaseId != feedbackDatabaseId)
+		{
+			MyProc->xminDatabaseId = InvalidOid;
+			pg_write_barrier();
+		}
+
 		if (TransactionIdIsNormal(feedbackCatalogXmin)
 			&& TransactionIdPrecedes(feedbackCatalogXmin, feedbackXmin))
 			MyPgXact->xmin = feedbackCatalogXmin;
 		else
 			MyPgXact->xmin = feedbackXmin;
+
+		if (OidIsValid(feedbackDatabaseId))
+		{
+			pg_write_barrier();
+			MyProc->xminDatabaseId = feedbackDatabaseId;
+		}
 	}
 }
 
@@ -2303,6 +2381,9 @@ InitWalSenderSlot(void)
 			walsnd->state = WALSNDSTATE_STARTUP;
 			walsnd->latch = &MyProc->procLatch;
 			walsnd->replyTime = 0;
+			walsnd->compression = REPL_COMPRESSION_NONE;
+			walsnd->rawBytes = 0;
+			walsnd->wireBytes = 0;
 			SpinLockRelease(&walsnd->mutex);
 			/* don't need the lock anymore */
 			MyWalSnd = (WalSnd *) walsnd;
@@ -2540,6 +2621,7 @@ XLogSendPhysical(void)
 	XLogRecPtr	startptr;
 	XLogRecPtr	endptr;
 	Size		nbytes;
+	Size		wirebytes;
 
 	/* If requested switch the WAL sender to the stopping state. */
 	if (got_STOPPING)
@@ -2759,6 +2841,31 @@ XLogSendPhysical(void)
 	output_message.len += nbytes;
 	output_message.data[output_message.len] = '\0';
 
+	/*
+	 * If the standby asked for compression, replace the data with its
+	 * compressed form and turn the message into a compressed XLogData
+	 * message, which has the uncompressed length between the header and the
+	 * data.  Data that doesn't compress is sent as it is.
+	 */
+	wirebytes = nbytes;
+	if (sendCompression != REPL_COMPRESSION_NONE)
+	{
+		int			hdrlen = 1 + sizeof(int64) * 3;
+		int32		clen;
+
+		clen = repl_compress(sendCompression,
+							 &output_message.data[hdrlen], nbytes,
+							 compressBuf);
+		if (clen >= 0)
+		{
+			output_message.data[0] = 'z';
+			output_message.len = hdrlen;
+			pq_sendint32(&output_message, nbytes);
+			pq_sendbytes(&output_message, compressBuf, clen);
+			wirebytes = sizeof(int32) + clen;
+		}
+	}
+
 	/*
 	 * Fill the send timestamp last, so that it is taken as late as possible.
 	 */
@@ -2777,6 +2884,8 @@ XLogSendPhysical(void)
 
 		SpinLockAcquire(&walsnd->mutex);
 		walsnd->sentPtr = sentPtr;
+		walsnd->rawBytes += nbytes;
+		walsnd->wireBytes += wirebytes;
 		SpinLockRelease(&walsnd->mutex);
 	}
 
@@ -3217,7 +3326,7 @@ offset_to_interval(TimeOffset offset)
 Datum
 pg_stat_get_wal_senders(PG_FUNCTION_ARGS)
 {
-#define PG_STAT_GET_WAL_SENDERS_COLS	12
+#define PG_STAT_GET_WAL_SENDERS_COLS	14
 	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
 	TupleDesc	tupdesc;
 	Tuplestorestate *tupstore;
@@ -3272,6 +3381,9 @@ pg_stat_get_wal_senders(PG_FUNCTION_ARGS)
 		int			pid;
 		WalSndState state;
 		TimestampTz replyTime;
+		ReplCompressionMethod compression;
+		uint64		rawBytes;
+		uint64		wireBytes;
 		Datum		values[PG_STAT_GET_WAL_SENDERS_COLS];
 		bool		nulls[PG_STAT_GET_WAL_SENDERS_COLS];
 
@@ -3292,6 +3404,9 @@ pg_stat_get_wal_senders(PG_FUNCTION_ARGS)
 		applyLag = walsnd->applyLag;
 		priority = walsnd->sync_standby_priority;
 		replyTime = walsnd->replyTime;
+		compression = walsnd->compression;
+		rawBytes = walsnd->rawBytes;
+		wireBytes = walsnd->wireBytes;
 		SpinLockRelease(&walsnd->mutex);
 
 		memset(nulls, 0, sizeof(nulls));
@@ -3373,6 +3488,24 @@ pg_stat_get_wal_senders(PG_FUNCTION_ARGS)
 				nulls[11] = true;
 			else
 				values[11] = TimestampTzGetDatum(replyTime);
+
+			if (compression == REPL_COMPRESSION_NONE)
+			{
+				nulls[12] = true;
+				nulls[13] = true;
+			}
+			else
+			{
+				values[12] =
+					CStringGetTextDatum(repl_compression_name(compression));
+
+				/* ratio of WAL streamed to bytes sent for it */
+				if (wireBytes == 0)
+					nulls[13] = true;
+				else
+					values[13] = Float8GetDatum((double) rawBytes /
+												(double) wireBytes);
+			}
 		}
 
 		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
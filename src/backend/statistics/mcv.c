@@ -0,0 +1,1182 @@
+/*-------------------------------------------------------------------------
+ *
+ * mcv.c
+ *	  POSTGRES multivariate MCV lists
+ *
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/statistics/mcv.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <math.h>
+
+#include "access/htup_details.h"
+#include "catalog/pg_statistic_ext.h"
+#include "fmgr.h"
+#include "lib/stringinfo.h"
+#include "nodes/nodeFuncs.h"
+#include "optimizer/clauses.h"
+#include "optimizer/cost.h"
+#include "statistics/extended_stats_internal.h"
+#include "statistics/statistics.h"
+#include "utils/builtins.h"
+#include "utils/bytea.h"
+#include "utils/fmgroids.h"
+#include "utils/fmgrprotos.h"
+#include "utils/lsyscache.h"
+#include "utils/selfuncs.h"
+#include "utils/syscache.h"
+#include "utils/typcache.h"
+
+/*
+ * A group of identical rows in the sorted sample, i.e. a candidate MCV item.
+ * 'first' is the index of the first row of the group in the sorted array.
+ */
+typedef struct MCVGroup
+{
+	int			first;			/* index of the first row in the group */
+	int			count;			/* number of rows in the group */
+} MCVGroup;
+
+/* sort support for ordering the candidate groups */
+typedef struct MCVGroupSortContext
+{
+	SortItem   *items;			/* sorted sample rows */
+	MultiSortSupport mss;		/* multi-column sort support */
+} MCVGroupSortContext;
+
+/*
+ * A clause that is evaluated against the MCV items, pre-processed so that
+ * we don't have to look at the expression tree for each item.
+ */
+typedef struct MCVClause
+{
+	int			dim;			/* index of the attribute in the MCV items */
+	bool		isnulltest;		/* NullTest (otherwise an OpExpr) */
+	NullTestType nulltesttype;	/* IS NULL / IS NOT NULL */
+	FmgrInfo	opproc;			/* operator function */
+	Oid			collid;			/* collation to use for the operator */
+	Datum		constvalue;		/* value of the Const argument */
+	bool		constisnull;	/* is the Const NULL? */
+	bool		varonleft;		/* is the Var the left argument? */
+} MCVClause;
+
+static double get_mincount_for_mcv_list(int samplerows, double totalrows);
+static int	compare_mcv_groups(const void *a, const void *b, void *arg);
+static int	compare_scalar_items(const void *a, const void *b, void *arg);
+static void compute_base_frequencies(int numrows, SortItem *items,
+						 int numattrs, MultiSortSupport mss,
+						 double *basefreqs);
+static bool mcv_opclause_args(OpExpr *expr, Var **var, Const **cst,
+				  bool *varonleft);
+static bool mcv_is_compatible_clause(Node *clause, Index relid,
+						 AttrNumber *attnum);
+static int	mcv_attnum_index(Bitmapset *keys, AttrNumber attnum);
+
+/*
+ * get_mincount_for_mcv_list
+ *		Determine the minimum number of times a combination needs to appear
+ *		in the sample for it to be included in the MCV list.
+ *
+ * We want to keep only combinations that appear sufficiently often in the
+ * sample that it is reasonable to extrapolate their sample frequencies to
+ * the entire table.  We do this by placing an upper bound (20%) on the
+ * relative standard error of the sample frequency, which for sampling
+ * without replacement gives
+ *
+ *	   n * (N - n) / (N - n + 0.04 * n * (N - 1))
+ *
+ * When the whole table was sampled (n = N) this is zero, so every group that
+ * fits into the list is kept.
+ *
+ * We can't reuse analyze_mcv_list() here, because that compares the items
+ * with the average frequency of the non-MCV values, which says nothing about
+ * how far the combination is from its base frequency.
+ */
+static double
+get_mincount_for_mcv_list(int samplerows, double totalrows)
+{
+	double		n = samplerows;
+	double		N = totalrows;
+	double		numer,
+				denom;
+
+	numer = n * (N - n);
+	denom = N - n + 0.04 * n * (N - 1);
+
+	/* Guard against division by zero (possible if n = N = 1) */
+	if (denom == 0.0)
+		return 0.0;
+
+	return numer / denom;
+}
+
+/*
+ * compare_mcv_groups
+ *		Order groups by decreasing count; ties are broken by the values, so
+ *		that the result does not depend on the qsort implementation.
+ */
+static int
+compare_mcv_groups(const void *a, const void *b, void *arg)
+{
+	const MCVGroup *ga = (const MCVGroup *) a;
+	const MCVGroup *gb = (const MCVGroup *) b;
+	MCVGroupSortContext *cxt = (MCVGroupSortContext *) arg;
+
+	if (ga->count > gb->count)
+		return -1;
+	if (ga->count < gb->count)
+		return 1;
+
+	return multi_sort_compare(&cxt->items[ga->first], &cxt->items[gb->first],
+							  cxt->mss);
+}
+
+/* compare two ScalarItems using the given sort support */
+static int
+compare_scalar_items(const void *a, const void *b, void *arg)
+{
+	const ScalarItem *ia = (const ScalarItem *) a;
+	const ScalarItem *ib = (const ScalarItem *) b;
+
+	return ApplySortComparator(ia->value, false, ib->value, false,
+							   (SortSupport) arg);
+}
+
+/*
+ * compute_base_frequencies
+ *		Compute for each (sorted) sample row the product of the per-column
+ *		frequencies of its values, i.e. the frequency the combination would
+ *		have if the columns were independent.
+ *
+ * For each column we sort the non-NULL values, and assign the size of each
+ * group of equal values to all rows in that group.  NULL values are counted
+ * as a separate group.
+ */
+static void
+compute_base_frequencies(int numrows, SortItem *items, int numattrs,
+						 MultiSortSupport mss, double *basefreqs)
+{
+	int			i,
+				j;
+	ScalarItem *values;
+
+	values = (ScalarItem *) palloc(numrows * sizeof(ScalarItem));
+
+	for (i = 0; i < numrows; i++)
+		basefreqs[i] = 1.0;
+
+	for (j = 0; j < numattrs; j++)
+	{
+		int			nvalues = 0;
+		int			nnulls = 0;
+		int			start;
+
+		for (i = 0; i < numrows; i++)
+		{
+			if (items[i].isnull[j])
+			{
+				nnulls++;
+				continue;
+			}
+
+			values[nvalues].value = items[i].values[j];
+			values[nvalues].tupno = i;
+			nvalues++;
+		}
+
+		qsort_arg((void *) values, nvalues, sizeof(ScalarItem),
+				  compare_scalar_items, &mss->ssup[j]);
+
+		/* walk the groups of equal values, including one beyond the end */
+		start = 0;
+		for (i = 1; i <= nvalues; i++)
+		{
+			int			k;
+
+			if (i < nvalues &&
+				compare_scalar_items(&values[start], &values[i],
+									 &mss->ssup[j]) == 0)
+				continue;
+
+			for (k = start; k < i; k++)
+				basefreqs[values[k].tupno] *= (double) (i - start) / numrows;
+
+			start = i;
+		}
+
+		/* and the same for rows with NULL in this column */
+		if (nnulls > 0)
+		{
+			for (i = 0; i < numrows; i++)
+			{
+				if (items[i].isnull[j])
+					basefreqs[i] *= (double) nnulls / numrows;
+			}
+		}
+	}
+
+	pfree(values);
+}
+
+/*
+ * statext_mcv_build
+ *		Build a multivariate MCV list from the sample rows.
+ *
+ * We sort the sample rows on all the columns, split them into groups of
+ * identical combinations of values, and keep the most common groups, up to
+ * the largest statistics target of the columns.  Groups that are too rare
+ * to be estimated reliably from the sample are discarded (we use the same
+ * rule as for per-column MCV lists).
+ *
+ * Along with the frequency of each item we also store the base frequency,
+ * which is what the estimate would be if the columns were independent.  The
+ * planner uses that to correct the estimate for the part of the data not
+ * covered by the MCV list.
+ *
+ * Returns NULL if the sample has no group worth keeping.
+ */
+MCVList *
+statext_mcv_build(int numrows, HeapTuple *rows, Bitmapset *attrs,
+				  VacAttrStats **stats, double totalrows)
+{
+	int			i,
+				j;
+	int			numattrs = bms_num_members(attrs);
+	int			ngroups;
+	int			nitems;
+	int			stattarget;
+	double		mincount;
+	int		   *attnums;
+	MultiSortSupport mss;
+	MCVGroupSortContext cxt;
+	SortItem   *items;
+	Datum	   *values;
+	bool	   *isnull;
+	double	   *basefreqs;
+	MCVGroup   *groups;
+	MCVList    *mcvlist;
+
+	Assert(numattrs >= 2 && numattrs <= STATS_MAX_DIMENSIONS);
+
+	if (numrows == 0)
+		return NULL;
+
+	/*
+	 * Transform the bms into an array, to make accessing i-th member easier.
+	 */
+	attnums = (int *) palloc(sizeof(int) * numattrs);
+	i = 0;
+	j = -1;
+	while ((j = bms_next_member(attrs, j)) >= 0)
+		attnums[i++] = j;
+
+	/*
+	 * We use the column data types' default sort operators and collations,
+	 * just like the functional dependencies do.
+	 */
+	mss = multi_sort_init(numattrs);
+
+	/* the number of items we want is driven by the largest target */
+	stattarget = 0;
+	for (i = 0; i < numattrs; i++)
+	{
+		TypeCacheEntry *type;
+
+		type = lookup_type_cache(stats[i]->attrtypid, TYPECACHE_LT_OPR);
+		if (type->lt_opr == InvalidOid) /* shouldn't happen */
+			elog(ERROR, "cache lookup failed for ordering operator for type %u",
+				 stats[i]->attrtypid);
+
+		multi_sort_add_dimension(mss, i, type->lt_opr, type->typcollation);
+
+		if (stats[i]->attr->attstattarget > stattarget)
+			stattarget = stats[i]->attr->attstattarget;
+	}
+
+	if (stattarget <= 0)
+		stattarget = default_statistics_target;
+	stattarget = Min(stattarget, STATS_MCVLIST_MAX_ITEMS);
+
+	/* collect the values from the sample rows */
+	items = (SortItem *) palloc(numrows * sizeof(SortItem));
+	values = (Datum *) palloc(sizeof(Datum) * numrows * numattrs);
+	isnull = (bool *) palloc(sizeof(bool) * numrows * numattrs);
+
+	for (i = 0; i < numrows; i++)
+	{
+		items[i].values = &values[i * numattrs];
+		items[i].isnull = &isnull[i * numattrs];
+
+		for (j = 0; j < numattrs; j++)
+			items[i].values[j] = heap_getattr(rows[i], attnums[j],
+											  stats[j]->tupDesc,
+											  &items[i].isnull[j]);
+	}
+
+	/* sort the rows, so that identical combinations are adjacent */
+	qsort_arg((void *) items, numrows, sizeof(SortItem),
+			  multi_sort_compare, mss);
+
+	/* split the sorted rows into groups */
+	groups = (MCVGroup *) palloc(numrows * sizeof(MCVGroup));
+	groups[0].first = 0;
+	groups[0].count = 1;
+	ngroups = 1;
+
+	for (i = 1; i < numrows; i++)
+	{
+		if (multi_sort_compare(&items[i], &items[i - 1], mss) != 0)
+		{
+			groups[ngroups].first = i;
+			groups[ngroups].count = 0;
+			ngroups++;
+		}
+
+		groups[ngroups - 1].count++;
+	}
+
+	/* order the groups by frequency, most common first */
+	cxt.items = items;
+	cxt.mss = mss;
+	qsort_arg((void *) groups, ngroups, sizeof(MCVGroup),
+			  compare_mcv_groups, &cxt);
+
+	/*
+	 * Keep at most stattarget groups, and stop at the first one that is too
+	 * rare to be included.
+	 */
+	nitems = Min(stattarget, ngroups);
+	mincount = get_mincount_for_mcv_list(numrows, totalrows);
+
+	for (i = 0; i < nitems; i++)
+	{
+		if (groups[i].count < mincount)
+		{
+			nitems = i;
+			break;
+		}
+	}
+
+	if (nitems == 0)
+		return NULL;
+
+	basefreqs = (double *) palloc(numrows * sizeof(double));
+	compute_base_frequencies(numrows, items, numattrs, mss, basefreqs);
+
+	/* build the MCV list itself */
+	mcvlist = (MCVList *) palloc0(offsetof(MCVList, items) +
+								  nitems * sizeof(MCVItem *));
+
+	mcvlist->magic = STATS_MCV_MAGIC;
+	mcvlist->type = STATS_MCV_TYPE_BASIC;
+	mcvlist->nitems = nitems;
+	mcvlist->ndimensions = numattrs;
+	for (j = 0; j < numattrs; j++)
+		mcvlist->types[j] = stats[j]->attrtypid;
+
+	for (i = 0; i < nitems; i++)
+	{
+		MCVItem    *item = (MCVItem *) palloc(sizeof(MCVItem));
+		SortItem   *sitem = &items[groups[i].first];
+
+		/* the values still point into the sample rows */
+		item->values = sitem->values;
+		item->isnull = sitem->isnull;
+		item->frequency = (double) groups[i].count / numrows;
+		item->base_frequency = basefreqs[groups[i].first];
+
+		mcvlist->items[i] = item;
+	}
+
+	pfree(groups);
+	pfree(basefreqs);
+
+	return mcvlist;
+}
+
+/*
+ * statext_mcv_load
+ *		Load the MCV list for the indicated pg_statistic_ext tuple
+ */
+MCVList *
+statext_mcv_load(Oid mvoid)
+{
+	MCVList    *result;
+	bool		isnull;
+	Datum		mcvlist;
+	HeapTuple	htup;
+
+	htup = SearchSysCache1(STATEXTOID, ObjectIdGetDatum(mvoid));
+	if (!HeapTupleIsValid(htup))
+		elog(ERROR, "cache lookup failed for statistics object %u", mvoid);
+
+	mcvlist = SysCacheGetAttr(STATEXTOID, htup,
+							  Anum_pg_statistic_ext_stxmcv, &isnull);
+	if (isnull)
+		elog(ERROR,
+			 "requested statistic kind \"%c\" is not yet built for statistics object %u",
+			 STATS_EXT_MCV, mvoid);
+
+	result = statext_mcv_deserialize(DatumGetByteaPP(mcvlist));
+
+	ReleaseSysCache(htup);
+
+	return result;
+}
+
+/*
+ * Serialize MCV list into a bytea value.
+ *
+ * The serialized format is simple: the header (magic, type, number of items
+ * and dimensions), the type OIDs of the columns, and then for each item the
+ * frequency, the base frequency, the NULL flags and the non-NULL values.
+ * Pass-by-value values are stored as whole Datums, fixed-length ones as
+ * typlen bytes, and varlena and cstring values are prefixed by their length
+ * (varlenas are detoasted first, so that the value is self-contained).
+ */
+bytea *
+statext_mcv_serialize(MCVList *mcvlist, VacAttrStats **stats)
+{
+	int			i,
+				dim;
+	int			ndims = mcvlist->ndimensions;
+	bytea	   *output;
+	char	   *tmp;
+	Size		len;
+
+	len = VARHDRSZ + SizeOfMCVList + ndims * sizeof(Oid);
+
+	for (i = 0; i < mcvlist->nitems; i++)
+	{
+		MCVItem    *item = mcvlist->items[i];
+
+		len += 2 * sizeof(double) + ndims * sizeof(bool);
+
+		for (dim = 0; dim < ndims; dim++)
+		{
+			Form_pg_type type = stats[dim]->attrtype;
+
+			if (item->isnull[dim])
+				continue;
+
+			if (type->typbyval)
+				len += sizeof(Datum);
+			else if (type->typlen > 0)
+				len += type->typlen;
+			else if (type->typlen == -1)
+			{
+				item->values[dim] =
+					PointerGetDatum(PG_DETOAST_DATUM(item->values[dim]));
+				len += sizeof(uint32) + VARSIZE(DatumGetPointer(item->values[dim]));
+			}
+			else
+			{
+				Assert(type->typlen == -2);
+				len += sizeof(uint32) +
+					strlen(DatumGetCString(item->values[dim])) + 1;
+			}
+		}
+	}
+
+	output = (bytea *) palloc0(len);
+	SET_VARSIZE(output, len);
+
+	tmp = VARDATA(output);
+
+	/* Store the base struct values (magic, type, nitems, ndimensions) */
+	memcpy(tmp, &mcvlist->magic, sizeof(uint32));
+	tmp += sizeof(uint32);
+	memcpy(tmp, &mcvlist->type, sizeof(uint32));
+	tmp += sizeof(uint32);
+	memcpy(tmp, &mcvlist->nitems, sizeof(uint32));
+	tmp += sizeof(uint32);
+	memcpy(tmp, &mcvlist->ndimensions, sizeof(AttrNumber));
+	tmp += sizeof(AttrNumber);
+
+	memcpy(tmp, mcvlist->types, ndims * sizeof(Oid));
+	tmp += ndims * sizeof(Oid);
+
+	for (i = 0; i < mcvlist->nitems; i++)
+	{
+		MCVItem    *item = mcvlist->items[i];
+
+		memcpy(tmp, &item->frequency, sizeof(double));
+		tmp += sizeof(double);
+		memcpy(tmp, &item->base_frequency, sizeof(double));
+		tmp += sizeof(double);
+		memcpy(tmp, item->isnull, ndims * sizeof(bool));
+		tmp += ndims * sizeof(bool);
+
+		for (dim = 0; dim < ndims; dim++)
+		{
+			Form_pg_type type = stats[dim]->attrtype;
+			uint32		vlen;
+
+			if (item->isnull[dim])
+				continue;
+
+			if (type->typbyval)
+			{
+				memcpy(tmp, &item->values[dim], sizeof(Datum));
+				tmp += sizeof(Datum);
+			}
+			else if (type->typlen > 0)
+			{
+				memcpy(tmp, DatumGetPointer(item->values[dim]), type->typlen);
+				tmp += type->typlen;
+			}
+			else if (type->typlen == -1)
+			{
+				vlen = VARSIZE(DatumGetPointer(item->values[dim]));
+				memcpy(tmp, &vlen, sizeof(uint32));
+				tmp += sizeof(uint32);
+				memcpy(tmp, DatumGetPointer(item->values[dim]), vlen);
+				tmp += vlen;
+			}
+			else
+			{
+				vlen = strlen(DatumGetCString(item->values[dim])) + 1;
+				memcpy(tmp, &vlen, sizeof(uint32));
+				tmp += sizeof(uint32);
+				memcpy(tmp, DatumGetCString(item->values[dim]), vlen);
+				tmp += vlen;
+			}
+		}
+
+		Assert(tmp <= ((char *) output + len));
+	}
+
+	/* we should have filled the whole bytea exactly */
+	Assert(tmp == ((char *) output + len));
+
+	return output;
+}
+
+/*
+ * Reads serialized MCV list into MCVList structure.
+ *
+ * Values of pass-by-reference types are copied, so that they are properly
+ * aligned and independent of the serialized value.
+ */
+MCVList *
+statext_mcv_deserialize(bytea *data)
+{
+	int			i,
+				dim;
+	int			ndims;
+	int16		typlen[STATS_MAX_DIMENSIONS];
+	bool		typbyval[STATS_MAX_DIMENSIONS];
+	MCVList    *mcvlist;
+	char	   *tmp;
+	char	   *end;
+
+	if (data == NULL)
+		return NULL;
+
+	if (VARSIZE_ANY_EXHDR(data) < SizeOfMCVList)
+		elog(ERROR, "invalid MCV size %zd (expected at least %zd)",
+			 VARSIZE_ANY_EXHDR(data), SizeOfMCVList);
+
+	/* read the MCV list header */
+	mcvlist = (MCVList *) palloc0(offsetof(MCVList, items));
+
+	/* initialize pointer to the data part (skip the varlena header) */
+	tmp = VARDATA_ANY(data);
+	end = tmp + VARSIZE_ANY_EXHDR(data);
+
+	/* read the header fields and perform basic sanity checks */
+	memcpy(&mcvlist->magic, tmp, sizeof(uint32));
+	tmp += sizeof(uint32);
+	memcpy(&mcvlist->type, tmp, sizeof(uint32));
+	tmp += sizeof(uint32);
+	memcpy(&mcvlist->nitems, tmp, sizeof(uint32));
+	tmp += sizeof(uint32);
+	memcpy(&mcvlist->ndimensions, tmp, sizeof(AttrNumber));
+	tmp += sizeof(AttrNumber);
+
+	if (mcvlist->magic != STATS_MCV_MAGIC)
+		elog(ERROR, "invalid MCV magic %u (expected %u)",
+			 mcvlist->magic, STATS_MCV_MAGIC);
+
+	if (mcvlist->type != STATS_MCV_TYPE_BASIC)
+		elog(ERROR, "invalid MCV type %u (expected %u)",
+			 mcvlist->type, STATS_MCV_TYPE_BASIC);
+
+	if (mcvlist->nitems == 0 || mcvlist->nitems > STATS_MCVLIST_MAX_ITEMS)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg("invalid number of items %u in MCV list",
+						mcvlist->nitems)));
+
+	ndims = mcvlist->ndimensions;
+	if (ndims < 2 || ndims > STATS_MAX_DIMENSIONS)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg("invalid number of dimensions %d in MCV list",
+						ndims)));
+
+	if ((Size) (end - tmp) < ndims * sizeof(Oid) +
+		mcvlist->nitems * (2 * sizeof(double) + ndims * sizeof(bool)))
+		elog(ERROR, "invalid MCV size %zd", VARSIZE_ANY_EXHDR(data));
+
+	memcpy(mcvlist->types, tmp, ndims * sizeof(Oid));
+	tmp += ndims * sizeof(Oid);
+
+	for (dim = 0; dim < ndims; dim++)
+		get_typlenbyval(mcvlist->types[dim], &typlen[dim], &typbyval[dim]);
+
+	/* allocate space for the MCV items */
+	mcvlist = repalloc(mcvlist, offsetof(MCVList, items)
+					   + (mcvlist->nitems * sizeof(MCVItem *)));
+
+	for (i = 0; i < mcvlist->nitems; i++)
+	{
+		MCVItem    *item;
+
+		item = (MCVItem *) palloc(sizeof(MCVItem));
+		item->values = (Datum *) palloc0(ndims * sizeof(Datum));
+		item->isnull = (bool *) palloc(ndims * sizeof(bool));
+
+		memcpy(&item->frequency, tmp, sizeof(double));
+		tmp += sizeof(double);
+		memcpy(&item->base_frequency, tmp, sizeof(double));
+		tmp += sizeof(double);
+		memcpy(item->isnull, tmp, ndims * sizeof(bool));
+		tmp += ndims * sizeof(bool);
+
+		for (dim = 0; dim < ndims; dim++)
+		{
+			uint32		vlen;
+			char	   *v;
+
+			if (item->isnull[dim])
+				continue;
+
+			if (typbyval[dim])
+			{
+				if (tmp + sizeof(Datum) > end)
+					elog(ERROR, "invalid MCV size %zd", VARSIZE_ANY_EXHDR(data));
+
+				memcpy(&item->values[dim], tmp, sizeof(Datum));
+				tmp += sizeof(Datum);
+				continue;
+			}
+
+			if (typlen[dim] > 0)
+				vlen = typlen[dim];
+			else
+			{
+				if (tmp + sizeof(uint32) > end)
+					elog(ERROR, "invalid MCV size %zd", VARSIZE_ANY_EXHDR(data));
+
+				memcpy(&vlen, tmp, sizeof(uint32));
+				tmp += sizeof(uint32);
+			}
+
+			if (tmp + vlen > end)
+				elog(ERROR, "invalid MCV size %zd", VARSIZE_ANY_EXHDR(data));
+
+			v = palloc(vlen);
+			memcpy(v, tmp, vlen);
+			tmp += vlen;
+
+			item->values[dim] = PointerGetDatum(v);
+		}
+
+		mcvlist->items[i] = item;
+
+		/* still within the bytea */
+		if (tmp > end)
+			elog(ERROR, "invalid MCV size %zd", VARSIZE_ANY_EXHDR(data));
+	}
+
+	/* we should have consumed the whole bytea exactly */
+	Assert(tmp == end);
+
+	return mcvlist;
+}
+
+/*
+ * pg_mcv_list_in		- input routine for type pg_mcv_list.
+ *
+ * pg_mcv_list is real enough to be a table column, but it has no operations
+ * of its own, and disallows input too
+ */
+Datum
+pg_mcv_list_in(PG_FUNCTION_ARGS)
+{
+	/*
+	 * pg_mcv_list stores the data in binary form and parsing text input is
+	 * not needed, so disallow this.
+	 */
+	ereport(ERROR,
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			 errmsg("cannot accept a value of type %s", "pg_mcv_list")));
+
+	PG_RETURN_VOID();			/* keep compiler quiet */
+}
+
+/*
+ * pg_mcv_list_out		- output routine for type pg_mcv_list.
+ *
+ * Each item is printed as the list of values (using the output functions of
+ * the column data types), followed by its frequency and base frequency.
+ */
+Datum
+pg_mcv_list_out(PG_FUNCTION_ARGS)
+{
+	bytea	   *data = PG_GETARG_BYTEA_PP(0);
+	MCVList    *mcvlist = statext_mcv_deserialize(data);
+	FmgrInfo	outfuncs[STATS_MAX_DIMENSIONS];
+	int			i,
+				dim;
+	StringInfoData str;
+
+	for (dim = 0; dim < mcvlist->ndimensions; dim++)
+	{
+		Oid			outfunc;
+		bool		isvarlena;
+
+		getTypeOutputInfo(mcvlist->types[dim], &outfunc, &isvarlena);
+		fmgr_info(outfunc, &outfuncs[dim]);
+	}
+
+	initStringInfo(&str);
+	appendStringInfoChar(&str, '{');
+
+	for (i = 0; i < mcvlist->nitems; i++)
+	{
+		MCVItem    *item = mcvlist->items[i];
+
+		if (i > 0)
+			appendStringInfoString(&str, ", ");
+
+		appendStringInfoChar(&str, '"');
+		for (dim = 0; dim < mcvlist->ndimensions; dim++)
+		{
+			if (dim > 0)
+				appendStringInfoString(&str, ", ");
+
+			if (item->isnull[dim])
+				appendStringInfoString(&str, "NULL");
+			else
+				appendStringInfoString(&str,
+									   OutputFunctionCall(&outfuncs[dim],
+														  item->values[dim]));
+		}
+		appendStringInfo(&str, "\": [%f, %f]",
+						 item->frequency, item->base_frequency);
+	}
+
+	appendStringInfoChar(&str, '}');
+
+	PG_RETURN_CSTRING(str.data);
+}
+
+/*
+ * pg_mcv_list_recv		- binary input routine for type pg_mcv_list.
+ */
+Datum
+pg_mcv_list_recv(PG_FUNCTION_ARGS)
+{
+	ereport(ERROR,
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			 errmsg("cannot accept a value of type %s", "pg_mcv_list")));
+
+	PG_RETURN_VOID();			/* keep compiler quiet */
+}
+
+/*
+ * pg_mcv_list_send		- binary output routine for type pg_mcv_list.
+ *
+ * MCV lists are serialized in a bytea value (although the type is named
+ * differently), so let's just send that.
+ */
+Datum
+pg_mcv_list_send(PG_FUNCTION_ARGS)
+{
+	return byteasend(fcinfo);
+}
+
+/*
+ * mcv_opclause_args
+ *		Split an OpExpr into the Var and Const arguments, if it has that form
+ *		(in either order).  We ignore a RelabelType node above the operands.
+ */
+static bool
+mcv_opclause_args(OpExpr *expr, Var **var, Const **cst, bool *varonleft)
+{
+	Node	   *left,
+			   *right;
+
+	if (list_length(expr->args) != 2)
+		return false;
+
+	left = (Node *) linitial(expr->args);
+	right = (Node *) lsecond(expr->args);
+
+	if (IsA(left, RelabelType))
+		left = (Node *) ((RelabelType *) left)->arg;
+	if (IsA(right, RelabelType))
+		right = (Node *) ((RelabelType *) right)->arg;
+
+	if (IsA(left, Var) && IsA(right, Const))
+	{
+		*var = (Var *) left;
+		*cst = (Const *) right;
+		*varonleft = true;
+	}
+	else if (IsA(left, Const) && IsA(right, Var))
+	{
+		*var = (Var *) right;
+		*cst = (Const *) left;
+		*varonleft = false;
+	}
+	else
+		return false;
+
+	return true;
+}
+
+/*
+ * mcv_is_compatible_clause
+ *		Determines if the clause is compatible with MCV lists
+ *
+ * Only OpExprs of the form (Var op Const) or (Const op Var) with operators
+ * estimated as equality, inequality or range comparisons, and NullTests on
+ * a Var, are currently accepted.  The Var must be a plain user attribute of
+ * the specified relation, whose attribute number we return in *attnum.
+ */
+static bool
+mcv_is_compatible_clause(Node *clause, Index relid, AttrNumber *attnum)
+{
+	RestrictInfo *rinfo = (RestrictInfo *) clause;
+	Var		   *var;
+
+	if (!IsA(rinfo, RestrictInfo))
+		return false;
+
+	/* Pseudoconstants are not interesting (they couldn't contain a Var) */
+	if (rinfo->pseudoconstant)
+		return false;
+
+	/* Clauses referencing multiple, or no, varnos are incompatible */
+	if (bms_membership(rinfo->clause_relids) != BMS_SINGLETON)
+		return false;
+
+	if (is_opclause(rinfo->clause))
+	{
+		OpExpr	   *expr = (OpExpr *) rinfo->clause;
+		Const	   *cst;
+		bool		varonleft;
+
+		if (!mcv_opclause_args(expr, &var, &cst, &varonleft))
+			return false;
+
+		/*
+		 * As with functional dependencies, we recognize the operators by
+		 * their restriction selectivity functions.
+		 */
+		switch (get_oprrest(expr->opno))
+		{
+			case F_EQSEL:
+			case F_NEQSEL:
+			case F_SCALARLTSEL:
+			case F_SCALARLESEL:
+			case F_SCALARGTSEL:
+			case F_SCALARGESEL:
+				break;
+
+			default:
+				return false;
+		}
+	}
+	else if (IsA(rinfo->clause, NullTest))
+	{
+		NullTest   *expr = (NullTest *) rinfo->clause;
+
+		/* row-wise NULL tests have different semantics */
+		if (expr->argisrow)
+			return false;
+
+		var = (Var *) expr->arg;
+
+		if (IsA(var, RelabelType))
+			var = (Var *) ((RelabelType *) var)->arg;
+	}
+	else
+		return false;
+
+	/* We only support plain Vars for now */
+	if (!IsA(var, Var))
+		return false;
+
+	/* Ensure Var is from the correct relation */
+	if (var->varno != relid)
+		return false;
+
+	/* We also better ensure the Var is from the current level */
+	if (var->varlevelsup != 0)
+		return false;
+
+	/* Also ignore system attributes (we don't allow stats on those) */
+	if (!AttrNumberIsForUserDefinedAttr(var->varattno))
+		return false;
+
+	*attnum = var->varattno;
+	return true;
+}
+
+/*
+ * mcv_attnum_index
+ *		Position of the attribute in the MCV items (the attributes are stored
+ *		in attnum order).
+ */
+static int
+mcv_attnum_index(Bitmapset *keys, AttrNumber attnum)
+{
+	int			idx = 0;
+	int			k = -1;
+
+	while ((k = bms_next_member(keys, k)) >= 0)
+	{
+		if (k == attnum)
+			return idx;
+		idx++;
+	}
+
+	elog(ERROR, "attribute %d is not covered by the statistics object", attnum);
+	return -1;					/* keep compiler quiet */
+}
+
+/*
+ * mcv_clauselist_selectivity
+ *		Return the estimated selectivity of (a subset of) the given clauses
+ *		using a multivariate MCV list, or 1.0 if no useful MCV list exists.
+ *
+ * 'estimatedclauses' is an input/output argument: clauses whose (zero-based)
+ * list index is already in the set are ignored, and we add the indexes of
+ * the clauses included in the estimated selectivity.
+ *
+ * We evaluate the clauses against each MCV item, which gives us the
+ * frequency of the matching items (mcv_sel) and their base frequency
+ * (mcv_basesel), along with the total frequency of all items (mcv_totalsel).
+ * We then compute the selectivity of the clauses the usual way, assuming
+ * independence (simple_sel), and combine that with the MCV estimate:
+ *
+ *	   sel = mcv_sel + clamp(simple_sel - mcv_basesel, 0, 1 - mcv_totalsel)
+ *
+ * The MCV items give us an exact answer for the common combinations, and we
+ * rely on the independence assumption only for the part of the data not
+ * covered by the MCV list.
+ */
+Selectivity
+mcv_clauselist_selectivity(PlannerInfo *root,
+						   List *clauses,
+						   int varRelid,
+						   JoinType jointype,
+						   SpecialJoinInfo *sjinfo,
+						   RelOptInfo *rel,
+						   Bitmapset **estimatedclauses)
+{
+	ListCell   *l;
+	Bitmapset  *clauses_attnums = NULL;
+	StatisticExtInfo *stat;
+	MCVList    *mcvlist;
+	AttrNumber *list_attnums;
+	List	   *stat_clauses = NIL;
+	MCVClause  *mcvclauses;
+	int			nclauses;
+	int			listidx;
+	int			i,
+				j;
+	Selectivity simple_sel,
+				mcv_sel = 0.0,
+				mcv_basesel = 0.0,
+				mcv_totalsel = 0.0,
+				other_sel,
+				sel;
+
+	/* check if there's any stats that might be useful for us. */
+	if (!has_stats_of_kind(rel->statlist, STATS_EXT_MCV))
+		return 1.0;
+
+	list_attnums = (AttrNumber *) palloc(sizeof(AttrNumber) *
+										 list_length(clauses));
+
+	/*
+	 * Pre-process the clauses list to extract the attnums seen in each item,
+	 * skipping clauses already estimated using other statistics.
+	 */
+	listidx = 0;
+	foreach(l, clauses)
+	{
+		Node	   *clause = (Node *) lfirst(l);
+		AttrNumber	attnum;
+
+		if (!bms_is_member(listidx, *estimatedclauses) &&
+			mcv_is_compatible_clause(clause, rel->relid, &attnum))
+		{
+			list_attnums[listidx] = attnum;
+			clauses_attnums = bms_add_member(clauses_attnums, attnum);
+		}
+		else
+			list_attnums[listidx] = InvalidAttrNumber;
+
+		listidx++;
+	}
+
+	/*
+	 * If there's not at least two distinct attnums then reject the whole list
+	 * of clauses. We must return 1.0 so the calling function's selectivity is
+	 * unaffected.
+	 */
+	if (bms_num_members(clauses_attnums) < 2)
+	{
+		pfree(list_attnums);
+		return 1.0;
+	}
+
+	/* find the best suited statistics object for these attnums */
+	stat = choose_best_statistics(rel->statlist, clauses_attnums,
+								  STATS_EXT_MCV);
+
+	/* if no matching stats could be found then we've nothing to do */
+	if (!stat)
+	{
+		pfree(list_attnums);
+		return 1.0;
+	}
+
+	/* collect the clauses covered by the statistics object */
+	listidx = 0;
+	foreach(l, clauses)
+	{
+		if (list_attnums[listidx] != InvalidAttrNumber &&
+			bms_is_member(list_attnums[listidx], stat->keys))
+		{
+			stat_clauses = lappend(stat_clauses, lfirst(l));
+			*estimatedclauses = bms_add_member(*estimatedclauses, listidx);
+		}
+
+		listidx++;
+	}
+
+	/* prepare the clauses for evaluation against the MCV items */
+	nclauses = list_length(stat_clauses);
+	mcvclauses = (MCVClause *) palloc0(nclauses * sizeof(MCVClause));
+
+	i = 0;
+	foreach(l, stat_clauses)
+	{
+		RestrictInfo *rinfo = (RestrictInfo *) lfirst(l);
+		MCVClause  *mc = &mcvclauses[i++];
+		Var		   *var;
+
+		if (is_opclause(rinfo->clause))
+		{
+			OpExpr	   *expr = (OpExpr *) rinfo->clause;
+			Const	   *cst;
+
+			if (!mcv_opclause_args(expr, &var, &cst, &mc->varonleft))
+				elog(ERROR, "incompatible clause");
+
+			fmgr_info(get_opcode(expr->opno), &mc->opproc);
+			mc->collid = expr->inputcollid;
+			mc->constvalue = cst->constvalue;
+			mc->constisnull = cst->constisnull;
+		}
+		else
+		{
+			NullTest   *expr = (NullTest *) rinfo->clause;
+
+			var = (Var *) expr->arg;
+			if (IsA(var, RelabelType))
+				var = (Var *) ((RelabelType *) var)->arg;
+
+			mc->isnulltest = true;
+			mc->nulltesttype = expr->nulltesttype;
+		}
+
+		mc->dim = mcv_attnum_index(stat->keys, var->varattno);
+	}
+
+	/* load the MCV list stored in the statistics object */
+	mcvlist = statext_mcv_load(stat->statOid);
+
+	/*
+	 * Evaluate the (implicitly ANDed) clauses for each MCV item.  The
+	 * operators are assumed to be strict, so a NULL on either side means the
+	 * item does not match.
+	 */
+	for (i = 0; i < mcvlist->nitems; i++)
+	{
+		MCVItem    *item = mcvlist->items[i];
+		bool		match = true;
+
+		for (j = 0; j < nclauses && match; j++)
+		{
+			MCVClause  *mc = &mcvclauses[j];
+			bool		isnull = item->isnull[mc->dim];
+
+			if (mc->isnulltest)
+			{
+				if (mc->nulltesttype == IS_NULL)
+					match = isnull;
+				else
+					match = !isnull;
+			}
+			else if (isnull || mc->constisnull)
+				match = false;
+			else if (mc->varonleft)
+				match = DatumGetBool(FunctionCall2Coll(&mc->opproc,
+													   mc->collid,
+													   item->values[mc->dim],
+													   mc->constvalue));
+			else
+				match = DatumGetBool(FunctionCall2Coll(&mc->opproc,
+													   mc->collid,
+													   mc->constvalue,
+													   item->values[mc->dim]));
+		}
+
+		mcv_totalsel += item->frequency;
+
+		if (match)
+		{
+			mcv_sel += item->frequency;
+			mcv_basesel += item->base_frequency;
+		}
+	}
+
+	/* estimate the same clauses the regular way, assuming independence */
+	simple_sel = clauselist_selectivity_simple(root, stat_clauses, varRelid,
+											   jointype, sjinfo, NULL);
+
+	/*
+	 * The base frequency of the matching items is the part of simple_sel
+	 * that is already accounted for by the MCV list, so the rest of it is
+	 * an estimate for the data not covered by the list.  That however can't
+	 * be more than the total frequency of the non-MCV part.
+	 */
+	other_sel = simple_sel - mcv_basesel;
+	if (other_sel < 0.0)
+		other_sel = 0.0;
+	if (other_sel > 1.0 - mcv_totalsel)
+		other_sel = 1.0 - mcv_totalsel;
+
+	sel = mcv_sel + other_sel;
+	CLAMP_PROBABILITY(sel);
+
+	pfree(mcvclauses);
+	pfree(list_attnums);
+
+	return sel;
+}
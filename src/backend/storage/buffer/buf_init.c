@@ -112,6 +112,14 @@ InitBufferPool(void)
 	{
 		int			i;
 
+		/*
+		 * Spread the buffer pool over the memory nodes, if requested.  The
+		 * blocks themselves haven't been touched yet, so they'll be
+		 * allocated where we tell the kernel to put them.
+		 */
+		ShmemSetNumaPlacement("Buffer Blocks", BufferBlocks,
+							  NBuffers * (Size) BLCKSZ, true);
+
 		/*
 		 * Initialize all the buffer headers.
 		 */
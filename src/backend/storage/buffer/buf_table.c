@@ -3,11 +3,22 @@
  * buf_table.c
  *	  routines for mapping BufferTags to buffer indexes.
  *
- * Note: the routines in this file do no locking of their own.  The caller
- * must hold a suitable lock on the appropriate BufMappingLock, as specified
- * in the comments.  We can't do the locking inside these functions because
- * in most cases the caller needs to adjust the buffer header contents
- * before the lock is released (see notes in README).
+ * The mapping table is an open-addressing hash table, split into
+ * NUM_BUFFER_PARTITIONS independent regions, one per BufMappingLock
+ * partition; a tag is stored in the region of its partition, using linear
+ * probing and backward-shift deletion within the region.  Each region has a
+ * version counter that is odd while the region is being modified.
+ *
+ * Insertions and deletions still require the caller to hold exclusive lock
+ * on the appropriate BufMappingLock, so there is only ever one writer per
+ * region.  Lookups, however, take no lock at all: they are optimistic reads
+ * that are retried if the region's version counter changed while they were
+ * probing.  A lookup result is therefore only a hint unless the caller holds
+ * the partition lock; see BufferAlloc for how an unlocked result is
+ * validated after pinning the buffer.  We can't do the write-side locking
+ * inside these functions because in most cases the caller needs to adjust
+ * the buffer header contents before the lock is released (see notes in
+ * README).
  *
  *
  * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
@@ -21,19 +32,71 @@
  */
 #include "postgres.h"
 
+#include <math.h>
+
+#include "access/hash.h"
 #include "storage/bufmgr.h"
 #include "storage/buf_internals.h"
+#include "storage/shmem.h"
 
 
-/* entry for buffer lookup hashtable */
+/*
+ * entry for buffer lookup hashtable; padded so that two entries fill a
+ * 64-byte cache line exactly
+ */
 typedef struct
 {
+	uint32		hashcode;		/* hash code of key */
+	int			id;				/* Associated buffer ID, or -1 if unused */
 	BufferTag	key;			/* Tag of a disk page */
-	int			id;				/* Associated buffer ID */
+	uint32		pad;
 } BufferLookupEnt;
 
-static HTAB *SharedBufHash;
+/* per-region control information, each on its own cache line */
+typedef union BufTableRegion
+{
+	struct
+	{
+		pg_atomic_uint32 version;	/* odd while being modified */
+		uint32		nentries;	/* number of used entries */
+	}			r;
+	char		pad[PG_CACHE_LINE_SIZE];
+} BufTableRegion;
+
+static BufTableRegion *SharedBufRegions;
+static BufferLookupEnt *SharedBufEntries;
+static uint32 SharedBufRegionSize;	/* entries per region, a power of 2 */
+
+#define BufTableRegionIndex(hashcode) \
+	((hashcode) % NUM_BUFFER_PARTITIONS)
+#define BufTableHomeSlot(hashcode) \
+	(((hashcode) / NUM_BUFFER_PARTITIONS) & (SharedBufRegionSize - 1))
+#define BufTableRegionEntries(region_index) \
+	(SharedBufEntries + (Size) (region_index) * SharedBufRegionSize)
+
+
+/*
+ * Compute the number of entries per region for a table of the given size.
+ *
+ * We want the load factor of every region to stay at or below one half, so
+ * that probe sequences stay short, and we must not run out of room in a
+ * region that gets more than its fair share of tags; so allow for the
+ * expected number of entries plus a generous multiple of its standard
+ * deviation.
+ */
+static uint32
+BufTableRegionSizeFor(int size)
+{
+	double		expected = (double) size / NUM_BUFFER_PARTITIONS;
+	double		needed;
+	uint32		result = 64;
+
+	needed = Max(2.0 * expected, expected + 8.0 * sqrt(expected) + 32.0);
+	while (result < needed)
+		result <<= 1;
 
+	return result;
+}
 
 /*
  * Estimate space needed for mapping hashtable
@@ -42,7 +105,17 @@ static HTAB *SharedBufHash;
 Size
 BufTableShmemSize(int size)
 {
-	return hash_estimate_size(size, sizeof(BufferLookupEnt));
+	Size		result;
+
+	result = mul_size(NUM_BUFFER_PARTITIONS, sizeof(BufTableRegion));
+	result = add_size(result,
+					  mul_size(mul_size(NUM_BUFFER_PARTITIONS,
+										BufTableRegionSizeFor(size)),
+							   sizeof(BufferLookupEnt)));
+	/* allow for aligning both arrays to cache line boundaries */
+	result = add_size(result, 2 * PG_CACHE_LINE_SIZE);
+
+	return result;
 }
 
 /*
@@ -52,19 +125,39 @@ BufTableShmemSize(int size)
 void
 InitBufTable(int size)
 {
-	HASHCTL		info;
+	bool		foundRegions,
+				foundEntries;
+	Size		nentries;
 
 	/* assume no locking is needed yet */
 
-	/* BufferTag maps to Buffer */
-	info.keysize = sizeof(BufferTag);
-	info.entrysize = sizeof(BufferLookupEnt);
-	info.num_partitions = NUM_BUFFER_PARTITIONS;
+	SharedBufRegionSize = BufTableRegionSizeFor(size);
+	nentries = (Size) NUM_BUFFER_PARTITIONS * SharedBufRegionSize;
+
+	SharedBufRegions = (BufTableRegion *)
+		CACHELINEALIGN(ShmemInitStruct("Shared Buffer Lookup Regions",
+									   NUM_BUFFER_PARTITIONS * sizeof(BufTableRegion) + PG_CACHE_LINE_SIZE,
+									   &foundRegions));
+	SharedBufEntries = (BufferLookupEnt *)
+		CACHELINEALIGN(ShmemInitStruct("Shared Buffer Lookup Table",
+									   nentries * sizeof(BufferLookupEnt) + PG_CACHE_LINE_SIZE,
+									   &foundEntries));
 
-	SharedBufHash = ShmemInitHash("Shared Buffer Lookup Table",
-								  size, size,
-								  &info,
-								  HASH_ELEM | HASH_BLOBS | HASH_PARTITION);
+	if (!foundRegions || !foundEntries)
+	{
+		int			i;
+		Size		j;
+
+		Assert(!foundRegions && !foundEntries);
+
+		for (i = 0; i < NUM_BUFFER_PARTITIONS; i++)
+		{
+			pg_atomic_init_u32(&SharedBufRegions[i].r.version, 0);
+			SharedBufRegions[i].r.nentries = 0;
+		}
+		for (j = 0; j < nentries; j++)
+			SharedBufEntries[j].id = -1;
+	}
 }
 
 /*
@@ -79,31 +172,109 @@ InitBufTable(int size)
 uint32
 BufTableHashCode(BufferTag *tagPtr)
 {
-	return get_hash_value(SharedBufHash, (void *) tagPtr);
+	return DatumGetUInt32(hash_any((const unsigned char *) tagPtr,
+								   sizeof(BufferTag)));
+}
+
+/*
+ * Probe one region for the given tag, without regard to concurrent
+ * modifications.  Returns the slot number, or -1 if not found.
+ */
+static inline int
+BufTableProbe(BufferLookupEnt *entries, BufferTag *tagPtr, uint32 hashcode)
+{
+	uint32		mask = SharedBufRegionSize - 1;
+	uint32		slot = BufTableHomeSlot(hashcode);
+	uint32		nprobes;
+
+	/* bounded, since a torn read could otherwise loop forever */
+	for (nprobes = 0; nprobes < SharedBufRegionSize; nprobes++)
+	{
+		BufferLookupEnt *ent = &entries[slot];
+
+		if (ent->id < 0)
+			break;
+		if (ent->hashcode == hashcode && BUFFERTAGS_EQUAL(ent->key, *tagPtr))
+			return (int) slot;
+		slot = (slot + 1) & mask;
+	}
+
+	return -1;
 }
 
 /*
  * BufTableLookup
  *		Lookup the given BufferTag; return buffer ID, or -1 if not found
  *
- * Caller must hold at least share lock on BufMappingLock for tag's partition
+ * No lock is required.  If the caller holds at least share lock on the
+ * BufMappingLock for tag's partition, the result is exact; otherwise it
+ * reflects some state of the table during the call, and a buffer found
+ * must be pinned and its tag rechecked before it can be trusted.
  */
 int
 BufTableLookup(BufferTag *tagPtr, uint32 hashcode)
 {
-	BufferLookupEnt *result;
+	uint32		region_index = BufTableRegionIndex(hashcode);
+	BufTableRegion *region = &SharedBufRegions[region_index];
+	BufferLookupEnt *entries = BufTableRegionEntries(region_index);
+	SpinDelayStatus delayStatus;
+	bool		waited = false;
+
+	for (;;)
+	{
+		uint32		version;
+		int			slot;
+		int			result;
+
+		version = pg_atomic_read_u32(&region->r.version);
+		if (version & 1)
+		{
+			/* a writer is busy in this region; wait for it to finish */
+			if (!waited)
+			{
+				init_local_spin_delay(&delayStatus);
+				waited = true;
+			}
+			perform_spin_delay(&delayStatus);
+			continue;
+		}
+
+		pg_read_barrier();
+		slot = BufTableProbe(entries, tagPtr, hashcode);
+		result = (slot >= 0) ? entries[slot].id : -1;
+		pg_read_barrier();
+
+		if (pg_atomic_read_u32(&region->r.version) == version)
+		{
+			if (waited)
+				finish_spin_delay(&delayStatus);
+			return result;
+		}
+	}
+}
+
+/*
+ * Mark the start and end of a modification of a region.  There is only one
+ * writer at a time, so plain atomic reads and writes are sufficient.
+ */
+static inline void
+BufTableBeginWrite(BufTableRegion *region)
+{
+	uint32		version = pg_atomic_read_u32(&region->r.version);
 
-	result = (BufferLookupEnt *)
-		hash_search_with_hash_value(SharedBufHash,
-									(void *) tagPtr,
-									hashcode,
-									HASH_FIND,
-									NULL);
+	Assert((version & 1) == 0);
+	pg_atomic_write_u32(&region->r.version, version + 1);
+	pg_write_barrier();
+}
 
-	if (!result)
-		return -1;
+static inline void
+BufTableEndWrite(BufTableRegion *region)
+{
+	uint32		version = pg_atomic_read_u32(&region->r.version);
 
-	return result->id;
+	Assert((version & 1) == 1);
+	pg_write_barrier();
+	pg_atomic_write_u32(&region->r.version, version + 1);
 }
 
 /*
@@ -119,23 +290,42 @@ BufTableLookup(BufferTag *tagPtr, uint32 hashcode)
 int
 BufTableInsert(BufferTag *tagPtr, uint32 hashcode, int buf_id)
 {
-	BufferLookupEnt *result;
-	bool		found;
+	uint32		region_index = BufTableRegionIndex(hashcode);
+	BufTableRegion *region = &SharedBufRegions[region_index];
+	BufferLookupEnt *entries = BufTableRegionEntries(region_index);
+	uint32		mask = SharedBufRegionSize - 1;
+	uint32		slot;
 
 	Assert(buf_id >= 0);		/* -1 is reserved for not-in-table */
 	Assert(tagPtr->blockNum != P_NEW);	/* invalid tag */
 
-	result = (BufferLookupEnt *)
-		hash_search_with_hash_value(SharedBufHash,
-									(void *) tagPtr,
-									hashcode,
-									HASH_ENTER,
-									&found);
+	/* Since we hold the lock, nobody else can be changing the region */
+	slot = BufTableHomeSlot(hashcode);
+	for (;;)
+	{
+		BufferLookupEnt *ent = &entries[slot];
+
+		if (ent->id < 0)
+			break;
+		if (ent->hashcode == hashcode && BUFFERTAGS_EQUAL(ent->key, *tagPtr))
+			return ent->id;		/* found something already in the table */
+		slot = (slot + 1) & mask;
+	}
 
-	if (found)					/* found something already in the table */
-		return result->id;
+	/* Keep at least one free slot, so that probes always terminate */
+	if (region->r.nentries >= SharedBufRegionSize - 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_OUT_OF_MEMORY),
+				 errmsg("out of shared memory"),
+				 errdetail("Shared buffer lookup table partition %u is full.",
+						   region_index)));
 
-	result->id = buf_id;
+	BufTableBeginWrite(region);
+	entries[slot].hashcode = hashcode;
+	entries[slot].key = *tagPtr;
+	entries[slot].id = buf_id;
+	region->r.nentries++;
+	BufTableEndWrite(region);
 
 	return -1;
 }
@@ -149,15 +339,44 @@ BufTableInsert(BufferTag *tagPtr, uint32 hashcode, int buf_id)
 void
 BufTableDelete(BufferTag *tagPtr, uint32 hashcode)
 {
-	BufferLookupEnt *result;
-
-	result = (BufferLookupEnt *)
-		hash_search_with_hash_value(SharedBufHash,
-									(void *) tagPtr,
-									hashcode,
-									HASH_REMOVE,
-									NULL);
+	uint32		region_index = BufTableRegionIndex(hashcode);
+	BufTableRegion *region = &SharedBufRegions[region_index];
+	BufferLookupEnt *entries = BufTableRegionEntries(region_index);
+	uint32		mask = SharedBufRegionSize - 1;
+	int			found;
+	uint32		hole;
+	uint32		slot;
 
-	if (!result)				/* shouldn't happen */
+	found = BufTableProbe(entries, tagPtr, hashcode);
+	if (found < 0)				/* shouldn't happen */
 		elog(ERROR, "shared buffer hash table corrupted");
+
+	BufTableBeginWrite(region);
+
+	/*
+	 * Close the hole by shifting back any following entries of the probe
+	 * sequence whose home slot doesn't lie cyclically within (hole, slot].
+	 */
+	hole = (uint32) found;
+	slot = hole;
+	for (;;)
+	{
+		uint32		home;
+
+		slot = (slot + 1) & mask;
+		if (entries[slot].id < 0)
+			break;
+
+		home = BufTableHomeSlot(entries[slot].hashcode);
+		if (hole <= slot ? (hole < home && home <= slot)
+			: (hole < home || home <= slot))
+			continue;
+
+		entries[hole] = entries[slot];
+		hole = slot;
+	}
+	entries[hole].id = -1;
+	region->r.nentries--;
+
+	BufTableEndWrite(region);
 }
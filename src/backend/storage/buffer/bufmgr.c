@@ -43,11 +43,14 @@
 #include "pgstat.h"
 #include "postmaster/bgwriter.h"
 #include "storage/buf_internals.h"
+#include "storage/doublewrite.h"
 #include "storage/bufmgr.h"
 #include "storage/ipc.h"
 #include "storage/proc.h"
 #include "storage/smgr.h"
 #include "storage/standby.h"
+#include "utils/hashutils.h"
+#include "utils/memutils.h"
 #include "utils/rel.h"
 #include "utils/resowner_private.h"
 #include "utils/timestamp.h"
@@ -73,6 +76,16 @@ typedef struct PrivateRefCountEntry
 	int32		refcount;
 } PrivateRefCountEntry;
 
+/*
+ * Entry of the overflow hashtable.  simplehash needs a status field, which
+ * is kept out of PrivateRefCountEntry so that the array stays small.
+ */
+typedef struct PrivateRefCountHashEntry
+{
+	PrivateRefCountEntry data;
+	char		status;			/* hash status */
+} PrivateRefCountHashEntry;
+
 /* 64 bytes, about the size of a cache line on common systems */
 #define REFCOUNT_ARRAY_ENTRIES 8
 
@@ -102,12 +115,17 @@ typedef struct CkptTsStatus
 
 	/* current offset in CkptBufferIds for this tablespace */
 	int			index;
+
+	/* tag of the last page written in this tablespace, if any */
+	bool		written_any;
+	BufferTag	last_written;
 } CkptTsStatus;
 
 /* GUC variables */
 bool		zero_damaged_pages = false;
 int			bgwriter_lru_maxpages = 100;
 double		bgwriter_lru_multiplier = 2.0;
+int			bgwriter_freelist_target = 0;
 bool		track_io_timing = false;
 int			effective_io_concurrency = 0;
 
@@ -164,9 +182,24 @@ static BufferDesc *PinCountWaitBuf = NULL;
  * fill it with NewPrivateRefCountEntry(). That split lets us avoid doing
  * memory allocations in NewPrivateRefCountEntry() which can be important
  * because in some scenarios it's called with a spinlock held...
+ *
+ * The overflow table is a simplehash table, so entries may move whenever an
+ * entry is inserted or deleted; never keep a pointer to a hashed entry
+ * across such an operation.
  */
+#define SH_PREFIX refcount
+#define SH_ELEMENT_TYPE PrivateRefCountHashEntry
+#define SH_KEY_TYPE Buffer
+#define SH_KEY data.buffer
+#define SH_HASH_KEY(tb, key) murmurhash32((uint32) (key))
+#define SH_EQUAL(tb, a, b) ((a) == (b))
+#define SH_SCOPE static inline
+#define SH_DEFINE
+#define SH_DECLARE
+#include "lib/simplehash.h"
+
 static struct PrivateRefCountEntry PrivateRefCountArray[REFCOUNT_ARRAY_ENTRIES];
-static HTAB *PrivateRefCountHash = NULL;
+static refcount_hash *PrivateRefCountHash = NULL;
 static int32 PrivateRefCountOverflowed = 0;
 static uint32 PrivateRefCountClock = 0;
 static PrivateRefCountEntry *ReservedRefCountEntry = NULL;
@@ -219,7 +252,7 @@ ReservePrivateRefCountEntry(void)
 		 * Move entry from the current clock position in the array into the
 		 * hashtable. Use that slot.
 		 */
-		PrivateRefCountEntry *hashent;
+		PrivateRefCountHashEntry *hashent;
 		bool		found;
 
 		/* select victim slot */
@@ -230,12 +263,11 @@ ReservePrivateRefCountEntry(void)
 		Assert(ReservedRefCountEntry->buffer != InvalidBuffer);
 
 		/* enter victim array entry into hashtable */
-		hashent = hash_search(PrivateRefCountHash,
-							  (void *) &(ReservedRefCountEntry->buffer),
-							  HASH_ENTER,
-							  &found);
+		hashent = refcount_insert(PrivateRefCountHash,
+								  ReservedRefCountEntry->buffer,
+								  &found);
 		Assert(!found);
-		hashent->refcount = ReservedRefCountEntry->refcount;
+		hashent->data.refcount = ReservedRefCountEntry->refcount;
 
 		/* clear the now free array slot */
 		ReservedRefCountEntry->buffer = InvalidBuffer;
@@ -278,6 +310,7 @@ static PrivateRefCountEntry *
 GetPrivateRefCountEntry(Buffer buffer, bool do_move)
 {
 	PrivateRefCountEntry *res;
+	PrivateRefCountHashEntry *hashent;
 	int			i;
 
 	Assert(BufferIsValid(buffer));
@@ -305,25 +338,26 @@ GetPrivateRefCountEntry(Buffer buffer, bool do_move)
 	if (PrivateRefCountOverflowed == 0)
 		return NULL;
 
-	res = hash_search(PrivateRefCountHash,
-					  (void *) &buffer,
-					  HASH_FIND,
-					  NULL);
+	hashent = refcount_lookup(PrivateRefCountHash, buffer);
 
-	if (res == NULL)
+	if (hashent == NULL)
 		return NULL;
 	else if (!do_move)
 	{
 		/* caller doesn't want us to move the hash entry into the array */
-		return res;
+		return &hashent->data;
 	}
 	else
 	{
 		/* move buffer from hashtable into the free array slot */
 		bool		found;
+		int32		refcount = hashent->data.refcount;
 		PrivateRefCountEntry *free;
 
-		/* Ensure there's a free array slot */
+		/*
+		 * Ensure there's a free array slot.  This may move another entry into
+		 * the hashtable, which invalidates "hashent".
+		 */
 		ReservePrivateRefCountEntry();
 
 		/* Use up the reserved slot */
@@ -334,13 +368,10 @@ GetPrivateRefCountEntry(Buffer buffer, bool do_move)
 
 		/* and fill it */
 		free->buffer = buffer;
-		free->refcount = res->refcount;
+		free->refcount = refcount;
 
 		/* delete from hashtable */
-		hash_search(PrivateRefCountHash,
-					(void *) &buffer,
-					HASH_REMOVE,
-					&found);
+		found = refcount_delete(PrivateRefCountHash, buffer);
 		Assert(found);
 		Assert(PrivateRefCountOverflowed > 0);
 		PrivateRefCountOverflowed--;
@@ -399,10 +430,7 @@ ForgetPrivateRefCountEntry(PrivateRefCountEntry *ref)
 		bool		found;
 		Buffer		buffer = ref->buffer;
 
-		hash_search(PrivateRefCountHash,
-					(void *) &buffer,
-					HASH_REMOVE,
-					&found);
+		found = refcount_delete(PrivateRefCountHash, buffer);
 		Assert(found);
 		Assert(PrivateRefCountOverflowed > 0);
 		PrivateRefCountOverflowed--;
@@ -433,6 +461,8 @@ static Buffer ReadBuffer_common(SMgrRelation reln, char relpersistence,
 				  ReadBufferMode mode, BufferAccessStrategy strategy,
 				  bool *hit);
 static bool PinBuffer(BufferDesc *buf, BufferAccessStrategy strategy);
+static bool PinBufferIfTagMatches(BufferDesc *buf, BufferTag *tag,
+					  BufferAccessStrategy strategy, bool *valid);
 static void PinBuffer_Locked(BufferDesc *buf);
 static void UnpinBuffer(BufferDesc *buf, bool fixOwner);
 static void BufferSync(int flags);
@@ -450,7 +480,8 @@ static BufferDesc *BufferAlloc(SMgrRelation smgr,
 			BlockNumber blockNum,
 			BufferAccessStrategy strategy,
 			bool *foundPtr);
-static void FlushBuffer(BufferDesc *buf, SMgrRelation reln);
+static void FlushBuffer(BufferDesc *buf, SMgrRelation reln,
+			IOContext io_context);
 static void AtProcExit_Buffers(int code, Datum arg);
 static void CheckForBufferLeaks(void);
 static int	rnode_comparator(const void *p1, const void *p2);
@@ -517,6 +548,62 @@ ComputeIoConcurrency(int io_concurrency, double *target)
 	return (new_prefetch_pages >= 0.0 && new_prefetch_pages < (double) INT_MAX);
 }
 
+/*
+ * PrefetchSharedBuffer -- initiate asynchronous read of a block of a
+ *		relation that uses shared buffers, given only its smgr relation
+ *
+ * This is the part of PrefetchBuffer that doesn't need a relcache entry, for
+ * the benefit of WAL replay.  Returns true if a prefetch was issued, false
+ * if the block is in the buffer pool already (or prefetching isn't compiled
+ * in).
+ */
+bool
+PrefetchSharedBuffer(SMgrRelation smgr_reln, ForkNumber forkNum,
+					 BlockNumber blockNum)
+{
+#ifdef USE_PREFETCH
+	BufferTag	newTag;			/* identity of requested block */
+	uint32		newHash;		/* hash value for newTag */
+	int			buf_id;
+
+	Assert(BlockNumberIsValid(blockNum));
+
+	/* create a tag so we can lookup the buffer */
+	INIT_BUFFERTAG(newTag, smgr_reln->smgr_rnode.node,
+				   forkNum, blockNum);
+
+	/* determine its hash code */
+	newHash = BufTableHashCode(&newTag);
+
+	/*
+	 * See if the block is in the buffer pool already.  This is only a hint,
+	 * so there's no need for the mapping lock: at worst we issue a useless
+	 * prefetch, or skip a useful one.
+	 */
+	buf_id = BufTableLookup(&newTag, newHash);
+
+	/* If not in buffers, initiate prefetch */
+	if (buf_id < 0)
+	{
+		smgrprefetch(smgr_reln, forkNum, blockNum);
+		return true;
+	}
+
+	/*
+	 * If the block *is* in buffers, we do nothing.  This is not really
+	 * ideal: the block might be just about to be evicted, which would be
+	 * stupid since we know we are going to need it soon.  But the only easy
+	 * answer is to bump the usage_count, which does not seem like a great
+	 * solution: when the caller does ultimately touch the block, usage_count
+	 * would get bumped again, resulting in too much favoritism for blocks
+	 * that are involved in a prefetch sequence. A real fix would involve
+	 * some additional per-buffer state, and it's not clear that there's
+	 * enough of a problem to justify that.
+	 */
+#endif							/* USE_PREFETCH */
+	return false;
+}
+
 /*
  * PrefetchBuffer -- initiate asynchronous read of a block of a relation
  *
@@ -547,41 +634,7 @@ PrefetchBuffer(Relation reln, ForkNumber forkNum, BlockNumber blockNum)
 		LocalPrefetchBuffer(reln->rd_smgr, forkNum, blockNum);
 	}
 	else
-	{
-		BufferTag	newTag;		/* identity of requested block */
-		uint32		newHash;	/* hash value for newTag */
-		LWLock	   *newPartitionLock;	/* buffer partition lock for it */
-		int			buf_id;
-
-		/* create a tag so we can lookup the buffer */
-		INIT_BUFFERTAG(newTag, reln->rd_smgr->smgr_rnode.node,
-					   forkNum, blockNum);
-
-		/* determine its hash code and partition lock ID */
-		newHash = BufTableHashCode(&newTag);
-		newPartitionLock = BufMappingPartitionLock(newHash);
-
-		/* see if the block is in the buffer pool already */
-		LWLockAcquire(newPartitionLock, LW_SHARED);
-		buf_id = BufTableLookup(&newTag, newHash);
-		LWLockRelease(newPartitionLock);
-
-		/* If not in buffers, initiate prefetch */
-		if (buf_id < 0)
-			smgrprefetch(reln->rd_smgr, forkNum, blockNum);
-
-		/*
-		 * If the block *is* in buffers, we do nothing.  This is not really
-		 * ideal: the block might be just about to be evicted, which would be
-		 * stupid since we know we are going to need it soon.  But the only
-		 * easy answer is to bump the usage_count, which does not seem like a
-		 * great solution: when the caller does ultimately touch the block,
-		 * usage_count would get bumped again, resulting in too much
-		 * favoritism for blocks that are involved in a prefetch sequence. A
-		 * real fix would involve some additional per-buffer state, and it's
-		 * not clear that there's enough of a problem to justify that.
-		 */
-	}
+		(void) PrefetchSharedBuffer(reln->rd_smgr, forkNum, blockNum);
 #endif							/* USE_PREFETCH */
 }
 
@@ -694,6 +747,25 @@ ReadBufferWithoutRelcache(RelFileNode rnode, ForkNumber forkNum,
 }
 
 
+/*
+ * IOContextForStrategy -- the pg_stat_io context of I/O done with a strategy
+ */
+static inline IOContext
+IOContextForStrategy(BufferAccessStrategy strategy)
+{
+	switch (StrategyGetType(strategy))
+	{
+		case BAS_BULKREAD:
+			return IOCONTEXT_BULKREAD;
+		case BAS_BULKWRITE:
+			return IOCONTEXT_BULKWRITE;
+		case BAS_VACUUM:
+			return IOCONTEXT_VACUUM;
+		default:
+			return IOCONTEXT_NORMAL;
+	}
+}
+
 /*
  * ReadBuffer_common -- common logic for all ReadBuffer variants
  *
@@ -709,6 +781,7 @@ ReadBuffer_common(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 	bool		found;
 	bool		isExtend;
 	bool		isLocalBuf = SmgrIsTemp(smgr);
+	IOContext	io_context = IOContextForStrategy(strategy);
 
 	*hit = false;
 
@@ -748,7 +821,11 @@ ReadBuffer_common(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 		bufHdr = BufferAlloc(smgr, relpersistence, forkNum, blockNum,
 							 strategy, &found);
 		if (found)
+		{
 			pgBufferUsage.shared_blks_hit++;
+			if (!isExtend)
+				pgstat_count_io(io_context, hits);
+		}
 		else if (isExtend)
 			pgBufferUsage.shared_blks_written++;
 		else if (mode == RBM_NORMAL || mode == RBM_NORMAL_NO_LOG ||
@@ -869,6 +946,8 @@ ReadBuffer_common(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 		MemSet((char *) bufBlock, 0, BLCKSZ);
 		/* don't set checksum for all-zero page */
 		smgrextend(smgr, forkNum, blockNum, (char *) bufBlock, false);
+		if (!isLocalBuf)
+			pgstat_count_io(io_context, extends);
 
 		/*
 		 * NB: we're *not* doing a ScheduleBufferTagForWriteback here;
@@ -894,6 +973,8 @@ ReadBuffer_common(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 				INSTR_TIME_SET_CURRENT(io_start);
 
 			smgrread(smgr, forkNum, blockNum, (char *) bufBlock);
+			if (!isLocalBuf)
+				pgstat_count_io(io_context, reads);
 
 			if (track_io_timing)
 			{
@@ -901,6 +982,9 @@ ReadBuffer_common(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 				INSTR_TIME_SUBTRACT(io_time, io_start);
 				pgstat_count_buffer_read_time(INSTR_TIME_GET_MICROSEC(io_time));
 				INSTR_TIME_ADD(pgBufferUsage.blk_read_time, io_time);
+				if (!isLocalBuf)
+					pgstat_count_io_time(io_context, read_time,
+										 INSTR_TIME_GET_MICROSEC(io_time));
 			}
 
 			/* check for garbage data */
@@ -1014,7 +1098,31 @@ BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 	newHash = BufTableHashCode(&newTag);
 	newPartitionLock = BufMappingPartitionLock(newHash);
 
-	/* see if the block is in the buffer pool already */
+	/*
+	 * First try to find and pin the buffer without taking the mapping lock.
+	 * The lookup result can be stale, so the buffer is pinned only if it
+	 * still holds the page we want; once pinned it can't be given a new
+	 * identity.  If the tag doesn't match, the buffer is being recycled or
+	 * invalidated, and we fall back to the locked lookup below.
+	 */
+	buf_id = BufTableLookup(&newTag, newHash);
+	if (buf_id >= 0)
+	{
+		buf = GetBufferDescriptor(buf_id);
+
+		if (PinBufferIfTagMatches(buf, &newTag, strategy, &valid))
+		{
+			*foundPtr = true;
+
+			/* see below for why StartBufferIO might be needed */
+			if (!valid && StartBufferIO(buf, true))
+				*foundPtr = false;
+
+			return buf;
+		}
+	}
+
+	/* see if the block is in the buffer pool, this time holding the lock */
 	LWLockAcquire(newPartitionLock, LW_SHARED);
 	buf_id = BufTableLookup(&newTag, newHash);
 	if (buf_id >= 0)
@@ -1143,7 +1251,7 @@ BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 														  smgr->smgr_rnode.node.dbNode,
 														  smgr->smgr_rnode.node.relNode);
 
-				FlushBuffer(buf, NULL);
+				FlushBuffer(buf, NULL, IOContextForStrategy(strategy));
 				LWLockRelease(BufferDescriptorGetContentLock(buf));
 
 				ScheduleBufferTagForWriteback(&BackendWritebackContext,
@@ -1637,6 +1745,95 @@ PinBuffer(BufferDesc *buf, BufferAccessStrategy strategy)
 	return result;
 }
 
+/*
+ * PinBufferIfTagMatches -- pin a buffer found without the mapping lock
+ *
+ * Like PinBuffer, but the buffer is pinned only if it still holds the page
+ * identified by "tag".  The tag is checked inside the CAS loop, so that a
+ * buffer that is plainly being recycled is neither pinned nor given a usage
+ * count it didn't earn.  That check alone isn't enough, though: the buffer
+ * can be given a new identity and be unpinned again between our read of
+ * the tag and the CAS, leaving the state word exactly as we read it.  So
+ * the tag is checked again once the pin is held, when it can no longer
+ * change, and the pin is dropped if it doesn't match.
+ *
+ * Returns true if the buffer was pinned, and sets *valid to whether it is
+ * BM_VALID.
+ */
+static bool
+PinBufferIfTagMatches(BufferDesc *buf, BufferTag *tag,
+					  BufferAccessStrategy strategy, bool *valid)
+{
+	Buffer		b = BufferDescriptorGetBuffer(buf);
+	PrivateRefCountEntry *ref;
+	uint32		buf_state;
+	uint32		old_buf_state;
+
+	ref = GetPrivateRefCountEntry(b, true);
+
+	if (ref != NULL)
+	{
+		/* we hold a pin already, so the tag can't change under us */
+		if (!BUFFERTAGS_EQUAL(buf->tag, *tag))
+			return false;
+		*valid = true;
+		ref->refcount++;
+		ResourceOwnerRememberBuffer(CurrentResourceOwner, b);
+		return true;
+	}
+
+	ReservePrivateRefCountEntry();
+
+	old_buf_state = pg_atomic_read_u32(&buf->state);
+	for (;;)
+	{
+		if (old_buf_state & BM_LOCKED)
+			old_buf_state = WaitBufHdrUnlocked(buf);
+
+		/* read the tag only after the state it goes with */
+		pg_read_barrier();
+		if (!(old_buf_state & BM_TAG_VALID) ||
+			!BUFFERTAGS_EQUAL(buf->tag, *tag))
+			return false;
+
+		buf_state = old_buf_state;
+
+		/* increase refcount */
+		buf_state += BUF_REFCOUNT_ONE;
+
+		/* increase usagecount, following the same rules as PinBuffer */
+		if (strategy == NULL)
+		{
+			if (BUF_STATE_GET_USAGECOUNT(buf_state) < BM_MAX_USAGE_COUNT)
+				buf_state += BUF_USAGECOUNT_ONE;
+		}
+		else
+		{
+			if (BUF_STATE_GET_USAGECOUNT(buf_state) == 0)
+				buf_state += BUF_USAGECOUNT_ONE;
+		}
+
+		if (pg_atomic_compare_exchange_u32(&buf->state, &old_buf_state,
+										   buf_state))
+			break;
+	}
+
+	ref = NewPrivateRefCountEntry(b);
+	ref->refcount++;
+	Assert(ref->refcount > 0);
+	ResourceOwnerRememberBuffer(CurrentResourceOwner, b);
+
+	/* the CAS acts as a barrier for reading the tag again */
+	if (!(buf_state & BM_TAG_VALID) || !BUFFERTAGS_EQUAL(buf->tag, *tag))
+	{
+		UnpinBuffer(buf, true);
+		return false;
+	}
+
+	*valid = (buf_state & BM_VALID) != 0;
+	return true;
+}
+
 /*
  * PinBuffer_Locked -- as above, but caller already locked the buffer header.
  * The spinlock is released before return.
@@ -1989,9 +2186,31 @@ BufferSync(int flags)
 		{
 			if (SyncOneBuffer(buf_id, false, &wb_context) & BUF_WRITTEN)
 			{
+				BufferTag	tag;
+
 				TRACE_POSTGRESQL_BUFFER_SYNC_WRITTEN(buf_id);
 				BgWriterStats.m_buf_written_checkpoints++;
 				num_written++;
+
+				/*
+				 * Once this tablespace moves on to another relation fork, the
+				 * files of the previous one can be synced ahead of the end of
+				 * the checkpoint.  If the buffer got replaced since we wrote
+				 * it, we might pick the wrong file, which is harmless.
+				 */
+				buf_state = LockBufHdr(bufHdr);
+				tag = bufHdr->tag;
+				UnlockBufHdr(bufHdr, buf_state);
+
+				if (ts_stat->written_any &&
+					(!RelFileNodeEquals(tag.rnode,
+										ts_stat->last_written.rnode) ||
+					 tag.forkNum != ts_stat->last_written.forkNum))
+					smgrsyncready(ts_stat->last_written.rnode,
+								  ts_stat->last_written.forkNum,
+								  ts_stat->last_written.blockNum);
+				ts_stat->last_written = tag;
+				ts_stat->written_any = true;
 			}
 		}
 
@@ -2086,6 +2305,7 @@ BgBufferSync(WritebackContext *wb_context)
 	int			num_to_scan;
 	int			num_written;
 	int			reusable_buffers;
+	int			freelist_len;
 
 	/* Variables for final smoothed_density update */
 	long		new_strategy_delta;
@@ -2261,6 +2481,12 @@ BgBufferSync(WritebackContext *wb_context)
 	 * next_to_clean point, until we have lapped the strategy scan, or cleaned
 	 * enough buffers to match our estimate of the next cycle's allocation
 	 * requirements, or hit the bgwriter_lru_maxpages limit.
+	 *
+	 * With bgwriter_freelist_target set, also put the reusable buffers we
+	 * come across on the freelist until it holds that many, scanning further
+	 * if needed, so that backends can take a clean victim from there rather
+	 * than running the clock sweep into dirty buffers and writing them
+	 * themselves.
 	 */
 
 	/* Make sure we can handle the pin inside SyncOneBuffer */
@@ -2269,13 +2495,23 @@ BgBufferSync(WritebackContext *wb_context)
 	num_to_scan = bufs_to_lap;
 	num_written = 0;
 	reusable_buffers = reusable_buffers_est;
+	freelist_len = StrategyFreeListLength();
 
 	/* Execute the LRU scan */
-	while (num_to_scan > 0 && reusable_buffers < upcoming_alloc_est)
+	while (num_to_scan > 0 &&
+		   (reusable_buffers < upcoming_alloc_est ||
+			freelist_len < bgwriter_freelist_target))
 	{
 		int			sync_state = SyncOneBuffer(next_to_clean, true,
 											   wb_context);
 
+		if ((sync_state & BUF_REUSABLE) &&
+			freelist_len < bgwriter_freelist_target)
+		{
+			StrategyPushCleanBuffer(GetBufferDescriptor(next_to_clean));
+			freelist_len++;
+		}
+
 		if (++next_to_clean >= NBuffers)
 		{
 			next_to_clean = 0;
@@ -2397,7 +2633,7 @@ SyncOneBuffer(int buf_id, bool skip_recently_used, WritebackContext *wb_context)
 	PinBuffer_Locked(bufHdr);
 	LWLockAcquire(BufferDescriptorGetContentLock(bufHdr), LW_SHARED);
 
-	FlushBuffer(bufHdr, NULL);
+	FlushBuffer(bufHdr, NULL, IOCONTEXT_NORMAL);
 
 	LWLockRelease(BufferDescriptorGetContentLock(bufHdr));
 
@@ -2442,16 +2678,9 @@ AtEOXact_Buffers(bool isCommit)
 void
 InitBufferPoolAccess(void)
 {
-	HASHCTL		hash_ctl;
-
 	memset(&PrivateRefCountArray, 0, sizeof(PrivateRefCountArray));
 
-	MemSet(&hash_ctl, 0, sizeof(hash_ctl));
-	hash_ctl.keysize = sizeof(int32);
-	hash_ctl.entrysize = sizeof(PrivateRefCountEntry);
-
-	PrivateRefCountHash = hash_create("PrivateRefCount", 100, &hash_ctl,
-									  HASH_ELEM | HASH_BLOBS);
+	PrivateRefCountHash = refcount_create(TopMemoryContext, 100, NULL);
 }
 
 /*
@@ -2515,12 +2744,13 @@ CheckForBufferLeaks(void)
 	/* if necessary search the hash */
 	if (PrivateRefCountOverflowed)
 	{
-		HASH_SEQ_STATUS hstat;
+		PrivateRefCountHashEntry *hashent;
+		refcount_iterator iter;
 
-		hash_seq_init(&hstat, PrivateRefCountHash);
-		while ((res = (PrivateRefCountEntry *) hash_seq_search(&hstat)) != NULL)
+		refcount_start_iterate(PrivateRefCountHash, &iter);
+		while ((hashent = refcount_iterate(PrivateRefCountHash, &iter)) != NULL)
 		{
-			PrintBufferLeakWarning(res->buffer);
+			PrintBufferLeakWarning(hashent->data.buffer);
 			RefCountErrors++;
 		}
 
@@ -2584,7 +2814,9 @@ CheckPointBuffers(int flags)
 	BufferSync(flags);
 	CheckpointStats.ckpt_sync_t = GetCurrentTimestamp();
 	TRACE_POSTGRESQL_BUFFER_CHECKPOINT_SYNC_START();
+	DoubleWriteStartCheckpoint();
 	smgrsync();
+	DoubleWriteEndCheckpoint();
 	CheckpointStats.ckpt_sync_end_t = GetCurrentTimestamp();
 	TRACE_POSTGRESQL_BUFFER_CHECKPOINT_DONE();
 }
@@ -2665,10 +2897,11 @@ BufferGetTag(Buffer buffer, RelFileNode *rnode, ForkNumber *forknum,
  * written.)
  *
  * If the caller has an smgr reference for the buffer's relation, pass it
- * as the second parameter.  If not, pass NULL.
+ * as the second parameter.  If not, pass NULL.  io_context is the context
+ * the write is counted under in pg_stat_io.
  */
 static void
-FlushBuffer(BufferDesc *buf, SMgrRelation reln)
+FlushBuffer(BufferDesc *buf, SMgrRelation reln, IOContext io_context)
 {
 	XLogRecPtr	recptr;
 	ErrorContextCallback errcallback;
@@ -2677,6 +2910,7 @@ FlushBuffer(BufferDesc *buf, SMgrRelation reln)
 	Block		bufBlock;
 	char	   *bufToWrite;
 	uint32		buf_state;
+	bool		use_dw;
 
 	/*
 	 * Acquire the buffer's io_in_progress lock.  If StartBufferIO returns
@@ -2751,6 +2985,18 @@ FlushBuffer(BufferDesc *buf, SMgrRelation reln)
 	if (track_io_timing)
 		INSTR_TIME_SET_CURRENT(io_start);
 
+	/*
+	 * With double_write, a durable copy of the page goes to the double-write
+	 * file first, so that a torn write can be repaired at crash recovery.
+	 * Unlogged relations are reset after a crash, so they don't need one.
+	 */
+	use_dw = double_write && (buf_state & BM_PERMANENT);
+	if (use_dw)
+		DoubleWriteBeginPage(buf->tag.rnode,
+							 buf->tag.forkNum,
+							 buf->tag.blockNum,
+							 bufToWrite);
+
 	/*
 	 * bufToWrite is either the shared buffer or a copy, as appropriate.
 	 */
@@ -2760,15 +3006,21 @@ FlushBuffer(BufferDesc *buf, SMgrRelation reln)
 			  bufToWrite,
 			  false);
 
+	if (use_dw)
+		DoubleWriteEndPage();
+
 	if (track_io_timing)
 	{
 		INSTR_TIME_SET_CURRENT(io_time);
 		INSTR_TIME_SUBTRACT(io_time, io_start);
 		pgstat_count_buffer_write_time(INSTR_TIME_GET_MICROSEC(io_time));
 		INSTR_TIME_ADD(pgBufferUsage.blk_write_time, io_time);
+		pgstat_count_io_time(io_context, write_time,
+							 INSTR_TIME_GET_MICROSEC(io_time));
 	}
 
 	pgBufferUsage.shared_blks_written++;
+	pgstat_count_io(io_context, writes);
 
 	/*
 	 * Mark the buffer as clean (unless BM_JUST_DIRTIED has become set) and
@@ -3224,7 +3476,7 @@ FlushRelationBuffers(Relation rel)
 		{
 			PinBuffer_Locked(bufHdr);
 			LWLockAcquire(BufferDescriptorGetContentLock(bufHdr), LW_SHARED);
-			FlushBuffer(bufHdr, rel->rd_smgr);
+			FlushBuffer(bufHdr, rel->rd_smgr, IOCONTEXT_NORMAL);
 			LWLockRelease(BufferDescriptorGetContentLock(bufHdr));
 			UnpinBuffer(bufHdr, true);
 		}
@@ -3278,7 +3530,7 @@ FlushDatabaseBuffers(Oid dbid)
 		{
 			PinBuffer_Locked(bufHdr);
 			LWLockAcquire(BufferDescriptorGetContentLock(bufHdr), LW_SHARED);
-			FlushBuffer(bufHdr, NULL);
+			FlushBuffer(bufHdr, NULL, IOCONTEXT_NORMAL);
 			LWLockRelease(BufferDescriptorGetContentLock(bufHdr));
 			UnpinBuffer(bufHdr, true);
 		}
@@ -3305,7 +3557,7 @@ FlushOneBuffer(Buffer buffer)
 
 	Assert(LWLockHeldByMe(BufferDescriptorGetContentLock(bufHdr)));
 
-	FlushBuffer(bufHdr, NULL);
+	FlushBuffer(bufHdr, NULL, IOCONTEXT_NORMAL);
 }
 
 /*
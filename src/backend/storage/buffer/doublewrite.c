@@ -0,0 +1,470 @@
+/*-------------------------------------------------------------------------
+ *
+ * doublewrite.c
+ *	  Double-write buffer protecting data pages against torn writes.
+ *
+ * A crash in the middle of writing a data page can leave it partly old and
+ * partly new on disk, and redo can't start from such a page.  Normally
+ * full_page_writes takes care of that by putting an image of each page in
+ * WAL the first time it is modified after a checkpoint.  With double_write
+ * enabled, FlushBuffer() instead appends a copy of each page of a permanent
+ * relation to a file in pg_dblwr, and makes it durable, before writing the
+ * page in place.  Any page that may have been torn then has an intact copy;
+ * those are written back before redo starts, and WAL needs no page images.
+ *
+ * A copy must be kept until the in-place write that follows it is durable,
+ * which is when a checkpoint has synced the file.  Each checkpoint starts a
+ * new double-write file just before it absorbs the fsync requests it acts
+ * on, and removes the older files once those have all been synced.  Writers
+ * hold DoubleWriteGenLock in shared mode from copying a page until the
+ * in-place write has queued its fsync request, so every copy in an older
+ * file belongs to a write that the checkpoint does sync.
+ *
+ * Copies are appended under DoubleWriteInsertLock and made durable under
+ * DoubleWriteFlushLock.  A process that finds its copy already flushed by
+ * someone else skips the fdatasync, so concurrent writers share them.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/storage/buffer/doublewrite.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "miscadmin.h"
+#include "pgstat.h"
+#include "port/pg_crc32c.h"
+#include "storage/doublewrite.h"
+#include "storage/fd.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "storage/smgr.h"
+#include "utils/hsearch.h"
+#include "utils/memutils.h"
+
+#define DOUBLE_WRITE_DIR	"pg_dblwr"
+
+/*
+ * Each copy in a double-write file is a header followed by the page.
+ */
+typedef struct DoubleWriteHeader
+{
+	RelFileNode rnode;			/* the page's relation */
+	ForkNumber	forknum;		/* ... fork */
+	BlockNumber blkno;			/* ... and block number */
+	pg_crc32c	crc;			/* CRC of the above and the page */
+} DoubleWriteHeader;
+
+#define DOUBLE_WRITE_RECSIZE	(sizeof(DoubleWriteHeader) + BLCKSZ)
+
+/*
+ * Shared state.  gen is the number of the file copies currently go to, and
+ * is changed only with DoubleWriteGenLock held exclusively.  insert_off is
+ * protected by DoubleWriteInsertLock, flush_off by DoubleWriteFlushLock.
+ * oldest_gen and ckpt_gen are used only by the checkpointing process.
+ */
+typedef struct DoubleWriteCtlData
+{
+	uint32		gen;			/* current file */
+	off_t		insert_off;		/* end of copies written to it */
+	off_t		flush_off;		/* end of copies known to be durable */
+	uint32		oldest_gen;		/* oldest file that may still exist */
+	uint32		ckpt_gen;		/* file started by current checkpoint */
+} DoubleWriteCtlData;
+
+static DoubleWriteCtlData *DoubleWriteCtl = NULL;
+
+/* GUC variable */
+bool		double_write = false;
+
+/* this process's descriptor for the current file, if open */
+static int	dw_fd = -1;
+static uint32 dw_fd_gen = 0;
+
+/* buffer to assemble a copy in */
+static char dw_record[DOUBLE_WRITE_RECSIZE];
+
+/* key of touched-forks table used during restore */
+typedef struct DoubleWriteForkKey
+{
+	RelFileNode rnode;
+	ForkNumber	forknum;
+} DoubleWriteForkKey;
+
+
+static void
+DoubleWriteFilePath(char *path, uint32 gen)
+{
+	snprintf(path, MAXPGPATH, DOUBLE_WRITE_DIR "/%08X", gen);
+}
+
+/*
+ * Report shared-memory space needed by DoubleWriteShmemInit
+ */
+Size
+DoubleWriteShmemSize(void)
+{
+	return sizeof(DoubleWriteCtlData);
+}
+
+/*
+ * Allocate and initialize shared memory for the double-write buffer
+ */
+void
+DoubleWriteShmemInit(void)
+{
+	bool		found;
+
+	DoubleWriteCtl = (DoubleWriteCtlData *)
+		ShmemInitStruct("Double Write Ctl", DoubleWriteShmemSize(), &found);
+
+	if (!found)
+	{
+		DoubleWriteCtl->gen = 1;
+		DoubleWriteCtl->insert_off = 0;
+		DoubleWriteCtl->flush_off = 0;
+		DoubleWriteCtl->oldest_gen = 1;
+		DoubleWriteCtl->ckpt_gen = 1;
+	}
+}
+
+/*
+ * Create an empty double-write file, durably.
+ */
+static void
+DoubleWriteCreateFile(uint32 gen)
+{
+	char		path[MAXPGPATH];
+	int			fd;
+
+	DoubleWriteFilePath(path, gen);
+	fd = BasicOpenFile(path, O_RDWR | O_CREAT | O_TRUNC | PG_BINARY);
+	if (fd < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not create file \"%s\": %m", path)));
+	close(fd);
+	fsync_fname(path, false);
+	fsync_fname(DOUBLE_WRITE_DIR, true);
+}
+
+/*
+ * Write back the pages copied to one double-write file.  Reading stops at
+ * the first copy that is incomplete or fails its CRC check, since the file
+ * can only be damaged at its end, where a crash interrupted a write before
+ * the page itself was written in place.
+ */
+static int
+DoubleWriteRestoreFile(const char *path, HTAB *touched)
+{
+	PGAlignedBlock page;
+	DoubleWriteHeader hdr;
+	int			fd;
+	int			npages = 0;
+
+	fd = OpenTransientFile(path, O_RDONLY | PG_BINARY);
+	if (fd < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not open file \"%s\": %m", path)));
+
+	for (;;)
+	{
+		pg_crc32c	crc;
+		SMgrRelation reln;
+		DoubleWriteForkKey key;
+
+		pgstat_report_wait_start(WAIT_EVENT_DOUBLE_WRITE_READ);
+		if (read(fd, &hdr, sizeof(hdr)) != sizeof(hdr) ||
+			read(fd, page.data, BLCKSZ) != BLCKSZ)
+		{
+			pgstat_report_wait_end();
+			break;
+		}
+		pgstat_report_wait_end();
+
+		INIT_CRC32C(crc);
+		COMP_CRC32C(crc, &hdr, offsetof(DoubleWriteHeader, crc));
+		COMP_CRC32C(crc, page.data, BLCKSZ);
+		FIN_CRC32C(crc);
+		if (!EQ_CRC32C(crc, hdr.crc))
+			break;
+
+		/* Skip pages of relations dropped or truncated since */
+		reln = smgropen(hdr.rnode, InvalidBackendId);
+		if (!smgrexists(reln, hdr.forknum) ||
+			hdr.blkno >= smgrnblocks(reln, hdr.forknum))
+			continue;
+
+		smgrwrite(reln, hdr.forknum, hdr.blkno, page.data, true);
+		npages++;
+
+		memset(&key, 0, sizeof(key));
+		key.rnode = hdr.rnode;
+		key.forknum = hdr.forknum;
+		(void) hash_search(touched, &key, HASH_ENTER, NULL);
+	}
+
+	CloseTransientFile(fd);
+
+	return npages;
+}
+
+static int
+uint32_cmp(const void *a, const void *b)
+{
+	uint32		x = *(const uint32 *) a;
+	uint32		y = *(const uint32 *) b;
+
+	return (x > y) - (x < y);
+}
+
+/*
+ * DoubleWriteStartup
+ *		Clean out the double-write directory at server start.
+ *
+ * If restore is true, we are about to perform WAL redo after a crash, and
+ * the pages copied to the double-write files are first written back in
+ * place, oldest first, and synced.  The files are removed either way; redo
+ * starts from pages that are intact.
+ */
+void
+DoubleWriteStartup(bool restore)
+{
+	DIR		   *dir;
+	struct dirent *de;
+	uint32	   *gens;
+	int			ngens = 0;
+	int			maxgens = 16;
+	int			npages = 0;
+	char		path[MAXPGPATH];
+	int			i;
+
+	if (MakePGDirectory(DOUBLE_WRITE_DIR) < 0 && errno != EEXIST)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not create directory \"%s\": %m",
+						DOUBLE_WRITE_DIR)));
+
+	gens = (uint32 *) palloc(maxgens * sizeof(uint32));
+	dir = AllocateDir(DOUBLE_WRITE_DIR);
+	while ((de = ReadDir(dir, DOUBLE_WRITE_DIR)) != NULL)
+	{
+		if (strlen(de->d_name) != 8 ||
+			strspn(de->d_name, "0123456789ABCDEF") != 8)
+			continue;
+		if (ngens >= maxgens)
+		{
+			maxgens *= 2;
+			gens = (uint32 *) repalloc(gens, maxgens * sizeof(uint32));
+		}
+		gens[ngens++] = (uint32) strtoul(de->d_name, NULL, 16);
+	}
+	FreeDir(dir);
+
+	qsort(gens, ngens, sizeof(uint32), uint32_cmp);
+
+	if (restore && ngens > 0)
+	{
+		HASHCTL		ctl;
+		HTAB	   *touched;
+		HASH_SEQ_STATUS status;
+		DoubleWriteForkKey *key;
+
+		memset(&ctl, 0, sizeof(ctl));
+		ctl.keysize = sizeof(DoubleWriteForkKey);
+		ctl.entrysize = sizeof(DoubleWriteForkKey);
+		ctl.hcxt = CurrentMemoryContext;
+		touched = hash_create("Double Write Restored Forks", 64, &ctl,
+							  HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+
+		for (i = 0; i < ngens; i++)
+		{
+			DoubleWriteFilePath(path, gens[i]);
+			npages += DoubleWriteRestoreFile(path, touched);
+		}
+
+		hash_seq_init(&status, touched);
+		while ((key = (DoubleWriteForkKey *) hash_seq_search(&status)) != NULL)
+			smgrimmedsync(smgropen(key->rnode, InvalidBackendId),
+						  key->forknum);
+		hash_destroy(touched);
+
+		if (npages > 0)
+			ereport(LOG,
+					(errmsg("restored %d pages from double-write files",
+							npages)));
+	}
+
+	for (i = 0; i < ngens; i++)
+	{
+		DoubleWriteFilePath(path, gens[i]);
+		if (unlink(path) < 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not remove file \"%s\": %m", path)));
+	}
+	pfree(gens);
+
+	if (double_write)
+		DoubleWriteCreateFile(DoubleWriteCtl->gen);
+	else
+		fsync_fname(DOUBLE_WRITE_DIR, true);
+}
+
+/*
+ * DoubleWriteBeginPage
+ *		Durably copy a page that is about to be written in place.
+ *
+ * The caller must call DoubleWriteEndPage() once the in-place write is done.
+ */
+void
+DoubleWriteBeginPage(RelFileNode rnode, ForkNumber forknum,
+					 BlockNumber blkno, const char *page)
+{
+	DoubleWriteHeader hdr;
+	char		path[MAXPGPATH];
+	off_t		off;
+	off_t		end;
+
+	LWLockAcquire(DoubleWriteGenLock, LW_SHARED);
+
+	if (dw_fd < 0 || dw_fd_gen != DoubleWriteCtl->gen)
+	{
+		if (dw_fd >= 0)
+			close(dw_fd);
+		dw_fd_gen = DoubleWriteCtl->gen;
+		DoubleWriteFilePath(path, dw_fd_gen);
+		dw_fd = BasicOpenFile(path, O_RDWR | PG_BINARY);
+		if (dw_fd < 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not open file \"%s\": %m", path)));
+	}
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.rnode = rnode;
+	hdr.forknum = forknum;
+	hdr.blkno = blkno;
+	INIT_CRC32C(hdr.crc);
+	COMP_CRC32C(hdr.crc, &hdr, offsetof(DoubleWriteHeader, crc));
+	COMP_CRC32C(hdr.crc, page, BLCKSZ);
+	FIN_CRC32C(hdr.crc);
+
+	memcpy(dw_record, &hdr, sizeof(hdr));
+	memcpy(dw_record + sizeof(hdr), page, BLCKSZ);
+
+	/* Append the copy */
+	LWLockAcquire(DoubleWriteInsertLock, LW_EXCLUSIVE);
+	off = DoubleWriteCtl->insert_off;
+	errno = 0;
+	pgstat_report_wait_start(WAIT_EVENT_DOUBLE_WRITE_WRITE);
+	if (pg_pwrite(dw_fd, dw_record, DOUBLE_WRITE_RECSIZE, off) !=
+		DOUBLE_WRITE_RECSIZE)
+	{
+		/* if write didn't set errno, assume problem is no disk space */
+		if (errno == 0)
+			errno = ENOSPC;
+		DoubleWriteFilePath(path, dw_fd_gen);
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not write to file \"%s\": %m", path)));
+	}
+	pgstat_report_wait_end();
+	end = off + DOUBLE_WRITE_RECSIZE;
+	DoubleWriteCtl->insert_off = end;
+	LWLockRelease(DoubleWriteInsertLock);
+
+	/* Make it durable, unless someone else already did */
+	LWLockAcquire(DoubleWriteFlushLock, LW_EXCLUSIVE);
+	if (DoubleWriteCtl->flush_off < end)
+	{
+		off_t		target;
+
+		LWLockAcquire(DoubleWriteInsertLock, LW_SHARED);
+		target = DoubleWriteCtl->insert_off;
+		LWLockRelease(DoubleWriteInsertLock);
+
+		pgstat_report_wait_start(WAIT_EVENT_DOUBLE_WRITE_SYNC);
+		if (pg_fdatasync(dw_fd) != 0)
+		{
+			DoubleWriteFilePath(path, dw_fd_gen);
+			ereport(data_sync_elevel(ERROR),
+					(errcode_for_file_access(),
+					 errmsg("could not fdatasync file \"%s\": %m", path)));
+		}
+		pgstat_report_wait_end();
+		DoubleWriteCtl->flush_off = target;
+	}
+	LWLockRelease(DoubleWriteFlushLock);
+
+	/* DoubleWriteGenLock stays held until DoubleWriteEndPage() */
+}
+
+/*
+ * DoubleWriteEndPage
+ *		Finish a page write started with DoubleWriteBeginPage().
+ */
+void
+DoubleWriteEndPage(void)
+{
+	LWLockRelease(DoubleWriteGenLock);
+}
+
+/*
+ * DoubleWriteStartCheckpoint
+ *		Switch to a new double-write file.
+ *
+ * Called after a checkpoint has written out buffers, and before it absorbs
+ * the fsync requests to be synced.  Copies in older files are no longer
+ * needed once those are done.
+ */
+void
+DoubleWriteStartCheckpoint(void)
+{
+	uint32		newgen;
+
+	if (!double_write)
+		return;
+
+	LWLockAcquire(DoubleWriteGenLock, LW_EXCLUSIVE);
+	newgen = DoubleWriteCtl->gen + 1;
+	DoubleWriteCreateFile(newgen);
+	DoubleWriteCtl->gen = newgen;
+	DoubleWriteCtl->insert_off = 0;
+	DoubleWriteCtl->flush_off = 0;
+	LWLockRelease(DoubleWriteGenLock);
+
+	DoubleWriteCtl->ckpt_gen = newgen;
+}
+
+/*
+ * DoubleWriteEndCheckpoint
+ *		Remove the double-write files the checkpoint has made unnecessary.
+ *
+ * Called once the checkpoint has synced all the files written to before it
+ * called DoubleWriteStartCheckpoint().
+ */
+void
+DoubleWriteEndCheckpoint(void)
+{
+	char		path[MAXPGPATH];
+	uint32		gen;
+
+	for (gen = DoubleWriteCtl->oldest_gen; gen != DoubleWriteCtl->ckpt_gen; gen++)
+	{
+		DoubleWriteFilePath(path, gen);
+		if (unlink(path) < 0 && errno != ENOENT)
+			ereport(LOG,
+					(errcode_for_file_access(),
+					 errmsg("could not remove file \"%s\": %m", path)));
+	}
+	DoubleWriteCtl->oldest_gen = DoubleWriteCtl->ckpt_gen;
+}
@@ -40,6 +40,7 @@ typedef struct
 
 	int			firstFreeBuffer;	/* Head of list of unused buffers */
 	int			lastFreeBuffer; /* Tail of list of unused buffers */
+	int			numFreeBuffers; /* Number of buffers in the list */
 
 	/*
 	 * NOTE: lastFreeBuffer is undefined when firstFreeBuffer is -1 (that is,
@@ -97,6 +98,19 @@ typedef struct BufferAccessStrategyData
 }			BufferAccessStrategyData;
 
 
+/*
+ * GUC variable: number of clock positions a backend claims from the shared
+ * clock hand at once.  1 means every tick advances the shared hand.
+ */
+int			clock_sweep_batch_size = 1;
+
+/*
+ * The part of the most recently claimed batch of clock positions that this
+ * backend hasn't examined yet.
+ */
+static uint32 sweepBatchNext = 0;
+static uint32 sweepBatchRemaining = 0;
+
 /* Prototypes for internal functions */
 static BufferDesc *GetBufferFromRing(BufferAccessStrategy strategy,
 				  uint32 *buf_state);
@@ -104,67 +118,99 @@ static void AddBufferToRing(BufferAccessStrategy strategy,
 				BufferDesc *buf);
 
 /*
- * ClockSweepTick - Helper routine for StrategyGetBuffer()
+ * ClockSweepClaimBatch - Helper routine for ClockSweepTick()
  *
- * Move the clock hand one buffer ahead of its current position and return the
- * id of the buffer now under the hand.
+ * Move the shared clock hand ahead by a batch of buffers, and make the
+ * buffers it passed over this backend's to examine.
  */
-static inline uint32
-ClockSweepTick(void)
+static void
+ClockSweepClaimBatch(void)
 {
-	uint32		victim;
+	uint32		batch;
+	uint32		start;
+	uint32		end;
+	uint32		nextwrap;
+
+	/*
+	 * Don't let a batch cover more than a small fraction of the pool, so
+	 * that with a small shared_buffers setting backends still interleave
+	 * their sweeps reasonably fairly.
+	 */
+	batch = Min((uint32) clock_sweep_batch_size, NBuffers / 16);
+	batch = Max(batch, 1);
 
 	/*
-	 * Atomically move hand ahead one buffer - if there's several processes
-	 * doing this, this can lead to buffers being returned slightly out of
-	 * apparent order.
+	 * Atomically move hand ahead - if there's several processes doing this,
+	 * this can lead to buffers being returned slightly out of apparent
+	 * order; more so with larger batches.
 	 */
-	victim =
-		pg_atomic_fetch_add_u32(&StrategyControl->nextVictimBuffer, 1);
+	start = pg_atomic_fetch_add_u32(&StrategyControl->nextVictimBuffer, batch);
+	end = start + batch;
 
-	if (victim >= NBuffers)
+	/* always wrap what we look up in BufferDescriptors */
+	sweepBatchNext = start % NBuffers;
+	sweepBatchRemaining = batch;
+
+	/*
+	 * If our batch passed the end of the buffer array, we're the one that
+	 * just caused a wraparound: force completePasses to be incremented while
+	 * holding the spinlock.  We need the spinlock so StrategySyncStart() can
+	 * return a consistent value consisting of nextVictimBuffer and
+	 * completePasses.
+	 */
+	nextwrap = (start / NBuffers + (start % NBuffers != 0)) * NBuffers;
+	if (nextwrap >= NBuffers && nextwrap < end)
 	{
-		uint32		originalVictim = victim;
+		uint32		expected;
+		uint32		wrapped;
+		bool		success = false;
 
-		/* always wrap what we look up in BufferDescriptors */
-		victim = victim % NBuffers;
+		expected = end;
 
-		/*
-		 * If we're the one that just caused a wraparound, force
-		 * completePasses to be incremented while holding the spinlock. We
-		 * need the spinlock so StrategySyncStart() can return a consistent
-		 * value consisting of nextVictimBuffer and completePasses.
-		 */
-		if (victim == 0)
+		while (!success)
 		{
-			uint32		expected;
-			uint32		wrapped;
-			bool		success = false;
+			/*
+			 * Acquire the spinlock while increasing completePasses. That
+			 * allows other readers to read nextVictimBuffer and
+			 * completePasses in a consistent manner which is required for
+			 * StrategySyncStart().  In theory delaying the increment
+			 * could lead to an overflow of nextVictimBuffers, but that's
+			 * highly unlikely and wouldn't be particularly harmful.
+			 */
+			SpinLockAcquire(&StrategyControl->buffer_strategy_lock);
 
-			expected = originalVictim + 1;
+			wrapped = expected % NBuffers;
 
-			while (!success)
-			{
-				/*
-				 * Acquire the spinlock while increasing completePasses. That
-				 * allows other readers to read nextVictimBuffer and
-				 * completePasses in a consistent manner which is required for
-				 * StrategySyncStart().  In theory delaying the increment
-				 * could lead to an overflow of nextVictimBuffers, but that's
-				 * highly unlikely and wouldn't be particularly harmful.
-				 */
-				SpinLockAcquire(&StrategyControl->buffer_strategy_lock);
-
-				wrapped = expected % NBuffers;
-
-				success = pg_atomic_compare_exchange_u32(&StrategyControl->nextVictimBuffer,
-														 &expected, wrapped);
-				if (success)
-					StrategyControl->completePasses++;
-				SpinLockRelease(&StrategyControl->buffer_strategy_lock);
-			}
+			success = pg_atomic_compare_exchange_u32(&StrategyControl->nextVictimBuffer,
+													 &expected, wrapped);
+			if (success)
+				StrategyControl->completePasses++;
+			SpinLockRelease(&StrategyControl->buffer_strategy_lock);
 		}
 	}
+}
+
+/*
+ * ClockSweepTick - Helper routine for StrategyGetBuffer()
+ *
+ * Move the clock hand one buffer ahead of its current position and return the
+ * id of the buffer now under the hand.  The hand moved is this backend's
+ * private one, which walks through the batch of positions most recently
+ * claimed from the shared hand; see clock_sweep_batch_size.
+ */
+static inline uint32
+ClockSweepTick(void)
+{
+	uint32		victim;
+
+	if (sweepBatchRemaining == 0)
+		ClockSweepClaimBatch();
+
+	victim = sweepBatchNext;
+	if (++sweepBatchNext >= NBuffers)
+		sweepBatchNext = 0;
+	sweepBatchRemaining--;
+
 	return victim;
 }
 
@@ -284,6 +330,7 @@ StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state)
 			/* Unconditionally remove buffer from freelist */
 			StrategyControl->firstFreeBuffer = buf->freeNext;
 			buf->freeNext = FREENEXT_NOT_IN_LIST;
+			StrategyControl->numFreeBuffers--;
 
 			/*
 			 * Release the lock so someone else can access the freelist while
@@ -293,10 +340,9 @@ StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state)
 
 			/*
 			 * If the buffer is pinned or has a nonzero usage_count, we cannot
-			 * use it; discard it and retry.  (This can only happen if VACUUM
-			 * put a valid buffer in the freelist and then someone else used
-			 * it before we got to it.  It's probably impossible altogether as
-			 * of 8.3, but we'd better check anyway.)
+			 * use it; discard it and retry.  (This can happen if the
+			 * bgwriter put a clean, valid buffer in the freelist and then
+			 * someone else used it before we got to it.)
 			 */
 			local_buf_state = LockBufHdr(buf);
 			if (BUF_STATE_GET_REFCOUNT(local_buf_state) == 0
@@ -375,11 +421,54 @@ StrategyFreeBuffer(BufferDesc *buf)
 		if (buf->freeNext < 0)
 			StrategyControl->lastFreeBuffer = buf->buf_id;
 		StrategyControl->firstFreeBuffer = buf->buf_id;
+		StrategyControl->numFreeBuffers++;
+	}
+
+	SpinLockRelease(&StrategyControl->buffer_strategy_lock);
+}
+
+/*
+ * StrategyPushCleanBuffer: put a clean, reusable buffer at the end of the
+ * freelist
+ *
+ * Unlike StrategyFreeBuffer's buffers, which hold nothing anyone wants, this
+ * is used by the bgwriter for buffers that still hold valid pages, which
+ * are only worth evicting after those already in the list.  The caller has
+ * checked that the buffer is unpinned and has a zero usage_count, but that
+ * may change before anyone takes it from the list, which StrategyGetBuffer
+ * copes with.
+ */
+void
+StrategyPushCleanBuffer(BufferDesc *buf)
+{
+	SpinLockAcquire(&StrategyControl->buffer_strategy_lock);
+
+	if (buf->freeNext == FREENEXT_NOT_IN_LIST)
+	{
+		buf->freeNext = FREENEXT_END_OF_LIST;
+		if (StrategyControl->firstFreeBuffer < 0)
+			StrategyControl->firstFreeBuffer = buf->buf_id;
+		else
+			GetBufferDescriptor(StrategyControl->lastFreeBuffer)->freeNext =
+				buf->buf_id;
+		StrategyControl->lastFreeBuffer = buf->buf_id;
+		StrategyControl->numFreeBuffers++;
 	}
 
 	SpinLockRelease(&StrategyControl->buffer_strategy_lock);
 }
 
+/*
+ * StrategyFreeListLength -- number of buffers in the freelist
+ *
+ * This is read without the lock, so it may be slightly stale.
+ */
+int
+StrategyFreeListLength(void)
+{
+	return INT_ACCESS_ONCE(StrategyControl->numFreeBuffers);
+}
+
 /*
  * StrategySyncStart -- tell BufferSync where to start syncing
  *
@@ -511,6 +600,7 @@ StrategyInitialize(bool init)
 		 */
 		StrategyControl->firstFreeBuffer = 0;
 		StrategyControl->lastFreeBuffer = NBuffers - 1;
+		StrategyControl->numFreeBuffers = NBuffers;
 
 		/* Initialize the clock sweep pointer */
 		pg_atomic_init_u32(&StrategyControl->nextVictimBuffer, 0);
@@ -702,3 +792,16 @@ StrategyRejectBuffer(BufferAccessStrategy strategy, BufferDesc *buf)
 
 	return true;
 }
+
+/*
+ * StrategyGetType -- report the type of a buffer access strategy
+ *
+ * A NULL strategy means normal buffer replacement.
+ */
+BufferAccessStrategyType
+StrategyGetType(BufferAccessStrategy strategy)
+{
+	if (strategy == NULL)
+		return BAS_NORMAL;
+	return strategy->btype;
+}
@@ -34,6 +34,23 @@ typedef struct
 	int			id;				/* Associated local buffer's index */
 } LocalBufferLookupEnt;
 
+/*
+ * entry for per-relation bookkeeping hashtable
+ *
+ * We remember, for each relation that currently has pages in local buffers,
+ * how many buffers it holds and an upper bound on the block numbers cached
+ * for each fork.  This lets DropRelFileNodeLocalBuffers and friends probe
+ * the lookup hashtable block-by-block for small relations instead of
+ * scanning every local buffer, which matters when temp_buffers is large and
+ * temporary tables are created and dropped at a high rate.
+ */
+typedef struct
+{
+	RelFileNode key;			/* the relation */
+	int			nbuffers;		/* number of local buffers it holds */
+	BlockNumber nblocks[MAX_FORKNUM + 1];	/* > any cached block number */
+} LocalBufferRelEnt;
+
 /* Note: this macro only works on local buffers, not shared ones! */
 #define LocalBufHdrGetBlock(bufHdr) \
 	LocalBufferBlockPointers[-((bufHdr)->buf_id + 2)]
@@ -47,9 +64,12 @@ int32	   *LocalRefCount = NULL;
 static int	nextFreeLocalBuf = 0;
 
 static HTAB *LocalBufHash = NULL;
+static HTAB *LocalBufRelHash = NULL;
 
 
 static void InitLocalBuffers(void);
+static void LocalBufferRelAdd(BufferTag *tag);
+static void InvalidateLocalBuffer(BufferDesc *bufHdr, bool check_refcount);
 static Block GetLocalBufferStorage(void);
 
 
@@ -241,17 +261,12 @@ LocalBufferAlloc(SMgrRelation smgr, ForkNumber forkNum, BlockNumber blockNum,
 	 */
 	if (buf_state & BM_TAG_VALID)
 	{
-		hresult = (LocalBufferLookupEnt *)
-			hash_search(LocalBufHash, (void *) &bufHdr->tag,
-						HASH_REMOVE, NULL);
-		if (!hresult)			/* shouldn't happen */
-			elog(ERROR, "local buffer hash table corrupted");
-		/* mark buffer invalid just in case hash insert fails */
-		CLEAR_BUFFERTAG(bufHdr->tag);
-		buf_state &= ~(BM_VALID | BM_TAG_VALID);
-		pg_atomic_unlocked_write_u32(&bufHdr->state, buf_state);
+		/* this also marks the buffer invalid, in case hash insert fails */
+		InvalidateLocalBuffer(bufHdr, false);
+		buf_state = pg_atomic_read_u32(&bufHdr->state);
 	}
 
+	LocalBufferRelAdd(&newTag);
 	hresult = (LocalBufferLookupEnt *)
 		hash_search(LocalBufHash, (void *) &newTag, HASH_ENTER, &found);
 	if (found)					/* shouldn't happen */
@@ -305,6 +320,75 @@ MarkLocalBufferDirty(Buffer buffer)
 	pg_atomic_unlocked_write_u32(&bufHdr->state, buf_state);
 }
 
+/*
+ * LocalBufferRelAdd
+ *		Account for a local buffer that has just been assigned the given tag.
+ */
+static void
+LocalBufferRelAdd(BufferTag *tag)
+{
+	LocalBufferRelEnt *relent;
+	bool		found;
+
+	relent = (LocalBufferRelEnt *)
+		hash_search(LocalBufRelHash, (void *) &tag->rnode, HASH_ENTER, &found);
+	if (!found)
+	{
+		relent->nbuffers = 0;
+		MemSet(relent->nblocks, 0, sizeof(relent->nblocks));
+	}
+	relent->nbuffers++;
+	if (tag->blockNum >= relent->nblocks[tag->forkNum])
+		relent->nblocks[tag->forkNum] = tag->blockNum + 1;
+}
+
+/*
+ * InvalidateLocalBuffer
+ *		Remove a local buffer from the lookup hashtable and mark it invalid.
+ *
+ * The buffer must have a valid tag.  If check_refcount is true, complain if
+ * the buffer is still pinned.  Any dirty contents are simply discarded.
+ */
+static void
+InvalidateLocalBuffer(BufferDesc *bufHdr, bool check_refcount)
+{
+	int			b = -bufHdr->buf_id - 2;
+	LocalBufferLookupEnt *hresult;
+	LocalBufferRelEnt *relent;
+	uint32		buf_state;
+
+	if (check_refcount && LocalRefCount[b] != 0)
+		elog(ERROR, "block %u of %s is still referenced (local %u)",
+			 bufHdr->tag.blockNum,
+			 relpathbackend(bufHdr->tag.rnode, MyBackendId,
+							bufHdr->tag.forkNum),
+			 LocalRefCount[b]);
+
+	/* Remove entry from hashtable */
+	hresult = (LocalBufferLookupEnt *)
+		hash_search(LocalBufHash, (void *) &bufHdr->tag,
+					HASH_REMOVE, NULL);
+	if (!hresult)				/* shouldn't happen */
+		elog(ERROR, "local buffer hash table corrupted");
+
+	/* Update the per-relation bookkeeping */
+	relent = (LocalBufferRelEnt *)
+		hash_search(LocalBufRelHash, (void *) &bufHdr->tag.rnode,
+					HASH_FIND, NULL);
+	if (!relent || relent->nbuffers <= 0)	/* shouldn't happen */
+		elog(ERROR, "local buffer hash table corrupted");
+	if (--relent->nbuffers == 0)
+		hash_search(LocalBufRelHash, (void *) &bufHdr->tag.rnode,
+					HASH_REMOVE, NULL);
+
+	/* Mark buffer invalid */
+	CLEAR_BUFFERTAG(bufHdr->tag);
+	buf_state = pg_atomic_read_u32(&bufHdr->state);
+	buf_state &= ~BUF_FLAG_MASK;
+	buf_state &= ~BUF_USAGECOUNT_MASK;
+	pg_atomic_unlocked_write_u32(&bufHdr->state, buf_state);
+}
+
 /*
  * DropRelFileNodeLocalBuffers
  *		This function removes from the buffer pool all the pages of the
@@ -314,46 +398,74 @@ MarkLocalBufferDirty(Buffer buffer)
  *		out first.  Therefore, this is NOT rollback-able, and so should be
  *		used only with extreme caution!
  *
+ *		If the range of blocks that might be cached is small compared to the
+ *		number of local buffers, we look each block up in the hashtable;
+ *		otherwise we scan the whole pool.
+ *
  *		See DropRelFileNodeBuffers in bufmgr.c for more notes.
  */
 void
 DropRelFileNodeLocalBuffers(RelFileNode rnode, ForkNumber forkNum,
 							BlockNumber firstDelBlock)
 {
+	LocalBufferRelEnt *relent;
+	BlockNumber nblocks;
 	int			i;
 
-	for (i = 0; i < NLocBuffer; i++)
-	{
-		BufferDesc *bufHdr = GetLocalBufferDescriptor(i);
-		LocalBufferLookupEnt *hresult;
-		uint32		buf_state;
+	if (LocalBufRelHash == NULL)
+		return;
 
-		buf_state = pg_atomic_read_u32(&bufHdr->state);
+	relent = (LocalBufferRelEnt *)
+		hash_search(LocalBufRelHash, (void *) &rnode, HASH_FIND, NULL);
+	if (!relent)
+		return;					/* relation has no local buffers */
 
-		if ((buf_state & BM_TAG_VALID) &&
-			RelFileNodeEquals(bufHdr->tag.rnode, rnode) &&
-			bufHdr->tag.forkNum == forkNum &&
-			bufHdr->tag.blockNum >= firstDelBlock)
+	nblocks = relent->nblocks[forkNum];
+	if (firstDelBlock >= nblocks)
+		return;					/* nothing cached at or beyond that block */
+
+	if (nblocks - firstDelBlock < (BlockNumber) NLocBuffer / 4)
+	{
+		BlockNumber blkno;
+
+		for (blkno = firstDelBlock; blkno < nblocks; blkno++)
 		{
-			if (LocalRefCount[i] != 0)
-				elog(ERROR, "block %u of %s is still referenced (local %u)",
-					 bufHdr->tag.blockNum,
-					 relpathbackend(bufHdr->tag.rnode, MyBackendId,
-									bufHdr->tag.forkNum),
-					 LocalRefCount[i]);
-			/* Remove entry from hashtable */
+			BufferTag	tag;
+			LocalBufferLookupEnt *hresult;
+
+			INIT_BUFFERTAG(tag, rnode, forkNum, blkno);
 			hresult = (LocalBufferLookupEnt *)
-				hash_search(LocalBufHash, (void *) &bufHdr->tag,
-							HASH_REMOVE, NULL);
-			if (!hresult)		/* shouldn't happen */
-				elog(ERROR, "local buffer hash table corrupted");
-			/* Mark buffer invalid */
-			CLEAR_BUFFERTAG(bufHdr->tag);
-			buf_state &= ~BUF_FLAG_MASK;
-			buf_state &= ~BUF_USAGECOUNT_MASK;
-			pg_atomic_unlocked_write_u32(&bufHdr->state, buf_state);
+				hash_search(LocalBufHash, (void *) &tag, HASH_FIND, NULL);
+			if (hresult)
+				InvalidateLocalBuffer(GetLocalBufferDescriptor(hresult->id),
+									  true);
 		}
 	}
+	else
+	{
+		for (i = 0; i < NLocBuffer; i++)
+		{
+			BufferDesc *bufHdr = GetLocalBufferDescriptor(i);
+			uint32		buf_state;
+
+			buf_state = pg_atomic_read_u32(&bufHdr->state);
+
+			if ((buf_state & BM_TAG_VALID) &&
+				RelFileNodeEquals(bufHdr->tag.rnode, rnode) &&
+				bufHdr->tag.forkNum == forkNum &&
+				bufHdr->tag.blockNum >= firstDelBlock)
+				InvalidateLocalBuffer(bufHdr, true);
+		}
+	}
+
+	/*
+	 * Everything left of this fork is below firstDelBlock now.  The entry
+	 * may have gone away if we removed the relation's last buffer.
+	 */
+	relent = (LocalBufferRelEnt *)
+		hash_search(LocalBufRelHash, (void *) &rnode, HASH_FIND, NULL);
+	if (relent)
+		relent->nblocks[forkNum] = firstDelBlock;
 }
 
 /*
@@ -366,37 +478,59 @@ DropRelFileNodeLocalBuffers(RelFileNode rnode, ForkNumber forkNum,
 void
 DropRelFileNodeAllLocalBuffers(RelFileNode rnode)
 {
+	LocalBufferRelEnt *relent;
+	BlockNumber nblocks = 0;
+	ForkNumber	forkNum;
 	int			i;
 
+	if (LocalBufRelHash == NULL)
+		return;
+
+	relent = (LocalBufferRelEnt *)
+		hash_search(LocalBufRelHash, (void *) &rnode, HASH_FIND, NULL);
+	if (!relent)
+		return;					/* relation has no local buffers */
+
+	for (forkNum = 0; forkNum <= MAX_FORKNUM; forkNum++)
+		nblocks += relent->nblocks[forkNum];
+
+	if (nblocks < (BlockNumber) NLocBuffer / 4)
+	{
+		BlockNumber fork_nblocks[MAX_FORKNUM + 1];
+
+		/* relent may go away under us, so work from a copy */
+		memcpy(fork_nblocks, relent->nblocks, sizeof(fork_nblocks));
+
+		for (forkNum = 0; forkNum <= MAX_FORKNUM; forkNum++)
+		{
+			BlockNumber blkno;
+
+			for (blkno = 0; blkno < fork_nblocks[forkNum]; blkno++)
+			{
+				BufferTag	tag;
+				LocalBufferLookupEnt *hresult;
+
+				INIT_BUFFERTAG(tag, rnode, forkNum, blkno);
+				hresult = (LocalBufferLookupEnt *)
+					hash_search(LocalBufHash, (void *) &tag, HASH_FIND, NULL);
+				if (hresult)
+					InvalidateLocalBuffer(GetLocalBufferDescriptor(hresult->id),
+										  true);
+			}
+		}
+		return;
+	}
+
 	for (i = 0; i < NLocBuffer; i++)
 	{
 		BufferDesc *bufHdr = GetLocalBufferDescriptor(i);
-		LocalBufferLookupEnt *hresult;
 		uint32		buf_state;
 
 		buf_state = pg_atomic_read_u32(&bufHdr->state);
 
 		if ((buf_state & BM_TAG_VALID) &&
 			RelFileNodeEquals(bufHdr->tag.rnode, rnode))
-		{
-			if (LocalRefCount[i] != 0)
-				elog(ERROR, "block %u of %s is still referenced (local %u)",
-					 bufHdr->tag.blockNum,
-					 relpathbackend(bufHdr->tag.rnode, MyBackendId,
-									bufHdr->tag.forkNum),
-					 LocalRefCount[i]);
-			/* Remove entry from hashtable */
-			hresult = (LocalBufferLookupEnt *)
-				hash_search(LocalBufHash, (void *) &bufHdr->tag,
-							HASH_REMOVE, NULL);
-			if (!hresult)		/* shouldn't happen */
-				elog(ERROR, "local buffer hash table corrupted");
-			/* Mark buffer invalid */
-			CLEAR_BUFFERTAG(bufHdr->tag);
-			buf_state &= ~BUF_FLAG_MASK;
-			buf_state &= ~BUF_USAGECOUNT_MASK;
-			pg_atomic_unlocked_write_u32(&bufHdr->state, buf_state);
-		}
+			InvalidateLocalBuffer(bufHdr, true);
 	}
 }
 
@@ -471,6 +605,16 @@ InitLocalBuffers(void)
 	if (!LocalBufHash)
 		elog(ERROR, "could not initialize local buffer hash table");
 
+	/* And the per-relation bookkeeping table */
+	MemSet(&info, 0, sizeof(info));
+	info.keysize = sizeof(RelFileNode);
+	info.entrysize = sizeof(LocalBufferRelEnt);
+
+	LocalBufRelHash = hash_create("Local Buffer Relation Table",
+								  64,
+								  &info,
+								  HASH_ELEM | HASH_BLOBS);
+
 	/* Initialization done, mark buffers allocated */
 	NLocBuffer = nbufs;
 }
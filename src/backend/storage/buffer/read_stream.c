@@ -0,0 +1,257 @@
+/*-------------------------------------------------------------------------
+ *
+ * read_stream.c
+ *	  Look-ahead reading of a stream of relation blocks.
+ *
+ * A ReadStream is created for a relation fork together with a callback that
+ * produces the block numbers the caller is going to read.  Block numbers are
+ * pulled from the callback ahead of time and kept in a small circular queue;
+ * for each block entering the queue we issue PrefetchBuffer() advice, so
+ * that by the time the consumer gets around to the block, the kernel has
+ * (hopefully) already read it.  The consumer still receives ordinary pinned
+ * buffers from ReadBufferExtended(), in the order the callback produced them.
+ *
+ * The look-ahead distance starts at one block and doubles with each block
+ * consumed, up to a maximum derived from effective_io_concurrency (or the
+ * tablespace's override of it), the same way bitmap heap scans size their
+ * prefetch window.  This keeps short scans such as LIMIT queries from
+ * issuing a burst of useless advice.  If prefetching is disabled or not
+ * supported, the stream degenerates into a plain sequence of reads.
+ *
+ * There are two ways of consuming a stream.  read_stream_next_buffer()
+ * returns the blocks exactly in callback order, which suits consumers that
+ * read everything the callback produces.  read_stream_get_buffer() is for
+ * consumers whose callback is only a forecast: it also reads blocks that
+ * were never queued, and silently drops queued blocks that the consumer
+ * passed over without reading.  Forecasts must be in ascending order for the
+ * latter to work well, but a wrong forecast only costs wasted advice.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/storage/buffer/read_stream.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <math.h>
+
+#include "storage/read_stream.h"
+#include "utils/rel.h"
+#include "utils/spccache.h"
+
+/*
+ * Upper limit on the look-ahead distance, regardless of the I/O concurrency
+ * settings.  Advice further ahead than this is unlikely to still be in the
+ * kernel's page cache by the time we get to it.
+ */
+#define READ_STREAM_MAX_DISTANCE	256
+
+struct ReadStream
+{
+	Relation	rel;			/* relation being read */
+	ForkNumber	forknum;		/* fork being read */
+	BufferAccessStrategy strategy;	/* passed through to ReadBufferExtended */
+
+	ReadStreamBlockNumberCB callback;
+	void	   *callback_private_data;
+
+	int			max_distance;	/* look-ahead limit; 0 means no prefetching */
+	int			distance;		/* current look-ahead target */
+	bool		exhausted;		/* has the callback returned InvalidBlockNumber? */
+
+	/* circular queue of block numbers already submitted as advice */
+	int			queue_size;
+	int			head;			/* index of the oldest queued block */
+	int			nqueued;		/* number of queued blocks */
+	BlockNumber queue[FLEXIBLE_ARRAY_MEMBER];
+};
+
+/*
+ * Pull block numbers from the callback until "target" blocks are queued or
+ * the callback is exhausted, issuing prefetch advice for each if requested.
+ */
+static void
+read_stream_fill(ReadStream *stream, int target, bool advise)
+{
+	while (!stream->exhausted && stream->nqueued < target)
+	{
+		BlockNumber blocknum;
+
+		blocknum = stream->callback(stream, stream->callback_private_data);
+		if (blocknum == InvalidBlockNumber)
+		{
+			stream->exhausted = true;
+			break;
+		}
+
+		stream->queue[(stream->head + stream->nqueued) % stream->queue_size] =
+			blocknum;
+		stream->nqueued++;
+
+		if (advise)
+			PrefetchBuffer(stream->rel, stream->forknum, blocknum);
+	}
+}
+
+/*
+ * Remove the oldest queued block number and return it.
+ */
+static BlockNumber
+read_stream_pop(ReadStream *stream)
+{
+	BlockNumber blocknum;
+
+	Assert(stream->nqueued > 0);
+	blocknum = stream->queue[stream->head];
+	stream->head = (stream->head + 1) % stream->queue_size;
+	stream->nqueued--;
+
+	return blocknum;
+}
+
+/*
+ * Widen the look-ahead window after consuming a block, and top up the
+ * queue to the new distance.
+ */
+static void
+read_stream_advance(ReadStream *stream)
+{
+	if (stream->distance < stream->max_distance)
+		stream->distance = Min(stream->distance * 2, stream->max_distance);
+
+	if (stream->max_distance > 0)
+		read_stream_fill(stream, stream->distance, true);
+}
+
+/*
+ * Create a new read stream over the given fork of "rel".
+ *
+ * The stream is allocated in, and must be ended before the demise of, the
+ * current memory context.  "strategy" is used for every buffer read through
+ * the stream and must outlive it.
+ */
+ReadStream *
+read_stream_begin_relation(Relation rel,
+						   ForkNumber forknum,
+						   BufferAccessStrategy strategy,
+						   ReadStreamBlockNumberCB callback,
+						   void *callback_private_data)
+{
+	ReadStream *stream;
+	int			max_distance = 0;
+
+#ifdef USE_PREFETCH
+	{
+		int			io_concurrency;
+		double		target;
+
+		/*
+		 * Honor the tablespace's effective_io_concurrency setting, if any; see
+		 * ExecInitBitmapHeapScan for the same logic.
+		 */
+		io_concurrency =
+			get_tablespace_io_concurrency(rel->rd_rel->reltablespace);
+		if (io_concurrency == effective_io_concurrency)
+			max_distance = target_prefetch_pages;
+		else if (ComputeIoConcurrency(io_concurrency, &target))
+			max_distance = (int) rint(target);
+		max_distance = Min(max_distance, READ_STREAM_MAX_DISTANCE);
+	}
+#endif							/* USE_PREFETCH */
+
+	stream = (ReadStream *)
+		palloc(offsetof(ReadStream, queue) +
+			   sizeof(BlockNumber) * (max_distance + 1));
+	stream->rel = rel;
+	stream->forknum = forknum;
+	stream->strategy = strategy;
+	stream->callback = callback;
+	stream->callback_private_data = callback_private_data;
+	stream->max_distance = max_distance;
+	stream->queue_size = max_distance + 1;
+	read_stream_reset(stream);
+
+	return stream;
+}
+
+/*
+ * Return the next block of the stream, pinned, or InvalidBuffer once the
+ * callback is exhausted.
+ */
+Buffer
+read_stream_next_buffer(ReadStream *stream)
+{
+	BlockNumber blocknum;
+
+	/* The block we need now is read right away, no point advising it */
+	if (stream->nqueued == 0)
+		read_stream_fill(stream, 1, false);
+	if (stream->nqueued == 0)
+		return InvalidBuffer;
+
+	blocknum = read_stream_pop(stream);
+
+	/* Get the following reads going before we wait for this one */
+	read_stream_advance(stream);
+
+	return ReadBufferExtended(stream->rel, stream->forknum, blocknum,
+							  RBM_NORMAL, stream->strategy);
+}
+
+/*
+ * Return the given block, pinned, using the stream's forecast if possible.
+ *
+ * Queued blocks below "blocknum" are taken to have been skipped by the
+ * consumer and are discarded.  If "blocknum" is not at the head of the
+ * queue after that, it is read directly and the queue is left alone.
+ */
+Buffer
+read_stream_get_buffer(ReadStream *stream, BlockNumber blocknum)
+{
+	for (;;)
+	{
+		if (stream->nqueued == 0)
+			read_stream_fill(stream, 1, false);
+		if (stream->nqueued == 0 ||
+			stream->queue[stream->head] >= blocknum)
+			break;
+		(void) read_stream_pop(stream);
+	}
+
+	if (stream->nqueued > 0 && stream->queue[stream->head] == blocknum)
+	{
+		(void) read_stream_pop(stream);
+		read_stream_advance(stream);
+	}
+
+	return ReadBufferExtended(stream->rel, stream->forknum, blocknum,
+							  RBM_NORMAL, stream->strategy);
+}
+
+/*
+ * Forget all queued blocks and start asking the callback again, with the
+ * look-ahead window back at its minimum size.  The caller is expected to
+ * have reset the callback's own state.
+ */
+void
+read_stream_reset(ReadStream *stream)
+{
+	stream->distance = Min(1, stream->max_distance);
+	stream->exhausted = false;
+	stream->head = 0;
+	stream->nqueued = 0;
+}
+
+/*
+ * Release a read stream.  The stream holds no buffer pins, so this only
+ * frees memory; any advice already issued is simply wasted.
+ */
+void
+read_stream_end(ReadStream *stream)
+{
+	pfree(stream);
+}
@@ -36,11 +36,22 @@
  * other backends, as infrastructure for parallel execution.  Such files need
  * to be created as a member of a SharedFileSet that all participants are
  * attached to.
+ *
+ * Private temporary files created while temp_file_compression is on are
+ * stored compressed, one BLCKSZ block at a time.  The logical file (what
+ * callers see, including positions reported by BufFileTell) is unchanged;
+ * the physical files hold compressed blocks wherever there was room, and
+ * an in-memory block index maps each logical block to its stored copy.
+ * See BufFileLoadCompressed and BufFileDumpCompressed.
+ *
+ * A BufFile can also be given a cache of recently read and written blocks;
+ * see BufFileSetCache.
  *-------------------------------------------------------------------------
  */
 
 #include "postgres.h"
 
+#include "common/pg_lzcompress.h"
 #include "executor/instrument.h"
 #include "miscadmin.h"
 #include "pgstat.h"
@@ -57,6 +68,44 @@
 #define MAX_PHYSICAL_FILESIZE	0x40000000
 #define BUFFILE_SEG_SIZE		(MAX_PHYSICAL_FILESIZE / BLCKSZ)
 
+/*
+ * Compressed blocks are stored in slots of whole allocation units, so that
+ * the space of a block that is rewritten can be reused by another block
+ * needing the same number of units.
+ */
+#define BUFFILE_UNIT_SIZE		(BLCKSZ / 8)
+#define BUFFILE_UNITS_PER_BLOCK	(BLCKSZ / BUFFILE_UNIT_SIZE)
+#define BUFFILE_UNITS_PER_SEG	(MAX_PHYSICAL_FILESIZE / BUFFILE_UNIT_SIZE)
+
+/*
+ * Maximum number of blocks a cached BufFile reads in one request when the
+ * block it needs is not in the cache.
+ */
+#define BUFFILE_READAHEAD_BLOCKS	8
+
+/* GUC variable */
+bool		temp_file_compression = false;
+
+/*
+ * Where a logical block of a compressed BufFile is stored.  complen is the
+ * number of bytes stored, or 0 if the block was never written; if it equals
+ * rawlen, the block is stored uncompressed.
+ */
+typedef struct BufFileBlockLoc
+{
+	int64		unit;			/* first allocation unit of the slot */
+	uint16		complen;		/* stored length in bytes */
+	uint16		rawlen;			/* valid bytes in the logical block */
+} BufFileBlockLoc;
+
+/* Free slots of one size, left behind by rewritten blocks */
+typedef struct BufFileFreeSlots
+{
+	int64	   *units;			/* first unit of each free slot */
+	int			nfree;
+	int			maxfree;
+} BufFileFreeSlots;
+
 /*
  * This data structure represents a buffered file that consists of one or
  * more physical files (each accessed through a virtual file descriptor
@@ -91,6 +140,29 @@ struct BufFile
 	int			pos;			/* next read/write position in buffer */
 	int			nbytes;			/* total # of valid bytes in buffer */
 	PGAlignedBlock buffer;
+
+	/*
+	 * Compression state.  When compress is set, the buffer always holds a
+	 * whole logical block, ie. curOffset is a multiple of BLCKSZ, except
+	 * transiently while the buffer is empty.
+	 */
+	bool		compress;
+	BufFileBlockLoc *blocks;	/* block index, palloc'd */
+	long		nblocks;		/* number of logical blocks written */
+	long		maxblocks;		/* allocated length of blocks[] */
+	int64		nextunit;		/* first never-used allocation unit */
+	BufFileFreeSlots freeslots[BUFFILE_UNITS_PER_BLOCK];	/* by size - 1 */
+	char	   *compbuf;		/* scratch space, PGLZ_MAX_OUTPUT(BLCKSZ) */
+
+	/*
+	 * Block cache state (see BufFileSetCache).  Only whole BLCKSZ blocks are
+	 * cached.  When the cache is enabled, the buffer always holds a whole
+	 * logical block, just as for a compressed file.
+	 */
+	int			ncache;			/* number of cache slots, or 0 if none */
+	int			nextcache;		/* next slot to replace */
+	long	   *cacheblk;		/* logical block in each slot, or -1 */
+	char	   *cachedata;		/* ncache * BLCKSZ bytes */
 };
 
 static BufFile *makeBufFileCommon(int nfiles);
@@ -100,6 +172,15 @@ static void BufFileLoadBuffer(BufFile *file);
 static void BufFileDumpBuffer(BufFile *file);
 static int	BufFileFlush(BufFile *file);
 static File MakeNewSharedSegment(BufFile *file, int segment);
+static void BufFileInitCompression(BufFile *file);
+static void BufFileLoadCompressed(BufFile *file);
+static void BufFileDumpCompressed(BufFile *file);
+static int64 BufFileAllocSlot(BufFile *file, int nunits);
+static void BufFileFreeSlot(BufFile *file, int64 unit, int nunits);
+static void BufFileLoadCached(BufFile *file);
+static int	BufFileCacheLookup(BufFile *file, long blknum);
+static void BufFileCacheStore(BufFile *file, long blknum, const char *data);
+static void BufFileCacheForget(BufFile *file, long blknum);
 
 /*
  * Create BufFile and perform the common initialization.
@@ -117,10 +198,39 @@ makeBufFileCommon(int nfiles)
 	file->curOffset = 0L;
 	file->pos = 0;
 	file->nbytes = 0;
+	file->compress = false;
+	file->ncache = 0;
+	file->nextcache = 0;
+	file->cacheblk = NULL;
+	file->cachedata = NULL;
 
 	return file;
 }
 
+/*
+ * Set up the block index and free space lists of a compressed BufFile.
+ */
+static void
+BufFileInitCompression(BufFile *file)
+{
+	int			i;
+
+	file->compress = true;
+	file->maxblocks = 64;
+	file->blocks = (BufFileBlockLoc *)
+		palloc0(file->maxblocks * sizeof(BufFileBlockLoc));
+	file->nblocks = 0;
+	file->nextunit = 0;
+	for (i = 0; i < BUFFILE_UNITS_PER_BLOCK; i++)
+	{
+		file->freeslots[i].maxfree = 16;
+		file->freeslots[i].units = (int64 *)
+			palloc(file->freeslots[i].maxfree * sizeof(int64));
+		file->freeslots[i].nfree = 0;
+	}
+	file->compbuf = (char *) palloc(PGLZ_MAX_OUTPUT(BLCKSZ));
+}
+
 /*
  * Create a BufFile given the first underlying physical file.
  * NOTE: caller must set isInterXact if appropriate.
@@ -191,6 +301,13 @@ BufFileCreateTemp(bool interXact)
 	file = makeBufFile(pfile);
 	file->isInterXact = interXact;
 
+	/*
+	 * Only private files are compressed; shared files are read by other
+	 * backends, which have no access to the block index.
+	 */
+	if (temp_file_compression)
+		BufFileInitCompression(file);
+
 	return file;
 }
 
@@ -387,9 +504,52 @@ BufFileClose(BufFile *file)
 		FileClose(file->files[i]);
 	/* release the buffer space */
 	pfree(file->files);
+	if (file->compress)
+	{
+		pfree(file->blocks);
+		for (i = 0; i < BUFFILE_UNITS_PER_BLOCK; i++)
+			pfree(file->freeslots[i].units);
+		pfree(file->compbuf);
+	}
+	if (file->ncache > 0)
+	{
+		pfree(file->cacheblk);
+		pfree(file->cachedata);
+	}
 	pfree(file);
 }
 
+/*
+ * BufFileSetCache
+ *
+ * Keep copies of up to nblocks recently read or written blocks of the file
+ * in memory.  This helps callers that keep several read positions in the
+ * same file, or that reread the same stretch of it repeatedly, or that read
+ * closely behind where they are writing.  Blocks that are not in the cache
+ * are read up to BUFFILE_READAHEAD_BLOCKS at a time, so that the cache also
+ * serves as a read-ahead buffer for sequential readers.
+ *
+ * This must be called before anything is written to the file.
+ */
+void
+BufFileSetCache(BufFile *file, int nblocks)
+{
+	int			i;
+
+	Assert(file->ncache == 0);
+	Assert(!file->dirty && file->nbytes == 0);
+
+	if (nblocks <= 0)
+		return;
+
+	file->cacheblk = (long *) palloc(nblocks * sizeof(long));
+	for (i = 0; i < nblocks; i++)
+		file->cacheblk[i] = -1;
+	file->cachedata = (char *) palloc((Size) nblocks * BLCKSZ);
+	file->ncache = nblocks;
+	file->nextcache = 0;
+}
+
 /*
  * BufFileLoadBuffer
  *
@@ -402,6 +562,18 @@ BufFileLoadBuffer(BufFile *file)
 {
 	File		thisfile;
 
+	if (file->ncache > 0)
+	{
+		BufFileLoadCached(file);
+		return;
+	}
+
+	if (file->compress)
+	{
+		BufFileLoadCompressed(file);
+		return;
+	}
+
 	/*
 	 * Advance to next component file if necessary and possible.
 	 */
@@ -442,6 +614,32 @@ BufFileDumpBuffer(BufFile *file)
 	int			wpos = 0;
 	int			bytestowrite;
 	File		thisfile;
+	long		blknum = -1;
+	bool		cacheit = false;
+
+	/*
+	 * With a block cache, the buffer holds one whole logical block (or the
+	 * beginning of one).  Whatever copy of it we had cached is now stale; but
+	 * if it's a full block, keep the new version in the cache instead, since
+	 * it may well be read again soon.  The buffer contents stay valid after
+	 * being written out, so we can copy them once the write has succeeded.
+	 */
+	if (file->ncache > 0)
+	{
+		Assert(file->curOffset % BLCKSZ == 0);
+		blknum = (long) file->curFile * BUFFILE_SEG_SIZE +
+			(long) (file->curOffset / BLCKSZ);
+		cacheit = (file->nbytes == BLCKSZ);
+		BufFileCacheForget(file, blknum);
+	}
+
+	if (file->compress)
+	{
+		BufFileDumpCompressed(file);
+		if (cacheit && !file->dirty)
+			BufFileCacheStore(file, blknum, file->buffer.data);
+		return;
+	}
 
 	/*
 	 * Unlike BufFileLoadBuffer, we must dump the whole buffer even if it
@@ -486,6 +684,9 @@ BufFileDumpBuffer(BufFile *file)
 	}
 	file->dirty = false;
 
+	if (cacheit)
+		BufFileCacheStore(file, blknum, file->buffer.data);
+
 	/*
 	 * At this point, curOffset has been advanced to the end of the buffer,
 	 * ie, its original value + nbytes.  We need to make it point to the
@@ -507,6 +708,345 @@ BufFileDumpBuffer(BufFile *file)
 	file->nbytes = 0;
 }
 
+/*
+ * BufFileLoadCompressed
+ *
+ * BufFileLoadBuffer for a compressed file: load the logical block containing
+ * the position curOffset + pos.  On exit, curOffset is the start of that
+ * block, pos is unchanged relative to the logical file, and nbytes is the
+ * number of valid bytes in the block.  The rest of the buffer is zeroed, so
+ * that a partial write can be stored as a whole block.
+ *
+ * Blocks never written, before the last block written, read as zeroes, like
+ * the holes an uncompressed file would have.
+ */
+static void
+BufFileLoadCompressed(BufFile *file)
+{
+	off_t		offset = file->curOffset + file->pos;
+	long		blknum;
+
+	/* Advance to next component file if necessary and possible */
+	if (offset >= MAX_PHYSICAL_FILESIZE &&
+		file->curFile + 1 < file->numFiles)
+	{
+		file->curFile++;
+		offset -= MAX_PHYSICAL_FILESIZE;
+	}
+
+	file->curOffset = offset - offset % BLCKSZ;
+	file->pos = (int) (offset % BLCKSZ);
+	file->nbytes = 0;
+
+	blknum = (long) file->curFile * BUFFILE_SEG_SIZE +
+		(long) (file->curOffset / BLCKSZ);
+
+	if (blknum < file->nblocks && file->blocks[blknum].complen > 0)
+	{
+		BufFileBlockLoc *loc = &file->blocks[blknum];
+		int			fileno = (int) (loc->unit / BUFFILE_UNITS_PER_SEG);
+		off_t		physoffset;
+		int			nread;
+
+		physoffset = (off_t) (loc->unit % BUFFILE_UNITS_PER_SEG) *
+			BUFFILE_UNIT_SIZE;
+
+		nread = FileRead(file->files[fileno], file->compbuf, loc->complen,
+						 physoffset, WAIT_EVENT_BUFFILE_READ);
+		if (nread < 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not read block %ld of temporary file: %m",
+							blknum)));
+		if (nread != loc->complen)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not read block %ld of temporary file: read only %d of %d bytes",
+							blknum, nread, (int) loc->complen)));
+
+		if (loc->complen == loc->rawlen)
+			memcpy(file->buffer.data, file->compbuf, loc->rawlen);
+		else if (pglz_decompress(file->compbuf, loc->complen,
+								 file->buffer.data, loc->rawlen) != loc->rawlen)
+			elog(ERROR, "compressed data in block %ld of temporary file is corrupt",
+				 blknum);
+
+		file->nbytes = loc->rawlen;
+		pgBufferUsage.temp_blks_read++;
+	}
+
+	memset(file->buffer.data + file->nbytes, 0, BLCKSZ - file->nbytes);
+	if (blknum < file->nblocks - 1)
+		file->nbytes = BLCKSZ;
+}
+
+/*
+ * BufFileDumpCompressed
+ *
+ * BufFileDumpBuffer for a compressed file: compress the block in the buffer
+ * and store it, in a free slot of the right size if there is one, else at
+ * the end of the physical files.  The slot of the block's previous version,
+ * if any, becomes free.  Blocks that don't compress are stored as they are.
+ *
+ * On exit, dirty is cleared if successful write.  If the logical position is
+ * at the end of the block, we move on to the next one, leaving the buffer
+ * empty; otherwise the block stays in the buffer.
+ */
+static void
+BufFileDumpCompressed(BufFile *file)
+{
+	long		blknum;
+	const char *src;
+	int32		complen;
+	int			nunits;
+	int64		unit;
+	int			fileno;
+	off_t		physoffset;
+	BufFileBlockLoc *loc;
+
+	Assert(file->curOffset % BLCKSZ == 0);
+	Assert(file->nbytes > 0);
+
+	/* Advance to next component file if necessary, as BufFileDumpBuffer does */
+	if (file->curOffset >= MAX_PHYSICAL_FILESIZE)
+	{
+		while (file->curFile + 1 >= file->numFiles)
+			extendBufFile(file);
+		file->curFile++;
+		file->curOffset = 0L;
+	}
+
+	blknum = (long) file->curFile * BUFFILE_SEG_SIZE +
+		(long) (file->curOffset / BLCKSZ);
+
+	complen = pglz_compress(file->buffer.data, file->nbytes, file->compbuf,
+							PGLZ_strategy_default);
+	if (complen < 0 || complen >= file->nbytes)
+	{
+		src = file->buffer.data;
+		complen = file->nbytes;
+	}
+	else
+		src = file->compbuf;
+	nunits = (complen + BUFFILE_UNIT_SIZE - 1) / BUFFILE_UNIT_SIZE;
+
+	/* Make room in the block index */
+	if (blknum >= file->maxblocks)
+	{
+		long		newmax = file->maxblocks;
+
+		while (blknum >= newmax)
+			newmax *= 2;
+		file->blocks = (BufFileBlockLoc *)
+			repalloc_huge(file->blocks, newmax * sizeof(BufFileBlockLoc));
+		memset(file->blocks + file->maxblocks, 0,
+			   (newmax - file->maxblocks) * sizeof(BufFileBlockLoc));
+		file->maxblocks = newmax;
+	}
+
+	unit = BufFileAllocSlot(file, nunits);
+	fileno = (int) (unit / BUFFILE_UNITS_PER_SEG);
+	physoffset = (off_t) (unit % BUFFILE_UNITS_PER_SEG) * BUFFILE_UNIT_SIZE;
+	while (fileno >= file->numFiles)
+		extendBufFile(file);
+
+	if (FileWrite(file->files[fileno], (char *) src, complen, physoffset,
+				  WAIT_EVENT_BUFFILE_WRITE) != complen)
+	{
+		BufFileFreeSlot(file, unit, nunits);
+		return;					/* failed to write */
+	}
+	pgBufferUsage.temp_blks_written++;
+
+	/* The old version of the block is no longer needed */
+	loc = &file->blocks[blknum];
+	if (loc->complen > 0)
+		BufFileFreeSlot(file, loc->unit,
+						(loc->complen + BUFFILE_UNIT_SIZE - 1) / BUFFILE_UNIT_SIZE);
+	loc->unit = unit;
+	loc->complen = (uint16) complen;
+	loc->rawlen = (uint16) file->nbytes;
+	if (blknum >= file->nblocks)
+		file->nblocks = blknum + 1;
+
+	file->dirty = false;
+
+	if (file->pos >= BLCKSZ)
+	{
+		file->curOffset += BLCKSZ;
+		file->pos = 0;
+		file->nbytes = 0;
+	}
+}
+
+/*
+ * Find space for a compressed block of the given number of allocation units.
+ * Slots don't cross segment file boundaries.
+ */
+static int64
+BufFileAllocSlot(BufFile *file, int nunits)
+{
+	BufFileFreeSlots *slots = &file->freeslots[nunits - 1];
+	int64		unit;
+
+	if (slots->nfree > 0)
+		return slots->units[--slots->nfree];
+
+	unit = file->nextunit;
+	if (unit % BUFFILE_UNITS_PER_SEG + nunits > BUFFILE_UNITS_PER_SEG)
+		unit += BUFFILE_UNITS_PER_SEG - unit % BUFFILE_UNITS_PER_SEG;
+	file->nextunit = unit + nunits;
+
+	return unit;
+}
+
+/*
+ * Remember a slot as free for reuse.
+ */
+static void
+BufFileFreeSlot(BufFile *file, int64 unit, int nunits)
+{
+	BufFileFreeSlots *slots = &file->freeslots[nunits - 1];
+
+	if (slots->nfree >= slots->maxfree)
+	{
+		slots->maxfree *= 2;
+		slots->units = (int64 *)
+			repalloc_huge(slots->units, slots->maxfree * sizeof(int64));
+	}
+	slots->units[slots->nfree++] = unit;
+}
+
+/*
+ * BufFileLoadCached
+ *
+ * BufFileLoadBuffer for a file with a block cache.  As for a compressed
+ * file, we load the whole logical block containing the position curOffset +
+ * pos, taking it from the cache if it's there.  Otherwise an uncompressed
+ * file is read up to BUFFILE_READAHEAD_BLOCKS blocks at a time, into
+ * consecutive cache slots; the blocks after the first one are left in the
+ * cache for the reads that follow.
+ */
+static void
+BufFileLoadCached(BufFile *file)
+{
+	off_t		offset = file->curOffset + file->pos;
+	long		blknum;
+	int			slot;
+	int			nblocks;
+	int			nread;
+	int			nfull;
+	char	   *data;
+	int			i;
+
+	/* Advance to next component file if necessary and possible */
+	if (offset >= MAX_PHYSICAL_FILESIZE &&
+		file->curFile + 1 < file->numFiles)
+	{
+		file->curFile++;
+		offset -= MAX_PHYSICAL_FILESIZE;
+	}
+
+	file->curOffset = offset - offset % BLCKSZ;
+	file->pos = (int) (offset % BLCKSZ);
+	file->nbytes = 0;
+
+	blknum = (long) file->curFile * BUFFILE_SEG_SIZE +
+		(long) (file->curOffset / BLCKSZ);
+
+	slot = BufFileCacheLookup(file, blknum);
+	if (slot >= 0)
+	{
+		memcpy(file->buffer.data, file->cachedata + (Size) slot * BLCKSZ,
+			   BLCKSZ);
+		file->nbytes = BLCKSZ;
+		return;
+	}
+
+	if (file->compress)
+	{
+		BufFileLoadCompressed(file);
+		if (file->nbytes == BLCKSZ)
+			BufFileCacheStore(file, blknum, file->buffer.data);
+		return;
+	}
+
+	/* Read ahead, but not past the end of this component file */
+	nblocks = Min(BUFFILE_READAHEAD_BLOCKS, file->ncache);
+	nblocks = Min(nblocks,
+				  (int) ((MAX_PHYSICAL_FILESIZE - file->curOffset) / BLCKSZ));
+	nblocks = Max(nblocks, 1);
+	if (file->nextcache + nblocks > file->ncache)
+		file->nextcache = 0;
+	data = file->cachedata + (Size) file->nextcache * BLCKSZ;
+
+	nread = FileRead(file->files[file->curFile], data, nblocks * BLCKSZ,
+					 file->curOffset, WAIT_EVENT_BUFFILE_READ);
+	if (nread < 0)
+		nread = 0;
+
+	/* Only the blocks we got all of are worth keeping */
+	nfull = nread / BLCKSZ;
+	for (i = 0; i < nblocks; i++)
+		file->cacheblk[file->nextcache + i] = (i < nfull) ? blknum + i : -1;
+	file->nextcache = (file->nextcache + nfull) % file->ncache;
+
+	file->nbytes = Min(nread, BLCKSZ);
+	memcpy(file->buffer.data, data, file->nbytes);
+	memset(file->buffer.data + file->nbytes, 0, BLCKSZ - file->nbytes);
+
+	if (nread > 0)
+		pgBufferUsage.temp_blks_read += (nread + BLCKSZ - 1) / BLCKSZ;
+}
+
+/*
+ * Return the cache slot holding logical block blknum, or -1 if none does.
+ */
+static int
+BufFileCacheLookup(BufFile *file, long blknum)
+{
+	int			i;
+
+	for (i = 0; i < file->ncache; i++)
+	{
+		if (file->cacheblk[i] == blknum)
+			return i;
+	}
+	return -1;
+}
+
+/*
+ * Remember the contents of logical block blknum, replacing the oldest
+ * cached block.
+ */
+static void
+BufFileCacheStore(BufFile *file, long blknum, const char *data)
+{
+	int			slot;
+
+	BufFileCacheForget(file, blknum);
+
+	slot = file->nextcache;
+	memcpy(file->cachedata + (Size) slot * BLCKSZ, data, BLCKSZ);
+	file->cacheblk[slot] = blknum;
+	file->nextcache = (slot + 1) % file->ncache;
+}
+
+/*
+ * Drop any cached copy of logical block blknum.
+ */
+static void
+BufFileCacheForget(BufFile *file, long blknum)
+{
+	int			i;
+
+	for (i = 0; i < file->ncache; i++)
+	{
+		if (file->cacheblk[i] == blknum)
+			file->cacheblk[i] = -1;
+	}
+}
+
 /*
  * BufFileRead
  *
@@ -534,7 +1074,7 @@ BufFileRead(BufFile *file, void *ptr, size_t size)
 			file->pos = 0;
 			file->nbytes = 0;
 			BufFileLoadBuffer(file);
-			if (file->nbytes <= 0)
+			if (file->pos >= file->nbytes)
 				break;			/* no more data available */
 		}
 
@@ -587,6 +1127,24 @@ BufFileWrite(BufFile *file, void *ptr, size_t size)
 			}
 		}
 
+		/*
+		 * A compressed file is written a whole block at a time, so we have
+		 * to read in the current contents of a block before changing part
+		 * of it.  That's not needed if we're about to overwrite all of it.
+		 * The same goes for a file with a block cache.
+		 */
+		if ((file->compress || file->ncache > 0) &&
+			file->nbytes == 0 && !file->dirty)
+		{
+			if ((file->curOffset + file->pos) % BLCKSZ != 0 || size < BLCKSZ)
+				BufFileLoadBuffer(file);
+			else
+			{
+				file->curOffset += file->pos;
+				file->pos = 0;
+			}
+		}
+
 		nthistime = BLCKSZ - file->pos;
 		if (nthistime > size)
 			nthistime = size;
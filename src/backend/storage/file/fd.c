@@ -1833,16 +1833,36 @@ FileWriteback(File file, off_t offset, off_t nbytes, uint32 wait_event_info)
 int
 FileRead(File file, char *buffer, int amount, off_t offset,
 		 uint32 wait_event_info)
+{
+	struct iovec iov;
+
+	iov.iov_base = buffer;
+	iov.iov_len = amount;
+
+	return FileReadV(file, &iov, 1, offset, wait_event_info);
+}
+
+/*
+ * FileReadV - read into several buffers with a single system call
+ *
+ * The buffers are filled in order from consecutive file positions starting
+ * at offset.  Like FileRead, this returns the number of bytes read, which
+ * may be short at end of file, or -1 with errno set.
+ */
+int
+FileReadV(File file, const struct iovec *iov, int iovcnt, off_t offset,
+		  uint32 wait_event_info)
 {
 	int			returnCode;
 	Vfd		   *vfdP;
 
 	Assert(FileIsValid(file));
+	Assert(iovcnt > 0 && iovcnt <= PG_IOV_MAX);
 
-	DO_DB(elog(LOG, "FileRead: %d (%s) " INT64_FORMAT " %d %p",
+	DO_DB(elog(LOG, "FileReadV: %d (%s) " INT64_FORMAT " %d %p",
 			   file, VfdCache[file].fileName,
 			   (int64) offset,
-			   amount, buffer));
+			   iovcnt, iov[0].iov_base));
 
 	returnCode = FileAccess(file);
 	if (returnCode < 0)
@@ -1852,7 +1872,7 @@ FileRead(File file, char *buffer, int amount, off_t offset,
 
 retry:
 	pgstat_report_wait_start(wait_event_info);
-	returnCode = pg_pread(vfdP->fd, buffer, amount, offset);
+	returnCode = pg_preadv(vfdP->fd, iov, iovcnt, offset);
 	pgstat_report_wait_end();
 
 	if (returnCode < 0)
@@ -1889,16 +1909,42 @@ retry:
 int
 FileWrite(File file, char *buffer, int amount, off_t offset,
 		  uint32 wait_event_info)
+{
+	struct iovec iov;
+
+	iov.iov_base = buffer;
+	iov.iov_len = amount;
+
+	return FileWriteV(file, &iov, 1, offset, wait_event_info);
+}
+
+/*
+ * FileWriteV - write several buffers with a single system call
+ *
+ * The buffers are written in order to consecutive file positions starting
+ * at offset.  Like FileWrite, this returns the number of bytes written, or
+ * -1 with errno set; a short write sets errno to ENOSPC if the kernel
+ * didn't say otherwise.
+ */
+int
+FileWriteV(File file, const struct iovec *iov, int iovcnt, off_t offset,
+		   uint32 wait_event_info)
 {
 	int			returnCode;
 	Vfd		   *vfdP;
+	int			amount = 0;
+	int			i;
 
 	Assert(FileIsValid(file));
+	Assert(iovcnt > 0 && iovcnt <= PG_IOV_MAX);
+
+	for (i = 0; i < iovcnt; i++)
+		amount += iov[i].iov_len;
 
-	DO_DB(elog(LOG, "FileWrite: %d (%s) " INT64_FORMAT " %d %p",
+	DO_DB(elog(LOG, "FileWriteV: %d (%s) " INT64_FORMAT " %d %p",
 			   file, VfdCache[file].fileName,
 			   (int64) offset,
-			   amount, buffer));
+			   amount, iov[0].iov_base));
 
 	returnCode = FileAccess(file);
 	if (returnCode < 0)
@@ -1934,7 +1980,7 @@ FileWrite(File file, char *buffer, int amount, off_t offset,
 retry:
 	errno = 0;
 	pgstat_report_wait_start(wait_event_info);
-	returnCode = pg_pwrite(VfdCache[file].fd, buffer, amount, offset);
+	returnCode = pg_pwritev(VfdCache[file].fd, iov, iovcnt, offset);
 	pgstat_report_wait_end();
 
 	/* if write didn't set errno, assume problem is no disk space */
@@ -2026,6 +2072,102 @@ FileSize(File file)
 	return lseek(VfdCache[file].fd, 0, SEEK_END);
 }
 
+/*
+ * FileZeroExtend - make [offset, offset + amount) of a file read as zeroes
+ *
+ * This is meant for extending a file by many blocks at once.  Where
+ * posix_fallocate() is available, the space is reserved without writing it;
+ * otherwise, or if the filesystem can't do that, zeroes are written.
+ * Returns 0 on success, or -1 with errno set.  Not for temporary files,
+ * whose size we would have to track.
+ */
+int
+FileZeroExtend(File file, off_t offset, off_t amount, uint32 wait_event_info)
+{
+	static const PGAlignedBlock zbuffer;
+	struct iovec iov[PG_IOV_MAX];
+	int			returnCode;
+	int			i;
+
+	Assert(FileIsValid(file));
+
+	DO_DB(elog(LOG, "FileZeroExtend: %d (%s) " INT64_FORMAT " " INT64_FORMAT,
+			   file, VfdCache[file].fileName,
+			   (int64) offset, (int64) amount));
+
+	returnCode = FileAccess(file);
+	if (returnCode < 0)
+		return returnCode;
+
+	Assert(!(VfdCache[file].fdstate & FD_TEMP_FILE_LIMIT));
+
+#ifdef HAVE_POSIX_FALLOCATE
+	do
+	{
+		pgstat_report_wait_start(wait_event_info);
+		returnCode = posix_fallocate(VfdCache[file].fd, offset, amount);
+		pgstat_report_wait_end();
+	} while (returnCode == EINTR && !(ProcDiePending || QueryCancelPending));
+
+	if (returnCode == 0)
+		return 0;
+
+	/* posix_fallocate() returns the error number rather than setting errno */
+	if (returnCode != EINVAL && returnCode != EOPNOTSUPP)
+	{
+		errno = returnCode;
+		return -1;
+	}
+	/* else the filesystem can't do it, so write zeroes instead */
+#endif
+
+	for (i = 0; i < PG_IOV_MAX; i++)
+	{
+		iov[i].iov_base = (char *) zbuffer.data;
+		iov[i].iov_len = BLCKSZ;
+	}
+
+	while (amount > 0)
+	{
+		int			iovcnt = 0;
+		off_t		chunk = 0;
+
+		while (iovcnt < PG_IOV_MAX && chunk < amount)
+		{
+			iov[iovcnt].iov_len = (size_t) Min((off_t) BLCKSZ, amount - chunk);
+			chunk += iov[iovcnt].iov_len;
+			iovcnt++;
+		}
+
+		errno = 0;
+		pgstat_report_wait_start(wait_event_info);
+		returnCode = pg_pwritev(VfdCache[file].fd, iov, iovcnt, offset);
+		pgstat_report_wait_end();
+
+		if (returnCode < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		if (returnCode == 0)
+		{
+			/* a write that makes no progress means we're out of space */
+			errno = ENOSPC;
+			return -1;
+		}
+
+		offset += returnCode;
+		amount -= returnCode;
+
+		/* restore the full-block length of any shortened entry */
+		for (i = 0; i < iovcnt; i++)
+			iov[i].iov_len = BLCKSZ;
+	}
+
+	return 0;
+}
+
 int
 FileTruncate(File file, off_t offset, uint32 wait_event_info)
 {
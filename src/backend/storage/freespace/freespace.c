@@ -26,6 +26,7 @@
 #include "access/htup_details.h"
 #include "access/xlogutils.h"
 #include "miscadmin.h"
+#include "storage/backendid.h"
 #include "storage/freespace.h"
 #include "storage/fsm_internals.h"
 #include "storage/lmgr.h"
@@ -76,6 +77,13 @@
 #define FSM_ROOT_LEVEL	(FSM_TREE_DEPTH - 1)
 #define FSM_BOTTOM_LEVEL 0
 
+/*
+ * Number of distinct starting offsets GetPageWithFreeSpaceAffinity() spreads
+ * backends over.  RelationAddExtraBlocks adds at least 20 pages per waiter,
+ * so this is small enough that the offsets normally land on fresh pages.
+ */
+#define FSM_INSERT_AFFINITY_SLOTS	16
+
 /*
  * The internal FSM routines work on a logical addressing scheme. Each
  * level of the tree can be thought of as a separately addressable file.
@@ -107,7 +115,7 @@ static Size fsm_space_cat_to_avail(uint8 cat);
 /* workhorse functions for various operations */
 static int fsm_set_and_search(Relation rel, FSMAddress addr, uint16 slot,
 				   uint8 newValue, uint8 minValue);
-static BlockNumber fsm_search(Relation rel, uint8 min_cat);
+static BlockNumber fsm_search(Relation rel, uint8 min_cat, uint16 affinity);
 static uint8 fsm_vacuum_page(Relation rel, FSMAddress addr,
 				BlockNumber start, BlockNumber end,
 				bool *eof);
@@ -133,7 +141,28 @@ GetPageWithFreeSpace(Relation rel, Size spaceNeeded)
 {
 	uint8		min_cat = fsm_space_needed_to_cat(spaceNeeded);
 
-	return fsm_search(rel, min_cat);
+	return fsm_search(rel, min_cat, 0);
+}
+
+/*
+ * GetPageWithFreeSpaceAffinity - like GetPageWithFreeSpace, but spread
+ *		concurrent callers over different pages.
+ *
+ * This is meant for callers that know many backends are asking the FSM for
+ * a page at the same moment, such as inserters that have all been waiting
+ * for the same relation extension lock.  Plain searches all start from the
+ * FSM page's shared next-slot pointer, which is only updated under a shared
+ * lock, so backends that search concurrently tend to be handed the same
+ * block and then queue up on its buffer lock.  Here the search starts at an
+ * offset derived from our backend ID instead.
+ */
+BlockNumber
+GetPageWithFreeSpaceAffinity(Relation rel, Size spaceNeeded)
+{
+	uint8		min_cat = fsm_space_needed_to_cat(spaceNeeded);
+
+	return fsm_search(rel, min_cat,
+					  (uint16) (MyBackendId % FSM_INSERT_AFFINITY_SLOTS));
 }
 
 /*
@@ -167,7 +196,7 @@ RecordAndGetPageWithFreeSpace(Relation rel, BlockNumber oldPage,
 	if (search_slot != -1)
 		return fsm_get_heap_blk(addr, search_slot);
 	else
-		return fsm_search(rel, search_cat);
+		return fsm_search(rel, search_cat, 0);
 }
 
 /*
@@ -688,7 +717,7 @@ fsm_set_and_search(Relation rel, FSMAddress addr, uint16 slot,
 		/* Search while we still hold the lock */
 		newslot = fsm_search_avail(buf, minValue,
 								   addr.level == FSM_BOTTOM_LEVEL,
-								   true);
+								   true, 0);
 	}
 
 	UnlockReleaseBuffer(buf);
@@ -698,9 +727,12 @@ fsm_set_and_search(Relation rel, FSMAddress addr, uint16 slot,
 
 /*
  * Search the tree for a heap page with at least min_cat of free space
+ *
+ * affinity is passed down to fsm_search_avail() for the bottom-level page;
+ * the upper levels are always searched from their next-slot pointers.
  */
 static BlockNumber
-fsm_search(Relation rel, uint8 min_cat)
+fsm_search(Relation rel, uint8 min_cat, uint16 affinity)
 {
 	int			restarts = 0;
 	FSMAddress	addr = FSM_ROOT_ADDRESS;
@@ -720,7 +752,9 @@ fsm_search(Relation rel, uint8 min_cat)
 			LockBuffer(buf, BUFFER_LOCK_SHARE);
 			slot = fsm_search_avail(buf, min_cat,
 									(addr.level == FSM_BOTTOM_LEVEL),
-									false);
+									false,
+									(addr.level == FSM_BOTTOM_LEVEL) ?
+									affinity : 0);
 			if (slot == -1)
 				max_avail = fsm_get_max_avail(BufferGetPage(buf));
 			UnlockReleaseBuffer(buf);
@@ -153,10 +153,15 @@ fsm_get_max_avail(Page page)
  *
  * If advancenext is false, fp_next_slot is set to point to the returned
  * slot, and if it's true, to the slot after the returned slot.
+ *
+ * If affinity is nonzero, the search starts that many slots to the right of
+ * fp_next_slot, and fp_next_slot is left alone.  Backends that are known to
+ * be searching the same page at the same moment can pass distinct values to
+ * avoid all racing to the slot fp_next_slot points to.
  */
 int
 fsm_search_avail(Buffer buf, uint8 minvalue, bool advancenext,
-				 bool exclusive_lock_held)
+				 bool exclusive_lock_held, uint16 affinity)
 {
 	Page		page = BufferGetPage(buf);
 	FSMPage		fsmpage = (FSMPage) PageGetContents(page);
@@ -181,6 +186,7 @@ restart:
 	target = fsmpage->fp_next_slot;
 	if (target < 0 || target >= LeafNodesPerPage)
 		target = 0;
+	target = (target + affinity) % LeafNodesPerPage;
 	target += NonLeafNodesPerPage;
 
 	/*----------
@@ -298,9 +304,12 @@ restart:
 	 * lock and get a garbled next pointer every now and then, than take the
 	 * concurrency hit of an exclusive lock.
 	 *
-	 * Wrap-around is handled at the beginning of this function.
+	 * Wrap-around is handled at the beginning of this function.  A search
+	 * with an affinity offset doesn't move the pointer, since it didn't start
+	 * from it.
 	 */
-	fsmpage->fp_next_slot = slot + (advancenext ? 1 : 0);
+	if (affinity == 0)
+		fsmpage->fp_next_slot = slot + (advancenext ? 1 : 0);
 
 	return slot;
 }
@@ -14,6 +14,14 @@
  * hard postmaster crash, remaining segments will be removed, if they
  * still exist, at the next postmaster startup.
  *
+ * If min_dynamic_shared_memory is set, that much space is set aside in the
+ * main shared memory segment at startup, and segments are carved out of it
+ * when they fit, instead of being created by dsm_impl.c.  That avoids the
+ * system calls and page faults of setting up a new segment, and lets the
+ * space use huge pages if the main segment does.  Such segments are
+ * recognizable by their handle, which is odd; handles of segments made by
+ * dsm_impl.c are always even.
+ *
  * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
  *
@@ -39,6 +47,8 @@
 #include "storage/ipc.h"
 #include "storage/lwlock.h"
 #include "storage/pg_shmem.h"
+#include "storage/shmem.h"
+#include "utils/freepage.h"
 #include "utils/guc.h"
 #include "utils/memutils.h"
 #include "utils/resowner_private.h"
@@ -83,6 +93,8 @@ typedef struct dsm_control_item
 	uint32		refcnt;			/* 2+ = active, 1 = moribund, 0 = gone */
 	void	   *impl_private_pm_handle; /* only needed on Windows */
 	bool		pinned;
+	Size		first_page;		/* location within the preallocated space */
+	Size		npages;			/* ... and size, if it's in there */
 } dsm_control_item;
 
 /* Layout of the dynamic shared memory control segment. */
@@ -100,6 +112,10 @@ static dsm_segment *dsm_create_descriptor(void);
 static bool dsm_control_segment_sane(dsm_control_header *control,
 						 Size mapped_size);
 static uint64 dsm_control_bytes_needed(uint32 nitems);
+static dsm_handle make_main_region_dsm_handle(uint32 slot);
+
+/* Is this the handle of a segment in the preallocated space? */
+#define is_main_region_dsm_handle(handle)	(((handle) & 1) != 0)
 
 /* Has this backend initialized the dynamic shared memory system yet? */
 static bool dsm_init_done = false;
@@ -135,6 +151,13 @@ static dsm_control_header *dsm_control;
 static Size dsm_control_mapped_size = 0;
 static void *dsm_control_impl_private = NULL;
 
+/*
+ * Preallocated space in the main shared memory segment, if any.  It starts
+ * with the FreePageManager that keeps track of the free parts of it.
+ */
+static char *dsm_main_space_begin = NULL;
+static FreePageManager *dsm_main_space_fpm = NULL;
+
 /*
  * Start up the dynamic shared memory system.
  *
@@ -252,8 +275,12 @@ dsm_cleanup_using_control_segment(dsm_handle old_control_handle)
 		if (refcnt == 0)
 			continue;
 
-		/* Log debugging information. */
+		/* Segments in the old main segment went away with it. */
 		handle = old_control->item[i].handle;
+		if (is_main_region_dsm_handle(handle))
+			continue;
+
+		/* Log debugging information. */
 		elog(DEBUG2, "cleaning up orphaned dynamic shared memory with ID %u (reference count %u)",
 			 handle, refcnt);
 
@@ -353,8 +380,12 @@ dsm_postmaster_shutdown(int code, Datum arg)
 		if (dsm_control->item[i].refcnt == 0)
 			continue;
 
-		/* Log debugging information. */
+		/* Nothing to do for segments in the main shared memory segment. */
 		handle = dsm_control->item[i].handle;
+		if (is_main_region_dsm_handle(handle))
+			continue;
+
+		/* Log debugging information. */
 		elog(DEBUG2, "cleaning up orphaned dynamic shared memory with ID %u",
 			 handle);
 
@@ -423,6 +454,41 @@ dsm_set_control_handle(dsm_handle h)
 }
 #endif
 
+/*
+ * Amount of main shared memory to set aside for dynamic shared memory
+ * segments.
+ */
+Size
+dsm_estimate_size(void)
+{
+	return 1024 * 1024 * (Size) min_dynamic_shared_memory;
+}
+
+/*
+ * Initialize the space set aside by dsm_estimate_size, if any.
+ */
+void
+dsm_shmem_init(void)
+{
+	Size		size = dsm_estimate_size();
+	bool		found;
+
+	if (size == 0)
+		return;
+
+	dsm_main_space_begin = ShmemInitStruct("Preallocated DSM", size, &found);
+	dsm_main_space_fpm = (FreePageManager *) dsm_main_space_begin;
+	if (!found)
+	{
+		Size		first_page = fpm_size_to_pages(sizeof(FreePageManager));
+		Size		npages = size / FPM_PAGE_SIZE - first_page;
+
+		/* Keep the FreePageManager itself, and hand it all the rest. */
+		FreePageManagerInitialize(dsm_main_space_fpm, dsm_main_space_begin);
+		FreePageManagerPut(dsm_main_space_fpm, first_page, npages);
+	}
+}
+
 /*
  * Create a new dynamic shared memory segment.
  *
@@ -439,6 +505,9 @@ dsm_create(Size size, int flags)
 	dsm_segment *seg;
 	uint32		i;
 	uint32		nitems;
+	Size		npages = 0;
+	Size		first_page = 0;
+	bool		in_main_space = false;
 
 	/* Unsafe in postmaster (and pointless in a stand-alone backend). */
 	Assert(IsUnderPostmaster);
@@ -449,20 +518,46 @@ dsm_create(Size size, int flags)
 	/* Create a new segment descriptor. */
 	seg = dsm_create_descriptor();
 
-	/* Loop until we find an unused segment identifier. */
-	for (;;)
+	/*
+	 * Lock the control segment so we can register the new segment.  The lock
+	 * also protects the preallocated space, so take it before trying that.
+	 */
+	LWLockAcquire(DynamicSharedMemoryControlLock, LW_EXCLUSIVE);
+
+	if (dsm_main_space_fpm != NULL)
 	{
-		Assert(seg->mapped_address == NULL && seg->mapped_size == 0);
-		seg->handle = random();
-		if (seg->handle == DSM_HANDLE_INVALID)	/* Reserve sentinel */
-			continue;
-		if (dsm_impl_op(DSM_OP_CREATE, seg->handle, size, &seg->impl_private,
-						&seg->mapped_address, &seg->mapped_size, ERROR))
-			break;
+		npages = fpm_size_to_pages(size);
+		if (FreePageManagerGet(dsm_main_space_fpm, npages, &first_page))
+		{
+			seg->mapped_address = fpm_page_to_pointer(dsm_main_space_begin,
+													  first_page);
+			seg->mapped_size = npages * FPM_PAGE_SIZE;
+			in_main_space = true;
+			/* The handle is chosen below, once we know the slot. */
+		}
 	}
 
-	/* Lock the control segment so we can register the new segment. */
-	LWLockAcquire(DynamicSharedMemoryControlLock, LW_EXCLUSIVE);
+	if (!in_main_space)
+	{
+		LWLockRelease(DynamicSharedMemoryControlLock);
+
+		/* Loop until we find an unused segment identifier. */
+		for (;;)
+		{
+			Assert(seg->mapped_address == NULL && seg->mapped_size == 0);
+			seg->handle = random();
+			if (seg->handle == DSM_HANDLE_INVALID)	/* Reserve sentinel */
+				continue;
+			if (is_main_region_dsm_handle(seg->handle))
+				continue;
+			if (dsm_impl_op(DSM_OP_CREATE, seg->handle, size,
+							&seg->impl_private, &seg->mapped_address,
+							&seg->mapped_size, ERROR))
+				break;
+		}
+
+		LWLockAcquire(DynamicSharedMemoryControlLock, LW_EXCLUSIVE);
+	}
 
 	/* Search the control segment for an unused slot. */
 	nitems = dsm_control->nitems;
@@ -470,11 +565,15 @@ dsm_create(Size size, int flags)
 	{
 		if (dsm_control->item[i].refcnt == 0)
 		{
+			if (in_main_space)
+				seg->handle = make_main_region_dsm_handle(i);
 			dsm_control->item[i].handle = seg->handle;
 			/* refcnt of 1 triggers destruction, so start at 2 */
 			dsm_control->item[i].refcnt = 2;
 			dsm_control->item[i].impl_private_pm_handle = NULL;
 			dsm_control->item[i].pinned = false;
+			dsm_control->item[i].first_page = first_page;
+			dsm_control->item[i].npages = npages;
 			seg->control_slot = i;
 			LWLockRelease(DynamicSharedMemoryControlLock);
 			return seg;
@@ -484,11 +583,19 @@ dsm_create(Size size, int flags)
 	/* Verify that we can support an additional mapping. */
 	if (nitems >= dsm_control->maxitems)
 	{
+		if (in_main_space)
+		{
+			FreePageManagerPut(dsm_main_space_fpm, first_page, npages);
+			seg->mapped_address = NULL;
+			seg->mapped_size = 0;
+		}
 		if ((flags & DSM_CREATE_NULL_IF_MAXSEGMENTS) != 0)
 		{
 			LWLockRelease(DynamicSharedMemoryControlLock);
-			dsm_impl_op(DSM_OP_DESTROY, seg->handle, 0, &seg->impl_private,
-						&seg->mapped_address, &seg->mapped_size, WARNING);
+			if (!in_main_space)
+				dsm_impl_op(DSM_OP_DESTROY, seg->handle, 0,
+							&seg->impl_private, &seg->mapped_address,
+							&seg->mapped_size, WARNING);
 			if (seg->resowner != NULL)
 				ResourceOwnerForgetDSM(seg->resowner, seg);
 			dlist_delete(&seg->node);
@@ -501,11 +608,15 @@ dsm_create(Size size, int flags)
 	}
 
 	/* Enter the handle into a new array slot. */
+	if (in_main_space)
+		seg->handle = make_main_region_dsm_handle(nitems);
 	dsm_control->item[nitems].handle = seg->handle;
 	/* refcnt of 1 triggers destruction, so start at 2 */
 	dsm_control->item[nitems].refcnt = 2;
 	dsm_control->item[nitems].impl_private_pm_handle = NULL;
 	dsm_control->item[nitems].pinned = false;
+	dsm_control->item[nitems].first_page = first_page;
+	dsm_control->item[nitems].npages = npages;
 	seg->control_slot = nitems;
 	dsm_control->nitems++;
 	LWLockRelease(DynamicSharedMemoryControlLock);
@@ -588,6 +699,13 @@ dsm_attach(dsm_handle h)
 		/* Otherwise we've found a match. */
 		dsm_control->item[i].refcnt++;
 		seg->control_slot = i;
+		if (is_main_region_dsm_handle(seg->handle))
+		{
+			seg->mapped_address =
+				fpm_page_to_pointer(dsm_main_space_begin,
+									dsm_control->item[i].first_page);
+			seg->mapped_size = dsm_control->item[i].npages * FPM_PAGE_SIZE;
+		}
 		break;
 	}
 	LWLockRelease(DynamicSharedMemoryControlLock);
@@ -605,8 +723,9 @@ dsm_attach(dsm_handle h)
 	}
 
 	/* Here's where we actually try to map the segment. */
-	dsm_impl_op(DSM_OP_ATTACH, seg->handle, 0, &seg->impl_private,
-				&seg->mapped_address, &seg->mapped_size, ERROR);
+	if (!is_main_region_dsm_handle(seg->handle))
+		dsm_impl_op(DSM_OP_ATTACH, seg->handle, 0, &seg->impl_private,
+					&seg->mapped_address, &seg->mapped_size, ERROR);
 
 	return seg;
 }
@@ -696,8 +815,9 @@ dsm_detach(dsm_segment *seg)
 	 */
 	if (seg->mapped_address != NULL)
 	{
-		dsm_impl_op(DSM_OP_DETACH, seg->handle, 0, &seg->impl_private,
-					&seg->mapped_address, &seg->mapped_size, WARNING);
+		if (!is_main_region_dsm_handle(seg->handle))
+			dsm_impl_op(DSM_OP_DETACH, seg->handle, 0, &seg->impl_private,
+						&seg->mapped_address, &seg->mapped_size, WARNING);
 		seg->impl_private = NULL;
 		seg->mapped_address = NULL;
 		seg->mapped_size = 0;
@@ -736,13 +856,20 @@ dsm_detach(dsm_segment *seg)
 			 * removed. If we actually fail to remove the segment for some
 			 * other reason, the postmaster may not have any better luck than
 			 * we did.  There's not much we can do about that, though.
+			 *
+			 * A segment in the preallocated space just gives its pages back.
 			 */
-			if (dsm_impl_op(DSM_OP_DESTROY, seg->handle, 0, &seg->impl_private,
+			if (is_main_region_dsm_handle(seg->handle) ||
+				dsm_impl_op(DSM_OP_DESTROY, seg->handle, 0, &seg->impl_private,
 							&seg->mapped_address, &seg->mapped_size, WARNING))
 			{
 				LWLockAcquire(DynamicSharedMemoryControlLock, LW_EXCLUSIVE);
 				Assert(dsm_control->item[control_slot].handle == seg->handle);
 				Assert(dsm_control->item[control_slot].refcnt == 1);
+				if (is_main_region_dsm_handle(seg->handle))
+					FreePageManagerPut(dsm_main_space_fpm,
+									   dsm_control->item[control_slot].first_page,
+									   dsm_control->item[control_slot].npages);
 				dsm_control->item[control_slot].refcnt = 0;
 				LWLockRelease(DynamicSharedMemoryControlLock);
 			}
@@ -817,7 +944,10 @@ dsm_pin_segment(dsm_segment *seg)
 	LWLockAcquire(DynamicSharedMemoryControlLock, LW_EXCLUSIVE);
 	if (dsm_control->item[seg->control_slot].pinned)
 		elog(ERROR, "cannot pin a segment that is already pinned");
-	dsm_impl_pin_segment(seg->handle, seg->impl_private, &handle);
+	if (is_main_region_dsm_handle(seg->handle))
+		handle = NULL;
+	else
+		dsm_impl_pin_segment(seg->handle, seg->impl_private, &handle);
 	dsm_control->item[seg->control_slot].pinned = true;
 	dsm_control->item[seg->control_slot].refcnt++;
 	dsm_control->item[seg->control_slot].impl_private_pm_handle = handle;
@@ -874,8 +1004,9 @@ dsm_unpin_segment(dsm_handle handle)
 	 * releasing the lock, because impl_private_pm_handle may get modified by
 	 * dsm_impl_unpin_segment.
 	 */
-	dsm_impl_unpin_segment(handle,
-						   &dsm_control->item[control_slot].impl_private_pm_handle);
+	if (!is_main_region_dsm_handle(handle))
+		dsm_impl_unpin_segment(handle,
+							   &dsm_control->item[control_slot].impl_private_pm_handle);
 
 	/* Note that 1 means no references (0 means unused slot). */
 	if (--dsm_control->item[control_slot].refcnt == 1)
@@ -902,12 +1033,17 @@ dsm_unpin_segment(dsm_handle handle)
 		 * pass the mapped size, mapped address, and private data as NULL
 		 * here.
 		 */
-		if (dsm_impl_op(DSM_OP_DESTROY, handle, 0, &junk_impl_private,
+		if (is_main_region_dsm_handle(handle) ||
+			dsm_impl_op(DSM_OP_DESTROY, handle, 0, &junk_impl_private,
 						&junk_mapped_address, &junk_mapped_size, WARNING))
 		{
 			LWLockAcquire(DynamicSharedMemoryControlLock, LW_EXCLUSIVE);
 			Assert(dsm_control->item[control_slot].handle == handle);
 			Assert(dsm_control->item[control_slot].refcnt == 1);
+			if (is_main_region_dsm_handle(handle))
+				FreePageManagerPut(dsm_main_space_fpm,
+								   dsm_control->item[control_slot].first_page,
+								   dsm_control->item[control_slot].npages);
 			dsm_control->item[control_slot].refcnt = 0;
 			LWLockRelease(DynamicSharedMemoryControlLock);
 		}
@@ -1102,3 +1238,20 @@ dsm_control_bytes_needed(uint32 nitems)
 	return offsetof(dsm_control_header, item)
 		+ sizeof(dsm_control_item) * (uint64) nitems;
 }
+
+/*
+ * Make a handle for a segment in the preallocated space, which will be
+ * registered in control slot 'slot'.  The handle is odd, has the slot number
+ * in the bits above that, and random bits above those to make it unlikely
+ * that a stale handle matches a later segment in the same slot.
+ */
+static dsm_handle
+make_main_region_dsm_handle(uint32 slot)
+{
+	int			shift = 1;
+
+	while (shift < 31 && ((uint32) 1 << (shift - 1)) <= dsm_control->maxitems)
+		shift++;
+
+	return 1 | (slot << 1) | ((uint32) random() << shift);
+}
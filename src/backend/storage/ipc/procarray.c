@@ -27,6 +27,14 @@
  * array represents standby processes, which by definition are not running
  * transactions that have XIDs.
  *
+ * Building a snapshot means visiting every entry of the array, which gets
+ * expensive with thousands of connections.  But the result can only change
+ * when some transaction stops running, since XIDs assigned later are not
+ * below the snapshot's xmax anyway.  So we count such completions, and keep
+ * the most recently built snapshot in shared memory tagged with the count it
+ * was built under; while the count is unchanged, backends copy the cached
+ * snapshot instead of scanning the array.
+ *
  * It is perhaps possible for a backend on the master to terminate without
  * writing an abort record for its transaction.  While that shouldn't really
  * happen, it would tie up KnownAssignedXids indefinitely, so we protect
@@ -92,6 +100,31 @@ typedef struct ProcArrayStruct
 	/* oldest catalog xmin of any replication slot */
 	TransactionId replication_slot_catalog_xmin;
 
+	/*
+	 * Number of times the set of running XIDs has shrunk, i.e. an XID-bearing
+	 * transaction or subtransaction has completed, or an entry was added to
+	 * or removed from the array.  Must hold exclusive ProcArrayLock to
+	 * change this, and shared lock to read it.
+	 */
+	uint64		completionCount;
+
+	/*
+	 * Shared snapshot cache.  The contents are valid iff cacheCount equals
+	 * completionCount; since that can't change while anyone holds
+	 * ProcArrayLock, a valid cache is immutable for holders of a shared lock.
+	 * Filling the cache requires winning cacheFilling, since several backends
+	 * building snapshots under shared lock could otherwise write it at once.
+	 * The XID arrays are SnapshotCacheXip and SnapshotCacheSubxip.
+	 */
+	pg_atomic_flag cacheFilling;
+	pg_atomic_uint64 cacheCount;
+	TransactionId cacheXmin;
+	TransactionId cacheXmax;
+	TransactionId cacheGlobalXmin;
+	int			cacheXcnt;
+	int			cacheSubxcnt;
+	bool		cacheSuboverflowed;
+
 	/* indexes into allPgXact[], has PROCARRAY_MAXPROCS entries */
 	int			pgprocnos[FLEXIBLE_ARRAY_MEMBER];
 } ProcArrayStruct;
@@ -108,6 +141,12 @@ static TransactionId *KnownAssignedXids;
 static bool *KnownAssignedXidsValid;
 static TransactionId latestObservedXid = InvalidTransactionId;
 
+/*
+ * XID arrays of the shared snapshot cache
+ */
+static TransactionId *SnapshotCacheXip;
+static TransactionId *SnapshotCacheSubxip;
+
 /*
  * If we're in STANDBY_SNAPSHOT_PENDING state, standbySnapshotPendingXmin is
  * the highest xid that might still be running that we don't have in
@@ -172,6 +211,12 @@ static void KnownAssignedXidsReset(void);
 static inline void ProcArrayEndTransactionInternal(PGPROC *proc,
 								PGXACT *pgxact, TransactionId latestXid);
 static void ProcArrayGroupClearXid(PGPROC *proc, TransactionId latestXid);
+static bool SnapshotCacheGet(Snapshot snapshot, TransactionId xmax,
+				 TransactionId *xmin, TransactionId *globalxmin,
+				 int *count, int *subcount, bool *suboverflowed);
+static void SnapshotCachePut(Snapshot snapshot, TransactionId xmin,
+				 TransactionId xmax, TransactionId globalxmin,
+				 int count, int subcount, bool suboverflowed);
 
 /*
  * Report shared-memory space needed by CreateSharedProcArray.
@@ -212,6 +257,12 @@ ProcArrayShmemSize(void)
 						mul_size(sizeof(bool), TOTAL_MAX_CACHED_SUBXIDS));
 	}
 
+	/* XID arrays of the shared snapshot cache */
+	size = add_size(size,
+					mul_size(sizeof(TransactionId),
+							 add_size(PROCARRAY_MAXPROCS,
+									  TOTAL_MAX_CACHED_SUBXIDS)));
+
 	return size;
 }
 
@@ -246,6 +297,10 @@ CreateSharedProcArray(void)
 		procArray->lastOverflowedXid = InvalidTransactionId;
 		procArray->replication_slot_xmin = InvalidTransactionId;
 		procArray->replication_slot_catalog_xmin = InvalidTransactionId;
+		/* start out with the cache invalid */
+		procArray->completionCount = 1;
+		pg_atomic_init_flag(&procArray->cacheFilling);
+		pg_atomic_init_u64(&procArray->cacheCount, 0);
 	}
 
 	allProcs = ProcGlobal->allProcs;
@@ -265,6 +320,14 @@ CreateSharedProcArray(void)
 							&found);
 	}
 
+	SnapshotCacheXip = (TransactionId *)
+		ShmemInitStruct("Snapshot Cache XIDs",
+						mul_size(sizeof(TransactionId),
+								 add_size(PROCARRAY_MAXPROCS,
+										  TOTAL_MAX_CACHED_SUBXIDS)),
+						&found);
+	SnapshotCacheSubxip = SnapshotCacheXip + PROCARRAY_MAXPROCS;
+
 	/* Register and initialize fields of ProcLWLockTranche */
 	LWLockRegisterTranche(LWTRANCHE_PROC, "proc");
 }
@@ -317,6 +380,9 @@ ProcArrayAdd(PGPROC *proc)
 	arrayP->pgprocnos[index] = proc->pgprocno;
 	arrayP->numProcs++;
 
+	/* a prepared transaction's XIDs may now appear twice, or only once */
+	arrayP->completionCount++;
+
 	LWLockRelease(ProcArrayLock);
 }
 
@@ -368,6 +434,7 @@ ProcArrayRemove(PGPROC *proc, TransactionId latestXid)
 					(arrayP->numProcs - index - 1) * sizeof(int));
 			arrayP->pgprocnos[arrayP->numProcs - 1] = -1;	/* for debugging */
 			arrayP->numProcs--;
+			arrayP->completionCount++;
 			LWLockRelease(ProcArrayLock);
 			return;
 		}
@@ -467,6 +534,9 @@ ProcArrayEndTransactionInternal(PGPROC *proc, PGXACT *pgxact,
 	if (TransactionIdPrecedes(ShmemVariableCache->latestCompletedXid,
 							  latestXid))
 		ShmemVariableCache->latestCompletedXid = latestXid;
+
+	/* and invalidate the shared snapshot cache */
+	procArray->completionCount++;
 }
 
 /*
@@ -1359,9 +1429,16 @@ GetOldestXmin(Relation rel, int flags)
 		if (pgxact->vacuumFlags & (flags & PROCARRAY_PROC_FLAGS_MASK))
 			continue;
 
+		/*
+		 * Always include processes not connected to a database, such as
+		 * WalSenders, unless a WalSender's feedback xmin has been scoped to
+		 * some other database by the standby.
+		 */
 		if (allDbs ||
 			proc->databaseId == MyDatabaseId ||
-			proc->databaseId == 0)	/* always include WalSender */
+			(proc->databaseId == 0 &&
+			 (!OidIsValid(UINT32_ACCESS_ONCE(proc->xminDatabaseId)) ||
+			  UINT32_ACCESS_ONCE(proc->xminDatabaseId) == MyDatabaseId)))
 		{
 			/* Fetch xid just once - see GetNewTransactionId */
 			TransactionId xid = UINT32_ACCESS_ONCE(pgxact->xid);
@@ -1579,7 +1656,18 @@ GetSnapshotData(Snapshot snapshot)
 
 	snapshot->takenDuringRecovery = RecoveryInProgress();
 
-	if (!snapshot->takenDuringRecovery)
+	/*
+	 * If nothing has completed since the cached snapshot was built, we can
+	 * just copy it; but it includes all XIDs, so only if we have none.
+	 */
+	if (!snapshot->takenDuringRecovery &&
+		!TransactionIdIsValid(MyPgXact->xid) &&
+		SnapshotCacheGet(snapshot, xmax, &xmin, &globalxmin, &count,
+						 &subcount, &suboverflowed))
+	{
+		/* nothing more to do */
+	}
+	else if (!snapshot->takenDuringRecovery)
 	{
 		int		   *pgprocnos = arrayP->pgprocnos;
 		int			numProcs;
@@ -1672,6 +1760,14 @@ GetSnapshotData(Snapshot snapshot)
 				}
 			}
 		}
+
+		/*
+		 * Publish the result for other backends, unless it lacks our own
+		 * XID.  (We know we have no subxids if we have no XID.)
+		 */
+		if (!TransactionIdIsValid(MyPgXact->xid))
+			SnapshotCachePut(snapshot, xmin, xmax, globalxmin,
+							 count, subcount, suboverflowed);
 	}
 	else
 	{
@@ -1796,6 +1892,81 @@ GetSnapshotData(Snapshot snapshot)
 	return snapshot;
 }
 
+/*
+ * SnapshotCacheGet -- copy the shared snapshot cache into "snapshot"
+ *
+ * Returns false, leaving everything untouched, if the cache is not valid.
+ * The caller must hold ProcArrayLock, in shared mode at least, and must not
+ * have an XID: the cached XID set includes every running XID, while a
+ * snapshot must not include its owner's.
+ */
+static bool
+SnapshotCacheGet(Snapshot snapshot, TransactionId xmax,
+				 TransactionId *xmin, TransactionId *globalxmin,
+				 int *count, int *subcount, bool *suboverflowed)
+{
+	ProcArrayStruct *arrayP = procArray;
+
+	if (pg_atomic_read_u64(&arrayP->cacheCount) != arrayP->completionCount)
+		return false;
+
+	/* pairs with the write barrier in SnapshotCachePut */
+	pg_read_barrier();
+
+	Assert(TransactionIdEquals(arrayP->cacheXmax, xmax));
+
+	*xmin = arrayP->cacheXmin;
+	*globalxmin = arrayP->cacheGlobalXmin;
+	*count = arrayP->cacheXcnt;
+	*subcount = arrayP->cacheSubxcnt;
+	*suboverflowed = arrayP->cacheSuboverflowed;
+
+	memcpy(snapshot->xip, SnapshotCacheXip,
+		   *count * sizeof(TransactionId));
+	memcpy(snapshot->subxip, SnapshotCacheSubxip,
+		   *subcount * sizeof(TransactionId));
+
+	return true;
+}
+
+/*
+ * SnapshotCachePut -- remember a freshly built snapshot in the shared cache
+ *
+ * The caller must hold ProcArrayLock and must have no XID.  If the cache is
+ * already valid, or another backend is busy filling it, do nothing; any
+ * backend building a snapshot under the same completionCount gets the same
+ * result anyway.
+ */
+static void
+SnapshotCachePut(Snapshot snapshot, TransactionId xmin,
+				 TransactionId xmax, TransactionId globalxmin,
+				 int count, int subcount, bool suboverflowed)
+{
+	ProcArrayStruct *arrayP = procArray;
+
+	if (pg_atomic_read_u64(&arrayP->cacheCount) == arrayP->completionCount)
+		return;
+	if (!pg_atomic_test_set_flag(&arrayP->cacheFilling))
+		return;
+
+	arrayP->cacheXmin = xmin;
+	arrayP->cacheXmax = xmax;
+	arrayP->cacheGlobalXmin = globalxmin;
+	arrayP->cacheXcnt = count;
+	arrayP->cacheSubxcnt = subcount;
+	arrayP->cacheSuboverflowed = suboverflowed;
+	memcpy(SnapshotCacheXip, snapshot->xip,
+		   count * sizeof(TransactionId));
+	memcpy(SnapshotCacheSubxip, snapshot->subxip,
+		   subcount * sizeof(TransactionId));
+
+	/* make the contents visible before marking them valid */
+	pg_write_barrier();
+	pg_atomic_write_u64(&arrayP->cacheCount, arrayP->completionCount);
+
+	pg_atomic_clear_flag(&arrayP->cacheFilling);
+}
+
 /*
  * ProcArrayInstallImportedXmin -- install imported xmin into MyPgXact->xmin
  *
@@ -2171,6 +2342,60 @@ GetOldestActiveTransactionId(void)
 	return oldestRunningXid;
 }
 
+/*
+ * GetOldestXminDatabaseId -- database holding back the xmin horizon
+ *
+ * Returns the OID of the database if all processes that currently hold back
+ * the xmin horizon are connected to that one database, or InvalidOid if they
+ * span several databases, if some of them are not tied to any database, or
+ * if there are none at all.  A walsender whose feedback xmin has been scoped
+ * via xminDatabaseId counts as belonging to that database.
+ *
+ * This is used by the walreceiver when hot_standby_feedback_per_database is
+ * enabled, to tell the primary that its feedback xmin only needs to protect
+ * one database.  Like the xmin itself, the answer may be stale by the time
+ * the caller uses it.
+ */
+Oid
+GetOldestXminDatabaseId(void)
+{
+	ProcArrayStruct *arrayP = procArray;
+	Oid			result = InvalidOid;
+	int			index;
+
+	LWLockAcquire(ProcArrayLock, LW_SHARED);
+
+	for (index = 0; index < arrayP->numProcs; index++)
+	{
+		int			pgprocno = arrayP->pgprocnos[index];
+		PGPROC	   *proc = &allProcs[pgprocno];
+		PGXACT	   *pgxact = &allPgXact[pgprocno];
+		Oid			dbid;
+
+		if (pgxact->vacuumFlags & PROC_IN_LOGICAL_DECODING)
+			continue;
+
+		if (!TransactionIdIsValid(UINT32_ACCESS_ONCE(pgxact->xmin)) &&
+			!TransactionIdIsValid(UINT32_ACCESS_ONCE(pgxact->xid)))
+			continue;
+
+		dbid = proc->databaseId;
+		if (!OidIsValid(dbid))
+			dbid = UINT32_ACCESS_ONCE(proc->xminDatabaseId);
+
+		if (!OidIsValid(dbid) || (OidIsValid(result) && dbid != result))
+		{
+			result = InvalidOid;
+			break;
+		}
+		result = dbid;
+	}
+
+	LWLockRelease(ProcArrayLock);
+
+	return result;
+}
+
 /*
  * GetOldestSafeDecodingTransactionId -- lowest xid not affected by vacuum
  *
@@ -3116,6 +3341,9 @@ XidCacheRemoveRunningXids(TransactionId xid,
 							  latestXid))
 		ShmemVariableCache->latestCompletedXid = latestXid;
 
+	/* and invalidate the shared snapshot cache */
+	procArray->completionCount++;
+
 	LWLockRelease(ProcArrayLock);
 }
 
@@ -66,11 +66,15 @@
 #include "postgres.h"
 
 #include "access/transam.h"
+#include "fmgr.h"
+#include "funcapi.h"
 #include "miscadmin.h"
 #include "storage/lwlock.h"
+#include "storage/pg_numa.h"
 #include "storage/pg_shmem.h"
 #include "storage/shmem.h"
 #include "storage/spin.h"
+#include "utils/builtins.h"
 
 
 /* shared memory global variables */
@@ -467,6 +471,175 @@ ShmemInitStruct(const char *name, Size size, bool *foundPtr)
 	return structPtr;
 }
 
+/*
+ * ShmemSetNumaPlacement -- apply numa_placement to a shared memory area
+ *
+ * This must be called before the area is first touched, since only pages
+ * that have not been faulted in yet are sure to obey the new policy.  With
+ * numa_placement = bind and "can_bind" set, the area is split into one
+ * slice per memory node; otherwise it is interleaved over all nodes.  Areas
+ * whose users are not tied to any node, such as the PGPROC array, should
+ * pass can_bind = false.  Failure is not fatal, merely suboptimal.
+ */
+void
+ShmemSetNumaPlacement(const char *name, void *ptr, Size size, bool can_bind)
+{
+	int			nnodes;
+	bool		ok = true;
+
+	if (numa_placement == NUMA_PLACEMENT_OFF)
+		return;
+
+	/* nothing to do on a single-node machine or an unsupported platform */
+	nnodes = pg_numa_num_nodes();
+	if (nnodes == 0)
+		return;
+
+	if (numa_placement == NUMA_PLACEMENT_BIND && can_bind)
+	{
+		Size		pagesize = pg_numa_page_size();
+		Size		slice = TYPEALIGN(pagesize, size / nnodes);
+		Size		offset = 0;
+		int			node;
+
+		for (node = 0; node < nnodes && offset < size && ok; node++)
+		{
+			Size		len = (node == nnodes - 1) ? size - offset :
+			Min(slice, size - offset);
+
+			ok = pg_numa_bind((char *) ptr + offset, len, node);
+			offset += len;
+		}
+	}
+	else
+		ok = pg_numa_interleave(ptr, size);
+
+	if (!ok)
+		ereport(WARNING,
+				(errmsg("could not set NUMA placement of shared memory area \"%s\": %m",
+						name),
+				 errdetail("Failed system call was mbind(%p, %zu) with page size %zu.",
+						   ptr, size, pg_numa_page_size())));
+}
+
+/*
+ * pg_get_shmem_numa -- report the memory nodes of named shared memory areas
+ *
+ * Returns one row per area and node, giving the amount of memory of the area
+ * resident on that node.  Pages that have never been touched are reported
+ * with a null node.  Since areas are not page-aligned, a page shared by two
+ * areas is counted for both.  If NUMA is not supported, returns no rows.
+ */
+Datum
+pg_get_shmem_numa(PG_FUNCTION_ARGS)
+{
+#define PG_GET_SHMEM_NUMA_COLS	3
+#define PG_GET_SHMEM_NUMA_BATCH	1024
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+	HASH_SEQ_STATUS hstat;
+	ShmemIndexEnt *ent;
+	Size		pagesize;
+	int			nodes[PG_GET_SHMEM_NUMA_BATCH];
+	int64		pages_on_node[PG_NUMA_MAX_NODES + 1];
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not " \
+						"allowed in this context")));
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	if (pg_numa_num_nodes() == 0)
+		return (Datum) 0;
+
+	pagesize = pg_numa_page_size();
+
+	LWLockAcquire(ShmemIndexLock, LW_SHARED);
+
+	hash_seq_init(&hstat, ShmemIndex);
+	while ((ent = (ShmemIndexEnt *) hash_seq_search(&hstat)) != NULL)
+	{
+		char	   *startptr = (char *) TYPEALIGN_DOWN(pagesize, ent->location);
+		char	   *endptr = (char *) TYPEALIGN(pagesize,
+												(char *) ent->location + ent->size);
+		char	   *ptr;
+		int			node;
+
+		memset(pages_on_node, 0, sizeof(pages_on_node));
+
+		for (ptr = startptr; ptr < endptr;
+			 ptr += PG_GET_SHMEM_NUMA_BATCH * pagesize)
+		{
+			int			npages = Min(PG_GET_SHMEM_NUMA_BATCH,
+									 (endptr - ptr) / pagesize);
+			int			i;
+
+			if (!pg_numa_query_nodes(ptr, npages, nodes))
+			{
+				int			save_errno = errno;
+
+				LWLockRelease(ShmemIndexLock);
+				errno = save_errno;
+				ereport(ERROR,
+						(errmsg("could not query NUMA node of shared memory area \"%s\": %m",
+								ent->key)));
+			}
+
+			/* the last slot counts pages not yet allocated */
+			for (i = 0; i < npages; i++)
+				pages_on_node[(nodes[i] >= 0 && nodes[i] < PG_NUMA_MAX_NODES) ?
+							  nodes[i] : PG_NUMA_MAX_NODES]++;
+		}
+
+		for (node = 0; node <= PG_NUMA_MAX_NODES; node++)
+		{
+			Datum		values[PG_GET_SHMEM_NUMA_COLS];
+			bool		nulls[PG_GET_SHMEM_NUMA_COLS];
+
+			if (pages_on_node[node] == 0)
+				continue;
+
+			memset(nulls, 0, sizeof(nulls));
+			values[0] = CStringGetTextDatum(ent->key);
+			if (node < PG_NUMA_MAX_NODES)
+				values[1] = Int32GetDatum(node);
+			else
+				nulls[1] = true;
+			values[2] = Int64GetDatum(pages_on_node[node] * (int64) pagesize);
+
+			tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+		}
+	}
+
+	LWLockRelease(ShmemIndexLock);
+
+	/* clean up and return the tuplestore */
+	tuplestore_donestoring(tupstore);
+
+	return (Datum) 0;
+}
 
 /*
  * Add two Size values, checking for overflow
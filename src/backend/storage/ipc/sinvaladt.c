@@ -44,15 +44,25 @@
  * SICleanupQueue is called, and we try not to do that often.)
  *
  * In reality, the messages are stored in a circular buffer of MAXNUMMESSAGES
- * entries.  We translate MsgNum values into circular-buffer indexes by
- * computing MsgNum % MAXNUMMESSAGES (this should be fast as long as
- * MAXNUMMESSAGES is a constant and a power of 2).  As long as maxMsgNum
- * doesn't exceed minMsgNum by more than MAXNUMMESSAGES, we have enough space
- * in the buffer.  If the buffer does overflow, we recover by setting the
- * "reset" flag for each backend that has fallen too far behind.  A backend
- * that is in "reset" state is ignored while determining minMsgNum.  When
- * it does finally attempt to receive inval messages, it must discard all
- * its invalidatable state, since it won't know what it missed.
+ * entries, which is sized by shared_invalidation_queue_size at postmaster
+ * start.  We translate MsgNum values into circular-buffer indexes by
+ * computing MsgNum & (MAXNUMMESSAGES - 1), which works because the size is
+ * required to be a power of 2.  As long as maxMsgNum doesn't exceed
+ * minMsgNum by more than MAXNUMMESSAGES, we have enough space in the
+ * buffer.  If the buffer does overflow, we recover by setting the "reset"
+ * flag for each backend that has fallen too far behind.  A backend that is
+ * in "reset" state is ignored while determining minMsgNum.  When it does
+ * finally attempt to receive inval messages, it must discard all its
+ * invalidatable state, since it won't know what it missed.
+ *
+ * Most messages only matter to backends connected to one particular
+ * database, though; see SIMessageIsRelevant.  Before resetting a backend,
+ * SICleanupQueue checks whether any of the messages it is about to lose
+ * could matter to that backend.  If none can, as is typical when a burst of
+ * DDL in one database overruns backends idling in other databases, the
+ * backend is simply advanced past them instead of being forced to rebuild
+ * all its caches.  Backends likewise skip irrelevant messages when reading
+ * the queue.
  *
  * To reduce the probability of needing resets, we send a "catchup" interrupt
  * to any backend that seems to be falling unreasonably far behind.  The
@@ -108,7 +118,8 @@
  * Configurable parameters.
  *
  * MAXNUMMESSAGES: max number of shared-inval messages we can buffer.
- * Must be a power of 2 for speed.
+ * Set by shared_invalidation_queue_size; guc.c makes sure that it is a
+ * power of 2, and no more than 2^20.
  *
  * MSGNUMWRAPAROUND: how often to reduce MsgNum variables to avoid overflow.
  * Must be a multiple of MAXNUMMESSAGES.  Should be large.
@@ -128,8 +139,9 @@
  * per iteration.
  */
 
-#define MAXNUMMESSAGES 4096
-#define MSGNUMWRAPAROUND (MAXNUMMESSAGES * 262144)
+#define MAXNUMMESSAGES shared_invalidation_queue_size
+#define MSGNUMWRAPAROUND 0x40000000
+#define MSGNUMTOINDEX(n) ((n) & (MAXNUMMESSAGES - 1))
 #define CLEANUP_MIN (MAXNUMMESSAGES / 2)
 #define CLEANUP_QUANTUM (MAXNUMMESSAGES / 16)
 #define SIG_THRESHOLD (MAXNUMMESSAGES / 2)
@@ -179,9 +191,10 @@ typedef struct SISeg
 	slock_t		msgnumLock;		/* spinlock protecting maxMsgNum */
 
 	/*
-	 * Circular buffer holding shared-inval messages
+	 * Circular buffer holding shared-inval messages (has MAXNUMMESSAGES
+	 * entries, and is located after the procState array).
 	 */
-	SharedInvalidationMessage buffer[MAXNUMMESSAGES];
+	SharedInvalidationMessage *buffer;
 
 	/*
 	 * Per-backend invalidation state info (has MaxBackends entries).
@@ -191,10 +204,44 @@ typedef struct SISeg
 
 static SISeg *shmInvalBuffer;	/* pointer to the shared inval buffer */
 
+/* GUC variable */
+int			shared_invalidation_queue_size = 4096;
+
 
 static LocalTransactionId nextLocalTransactionId;
 
 static void CleanupInvalidationState(int status, Datum arg);
+static bool SIMessagesRelevant(SISeg *segP, int from, int to, Oid dbId);
+
+
+/*
+ * SIMessageIsRelevant
+ *		Could this message affect a backend connected to database dbId?
+ *
+ * This must agree with the tests in LocalExecuteInvalidationMessage.  smgr
+ * messages are always relevant, since a backend can have smgr entries for
+ * relations of other databases.
+ */
+static inline bool
+SIMessageIsRelevant(const SharedInvalidationMessage *msg, Oid dbId)
+{
+	Oid			msgDbId;
+
+	if (msg->id >= 0)
+		msgDbId = msg->cc.dbId;
+	else if (msg->id == SHAREDINVALCATALOG_ID)
+		msgDbId = msg->cat.dbId;
+	else if (msg->id == SHAREDINVALRELCACHE_ID)
+		msgDbId = msg->rc.dbId;
+	else if (msg->id == SHAREDINVALRELMAP_ID)
+		msgDbId = msg->rm.dbId;
+	else if (msg->id == SHAREDINVALSNAPSHOT_ID)
+		msgDbId = msg->sn.dbId;
+	else
+		return true;
+
+	return msgDbId == dbId || msgDbId == InvalidOid;
+}
 
 
 /*
@@ -207,6 +254,9 @@ SInvalShmemSize(void)
 
 	size = offsetof(SISeg, procState);
 	size = add_size(size, mul_size(sizeof(ProcState), MaxBackends));
+	size = MAXALIGN(size);
+	size = add_size(size, mul_size(sizeof(SharedInvalidationMessage),
+								   MAXNUMMESSAGES));
 
 	return size;
 }
@@ -234,6 +284,10 @@ CreateSharedInvalidationState(void)
 	shmInvalBuffer->lastBackend = 0;
 	shmInvalBuffer->maxBackends = MaxBackends;
 	SpinLockInit(&shmInvalBuffer->msgnumLock);
+	shmInvalBuffer->buffer = (SharedInvalidationMessage *)
+		((char *) shmInvalBuffer +
+		 MAXALIGN(offsetof(SISeg, procState) +
+				  mul_size(sizeof(ProcState), MaxBackends)));
 
 	/* The buffer[] array is initially all unused, so we need not fill it */
 
@@ -480,7 +534,7 @@ SIInsertDataEntries(const SharedInvalidationMessage *data, int n)
 		max = segP->maxMsgNum;
 		while (nthistime-- > 0)
 		{
-			segP->buffer[max % MAXNUMMESSAGES] = *data++;
+			segP->buffer[MSGNUMTOINDEX(max)] = *data++;
 			max++;
 		}
 
@@ -594,7 +648,8 @@ SIGetDataEntries(SharedInvalidationMessage *data, int datasize)
 
 	/*
 	 * Retrieve messages and advance backend's counter, until data array is
-	 * full or there are no more messages.
+	 * full or there are no more messages.  Messages that cannot matter to
+	 * our database are skipped over without returning them.
 	 *
 	 * There may be other backends that haven't read the message(s), so we
 	 * cannot delete them here.  SICleanupQueue() will eventually remove them
@@ -603,7 +658,11 @@ SIGetDataEntries(SharedInvalidationMessage *data, int datasize)
 	n = 0;
 	while (n < datasize && stateP->nextMsgNum < max)
 	{
-		data[n++] = segP->buffer[stateP->nextMsgNum % MAXNUMMESSAGES];
+		SharedInvalidationMessage *msg;
+
+		msg = &segP->buffer[MSGNUMTOINDEX(stateP->nextMsgNum)];
+		if (SIMessageIsRelevant(msg, MyDatabaseId))
+			data[n++] = *msg;
 		stateP->nextMsgNum++;
 	}
 
@@ -677,13 +736,23 @@ SICleanupQueue(bool callerHasWriteLock, int minFree)
 
 		/*
 		 * If we must free some space and this backend is preventing it, force
-		 * him into reset state and then ignore until he catches up.
+		 * him into reset state and then ignore until he catches up.  But if
+		 * none of the messages he'd lose can matter to him, just advance him
+		 * past them.  Backends that are not (yet) advertising a database get
+		 * reset, since they might still be about to connect to any database.
 		 */
 		if (n < lowbound)
 		{
-			stateP->resetState = true;
-			/* no point in signaling him ... */
-			continue;
+			Oid			dbId = stateP->proc->databaseId;
+
+			if (!OidIsValid(dbId) ||
+				SIMessagesRelevant(segP, n, lowbound, dbId))
+			{
+				stateP->resetState = true;
+				/* no point in signaling him ... */
+				continue;
+			}
+			stateP->nextMsgNum = n = lowbound;
 		}
 
 		/* Track the global minimum nextMsgNum */
@@ -751,6 +820,26 @@ SICleanupQueue(bool callerHasWriteLock, int minFree)
 	}
 }
 
+/*
+ * SIMessagesRelevant
+ *		Could any of messages from .. to-1 affect a backend in database dbId?
+ *
+ * Caller must hold SInvalReadLock exclusively; the messages must still be in
+ * the buffer.
+ */
+static bool
+SIMessagesRelevant(SISeg *segP, int from, int to, Oid dbId)
+{
+	int			i;
+
+	for (i = from; i < to; i++)
+	{
+		if (SIMessageIsRelevant(&segP->buffer[MSGNUMTOINDEX(i)], dbId))
+			return true;
+	}
+	return false;
+}
+
 
 /*
  * GetNextLocalTransactionId --- allocate a new LocalTransactionId
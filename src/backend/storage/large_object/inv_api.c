@@ -46,6 +46,7 @@
 #include "miscadmin.h"
 #include "storage/large_object.h"
 #include "utils/fmgroids.h"
+#include "utils/memutils.h"
 #include "utils/rel.h"
 #include "utils/snapmgr.h"
 #include "utils/tqual.h"
@@ -56,6 +57,12 @@
  */
 bool		lo_compat_privileges;
 
+/*
+ * Amount of data read ahead for small reads through a read-only descriptor.
+ * Reads at least this large bypass the read-ahead buffer.
+ */
+#define LO_READAHEAD_SIZE	(64 * LOBLKSIZE)
+
 /*
  * All accesses to pg_largeobject and its index make use of a single Relation
  * reference, so that we only need to open pg_relation once per transaction.
@@ -66,6 +73,8 @@ bool		lo_compat_privileges;
 static Relation lo_heap_r = NULL;
 static Relation lo_index_r = NULL;
 
+static int	inv_read_pages(LargeObjectDesc *obj_desc, char *buf, int nbytes);
+
 
 /*
  * Open pg_largeobject and its index, if not already done in current xact
@@ -316,6 +325,9 @@ inv_open(Oid lobjId, int flags, MemoryContext mcxt)
 	retval->subid = GetCurrentSubTransactionId();
 	retval->offset = 0;
 	retval->flags = descflags;
+	retval->readbuf = NULL;
+	retval->readbuf_offset = 0;
+	retval->readbuf_len = 0;
 
 	/*
 	 * We must register the snapshot in TopTransaction's resowner, because it
@@ -343,6 +355,8 @@ inv_close(LargeObjectDesc *obj_desc)
 	UnregisterSnapshotFromOwner(obj_desc->snapshot,
 								TopTransactionResourceOwner);
 
+	if (obj_desc->readbuf)
+		pfree(obj_desc->readbuf);
 	pfree(obj_desc);
 }
 
@@ -493,15 +507,8 @@ inv_tell(LargeObjectDesc *obj_desc)
 int
 inv_read(LargeObjectDesc *obj_desc, char *buf, int nbytes)
 {
-	int			nread = 0;
-	int64		n;
-	int64		off;
-	int			len;
-	int32		pageno = (int32) (obj_desc->offset / LOBLKSIZE);
-	uint64		pageoff;
-	ScanKeyData skey[2];
-	SysScanDesc sd;
-	HeapTuple	tuple;
+	uint64		bufend;
+	int			n;
 
 	Assert(PointerIsValid(obj_desc));
 	Assert(buf != NULL);
@@ -515,6 +522,64 @@ inv_read(LargeObjectDesc *obj_desc, char *buf, int nbytes)
 	if (nbytes <= 0)
 		return 0;
 
+	/*
+	 * Large reads, and reads through a descriptor that can also write (and
+	 * so must see the latest data), go straight to pg_largeobject.
+	 */
+	if ((obj_desc->flags & IFS_WRLOCK) != 0 || nbytes >= LO_READAHEAD_SIZE)
+		return inv_read_pages(obj_desc, buf, nbytes);
+
+	/*
+	 * A read-only descriptor always reads with the same snapshot, so what we
+	 * read once stays valid.  Serve small reads from a buffer of data read
+	 * ahead, so that reading an LO sequentially in small pieces isn't an
+	 * index scan per piece.
+	 */
+	bufend = obj_desc->readbuf_offset + obj_desc->readbuf_len;
+	if (obj_desc->readbuf == NULL ||
+		obj_desc->offset < obj_desc->readbuf_offset ||
+		obj_desc->offset + nbytes > bufend)
+	{
+		uint64		offset = obj_desc->offset;
+
+		if (obj_desc->readbuf == NULL)
+			obj_desc->readbuf =
+				MemoryContextAlloc(GetMemoryChunkContext(obj_desc),
+								   LO_READAHEAD_SIZE);
+		obj_desc->readbuf_len = 0;
+		obj_desc->readbuf_offset = offset;
+		obj_desc->readbuf_len = inv_read_pages(obj_desc, obj_desc->readbuf,
+											   LO_READAHEAD_SIZE);
+		obj_desc->offset = offset;
+		bufend = offset + obj_desc->readbuf_len;
+	}
+
+	/* Fewer bytes than requested means we've hit the end of the LO */
+	n = (int) Min((uint64) nbytes, bufend - obj_desc->offset);
+	memcpy(buf, obj_desc->readbuf + (obj_desc->offset - obj_desc->readbuf_offset),
+		   n);
+	obj_desc->offset += n;
+
+	return n;
+}
+
+/*
+ * Read nbytes of the LO at the current seek position from pg_largeobject,
+ * in one scan of its index, and advance the seek position past them.
+ */
+static int
+inv_read_pages(LargeObjectDesc *obj_desc, char *buf, int nbytes)
+{
+	int			nread = 0;
+	int64		n;
+	int64		off;
+	int			len;
+	int32		pageno = (int32) (obj_desc->offset / LOBLKSIZE);
+	uint64		pageoff;
+	ScanKeyData skey[2];
+	SysScanDesc sd;
+	HeapTuple	tuple;
+
 	open_lo_relation();
 
 	ScanKeyInit(&skey[0],
@@ -72,6 +72,16 @@
  *
  * This protects us against the problem from above as nobody can release too
  *	  quick, before we're queued, since after Phase 2 we're already queued.
+ *
+ * Sleeping and being woken up through the semaphore takes far longer than
+ * most LWLocks are held for, so before queuing up in LWLockAcquire we spin
+ * for a short while, watching the lock word without writing to it, in case
+ * the holder releases it.  We only do that if nobody is queued on the lock
+ * yet; otherwise the lock is evidently busy enough that spinning is unlikely
+ * to pay off, and would let us jump ahead of processes that are already
+ * waiting.  The number of spins is adjusted per tranche according to
+ * whether spinning has recently worked, so that locks that are often held
+ * across I/O, such as WALWriteLock, quickly stop being spun on.
  * -------------------------------------------------------------------------
  */
 #include "postgres.h"
@@ -79,6 +89,7 @@
 #include "miscadmin.h"
 #include "pgstat.h"
 #include "pg_trace.h"
+#include "portability/instr_time.h"
 #include "postmaster/postmaster.h"
 #include "replication/slot.h"
 #include "storage/ipc.h"
@@ -107,6 +118,11 @@ extern slock_t *ShmemLock;
 /* Must be greater than MAX_BACKENDS - which is 2^23-1, so we're fine. */
 #define LW_SHARED_MASK				((uint32) ((1 << 24)-1))
 
+/* Bounds for the adaptive spinning done by LWLockSpinUntilFree */
+#define LWLOCK_MIN_SPINS			10
+#define LWLOCK_MAX_SPINS			1000
+#define LWLOCK_DEFAULT_SPINS		100
+
 /*
  * This is indexed by tranche ID and stores the names of all tranches known
  * to the current backend.
@@ -163,6 +179,54 @@ static void RegisterLWLockTranches(void);
 static inline void LWLockReportWaitStart(LWLock *lock);
 static inline void LWLockReportWaitEnd(void);
 
+/*
+ * Always-on per-tranche wait statistics, reported by pg_stat_lwlocks.
+ *
+ * Each PGPROC slot has its own row of counters in shared memory, so a
+ * process only ever writes to its own cache lines and can update them
+ * without atomics or locking.  Readers sum over all slots, accepting that
+ * they might see slightly stale values.  Slots are not cleared when a
+ * process exits; the next process to use the PGPROC simply keeps adding to
+ * the same counters, so the totals cover everything since startup.
+ */
+static LWLockTrancheStats *LWLockStatsArray = NULL;
+static LWLockTrancheStats *MyLWLockStats = NULL;
+
+/*
+ * Current spin limit per tranche for LWLockSpinUntilFree, indexed like the
+ * statistics slots; zero means LWLOCK_DEFAULT_SPINS.  This is local to each
+ * process, like spins_per_delay before it is reported to shared memory.
+ */
+static uint16 lwlock_spin_limit[LWLOCK_STATS_NUM_TRANCHES];
+
+/* state of the wait in progress, between LWLockReportWaitStart/End */
+static LWLockTrancheStats *lwlock_wait_stats = NULL;
+static instr_time lwlock_wait_start;
+
+#define LWLockStatsNumProcs()	(MaxBackends + NUM_AUXILIARY_PROCS)
+
+/*
+ * Return this process's statistics entry for the lock's tranche, or NULL
+ * if we aren't collecting statistics (yet).  All tranches outside the
+ * builtin range share one entry.
+ */
+static inline LWLockTrancheStats *
+LWLockStatsEntry(LWLock *lock)
+{
+	if (MyLWLockStats == NULL)
+		return NULL;
+	return &MyLWLockStats[Min(lock->tranche, LWLOCK_STATS_EXTENSION_SLOT)];
+}
+
+static inline void
+LWLockStatsCountAcquire(LWLock *lock)
+{
+	LWLockTrancheStats *entry = LWLockStatsEntry(lock);
+
+	if (entry)
+		entry->acquires++;
+}
+
 #ifdef LWLOCK_STATS
 typedef struct lwlock_stats_key
 {
@@ -521,6 +585,8 @@ RegisterLWLockTranches(void)
 	LWLockRegisterTranche(LWTRANCHE_TBM, "tbm");
 	LWLockRegisterTranche(LWTRANCHE_PARALLEL_APPEND, "parallel_append");
 	LWLockRegisterTranche(LWTRANCHE_PARALLEL_HASH_JOIN, "parallel_hash_join");
+	LWLockRegisterTranche(LWTRANCHE_STATS_DSA, "stats_dsa");
+	LWLockRegisterTranche(LWTRANCHE_STATS_HASH, "stats_hash");
 
 	/* Register named tranches. */
 	for (i = 0; i < NamedLWLockTrancheRequests; i++)
@@ -528,8 +594,35 @@ RegisterLWLockTranches(void)
 							  NamedLWLockTrancheArray[i].trancheName);
 }
 
+/*
+ * Compute shmem space needed for LWLock statistics.
+ */
+Size
+LWLockStatsShmemSize(void)
+{
+	return mul_size(mul_size(LWLockStatsNumProcs(), LWLOCK_STATS_NUM_TRANCHES),
+					sizeof(LWLockTrancheStats));
+}
+
+/*
+ * Allocate and initialize shmem space for LWLock statistics.
+ */
+void
+LWLockStatsShmemInit(void)
+{
+	bool		found;
+
+	LWLockStatsArray = (LWLockTrancheStats *)
+		ShmemInitStruct("LWLock Statistics", LWLockStatsShmemSize(), &found);
+
+	if (!found)
+		MemSet(LWLockStatsArray, 0, LWLockStatsShmemSize());
+}
+
 /*
  * InitLWLockAccess - initialize backend-local state needed to hold LWLocks
+ *
+ * The caller must have set up MyProc.
  */
 void
 InitLWLockAccess(void)
@@ -537,6 +630,47 @@ InitLWLockAccess(void)
 #ifdef LWLOCK_STATS
 	init_lwlock_stats();
 #endif
+
+	Assert(MyProc != NULL);
+	if (LWLockStatsArray != NULL && MyProc->pgprocno < LWLockStatsNumProcs())
+		MyLWLockStats = &LWLockStatsArray[MyProc->pgprocno *
+										  LWLOCK_STATS_NUM_TRANCHES];
+}
+
+/*
+ * LWLockGetTrancheStats - sum the statistics of all processes for the given
+ *		statistics slot, which is a tranche ID no larger than
+ *		LWLOCK_STATS_EXTENSION_SLOT.
+ *
+ * No locks are taken, so the result is only approximate while other
+ * processes are busy.
+ */
+void
+LWLockGetTrancheStats(int slot, LWLockTrancheStats *stats)
+{
+	int			procno;
+
+	Assert(slot >= 0 && slot < LWLOCK_STATS_NUM_TRANCHES);
+
+	MemSet(stats, 0, sizeof(LWLockTrancheStats));
+
+	if (LWLockStatsArray == NULL)
+		return;
+
+	for (procno = 0; procno < LWLockStatsNumProcs(); procno++)
+	{
+		volatile LWLockTrancheStats *entry;
+		int			i;
+
+		entry = &LWLockStatsArray[procno * LWLOCK_STATS_NUM_TRANCHES + slot];
+
+		stats->acquires += entry->acquires;
+		stats->waits += entry->waits;
+		stats->spin_delays += entry->spin_delays;
+		stats->wait_time += entry->wait_time;
+		for (i = 0; i < LWLOCK_STATS_WAIT_BUCKETS; i++)
+			stats->wait_histogram[i] += entry->wait_histogram[i];
+	}
 }
 
 /*
@@ -694,6 +828,15 @@ LWLockInitialize(LWLock *lock, int tranche_id)
 static inline void
 LWLockReportWaitStart(LWLock *lock)
 {
+	LWLockTrancheStats *entry = LWLockStatsEntry(lock);
+
+	if (entry)
+	{
+		entry->waits++;
+		INSTR_TIME_SET_CURRENT(lwlock_wait_start);
+	}
+	lwlock_wait_stats = entry;
+
 	pgstat_report_wait_start(PG_WAIT_LWLOCK | lock->tranche);
 }
 
@@ -704,6 +847,27 @@ static inline void
 LWLockReportWaitEnd(void)
 {
 	pgstat_report_wait_end();
+
+	if (lwlock_wait_stats)
+	{
+		instr_time	duration;
+		uint64		usecs;
+		uint64		val;
+		int			bucket = 0;
+
+		INSTR_TIME_SET_CURRENT(duration);
+		INSTR_TIME_SUBTRACT(duration, lwlock_wait_start);
+		usecs = INSTR_TIME_GET_MICROSEC(duration);
+
+		/* bucket n holds waits of [2^n, 2^(n+1)) us; bucket 0 also < 1 us */
+		for (val = usecs; val > 1 && bucket < LWLOCK_STATS_WAIT_BUCKETS - 1;
+			 val >>= 1)
+			bucket++;
+
+		lwlock_wait_stats->wait_time += usecs;
+		lwlock_wait_stats->wait_histogram[bucket]++;
+		lwlock_wait_stats = NULL;
+	}
 }
 
 /*
@@ -798,6 +962,74 @@ LWLockAttemptLock(LWLock *lock, LWLockMode mode)
 	pg_unreachable();
 }
 
+/*
+ * Get the current spin limit for the lock's tranche.
+ */
+static inline int
+LWLockGetSpinLimit(LWLock *lock)
+{
+	int			limit;
+
+	limit = lwlock_spin_limit[Min(lock->tranche, LWLOCK_STATS_EXTENSION_SLOT)];
+	return limit == 0 ? LWLOCK_DEFAULT_SPINS : limit;
+}
+
+/*
+ * Adjust the spin limit for the lock's tranche after spinning on it.  Like
+ * finish_spin_delay's spins_per_delay, it's raised only if spinning got us
+ * the lock, and lowered otherwise.
+ */
+static void
+LWLockUpdateSpinLimit(LWLock *lock, bool acquired)
+{
+	int			slot = Min(lock->tranche, LWLOCK_STATS_EXTENSION_SLOT);
+	int			limit = LWLockGetSpinLimit(lock);
+
+	if (acquired)
+		lwlock_spin_limit[slot] = Min(limit + 100, LWLOCK_MAX_SPINS);
+	else
+		lwlock_spin_limit[slot] = Max(limit - 10, LWLOCK_MIN_SPINS);
+}
+
+/*
+ * Spin for a bounded time waiting for the lock to become available in the
+ * given mode, without trying to take it.
+ *
+ * Returns true if the lock looked free before we ran out of spins, in which
+ * case the caller should retry LWLockAttemptLock and report the outcome to
+ * LWLockUpdateSpinLimit.  Returns false without spinning at all if other
+ * processes are already queued on the lock.
+ */
+static bool
+LWLockSpinUntilFree(LWLock *lock, LWLockMode mode)
+{
+	uint32		conflict_mask;
+	int			limit = LWLockGetSpinLimit(lock);
+	int			spins;
+
+	if (mode == LW_EXCLUSIVE)
+		conflict_mask = LW_LOCK_MASK;
+	else
+		conflict_mask = LW_VAL_EXCLUSIVE;
+
+	for (spins = 0; spins < limit; spins++)
+	{
+		uint32		state = pg_atomic_read_u32(&lock->state);
+
+		if (state & LW_FLAG_HAS_WAITERS)
+			return false;
+
+		if ((state & conflict_mask) == 0)
+			return true;
+
+		SPIN_DELAY();
+	}
+
+	/* didn't work this time; spin a little less next time */
+	LWLockUpdateSpinLimit(lock, false);
+	return false;
+}
+
 /*
  * Lock the LWLock's wait list against concurrent activity.
  *
@@ -810,9 +1042,9 @@ static void
 LWLockWaitListLock(LWLock *lock)
 {
 	uint32		old_state;
+	uint32		delays = 0;
 #ifdef LWLOCK_STATS
 	lwlock_stats *lwstats;
-	uint32		delays = 0;
 
 	lwstats = get_lwlock_stats_entry(lock);
 #endif
@@ -835,9 +1067,7 @@ LWLockWaitListLock(LWLock *lock)
 				perform_spin_delay(&delayStatus);
 				old_state = pg_atomic_read_u32(&lock->state);
 			}
-#ifdef LWLOCK_STATS
 			delays += delayStatus.delays;
-#endif
 			finish_spin_delay(&delayStatus);
 		}
 
@@ -847,6 +1077,14 @@ LWLockWaitListLock(LWLock *lock)
 		 */
 	}
 
+	if (delays > 0)
+	{
+		LWLockTrancheStats *entry = LWLockStatsEntry(lock);
+
+		if (entry)
+			entry->spin_delays += delays;
+	}
+
 #ifdef LWLOCK_STATS
 	lwstats->spin_delay_count += delays;
 #endif
@@ -1191,6 +1429,22 @@ LWLockAcquire(LWLock *lock, LWLockMode mode)
 			break;				/* got the lock */
 		}
 
+		/*
+		 * Before going to the trouble of queuing and sleeping, spin briefly
+		 * in case the lock is about to be released.
+		 */
+		if (LWLockSpinUntilFree(lock, mode))
+		{
+			bool		acquired = !LWLockAttemptLock(lock, mode);
+
+			LWLockUpdateSpinLimit(lock, acquired);
+			if (acquired)
+			{
+				LOG_LWDEBUG("LWLockAcquire", lock, "acquired after spinning");
+				break;			/* got the lock */
+			}
+		}
+
 		/*
 		 * Ok, at this point we couldn't grab the lock on the first try. We
 		 * cannot simply queue ourselves to the end of the list and wait to be
@@ -1272,6 +1526,7 @@ LWLockAcquire(LWLock *lock, LWLockMode mode)
 	/* Add lock to list of locks held by this backend */
 	held_lwlocks[num_held_lwlocks].lock = lock;
 	held_lwlocks[num_held_lwlocks++].mode = mode;
+	LWLockStatsCountAcquire(lock);
 
 	/*
 	 * Fix the process wait semaphore's count for any absorbed wakeups.
@@ -1325,6 +1580,7 @@ LWLockConditionalAcquire(LWLock *lock, LWLockMode mode)
 		/* Add lock to list of locks held by this backend */
 		held_lwlocks[num_held_lwlocks].lock = lock;
 		held_lwlocks[num_held_lwlocks++].mode = mode;
+		LWLockStatsCountAcquire(lock);
 		TRACE_POSTGRESQL_LWLOCK_CONDACQUIRE(T_NAME(lock), mode);
 	}
 	return !mustwait;
@@ -1453,6 +1709,7 @@ LWLockAcquireOrWait(LWLock *lock, LWLockMode mode)
 		/* Add lock to list of locks held by this backend */
 		held_lwlocks[num_held_lwlocks].lock = lock;
 		held_lwlocks[num_held_lwlocks++].mode = mode;
+		LWLockStatsCountAcquire(lock);
 		TRACE_POSTGRESQL_LWLOCK_ACQUIRE_OR_WAIT(T_NAME(lock), mode);
 	}
 
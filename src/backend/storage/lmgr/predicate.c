@@ -3905,6 +3905,7 @@ CheckForSerializableConflictOut(bool visible, Relation relation,
 	SERIALIZABLEXID *sxid;
 	SERIALIZABLEXACT *sxact;
 	HTSV_Result htsvResult;
+	LWLockMode	lockmode;
 
 	if (!SerializationNeededForRead(relation, snapshot))
 		return;
@@ -3981,9 +3982,16 @@ CheckForSerializableConflictOut(bool visible, Relation relation,
 
 	/*
 	 * Find sxact or summarized info for the top level xid.
+	 *
+	 * Usually it turns out that there's nothing to do, so we look with just a
+	 * shared lock first, like CheckTargetForConflictsIn.  If we find that we
+	 * have to change something, we start over with an exclusive lock, since
+	 * anything might have changed while we held no lock.
 	 */
 	sxidtag.xid = xid;
-	LWLockAcquire(SerializableXactHashLock, LW_EXCLUSIVE);
+	lockmode = LW_SHARED;
+recheck:
+	LWLockAcquire(SerializableXactHashLock, lockmode);
 	sxid = (SERIALIZABLEXID *)
 		hash_search(SerializableXidHash, &sxidtag, HASH_FIND, NULL);
 	if (!sxid)
@@ -4015,7 +4023,16 @@ CheckForSerializableConflictOut(bool visible, Relation relation,
 						 errdetail_internal("Reason code: Canceled on identification as a pivot, with conflict out to old committed transaction %u.", xid),
 						 errhint("The transaction might succeed if retried.")));
 
-			MySerializableXact->flags |= SXACT_FLAG_SUMMARY_CONFLICT_OUT;
+			if (!SxactHasSummaryConflictOut(MySerializableXact))
+			{
+				if (lockmode == LW_SHARED)
+				{
+					LWLockRelease(SerializableXactHashLock);
+					lockmode = LW_EXCLUSIVE;
+					goto recheck;
+				}
+				MySerializableXact->flags |= SXACT_FLAG_SUMMARY_CONFLICT_OUT;
+			}
 		}
 
 		/* It's not serializable or otherwise not important. */
@@ -4041,6 +4058,12 @@ CheckForSerializableConflictOut(bool visible, Relation relation,
 	{
 		if (!SxactIsPrepared(sxact))
 		{
+			if (lockmode == LW_SHARED)
+			{
+				LWLockRelease(SerializableXactHashLock);
+				lockmode = LW_EXCLUSIVE;
+				goto recheck;
+			}
 			sxact->flags |= SXACT_FLAG_DOOMED;
 			LWLockRelease(SerializableXactHashLock);
 			return;
@@ -4086,6 +4109,13 @@ CheckForSerializableConflictOut(bool visible, Relation relation,
 		return;
 	}
 
+	if (lockmode == LW_SHARED)
+	{
+		LWLockRelease(SerializableXactHashLock);
+		lockmode = LW_EXCLUSIVE;
+		goto recheck;
+	}
+
 	/*
 	 * Flag the conflict.  But first, if this conflict creates a dangerous
 	 * structure, ereport an error.
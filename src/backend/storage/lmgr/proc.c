@@ -93,6 +93,7 @@ static void RemoveProcFromArray(int code, Datum arg);
 static void ProcKill(int code, Datum arg);
 static void AuxiliaryProcKill(int code, Datum arg);
 static void CheckDeadLock(void);
+static Size FastPathLockShmemSizePerProc(void);
 
 
 /*
@@ -118,6 +119,27 @@ ProcGlobalShmemSize(void)
 	size = add_size(size, mul_size(NUM_AUXILIARY_PROCS, sizeof(PGXACT)));
 	size = add_size(size, mul_size(max_prepared_xacts, sizeof(PGXACT)));
 
+	/* Fast-path lock arrays, for every PGPROC */
+	size = add_size(size,
+					mul_size(add_size(add_size(MaxBackends, NUM_AUXILIARY_PROCS),
+									  max_prepared_xacts),
+							 FastPathLockShmemSizePerProc()));
+
+	return size;
+}
+
+/*
+ * Report the space needed for the fast-path lock arrays of one PGPROC.
+ */
+static Size
+FastPathLockShmemSizePerProc(void)
+{
+	Size		size;
+
+	size = MAXALIGN(mul_size(FastPathLockGroupsPerBackend, sizeof(uint64)));
+	size = add_size(size,
+					MAXALIGN(mul_size(FP_LOCK_SLOTS_PER_BACKEND, sizeof(Oid))));
+
 	return size;
 }
 
@@ -163,6 +185,9 @@ InitProcGlobal(void)
 {
 	PGPROC	   *procs;
 	PGXACT	   *pgxacts;
+	char	   *fpPtr;
+	Size		fpLockBitsSize,
+				fpRelIdSize;
 	int			i,
 				j;
 	bool		found;
@@ -196,7 +221,11 @@ InitProcGlobal(void)
 	 * dedicated to exactly one of these purposes, and they do not move
 	 * between groups.
 	 */
-	procs = (PGPROC *) ShmemAlloc(TotalProcs * sizeof(PGPROC));
+	procs = (PGPROC *) ShmemInitStruct("PGPROC Array",
+									   TotalProcs * sizeof(PGPROC), &found);
+	Assert(!found);
+	ShmemSetNumaPlacement("PGPROC Array", procs, TotalProcs * sizeof(PGPROC),
+						  false);
 	MemSet(procs, 0, TotalProcs * sizeof(PGPROC));
 	ProcGlobal->allProcs = procs;
 	/* XXX allProcCount isn't really all of them; it excludes prepared xacts */
@@ -210,14 +239,38 @@ InitProcGlobal(void)
 	 * multiprocessor system.  There is one PGXACT structure for every PGPROC
 	 * structure.
 	 */
-	pgxacts = (PGXACT *) ShmemAlloc(TotalProcs * sizeof(PGXACT));
+	pgxacts = (PGXACT *) ShmemInitStruct("PGXACT Array",
+										 TotalProcs * sizeof(PGXACT), &found);
+	Assert(!found);
+	ShmemSetNumaPlacement("PGXACT Array", pgxacts,
+						  TotalProcs * sizeof(PGXACT), false);
 	MemSet(pgxacts, 0, TotalProcs * sizeof(PGXACT));
 	ProcGlobal->allPgXact = pgxacts;
 
+	/*
+	 * The fast-path lock arrays are sized at startup, so they can't be part
+	 * of the PGPROC struct itself; carve them out of another array instead.
+	 */
+	fpLockBitsSize = MAXALIGN(FastPathLockGroupsPerBackend * sizeof(uint64));
+	fpRelIdSize = MAXALIGN(FP_LOCK_SLOTS_PER_BACKEND * sizeof(Oid));
+	Assert(fpLockBitsSize + fpRelIdSize == FastPathLockShmemSizePerProc());
+
+	fpPtr = ShmemInitStruct("Fast-Path Lock Array",
+							TotalProcs * (fpLockBitsSize + fpRelIdSize),
+							&found);
+	Assert(!found);
+	MemSet(fpPtr, 0, TotalProcs * (fpLockBitsSize + fpRelIdSize));
+
 	for (i = 0; i < TotalProcs; i++)
 	{
 		/* Common initialization for all PGPROCs, regardless of type. */
 
+		/* Point the PGPROC at its own part of the fast-path lock arrays */
+		procs[i].fpLockBits = (uint64 *) fpPtr;
+		fpPtr += fpLockBitsSize;
+		procs[i].fpRelId = (Oid *) fpPtr;
+		fpPtr += fpRelIdSize;
+
 		/*
 		 * Set up per-PGPROC semaphore, latch, and backendLock. Prepared xact
 		 * dummy PGPROCs don't need these though - they're never associated
@@ -379,6 +432,7 @@ InitProcess(void)
 	MyProc->databaseId = InvalidOid;
 	MyProc->roleId = InvalidOid;
 	MyProc->tempNamespaceId = InvalidOid;
+	MyProc->xminDatabaseId = InvalidOid;
 	MyProc->isBackgroundWorker = IsBackgroundWorker;
 	MyPgXact->delayChkpt = false;
 	MyPgXact->vacuumFlags = 0;
@@ -561,6 +615,7 @@ InitAuxiliaryProcess(void)
 	MyProc->databaseId = InvalidOid;
 	MyProc->roleId = InvalidOid;
 	MyProc->tempNamespaceId = InvalidOid;
+	MyProc->xminDatabaseId = InvalidOid;
 	MyProc->isBackgroundWorker = IsBackgroundWorker;
 	MyPgXact->delayChkpt = false;
 	MyPgXact->vacuumFlags = 0;
@@ -601,6 +656,9 @@ InitAuxiliaryProcess(void)
 	 * Arrange to clean up at process exit.
 	 */
 	on_shmem_exit(AuxiliaryProcKill, Int32GetDatum(proctype));
+
+	/* Now that we have a PGPROC, set up local LWLock state, too */
+	InitLWLockAccess();
 }
 
 /*
@@ -152,8 +152,21 @@ typedef struct
 	CycleCtr	cycle_ctr;		/* mdckpt_cycle_ctr when request was made */
 } PendingUnlinkEntry;
 
+/*
+ * During a checkpoint, BufferSync() tells us about relation forks it is done
+ * writing, so that mdsyncstep() can fsync their segments while the
+ * checkpointer would otherwise be sleeping, leaving less for mdsync().
+ */
+typedef struct
+{
+	RelFileNode rnode;			/* the relation fork written */
+	ForkNumber	forknum;
+	BlockNumber lastseg;		/* last segment the checkpoint wrote to */
+} SyncAheadEntry;
+
 static HTAB *pendingOpsTable = NULL;
 static List *pendingUnlinks = NIL;
+static List *syncAheadQueue = NIL;
 static MemoryContext pendingOpsCxt; /* context for the above  */
 
 static CycleCtr mdsync_cycle_ctr = 0;
@@ -545,6 +558,55 @@ mdextend(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 	Assert(_mdnblocks(reln, forknum, v) <= ((BlockNumber) RELSEG_SIZE));
 }
 
+/*
+ *	mdzeroextend() -- Add nblocks zeroed blocks to the specified relation.
+ *
+ *		This is like calling mdextend() with an all-zeroes page for each of
+ *		the blocks, but the file is extended with as few system calls as
+ *		possible, without the caller having to supply any page images.
+ */
+void
+mdzeroextend(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
+			 BlockNumber nblocks, bool skipFsync)
+{
+	/* See mdextend() */
+	if ((uint64) blocknum + nblocks >= (uint64) InvalidBlockNumber)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("cannot extend file \"%s\" beyond %u blocks",
+						relpath(reln->smgr_rnode, forknum),
+						InvalidBlockNumber)));
+
+	while (nblocks > 0)
+	{
+		BlockNumber segstartblock = blocknum % ((BlockNumber) RELSEG_SIZE);
+		BlockNumber numblocks;
+		MdfdVec    *v;
+
+		/* Don't cross a segment boundary in one go */
+		numblocks = Min(nblocks, ((BlockNumber) RELSEG_SIZE) - segstartblock);
+
+		v = _mdfd_getseg(reln, forknum, blocknum, skipFsync, EXTENSION_CREATE);
+
+		if (FileZeroExtend(v->mdfd_vfd, (off_t) BLCKSZ * segstartblock,
+						   (off_t) BLCKSZ * numblocks,
+						   WAIT_EVENT_DATA_FILE_EXTEND) != 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not extend file \"%s\": %m",
+							FilePathName(v->mdfd_vfd)),
+					 errhint("Check free disk space.")));
+
+		if (!skipFsync && !SmgrIsTemp(reln))
+			register_dirty_segment(reln, forknum, v);
+
+		Assert(_mdnblocks(reln, forknum, v) <= ((BlockNumber) RELSEG_SIZE));
+
+		blocknum += numblocks;
+		nblocks -= numblocks;
+	}
+}
+
 /*
  *	mdopen() -- Open the specified relation.
  *
@@ -647,7 +709,15 @@ mdprefetch(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum)
 	off_t		seekpos;
 	MdfdVec    *v;
 
-	v = _mdfd_getseg(reln, forknum, blocknum, false, EXTENSION_FAIL);
+	/*
+	 * During WAL replay we may be asked to prefetch blocks of files that are
+	 * only created, or have already been dropped, further on in the WAL.
+	 * Prefetching is just a hint, so quietly do nothing then.
+	 */
+	v = _mdfd_getseg(reln, forknum, blocknum, false,
+					 InRecovery ? EXTENSION_RETURN_NULL : EXTENSION_FAIL);
+	if (v == NULL)
+		return;
 
 	seekpos = (off_t) BLCKSZ * (blocknum % ((BlockNumber) RELSEG_SIZE));
 
@@ -834,6 +904,170 @@ mdwrite(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 		register_dirty_segment(reln, forknum, v);
 }
 
+/*
+ *	mdreadv() -- Read a run of consecutive blocks into the supplied buffers.
+ *
+ *		Each segment-contained part of the run, up to PG_IOV_MAX blocks at a
+ *		time, is read with a single FileReadV().  If that comes up short,
+ *		the first missing block is reread with mdread(), which knows how to
+ *		complain or zero-fill, and we carry on from there.
+ */
+void
+mdreadv(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
+		char **buffers, BlockNumber nblocks)
+{
+	while (nblocks > 0)
+	{
+		struct iovec iov[PG_IOV_MAX];
+		off_t		seekpos;
+		int			nbytes;
+		MdfdVec    *v;
+		BlockNumber nblocks_this_segment;
+		BlockNumber ndone;
+		int			i;
+
+		v = _mdfd_getseg(reln, forknum, blocknum, false,
+						 EXTENSION_FAIL | EXTENSION_CREATE_RECOVERY);
+
+		seekpos = (off_t) BLCKSZ * (blocknum % ((BlockNumber) RELSEG_SIZE));
+
+		Assert(seekpos < (off_t) BLCKSZ * RELSEG_SIZE);
+
+		nblocks_this_segment =
+			Min(nblocks,
+				RELSEG_SIZE - (blocknum % ((BlockNumber) RELSEG_SIZE)));
+		nblocks_this_segment = Min(nblocks_this_segment, PG_IOV_MAX);
+
+		for (i = 0; i < nblocks_this_segment; i++)
+		{
+			iov[i].iov_base = buffers[i];
+			iov[i].iov_len = BLCKSZ;
+		}
+
+		TRACE_POSTGRESQL_SMGR_MD_READ_START(forknum, blocknum,
+											reln->smgr_rnode.node.spcNode,
+											reln->smgr_rnode.node.dbNode,
+											reln->smgr_rnode.node.relNode,
+											reln->smgr_rnode.backend);
+
+		nbytes = FileReadV(v->mdfd_vfd, iov, nblocks_this_segment, seekpos,
+						   WAIT_EVENT_DATA_FILE_READ);
+
+		TRACE_POSTGRESQL_SMGR_MD_READ_DONE(forknum, blocknum,
+										   reln->smgr_rnode.node.spcNode,
+										   reln->smgr_rnode.node.dbNode,
+										   reln->smgr_rnode.node.relNode,
+										   reln->smgr_rnode.backend,
+										   nbytes,
+										   BLCKSZ * nblocks_this_segment);
+
+		if (nbytes < 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not read blocks %u..%u in file \"%s\": %m",
+							blocknum, blocknum + nblocks_this_segment - 1,
+							FilePathName(v->mdfd_vfd))));
+
+		ndone = nbytes / BLCKSZ;
+		if (ndone < nblocks_this_segment)
+		{
+			/* Short read: let mdread() deal with the first missing block */
+			mdread(reln, forknum, blocknum + ndone, buffers[ndone]);
+			ndone++;
+		}
+
+		blocknum += ndone;
+		buffers += ndone;
+		nblocks -= ndone;
+	}
+}
+
+/*
+ *	mdwritev() -- Write a run of consecutive blocks from the supplied buffers.
+ *
+ *		Like mdwrite(), this is only for already-existing blocks.  A short
+ *		write is finished off with mdwrite(), which reports the error if the
+ *		problem persists.
+ */
+void
+mdwritev(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
+		 char **buffers, BlockNumber nblocks, bool skipFsync)
+{
+	/* This assert is too expensive to have on normally ... */
+#ifdef CHECK_WRITE_VS_EXTEND
+	Assert(blocknum + nblocks <= mdnblocks(reln, forknum));
+#endif
+
+	while (nblocks > 0)
+	{
+		struct iovec iov[PG_IOV_MAX];
+		off_t		seekpos;
+		int			nbytes;
+		MdfdVec    *v;
+		BlockNumber nblocks_this_segment;
+		BlockNumber ndone;
+		int			i;
+
+		v = _mdfd_getseg(reln, forknum, blocknum, skipFsync,
+						 EXTENSION_FAIL | EXTENSION_CREATE_RECOVERY);
+
+		seekpos = (off_t) BLCKSZ * (blocknum % ((BlockNumber) RELSEG_SIZE));
+
+		Assert(seekpos < (off_t) BLCKSZ * RELSEG_SIZE);
+
+		nblocks_this_segment =
+			Min(nblocks,
+				RELSEG_SIZE - (blocknum % ((BlockNumber) RELSEG_SIZE)));
+		nblocks_this_segment = Min(nblocks_this_segment, PG_IOV_MAX);
+
+		for (i = 0; i < nblocks_this_segment; i++)
+		{
+			iov[i].iov_base = buffers[i];
+			iov[i].iov_len = BLCKSZ;
+		}
+
+		TRACE_POSTGRESQL_SMGR_MD_WRITE_START(forknum, blocknum,
+											 reln->smgr_rnode.node.spcNode,
+											 reln->smgr_rnode.node.dbNode,
+											 reln->smgr_rnode.node.relNode,
+											 reln->smgr_rnode.backend);
+
+		nbytes = FileWriteV(v->mdfd_vfd, iov, nblocks_this_segment, seekpos,
+							WAIT_EVENT_DATA_FILE_WRITE);
+
+		TRACE_POSTGRESQL_SMGR_MD_WRITE_DONE(forknum, blocknum,
+											reln->smgr_rnode.node.spcNode,
+											reln->smgr_rnode.node.dbNode,
+											reln->smgr_rnode.node.relNode,
+											reln->smgr_rnode.backend,
+											nbytes,
+											BLCKSZ * nblocks_this_segment);
+
+		if (nbytes < 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not write blocks %u..%u in file \"%s\": %m",
+							blocknum, blocknum + nblocks_this_segment - 1,
+							FilePathName(v->mdfd_vfd))));
+
+		ndone = nbytes / BLCKSZ;
+		if (ndone < nblocks_this_segment)
+		{
+			/* Short write: retry the first incomplete block on its own */
+			mdwrite(reln, forknum, blocknum + ndone, buffers[ndone],
+					skipFsync);
+			ndone++;
+		}
+
+		if (!skipFsync && !SmgrIsTemp(reln))
+			register_dirty_segment(reln, forknum, v);
+
+		blocknum += ndone;
+		buffers += ndone;
+		nblocks -= ndone;
+	}
+}
+
 /*
  *	mdnblocks() -- Get the number of blocks stored in a relation.
  *
@@ -1016,6 +1250,7 @@ mdimmedsync(SMgrRelation reln, ForkNumber forknum)
 					(errcode_for_file_access(),
 					 errmsg("could not fsync file \"%s\": %m",
 							FilePathName(v->mdfd_vfd))));
+		pgstat_count_io(IOCONTEXT_NORMAL, fsyncs);
 		segno--;
 	}
 }
@@ -1059,6 +1294,10 @@ mdsync(void)
 	 */
 	AbsorbFsyncRequests();
 
+	/* Whatever mdsyncstep() didn't get to is done in the loop below */
+	list_free_deep(syncAheadQueue);
+	syncAheadQueue = NIL;
+
 	/*
 	 * To avoid excess fsync'ing (in the worst case, maybe a never-terminating
 	 * checkpoint), we want to ignore fsync requests that are entered into the
@@ -1208,6 +1447,7 @@ mdsync(void)
 						FileSync(seg->mdfd_vfd, WAIT_EVENT_DATA_FILE_SYNC) >= 0)
 					{
 						/* Success; update statistics about sync timing */
+						pgstat_count_io(IOCONTEXT_NORMAL, fsyncs);
 						INSTR_TIME_SET_CURRENT(sync_end);
 						sync_diff = sync_end;
 						INSTR_TIME_SUBTRACT(sync_diff, sync_start);
@@ -1305,15 +1545,134 @@ mdsync(void)
 		}
 	}							/* end loop over hashtable entries */
 
-	/* Return sync performance metrics for report at checkpoint end */
-	CheckpointStats.ckpt_sync_rels = processed;
-	CheckpointStats.ckpt_longest_sync = longest;
-	CheckpointStats.ckpt_agg_sync_time = total_elapsed;
+	/*
+	 * Return sync performance metrics for report at checkpoint end, adding
+	 * to those of the syncs done by mdsyncstep().
+	 */
+	CheckpointStats.ckpt_sync_rels += processed;
+	CheckpointStats.ckpt_longest_sync =
+		Max(CheckpointStats.ckpt_longest_sync, longest);
+	CheckpointStats.ckpt_agg_sync_time += total_elapsed;
 
 	/* Flag successful completion of mdsync */
 	mdsync_in_progress = false;
 }
 
+/*
+ *	mdsyncready() -- Note a relation fork the checkpoint is done writing.
+ *
+ * The segments of the fork up to the one containing blocknum are queued for
+ * mdsyncstep().
+ */
+void
+mdsyncready(RelFileNode rnode, ForkNumber forknum, BlockNumber blocknum)
+{
+	SyncAheadEntry *ahead;
+	MemoryContext oldcxt;
+
+	if (!pendingOpsTable || !enableFsync)
+		return;
+
+	oldcxt = MemoryContextSwitchTo(pendingOpsCxt);
+	ahead = (SyncAheadEntry *) palloc(sizeof(SyncAheadEntry));
+	ahead->rnode = rnode;
+	ahead->forknum = forknum;
+	ahead->lastseg = blocknum / ((BlockNumber) RELSEG_SIZE);
+	syncAheadQueue = lappend(syncAheadQueue, ahead);
+	MemoryContextSwitchTo(oldcxt);
+}
+
+/*
+ *	mdsyncstep() -- fsync one segment queued by mdsyncready().
+ *
+ * Returns false if no queued segment has an fsync request pending.
+ *
+ * Every request in the table was made for a write that happened before we
+ * start the fsync, so we can clear the request once it succeeds; writes
+ * made later will get requests of their own.  A segment we can't open is
+ * left for mdsync(), which knows how to deal with dropped relations.
+ */
+bool
+mdsyncstep(void)
+{
+	while (syncAheadQueue != NIL)
+	{
+		SyncAheadEntry *ahead = (SyncAheadEntry *) linitial(syncAheadQueue);
+		PendingOperationEntry *entry;
+		SMgrRelation reln;
+		MdfdVec    *seg;
+		int			segno = -1;
+		instr_time	sync_start,
+					sync_end;
+		uint64		elapsed;
+
+		entry = (PendingOperationEntry *) hash_search(pendingOpsTable,
+													  &ahead->rnode,
+													  HASH_FIND, NULL);
+		if (entry != NULL)
+			segno = bms_next_member(entry->requests[ahead->forknum], -1);
+		if (segno < 0 || (BlockNumber) segno > ahead->lastseg)
+		{
+			/* nothing (more) to do for this fork */
+			syncAheadQueue = list_delete_first(syncAheadQueue);
+			pfree(ahead);
+			continue;
+		}
+
+		/* See mdsync() about opening the relation here */
+		reln = smgropen(ahead->rnode, InvalidBackendId);
+		seg = _mdfd_getseg(reln, ahead->forknum,
+						   (BlockNumber) segno * (BlockNumber) RELSEG_SIZE,
+						   false,
+						   EXTENSION_RETURN_NULL | EXTENSION_DONT_CHECK_SIZE);
+		if (seg == NULL)
+		{
+			syncAheadQueue = list_delete_first(syncAheadQueue);
+			pfree(ahead);
+			continue;
+		}
+
+		INSTR_TIME_SET_CURRENT(sync_start);
+
+		if (FileSync(seg->mdfd_vfd, WAIT_EVENT_DATA_FILE_SYNC) < 0)
+		{
+			int			save_errno = errno;
+			char	   *path;
+
+			if (FILE_POSSIBLY_DELETED(save_errno))
+			{
+				syncAheadQueue = list_delete_first(syncAheadQueue);
+				pfree(ahead);
+				return true;
+			}
+
+			path = _mdfd_segpath(reln, ahead->forknum, (BlockNumber) segno);
+			errno = save_errno;
+			ereport(data_sync_elevel(ERROR),
+					(errcode_for_file_access(),
+					 errmsg("could not fsync file \"%s\": %m", path)));
+		}
+
+		pgstat_count_io(IOCONTEXT_NORMAL, fsyncs);
+		INSTR_TIME_SET_CURRENT(sync_end);
+		INSTR_TIME_SUBTRACT(sync_end, sync_start);
+		elapsed = INSTR_TIME_GET_MICROSEC(sync_end);
+		CheckpointStats.ckpt_sync_rels++;
+		CheckpointStats.ckpt_longest_sync =
+			Max(CheckpointStats.ckpt_longest_sync, elapsed);
+		CheckpointStats.ckpt_agg_sync_time += elapsed;
+		if (log_checkpoints)
+			elog(DEBUG1, "checkpoint sync ahead: file=%s time=%.3f msec",
+				 FilePathName(seg->mdfd_vfd), (double) elapsed / 1000);
+
+		entry->requests[ahead->forknum] =
+			bms_del_member(entry->requests[ahead->forknum], segno);
+		return true;
+	}
+
+	return false;
+}
+
 /*
  * mdpreckpt() -- Do pre-checkpoint work
  *
@@ -1435,6 +1794,7 @@ register_dirty_segment(SMgrRelation reln, ForkNumber forknum, MdfdVec *seg)
 					(errcode_for_file_access(),
 					 errmsg("could not fsync file \"%s\": %m",
 							FilePathName(seg->mdfd_vfd))));
+		pgstat_count_io(IOCONTEXT_NORMAL, fsyncs);
 	}
 }
 
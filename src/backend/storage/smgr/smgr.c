@@ -47,12 +47,21 @@ typedef struct f_smgr
 								bool isRedo);
 	void		(*smgr_extend) (SMgrRelation reln, ForkNumber forknum,
 								BlockNumber blocknum, char *buffer, bool skipFsync);
+	void		(*smgr_zeroextend) (SMgrRelation reln, ForkNumber forknum,
+									BlockNumber blocknum, BlockNumber nblocks,
+									bool skipFsync);
 	void		(*smgr_prefetch) (SMgrRelation reln, ForkNumber forknum,
 								  BlockNumber blocknum);
 	void		(*smgr_read) (SMgrRelation reln, ForkNumber forknum,
 							  BlockNumber blocknum, char *buffer);
 	void		(*smgr_write) (SMgrRelation reln, ForkNumber forknum,
 							   BlockNumber blocknum, char *buffer, bool skipFsync);
+	void		(*smgr_readv) (SMgrRelation reln, ForkNumber forknum,
+							   BlockNumber blocknum, char **buffers,
+							   BlockNumber nblocks);
+	void		(*smgr_writev) (SMgrRelation reln, ForkNumber forknum,
+								BlockNumber blocknum, char **buffers,
+								BlockNumber nblocks, bool skipFsync);
 	void		(*smgr_writeback) (SMgrRelation reln, ForkNumber forknum,
 								   BlockNumber blocknum, BlockNumber nblocks);
 	BlockNumber (*smgr_nblocks) (SMgrRelation reln, ForkNumber forknum);
@@ -60,6 +69,9 @@ typedef struct f_smgr
 								  BlockNumber nblocks);
 	void		(*smgr_immedsync) (SMgrRelation reln, ForkNumber forknum);
 	void		(*smgr_pre_ckpt) (void);	/* may be NULL */
+	void		(*smgr_sync_ready) (RelFileNode rnode, ForkNumber forknum,
+									BlockNumber blocknum);	/* may be NULL */
+	bool		(*smgr_sync_step) (void);	/* may be NULL */
 	void		(*smgr_sync) (void);	/* may be NULL */
 	void		(*smgr_post_ckpt) (void);	/* may be NULL */
 } f_smgr;
@@ -75,14 +87,19 @@ static const f_smgr smgrsw[] = {
 		.smgr_exists = mdexists,
 		.smgr_unlink = mdunlink,
 		.smgr_extend = mdextend,
+		.smgr_zeroextend = mdzeroextend,
 		.smgr_prefetch = mdprefetch,
 		.smgr_read = mdread,
 		.smgr_write = mdwrite,
+		.smgr_readv = mdreadv,
+		.smgr_writev = mdwritev,
 		.smgr_writeback = mdwriteback,
 		.smgr_nblocks = mdnblocks,
 		.smgr_truncate = mdtruncate,
 		.smgr_immedsync = mdimmedsync,
 		.smgr_pre_ckpt = mdpreckpt,
+		.smgr_sync_ready = mdsyncready,
+		.smgr_sync_step = mdsyncstep,
 		.smgr_sync = mdsync,
 		.smgr_post_ckpt = mdpostckpt
 	}
@@ -619,6 +636,21 @@ smgrextend(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 										 buffer, skipFsync);
 }
 
+/*
+ *	smgrzeroextend() -- Add nblocks all-zeroes blocks to a file.
+ *
+ *		Like smgrextend() called for each block with a zeroed page, but the
+ *		storage manager may do it much more cheaply.  The blocks must start
+ *		at the current EOF.
+ */
+void
+smgrzeroextend(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
+			   BlockNumber nblocks, bool skipFsync)
+{
+	smgrsw[reln->smgr_which].smgr_zeroextend(reln, forknum, blocknum,
+											 nblocks, skipFsync);
+}
+
 /*
  *	smgrprefetch() -- Initiate asynchronous read of the specified block of a relation.
  */
@@ -666,6 +698,38 @@ smgrwrite(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 										buffer, skipFsync);
 }
 
+/*
+ *	smgrreadv() -- read a run of consecutive blocks from a relation into
+ *				   the supplied buffers.
+ *
+ *		buffers[i] receives block blocknum + i; the buffers need not be
+ *		adjacent in memory.  The semantics are otherwise those of nblocks
+ *		calls to smgrread(), but the storage manager is free to transfer
+ *		the whole run with fewer system calls.
+ */
+void
+smgrreadv(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
+		  char **buffers, BlockNumber nblocks)
+{
+	smgrsw[reln->smgr_which].smgr_readv(reln, forknum, blocknum,
+										buffers, nblocks);
+}
+
+/*
+ *	smgrwritev() -- Write a run of consecutive blocks from the supplied
+ *					buffers.
+ *
+ *		The vectored counterpart of smgrwrite(), with the same restriction
+ *		to already-existing blocks.
+ */
+void
+smgrwritev(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
+		   char **buffers, BlockNumber nblocks, bool skipFsync)
+{
+	smgrsw[reln->smgr_which].smgr_writev(reln, forknum, blocknum,
+										 buffers, nblocks, skipFsync);
+}
+
 
 /*
  *	smgrwriteback() -- Trigger kernel writeback for the supplied range of
@@ -767,6 +831,44 @@ smgrpreckpt(void)
 	}
 }
 
+/*
+ *	smgrsyncready() -- Note that a checkpoint is done writing a relation fork.
+ *
+ *		BufferSync() calls this with the last block it wrote before moving on
+ *		to another fork, so that the files written so far can be synced
+ *		before smgrsync() is reached.
+ */
+void
+smgrsyncready(RelFileNode rnode, ForkNumber forknum, BlockNumber blocknum)
+{
+	int			i;
+
+	for (i = 0; i < NSmgr; i++)
+	{
+		if (smgrsw[i].smgr_sync_ready)
+			smgrsw[i].smgr_sync_ready(rnode, forknum, blocknum);
+	}
+}
+
+/*
+ *	smgrsyncstep() -- Sync one file noted by smgrsyncready(), if any.
+ *
+ *		Returns false if there was nothing to sync.  The checkpointer calls
+ *		this in place of napping while it is ahead of its write schedule.
+ */
+bool
+smgrsyncstep(void)
+{
+	int			i;
+
+	for (i = 0; i < NSmgr; i++)
+	{
+		if (smgrsw[i].smgr_sync_step && smgrsw[i].smgr_sync_step())
+			return true;
+	}
+	return false;
+}
+
 /*
  *	smgrsync() -- Sync files to disk during checkpoint.
  */
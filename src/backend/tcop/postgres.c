@@ -55,6 +55,7 @@
 #include "parser/analyze.h"
 #include "parser/parser.h"
 #include "pg_getopt.h"
+#include "portability/instr_time.h"
 #include "postmaster/autovacuum.h"
 #include "postmaster/postmaster.h"
 #include "replication/logicallauncher.h"
@@ -1967,6 +1968,7 @@ exec_execute_message(const char *portal_name, long max_rows)
 	bool		execute_is_fetch;
 	bool		was_logged = false;
 	char		msec_str[32];
+	instr_time	starttime;
 
 	/* Adjust destination to tell printtup.c what to do */
 	dest = whereToSendOutput;
@@ -2096,6 +2098,9 @@ exec_execute_message(const char *portal_name, long max_rows)
 	if (max_rows <= 0)
 		max_rows = FETCH_ALL;
 
+	if (plan_cache_runtime_feedback)
+		INSTR_TIME_SET_CURRENT(starttime);
+
 	completed = PortalRun(portal,
 						  max_rows,
 						  true, /* always top level */
@@ -2104,6 +2109,40 @@ exec_execute_message(const char *portal_name, long max_rows)
 						  receiver,
 						  completionTag);
 
+	/*
+	 * If the portal's cached plan was run to completion by this one message,
+	 * let the plan cache know how long that took.  The statement that the
+	 * portal was bound from might have been replaced in the meantime, but
+	 * CachedPlanRecordRuntime copes with that for generic plans, and at
+	 * worst the replacement gets credited with a custom plan's run time.
+	 */
+	if (plan_cache_runtime_feedback && completed && !execute_is_fetch &&
+		portal->cplan != NULL)
+	{
+		CachedPlanSource *psrc = NULL;
+
+		if (portal->prepStmtName == NULL)
+			psrc = unnamed_stmt_psrc;
+		else
+		{
+			PreparedStatement *pstmt;
+
+			pstmt = FetchPreparedStatement(portal->prepStmtName, false);
+			if (pstmt)
+				psrc = pstmt->plansource;
+		}
+
+		if (psrc != NULL)
+		{
+			instr_time	endtime;
+
+			INSTR_TIME_SET_CURRENT(endtime);
+			INSTR_TIME_SUBTRACT(endtime, starttime);
+			CachedPlanRecordRuntime(psrc, portal->cplan,
+									INSTR_TIME_GET_MILLISEC(endtime));
+		}
+	}
+
 	receiver->rDestroy(receiver);
 
 	if (completed)
@@ -3853,6 +3892,7 @@ PostgresMain(int argc, char *argv[],
 
 		/* Initialize MaxBackends (if under postmaster, was done already) */
 		InitializeMaxBackends();
+		InitializeFastPathLocks();
 	}
 
 	/* Early initialization */
@@ -0,0 +1,243 @@
+/*-------------------------------------------------------------------------
+ *
+ * jsonb_selfuncs.c
+ *	  Selectivity estimation functions for jsonb operators.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/utils/adt/jsonb_selfuncs.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/htup_details.h"
+#include "catalog/pg_statistic.h"
+#include "catalog/pg_type.h"
+#include "utils/array.h"
+#include "utils/builtins.h"
+#include "utils/fmgroids.h"
+#include "utils/jsonb.h"
+#include "utils/lsyscache.h"
+#include "utils/selfuncs.h"
+
+
+/*
+ * Default selectivity of a key-existence test, used when we have no key
+ * statistics.  This is the same as contsel() returns.
+ */
+#define DEFAULT_JSONB_EXISTS_SEL 0.001
+
+/* lookup table type for binary searching through MCELEMs */
+typedef struct
+{
+	text	   *element;
+	float4		frequency;
+} TextFreq;
+
+/* type of keys for bsearch'ing through an array of TextFreqs */
+typedef struct
+{
+	char	   *key;
+	int			length;
+} JsonbKey;
+
+static Selectivity jsonb_exists_selec(VariableStatData *vardata,
+				   RegProcedure oprcode, Datum constval);
+static Selectivity jsonb_key_selec(text *key, TextFreq *lookup, int length,
+				float4 minfreq);
+static int	compare_key_textfreq(const void *e1, const void *e2);
+
+
+/*
+ *	jsonb_exists_sel -- Selectivity of "?", "?|" and "?&"
+ *
+ * restriction selectivity function for jsonb ? text, jsonb ?| text[] and
+ * jsonb ?& text[]
+ */
+Datum
+jsonb_exists_sel(PG_FUNCTION_ARGS)
+{
+	PlannerInfo *root = (PlannerInfo *) PG_GETARG_POINTER(0);
+	Oid			operator = PG_GETARG_OID(1);
+	List	   *args = (List *) PG_GETARG_POINTER(2);
+	int			varRelid = PG_GETARG_INT32(3);
+	VariableStatData vardata;
+	Node	   *other;
+	bool		varonleft;
+	Selectivity selec;
+
+	/*
+	 * If expression is not variable op something, then punt and return a
+	 * default estimate.  These operators have no commutators, so the
+	 * variable must be on the left.
+	 */
+	if (!get_restriction_variable(root, args, varRelid,
+								  &vardata, &other, &varonleft))
+		PG_RETURN_FLOAT8(DEFAULT_JSONB_EXISTS_SEL);
+
+	if (!varonleft || !IsA(other, Const))
+	{
+		ReleaseVariableStats(vardata);
+		PG_RETURN_FLOAT8(DEFAULT_JSONB_EXISTS_SEL);
+	}
+
+	/* The operators are strict, so we can cope with NULL right away */
+	if (((Const *) other)->constisnull)
+	{
+		ReleaseVariableStats(vardata);
+		PG_RETURN_FLOAT8(0.0);
+	}
+
+	selec = jsonb_exists_selec(&vardata, get_opcode(operator),
+							   ((Const *) other)->constvalue);
+
+	ReleaseVariableStats(vardata);
+
+	CLAMP_PROBABILITY(selec);
+
+	PG_RETURN_FLOAT8((float8) selec);
+}
+
+/*
+ * Key-existence selectivity for a jsonb var vs a text or text[] constant
+ */
+static Selectivity
+jsonb_exists_selec(VariableStatData *vardata, RegProcedure oprcode,
+				   Datum constval)
+{
+	Form_pg_statistic stats;
+	AttStatsSlot sslot;
+	TextFreq   *lookup;
+	float4		minfreq;
+	Selectivity selec;
+	int			i;
+
+	if (!HeapTupleIsValid(vardata->statsTuple))
+		return (Selectivity) DEFAULT_JSONB_EXISTS_SEL;
+
+	stats = (Form_pg_statistic) GETSTRUCT(vardata->statsTuple);
+
+	/* MCELEM will be an array of TEXT elements for a jsonb column */
+	if (!get_attstatsslot(&sslot, vardata->statsTuple,
+						  STATISTIC_KIND_MCELEM, InvalidOid,
+						  ATTSTATSSLOT_VALUES | ATTSTATSSLOT_NUMBERS))
+		return (Selectivity) DEFAULT_JSONB_EXISTS_SEL;
+
+	/*
+	 * There should be two more Numbers than Values, because the last two
+	 * cells are taken for minimal and maximal frequency.  Punt if not.
+	 */
+	if (sslot.nnumbers != sslot.nvalues + 2)
+	{
+		free_attstatsslot(&sslot);
+		return (Selectivity) DEFAULT_JSONB_EXISTS_SEL;
+	}
+
+	/* Transpose the data into a single array so we can use bsearch() */
+	lookup = (TextFreq *) palloc(sizeof(TextFreq) * sslot.nvalues);
+	for (i = 0; i < sslot.nvalues; i++)
+	{
+		lookup[i].element = (text *) DatumGetPointer(sslot.values[i]);
+		lookup[i].frequency = sslot.numbers[i];
+	}
+	minfreq = sslot.numbers[sslot.nnumbers - 2];
+
+	if (oprcode == F_JSONB_EXISTS)
+	{
+		selec = jsonb_key_selec(DatumGetTextPP(constval), lookup,
+								sslot.nvalues, minfreq);
+	}
+	else if (oprcode == F_JSONB_EXISTS_ANY || oprcode == F_JSONB_EXISTS_ALL)
+	{
+		ArrayType  *keys = DatumGetArrayTypeP(constval);
+		Datum	   *key_datums;
+		bool	   *key_nulls;
+		int			elem_count;
+		bool		any = (oprcode == F_JSONB_EXISTS_ANY);
+
+		deconstruct_array(keys, TEXTOID, -1, false, 'i',
+						  &key_datums, &key_nulls, &elem_count);
+
+		/*
+		 * Treat the keys' occurrences as independent events.  Null keys are
+		 * ignored, as they are by the operators.
+		 */
+		selec = any ? 0.0 : 1.0;
+		for (i = 0; i < elem_count; i++)
+		{
+			Selectivity s;
+
+			if (key_nulls[i])
+				continue;
+
+			s = jsonb_key_selec(DatumGetTextPP(key_datums[i]), lookup,
+								sslot.nvalues, minfreq);
+			if (any)
+				selec = selec + s - selec * s;
+			else
+				selec *= s;
+		}
+	}
+	else
+		selec = DEFAULT_JSONB_EXISTS_SEL;
+
+	pfree(lookup);
+	free_attstatsslot(&sslot);
+
+	/* MCELEM stats count only non-null rows, so adjust for null rows */
+	selec *= (1.0 - stats->stanullfrac);
+
+	return selec;
+}
+
+/*
+ * Selectivity of a single key, looked up in the sorted MCELEM array
+ */
+static Selectivity
+jsonb_key_selec(text *key, TextFreq *lookup, int length, float4 minfreq)
+{
+	JsonbKey	k;
+	TextFreq   *searchres;
+
+	k.key = VARDATA_ANY(key);
+	k.length = VARSIZE_ANY_EXHDR(key);
+
+	searchres = (TextFreq *) bsearch(&k, lookup, length, sizeof(TextFreq),
+									 compare_key_textfreq);
+
+	/*
+	 * If the key is not in MCELEM, punt, but assume that the selectivity
+	 * cannot be more than minfreq / 2.
+	 */
+	if (searchres)
+		return (Selectivity) searchres->frequency;
+	else
+		return (Selectivity) Min(DEFAULT_JSONB_EXISTS_SEL, minfreq / 2);
+}
+
+/*
+ * bsearch() comparator for a key (non-NULL terminated string with length)
+ * and a TextFreq.  Use length, then byte-for-byte comparison, because that's
+ * how ANALYZE sorted the keys; see jsonb_typanalyze.c.
+ */
+static int
+compare_key_textfreq(const void *e1, const void *e2)
+{
+	const JsonbKey *key = (const JsonbKey *) e1;
+	const TextFreq *t = (const TextFreq *) e2;
+	int			len1,
+				len2;
+
+	len1 = key->length;
+	len2 = VARSIZE_ANY_EXHDR(t->element);
+
+	if (len1 > len2)
+		return 1;
+	else if (len1 < len2)
+		return -1;
+
+	return memcmp(key->key, VARDATA_ANY(t->element), len1);
+}
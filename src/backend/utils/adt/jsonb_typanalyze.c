@@ -0,0 +1,457 @@
+/*-------------------------------------------------------------------------
+ *
+ * jsonb_typanalyze.c
+ *	  Functions for gathering statistics from jsonb columns
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/utils/adt/jsonb_typanalyze.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/hash.h"
+#include "access/tuptoaster.h"
+#include "catalog/pg_collation.h"
+#include "catalog/pg_operator.h"
+#include "catalog/pg_type.h"
+#include "commands/vacuum.h"
+#include "utils/builtins.h"
+#include "utils/jsonb.h"
+
+
+/*
+ * As in array_typanalyze.c, we ignore documents that are wider than
+ * JSONB_WIDTH_THRESHOLD (after detoasting!) to limit the memory, IO and CPU
+ * spent on analysis.
+ */
+#define JSONB_WIDTH_THRESHOLD 0x10000
+
+/* Extra data for compute_jsonb_stats function */
+typedef struct
+{
+	/* Saved state from std_typanalyze() */
+	AnalyzeAttrComputeStatsFunc std_compute_stats;
+	void	   *std_extra_data;
+} JsonbAnalyzeExtraData;
+
+/* A hash key for keys (not NULL terminated) */
+typedef struct
+{
+	char	   *key;
+	int			length;
+} JsonbKeyHashKey;
+
+/* A hash table entry for the Lossy Counting algorithm */
+typedef struct
+{
+	JsonbKeyHashKey key;		/* This is 'e' from the LC algorithm. */
+	int			frequency;		/* This is 'f'. */
+	int			delta;			/* And this is 'delta'. */
+	int			last_row;		/* For de-duplication of array elements. */
+} TrackItem;
+
+static void compute_jsonb_stats(VacAttrStats *stats,
+					AnalyzeAttrFetchFunc fetchfunc,
+					int samplerows,
+					double totalrows);
+static void prune_keys_hashtable(HTAB *keys_tab, int b_current);
+static uint32 jsonb_key_hash(const void *key, Size keysize);
+static int	jsonb_key_match(const void *key1, const void *key2, Size keysize);
+static int	jsonb_key_compare(const void *key1, const void *key2);
+static int	trackitem_compare_frequencies_desc(const void *e1, const void *e2);
+static int	trackitem_compare_keys(const void *e1, const void *e2);
+
+
+/*
+ * jsonb_typanalyze -- typanalyze function for jsonb columns
+ */
+Datum
+jsonb_typanalyze(PG_FUNCTION_ARGS)
+{
+	VacAttrStats *stats = (VacAttrStats *) PG_GETARG_POINTER(0);
+	JsonbAnalyzeExtraData *extra_data;
+
+	/*
+	 * Call the standard typanalyze function.  It may fail to find needed
+	 * operators, in which case we also can't do anything, so just fail.
+	 */
+	if (!std_typanalyze(stats))
+		PG_RETURN_BOOL(false);
+
+	extra_data = (JsonbAnalyzeExtraData *) palloc(sizeof(JsonbAnalyzeExtraData));
+
+	/* Save old compute_stats and extra_data for scalar statistics ... */
+	extra_data->std_compute_stats = stats->compute_stats;
+	extra_data->std_extra_data = stats->extra_data;
+
+	/* ... and replace with our info */
+	stats->compute_stats = compute_jsonb_stats;
+	stats->extra_data = extra_data;
+
+	PG_RETURN_BOOL(true);
+}
+
+/*
+ * compute_jsonb_stats() -- compute statistics for a jsonb column
+ *
+ * Besides the standard scalar statistics, which are of little use since
+ * whole documents rarely repeat, we find the most common top-level keys.
+ * More precisely, we track the strings that the ?, ?| and ?& operators look
+ * for: the keys of a root object, and the string elements of a root array
+ * (or a root string scalar).  jsonb_exists_sel() uses these to estimate the
+ * selectivity of those operators.
+ *
+ * We use the Lossy Counting algorithm with the same parameters as
+ * compute_array_stats(); see there for a description.  Keys are unique
+ * within an object, and duplicate array elements are counted once per row,
+ * so each entry's frequency is the fraction of analyzed non-null rows that
+ * contain it.  The MCELEM slot is laid out as for tsvector columns: text
+ * values sorted by length and then byte-wise, followed by the minimal and
+ * maximal frequencies.
+ */
+static void
+compute_jsonb_stats(VacAttrStats *stats, AnalyzeAttrFetchFunc fetchfunc,
+					int samplerows, double totalrows)
+{
+	JsonbAnalyzeExtraData *extra_data;
+	int			num_mcelem;
+	int			analyzed_rows = 0;
+
+	/* This is D from the LC algorithm. */
+	HTAB	   *keys_tab;
+	HASHCTL		hash_ctl;
+	HASH_SEQ_STATUS scan_status;
+
+	/* This is the current bucket number from the LC algorithm */
+	int			b_current;
+
+	/* This is 'w' from the LC algorithm */
+	int			bucket_width;
+	int			row_no;
+	int64		key_no;
+	JsonbKeyHashKey hash_key;
+	TrackItem  *item;
+	int			slot_idx;
+
+	extra_data = (JsonbAnalyzeExtraData *) stats->extra_data;
+
+	/*
+	 * Invoke analyze.c's standard analysis function to create scalar-style
+	 * stats for the column.  It will expect its own extra_data pointer, so
+	 * temporarily install that.
+	 */
+	stats->extra_data = extra_data->std_extra_data;
+	extra_data->std_compute_stats(stats, fetchfunc, samplerows, totalrows);
+	stats->extra_data = extra_data;
+
+	/* We want statistics_target * 10 keys, as for array elements */
+	num_mcelem = stats->attr->attstattarget * 10;
+	bucket_width = num_mcelem * 1000 / 7;
+
+	MemSet(&hash_ctl, 0, sizeof(hash_ctl));
+	hash_ctl.keysize = sizeof(JsonbKeyHashKey);
+	hash_ctl.entrysize = sizeof(TrackItem);
+	hash_ctl.hash = jsonb_key_hash;
+	hash_ctl.match = jsonb_key_match;
+	hash_ctl.hcxt = CurrentMemoryContext;
+	keys_tab = hash_create("Analyzed jsonb keys table",
+						   num_mcelem,
+						   &hash_ctl,
+						   HASH_ELEM | HASH_FUNCTION | HASH_COMPARE | HASH_CONTEXT);
+
+	/* Initialize counters. */
+	b_current = 1;
+	key_no = 0;
+
+	/* Loop over the documents. */
+	for (row_no = 0; row_no < samplerows; row_no++)
+	{
+		Datum		value;
+		bool		isnull;
+		Jsonb	   *jb;
+		JsonbIterator *it;
+		JsonbValue	v;
+		JsonbIteratorToken r;
+
+		vacuum_delay_point();
+
+		value = fetchfunc(stats, row_no, &isnull);
+		if (isnull)
+			continue;
+
+		/* Skip too-large values. */
+		if (toast_raw_datum_size(value) > JSONB_WIDTH_THRESHOLD)
+			continue;
+		else
+			analyzed_rows++;
+
+		jb = DatumGetJsonbP(value);
+
+		/*
+		 * Walk the root container without descending into nested ones, and
+		 * add its keys, or its string elements, to our tracking hashtable.
+		 */
+		it = JsonbIteratorInit(&jb->root);
+		while ((r = JsonbIteratorNext(&it, &v, true)) != WJB_DONE)
+		{
+			bool		found;
+
+			if (r != WJB_KEY && !(r == WJB_ELEM && v.type == jbvString))
+				continue;
+
+			/*
+			 * The key points into the (detoasted) document, so if a new entry
+			 * is created we make a copy of it.
+			 */
+			hash_key.key = v.val.string.val;
+			hash_key.length = v.val.string.len;
+
+			item = (TrackItem *) hash_search(keys_tab,
+											 (const void *) &hash_key,
+											 HASH_ENTER, &found);
+
+			if (found)
+			{
+				/* ? ignores duplicate array elements, and so do we */
+				if (item->last_row == row_no)
+					continue;
+
+				item->frequency++;
+				item->last_row = row_no;
+			}
+			else
+			{
+				item->frequency = 1;
+				item->delta = b_current - 1;
+				item->last_row = row_no;
+
+				item->key.key = palloc(hash_key.length);
+				memcpy(item->key.key, hash_key.key, hash_key.length);
+			}
+
+			/* key_no is the number of elements processed (ie N) */
+			key_no++;
+
+			/* We prune the D structure after processing each bucket */
+			if (key_no % bucket_width == 0)
+			{
+				prune_keys_hashtable(keys_tab, b_current);
+				b_current++;
+			}
+		}
+
+		/* If the document was toasted, free the detoasted copy. */
+		if (PointerGetDatum(jb) != value)
+			pfree(jb);
+	}
+
+	/* Skip pg_statistic slots occupied by standard statistics */
+	slot_idx = 0;
+	while (slot_idx < STATISTIC_NUM_SLOTS && stats->stakind[slot_idx] != 0)
+		slot_idx++;
+	if (slot_idx >= STATISTIC_NUM_SLOTS)
+		elog(ERROR, "insufficient pg_statistic slots for jsonb stats");
+
+	/* We can only compute real stats if we found some non-null values. */
+	if (analyzed_rows > 0)
+	{
+		int			nonnull_cnt = analyzed_rows;
+		int			i;
+		TrackItem **sort_table;
+		int			track_len;
+		int64		cutoff_freq;
+		int64		minfreq,
+					maxfreq;
+
+		/*
+		 * We assume the standard stats code already took care of setting
+		 * stats_valid, stanullfrac, stawidth, stadistinct.
+		 *
+		 * Construct an array of the hashtable items meeting the cutoff
+		 * frequency (s - epsilon)*N, and identify their minimum and maximum
+		 * frequencies.
+		 */
+		cutoff_freq = 9 * key_no / bucket_width;
+
+		i = hash_get_num_entries(keys_tab); /* surely enough space */
+		sort_table = (TrackItem **) palloc(sizeof(TrackItem *) * i);
+
+		hash_seq_init(&scan_status, keys_tab);
+		track_len = 0;
+		minfreq = key_no;
+		maxfreq = 0;
+		while ((item = (TrackItem *) hash_seq_search(&scan_status)) != NULL)
+		{
+			if (item->frequency > cutoff_freq)
+			{
+				sort_table[track_len++] = item;
+				minfreq = Min(minfreq, item->frequency);
+				maxfreq = Max(maxfreq, item->frequency);
+			}
+		}
+		Assert(track_len <= i);
+
+		/* emit some statistics for debug purposes */
+		elog(DEBUG3, "compute_jsonb_stats: target # mces = %d, "
+			 "bucket width = %d, "
+			 "# keys = " INT64_FORMAT ", hashtable size = %d, "
+			 "usable entries = %d",
+			 num_mcelem, bucket_width, key_no, i, track_len);
+
+		/*
+		 * If we obtained more keys than we really want, get rid of those with
+		 * least frequencies.
+		 */
+		if (num_mcelem < track_len)
+		{
+			qsort(sort_table, track_len, sizeof(TrackItem *),
+				  trackitem_compare_frequencies_desc);
+			/* reset minfreq to the smallest frequency we're keeping */
+			minfreq = sort_table[num_mcelem - 1]->frequency;
+		}
+		else
+			num_mcelem = track_len;
+
+		/* Generate MCELEM slot entry */
+		if (num_mcelem > 0)
+		{
+			MemoryContext old_context;
+			Datum	   *mcelem_values;
+			float4	   *mcelem_freqs;
+
+			/* Sort on the key, for binary searches in jsonb_exists_sel() */
+			qsort(sort_table, num_mcelem, sizeof(TrackItem *),
+				  trackitem_compare_keys);
+
+			/* Must copy the target values into anl_context */
+			old_context = MemoryContextSwitchTo(stats->anl_context);
+
+			mcelem_values = (Datum *) palloc(num_mcelem * sizeof(Datum));
+			mcelem_freqs = (float4 *) palloc((num_mcelem + 2) * sizeof(float4));
+
+			for (i = 0; i < num_mcelem; i++)
+			{
+				TrackItem  *item = sort_table[i];
+
+				mcelem_values[i] =
+					PointerGetDatum(cstring_to_text_with_len(item->key.key,
+															 item->key.length));
+				mcelem_freqs[i] = (double) item->frequency /
+					(double) nonnull_cnt;
+			}
+			mcelem_freqs[i++] = (double) minfreq / (double) nonnull_cnt;
+			mcelem_freqs[i] = (double) maxfreq / (double) nonnull_cnt;
+			MemoryContextSwitchTo(old_context);
+
+			stats->stakind[slot_idx] = STATISTIC_KIND_MCELEM;
+			stats->staop[slot_idx] = TextEqualOperator;
+			stats->stacoll[slot_idx] = DEFAULT_COLLATION_OID;
+			stats->stanumbers[slot_idx] = mcelem_freqs;
+			/* See above comment about two extra frequency fields */
+			stats->numnumbers[slot_idx] = num_mcelem + 2;
+			stats->stavalues[slot_idx] = mcelem_values;
+			stats->numvalues[slot_idx] = num_mcelem;
+			/* We are storing text values */
+			stats->statypid[slot_idx] = TEXTOID;
+			stats->statyplen[slot_idx] = -1;	/* typlen, -1 for varlena */
+			stats->statypbyval[slot_idx] = false;
+			stats->statypalign[slot_idx] = 'i';
+		}
+	}
+
+	/*
+	 * We don't need to bother cleaning up any of our temporary palloc's. The
+	 * hashtable should also go away, as it used a child memory context.
+	 */
+}
+
+/*
+ * A function to prune the D structure from the Lossy Counting algorithm.
+ * Consult compute_jsonb_stats() for wider explanation.
+ */
+static void
+prune_keys_hashtable(HTAB *keys_tab, int b_current)
+{
+	HASH_SEQ_STATUS scan_status;
+	TrackItem  *item;
+
+	hash_seq_init(&scan_status, keys_tab);
+	while ((item = (TrackItem *) hash_seq_search(&scan_status)) != NULL)
+	{
+		if (item->frequency + item->delta <= b_current)
+		{
+			char	   *key = item->key.key;
+
+			if (hash_search(keys_tab, (const void *) &item->key,
+							HASH_REMOVE, NULL) == NULL)
+				elog(ERROR, "hash table corrupted");
+			pfree(key);
+		}
+	}
+}
+
+/*
+ * Hash function for keys, which are not NULL terminated.
+ */
+static uint32
+jsonb_key_hash(const void *key, Size keysize)
+{
+	const JsonbKeyHashKey *k = (const JsonbKeyHashKey *) key;
+
+	return DatumGetUInt32(hash_any((const unsigned char *) k->key,
+								   k->length));
+}
+
+/*
+ * Matching function for keys, to be used in hashtable lookups.
+ */
+static int
+jsonb_key_match(const void *key1, const void *key2, Size keysize)
+{
+	/* The keysize parameter is superfluous, the keys store their lengths */
+	return jsonb_key_compare(key1, key2);
+}
+
+/*
+ * Comparison function for keys: first by length, then byte-wise.
+ */
+static int
+jsonb_key_compare(const void *key1, const void *key2)
+{
+	const JsonbKeyHashKey *d1 = (const JsonbKeyHashKey *) key1;
+	const JsonbKeyHashKey *d2 = (const JsonbKeyHashKey *) key2;
+
+	if (d1->length > d2->length)
+		return 1;
+	else if (d1->length < d2->length)
+		return -1;
+	return memcmp(d1->key, d2->key, d1->length);
+}
+
+/*
+ * qsort() comparator for sorting TrackItems on frequencies (descending sort)
+ */
+static int
+trackitem_compare_frequencies_desc(const void *e1, const void *e2)
+{
+	const TrackItem *const *t1 = (const TrackItem *const *) e1;
+	const TrackItem *const *t2 = (const TrackItem *const *) e2;
+
+	return (*t2)->frequency - (*t1)->frequency;
+}
+
+/*
+ * qsort() comparator for sorting TrackItems on keys
+ */
+static int
+trackitem_compare_keys(const void *e1, const void *e2)
+{
+	const TrackItem *const *t1 = (const TrackItem *const *) e1;
+	const TrackItem *const *t2 = (const TrackItem *const *) e2;
+
+	return jsonb_key_compare(&(*t1)->key, &(*t2)->key);
+}
@@ -17,6 +17,7 @@
 #include <limits.h>
 
 #include "access/htup_details.h"
+#include "access/tuptoaster.h"
 #include "catalog/pg_type.h"
 #include "fmgr.h"
 #include "funcapi.h"
@@ -459,6 +460,8 @@ static JsonbValue *findJsonbValueFromContainerLen(JsonbContainer *container,
 							   uint32 flags,
 							   char *key,
 							   uint32 keylen);
+static bool findJsonbObjectFieldLazy(Datum jsonb, char *key, uint32 keylen,
+						 JsonbValue **result);
 
 /* functions supporting jsonb_delete, jsonb_set and jsonb_concat */
 static JsonbValue *IteratorConcat(JsonbIterator **it1, JsonbIterator **it2,
@@ -715,16 +718,22 @@ json_object_field(PG_FUNCTION_ARGS)
 Datum
 jsonb_object_field(PG_FUNCTION_ARGS)
 {
-	Jsonb	   *jb = PG_GETARG_JSONB_P(0);
 	text	   *key = PG_GETARG_TEXT_PP(1);
 	JsonbValue *v;
 
-	if (!JB_ROOT_IS_OBJECT(jb))
-		PG_RETURN_NULL();
+	if (!findJsonbObjectFieldLazy(PG_GETARG_DATUM(0),
+								  VARDATA_ANY(key), VARSIZE_ANY_EXHDR(key),
+								  &v))
+	{
+		Jsonb	   *jb = PG_GETARG_JSONB_P(0);
 
-	v = findJsonbValueFromContainerLen(&jb->root, JB_FOBJECT,
-									   VARDATA_ANY(key),
-									   VARSIZE_ANY_EXHDR(key));
+		if (!JB_ROOT_IS_OBJECT(jb))
+			PG_RETURN_NULL();
+
+		v = findJsonbValueFromContainerLen(&jb->root, JB_FOBJECT,
+										   VARDATA_ANY(key),
+										   VARSIZE_ANY_EXHDR(key));
+	}
 
 	if (v != NULL)
 		PG_RETURN_JSONB_P(JsonbValueToJsonb(v));
@@ -751,16 +760,22 @@ json_object_field_text(PG_FUNCTION_ARGS)
 Datum
 jsonb_object_field_text(PG_FUNCTION_ARGS)
 {
-	Jsonb	   *jb = PG_GETARG_JSONB_P(0);
 	text	   *key = PG_GETARG_TEXT_PP(1);
 	JsonbValue *v;
 
-	if (!JB_ROOT_IS_OBJECT(jb))
-		PG_RETURN_NULL();
+	if (!findJsonbObjectFieldLazy(PG_GETARG_DATUM(0),
+								  VARDATA_ANY(key), VARSIZE_ANY_EXHDR(key),
+								  &v))
+	{
+		Jsonb	   *jb = PG_GETARG_JSONB_P(0);
 
-	v = findJsonbValueFromContainerLen(&jb->root, JB_FOBJECT,
-									   VARDATA_ANY(key),
-									   VARSIZE_ANY_EXHDR(key));
+		if (!JB_ROOT_IS_OBJECT(jb))
+			PG_RETURN_NULL();
+
+		v = findJsonbValueFromContainerLen(&jb->root, JB_FOBJECT,
+										   VARDATA_ANY(key),
+										   VARSIZE_ANY_EXHDR(key));
+	}
 
 	if (v != NULL)
 	{
@@ -3920,6 +3935,109 @@ findJsonbValueFromContainerLen(JsonbContainer *container, uint32 flags,
 	return findJsonbValueFromContainer(container, flags, &k);
 }
 
+/*
+ * Look up a key in the root object of a jsonb datum without detoasting all of
+ * it, if possible.
+ *
+ * For a large value stored out of line without compression, we can fetch
+ * just the leading slices that hold the container header, the JEntry array
+ * and the keys, binary-search the keys, and then fetch a prefix just long
+ * enough to cover the matching value.  A document that is compressed must be
+ * decompressed in full anyway, so for such datums (and small ones, where the
+ * extra TOAST fetches aren't worth it) we return false and the caller should
+ * detoast the value normally.  Otherwise we return true and set *result to
+ * the value found, or NULL if the root isn't an object or lacks the key.
+ */
+static bool
+findJsonbObjectFieldLazy(Datum jsonb, char *key, uint32 keylen,
+						 JsonbValue **result)
+{
+	struct varlena *attr = (struct varlena *) DatumGetPointer(jsonb);
+	struct varatt_external toast_pointer;
+	struct varlena *slice;
+	JsonbContainer *container;
+	uint32		count;
+	uint32		hdrlen;
+	uint32		keysend;
+	uint32		stopLow,
+				stopHigh;
+	int32		valend = -1;
+
+	if (!VARATT_IS_EXTERNAL_ONDISK(attr))
+		return false;
+
+	VARATT_EXTERNAL_GET_POINTER(toast_pointer, attr);
+	if (VARATT_EXTERNAL_IS_COMPRESSED(toast_pointer) ||
+		VARATT_EXTERNAL_GET_EXTSIZE(toast_pointer) < 4 * TOAST_MAX_CHUNK_SIZE)
+		return false;
+
+	*result = NULL;
+
+	/* Fetch the root container's header */
+	slice = PG_DETOAST_DATUM_SLICE(jsonb, 0, sizeof(uint32));
+	container = (JsonbContainer *) VARDATA(slice);
+	if ((container->header & JB_FOBJECT) == 0)
+		return true;
+	count = container->header & JB_CMASK;
+	if (count == 0)
+		return true;
+	pfree(slice);
+
+	/* Fetch the JEntry array, which locates the keys and the values */
+	hdrlen = offsetof(JsonbContainer, children) + 2 * count * sizeof(JEntry);
+	slice = PG_DETOAST_DATUM_SLICE(jsonb, 0, hdrlen);
+	container = (JsonbContainer *) VARDATA(slice);
+
+	/* All the keys are stored before all the values */
+	keysend = getJsonbOffset(container, count);
+	pfree(slice);
+	slice = PG_DETOAST_DATUM_SLICE(jsonb, 0, hdrlen + keysend);
+	container = (JsonbContainer *) VARDATA(slice);
+
+	/* Binary search the keys, in the same order as the main code */
+	stopLow = 0;
+	stopHigh = count;
+	while (stopLow < stopHigh)
+	{
+		uint32		stopMiddle = stopLow + (stopHigh - stopLow) / 2;
+		uint32		candidateoff = getJsonbOffset(container, stopMiddle);
+		uint32		candidatelen = getJsonbLength(container, stopMiddle);
+		char	   *candidate = (char *) container + hdrlen + candidateoff;
+		int			difference;
+
+		if (candidatelen == keylen)
+			difference = memcmp(candidate, key, keylen);
+		else
+			difference = (candidatelen > keylen) ? 1 : -1;
+
+		if (difference == 0)
+		{
+			int			index = stopMiddle + count;
+
+			valend = getJsonbOffset(container, index) +
+				getJsonbLength(container, index);
+			break;
+		}
+		else if (difference < 0)
+			stopLow = stopMiddle + 1;
+		else
+			stopHigh = stopMiddle;
+	}
+	pfree(slice);
+
+	if (valend < 0)
+		return true;
+
+	/*
+	 * Fetch everything up to the end of the value and let the regular code
+	 * extract it; nothing past that prefix will be looked at.
+	 */
+	slice = PG_DETOAST_DATUM_SLICE(jsonb, 0, hdrlen + valend);
+	*result = findJsonbValueFromContainerLen((JsonbContainer *) VARDATA(slice),
+											 JB_FOBJECT, key, keylen);
+	return true;
+}
+
 /*
  * Semantic actions for json_strip_nulls.
  *
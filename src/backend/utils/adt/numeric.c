@@ -101,6 +101,15 @@ typedef signed char NumericDigit;
 typedef int16 NumericDigit;
 #endif
 
+#ifdef HAVE_INT128
+/*
+ * Upper bound on the NBASE digits of an int128 operand of the fast paths in
+ * numeric_add(), numeric_sub() and numeric_mul(); for any NBASE, results of
+ * those stay far below the int128 limit.
+ */
+#define NUMERIC_INT128_MAX_DIGITS	9
+#endif
+
 /*
  * The Numeric type as stored on disk.
  *
@@ -483,6 +492,10 @@ static void int64_to_numericvar(int64 val, NumericVar *var);
 #ifdef HAVE_INT128
 static bool numericvar_to_int128(const NumericVar *var, int128 *result);
 static void int128_to_numericvar(int128 val, NumericVar *var);
+static bool numeric_to_scaled_int128(Numeric num, int scale, int maxdigits,
+						 int128 *result, int *resultdigits);
+static Numeric make_result_from_scaled_int128(int128 val, int scale,
+							   int dscale);
 #endif
 static double numeric_to_double_no_overflow(Numeric num);
 static double numericvar_to_double_no_overflow(const NumericVar *var);
@@ -2408,6 +2421,28 @@ numeric_add(PG_FUNCTION_ARGS)
 	if (NUMERIC_IS_NAN(num1) || NUMERIC_IS_NAN(num2))
 		PG_RETURN_NUMERIC(make_result(&const_nan));
 
+#ifdef HAVE_INT128
+	{
+		/*
+		 * If both values fit in an int128 at the larger of their scales,
+		 * compute the exact result in registers.
+		 */
+		int			dscale = Max(NUMERIC_DSCALE(num1), NUMERIC_DSCALE(num2));
+		int			scale = (dscale + DEC_DIGITS - 1) / DEC_DIGITS;
+		int128		val1,
+					val2;
+		int			ndigits1,
+					ndigits2;
+
+		if (numeric_to_scaled_int128(num1, scale, NUMERIC_INT128_MAX_DIGITS,
+									 &val1, &ndigits1) &&
+			numeric_to_scaled_int128(num2, scale, NUMERIC_INT128_MAX_DIGITS,
+									 &val2, &ndigits2))
+			PG_RETURN_NUMERIC(make_result_from_scaled_int128(val1 + val2,
+															 scale, dscale));
+	}
+#endif
+
 	/*
 	 * Unpack the values, let add_var() compute the result and return it.
 	 */
@@ -2446,6 +2481,28 @@ numeric_sub(PG_FUNCTION_ARGS)
 	if (NUMERIC_IS_NAN(num1) || NUMERIC_IS_NAN(num2))
 		PG_RETURN_NUMERIC(make_result(&const_nan));
 
+#ifdef HAVE_INT128
+	{
+		/*
+		 * If both values fit in an int128 at the larger of their scales,
+		 * compute the exact result in registers.
+		 */
+		int			dscale = Max(NUMERIC_DSCALE(num1), NUMERIC_DSCALE(num2));
+		int			scale = (dscale + DEC_DIGITS - 1) / DEC_DIGITS;
+		int128		val1,
+					val2;
+		int			ndigits1,
+					ndigits2;
+
+		if (numeric_to_scaled_int128(num1, scale, NUMERIC_INT128_MAX_DIGITS,
+									 &val1, &ndigits1) &&
+			numeric_to_scaled_int128(num2, scale, NUMERIC_INT128_MAX_DIGITS,
+									 &val2, &ndigits2))
+			PG_RETURN_NUMERIC(make_result_from_scaled_int128(val1 - val2,
+															 scale, dscale));
+	}
+#endif
+
 	/*
 	 * Unpack the values, let sub_var() compute the result and return it.
 	 */
@@ -2484,6 +2541,30 @@ numeric_mul(PG_FUNCTION_ARGS)
 	if (NUMERIC_IS_NAN(num1) || NUMERIC_IS_NAN(num2))
 		PG_RETURN_NUMERIC(make_result(&const_nan));
 
+#ifdef HAVE_INT128
+	{
+		/*
+		 * If the exact product is sure to fit in an int128, compute it in
+		 * registers.  The scales of the inputs add up, as with mul_var().
+		 */
+		int			scale1 = (NUMERIC_DSCALE(num1) + DEC_DIGITS - 1) / DEC_DIGITS;
+		int			scale2 = (NUMERIC_DSCALE(num2) + DEC_DIGITS - 1) / DEC_DIGITS;
+		int128		val1,
+					val2;
+		int			ndigits1,
+					ndigits2;
+
+		if (numeric_to_scaled_int128(num1, scale1, NUMERIC_INT128_MAX_DIGITS,
+									 &val1, &ndigits1) &&
+			numeric_to_scaled_int128(num2, scale2, NUMERIC_INT128_MAX_DIGITS,
+									 &val2, &ndigits2) &&
+			ndigits1 + ndigits2 <= NUMERIC_INT128_MAX_DIGITS)
+			PG_RETURN_NUMERIC(make_result_from_scaled_int128(val1 * val2,
+															 scale1 + scale2,
+															 NUMERIC_DSCALE(num1) + NUMERIC_DSCALE(num2)));
+	}
+#endif
+
 	/*
 	 * Unpack the values, let mul_var() compute the result and return it.
 	 * Unlike add_var() and sub_var(), mul_var() will round its result. In the
@@ -3374,8 +3455,28 @@ typedef struct NumericAggState
 	int			maxScale;		/* maximum scale seen so far */
 	int64		maxScaleCount;	/* number of values seen with maximum scale */
 	int64		NaNcount;		/* count of NaN values (not included in N!) */
+#ifdef HAVE_INT128
+	int128		fastSumX;		/* part of sumX kept as a scaled integer */
+	int			fastScale;		/* fastSumX is in units of NBASE^-fastScale */
+	int			fastDscale;		/* max dscale of the values in fastSumX */
+#endif
 } NumericAggState;
 
+#ifdef HAVE_INT128
+/*
+ * Most inputs of SUM() and AVG() are small enough to be added up as 128-bit
+ * integers, which is much cheaper than going through a NumericVar and the
+ * NumericSumAccum.  An input is added to fastSumX if its scale is at most
+ * NUMERIC_FAST_MAX_SCALE NBASE digits and, scaled to fastScale, it has at
+ * most NUMERIC_FAST_MAX_DIGITS NBASE digits (so its absolute value is below
+ * 10^28 < 2^94).  Before fastSumX could overflow, or when a larger scale
+ * comes along, it is flushed into sumX; readers of sumX flush it first.
+ */
+#define NUMERIC_FAST_MAX_SCALE	4
+#define NUMERIC_FAST_MAX_DIGITS	7
+#define NUMERIC_FAST_LIMIT		(((int128) 1) << 126)
+#endif
+
 /*
  * Prepare state data for a numeric aggregate function that needs to compute
  * sum, count and optionally sum of squares of the input.
@@ -3417,6 +3518,77 @@ makeNumericAggStateCurrentContext(bool calcSumX2)
 	return state;
 }
 
+#ifdef HAVE_INT128
+/*
+ * Move the value accumulated in fastSumX into sumX.
+ */
+static void
+numeric_fast_flush(NumericAggState *state)
+{
+	NumericVar	X;
+	MemoryContext old_context;
+
+	if (state->fastSumX == 0 && state->fastDscale == 0)
+		return;
+
+	init_var(&X);
+	int128_to_numericvar(state->fastSumX, &X);
+	if (X.ndigits > 0)
+		X.weight -= state->fastScale;
+	X.dscale = state->fastDscale;
+
+	old_context = MemoryContextSwitchTo(state->agg_context);
+	accum_sum_add(&(state->sumX), &X);
+	MemoryContextSwitchTo(old_context);
+
+	free_var(&X);
+
+	state->fastSumX = 0;
+	state->fastDscale = 0;
+}
+
+/*
+ * Add (or, if negate is true, subtract) a non-NaN value to fastSumX, reading
+ * its digits directly from the packed representation.  Returns false if the
+ * value doesn't qualify, in which case the caller must add it to sumX.
+ */
+static bool
+numeric_fast_accum(NumericAggState *state, Numeric num, bool negate)
+{
+	int			dscale = NUMERIC_DSCALE(num);
+	int			scale = (dscale + DEC_DIGITS - 1) / DEC_DIGITS;
+	int128		val;
+	int			ndigits;
+
+	if (scale > NUMERIC_FAST_MAX_SCALE)
+		return false;
+
+	/*
+	 * Rescaling a nonzero fastSumX could overflow, so flush it instead.  This
+	 * happens at most NUMERIC_FAST_MAX_SCALE times.
+	 */
+	if (scale > state->fastScale)
+	{
+		numeric_fast_flush(state);
+		state->fastScale = scale;
+	}
+
+	if (!numeric_to_scaled_int128(num, state->fastScale,
+								  NUMERIC_FAST_MAX_DIGITS, &val, &ndigits))
+		return false;
+
+	/* |val| < 2^94, so this leaves room for one more value */
+	if (state->fastSumX >= NUMERIC_FAST_LIMIT ||
+		state->fastSumX <= -NUMERIC_FAST_LIMIT)
+		numeric_fast_flush(state);
+
+	state->fastSumX += negate ? -val : val;
+	state->fastDscale = Max(state->fastDscale, dscale);
+
+	return true;
+}
+#endif
+
 /*
  * Accumulate a new input value for numeric aggregate functions.
  */
@@ -3426,6 +3598,8 @@ do_numeric_accum(NumericAggState *state, Numeric newval)
 	NumericVar	X;
 	NumericVar	X2;
 	MemoryContext old_context;
+	int			dscale;
+	bool		summed = false;
 
 	/* Count NaN inputs separately from all else */
 	if (NUMERIC_IS_NAN(newval))
@@ -3434,21 +3608,31 @@ do_numeric_accum(NumericAggState *state, Numeric newval)
 		return;
 	}
 
-	/* load processed number in short-lived context */
-	init_var_from_num(newval, &X);
-
 	/*
 	 * Track the highest input dscale that we've seen, to support inverse
 	 * transitions (see do_numeric_discard).
 	 */
-	if (X.dscale > state->maxScale)
+	dscale = NUMERIC_DSCALE(newval);
+	if (dscale > state->maxScale)
 	{
-		state->maxScale = X.dscale;
+		state->maxScale = dscale;
 		state->maxScaleCount = 1;
 	}
-	else if (X.dscale == state->maxScale)
+	else if (dscale == state->maxScale)
 		state->maxScaleCount++;
 
+	state->N++;
+
+#ifdef HAVE_INT128
+	/* Without sumX2, the fast path needs no NumericVar at all */
+	summed = numeric_fast_accum(state, newval, false);
+	if (summed && !state->calcSumX2)
+		return;
+#endif
+
+	/* load processed number in short-lived context */
+	init_var_from_num(newval, &X);
+
 	/* if we need X^2, calculate that in short-lived context */
 	if (state->calcSumX2)
 	{
@@ -3459,10 +3643,9 @@ do_numeric_accum(NumericAggState *state, Numeric newval)
 	/* The rest of this needs to work in the aggregate context */
 	old_context = MemoryContextSwitchTo(state->agg_context);
 
-	state->N++;
-
 	/* Accumulate sums */
-	accum_sum_add(&(state->sumX), &X);
+	if (!summed)
+		accum_sum_add(&(state->sumX), &X);
 
 	if (state->calcSumX2)
 		accum_sum_add(&(state->sumX2), &X2);
@@ -3544,9 +3727,15 @@ do_numeric_discard(NumericAggState *state, Numeric newval)
 
 	if (state->N-- > 1)
 	{
+		bool		summed = false;
+
+#ifdef HAVE_INT128
+		summed = numeric_fast_accum(state, newval, true);
+#endif
 		/* Negate X, to subtract it from the sum */
 		X.sign = (X.sign == NUMERIC_POS ? NUMERIC_NEG : NUMERIC_POS);
-		accum_sum_add(&(state->sumX), &X);
+		if (!summed)
+			accum_sum_add(&(state->sumX), &X);
 
 		if (state->calcSumX2)
 		{
@@ -3563,6 +3752,10 @@ do_numeric_discard(NumericAggState *state, Numeric newval)
 		accum_sum_reset(&state->sumX);
 		if (state->calcSumX2)
 			accum_sum_reset(&state->sumX2);
+#ifdef HAVE_INT128
+		state->fastSumX = 0;
+		state->fastDscale = 0;
+#endif
 	}
 
 	MemoryContextSwitchTo(old_context);
@@ -3610,6 +3803,11 @@ numeric_combine(PG_FUNCTION_ARGS)
 	if (state2 == NULL)
 		PG_RETURN_POINTER(state1);
 
+#ifdef HAVE_INT128
+	/* the state's sumX is read below, so bring it up to date */
+	numeric_fast_flush(state2);
+#endif
+
 	/* manually copy all fields from state2 to state1 */
 	if (state1 == NULL)
 	{
@@ -3698,6 +3896,11 @@ numeric_avg_combine(PG_FUNCTION_ARGS)
 	if (state2 == NULL)
 		PG_RETURN_POINTER(state1);
 
+#ifdef HAVE_INT128
+	/* the state's sumX is read below, so bring it up to date */
+	numeric_fast_flush(state2);
+#endif
+
 	/* manually copy all fields from state2 to state1 */
 	if (state1 == NULL)
 	{
@@ -3772,6 +3975,9 @@ numeric_avg_serialize(PG_FUNCTION_ARGS)
 	 * this? Doing so would also remove the fmgr call overhead.
 	 */
 	init_var(&tmp_var);
+#ifdef HAVE_INT128
+	numeric_fast_flush(state);
+#endif
 	accum_sum_final(&state->sumX, &tmp_var);
 
 	temp = DirectFunctionCall1(numeric_send,
@@ -3886,6 +4092,9 @@ numeric_serialize(PG_FUNCTION_ARGS)
 	 */
 	init_var(&tmp_var);
 
+#ifdef HAVE_INT128
+	numeric_fast_flush(state);
+#endif
 	accum_sum_final(&state->sumX, &tmp_var);
 	temp = DirectFunctionCall1(numeric_send,
 							   NumericGetDatum(make_result(&tmp_var)));
@@ -4782,6 +4991,9 @@ numeric_avg(PG_FUNCTION_ARGS)
 	N_datum = DirectFunctionCall1(int8_numeric, Int64GetDatum(state->N));
 
 	init_var(&sumX_var);
+#ifdef HAVE_INT128
+	numeric_fast_flush(state);
+#endif
 	accum_sum_final(&state->sumX, &sumX_var);
 	sumX_datum = NumericGetDatum(make_result(&sumX_var));
 	free_var(&sumX_var);
@@ -4806,6 +5018,9 @@ numeric_sum(PG_FUNCTION_ARGS)
 		PG_RETURN_NUMERIC(make_result(&const_nan));
 
 	init_var(&sumX_var);
+#ifdef HAVE_INT128
+	numeric_fast_flush(state);
+#endif
 	accum_sum_final(&state->sumX, &sumX_var);
 	result = make_result(&sumX_var);
 	free_var(&sumX_var);
@@ -4854,6 +5069,9 @@ numeric_stddev_internal(NumericAggState *state,
 	init_var(&vsumX2);
 
 	int64_to_numericvar(state->N, &vN);
+#ifdef HAVE_INT128
+	numeric_fast_flush(state);
+#endif
 	accum_sum_final(&(state->sumX), &vsumX);
 	accum_sum_final(&(state->sumX2), &vsumX2);
 
@@ -6492,6 +6710,69 @@ int128_to_numericvar(int128 val, NumericVar *var)
 	var->ndigits = ndigits;
 	var->weight = ndigits - 1;
 }
+
+/*
+ * Convert a non-NaN numeric to an int128 in units of NBASE^-scale, reading
+ * the digits straight from the packed value.  This fails if the value has
+ * digits below that unit (which can't happen if scale is at least the
+ * value's dscale in NBASE digits), or if the scaled value would have more
+ * than maxdigits NBASE digits.  On success, the number of NBASE digits of
+ * the scaled value (0 for zero) is returned in *resultdigits.
+ */
+static bool
+numeric_to_scaled_int128(Numeric num, int scale, int maxdigits,
+						 int128 *result, int *resultdigits)
+{
+	NumericDigit *digits = NUMERIC_DIGITS(num);
+	int			ndigits = NUMERIC_NDIGITS(num);
+	int			weight = NUMERIC_WEIGHT(num);
+	int128		val = 0;
+	int			i;
+
+	Assert(maxdigits <= NUMERIC_INT128_MAX_DIGITS);
+
+	if (ndigits == 0)
+	{
+		*result = 0;
+		*resultdigits = 0;
+		return true;
+	}
+
+	if (weight - ndigits + 1 < -scale || weight + 1 + scale > maxdigits)
+		return false;
+
+	for (i = 0; i < ndigits; i++)
+		val = val * NBASE + digits[i];
+	for (i = weight - ndigits + 1 + scale; i > 0; i--)
+		val *= NBASE;
+
+	*result = (NUMERIC_SIGN(num) == NUMERIC_NEG) ? -val : val;
+	*resultdigits = weight + 1 + scale;
+	return true;
+}
+
+/*
+ * Make a numeric from an int128 in units of NBASE^-scale, with the given
+ * display scale.
+ */
+static Numeric
+make_result_from_scaled_int128(int128 val, int scale, int dscale)
+{
+	NumericVar	result;
+	Numeric		res;
+
+	init_var(&result);
+	int128_to_numericvar(val, &result);
+	if (result.ndigits > 0)
+		result.weight -= scale;
+	result.dscale = dscale;
+
+	res = make_result(&result);
+
+	free_var(&result);
+
+	return res;
+}
 #endif
 
 /*
@@ -1550,6 +1550,43 @@ icu_to_uchar(UChar **buff_uchar, const char *buff, size_t nbytes)
 	return len_uchar;
 }
 
+/*
+ * Like icu_to_uchar(), but convert into the caller's palloc'd buffer
+ * *buff_uchar of *buflen_uchar UChars, enlarging it with repalloc() if the
+ * result doesn't fit.  This saves the separate pass to measure the result,
+ * and an allocation, for callers converting many strings.
+ *
+ * The result string is not necessarily nul-terminated.
+ */
+int32_t
+icu_to_uchar_buf(UChar **buff_uchar, int32_t *buflen_uchar,
+				 const char *buff, size_t nbytes)
+{
+	UErrorCode	status;
+	int32_t		len_uchar;
+
+	init_icu_converter();
+
+	status = U_ZERO_ERROR;
+	len_uchar = ucnv_toUChars(icu_converter, *buff_uchar, *buflen_uchar,
+							  buff, nbytes, &status);
+	if (status == U_BUFFER_OVERFLOW_ERROR)
+	{
+		*buflen_uchar = len_uchar + 1;
+		*buff_uchar = repalloc(*buff_uchar,
+							   *buflen_uchar * sizeof(**buff_uchar));
+
+		status = U_ZERO_ERROR;
+		len_uchar = ucnv_toUChars(icu_converter, *buff_uchar, *buflen_uchar,
+								  buff, nbytes, &status);
+	}
+	if (U_FAILURE(status))
+		ereport(ERROR,
+				(errmsg("ucnv_toUChars failed: %s", u_errorName(status))));
+
+	return len_uchar;
+}
+
 /*
  * Convert a string of UChars into the database encoding.
  *
@@ -15,6 +15,7 @@
 #include "postgres.h"
 
 #include "access/htup_details.h"
+#include "access/xlog.h"
 #include "catalog/pg_authid.h"
 #include "catalog/pg_type.h"
 #include "common/ip.h"
@@ -23,9 +24,11 @@
 #include "pgstat.h"
 #include "postmaster/bgworker_internals.h"
 #include "postmaster/postmaster.h"
+#include "storage/lwlock.h"
 #include "storage/proc.h"
 #include "storage/procarray.h"
 #include "utils/acl.h"
+#include "utils/array.h"
 #include "utils/builtins.h"
 #include "utils/inet.h"
 #include "utils/timestamp.h"
@@ -195,6 +198,22 @@ pg_stat_get_mod_since_analyze(PG_FUNCTION_ARGS)
 }
 
 
+Datum
+pg_stat_get_ins_since_vacuum(PG_FUNCTION_ARGS)
+{
+	Oid			relid = PG_GETARG_OID(0);
+	int64		result;
+	PgStat_StatTabEntry *tabentry;
+
+	if ((tabentry = pgstat_fetch_stat_tabentry(relid)) == NULL)
+		result = 0;
+	else
+		result = (int64) (tabentry->inserts_since_vacuum);
+
+	PG_RETURN_INT64(result);
+}
+
+
 Datum
 pg_stat_get_blocks_fetched(PG_FUNCTION_ARGS)
 {
@@ -541,7 +560,7 @@ pg_stat_get_progress_info(PG_FUNCTION_ARGS)
 Datum
 pg_stat_get_activity(PG_FUNCTION_ARGS)
 {
-#define PG_STAT_GET_ACTIVITY_COLS	24
+#define PG_STAT_GET_ACTIVITY_COLS	28
 	int			num_backends = pgstat_fetch_stat_numbackends();
 	int			curr_backend;
 	int			pid = PG_ARGISNULL(0) ? -1 : PG_GETARG_INT32(0);
@@ -837,6 +856,11 @@ pg_stat_get_activity(PG_FUNCTION_ARGS)
 			else
 				values[17] =
 					CStringGetTextDatum(pgstat_get_backend_desc(beentry->st_backendType));
+
+			values[24] = Int64GetDatum(beentry->st_net_bytes_sent);
+			values[25] = Int64GetDatum(beentry->st_net_bytes_received);
+			values[26] = Int64GetDatum(beentry->st_net_send_calls);
+			values[27] = Int64GetDatum(beentry->st_net_recv_calls);
 		}
 		else
 		{
@@ -853,6 +877,10 @@ pg_stat_get_activity(PG_FUNCTION_ARGS)
 			nulls[13] = true;
 			nulls[14] = true;
 			nulls[17] = true;
+			nulls[24] = true;
+			nulls[25] = true;
+			nulls[26] = true;
+			nulls[27] = true;
 		}
 
 		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
@@ -1471,6 +1499,36 @@ pg_stat_get_db_deadlocks(PG_FUNCTION_ARGS)
 	PG_RETURN_INT64(result);
 }
 
+Datum
+pg_stat_get_db_parallel_workers_to_launch(PG_FUNCTION_ARGS)
+{
+	Oid			dbid = PG_GETARG_OID(0);
+	int64		result;
+	PgStat_StatDBEntry *dbentry;
+
+	if ((dbentry = pgstat_fetch_stat_dbentry(dbid)) == NULL)
+		result = 0;
+	else
+		result = (int64) (dbentry->n_parallel_workers_to_launch);
+
+	PG_RETURN_INT64(result);
+}
+
+Datum
+pg_stat_get_db_parallel_workers_launched(PG_FUNCTION_ARGS)
+{
+	Oid			dbid = PG_GETARG_OID(0);
+	int64		result;
+	PgStat_StatDBEntry *dbentry;
+
+	if ((dbentry = pgstat_fetch_stat_dbentry(dbid)) == NULL)
+		result = 0;
+	else
+		result = (int64) (dbentry->n_parallel_workers_launched);
+
+	PG_RETURN_INT64(result);
+}
+
 Datum
 pg_stat_get_db_blk_read_time(PG_FUNCTION_ARGS)
 {
@@ -1882,3 +1940,202 @@ pg_stat_get_archiver(PG_FUNCTION_ARGS)
 	PG_RETURN_DATUM(HeapTupleGetDatum(
 									  heap_form_tuple(tupdesc, values, nulls)));
 }
+
+/*
+ * Returns statistics about WAL flushing by XLogFlush(): how often it flushed
+ * WAL itself, and how often it found its request satisfied by a flush that
+ * another backend did while it was waiting.
+ */
+Datum
+pg_stat_get_wal_group_commit(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	Datum		values[2];
+	bool		nulls[2];
+	uint64		flushes;
+	uint64		followers;
+
+	/* Initialise values and NULL flags arrays */
+	MemSet(values, 0, sizeof(values));
+	MemSet(nulls, 0, sizeof(nulls));
+
+	/* Initialise attributes information in the tuple descriptor */
+	tupdesc = CreateTemplateTupleDesc(2);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 1, "flushes",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 2, "followers",
+					   INT8OID, -1, 0);
+
+	BlessTupleDesc(tupdesc);
+
+	GetXLogGroupFlushStats(&flushes, &followers);
+
+	values[0] = Int64GetDatum((int64) flushes);
+	values[1] = Int64GetDatum((int64) followers);
+
+	/* Returns the record as Datum */
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
+
+/*
+ * Returns per-tranche LWLock acquisition and wait statistics.
+ */
+Datum
+pg_stat_get_lwlocks(PG_FUNCTION_ARGS)
+{
+#define PG_STAT_GET_LWLOCKS_COLS	6
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+	int			slot;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not " \
+						"allowed in this context")));
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+	MemoryContextSwitchTo(oldcontext);
+
+	for (slot = 0; slot < LWLOCK_STATS_NUM_TRANCHES; slot++)
+	{
+		LWLockTrancheStats stats;
+		Datum		values[PG_STAT_GET_LWLOCKS_COLS];
+		bool		nulls[PG_STAT_GET_LWLOCKS_COLS];
+		Datum		buckets[LWLOCK_STATS_WAIT_BUCKETS];
+		const char *name;
+		int			i;
+
+		LWLockGetTrancheStats(slot, &stats);
+
+		/* Skip tranches that have never been used, such as unused IDs */
+		if (stats.acquires == 0 && stats.waits == 0)
+			continue;
+
+		if (slot == LWLOCK_STATS_EXTENSION_SLOT)
+			name = "extension";
+		else
+			name = GetLWLockIdentifier(PG_WAIT_LWLOCK, (uint16) slot);
+
+		MemSet(nulls, 0, sizeof(nulls));
+
+		for (i = 0; i < LWLOCK_STATS_WAIT_BUCKETS; i++)
+			buckets[i] = Int64GetDatum((int64) stats.wait_histogram[i]);
+
+		values[0] = CStringGetTextDatum(name);
+		values[1] = Int64GetDatum((int64) stats.acquires);
+		values[2] = Int64GetDatum((int64) stats.waits);
+		values[3] = Int64GetDatum((int64) stats.spin_delays);
+		/* convert to msec */
+		values[4] = Float8GetDatum((double) stats.wait_time / 1000.0);
+		values[5] = PointerGetDatum(construct_array(buckets,
+													LWLOCK_STATS_WAIT_BUCKETS,
+													INT8OID, sizeof(int64),
+													FLOAT8PASSBYVAL, 'd'));
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	/* clean up and return the tuplestore */
+	tuplestore_donestoring(tupstore);
+
+	return (Datum) 0;
+}
+
+/*
+ * Returns shared buffer I/O statistics per backend type and I/O context.
+ */
+Datum
+pg_stat_get_io(PG_FUNCTION_ARGS)
+{
+#define PG_STAT_GET_IO_COLS	9
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+	int			btype;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not " \
+						"allowed in this context")));
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+	MemoryContextSwitchTo(oldcontext);
+
+	for (btype = 0; btype < BACKEND_NUM_TYPES; btype++)
+	{
+		int			context;
+
+		for (context = 0; context < IOCONTEXT_NUM_TYPES; context++)
+		{
+			PgStat_IOCounters counters;
+			Datum		values[PG_STAT_GET_IO_COLS];
+			bool		nulls[PG_STAT_GET_IO_COLS];
+
+			pgstat_get_io_stats((BackendType) btype, (IOContext) context,
+								&counters);
+
+			/* Skip combinations that haven't done any I/O */
+			if (counters.reads == 0 && counters.hits == 0 &&
+				counters.writes == 0 && counters.extends == 0 &&
+				counters.fsyncs == 0)
+				continue;
+
+			MemSet(nulls, 0, sizeof(nulls));
+
+			values[0] = CStringGetTextDatum(pgstat_get_backend_desc((BackendType) btype));
+			values[1] = CStringGetTextDatum(pgstat_get_io_context_desc((IOContext) context));
+			values[2] = Int64GetDatum((int64) counters.reads);
+			/* convert to msec */
+			values[3] = Float8GetDatum((double) counters.read_time / 1000.0);
+			values[4] = Int64GetDatum((int64) counters.hits);
+			values[5] = Int64GetDatum((int64) counters.writes);
+			values[6] = Float8GetDatum((double) counters.write_time / 1000.0);
+			values[7] = Int64GetDatum((int64) counters.extends);
+			values[8] = Int64GetDatum((int64) counters.fsyncs);
+
+			tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+		}
+	}
+
+	/* clean up and return the tuplestore */
+	tuplestore_donestoring(tupstore);
+
+	return (Datum) 0;
+}
@@ -29,6 +29,7 @@
  */
 #include "postgres.h"
 
+#include "access/hash.h"
 #include "catalog/pg_type.h"
 #include "funcapi.h"
 #include "miscadmin.h"
@@ -89,11 +90,20 @@ typedef struct regexp_matches_ctx
  * patterns are seen will "fail to keep up" and will drop off the end of the
  * cache.  With move-to-front, a reusable pattern is guaranteed to stay in
  * the cache as long as it's used at least once in every MAX_CACHED_RES uses.
+ *
+ * To keep scanning a long list cheap, each entry also remembers a hash of
+ * its pattern, which is compared before the pattern itself.
+ *
+ * Along with the compiled RE, we remember whether the pattern is a plain
+ * literal string, and any fixed prefix that all matches must start with.
+ * For a simple boolean match, that lets RE_compile_and_execute() do a
+ * substring search instead of running the regex engine at all, or reject
+ * most non-matching strings without converting them to pg_wchar.
  */
 
 /* this is the maximum number of cached regular expressions */
 #ifndef MAX_CACHED_RES
-#define MAX_CACHED_RES	32
+#define MAX_CACHED_RES	128
 #endif
 
 /* this structure describes one cached regular expression */
@@ -101,8 +111,13 @@ typedef struct cached_re_str
 {
 	char	   *cre_pat;		/* original RE (not null terminated!) */
 	int			cre_pat_len;	/* length of original RE, in bytes */
+	uint32		cre_pat_hash;	/* hash of original RE */
 	int			cre_flags;		/* compile flags: extended,icase etc */
 	Oid			cre_collation;	/* collation to use */
+	bool		cre_literal;	/* RE matches just the literal cre_pat? */
+	char	   *cre_prefix;		/* fixed prefix of all matches, in database
+								 * encoding, or NULL if none */
+	int			cre_prefix_len; /* length of cre_prefix, in bytes */
 	regex_t		cre_re;			/* the compiled regular expression */
 } cached_re_str;
 
@@ -111,6 +126,12 @@ static cached_re_str re_array[MAX_CACHED_RES];	/* cached re's */
 
 
 /* Local functions */
+static cached_re_str *RE_compile_and_cache_entry(text *text_re, int cflags,
+						   Oid collation);
+static bool RE_pattern_is_literal(const char *pat, int pat_len, int cflags);
+static void RE_find_fixed_prefix(cached_re_str *cre);
+static bool RE_literal_search(const char *pat, int pat_len,
+				  const char *dat, int dat_len);
 static regexp_matches_ctx *setup_regexp_matches(text *orig_str, text *pattern,
 					 pg_re_flags *flags,
 					 Oid collation,
@@ -135,9 +156,23 @@ static Datum build_regexp_split_result(regexp_matches_ctx *splitctx);
  */
 static regex_t *
 RE_compile_and_cache(text *text_re, int cflags, Oid collation)
+{
+	return &RE_compile_and_cache_entry(text_re, cflags, collation)->cre_re;
+}
+
+/*
+ * RE_compile_and_cache_entry - guts of RE_compile_and_cache
+ *
+ * Returns the cache entry, for callers that want to look at more than the
+ * compiled RE.  As with the returned regex_t, it's only valid until the
+ * next call.
+ */
+static cached_re_str *
+RE_compile_and_cache_entry(text *text_re, int cflags, Oid collation)
 {
 	int			text_re_len = VARSIZE_ANY_EXHDR(text_re);
 	char	   *text_re_val = VARDATA_ANY(text_re);
+	uint32		text_re_hash;
 	pg_wchar   *pattern;
 	int			pattern_len;
 	int			i;
@@ -145,6 +180,9 @@ RE_compile_and_cache(text *text_re, int cflags, Oid collation)
 	cached_re_str re_temp;
 	char		errMsg[100];
 
+	text_re_hash = DatumGetUInt32(hash_any((unsigned char *) text_re_val,
+										   text_re_len));
+
 	/*
 	 * Look for a match among previously compiled REs.  Since the data
 	 * structure is self-organizing with most-used entries at the front, our
@@ -152,7 +190,8 @@ RE_compile_and_cache(text *text_re, int cflags, Oid collation)
 	 */
 	for (i = 0; i < num_res; i++)
 	{
-		if (re_array[i].cre_pat_len == text_re_len &&
+		if (re_array[i].cre_pat_hash == text_re_hash &&
+			re_array[i].cre_pat_len == text_re_len &&
 			re_array[i].cre_flags == cflags &&
 			re_array[i].cre_collation == collation &&
 			memcmp(re_array[i].cre_pat, text_re_val, text_re_len) == 0)
@@ -167,7 +206,7 @@ RE_compile_and_cache(text *text_re, int cflags, Oid collation)
 				re_array[0] = re_temp;
 			}
 
-			return &re_array[0].cre_re;
+			return &re_array[0];
 		}
 	}
 
@@ -224,9 +263,15 @@ RE_compile_and_cache(text *text_re, int cflags, Oid collation)
 	}
 	memcpy(re_temp.cre_pat, text_re_val, text_re_len);
 	re_temp.cre_pat_len = text_re_len;
+	re_temp.cre_pat_hash = text_re_hash;
 	re_temp.cre_flags = cflags;
 	re_temp.cre_collation = collation;
 
+	/* Remember what we can use to avoid running the regex engine */
+	re_temp.cre_literal = RE_pattern_is_literal(text_re_val, text_re_len,
+												cflags);
+	RE_find_fixed_prefix(&re_temp);
+
 	/*
 	 * Okay, we have a valid new item in re_temp; insert it into the storage
 	 * array.  Discard last entry if needed.
@@ -237,6 +282,8 @@ RE_compile_and_cache(text *text_re, int cflags, Oid collation)
 		Assert(num_res < MAX_CACHED_RES);
 		pg_regfree(&re_array[num_res].cre_re);
 		free(re_array[num_res].cre_pat);
+		if (re_array[num_res].cre_prefix)
+			free(re_array[num_res].cre_prefix);
 	}
 
 	if (num_res > 0)
@@ -245,7 +292,117 @@ RE_compile_and_cache(text *text_re, int cflags, Oid collation)
 	re_array[0] = re_temp;
 	num_res++;
 
-	return &re_array[0].cre_re;
+	return &re_array[0];
+}
+
+/*
+ * RE_pattern_is_literal - does the pattern match only its own text?
+ *
+ * That's the case for an advanced RE with default options that contains no
+ * characters having special meaning, which is common for patterns written
+ * by applications.  Matching such a pattern is just a substring search.  We
+ * only do that search on the database-encoded strings if a byte-wise match
+ * can't start in the middle of a character, which is true of single-byte
+ * encodings and UTF8; the pattern's bytes could otherwise be mistaken for
+ * trailing bytes of the data's characters.
+ */
+static bool
+RE_pattern_is_literal(const char *pat, int pat_len, int cflags)
+{
+	int			i;
+
+	if (cflags != REG_ADVANCED)
+		return false;
+
+	if (pg_database_encoding_max_length() != 1 &&
+		GetDatabaseEncoding() != PG_UTF8)
+		return false;
+
+	for (i = 0; i < pat_len; i++)
+	{
+		if (strchr("\\^$.[]()|*+?{}", pat[i]) != NULL)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * RE_find_fixed_prefix - fill in the cache entry's fixed prefix, if any
+ *
+ * pg_regprefix() promises that every string satisfying the RE starts with
+ * the prefix it reports, though not that every string starting with it
+ * satisfies the RE; so we can use it only to reject strings quickly.  The
+ * planner relies on the same promise to turn a regex match into an index
+ * range condition.
+ *
+ * We don't bother when the RE is newline-anchored, since then "^" can match
+ * after any newline and the prefix needn't be at the start of the data.
+ * That may be requested by embedded options as well as by cflags, and we
+ * can't see the compiled flags from here, so also skip patterns that start
+ * with an embedded-options or director sequence.
+ *
+ * Failure to find a prefix, including running out of memory, just means
+ * we can't use one.
+ */
+static void
+RE_find_fixed_prefix(cached_re_str *cre)
+{
+	pg_wchar   *str;
+	size_t		slen;
+	int			re_result;
+
+	cre->cre_prefix = NULL;
+	cre->cre_prefix_len = 0;
+
+	if (cre->cre_literal)
+		return;
+
+	if ((cre->cre_flags & REG_NLANCH) != 0)
+		return;
+	if (cre->cre_pat_len >= 2 &&
+		(strncmp(cre->cre_pat, "(?", 2) == 0 ||
+		 strncmp(cre->cre_pat, "**", 2) == 0))
+		return;
+
+	re_result = pg_regprefix(&cre->cre_re, &str, &slen);
+	if (re_result != REG_PREFIX && re_result != REG_EXACT)
+		return;
+
+	if (slen > 0)
+	{
+		cre->cre_prefix = malloc(pg_database_encoding_max_length() * slen + 1);
+		if (cre->cre_prefix != NULL)
+			cre->cre_prefix_len = pg_wchar2mb_with_len(str, cre->cre_prefix,
+													   slen);
+	}
+
+	free(str);
+}
+
+/*
+ * RE_literal_search - is pat a substring of dat?
+ */
+static bool
+RE_literal_search(const char *pat, int pat_len, const char *dat, int dat_len)
+{
+	const char *p = dat;
+	const char *last = dat + dat_len - pat_len;
+
+	if (pat_len == 0)
+		return true;
+
+	while (p <= last)
+	{
+		p = memchr(p, (unsigned char) pat[0], last - p + 1);
+		if (p == NULL)
+			return false;
+		if (memcmp(p, pat, pat_len) == 0)
+			return true;
+		p++;
+	}
+
+	return false;
 }
 
 /*
@@ -344,12 +501,23 @@ RE_compile_and_execute(text *text_re, char *dat, int dat_len,
 					   int cflags, Oid collation,
 					   int nmatch, regmatch_t *pmatch)
 {
-	regex_t    *re;
+	cached_re_str *cre;
 
 	/* Compile RE */
-	re = RE_compile_and_cache(text_re, cflags, collation);
+	cre = RE_compile_and_cache_entry(text_re, cflags, collation);
+
+	/* A literal pattern can be matched directly, if no details are wanted */
+	if (cre->cre_literal && nmatch == 0)
+		return RE_literal_search(cre->cre_pat, cre->cre_pat_len,
+								 dat, dat_len);
+
+	/* Reject data that doesn't begin with the RE's fixed prefix */
+	if (cre->cre_prefix != NULL &&
+		(dat_len < cre->cre_prefix_len ||
+		 memcmp(dat, cre->cre_prefix, cre->cre_prefix_len) != 0))
+		return false;
 
-	return RE_execute(re, dat, dat_len, nmatch, pmatch);
+	return RE_execute(&cre->cre_re, dat, dat_len, nmatch, pmatch);
 }
 
 
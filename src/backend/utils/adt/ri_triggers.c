@@ -30,9 +30,13 @@
 
 #include "postgres.h"
 
+#include "access/genam.h"
+#include "access/heapam.h"
 #include "access/htup_details.h"
+#include "access/stratnum.h"
 #include "access/sysattr.h"
 #include "access/xact.h"
+#include "catalog/pg_am.h"
 #include "catalog/pg_collation.h"
 #include "catalog/pg_constraint.h"
 #include "catalog/pg_operator.h"
@@ -112,6 +116,7 @@ typedef struct RI_ConstraintInfo
 	NameData	conname;		/* name of the FK constraint */
 	Oid			pk_relid;		/* referenced relation */
 	Oid			fk_relid;		/* referencing relation */
+	Oid			conindid;		/* index supporting the referenced key */
 	char		confupdtype;	/* foreign key's ON UPDATE action */
 	char		confdeltype;	/* foreign key's ON DELETE action */
 	char		confmatchtype;	/* foreign key's match type */
@@ -233,6 +238,11 @@ static bool ri_PerformCheck(const RI_ConstraintInfo *riinfo,
 				Relation fk_rel, Relation pk_rel,
 				HeapTuple old_tuple, HeapTuple new_tuple,
 				bool detectNewRows, int expect_OK);
+static bool ri_FastPathCheck(const RI_ConstraintInfo *riinfo,
+				 Relation fk_rel, Relation pk_rel, HeapTuple new_row);
+static bool ri_FastPathScanKeys(const RI_ConstraintInfo *riinfo,
+					Relation fk_rel, Relation idxrel,
+					Datum *vals, ScanKey skey);
 static void ri_ExtractValues(Relation rel, HeapTuple tup,
 				 const RI_ConstraintInfo *riinfo, bool rel_is_pk,
 				 Datum *vals, char *nulls);
@@ -381,6 +391,16 @@ RI_FKey_check(TriggerData *trigdata)
 			break;
 	}
 
+	/*
+	 * In the common case, look the key up in the PK's unique index
+	 * ourselves, saving the overhead of going through SPI for every row.
+	 */
+	if (ri_FastPathCheck(riinfo, fk_rel, pk_rel, new_row))
+	{
+		heap_close(pk_rel, RowShareLock);
+		return PointerGetDatum(NULL);
+	}
+
 	if (SPI_connect() != SPI_OK_CONNECT)
 		elog(ERROR, "SPI_connect failed");
 
@@ -2229,6 +2249,7 @@ ri_LoadConstraintInfo(Oid constraintOid)
 	memcpy(&riinfo->conname, &conForm->conname, sizeof(NameData));
 	riinfo->pk_relid = conForm->confrelid;
 	riinfo->fk_relid = conForm->conrelid;
+	riinfo->conindid = conForm->conindid;
 	riinfo->confupdtype = conForm->confupdtype;
 	riinfo->confdeltype = conForm->confdeltype;
 	riinfo->confmatchtype = conForm->confmatchtype;
@@ -2559,6 +2580,214 @@ ri_PerformCheck(const RI_ConstraintInfo *riinfo,
 	return SPI_processed != 0;
 }
 
+/*
+ * ri_FastPathCheck -
+ *
+ * Check that the key of new_row is present in the PK table by scanning the
+ * unique index underlying the constraint directly, and lock the PK row
+ * FOR KEY SHARE, which is what the SPI query of RI_FKey_check would do.
+ * A violation is reported as an error.  Returns false, having done nothing,
+ * if the check can't be done this way and the caller must run the query.
+ *
+ * The caller has checked that none of the key columns are null.
+ */
+static bool
+ri_FastPathCheck(const RI_ConstraintInfo *riinfo,
+				 Relation fk_rel, Relation pk_rel, HeapTuple new_row)
+{
+	Oid			pk_owner = RelationGetForm(pk_rel)->relowner;
+	Relation	idxrel;
+	Datum		vals[RI_MAX_NUMKEYS];
+	char		nulls[RI_MAX_NUMKEYS];
+	ScanKeyData skey[INDEX_MAX_KEYS];
+	Snapshot	snapshot;
+	Oid			save_userid;
+	int			save_sec_context;
+	bool		found;
+
+	/*
+	 * The query would be run as the PK table's owner, who normally holds
+	 * the privileges it needs.  Leave any other case to the query, so that
+	 * the usual error is raised.
+	 */
+	if (pk_rel->rd_rel->relkind != RELKIND_RELATION ||
+		!OidIsValid(riinfo->conindid) ||
+		pg_class_aclcheck(RelationGetRelid(pk_rel), pk_owner,
+						  ACL_SELECT) != ACLCHECK_OK ||
+		pg_class_aclcheck(RelationGetRelid(pk_rel), pk_owner,
+						  ACL_UPDATE) != ACLCHECK_OK)
+		return false;
+
+	idxrel = index_open(riinfo->conindid, AccessShareLock);
+
+	ri_ExtractValues(fk_rel, new_row, riinfo, false, vals, nulls);
+	if (!ri_FastPathScanKeys(riinfo, fk_rel, idxrel, vals, skey))
+	{
+		index_close(idxrel, AccessShareLock);
+		return false;
+	}
+
+	/* Switch to proper UID to perform check as */
+	GetUserIdAndSecContext(&save_userid, &save_sec_context);
+	SetUserIdAndSecContext(pk_owner,
+						   save_sec_context | SECURITY_LOCAL_USERID_CHANGE |
+						   SECURITY_NOFORCE_RLS);
+
+	/* Take a snapshot the same way SPI would for the query */
+	CommandCounterIncrement();
+	PushActiveSnapshot(GetTransactionSnapshot());
+	UpdateActiveSnapshotCommandId();
+	snapshot = GetActiveSnapshot();
+
+	for (;;)
+	{
+		IndexScanDesc scan;
+		HeapTuple	tuple;
+		bool		retry = false;
+
+		found = false;
+		scan = index_beginscan(pk_rel, idxrel, snapshot, riinfo->nkeys, 0);
+		index_rescan(scan, skey, riinfo->nkeys, NULL, 0);
+
+		while (!found && !retry &&
+			   (tuple = index_getnext(scan, ForwardScanDirection)) != NULL)
+		{
+			HeapTupleData locktup;
+			Buffer		buffer;
+			HeapUpdateFailureData hufd;
+			HTSU_Result test;
+
+			locktup.t_self = tuple->t_self;
+			test = heap_lock_tuple(pk_rel, &locktup,
+								   GetCurrentCommandId(true),
+								   LockTupleKeyShare, LockWaitBlock, true,
+								   &buffer, &hufd);
+			ReleaseBuffer(buffer);
+
+			switch (test)
+			{
+				case HeapTupleMayBeUpdated:
+					found = true;
+					break;
+
+				case HeapTupleSelfUpdated:
+					/* updated or deleted by us; treat it as deleted */
+					break;
+
+				case HeapTupleUpdated:
+					if (IsolationUsesXactSnapshot())
+						ereport(ERROR,
+								(errcode(ERRCODE_T_R_SERIALIZATION_FAILURE),
+								 errmsg("could not serialize access due to concurrent update")));
+					if (ItemPointerIndicatesMovedPartitions(&hufd.ctid))
+						ereport(ERROR,
+								(errcode(ERRCODE_T_R_SERIALIZATION_FAILURE),
+								 errmsg("tuple to be locked was already moved to another partition due to concurrent update")));
+
+					/*
+					 * If the row was updated rather than deleted, look the
+					 * key up again in a fresh snapshot.  That finds the new
+					 * version if it still has the same key, which is what
+					 * the query's EvalPlanQual recheck amounts to.
+					 */
+					if (!ItemPointerEquals(&hufd.ctid, &locktup.t_self))
+						retry = true;
+					break;
+
+				case HeapTupleInvisible:
+					elog(ERROR, "attempted to lock invisible tuple");
+					break;
+
+				default:
+					elog(ERROR, "unrecognized heap_lock_tuple status: %u",
+						 test);
+					break;
+			}
+		}
+
+		index_endscan(scan);
+
+		if (!retry)
+			break;
+
+		PopActiveSnapshot();
+		PushActiveSnapshot(GetTransactionSnapshot());
+		snapshot = GetActiveSnapshot();
+	}
+
+	PopActiveSnapshot();
+
+	/* Restore UID and security context */
+	SetUserIdAndSecContext(save_userid, save_sec_context);
+
+	index_close(idxrel, AccessShareLock);
+
+	if (!found)
+		ri_ReportViolation(riinfo, pk_rel, fk_rel, new_row, NULL,
+						   RI_PLAN_CHECK_LOOKUPPK);
+
+	return true;
+}
+
+/*
+ * ri_FastPathScanKeys -
+ *
+ * Build btree scan keys on idxrel, in index column order, to look up the
+ * FK values in vals.  Returns false if the constraint's equality operators
+ * can't be used as index quals directly.
+ */
+static bool
+ri_FastPathScanKeys(const RI_ConstraintInfo *riinfo,
+					Relation fk_rel, Relation idxrel,
+					Datum *vals, ScanKey skey)
+{
+	int			k;
+
+	if (idxrel->rd_rel->relam != BTREE_AM_OID ||
+		IndexRelationGetNumberOfKeyAttributes(idxrel) != riinfo->nkeys)
+		return false;
+
+	for (k = 0; k < riinfo->nkeys; k++)
+	{
+		AttrNumber	pk_attnum = idxrel->rd_index->indkey.values[k];
+		Oid			eq_opr;
+		Oid			lefttype;
+		Oid			righttype;
+		int			i;
+
+		for (i = 0; i < riinfo->nkeys; i++)
+		{
+			if (riinfo->pk_attnums[i] == pk_attnum)
+				break;
+		}
+		if (i >= riinfo->nkeys)
+			return false;
+
+		/*
+		 * The FK value is passed to the operator as is, so it must not need
+		 * any conversion the query would have applied.
+		 */
+		eq_opr = riinfo->pf_eq_oprs[i];
+		op_input_types(eq_opr, &lefttype, &righttype);
+		if (get_op_opfamily_strategy(eq_opr, idxrel->rd_opfamily[k]) !=
+			BTEqualStrategyNumber ||
+			!IsBinaryCoercible(RIAttType(fk_rel, riinfo->fk_attnums[i]),
+							   righttype))
+			return false;
+
+		ScanKeyEntryInitialize(&skey[k],
+							   0,
+							   k + 1,
+							   BTEqualStrategyNumber,
+							   righttype,
+							   idxrel->rd_indcollation[k],
+							   get_opcode(eq_opr),
+							   vals[i]);
+	}
+
+	return true;
+}
+
 /*
  * Extract fields from a tuple into Datum/nulls arrays
  */
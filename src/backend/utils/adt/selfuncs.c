@@ -6749,9 +6749,10 @@ genericcostestimate(PlannerInfo *root,
 
 	/*
 	 * Check for ScalarArrayOpExpr index quals, and estimate the number of
-	 * index scans that will be performed.
+	 * index scans that will be performed.  The caller may have told us about
+	 * other sources of repeated scans.
 	 */
-	num_sa_scans = 1;
+	num_sa_scans = Max(costs->num_sa_scans, 1.0);
 	foreach(l, indexQuals)
 	{
 		RestrictInfo *rinfo = (RestrictInfo *) lfirst(l);
@@ -6976,11 +6977,28 @@ btcostestimate(PlannerInfo *root, IndexPath *path, double loop_count,
 	bool		found_saop;
 	bool		found_is_null_op;
 	double		num_sa_scans;
+	double		num_skip_groups;
 	ListCell   *lc;
 
 	/* Do preliminary analysis of indexquals */
 	qinfos = deconstruct_indexquals(path);
 
+	/*
+	 * A skip scan searches the index once for each distinct value of the
+	 * first column, after a probe to find that value.  Each search behaves
+	 * as if there were an '=' qual on the first column, much like the
+	 * searches induced by a ScalarArrayOpExpr.
+	 */
+	num_skip_groups = 0;
+	if (path->indexskip)
+	{
+		TargetEntry *tle = (TargetEntry *) linitial(index->indextlist);
+
+		num_skip_groups = estimate_num_groups(root, list_make1(tle->expr),
+											  Max(index->tuples, 1.0),
+											  NULL);
+	}
+
 	/*
 	 * For a btree scan, only leading '=' quals plus inequality quals for the
 	 * immediately next attribute contribute to index selectivity (these are
@@ -7000,10 +7018,10 @@ btcostestimate(PlannerInfo *root, IndexPath *path, double loop_count,
 	 */
 	indexBoundQuals = NIL;
 	indexcol = 0;
-	eqQualHere = false;
+	eqQualHere = path->indexskip;
 	found_saop = false;
 	found_is_null_op = false;
-	num_sa_scans = 1;
+	num_sa_scans = Max(num_skip_groups, 1.0);
 	foreach(lc, qinfos)
 	{
 		IndexQualInfo *qinfo = (IndexQualInfo *) lfirst(lc);
@@ -7107,6 +7125,7 @@ btcostestimate(PlannerInfo *root, IndexPath *path, double loop_count,
 	 */
 	MemSet(&costs, 0, sizeof(costs));
 	costs.numIndexTuples = numIndexTuples;
+	costs.num_sa_scans = num_skip_groups;
 
 	genericcostestimate(root, path, loop_count, qinfos, &costs);
 
@@ -7119,13 +7138,15 @@ btcostestimate(PlannerInfo *root, IndexPath *path, double loop_count,
 	 *
 	 * If there are ScalarArrayOpExprs, charge this once per SA scan.  The
 	 * ones after the first one are not startup cost so far as the overall
-	 * plan is concerned, so add them only to "total" cost.
+	 * plan is concerned, so add them only to "total" cost.  A skip scan
+	 * also descends once per group to find the next value.
 	 */
 	if (index->tuples > 1)		/* avoid computing log(0) */
 	{
 		descentCost = ceil(log(index->tuples) / log(2.0)) * cpu_operator_cost;
 		costs.indexStartupCost += descentCost;
-		costs.indexTotalCost += costs.num_sa_scans * descentCost;
+		costs.indexTotalCost += (costs.num_sa_scans + num_skip_groups) *
+			descentCost;
 	}
 
 	/*
@@ -7136,11 +7157,13 @@ btcostestimate(PlannerInfo *root, IndexPath *path, double loop_count,
 	 * in cases where only a single leaf page is expected to be visited.  This
 	 * cost is somewhat arbitrarily set at 50x cpu_operator_cost per page
 	 * touched.  The number of such pages is btree tree height plus one (ie,
-	 * we charge for the leaf page too).  As above, charge once per SA scan.
+	 * we charge for the leaf page too).  As above, charge once per SA scan,
+	 * and once more per skip scan group.
 	 */
 	descentCost = (index->tree_height + 1) * 50.0 * cpu_operator_cost;
 	costs.indexStartupCost += descentCost;
-	costs.indexTotalCost += costs.num_sa_scans * descentCost;
+	costs.indexTotalCost += (costs.num_sa_scans + num_skip_groups) *
+		descentCost;
 
 	/*
 	 * If we can get an estimate of the first column's ordering correlation C
@@ -35,8 +35,22 @@ static const float weights[] = {0.1f, 0.2f, 0.4f, 1.0f};
 #define RANK_NORM_RDIVRPLUS1	0x20
 #define DEF_NORM_METHOD			RANK_NO_NORM
 
-static float calc_rank_or(const float *w, TSVector t, TSQuery q);
-static float calc_rank_and(const float *w, TSVector t, TSQuery q);
+/*
+ * The sorted, de-duplicated operands of the last query ranked at a given
+ * call site, kept in fn_extra.  Rankings are normally computed with the
+ * same query for every row, so this saves re-sorting the operands per row.
+ */
+typedef struct
+{
+	TSQuery		query;			/* private copy of the query */
+	QueryOperand **items;		/* unique operands, pointing into query */
+	int			nitems;
+} RankOperandCache;
+
+static float calc_rank_or(const float *w, TSVector t, TSQuery q,
+			 QueryOperand **item, int size);
+static float calc_rank_and(const float *w, TSVector t, TSQuery q,
+			  QueryOperand **item, int size);
 
 /*
  * Returns a weight of a word collocation
@@ -197,8 +211,54 @@ SortAndUniqItems(TSQuery q, int *size)
 	return res;
 }
 
+/*
+ * Return the sorted, unique operands of *q, as SortAndUniqItems does, but
+ * reuse the result of the previous call at this call site if the query is
+ * unchanged.  On a cache hit *q is replaced by the cached copy of the query,
+ * so that the returned operands point into it.  The result must not be
+ * freed by the caller.
+ */
+static QueryOperand **
+get_rank_operands(FmgrInfo *flinfo, TSQuery *q, int *size)
+{
+	RankOperandCache *cache = (RankOperandCache *) flinfo->fn_extra;
+	MemoryContext oldcontext;
+
+	if (cache != NULL &&
+		VARSIZE(cache->query) == VARSIZE(*q) &&
+		memcmp(cache->query, *q, VARSIZE(*q)) == 0)
+	{
+		*q = cache->query;
+		*size = cache->nitems;
+		return cache->items;
+	}
+
+	oldcontext = MemoryContextSwitchTo(flinfo->fn_mcxt);
+
+	if (cache == NULL)
+		cache = (RankOperandCache *) palloc0(sizeof(RankOperandCache));
+	else
+	{
+		pfree(cache->query);
+		pfree(cache->items);
+	}
+
+	cache->query = (TSQuery) palloc(VARSIZE(*q));
+	memcpy(cache->query, *q, VARSIZE(*q));
+	cache->nitems = cache->query->size;
+	cache->items = SortAndUniqItems(cache->query, &cache->nitems);
+	flinfo->fn_extra = (void *) cache;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	*q = cache->query;
+	*size = cache->nitems;
+	return cache->items;
+}
+
 static float
-calc_rank_and(const float *w, TSVector t, TSQuery q)
+calc_rank_and(const float *w, TSVector t, TSQuery q,
+			  QueryOperand **item, int size)
 {
 	WordEntryPosVector **pos;
 	WordEntryPosVector1 posnull;
@@ -216,15 +276,9 @@ calc_rank_and(const float *w, TSVector t, TSQuery q)
 				dist,
 				nitem;
 	float		res = -1.0;
-	QueryOperand **item;
-	int			size = q->size;
 
-	item = SortAndUniqItems(q, &size);
 	if (size < 2)
-	{
-		pfree(item);
-		return calc_rank_or(w, t, q);
-	}
+		return calc_rank_or(w, t, q, item, size);
 	pos = (WordEntryPosVector **) palloc0(sizeof(WordEntryPosVector *) * q->size);
 
 	/* A dummy WordEntryPos array to use when haspos is false */
@@ -276,12 +330,12 @@ calc_rank_and(const float *w, TSVector t, TSQuery q)
 		}
 	}
 	pfree(pos);
-	pfree(item);
 	return res;
 }
 
 static float
-calc_rank_or(const float *w, TSVector t, TSQuery q)
+calc_rank_or(const float *w, TSVector t, TSQuery q,
+			 QueryOperand **item, int size)
 {
 	WordEntry  *entry,
 			   *firstentry;
@@ -292,15 +346,11 @@ calc_rank_or(const float *w, TSVector t, TSQuery q)
 				i,
 				nitem;
 	float		res = 0.0;
-	QueryOperand **item;
-	int			size = q->size;
 
 	/* A dummy WordEntryPos array to use when haspos is false */
 	posnull.npos = 1;
 	posnull.pos[0] = 0;
 
-	item = SortAndUniqItems(q, &size);
-
 	for (i = 0; i < size; i++)
 	{
 		float		resj,
@@ -350,38 +400,43 @@ calc_rank_or(const float *w, TSVector t, TSQuery q)
 	}
 	if (size > 0)
 		res = res / size;
-	pfree(item);
 	return res;
 }
 
 static float
-calc_rank(const float *w, TSVector t, TSQuery q, int32 method)
+calc_rank(const float *w, TSVector t, TSQuery q, int32 method,
+		  FmgrInfo *flinfo)
 {
-	QueryItem  *item = GETQUERY(q);
+	QueryItem  *item;
+	QueryOperand **operands;
+	int			noperands;
 	float		res = 0.0;
-	int			len;
+	int			len = -1;
 
 	if (!t->size || !q->size)
 		return 0.0;
 
+	operands = get_rank_operands(flinfo, &q, &noperands);
+	item = GETQUERY(q);
+
 	/* XXX: What about NOT? */
 	res = (item->type == QI_OPR && (item->qoperator.oper == OP_AND ||
 									item->qoperator.oper == OP_PHRASE)) ?
-		calc_rank_and(w, t, q) :
-		calc_rank_or(w, t, q);
+		calc_rank_and(w, t, q, operands, noperands) :
+		calc_rank_or(w, t, q, operands, noperands);
 
 	if (res < 0)
 		res = 1e-20f;
 
+	/* the document length is needed by both length normalizations */
+	if (method & (RANK_NORM_LOGLENGTH | RANK_NORM_LENGTH))
+		len = cnt_length(t);
+
 	if ((method & RANK_NORM_LOGLENGTH) && t->size > 0)
-		res /= log((double) (cnt_length(t) + 1)) / log(2.0);
+		res /= log((double) (len + 1)) / log(2.0);
 
-	if (method & RANK_NORM_LENGTH)
-	{
-		len = cnt_length(t);
-		if (len > 0)
-			res /= (float) len;
-	}
+	if ((method & RANK_NORM_LENGTH) && len > 0)
+		res /= (float) len;
 
 	/* RANK_NORM_EXTDIST not applicable */
 
@@ -444,7 +499,7 @@ ts_rank_wttf(PG_FUNCTION_ARGS)
 	int			method = PG_GETARG_INT32(3);
 	float		res;
 
-	res = calc_rank(getWeights(win), txt, query, method);
+	res = calc_rank(getWeights(win), txt, query, method, fcinfo->flinfo);
 
 	PG_FREE_IF_COPY(win, 0);
 	PG_FREE_IF_COPY(txt, 1);
@@ -460,7 +515,8 @@ ts_rank_wtt(PG_FUNCTION_ARGS)
 	TSQuery		query = PG_GETARG_TSQUERY(2);
 	float		res;
 
-	res = calc_rank(getWeights(win), txt, query, DEF_NORM_METHOD);
+	res = calc_rank(getWeights(win), txt, query, DEF_NORM_METHOD,
+					 fcinfo->flinfo);
 
 	PG_FREE_IF_COPY(win, 0);
 	PG_FREE_IF_COPY(txt, 1);
@@ -476,7 +532,7 @@ ts_rank_ttf(PG_FUNCTION_ARGS)
 	int			method = PG_GETARG_INT32(2);
 	float		res;
 
-	res = calc_rank(getWeights(NULL), txt, query, method);
+	res = calc_rank(getWeights(NULL), txt, query, method, fcinfo->flinfo);
 
 	PG_FREE_IF_COPY(txt, 0);
 	PG_FREE_IF_COPY(query, 1);
@@ -490,7 +546,8 @@ ts_rank_tt(PG_FUNCTION_ARGS)
 	TSQuery		query = PG_GETARG_TSQUERY(1);
 	float		res;
 
-	res = calc_rank(getWeights(NULL), txt, query, DEF_NORM_METHOD);
+	res = calc_rank(getWeights(NULL), txt, query, DEF_NORM_METHOD,
+					 fcinfo->flinfo);
 
 	PG_FREE_IF_COPY(txt, 0);
 	PG_FREE_IF_COPY(query, 1);
@@ -797,6 +854,7 @@ get_docrep(TSVector txt, QueryRepresentation *qr, int *doclen)
 		DocRepresentation *rptr = doc + 1,
 				   *wptr = doc,
 					storage;
+		QueryItem **itembuf;
 
 		/*
 		 * Sort representation in ascending order by pos and entry
@@ -804,10 +862,13 @@ get_docrep(TSVector txt, QueryRepresentation *qr, int *doclen)
 		qsort((void *) doc, cur, sizeof(DocRepresentation), compareDocR);
 
 		/*
-		 * Join QueryItem per WordEntry and it's position
+		 * Join QueryItem per WordEntry and it's position.  Each entry of doc
+		 * lands in exactly one group and groups are consecutive, so all the
+		 * groups' item arrays can be carved out of a single allocation.
 		 */
+		itembuf = (QueryItem **) palloc(sizeof(QueryItem *) * cur);
 		storage.pos = doc->pos;
-		storage.data.query.items = palloc(sizeof(QueryItem *) * qr->query->size);
+		storage.data.query.items = itembuf;
 		storage.data.query.items[0] = doc->data.map.item;
 		storage.data.query.nitem = 1;
 
@@ -824,7 +885,7 @@ get_docrep(TSVector txt, QueryRepresentation *qr, int *doclen)
 				*wptr = storage;
 				wptr++;
 				storage.pos = rptr->pos;
-				storage.data.query.items = palloc(sizeof(QueryItem *) * qr->query->size);
+				storage.data.query.items += storage.data.query.nitem;
 				storage.data.query.items[0] = rptr->data.map.item;
 				storage.data.query.nitem = 1;
 			}
@@ -74,6 +74,17 @@ typedef struct
 	hyperLogLogState full_card; /* Full key cardinality state */
 	double		prop_card;		/* Required cardinality proportion */
 	pg_locale_t locale;
+#ifdef USE_ICU
+	/* buf1 and buf2 converted to UChars, for ICU without UTF8 */
+	UChar	   *ubuf1;
+	UChar	   *ubuf2;
+	int32_t		ubuflen1;
+	int32_t		ubuflen2;
+	int32_t		ulen1;			/* Length of ubuf1 UChar string, or -1 if
+								 * buf1 has not been converted */
+	int32_t		ulen2;			/* Length of ubuf2 UChar string, or -1 if
+								 * buf2 has not been converted */
+#endif
 } VarStringSortSupport;
 
 /*
@@ -97,7 +108,6 @@ static int	namefastcmp_c(Datum x, Datum y, SortSupport ssup);
 static int	varlenafastcmp_locale(Datum x, Datum y, SortSupport ssup);
 static int	namefastcmp_locale(Datum x, Datum y, SortSupport ssup);
 static int	varstrfastcmp_locale(char *a1p, int len1, char *a2p, int len2, SortSupport ssup);
-static int	varstrcmp_abbrev(Datum x, Datum y, SortSupport ssup);
 static Datum varstr_abbrev_convert(Datum original, SortSupport ssup);
 static bool varstr_abbrev_abort(int memtupcount, SortSupport ssup);
 static int32 text_length(Datum str);
@@ -1966,6 +1976,19 @@ varstr_sortsupport(SortSupport ssup, Oid typeid, Oid collid)
 		/* Initialize */
 		sss->last_returned = 0;
 		sss->locale = locale;
+#ifdef USE_ICU
+		sss->ubuf1 = NULL;
+		sss->ubuf2 = NULL;
+		sss->ulen1 = -1;
+		sss->ulen2 = -1;
+		if (locale && locale->provider == COLLPROVIDER_ICU)
+		{
+			sss->ubuf1 = palloc(TEXTBUFLEN * sizeof(UChar));
+			sss->ubuflen1 = TEXTBUFLEN;
+			sss->ubuf2 = palloc(TEXTBUFLEN * sizeof(UChar));
+			sss->ubuflen2 = TEXTBUFLEN;
+		}
+#endif
 
 		/*
 		 * To avoid somehow confusing a strxfrm() blob and an original string,
@@ -1990,6 +2013,13 @@ varstr_sortsupport(SortSupport ssup, Oid typeid, Oid collid)
 		 * If possible, plan to use the abbreviated keys optimization.  The
 		 * core code may switch back to authoritative comparator should
 		 * abbreviation be aborted.
+		 *
+		 * Abbreviated keys compare as unsigned integers.  When they're equal,
+		 * the core system calls varstrfastcmp_c() (bpcharfastcmp_c() in
+		 * BpChar case) or varlenafastcmp_locale().  Even a strcmp() on two
+		 * non-truncated strxfrm() blobs cannot indicate *equality*
+		 * authoritatively, for the same reason that there is a strcoll()
+		 * tie-breaker call to strcmp() in varstr_cmp().
 		 */
 		if (abbreviate)
 		{
@@ -1997,7 +2027,7 @@ varstr_sortsupport(SortSupport ssup, Oid typeid, Oid collid)
 			initHyperLogLog(&sss->abbr_card, 10);
 			initHyperLogLog(&sss->full_card, 10);
 			ssup->abbrev_full_comparator = ssup->comparator;
-			ssup->comparator = varstrcmp_abbrev;
+			ssup->comparator = ssup_datum_unsigned_cmp;
 			ssup->abbrev_converter = varstr_abbrev_convert;
 			ssup->abbrev_abort = varstr_abbrev_abort;
 		}
@@ -2197,6 +2227,9 @@ varstrfastcmp_locale(char *a1p, int len1, char *a2p, int len2, SortSupport ssup)
 		memcpy(sss->buf1, a1p, len1);
 		sss->buf1[len1] = '\0';
 		sss->last_len1 = len1;
+#ifdef USE_ICU
+		sss->ulen1 = -1;
+#endif
 	}
 
 	/*
@@ -2210,6 +2243,9 @@ varstrfastcmp_locale(char *a1p, int len1, char *a2p, int len2, SortSupport ssup)
 		memcpy(sss->buf2, a2p, len2);
 		sss->buf2[len2] = '\0';
 		sss->last_len2 = len2;
+#ifdef USE_ICU
+		sss->ulen2 = -1;
+#endif
 	}
 	else if (arg1_match && !sss->cache_blob)
 	{
@@ -2239,20 +2275,26 @@ varstrfastcmp_locale(char *a1p, int len1, char *a2p, int len2, SortSupport ssup)
 			else
 #endif
 			{
-				int32_t		ulen1,
-							ulen2;
-				UChar	   *uchar1,
-						   *uchar2;
-
-				ulen1 = icu_to_uchar(&uchar1, a1p, len1);
-				ulen2 = icu_to_uchar(&uchar2, a2p, len2);
+				/*
+				 * Convert the strings to UChars, unless we still have the
+				 * conversion of an unchanged buffer from an earlier call.
+				 * As for strcoll() caching above, that saves work when the
+				 * same string is compared against many others.  The
+				 * conversions have to be invalidated whenever buf1 or buf2
+				 * are overwritten, including by varstr_abbrev_convert().
+				 */
+				if (sss->ulen1 < 0)
+					sss->ulen1 = icu_to_uchar_buf(&sss->ubuf1,
+												  &sss->ubuflen1,
+												  sss->buf1, len1);
+				if (sss->ulen2 < 0)
+					sss->ulen2 = icu_to_uchar_buf(&sss->ubuf2,
+												  &sss->ubuflen2,
+												  sss->buf2, len2);
 
 				result = ucol_strcoll(sss->locale->info.icu.ucol,
-									  uchar1, ulen1,
-									  uchar2, ulen2);
-
-				pfree(uchar1);
-				pfree(uchar2);
+									  sss->ubuf1, sss->ulen1,
+									  sss->ubuf2, sss->ulen2);
 			}
 #else							/* not USE_ICU */
 			/* shouldn't happen */
@@ -2286,27 +2328,6 @@ varstrfastcmp_locale(char *a1p, int len1, char *a2p, int len2, SortSupport ssup)
 	return result;
 }
 
-/*
- * Abbreviated key comparison func
- */
-static int
-varstrcmp_abbrev(Datum x, Datum y, SortSupport ssup)
-{
-	/*
-	 * When 0 is returned, the core system will call varstrfastcmp_c()
-	 * (bpcharfastcmp_c() in BpChar case) or varlenafastcmp_locale().  Even a
-	 * strcmp() on two non-truncated strxfrm() blobs cannot indicate *equality*
-	 * authoritatively, for the same reason that there is a strcoll()
-	 * tie-breaker call to strcmp() in varstr_cmp().
-	 */
-	if (x > y)
-		return 1;
-	else if (x == y)
-		return 0;
-	else
-		return -1;
-}
-
 /*
  * Conversion routine for sortsupport.  Converts original to abbreviated key
  * representation.  Our encoding strategy is simple -- pack the first 8 bytes
@@ -2345,9 +2366,9 @@ varstr_abbrev_convert(Datum original, SortSupport ssup)
 	 * strings may contain NUL bytes.  Besides, this should be faster, too.
 	 *
 	 * More generally, it's okay that bytea callers can have NUL bytes in
-	 * strings because varstrcmp_abbrev() need not make a distinction between
-	 * terminating NUL bytes, and NUL bytes representing actual NULs in the
-	 * authoritative representation.  Hopefully a comparison at or past one
+	 * strings because ssup_datum_unsigned_cmp() need not make a distinction
+	 * between terminating NUL bytes, and NUL bytes representing actual NULs
+	 * in the authoritative representation.  Hopefully a comparison at or past one
 	 * abbreviated key's terminating NUL byte will resolve the comparison
 	 * without consulting the authoritative representation; specifically, some
 	 * later non-NUL byte in the longer string can resolve the comparison
@@ -2368,10 +2389,6 @@ varstr_abbrev_convert(Datum original, SortSupport ssup)
 	else
 	{
 		Size		bsize;
-#ifdef USE_ICU
-		int32_t		ulen = -1;
-		UChar	   *uchar = NULL;
-#endif
 
 		/*
 		 * We're not using the C collation, so fall back on strxfrm or ICU
@@ -2405,10 +2422,16 @@ varstr_abbrev_convert(Datum original, SortSupport ssup)
 		sss->last_len1 = len;
 
 #ifdef USE_ICU
-		/* When using ICU and not UTF8, convert string to UChar. */
+		/*
+		 * When using ICU and not UTF8, convert string to UChar.  The blob
+		 * will overwrite buf2, so its conversion is no longer valid.
+		 */
+		sss->ulen1 = -1;
+		sss->ulen2 = -1;
 		if (sss->locale && sss->locale->provider == COLLPROVIDER_ICU &&
 			GetDatabaseEncoding() != PG_UTF8)
-			ulen = icu_to_uchar(&uchar, sss->buf1, len);
+			sss->ulen1 = icu_to_uchar_buf(&sss->ubuf1, &sss->ubuflen1,
+										  sss->buf1, len);
 #endif
 
 		/*
@@ -2450,7 +2473,7 @@ varstr_abbrev_convert(Datum original, SortSupport ssup)
 				}
 				else
 					bsize = ucol_getSortKey(sss->locale->info.icu.ucol,
-											uchar, ulen,
+											sss->ubuf1, sss->ulen1,
 											(uint8_t *) sss->buf2, sss->buflen2);
 			}
 			else
@@ -2486,11 +2509,6 @@ varstr_abbrev_convert(Datum original, SortSupport ssup)
 		 * okay.  See remarks on bytea case above.)
 		 */
 		memcpy(pres, sss->buf2, Min(sizeof(Datum), bsize));
-
-#ifdef USE_ICU
-		if (uchar)
-			pfree(uchar);
-#endif
 	}
 
 	/*
@@ -2535,7 +2553,7 @@ done:
 	/*
 	 * Byteswap on little-endian machines.
 	 *
-	 * This is needed so that varstrcmp_abbrev() (an unsigned integer 3-way
+	 * This is needed so that ssup_datum_unsigned_cmp() (an unsigned integer 3-way
 	 * comparator) works correctly on all platforms.  If we didn't do this,
 	 * the comparator would have to call memcmp() with a pair of pointers to
 	 * the first byte of each abbreviated key, which is slower.
@@ -4966,6 +4984,46 @@ pg_column_size(PG_FUNCTION_ARGS)
 	PG_RETURN_INT32(result);
 }
 
+/*
+ * Return the compression method of a datum, or NULL if it isn't compressed
+ *
+ * Works on any data type
+ */
+Datum
+pg_column_compression(PG_FUNCTION_ARGS)
+{
+	int			typlen;
+	int			cmethod;
+
+	/* On first call, get the input type's typlen, and save at *fn_extra */
+	if (fcinfo->flinfo->fn_extra == NULL)
+	{
+		/* Lookup the datatype of the supplied argument */
+		Oid			argtypeid = get_fn_expr_argtype(fcinfo->flinfo, 0);
+
+		typlen = get_typlen(argtypeid);
+		if (typlen == 0)		/* should not happen */
+			elog(ERROR, "cache lookup failed for type %u", argtypeid);
+
+		fcinfo->flinfo->fn_extra = MemoryContextAlloc(fcinfo->flinfo->fn_mcxt,
+													  sizeof(int));
+		*((int *) fcinfo->flinfo->fn_extra) = typlen;
+	}
+	else
+		typlen = *((int *) fcinfo->flinfo->fn_extra);
+
+	/* only varlena types can be compressed */
+	if (typlen != -1)
+		PG_RETURN_NULL();
+
+	cmethod = toast_get_compression_id((struct varlena *)
+									   DatumGetPointer(PG_GETARG_DATUM(0)));
+	if (cmethod == TOAST_INVALID_COMPRESSION_ID)
+		PG_RETURN_NULL();
+
+	PG_RETURN_TEXT_P(cstring_to_text(toast_compression_method_name(cmethod)));
+}
+
 /*
  * string_agg - Concatenates values and returns string.
  *
@@ -25,6 +25,7 @@
 #include "catalog/pg_collation.h"
 #include "catalog/pg_operator.h"
 #include "catalog/pg_type.h"
+#include "funcapi.h"
 #include "miscadmin.h"
 #ifdef CATCACHE_STATS
 #include "storage/ipc.h"		/* for on_proc_exit */
@@ -75,6 +76,9 @@
 /* Cache management header --- pointer is NULL until created */
 static CatCacheHeader *CacheHdr = NULL;
 
+/* GUC variable: memory limit for all catcache entries, in kB (0 = none) */
+int			catalog_cache_memory = 0;
+
 static inline HeapTuple SearchCatCacheInternal(CatCache *cache,
 					   int nkeys,
 					   Datum v1, Datum v2,
@@ -100,6 +104,7 @@ static void CatCachePrintStats(int code, Datum arg);
 #endif
 static void CatCacheRemoveCTup(CatCache *cache, CatCTup *ct);
 static void CatCacheRemoveCList(CatCache *cache, CatCList *cl);
+static void CatCacheEvict(void);
 static void CatalogCacheInitializeCache(CatCache *cache);
 static CatCTup *CatalogCacheCreateEntry(CatCache *cache, HeapTuple ntp,
 						Datum *arguments,
@@ -480,8 +485,9 @@ CatCacheRemoveCTup(CatCache *cache, CatCTup *ct)
 		return;					/* nothing left to do */
 	}
 
-	/* delink from linked list */
+	/* delink from linked lists */
 	dlist_delete(&ct->cache_elem);
+	dlist_delete(&ct->lru_elem);
 
 	/*
 	 * Free keys when we're dealing with a negative entry, normal entries just
@@ -491,6 +497,9 @@ CatCacheRemoveCTup(CatCache *cache, CatCTup *ct)
 		CatCacheFreeKeys(cache->cc_tupdesc, cache->cc_nkeys,
 						 cache->cc_keyno, ct->keys);
 
+	cache->cc_memory -= GetMemoryChunkSpace(ct);
+	CacheHdr->ch_memory -= GetMemoryChunkSpace(ct);
+
 	pfree(ct);
 
 	--cache->cc_ntup;
@@ -535,9 +544,57 @@ CatCacheRemoveCList(CatCache *cache, CatCList *cl)
 	CatCacheFreeKeys(cache->cc_tupdesc, cl->nkeys,
 					 cache->cc_keyno, cl->keys);
 
+	cache->cc_memory -= GetMemoryChunkSpace(cl);
+	CacheHdr->ch_memory -= GetMemoryChunkSpace(cl);
+
 	pfree(cl);
 }
 
+/*
+ *		CatCacheEvict
+ *
+ * Remove unreferenced entries, least recently used first, until the memory
+ * used by all catcaches is within catalog_cache_memory.
+ *
+ * Entries in use, and entries that belong to a list in use, are skipped.
+ * Evicting a member of an unreferenced list deletes the list as well; that
+ * is no different from what invalidating the entry would do.
+ */
+static void
+CatCacheEvict(void)
+{
+	Size		limit = (Size) catalog_cache_memory * 1024;
+	dlist_node *cur;
+
+	cur = CacheHdr->ch_lru.head.prev;
+	while (CacheHdr->ch_memory > limit && cur != &CacheHdr->ch_lru.head)
+	{
+		CatCTup    *ct = dlist_container(CatCTup, lru_elem, cur);
+		CatCache   *cache = ct->my_cache;
+
+		cur = cur->prev;
+
+		if (ct->refcount > 0 ||
+			(ct->c_list && ct->c_list->refcount > 0))
+			continue;
+
+		cache->cc_evictions++;
+
+		if (ct->c_list)
+		{
+			/*
+			 * Removing the list can remove other dead members along with
+			 * it, possibly including the next entry we'd look at, so start
+			 * over from the tail.
+			 */
+			CatCacheRemoveCTup(cache, ct);
+			cur = CacheHdr->ch_lru.head.prev;
+		}
+		else
+			CatCacheRemoveCTup(cache, ct);
+	}
+}
+
 
 /*
  *	CatCacheInvalidate
@@ -604,9 +661,7 @@ CatCacheInvalidate(CatCache *cache, uint32 hashValue)
 			else
 				CatCacheRemoveCTup(cache, ct);
 			CACHE1_elog(DEBUG2, "CatCacheInvalidate: invalidated");
-#ifdef CATCACHE_STATS
 			cache->cc_invals++;
-#endif
 			/* could be multiple matches, so keep looking! */
 		}
 	}
@@ -682,9 +737,7 @@ ResetCatalogCache(CatCache *cache)
 			}
 			else
 				CatCacheRemoveCTup(cache, ct);
-#ifdef CATCACHE_STATS
 			cache->cc_invals++;
-#endif
 		}
 	}
 }
@@ -810,7 +863,9 @@ InitCatCache(int id,
 	{
 		CacheHdr = (CatCacheHeader *) palloc(sizeof(CatCacheHeader));
 		slist_init(&CacheHdr->ch_caches);
+		dlist_init(&CacheHdr->ch_lru);
 		CacheHdr->ch_ntup = 0;
+		CacheHdr->ch_memory = 0;
 #ifdef CATCACHE_STATS
 		/* set up to dump stats at backend exit */
 		on_proc_exit(CatCachePrintStats, 0);
@@ -1231,9 +1286,7 @@ SearchCatCacheInternal(CatCache *cache,
 	if (unlikely(cache->cc_tupdesc == NULL))
 		CatalogCacheInitializeCache(cache);
 
-#ifdef CATCACHE_STATS
 	cache->cc_searches++;
-#endif
 
 	/* Initialize local parameter array */
 	arguments[0] = v1;
@@ -1274,6 +1327,7 @@ SearchCatCacheInternal(CatCache *cache,
 		 * near the front of the hashbucket's list.)
 		 */
 		dlist_move_head(bucket, &ct->cache_elem);
+		dlist_move_head(&CacheHdr->ch_lru, &ct->lru_elem);
 
 		/*
 		 * If it's a positive entry, bump its refcount and return it. If it's
@@ -1288,9 +1342,7 @@ SearchCatCacheInternal(CatCache *cache,
 			CACHE3_elog(DEBUG2, "SearchCatCache(%s): found in bucket %d",
 						cache->cc_relname, hashIndex);
 
-#ifdef CATCACHE_STATS
 			cache->cc_hits++;
-#endif
 
 			return &ct->tuple;
 		}
@@ -1299,9 +1351,7 @@ SearchCatCacheInternal(CatCache *cache,
 			CACHE3_elog(DEBUG2, "SearchCatCache(%s): found neg entry in bucket %d",
 						cache->cc_relname, hashIndex);
 
-#ifdef CATCACHE_STATS
 			cache->cc_neg_hits++;
-#endif
 
 			return NULL;
 		}
@@ -1429,9 +1479,7 @@ SearchCatCacheMiss(CatCache *cache,
 	CACHE3_elog(DEBUG2, "SearchCatCache(%s): put in bucket %d",
 				cache->cc_relname, hashIndex);
 
-#ifdef CATCACHE_STATS
 	cache->cc_newloads++;
-#endif
 
 	return &ct->tuple;
 }
@@ -1542,9 +1590,7 @@ SearchCatCacheList(CatCache *cache,
 
 	Assert(nkeys > 0 && nkeys < cache->cc_nkeys);
 
-#ifdef CATCACHE_STATS
 	cache->cc_lsearches++;
-#endif
 
 	/* Initialize local parameter array */
 	arguments[0] = v1;
@@ -1593,6 +1639,13 @@ SearchCatCacheList(CatCache *cache,
 		 */
 		dlist_move_head(&cache->cc_lists, &cl->cache_elem);
 
+		/*
+		 * The members are evicted along with the list, so keep them from
+		 * falling to the end of the LRU list while the list is in use.
+		 */
+		for (i = 0; i < cl->n_members; i++)
+			dlist_move_head(&CacheHdr->ch_lru, &cl->members[i]->lru_elem);
+
 		/* Bump the list's refcount and return it */
 		ResourceOwnerEnlargeCatCacheListRefs(CurrentResourceOwner);
 		cl->refcount++;
@@ -1601,9 +1654,7 @@ SearchCatCacheList(CatCache *cache,
 		CACHE2_elog(DEBUG2, "SearchCatCacheList(%s): found list",
 					cache->cc_relname);
 
-#ifdef CATCACHE_STATS
 		cache->cc_lhits++;
-#endif
 
 		return cl;
 	}
@@ -1712,6 +1763,8 @@ SearchCatCacheList(CatCache *cache,
 		nmembers = list_length(ctlist);
 		cl = (CatCList *)
 			palloc(offsetof(CatCList, members) + nmembers * sizeof(CatCTup *));
+		cache->cc_memory += GetMemoryChunkSpace(cl);
+		CacheHdr->ch_memory += GetMemoryChunkSpace(cl);
 
 		/* Extract key values */
 		CatCacheCopyKeys(cache->cc_tupdesc, nkeys, cache->cc_keyno,
@@ -1821,6 +1874,15 @@ CatalogCacheCreateEntry(CatCache *cache, HeapTuple ntp, Datum *arguments,
 	HeapTuple	dtp;
 	MemoryContext oldcxt;
 
+	/*
+	 * Make room for the new entry, if we're over the memory limit.  Do it
+	 * first, so that the new entry, which has no references yet, is not a
+	 * candidate itself.
+	 */
+	if (catalog_cache_memory > 0 &&
+		CacheHdr->ch_memory > (Size) catalog_cache_memory * 1024)
+		CatCacheEvict();
+
 	/* negative entries have no tuple associated */
 	if (ntp)
 	{
@@ -1901,9 +1963,12 @@ CatalogCacheCreateEntry(CatCache *cache, HeapTuple ntp, Datum *arguments,
 	ct->hash_value = hashValue;
 
 	dlist_push_head(&cache->cc_bucket[hashIndex], &ct->cache_elem);
+	dlist_push_head(&CacheHdr->ch_lru, &ct->lru_elem);
 
 	cache->cc_ntup++;
 	CacheHdr->ch_ntup++;
+	cache->cc_memory += GetMemoryChunkSpace(ct);
+	CacheHdr->ch_memory += GetMemoryChunkSpace(ct);
 
 	/*
 	 * If the hash table has become too full, enlarge the buckets array. Quite
@@ -2101,3 +2166,78 @@ PrintCatCacheListLeakWarning(CatCList *list)
 		 list->my_cache->cc_relname, list->my_cache->id,
 		 list, list->refcount);
 }
+
+
+/*
+ * SQL-callable function to report the contents and activity of this
+ * backend's catalog caches
+ */
+Datum
+pg_catalog_cache_stats(PG_FUNCTION_ARGS)
+{
+#define PG_CATALOG_CACHE_STATS_COLS 13
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+	slist_iter	iter;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not " \
+						"allowed in this context")));
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	if (CacheHdr != NULL)
+	{
+		slist_foreach(iter, &CacheHdr->ch_caches)
+		{
+			CatCache   *cache = slist_container(CatCache, cc_next, iter.cur);
+			Datum		values[PG_CATALOG_CACHE_STATS_COLS];
+			bool		nulls[PG_CATALOG_CACHE_STATS_COLS];
+
+			MemSet(nulls, 0, sizeof(nulls));
+
+			values[0] = Int32GetDatum(cache->id);
+			values[1] = ObjectIdGetDatum(cache->cc_reloid);
+			values[2] = ObjectIdGetDatum(cache->cc_indexoid);
+			values[3] = Int32GetDatum(cache->cc_ntup);
+			values[4] = Int64GetDatum((int64) cache->cc_memory);
+			values[5] = Int64GetDatum(cache->cc_searches);
+			values[6] = Int64GetDatum(cache->cc_hits);
+			values[7] = Int64GetDatum(cache->cc_neg_hits);
+			values[8] = Int64GetDatum(cache->cc_newloads);
+			values[9] = Int64GetDatum(cache->cc_invals);
+			values[10] = Int64GetDatum(cache->cc_evictions);
+			values[11] = Int64GetDatum(cache->cc_lsearches);
+			values[12] = Int64GetDatum(cache->cc_lhits);
+
+			tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+		}
+	}
+
+	/* clean up and return the tuplestore */
+	tuplestore_donestoring(tupstore);
+
+	return (Datum) 0;
+}
@@ -9,7 +9,9 @@
  * changes in the objects they depend on.
  *
  * The logic for choosing generic or custom plans is in choose_custom_plan,
- * which see for comments.
+ * which see for comments.  If plan_cache_runtime_feedback is on, callers
+ * that execute the plans report how long that took, and the choice is then
+ * based on the measurements rather than on the estimated costs.
  *
  * Cache invalidation is driven off sinval events.  Any CachedPlanSource
  * that matches the event is marked invalid, as is its generic CachedPlan
@@ -58,6 +60,7 @@
 
 #include "access/transam.h"
 #include "catalog/namespace.h"
+#include "executor/execPartition.h"
 #include "executor/executor.h"
 #include "miscadmin.h"
 #include "nodes/nodeFuncs.h"
@@ -67,6 +70,7 @@
 #include "optimizer/prep.h"
 #include "parser/analyze.h"
 #include "parser/parsetree.h"
+#include "portability/instr_time.h"
 #include "storage/lmgr.h"
 #include "tcop/pquery.h"
 #include "tcop/utility.h"
@@ -86,6 +90,17 @@
 	((plansource)->raw_parse_tree && \
 	 IsA((plansource)->raw_parse_tree->stmt, TransactionStmt))
 
+/*
+ * With plan_cache_runtime_feedback, the measured run times of generic and
+ * custom plans are compared once each kind has been run this many times.
+ * Run times are averaged over the last PLAN_FEEDBACK_WINDOW runs or so, and
+ * every PLAN_FEEDBACK_PROBE_INTERVAL'th run uses the kind of plan that is
+ * currently the slower one, so that we notice if it's become faster.
+ */
+#define PLAN_FEEDBACK_MIN_RUNS			5
+#define PLAN_FEEDBACK_WINDOW			16
+#define PLAN_FEEDBACK_PROBE_INTERVAL	32
+
 /*
  * This is the head of the backend's list of "saved" CachedPlanSources (i.e.,
  * those that are in long-lived storage and are examined for sinval events).
@@ -102,7 +117,8 @@ static dlist_head cached_expression_list = DLIST_STATIC_INIT(cached_expression_l
 static void ReleaseGenericPlan(CachedPlanSource *plansource);
 static List *RevalidateCachedQuery(CachedPlanSource *plansource,
 					  QueryEnvironment *queryEnv);
-static bool CheckCachedPlan(CachedPlanSource *plansource);
+static bool CheckCachedPlan(CachedPlanSource *plansource,
+				ParamListInfo boundParams);
 static CachedPlan *BuildCachedPlan(CachedPlanSource *plansource, List *qlist,
 				ParamListInfo boundParams, QueryEnvironment *queryEnv);
 static bool choose_custom_plan(CachedPlanSource *plansource,
@@ -110,6 +126,8 @@ static bool choose_custom_plan(CachedPlanSource *plansource,
 static double cached_plan_cost(CachedPlan *plan, bool include_planner);
 static Query *QueryListGetPrimaryStmt(List *stmts);
 static void AcquireExecutorLocks(List *stmt_list, bool acquire);
+static List *GetPartitionsToLock(List *stmt_list, ParamListInfo boundParams);
+static void AcquirePartitionLocks(List *partitions, bool acquire);
 static void AcquirePlannerLocks(List *stmt_list, bool acquire);
 static void ScanQueryForLocks(Query *parsetree, bool acquire);
 static bool ScanQueryWalker(Node *node, bool *acquire);
@@ -118,8 +136,9 @@ static void PlanCacheRelCallback(Datum arg, Oid relid);
 static void PlanCacheObjectCallback(Datum arg, int cacheid, uint32 hashvalue);
 static void PlanCacheSysCallback(Datum arg, int cacheid, uint32 hashvalue);
 
-/* GUC parameter */
+/* GUC parameters */
 int			plan_cache_mode;
+bool		plan_cache_runtime_feedback = false;
 
 /*
  * InitPlanCache: initialize module during InitPostgres.
@@ -222,6 +241,10 @@ CreateCachedPlan(RawStmt *raw_parse_tree,
 	plansource->generic_cost = -1;
 	plansource->total_custom_cost = 0;
 	plansource->num_custom_plans = 0;
+	plansource->generic_time = 0;
+	plansource->custom_time = 0;
+	plansource->num_generic_runs = 0;
+	plansource->num_custom_runs = 0;
 
 	MemoryContextSwitchTo(oldcxt);
 
@@ -289,6 +312,10 @@ CreateOneShotCachedPlan(RawStmt *raw_parse_tree,
 	plansource->generic_cost = -1;
 	plansource->total_custom_cost = 0;
 	plansource->num_custom_plans = 0;
+	plansource->generic_time = 0;
+	plansource->custom_time = 0;
+	plansource->num_generic_runs = 0;
+	plansource->num_custom_runs = 0;
 
 	return plansource;
 }
@@ -791,9 +818,11 @@ RevalidateCachedQuery(CachedPlanSource *plansource,
  *
  * On a "true" return, we have acquired the locks needed to run the plan.
  * (We must do this for the "true" result to be race-condition-free.)
+ * boundParams are the Params the plan will be run with; they let us skip
+ * locking the partitions that the executor will prune at startup anyway.
  */
 static bool
-CheckCachedPlan(CachedPlanSource *plansource)
+CheckCachedPlan(CachedPlanSource *plansource, ParamListInfo boundParams)
 {
 	CachedPlan *plan = plansource->gplan;
 
@@ -844,8 +873,26 @@ CheckCachedPlan(CachedPlanSource *plansource)
 		 */
 		if (plan->is_valid)
 		{
-			/* Successfully revalidated and locked the query. */
-			return true;
+			List	   *partitions;
+
+			/*
+			 * Now that we know that the partitioned tables are what the plan
+			 * expects, find out which of their prunable partitions survive
+			 * initial pruning, and lock those too.  That can process more
+			 * invalidations, so check again.
+			 */
+			partitions = GetPartitionsToLock(plan->stmt_list, boundParams);
+			AcquirePartitionLocks(partitions, true);
+
+			if (plan->is_valid)
+			{
+				/* Successfully revalidated and locked the query. */
+				list_free(partitions);
+				return true;
+			}
+
+			AcquirePartitionLocks(partitions, false);
+			list_free(partitions);
 		}
 
 		/* Oops, the race case happened.  Release useless locks. */
@@ -1002,6 +1049,9 @@ BuildCachedPlan(CachedPlanSource *plansource, List *qlist,
 	plan->is_saved = false;
 	plan->is_valid = true;
 
+	plan->is_generic = false;
+	plan->planning_time = 0;
+
 	/* assign generation number to new plan */
 	plan->generation = ++(plansource->generation);
 
@@ -1043,6 +1093,28 @@ choose_custom_plan(CachedPlanSource *plansource, ParamListInfo boundParams)
 	if (plansource->cursor_options & CURSOR_OPT_CUSTOM_PLAN)
 		return true;
 
+	/*
+	 * If we've timed enough runs of both the current generic plan and custom
+	 * plans, go with whichever has been faster, except that now and then we
+	 * try the other one again.  Custom plans need not be the same plan every
+	 * time, so if the parameter values are skewed, their average is just
+	 * that; it's what we'd get by always using custom plans, though.
+	 */
+	if (plan_cache_runtime_feedback &&
+		plansource->num_generic_runs >= PLAN_FEEDBACK_MIN_RUNS &&
+		plansource->num_custom_runs >= PLAN_FEEDBACK_MIN_RUNS)
+	{
+		bool		prefer_custom;
+		int64		nruns;
+
+		prefer_custom = plansource->custom_time < plansource->generic_time;
+		nruns = (int64) plansource->num_generic_runs +
+			plansource->num_custom_runs;
+		if (nruns % PLAN_FEEDBACK_PROBE_INTERVAL == 0)
+			return !prefer_custom;
+		return prefer_custom;
+	}
+
 	/* Generate custom plans until we have done at least 5 (arbitrary) */
 	if (plansource->num_custom_plans < 5)
 		return true;
@@ -1160,7 +1232,7 @@ GetCachedPlan(CachedPlanSource *plansource, ParamListInfo boundParams,
 
 	if (!customplan)
 	{
-		if (CheckCachedPlan(plansource))
+		if (CheckCachedPlan(plansource, boundParams))
 		{
 			/* We want a generic plan, and we already have a valid one */
 			plan = plansource->gplan;
@@ -1174,6 +1246,7 @@ GetCachedPlan(CachedPlanSource *plansource, ParamListInfo boundParams,
 			ReleaseGenericPlan(plansource);
 			/* Link the new generic plan into the plansource */
 			plansource->gplan = plan;
+			plan->is_generic = true;
 			plan->refcount++;
 			/* Immediately reparent into appropriate context */
 			if (plansource->is_saved)
@@ -1190,6 +1263,9 @@ GetCachedPlan(CachedPlanSource *plansource, ParamListInfo boundParams,
 			}
 			/* Update generic_cost whenever we make a new generic plan */
 			plansource->generic_cost = cached_plan_cost(plan, false);
+			/* ... and forget how the last one performed */
+			plansource->generic_time = 0;
+			plansource->num_generic_runs = 0;
 
 			/*
 			 * If, based on the now-known value of generic_cost, we'd not have
@@ -1213,8 +1289,23 @@ GetCachedPlan(CachedPlanSource *plansource, ParamListInfo boundParams,
 
 	if (customplan)
 	{
+		instr_time	starttime;
+
+		if (plan_cache_runtime_feedback)
+			INSTR_TIME_SET_CURRENT(starttime);
+
 		/* Build a custom plan */
 		plan = BuildCachedPlan(plansource, qlist, boundParams, queryEnv);
+
+		/* Custom plans are charged for the time spent planning them */
+		if (plan_cache_runtime_feedback)
+		{
+			instr_time	endtime;
+
+			INSTR_TIME_SET_CURRENT(endtime);
+			INSTR_TIME_SUBTRACT(endtime, starttime);
+			plan->planning_time = INSTR_TIME_GET_MILLISEC(endtime);
+		}
 		/* Accumulate total costs of custom plans, but 'ware overflow */
 		if (plansource->num_custom_plans < INT_MAX)
 		{
@@ -1280,6 +1371,43 @@ ReleaseCachedPlan(CachedPlan *plan, bool useResOwner)
 	}
 }
 
+/*
+ * CachedPlanRecordRuntime: report the run time of a cached plan
+ *
+ * If plan_cache_runtime_feedback is on, callers that obtained a plan with
+ * GetCachedPlan() and ran it to completion should report how long that took,
+ * in milliseconds, before releasing the plan.  The times are used by
+ * choose_custom_plan().  Runs of a generic plan that has since been replaced
+ * are ignored.
+ */
+void
+CachedPlanRecordRuntime(CachedPlanSource *plansource, CachedPlan *plan,
+						double msecs)
+{
+	Assert(plansource->magic == CACHEDPLANSOURCE_MAGIC);
+	Assert(plan->magic == CACHEDPLAN_MAGIC);
+
+	if (plan->is_generic)
+	{
+		if (plan != plansource->gplan)
+			return;
+		if (plansource->num_generic_runs < INT_MAX)
+			plansource->num_generic_runs++;
+		plansource->generic_time +=
+			(msecs - plansource->generic_time) /
+			Min(plansource->num_generic_runs, PLAN_FEEDBACK_WINDOW);
+	}
+	else
+	{
+		msecs += plan->planning_time;
+		if (plansource->num_custom_runs < INT_MAX)
+			plansource->num_custom_runs++;
+		plansource->custom_time +=
+			(msecs - plansource->custom_time) /
+			Min(plansource->num_custom_runs, PLAN_FEEDBACK_WINDOW);
+	}
+}
+
 /*
  * CachedPlanSetParentContext: move a CachedPlanSource to a new memory context
  *
@@ -1400,6 +1528,10 @@ CopyCachedPlan(CachedPlanSource *plansource)
 	newsource->generic_cost = plansource->generic_cost;
 	newsource->total_custom_cost = plansource->total_custom_cost;
 	newsource->num_custom_plans = plansource->num_custom_plans;
+	newsource->generic_time = plansource->generic_time;
+	newsource->custom_time = plansource->custom_time;
+	newsource->num_generic_runs = plansource->num_generic_runs;
+	newsource->num_custom_runs = plansource->num_custom_runs;
 
 	MemoryContextSwitchTo(oldcxt);
 
@@ -1421,6 +1553,182 @@ CachedPlanIsValid(CachedPlanSource *plansource)
 	return plansource->is_valid;
 }
 
+/*
+ * CachedPlanAllowsSimpleValidityCheck: can we use CachedPlanIsSimplyValid?
+ *
+ * This function, together with CachedPlanIsSimplyValid, provides a fast path
+ * for revalidating "simple" generic plans.  The core requirement to be simple
+ * is that the plan must not require taking any locks, which translates to
+ * not touching any tables; this happens to match up well with an important
+ * use-case in PL/pgSQL.  This function tests whether that's true, along
+ * with checking some other corner cases that we'd rather not bother with
+ * handling in the fast path.  (Note that it's still possible for such a plan
+ * to be invalidated, for example due to a change in a function that was
+ * inlined into the plan.)
+ *
+ * If the plan is simply valid, and "owner" is not NULL, record a refcount on
+ * the plan in that resowner before returning.  It is caller's responsibility
+ * to be sure that a refcount is held on any plan that's being actively used.
+ *
+ * This must only be called on known-valid generic plans (eg, ones just
+ * returned by GetCachedPlan).  If it returns true, the caller may re-use
+ * the cached plan as long as CachedPlanIsSimplyValid returns true; that
+ * check is much cheaper than the full revalidation done by GetCachedPlan.
+ */
+bool
+CachedPlanAllowsSimpleValidityCheck(CachedPlanSource *plansource,
+									CachedPlan *plan, ResourceOwner owner)
+{
+	ListCell   *lc;
+
+	/*
+	 * Sanity-check that the caller gave us a validated generic plan.  Notice
+	 * that we *don't* assert plansource->is_valid as you might expect; that's
+	 * because it's possible that that's already false when GetCachedPlan
+	 * returns, e.g. because ResetPlanCache happened partway through.  We
+	 * should accept the plan as long as plan->is_valid is true, and expect to
+	 * replan after the next CachedPlanIsSimplyValid call.
+	 */
+	Assert(plansource->magic == CACHEDPLANSOURCE_MAGIC);
+	Assert(plan->magic == CACHEDPLAN_MAGIC);
+	Assert(plan->is_valid);
+	Assert(plan == plansource->gplan);
+	Assert(plansource->search_path != NULL);
+	Assert(OverrideSearchPathMatchesCurrent(plansource->search_path));
+
+	/* We don't support oneshot plans here. */
+	if (plansource->is_oneshot)
+		return false;
+	Assert(!plan->is_oneshot);
+
+	/*
+	 * If the plan is dependent on RLS considerations, or it's transient,
+	 * reject.  These things probably can't ever happen for table-free
+	 * queries, but for safety's sake let's check.
+	 */
+	if (plansource->dependsOnRLS)
+		return false;
+	if (plan->dependsOnRole)
+		return false;
+	if (TransactionIdIsValid(plan->saved_xmin))
+		return false;
+
+	/*
+	 * Reject if AcquirePlannerLocks would have anything to do.  This is
+	 * simplistic, but there's no need to inquire any more carefully; indeed,
+	 * for current callers it shouldn't even be possible to hit any of these
+	 * checks.
+	 */
+	foreach(lc, plansource->query_list)
+	{
+		Query	   *query = lfirst_node(Query, lc);
+
+		if (query->commandType == CMD_UTILITY)
+			return false;
+		if (query->rtable || query->cteList || query->hasSubLinks)
+			return false;
+	}
+
+	/*
+	 * Reject if AcquireExecutorLocks would have anything to do.  This is
+	 * probably unnecessary given the previous check, but let's be safe.
+	 */
+	foreach(lc, plan->stmt_list)
+	{
+		PlannedStmt *plannedstmt = lfirst_node(PlannedStmt, lc);
+		ListCell   *lc2;
+
+		if (plannedstmt->commandType == CMD_UTILITY)
+			return false;
+
+		/*
+		 * The planner may have added rangetable entries of its own, so look
+		 * for actual relations rather than insisting on an empty rtable.
+		 */
+		foreach(lc2, plannedstmt->rtable)
+		{
+			RangeTblEntry *rte = (RangeTblEntry *) lfirst(lc2);
+
+			if (rte->rtekind == RTE_RELATION)
+				return false;
+		}
+	}
+
+	/*
+	 * Okay, it's simple.  Note that what we've primarily established here is
+	 * that no locks need be taken before checking the plan's is_valid flag.
+	 */
+
+	/* Bump refcount if requested. */
+	if (owner)
+	{
+		ResourceOwnerEnlargePlanCacheRefs(owner);
+		plan->refcount++;
+		ResourceOwnerRememberPlanCacheRef(owner, plan);
+	}
+
+	return true;
+}
+
+/*
+ * CachedPlanIsSimplyValid: quick check for plan still being valid
+ *
+ * This function must not be used unless CachedPlanAllowsSimpleValidityCheck
+ * previously said it was OK.
+ *
+ * If the plan is valid, and "owner" is not NULL, record a refcount on
+ * the plan in that resowner before returning.  It is caller's responsibility
+ * to be sure that a refcount is held on any plan that's being actively used.
+ *
+ * The code here is unconditionally safe as long as the only use of this
+ * CachedPlanSource is in connection with the particular CachedPlan pointer
+ * that's passed in.  If the plansource were being used for other purposes,
+ * it's possible that its generic plan could be invalidated and regenerated
+ * while the current caller wasn't looking, and then there could be a chance
+ * collision of address between this caller's now-stale plan pointer and the
+ * actual address of the new generic plan.  For current uses, that scenario
+ * can't happen; but with a plansource shared across multiple uses, it'd be
+ * advisable to also save plan->generation and verify that that still matches.
+ */
+bool
+CachedPlanIsSimplyValid(CachedPlanSource *plansource, CachedPlan *plan,
+						ResourceOwner owner)
+{
+	/*
+	 * Careful here: since the caller doesn't necessarily hold a refcount on
+	 * the plan to start with, it's possible that "plan" is a dangling
+	 * pointer.  Don't dereference it until we've verified that it still
+	 * matches the plansource's gplan (which is either valid or NULL).
+	 */
+	Assert(plansource->magic == CACHEDPLANSOURCE_MAGIC);
+
+	/*
+	 * Has cache invalidation fired on this plan?  We can check this right
+	 * away since there are no locks that we'd need to acquire first.  Note
+	 * that here we *do* check plansource->is_valid, so as to force plan
+	 * rebuild if that's become false.
+	 */
+	if (!plansource->is_valid || plan != plansource->gplan || !plan->is_valid)
+		return false;
+
+	Assert(plan->magic == CACHEDPLAN_MAGIC);
+
+	/* Is the search_path still the same as when we made it? */
+	Assert(plansource->search_path != NULL);
+	if (!OverrideSearchPathMatchesCurrent(plansource->search_path))
+		return false;
+
+	/* It's still good.  Bump refcount if requested. */
+	if (owner)
+	{
+		ResourceOwnerEnlargePlanCacheRefs(owner);
+		plan->refcount++;
+		ResourceOwnerRememberPlanCacheRef(owner, plan);
+	}
+
+	return true;
+}
+
 /*
  * CachedPlanGetTargetList: return tlist, if any, describing plan's output
  *
@@ -1558,6 +1866,11 @@ QueryListGetPrimaryStmt(List *stmts)
 /*
  * AcquireExecutorLocks: acquire locks needed for execution of a cached plan;
  * or release them if acquire is false.
+ *
+ * The leaf partitions listed in a PlannedStmt's prunableRelids are skipped,
+ * since with thousands of partitions locking them all would cost far more
+ * than running the query.  The ones that survive initial pruning are locked
+ * separately by AcquirePartitionLocks.
  */
 static void
 AcquireExecutorLocks(List *stmt_list, bool acquire)
@@ -1568,6 +1881,7 @@ AcquireExecutorLocks(List *stmt_list, bool acquire)
 	{
 		PlannedStmt *plannedstmt = lfirst_node(PlannedStmt, lc1);
 		ListCell   *lc2;
+		Index		rti;
 
 		if (plannedstmt->commandType == CMD_UTILITY)
 		{
@@ -1585,11 +1899,13 @@ AcquireExecutorLocks(List *stmt_list, bool acquire)
 			continue;
 		}
 
+		rti = 1;
 		foreach(lc2, plannedstmt->rtable)
 		{
 			RangeTblEntry *rte = (RangeTblEntry *) lfirst(lc2);
 
-			if (rte->rtekind != RTE_RELATION)
+			if (rte->rtekind != RTE_RELATION ||
+				bms_is_member(rti++, plannedstmt->prunableRelids))
 				continue;
 
 			/*
@@ -1606,6 +1922,69 @@ AcquireExecutorLocks(List *stmt_list, bool acquire)
 	}
 }
 
+/*
+ * GetPartitionsToLock: find the prunable partitions of an executable
+ * stmt_list that survive initial pruning, and so need executor locks.
+ *
+ * Leaf partitions whose scans may be pruned at executor startup are left out
+ * by AcquireExecutorLocks; this returns the RangeTblEntrys of those that the
+ * executor will actually initialize, for AcquirePartitionLocks.  The rest of
+ * the plan's locks must be held already, and the plan must be known valid.
+ */
+static List *
+GetPartitionsToLock(List *stmt_list, ParamListInfo boundParams)
+{
+	List	   *result = NIL;
+	ListCell   *lc;
+
+	foreach(lc, stmt_list)
+	{
+		PlannedStmt *plannedstmt = lfirst_node(PlannedStmt, lc);
+		Bitmapset  *relids;
+		int			rti;
+
+		if (plannedstmt->commandType == CMD_UTILITY ||
+			bms_is_empty(plannedstmt->prunableRelids))
+			continue;
+
+		/*
+		 * Without Param values there is nothing to prune with; the executor
+		 * will report that, but it still needs the locks to get that far.
+		 */
+		if (boundParams == NULL)
+			relids = plannedstmt->prunableRelids;
+		else
+			relids = ExecPrunableRelidsToLock(plannedstmt, boundParams);
+
+		rti = -1;
+		while ((rti = bms_next_member(relids, rti)) >= 0)
+			result = lappend(result, rt_fetch(rti, plannedstmt->rtable));
+	}
+
+	return result;
+}
+
+/*
+ * AcquirePartitionLocks: acquire (or release) the executor locks on the
+ * partitions found by GetPartitionsToLock.
+ */
+static void
+AcquirePartitionLocks(List *partitions, bool acquire)
+{
+	ListCell   *lc;
+
+	foreach(lc, partitions)
+	{
+		RangeTblEntry *rte = lfirst_node(RangeTblEntry, lc);
+
+		Assert(rte->rtekind == RTE_RELATION);
+		if (acquire)
+			LockRelationOid(rte->relid, rte->rellockmode);
+		else
+			UnlockRelationOid(rte->relid, rte->rellockmode);
+	}
+}
+
 /*
  * AcquirePlannerLocks: acquire locks needed for planning of a querytree list;
  * or release them if acquire is false.
@@ -27,6 +27,7 @@
 #include "postgres.h"
 
 #include <sys/file.h>
+#include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
 
@@ -67,6 +68,7 @@
 #include "catalog/storage.h"
 #include "commands/policy.h"
 #include "commands/trigger.h"
+#include "funcapi.h"
 #include "miscadmin.h"
 #include "nodes/nodeFuncs.h"
 #include "optimizer/clauses.h"
@@ -96,6 +98,14 @@
 
 #define RELCACHE_INIT_FILEMAGIC		0x573266	/* version ID value */
 
+/* contents of an init file being loaded by load_relcache_init_file() */
+typedef struct InitFileData
+{
+	char	   *data;			/* the whole file */
+	Size		len;			/* its length */
+	Size		pos;			/* read position */
+} InitFileData;
+
 /*
  *		hardcoded tuple descriptors, contents generated by genbki.pl
  */
@@ -120,10 +130,28 @@ typedef struct relidcacheent
 {
 	Oid			reloid;
 	Relation	reldesc;
+	dlist_node	lru_elem;		/* list member of RelationLRUList */
+	Size		memsize;		/* estimated space used by reldesc */
 } RelIdCacheEnt;
 
 static HTAB *RelationIdCache;
 
+/*
+ * All entries of RelationIdCache are also kept in a list in LRU order, most
+ * recently opened first, which is used to pick entries to throw away when
+ * the estimated size of the relcache exceeds relation_cache_memory.
+ */
+static dlist_head RelationLRUList = DLIST_STATIC_INIT(RelationLRUList);
+static Size RelationCacheMemory = 0;
+
+/* GUC variable: memory limit for the relcache, in kB (0 = none) */
+int			relation_cache_memory = 0;
+
+/* Counters reported by pg_relation_cache_stats() */
+static long relcacheHits = 0L;
+static long relcacheLoads = 0L;
+static long relcacheEvictions = 0L;
+
 /*
  * This flag is false until we have prepared the critical relcache entries
  * that are needed to do indexscans on the tables read by relcache building.
@@ -196,9 +224,16 @@ do { \
 		else if (!IsBootstrapProcessingMode()) \
 			elog(WARNING, "leaking still-referenced relcache entry for \"%s\"", \
 				 RelationGetRelationName(_old_rel)); \
+		RelationCacheMemory -= hentry->memsize; \
+		dlist_move_head(&RelationLRUList, &hentry->lru_elem); \
 	} \
 	else \
+	{ \
 		hentry->reldesc = (RELATION); \
+		dlist_push_head(&RelationLRUList, &hentry->lru_elem); \
+	} \
+	hentry->memsize = RelationCacheEntrySize(RELATION); \
+	RelationCacheMemory += hentry->memsize; \
 } while(0)
 
 #define RelationIdCacheLookup(ID, RELATION) \
@@ -222,6 +257,11 @@ do { \
 	if (hentry == NULL) \
 		elog(WARNING, "failed to delete relcache entry for OID %u", \
 			 (RELATION)->rd_id); \
+	else \
+	{ \
+		dlist_delete(&hentry->lru_elem); \
+		RelationCacheMemory -= hentry->memsize; \
+	} \
 } while(0)
 
 
@@ -246,8 +286,10 @@ static HTAB *OpClassCache = NULL;
 
 /* non-export function prototypes */
 
+static Size RelationCacheEntrySize(Relation relation);
 static void RelationDestroyRelation(Relation relation, bool remember_tupdesc);
 static void RelationClearRelation(Relation relation, bool rebuild);
+static void RelationCacheEvict(void);
 
 static void RelationReloadIndexInfo(Relation relation);
 static void RelationReloadNailed(Relation relation);
@@ -258,6 +300,7 @@ static void AtEOSubXact_cleanup(Relation relation, bool isCommit,
 					SubTransactionId mySubid, SubTransactionId parentSubid);
 static bool load_relcache_init_file(bool shared);
 static void write_relcache_init_file(bool shared);
+static bool read_initfile(void *data, Size len, InitFileData *file);
 static void write_item(const void *data, Size len, FILE *fp);
 
 static void formrdesc(const char *relationName, Oid relationReltype,
@@ -1906,6 +1949,7 @@ formrdesc(const char *relationName, Oid relationReltype,
 Relation
 RelationIdGetRelation(Oid relationId)
 {
+	RelIdCacheEnt *hentry;
 	Relation	rd;
 
 	/* Make sure we're in an xact, even if this ends up being a cache hit */
@@ -1914,10 +1958,16 @@ RelationIdGetRelation(Oid relationId)
 	/*
 	 * first try to find reldesc in the cache
 	 */
-	RelationIdCacheLookup(relationId, rd);
+	hentry = (RelIdCacheEnt *) hash_search(RelationIdCache,
+										   (void *) &relationId,
+										   HASH_FIND, NULL);
 
-	if (RelationIsValid(rd))
+	if (hentry != NULL)
 	{
+		rd = hentry->reldesc;
+		relcacheHits++;
+		dlist_move_head(&RelationLRUList, &hentry->lru_elem);
+
 		RelationIncrementReferenceCount(rd);
 		/* revalidate cache entry if necessary */
 		if (!rd->rd_isvalid)
@@ -1950,6 +2000,7 @@ RelationIdGetRelation(Oid relationId)
 	 * no reldesc in the cache, so have RelationBuildDesc() build one and add
 	 * it.
 	 */
+	relcacheLoads++;
 	rd = RelationBuildDesc(relationId, true);
 	if (RelationIsValid(rd))
 		RelationIncrementReferenceCount(rd);
@@ -2546,9 +2597,118 @@ RelationClearRelation(Relation relation, bool rebuild)
 
 		/* And now we can throw away the temporary entry */
 		RelationDestroyRelation(newrel, !keep_tupdesc);
+
+		/* The rebuilt entry may well be of a different size */
+		{
+			RelIdCacheEnt *hentry;
+
+			hentry = (RelIdCacheEnt *) hash_search(RelationIdCache,
+												   (void *) &save_relid,
+												   HASH_FIND, NULL);
+			if (hentry != NULL && hentry->reldesc == relation)
+			{
+				RelationCacheMemory -= hentry->memsize;
+				hentry->memsize = RelationCacheEntrySize(relation);
+				RelationCacheMemory += hentry->memsize;
+			}
+		}
 	}
 }
 
+/*
+ * RelationCacheEntrySize
+ *
+ *	 Estimate the space used by a relcache entry, for the purposes of
+ *	 relation_cache_memory.  We count the main substructures, but not the
+ *	 various lists and caches that are only built on demand.
+ */
+static Size
+RelationCacheEntrySize(Relation relation)
+{
+	Size		size = sizeof(RelationData);
+
+	if (relation->rd_rel)
+		size += GetMemoryChunkSpace(relation->rd_rel);
+	if (relation->rd_att)
+		size += GetMemoryChunkSpace(relation->rd_att);
+	if (relation->rd_indexcxt)
+		size += MemoryContextMemAllocated(relation->rd_indexcxt, true);
+	if (relation->rd_rulescxt)
+		size += MemoryContextMemAllocated(relation->rd_rulescxt, true);
+	if (relation->rd_rsdesc)
+		size += MemoryContextMemAllocated(relation->rd_rsdesc->rscxt, true);
+	if (relation->rd_partkeycxt)
+		size += MemoryContextMemAllocated(relation->rd_partkeycxt, true);
+	if (relation->rd_pdcxt)
+		size += MemoryContextMemAllocated(relation->rd_pdcxt, true);
+
+	return size;
+}
+
+/*
+ * RelationCacheEvict
+ *
+ *	 Throw away unreferenced relcache entries, least recently opened first,
+ *	 until the relcache is within relation_cache_memory.
+ *
+ *	 Entries that are open, nailed, or created or given a new relfilenode
+ *	 in the current transaction are kept.  This is called at transaction
+ *	 end rather than whenever an entry is added, because most code walking
+ *	 RelationIdCache with hash_seq_search doesn't expect entries to vanish
+ *	 underneath it.
+ */
+static void
+RelationCacheEvict(void)
+{
+	Size		limit = (Size) relation_cache_memory * 1024;
+	dlist_node *cur;
+
+	cur = RelationLRUList.head.prev;
+	while (RelationCacheMemory > limit && cur != &RelationLRUList.head)
+	{
+		RelIdCacheEnt *hentry = dlist_container(RelIdCacheEnt, lru_elem, cur);
+		Relation	relation = hentry->reldesc;
+
+		cur = cur->prev;
+
+		if (!RelationHasReferenceCountZero(relation) ||
+			relation->rd_isnailed ||
+			relation->rd_createSubid != InvalidSubTransactionId ||
+			relation->rd_newRelfilenodeSubid != InvalidSubTransactionId)
+			continue;
+
+		relcacheEvictions++;
+		RelationClearRelation(relation, false);
+	}
+}
+
+/*
+ * SQL-callable function to report the size and activity of this backend's
+ * relcache
+ */
+Datum
+pg_relation_cache_stats(PG_FUNCTION_ARGS)
+{
+#define PG_RELATION_CACHE_STATS_COLS 5
+	TupleDesc	tupdesc;
+	Datum		values[PG_RELATION_CACHE_STATS_COLS];
+	bool		nulls[PG_RELATION_CACHE_STATS_COLS];
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	MemSet(nulls, 0, sizeof(nulls));
+
+	values[0] = Int32GetDatum((int32) hash_get_num_entries(RelationIdCache));
+	values[1] = Int64GetDatum((int64) RelationCacheMemory);
+	values[2] = Int64GetDatum(relcacheHits);
+	values[3] = Int64GetDatum(relcacheLoads);
+	values[4] = Int64GetDatum(relcacheEvictions);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
+
 /*
  * RelationFlushRelation
  *
@@ -2880,6 +3040,11 @@ AtEOXact_RelationCache(bool isCommit)
 	eoxact_list_overflowed = false;
 	NextEOXactTupleDescNum = 0;
 	EOXactTupleDescArrayLen = 0;
+
+	/* Shrink the cache back to its memory limit, if there's one */
+	if (relation_cache_memory > 0 && !IsBootstrapProcessingMode() &&
+		RelationCacheMemory > (Size) relation_cache_memory * 1024)
+		RelationCacheEvict();
 }
 
 /*
@@ -5328,7 +5493,9 @@ errtableconstraint(Relation rel, const char *conname)
 static bool
 load_relcache_init_file(bool shared)
 {
-	FILE	   *fp;
+	int			fd;
+	struct stat st;
+	InitFileData initfile;
 	char		initfilename[MAXPGPATH];
 	Relation   *rels;
 	int			relno,
@@ -5346,9 +5513,30 @@ load_relcache_init_file(bool shared)
 		snprintf(initfilename, sizeof(initfilename), "%s/%s",
 				 DatabasePath, RELCACHE_INIT_FILENAME);
 
-	fp = AllocateFile(initfilename, PG_BINARY_R);
-	if (fp == NULL)
+	/*
+	 * Slurp the whole file into memory with a single read, rather than
+	 * issuing a read call for each of the many small items in it.  The file
+	 * is replaced by rename() when it is rewritten, so we can't see a
+	 * partially written one.
+	 */
+	fd = OpenTransientFile(initfilename, O_RDONLY | PG_BINARY);
+	if (fd < 0)
+		return false;
+	if (fstat(fd, &st) < 0)
+	{
+		CloseTransientFile(fd);
+		return false;
+	}
+	initfile.len = st.st_size;
+	initfile.pos = 0;
+	initfile.data = palloc(initfile.len);
+	if (read(fd, initfile.data, initfile.len) != (ssize_t) initfile.len)
+	{
+		CloseTransientFile(fd);
+		pfree(initfile.data);
 		return false;
+	}
+	CloseTransientFile(fd);
 
 	/*
 	 * Read the index relcache entries from the file.  Note we will not enter
@@ -5361,7 +5549,7 @@ load_relcache_init_file(bool shared)
 	nailed_rels = nailed_indexes = 0;
 
 	/* check for correct magic number (compatible version) */
-	if (fread(&magic, 1, sizeof(magic), fp) != sizeof(magic))
+	if (!read_initfile(&magic, sizeof(magic), &initfile))
 		goto read_failed;
 	if (magic != RELCACHE_INIT_FILEMAGIC)
 		goto read_failed;
@@ -5369,19 +5557,15 @@ load_relcache_init_file(bool shared)
 	for (relno = 0;; relno++)
 	{
 		Size		len;
-		size_t		nread;
 		Relation	rel;
 		Form_pg_class relform;
 		bool		has_not_null;
 
 		/* first read the relation descriptor length */
-		nread = fread(&len, 1, sizeof(len), fp);
-		if (nread != sizeof(len))
-		{
-			if (nread == 0)
-				break;			/* end of file */
+		if (initfile.pos == initfile.len)
+			break;				/* end of file */
+		if (!read_initfile(&len, sizeof(len), &initfile))
 			goto read_failed;
-		}
 
 		/* safety check for incompatible relcache layout */
 		if (len != sizeof(RelationData))
@@ -5397,15 +5581,15 @@ load_relcache_init_file(bool shared)
 		rel = rels[num_rels++] = (Relation) palloc(len);
 
 		/* then, read the Relation structure */
-		if (fread(rel, 1, len, fp) != len)
+		if (!read_initfile(rel, len, &initfile))
 			goto read_failed;
 
 		/* next read the relation tuple form */
-		if (fread(&len, 1, sizeof(len), fp) != sizeof(len))
+		if (!read_initfile(&len, sizeof(len), &initfile))
 			goto read_failed;
 
 		relform = (Form_pg_class) palloc(len);
-		if (fread(relform, 1, len, fp) != len)
+		if (!read_initfile(relform, len, &initfile))
 			goto read_failed;
 
 		rel->rd_rel = relform;
@@ -5423,23 +5607,23 @@ load_relcache_init_file(bool shared)
 		{
 			Form_pg_attribute attr = TupleDescAttr(rel->rd_att, i);
 
-			if (fread(&len, 1, sizeof(len), fp) != sizeof(len))
+			if (!read_initfile(&len, sizeof(len), &initfile))
 				goto read_failed;
 			if (len != ATTRIBUTE_FIXED_PART_SIZE)
 				goto read_failed;
-			if (fread(attr, 1, len, fp) != len)
+			if (!read_initfile(attr, len, &initfile))
 				goto read_failed;
 
 			has_not_null |= attr->attnotnull;
 		}
 
 		/* next read the access method specific field */
-		if (fread(&len, 1, sizeof(len), fp) != sizeof(len))
+		if (!read_initfile(&len, sizeof(len), &initfile))
 			goto read_failed;
 		if (len > 0)
 		{
 			rel->rd_options = palloc(len);
-			if (fread(rel->rd_options, 1, len, fp) != len)
+			if (!read_initfile(rel->rd_options, len, &initfile))
 				goto read_failed;
 			if (len != VARSIZE(rel->rd_options))
 				goto read_failed;	/* sanity check */
@@ -5477,11 +5661,11 @@ load_relcache_init_file(bool shared)
 				nailed_indexes++;
 
 			/* next, read the pg_index tuple */
-			if (fread(&len, 1, sizeof(len), fp) != sizeof(len))
+			if (!read_initfile(&len, sizeof(len), &initfile))
 				goto read_failed;
 
 			rel->rd_indextuple = (HeapTuple) palloc(len);
-			if (fread(rel->rd_indextuple, 1, len, fp) != len)
+			if (!read_initfile(rel->rd_indextuple, len, &initfile))
 				goto read_failed;
 
 			/* Fix up internal pointers in the tuple -- see heap_copytuple */
@@ -5508,50 +5692,50 @@ load_relcache_init_file(bool shared)
 			InitIndexAmRoutine(rel);
 
 			/* next, read the vector of opfamily OIDs */
-			if (fread(&len, 1, sizeof(len), fp) != sizeof(len))
+			if (!read_initfile(&len, sizeof(len), &initfile))
 				goto read_failed;
 
 			opfamily = (Oid *) MemoryContextAlloc(indexcxt, len);
-			if (fread(opfamily, 1, len, fp) != len)
+			if (!read_initfile(opfamily, len, &initfile))
 				goto read_failed;
 
 			rel->rd_opfamily = opfamily;
 
 			/* next, read the vector of opcintype OIDs */
-			if (fread(&len, 1, sizeof(len), fp) != sizeof(len))
+			if (!read_initfile(&len, sizeof(len), &initfile))
 				goto read_failed;
 
 			opcintype = (Oid *) MemoryContextAlloc(indexcxt, len);
-			if (fread(opcintype, 1, len, fp) != len)
+			if (!read_initfile(opcintype, len, &initfile))
 				goto read_failed;
 
 			rel->rd_opcintype = opcintype;
 
 			/* next, read the vector of support procedure OIDs */
-			if (fread(&len, 1, sizeof(len), fp) != sizeof(len))
+			if (!read_initfile(&len, sizeof(len), &initfile))
 				goto read_failed;
 			support = (RegProcedure *) MemoryContextAlloc(indexcxt, len);
-			if (fread(support, 1, len, fp) != len)
+			if (!read_initfile(support, len, &initfile))
 				goto read_failed;
 
 			rel->rd_support = support;
 
 			/* next, read the vector of collation OIDs */
-			if (fread(&len, 1, sizeof(len), fp) != sizeof(len))
+			if (!read_initfile(&len, sizeof(len), &initfile))
 				goto read_failed;
 
 			indcollation = (Oid *) MemoryContextAlloc(indexcxt, len);
-			if (fread(indcollation, 1, len, fp) != len)
+			if (!read_initfile(indcollation, len, &initfile))
 				goto read_failed;
 
 			rel->rd_indcollation = indcollation;
 
 			/* finally, read the vector of indoption values */
-			if (fread(&len, 1, sizeof(len), fp) != sizeof(len))
+			if (!read_initfile(&len, sizeof(len), &initfile))
 				goto read_failed;
 
 			indoption = (int16 *) MemoryContextAlloc(indexcxt, len);
-			if (fread(indoption, 1, len, fp) != len)
+			if (!read_initfile(indoption, len, &initfile))
 				goto read_failed;
 
 			rel->rd_indoption = indoption;
@@ -5690,7 +5874,7 @@ load_relcache_init_file(bool shared)
 	}
 
 	pfree(rels);
-	FreeFile(fp);
+	pfree(initfile.data);
 
 	if (shared)
 		criticalSharedRelcachesBuilt = true;
@@ -5705,7 +5889,7 @@ load_relcache_init_file(bool shared)
 	 */
 read_failed:
 	pfree(rels);
-	FreeFile(fp);
+	pfree(initfile.data);
 
 	return false;
 }
@@ -5911,6 +6095,17 @@ write_relcache_init_file(bool shared)
 	LWLockRelease(RelCacheInitLock);
 }
 
+/* copy the next len bytes of an init file that's been read in */
+static bool
+read_initfile(void *data, Size len, InitFileData *file)
+{
+	if (len > file->len - file->pos)
+		return false;
+	memcpy(data, file->data + file->pos, len);
+	file->pos += len;
+	return true;
+}
+
 /* write a chunk of data preceded by its length */
 static void
 write_item(const void *data, Size len, FILE *fp)
@@ -25,6 +25,104 @@
 #include "utils/hsearch.h"
 
 
+/*
+ * Constants for hash_bytes_long, from wyhash by Wang Yi (public domain).
+ */
+#define WYHASH_P0	UINT64CONST(0xa0761d6478bd642f)
+#define WYHASH_P1	UINT64CONST(0xe7037ed1a0b428db)
+#define WYHASH_P2	UINT64CONST(0x8ebc6af09c88c6e3)
+
+/*
+ * Multiply two 64-bit values and fold the 128-bit product to 64 bits.
+ */
+static inline uint64
+hash_mum(uint64 a, uint64 b)
+{
+#ifdef HAVE_INT128
+	uint128		r = (uint128) a * b;
+
+	return (uint64) r ^ (uint64) (r >> 64);
+#else
+	uint64		ha = a >> 32,
+				la = (uint32) a,
+				hb = b >> 32,
+				lb = (uint32) b;
+	uint64		rh = ha * hb,
+				rm0 = ha * lb,
+				rm1 = hb * la,
+				rl = la * lb;
+	uint64		t = rl + (rm0 << 32);
+	uint64		lo,
+				hi;
+
+	hi = rh + (rm0 >> 32) + (rm1 >> 32) + (t < rl);
+	lo = t + (rm1 << 32);
+	hi += (lo < t);
+
+	return lo ^ hi;
+#endif
+}
+
+/* Read 8 bytes as an integer, in native byte order */
+static inline uint64
+hash_read8(const unsigned char *p)
+{
+	uint64		v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+/*
+ * hash_bytes_long: hash a byte string of more than 16 bytes
+ *
+ * This is modelled on the long-input path of wyhash, which consumes 16
+ * bytes per 64x64->128-bit multiplication.  Its results depend on byte order, so it must
+ * only be used for hash values that are never stored on disk or compared
+ * between machines; anything persistent, such as hash index entries and hash
+ * partition bounds, must keep using hash_any.
+ */
+static inline uint32
+hash_bytes_long(const unsigned char *k, int keylen)
+{
+	size_t		len = (size_t) keylen;
+	size_t		i = len;
+	uint64		h = WYHASH_P0;
+
+	Assert(len > 16);
+
+	while (i > 16)
+	{
+		h = hash_mum(hash_read8(k) ^ WYHASH_P1, hash_read8(k + 8) ^ h);
+		k += 16;
+		i -= 16;
+	}
+
+	/* the last 16 bytes, possibly overlapping ones already hashed */
+	h = hash_mum(hash_read8(k + i - 16) ^ WYHASH_P1,
+				 hash_read8(k + i - 8) ^ h);
+	h = hash_mum(h ^ WYHASH_P1 ^ (uint64) len, WYHASH_P2);
+
+	return (uint32) (h ^ (h >> 32));
+}
+
+/*
+ * hash_key_bytes: hash a dynahash key
+ *
+ * lookup3 (hash_any) is hard to beat for short keys, but hash_bytes_long is
+ * markedly faster once keys exceed a couple of dozen bytes, as long names
+ * and string keys often do.
+ */
+#define HASH_LONG_KEY_MIN	33
+
+static inline uint32
+hash_key_bytes(const unsigned char *k, int keylen)
+{
+	if (keylen < HASH_LONG_KEY_MIN)
+		return DatumGetUInt32(hash_any(k, keylen));
+	return hash_bytes_long(k, keylen);
+}
+
 /*
  * string_hash: hash function for keys that are NUL-terminated strings.
  *
@@ -41,8 +139,7 @@ string_hash(const void *key, Size keysize)
 	Size		s_len = strlen((const char *) key);
 
 	s_len = Min(s_len, keysize - 1);
-	return DatumGetUInt32(hash_any((const unsigned char *) key,
-								   (int) s_len));
+	return hash_key_bytes((const unsigned char *) key, (int) s_len);
 }
 
 /*
@@ -51,8 +148,7 @@ string_hash(const void *key, Size keysize)
 uint32
 tag_hash(const void *key, Size keysize)
 {
-	return DatumGetUInt32(hash_any((const unsigned char *) key,
-								   (int) keysize));
+	return hash_key_bytes((const unsigned char *) key, (int) keysize);
 }
 
 /*
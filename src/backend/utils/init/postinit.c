@@ -534,6 +534,28 @@ InitializeMaxBackends(void)
 		elog(ERROR, "too many backends configured");
 }
 
+/*
+ * Initialize the number of fast-path lock groups, based on the configured
+ * max_locks_per_transaction.
+ *
+ * Each backend gets as many fast-path lock slots as it is expected to hold
+ * relation locks, rounded up to a power of 2 number of groups and capped at
+ * FP_LOCK_GROUPS_PER_BACKEND_MAX.  Like MaxBackends, this is passed from the
+ * postmaster to subprocesses via BackendParameters; only postmaster itself
+ * and processes not under postmaster control should call this.
+ */
+void
+InitializeFastPathLocks(void)
+{
+	Assert(FastPathLockGroupsPerBackend == 0);
+
+	FastPathLockGroupsPerBackend = 1;
+	while (FastPathLockGroupsPerBackend < FP_LOCK_GROUPS_PER_BACKEND_MAX &&
+		   FastPathLockGroupsPerBackend * FP_LOCK_SLOTS_PER_GROUP <
+		   max_locks_per_xact)
+		FastPathLockGroupsPerBackend *= 2;
+}
+
 /*
  * Early initialization of a backend (either standalone or under postmaster).
  * This happens even before InitPostgres.
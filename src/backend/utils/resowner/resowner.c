@@ -677,6 +677,32 @@ ResourceOwnerReleaseInternal(ResourceOwner owner,
 	CurrentResourceOwner = save;
 }
 
+/*
+ * ResourceOwnerReleaseAllPlanCacheRefs
+ *		Release the plancache references (only) held by this owner.
+ *
+ * We might eventually add similar functions for other resource types,
+ * but for now, only this is needed.  It lets a caller that deliberately
+ * holds plancache references until end of transaction drop them without
+ * provoking leak warnings.
+ */
+void
+ResourceOwnerReleaseAllPlanCacheRefs(ResourceOwner owner)
+{
+	ResourceOwner save;
+	Datum		foundres;
+
+	save = CurrentResourceOwner;
+	CurrentResourceOwner = owner;
+	while (ResourceArrayGetAny(&(owner->planrefarr), &foundres))
+	{
+		CachedPlan *res = (CachedPlan *) DatumGetPointer(foundres);
+
+		ReleaseCachedPlan(res, true);
+	}
+	CurrentResourceOwner = save;
+}
+
 /*
  * ResourceOwnerDelete
  *		Delete an owner object and its descendants.
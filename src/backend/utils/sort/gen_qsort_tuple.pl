@@ -22,6 +22,11 @@
 #     Instead of sorting arbitrary objects, we're always sorting SortTuples.
 #     Add CHECK_FOR_INTERRUPTS().
 #
+# Besides the generic qsort_tuple and the single-key qsort_ssup, we emit
+# variants for leading keys whose comparator tuplesort.c recognizes as one
+# of the ssup_datum_*_cmp functions: those compare datum1 inline, and only
+# call the tuple comparator to break ties.
+#
 # CAUTION: if you change this file, see also qsort.c and qsort_arg.c
 #
 
@@ -53,6 +58,40 @@ print <<'EOM';
 EOM
 emit_qsort_implementation();
 
+$SUFFIX      = 'tuple_unsigned';
+$EXTRAARGS   = ', Tuplesortstate *state';
+$EXTRAPARAMS = ', state';
+$CMPPARAMS   = ', state';
+print <<'EOM';
+
+#define cmp_tuple_unsigned(a, b, state) \
+	qsort_tuple_unsigned_compare(a, b, state)
+
+EOM
+emit_qsort_implementation();
+
+$SUFFIX = 'tuple_signed';
+print <<'EOM';
+
+#ifdef USE_FLOAT8_BYVAL
+#define cmp_tuple_signed(a, b, state) \
+	qsort_tuple_signed_compare(a, b, state)
+
+EOM
+emit_qsort_implementation();
+print <<'EOM';
+#endif							/* USE_FLOAT8_BYVAL */
+EOM
+
+$SUFFIX = 'tuple_int32';
+print <<'EOM';
+
+#define cmp_tuple_int32(a, b, state) \
+	qsort_tuple_int32_compare(a, b, state)
+
+EOM
+emit_qsort_implementation();
+
 sub emit_qsort_boilerplate
 {
 	print <<'EOM';
@@ -47,7 +47,14 @@
  *
  * To further make the I/Os more sequential, we can use a larger buffer
  * when reading, and read multiple blocks from the same tape in one go,
- * whenever the buffer becomes empty.
+ * whenever the buffer becomes empty.  That only helps if the blocks of a
+ * tape are close to each other in the underlying file, though, so each tape
+ * being written grabs a run of free blocks at a time, rather than taking
+ * them one by one from the shared free list.  Otherwise, the blocks of
+ * tapes written concurrently in a merge pass would end up interleaved, and
+ * reading back one tape would skip all over the file.  The run size starts
+ * small and doubles on each refill, so tapes that hold only a few blocks
+ * don't reserve much space they never use.
  *
  * To support the above policy of writing to the lowest free block,
  * ltsGetFreeBlock sorts the list of free block numbers into decreasing
@@ -114,6 +121,14 @@ typedef struct TapeBlockTrailer
 #define TapeBlockSetNBytes(buf, nbytes) \
 	(TapeBlockGetTrailer(buf)->next = -(nbytes))
 
+/*
+ * When writing, a tape preallocates this many blocks at a time from the
+ * free list or the end of the file.  The number doubles on each refill, up
+ * to the maximum.
+ */
+#define TAPE_WRITE_PREALLOC_MIN 8
+#define TAPE_WRITE_PREALLOC_MAX 128
+
 
 /*
  * This data structure represents a single "logical tape" within the set
@@ -155,6 +170,14 @@ typedef struct LogicalTape
 	int			max_size;		/* highest useful, safe buffer_size */
 	int			pos;			/* next read/write position in buffer */
 	int			nbytes;			/* total # of valid bytes in buffer */
+
+	/*
+	 * Blocks preallocated for this tape while writing, in decreasing order,
+	 * so that the last entry is the next one to use.
+	 */
+	long	   *prealloc;
+	int			nprealloc;		/* # of blocks remaining in prealloc[] */
+	int			prealloc_size;	/* allocated size of prealloc[] */
 } LogicalTape;
 
 /*
@@ -208,7 +231,9 @@ struct LogicalTapeSet
 static void ltsWriteBlock(LogicalTapeSet *lts, long blocknum, void *buffer);
 static void ltsReadBlock(LogicalTapeSet *lts, long blocknum, void *buffer);
 static long ltsGetFreeBlock(LogicalTapeSet *lts);
+static long ltsGetPreallocBlock(LogicalTapeSet *lts, LogicalTape *lt);
 static void ltsReleaseBlock(LogicalTapeSet *lts, long blocknum);
+static void ltsReleasePrealloc(LogicalTapeSet *lts, LogicalTape *lt);
 static void ltsConcatWorkerTapes(LogicalTapeSet *lts, TapeShare *shared,
 					 SharedFileSet *fileset);
 
@@ -227,11 +252,11 @@ ltsWriteBlock(LogicalTapeSet *lts, long blocknum, void *buffer)
 	 * end of file and the target block with zeros.
 	 *
 	 * This should happen rarely, otherwise you are not writing very
-	 * sequentially.  In current use, this only happens when the sort ends
-	 * writing a run, and switches to another tape.  The last block of the
-	 * previous tape isn't flushed to disk until the end of the sort, so you
-	 * get one-block hole, where the last block of the previous tape will
-	 * later go.
+	 * sequentially.  In current use, this happens when the sort ends writing
+	 * a run, and switches to another tape.  The last block of the previous
+	 * tape isn't flushed to disk until the end of the sort, and the rest of
+	 * the blocks it had preallocated are only written once it's used them,
+	 * so you get a hole where those blocks will later go.
 	 *
 	 * Note that BufFile concatenation can leave "holes" in BufFile between
 	 * worker-owned block ranges.  These are tracked for reporting purposes
@@ -363,6 +388,46 @@ ltsGetFreeBlock(LogicalTapeSet *lts)
 		return lts->nBlocksAllocated++;
 }
 
+/*
+ * Select a block for a tape to write to next, from the blocks preallocated
+ * for it.  When it runs out, preallocate a new bunch of blocks.
+ */
+static long
+ltsGetPreallocBlock(LogicalTapeSet *lts, LogicalTape *lt)
+{
+	if (lt->nprealloc == 0)
+	{
+		int			i;
+
+		if (lt->prealloc == NULL)
+		{
+			lt->prealloc_size = TAPE_WRITE_PREALLOC_MIN;
+			lt->prealloc = (long *) palloc(sizeof(long) * lt->prealloc_size);
+		}
+		else if (lt->prealloc_size < TAPE_WRITE_PREALLOC_MAX)
+		{
+			lt->prealloc_size = Min(lt->prealloc_size * 2,
+									TAPE_WRITE_PREALLOC_MAX);
+			lt->prealloc = (long *) repalloc(lt->prealloc,
+											 sizeof(long) * lt->prealloc_size);
+		}
+
+		/*
+		 * ltsGetFreeBlock() hands out blocks in increasing order, so filling
+		 * the array from the end leaves it in decreasing order.
+		 */
+		lt->nprealloc = lt->prealloc_size;
+		for (i = lt->nprealloc; i > 0; i--)
+		{
+			lt->prealloc[i - 1] = ltsGetFreeBlock(lts);
+			Assert(i == lt->nprealloc ||
+				   lt->prealloc[i - 1] > lt->prealloc[i]);
+		}
+	}
+
+	return lt->prealloc[--lt->nprealloc];
+}
+
 /*
  * Return a block# to the freelist.
  */
@@ -397,6 +462,22 @@ ltsReleaseBlock(LogicalTapeSet *lts, long blocknum)
 		lts->blocksSorted = false;
 }
 
+/*
+ * Return the blocks that a tape preallocated but didn't use to the
+ * freelist, at the end of its write phase.
+ */
+static void
+ltsReleasePrealloc(LogicalTapeSet *lts, LogicalTape *lt)
+{
+	while (lt->nprealloc > 0)
+		ltsReleaseBlock(lts, lt->prealloc[--lt->nprealloc]);
+
+	if (lt->prealloc)
+		pfree(lt->prealloc);
+	lt->prealloc = NULL;
+	lt->prealloc_size = 0;
+}
+
 /*
  * Claim ownership of a set of logical tapes from existing shared BufFiles.
  *
@@ -552,6 +633,9 @@ LogicalTapeSetCreate(int ntapes, TapeShare *shared, SharedFileSet *fileset,
 		lt->max_size = MaxAllocSize;
 		lt->pos = 0;
 		lt->nbytes = 0;
+		lt->prealloc = NULL;
+		lt->nprealloc = 0;
+		lt->prealloc_size = 0;
 	}
 
 	/*
@@ -592,6 +676,8 @@ LogicalTapeSetClose(LogicalTapeSet *lts)
 		lt = &lts->tapes[i];
 		if (lt->buffer)
 			pfree(lt->buffer);
+		if (lt->prealloc)
+			pfree(lt->prealloc);
 	}
 	pfree(lts->freeBlocks);
 	pfree(lts);
@@ -640,7 +726,7 @@ LogicalTapeWrite(LogicalTapeSet *lts, int tapenum,
 		Assert(lt->firstBlockNumber == -1);
 		Assert(lt->pos == 0);
 
-		lt->curBlockNumber = ltsGetFreeBlock(lts);
+		lt->curBlockNumber = ltsGetPreallocBlock(lts, lt);
 		lt->firstBlockNumber = lt->curBlockNumber;
 
 		TapeBlockGetTrailer(lt->buffer)->prev = -1L;
@@ -664,7 +750,7 @@ LogicalTapeWrite(LogicalTapeSet *lts, int tapenum,
 			 * First allocate the next block, so that we can store it in the
 			 * 'next' pointer of this block.
 			 */
-			nextBlockNumber = ltsGetFreeBlock(lts);
+			nextBlockNumber = ltsGetPreallocBlock(lts, lt);
 
 			/* set the next-pointer and dump the current block. */
 			TapeBlockGetTrailer(lt->buffer)->next = nextBlockNumber;
@@ -756,6 +842,7 @@ LogicalTapeRewindForRead(LogicalTapeSet *lts, int tapenum, size_t buffer_size)
 			ltsWriteBlock(lts, lt->curBlockNumber, (void *) lt->buffer);
 		}
 		lt->writing = false;
+		ltsReleasePrealloc(lts, lt);
 	}
 	else
 	{
@@ -905,6 +992,7 @@ LogicalTapeFreeze(LogicalTapeSet *lts, int tapenum, TapeShare *share)
 	}
 	lt->writing = false;
 	lt->frozen = true;
+	ltsReleasePrealloc(lts, lt);
 
 	/*
 	 * The seek and backspace functions assume a single block read buffer.
@@ -1077,9 +1165,12 @@ LogicalTapeTell(LogicalTapeSet *lts, int tapenum,
 
 /*
  * Obtain total disk space currently used by a LogicalTapeSet, in blocks.
+ *
+ * Blocks that tapes have preallocated but not written to yet don't take up
+ * any space, so this counts only what has reached the underlying file.
  */
 long
 LogicalTapeSetBlocks(LogicalTapeSet *lts)
 {
-	return lts->nBlocksAllocated - lts->nHoleBlocks;
+	return lts->nBlocksWritten - lts->nHoleBlocks;
 }
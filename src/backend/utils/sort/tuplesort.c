@@ -419,6 +419,14 @@ struct Tuplesortstate
 	 */
 	SortSupport onlyKey;
 
+	/*
+	 * Whether SortTuple's datum1 and isnull1 members hold the leading sort
+	 * key, so that tuplesort_sort_memtuples() may look at them directly.
+	 * Not so in the hash index case, nor in the CLUSTER case when the
+	 * leading index column is an expression.
+	 */
+	bool		haveDatum1;
+
 	/*
 	 * Additional state for managing "abbreviated key" sortsupport routines
 	 * (which currently may be used by all cases except the hash index case).
@@ -648,12 +656,63 @@ static void worker_nomergeruns(Tuplesortstate *state);
 static void leader_takeover_tapes(Tuplesortstate *state);
 static void free_sort_tuple(Tuplesortstate *state, SortTuple *stup);
 
+/*
+ * Comparators for the qsort_tuple_unsigned(), qsort_tuple_signed() and
+ * qsort_tuple_int32() variants below.  The leading key is compared inline;
+ * comparetup is only needed to break ties, when there are more keys or the
+ * leading key is abbreviated.
+ */
+static inline int
+qsort_tuple_unsigned_compare(SortTuple *a, SortTuple *b, Tuplesortstate *state)
+{
+	int			compare;
+
+	compare = ApplyUnsignedSortComparator(a->datum1, a->isnull1,
+										  b->datum1, b->isnull1,
+										  &state->sortKeys[0]);
+	if (compare != 0 || state->onlyKey != NULL)
+		return compare;
+
+	return state->comparetup(a, b, state);
+}
+
+#ifdef USE_FLOAT8_BYVAL
+static inline int
+qsort_tuple_signed_compare(SortTuple *a, SortTuple *b, Tuplesortstate *state)
+{
+	int			compare;
+
+	compare = ApplySignedSortComparator(a->datum1, a->isnull1,
+										b->datum1, b->isnull1,
+										&state->sortKeys[0]);
+	if (compare != 0 || state->onlyKey != NULL)
+		return compare;
+
+	return state->comparetup(a, b, state);
+}
+#endif
+
+static inline int
+qsort_tuple_int32_compare(SortTuple *a, SortTuple *b, Tuplesortstate *state)
+{
+	int			compare;
+
+	compare = ApplyInt32SortComparator(a->datum1, a->isnull1,
+									   b->datum1, b->isnull1,
+									   &state->sortKeys[0]);
+	if (compare != 0 || state->onlyKey != NULL)
+		return compare;
+
+	return state->comparetup(a, b, state);
+}
+
 /*
  * Special versions of qsort just for SortTuple objects.  qsort_tuple() sorts
  * any variant of SortTuples, using the appropriate comparetup function.
  * qsort_ssup() is specialized for the case where the comparetup function
  * reduces to ApplySortComparator(), that is single-key MinimalTuple sorts
- * and Datum sorts.
+ * and Datum sorts.  qsort_tuple_unsigned() and friends are specialized for
+ * leading keys that use one of the ssup_datum_*_cmp comparators.
  */
 #include "qsort_tuple.c"
 
@@ -706,10 +765,15 @@ tuplesort_begin_common(int workMem, SortCoordinate coordinate,
 	 * fragmentation. Note that the memtuples array of SortTuples is allocated
 	 * in the parent context, not this context, because there is no need to
 	 * free memtuples early.
+	 *
+	 * Tuples are only ever freed all together, by resetting the context once
+	 * they've been dumped to tape, so a bump context does fine and carries
+	 * much less overhead per tuple.  A bounded sort does free tuples one by
+	 * one; tuplesort_set_bound() switches to a regular context for it.
 	 */
-	tuplecontext = AllocSetContextCreate(sortcontext,
-										 "Caller tuples",
-										 ALLOCSET_DEFAULT_SIZES);
+	tuplecontext = BumpContextCreate(sortcontext,
+									 "Caller tuples",
+									 ALLOCSET_DEFAULT_SIZES);
 
 	/*
 	 * Make the Tuplesortstate within the per-sort context.  This way, we
@@ -871,6 +935,8 @@ tuplesort_begin_heap(TupleDesc tupDesc,
 	if (nkeys == 1 && !state->sortKeys->abbrev_converter)
 		state->onlyKey = state->sortKeys;
 
+	state->haveDatum1 = true;
+
 	MemoryContextSwitchTo(oldcontext);
 
 	return state;
@@ -917,6 +983,9 @@ tuplesort_begin_cluster(TupleDesc tupDesc,
 
 	state->indexInfo = BuildIndexInfo(indexRel);
 
+	/* datum1 holds the leading key unless that's an expression */
+	state->haveDatum1 = (state->indexInfo->ii_IndexAttrNumbers[0] != 0);
+
 	state->tupDesc = tupDesc;	/* assume we need not copy tupDesc */
 
 	indexScanKey = _bt_mkscankey_nodata(indexRel);
@@ -1013,6 +1082,7 @@ tuplesort_begin_index_btree(Relation heapRel,
 	state->heapRel = heapRel;
 	state->indexRel = indexRel;
 	state->enforceUnique = enforceUnique;
+	state->haveDatum1 = true;
 
 	indexScanKey = _bt_mkscankey_nodata(indexRel);
 
@@ -1095,6 +1165,74 @@ tuplesort_begin_index_hash(Relation heapRel,
 	return state;
 }
 
+Tuplesortstate *
+tuplesort_begin_index_gist(Relation heapRel,
+						   Relation indexRel,
+						   int workMem,
+						   SortCoordinate coordinate,
+						   bool randomAccess)
+{
+	Tuplesortstate *state = tuplesort_begin_common(workMem, coordinate,
+												   randomAccess);
+	MemoryContext oldcontext;
+	int			i;
+
+	oldcontext = MemoryContextSwitchTo(state->sortcontext);
+
+#ifdef TRACE_SORT
+	if (trace_sort)
+		elog(LOG,
+			 "begin index sort: workMem = %d, randomAccess = %c",
+			 workMem, randomAccess ? 't' : 'f');
+#endif
+
+	state->nKeys = IndexRelationGetNumberOfKeyAttributes(indexRel);
+
+	TRACE_POSTGRESQL_SORT_START(INDEX_SORT,
+								false,	/* no unique check */
+								state->nKeys,
+								workMem,
+								randomAccess,
+								PARALLEL_SORT(state));
+
+	/* GiST keys are compared by the opclass's sortsupport comparators */
+	state->comparetup = comparetup_index_btree;
+	state->copytup = copytup_index;
+	state->writetup = writetup_index;
+	state->readtup = readtup_index;
+	state->abbrevNext = 10;
+
+	state->heapRel = heapRel;
+	state->indexRel = indexRel;
+	state->enforceUnique = false;
+	state->haveDatum1 = true;
+
+	/* Prepare SortSupport data for each column */
+	state->sortKeys = (SortSupport) palloc0(state->nKeys *
+											sizeof(SortSupportData));
+
+	for (i = 0; i < state->nKeys; i++)
+	{
+		SortSupport sortKey = state->sortKeys + i;
+
+		sortKey->ssup_cxt = CurrentMemoryContext;
+		sortKey->ssup_collation = indexRel->rd_indcollation[i];
+		sortKey->ssup_nulls_first = false;
+		sortKey->ssup_attno = i + 1;
+		/* Convey if abbreviation optimization is applicable in principle */
+		sortKey->abbreviate = (i == 0);
+
+		AssertState(sortKey->ssup_attno != 0);
+
+		/* Look for a sort support function */
+		PrepareSortSupportFromGistIndexRel(indexRel, sortKey);
+	}
+
+	MemoryContextSwitchTo(oldcontext);
+
+	return state;
+}
+
 Tuplesortstate *
 tuplesort_begin_datum(Oid datumType, Oid sortOperator, Oid sortCollation,
 					  bool nullsFirstFlag, int workMem,
@@ -1165,6 +1303,8 @@ tuplesort_begin_datum(Oid datumType, Oid sortOperator, Oid sortCollation,
 	if (!state->sortKeys->abbrev_converter)
 		state->onlyKey = state->sortKeys;
 
+	state->haveDatum1 = true;
+
 	MemoryContextSwitchTo(oldcontext);
 
 	return state;
@@ -1208,6 +1348,15 @@ tuplesort_set_bound(Tuplesortstate *state, int64 bound)
 	state->bounded = true;
 	state->bound = (int) bound;
 
+	/*
+	 * The top-N heap discards tuples one at a time, which a bump context
+	 * wouldn't reclaim.  There are no tuples yet, so just swap the context.
+	 */
+	MemoryContextDelete(state->tuplecontext);
+	state->tuplecontext = AllocSetContextCreate(state->sortcontext,
+												"Caller tuples",
+												ALLOCSET_DEFAULT_SIZES);
+
 	/*
 	 * Bounded sorts are not an effective target for abbreviated key
 	 * optimization.  Disable by setting state to be consistent with no
@@ -2999,10 +3148,10 @@ dumptuples(Tuplesortstate *state, bool alltuples)
 
 	/*
 	 * Reset tuple memory.  We've freed all of the tuples that we previously
-	 * allocated.  It's important to avoid fragmentation when there is a stark
-	 * change in the sizes of incoming tuples.  Fragmentation due to
-	 * AllocSetFree's bucketing by size class might be particularly bad if
-	 * this step wasn't taken.
+	 * allocated, but the bump context that normally holds them only gives
+	 * the space back here.  It's also important to avoid fragmentation when
+	 * there is a stark change in the sizes of incoming tuples, in the
+	 * regular context used by bounded sorts.
 	 */
 	MemoryContextReset(state->tuplecontext);
 
@@ -3300,28 +3449,267 @@ sort_bounded_heap(Tuplesortstate *state)
 	state->boundUsed = true;
 }
 
+/*
+ * Kinds of leading sort key that tuplesort_sort_memtuples() has specialized
+ * routines for, by the ssup_datum_*_cmp comparator in use.
+ */
+typedef enum
+{
+	SORTKEY_UNSIGNED,
+#ifdef USE_FLOAT8_BYVAL
+	SORTKEY_SIGNED,
+#endif
+	SORTKEY_INT32
+} SortKeyKind;
+
+/*
+ * Inputs at least this large are radix sorted; so are the buckets of the
+ * radix sort, recursively.  Smaller ones are left to quicksort.
+ */
+#define RADIX_SORT_MIN_TUPLES	1024
+
+/*
+ * Quicksort with the comparator specialized for the kind of leading key.
+ */
+static void
+qsort_tuple_kind(SortTuple *a, size_t n, SortKeyKind kind,
+				 Tuplesortstate *state)
+{
+	switch (kind)
+	{
+		case SORTKEY_UNSIGNED:
+			qsort_tuple_unsigned(a, n, state);
+			break;
+#ifdef USE_FLOAT8_BYVAL
+		case SORTKEY_SIGNED:
+			qsort_tuple_signed(a, n, state);
+			break;
+#endif
+		case SORTKEY_INT32:
+			qsort_tuple_int32(a, n, state);
+			break;
+	}
+}
+
+/*
+ * Map the (non-NULL) leading key of a SortTuple to a uint64 that sorts the
+ * same way when compared as unsigned, most significant byte first.
+ */
+static inline uint64
+radix_sort_key(const SortTuple *tup, SortKeyKind kind, bool reverse)
+{
+	uint64		key = 0;
+
+	switch (kind)
+	{
+		case SORTKEY_UNSIGNED:
+#if SIZEOF_DATUM == 8
+			key = (uint64) tup->datum1;
+#else
+			key = ((uint64) tup->datum1) << 32;
+#endif
+			break;
+#ifdef USE_FLOAT8_BYVAL
+		case SORTKEY_SIGNED:
+			/* flipping the sign bit makes two's complement sort unsigned */
+			key = ((uint64) DatumGetInt64(tup->datum1)) ^
+				(UINT64CONST(1) << 63);
+			break;
+#endif
+		case SORTKEY_INT32:
+			key = ((uint64) ((uint32) DatumGetInt32(tup->datum1) ^
+							 (uint32) 0x80000000)) << 32;
+			break;
+	}
+
+	return reverse ? ~key : key;
+}
+
+/*
+ * radix_sort_tuple
+ *		MSD radix sort ("American flag sort") of SortTuples with non-NULL
+ *		leading keys, on the bytes of radix_sort_key() from 'level' on.
+ *
+ * Each pass counts the tuples falling into each of 256 buckets by the byte
+ * at hand, permutes them into place, and recurses into the buckets.  Buckets
+ * below RADIX_SORT_MIN_TUPLES are quicksorted instead.  Once all 'nlevels'
+ * bytes are used up the leading keys are equal, and only comparetup can
+ * order the tuples further.  Recursion depth is bounded by 'nlevels'.
+ */
+static void
+radix_sort_tuple(SortTuple *a, size_t n, int level, int nlevels,
+				 SortKeyKind kind, Tuplesortstate *state)
+{
+	bool		reverse = state->sortKeys[0].ssup_reverse;
+	size_t		counts[256];
+	size_t		next[256];
+	size_t		ends[256];
+	size_t		i;
+	int			shift;
+	int			b;
+
+	for (;;)
+	{
+		CHECK_FOR_INTERRUPTS();
+
+		if (n < RADIX_SORT_MIN_TUPLES)
+		{
+			qsort_tuple_kind(a, n, kind, state);
+			return;
+		}
+		if (level >= nlevels)
+		{
+			if (state->onlyKey == NULL)
+				qsort_tuple(a, n, state->comparetup, state);
+			return;
+		}
+
+		shift = 56 - 8 * level;
+		memset(counts, 0, sizeof(counts));
+		for (i = 0; i < n; i++)
+			counts[(radix_sort_key(&a[i], kind, reverse) >> shift) & 0xFF]++;
+
+		/* If all tuples share this byte, just go on to the next one */
+		if (counts[(radix_sort_key(&a[0], kind, reverse) >> shift) & 0xFF] < n)
+			break;
+		level++;
+	}
+
+	next[0] = 0;
+	ends[0] = counts[0];
+	for (b = 1; b < 256; b++)
+	{
+		next[b] = ends[b - 1];
+		ends[b] = next[b] + counts[b];
+	}
+
+	/* Swap each tuple into its bucket */
+	for (b = 0; b < 256; b++)
+	{
+		while (next[b] < ends[b])
+		{
+			SortTuple  *tup = &a[next[b]];
+			int			tb;
+
+			tb = (radix_sort_key(tup, kind, reverse) >> shift) & 0xFF;
+			if (tb == b)
+				next[b]++;
+			else
+			{
+				SortTuple	tmp = *tup;
+
+				*tup = a[next[tb]];
+				a[next[tb]++] = tmp;
+			}
+		}
+	}
+
+	for (b = 0; b < 256; b++)
+	{
+		if (counts[b] > 1)
+			radix_sort_tuple(a + ends[b] - counts[b], counts[b],
+							 level + 1, nlevels, kind, state);
+	}
+}
+
 /*
  * Sort all memtuples using specialized qsort() routines.
  *
  * Quicksort is used for small in-memory sorts, and external sort runs.
+ * When the leading key compares like an integer, large inputs are radix
+ * sorted on it instead, and quicksort uses an inlined comparison of it.
  */
 static void
 tuplesort_sort_memtuples(Tuplesortstate *state)
 {
+	SortTuple  *memtuples = state->memtuples;
+	size_t		n = state->memtupcount;
+	SortSupport leading = state->sortKeys;
+	SortKeyKind kind = SORTKEY_UNSIGNED;
+	bool		specialized = true;
+	int			nlevels;
+	size_t		nnulls;
+	size_t		i;
+	SortTuple  *nulls;
+	SortTuple  *values;
+
 	Assert(!LEADER(state));
 
-	if (state->memtupcount > 1)
+	if (n <= 1)
+		return;
+
+	/* Is there a specialized routine for the leading key? */
+	if (!state->haveDatum1 || leading == NULL)
+		specialized = false;
+	else if (leading->comparator == ssup_datum_unsigned_cmp)
+		kind = SORTKEY_UNSIGNED;
+#ifdef USE_FLOAT8_BYVAL
+	else if (leading->comparator == ssup_datum_signed_cmp)
+		kind = SORTKEY_SIGNED;
+#endif
+	else if (leading->comparator == ssup_datum_int32_cmp)
+		kind = SORTKEY_INT32;
+	else
+		specialized = false;
+
+	if (!specialized)
 	{
 		/* Can we use the single-key sort function? */
 		if (state->onlyKey != NULL)
-			qsort_ssup(state->memtuples, state->memtupcount,
-					   state->onlyKey);
+			qsort_ssup(memtuples, n, state->onlyKey);
 		else
-			qsort_tuple(state->memtuples,
-						state->memtupcount,
-						state->comparetup,
-						state);
+			qsort_tuple(memtuples, n, state->comparetup, state);
+		return;
 	}
+
+	if (n < RADIX_SORT_MIN_TUPLES)
+	{
+		qsort_tuple_kind(memtuples, n, kind, state);
+		return;
+	}
+
+	/*
+	 * Set the tuples with a NULL leading key aside at the end they sort to;
+	 * only comparetup can order them among themselves.
+	 */
+	nnulls = 0;
+	if (leading->ssup_nulls_first)
+	{
+		for (i = 0; i < n; i++)
+		{
+			if (memtuples[i].isnull1)
+			{
+				SortTuple	tmp = memtuples[i];
+
+				memtuples[i] = memtuples[nnulls];
+				memtuples[nnulls++] = tmp;
+			}
+		}
+		nulls = memtuples;
+		values = memtuples + nnulls;
+	}
+	else
+	{
+		for (i = n; i > 0; i--)
+		{
+			if (memtuples[i - 1].isnull1)
+			{
+				SortTuple	tmp = memtuples[i - 1];
+
+				memtuples[i - 1] = memtuples[n - 1 - nnulls];
+				memtuples[n - 1 - nnulls++] = tmp;
+			}
+		}
+		values = memtuples;
+		nulls = memtuples + (n - nnulls);
+	}
+
+	if (nnulls > 1 && state->onlyKey == NULL)
+		qsort_tuple(nulls, nnulls, state->comparetup, state);
+
+	nlevels = (kind == SORTKEY_INT32 || SIZEOF_DATUM < 8) ? 4 : 8;
+	if (n - nnulls > 1)
+		radix_sort_tuple(values, n - nnulls, 0, nlevels, kind, state);
 }
 
 /*
@@ -3947,7 +4335,8 @@ readtup_cluster(Tuplesortstate *state, SortTuple *stup,
  *
  * The btree and hash cases require separate comparison functions, but the
  * IndexTuple representation is the same so the copy/write/read support
- * functions can be shared.
+ * functions can be shared.  GiST sorts use the btree comparison function,
+ * with sortsupport comparators supplied by the GiST opclasses.
  */
 
 static int
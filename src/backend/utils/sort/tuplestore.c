@@ -20,7 +20,10 @@
  * in kilobytes by the caller.  We absorb tuples and simply store them in an
  * in-memory array as long as we haven't exceeded maxKBytes.  If we do exceed
  * maxKBytes, we dump all the tuples into a temp file and then read from that
- * when needed.
+ * when needed.  A quarter of the memory allowance (up to a limit) is then
+ * given over to a cache of temp file blocks, which lets read pointers that
+ * trail the write position, or that reread the same stretch of the file,
+ * mostly avoid actual reads; see BufFileSetCache.
  *
  * Upon creation, a tuplestore supports a single read pointer, numbered 0.
  * Additional read pointers can be created using tuplestore_alloc_read_pointer.
@@ -65,6 +68,13 @@
 #include "utils/resowner.h"
 
 
+/*
+ * Upper limit on the number of temp file blocks cached for a tuplestore that
+ * has spilled to disk.
+ */
+#define TUPLESTORE_MAX_CACHE_BLOCKS 256
+
+
 /*
  * Possible states of a Tuplestore object.  These denote the states that
  * persist between calls of Tuplestore routines.
@@ -111,6 +121,7 @@ struct Tuplestorestate
 	int64		allowedMem;		/* total memory allowed, in bytes */
 	int64		tuples;			/* number of tuples added */
 	BufFile    *myfile;			/* underlying file, or NULL if none */
+	int			cacheblocks;	/* size of myfile's block cache */
 	MemoryContext context;		/* memory context for holding tuples */
 	ResourceOwner resowner;		/* resowner for holding temp files */
 
@@ -263,6 +274,7 @@ tuplestore_begin_common(int eflags, bool interXact, int maxKBytes)
 	state->allowedMem = maxKBytes * 1024L;
 	state->availMem = state->allowedMem;
 	state->myfile = NULL;
+	state->cacheblocks = 0;
 	state->context = CurrentMemoryContext;
 	state->resowner = CurrentResourceOwner;
 
@@ -423,6 +435,8 @@ tuplestore_clear(Tuplestorestate *state)
 	if (state->myfile)
 		BufFileClose(state->myfile);
 	state->myfile = NULL;
+	FREEMEM(state, (int64) state->cacheblocks * BLCKSZ);
+	state->cacheblocks = 0;
 	if (state->memtuples)
 	{
 		for (i = state->memtupdeleted; i < state->memtupcount; i++)
@@ -822,6 +836,21 @@ tuplestore_puttuple_common(Tuplestorestate *state, void *tuple)
 
 			CurrentResourceOwner = oldowner;
 
+			/*
+			 * Give part of our memory allowance to a block cache for the
+			 * file.  The tuples are about to go to disk, so the space will
+			 * be available once they've been dumped.
+			 */
+			state->cacheblocks = (int) Min(state->allowedMem / 4 / BLCKSZ,
+										   TUPLESTORE_MAX_CACHE_BLOCKS);
+			if (state->cacheblocks >= 2)
+			{
+				BufFileSetCache(state->myfile, state->cacheblocks);
+				USEMEM(state, (int64) state->cacheblocks * BLCKSZ);
+			}
+			else
+				state->cacheblocks = 0;
+
 			/*
 			 * Freeze the decision about whether trailing length words will be
 			 * used.  We can't change this choice once data is on tape, even
@@ -1519,11 +1519,28 @@ XidInMVCCSnapshot(TransactionId xid, Snapshot snapshot)
 		}
 		else
 		{
+			TransactionId topxid;
+
 			/*
-			 * Snapshot overflowed, so convert xid to top-level.  This is safe
-			 * because we eliminated too-old XIDs above.
+			 * Snapshot overflowed.  Most XIDs we are asked about are
+			 * top-level ones, and those can be found in xip[] directly, so
+			 * try that before paying for a pg_subtrans lookup.
 			 */
-			xid = SubTransGetTopmostTransaction(xid);
+			for (i = 0; i < snapshot->xcnt; i++)
+			{
+				if (TransactionIdEquals(xid, snapshot->xip[i]))
+					return true;
+			}
+
+			/*
+			 * Not a running top-level xact, so convert xid to top-level.
+			 * This is safe because we eliminated too-old XIDs above.  If
+			 * that doesn't change anything, we already know the answer.
+			 */
+			topxid = SubTransGetTopmostTransaction(xid);
+			if (TransactionIdEquals(topxid, xid))
+				return false;
+			xid = topxid;
 
 			/*
 			 * If xid was indeed a subxact, we might now have an xid < xmin,
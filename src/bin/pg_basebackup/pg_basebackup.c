@@ -13,6 +13,7 @@
 
 #include "postgres_fe.h"
 
+#include <limits.h>
 #include <unistd.h>
 #include <dirent.h>
 #include <sys/stat.h>
@@ -27,7 +28,9 @@
 #endif
 
 #include "access/xlog_internal.h"
+#include "catalog/pg_tablespace_d.h"
 #include "common/file_perm.h"
+#include "common/relpath.h"
 #include "common/file_utils.h"
 #include "common/string.h"
 #include "fe_utils/string_utils.h"
@@ -36,6 +39,7 @@
 #include "pqexpbuffer.h"
 #include "pgtar.h"
 #include "pgtime.h"
+#include "port/pg_bswap.h"
 #include "receivelog.h"
 #include "replication/basebackup.h"
 #include "streamutil.h"
@@ -99,6 +103,11 @@ static bool temp_replication_slot = true;
 static bool create_slot = false;
 static bool no_slot = false;
 static bool verify_checksums = true;
+static ReplCompressionMethod stream_compression = REPL_COMPRESSION_NONE;
+static ReplCompressionMethod server_compression = REPL_COMPRESSION_NONE;
+static char *incremental_from = NULL;
+static XLogRecPtr incremental_lsn = InvalidXLogRecPtr;
+static PQExpBuffer incremental_dbs = NULL;
 
 static bool success = false;
 static bool made_new_pgdata = false;
@@ -131,6 +140,25 @@ static int	has_xlogendptr = 0;
 static volatile LONG has_xlogendptr = 0;
 #endif
 
+/*
+ * State of a file being reconstructed from an incremental file sent by the
+ * server and the same file in the prior backup, see basebackup.h.
+ */
+typedef struct IncrementalFile
+{
+	char		priorpath[MAXPGPATH];	/* the file in the prior backup */
+	char	   *meta;			/* header and block list */
+	size_t		metalen;		/* bytes of them received so far */
+	size_t		metasize;		/* size of them, once the header is in */
+	bool		started;		/* have we got all of them? */
+	uint32		nblocks;		/* number of blocks included */
+	uint32		truncation_length;	/* length of the file, in blocks */
+	uint32	   *blocks;			/* block numbers of the blocks included */
+	pgoff_t		datalen;		/* bytes of block data received so far */
+} IncrementalFile;
+
+#define INCREMENTAL_HEADER_SIZE	(3 * sizeof(uint32))
+
 /* Contents of configuration file to be generated */
 static PQExpBuffer recoveryconfcontents = NULL;
 
@@ -140,6 +168,14 @@ static void disconnect_and_exit(int code) pg_attribute_noreturn();
 static void verify_dir_is_empty_or_create(char *dirname, bool *created, bool *found);
 static void progress_report(int tablespacenum, const char *filename, bool force);
 
+static int	GetBackupCopyData(PGconn *conn, char **buffer);
+static void PrepareIncrementalBackup(void);
+static void AddIncrementalDatabases(const char *dir, Oid spcoid);
+static void IncrementalFileWrite(IncrementalFile *inc, FILE *file,
+					 const char *filename, char *data, int len);
+static void IncrementalFileStart(IncrementalFile *inc, FILE *file,
+					 const char *filename);
+static void IncrementalFileFinish(IncrementalFile *inc, const char *filename);
 static void ReceiveTarFile(PGconn *conn, PGresult *res, int rownum);
 static void ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum);
 static void GenerateRecoveryConf(PGconn *conn);
@@ -354,6 +390,11 @@ usage(void)
 			 "                         include required WAL files with specified method\n"));
 	printf(_("  -z, --gzip             compress tar output\n"));
 	printf(_("  -Z, --compress=0-9     compress tar output with given compression level\n"));
+	printf(_("      --server-compression=METHOD\n"
+			 "                         have the server compress the backup in transit with METHOD\n"));
+	printf(_("      --incremental-from=DIR\n"
+			 "                         take an incremental backup against the plain format\n"
+			 "                         backup in DIR\n"));
 	printf(_("\nGeneral options:\n"));
 	printf(_("  -c, --checkpoint=fast|spread\n"
 			 "                         set fast or spread checkpointing\n"));
@@ -368,6 +409,8 @@ usage(void)
 	printf(_("      --no-slot          prevent creation of temporary replication slot\n"));
 	printf(_("      --no-verify-checksums\n"
 			 "                         do not verify checksums\n"));
+	printf(_("      --stream-compression=METHOD\n"
+			 "                         compress streamed WAL in transit with METHOD\n"));
 	printf(_("  -?, --help             show this help, then exit\n"));
 	printf(_("\nConnection options:\n"));
 	printf(_("  -d, --dbname=CONNSTR   connection string\n"));
@@ -505,6 +548,7 @@ LogStreamerMain(logstreamer_param *param)
 	stream.mark_done = true;
 	stream.partial_suffix = NULL;
 	stream.replication_slot = replication_slot;
+	stream.compression = stream_compression;
 
 	if (format == 'p')
 		stream.walmethod = CreateWalDirectoryMethod(param->xlog, 0, do_sync);
@@ -954,6 +998,77 @@ writeTarData(
 #define WRITE_TAR_DATA(buf, sz) writeTarData(tarfile, buf, sz, filename)
 #endif
 
+/*
+ * Receive the next CopyData message of a tar stream, like PQgetCopyData(),
+ * and decompress it if the server was asked to compress the tar streams.
+ *
+ * *buffer is set to point to the data, which remains valid until the next
+ * call; the caller must not free it.
+ */
+static int
+GetBackupCopyData(PGconn *conn, char **buffer)
+{
+	static char *copybuf = NULL;
+	static char *decompress_buf = NULL;
+	static int	decompress_buf_size = 0;
+	uint32		rawlen;
+	int			r;
+
+	if (copybuf != NULL)
+	{
+		PQfreemem(copybuf);
+		copybuf = NULL;
+	}
+
+	r = PQgetCopyData(conn, &copybuf, 0);
+	*buffer = copybuf;
+	if (r < 0 || server_compression == REPL_COMPRESSION_NONE)
+		return r;
+
+	/*
+	 * Each message holds the length of one chunk of the tar stream, followed
+	 * by the chunk either compressed or, if that didn't make it smaller, as it
+	 * is.
+	 */
+	if (r < sizeof(uint32))
+	{
+		fprintf(stderr, _("%s: invalid compressed COPY data\n"), progname);
+		disconnect_and_exit(1);
+	}
+	memcpy(&rawlen, copybuf, sizeof(uint32));
+	rawlen = pg_ntoh32(rawlen);
+	r -= sizeof(uint32);
+
+	if (rawlen == r)
+	{
+		*buffer = copybuf + sizeof(uint32);
+		return r;
+	}
+
+	if (rawlen > INT_MAX)
+	{
+		fprintf(stderr, _("%s: invalid compressed COPY data\n"), progname);
+		disconnect_and_exit(1);
+	}
+	if ((int) rawlen > decompress_buf_size)
+	{
+		if (decompress_buf)
+			pg_free(decompress_buf);
+		decompress_buf = pg_malloc(rawlen);
+		decompress_buf_size = rawlen;
+	}
+
+	if (repl_decompress(server_compression, copybuf + sizeof(uint32), r,
+						decompress_buf, rawlen) < 0)
+	{
+		fprintf(stderr, _("%s: could not decompress COPY data\n"), progname);
+		disconnect_and_exit(1);
+	}
+
+	*buffer = decompress_buf;
+	return rawlen;
+}
+
 /*
  * Receive a tar format file from the connection to the server, and write
  * the data from this file directly into a tar file. If compression is
@@ -1105,13 +1220,7 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 	{
 		int			r;
 
-		if (copybuf != NULL)
-		{
-			PQfreemem(copybuf);
-			copybuf = NULL;
-		}
-
-		r = PQgetCopyData(conn, &copybuf, 0);
+		r = GetBackupCopyData(conn, &copybuf);
 		if (r == -1)
 		{
 			/*
@@ -1359,9 +1468,6 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 	}							/* while (1) */
 	progress_report(rownum, filename, true);
 
-	if (copybuf != NULL)
-		PQfreemem(copybuf);
-
 	/* sync the resulting tar file, errors are not considered fatal */
 	if (do_sync && strcmp(basedir, "-") != 0)
 		(void) fsync_fname(filename, false, progname);
@@ -1410,6 +1516,9 @@ ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum)
 	bool		basetablespace;
 	char	   *copybuf = NULL;
 	FILE	   *file = NULL;
+	char		prior_path[MAXPGPATH];
+	IncrementalFile inc;
+	bool		in_incremental = false;
 
 	basetablespace = PQgetisnull(res, rownum, 0);
 	if (basetablespace)
@@ -1419,6 +1528,15 @@ ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum)
 				get_tablespace_mapping(PQgetvalue(res, rownum, 1)),
 				sizeof(current_path));
 
+	/* Where the files of this tablespace are in the prior backup */
+	if (incremental_from == NULL)
+		prior_path[0] = '\0';
+	else if (basetablespace)
+		strlcpy(prior_path, incremental_from, sizeof(prior_path));
+	else
+		snprintf(prior_path, sizeof(prior_path), "%s/pg_tblspc/%s",
+				 incremental_from, PQgetvalue(res, rownum, 0));
+
 	/*
 	 * Get the COPY data
 	 */
@@ -1434,13 +1552,7 @@ ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum)
 	{
 		int			r;
 
-		if (copybuf != NULL)
-		{
-			PQfreemem(copybuf);
-			copybuf = NULL;
-		}
-
-		r = PQgetCopyData(conn, &copybuf, 0);
+		r = GetBackupCopyData(conn, &copybuf);
 
 		if (r == -1)
 		{
@@ -1567,8 +1679,27 @@ ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum)
 			}
 
 			/*
-			 * regular file
+			 * regular file, or an incremental file to reconstruct the file
+			 * named without the prefix from
 			 */
+			if (incremental_from != NULL)
+			{
+				char	   *lastsep = last_dir_separator(filename);
+				size_t		prefixlen = strlen(INCREMENTAL_PREFIX);
+
+				if (lastsep != NULL &&
+					strncmp(lastsep + 1, INCREMENTAL_PREFIX, prefixlen) == 0)
+				{
+					memmove(lastsep + 1, lastsep + 1 + prefixlen,
+							strlen(lastsep + 1 + prefixlen) + 1);
+
+					MemSet(&inc, 0, sizeof(inc));
+					snprintf(inc.priorpath, sizeof(inc.priorpath), "%s/%s",
+							 prior_path, filename + strlen(current_path) + 1);
+					in_incremental = true;
+				}
+			}
+
 			file = fopen(filename, "wb");
 			if (!file)
 			{
@@ -1604,13 +1735,20 @@ ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum)
 				 * Received the padding block for this file, ignore it and
 				 * close the file, then move on to the next tar header.
 				 */
+				if (in_incremental)
+				{
+					IncrementalFileFinish(&inc, filename);
+					in_incremental = false;
+				}
 				fclose(file);
 				file = NULL;
 				totaldone += r;
 				continue;
 			}
 
-			if (fwrite(copybuf, r, 1, file) != 1)
+			if (in_incremental)
+				IncrementalFileWrite(&inc, file, filename, copybuf, r);
+			else if (fwrite(copybuf, r, 1, file) != 1)
 			{
 				fprintf(stderr, _("%s: could not write to file \"%s\": %s\n"),
 						progname, filename, strerror(errno));
@@ -1627,6 +1765,11 @@ ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum)
 				 * expected. Close the file and move on to the next tar
 				 * header.
 				 */
+				if (in_incremental)
+				{
+					IncrementalFileFinish(&inc, filename);
+					in_incremental = false;
+				}
 				fclose(file);
 				file = NULL;
 				continue;
@@ -1643,9 +1786,6 @@ ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum)
 		disconnect_and_exit(1);
 	}
 
-	if (copybuf != NULL)
-		PQfreemem(copybuf);
-
 	if (basetablespace && writerecoveryconf)
 		WriteRecoveryConf();
 
@@ -1655,6 +1795,273 @@ ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum)
 	 */
 }
 
+/*
+ * Process data of an incremental file received from the server, which is
+ * written to 'file'.
+ */
+static void
+IncrementalFileWrite(IncrementalFile *inc, FILE *file, const char *filename,
+					 char *data, int len)
+{
+	while (len > 0)
+	{
+		uint32		idx;
+		int			off;
+		int			n;
+
+		if (!inc->started)
+		{
+			/* Collect the header, and then the block list */
+			size_t		want;
+
+			if (inc->meta == NULL)
+				inc->meta = pg_malloc(INCREMENTAL_HEADER_SIZE);
+
+			if (inc->metalen < INCREMENTAL_HEADER_SIZE)
+				want = INCREMENTAL_HEADER_SIZE - inc->metalen;
+			else
+				want = inc->metasize - inc->metalen;
+			n = Min(want, len);
+			memcpy(inc->meta + inc->metalen, data, n);
+			inc->metalen += n;
+			data += n;
+			len -= n;
+
+			if (inc->metalen == INCREMENTAL_HEADER_SIZE)
+			{
+				uint32		hdr[3];
+
+				memcpy(hdr, inc->meta, sizeof(hdr));
+				if (pg_ntoh32(hdr[0]) != INCREMENTAL_MAGIC)
+				{
+					fprintf(stderr, _("%s: invalid incremental file \"%s\"\n"),
+							progname, filename);
+					disconnect_and_exit(1);
+				}
+				inc->nblocks = pg_ntoh32(hdr[1]);
+				inc->truncation_length = pg_ntoh32(hdr[2]);
+				if (inc->nblocks > inc->truncation_length)
+				{
+					fprintf(stderr, _("%s: invalid incremental file \"%s\"\n"),
+							progname, filename);
+					disconnect_and_exit(1);
+				}
+				inc->metasize = INCREMENTAL_HEADER_SIZE +
+					(size_t) inc->nblocks * sizeof(uint32);
+				inc->meta = pg_realloc(inc->meta, inc->metasize);
+			}
+
+			if (inc->metalen >= INCREMENTAL_HEADER_SIZE &&
+				inc->metalen == inc->metasize)
+				IncrementalFileStart(inc, file, filename);
+			continue;
+		}
+
+		/* Block data: write it into place */
+		idx = inc->datalen / BLCKSZ;
+		off = inc->datalen % BLCKSZ;
+		if (idx >= inc->nblocks)
+		{
+			fprintf(stderr, _("%s: invalid incremental file \"%s\"\n"),
+					progname, filename);
+			disconnect_and_exit(1);
+		}
+		n = Min(len, BLCKSZ - off);
+
+		if (fseeko(file, (pgoff_t) inc->blocks[idx] * BLCKSZ + off,
+				   SEEK_SET) != 0 ||
+			fwrite(data, n, 1, file) != 1)
+		{
+			fprintf(stderr, _("%s: could not write to file \"%s\": %s\n"),
+					progname, filename, strerror(errno));
+			disconnect_and_exit(1);
+		}
+		inc->datalen += n;
+		data += n;
+		len -= n;
+	}
+}
+
+/*
+ * Having received the block list of an incremental file, copy the unchanged
+ * blocks from the file in the prior backup.
+ */
+static void
+IncrementalFileStart(IncrementalFile *inc, FILE *file, const char *filename)
+{
+	FILE	   *prior;
+	char		buf[BLCKSZ];
+	uint32		nprior = 0;
+	uint32		nmissing;
+	uint32		i;
+
+	inc->blocks = (uint32 *) (inc->meta + INCREMENTAL_HEADER_SIZE);
+	for (i = 0; i < inc->nblocks; i++)
+	{
+		inc->blocks[i] = pg_ntoh32(inc->blocks[i]);
+		if (inc->blocks[i] >= inc->truncation_length ||
+			(i > 0 && inc->blocks[i] <= inc->blocks[i - 1]))
+		{
+			fprintf(stderr, _("%s: invalid incremental file \"%s\"\n"),
+					progname, filename);
+			disconnect_and_exit(1);
+		}
+	}
+
+	prior = fopen(inc->priorpath, PG_BINARY_R);
+	if (prior == NULL && errno != ENOENT)
+	{
+		fprintf(stderr, _("%s: could not open file \"%s\": %s\n"),
+				progname, inc->priorpath, strerror(errno));
+		disconnect_and_exit(1);
+	}
+	if (prior != NULL)
+	{
+		while (nprior < inc->truncation_length &&
+			   fread(buf, BLCKSZ, 1, prior) == 1)
+		{
+			if (fwrite(buf, BLCKSZ, 1, file) != 1)
+			{
+				fprintf(stderr, _("%s: could not write to file \"%s\": %s\n"),
+						progname, filename, strerror(errno));
+				disconnect_and_exit(1);
+			}
+			nprior++;
+		}
+		if (ferror(prior))
+		{
+			fprintf(stderr, _("%s: could not read file \"%s\": %s\n"),
+					progname, inc->priorpath, strerror(errno));
+			disconnect_and_exit(1);
+		}
+		fclose(prior);
+	}
+
+	/* Every block past the end of the prior file must be included */
+	nmissing = inc->truncation_length - nprior;
+	for (i = 0; i < inc->nblocks; i++)
+		if (inc->blocks[i] >= nprior)
+			nmissing--;
+	if (nmissing > 0)
+	{
+		fprintf(stderr,
+				_("%s: cannot reconstruct file \"%s\": %u blocks are neither in the prior backup nor sent by the server\n"),
+				progname, filename, nmissing);
+		disconnect_and_exit(1);
+	}
+
+	inc->started = true;
+}
+
+/*
+ * Check that we got all of an incremental file.
+ */
+static void
+IncrementalFileFinish(IncrementalFile *inc, const char *filename)
+{
+	if (!inc->started || inc->datalen != (pgoff_t) inc->nblocks * BLCKSZ)
+	{
+		fprintf(stderr, _("%s: incremental file \"%s\" is incomplete\n"),
+				progname, filename);
+		disconnect_and_exit(1);
+	}
+	pg_free(inc->meta);
+	inc->meta = NULL;
+}
+
+/*
+ * Set up an incremental backup against the plain format backup in
+ * incremental_from: find the LSN it started at in its backup_label, and list
+ * the databases it contains, whose files the server can send incrementally.
+ */
+static void
+PrepareIncrementalBackup(void)
+{
+	char		path[MAXPGPATH];
+	char		line[MAXPGPATH];
+	FILE	   *fp;
+	DIR		   *dir;
+	struct dirent *de;
+	uint32		hi,
+				lo;
+	bool		found = false;
+
+	snprintf(path, sizeof(path), "%s/backup_label", incremental_from);
+	fp = fopen(path, "r");
+	if (fp == NULL)
+	{
+		fprintf(stderr, _("%s: could not open file \"%s\": %s\n"),
+				progname, path, strerror(errno));
+		disconnect_and_exit(1);
+	}
+	while (fgets(line, sizeof(line), fp) != NULL)
+	{
+		if (sscanf(line, "START WAL LOCATION: %X/%X", &hi, &lo) == 2)
+		{
+			found = true;
+			break;
+		}
+	}
+	fclose(fp);
+	if (!found)
+	{
+		fprintf(stderr, _("%s: could not find the start WAL location in \"%s\"\n"),
+				progname, path);
+		disconnect_and_exit(1);
+	}
+	incremental_lsn = ((uint64) hi) << 32 | lo;
+
+	incremental_dbs = createPQExpBuffer();
+
+	snprintf(path, sizeof(path), "%s/base", incremental_from);
+	AddIncrementalDatabases(path, DEFAULTTABLESPACE_OID);
+
+	snprintf(path, sizeof(path), "%s/pg_tblspc", incremental_from);
+	dir = opendir(path);
+	if (dir == NULL)
+	{
+		fprintf(stderr, _("%s: could not open directory \"%s\": %s\n"),
+				progname, path, strerror(errno));
+		disconnect_and_exit(1);
+	}
+	while (errno = 0, (de = readdir(dir)) != NULL)
+	{
+		char		spcpath[MAXPGPATH];
+
+		if (strspn(de->d_name, "0123456789") != strlen(de->d_name))
+			continue;
+		snprintf(spcpath, sizeof(spcpath), "%s/%s/%s", path, de->d_name,
+				 TABLESPACE_VERSION_DIRECTORY);
+		AddIncrementalDatabases(spcpath, atooid(de->d_name));
+	}
+	closedir(dir);
+}
+
+/*
+ * Add the databases in a tablespace directory of the prior backup to
+ * incremental_dbs, as "tablespace/database".
+ */
+static void
+AddIncrementalDatabases(const char *path, Oid spcoid)
+{
+	DIR		   *dir;
+	struct dirent *de;
+
+	dir = opendir(path);
+	if (dir == NULL)
+		return;					/* tablespace not in the prior backup */
+	while ((de = readdir(dir)) != NULL)
+	{
+		if (de->d_name[0] == '\0' ||
+			strspn(de->d_name, "0123456789") != strlen(de->d_name))
+			continue;
+		appendPQExpBuffer(incremental_dbs, "%s%u/%s",
+						  incremental_dbs->len > 0 ? "," : "",
+						  spcoid, de->d_name);
+	}
+	closedir(dir);
+}
+
 /*
  * Escape a string so that it can be used as a value in a key-value pair
  * a configuration file.
@@ -1806,6 +2213,8 @@ BaseBackup(void)
 	char	   *basebkp;
 	char		escaped_label[MAXPGPATH];
 	char	   *maxrate_clause = NULL;
+	char	   *compression_clause = NULL;
+	char	   *incremental_clause = NULL;
 	int			i;
 	char		xlogstart[64];
 	char		xlogend[64];
@@ -1847,6 +2256,26 @@ BaseBackup(void)
 		disconnect_and_exit(1);
 	}
 
+	/*
+	 * Compression of the backup by the server was added in version 12.
+	 */
+	if (server_compression != REPL_COMPRESSION_NONE && serverMajor < 1200)
+	{
+		fprintf(stderr, _("%s: --server-compression requires server version 12 or later\n"),
+				progname);
+		disconnect_and_exit(1);
+	}
+
+	/*
+	 * So were incremental backups.
+	 */
+	if (incremental_from != NULL && serverMajor < 1200)
+	{
+		fprintf(stderr, _("%s: --incremental-from requires server version 12 or later\n"),
+				progname);
+		disconnect_and_exit(1);
+	}
+
 	/*
 	 * Build contents of configuration file if requested
 	 */
@@ -1867,6 +2296,19 @@ BaseBackup(void)
 	if (maxrate > 0)
 		maxrate_clause = psprintf("MAX_RATE %u", maxrate);
 
+	if (server_compression != REPL_COMPRESSION_NONE)
+		compression_clause = psprintf("COMPRESSION '%s'",
+									  repl_compression_name(server_compression));
+
+	if (incremental_from != NULL)
+	{
+		PrepareIncrementalBackup();
+		incremental_clause =
+			psprintf("INCREMENTAL '%X/%X' INCREMENTAL_DATABASES '%s'",
+					 (uint32) (incremental_lsn >> 32), (uint32) incremental_lsn,
+					 incremental_dbs->data);
+	}
+
 	if (verbose)
 		fprintf(stderr,
 				_("%s: initiating base backup, waiting for checkpoint to complete\n"),
@@ -1882,7 +2324,7 @@ BaseBackup(void)
 	}
 
 	basebkp =
-		psprintf("BASE_BACKUP LABEL '%s' %s %s %s %s %s %s %s",
+		psprintf("BASE_BACKUP LABEL '%s' %s %s %s %s %s %s %s %s %s",
 				 escaped_label,
 				 showprogress ? "PROGRESS" : "",
 				 includewal == FETCH_WAL ? "WAL" : "",
@@ -1890,7 +2332,9 @@ BaseBackup(void)
 				 includewal == NO_WAL ? "" : "NOWAIT",
 				 maxrate_clause ? maxrate_clause : "",
 				 format == 't' ? "TABLESPACE_MAP" : "",
-				 verify_checksums ? "" : "NOVERIFY_CHECKSUMS");
+				 verify_checksums ? "" : "NOVERIFY_CHECKSUMS",
+				 compression_clause ? compression_clause : "",
+				 incremental_clause ? incremental_clause : "");
 
 	if (PQsendQuery(conn, basebkp) == 0)
 	{
@@ -2225,6 +2669,9 @@ main(int argc, char **argv)
 		{"waldir", required_argument, NULL, 1},
 		{"no-slot", no_argument, NULL, 2},
 		{"no-verify-checksums", no_argument, NULL, 3},
+		{"stream-compression", required_argument, NULL, 4},
+		{"server-compression", required_argument, NULL, 5},
+		{"incremental-from", required_argument, NULL, 6},
 		{NULL, 0, NULL, 0}
 	};
 	int			c;
@@ -2396,6 +2843,38 @@ main(int argc, char **argv)
 			case 3:
 				verify_checksums = false;
 				break;
+			case 4:
+				if (!repl_compression_parse(optarg, &stream_compression))
+				{
+					fprintf(stderr, _("%s: invalid stream compression method \"%s\"\n"),
+							progname, optarg);
+					exit(1);
+				}
+				if (!repl_compression_supported(stream_compression))
+				{
+					fprintf(stderr, _("%s: stream compression method \"%s\" is not supported by this build\n"),
+							progname, optarg);
+					exit(1);
+				}
+				break;
+			case 5:
+				if (!repl_compression_parse(optarg, &server_compression))
+				{
+					fprintf(stderr, _("%s: invalid server compression method \"%s\"\n"),
+							progname, optarg);
+					exit(1);
+				}
+				if (!repl_compression_supported(server_compression))
+				{
+					fprintf(stderr, _("%s: server compression method \"%s\" is not supported by this build\n"),
+							progname, optarg);
+					exit(1);
+				}
+				break;
+			case 6:
+				incremental_from = pg_strdup(optarg);
+				canonicalize_path(incremental_from);
+				break;
 			default:
 
 				/*
@@ -2454,6 +2933,26 @@ main(int argc, char **argv)
 		exit(1);
 	}
 
+	if (incremental_from != NULL && format != 'p')
+	{
+		fprintf(stderr,
+				_("%s: incremental backups are only supported in plain mode\n"),
+				progname);
+		fprintf(stderr, _("Try \"%s --help\" for more information.\n"),
+				progname);
+		exit(1);
+	}
+
+	if (stream_compression != REPL_COMPRESSION_NONE && includewal != STREAM_WAL)
+	{
+		fprintf(stderr,
+				_("%s: stream compression can only be used with WAL streaming\n"),
+				progname);
+		fprintf(stderr, _("Try \"%s --help\" for more information.\n"),
+				progname);
+		exit(1);
+	}
+
 	if (replication_slot && includewal != STREAM_WAL)
 	{
 		fprintf(stderr,
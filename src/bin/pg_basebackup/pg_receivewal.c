@@ -45,6 +45,7 @@ static bool do_sync = true;
 static bool synchronous = false;
 static char *replication_slot = NULL;
 static XLogRecPtr endpos = InvalidXLogRecPtr;
+static ReplCompressionMethod stream_compression = REPL_COMPRESSION_NONE;
 
 
 static void usage(void);
@@ -87,6 +88,8 @@ usage(void)
 	printf(_("  -s, --status-interval=SECS\n"
 			 "                         time between status packets sent to server (default: %d)\n"), (standby_message_timeout / 1000));
 	printf(_("  -S, --slot=SLOTNAME    replication slot to use\n"));
+	printf(_("      --stream-compression=METHOD\n"
+			 "                         compress streamed WAL in transit with METHOD\n"));
 	printf(_("      --synchronous      flush write-ahead log immediately after writing\n"));
 	printf(_("  -v, --verbose          output verbose messages\n"));
 	printf(_("  -V, --version          output version information, then exit\n"));
@@ -440,6 +443,7 @@ StreamLog(void)
 												stream.do_sync);
 	stream.partial_suffix = ".partial";
 	stream.replication_slot = replication_slot;
+	stream.compression = stream_compression;
 
 	ReceiveXlogStream(conn, &stream);
 
@@ -497,6 +501,7 @@ main(int argc, char **argv)
 		{"if-not-exists", no_argument, NULL, 3},
 		{"synchronous", no_argument, NULL, 4},
 		{"no-sync", no_argument, NULL, 5},
+		{"stream-compression", required_argument, NULL, 6},
 		{NULL, 0, NULL, 0}
 	};
 
@@ -609,6 +614,20 @@ main(int argc, char **argv)
 			case 5:
 				do_sync = false;
 				break;
+			case 6:
+				if (!repl_compression_parse(optarg, &stream_compression))
+				{
+					fprintf(stderr, _("%s: invalid stream compression method \"%s\"\n"),
+							progname, optarg);
+					exit(1);
+				}
+				if (!repl_compression_supported(stream_compression))
+				{
+					fprintf(stderr, _("%s: stream compression method \"%s\" is not supported by this build\n"),
+							progname, optarg);
+					exit(1);
+				}
+				break;
 			default:
 
 				/*
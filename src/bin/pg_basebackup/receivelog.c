@@ -14,6 +14,7 @@
 
 #include "postgres_fe.h"
 
+#include <limits.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #ifdef HAVE_SYS_SELECT_H
@@ -27,6 +28,7 @@
 #include "libpq-fe.h"
 #include "access/xlog_internal.h"
 #include "common/file_utils.h"
+#include "port/pg_bswap.h"
 
 
 /* fd and filename for currently open WAL file */
@@ -37,6 +39,10 @@ static XLogRecPtr lastFlushPosition = InvalidXLogRecPtr;
 
 static bool still_sending = true;	/* feedback still needs to be sent? */
 
+/* buffer to decompress compressed XLogData messages in */
+static char *decompress_buf = NULL;
+static int	decompress_buf_size = 0;
+
 static PGresult *HandleCopyStream(PGconn *conn, StreamCtl *stream,
 				 XLogRecPtr *stoppos);
 static int	CopyStreamPoll(PGconn *conn, long timeout_ms, pgsocket stop_socket);
@@ -441,6 +447,9 @@ CheckServerVersionForStreaming(PGconn *conn)
  * If 'synchronous' is true, the received WAL is flushed as soon as written,
  * otherwise only when the WAL file is closed.
  *
+ * If 'compression' is not REPL_COMPRESSION_NONE, the server is asked to
+ * compress the WAL it sends with that method.
+ *
  * Note: The WAL location *must* be at a log segment start!
  */
 bool
@@ -448,6 +457,7 @@ ReceiveXlogStream(PGconn *conn, StreamCtl *stream)
 {
 	char		query[128];
 	char		slotcmd[128];
+	char		optcmd[64];
 	PGresult   *res;
 	XLogRecPtr	stoppos;
 
@@ -576,10 +586,15 @@ ReceiveXlogStream(PGconn *conn, StreamCtl *stream)
 			return true;
 
 		/* Initiate the replication stream at specified location */
-		snprintf(query, sizeof(query), "START_REPLICATION %s%X/%X TIMELINE %u",
+		if (stream->compression != REPL_COMPRESSION_NONE)
+			snprintf(optcmd, sizeof(optcmd), " (compression '%s')",
+					 repl_compression_name(stream->compression));
+		else
+			optcmd[0] = '\0';
+		snprintf(query, sizeof(query), "START_REPLICATION %s%X/%X TIMELINE %u%s",
 				 slotcmd,
 				 (uint32) (stream->startpos >> 32), (uint32) stream->startpos,
-				 stream->timeline);
+				 stream->timeline, optcmd);
 		res = PQexec(conn, query);
 		if (PQresultStatus(res) != PGRES_COPY_BOTH)
 		{
@@ -841,7 +856,7 @@ HandleCopyStream(PGconn *conn, StreamCtl *stream,
 										 &last_status))
 					goto error;
 			}
-			else if (copybuf[0] == 'w')
+			else if (copybuf[0] == 'w' || copybuf[0] == 'z')
 			{
 				if (!ProcessXLogDataMsg(conn, stream, copybuf, r, &blockpos))
 					goto error;
@@ -1059,7 +1074,7 @@ ProcessKeepaliveMsg(PGconn *conn, StreamCtl *stream, char *copybuf, int len,
 }
 
 /*
- * Process XLogData message.
+ * Process XLogData message, or compressed XLogData message.
  */
 static bool
 ProcessXLogDataMsg(PGconn *conn, StreamCtl *stream, char *copybuf, int len,
@@ -1069,6 +1084,7 @@ ProcessXLogDataMsg(PGconn *conn, StreamCtl *stream, char *copybuf, int len,
 	int			bytes_left;
 	int			bytes_written;
 	int			hdr_len;
+	char	   *data;
 
 	/*
 	 * Once we've decided we don't want to receive any more, just ignore any
@@ -1086,6 +1102,8 @@ ProcessXLogDataMsg(PGconn *conn, StreamCtl *stream, char *copybuf, int len,
 	hdr_len += 8;				/* dataStart */
 	hdr_len += 8;				/* walEnd */
 	hdr_len += 8;				/* sendTime */
+	if (copybuf[0] == 'z')
+		hdr_len += 4;			/* uncompressed length */
 	if (len < hdr_len)
 	{
 		fprintf(stderr, _("%s: streaming header too small: %d\n"),
@@ -1094,6 +1112,44 @@ ProcessXLogDataMsg(PGconn *conn, StreamCtl *stream, char *copybuf, int len,
 	}
 	*blockpos = fe_recvint64(&copybuf[1]);
 
+	data = copybuf + hdr_len;
+	bytes_left = len - hdr_len;
+
+	if (copybuf[0] == 'z')
+	{
+		uint32		rawlen;
+
+		memcpy(&rawlen, &copybuf[hdr_len - 4], sizeof(rawlen));
+		rawlen = pg_ntoh32(rawlen);
+
+		if (stream->compression == REPL_COMPRESSION_NONE ||
+			rawlen == 0 || rawlen > INT_MAX)
+		{
+			fprintf(stderr, _("%s: invalid compressed WAL message\n"),
+					progname);
+			return false;
+		}
+
+		if ((int) rawlen > decompress_buf_size)
+		{
+			if (decompress_buf)
+				pg_free(decompress_buf);
+			decompress_buf = pg_malloc(rawlen);
+			decompress_buf_size = rawlen;
+		}
+
+		if (repl_decompress(stream->compression, data, bytes_left,
+							decompress_buf, rawlen) < 0)
+		{
+			fprintf(stderr, _("%s: could not decompress WAL data\n"),
+					progname);
+			return false;
+		}
+
+		data = decompress_buf;
+		bytes_left = rawlen;
+	}
+
 	/* Extract WAL location for this block */
 	xlogoff = XLogSegmentOffset(*blockpos, WalSegSz);
 
@@ -1124,7 +1180,6 @@ ProcessXLogDataMsg(PGconn *conn, StreamCtl *stream, char *copybuf, int len,
 		}
 	}
 
-	bytes_left = len - hdr_len;
 	bytes_written = 0;
 
 	while (bytes_left)
@@ -1149,7 +1204,7 @@ ProcessXLogDataMsg(PGconn *conn, StreamCtl *stream, char *copybuf, int len,
 			}
 		}
 
-		if (stream->walmethod->write(walfile, copybuf + hdr_len + bytes_written,
+		if (stream->walmethod->write(walfile, data + bytes_written,
 									 bytes_to_write) != bytes_to_write)
 		{
 			fprintf(stderr,
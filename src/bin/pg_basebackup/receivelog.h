@@ -16,6 +16,7 @@
 #include "walmethods.h"
 
 #include "access/xlogdefs.h"
+#include "common/replcompress.h"
 
 /*
  * Called before trying to read more data or when a segment is
@@ -47,6 +48,7 @@ typedef struct StreamCtl
 	WalWriteMethod *walmethod;	/* How to write the WAL */
 	char	   *partial_suffix; /* Suffix appended to partially received files */
 	char	   *replication_slot;	/* Replication slot to use, or NULL */
+	ReplCompressionMethod compression;	/* Compression to ask the server for */
 } StreamCtl;
 
 
@@ -0,0 +1,151 @@
+# Test incremental backups taken with pg_basebackup --incremental-from
+use strict;
+use warnings;
+use File::Find;
+use PostgresNode;
+use TestLib;
+use Test::More tests => 13;
+
+my $tempdir = TestLib::tempdir;
+
+my $node = get_new_node('main');
+$node->init(allows_streaming => 1, extra => ['--data-checksums']);
+$node->start;
+
+# Returns a checksum of the contents of the test tables in a database
+sub table_contents
+{
+	my ($node, $dbname) = @_;
+	return $node->safe_psql($dbname,
+		    "SELECT relname, count(*), md5(string_agg(t::text, ',' ORDER BY t::text)) "
+		  . "FROM (SELECT 'inc_tab1' AS relname, t FROM inc_tab1 t "
+		  . "UNION ALL SELECT 'inc_tab2', t FROM inc_tab2 t) s "
+		  . "GROUP BY relname ORDER BY relname");
+}
+
+# Returns the INCREMENTAL files left over in a backup, if any
+sub leftover_incremental_files
+{
+	my ($dir) = @_;
+	my @files;
+	find(
+		sub {
+			push @files, $File::Find::name if $_ =~ /^INCREMENTAL\./;
+		},
+		$dir);
+	return join(', ', @files);
+}
+
+$node->safe_psql(
+	'postgres', q{
+CREATE TABLE inc_tab1 (a int PRIMARY KEY, b text);
+INSERT INTO inc_tab1 SELECT g, repeat('a', 50) FROM generate_series(1, 10000) g;
+CREATE TABLE inc_tab2 (a int, b text);
+INSERT INTO inc_tab2 SELECT g, 'unchanged' FROM generate_series(1, 10000) g;
+CREATE TABLE inc_dropped (a int);
+INSERT INTO inc_dropped SELECT generate_series(1, 1000);
+CHECKPOINT;
+});
+
+my $full = $node->backup_dir . '/full';
+$node->command_ok([ 'pg_basebackup', '-D', $full, '-c', 'fast' ],
+	'full backup');
+
+$node->command_fails(
+	[
+		'pg_basebackup', '-D', "$tempdir/inc_tar", '-Ft',
+		"--incremental-from=$full"
+	],
+	'incremental backup in tar format fails');
+$node->command_fails(
+	[
+		'pg_basebackup', '-D', "$tempdir/inc_bad",
+		"--incremental-from=$tempdir"
+	],
+	'incremental backup against a directory without backup_label fails');
+
+# Change some blocks, extend a relation, and create and drop others.  inc_tab2 isn't touched, so its blocks are taken from the
+# full backup.
+$node->safe_psql(
+	'postgres', q{
+UPDATE inc_tab1 SET b = 'updated' WHERE a % 100 = 0;
+DELETE FROM inc_tab1 WHERE a > 9000;
+INSERT INTO inc_tab1 SELECT g, 'new' FROM generate_series(20001, 25000) g;
+VACUUM inc_tab1;
+CREATE TABLE inc_new (a int);
+INSERT INTO inc_new SELECT generate_series(1, 1000);
+DROP TABLE inc_dropped;
+CREATE DATABASE inc_db;
+});
+$node->safe_psql(
+	'inc_db', q{
+CREATE TABLE inc_tab1 AS SELECT g AS a, 'db' AS b FROM generate_series(1, 500) g;
+CREATE TABLE inc_tab2 (a int, b text);
+});
+
+my $incr1 = $node->backup_dir . '/incr1';
+$node->command_ok(
+	[
+		'pg_basebackup', '-D', $incr1, '-c', 'fast',
+		"--incremental-from=$full"
+	],
+	'incremental backup');
+is(leftover_incremental_files($incr1),
+	'', 'incremental files reconstructed');
+
+my $expected_postgres = table_contents($node, 'postgres');
+my $expected_inc_db   = table_contents($node, 'inc_db');
+
+# An incremental backup taken against the incremental one, after TRUNCATE
+# gave inc_tab2 a new relfilenode
+$node->safe_psql(
+	'postgres', q{
+UPDATE inc_tab1 SET b = 'updated again' WHERE a % 7 = 0;
+TRUNCATE inc_tab2;
+INSERT INTO inc_tab2 VALUES (1, 'after truncate');
+});
+
+my $incr2 = $node->backup_dir . '/incr2';
+$node->command_ok(
+	[
+		'pg_basebackup', '-D', $incr2, '-c', 'fast',
+		"--incremental-from=$incr1"
+	],
+	'incremental backup against an incremental backup');
+is(leftover_incremental_files($incr2),
+	'', 'incremental files reconstructed');
+
+my $expected_postgres2 = table_contents($node, 'postgres');
+
+# Changes made after the last backup must not show up in either restore.
+$node->safe_psql('postgres', "DELETE FROM inc_tab1");
+
+my $restored1 = get_new_node('restored1');
+$restored1->init_from_backup($node, 'incr1');
+$restored1->start;
+is(table_contents($restored1, 'postgres'),
+	$expected_postgres, 'restored incremental backup matches primary');
+is(table_contents($restored1, 'inc_db'),
+	$expected_inc_db, 'database created after the prior backup restored');
+is( $restored1->safe_psql(
+		'postgres',
+		"SELECT count(*), to_regclass('inc_dropped') FROM inc_new"),
+	'1000|',
+	'created and dropped tables restored');
+$restored1->stop;
+
+my $restored2 = get_new_node('restored2');
+$restored2->init_from_backup($node, 'incr2');
+$restored2->start;
+is(table_contents($restored2, 'postgres'),
+	$expected_postgres2, 'restored chained incremental backup matches primary');
+is( $restored2->safe_psql(
+		'postgres', "SELECT count(*) FROM inc_tab1 WHERE a % 7 = 0 AND b <> 'updated again'"),
+	'0',
+	'changes after first incremental backup restored');
+$restored2->safe_psql('postgres', 'VACUUM inc_tab1');
+is($restored2->safe_psql('postgres', 'SELECT count(*) FROM inc_tab1'),
+	'14000', 'restored cluster usable');
+$restored2->stop;
+
+$node->stop;
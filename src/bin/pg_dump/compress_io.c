@@ -11,9 +11,10 @@
  * provides more flexibility, using callbacks to read/write data from the
  * underlying stream. The second API is a wrapper around fopen/gzopen and
  * friends, providing an interface similar to those, but abstracts away
- * the possible compression. Both APIs use libz for the compression, but
- * the second API uses gzip headers, so the resulting files can be easily
- * manipulated with the gzip utility.
+ * the possible compression. Both APIs can use libz, LZ4 or zstd for the
+ * compression.  The second API writes gzip files and LZ4 or zstd frames, so
+ * the resulting files can be easily manipulated with the gzip, lz4 and zstd
+ * utilities.
  *
  * Compressor API
  * --------------
@@ -41,10 +42,12 @@
  *	libz's gzopen() APIs. It allows you to use the same functions for
  *	compressed and uncompressed streams. cfopen_read() first tries to open
  *	the file with given name, and if it fails, it tries to open the same
- *	file with the .gz suffix. cfopen_write() opens a file for writing, an
- *	extra argument specifies if the file should be compressed, and adds the
- *	.gz suffix to the filename if so. This allows you to easily handle both
- *	compressed and uncompressed files.
+ *	file with the .gz, .lz4 or .zst suffix. cfopen_write() opens a file for
+ *	writing, an extra argument specifies if and how the file should be
+ *	compressed, and adds the matching suffix to the filename if so. This
+ *	allows you to easily handle both compressed and uncompressed files.
+ *	LZ4 and zstd streams are implemented here on top of stdio, using the
+ *	libraries' streaming interfaces.
  *
  * IDENTIFICATION
  *	   src/bin/pg_dump/compress_io.c
@@ -56,6 +59,17 @@
 #include "compress_io.h"
 #include "pg_backup_utils.h"
 
+#ifdef USE_LZ4
+#include <lz4frame.h>
+#endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
+#if defined(USE_LZ4) || defined(USE_ZSTD)
+#define HAVE_FRAME_COMPRESSION
+#endif
+
 /*----------------------
  * Compressor API
  *----------------------
@@ -72,11 +86,26 @@ struct CompressorState
 	char	   *zlibOut;
 	size_t		zlibOutSize;
 #endif
+
+#ifdef USE_LZ4
+	LZ4F_compressionContext_t lz4ctx;
+	size_t		lz4HeaderLen;	/* frame header waiting in frameOut */
+#endif
+#ifdef USE_ZSTD
+	ZSTD_CCtx  *zstdctx;
+#endif
+#ifdef HAVE_FRAME_COMPRESSION
+	char	   *frameOut;		/* output buffer for LZ4 or zstd */
+	size_t		frameOutSize;
+#endif
 };
 
 /* translator: this is a module name */
 static const char *modulename = gettext_noop("compress_io");
 
+/* number of zstd worker threads to compress with; 0 means compress inline */
+static int	compressWorkers = 0;
+
 static void ParseCompressionOption(int compression, CompressionAlgorithm *alg,
 					   int *level);
 
@@ -91,6 +120,25 @@ static void WriteDataToArchiveZlib(ArchiveHandle *AH, CompressorState *cs,
 static void EndCompressorZlib(ArchiveHandle *AH, CompressorState *cs);
 #endif
 
+/* Routines that support LZ4 compressed data I/O */
+#ifdef USE_LZ4
+static void InitCompressorLZ4(CompressorState *cs, int level);
+static void ReadDataFromArchiveLZ4(ArchiveHandle *AH, ReadFunc readF);
+static void WriteDataToArchiveLZ4(ArchiveHandle *AH, CompressorState *cs,
+					  const char *data, size_t dLen);
+static void EndCompressorLZ4(ArchiveHandle *AH, CompressorState *cs);
+#endif
+
+/* Routines that support zstd compressed data I/O */
+#ifdef USE_ZSTD
+static ZSTD_CCtx *CreateZstdCompressor(int level);
+static void InitCompressorZstd(CompressorState *cs, int level);
+static void ReadDataFromArchiveZstd(ArchiveHandle *AH, ReadFunc readF);
+static void WriteDataToArchiveZstd(ArchiveHandle *AH, CompressorState *cs,
+					   const char *data, size_t dLen);
+static void EndCompressorZstd(ArchiveHandle *AH, CompressorState *cs);
+#endif
+
 /* Routines that support uncompressed data I/O */
 static void ReadDataFromArchiveNone(ArchiveHandle *AH, ReadFunc readF);
 static void WriteDataToArchiveNone(ArchiveHandle *AH, CompressorState *cs,
@@ -98,17 +146,30 @@ static void WriteDataToArchiveNone(ArchiveHandle *AH, CompressorState *cs,
 
 /*
  * Interprets a numeric 'compression' value. The algorithm implied by the
- * value (zlib or none at the moment), is returned in *alg, and the
- * zlib compression level in *level.
+ * value is returned in *alg, and the compression level in *level.
  */
 static void
 ParseCompressionOption(int compression, CompressionAlgorithm *alg, int *level)
 {
+	int			lvl = compression;
+
 	if (compression == Z_DEFAULT_COMPRESSION ||
 		(compression > 0 && compression <= 9))
 		*alg = COMPR_ALG_LIBZ;
 	else if (compression == 0)
 		*alg = COMPR_ALG_NONE;
+	else if (compression >= COMPRESSION_CODE(COMPR_ALG_LZ4, 0) &&
+			 compression <= COMPRESSION_CODE(COMPR_ALG_LZ4, LZ4_MAX_LEVEL))
+	{
+		*alg = COMPR_ALG_LZ4;
+		lvl = compression - COMPRESSION_CODE(COMPR_ALG_LZ4, 0);
+	}
+	else if (compression >= COMPRESSION_CODE(COMPR_ALG_ZSTD, 0) &&
+			 compression <= COMPRESSION_CODE(COMPR_ALG_ZSTD, ZSTD_MAX_LEVEL))
+	{
+		*alg = COMPR_ALG_ZSTD;
+		lvl = compression - COMPRESSION_CODE(COMPR_ALG_ZSTD, 0);
+	}
 	else
 	{
 		exit_horribly(modulename, "invalid compression code: %d\n",
@@ -116,13 +177,92 @@ ParseCompressionOption(int compression, CompressionAlgorithm *alg, int *level)
 		*alg = COMPR_ALG_NONE;	/* keep compiler quiet */
 	}
 
-	/* The level is just the passed-in value. */
 	if (level)
-		*level = compression;
+		*level = lvl;
+}
+
+/*
+ * Complain that we were built without support for the given algorithm.
+ */
+static void
+ReportCompressionUnsupported(CompressionAlgorithm alg)
+{
+	exit_horribly(modulename, "not built with %s support\n",
+				  alg == COMPR_ALG_LZ4 ? "LZ4" :
+				  alg == COMPR_ALG_ZSTD ? "zstd" : "zlib");
 }
 
 /* Public interface routines */
 
+/*
+ * Is the compression method implied by 'compression' available in this
+ * build?  The method is returned in *alg, if that's not NULL.
+ */
+bool
+CompressionSupported(int compression, CompressionAlgorithm *alg)
+{
+	CompressionAlgorithm a;
+
+	ParseCompressionOption(compression, &a, NULL);
+	if (alg)
+		*alg = a;
+
+	switch (a)
+	{
+		case COMPR_ALG_NONE:
+			return true;
+		case COMPR_ALG_LIBZ:
+#ifdef HAVE_LIBZ
+			return true;
+#else
+			return false;
+#endif
+		case COMPR_ALG_LZ4:
+#ifdef USE_LZ4
+			return true;
+#else
+			return false;
+#endif
+		case COMPR_ALG_ZSTD:
+#ifdef USE_ZSTD
+			return true;
+#else
+			return false;
+#endif
+	}
+	return false;				/* keep compiler quiet */
+}
+
+/*
+ * Set the number of worker threads zstd compression should use.  This has
+ * to be supported by the zstd library we're linked with, so check that
+ * right away rather than when we start writing data.
+ */
+void
+SetCompressionWorkers(int workers)
+{
+#ifdef USE_ZSTD
+	if (workers > 0)
+	{
+		ZSTD_CCtx  *cctx = ZSTD_createCCtx();
+		size_t		res;
+
+		if (cctx == NULL)
+			exit_horribly(modulename, "could not initialize compression library\n");
+		res = ZSTD_CCtx_setParameter(cctx, ZSTD_c_nbWorkers, workers);
+		ZSTD_freeCCtx(cctx);
+		if (ZSTD_isError(res))
+			exit_horribly(modulename,
+						  "could not set number of compression workers: %s\n",
+						  ZSTD_getErrorName(res));
+	}
+#else
+	if (workers > 0)
+		ReportCompressionUnsupported(COMPR_ALG_ZSTD);
+#endif
+	compressWorkers = workers;
+}
+
 /* Allocate a new compressor */
 CompressorState *
 AllocateCompressor(int compression, WriteFunc writeF)
@@ -131,13 +271,10 @@ AllocateCompressor(int compression, WriteFunc writeF)
 	CompressionAlgorithm alg;
 	int			level;
 
+	if (!CompressionSupported(compression, &alg))
+		ReportCompressionUnsupported(alg);
 	ParseCompressionOption(compression, &alg, &level);
 
-#ifndef HAVE_LIBZ
-	if (alg == COMPR_ALG_LIBZ)
-		exit_horribly(modulename, "not built with zlib support\n");
-#endif
-
 	cs = (CompressorState *) pg_malloc0(sizeof(CompressorState));
 	cs->writeF = writeF;
 	cs->comprAlg = alg;
@@ -149,6 +286,14 @@ AllocateCompressor(int compression, WriteFunc writeF)
 	if (alg == COMPR_ALG_LIBZ)
 		InitCompressorZlib(cs, level);
 #endif
+#ifdef USE_LZ4
+	if (alg == COMPR_ALG_LZ4)
+		InitCompressorLZ4(cs, level);
+#endif
+#ifdef USE_ZSTD
+	if (alg == COMPR_ALG_ZSTD)
+		InitCompressorZstd(cs, level);
+#endif
 
 	return cs;
 }
@@ -162,17 +307,29 @@ ReadDataFromArchive(ArchiveHandle *AH, int compression, ReadFunc readF)
 {
 	CompressionAlgorithm alg;
 
-	ParseCompressionOption(compression, &alg, NULL);
+	if (!CompressionSupported(compression, &alg))
+		ReportCompressionUnsupported(alg);
 
-	if (alg == COMPR_ALG_NONE)
-		ReadDataFromArchiveNone(AH, readF);
-	if (alg == COMPR_ALG_LIBZ)
+	switch (alg)
 	{
+		case COMPR_ALG_NONE:
+			ReadDataFromArchiveNone(AH, readF);
+			break;
+		case COMPR_ALG_LIBZ:
 #ifdef HAVE_LIBZ
-		ReadDataFromArchiveZlib(AH, readF);
-#else
-		exit_horribly(modulename, "not built with zlib support\n");
+			ReadDataFromArchiveZlib(AH, readF);
 #endif
+			break;
+		case COMPR_ALG_LZ4:
+#ifdef USE_LZ4
+			ReadDataFromArchiveLZ4(AH, readF);
+#endif
+			break;
+		case COMPR_ALG_ZSTD:
+#ifdef USE_ZSTD
+			ReadDataFromArchiveZstd(AH, readF);
+#endif
+			break;
 	}
 }
 
@@ -188,8 +345,16 @@ WriteDataToArchive(ArchiveHandle *AH, CompressorState *cs,
 		case COMPR_ALG_LIBZ:
 #ifdef HAVE_LIBZ
 			WriteDataToArchiveZlib(AH, cs, data, dLen);
-#else
-			exit_horribly(modulename, "not built with zlib support\n");
+#endif
+			break;
+		case COMPR_ALG_LZ4:
+#ifdef USE_LZ4
+			WriteDataToArchiveLZ4(AH, cs, data, dLen);
+#endif
+			break;
+		case COMPR_ALG_ZSTD:
+#ifdef USE_ZSTD
+			WriteDataToArchiveZstd(AH, cs, data, dLen);
 #endif
 			break;
 		case COMPR_ALG_NONE:
@@ -208,6 +373,14 @@ EndCompressor(ArchiveHandle *AH, CompressorState *cs)
 #ifdef HAVE_LIBZ
 	if (cs->comprAlg == COMPR_ALG_LIBZ)
 		EndCompressorZlib(AH, cs);
+#endif
+#ifdef USE_LZ4
+	if (cs->comprAlg == COMPR_ALG_LZ4)
+		EndCompressorLZ4(AH, cs);
+#endif
+#ifdef USE_ZSTD
+	if (cs->comprAlg == COMPR_ALG_ZSTD)
+		EndCompressorZstd(AH, cs);
 #endif
 	free(cs);
 }
@@ -390,6 +563,268 @@ ReadDataFromArchiveZlib(ArchiveHandle *AH, ReadFunc readF)
 }
 #endif							/* HAVE_LIBZ */
 
+#ifdef USE_LZ4
+/*
+ * Functions for LZ4 compressed output.  We write a single LZ4 frame, so
+ * that the data could be decompressed by the lz4 utility, too.
+ */
+
+static void
+InitCompressorLZ4(CompressorState *cs, int level)
+{
+	LZ4F_preferences_t prefs;
+	size_t		res;
+
+	memset(&prefs, 0, sizeof(prefs));
+	prefs.compressionLevel = level;
+
+	res = LZ4F_createCompressionContext(&cs->lz4ctx, LZ4F_VERSION);
+	if (LZ4F_isError(res))
+		exit_horribly(modulename,
+					  "could not initialize compression library: %s\n",
+					  LZ4F_getErrorName(res));
+
+	cs->frameOutSize = LZ4F_compressBound(LZ4_IN_SIZE, &prefs);
+	cs->frameOut = pg_malloc(cs->frameOutSize);
+
+	/* The frame header is written out along with the first data */
+	res = LZ4F_compressBegin(cs->lz4ctx, cs->frameOut, cs->frameOutSize,
+							 &prefs);
+	if (LZ4F_isError(res))
+		exit_horribly(modulename, "could not compress data: %s\n",
+					  LZ4F_getErrorName(res));
+	cs->lz4HeaderLen = res;
+}
+
+static void
+WriteDataToArchiveLZ4(ArchiveHandle *AH, CompressorState *cs,
+					  const char *data, size_t dLen)
+{
+	if (cs->lz4HeaderLen > 0)
+	{
+		cs->writeF(AH, cs->frameOut, cs->lz4HeaderLen);
+		cs->lz4HeaderLen = 0;
+	}
+
+	while (dLen > 0)
+	{
+		size_t		chunk = Min(dLen, LZ4_IN_SIZE);
+		size_t		res;
+
+		res = LZ4F_compressUpdate(cs->lz4ctx, cs->frameOut, cs->frameOutSize,
+								  data, chunk, NULL);
+		if (LZ4F_isError(res))
+			exit_horribly(modulename, "could not compress data: %s\n",
+						  LZ4F_getErrorName(res));
+
+		/* LZ4 may just buffer the input; avoid zero-length chunks */
+		if (res > 0)
+			cs->writeF(AH, cs->frameOut, res);
+
+		data += chunk;
+		dLen -= chunk;
+	}
+}
+
+static void
+EndCompressorLZ4(ArchiveHandle *AH, CompressorState *cs)
+{
+	size_t		res;
+
+	if (cs->lz4HeaderLen > 0)
+		cs->writeF(AH, cs->frameOut, cs->lz4HeaderLen);
+
+	res = LZ4F_compressEnd(cs->lz4ctx, cs->frameOut, cs->frameOutSize, NULL);
+	if (LZ4F_isError(res))
+		exit_horribly(modulename, "could not compress data: %s\n",
+					  LZ4F_getErrorName(res));
+	if (res > 0)
+		cs->writeF(AH, cs->frameOut, res);
+
+	LZ4F_freeCompressionContext(cs->lz4ctx);
+	free(cs->frameOut);
+}
+
+static void
+ReadDataFromArchiveLZ4(ArchiveHandle *AH, ReadFunc readF)
+{
+	LZ4F_decompressionContext_t ctx;
+	size_t		res;
+	size_t		cnt;
+	char	   *buf;
+	size_t		buflen;
+	char	   *out;
+
+	res = LZ4F_createDecompressionContext(&ctx, LZ4F_VERSION);
+	if (LZ4F_isError(res))
+		exit_horribly(modulename,
+					  "could not initialize compression library: %s\n",
+					  LZ4F_getErrorName(res));
+
+	buf = pg_malloc(LZ4_IN_SIZE);
+	buflen = LZ4_IN_SIZE;
+
+	out = pg_malloc(LZ4_IN_SIZE + 1);
+
+	while ((cnt = readF(AH, &buf, &buflen)))
+	{
+		const char *in = buf;
+		size_t		outlen;
+
+		/* keep going while there's input, or the output buffer was full */
+		do
+		{
+			size_t		inlen = cnt;
+
+			outlen = LZ4_IN_SIZE;
+			res = LZ4F_decompress(ctx, out, &outlen, in, &inlen, NULL);
+			if (LZ4F_isError(res))
+				exit_horribly(modulename, "could not uncompress data: %s\n",
+							  LZ4F_getErrorName(res));
+			in += inlen;
+			cnt -= inlen;
+
+			out[outlen] = '\0';
+			ahwrite(out, 1, outlen, AH);
+		} while (cnt > 0 || outlen == LZ4_IN_SIZE);
+	}
+
+	LZ4F_freeDecompressionContext(ctx);
+	free(buf);
+	free(out);
+}
+#endif							/* USE_LZ4 */
+
+#ifdef USE_ZSTD
+/*
+ * Functions for zstd compressed output.
+ */
+
+/* Create a compression context, honoring the requested number of workers */
+static ZSTD_CCtx *
+CreateZstdCompressor(int level)
+{
+	ZSTD_CCtx  *cctx;
+	size_t		res;
+
+	cctx = ZSTD_createCCtx();
+	if (cctx == NULL)
+		exit_horribly(modulename, "could not initialize compression library\n");
+
+	res = ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, level);
+	if (!ZSTD_isError(res) && compressWorkers > 0)
+		res = ZSTD_CCtx_setParameter(cctx, ZSTD_c_nbWorkers, compressWorkers);
+	if (ZSTD_isError(res))
+		exit_horribly(modulename,
+					  "could not initialize compression library: %s\n",
+					  ZSTD_getErrorName(res));
+
+	return cctx;
+}
+
+static void
+InitCompressorZstd(CompressorState *cs, int level)
+{
+	cs->zstdctx = CreateZstdCompressor(level);
+	cs->frameOutSize = ZSTD_CStreamOutSize();
+	cs->frameOut = pg_malloc(cs->frameOutSize);
+}
+
+static void
+WriteDataToArchiveZstd(ArchiveHandle *AH, CompressorState *cs,
+					   const char *data, size_t dLen)
+{
+	ZSTD_inBuffer in = {data, dLen, 0};
+
+	while (in.pos < in.size)
+	{
+		ZSTD_outBuffer out = {cs->frameOut, cs->frameOutSize, 0};
+		size_t		res;
+
+		res = ZSTD_compressStream2(cs->zstdctx, &out, &in, ZSTD_e_continue);
+		if (ZSTD_isError(res))
+			exit_horribly(modulename, "could not compress data: %s\n",
+						  ZSTD_getErrorName(res));
+
+		/* zstd may just buffer the input; avoid zero-length chunks */
+		if (out.pos > 0)
+			cs->writeF(AH, cs->frameOut, out.pos);
+	}
+}
+
+static void
+EndCompressorZstd(ArchiveHandle *AH, CompressorState *cs)
+{
+	ZSTD_inBuffer in = {NULL, 0, 0};
+	size_t		res;
+
+	/* Flush everything zstd (and its workers) still hold */
+	do
+	{
+		ZSTD_outBuffer out = {cs->frameOut, cs->frameOutSize, 0};
+
+		res = ZSTD_compressStream2(cs->zstdctx, &out, &in, ZSTD_e_end);
+		if (ZSTD_isError(res))
+			exit_horribly(modulename, "could not compress data: %s\n",
+						  ZSTD_getErrorName(res));
+		if (out.pos > 0)
+			cs->writeF(AH, cs->frameOut, out.pos);
+	} while (res != 0);
+
+	ZSTD_freeCCtx(cs->zstdctx);
+	free(cs->frameOut);
+}
+
+static void
+ReadDataFromArchiveZstd(ArchiveHandle *AH, ReadFunc readF)
+{
+	ZSTD_DCtx  *dctx;
+	size_t		cnt;
+	char	   *buf;
+	size_t		buflen;
+	char	   *outbuf;
+	size_t		outbufsize;
+
+	dctx = ZSTD_createDCtx();
+	if (dctx == NULL)
+		exit_horribly(modulename, "could not initialize compression library\n");
+
+	buflen = ZSTD_DStreamInSize();
+	buf = pg_malloc(buflen);
+
+	outbufsize = ZSTD_DStreamOutSize();
+	outbuf = pg_malloc(outbufsize + 1);
+
+	while ((cnt = readF(AH, &buf, &buflen)))
+	{
+		ZSTD_inBuffer in = {buf, cnt, 0};
+		ZSTD_outBuffer out;
+
+		/* keep going while there's input, or the output buffer was full */
+		do
+		{
+			size_t		res;
+
+			out.dst = outbuf;
+			out.size = outbufsize;
+			out.pos = 0;
+
+			res = ZSTD_decompressStream(dctx, &out, &in);
+			if (ZSTD_isError(res))
+				exit_horribly(modulename, "could not uncompress data: %s\n",
+							  ZSTD_getErrorName(res));
+
+			outbuf[out.pos] = '\0';
+			ahwrite(outbuf, 1, out.pos, AH);
+		} while (in.pos < in.size || out.pos == out.size);
+	}
+
+	ZSTD_freeDCtx(dctx);
+	free(buf);
+	free(outbuf);
+}
+#endif							/* USE_ZSTD */
+
 
 /*
  * Functions for uncompressed output.
@@ -430,6 +865,11 @@ WriteDataToArchiveNone(ArchiveHandle *AH, CompressorState *cs,
 /*
  * cfp represents an open stream, wrapping the underlying FILE or gzFile
  * pointer. This is opaque to the callers.
+ *
+ * For LZ4 and zstd, framefp is the underlying FILE, and we do the buffering
+ * ourselves: when reading, inbuf holds compressed data read from the file
+ * but not yet decompressed, and outbuf holds decompressed data not yet
+ * returned to the caller.  When writing, outbuf holds compressed output.
  */
 struct cfp
 {
@@ -437,10 +877,58 @@ struct cfp
 #ifdef HAVE_LIBZ
 	gzFile		compressedfp;
 #endif
+#ifdef HAVE_FRAME_COMPRESSION
+	CompressionAlgorithm framealg;	/* COMPR_ALG_NONE if framefp unused */
+	FILE	   *framefp;
+	bool		writing;		/* opened for writing? */
+	bool		eof;			/* no more input to decompress? */
+	char	   *inbuf;
+	size_t		inbufsize;
+	size_t		inpos;			/* next unconsumed byte of inbuf */
+	size_t		inlen;			/* bytes of valid data in inbuf */
+	char	   *outbuf;
+	size_t		outbufsize;
+	size_t		outpos;			/* next unreturned byte of outbuf */
+	size_t		outlen;			/* bytes of valid data in outbuf */
+#ifdef USE_LZ4
+	LZ4F_compressionContext_t lz4cctx;
+	LZ4F_decompressionContext_t lz4dctx;
+#endif
+#ifdef USE_ZSTD
+	ZSTD_CCtx  *zstdcctx;
+	ZSTD_DCtx  *zstddctx;
+#endif
+#endif
 };
 
+/* Suffixes of compressed files, and a compression code to open them with */
+static const struct
+{
+	const char *suffix;
+	int			compression;
+}			compressed_suffixes[] =
+{
 #ifdef HAVE_LIBZ
+	{".gz", Z_DEFAULT_COMPRESSION},
+#endif
+#ifdef USE_LZ4
+	{".lz4", COMPRESSION_CODE(COMPR_ALG_LZ4, 0)},
+#endif
+#ifdef USE_ZSTD
+	{".zst", COMPRESSION_CODE(COMPR_ALG_ZSTD, 0)},
+#endif
+	{NULL, 0}
+};
+
 static int	hasSuffix(const char *filename, const char *suffix);
+
+#ifdef HAVE_FRAME_COMPRESSION
+static bool frame_open(cfp *fp, const char *path, const char *mode,
+		   CompressionAlgorithm alg, int level);
+static size_t frame_write(cfp *fp, const void *ptr, size_t size);
+static bool frame_fill(cfp *fp);
+static size_t frame_read(cfp *fp, void *ptr, size_t size);
+static int	frame_close(cfp *fp);
 #endif
 
 /* free() without changing errno; useful in several places below */
@@ -457,9 +945,10 @@ free_keep_errno(void *p)
  * Open a file for reading. 'path' is the file to open, and 'mode' should
  * be either "r" or "rb".
  *
- * If the file at 'path' does not exist, we append the ".gz" suffix (if 'path'
- * doesn't already have it) and try again. So if you pass "foo" as 'path',
- * this will open either "foo" or "foo.gz".
+ * If the file at 'path' does not exist, we append the ".gz", ".lz4" and
+ * ".zst" suffixes in turn (if 'path' doesn't already have one) and try
+ * again. So if you pass "foo" as 'path', this will open whichever of "foo",
+ * "foo.gz", "foo.lz4" or "foo.zst" exists.
  *
  * On failure, return NULL with an error code in errno.
  */
@@ -467,24 +956,22 @@ cfp *
 cfopen_read(const char *path, const char *mode)
 {
 	cfp		   *fp;
+	int			i;
 
-#ifdef HAVE_LIBZ
-	if (hasSuffix(path, ".gz"))
-		fp = cfopen(path, mode, 1);
-	else
-#endif
+	for (i = 0; compressed_suffixes[i].suffix != NULL; i++)
 	{
-		fp = cfopen(path, mode, 0);
-#ifdef HAVE_LIBZ
-		if (fp == NULL)
-		{
-			char	   *fname;
+		if (hasSuffix(path, compressed_suffixes[i].suffix))
+			return cfopen(path, mode, compressed_suffixes[i].compression);
+	}
 
-			fname = psprintf("%s.gz", path);
-			fp = cfopen(fname, mode, 1);
-			free_keep_errno(fname);
-		}
-#endif
+	fp = cfopen(path, mode, 0);
+	for (i = 0; fp == NULL && compressed_suffixes[i].suffix != NULL; i++)
+	{
+		char	   *fname;
+
+		fname = psprintf("%s%s", path, compressed_suffixes[i].suffix);
+		fp = cfopen(fname, mode, compressed_suffixes[i].compression);
+		free_keep_errno(fname);
 	}
 	return fp;
 }
@@ -494,9 +981,9 @@ cfopen_read(const char *path, const char *mode)
  * be a filemode as accepted by fopen() and gzopen() that indicates writing
  * ("w", "wb", "a", or "ab").
  *
- * If 'compression' is non-zero, a gzip compressed stream is opened, and
- * 'compression' indicates the compression level used. The ".gz" suffix
- * is automatically added to 'path' in that case.
+ * If 'compression' is non-zero, a compressed stream is opened, and
+ * 'compression' indicates the method and level used. The ".gz", ".lz4" or
+ * ".zst" suffix is automatically added to 'path' in that case.
  *
  * On failure, return NULL with an error code in errno.
  */
@@ -504,37 +991,55 @@ cfp *
 cfopen_write(const char *path, const char *mode, int compression)
 {
 	cfp		   *fp;
+	CompressionAlgorithm alg;
+
+	if (!CompressionSupported(compression, &alg))
+		ReportCompressionUnsupported(alg);
 
-	if (compression == 0)
+	if (alg == COMPR_ALG_NONE)
 		fp = cfopen(path, mode, 0);
 	else
 	{
-#ifdef HAVE_LIBZ
 		char	   *fname;
 
-		fname = psprintf("%s.gz", path);
+		fname = psprintf("%s%s", path,
+						 alg == COMPR_ALG_LIBZ ? ".gz" :
+						 alg == COMPR_ALG_LZ4 ? ".lz4" : ".zst");
 		fp = cfopen(fname, mode, compression);
 		free_keep_errno(fname);
-#else
-		exit_horribly(modulename, "not built with zlib support\n");
-		fp = NULL;				/* keep compiler quiet */
-#endif
 	}
 	return fp;
 }
 
 /*
  * Opens file 'path' in 'mode'. If 'compression' is non-zero, the file
- * is opened with libz gzopen(), otherwise with plain fopen().
+ * is opened with libz gzopen(), or as an LZ4 or zstd stream, as the
+ * compression code says; otherwise with plain fopen().
  *
  * On failure, return NULL with an error code in errno.
  */
 cfp *
 cfopen(const char *path, const char *mode, int compression)
 {
-	cfp		   *fp = pg_malloc(sizeof(cfp));
+	cfp		   *fp = pg_malloc0(sizeof(cfp));
+	CompressionAlgorithm alg;
+	int			level;
 
-	if (compression != 0)
+	if (!CompressionSupported(compression, &alg))
+		ReportCompressionUnsupported(alg);
+	ParseCompressionOption(compression, &alg, &level);
+
+	if (alg == COMPR_ALG_LZ4 || alg == COMPR_ALG_ZSTD)
+	{
+#ifdef HAVE_FRAME_COMPRESSION
+		if (!frame_open(fp, path, mode, alg, level))
+		{
+			free_keep_errno(fp);
+			fp = NULL;
+		}
+#endif
+	}
+	else if (alg == COMPR_ALG_LIBZ)
 	{
 #ifdef HAVE_LIBZ
 		if (compression != Z_DEFAULT_COMPRESSION)
@@ -558,15 +1063,10 @@ cfopen(const char *path, const char *mode, int compression)
 			free_keep_errno(fp);
 			fp = NULL;
 		}
-#else
-		exit_horribly(modulename, "not built with zlib support\n");
 #endif
 	}
 	else
 	{
-#ifdef HAVE_LIBZ
-		fp->compressedfp = NULL;
-#endif
 		fp->uncompressedfp = fopen(path, mode);
 		if (fp->uncompressedfp == NULL)
 		{
@@ -587,6 +1087,10 @@ cfread(void *ptr, int size, cfp *fp)
 	if (size == 0)
 		return 0;
 
+#ifdef HAVE_FRAME_COMPRESSION
+	if (fp->framealg != COMPR_ALG_NONE)
+		return frame_read(fp, ptr, size);
+#endif
 #ifdef HAVE_LIBZ
 	if (fp->compressedfp)
 	{
@@ -614,6 +1118,10 @@ cfread(void *ptr, int size, cfp *fp)
 int
 cfwrite(const void *ptr, int size, cfp *fp)
 {
+#ifdef HAVE_FRAME_COMPRESSION
+	if (fp->framealg != COMPR_ALG_NONE)
+		return frame_write(fp, ptr, size);
+#endif
 #ifdef HAVE_LIBZ
 	if (fp->compressedfp)
 		return gzwrite(fp->compressedfp, ptr, size);
@@ -627,6 +1135,15 @@ cfgetc(cfp *fp)
 {
 	int			ret;
 
+#ifdef HAVE_FRAME_COMPRESSION
+	if (fp->framealg != COMPR_ALG_NONE)
+	{
+		if (!frame_fill(fp))
+			exit_horribly(modulename,
+						  "could not read from input file: end of file\n");
+		return (unsigned char) fp->outbuf[fp->outpos++];
+	}
+#endif
 #ifdef HAVE_LIBZ
 	if (fp->compressedfp)
 	{
@@ -655,6 +1172,25 @@ cfgetc(cfp *fp)
 char *
 cfgets(cfp *fp, char *buf, int len)
 {
+#ifdef HAVE_FRAME_COMPRESSION
+	if (fp->framealg != COMPR_ALG_NONE)
+	{
+		int			n = 0;
+
+		while (n < len - 1 && frame_fill(fp))
+		{
+			char		c = fp->outbuf[fp->outpos++];
+
+			buf[n++] = c;
+			if (c == '\n')
+				break;
+		}
+		if (n == 0)
+			return NULL;
+		buf[n] = '\0';
+		return buf;
+	}
+#endif
 #ifdef HAVE_LIBZ
 	if (fp->compressedfp)
 		return gzgets(fp->compressedfp, buf, len);
@@ -673,6 +1209,11 @@ cfclose(cfp *fp)
 		errno = EBADF;
 		return EOF;
 	}
+#ifdef HAVE_FRAME_COMPRESSION
+	if (fp->framealg != COMPR_ALG_NONE)
+		result = frame_close(fp);
+	else
+#endif
 #ifdef HAVE_LIBZ
 	if (fp->compressedfp)
 	{
@@ -693,6 +1234,10 @@ cfclose(cfp *fp)
 int
 cfeof(cfp *fp)
 {
+#ifdef HAVE_FRAME_COMPRESSION
+	if (fp->framealg != COMPR_ALG_NONE)
+		return fp->eof && fp->outpos >= fp->outlen;
+#endif
 #ifdef HAVE_LIBZ
 	if (fp->compressedfp)
 		return gzeof(fp->compressedfp);
@@ -717,7 +1262,6 @@ get_cfp_error(cfp *fp)
 	return strerror(errno);
 }
 
-#ifdef HAVE_LIBZ
 static int
 hasSuffix(const char *filename, const char *suffix)
 {
@@ -732,4 +1276,309 @@ hasSuffix(const char *filename, const char *suffix)
 				  suffixlen) == 0;
 }
 
+#ifdef HAVE_FRAME_COMPRESSION
+/*
+ * Open an LZ4 or zstd stream on 'path'.  On failure, return false with an
+ * error code in errno.
+ */
+static bool
+frame_open(cfp *fp, const char *path, const char *mode,
+		   CompressionAlgorithm alg, int level)
+{
+	fp->framefp = fopen(path, mode);
+	if (fp->framefp == NULL)
+		return false;
+	fp->framealg = alg;
+	fp->writing = (mode[0] != 'r');
+
+#ifdef USE_LZ4
+	if (alg == COMPR_ALG_LZ4)
+	{
+		size_t		res;
+
+		if (fp->writing)
+		{
+			LZ4F_preferences_t prefs;
+
+			memset(&prefs, 0, sizeof(prefs));
+			prefs.compressionLevel = level;
+
+			res = LZ4F_createCompressionContext(&fp->lz4cctx, LZ4F_VERSION);
+			if (LZ4F_isError(res))
+				exit_horribly(modulename,
+							  "could not initialize compression library: %s\n",
+							  LZ4F_getErrorName(res));
+			fp->outbufsize = LZ4F_compressBound(LZ4_IN_SIZE, &prefs);
+			fp->outbuf = pg_malloc(fp->outbufsize);
+
+			res = LZ4F_compressBegin(fp->lz4cctx, fp->outbuf, fp->outbufsize,
+									 &prefs);
+			if (LZ4F_isError(res))
+				exit_horribly(modulename, "could not compress data: %s\n",
+							  LZ4F_getErrorName(res));
+			if (fwrite(fp->outbuf, 1, res, fp->framefp) != res)
+			{
+				int			save_errno = errno;
+
+				LZ4F_freeCompressionContext(fp->lz4cctx);
+				free(fp->outbuf);
+				fclose(fp->framefp);
+				errno = save_errno;
+				return false;
+			}
+		}
+		else
+		{
+			res = LZ4F_createDecompressionContext(&fp->lz4dctx, LZ4F_VERSION);
+			if (LZ4F_isError(res))
+				exit_horribly(modulename,
+							  "could not initialize compression library: %s\n",
+							  LZ4F_getErrorName(res));
+			fp->inbufsize = LZ4_IN_SIZE;
+			fp->outbufsize = LZ4_IN_SIZE;
+		}
+	}
+#endif
+#ifdef USE_ZSTD
+	if (alg == COMPR_ALG_ZSTD)
+	{
+		if (fp->writing)
+		{
+			fp->zstdcctx = CreateZstdCompressor(level);
+			fp->outbufsize = ZSTD_CStreamOutSize();
+			fp->outbuf = pg_malloc(fp->outbufsize);
+		}
+		else
+		{
+			fp->zstddctx = ZSTD_createDCtx();
+			if (fp->zstddctx == NULL)
+				exit_horribly(modulename,
+							  "could not initialize compression library\n");
+			fp->inbufsize = ZSTD_DStreamInSize();
+			fp->outbufsize = ZSTD_DStreamOutSize();
+		}
+	}
+#endif
+
+	if (!fp->writing)
+	{
+		fp->inbuf = pg_malloc(fp->inbufsize);
+		fp->outbuf = pg_malloc(fp->outbufsize);
+	}
+
+	return true;
+}
+
+/*
+ * Compress 'size' bytes and write the result out.  Returns 'size', or 0
+ * with an error code in errno if the write failed.
+ */
+static size_t
+frame_write(cfp *fp, const void *ptr, size_t size)
+{
+	const char *data = ptr;
+	size_t		remaining = size;
+
+#ifdef USE_LZ4
+	if (fp->framealg == COMPR_ALG_LZ4)
+	{
+		while (remaining > 0)
+		{
+			size_t		chunk = Min(remaining, LZ4_IN_SIZE);
+			size_t		res;
+
+			res = LZ4F_compressUpdate(fp->lz4cctx, fp->outbuf, fp->outbufsize,
+									  data, chunk, NULL);
+			if (LZ4F_isError(res))
+				exit_horribly(modulename, "could not compress data: %s\n",
+							  LZ4F_getErrorName(res));
+			if (fwrite(fp->outbuf, 1, res, fp->framefp) != res)
+				return 0;
+			data += chunk;
+			remaining -= chunk;
+		}
+	}
+#endif
+#ifdef USE_ZSTD
+	if (fp->framealg == COMPR_ALG_ZSTD)
+	{
+		ZSTD_inBuffer in = {data, remaining, 0};
+
+		while (in.pos < in.size)
+		{
+			ZSTD_outBuffer out = {fp->outbuf, fp->outbufsize, 0};
+			size_t		res;
+
+			res = ZSTD_compressStream2(fp->zstdcctx, &out, &in,
+									   ZSTD_e_continue);
+			if (ZSTD_isError(res))
+				exit_horribly(modulename, "could not compress data: %s\n",
+							  ZSTD_getErrorName(res));
+			if (fwrite(fp->outbuf, 1, out.pos, fp->framefp) != out.pos)
+				return 0;
+		}
+	}
+#endif
+
+	return size;
+}
+
+/*
+ * Make sure there is decompressed data in outbuf.  Returns false if there
+ * is none left.
+ */
+static bool
+frame_fill(cfp *fp)
+{
+	while (fp->outpos >= fp->outlen)
+	{
+		bool		input_done = false;
+
+		if (fp->eof)
+			return false;
+
+		if (fp->inpos >= fp->inlen)
+		{
+			fp->inlen = fread(fp->inbuf, 1, fp->inbufsize, fp->framefp);
+			fp->inpos = 0;
+			if (fp->inlen == 0)
+			{
+				if (ferror(fp->framefp))
+					READ_ERROR_EXIT(fp->framefp);
+				input_done = true;
+			}
+		}
+
+#ifdef USE_LZ4
+		if (fp->framealg == COMPR_ALG_LZ4)
+		{
+			size_t		outlen = fp->outbufsize;
+			size_t		inlen = fp->inlen - fp->inpos;
+			size_t		res;
+
+			res = LZ4F_decompress(fp->lz4dctx, fp->outbuf, &outlen,
+								  fp->inbuf + fp->inpos, &inlen, NULL);
+			if (LZ4F_isError(res))
+				exit_horribly(modulename, "could not uncompress data: %s\n",
+							  LZ4F_getErrorName(res));
+			fp->inpos += inlen;
+			fp->outlen = outlen;
+			fp->outpos = 0;
+		}
+#endif
+#ifdef USE_ZSTD
+		if (fp->framealg == COMPR_ALG_ZSTD)
+		{
+			ZSTD_inBuffer in = {fp->inbuf, fp->inlen, fp->inpos};
+			ZSTD_outBuffer out = {fp->outbuf, fp->outbufsize, 0};
+			size_t		res;
+
+			res = ZSTD_decompressStream(fp->zstddctx, &out, &in);
+			if (ZSTD_isError(res))
+				exit_horribly(modulename, "could not uncompress data: %s\n",
+							  ZSTD_getErrorName(res));
+			fp->inpos = in.pos;
+			fp->outlen = out.pos;
+			fp->outpos = 0;
+		}
+#endif
+
+		/* At end of file, and the library had nothing more to give us */
+		if (input_done && fp->outlen == 0)
+			fp->eof = true;
+	}
+
+	return true;
+}
+
+/*
+ * Read up to 'size' bytes of decompressed data.
+ */
+static size_t
+frame_read(cfp *fp, void *ptr, size_t size)
+{
+	char	   *dst = ptr;
+	size_t		done = 0;
+
+	while (done < size && frame_fill(fp))
+	{
+		size_t		n = Min(size - done, fp->outlen - fp->outpos);
+
+		memcpy(dst + done, fp->outbuf + fp->outpos, n);
+		fp->outpos += n;
+		done += n;
+	}
+
+	return done;
+}
+
+/*
+ * Finish the stream, if writing, and close the file.
+ */
+static int
+frame_close(cfp *fp)
+{
+	int			result = 0;
+
+	if (fp->writing)
+	{
+#ifdef USE_LZ4
+		if (fp->framealg == COMPR_ALG_LZ4)
+		{
+			size_t		res;
+
+			res = LZ4F_compressEnd(fp->lz4cctx, fp->outbuf, fp->outbufsize,
+								   NULL);
+			if (LZ4F_isError(res))
+				exit_horribly(modulename, "could not compress data: %s\n",
+							  LZ4F_getErrorName(res));
+			if (fwrite(fp->outbuf, 1, res, fp->framefp) != res)
+				result = EOF;
+			LZ4F_freeCompressionContext(fp->lz4cctx);
+		}
+#endif
+#ifdef USE_ZSTD
+		if (fp->framealg == COMPR_ALG_ZSTD)
+		{
+			ZSTD_inBuffer in = {NULL, 0, 0};
+			size_t		res;
+
+			do
+			{
+				ZSTD_outBuffer out = {fp->outbuf, fp->outbufsize, 0};
+
+				res = ZSTD_compressStream2(fp->zstdcctx, &out, &in,
+										   ZSTD_e_end);
+				if (ZSTD_isError(res))
+					exit_horribly(modulename, "could not compress data: %s\n",
+								  ZSTD_getErrorName(res));
+				if (fwrite(fp->outbuf, 1, out.pos, fp->framefp) != out.pos)
+					result = EOF;
+			} while (res != 0 && result == 0);
+			ZSTD_freeCCtx(fp->zstdcctx);
+		}
+#endif
+	}
+	else
+	{
+#ifdef USE_LZ4
+		if (fp->framealg == COMPR_ALG_LZ4)
+			LZ4F_freeDecompressionContext(fp->lz4dctx);
+#endif
+#ifdef USE_ZSTD
+		if (fp->framealg == COMPR_ALG_ZSTD)
+			ZSTD_freeDCtx(fp->zstddctx);
 #endif
+	}
+
+	if (fclose(fp->framefp) != 0)
+		result = EOF;
+	fp->framefp = NULL;
+	if (fp->inbuf)
+		free_keep_errno(fp->inbuf);
+	if (fp->outbuf)
+		free_keep_errno(fp->outbuf);
+
+	return result;
+}
+#endif							/* HAVE_FRAME_COMPRESSION */
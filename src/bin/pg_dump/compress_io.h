@@ -21,12 +21,28 @@
 #define ZLIB_OUT_SIZE	4096
 #define ZLIB_IN_SIZE	4096
 
+/* Size of the input chunks we feed to LZ4 at a time. */
+#define LZ4_IN_SIZE		65536
+
 typedef enum
 {
 	COMPR_ALG_NONE,
-	COMPR_ALG_LIBZ
+	COMPR_ALG_LIBZ,
+	COMPR_ALG_LZ4,
+	COMPR_ALG_ZSTD
 } CompressionAlgorithm;
 
+/*
+ * A 'compression' value, as passed around the archivers and stored in the
+ * archive header, is 0 for no compression, or Z_DEFAULT_COMPRESSION or 1-9
+ * for zlib at that level.  The other algorithms are encoded with
+ * COMPRESSION_CODE(); a level of 0 selects the library's default level.
+ */
+#define COMPRESSION_CODE(alg, level)	((alg) * 1000 + (level))
+
+#define LZ4_MAX_LEVEL	12
+#define ZSTD_MAX_LEVEL	22
+
 /* Prototype for callback function to WriteDataToArchive() */
 typedef void (*WriteFunc) (ArchiveHandle *AH, const char *buf, size_t len);
 
@@ -46,6 +62,8 @@ typedef size_t (*ReadFunc) (ArchiveHandle *AH, char **buf, size_t *buflen);
 /* struct definition appears in compress_io.c */
 typedef struct CompressorState CompressorState;
 
+extern bool CompressionSupported(int compression, CompressionAlgorithm *alg);
+extern void SetCompressionWorkers(int workers);
 extern CompressorState *AllocateCompressor(int compression, WriteFunc writeF);
 extern void ReadDataFromArchive(ArchiveHandle *AH, int compression,
 					ReadFunc readF);
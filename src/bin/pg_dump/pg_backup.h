@@ -69,6 +69,8 @@ typedef struct _restoreOptions
 									 * instead of OWNER TO */
 	char	   *superuser;		/* Username to use as superuser */
 	char	   *use_role;		/* Issue SET ROLE to this */
+	char	   *maintenance_work_mem;	/* if not NULL, SET this per session */
+	int			max_parallel_maintenance_workers;	/* if >= 0, SET this */
 	int			dropSchema;
 	int			disable_dollar_quoting;
 	int			dump_inserts;
@@ -159,6 +161,7 @@ typedef struct _dumpOptions
 	int			use_setsessauth;
 	int			enable_row_security;
 	int			load_via_partition_root;
+	int			split_table_size;	/* split data of bigger tables (MB) */
 
 	/* default, if no "inclusion" switches appear, is to dump everything */
 	bool		include_everything;
@@ -30,6 +30,7 @@
 #include <io.h>
 #endif
 
+#include "compress_io.h"
 #include "parallel.h"
 #include "pg_backup_archiver.h"
 #include "pg_backup_db.h"
@@ -381,8 +382,8 @@ RestoreArchive(Archive *AHX)
 	/*
 	 * Make sure we won't need (de)compression we haven't got
 	 */
-#ifndef HAVE_LIBZ
-	if (AH->compression != 0 && AH->PrintTocDataPtr != NULL)
+	if (!CompressionSupported(AH->compression, NULL) &&
+		AH->PrintTocDataPtr != NULL)
 	{
 		for (te = AH->toc->next; te != AH->toc; te = te->next)
 		{
@@ -390,7 +391,6 @@ RestoreArchive(Archive *AHX)
 				exit_horribly(modulename, "cannot restore from compressed archive (compression not supported in this installation)\n");
 		}
 	}
-#endif
 
 	/*
 	 * Prepare index arrays, so we can assume we have them throughout restore.
@@ -981,6 +981,7 @@ NewRestoreOptions(void)
 	opts->format = archUnknown;
 	opts->promptPassword = TRI_DEFAULT;
 	opts->dumpSections = DUMP_UNSECTIONED;
+	opts->max_parallel_maintenance_workers = -1;
 
 	return opts;
 }
@@ -1556,7 +1557,10 @@ SetOutput(ArchiveHandle *AH, const char *filename, int compression)
 		char		fmode[14];
 
 		/* Don't use PG_BINARY_x since this is zlib */
-		sprintf(fmode, "wb%d", compression);
+		if (compression == Z_DEFAULT_COMPRESSION)
+			strcpy(fmode, "wb");
+		else
+			sprintf(fmode, "wb%d", compression);
 		if (fn >= 0)
 			AH->OF = gzdopen(dup(fn), fmode);
 		else
@@ -1893,7 +1897,9 @@ buildTocEntryArrays(ArchiveHandle *AH)
 		 * tableDataId provides the TABLE DATA item's dump ID for each TABLE
 		 * TOC entry that has a DATA item.  We compute this by reversing the
 		 * TABLE DATA item's dependency, knowing that a TABLE DATA item has
-		 * just one dependency and it is the TABLE item.
+		 * just one dependency and it is the TABLE item.  If the table's data
+		 * was dumped in several parts, tableDataId gives the first one and
+		 * the others are chained to it through nextDataPart.
 		 */
 		if (strcmp(te->desc, "TABLE DATA") == 0 && te->nDeps > 0)
 		{
@@ -1907,7 +1913,16 @@ buildTocEntryArrays(ArchiveHandle *AH)
 			if (tableId <= 0 || tableId > maxDumpId)
 				exit_horribly(modulename, "bad table dumpId for TABLE DATA item\n");
 
-			AH->tableDataId[tableId] = te->dumpId;
+			if (AH->tableDataId[tableId] == 0)
+				AH->tableDataId[tableId] = te->dumpId;
+			else
+			{
+				TocEntry   *prev = AH->tocsByDumpId[AH->tableDataId[tableId]];
+
+				while (prev->nextDataPart != NULL)
+					prev = prev->nextDataPart;
+				prev->nextDataPart = te;
+			}
 		}
 	}
 }
@@ -3186,6 +3201,20 @@ _doSetFixedOutputState(ArchiveHandle *AH)
 	if (AH->public.searchpath)
 		ahprintf(AH, "%s", AH->public.searchpath);
 
+	/* Give index builds and constraint checks the requested resources */
+	if (ropt && ropt->maintenance_work_mem)
+	{
+		PQExpBuffer qry = createPQExpBuffer();
+
+		appendPQExpBufferStr(qry, "SET maintenance_work_mem = ");
+		appendStringLiteralAHX(qry, ropt->maintenance_work_mem, AH);
+		ahprintf(AH, "%s;\n", qry->data);
+		destroyPQExpBuffer(qry);
+	}
+	if (ropt && ropt->max_parallel_maintenance_workers >= 0)
+		ahprintf(AH, "SET max_parallel_maintenance_workers = %d;\n",
+				 ropt->max_parallel_maintenance_workers);
+
 	/* Make sure function checking is disabled */
 	ahprintf(AH, "SET check_function_bodies = false;\n");
 
@@ -3831,10 +3860,8 @@ ReadHead(ArchiveHandle *AH)
 	else
 		AH->compression = Z_DEFAULT_COMPRESSION;
 
-#ifndef HAVE_LIBZ
-	if (AH->compression != 0)
+	if (!CompressionSupported(AH->compression, NULL))
 		write_msg(modulename, "WARNING: archive is compressed, but this installation does not support compression -- no data will be available\n");
-#endif
 
 	if (AH->version >= K_VERS_1_4)
 	{
@@ -4624,6 +4651,13 @@ fix_dependencies(ArchiveHandle *AH)
  * that parallel restore will prioritize larger jobs (index builds, FK
  * constraint checks, etc) over smaller ones, avoiding situations where we
  * end a restore with only one active job working on a large table.
+ *
+ * Finally, scale the dataLength of each table data item by the number of
+ * post-data items that wait for it.  Loading a table is the head of a chain
+ * of work whose total cost grows with both the table's size and the number
+ * of indexes and constraints built on it, so starting the heavily-indexed
+ * big tables first keeps their index builds from being the only jobs still
+ * running at the end of the restore.
  */
 static void
 repoint_table_dependencies(ArchiveHandle *AH)
@@ -4631,6 +4665,9 @@ repoint_table_dependencies(ArchiveHandle *AH)
 	TocEntry   *te;
 	int			i;
 	DumpId		olddep;
+	int		   *nPostDataDeps;
+
+	nPostDataDeps = (int *) pg_malloc0((AH->maxDumpId + 1) * sizeof(int));
 
 	for (te = AH->toc->next; te != AH->toc; te = te->next)
 	{
@@ -4644,14 +4681,42 @@ repoint_table_dependencies(ArchiveHandle *AH)
 			{
 				DumpId		tabledataid = AH->tableDataId[olddep];
 				TocEntry   *tabledatate = AH->tocsByDumpId[tabledataid];
+				TocEntry   *partte;
 
 				te->dependencies[i] = tabledataid;
 				te->dataLength = Max(te->dataLength, tabledatate->dataLength);
+				nPostDataDeps[tabledataid]++;
 				ahlog(AH, 2, "transferring dependency %d -> %d to %d\n",
 					  te->dumpId, olddep, tabledataid);
+
+				/* If the data is in several parts, depend on all of them */
+				for (partte = tabledatate->nextDataPart; partte != NULL;
+					 partte = partte->nextDataPart)
+				{
+					te->dependencies = (DumpId *)
+						pg_realloc(te->dependencies,
+								   (te->nDeps + 1) * sizeof(DumpId));
+					te->dependencies[te->nDeps++] = partte->dumpId;
+					te->depCount++;
+					ahlog(AH, 2, "adding dependency %d -> %d\n",
+						  te->dumpId, partte->dumpId);
+				}
 			}
 		}
 	}
+
+	for (i = 1; i <= AH->maxDumpId; i++)
+	{
+		TocEntry   *partte;
+
+		if (nPostDataDeps[i] == 0)
+			continue;
+		for (partte = AH->tocsByDumpId[i]; partte != NULL;
+			 partte = partte->nextDataPart)
+			partte->dataLength *= 1 + nPostDataDeps[i];
+	}
+
+	free(nPostDataDeps);
 }
 
 /*
@@ -4770,7 +4835,12 @@ mark_create_done(ArchiveHandle *AH, TocEntry *te)
 	{
 		TocEntry   *ted = AH->tocsByDumpId[AH->tableDataId[te->dumpId]];
 
-		ted->created = true;
+		/*
+		 * If the data is in several parts, they may be loaded concurrently,
+		 * so none of them can TRUNCATE the table first.
+		 */
+		if (ted->nextDataPart == NULL)
+			ted->created = true;
 	}
 }
 
@@ -4786,9 +4856,11 @@ inhibit_data_for_failed_table(ArchiveHandle *AH, TocEntry *te)
 
 	if (AH->tableDataId[te->dumpId] != 0)
 	{
-		TocEntry   *ted = AH->tocsByDumpId[AH->tableDataId[te->dumpId]];
+		TocEntry   *ted;
 
-		ted->reqs = 0;
+		for (ted = AH->tocsByDumpId[AH->tableDataId[te->dumpId]];
+			 ted != NULL; ted = ted->nextDataPart)
+			ted->reqs = 0;
 	}
 }
 
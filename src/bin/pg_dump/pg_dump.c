@@ -56,6 +56,7 @@
 #include "libpq/libpq-fs.h"
 #include "storage/block.h"
 
+#include "compress_io.h"
 #include "dumputils.h"
 #include "parallel.h"
 #include "pg_backup_db.h"
@@ -134,6 +135,9 @@ char		g_comment_end[10];
 
 static const CatalogId nilCatalogId = {0, 0};
 
+/* upper limit on the number of parts a table's data is split into */
+#define MAX_TABLE_DATA_PARTS	1024
+
 /*
  * Macro for producing quoted, schema-qualified name of a dumpable object.
  */
@@ -142,6 +146,7 @@ static const CatalogId nilCatalogId = {0, 0};
 				   (obj)->dobj.name)
 
 static void help(const char *progname);
+static int	parse_compression_option(const char *arg, int *workers);
 static void setup_connection(Archive *AH,
 				 const char *dumpencoding, const char *dumpsnapshot,
 				 char *use_role);
@@ -233,8 +238,9 @@ static void addBoundaryDependencies(DumpableObject **dobjs, int numObjs,
 						DumpableObject *boundaryObjs);
 
 static void getDomainConstraints(Archive *fout, TypeInfo *tyinfo);
-static void getTableData(DumpOptions *dopt, TableInfo *tblinfo, int numTables, char relkind);
+static void getTableData(Archive *fout, TableInfo *tblinfo, int numTables, char relkind);
 static void makeTableDataInfo(DumpOptions *dopt, TableInfo *tbinfo);
+static void splitTableData(Archive *fout, TableDataInfo *tdinfo);
 static void buildMatViewRefreshDependencies(Archive *fout);
 static void getTableDataFKConstraints(void);
 static char *format_function_arguments(FuncInfo *finfo, char *funcargs,
@@ -310,6 +316,8 @@ main(int argc, char **argv)
 	int			numWorkers = 1;
 	trivalue	prompt_password = TRI_DEFAULT;
 	int			compressLevel = -1;
+	bool		compressSpecified = false;
+	int			compressWorkers = 0;
 	int			plainText = 0;
 	ArchiveFormat archiveFormat = archUnknown;
 	ArchiveMode archiveMode;
@@ -367,6 +375,7 @@ main(int argc, char **argv)
 		{"section", required_argument, NULL, 5},
 		{"serializable-deferrable", no_argument, &dopt.serializable_deferrable, 1},
 		{"snapshot", required_argument, NULL, 6},
+		{"split-table-size", required_argument, NULL, 8},
 		{"strict-names", no_argument, &strict_names, 1},
 		{"use-set-session-authorization", no_argument, &dopt.use_setsessauth, 1},
 		{"no-comments", no_argument, &dopt.no_comments, 1},
@@ -520,13 +529,10 @@ main(int argc, char **argv)
 				dopt.aclsSkip = true;
 				break;
 
-			case 'Z':			/* Compression Level */
-				compressLevel = atoi(optarg);
-				if (compressLevel < 0 || compressLevel > 9)
-				{
-					write_msg(NULL, "compression level must be in range 0..9\n");
-					exit_nicely(1);
-				}
+			case 'Z':			/* Compression method and level */
+				compressLevel = parse_compression_option(optarg,
+														 &compressWorkers);
+				compressSpecified = true;
 				break;
 
 			case 0:
@@ -557,6 +563,15 @@ main(int argc, char **argv)
 				dosync = false;
 				break;
 
+			case 8:				/* split-table-size */
+				dopt.split_table_size = atoi(optarg);
+				if (dopt.split_table_size <= 0)
+				{
+					write_msg(NULL, "split table size must be a positive number of megabytes\n");
+					exit_nicely(1);
+				}
+				break;
+
 			default:
 				fprintf(stderr, _("Try \"%s --help\" for more information.\n"), progname);
 				exit_nicely(1);
@@ -618,7 +633,7 @@ main(int argc, char **argv)
 		plainText = 1;
 
 	/* Custom and directory formats are compressed by default, others not */
-	if (compressLevel == -1)
+	if (!compressSpecified)
 	{
 #ifdef HAVE_LIBZ
 		if (archiveFormat == archCustom || archiveFormat == archDirectory)
@@ -628,12 +643,29 @@ main(int argc, char **argv)
 			compressLevel = 0;
 	}
 
-#ifndef HAVE_LIBZ
-	if (compressLevel != 0)
+	/* LZ4 and zstd were checked for already, so this can only be zlib */
+	if (!CompressionSupported(compressLevel, NULL))
+	{
 		write_msg(NULL, "WARNING: requested compression not available in this "
 				  "installation -- archive will be uncompressed\n");
-	compressLevel = 0;
-#endif
+		compressLevel = 0;
+	}
+
+	/* Plain text output can only be compressed with gzip */
+	if (archiveFormat == archNull && compressLevel != 0)
+	{
+		CompressionAlgorithm alg;
+
+		(void) CompressionSupported(compressLevel, &alg);
+		if (alg != COMPR_ALG_LIBZ)
+		{
+			write_msg(NULL, "only gzip compression is supported for plain text output\n");
+			exit_nicely(1);
+		}
+	}
+
+	if (compressWorkers > 0)
+		SetCompressionWorkers(compressWorkers);
 
 	/*
 	 * If emitting an archive format, we always want to emit a DATABASE item,
@@ -789,14 +821,14 @@ main(int argc, char **argv)
 
 	if (!dopt.schemaOnly)
 	{
-		getTableData(&dopt, tblinfo, numTables, 0);
+		getTableData(fout, tblinfo, numTables, 0);
 		buildMatViewRefreshDependencies(fout);
 		if (dopt.dataOnly)
 			getTableDataFKConstraints();
 	}
 
 	if (dopt.schemaOnly && dopt.sequence_data)
-		getTableData(&dopt, tblinfo, numTables, RELKIND_SEQUENCE);
+		getTableData(fout, tblinfo, numTables, RELKIND_SEQUENCE);
 
 	/*
 	 * In binary-upgrade mode, we do not have to worry about the actual blob
@@ -887,10 +919,7 @@ main(int argc, char **argv)
 	ropt->sequence_data = dopt.sequence_data;
 	ropt->binary_upgrade = dopt.binary_upgrade;
 
-	if (compressLevel == -1)
-		ropt->compression = 0;
-	else
-		ropt->compression = compressLevel;
+	ropt->compression = compressLevel;
 
 	ropt->suppressDumpWarnings = true;	/* We've already shown them */
 
@@ -923,6 +952,156 @@ main(int argc, char **argv)
 }
 
 
+/*
+ * parse_compression_option
+ *	  interpret the argument of -Z/--compress
+ *
+ * The argument is either a gzip compression level 0-9, or METHOD[:DETAIL]
+ * where METHOD is gzip, lz4, zstd or none, and DETAIL is a compression
+ * level or a comma-separated list of level=N and (for zstd) workers=N.
+ * Returns the compression code for the archivers; the number of zstd
+ * worker threads is stored into *workers.
+ */
+static int
+parse_compression_option(const char *arg, int *workers)
+{
+	CompressionAlgorithm alg;
+	const char *method;
+	const char *detail;
+	int			methodlen;
+	int			level = -1;
+	int			maxlevel;
+	char	   *endptr;
+	long		num;
+
+	/* A bare number is a gzip level, as in older releases */
+	num = strtol(arg, &endptr, 10);
+	if (endptr != arg && *endptr == '\0')
+	{
+		level = (int) num;
+		if (num < 0 || num > 9)
+		{
+			write_msg(NULL, "compression level must be in range 0..9\n");
+			exit_nicely(1);
+		}
+		return level;
+	}
+
+	method = arg;
+	detail = strchr(arg, ':');
+	methodlen = detail ? detail - arg : strlen(arg);
+
+	if (methodlen == 4 && strncmp(method, "none", 4) == 0)
+		alg = COMPR_ALG_NONE;
+	else if (methodlen == 4 && strncmp(method, "gzip", 4) == 0)
+		alg = COMPR_ALG_LIBZ;
+	else if (methodlen == 3 && strncmp(method, "lz4", 3) == 0)
+		alg = COMPR_ALG_LZ4;
+	else if (methodlen == 4 && strncmp(method, "zstd", 4) == 0)
+		alg = COMPR_ALG_ZSTD;
+	else
+	{
+		write_msg(NULL, "unrecognized compression method \"%.*s\"\n",
+				  methodlen, method);
+		exit_nicely(1);
+	}
+
+	if (detail != NULL)
+	{
+		char	   *copy = pg_strdup(detail + 1);
+		char	   *item;
+
+		for (item = strtok(copy, ","); item != NULL; item = strtok(NULL, ","))
+		{
+			const char *value;
+			int		   *target;
+			char	   *endptr;
+			long		val;
+
+			if (strncmp(item, "level=", 6) == 0)
+			{
+				value = item + 6;
+				target = &level;
+			}
+			else if (strncmp(item, "workers=", 8) == 0 &&
+					 alg == COMPR_ALG_ZSTD)
+			{
+				value = item + 8;
+				target = workers;
+			}
+			else if (strspn(item, "0123456789") == strlen(item))
+			{
+				value = item;
+				target = &level;
+			}
+			else
+			{
+				write_msg(NULL, "unrecognized compression option \"%s\"\n",
+						  item);
+				exit_nicely(1);
+			}
+
+			errno = 0;
+			val = strtol(value, &endptr, 10);
+			if (*value == '\0' || *endptr != '\0' || errno != 0 ||
+				val < 0 || val > INT_MAX)
+			{
+				write_msg(NULL, "invalid value in compression option \"%s\"\n",
+						  item);
+				exit_nicely(1);
+			}
+			*target = (int) val;
+		}
+		free(copy);
+	}
+
+	switch (alg)
+	{
+		case COMPR_ALG_NONE:
+			if (level > 0)
+			{
+				write_msg(NULL, "compression method \"none\" does not accept a level\n");
+				exit_nicely(1);
+			}
+			return 0;
+
+		case COMPR_ALG_LIBZ:
+			if (level == -1)
+				return Z_DEFAULT_COMPRESSION;
+			maxlevel = 9;
+			break;
+
+		case COMPR_ALG_LZ4:
+			maxlevel = LZ4_MAX_LEVEL;
+			break;
+
+		case COMPR_ALG_ZSTD:
+			maxlevel = ZSTD_MAX_LEVEL;
+			break;
+	}
+
+	if (level == -1)
+		level = 0;				/* use the library's default */
+	else if (level < 1 || level > maxlevel)
+	{
+		write_msg(NULL, "compression level for \"%.*s\" must be in range 1..%d\n",
+				  methodlen, method, maxlevel);
+		exit_nicely(1);
+	}
+
+	if (alg == COMPR_ALG_LIBZ)
+		return level;
+
+	if (!CompressionSupported(COMPRESSION_CODE(alg, level), NULL))
+	{
+		write_msg(NULL, "compression method \"%.*s\" is not supported by this build\n",
+				  methodlen, method);
+		exit_nicely(1);
+	}
+
+	return COMPRESSION_CODE(alg, level);
+}
+
 static void
 help(const char *progname)
 {
@@ -937,7 +1116,9 @@ help(const char *progname)
 	printf(_("  -j, --jobs=NUM               use this many parallel jobs to dump\n"));
 	printf(_("  -v, --verbose                verbose mode\n"));
 	printf(_("  -V, --version                output version information, then exit\n"));
-	printf(_("  -Z, --compress=0-9           compression level for compressed formats\n"));
+	printf(_("  -Z, --compress=METHOD[:DETAIL]\n"
+			 "                               compress as specified (gzip, lz4, zstd or none,\n"
+			 "                               or a gzip level 0-9)\n"));
 	printf(_("  --lock-wait-timeout=TIMEOUT  fail after waiting TIMEOUT for a table lock\n"));
 	printf(_("  --no-sync                    do not wait for changes to be written safely to disk\n"));
 	printf(_("  -?, --help                   show this help, then exit\n"));
@@ -980,6 +1161,8 @@ help(const char *progname)
 	printf(_("  --section=SECTION            dump named section (pre-data, data, or post-data)\n"));
 	printf(_("  --serializable-deferrable    wait until the dump can run without anomalies\n"));
 	printf(_("  --snapshot=SNAPSHOT          use given snapshot for the dump\n"));
+	printf(_("  --split-table-size=MB        dump data of tables larger than MB megabytes\n"
+			 "                               in several parts\n"));
 	printf(_("  --strict-names               require table and/or schema include patterns to\n"
 			 "                               match at least one entity each\n"));
 	printf(_("  --use-set-session-authorization\n"
@@ -1762,7 +1945,7 @@ dumpTableData_copy(Archive *fout, void *dcontext)
 		}
 		else
 			appendPQExpBufferStr(q, "* ");
-		appendPQExpBuffer(q, "FROM %s %s) TO stdout;",
+		appendPQExpBuffer(q, "FROM ONLY %s %s) TO stdout;",
 						  fmtQualifiedDumpable(tbinfo),
 						  tdinfo->filtercond);
 	}
@@ -2149,9 +2332,10 @@ dumpTableData(Archive *fout, TableDataInfo *tdinfo)
 		 * However, relpages is declared as "integer" in pg_class, and hence
 		 * also in TableInfo, but it's really BlockNumber a/k/a unsigned int.
 		 * Cast so that we get the right interpretation of table sizes
-		 * exceeding INT_MAX pages.
+		 * exceeding INT_MAX pages.  If the data is split, assume the parts
+		 * are about the same size.
 		 */
-		te->dataLength = (BlockNumber) tbinfo->relpages;
+		te->dataLength = (BlockNumber) tbinfo->relpages / tdinfo->nparts;
 	}
 
 	destroyPQExpBuffer(copyBuf);
@@ -2206,15 +2390,21 @@ refreshMatViewData(Archive *fout, TableDataInfo *tdinfo)
  *	  set up dumpable objects representing the contents of tables
  */
 static void
-getTableData(DumpOptions *dopt, TableInfo *tblinfo, int numTables, char relkind)
+getTableData(Archive *fout, TableInfo *tblinfo, int numTables, char relkind)
 {
+	DumpOptions *dopt = fout->dopt;
 	int			i;
 
 	for (i = 0; i < numTables; i++)
 	{
 		if (tblinfo[i].dobj.dump & DUMP_COMPONENT_DATA &&
 			(!relkind || tblinfo[i].relkind == relkind))
+		{
 			makeTableDataInfo(dopt, &(tblinfo[i]));
+
+			if (dopt->split_table_size > 0 && tblinfo[i].dataObj != NULL)
+				splitTableData(fout, tblinfo[i].dataObj);
+		}
 	}
 }
 
@@ -2277,11 +2467,151 @@ makeTableDataInfo(DumpOptions *dopt, TableInfo *tbinfo)
 	tdinfo->dobj.namespace = tbinfo->dobj.namespace;
 	tdinfo->tdtable = tbinfo;
 	tdinfo->filtercond = NULL;	/* might get set later */
+	tdinfo->nparts = 1;
+	tdinfo->nextPart = NULL;
 	addObjectDependency(&tdinfo->dobj, tbinfo->dobj.dumpId);
 
 	tbinfo->dataObj = tdinfo;
 }
 
+/*
+ * splitTableData -
+ *	  divide the data of a large table into several TABLE DATA objects
+ *
+ * Each part selects a range of the table's primary key, so that a parallel
+ * dump or restore can work on one big table with several jobs.  This is
+ * only possible for tables with a single-column integer primary key; other
+ * tables are dumped in one piece, as are extension configuration tables,
+ * which already have a filter condition of their own.
+ */
+static void
+splitTableData(Archive *fout, TableDataInfo *tdinfo)
+{
+	DumpOptions *dopt = fout->dopt;
+	TableInfo  *tbinfo = tdinfo->tdtable;
+	TableDataInfo *prev;
+	PQExpBuffer query;
+	PGresult   *res;
+	char	   *keycol;
+	double		relsize;
+	int64		minval;
+	int64		maxval;
+	uint64		step;
+	int			nparts;
+	int			i;
+
+	if (tdinfo->dobj.objType != DO_TABLE_DATA || tdinfo->filtercond != NULL)
+		return;
+
+	relsize = (double) (BlockNumber) tbinfo->relpages * BLCKSZ;
+	if (relsize / (1024.0 * 1024.0) < 2.0 * dopt->split_table_size)
+		return;
+	nparts = (int) Min(relsize / (1024.0 * 1024.0) / dopt->split_table_size,
+					   MAX_TABLE_DATA_PARTS);
+
+	query = createPQExpBuffer();
+
+	/* Look for a usable primary key */
+	appendPQExpBuffer(query,
+					  "SELECT a.attname "
+					  "FROM pg_catalog.pg_index i "
+					  "JOIN pg_catalog.pg_attribute a "
+					  "ON a.attrelid = i.indrelid AND a.attnum = i.indkey[0] "
+					  "WHERE i.indrelid = '%u'::pg_catalog.oid "
+					  "AND i.indisprimary AND i.%s = 1 "
+					  "AND a.atttypid IN ('pg_catalog.int2'::pg_catalog.regtype, "
+					  "'pg_catalog.int4'::pg_catalog.regtype, "
+					  "'pg_catalog.int8'::pg_catalog.regtype)",
+					  tbinfo->dobj.catId.oid,
+					  fout->remoteVersion >= 110000 ? "indnkeyatts" : "indnatts");
+	res = ExecuteSqlQuery(fout, query->data, PGRES_TUPLES_OK);
+	if (PQntuples(res) != 1)
+	{
+		PQclear(res);
+		destroyPQExpBuffer(query);
+		return;
+	}
+	/* must copy, since fmtId is nonreentrant */
+	keycol = pg_strdup(fmtId(PQgetvalue(res, 0, 0)));
+	PQclear(res);
+
+	/* Find the key range, using the dump's snapshot */
+	resetPQExpBuffer(query);
+	appendPQExpBuffer(query, "SELECT min(%s), max(%s) ", keycol, keycol);
+	appendPQExpBuffer(query, "FROM ONLY %s", fmtQualifiedDumpable(tbinfo));
+	res = ExecuteSqlQuery(fout, query->data, PGRES_TUPLES_OK);
+	if (PQgetisnull(res, 0, 0))
+	{
+		/* table is empty, whatever relpages says */
+		PQclear(res);
+		destroyPQExpBuffer(query);
+		free(keycol);
+		return;
+	}
+	minval = strtoll(PQgetvalue(res, 0, 0), NULL, 10);
+	maxval = strtoll(PQgetvalue(res, 0, 1), NULL, 10);
+	PQclear(res);
+	destroyPQExpBuffer(query);
+
+	/* Don't make more parts than there are key values */
+	if ((uint64) maxval - (uint64) minval < (uint64) nparts)
+		nparts = (int) ((uint64) maxval - (uint64) minval) + 1;
+	if (nparts < 2)
+	{
+		free(keycol);
+		return;
+	}
+	step = ((uint64) maxval - (uint64) minval) / nparts + 1;
+
+	if (g_verbose)
+		write_msg(NULL, "splitting data of table \"%s.%s\" into %d parts\n",
+				  tbinfo->dobj.namespace->dobj.name, tbinfo->dobj.name,
+				  nparts);
+
+	/*
+	 * The first and last parts are left open-ended, so that no row can be
+	 * missed whatever the key range turns out to be.
+	 */
+	prev = NULL;
+	for (i = 0; i < nparts; i++)
+	{
+		TableDataInfo *part;
+		int64		lo = (int64) ((uint64) minval + step * i);
+		int64		hi = (int64) ((uint64) minval + step * (i + 1));
+		char		buf[128];
+
+		if (i == 0)
+			snprintf(buf, sizeof(buf), "WHERE %s < " INT64_FORMAT,
+					 keycol, hi);
+		else if (i == nparts - 1)
+			snprintf(buf, sizeof(buf), "WHERE %s >= " INT64_FORMAT,
+					 keycol, lo);
+		else
+			snprintf(buf, sizeof(buf),
+					 "WHERE %s >= " INT64_FORMAT " AND %s < " INT64_FORMAT,
+					 keycol, lo, keycol, hi);
+
+		if (prev == NULL)
+			part = tdinfo;
+		else
+		{
+			part = (TableDataInfo *) pg_malloc(sizeof(TableDataInfo));
+			memcpy(part, tdinfo, sizeof(TableDataInfo));
+			AssignDumpId(&part->dobj);
+			part->dobj.dependencies = NULL;
+			part->dobj.nDeps = part->dobj.allocDeps = 0;
+			addObjectDependency(&part->dobj, tbinfo->dobj.dumpId);
+			prev->nextPart = part;
+		}
+		part->filtercond = pg_strdup(buf);
+		part->nparts = nparts;
+		part->nextPart = NULL;
+		prev = part;
+	}
+
+	free(keycol);
+}
+
 /*
  * The refresh for a materialized view must be dependent on the refresh for
  * any materialized view that this one is dependent on.
@@ -2419,6 +2749,8 @@ getTableDataFKConstraints(void)
 		{
 			ConstraintInfo *cinfo = (ConstraintInfo *) dobjs[i];
 			TableInfo  *ftable;
+			TableDataInfo *condata;
+			TableDataInfo *fdata;
 
 			/* Not interesting unless both tables are to be dumped */
 			if (cinfo->contable == NULL ||
@@ -2431,10 +2763,23 @@ getTableDataFKConstraints(void)
 
 			/*
 			 * Okay, make referencing table's TABLE_DATA object depend on the
-			 * referenced table's TABLE_DATA object.
+			 * referenced table's TABLE_DATA object.  If either table's data
+			 * is split, every part of the former must follow every part of
+			 * the latter (a self-reference needs just the one dependency).
 			 */
-			addObjectDependency(&cinfo->contable->dataObj->dobj,
-								ftable->dataObj->dobj.dumpId);
+			if (ftable == cinfo->contable)
+			{
+				addObjectDependency(&cinfo->contable->dataObj->dobj,
+									ftable->dataObj->dobj.dumpId);
+				continue;
+			}
+			for (condata = cinfo->contable->dataObj; condata != NULL;
+				 condata = condata->nextPart)
+			{
+				for (fdata = ftable->dataObj; fdata != NULL;
+					 fdata = fdata->nextPart)
+					addObjectDependency(&condata->dobj, fdata->dobj.dumpId);
+			}
 		}
 	}
 	free(dobjs);
@@ -3999,6 +4344,8 @@ getSubscriptions(Archive *fout)
 	int			i_subslotname;
 	int			i_subsynccommit;
 	int			i_subpublications;
+	int			i_substream;
+	int			i_subbinary;
 	int			i,
 				ntups;
 
@@ -4030,11 +4377,18 @@ getSubscriptions(Archive *fout)
 					  "SELECT s.tableoid, s.oid, s.subname,"
 					  "(%s s.subowner) AS rolname, "
 					  " s.subconninfo, s.subslotname, s.subsynccommit, "
-					  " s.subpublications "
-					  "FROM pg_subscription s "
-					  "WHERE s.subdbid = (SELECT oid FROM pg_database"
-					  "                   WHERE datname = current_database())",
+					  " s.subpublications, ",
 					  username_subquery);
+
+	if (fout->remoteVersion >= 120000)
+		appendPQExpBufferStr(query, " s.substream, s.subbinary ");
+	else
+		appendPQExpBufferStr(query, " false AS substream, false AS subbinary ");
+
+	appendPQExpBufferStr(query,
+						 "FROM pg_subscription s "
+						 "WHERE s.subdbid = (SELECT oid FROM pg_database"
+						 "                   WHERE datname = current_database())");
 	res = ExecuteSqlQuery(fout, query->data, PGRES_TUPLES_OK);
 
 	ntups = PQntuples(res);
@@ -4047,6 +4401,8 @@ getSubscriptions(Archive *fout)
 	i_subslotname = PQfnumber(res, "subslotname");
 	i_subsynccommit = PQfnumber(res, "subsynccommit");
 	i_subpublications = PQfnumber(res, "subpublications");
+	i_substream = PQfnumber(res, "substream");
+	i_subbinary = PQfnumber(res, "subbinary");
 
 	subinfo = pg_malloc(ntups * sizeof(SubscriptionInfo));
 
@@ -4068,6 +4424,10 @@ getSubscriptions(Archive *fout)
 			pg_strdup(PQgetvalue(res, i, i_subsynccommit));
 		subinfo[i].subpublications =
 			pg_strdup(PQgetvalue(res, i, i_subpublications));
+		subinfo[i].substream =
+			pg_strdup(PQgetvalue(res, i, i_substream));
+		subinfo[i].subbinary =
+			pg_strdup(PQgetvalue(res, i, i_subbinary));
 
 		if (strlen(subinfo[i].rolname) == 0)
 			write_msg(NULL, "WARNING: owner of subscription \"%s\" appears to be invalid\n",
@@ -4140,6 +4500,12 @@ dumpSubscription(Archive *fout, SubscriptionInfo *subinfo)
 	if (strcmp(subinfo->subsynccommit, "off") != 0)
 		appendPQExpBuffer(query, ", synchronous_commit = %s", fmtId(subinfo->subsynccommit));
 
+	if (strcmp(subinfo->substream, "f") != 0)
+		appendPQExpBufferStr(query, ", streaming = on");
+
+	if (strcmp(subinfo->subbinary, "f") != 0)
+		appendPQExpBufferStr(query, ", binary = true");
+
 	appendPQExpBufferStr(query, ");\n");
 
 	ArchiveEntry(fout, subinfo->dobj.catId, subinfo->dobj.dumpId,
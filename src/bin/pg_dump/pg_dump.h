@@ -351,6 +351,8 @@ typedef struct _tableDataInfo
 	DumpableObject dobj;
 	TableInfo  *tdtable;		/* link to table to dump */
 	char	   *filtercond;		/* WHERE condition to limit rows dumped */
+	int			nparts;			/* number of parts the data is split into */
+	struct _tableDataInfo *nextPart;	/* next part of split table data */
 } TableDataInfo;
 
 typedef struct _indxInfo
@@ -622,6 +624,8 @@ typedef struct _SubscriptionInfo
 	char	   *subconninfo;
 	char	   *subslotname;
 	char	   *subsynccommit;
+	char	   *substream;
+	char	   *subbinary;
 	char	   *subpublications;
 } SubscriptionInfo;
 
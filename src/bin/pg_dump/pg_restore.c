@@ -118,6 +118,8 @@ main(int argc, char **argv)
 		{"no-tablespaces", no_argument, &outputNoTablespaces, 1},
 		{"role", required_argument, NULL, 2},
 		{"section", required_argument, NULL, 3},
+		{"maintenance-work-mem", required_argument, NULL, 4},
+		{"max-parallel-maintenance-workers", required_argument, NULL, 5},
 		{"strict-names", no_argument, &strict_names, 1},
 		{"use-set-session-authorization", no_argument, &use_setsessauth, 1},
 		{"no-comments", no_argument, &no_comments, 1},
@@ -281,6 +283,28 @@ main(int argc, char **argv)
 				set_dump_section(optarg, &(opts->dumpSections));
 				break;
 
+			case 4:				/* maintenance_work_mem */
+				opts->maintenance_work_mem = pg_strdup(optarg);
+				break;
+
+			case 5:				/* max_parallel_maintenance_workers */
+				{
+					char	   *endptr;
+					long		val;
+
+					errno = 0;
+					val = strtol(optarg, &endptr, 10);
+					if (*optarg == '\0' || *endptr != '\0' || errno != 0 ||
+						val < 0 || val > INT_MAX)
+					{
+						fprintf(stderr, _("%s: invalid number of parallel maintenance workers: \"%s\"\n"),
+								progname, optarg);
+						exit_nicely(1);
+					}
+					opts->max_parallel_maintenance_workers = (int) val;
+				}
+				break;
+
 			default:
 				fprintf(stderr, _("Try \"%s --help\" for more information.\n"), progname);
 				exit_nicely(1);
@@ -494,6 +518,10 @@ usage(const char *progname)
 	printf(_("  --disable-triggers           disable triggers during data-only restore\n"));
 	printf(_("  --enable-row-security        enable row security\n"));
 	printf(_("  --if-exists                  use IF EXISTS when dropping objects\n"));
+	printf(_("  --maintenance-work-mem=SIZE  set maintenance_work_mem for index builds\n"));
+	printf(_("  --max-parallel-maintenance-workers=NUM\n"
+			 "                               set max_parallel_maintenance_workers for\n"
+			 "                               index builds\n"));
 	printf(_("  --no-comments                do not restore comments\n"));
 	printf(_("  --no-data-for-failed-tables  do not restore data of tables that could not be\n"
 			 "                               created\n"));
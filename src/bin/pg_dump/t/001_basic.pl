@@ -4,7 +4,7 @@ use warnings;
 use Config;
 use PostgresNode;
 use TestLib;
-use Test::More tests => 70;
+use Test::More tests => 74;
 
 my $tempdir       = TestLib::tempdir;
 my $tempdir_short = TestLib::tempdir_short;
@@ -106,6 +106,16 @@ command_fails_like(
 	qr/\Qpg_dump: compression level must be in range 0..9\E/,
 	'pg_dump: compression level must be in range 0..9');
 
+command_fails_like(
+	[ 'pg_dump', '-Z', 'gzip:12' ],
+	qr/\Qpg_dump: compression level for "gzip" must be in range 1..9\E/,
+	'pg_dump: compression level for "gzip" must be in range 1..9');
+
+command_fails_like(
+	[ 'pg_dump', '-Z', 'foo' ],
+	qr/\Qpg_dump: unrecognized compression method "foo"\E/,
+	'pg_dump: unrecognized compression method');
+
 command_fails_like(
 	[ 'pg_restore', '--if-exists' ],
 	qr/\Qpg_restore: option --if-exists requires option -c\/--clean\E/,
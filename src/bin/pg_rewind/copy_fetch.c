@@ -245,19 +245,37 @@ copy_executeFileMap(filemap_t *map)
 	close_target_file();
 }
 
+/*
+ * Copy the modified blocks of a relation file.  Runs of consecutive blocks
+ * are copied with one rewind_copy_file_range() call, to avoid reopening the
+ * source file for each block.
+ */
 static void
 execute_pagemap(datapagemap_t *pagemap, const char *path)
 {
 	datapagemap_iterator_t *iter;
 	BlockNumber blkno;
-	off_t		offset;
+	BlockNumber runstart = InvalidBlockNumber;
+	BlockNumber runend = InvalidBlockNumber;
 
 	iter = datapagemap_iterate(pagemap);
 	while (datapagemap_next(iter, &blkno))
 	{
-		offset = blkno * BLCKSZ;
-		rewind_copy_file_range(path, offset, offset + BLCKSZ, false);
-		/* Ok, this block has now been copied from new data dir to old */
+		if (runstart != InvalidBlockNumber && blkno == runend)
+		{
+			runend++;
+			continue;
+		}
+
+		if (runstart != InvalidBlockNumber)
+			rewind_copy_file_range(path, (off_t) runstart * BLCKSZ,
+								   (off_t) runend * BLCKSZ, false);
+		runstart = blkno;
+		runend = blkno + 1;
 	}
+	if (runstart != InvalidBlockNumber)
+		rewind_copy_file_range(path, (off_t) runstart * BLCKSZ,
+							   (off_t) runend * BLCKSZ, false);
+	/* Ok, these blocks have now been copied from new data dir to old */
 	pg_free(iter);
 }
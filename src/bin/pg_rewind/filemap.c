@@ -75,6 +75,9 @@ static const char *excludeDirContents[] =
 	/* Contents zeroed on startup, see StartupSUBTRANS(). */
 	"pg_subtrans",
 
+	/* Contents removed on startup, see DoubleWriteStartup(). */
+	"pg_dblwr",
+
 	/* end of list */
 	NULL
 };
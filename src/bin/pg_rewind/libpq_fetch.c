@@ -510,19 +510,36 @@ libpq_executeFileMap(filemap_t *map)
 	receiveFileChunks(sql);
 }
 
+/*
+ * Queue the modified blocks of a relation file for fetching.  Runs of
+ * consecutive blocks are requested as one range, so that they're read with
+ * one pg_read_binary_file() call (per CHUNKSIZE) rather than one per block.
+ */
 static void
 execute_pagemap(datapagemap_t *pagemap, const char *path)
 {
 	datapagemap_iterator_t *iter;
 	BlockNumber blkno;
-	off_t		offset;
+	BlockNumber runstart = InvalidBlockNumber;
+	BlockNumber runend = InvalidBlockNumber;
 
 	iter = datapagemap_iterate(pagemap);
 	while (datapagemap_next(iter, &blkno))
 	{
-		offset = blkno * BLCKSZ;
+		if (runstart != InvalidBlockNumber && blkno == runend)
+		{
+			runend++;
+			continue;
+		}
 
-		fetch_file_range(path, offset, offset + BLCKSZ);
+		if (runstart != InvalidBlockNumber)
+			fetch_file_range(path, (uint64) runstart * BLCKSZ,
+							 (uint64) runend * BLCKSZ);
+		runstart = blkno;
+		runend = blkno + 1;
 	}
+	if (runstart != InvalidBlockNumber)
+		fetch_file_range(path, (uint64) runstart * BLCKSZ,
+						 (uint64) runend * BLCKSZ);
 	pg_free(iter);
 }
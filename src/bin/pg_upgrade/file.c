@@ -97,6 +97,36 @@ copyFile(const char *src, const char *dst,
 		pg_fatal("error while copying relation \"%s.%s\": could not create file \"%s\": %s\n",
 				 schemaName, relName, dst, strerror(errno));
 
+#ifdef HAVE_COPY_FILE_RANGE
+
+	/*
+	 * Let the kernel copy the data if it can.  That avoids moving it through
+	 * user space, and file systems that support reflinks may share the
+	 * blocks instead of copying them.  If the kernel or file system doesn't
+	 * support it, fall back to read/write below, which carries on from
+	 * wherever copy_file_range() stopped.
+	 */
+	for (;;)
+	{
+		ssize_t		nbytes = copy_file_range(src_fd, NULL, dest_fd, NULL,
+											 (size_t) 1 << 30, 0);
+
+		if (nbytes > 0)
+			continue;
+		if (nbytes == 0)
+		{
+			close(src_fd);
+			close(dest_fd);
+			return;
+		}
+		if (errno == EXDEV || errno == ENOSYS || errno == EINVAL ||
+			errno == EOPNOTSUPP)
+			break;
+		pg_fatal("error while copying relation \"%s.%s\" (\"%s\" to \"%s\"): %s\n",
+				 schemaName, relName, src, dst, strerror(errno));
+	}
+#endif
+
 	/* copy in fairly large chunks for best efficiency */
 #define COPY_BUF_SIZE (50 * BLCKSZ)
 
@@ -414,7 +414,7 @@ void transfer_all_new_tablespaces(DbInfoArr *old_db_arr,
 							 DbInfoArr *new_db_arr, char *old_pgdata, char *new_pgdata);
 void transfer_all_new_dbs(DbInfoArr *old_db_arr,
 					 DbInfoArr *new_db_arr, char *old_pgdata, char *new_pgdata,
-					 char *old_tablespace);
+					 char *old_tablespace, int slice, int nslices);
 
 /* tablespace.c */
 
@@ -463,5 +463,5 @@ void parallel_exec_prog(const char *log_file, const char *opt_log_file,
 				   const char *fmt,...) pg_attribute_printf(3, 4);
 void parallel_transfer_all_new_dbs(DbInfoArr *old_db_arr, DbInfoArr *new_db_arr,
 							  char *old_pgdata, char *new_pgdata,
-							  char *old_tablespace);
+							  char *old_tablespace, int slice, int nslices);
 bool		reap_child(bool wait_for_child);
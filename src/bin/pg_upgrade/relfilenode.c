@@ -16,8 +16,10 @@
 #include "access/transam.h"
 
 
-static void transfer_single_new_db(FileNameMap *maps, int size, char *old_tablespace);
-static void transfer_relfile(FileNameMap *map, const char *suffix, bool vm_must_add_frozenbit);
+static void transfer_single_new_db(FileNameMap *maps, int size, char *old_tablespace,
+					   int slice, int nslices);
+static void transfer_relfile(FileNameMap *map, const char *suffix, bool vm_must_add_frozenbit,
+				 int mapnum, int slice, int nslices);
 
 
 /*
@@ -49,24 +51,35 @@ transfer_all_new_tablespaces(DbInfoArr *old_db_arr, DbInfoArr *new_db_arr,
 	 * NULL tablespace path, which matches all tablespaces.  In parallel mode,
 	 * we pass the default tablespace and all user-created tablespaces and let
 	 * those operations happen in parallel.
+	 *
+	 * A cluster often has all its data in just one tablespace, so in parallel
+	 * mode each tablespace is further split into as many slices as there are
+	 * jobs.  Slices are assigned round-robin by relation file segment, see
+	 * transfer_relfile(), so that even a single huge table is transferred by
+	 * all the jobs.
 	 */
 	if (user_opts.jobs <= 1)
 		parallel_transfer_all_new_dbs(old_db_arr, new_db_arr, old_pgdata,
-									  new_pgdata, NULL);
+									  new_pgdata, NULL, 0, 1);
 	else
 	{
 		int			tblnum;
+		int			slice;
 
 		/* transfer default tablespace */
-		parallel_transfer_all_new_dbs(old_db_arr, new_db_arr, old_pgdata,
-									  new_pgdata, old_pgdata);
+		for (slice = 0; slice < user_opts.jobs; slice++)
+			parallel_transfer_all_new_dbs(old_db_arr, new_db_arr, old_pgdata,
+										  new_pgdata, old_pgdata,
+										  slice, user_opts.jobs);
 
 		for (tblnum = 0; tblnum < os_info.num_old_tablespaces; tblnum++)
-			parallel_transfer_all_new_dbs(old_db_arr,
-										  new_db_arr,
-										  old_pgdata,
-										  new_pgdata,
-										  os_info.old_tablespaces[tblnum]);
+			for (slice = 0; slice < user_opts.jobs; slice++)
+				parallel_transfer_all_new_dbs(old_db_arr,
+											  new_db_arr,
+											  old_pgdata,
+											  new_pgdata,
+											  os_info.old_tablespaces[tblnum],
+											  slice, user_opts.jobs);
 		/* reap all children */
 		while (reap_child(true) == true)
 			;
@@ -84,10 +97,14 @@ transfer_all_new_tablespaces(DbInfoArr *old_db_arr, DbInfoArr *new_db_arr,
  *
  * Responsible for upgrading all database. invokes routines to generate mappings and then
  * physically link the databases.
+ *
+ * Only the file segments belonging to the given slice (out of nslices) are
+ * transferred; pass 0 and 1 to transfer everything.
  */
 void
 transfer_all_new_dbs(DbInfoArr *old_db_arr, DbInfoArr *new_db_arr,
-					 char *old_pgdata, char *new_pgdata, char *old_tablespace)
+					 char *old_pgdata, char *new_pgdata, char *old_tablespace,
+					 int slice, int nslices)
 {
 	int			old_dbnum,
 				new_dbnum;
@@ -122,9 +139,12 @@ transfer_all_new_dbs(DbInfoArr *old_db_arr, DbInfoArr *new_db_arr,
 									new_pgdata);
 		if (n_maps)
 		{
-			print_maps(mappings, n_maps, new_db->db_name);
+			/* all slices build the same maps; only print them once */
+			if (slice == 0)
+				print_maps(mappings, n_maps, new_db->db_name);
 
-			transfer_single_new_db(mappings, n_maps, old_tablespace);
+			transfer_single_new_db(mappings, n_maps, old_tablespace,
+								   slice, nslices);
 		}
 		/* We allocate something even for n_maps == 0 */
 		pg_free(mappings);
@@ -139,7 +159,8 @@ transfer_all_new_dbs(DbInfoArr *old_db_arr, DbInfoArr *new_db_arr,
  * create links for mappings stored in "maps" array.
  */
 static void
-transfer_single_new_db(FileNameMap *maps, int size, char *old_tablespace)
+transfer_single_new_db(FileNameMap *maps, int size, char *old_tablespace,
+					   int slice, int nslices)
 {
 	int			mapnum;
 	bool		vm_crashsafe_match = true;
@@ -166,7 +187,8 @@ transfer_single_new_db(FileNameMap *maps, int size, char *old_tablespace)
 			strcmp(maps[mapnum].old_tablespace, old_tablespace) == 0)
 		{
 			/* transfer primary file */
-			transfer_relfile(&maps[mapnum], "", vm_must_add_frozenbit);
+			transfer_relfile(&maps[mapnum], "", vm_must_add_frozenbit,
+							 mapnum, slice, nslices);
 
 			/* fsm/vm files added in PG 8.4 */
 			if (GET_MAJOR_VERSION(old_cluster.major_version) >= 804)
@@ -174,9 +196,11 @@ transfer_single_new_db(FileNameMap *maps, int size, char *old_tablespace)
 				/*
 				 * Copy/link any fsm and vm files, if they exist
 				 */
-				transfer_relfile(&maps[mapnum], "_fsm", vm_must_add_frozenbit);
+				transfer_relfile(&maps[mapnum], "_fsm", vm_must_add_frozenbit,
+								 mapnum, slice, nslices);
 				if (vm_crashsafe_match)
-					transfer_relfile(&maps[mapnum], "_vm", vm_must_add_frozenbit);
+					transfer_relfile(&maps[mapnum], "_vm", vm_must_add_frozenbit,
+									 mapnum, slice, nslices);
 			}
 		}
 	}
@@ -189,9 +213,15 @@ transfer_single_new_db(FileNameMap *maps, int size, char *old_tablespace)
  * Copy or link file from old cluster to new one.  If vm_must_add_frozenbit
  * is true, visibility map forks are converted and rewritten, even in link
  * mode.
+ *
+ * Segment segno of the relation at position mapnum in the maps belongs to
+ * slice (mapnum + segno) % nslices; segments of other slices are skipped.
+ * This spreads consecutive segments of a large relation over the slices,
+ * while its small fsm and vm forks stay with its first segment.
  */
 static void
-transfer_relfile(FileNameMap *map, const char *type_suffix, bool vm_must_add_frozenbit)
+transfer_relfile(FileNameMap *map, const char *type_suffix, bool vm_must_add_frozenbit,
+				 int mapnum, int slice, int nslices)
 {
 	char		old_file[MAXPGPATH];
 	char		new_file[MAXPGPATH];
@@ -246,6 +276,10 @@ transfer_relfile(FileNameMap *map, const char *type_suffix, bool vm_must_add_fro
 				return;
 		}
 
+		/* Leave segments of other slices to their jobs */
+		if ((mapnum + segno) % nslices != slice)
+			continue;
+
 		unlink(new_file);
 
 		/* Copying files might take some time, so give feedback. */
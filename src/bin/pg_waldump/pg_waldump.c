@@ -47,6 +47,7 @@ typedef struct XLogDumpConfig
 	bool		follow;
 	bool		stats;
 	bool		stats_per_record;
+	bool		stats_per_relation;
 
 	/* filter options */
 	int			filter_by_rmgr;
@@ -63,11 +64,29 @@ typedef struct Stats
 
 #define MAX_XLINFO_TYPES 16
 
+/* Entry in the hash table of per-relation statistics */
+typedef struct RelStats
+{
+	bool		used;
+	RelFileNode rnode;
+	Stats		stats;
+} RelStats;
+
 typedef struct XLogDumpStats
 {
 	uint64		count;
 	Stats		rmgr_stats[RM_NEXT_ID];
 	Stats		record_stats[RM_NEXT_ID][MAX_XLINFO_TYPES];
+
+	/*
+	 * Per-relation statistics, for --stats=relation.  rel_stats is an
+	 * open-addressing hash table of rel_stats_size entries (a power of 2);
+	 * norel_stats counts the records that reference no relation at all.
+	 */
+	RelStats   *rel_stats;
+	int			rel_stats_size;
+	int			rel_stats_used;
+	Stats		norel_stats;
 } XLogDumpStats;
 
 static void fatal_error(const char *fmt,...) pg_attribute_printf(1, 2);
@@ -494,6 +513,96 @@ XLogDumpRecordLen(XLogReaderState *record, uint32 *rec_len, uint32 *fpi_len)
 	*rec_len = XLogRecGetTotalLen(record) - *fpi_len;
 }
 
+/*
+ * Find or create the per-relation statistics entry for rnode.
+ */
+static Stats *
+XLogDumpRelStats(XLogDumpStats *stats, RelFileNode *rnode)
+{
+	uint32		hash;
+	int			i;
+
+	/* Keep the table at most half full */
+	if (stats->rel_stats_used >= stats->rel_stats_size / 2)
+	{
+		RelStats   *old = stats->rel_stats;
+		int			oldsize = stats->rel_stats_size;
+
+		stats->rel_stats_size = Max(oldsize * 2, 1024);
+		stats->rel_stats = (RelStats *)
+			pg_malloc0(stats->rel_stats_size * sizeof(RelStats));
+		stats->rel_stats_used = 0;
+		for (i = 0; i < oldsize; i++)
+		{
+			if (old[i].used)
+				*XLogDumpRelStats(stats, &old[i].rnode) = old[i].stats;
+		}
+		if (old)
+			pg_free(old);
+	}
+
+	hash = ((rnode->spcNode * 31 + rnode->dbNode) * 31 + rnode->relNode) *
+		UINT64CONST(0x9E3779B1) >> 8;
+	for (i = hash & (stats->rel_stats_size - 1);;
+		 i = (i + 1) & (stats->rel_stats_size - 1))
+	{
+		RelStats   *entry = &stats->rel_stats[i];
+
+		if (!entry->used)
+		{
+			entry->used = true;
+			entry->rnode = *rnode;
+			stats->rel_stats_used++;
+			return &entry->stats;
+		}
+		if (RelFileNodeEquals(entry->rnode, *rnode))
+			return &entry->stats;
+	}
+}
+
+/*
+ * Attribute a record's size to the relations it touches.  The record itself
+ * (its main data and block data) is charged to the relation of its first
+ * block reference, which is the block the record is mainly about; each
+ * full-page image is charged to the relation it's an image of.
+ */
+static void
+XLogDumpCountRelations(XLogDumpStats *stats, XLogReaderState *record,
+					   uint32 rec_len)
+{
+	int			block_id;
+	bool		counted = false;
+
+	for (block_id = 0; block_id <= record->max_block_id; block_id++)
+	{
+		RelFileNode rnode;
+		ForkNumber	forknum;
+		BlockNumber blk;
+		Stats	   *relstats;
+
+		if (!XLogRecHasBlockRef(record, block_id))
+			continue;
+
+		XLogRecGetBlockTag(record, block_id, &rnode, &forknum, &blk);
+		relstats = XLogDumpRelStats(stats, &rnode);
+
+		if (!counted)
+		{
+			relstats->count++;
+			relstats->rec_len += rec_len;
+			counted = true;
+		}
+		if (XLogRecHasBlockImage(record, block_id))
+			relstats->fpi_len += record->blocks[block_id].bimg_len;
+	}
+
+	if (!counted)
+	{
+		stats->norel_stats.count++;
+		stats->norel_stats.rec_len += rec_len;
+	}
+}
+
 /*
  * Store per-rmgr and per-record statistics for a given record.
  */
@@ -530,6 +639,9 @@ XLogDumpCountRecord(XLogDumpConfig *config, XLogDumpStats *stats,
 	stats->record_stats[rmid][recid].count++;
 	stats->record_stats[rmid][recid].rec_len += rec_len;
 	stats->record_stats[rmid][recid].fpi_len += fpi_len;
+
+	if (config->stats_per_relation)
+		XLogDumpCountRelations(stats, record, rec_len);
 }
 
 /*
@@ -616,15 +728,26 @@ XLogDumpDisplayRecord(XLogDumpConfig *config, XLogReaderState *record)
 				if (record->blocks[block_id].bimg_info &
 					BKPIMAGE_IS_COMPRESSED)
 				{
+					uint8		bimg_info = record->blocks[block_id].bimg_info;
+					const char *method;
+
+					if (bimg_info & BKPIMAGE_COMPRESS_LZ4)
+						method = "lz4";
+					else if (bimg_info & BKPIMAGE_COMPRESS_ZSTD)
+						method = "zstd";
+					else
+						method = "pglz";
+
 					printf(" (FPW%s); hole: offset: %u, length: %u, "
-						   "compression saved: %u\n",
+						   "compression saved: %u, method: %s\n",
 						   XLogRecBlockImageApply(record, block_id) ?
 						   "" : " for WAL verification",
 						   record->blocks[block_id].hole_offset,
 						   record->blocks[block_id].hole_length,
 						   BLCKSZ -
 						   record->blocks[block_id].hole_length -
-						   record->blocks[block_id].bimg_len);
+						   record->blocks[block_id].bimg_len,
+						   method);
 				}
 				else
 				{
@@ -681,6 +804,24 @@ XLogDumpStatsRow(const char *name,
 }
 
 
+/*
+ * qsort comparator to sort relations by descending combined size.
+ */
+static int
+RelStatsCmp(const void *a, const void *b)
+{
+	const RelStats *ra = (const RelStats *) a;
+	const RelStats *rb = (const RelStats *) b;
+	uint64		la = ra->stats.rec_len + ra->stats.fpi_len;
+	uint64		lb = rb->stats.rec_len + rb->stats.fpi_len;
+
+	if (la > lb)
+		return -1;
+	if (la < lb)
+		return 1;
+	return 0;
+}
+
 /*
  * Display summary statistics about the records seen so far.
  */
@@ -724,7 +865,45 @@ XLogDumpDisplayStats(XLogDumpConfig *config, XLogDumpStats *stats)
 		   "Type", "N", "(%)", "Record size", "(%)", "FPI size", "(%)", "Combined size", "(%)",
 		   "----", "-", "---", "-----------", "---", "--------", "---", "-------------", "---");
 
-	for (ri = 0; ri < RM_NEXT_ID; ri++)
+	if (config->stats_per_relation)
+	{
+		int			nrels = 0;
+
+		/*
+		 * Compact the used hash table entries to the front, and show them
+		 * biggest first.
+		 */
+		for (ri = 0; ri < stats->rel_stats_size; ri++)
+		{
+			if (stats->rel_stats[ri].used)
+				stats->rel_stats[nrels++] = stats->rel_stats[ri];
+		}
+		if (nrels > 0)
+			qsort(stats->rel_stats, nrels, sizeof(RelStats), RelStatsCmp);
+
+		for (ri = 0; ri < nrels; ri++)
+		{
+			RelStats   *entry = &stats->rel_stats[ri];
+
+			XLogDumpStatsRow(psprintf("%u/%u/%u",
+									  entry->rnode.spcNode,
+									  entry->rnode.dbNode,
+									  entry->rnode.relNode),
+							 entry->stats.count, total_count,
+							 entry->stats.rec_len, total_rec_len,
+							 entry->stats.fpi_len, total_fpi_len,
+							 entry->stats.rec_len + entry->stats.fpi_len,
+							 total_len);
+		}
+		if (stats->norel_stats.count > 0)
+			XLogDumpStatsRow("(no relation)",
+							 stats->norel_stats.count, total_count,
+							 stats->norel_stats.rec_len, total_rec_len,
+							 0, total_fpi_len,
+							 stats->norel_stats.rec_len, total_len);
+	}
+
+	for (ri = 0; ri < RM_NEXT_ID && !config->stats_per_relation; ri++)
 	{
 		uint64		count,
 					rec_len,
@@ -821,8 +1000,10 @@ usage(void)
 			 "                         (default: 1 or the value used in STARTSEG)\n"));
 	printf(_("  -V, --version          output version information, then exit\n"));
 	printf(_("  -x, --xid=XID          only show records with transaction ID XID\n"));
-	printf(_("  -z, --stats[=record]   show statistics instead of records\n"
-			 "                         (optionally, show per-record statistics)\n"));
+	printf(_("  -z, --stats[=record|relation]\n"
+			 "                         show statistics instead of records\n"
+			 "                         (optionally, show per-record or per-relation\n"
+			 "                         statistics)\n"));
 	printf(_("  -?, --help             show this help, then exit\n"));
 }
 
@@ -879,6 +1060,7 @@ main(int argc, char **argv)
 	config.filter_by_xid_enabled = false;
 	config.stats = false;
 	config.stats_per_record = false;
+	config.stats_per_relation = false;
 
 	if (argc <= 1)
 	{
@@ -982,10 +1164,13 @@ main(int argc, char **argv)
 			case 'z':
 				config.stats = true;
 				config.stats_per_record = false;
+				config.stats_per_relation = false;
 				if (optarg)
 				{
 					if (strcmp(optarg, "record") == 0)
 						config.stats_per_record = true;
+					else if (strcmp(optarg, "relation") == 0)
+						config.stats_per_relation = true;
 					else if (strcmp(optarg, "rmgr") != 0)
 					{
 						fprintf(stderr, _("%s: unrecognized argument to --stats: %s\n"),
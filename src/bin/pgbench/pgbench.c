@@ -160,6 +160,23 @@ int			fillfactor = 100;
  */
 bool		unlogged_tables = false;
 
+/*
+ * number of partitions of pgbench_accounts (0 = not partitioned), and how
+ * they are created.  In benchmarking mode, these are looked up in the
+ * catalogs for the report.
+ */
+typedef enum
+{
+	PART_NONE,					/* no partitioning */
+	PART_RANGE,					/* range partitioning on aid */
+	PART_HASH					/* hash partitioning on aid */
+} PartitionMethod;
+
+static const char *PARTITION_METHOD[] = {"none", "range", "hash"};
+
+int			partitions = 0;
+PartitionMethod partition_method = PART_NONE;
+
 /*
  * log sampling rate (1.0 = log everything, 0.0 = option not given)
  */
@@ -213,9 +230,16 @@ int			agg_interval;		/* log aggregates instead of individual
 bool		per_script_stats = false;	/* whether to collect stats per script */
 int			progress = 0;		/* thread progress report every this seconds */
 bool		progress_timestamp = false; /* progress report with Unix time */
+
+#define MAX_PERCENTILES 16
+double		percentiles[MAX_PERCENTILES];	/* latency percentiles to report */
+int			npercentiles = 0;
+char	   *histogram_file = NULL;	/* where to write the latency histogram */
+bool		collect_histogram = false;	/* whether to fill latency_hist */
 int			nclients = 1;		/* number of clients */
 int			nthreads = 1;		/* number of threads */
 bool		is_connect;			/* establish connection for each transaction */
+bool		pipeline = false;	/* send each script's commands as a pipeline */
 bool		report_per_command;	/* report per-command latencies */
 int			main_pid;			/* main process id used in log filename */
 
@@ -265,6 +289,25 @@ typedef struct SimpleStats
 	double		sum2;			/* sum of squared values */
 } SimpleStats;
 
+/*
+ * Latency histogram, with HDR-style log-linear buckets.  Latencies below
+ * 2 * LHIST_SUB_BUCKETS microseconds get one bucket each; above that, each
+ * power-of-two range of latencies is split into LHIST_SUB_BUCKETS equally
+ * wide buckets, so the relative error of any percentile computed from the
+ * histogram is below 1 / LHIST_SUB_BUCKETS.  Latencies of 2^40 us (about
+ * 12 days) or more all go into the last bucket.
+ */
+#define LHIST_SUB_BITS		6
+#define LHIST_SUB_BUCKETS	(1 << LHIST_SUB_BITS)
+#define LHIST_MAX_SHIFT		33
+#define LHIST_NBUCKETS		((LHIST_MAX_SHIFT + 2) * LHIST_SUB_BUCKETS)
+#define LHIST_MAX_VALUE		(INT64CONST(1) << (LHIST_MAX_SHIFT + LHIST_SUB_BITS + 1))
+
+typedef struct LatencyHistogram
+{
+	int64		counts[LHIST_NBUCKETS];
+} LatencyHistogram;
+
 /*
  * Data structure to hold various statistics: per-thread and per-script stats
  * are maintained and merged together.
@@ -277,6 +320,7 @@ typedef struct StatsData
 								 * and --latency-limit */
 	SimpleStats latency;
 	SimpleStats lag;
+	LatencyHistogram latency_hist;	/* filled only if collect_histogram */
 } StatsData;
 
 /*
@@ -344,12 +388,17 @@ typedef enum
 	 * executed. It quickly skip commands that do not need any evaluation.
 	 * This state can move forward several commands, till there is something
 	 * to do or the end of the script.
+	 *
+	 * Under --pipeline, a SQL command goes straight to CSTATE_END_COMMAND
+	 * once sent.  At the end of the script, a pipeline sync is sent, and
+	 * CSTATE_WAIT_PIPELINE collects the results of all the commands.
 	 */
 	CSTATE_START_COMMAND,
 	CSTATE_WAIT_RESULT,
 	CSTATE_SLEEP,
 	CSTATE_END_COMMAND,
 	CSTATE_SKIP_COMMAND,
+	CSTATE_WAIT_PIPELINE,
 
 	/*
 	 * CSTATE_END_TX performs end-of-transaction processing.  It calculates
@@ -400,6 +449,7 @@ typedef struct
 	instr_time	stmt_begin;		/* used for measuring statement latencies */
 
 	bool		prepared[MAX_SCRIPTS];	/* whether client prepared the script */
+	bool		pipeline_pending;	/* commands await results, in --pipeline */
 
 	/* per client collected stats */
 	int64		cnt;			/* client transaction count, for -t */
@@ -468,6 +518,24 @@ typedef struct
 
 #define INVALID_THREAD		((pthread_t) 0)
 
+/*
+ * State of one range of pgbench_accounts rows during initialization.  With
+ * -j, each range is loaded by its own thread over its own connection.
+ */
+typedef struct
+{
+	pthread_t	thread;			/* thread handle */
+	PGconn	   *con;			/* connection used to load this range */
+	int64		start;			/* first row (0-based) to generate */
+	int64		end;			/* one past the last row to generate */
+	bool		server_side;	/* generate rows with INSERT ... SELECT? */
+	bool		is_reporter;	/* report progress for all ranges? */
+	volatile int64 done;		/* number of rows sent so far */
+} InitRange;
+
+static InitRange *initRanges = NULL;
+static int	nInitRanges = 0;
+
 /*
  * queries read from files
  */
@@ -614,8 +682,9 @@ usage(void)
 		   "  %s [OPTION]... [DBNAME]\n"
 		   "\nInitialization options:\n"
 		   "  -i, --initialize         invokes initialization mode\n"
-		   "  -I, --init-steps=[dtgvpf]+ (default \"dtgvp\")\n"
+		   "  -I, --init-steps=[dtgGvpf]+ (default \"dtgvp\")\n"
 		   "                           run selected initialization steps\n"
+		   "                           (g = client-side, G = server-side data generation)\n"
 		   "  -F, --fillfactor=NUM     set fill factor\n"
 		   "  -n, --no-vacuum          do not run VACUUM during initialization\n"
 		   "  -q, --quiet              quiet logging (one message each 5 seconds)\n"
@@ -623,6 +692,9 @@ usage(void)
 		   "  --foreign-keys           create foreign key constraints between tables\n"
 		   "  --index-tablespace=TABLESPACE\n"
 		   "                           create indexes in the specified tablespace\n"
+		   "  --partitions=NUM         partition pgbench_accounts into NUM parts (default: 0)\n"
+		   "  --partition-method=(range|hash)\n"
+		   "                           partition pgbench_accounts with this method (default: range)\n"
 		   "  --tablespace=TABLESPACE  create tables in the specified tablespace\n"
 		   "  --unlogged-tables        create tables as unlogged tables\n"
 		   "\nOptions to select what to run:\n"
@@ -638,7 +710,8 @@ usage(void)
 		   "  -C, --connect            establish new connection for each transaction\n"
 		   "  -D, --define=VARNAME=VALUE\n"
 		   "                           define variable for use by custom script\n"
-		   "  -j, --jobs=NUM           number of threads (default: 1)\n"
+		   "  -j, --jobs=NUM           number of threads (default: 1); with -i,\n"
+		   "                           number of connections generating data\n"
 		   "  -l, --log                write transaction times to log file\n"
 		   "  -L, --latency-limit=NUM  count transactions lasting more than NUM ms as late\n"
 		   "  -M, --protocol=simple|extended|prepared\n"
@@ -652,8 +725,13 @@ usage(void)
 		   "  -T, --time=NUM           duration of benchmark test in seconds\n"
 		   "  -v, --vacuum-all         vacuum all four standard tables before tests\n"
 		   "  --aggregate-interval=NUM aggregate data over NUM seconds\n"
+		   "  --latency-histogram=FILENAME\n"
+		   "                           write latency histogram to FILENAME\n"
+		   "  --latency-percentiles=LIST\n"
+		   "                           report these latency percentiles (e.g., 50,99,99.9)\n"
 		   "  --log-prefix=PREFIX      prefix for transaction time log file\n"
 		   "                           (default: \"pgbench_log\")\n"
+		   "  --pipeline               send the commands of each script in a pipeline\n"
 		   "  --progress-timestamp     use Unix epoch timestamps for progress\n"
 		   "  --random-seed=SEED       set random seed (\"time\", \"rand\", integer)\n"
 		   "  --sampling-rate=NUM      fraction of transactions to log (e.g., 0.01 for 1%%)\n"
@@ -1156,6 +1234,97 @@ mergeSimpleStats(SimpleStats *acc, SimpleStats *ss)
 	acc->sum2 += ss->sum2;
 }
 
+/*
+ * Return the histogram bucket for a latency of val microseconds.
+ */
+static int
+latencyBucket(double val)
+{
+	int64		v = (int64) val;
+	int			shift = 0;
+
+	if (v < 0)
+		v = 0;
+	if (v >= LHIST_MAX_VALUE)
+		return LHIST_NBUCKETS - 1;
+
+	/* find the shift that brings v into [SUB_BUCKETS, 2 * SUB_BUCKETS) */
+	while ((v >> shift) >= 2 * LHIST_SUB_BUCKETS)
+		shift++;
+
+	return shift * LHIST_SUB_BUCKETS + (int) (v >> shift);
+}
+
+/*
+ * Return the range of latencies, in microseconds, covered by a bucket.
+ */
+static void
+latencyBucketRange(int bucket, int64 *lo, int64 *hi)
+{
+	if (bucket < 2 * LHIST_SUB_BUCKETS)
+	{
+		*lo = *hi = bucket;
+	}
+	else
+	{
+		int			shift = bucket / LHIST_SUB_BUCKETS - 1;
+		int64		sub = bucket - shift * LHIST_SUB_BUCKETS;
+
+		*lo = sub << shift;
+		*hi = *lo + (INT64CONST(1) << shift) - 1;
+	}
+}
+
+/*
+ * Merge two latency histograms
+ */
+static void
+mergeHistogram(LatencyHistogram *acc, LatencyHistogram *h)
+{
+	int			i;
+
+	for (i = 0; i < LHIST_NBUCKETS; i++)
+		acc->counts[i] += h->counts[i];
+}
+
+/*
+ * Compute the given percentile of the latencies recorded in h, in
+ * microseconds.  If base isn't NULL, its counts are subtracted first, which
+ * gives the percentile over the values recorded since base was copied.
+ *
+ * The upper end of the bucket holding the percentile is returned, so the
+ * result is never below the exact value.  Returns -1 if there is no data.
+ */
+static double
+histogramPercentile(LatencyHistogram *h, LatencyHistogram *base, double pct)
+{
+	int64		total = 0;
+	int64		target;
+	int64		seen = 0;
+	int64		lo,
+				hi;
+	int			i;
+
+	for (i = 0; i < LHIST_NBUCKETS; i++)
+		total += h->counts[i] - (base ? base->counts[i] : 0);
+	if (total <= 0)
+		return -1;
+
+	target = (int64) ceil(total * pct / 100.0);
+	if (target < 1)
+		target = 1;
+
+	for (i = 0; i < LHIST_NBUCKETS - 1; i++)
+	{
+		seen += h->counts[i] - (base ? base->counts[i] : 0);
+		if (seen >= target)
+			break;
+	}
+
+	latencyBucketRange(i, &lo, &hi);
+	return (double) hi;
+}
+
 /*
  * Initialize a StatsData struct to mostly zeroes, with its start time set to
  * the given value.
@@ -1168,6 +1337,7 @@ initStats(StatsData *sd, time_t start_time)
 	sd->skipped = 0;
 	initSimpleStats(&sd->latency);
 	initSimpleStats(&sd->lag);
+	memset(&sd->latency_hist, 0, sizeof(LatencyHistogram));
 }
 
 /*
@@ -1186,6 +1356,8 @@ accumStats(StatsData *stats, bool skipped, double lat, double lag)
 	else
 	{
 		addToSimpleStats(&stats->latency, lat);
+		if (collect_histogram)
+			stats->latency_hist.counts[latencyBucket(lat)]++;
 
 		/* and possibly the same for schedule lag */
 		if (throttle_delay)
@@ -2764,6 +2936,14 @@ sendCommand(CState *st, Command *command)
 				if (commands[j]->type != SQL_COMMAND)
 					continue;
 				preparedStatementName(name, st->use_file, j);
+				if (pipeline)
+				{
+					/* the result is collected with the rest of the pipeline */
+					if (PQsendPrepare(st->con, name, commands[j]->argv[0],
+									  commands[j]->argc - 1, NULL) == 0)
+						fprintf(stderr, "%s", PQerrorMessage(st->con));
+					continue;
+				}
 				res = PQprepare(st->con, name,
 								commands[j]->argv[0], commands[j]->argc - 1, NULL);
 				if (PQresultStatus(res) != PGRES_COMMAND_OK)
@@ -2903,6 +3083,14 @@ advanceConnectionState(TState *thread, CState *st, StatsData *agg)
 					INSTR_TIME_SET_CURRENT(now);
 					INSTR_TIME_ACCUM_DIFF(thread->conn_time, now, start);
 
+					if (pipeline && !PQenterPipelineMode(st->con))
+					{
+						fprintf(stderr, "client %d could not enter pipeline mode: %s",
+								st->id, PQerrorMessage(st->con));
+						st->state = CSTATE_ABORTED;
+						break;
+					}
+
 					/* Reset session-local state */
 					memset(st->prepared, 0, sizeof(st->prepared));
 				}
@@ -3006,6 +3194,18 @@ advanceConnectionState(TState *thread, CState *st, StatsData *agg)
 				/* Transition to script end processing if done */
 				if (sql_script[st->use_file].commands[st->command] == NULL)
 				{
+					/* but first collect the results of a pipeline */
+					if (st->pipeline_pending)
+					{
+						if (!PQpipelineSync(st->con))
+						{
+							commandFailed(st, "SQL", "pipeline sync failed");
+							st->state = CSTATE_ABORTED;
+							break;
+						}
+						st->state = CSTATE_WAIT_PIPELINE;
+						break;
+					}
 					st->state = CSTATE_END_TX;
 					break;
 				}
@@ -3161,6 +3361,50 @@ advanceConnectionState(TState *thread, CState *st, StatsData *agg)
 				}
 				break;
 
+				/*
+				 * Wait for the results of all the commands of the script sent
+				 * under --pipeline, up to the closing pipeline sync
+				 */
+			case CSTATE_WAIT_PIPELINE:
+				if (debug)
+					fprintf(stderr, "client %d receiving pipeline\n", st->id);
+				if (!PQconsumeInput(st->con))
+				{
+					/* there's something wrong */
+					commandFailed(st, "SQL", "perhaps the backend died while processing");
+					st->state = CSTATE_ABORTED;
+					break;
+				}
+				while (st->state == CSTATE_WAIT_PIPELINE)
+				{
+					if (PQisBusy(st->con))
+						return;	/* don't have the next result yet */
+
+					/* a null result just ends the results of one command */
+					res = PQgetResult(st->con);
+					if (res == NULL)
+						continue;
+
+					switch (PQresultStatus(res))
+					{
+						case PGRES_COMMAND_OK:
+						case PGRES_TUPLES_OK:
+						case PGRES_EMPTY_QUERY:
+							/* OK */
+							break;
+						case PGRES_PIPELINE_SYNC:
+							st->pipeline_pending = false;
+							st->state = CSTATE_END_TX;
+							break;
+						default:
+							commandFailed(st, "SQL", PQerrorMessage(st->con));
+							st->state = CSTATE_ABORTED;
+							break;
+					}
+					PQclear(res);
+				}
+				break;
+
 				/*
 				 * Wait until sleep is done. This state is entered after a
 				 * \sleep metacommand. The behavior is similar to
@@ -3271,6 +3515,12 @@ doExecuteCommand(TState *thread, CState *st, instr_time now)
 			commandFailed(st, "SQL", "SQL command send failed");
 			st->state = CSTATE_ABORTED;
 		}
+		else if (pipeline)
+		{
+			/* results are collected at the end of the script */
+			st->pipeline_pending = true;
+			st->state = CSTATE_END_COMMAND;
+		}
 		else
 			st->state = CSTATE_WAIT_RESULT;
 	}
@@ -3523,7 +3773,8 @@ processXactStats(TState *thread, CState *st, instr_time *now,
 {
 	double		latency = 0.0,
 				lag = 0.0;
-	bool		thread_details = progress || throttle_delay || latency_limit,
+	bool		thread_details = progress || throttle_delay || latency_limit ||
+		collect_histogram,
 				detailed = thread_details || use_log || per_script_stats;
 
 	if (detailed && !skipped)
@@ -3591,6 +3842,60 @@ initDropTables(PGconn *con)
 					 "pgbench_tellers");
 }
 
+/*
+ * Create the partitions of pgbench_accounts
+ *
+ * Range partitions split the aid range of the current scale into equal
+ * parts; the first and last are left open-ended, so that any aid can be
+ * routed.  Hash partitions use modulus = number of partitions.
+ */
+static void
+initCreatePartitions(PGconn *con)
+{
+	int64		part_size = ((int64) naccounts * scale + partitions - 1) / partitions;
+	int			p;
+
+	fprintf(stderr, "creating %d partitions...\n", partitions);
+
+	for (p = 1; p <= partitions; p++)
+	{
+		char		bound[128];
+		char		buffer[512];
+
+		if (partition_method == PART_RANGE)
+		{
+			char		lo[32];
+			char		hi[32];
+
+			if (p == 1)
+				strlcpy(lo, "minvalue", sizeof(lo));
+			else
+				snprintf(lo, sizeof(lo), INT64_FORMAT, (p - 1) * part_size + 1);
+			if (p == partitions)
+				strlcpy(hi, "maxvalue", sizeof(hi));
+			else
+				snprintf(hi, sizeof(hi), INT64_FORMAT, p * part_size + 1);
+
+			snprintf(bound, sizeof(bound), "from (%s) to (%s)", lo, hi);
+		}
+		else
+		{
+			Assert(partition_method == PART_HASH);
+			snprintf(bound, sizeof(bound),
+					 "with (modulus %d, remainder %d)", partitions, p - 1);
+		}
+
+		/* partitions inherit the tablespace of pgbench_accounts */
+		snprintf(buffer, sizeof(buffer),
+				 "create%s table pgbench_accounts_%d partition of pgbench_accounts "
+				 "for values %s with (fillfactor=%d)",
+				 unlogged_tables ? " unlogged" : "",
+				 p, bound, fillfactor);
+
+		executeStatement(con, buffer);
+	}
+}
+
 /*
  * Create pgbench's standard tables
  */
@@ -3664,7 +3969,14 @@ initCreateTables(PGconn *con)
 
 		/* Construct new create table statement. */
 		opts[0] = '\0';
-		if (ddl->declare_fillfactor)
+
+		/* fillfactor goes on partitions, not on the partitioned table */
+		if (partition_method != PART_NONE &&
+			strcmp(ddl->table, "pgbench_accounts") == 0)
+			snprintf(opts + strlen(opts), sizeof(opts) - strlen(opts),
+					 " partition by %s (aid)",
+					 PARTITION_METHOD[partition_method]);
+		else if (ddl->declare_fillfactor)
 			snprintf(opts + strlen(opts), sizeof(opts) - strlen(opts),
 					 " with (fillfactor=%d)", fillfactor);
 		if (tablespace != NULL)
@@ -3686,51 +3998,54 @@ initCreateTables(PGconn *con)
 
 		executeStatement(con, buffer);
 	}
+
+	if (partition_method != PART_NONE)
+		initCreatePartitions(con);
 }
 
 /*
- * Fill the standard tables with some data
+ * Truncate away any old data, in one command in case there are foreign keys
  */
 static void
-initGenerateData(PGconn *con)
+initTruncateTables(PGconn *con)
 {
-	char		sql[256];
-	PGresult   *res;
-	int			i;
-	int64		k;
-
-	/* used to track elapsed time and estimate of the remaining time */
-	instr_time	start,
-				diff;
-	double		elapsed_sec,
-				remaining_sec;
-	int			log_interval = 1;
-
-	fprintf(stderr, "generating data...\n");
-
-	/*
-	 * we do all of this in one transaction to enable the backend's
-	 * data-loading optimizations
-	 */
-	executeStatement(con, "begin");
-
-	/*
-	 * truncate away any old data, in one command in case there are foreign
-	 * keys
-	 */
 	executeStatement(con, "truncate table "
 					 "pgbench_accounts, "
 					 "pgbench_branches, "
 					 "pgbench_history, "
 					 "pgbench_tellers");
+}
+
+/*
+ * Fill pgbench_branches and pgbench_tellers.  These are small, so the only
+ * difference between client- and server-side generation is the number of
+ * round trips.  The "filler" columns default to NULL.
+ */
+static void
+initGenerateBranchesTellers(PGconn *con, bool server_side)
+{
+	char		sql[256];
+	int			i;
+
+	if (server_side)
+	{
+		snprintf(sql, sizeof(sql),
+				 "insert into pgbench_branches(bid,bbalance) "
+				 "select bid, 0 from generate_series(1, %d) as bid",
+				 nbranches * scale);
+		executeStatement(con, sql);
+
+		snprintf(sql, sizeof(sql),
+				 "insert into pgbench_tellers(tid,bid,tbalance) "
+				 "select tid, (tid - 1) / %d + 1, 0 "
+				 "from generate_series(1, %d) as tid",
+				 ntellers, ntellers * scale);
+		executeStatement(con, sql);
+		return;
+	}
 
-	/*
-	 * fill branches, tellers, accounts in that order in case foreign keys
-	 * already exist
-	 */
 	for (i = 0; i < nbranches * scale; i++)
 	{
-		/* "filler" column defaults to NULL */
 		snprintf(sql, sizeof(sql),
 				 "insert into pgbench_branches(bid,bbalance) values(%d,0)",
 				 i + 1);
@@ -3739,16 +4054,82 @@ initGenerateData(PGconn *con)
 
 	for (i = 0; i < ntellers * scale; i++)
 	{
-		/* "filler" column defaults to NULL */
 		snprintf(sql, sizeof(sql),
 				 "insert into pgbench_tellers(tid,bid,tbalance) values (%d,%d,0)",
 				 i + 1, i / ntellers + 1);
 		executeStatement(con, sql);
 	}
+}
+
+/*
+ * Report progress of filling pgbench_accounts, summed over all ranges.
+ * Only the range loaded by the main thread reports; the other threads'
+ * counters are read without locking, which is good enough for a progress
+ * message.
+ */
+static void
+reportAccountsProgress(instr_time start, int64 *log_interval, bool last)
+{
+	int64		total = (int64) naccounts * scale;
+	int64		j = 0;
+	instr_time	diff;
+	double		elapsed_sec,
+				remaining_sec;
+	int			i;
+
+	for (i = 0; i < nInitRanges; i++)
+		j += initRanges[i].done;
+
+	INSTR_TIME_SET_CURRENT(diff);
+	INSTR_TIME_SUBTRACT(diff, start);
+
+	elapsed_sec = INSTR_TIME_GET_DOUBLE(diff);
+	remaining_sec = (j > 0) ? ((double) total - j) * elapsed_sec / j : 0.0;
+
+	/* in quiet mode, only report once per interval (or at the end) */
+	if (use_quiet)
+	{
+		if (!last && elapsed_sec < *log_interval * LOG_STEP_SECONDS)
+			return;
+		/* skip to the next interval */
+		*log_interval = (int64) ceil(elapsed_sec / LOG_STEP_SECONDS);
+	}
+
+	fprintf(stderr, INT64_FORMAT " of " INT64_FORMAT " tuples (%d%%) done (elapsed %.2f s, remaining %.2f s)\n",
+			j, total, (int) ((j * 100) / total),
+			elapsed_sec, remaining_sec);
+}
+
+/*
+ * Fill one range of pgbench_accounts, using the range's own connection.
+ *
+ * Client-side generation formats every row here and streams it through
+ * COPY; server-side generation sends a single INSERT ... SELECT over
+ * generate_series() and lets the server build the rows.
+ */
+static void
+initGenerateAccounts(InitRange *range)
+{
+	PGconn	   *con = range->con;
+	char		sql[256];
+	PGresult   *res;
+	int64		k;
+	instr_time	start;
+	int64		log_interval = 1;
+
+	if (range->server_side)
+	{
+		/* "filler" column gets a blank padded empty string, as with COPY */
+		snprintf(sql, sizeof(sql),
+				 "insert into pgbench_accounts(aid,bid,abalance,filler) "
+				 "select aid, (aid - 1) / %d + 1, 0, '' "
+				 "from generate_series(" INT64_FORMAT ", " INT64_FORMAT ") as aid",
+				 naccounts, range->start + 1, range->end);
+		executeStatement(con, sql);
+		range->done = range->end - range->start;
+		return;
+	}
 
-	/*
-	 * accounts is big enough to be worth using COPY and tracking runtime
-	 */
 	res = PQexec(con, "copy pgbench_accounts from stdin");
 	if (PQresultStatus(res) != PGRES_COPY_IN)
 	{
@@ -3759,7 +4140,7 @@ initGenerateData(PGconn *con)
 
 	INSTR_TIME_SET_CURRENT(start);
 
-	for (k = 0; k < (int64) naccounts * scale; k++)
+	for (k = range->start; k < range->end; k++)
 	{
 		int64		j = k + 1;
 
@@ -3772,45 +4153,15 @@ initGenerateData(PGconn *con)
 			fprintf(stderr, "PQputline failed\n");
 			exit(1);
 		}
+		range->done = j - range->start;
 
 		/*
 		 * If we want to stick with the original logging, print a message each
-		 * 100k inserted rows.
+		 * 100k inserted rows.  In quiet mode, check the clock every 100 rows.
 		 */
-		if ((!use_quiet) && (j % 100000 == 0))
-		{
-			INSTR_TIME_SET_CURRENT(diff);
-			INSTR_TIME_SUBTRACT(diff, start);
-
-			elapsed_sec = INSTR_TIME_GET_DOUBLE(diff);
-			remaining_sec = ((double) scale * naccounts - j) * elapsed_sec / j;
-
-			fprintf(stderr, INT64_FORMAT " of " INT64_FORMAT " tuples (%d%%) done (elapsed %.2f s, remaining %.2f s)\n",
-					j, (int64) naccounts * scale,
-					(int) (((int64) j * 100) / (naccounts * (int64) scale)),
-					elapsed_sec, remaining_sec);
-		}
-		/* let's not call the timing for each row, but only each 100 rows */
-		else if (use_quiet && (j % 100 == 0))
-		{
-			INSTR_TIME_SET_CURRENT(diff);
-			INSTR_TIME_SUBTRACT(diff, start);
-
-			elapsed_sec = INSTR_TIME_GET_DOUBLE(diff);
-			remaining_sec = ((double) scale * naccounts - j) * elapsed_sec / j;
-
-			/* have we reached the next interval (or end)? */
-			if ((j == scale * naccounts) || (elapsed_sec >= log_interval * LOG_STEP_SECONDS))
-			{
-				fprintf(stderr, INT64_FORMAT " of " INT64_FORMAT " tuples (%d%%) done (elapsed %.2f s, remaining %.2f s)\n",
-						j, (int64) naccounts * scale,
-						(int) (((int64) j * 100) / (naccounts * (int64) scale)), elapsed_sec, remaining_sec);
-
-				/* skip to the next interval */
-				log_interval = (int) ceil(elapsed_sec / LOG_STEP_SECONDS);
-			}
-		}
-
+		if (range->is_reporter &&
+			range->done % (use_quiet ? 100 : 100000) == 0)
+			reportAccountsProgress(start, &log_interval, j == range->end);
 	}
 	if (PQputline(con, "\\.\n"))
 	{
@@ -3822,8 +4173,108 @@ initGenerateData(PGconn *con)
 		fprintf(stderr, "PQendcopy failed\n");
 		exit(1);
 	}
+}
+
+/* thread entry point for parallel initialization */
+static void *
+initAccountsThread(void *arg)
+{
+	InitRange  *range = (InitRange *) arg;
+
+	if ((range->con = doConnect()) == NULL)
+		exit(1);
+	initGenerateAccounts(range);
+	PQfinish(range->con);
+	return NULL;
+}
+
+/*
+ * Fill the standard tables with some data
+ *
+ * With a single job, we do all of this in one transaction to enable the
+ * backend's data-loading optimizations.  With several jobs, the old data
+ * is truncated and the small tables filled first, then pgbench_accounts
+ * is split into equal ranges of aid, each loaded by its own thread and
+ * connection.
+ */
+static void
+initGenerateData(PGconn *con, bool server_side)
+{
+	int64		total = (int64) naccounts * scale;
+	int			nranges;
+	int			i;
+
+	fprintf(stderr, "generating data (%s)...\n",
+			server_side ? "server-side" : "client-side");
+
+	/* no point in having more ranges than scale units */
+	nranges = Max(1, Min(nthreads, scale));
+
+	initRanges = (InitRange *) pg_malloc0(sizeof(InitRange) * nranges);
+	nInitRanges = nranges;
+	for (i = 0; i < nranges; i++)
+	{
+		/* split on scale boundaries, so ranges are whole branches */
+		initRanges[i].start = naccounts * ((int64) scale * i / nranges);
+		initRanges[i].end = naccounts * ((int64) scale * (i + 1) / nranges);
+		initRanges[i].server_side = server_side;
+		initRanges[i].is_reporter = (i == 0);
+		initRanges[i].thread = INVALID_THREAD;
+	}
+	Assert(initRanges[nranges - 1].end == total);
+
+	executeStatement(con, "begin");
+	initTruncateTables(con);
+
+	/*
+	 * fill branches, tellers, accounts in that order in case foreign keys
+	 * already exist
+	 */
+	initGenerateBranchesTellers(con, server_side);
+
+	if (nranges == 1)
+	{
+		initRanges[0].con = con;
+		initGenerateAccounts(&initRanges[0]);
+		executeStatement(con, "commit");
+	}
+	else
+	{
+		/* other connections must see the truncation and the small tables */
+		executeStatement(con, "commit");
+
+#ifdef ENABLE_THREAD_SAFETY
+		/* the first range is loaded by the main thread */
+		for (i = 1; i < nranges; i++)
+		{
+			InitRange  *range = &initRanges[i];
+			int			err = pthread_create(&range->thread, NULL,
+											 initAccountsThread, range);
+
+			if (err != 0 || range->thread == INVALID_THREAD)
+			{
+				fprintf(stderr, "could not create thread: %s\n", strerror(err));
+				exit(1);
+			}
+		}
+#endif							/* ENABLE_THREAD_SAFETY */
+
+		initRanges[0].con = con;
+		initGenerateAccounts(&initRanges[0]);
 
-	executeStatement(con, "commit");
+		for (i = 1; i < nranges; i++)
+		{
+#ifdef ENABLE_THREAD_SAFETY
+			pthread_join(initRanges[i].thread, NULL);
+#else
+			(void) initAccountsThread(&initRanges[i]);
+#endif							/* ENABLE_THREAD_SAFETY */
+		}
+	}
+
+	pg_free(initRanges);
+	initRanges = NULL;
+	nInitRanges = 0;
 }
 
 /*
@@ -3916,11 +4367,11 @@ checkInitSteps(const char *initialize_steps)
 
 	for (step = initialize_steps; *step != '\0'; step++)
 	{
-		if (strchr("dtgvpf ", *step) == NULL)
+		if (strchr("dtgGvpf ", *step) == NULL)
 		{
 			fprintf(stderr, "unrecognized initialization step \"%c\"\n",
 					*step);
-			fprintf(stderr, "allowed steps are: \"d\", \"t\", \"g\", \"v\", \"p\", \"f\"\n");
+			fprintf(stderr, "allowed steps are: \"d\", \"t\", \"g\", \"G\", \"v\", \"p\", \"f\"\n");
 			exit(1);
 		}
 	}
@@ -3949,7 +4400,10 @@ runInitSteps(const char *initialize_steps)
 				initCreateTables(con);
 				break;
 			case 'g':
-				initGenerateData(con);
+				initGenerateData(con, false);
+				break;
+			case 'G':
+				initGenerateData(con, true);
 				break;
 			case 'v':
 				initVacuum(con);
@@ -4685,6 +5139,63 @@ printSimpleStats(const char *prefix, SimpleStats *ss)
 	}
 }
 
+/* print the requested latency percentiles */
+static void
+printPercentiles(const char *prefix, StatsData *sd)
+{
+	int			i;
+
+	for (i = 0; i < npercentiles; i++)
+	{
+		double		val = histogramPercentile(&sd->latency_hist, NULL,
+											  percentiles[i]);
+
+		/* the bucket's upper end can't be above the largest value seen */
+		if (val < 0)
+			continue;
+		if (val > sd->latency.max)
+			val = sd->latency.max;
+		printf("%s p%g = %.3f ms\n", prefix, percentiles[i], 0.001 * val);
+	}
+}
+
+/*
+ * Write the non-empty buckets of the latency histogram to histogram_file,
+ * one per line: lower bound and upper bound in microseconds, and count.
+ */
+static void
+writeHistogram(StatsData *sd)
+{
+	FILE	   *fp;
+	int			i;
+
+	if ((fp = fopen(histogram_file, "w")) == NULL)
+	{
+		fprintf(stderr, "could not open histogram file \"%s\": %s\n",
+				histogram_file, strerror(errno));
+		exit(1);
+	}
+
+	for (i = 0; i < LHIST_NBUCKETS; i++)
+	{
+		int64		lo,
+					hi;
+
+		if (sd->latency_hist.counts[i] == 0)
+			continue;
+		latencyBucketRange(i, &lo, &hi);
+		fprintf(fp, INT64_FORMAT " " INT64_FORMAT " " INT64_FORMAT "\n",
+				lo, hi, sd->latency_hist.counts[i]);
+	}
+
+	if (fclose(fp) != 0)
+	{
+		fprintf(stderr, "could not write histogram file \"%s\": %s\n",
+				histogram_file, strerror(errno));
+		exit(1);
+	}
+}
+
 /* print out results */
 static void
 printResults(TState *threads, StatsData *total, instr_time total_time,
@@ -4708,6 +5219,9 @@ printResults(TState *threads, StatsData *total, instr_time total_time,
 	printf("transaction type: %s\n",
 		   num_scripts == 1 ? sql_script[0].desc : "multiple scripts");
 	printf("scaling factor: %d\n", scale);
+	if (partition_method != PART_NONE)
+		printf("partition method: %s\npartitions: %d\n",
+			   PARTITION_METHOD[partition_method], partitions);
 	printf("query mode: %s\n", QUERYMODE[querymode]);
 	printf("number of clients: %d\n", nclients);
 	printf("number of threads: %d\n", nthreads);
@@ -4747,8 +5261,11 @@ printResults(TState *threads, StatsData *total, instr_time total_time,
 			   latency_limit / 1000.0, latency_late, ntx,
 			   (ntx > 0) ? 100.0 * latency_late / ntx : 0.0);
 
-	if (throttle_delay || progress || latency_limit)
+	if (throttle_delay || progress || latency_limit || collect_histogram)
+	{
 		printSimpleStats("latency", &total->latency);
+		printPercentiles("latency", total);
+	}
 	else
 	{
 		/* no measurement, show average latency computed from run time */
@@ -4798,6 +5315,7 @@ printResults(TState *threads, StatsData *total, instr_time total_time,
 						   100.0 * sstats->skipped / sstats->cnt);
 
 				printSimpleStats(" - latency", &sstats->latency);
+				printPercentiles(" - latency", sstats);
 			}
 
 			/* Report per-command latencies */
@@ -4914,6 +5432,11 @@ main(int argc, char **argv)
 		{"log-prefix", required_argument, NULL, 7},
 		{"foreign-keys", no_argument, NULL, 8},
 		{"random-seed", required_argument, NULL, 9},
+		{"pipeline", no_argument, NULL, 10},
+		{"latency-percentiles", required_argument, NULL, 11},
+		{"latency-histogram", required_argument, NULL, 12},
+		{"partitions", required_argument, NULL, 13},
+		{"partition-method", required_argument, NULL, 14},
 		{NULL, 0, NULL, 0}
 	};
 
@@ -5052,7 +5575,6 @@ main(int argc, char **argv)
 #endif							/* HAVE_GETRLIMIT */
 				break;
 			case 'j':			/* jobs */
-				benchmarking_option_set = true;
 				nthreads = atoi(optarg);
 				if (nthreads <= 0)
 				{
@@ -5271,6 +5793,65 @@ main(int argc, char **argv)
 					exit(1);
 				}
 				break;
+			case 10:			/* pipeline */
+				benchmarking_option_set = true;
+				pipeline = true;
+				break;
+			case 11:			/* latency-percentiles */
+				{
+					char	   *p = optarg;
+
+					benchmarking_option_set = true;
+					collect_histogram = true;
+					npercentiles = 0;
+					for (;;)
+					{
+						char	   *endptr;
+						double		pct = strtod(p, &endptr);
+
+						if (endptr == p || pct <= 0 || pct > 100 ||
+							(*endptr != ',' && *endptr != '\0') ||
+							npercentiles >= MAX_PERCENTILES)
+						{
+							fprintf(stderr, "invalid list of latency percentiles: \"%s\"\n",
+									optarg);
+							exit(1);
+						}
+						percentiles[npercentiles++] = pct;
+						if (*endptr == '\0')
+							break;
+						p = endptr + 1;
+					}
+				}
+				break;
+			case 12:			/* latency-histogram */
+				benchmarking_option_set = true;
+				collect_histogram = true;
+				histogram_file = pg_strdup(optarg);
+				break;
+			case 13:			/* partitions */
+				initialization_option_set = true;
+				partitions = atoi(optarg);
+				if (partitions < 0)
+				{
+					fprintf(stderr, "invalid number of partitions: \"%s\"\n",
+							optarg);
+					exit(1);
+				}
+				break;
+			case 14:			/* partition-method */
+				initialization_option_set = true;
+				if (pg_strcasecmp(optarg, "range") == 0)
+					partition_method = PART_RANGE;
+				else if (pg_strcasecmp(optarg, "hash") == 0)
+					partition_method = PART_HASH;
+				else
+				{
+					fprintf(stderr, "invalid partition method, expecting \"range\" or \"hash\", got: \"%s\"\n",
+							optarg);
+					exit(1);
+				}
+				break;
 			default:
 				fprintf(stderr, _("Try \"%s --help\" for more information.\n"), progname);
 				exit(1);
@@ -5357,6 +5938,16 @@ main(int argc, char **argv)
 		if (initialize_steps == NULL)
 			initialize_steps = pg_strdup(DEFAULT_INIT_STEPS);
 
+		if (partitions == 0 && partition_method != PART_NONE)
+		{
+			fprintf(stderr, "--partition-method requires greater than zero --partitions\n");
+			exit(1);
+		}
+
+		/* range partitioning is the default */
+		if (partitions > 0 && partition_method == PART_NONE)
+			partition_method = PART_RANGE;
+
 		if (is_no_vacuum)
 		{
 			/* Remove any vacuum step in initialize_steps */
@@ -5444,6 +6035,12 @@ main(int argc, char **argv)
 		exit(1);
 	}
 
+	if (pipeline && querymode == QUERY_SIMPLE)
+	{
+		fprintf(stderr, "--pipeline requires --protocol=extended or --protocol=prepared\n");
+		exit(1);
+	}
+
 	/*
 	 * save main process id in the global variable because process id will be
 	 * changed after fork.
@@ -5543,6 +6140,31 @@ main(int argc, char **argv)
 			fprintf(stderr,
 					"scale option ignored, using count from pgbench_branches table (%d)\n",
 					scale);
+
+		/* find out whether pgbench_accounts is partitioned, for the report */
+		if (PQserverVersion(con) >= 100000)
+		{
+			res = PQexec(con,
+						 "select p.partstrat, count(i.inhrelid) "
+						 "from pg_catalog.pg_partitioned_table p "
+						 "left join pg_catalog.pg_inherits i on i.inhparent = p.partrelid "
+						 "where p.partrelid = 'pgbench_accounts'::pg_catalog.regclass "
+						 "group by p.partstrat");
+			if (PQresultStatus(res) != PGRES_TUPLES_OK)
+			{
+				fprintf(stderr, "%s", PQerrorMessage(con));
+				exit(1);
+			}
+			if (PQntuples(res) == 1)
+			{
+				const char *strat = PQgetvalue(res, 0, 0);
+
+				partition_method = (strcmp(strat, "h") == 0) ? PART_HASH :
+					(strcmp(strat, "r") == 0) ? PART_RANGE : PART_NONE;
+				partitions = atoi(PQgetvalue(res, 0, 1));
+			}
+			PQclear(res);
+		}
 	}
 
 	/*
@@ -5705,6 +6327,8 @@ main(int argc, char **argv)
 		/* aggregate thread level stats */
 		mergeSimpleStats(&stats.latency, &thread->stats.latency);
 		mergeSimpleStats(&stats.lag, &thread->stats.lag);
+		if (collect_histogram)
+			mergeHistogram(&stats.latency_hist, &thread->stats.latency_hist);
 		stats.cnt += thread->stats.cnt;
 		stats.skipped += thread->stats.skipped;
 		latency_late += thread->latency_late;
@@ -5726,6 +6350,9 @@ main(int argc, char **argv)
 	INSTR_TIME_SUBTRACT(total_time, start_time);
 	printResults(threads, &stats, total_time, conn_total_time, latency_late);
 
+	if (histogram_file)
+		writeHistogram(&stats);
+
 	if (exit_code != 0)
 		fprintf(stderr, "Run was aborted; the above results are incomplete.\n");
 
@@ -5793,6 +6420,12 @@ threadRun(void *arg)
 		{
 			if ((state[i].con = doConnect()) == NULL)
 				goto done;
+			if (pipeline && !PQenterPipelineMode(state[i].con))
+			{
+				fprintf(stderr, "client %d could not enter pipeline mode: %s",
+						state[i].id, PQerrorMessage(state[i].con));
+				goto done;
+			}
 		}
 	}
 
@@ -5844,7 +6477,8 @@ threadRun(void *arg)
 				if (min_usec > this_usec)
 					min_usec = this_usec;
 			}
-			else if (st->state == CSTATE_WAIT_RESULT)
+			else if (st->state == CSTATE_WAIT_RESULT ||
+					 st->state == CSTATE_WAIT_PIPELINE)
 			{
 				/*
 				 * waiting for result from server - nothing to do unless the
@@ -5941,7 +6575,8 @@ threadRun(void *arg)
 		{
 			CState	   *st = &state[i];
 
-			if (st->state == CSTATE_WAIT_RESULT)
+			if (st->state == CSTATE_WAIT_RESULT ||
+				st->state == CSTATE_WAIT_PIPELINE)
 			{
 				/* don't call advanceConnectionState unless data is available */
 				int			sock = PQsocket(st->con);
@@ -6011,6 +6646,9 @@ threadRun(void *arg)
 				{
 					mergeSimpleStats(&cur.latency, &thread[i].stats.latency);
 					mergeSimpleStats(&cur.lag, &thread[i].stats.lag);
+					if (collect_histogram)
+						mergeHistogram(&cur.latency_hist,
+									   &thread[i].stats.latency_hist);
 					cur.cnt += thread[i].stats.cnt;
 					cur.skipped += thread[i].stats.skipped;
 				}
@@ -6055,6 +6693,18 @@ threadRun(void *arg)
 						"progress: %s, %.1f tps, lat %.3f ms stddev %.3f",
 						tbuf, tps, latency, stdev);
 
+				/* percentiles over this interval only */
+				for (i = 0; i < npercentiles; i++)
+				{
+					double		val = histogramPercentile(&cur.latency_hist,
+														  &last.latency_hist,
+														  percentiles[i]);
+
+					if (val >= 0)
+						fprintf(stderr, ", p%g %.3f", percentiles[i],
+								0.001 * val);
+				}
+
 				if (throttle_delay)
 				{
 					fprintf(stderr, ", lag %.3f ms", lag);
@@ -110,6 +110,49 @@ pgbench(
 	],
 	'pgbench scale 1 initialization');
 
+# Server-side and parallel data generation
+pgbench(
+	'--initialize --init-steps=dtGp --scale=2 --jobs=2',
+	0,
+	[qr{^$}],
+	[
+		qr{creating tables},
+		qr{generating data \(server-side\)},
+		qr{creating primary keys},
+		qr{done\.}
+	],
+	'pgbench server-side parallel initialization');
+
+pgbench(
+	'--initialize --init-steps=dtgp --scale=2 --jobs=2',
+	0,
+	[qr{^$}],
+	[
+		qr{generating data \(client-side\)},
+		qr{.* of .* tuples \(.*\) done},
+		qr{done\.}
+	],
+	'pgbench client-side parallel initialization');
+
+# Partitioned pgbench_accounts
+pgbench(
+	'--initialize --scale=1 --partitions=3 --partition-method=hash',
+	0,
+	[qr{^$}],
+	[ qr{creating 3 partitions}, qr{done\.} ],
+	'pgbench hash partitioned initialization');
+
+pgbench(
+	'-n -t 10 -b simple-update',
+	0,
+	[
+		qr{partition method: hash},
+		qr{partitions: 3},
+		qr{processed: 10/10}
+	],
+	[qr{^$}],
+	'pgbench on partitioned accounts');
+
 # Test interaction of --init-steps with legacy step-selection options
 pgbench(
 	'--initialize --init-steps=dtpvgvv --no-vacuum --foreign-keys --unlogged-tables',
@@ -857,6 +900,26 @@ pgbench(
 check_pgbench_logs("$bdir/001_pgbench_log_3", 1, 10, 10,
 	qr{^\d \d{1,2} \d+ \d \d+ \d+$});
 
+# latency percentiles and histogram
+pgbench(
+	"-n -S -t 20 -c 2 --latency-percentiles=50,99.9 --latency-histogram=$bdir/001_pgbench_hist",
+	0,
+	[
+		qr{processed: 40/40},
+		qr{latency p50 = \d+\.\d{3} ms},
+		qr{latency p99\.9 = \d+\.\d{3} ms}
+	],
+	[qr{^$}],
+	'pgbench latency percentiles');
+
+{
+	my $contents = slurp_file("$bdir/001_pgbench_hist");
+	my $total = 0;
+	$total += $1 while $contents =~ /^\d+ \d+ (\d+)$/mg;
+	is($total, 40, "histogram file counts all transactions");
+	ok(unlink("$bdir/001_pgbench_hist"), "remove histogram file");
+}
+
 # done
 $node->stop;
 done_testing();
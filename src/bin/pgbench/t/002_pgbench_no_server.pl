@@ -94,6 +94,21 @@ my @options = (
 		'bad #threads', '-j eleven', [qr{invalid number of threads: "eleven"}]
 	],
 	[ 'bad scale', '-i -s two', [qr{invalid scaling factor: "two"}] ],
+	[
+		'bad partition method',
+		'-i --partitions=2 --partition-method=list',
+		[qr{invalid partition method}]
+	],
+	[
+		'partition method without partitions',
+		'-i --partition-method=hash',
+		[qr{--partition-method requires greater than zero --partitions}]
+	],
+	[
+		'bad latency percentiles',
+		'--latency-percentiles=50,101',
+		[qr{invalid list of latency percentiles: "50,101"}]
+	],
 	[
 		'invalid #transactions',
 		'-t zil',
@@ -0,0 +1,200 @@
+/*-------------------------------------------------------------------------
+ *
+ * replcompress.c
+ *	  Compression of WAL streamed over the replication protocol
+ *
+ * A walsender asked to compress the WAL it streams compresses the data of
+ * each XLogData message on its own, and sends it in a compressed XLogData
+ * message instead if that makes it smaller.  These are the routines shared
+ * by the walsender and the clients: walreceiver, pg_receivewal and
+ * pg_basebackup.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/common/replcompress.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef FRONTEND
+#include "postgres.h"
+#else
+#include "postgres_fe.h"
+#endif
+
+#ifdef USE_LZ4
+#include <lz4.h>
+#endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "common/replcompress.h"
+
+/*
+ * Look up a compression method by name.  Returns false if there's no such
+ * method; it may still not be supported by this build, see
+ * repl_compression_supported().
+ */
+bool
+repl_compression_parse(const char *name, ReplCompressionMethod *method)
+{
+	if (pg_strcasecmp(name, "none") == 0 || pg_strcasecmp(name, "off") == 0)
+		*method = REPL_COMPRESSION_NONE;
+	else if (pg_strcasecmp(name, "pglz") == 0)
+		*method = REPL_COMPRESSION_PGLZ;
+	else if (pg_strcasecmp(name, "lz4") == 0)
+		*method = REPL_COMPRESSION_LZ4;
+	else if (pg_strcasecmp(name, "zstd") == 0)
+		*method = REPL_COMPRESSION_ZSTD;
+	else
+		return false;
+
+	return true;
+}
+
+/*
+ * Name of a compression method, as accepted by repl_compression_parse().
+ */
+const char *
+repl_compression_name(ReplCompressionMethod method)
+{
+	switch (method)
+	{
+		case REPL_COMPRESSION_NONE:
+			return "none";
+		case REPL_COMPRESSION_PGLZ:
+			return "pglz";
+		case REPL_COMPRESSION_LZ4:
+			return "lz4";
+		case REPL_COMPRESSION_ZSTD:
+			return "zstd";
+	}
+
+	return "???";				/* keep compiler quiet */
+}
+
+/*
+ * Was this build compiled with support for the method?
+ */
+bool
+repl_compression_supported(ReplCompressionMethod method)
+{
+	switch (method)
+	{
+		case REPL_COMPRESSION_NONE:
+		case REPL_COMPRESSION_PGLZ:
+			return true;
+		case REPL_COMPRESSION_LZ4:
+#ifdef USE_LZ4
+			return true;
+#else
+			return false;
+#endif
+		case REPL_COMPRESSION_ZSTD:
+#ifdef USE_ZSTD
+			return true;
+#else
+			return false;
+#endif
+	}
+
+	return false;
+}
+
+/*
+ * Compress 'slen' bytes at 'source' into 'dest', which must have room for
+ * REPL_COMPRESS_BOUND(slen) bytes.
+ *
+ * Returns the compressed size, or -1 if the data didn't get any smaller, in
+ * which case the caller should send it uncompressed.
+ */
+int32
+repl_compress(ReplCompressionMethod method, const char *source, int32 slen,
+			  char *dest)
+{
+	int32		len = -1;
+
+	switch (method)
+	{
+		case REPL_COMPRESSION_NONE:
+			break;
+
+		case REPL_COMPRESSION_PGLZ:
+			len = pglz_compress(source, slen, dest, PGLZ_strategy_default);
+			break;
+
+		case REPL_COMPRESSION_LZ4:
+#ifdef USE_LZ4
+			len = LZ4_compress_default(source, dest, slen, slen - 1);
+			if (len <= 0)
+				len = -1;		/* didn't fit */
+#endif
+			break;
+
+		case REPL_COMPRESSION_ZSTD:
+#ifdef USE_ZSTD
+			{
+				size_t		zlen;
+
+				zlen = ZSTD_compress(dest, slen - 1, source, slen, 1);
+				len = ZSTD_isError(zlen) ? -1 : (int32) zlen;
+			}
+#endif
+			break;
+	}
+
+	if (len >= slen)
+		len = -1;
+
+	return len;
+}
+
+/*
+ * Decompress 'slen' bytes at 'source', which are known to decompress to
+ * 'rawsize' bytes, into 'dest'.
+ *
+ * Returns 'rawsize', or -1 if the data is corrupt or the method isn't
+ * supported by this build.
+ */
+int32
+repl_decompress(ReplCompressionMethod method, const char *source, int32 slen,
+				char *dest, int32 rawsize)
+{
+	int32		len = -1;
+
+	switch (method)
+	{
+		case REPL_COMPRESSION_NONE:
+			break;
+
+		case REPL_COMPRESSION_PGLZ:
+			len = pglz_decompress(source, slen, dest, rawsize);
+			break;
+
+		case REPL_COMPRESSION_LZ4:
+#ifdef USE_LZ4
+			len = LZ4_decompress_safe(source, dest, slen, rawsize);
+#endif
+			break;
+
+		case REPL_COMPRESSION_ZSTD:
+#ifdef USE_ZSTD
+			{
+				size_t		zlen;
+
+				zlen = ZSTD_decompress(dest, rawsize, source, slen);
+				len = ZSTD_isError(zlen) ? -1 : (int32) zlen;
+			}
+#endif
+			break;
+	}
+
+	if (len != rawsize)
+		return -1;
+
+	return rawsize;
+}
@@ -194,6 +194,10 @@ typedef struct IndexAmRoutine
 	bool		amcanparallel;
 	/* does AM support columns included with clause INCLUDE? */
 	bool		amcaninclude;
+	/* can AM skip over distinct values of an unconstrained first column? */
+	bool		amcanskip;
+	/* does AM support parallel index builds? */
+	bool		amcanbuildparallel;
 	/* type of data stored in index, or InvalidOid if variable */
 	Oid			amkeytype;
 
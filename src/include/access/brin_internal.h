@@ -13,6 +13,7 @@
 
 #include "access/amapi.h"
 #include "storage/bufpage.h"
+#include "storage/shm_toc.h"
 #include "utils/typcache.h"
 
 
@@ -87,6 +88,7 @@ extern void brin_free_desc(BrinDesc *bdesc);
 extern IndexBuildResult *brinbuild(Relation heap, Relation index,
 		  struct IndexInfo *indexInfo);
 extern void brinbuildempty(Relation index);
+extern void _brin_parallel_build_main(dsm_segment *seg, shm_toc *toc);
 extern bool brininsert(Relation idxRel, Datum *values, bool *nulls,
 		   ItemPointer heaptid, Relation heapRel,
 		   IndexUniqueCheck checkUnique,
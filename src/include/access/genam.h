@@ -157,6 +157,9 @@ extern void index_parallelrescan(IndexScanDesc scan);
 extern IndexScanDesc index_beginscan_parallel(Relation heaprel,
 						 Relation indexrel, int nkeys, int norderbys,
 						 ParallelIndexScanDesc pscan);
+extern IndexScanDesc index_beginscan_bitmap_parallel(Relation indexrel,
+								int nkeys, ParallelIndexScanDesc pscan);
+extern void index_set_prefetch(IndexScanDesc scan, int maximum);
 extern ItemPointer index_getnext_tid(IndexScanDesc scan,
 				  ScanDirection direction);
 extern HeapTuple index_fetch_heap(IndexScanDesc scan);
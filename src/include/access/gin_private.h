@@ -16,6 +16,7 @@
 #include "access/itup.h"
 #include "fmgr.h"
 #include "storage/bufmgr.h"
+#include "storage/shm_toc.h"
 #include "lib/rbtree.h"
 
 /*
@@ -38,6 +39,13 @@ typedef struct GinOptions
 	 ((GinOptions *) (relation)->rd_options)->pendingListCleanupSize : \
 	 gin_pending_list_limit)
 
+/*
+ * Pending list cleanup is normally left to autovacuum.  Once the list grows
+ * to this many times its cleanup size, inserting backends clean it up
+ * themselves; autovacuum evidently isn't keeping up.
+ */
+#define GIN_PENDING_LIST_BACKPRESSURE	4
+
 
 /* Macros for buffer lock/unlock operations */
 #define GIN_UNLOCK	BUFFER_LOCK_UNLOCK
@@ -116,6 +124,7 @@ extern void ginEntryInsert(GinState *ginstate,
 			   OffsetNumber attnum, Datum key, GinNullCategory category,
 			   ItemPointerData *items, uint32 nitem,
 			   GinStatsData *buildStats);
+extern void _gin_parallel_build_main(dsm_segment *seg, shm_toc *toc);
 
 /* ginbtree.c */
 
@@ -338,6 +347,11 @@ typedef struct GinScanEntryData
 	int			nlist;
 	OffsetNumber offset;
 
+	/* compressed segments of the posting tree page not yet decoded */
+	char	   *segbuf;			/* copy of the page's segments, or NULL */
+	GinPostingList *nextseg;	/* next segment to decode, or NULL */
+	char	   *segend;			/* end of segbuf */
+
 	bool		isFinished;
 	bool		reduceResult;
 	uint32		predictNumberResult;
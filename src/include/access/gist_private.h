@@ -21,6 +21,8 @@
 #include "lib/pairingheap.h"
 #include "storage/bufmgr.h"
 #include "storage/buffile.h"
+#include "storage/condition_variable.h"
+#include "storage/spin.h"
 #include "utils/hsearch.h"
 #include "access/genam.h"
 
@@ -176,6 +178,37 @@ typedef struct GISTScanOpaqueData
 
 typedef GISTScanOpaqueData *GISTScanOpaque;
 
+/*
+ * GISTParallelScanDescData: shared state of a parallel GiST scan.
+ *
+ * The first participant to start the scan reads the root page and publishes
+ * the downlinks that satisfy the scan keys.  Each participant then claims one
+ * such subtree at a time and searches it with its own queue.  If the root is
+ * a leaf, the participant that read it returns its matches and the others
+ * find nothing to claim.  Ordered (KNN) scans can't be divided this way, so
+ * the planner doesn't generate parallel paths for them.
+ */
+typedef enum
+{
+	GISTPARALLEL_NOT_STARTED,
+	GISTPARALLEL_READING_ROOT,
+	GISTPARALLEL_ROOT_DONE
+} GISTPS_State;
+
+typedef struct GISTParallelScanDescData
+{
+	GISTPS_State gps_state;		/* see above */
+	GistNSN		gps_rootlsn;	/* LSN of root page when it was read */
+	int			gps_nsubtrees;	/* number of valid entries in gps_subtrees */
+	int			gps_nextsubtree;	/* next entry of gps_subtrees to claim */
+	slock_t		gps_mutex;		/* protects above variables */
+	ConditionVariable gps_cv;	/* signaled once the root has been read */
+	BlockNumber gps_subtrees[MaxIndexTuplesPerPage];	/* matching children of
+														 * the root */
+} GISTParallelScanDescData;
+
+typedef GISTParallelScanDescData *GISTParallelScanDesc;
+
 /* despite the name, gistxlogPage is not part of any xlog record */
 typedef struct gistxlogPage
 {
@@ -465,12 +498,16 @@ extern IndexTuple gistgetadjusted(Relation r,
 				GISTSTATE *giststate);
 extern IndexTuple gistFormTuple(GISTSTATE *giststate,
 			  Relation r, Datum *attdata, bool *isnull, bool isleaf);
+extern void gistCompressValues(GISTSTATE *giststate, Relation r,
+				   Datum *attdata, bool *isnull, bool isleaf,
+				   Datum *compatt);
 
 extern OffsetNumber gistchoose(Relation r, Page p,
 		   IndexTuple it,
 		   GISTSTATE *giststate);
 
 extern void GISTInitBuffer(Buffer b, uint32 f);
+extern void gistinitpage(Page page, uint32 f);
 extern void gistdentryinit(GISTSTATE *giststate, int nkey, GISTENTRY *e,
 			   Datum k, Relation r, Page pg, OffsetNumber o,
 			   bool l, bool isNull);
@@ -206,20 +206,74 @@ typedef struct BTMetaPageData
  * bit is set (we never assume that pivot tuples must explicitly store the
  * number of attributes, and currently do not bother storing the number of
  * attributes unless indnkeyatts actually differs from indnatts).
- * INDEX_ALT_TID_MASK is only used for pivot tuples at present, though it's
- * possible that it will be used within non-pivot tuples in the future.  Do
- * not assume that a tuple with INDEX_ALT_TID_MASK set must be a pivot
+ * INDEX_ALT_TID_MASK is also used by posting list tuples, which are leaf
+ * tuples that stand for several heap tuples with the same key (see below).
+ * Do not assume that a tuple with INDEX_ALT_TID_MASK set must be a pivot
  * tuple.
  *
  * The 12 least significant offset bits are used to represent the number of
- * attributes in INDEX_ALT_TID_MASK tuples, leaving 4 bits that are reserved
- * for future use (BT_RESERVED_OFFSET_MASK bits). BT_N_KEYS_OFFSET_MASK should
- * be large enough to store any number <= INDEX_MAX_KEYS.
+ * attributes in INDEX_ALT_TID_MASK pivot tuples, leaving 4 bits that are
+ * reserved for future use (BT_RESERVED_OFFSET_MASK bits), except for the
+ * BT_IS_POSTING bit. BT_N_KEYS_OFFSET_MASK should be large enough to store
+ * any number <= INDEX_MAX_KEYS.
  */
 #define INDEX_ALT_TID_MASK			INDEX_AM_RESERVED_BIT
-#define BT_RESERVED_OFFSET_MASK		0xF000
+#define BT_RESERVED_OFFSET_MASK		0xD000
+#define BT_IS_POSTING				0x2000
 #define BT_N_KEYS_OFFSET_MASK		0x0FFF
 
+/*
+ * Posting list tuples.  When a leaf page would otherwise have to be split,
+ * runs of leaf tuples with equal keys may be merged into a single posting
+ * list tuple: the key, followed by the heap TIDs of all the merged tuples
+ * in ascending order (see nbtdedup.c).  Posting list tuples have both
+ * INDEX_ALT_TID_MASK and the BT_IS_POSTING offset bit set.  The other 12
+ * offset bits hold the number of heap TIDs rather than the number of
+ * attributes, which is always the full number of attributes, and the block
+ * number holds the byte offset of the posting list within the tuple.
+ * Pivot tuples are never posting list tuples.
+ */
+#define BTreeTupleIsPosting(itup) \
+	(((itup)->t_info & INDEX_ALT_TID_MASK) != 0 && \
+	 (ItemPointerGetOffsetNumberNoCheck(&(itup)->t_tid) & BT_IS_POSTING) != 0)
+#define BTreeTupleGetNPosting(itup) \
+	( \
+		AssertMacro(BTreeTupleIsPosting(itup)), \
+		ItemPointerGetOffsetNumberNoCheck(&(itup)->t_tid) & BT_N_KEYS_OFFSET_MASK \
+	)
+#define BTreeTupleGetPostingOffset(itup) \
+	ItemPointerGetBlockNumberNoCheck(&(itup)->t_tid)
+#define BTreeTupleGetPosting(itup) \
+	((ItemPointer) ((char *) (itup) + BTreeTupleGetPostingOffset(itup)))
+#define BTreeTupleGetPostingN(itup, n) \
+	(BTreeTupleGetPosting(itup) + (n))
+#define BTreeTupleSetPosting(itup, nhtids, off) \
+	do { \
+		(itup)->t_info |= INDEX_ALT_TID_MASK; \
+		Assert(((nhtids) & ~BT_N_KEYS_OFFSET_MASK) == 0); \
+		ItemPointerSetOffsetNumber(&(itup)->t_tid, (nhtids) | BT_IS_POSTING); \
+		ItemPointerSetBlockNumber(&(itup)->t_tid, (off)); \
+	} while(0)
+
+/*
+ * Upper bound on the number of heap TIDs on a leaf page, for the arrays
+ * used to return the matches on one page to a scan.  Posting lists allow
+ * more of them than MaxIndexTuplesPerPage.
+ */
+#define MaxTIDsPerBTreePage \
+	((int) ((BLCKSZ - SizeOfPageHeaderData - sizeof(BTPageOpaqueData)) / \
+			sizeof(ItemPointerData)))
+
+/*
+ * A run of consecutive items on a leaf page that deduplication merges into
+ * a single posting list tuple.
+ */
+typedef struct BTDedupInterval
+{
+	OffsetNumber baseoff;		/* offset of the first item */
+	uint16		nitems;			/* number of items merged */
+} BTDedupInterval;
+
 /* Get/set downlink block number */
 #define BTreeInnerTupleGetDownLink(itup) \
 	ItemPointerGetBlockNumberNoCheck(&((itup)->t_tid))
@@ -246,7 +300,7 @@ typedef struct BTMetaPageData
  */
 #define BTreeTupleGetNAtts(itup, rel)	\
 	( \
-		(itup)->t_info & INDEX_ALT_TID_MASK ? \
+		(itup)->t_info & INDEX_ALT_TID_MASK && !BTreeTupleIsPosting(itup) ? \
 		( \
 			AssertMacro((ItemPointerGetOffsetNumberNoCheck(&(itup)->t_tid) & BT_RESERVED_OFFSET_MASK) == 0), \
 			ItemPointerGetOffsetNumberNoCheck(&(itup)->t_tid) & BT_N_KEYS_OFFSET_MASK \
@@ -386,7 +440,7 @@ typedef struct BTScanPosData
 	int			lastItem;		/* last valid index in items[] */
 	int			itemIndex;		/* current index in items[] */
 
-	BTScanPosItem items[MaxIndexTuplesPerPage]; /* MUST BE LAST */
+	BTScanPosItem items[MaxTIDsPerBTreePage];	/* MUST BE LAST */
 } BTScanPosData;
 
 typedef BTScanPosData *BTScanPos;
@@ -449,14 +503,31 @@ typedef struct BTScanOpaqueData
 	BTArrayKeyInfo *arrayKeys;	/* info about each equality-type array key */
 	MemoryContext arrayContext; /* scan-lifespan context for array data */
 
+	/*
+	 * Workspace for skip scans, which have no keys on the first index column
+	 * and instead repeat the scan for each of its distinct values in turn;
+	 * see _bt_setup_skip_scan.  skipKeyData holds the key on the first
+	 * column, followed by a copy of the regular input keys.
+	 */
+	bool		skipScan;		/* is this a skip scan? */
+	bool		skipHaveValue;	/* skipValue and skipIsNull are valid */
+	bool		skipProbe;		/* looking for the next distinct value? */
+	bool		skipIsNull;		/* current value of the first column */
+	Datum		skipValue;
+	StrategyNumber skipProbeStrategy;	/* > or < when probing after a value */
+	ScanKey		skipKeyData;
+	FmgrInfo	skipProcs[BTMaxStrategyNumber]; /* operator procs of column 1 */
+	MemoryContext skipContext;	/* scan-lifespan context for skip data */
+
 	/* info about killed items if any (killedItems is NULL if never used) */
 	int		   *killedItems;	/* currPos.items indexes of killed items */
 	int			numKilled;		/* number of currently stored items */
 
 	/*
-	 * If we are doing an index-only scan, these are the tuple storage
-	 * workspaces for the currPos and markPos respectively.  Each is of size
-	 * BLCKSZ, so it can hold as much as a full page's worth of tuples.
+	 * If we are doing an index-only scan or a skip scan, these are the tuple
+	 * storage workspaces for the currPos and markPos respectively.  Each is
+	 * of size BLCKSZ, so it can hold as much as a full page's worth of
+	 * tuples.
 	 */
 	char	   *currTuples;		/* tuple storage for currPos */
 	char	   *markTuples;		/* tuple storage for markPos */
@@ -523,6 +594,18 @@ extern void _bt_parallel_release(IndexScanDesc scan, BlockNumber scan_page);
 extern void _bt_parallel_done(IndexScanDesc scan);
 extern void _bt_parallel_advance_array_keys(IndexScanDesc scan);
 
+/*
+ * prototypes for functions in nbtdedup.c
+ */
+extern bool _bt_dedup_is_possible(Relation rel);
+extern bool _bt_dedup_keys_equal(IndexTuple itup1, IndexTuple itup2);
+extern int	_bt_dedup_max_htids(IndexTuple base);
+extern IndexTuple _bt_form_posting(IndexTuple base, ItemPointer htids,
+				 int nhtids);
+extern bool _bt_dedup_one_page(Relation rel, Buffer buf);
+extern Page _bt_dedup_apply(Page page, BTDedupInterval *intervals,
+				int nintervals);
+
 /*
  * prototypes for functions in nbtinsert.c
  */
@@ -552,7 +635,8 @@ extern void _bt_delitems_delete(Relation rel, Buffer buf,
 					OffsetNumber *itemnos, int nitems, Relation heapRel);
 extern void _bt_delitems_vacuum(Relation rel, Buffer buf,
 					OffsetNumber *itemnos, int nitems,
-					BlockNumber lastBlockVacuumed);
+					OffsetNumber *updatednos, IndexTuple *updated,
+					int nupdated, BlockNumber lastBlockVacuumed);
 extern int	_bt_pagedel(Relation rel, Buffer buf);
 
 /*
@@ -570,6 +654,7 @@ extern int32 _bt_compare(Relation rel, int keysz, ScanKey scankey,
 			Page page, OffsetNumber offnum);
 extern bool _bt_first(IndexScanDesc scan, ScanDirection dir);
 extern bool _bt_next(IndexScanDesc scan, ScanDirection dir);
+extern bool _bt_skip_advance(IndexScanDesc scan, ScanDirection dir);
 extern Buffer _bt_get_endpoint(Relation rel, uint32 level, bool rightmost,
 				 Snapshot snapshot);
 
@@ -585,6 +670,8 @@ extern void _bt_start_array_keys(IndexScanDesc scan, ScanDirection dir);
 extern bool _bt_advance_array_keys(IndexScanDesc scan, ScanDirection dir);
 extern void _bt_mark_array_keys(IndexScanDesc scan);
 extern void _bt_restore_array_keys(IndexScanDesc scan);
+extern void _bt_setup_skip_scan(IndexScanDesc scan);
+extern void _bt_skip_forget_value(IndexScanDesc scan);
 extern void _bt_preprocess_keys(IndexScanDesc scan);
 extern IndexTuple _bt_checkkeys(IndexScanDesc scan,
 			  Page page, OffsetNumber offnum,
@@ -600,7 +687,8 @@ extern bytea *btoptions(Datum reloptions, bool validate);
 extern bool btproperty(Oid index_oid, int attno,
 		   IndexAMProperty prop, const char *propname,
 		   bool *res, bool *isnull);
-extern IndexTuple _bt_nonkey_truncate(Relation rel, IndexTuple itup);
+extern IndexTuple _bt_truncate(Relation rel, IndexTuple lastleft,
+			 IndexTuple firstright);
 extern bool _bt_check_natts(Relation rel, Page page, OffsetNumber offnum);
 
 /*
@@ -41,6 +41,8 @@
 										 * FSM */
 #define XLOG_BTREE_META_CLEANUP	0xE0	/* update cleanup-related data in the
 										 * metapage */
+#define XLOG_BTREE_DEDUP		0xF0	/* merge duplicates on a leaf page into
+										 * posting list tuples */
 
 /*
  * All that we need to regenerate the meta-data page
@@ -86,16 +88,16 @@ typedef struct xl_btree_insert
  * are stored or not).  The _HIGHKEY variants indicate that we've logged
  * explicitly left page high key value, otherwise redo should use right page
  * leftmost key as a left page high key.  _HIGHKEY is specified for internal
- * pages where right page leftmost key is suppressed, and for leaf pages
- * of covering indexes where high key have non-key attributes truncated.
+ * pages where right page leftmost key is suppressed, and for leaf pages,
+ * where the high key is truncated (see _bt_truncate).  The plain variants
+ * are no longer generated, but redo still understands them.
  *
  * Backup Blk 0: original page / new left page
  *
  * The left page's data portion contains the new item, if it's the _L variant.
  * (In the _R variants, the new item is one of the right page's tuples.)
- * If level > 0, an IndexTuple representing the HIKEY of the left page
- * follows.  We don't need this on leaf pages, because it's the same as the
- * leftmost key in the new right page.
+ * For the _HIGHKEY variants, an IndexTuple representing the HIKEY of the
+ * left page follows.
  *
  * Backup Blk 1: new right page
  *
@@ -165,16 +167,40 @@ typedef struct xl_btree_reuse_page
  * block numbers aren't given.
  *
  * Note that the *last* WAL record in any vacuum of an index is allowed to
- * have a zero length array of offsets. Earlier records must have at least one.
+ * have a zero length array of offsets. Earlier records must have at least one
+ * deleted or updated item.  An updated item is a posting list tuple that some
+ * but not all of the heap TIDs were removed from; the smaller replacement
+ * tuple is included in the record.
  */
 typedef struct xl_btree_vacuum
 {
 	BlockNumber lastBlockVacuumed;
+	uint16		ndeleted;
+	uint16		nupdated;
 
-	/* TARGET OFFSET NUMBERS FOLLOW */
+	/* DELETED TARGET OFFSET NUMBERS FOLLOW */
+	/* UPDATED TARGET OFFSET NUMBERS FOLLOW */
+	/* UPDATED TUPLES FOLLOW, EACH MAXALIGN'D */
 } xl_btree_vacuum;
 
-#define SizeOfBtreeVacuum	(offsetof(xl_btree_vacuum, lastBlockVacuumed) + sizeof(BlockNumber))
+#define SizeOfBtreeVacuum	(offsetof(xl_btree_vacuum, nupdated) + sizeof(uint16))
+
+/*
+ * This is what we need to know about deduplicating the items of a leaf page,
+ * merging runs of items with equal keys into posting list tuples (see
+ * nbtdedup.c).  Each interval gives the offset of its first item and the
+ * number of items merged into it, in the page as it was before.
+ *
+ * Backup Blk 0: leaf page
+ */
+typedef struct xl_btree_dedup
+{
+	uint16		nintervals;
+
+	/* DEDUPLICATION INTERVALS (BTDedupInterval) FOLLOW */
+} xl_btree_dedup;
+
+#define SizeOfBtreeDedup	(offsetof(xl_btree_dedup, nintervals) + sizeof(uint16))
 
 /*
  * This is what we need to know about marking an empty branch for deletion.
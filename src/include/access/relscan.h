@@ -19,6 +19,7 @@
 #include "access/htup_details.h"
 #include "access/itup.h"
 #include "access/tupdesc.h"
+#include "storage/read_stream.h"
 #include "storage/spin.h"
 
 /*
@@ -64,6 +65,9 @@ typedef struct HeapScanDescData
 	/* rs_numblocks is usually InvalidBlockNumber, meaning "scan whole rel" */
 	BufferAccessStrategy rs_strategy;	/* access strategy for reads */
 	bool		rs_syncscan;	/* report location to syncscan logic? */
+	ReadStream *rs_stream;		/* look-ahead reader for forward scans */
+	BlockNumber rs_stream_next; /* next block to hand to rs_stream */
+	BlockNumber rs_stream_remaining;	/* rs_numblocks as seen by rs_stream */
 
 	/* scan current state */
 	bool		rs_inited;		/* false = scan not init'd yet */
@@ -95,6 +99,7 @@ typedef struct IndexScanDescData
 	ScanKey		keyData;		/* array of index qualifier descriptors */
 	ScanKey		orderByData;	/* array of ordering op descriptors */
 	bool		xs_want_itup;	/* caller requests index tuples */
+	bool		xs_want_skip;	/* caller requests a skip scan, if amcanskip */
 	bool		xs_temp_snap;	/* unregister snapshot at scan end? */
 
 	/* signaling to index AM about killing index tuples */
@@ -137,6 +142,9 @@ typedef struct IndexScanDescData
 	/* state data for traversing HOT chains in index_getnext */
 	bool		xs_continue_hot;	/* T if must keep walking HOT chain */
 
+	/* index entries read ahead, see index_set_prefetch() */
+	struct IndexPrefetchData *xs_prefetch;
+
 	/* parallel index scan information, in shared memory */
 	ParallelIndexScanDesc parallel_scan;
 }			IndexScanDescData;
@@ -35,6 +35,18 @@
 /* Maximum length of an SLRU name */
 #define SLRU_MAX_NAME_LENGTH	32
 
+/*
+ * Buffer slots are grouped into banks of SLRU_BANK_SIZE slots, and a given
+ * page can only be stored in the bank selected by its page number.  Looking
+ * up a page or choosing a victim slot therefore only examines one bank, so
+ * the cost does not grow with the total number of buffers.  Pools whose size
+ * is not a multiple of SLRU_BANK_SIZE are treated as a single bank.
+ */
+#define SLRU_BANK_SIZE			16
+
+/* Upper limit on configurable SLRU buffer pool sizes (1GB at 8kB pages) */
+#define SLRU_MAX_ALLOWED_BUFFERS	((1024 * 1024 * 1024) / BLCKSZ)
+
 /*
  * Page status codes.  Note that these do not include the "dirty" bit.
  * page_dirty can be true only in the VALID or WRITE_IN_PROGRESS states;
@@ -59,6 +71,10 @@ typedef struct SlruSharedData
 	/* Number of buffers managed by this SLRU structure */
 	int			num_slots;
 
+	/* Number of banks the buffers are divided into, and slots per bank */
+	int			num_banks;
+	int			bank_size;
+
 	/*
 	 * Arrays holding info for each buffer slot.  Page number is undefined
 	 * when status is EMPTY, as is page_lru_count.
@@ -137,6 +153,7 @@ typedef struct SlruCtlData
 typedef SlruCtlData *SlruCtl;
 
 
+extern int	SimpleLruAdjustBuffers(int nslots);
 extern Size SimpleLruShmemSize(int nslots, int nlsns);
 extern void SimpleLruInit(SlruCtl ctl, const char *name, int nslots, int nlsns,
 			  LWLock *ctllock, const char *subdir, int tranche_id);
@@ -11,9 +11,12 @@
 #ifndef SUBTRANS_H
 #define SUBTRANS_H
 
-/* Number of SLRU buffers to use for subtrans */
+/* Default number of SLRU buffers to use for subtrans */
 #define NUM_SUBTRANS_BUFFERS	32
 
+/* GUC variable */
+extern int	subtrans_buffers;
+
 extern void SubTransSetParent(TransactionId xid, TransactionId parent);
 extern TransactionId SubTransGetParent(TransactionId xid);
 extern TransactionId SubTransGetTopmostTransaction(TransactionId xid);
@@ -109,7 +109,37 @@
  * saves space, so we expect either equality or less-than.
  */
 #define VARATT_EXTERNAL_IS_COMPRESSED(toast_pointer) \
-	((toast_pointer).va_extsize < (toast_pointer).va_rawsize - VARHDRSZ)
+	(VARATT_EXTERNAL_GET_EXTSIZE(toast_pointer) < \
+	 (toast_pointer).va_rawsize - VARHDRSZ)
+
+/*
+ * The compression method of an externally-stored compressed value is kept
+ * in the high-order bits of va_extsize, the same way it is for an in-line
+ * compressed value's va_rawsize.
+ */
+#define VARATT_EXTERNAL_GET_EXTSIZE(toast_pointer) \
+	((int32) ((uint32) (toast_pointer).va_extsize & VARLENA_RAWSIZE_MASK))
+#define VARATT_EXTERNAL_GET_COMPRESSION(toast_pointer) \
+	((int) ((uint32) (toast_pointer).va_extsize >> VARLENA_RAWSIZE_BITS))
+#define VARATT_EXTERNAL_SET_SIZE_AND_COMPRESSION(toast_pointer, len, cmid) \
+	((toast_pointer).va_extsize = \
+	 (int32) ((uint32) (len) | ((uint32) (cmid) << VARLENA_RAWSIZE_BITS)))
+
+/*
+ * Compression methods for TOAST data.  The numbers are stored on disk, so
+ * they must never change; pglz is zero so that values compressed before
+ * there was a choice of method read back correctly.
+ */
+typedef enum ToastCompressionId
+{
+	TOAST_PGLZ_COMPRESSION_ID = 0,
+	TOAST_LZ4_COMPRESSION_ID = 1,
+	TOAST_ZSTD_COMPRESSION_ID = 2,
+	TOAST_INVALID_COMPRESSION_ID = 3
+} ToastCompressionId;
+
+/* GUC variable */
+extern int	default_toast_compression;
 
 /*
  * Macro to fetch the possibly-unaligned contents of an EXTERNAL datum
@@ -210,7 +240,32 @@ extern HeapTuple toast_build_flattened_tuple(TupleDesc tupleDesc,
  *	Create a compressed version of a varlena datum, if possible
  * ----------
  */
-extern Datum toast_compress_datum(Datum value);
+extern Datum toast_compress_datum(Datum value, int cmethod);
+
+/* ----------
+ * toast_get_compression_method -
+ *
+ *	Return the compression method to use for an attribute of a relation
+ * ----------
+ */
+extern int	toast_get_compression_method(Relation rel, int attnum);
+
+/* ----------
+ * toast_get_compression_id -
+ *
+ *	Return the compression method of a varlena datum, or
+ *	TOAST_INVALID_COMPRESSION_ID if it is not compressed
+ * ----------
+ */
+extern int	toast_get_compression_id(struct varlena *attr);
+
+/* ----------
+ * Conversion between compression method names and ids
+ * ----------
+ */
+extern int	toast_compression_method_from_name(const char *name);
+extern const char *toast_compression_method_name(int cmethod);
+extern void toast_validate_compression_option(const char *value);
 
 /* ----------
  * toast_raw_datum_size -
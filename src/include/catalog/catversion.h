@@ -53,6 +53,6 @@
  */
 
 /*							yyyymmddN */
-#define CATALOG_VERSION_NO	201901041
+#define CATALOG_VERSION_NO	201901076
 
 #endif
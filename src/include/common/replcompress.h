@@ -0,0 +1,41 @@
+/*-------------------------------------------------------------------------
+ *
+ * replcompress.h
+ *	  Compression of WAL streamed over the replication protocol
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/common/replcompress.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef REPLCOMPRESS_H
+#define REPLCOMPRESS_H
+
+#include "common/pg_lzcompress.h"
+
+typedef enum ReplCompressionMethod
+{
+	REPL_COMPRESSION_NONE = 0,
+	REPL_COMPRESSION_PGLZ,
+	REPL_COMPRESSION_LZ4,
+	REPL_COMPRESSION_ZSTD
+} ReplCompressionMethod;
+
+/*
+ * Size of the output buffer that repl_compress() needs for an input of
+ * 'slen' bytes.
+ */
+#define REPL_COMPRESS_BOUND(slen)	PGLZ_MAX_OUTPUT(slen)
+
+extern bool repl_compression_parse(const char *name,
+					   ReplCompressionMethod *method);
+extern const char *repl_compression_name(ReplCompressionMethod method);
+extern bool repl_compression_supported(ReplCompressionMethod method);
+extern int32 repl_compress(ReplCompressionMethod method, const char *source,
+			  int32 slen, char *dest);
+extern int32 repl_decompress(ReplCompressionMethod method, const char *source,
+				int32 slen, char *dest, int32 rawsize);
+
+#endif							/* REPLCOMPRESS_H */
@@ -20,6 +20,7 @@
 /* forward references to avoid circularity */
 struct ExprEvalStep;
 struct ArrayRefState;
+struct ScalarArrayOpExprHashTable;
 
 /* Bits in ExprState->flags (see also execnodes.h for public flag bits): */
 /* expression's interpreter has been initialized */
@@ -91,6 +92,26 @@ typedef enum ExprEvalOp
 	EEOP_FUNCEXPR_FUSAGE,
 	EEOP_FUNCEXPR_STRICT_FUSAGE,
 
+	/*
+	 * Strict comparisons of common builtin types, evaluated inline rather
+	 * than by calling the function.  These are used in place of
+	 * EEOP_FUNCEXPR_STRICT when usage stats are not being tracked; the
+	 * step's d.func data is filled in just the same.  Keep them contiguous
+	 * and in this order, see ExecInitFunc().
+	 */
+	EEOP_FUNCEXPR_STRICT_INT4EQ,
+	EEOP_FUNCEXPR_STRICT_INT4NE,
+	EEOP_FUNCEXPR_STRICT_INT4LT,
+	EEOP_FUNCEXPR_STRICT_INT4LE,
+	EEOP_FUNCEXPR_STRICT_INT4GT,
+	EEOP_FUNCEXPR_STRICT_INT4GE,
+	EEOP_FUNCEXPR_STRICT_INT8EQ,
+	EEOP_FUNCEXPR_STRICT_INT8NE,
+	EEOP_FUNCEXPR_STRICT_INT8LT,
+	EEOP_FUNCEXPR_STRICT_INT8LE,
+	EEOP_FUNCEXPR_STRICT_INT8GT,
+	EEOP_FUNCEXPR_STRICT_INT8GE,
+
 	/*
 	 * Evaluate boolean AND expression, one step per subexpression. FIRST/LAST
 	 * subexpressions are special-cased for performance.  Since AND always has
@@ -213,6 +234,7 @@ typedef enum ExprEvalOp
 	/* evaluate assorted special-purpose expression types */
 	EEOP_CONVERT_ROWTYPE,
 	EEOP_SCALARARRAYOP,
+	EEOP_HASHED_SCALARARRAYOP,
 	EEOP_XMLEXPR,
 	EEOP_AGGREF,
 	EEOP_GROUPING_FUNC,
@@ -224,6 +246,7 @@ typedef enum ExprEvalOp
 	EEOP_AGG_STRICT_DESERIALIZE,
 	EEOP_AGG_DESERIALIZE,
 	EEOP_AGG_STRICT_INPUT_CHECK,
+	EEOP_AGG_PLAIN_PERGROUP_NULLCHECK,
 	EEOP_AGG_INIT_TRANS,
 	EEOP_AGG_STRICT_TRANS_CHECK,
 	EEOP_AGG_PLAIN_TRANS_BYVAL,
@@ -546,6 +569,21 @@ typedef struct ExprEvalStep
 			PGFunction	fn_addr;	/* actual call address */
 		}			scalararrayop;
 
+		/* for EEOP_HASHED_SCALARARRAYOP */
+		struct
+		{
+			bool		has_nulls;	/* array contained any NULL elements? */
+			struct ScalarArrayOpExprHashTable *elements_tab;	/* built at
+																 * first use */
+			FmgrInfo   *finfo;	/* equality function's lookup data */
+			FunctionCallInfo fcinfo_data;	/* arguments etc */
+			/* faster to access without additional indirection: */
+			PGFunction	fn_addr;	/* actual call address */
+			FmgrInfo   *hash_finfo; /* hash function's lookup data */
+			FunctionCallInfo hash_fcinfo_data;	/* arguments etc */
+			PGFunction	hash_fn_addr;	/* actual call address */
+		}			hashedscalararrayop;
+
 		/* for EEOP_XMLEXPR */
 		struct
 		{
@@ -609,6 +647,14 @@ typedef struct ExprEvalStep
 			int			jumpnull;
 		}			agg_strict_input_check;
 
+		/* for EEOP_AGG_PLAIN_PERGROUP_NULLCHECK */
+		struct
+		{
+			AggState   *aggstate;
+			int			setoff;
+			int			jumpnull;
+		}			agg_plain_pergroup_nullcheck;
+
 		/* for EEOP_AGG_INIT_TRANS */
 		struct
 		{
@@ -729,6 +775,8 @@ extern void ExecEvalArrayRefAssign(ExprState *state, ExprEvalStep *op);
 extern void ExecEvalConvertRowtype(ExprState *state, ExprEvalStep *op,
 					   ExprContext *econtext);
 extern void ExecEvalScalarArrayOp(ExprState *state, ExprEvalStep *op);
+extern void ExecEvalHashedScalarArrayOp(ExprState *state, ExprEvalStep *op,
+							ExprContext *econtext);
 extern void ExecEvalConstraintNotNull(ExprState *state, ExprEvalStep *op);
 extern void ExecEvalConstraintCheck(ExprState *state, ExprEvalStep *op);
 extern void ExecEvalXmlExpr(ExprState *state, ExprEvalStep *op);
@@ -149,5 +149,7 @@ extern PartitionPruneState *ExecCreatePartitionPruneState(PlanState *planstate,
 extern Bitmapset *ExecFindMatchingSubPlans(PartitionPruneState *prunestate);
 extern Bitmapset *ExecFindInitialMatchingSubPlans(PartitionPruneState *prunestate,
 								int nsubplans);
+extern Bitmapset *ExecPrunableRelidsToLock(PlannedStmt *plannedstmt,
+						 ParamListInfo params);
 
 #endif							/* EXECPARTITION_H */
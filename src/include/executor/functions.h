@@ -26,6 +26,9 @@ extern SQLFunctionParseInfoPtr prepare_sql_fn_parse_info(HeapTuple procedureTupl
 						  Node *call_expr,
 						  Oid inputCollation);
 
+extern List *get_sql_fn_raw_parsetrees(HeapTuple procedureTuple,
+						  const char *src);
+
 extern void sql_fn_parser_setup(struct ParseState *pstate,
 					SQLFunctionParseInfoPtr pinfo);
 
@@ -92,6 +92,13 @@ typedef struct HashJoinTupleData
  * allowed for the join; while building the hashtables, we decrease the number
  * of MCVs being specially treated if needed to stay under this limit.
  *
+ * Serial hash joins also watch for inner hash values that the statistics
+ * missed: if, while building the first batch, a single hash value turns out
+ * to hold most of the in-memory tuples, no increase in the number of batches
+ * can split it.  Such a value gets a "detected" skew bucket of its own, whose
+ * space doesn't count against either limit; it stays in memory until the
+ * first batch is done, just as the batch holding it would have had to.
+ *
  * Note: you might wonder why we look at the outer relation stats for this,
  * rather than the inner.  One reason is that the outer relation is typically
  * bigger, so we get more I/O savings by optimizing for its most common values.
@@ -103,6 +110,7 @@ typedef struct HashSkewBucket
 {
 	uint32		hashvalue;		/* common hash value */
 	HashJoinTuple tuples;		/* linked list of inner-relation tuples */
+	bool		detected;		/* found at runtime, not from MCV stats? */
 } HashSkewBucket;
 
 #define SKEW_BUCKET_OVERHEAD  MAXALIGN(sizeof(HashSkewBucket))
@@ -338,11 +346,20 @@ typedef struct HashJoinTableData
 	FmgrInfo   *inner_hashfunctions;	/* lookup data for hash functions */
 	bool	   *hashStrict;		/* is each hash join operator strict? */
 
+	/*
+	 * Bloom filter over the hash values of all inner tuples, in hashCxt, for
+	 * use by a runtime filter in the outer scan; NULL if not wanted.  It is
+	 * only set once the inner relation has been read completely.
+	 */
+	struct bloom_filter *bloomfilter;
+
 	Size		spaceUsed;		/* memory space currently used by tuples */
 	Size		spaceAllowed;	/* upper limit for space used */
 	Size		spacePeak;		/* peak space used */
 	Size		spaceUsedSkew;	/* skew hash table's current space usage */
 	Size		spaceAllowedSkew;	/* upper limit for skew hashtable */
+	Size		spaceUsedDetected;	/* space of detected skew buckets, which
+									 * has been added to spaceAllowed */
 
 	MemoryContext hashCxt;		/* context for whole-hash-join storage */
 	MemoryContext batchCxt;		/* context for this-batch-only storage */
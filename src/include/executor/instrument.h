@@ -32,13 +32,32 @@ typedef struct BufferUsage
 	instr_time	blk_write_time; /* time spent writing */
 } BufferUsage;
 
+typedef struct WalUsage
+{
+	long		wal_records;	/* # of WAL records produced */
+	long		wal_fpi;		/* # of WAL full page images produced */
+	uint64		wal_bytes;		/* size of WAL records produced */
+} WalUsage;
+
+/* Hardware performance counters, see InstrCpuCountersAvailable() */
+typedef struct CpuUsage
+{
+	uint64		cycles;			/* # of CPU cycles */
+	uint64		instructions;	/* # of instructions retired */
+	uint64		cache_misses;	/* # of last-level cache misses */
+	uint64		branch_misses;	/* # of mispredicted branches */
+} CpuUsage;
+
 /* Flag bits included in InstrAlloc's instrument_options bitmask */
 typedef enum InstrumentOption
 {
 	INSTRUMENT_TIMER = 1 << 0,	/* needs timer (and row counts) */
 	INSTRUMENT_BUFFERS = 1 << 1,	/* needs buffer usage */
 	INSTRUMENT_ROWS = 1 << 2,	/* needs row count */
-	INSTRUMENT_ALL = PG_INT32_MAX
+	INSTRUMENT_WAL = 1 << 3,	/* needs WAL usage */
+	INSTRUMENT_CPU = 1 << 4,	/* needs hardware CPU counters */
+	/* CPU counters cost system calls, so they must be requested explicitly */
+	INSTRUMENT_ALL = PG_INT32_MAX & ~INSTRUMENT_CPU
 } InstrumentOption;
 
 typedef struct Instrumentation
@@ -46,6 +65,8 @@ typedef struct Instrumentation
 	/* Parameters set at node creation: */
 	bool		need_timer;		/* true if we need timer data */
 	bool		need_bufusage;	/* true if we need buffer usage data */
+	bool		need_walusage;	/* true if we need WAL usage data */
+	bool		need_cpuusage;	/* true if we need CPU counter data */
 	/* Info about current plan cycle: */
 	bool		running;		/* true if we've completed first tuple */
 	instr_time	starttime;		/* Start time of current iteration of node */
@@ -53,6 +74,8 @@ typedef struct Instrumentation
 	double		firsttuple;		/* Time for first tuple of this cycle */
 	double		tuplecount;		/* Tuples emitted so far this cycle */
 	BufferUsage bufusage_start; /* Buffer usage at start */
+	WalUsage	walusage_start; /* WAL usage at start */
+	CpuUsage	cpuusage_start; /* CPU counters at start */
 	/* Accumulated statistics across all completed cycles: */
 	double		startup;		/* Total startup time (in seconds) */
 	double		total;			/* Total total time (in seconds) */
@@ -62,6 +85,8 @@ typedef struct Instrumentation
 	double		nfiltered1;		/* # tuples removed by scanqual or joinqual */
 	double		nfiltered2;		/* # tuples removed by "other" quals */
 	BufferUsage bufusage;		/* Total buffer usage */
+	WalUsage	walusage;		/* total WAL usage */
+	CpuUsage	cpuusage;		/* total CPU counters */
 } Instrumentation;
 
 typedef struct WorkerInstrumentation
@@ -71,6 +96,7 @@ typedef struct WorkerInstrumentation
 } WorkerInstrumentation;
 
 extern PGDLLIMPORT BufferUsage pgBufferUsage;
+extern PGDLLIMPORT WalUsage pgWalUsage;
 
 extern Instrumentation *InstrAlloc(int n, int instrument_options);
 extern void InstrInit(Instrumentation *instr, int instrument_options);
@@ -81,5 +107,8 @@ extern void InstrAggNode(Instrumentation *dst, Instrumentation *add);
 extern void InstrStartParallelQuery(void);
 extern void InstrEndParallelQuery(BufferUsage *result);
 extern void InstrAccumParallelQuery(BufferUsage *result);
+extern bool InstrCpuCountersAvailable(void);
+extern void WalUsageAccumDiff(WalUsage *dst, const WalUsage *add,
+				  const WalUsage *sub);
 
 #endif							/* INSTRUMENT_H */
@@ -280,6 +280,13 @@ typedef struct AggStatePerPhaseData
 	Sort	   *sortnode;		/* Sort node for input ordering for phase */
 
 	ExprState  *evaltrans;		/* evaluation of transition functions  */
+
+	/*
+	 * Variants of evaltrans for hashed aggregation that has spilled to disk,
+	 * indexed by [minslot][nullcheck]; see hashagg_recompile_expressions().
+	 * [0][0] is evaltrans as originally built.
+	 */
+	ExprState  *evaltrans_cache[2][2];
 }			AggStatePerPhaseData;
 
 /*
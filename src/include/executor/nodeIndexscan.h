@@ -42,5 +42,6 @@ extern void ExecIndexEvalRuntimeKeys(ExprContext *econtext,
 extern bool ExecIndexEvalArrayKeys(ExprContext *econtext,
 					   IndexArrayKeyInfo *arrayKeys, int numArrayKeys);
 extern bool ExecIndexAdvanceArrayKeys(IndexArrayKeyInfo *arrayKeys, int numArrayKeys);
+extern int	ExecIndexPrefetchMaximum(Relation heapRelation, int eflags);
 
 #endif							/* NODEINDEXSCAN_H */
@@ -16,6 +16,12 @@
 
 #include "nodes/execnodes.h"
 
+/*
+ * Number of consecutive non-matching inner tuples a skip-ahead merge join
+ * steps over before re-seeking its inner index scan to the current outer key.
+ */
+#define MJ_SKIP_INNER_THRESHOLD		16
+
 extern MergeJoinState *ExecInitMergeJoin(MergeJoin *node, EState *estate, int eflags);
 extern void ExecEndMergeJoin(MergeJoinState *node);
 extern void ExecReScanMergeJoin(MergeJoinState *node);
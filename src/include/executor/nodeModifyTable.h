@@ -18,5 +18,12 @@
 extern ModifyTableState *ExecInitModifyTable(ModifyTable *node, EState *estate, int eflags);
 extern void ExecEndModifyTable(ModifyTableState *node);
 extern void ExecReScanModifyTable(ModifyTableState *node);
+extern int	ExecForeignBatchSize(ModifyTableState *mtstate,
+					 ResultRelInfo *resultRelInfo);
+extern uint64 ExecBufferForeignInsert(ModifyTableState *mtstate,
+						ResultRelInfo *resultRelInfo,
+						TupleTableSlot *slot,
+						TupleTableSlot *planSlot);
+extern uint64 ExecPendingInserts(ModifyTableState *mtstate);
 
 #endif							/* NODEMODIFYTABLE_H */
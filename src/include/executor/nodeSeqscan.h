@@ -17,6 +17,9 @@
 #include "access/parallel.h"
 #include "nodes/execnodes.h"
 
+/* GUC parameter */
+extern bool enable_vectorized_scan;
+
 extern SeqScanState *ExecInitSeqScan(SeqScan *node, EState *estate, int eflags);
 extern void ExecEndSeqScan(SeqScanState *node);
 extern void ExecReScanSeqScan(SeqScanState *node);
@@ -102,6 +102,7 @@ extern WaitEventSet *FeBeWaitSet;
 extern char *SSLCipherSuites;
 extern char *SSLECDHCurve;
 extern bool SSLPreferServerCiphers;
+extern bool ssl_ktls;
 extern int	ssl_min_protocol_version;
 extern int	ssl_max_protocol_version;
 
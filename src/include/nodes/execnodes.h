@@ -18,6 +18,7 @@
 #include "access/heapam.h"
 #include "access/tupconvert.h"
 #include "executor/instrument.h"
+#include "lib/ilist.h"
 #include "lib/pairingheap.h"
 #include "nodes/params.h"
 #include "nodes/plannodes.h"
@@ -437,6 +438,12 @@ typedef struct ResultRelInfo
 	/* true when modifying foreign table directly */
 	bool		ri_usesFdwDirectModify;
 
+	/* batch insert stuff */
+	int			ri_NumSlots;	/* number of slots in the array */
+	int			ri_BatchSize;	/* max slots inserted in a single batch */
+	TupleTableSlot **ri_Slots;	/* input tuples for batch insert */
+	TupleTableSlot **ri_PlanSlots;	/* corresponding plan tuples, if any */
+
 	/* list of WithCheckOption's to be checked */
 	List	   *ri_WithCheckOptions;
 
@@ -1129,6 +1136,9 @@ typedef struct ModifyTableState
 
 	/* Per plan map for tuple conversion from child to root */
 	TupleConversionMap **mt_per_subplan_tupconv_maps;
+
+	/* ResultRelInfos that have rows buffered for a batch insert */
+	List	   *mt_pending_inserts;
 } ModifyTableState;
 
 /* ----------------
@@ -1262,6 +1272,7 @@ typedef struct BitmapOrState
  *		currentRelation    relation being scanned (NULL if none)
  *		currentScanDesc    current scan descriptor for scan (NULL if none)
  *		ScanTupleSlot	   pointer to slot in tuple table holding scan tuple
+ *		RuntimeFilter	   filter pushed down by a parent hash join, or NULL
  * ----------------
  */
 typedef struct ScanState
@@ -1270,16 +1281,49 @@ typedef struct ScanState
 	Relation	ss_currentRelation;
 	HeapScanDesc ss_currentScanDesc;
 	TupleTableSlot *ss_ScanTupleSlot;
+	struct RuntimeJoinFilter *ss_RuntimeFilter;
 } ScanState;
 
+/* ----------------
+ *	 RuntimeJoinFilter information
+ *
+ *		A hash join whose outer side is a plain relation scan can ask the
+ *		scan to discard tuples whose join keys certainly have no match in
+ *		the hash table, using a Bloom filter built along with the table.
+ *		Until the hash table has been built, every tuple passes.
+ *
+ *		hjstate			   the hash join owning the filter
+ *		hashkeys		   outer hash keys, evaluated over the scan tuple
+ *		ntested			   number of tuples tested against the filter
+ *		nrejected		   number of those rejected by it
+ *		disabled		   true if the filter turned out not to be selective
+ * ----------------
+ */
+typedef struct RuntimeJoinFilter
+{
+	struct HashJoinState *hjstate;
+	List	   *hashkeys;		/* list of ExprState nodes */
+	int64		ntested;
+	int64		nrejected;
+	bool		disabled;
+} RuntimeJoinFilter;
+
 /* ----------------
  *	 SeqScanState information
+ *
+ *		batch is non-NULL if some of the quals are simple comparisons that
+ *		are checked for a whole page of tuples at a time; ps.qual then holds
+ *		only the remaining quals.
  * ----------------
  */
+/* this struct is private in nodeSeqscan.c: */
+typedef struct SeqScanBatchState SeqScanBatchState;
+
 typedef struct SeqScanState
 {
 	ScanState	ss;				/* its first field is NodeTag */
 	Size		pscan_len;		/* size of parallel heap scan descriptor */
+	SeqScanBatchState *batch;	/* batch qual state, or NULL */
 } SeqScanState;
 
 /* ----------------
@@ -1337,6 +1381,7 @@ typedef struct
  *		RuntimeContext	   expr context for evaling runtime Skeys
  *		RelationDesc	   index relation descriptor
  *		ScanDesc		   index scan descriptor
+ *		PrefetchMaximum	   how far to read ahead in the index, 0 for not at all
  *
  *		ReorderQueue	   tuples that need reordering due to re-check
  *		ReachedEnd		   have we fetched all tuples from index already?
@@ -1363,6 +1408,7 @@ typedef struct IndexScanState
 	ExprContext *iss_RuntimeContext;
 	Relation	iss_RelationDesc;
 	IndexScanDesc iss_ScanDesc;
+	int			iss_PrefetchMaximum;
 
 	/* These are needed for re-checking ORDER BY expr ordering */
 	pairingheap *iss_ReorderQueue;
@@ -1391,6 +1437,7 @@ typedef struct IndexScanState
  *		RelationDesc	   index relation descriptor
  *		ScanDesc		   index scan descriptor
  *		VMBuffer		   buffer in use for visibility map testing, if any
+ *		PrefetchMaximum	   how far to read ahead in the index, 0 for not at all
  *		ioss_PscanLen	   Size of parallel index-only scan descriptor
  * ----------------
  */
@@ -1409,6 +1456,7 @@ typedef struct IndexOnlyScanState
 	Relation	ioss_RelationDesc;
 	IndexScanDesc ioss_ScanDesc;
 	Buffer		ioss_VMBuffer;
+	int			ioss_PrefetchMaximum;
 	Size		ioss_PscanLen;
 } IndexOnlyScanState;
 
@@ -1426,6 +1474,7 @@ typedef struct IndexOnlyScanState
  *		RuntimeContext	   expr context for evaling runtime Skeys
  *		RelationDesc	   index relation descriptor
  *		ScanDesc		   index scan descriptor
+ *		PscanLen		   size of parallel index scan descriptor
  * ----------------
  */
 typedef struct BitmapIndexScanState
@@ -1442,6 +1491,7 @@ typedef struct BitmapIndexScanState
 	ExprContext *biss_RuntimeContext;
 	Relation	biss_RelationDesc;
 	IndexScanDesc biss_ScanDesc;
+	Size		biss_PscanLen;
 } BitmapIndexScanState;
 
 /* ----------------
@@ -1453,14 +1503,23 @@ typedef struct BitmapIndexScanState
  *						TIDBitmap.
  *		BM_INPROGRESS	TIDBitmap creation is in progress; workers need to
  *						sleep until it's finished.
+ *		BM_MERGING		With a parallel bitmap build, the participants'
+ *						partial TIDBitmaps are being merged into the shared
+ *						one; processes arriving now just wait for that.
  *		BM_FINISHED		TIDBitmap creation is done, so now all workers can
  *						proceed to iterate over TIDBitmap.
+ *
+ * With a parallel bitmap build (parallel-aware index scans below the bitmap
+ * heap scan), every process that sees BM_INITIAL or BM_INPROGRESS builds a
+ * TIDBitmap for its share of the index scans; the last one to finish merges
+ * them all.
  * ----------------
  */
 typedef enum
 {
 	BM_INITIAL,
 	BM_INPROGRESS,
+	BM_MERGING,
 	BM_FINISHED
 } SharedBitmapState;
 
@@ -1473,6 +1532,11 @@ typedef enum
  *		prefetch_pages			# pages prefetch iterator is ahead of current
  *		prefetch_target			current target prefetch distance
  *		state					current state of the TIDBitmap
+ *		nbuilders				# processes building a partial TIDBitmap
+ *		nbuilt					# partial TIDBitmaps built so far
+ *		maxbuilders				size of the partial_bitmaps array
+ *		partial_bitmaps			dsa_pointer to array of partial TIDBitmaps,
+ *								as exported by tbm_export()
  *		cv						conditional wait variable
  *		phs_snapshot_data		snapshot data shared to workers
  * ----------------
@@ -1485,6 +1549,10 @@ typedef struct ParallelBitmapHeapState
 	int			prefetch_pages;
 	int			prefetch_target;
 	SharedBitmapState state;
+	int			nbuilders;
+	int			nbuilt;
+	int			maxbuilders;
+	dsa_pointer partial_bitmaps;
 	ConditionVariable cv;
 	char		phs_snapshot_data[FLEXIBLE_ARRAY_MEMBER];
 } ParallelBitmapHeapState;
@@ -1511,6 +1579,7 @@ typedef struct ParallelBitmapHeapState
  *		shared_tbmiterator	   shared iterator
  *		shared_prefetch_iterator shared iterator for prefetching
  *		pstate			   shared state for parallel bitmap scan
+ *		parallel_build	   do all participants build the bitmap together?
  * ----------------
  */
 typedef struct BitmapHeapScanState
@@ -1535,6 +1604,7 @@ typedef struct BitmapHeapScanState
 	TBMSharedIterator *shared_tbmiterator;
 	TBMSharedIterator *shared_prefetch_iterator;
 	ParallelBitmapHeapState *pstate;
+	bool		parallel_build;
 } BitmapHeapScanState;
 
 /* ----------------
@@ -1661,6 +1731,9 @@ typedef struct TableFuncScanState
  * Multiple CteScan nodes can read out from the same CTE query.  We use
  * a tuplestore to hold rows that have been read from the CTE query but
  * not yet consumed by all readers.
+ *
+ * A parallel-aware CteScan reads from a shared tuplestore instead, which
+ * the leader fills from the CTE before starting the workers.
  * ----------------
  */
 typedef struct CteScanState
@@ -1669,6 +1742,7 @@ typedef struct CteScanState
 	int			eflags;			/* capability flags to pass to tuplestore */
 	int			readptr;		/* index of my tuplestore read pointer */
 	PlanState  *cteplanstate;	/* PlanState for the CTE query itself */
+	SharedTuplestoreAccessor *sts;	/* shared rows, in a parallel scan */
 	/* Link to the "leader" CteScanState (possibly this same node) */
 	struct CteScanState *leader;
 	/* The remaining fields are only valid in the "leader" CteScanState */
@@ -1805,6 +1879,11 @@ typedef struct NestLoopState
  *		NullInnerTupleSlot prepared null tuple for left outer joins
  *		OuterEContext	   workspace for computing outer tuple's join values
  *		InnerEContext	   workspace for computing inner tuple's join values
+ *		SkipParam		   PARAM_EXEC ID used to re-seek the inner scan, or -1
+ *		SkipCount		   inner tuples skipped since the last match or re-seek
+ *		SkipValue		   copy of the outer key the inner scan was sought to
+ *		SkipTypLen		   typlen of the outer key
+ *		SkipTypByVal	   typbyval of the outer key
  * ----------------
  */
 /* private in nodeMergejoin.c: */
@@ -1830,6 +1909,11 @@ typedef struct MergeJoinState
 	TupleTableSlot *mj_NullInnerTupleSlot;
 	ExprContext *mj_OuterEContext;
 	ExprContext *mj_InnerEContext;
+	int			mj_SkipParam;
+	int			mj_SkipCount;
+	Datum		mj_SkipValue;
+	int16		mj_SkipTypLen;
+	bool		mj_SkipTypByVal;
 } MergeJoinState;
 
 /* ----------------
@@ -1908,6 +1992,51 @@ typedef struct MaterialState
 	Tuplestorestate *tuplestorestate;
 } MaterialState;
 
+/* ----------------
+ *	 ResultCacheState information
+ *
+ *		result cache nodes are used to cache the results of a parameterized
+ *		subplan, so that a rescan with parameter values that were seen
+ *		before doesn't need to run the subplan again.  The cache is an LRU
+ *		hash table, bounded by work_mem.
+ * ----------------
+ */
+typedef struct ResultCacheInstrumentation
+{
+	uint64		cache_hits;		/* number of rescans answered from cache */
+	uint64		cache_misses;	/* number of rescans that ran the subplan */
+	uint64		cache_evictions;	/* number of entries evicted to free
+									 * memory */
+	uint64		cache_overflows;	/* number of times a single entry didn't
+									 * fit in work_mem */
+	uint64		mem_peak;		/* peak memory usage in bytes */
+} ResultCacheInstrumentation;
+
+struct ResultCacheEntry;
+struct ResultCacheTuple;
+struct resultcache_hash;
+
+typedef struct ResultCacheState
+{
+	ScanState	ss;				/* its first field is NodeTag */
+	int			rc_status;		/* value of ExecResultCache state machine */
+	int			nkeys;			/* number of cache keys */
+	struct resultcache_hash *hashtable; /* hash table for cache entries */
+	TupleDesc	hashkeydesc;	/* tuple descriptor for cache keys */
+	TupleTableSlot *tableslot;	/* slot for cache keys in the hash table */
+	TupleTableSlot *probeslot;	/* slot for the current cache key */
+	ExprState **param_exprs;	/* exprs to compute the cache key */
+	MemoryContext tableContext; /* memory context for the cache */
+	dlist_head	lru_list;		/* least recently used entry list */
+	struct ResultCacheEntry *entry; /* entry being read or filled */
+	struct ResultCacheTuple *last_tuple;	/* last tuple read or stored */
+	uint64		mem_used;		/* bytes of memory used by the cache */
+	uint64		mem_limit;		/* memory limit in bytes for the cache */
+	bool		singlerow;		/* entry is complete after its first tuple */
+	Bitmapset  *keyparamids;	/* paramids of the cache key params */
+	ResultCacheInstrumentation stats;	/* execution statistics */
+} ResultCacheState;
+
 /* ----------------
  *	 Shared memory container for per-worker sort information
  * ----------------
@@ -1936,6 +2065,31 @@ typedef struct SortState
 	SharedSortInfo *shared_info;	/* one entry per worker */
 } SortState;
 
+/* ----------------
+ *	 IncrementalSortState information
+ *
+ *		Tuples are collected into batches that end at a change of the
+ *		presorted columns, and each batch is sorted separately.
+ *		group_pivot holds the tuple that the presorted columns of the
+ *		following input tuples are compared with; once a batch is complete,
+ *		it holds the first tuple of the next batch.
+ * ----------------
+ */
+typedef struct IncrementalSortState
+{
+	ScanState	ss;				/* its first field is NodeTag */
+	bool		bounded;		/* is the result set bounded? */
+	int64		bound;			/* if bounded, how many tuples are needed */
+	int64		bound_Done;		/* number of tuples returned so far */
+	bool		batch_sorted;	/* is the current batch being returned? */
+	bool		outerNodeDone;	/* has the outer node been exhausted? */
+	void	   *tuplesortstate; /* private state of tuplesort.c */
+	ExprState  *eqfunction;		/* compares presorted columns */
+	TupleTableSlot *group_pivot;	/* see above */
+	int64		groupsCount;	/* number of batches sorted */
+	TuplesortInstrumentation sinstrument;	/* stats of the largest batch */
+} IncrementalSortState;
+
 /* ---------------------
  *	GroupState information
  * ---------------------
@@ -2016,6 +2170,21 @@ typedef struct AggState
 	AggStatePerGroup *all_pergroups;	/* array of first ->pergroups, than
 										 * ->hash_pergroup */
 	ProjectionInfo *combinedproj;	/* projection machinery */
+
+	/* these fields are used to spill hashed aggregation to disk: */
+	bool		hash_spill_mode;	/* don't create new groups, spill their
+									 * input tuples instead */
+	bool		hash_ever_spilled;	/* ever spilled during this execution? */
+	Size		hash_mem_limit; /* memory limit before spilling */
+	double		hashentrysize;	/* estimated memory per group */
+	uint64		hash_ngroups_current;	/* groups now in memory */
+	struct HashAggSpill *hash_spills;	/* spill state for each hashed
+										 * grouping set, first pass only */
+	List	   *hash_batches;	/* spilled batches still to be processed */
+	TupleTableSlot *hash_spill_rslot;	/* for reading spill files */
+	int			hash_batches_used;	/* passes over the hash table so far */
+	Size		hash_mem_peak;	/* peak hash table memory usage */
+	uint64		hash_disk_used; /* bytes written to spill files */
 } AggState;
 
 /* ----------------
@@ -2213,6 +2382,8 @@ typedef struct HashState
 
 	/* Parallel hash state. */
 	struct ParallelHashJoinState *parallel_state;
+
+	bool		build_runtime_filter;	/* also build a Bloom filter? */
 } HashState;
 
 /* ----------------
@@ -3152,7 +3152,8 @@ typedef enum VacuumOption
 	VACOPT_FULL = 1 << 4,		/* FULL (non-concurrent) vacuum */
 	VACOPT_SKIP_LOCKED = 1 << 5,	/* skip if cannot get lock */
 	VACOPT_SKIPTOAST = 1 << 6,	/* don't process the TOAST table, if any */
-	VACOPT_DISABLE_PAGE_SKIPPING = 1 << 7	/* don't skip any pages */
+	VACOPT_DISABLE_PAGE_SKIPPING = 1 << 7,	/* don't skip any pages */
+	VACOPT_SKIP_UNCHANGED = 1 << 8	/* skip unmodified partitions */
 } VacuumOption;
 
 /*
@@ -3174,6 +3175,8 @@ typedef struct VacuumStmt
 {
 	NodeTag		type;
 	int			options;		/* OR of VacuumOption flags */
+	int			nworkers;		/* # of workers for index vacuuming, 0 to
+								 * choose automatically, -1 for none */
 	List	   *rels;			/* list of VacuumRelation, or NIL for all */
 } VacuumStmt;
 
@@ -87,6 +87,14 @@ typedef struct PlannedStmt
 
 	List	   *paramExecTypes; /* type OIDs for PARAM_EXEC Params */
 
+	/*
+	 * PartitionPruneInfos whose initial pruning can be done before locking,
+	 * and the RT indexes of the leaf partitions they may prune; those are
+	 * only locked if they survive pruning.
+	 */
+	List	   *partPruneInfos;
+	Bitmapset  *prunableRelids;
+
 	Node	   *utilityStmt;	/* non-null if this is utility stmt */
 
 	/* statement location in source string (copied from Query) */
@@ -392,6 +400,8 @@ typedef struct SampleScan
  *
  * indexorderdir specifies the scan ordering, for indexscans on amcanorder
  * indexes (for other indexes it should be "don't care").
+ *
+ * indexskip requests a skip scan from the index AM, see IndexPath.
  * ----------------
  */
 typedef struct IndexScan
@@ -404,6 +414,7 @@ typedef struct IndexScan
 	List	   *indexorderbyorig;	/* the same in original form */
 	List	   *indexorderbyops;	/* OIDs of sort ops for ORDER BY exprs */
 	ScanDirection indexorderdir;	/* forward or backward or don't care */
+	bool		indexskip;		/* skip scan over the first column? */
 } IndexScan;
 
 /* ----------------
@@ -431,6 +442,7 @@ typedef struct IndexOnlyScan
 	List	   *indexorderby;	/* list of index ORDER BY exprs */
 	List	   *indextlist;		/* TargetEntry list describing index's cols */
 	ScanDirection indexorderdir;	/* forward or backward or don't care */
+	bool		indexskip;		/* skip scan over the first column? */
 } IndexOnlyScan;
 
 /* ----------------
@@ -720,6 +732,8 @@ typedef struct MergeJoin
 {
 	Join		join;
 	bool		skip_mark_restore;	/* Can we skip mark/restore calls? */
+	int			skipParam;		/* PARAM_EXEC ID used to re-seek the inner
+								 * index scan, or -1 */
 	List	   *mergeclauses;	/* mergeclauses as expression trees */
 	/* these are arrays, but have the same length as the mergeclauses list: */
 	Oid		   *mergeFamilies;	/* per-clause OIDs of btree opfamilies */
@@ -747,6 +761,25 @@ typedef struct Material
 	Plan		plan;
 } Material;
 
+/* ----------------
+ *		result cache node
+ *
+ * Caches the output of the inner side of a parameterized nestloop, keyed
+ * by the values of param_exprs.  If any other parameter that the subplan
+ * depends on changes, the cache is emptied.
+ * ----------------
+ */
+typedef struct ResultCache
+{
+	Plan		plan;
+	int			numKeys;		/* size of the cache key */
+	List	   *param_exprs;	/* exprs containing the cache key params */
+	bool		singlerow;		/* true if the cache entry is complete after
+								 * caching its first tuple */
+	uint32		est_entries;	/* estimated number of cache entries */
+	Bitmapset  *keyparamids;	/* paramids of the params in param_exprs */
+} ResultCache;
+
 /* ----------------
  *		sort node
  * ----------------
@@ -761,6 +794,19 @@ typedef struct Sort
 	bool	   *nullsFirst;		/* NULLS FIRST/LAST directions */
 } Sort;
 
+/* ----------------
+ *		incremental sort node
+ *
+ * The input is known to be sorted already on the first presortedCols sort
+ * keys, so only runs of tuples sharing those keys need to be sorted.
+ * ----------------
+ */
+typedef struct IncrementalSort
+{
+	Sort		sort;
+	int			presortedCols;	/* number of presorted columns */
+} IncrementalSort;
+
 /* ---------------
  *	 group node -
  *		Used for queries with GROUP BY (but no aggregates) specified.
@@ -1073,12 +1119,17 @@ typedef struct PlanRowMark
  * other_subplans		Indexes of any subplans that are not accounted for
  *						by any of the PartitionedRelPruneInfo nodes in
  *						"prune_infos".  These subplans must not be pruned.
+ * prune_before_locking	True if initial pruning can be done before the
+ *						executor locks are taken for a cached plan, because
+ *						its result depends only on external Params.  See
+ *						AcquireExecutorLocks().
  */
 typedef struct PartitionPruneInfo
 {
 	NodeTag		type;
 	List	   *prune_infos;
 	Bitmapset  *other_subplans;
+	bool		prune_before_locking;
 } PartitionPruneInfo;
 
 /*
@@ -1096,6 +1147,8 @@ typedef struct PartitionPruneInfo
  * it is -1 if the partition is a leaf or has been pruned.  Note that subplan
  * indexes, as stored in 'subplan_map', are global across the parent plan
  * node, but partition indexes are valid only within a particular hierarchy.
+ * leafpart_rti_map[p] holds the RT index of leaf partition p if it has a
+ * subplan, else 0.
  */
 typedef struct PartitionedRelPruneInfo
 {
@@ -1108,6 +1161,7 @@ typedef struct PartitionedRelPruneInfo
 	int			nexprs;			/* Length of hasexecparam[] */
 	int		   *subplan_map;	/* subplan index by partition index, or -1 */
 	int		   *subpart_map;	/* subpart index by partition index, or -1 */
+	int		   *leafpart_rti_map;	/* RT index by partition index, or 0 */
 	bool	   *hasexecparam;	/* true if corresponding pruning_step contains
 								 * any PARAM_EXEC Params. */
 	bool		do_initial_prune;	/* true if pruning should be performed
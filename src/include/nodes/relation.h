@@ -129,6 +129,11 @@ typedef struct PlannerGlobal
 
 	List	   *paramExecTypes; /* type OIDs for PARAM_EXEC Params */
 
+	List	   *partPruneInfos; /* "flat" list of PartitionPruneInfos that can
+								 * prune before locking */
+
+	Bitmapset  *prunableRelids; /* RT indexes of leaf partitions they cover */
+
 	Index		lastPHId;		/* highest PlaceHolderVar ID assigned */
 
 	Index		lastRowMarkId;	/* highest PlanRowMark ID assigned */
@@ -811,6 +816,7 @@ typedef struct IndexOptInfo
 	bool		amhasgettuple;	/* does AM have amgettuple interface? */
 	bool		amhasgetbitmap; /* does AM have amgetbitmap interface? */
 	bool		amcanparallel;	/* does AM support parallel scan? */
+	bool		amcanskip;		/* can AM skip over first column values? */
 	/* Rather than include amapi.h here, we declare amcostestimate like this */
 	void		(*amcostestimate) ();	/* AM's cost estimator */
 } IndexOptInfo;
@@ -1156,6 +1162,11 @@ typedef struct Path
  * NoMovementScanDirection for an indexscan, but the planner wants to
  * distinguish ordered from unordered indexes for building pathkeys.)
  *
+ * 'indexskip' is true for a skip scan, which steps through the distinct
+ * values of the first index column and does a separate search of the
+ * indexquals for each.  It is only used when the first column has no
+ * indexquals of its own.
+ *
  * 'indextotalcost' and 'indexselectivity' are saved in the IndexPath so that
  * we need not recompute them when considering using the same index in a
  * bitmap index/heap scan (see BitmapHeapPath).  The costs of the IndexPath
@@ -1172,6 +1183,7 @@ typedef struct IndexPath
 	List	   *indexorderbys;
 	List	   *indexorderbycols;
 	ScanDirection indexscandir;
+	bool		indexskip;
 	Cost		indextotalcost;
 	Selectivity indexselectivity;
 } IndexPath;
@@ -1369,6 +1381,25 @@ typedef struct MaterialPath
 	Path	   *subpath;
 } MaterialPath;
 
+/*
+ * ResultCachePath represents a ResultCache plan node, i.e., a cache of the
+ * results of a parameterized subpath, keyed by the parameter values.  This
+ * is used for the inner side of a nestloop whose outer side has many
+ * repeated join key values.
+ */
+typedef struct ResultCachePath
+{
+	Path		path;
+	Path	   *subpath;		/* outerpath to cache tuples from */
+	List	   *param_exprs;	/* cache keys */
+	bool		singlerow;		/* true if the cache entry is to be marked as
+								 * complete after caching the first record. */
+	double		calls;			/* expected number of rescans */
+	uint32		est_entries;	/* The maximum number of entries that the
+								 * planner expects will fit in the cache, or 0
+								 * if unknown */
+} ResultCachePath;
+
 /*
  * UniquePath represents elimination of distinct rows from the output of
  * its subpath.
@@ -1487,6 +1518,11 @@ typedef JoinPath NestPath;
  *
  * materialize_inner is true if a Material node should be placed atop the
  * inner input.  This may appear with or without an inner Sort step.
+ *
+ * skip_inner is true if the inner input is a btree index scan that the
+ * executor should re-seek forward to the current outer key, rather than
+ * stepping over long runs of non-matching inner tuples one at a time.
+ * This is never set together with materialize_inner.
  */
 
 typedef struct MergePath
@@ -1497,6 +1533,7 @@ typedef struct MergePath
 	List	   *innersortkeys;	/* keys for explicit sort, if any */
 	bool		skip_mark_restore;	/* can executor skip mark/restore? */
 	bool		materialize_inner;	/* add Materialize to inner? */
+	bool		skip_inner;		/* re-seek inner index scan forward? */
 } MergePath;
 
 /*
@@ -1562,6 +1599,16 @@ typedef struct SortPath
 	Path	   *subpath;		/* path representing input source */
 } SortPath;
 
+/*
+ * IncrementalSortPath represents a sort step whose input is already sorted
+ * on a leading subset of the required pathkeys
+ */
+typedef struct IncrementalSortPath
+{
+	SortPath	spath;
+	int			presortedCols;	/* number of presorted columns */
+} IncrementalSortPath;
+
 /*
  * GroupPath represents grouping (of presorted input)
  *
@@ -59,6 +59,8 @@ extern void tbm_add_page(TIDBitmap *tbm, BlockNumber pageno);
 
 extern void tbm_union(TIDBitmap *a, const TIDBitmap *b);
 extern void tbm_intersect(TIDBitmap *a, const TIDBitmap *b);
+extern dsa_pointer tbm_export(const TIDBitmap *tbm, dsa_area *dsa);
+extern void tbm_union_exported(TIDBitmap *a, dsa_area *dsa, dsa_pointer dp);
 
 extern bool tbm_is_empty(const TIDBitmap *tbm);
 
@@ -32,6 +32,9 @@ extern void SS_finalize_plan(PlannerInfo *root, Plan *plan);
 extern Param *SS_make_initplan_output_param(PlannerInfo *root,
 							  Oid resulttype, int32 resulttypmod,
 							  Oid resultcollation);
+extern Param *SS_make_runtime_param(PlannerInfo *root,
+					  Oid paramtype, int32 paramtypmod,
+					  Oid paramcollation);
 extern void SS_make_initplan_from_plan(PlannerInfo *root,
 						   PlannerInfo *subroot, Plan *plan,
 						   Param *prm);
@@ -87,6 +87,10 @@ extern bool partition_bounds_equal(int partnatts, int16 *parttyplen,
 					   PartitionBoundInfo b2);
 extern PartitionBoundInfo partition_bounds_copy(PartitionBoundInfo src,
 					  PartitionKey key);
+extern int *partition_bounds_nested_map(int partnatts, FmgrInfo *partsupfunc,
+							Oid *partcollation,
+							PartitionBoundInfo b1, int nparts1,
+							PartitionBoundInfo b2);
 extern void check_new_partition_bound(char *relname, Relation parent,
 						  PartitionBoundSpec *spec);
 extern void check_default_partition_contents(Relation parent,
@@ -0,0 +1,148 @@
+/*-------------------------------------------------------------------------
+ *
+ * simd.h
+ *	  Scanning of byte strings for a few interesting byte values, 16 bytes
+ *	  at a time where the platform allows.
+ *
+ * Parsers such as COPY spend much of their time stepping over ordinary
+ * bytes on the way to the next delimiter, quote or line break.  The
+ * functions here find the first byte of a buffer that is one of a handful
+ * of given values, using SSE2 on x86-64 and Advanced SIMD on AArch64.
+ * Both are part of the base instruction set of those architectures, so no
+ * runtime check is required.  Elsewhere we fall back to a plain loop.
+ *
+ * These are meant for byte values that are ASCII; callers dealing with
+ * client encodings whose multibyte characters can contain ASCII bytes must
+ * not use them, for the same reasons they can't simply look at one byte at
+ * a time.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/port/simd.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef SIMD_H
+#define SIMD_H
+
+#if defined(__x86_64__) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define USE_SSE2
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define USE_NEON
+#endif
+
+/*
+ * Return the offset of the first byte in s[0 .. len - 1] that equals c1,
+ * c2, c3 or c4, or len if there is none.  Callers looking for fewer values
+ * can pass some of them more than once.
+ */
+static inline int
+pg_find_bytes(const char *s, int len, char c1, char c2, char c3, char c4)
+{
+	int			i = 0;
+
+#if defined(USE_SSE2)
+	const __m128i v1 = _mm_set1_epi8(c1);
+	const __m128i v2 = _mm_set1_epi8(c2);
+	const __m128i v3 = _mm_set1_epi8(c3);
+	const __m128i v4 = _mm_set1_epi8(c4);
+
+	for (; i + 16 <= len; i += 16)
+	{
+		__m128i		chunk = _mm_loadu_si128((const __m128i *) (s + i));
+		__m128i		match;
+
+		match = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, v1),
+										  _mm_cmpeq_epi8(chunk, v2)),
+							 _mm_or_si128(_mm_cmpeq_epi8(chunk, v3),
+										  _mm_cmpeq_epi8(chunk, v4)));
+		if (_mm_movemask_epi8(match) != 0)
+			break;				/* find the exact position below */
+	}
+#elif defined(USE_NEON)
+	const uint8x16_t v1 = vdupq_n_u8((uint8) c1);
+	const uint8x16_t v2 = vdupq_n_u8((uint8) c2);
+	const uint8x16_t v3 = vdupq_n_u8((uint8) c3);
+	const uint8x16_t v4 = vdupq_n_u8((uint8) c4);
+
+	for (; i + 16 <= len; i += 16)
+	{
+		uint8x16_t	chunk = vld1q_u8((const uint8 *) (s + i));
+		uint8x16_t	match;
+
+		match = vorrq_u8(vorrq_u8(vceqq_u8(chunk, v1), vceqq_u8(chunk, v2)),
+						 vorrq_u8(vceqq_u8(chunk, v3), vceqq_u8(chunk, v4)));
+		if (vmaxvq_u8(match) != 0)
+			break;				/* find the exact position below */
+	}
+#endif
+
+	for (; i < len; i++)
+	{
+		char		c = s[i];
+
+		if (c == c1 || c == c2 || c == c3 || c == c4)
+			break;
+	}
+
+	return i;
+}
+
+/*
+ * Like pg_find_bytes, but look for c1, c2 or any ASCII control character,
+ * that is any byte below 0x20.
+ */
+static inline int
+pg_find_bytes_or_control(const char *s, int len, char c1, char c2)
+{
+	int			i = 0;
+
+#if defined(USE_SSE2)
+	const __m128i v1 = _mm_set1_epi8(c1);
+	const __m128i v2 = _mm_set1_epi8(c2);
+	const __m128i vctl = _mm_set1_epi8(0x1F);
+
+	for (; i + 16 <= len; i += 16)
+	{
+		__m128i		chunk = _mm_loadu_si128((const __m128i *) (s + i));
+		__m128i		match;
+
+		/* there's no unsigned compare, but x <= 0x1F iff max(x, 0x1F) = 0x1F */
+		match = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, v1),
+										  _mm_cmpeq_epi8(chunk, v2)),
+							 _mm_cmpeq_epi8(_mm_max_epu8(chunk, vctl), vctl));
+		if (_mm_movemask_epi8(match) != 0)
+			break;				/* find the exact position below */
+	}
+#elif defined(USE_NEON)
+	const uint8x16_t v1 = vdupq_n_u8((uint8) c1);
+	const uint8x16_t v2 = vdupq_n_u8((uint8) c2);
+	const uint8x16_t vctl = vdupq_n_u8(0x20);
+
+	for (; i + 16 <= len; i += 16)
+	{
+		uint8x16_t	chunk = vld1q_u8((const uint8 *) (s + i));
+		uint8x16_t	match;
+
+		match = vorrq_u8(vorrq_u8(vceqq_u8(chunk, v1), vceqq_u8(chunk, v2)),
+						 vcltq_u8(chunk, vctl));
+		if (vmaxvq_u8(match) != 0)
+			break;				/* find the exact position below */
+	}
+#endif
+
+	for (; i < len; i++)
+	{
+		char		c = s[i];
+
+		if (c == c1 || c == c2 || (unsigned char) c < (unsigned char) 0x20)
+			break;
+	}
+
+	return i;
+}
+
+#endif							/* SIMD_H */
@@ -22,7 +22,9 @@
  */
 typedef enum
 {
-	AVW_BRINSummarizeRange
+	AVW_BRINSummarizeRange,
+	AVW_GINCleanupPendingList,
+	AVW_HeapPrunePage
 } AutoVacuumWorkItemType;
 
 
@@ -30,9 +32,12 @@ typedef enum
 extern bool autovacuum_start_daemon;
 extern int	autovacuum_max_workers;
 extern int	autovacuum_work_mem;
+extern int	autovacuum_max_parallel_workers;
 extern int	autovacuum_naptime;
 extern int	autovacuum_vac_thresh;
+extern int	autovacuum_vac_ins_thresh;
 extern double autovacuum_vac_scale;
+extern double autovacuum_vac_ins_scale;
 extern int	autovacuum_anl_thresh;
 extern double autovacuum_anl_scale;
 extern int	autovacuum_freeze_max_age;
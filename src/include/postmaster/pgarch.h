@@ -26,6 +26,17 @@
 #define MAX_XFN_CHARS	40
 #define VALID_XFN_CHARS "0123456789ABCDEF.history.backup.partial"
 
+/*
+ * Hook for archiving a file in-process, for a library loaded with
+ * shared_preload_libraries.  It is called in the archiver process, instead of
+ * running archive_command, with the file's name and its path relative to the
+ * data directory, and returns true once the file is safely archived.  It
+ * should report failure by returning false rather than throwing an error,
+ * which would make the archiver exit.
+ */
+typedef bool (*archive_file_hook_type) (const char *file, const char *path);
+extern PGDLLIMPORT archive_file_hook_type archive_file_hook;
+
 /* ----------
  * Functions called from postmaster
  * ----------
@@ -20,6 +20,24 @@
 #define MAX_RATE_LOWER	32
 #define MAX_RATE_UPPER	1048576
 
+/*
+ * With the INCREMENTAL option, relation files that may be largely unchanged
+ * are sent as incremental files, under the name of the file with
+ * INCREMENTAL_PREFIX prepended to its last component.  An incremental file
+ * holds, in network byte order,
+ *
+ *	uint32	INCREMENTAL_MAGIC
+ *	uint32	number of blocks included
+ *	uint32	length of the file, in blocks
+ *	uint32	block numbers of the blocks included, in ascending order
+ *
+ * followed by the contents of those blocks, BLCKSZ bytes each.  The blocks
+ * not included have not changed since the incremental LSN, and are to be
+ * taken from a backup that was started at or before it.
+ */
+#define INCREMENTAL_PREFIX	"INCREMENTAL."
+#define INCREMENTAL_MAGIC	0xd3ae1f0d
+
 
 typedef struct
 {
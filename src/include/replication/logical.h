@@ -55,6 +55,14 @@ typedef struct LogicalDecodingContext
 	OutputPluginCallbacks callbacks;
 	OutputPluginOptions options;
 
+	/*
+	 * Does the output plugin support streaming of in-progress transactions,
+	 * and is it enabled?  Initialized based on the callbacks provided by the
+	 * plugin, which may then disable it in its startup callback, e.g. unless
+	 * the client asked for streaming.
+	 */
+	bool		streaming;
+
 	/*
 	 * User specified options
 	 */
@@ -25,6 +25,11 @@ typedef struct PGOutputData
 
 	List	   *publication_names;
 	List	   *publications;
+	bool		streaming;		/* may in-progress transactions be sent? */
+	bool		binary;			/* send data in binary format if possible? */
+
+	/* are we in the middle of a block of changes of a streamed xact? */
+	bool		in_streaming;
 } PGOutputData;
 
 #endif							/* PGOUTPUT_H */
@@ -14,6 +14,7 @@
 
 #include "access/xlog.h"
 #include "access/xlogdefs.h"
+#include "common/replcompress.h"
 #include "fmgr.h"
 #include "getaddrinfo.h"		/* for NI_MAXHOST */
 #include "replication/logicalproto.h"
@@ -27,6 +28,8 @@
 extern int	wal_receiver_status_interval;
 extern int	wal_receiver_timeout;
 extern bool hot_standby_feedback;
+extern bool hot_standby_feedback_per_database;
+extern int	wal_receiver_compression;
 
 /*
  * MAXCONNINFO: maximum size of a connection string.
@@ -158,11 +161,14 @@ typedef struct
 		struct
 		{
 			TimeLineID	startpointTLI;	/* Starting timeline */
+			ReplCompressionMethod compression;	/* Compression of WAL data */
 		}			physical;
 		struct
 		{
 			uint32		proto_version;	/* Logical protocol version */
 			List	   *publication_names;	/* String list of publications */
+			bool		streaming;	/* Stream in-progress transactions */
+			bool		binary;	/* Ask for data in binary format */
 		}			logical;
 	}			proto;
 } WalRcvStreamOptions;
@@ -13,6 +13,7 @@
 #define _WALSENDER_PRIVATE_H
 
 #include "access/xlog.h"
+#include "common/replcompress.h"
 #include "nodes/nodes.h"
 #include "replication/syncrep.h"
 #include "storage/latch.h"
@@ -60,6 +61,15 @@ typedef struct WalSnd
 	TimeOffset	flushLag;
 	TimeOffset	applyLag;
 
+	/*
+	 * Compression of the streamed WAL requested by the standby, and the
+	 * number of bytes of WAL sent and of bytes actually put on the wire for
+	 * them.
+	 */
+	ReplCompressionMethod compression;
+	uint64		rawBytes;
+	uint64		wireBytes;
+
 	/* Protects shared variables shown above. */
 	slock_t		mutex;
 
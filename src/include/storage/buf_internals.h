@@ -309,8 +309,11 @@ extern void ScheduleBufferTagForWriteback(WritebackContext *context, BufferTag *
 extern BufferDesc *StrategyGetBuffer(BufferAccessStrategy strategy,
 				  uint32 *buf_state);
 extern void StrategyFreeBuffer(BufferDesc *buf);
+extern void StrategyPushCleanBuffer(BufferDesc *buf);
+extern int	StrategyFreeListLength(void);
 extern bool StrategyRejectBuffer(BufferAccessStrategy strategy,
 					 BufferDesc *buf);
+extern BufferAccessStrategyType StrategyGetType(BufferAccessStrategy strategy);
 
 extern int	StrategySyncStart(uint32 *complete_passes, uint32 *num_buf_alloc);
 extern void StrategyNotifyBgWriter(int bgwprocno);
@@ -114,6 +114,16 @@ typedef union
 	uint32		data[BLCKSZ / (sizeof(uint32) * N_SUMS)][N_SUMS];
 } PGChecksummablePage;
 
+/*
+ * The file including this one may define PG_CHECKSUM_BLOCK_HOOK as the name
+ * of a function computing the same result as pg_checksum_block, for example
+ * an implementation chosen at runtime for the CPU in use.  It must then
+ * supply a definition of that function.
+ */
+#ifdef PG_CHECKSUM_BLOCK_HOOK
+static uint32 PG_CHECKSUM_BLOCK_HOOK(const PGChecksummablePage *page);
+#endif
+
 /*
  * Base offsets to initialize each of the parallel FNV hashes into a
  * different initial state.
@@ -201,7 +211,11 @@ pg_checksum_page(char *page, BlockNumber blkno)
 	 */
 	save_checksum = cpage->phdr.pd_checksum;
 	cpage->phdr.pd_checksum = 0;
+#ifdef PG_CHECKSUM_BLOCK_HOOK
+	checksum = PG_CHECKSUM_BLOCK_HOOK(cpage);
+#else
 	checksum = pg_checksum_block(cpage);
+#endif
 	cpage->phdr.pd_checksum = save_checksum;
 
 	/* Mix in the block number to detect transposed pages */
@@ -0,0 +1,34 @@
+/*-------------------------------------------------------------------------
+ *
+ * doublewrite.h
+ *	  Double-write buffer protecting data pages against torn writes.
+ *
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/storage/doublewrite.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef DOUBLEWRITE_H
+#define DOUBLEWRITE_H
+
+#include "storage/block.h"
+#include "storage/relfilenode.h"
+
+/* GUC variable */
+extern PGDLLIMPORT bool double_write;
+
+extern Size DoubleWriteShmemSize(void);
+extern void DoubleWriteShmemInit(void);
+extern void DoubleWriteStartup(bool restore);
+
+extern void DoubleWriteBeginPage(RelFileNode rnode, ForkNumber forknum,
+					 BlockNumber blkno, const char *page);
+extern void DoubleWriteEndPage(void);
+
+extern void DoubleWriteStartCheckpoint(void);
+extern void DoubleWriteEndCheckpoint(void);
+
+#endif							/* DOUBLEWRITE_H */
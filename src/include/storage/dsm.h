@@ -32,6 +32,8 @@ extern void dsm_detach_all(void);
 #ifdef EXEC_BACKEND
 extern void dsm_set_control_handle(dsm_handle h);
 #endif
+extern Size dsm_estimate_size(void);
+extern void dsm_shmem_init(void);
 
 /* Functions that create or remove mappings. */
 extern dsm_segment *dsm_create(Size size, int flags);
@@ -38,8 +38,9 @@
 #define USE_DSM_MMAP
 #endif
 
-/* GUC. */
+/* GUCs. */
 extern int	dynamic_shared_memory_type;
+extern int	min_dynamic_shared_memory;
 
 /*
  * Directory for on-disk state.
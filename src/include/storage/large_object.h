@@ -26,6 +26,8 @@
  * subid is the subtransaction that opened the desc (or currently owns it)
  * offset is the current seek offset within the LO
  * flags contains some flag bits
+ * readbuf, if not NULL, holds readbuf_len bytes of the LO starting at offset
+ * readbuf_offset, read ahead for a read-only descriptor (see inv_read)
  *
  * NOTE: as of v11, permission checks are made when the large object is
  * opened; therefore IFS_RDLOCK/IFS_WRLOCK indicate that read or write mode
@@ -48,6 +50,9 @@ typedef struct LargeObjectDesc
 #define IFS_RDLOCK		(1 << 0)	/* LO was opened for reading */
 #define IFS_WRLOCK		(1 << 1)	/* LO was opened for writing */
 
+	char	   *readbuf;		/* read-ahead buffer, or NULL */
+	uint64		readbuf_offset; /* LO offset of readbuf's first byte */
+	int			readbuf_len;	/* number of valid bytes in readbuf */
 } LargeObjectDesc;
 
 
@@ -116,8 +116,12 @@ extern PGDLLIMPORT int NamedLWLockTrancheRequests;
 #define LOG2_NUM_LOCK_PARTITIONS  4
 #define NUM_LOCK_PARTITIONS  (1 << LOG2_NUM_LOCK_PARTITIONS)
 
-/* Number of partitions the shared predicate lock tables are divided into */
-#define LOG2_NUM_PREDICATELOCK_PARTITIONS  4
+/*
+ * Number of partitions the shared predicate lock tables are divided into.
+ * Every tuple, page and relation read by a serializable transaction takes
+ * one of these locks, so we use more than for the regular lock manager.
+ */
+#define LOG2_NUM_PREDICATELOCK_PARTITIONS  6
 #define NUM_PREDICATELOCK_PARTITIONS  (1 << LOG2_NUM_PREDICATELOCK_PARTITIONS)
 
 /* Offsets for various chunks of preallocated lwlocks. */
@@ -158,6 +162,8 @@ extern void LWLockUpdateVar(LWLock *lock, uint64 *valptr, uint64 value);
 extern Size LWLockShmemSize(void);
 extern void CreateLWLocks(void);
 extern void InitLWLockAccess(void);
+extern Size LWLockStatsShmemSize(void);
+extern void LWLockStatsShmemInit(void);
 
 extern const char *GetLWLockIdentifier(uint32 classId, uint16 eventId);
 
@@ -219,9 +225,33 @@ typedef enum BuiltinTrancheIds
 	LWTRANCHE_SHARED_TUPLESTORE,
 	LWTRANCHE_TBM,
 	LWTRANCHE_PARALLEL_APPEND,
+	LWTRANCHE_STATS_DSA,
+	LWTRANCHE_STATS_HASH,
 	LWTRANCHE_FIRST_USER_DEFINED
 }			BuiltinTrancheIds;
 
+/*
+ * Per-tranche LWLock statistics, as shown in pg_stat_lwlocks.  Builtin
+ * tranches each get their own slot; all user-defined tranches are counted
+ * together in LWLOCK_STATS_EXTENSION_SLOT.  wait_histogram[n] counts waits
+ * that took at least 2^n but less than 2^(n+1) microseconds; the first
+ * bucket also counts shorter waits, and the last one all longer waits.
+ */
+#define LWLOCK_STATS_EXTENSION_SLOT		LWTRANCHE_FIRST_USER_DEFINED
+#define LWLOCK_STATS_NUM_TRANCHES		(LWLOCK_STATS_EXTENSION_SLOT + 1)
+#define LWLOCK_STATS_WAIT_BUCKETS		16
+
+typedef struct LWLockTrancheStats
+{
+	uint64		acquires;		/* successful acquisitions */
+	uint64		waits;			/* times a process slept on the lock */
+	uint64		spin_delays;	/* spin delays on the wait list mutex */
+	uint64		wait_time;		/* total time slept, in microseconds */
+	uint64		wait_histogram[LWLOCK_STATS_WAIT_BUCKETS];
+} LWLockTrancheStats;
+
+extern void LWLockGetTrancheStats(int slot, LWLockTrancheStats *stats);
+
 /*
  * Prior to PostgreSQL 9.4, we used an enum type called LWLockId to refer
  * to LWLocks.  New code should instead use LWLock *.  However, for the
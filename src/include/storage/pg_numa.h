@@ -0,0 +1,49 @@
+/*-------------------------------------------------------------------------
+ *
+ * pg_numa.h
+ *	  Platform-independent API for NUMA placement of shared memory.
+ *
+ * On machines with more than one memory node, where a page of shared memory
+ * lives can matter as much as whether it is cached at all.  This file
+ * declares the small set of operations the rest of the backend needs to
+ * spread, or pin, ranges of the main shared memory segment over the memory
+ * nodes, and to find out where the pages of a range currently reside.  On
+ * platforms without NUMA support all of these report failure, and callers
+ * are expected to carry on with the operating system's default placement.
+ *
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/storage/pg_numa.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef PG_NUMA_H
+#define PG_NUMA_H
+
+/* Highest memory node number we are prepared to deal with, plus one */
+#define PG_NUMA_MAX_NODES	64
+
+/* Number of memory nodes, or 0 if NUMA placement is not supported */
+extern int	pg_numa_num_nodes(void);
+
+/* Size of the pages pg_numa_query_nodes() reports on */
+extern Size pg_numa_page_size(void);
+
+/* Spread the pages of a range round-robin over all memory nodes */
+extern bool pg_numa_interleave(void *ptr, Size size);
+
+/*
+ * Restrict the pages of a range to one memory node; "node" counts the nodes
+ * from 0 to pg_numa_num_nodes() - 1, which need not be their system numbers
+ */
+extern bool pg_numa_bind(void *ptr, Size size, int node);
+
+/*
+ * Report the system node number of each of "npages" pages starting at
+ * page-aligned "ptr"; pages not yet allocated are reported as -1.
+ */
+extern bool pg_numa_query_nodes(void *ptr, int npages, int *nodes);
+
+#endif							/* PG_NUMA_H */
@@ -52,8 +52,20 @@ typedef enum
 	HUGE_PAGES_TRY
 }			HugePagesType;
 
+/* GUC variable */
+extern int	numa_placement;
+
+/* Possible values for numa_placement */
+typedef enum
+{
+	NUMA_PLACEMENT_OFF,
+	NUMA_PLACEMENT_INTERLEAVE,
+	NUMA_PLACEMENT_BIND
+}			NumaPlacementType;
+
 #ifndef WIN32
 extern unsigned long UsedShmemSegID;
+extern bool UsedShmemHugePages;
 #else
 extern HANDLE UsedShmemSegID;
 #endif
@@ -68,5 +80,8 @@ extern PGShmemHeader *PGSharedMemoryCreate(Size size, bool makePrivate,
 					 int port, PGShmemHeader **shim);
 extern bool PGSharedMemoryIsInUse(unsigned long id1, unsigned long id2);
 extern void PGSharedMemoryDetach(void);
+#ifndef WIN32
+extern void GetHugePageSize(Size *hugepagesize, int *mmap_flags);
+#endif
 
 #endif							/* PG_SHMEM_H */
@@ -63,12 +63,22 @@ struct XidCache
 	(PROC_IN_VACUUM | PROC_IN_ANALYZE | PROC_VACUUM_FOR_WRAPAROUND)
 
 /*
- * We allow a small number of "weak" relation locks (AccesShareLock,
- * RowShareLock, RowExclusiveLock) to be recorded in the PGPROC structure
- * rather than the main lock table.  This eases contention on the lock
- * manager LWLocks.  See storage/lmgr/README for additional details.
+ * We allow a number of "weak" relation locks (AccesShareLock, RowShareLock,
+ * RowExclusiveLock) to be recorded in per-backend fast-path arrays rather
+ * than the main lock table.  This eases contention on the lock manager
+ * LWLocks.  See storage/lmgr/README for additional details.
+ *
+ * The slots are divided into groups of FP_LOCK_SLOTS_PER_GROUP, each with
+ * the lock modes packed into a single uint64; a relation can only ever be
+ * stored in the group its OID hashes to.  The number of groups is derived
+ * from max_locks_per_transaction at startup, see InitializeFastPathLocks().
  */
-#define		FP_LOCK_SLOTS_PER_BACKEND 16
+#define		FP_LOCK_GROUPS_PER_BACKEND_MAX	1024
+#define		FP_LOCK_SLOTS_PER_GROUP		16	/* 3 bits each, must fit a uint64 */
+#define		FP_LOCK_SLOTS_PER_BACKEND \
+	(FP_LOCK_SLOTS_PER_GROUP * FastPathLockGroupsPerBackend)
+
+extern PGDLLIMPORT int FastPathLockGroupsPerBackend;
 
 /*
  * An invalid pgprocno.  Must be larger than the maximum number of PGPROC
@@ -117,6 +127,14 @@ struct PGPROC
 	Oid			tempNamespaceId;	/* OID of temp schema this backend is
 									 * using */
 
+	/*
+	 * For a walsender relaying hot standby feedback without a replication
+	 * slot: OID of the only database whose standby queries the feedback xmin
+	 * protects, or InvalidOid if it applies to all databases.  See
+	 * GetOldestXmin.
+	 */
+	Oid			xminDatabaseId;
+
 	bool		isBackgroundWorker; /* true if background worker. */
 
 	/*
@@ -190,8 +208,9 @@ struct PGPROC
 	LWLock		backendLock;
 
 	/* Lock manager data, recording fast-path locks taken by this backend. */
-	uint64		fpLockBits;		/* lock modes held for each fast-path slot */
-	Oid			fpRelId[FP_LOCK_SLOTS_PER_BACKEND]; /* slots for rel oids */
+	uint64	   *fpLockBits;		/* lock modes held for each fast-path slot,
+								 * one word per group */
+	Oid		   *fpRelId;		/* slots for rel oids */
 	bool		fpVXIDLock;		/* are we holding a fast-path VXID lock? */
 	LocalTransactionId fpLocalTransactionId;	/* lxid for fast-path VXID
 												 * lock */
@@ -0,0 +1,46 @@
+/*-------------------------------------------------------------------------
+ *
+ * read_stream.h
+ *	  Look-ahead reading of a stream of relation blocks.
+ *
+ * A ReadStream sits between a consumer that reads a predictable sequence of
+ * blocks (a sequential scan, ANALYZE's block sampler, VACUUM's heap pass)
+ * and the buffer manager.  The consumer supplies a callback that generates
+ * block numbers; the stream calls it ahead of time and issues prefetch
+ * advice for up to a tablespace-dependent number of blocks beyond the one
+ * being consumed, so that the kernel can have those reads in flight while
+ * the consumer is busy with the current page.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/storage/read_stream.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef READ_STREAM_H
+#define READ_STREAM_H
+
+#include "storage/bufmgr.h"
+
+/* ReadStream is an opaque type whose details are not known outside read_stream.c. */
+typedef struct ReadStream ReadStream;
+
+/*
+ * Callback returning the next block number the consumer will want, or
+ * InvalidBlockNumber once the sequence is exhausted.
+ */
+typedef BlockNumber (*ReadStreamBlockNumberCB) (ReadStream *stream,
+												void *callback_private_data);
+
+extern ReadStream *read_stream_begin_relation(Relation rel,
+						   ForkNumber forknum,
+						   BufferAccessStrategy strategy,
+						   ReadStreamBlockNumberCB callback,
+						   void *callback_private_data);
+extern Buffer read_stream_next_buffer(ReadStream *stream);
+extern Buffer read_stream_get_buffer(ReadStream *stream, BlockNumber blocknum);
+extern void read_stream_reset(ReadStream *stream);
+extern void read_stream_end(ReadStream *stream);
+
+#endif							/* READ_STREAM_H */
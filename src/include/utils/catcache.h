@@ -63,10 +63,9 @@ typedef struct catcache
 											 * scans */
 
 	/*
-	 * Keep these at the end, so that compiling catcache.c with CATCACHE_STATS
-	 * doesn't break ABI for other modules
+	 * Statistics, reported by pg_catalog_cache_stats() and, if catcache.c is
+	 * compiled with CATCACHE_STATS, at backend exit
 	 */
-#ifdef CATCACHE_STATS
 	long		cc_searches;	/* total # searches against this cache */
 	long		cc_hits;		/* # of matches against existing entry */
 	long		cc_neg_hits;	/* # of matches against negative entry */
@@ -79,7 +78,8 @@ typedef struct catcache
 	long		cc_invals;		/* # of entries invalidated from cache */
 	long		cc_lsearches;	/* total # list-searches */
 	long		cc_lhits;		/* # of matches against existing lists */
-#endif
+	long		cc_evictions;	/* # of entries evicted to save memory */
+	Size		cc_memory;		/* space used by this cache's entries */
 } CatCache;
 
 
@@ -103,6 +103,13 @@ typedef struct catctup
 	 */
 	dlist_node	cache_elem;		/* list member of per-bucket list */
 
+	/*
+	 * All tuples in all caches are also members of a single dlist in LRU
+	 * order, which is used to pick entries to evict when the caches exceed
+	 * catalog_cache_memory.
+	 */
+	dlist_node	lru_elem;		/* list member of global LRU list */
+
 	/*
 	 * A tuple marked "dead" must not be returned by subsequent searches.
 	 * However, it won't be physically deleted from the cache until its
@@ -183,9 +190,14 @@ typedef struct catcacheheader
 {
 	slist_head	ch_caches;		/* head of list of CatCache structs */
 	int			ch_ntup;		/* # of tuples in all caches */
+	dlist_head	ch_lru;			/* all tuples, most recently used first */
+	Size		ch_memory;		/* space used by entries of all caches */
 } CatCacheHeader;
 
 
+/* GUC variable */
+extern int	catalog_cache_memory;
+
 /* this extern duplicates utils/memutils.h... */
 extern PGDLLIMPORT MemoryContext CacheMemoryContext;
 
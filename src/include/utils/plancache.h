@@ -19,6 +19,7 @@
 #include "lib/ilist.h"
 #include "nodes/params.h"
 #include "utils/queryenvironment.h"
+#include "utils/resowner.h"
 
 /* Forward declaration, to avoid including parsenodes.h here */
 struct RawStmt;
@@ -31,8 +32,9 @@ typedef enum
 	PLAN_CACHE_MODE_FORCE_CUSTOM_PLAN
 }			PlanCacheMode;
 
-/* GUC parameter */
+/* GUC parameters */
 extern int	plan_cache_mode;
+extern bool plan_cache_runtime_feedback;
 
 #define CACHEDPLANSOURCE_MAGIC		195726186
 #define CACHEDPLAN_MAGIC			953717834
@@ -128,6 +130,12 @@ typedef struct CachedPlanSource
 	double		generic_cost;	/* cost of generic plan, or -1 if not known */
 	double		total_custom_cost;	/* total cost of custom plans so far */
 	int			num_custom_plans;	/* number of plans included in total */
+	/* Measured run times, kept if plan_cache_runtime_feedback is on: */
+	double		generic_time;	/* avg msec per run of current generic plan */
+	double		custom_time;	/* avg msec per run of a custom plan,
+								 * including planning */
+	int			num_generic_runs;	/* number of runs included in generic_time */
+	int			num_custom_runs;	/* number of runs included in custom_time */
 } CachedPlanSource;
 
 /*
@@ -152,6 +160,8 @@ typedef struct CachedPlan
 	TransactionId saved_xmin;	/* if valid, replan when TransactionXmin
 								 * changes from this value */
 	int			generation;		/* parent's generation number for this plan */
+	bool		is_generic;		/* was it made as parent's generic plan? */
+	double		planning_time;	/* msec spent planning, if measured */
 	int			refcount;		/* count of live references to this struct */
 	MemoryContext context;		/* context containing this CachedPlan */
 } CachedPlan;
@@ -210,6 +220,13 @@ extern CachedPlanSource *CopyCachedPlan(CachedPlanSource *plansource);
 
 extern bool CachedPlanIsValid(CachedPlanSource *plansource);
 
+extern bool CachedPlanAllowsSimpleValidityCheck(CachedPlanSource *plansource,
+									CachedPlan *plan,
+									ResourceOwner owner);
+extern bool CachedPlanIsSimplyValid(CachedPlanSource *plansource,
+						CachedPlan *plan,
+						ResourceOwner owner);
+
 extern List *CachedPlanGetTargetList(CachedPlanSource *plansource,
 						QueryEnvironment *queryEnv);
 
@@ -218,6 +235,8 @@ extern CachedPlan *GetCachedPlan(CachedPlanSource *plansource,
 			  bool useResOwner,
 			  QueryEnvironment *queryEnv);
 extern void ReleaseCachedPlan(CachedPlan *plan, bool useResOwner);
+extern void CachedPlanRecordRuntime(CachedPlanSource *plansource,
+						CachedPlan *plan, double msecs);
 
 extern CachedExpression *GetCachedExpression(Node *expr);
 extern void FreeCachedExpression(CachedExpression *cexpr);
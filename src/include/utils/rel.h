@@ -239,6 +239,7 @@ typedef struct AutoVacOpts
 {
 	bool		enabled;
 	int			vacuum_threshold;
+	int			vacuum_ins_threshold;
 	int			analyze_threshold;
 	int			vacuum_cost_delay;
 	int			vacuum_cost_limit;
@@ -250,6 +251,7 @@ typedef struct AutoVacOpts
 	int			multixact_freeze_table_age;
 	int			log_min_duration;
 	float8		vacuum_scale_factor;
+	float8		vacuum_ins_scale_factor;
 	float8		analyze_scale_factor;
 } AutoVacOpts;
 
@@ -263,6 +265,7 @@ typedef struct StdRdOptions
 	AutoVacOpts autovacuum;		/* autovacuum-related options */
 	bool		user_catalog_table; /* use as an additional catalog relation */
 	int			parallel_workers;	/* max number of parallel workers */
+	bool		deduplicate_items;	/* merge duplicates in btree leaf pages */
 } StdRdOptions;
 
 #define HEAP_MIN_FILLFACTOR			10
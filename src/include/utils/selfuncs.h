@@ -125,6 +125,9 @@ typedef struct
  * Callers should initialize all fields of GenericCosts to zero.  In addition,
  * they can set numIndexTuples to some positive value if they have a better
  * than default way of estimating the number of leaf index tuples visited.
+ * Likewise, they can set num_sa_scans to the number of index searches made
+ * for other reasons than ScalarArrayOps, such as the groups of a skip scan;
+ * the ScalarArrayOps' own searches are multiplied into it.
  */
 typedef struct
 {
@@ -138,7 +141,7 @@ typedef struct
 	double		numIndexPages;	/* number of leaf pages visited */
 	double		numIndexTuples; /* number of leaf tuples visited */
 	double		spc_random_page_cost;	/* relevant random_page_cost value */
-	double		num_sa_scans;	/* # indexscans from ScalarArrayOps */
+	double		num_sa_scans;	/* # indexscans from ScalarArrayOps, etc */
 } GenericCosts;
 
 /* Hooks for plugins to get control when we ask for stats */
@@ -209,6 +209,10 @@ extern Tuplesortstate *tuplesort_begin_index_hash(Relation heapRel,
 						   uint32 max_buckets,
 						   int workMem, SortCoordinate coordinate,
 						   bool randomAccess);
+extern Tuplesortstate *tuplesort_begin_index_gist(Relation heapRel,
+						   Relation indexRel,
+						   int workMem, SortCoordinate coordinate,
+						   bool randomAccess);
 extern Tuplesortstate *tuplesort_begin_datum(Oid datumType,
 					  Oid sortOperator, Oid sortCollation,
 					  bool nullsFirstFlag,
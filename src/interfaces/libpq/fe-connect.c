@@ -361,6 +361,7 @@ static PGconn *makeEmptyPGconn(void);
 static bool fillPGconn(PGconn *conn, PQconninfoOption *connOptions);
 static void freePGconn(PGconn *conn);
 static void closePGconn(PGconn *conn);
+static void pqFreeCommandQueue(PGcmdQueueEntry *queue);
 static void release_conn_addrinfo(PGconn *conn);
 static void sendTerminateConn(PGconn *conn);
 static PQconninfoOption *conninfo_init(PQExpBuffer errorMessage);
@@ -2274,7 +2275,10 @@ keep_going:						/* We will come back to here until there is
 		/* Drop any PGresult we might have, too */
 		conn->asyncStatus = PGASYNC_IDLE;
 		conn->xactStatus = PQTRANS_IDLE;
+		conn->pipelineStatus = PQ_PIPELINE_OFF;
 		pqClearAsyncResult(conn);
+		pqFreeCommandQueue(conn->cmd_queue_head);
+		conn->cmd_queue_head = conn->cmd_queue_tail = NULL;
 
 		/* Reset conn->status to put the state machine in the right state */
 		conn->status = CONNECTION_NEEDED;
@@ -3598,6 +3602,24 @@ makeEmptyPGconn(void)
 	return conn;
 }
 
+/*
+ * pqFreeCommandQueue
+ *	 - free a list of pipeline command queue entries
+ */
+static void
+pqFreeCommandQueue(PGcmdQueueEntry *queue)
+{
+	while (queue != NULL)
+	{
+		PGcmdQueueEntry *cur = queue;
+
+		queue = cur->next;
+		if (cur->query)
+			free(cur->query);
+		free(cur);
+	}
+}
+
 /*
  * freePGconn
  *	 - free an idle (closed) PGconn data structure
@@ -3644,6 +3666,7 @@ freePGconn(PGconn *conn)
 		free(conn->client_encoding_initial);
 	if (conn->events)
 		free(conn->events);
+	pqFreeCommandQueue(conn->cmd_queue_recycle);
 	if (conn->pghost)
 		free(conn->pghost);
 	if (conn->pghostaddr)
@@ -3792,7 +3815,10 @@ closePGconn(PGconn *conn)
 	conn->status = CONNECTION_BAD;	/* Well, not really _bad_ - just absent */
 	conn->asyncStatus = PGASYNC_IDLE;
 	conn->xactStatus = PQTRANS_IDLE;
+	conn->pipelineStatus = PQ_PIPELINE_OFF;
 	pqClearAsyncResult(conn);	/* deallocate result */
+	pqFreeCommandQueue(conn->cmd_queue_head);
+	conn->cmd_queue_head = conn->cmd_queue_tail = NULL;
 	resetPQExpBuffer(&conn->errorMessage);
 	release_conn_addrinfo(conn);
 
@@ -6266,6 +6292,14 @@ PQtransactionStatus(const PGconn *conn)
 	return conn->xactStatus;
 }
 
+PGpipelineStatus
+PQpipelineStatus(const PGconn *conn)
+{
+	if (!conn)
+		return PQ_PIPELINE_OFF;
+	return conn->pipelineStatus;
+}
+
 const char *
 PQparameterStatus(const PGconn *conn, const char *paramName)
 {
@@ -44,6 +44,7 @@
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/rel.h"
+#include "utils/resowner.h"
 #include "utils/snapmgr.h"
 #include "utils/syscache.h"
 #include "utils/typcache.h"
@@ -76,6 +77,14 @@ typedef struct
  * a function.  (We assume the case to optimize is many repetitions of a
  * function within a transaction.)
  *
+ * Similarly, plancache references on simple expressions' generic plans are
+ * held until end of transaction in a resource owner of our own, so that
+ * re-evaluating a simple expression only needs a quick validity check
+ * instead of a trip through the plancache.  The resource owner is a child
+ * of TopTransactionResourceOwner; we release its references explicitly at
+ * commit, and let abort processing take care of them otherwise.  DO blocks
+ * share it, too, since it holds nothing but those references.
+ *
  * However, there's no value in trying to amortize simple expression setup
  * across multiple executions of a DO block (inline code block), since there
  * can never be any.  If we use the shared EState for a DO block, the expr
@@ -93,6 +102,7 @@ typedef struct SimpleEcontextStackEntry
 } SimpleEcontextStackEntry;
 
 static EState *shared_simple_eval_estate = NULL;
+static ResourceOwner shared_simple_eval_resowner = NULL;
 static SimpleEcontextStackEntry *simple_econtext_stack = NULL;
 
 /*
@@ -414,6 +424,7 @@ static plpgsql_CastHashEntry *get_cast_hashentry(PLpgSQL_execstate *estate,
 				   Oid dsttype, int32 dsttypmod);
 static void exec_init_tuple_store(PLpgSQL_execstate *estate);
 static void exec_set_found(PLpgSQL_execstate *estate, bool state);
+static ResourceOwner get_simple_eval_resowner(void);
 static void plpgsql_create_econtext(PLpgSQL_execstate *estate);
 static void plpgsql_destroy_econtext(PLpgSQL_execstate *estate);
 static void assign_simple_var(PLpgSQL_execstate *estate, PLpgSQL_var *var,
@@ -5838,6 +5849,13 @@ exec_run_select(PLpgSQL_execstate *estate,
 }
 
 
+/*
+ * Maximum number of rows exec_for_query fetches from the portal at once.
+ * Larger batches mean fewer executor round trips, but each batch is held
+ * in memory in its entirety.
+ */
+#define PLPGSQL_FOR_MAX_FETCH	1000
+
 /*
  * exec_for_query --- execute body of FOR loop for each row from a portal
  *
@@ -5854,6 +5872,7 @@ exec_for_query(PLpgSQL_execstate *estate, PLpgSQL_stmt_forq *stmt,
 	uint64		previous_id = INVALID_TUPLEDESC_IDENTIFIER;
 	bool		tupdescs_match = true;
 	uint64		n;
+	long		fetch_count = 50;
 
 	/* Fetch loop variable's datum entry */
 	var = (PLpgSQL_variable *) estate->datums[stmt->var->dno];
@@ -5959,11 +5978,15 @@ exec_for_query(PLpgSQL_execstate *estate, PLpgSQL_stmt_forq *stmt,
 		SPI_freetuptable(tuptab);
 
 		/*
-		 * Fetch more tuples.  If prefetching is allowed, grab 50 at a time.
+		 * Fetch more tuples.  If prefetching is allowed, grab 50 at first,
+		 * then double the batch size on each trip up to a limit, so that
+		 * loops over large results make fewer trips through the executor.
 		 */
-		SPI_cursor_fetch(portal, true, prefetch_ok ? 50 : 1);
+		SPI_cursor_fetch(portal, true, prefetch_ok ? fetch_count : 1);
 		tuptab = SPI_tuptable;
 		n = SPI_processed;
+		if (fetch_count < PLPGSQL_FOR_MAX_FETCH)
+			fetch_count = Min(fetch_count * 2, PLPGSQL_FOR_MAX_FETCH);
 	}
 
 loop_exit:
@@ -6009,8 +6032,12 @@ loop_exit:
  * someone might redefine a SQL function that had been inlined into the simple
  * expression.  That cannot cause a simple expression to become non-simple (or
  * vice versa), but we do have to handle replacing the expression tree.
- * Fortunately it's normally inexpensive to call SPI_plan_get_cached_plan for
- * a simple expression.
+ *
+ * Most simple expressions don't touch any tables, so once we have their
+ * generic plan we keep a refcount on it until end of transaction and just
+ * use CachedPlanIsSimplyValid() to notice invalidations.  Otherwise we fall
+ * back to calling SPI_plan_get_cached_plan on each evaluation, which is
+ * normally inexpensive for a simple expression, but not free.
  *
  * Note: if pass-by-reference, the result is in the eval_mcontext.
  * It will be freed when exec_eval_cleanup is done.
@@ -6026,7 +6053,7 @@ exec_eval_simple_expr(PLpgSQL_execstate *estate,
 {
 	ExprContext *econtext = estate->eval_econtext;
 	LocalTransactionId curlxid = MyProc->lxid;
-	CachedPlan *cplan;
+	CachedPlan *cplan = NULL;
 	void	   *save_setup_arg;
 	MemoryContext oldcontext;
 
@@ -6043,28 +6070,74 @@ exec_eval_simple_expr(PLpgSQL_execstate *estate,
 		return false;
 
 	/*
-	 * Revalidate cached plan, so that we will notice if it became stale. (We
-	 * need to hold a refcount while using the plan, anyway.)  If replanning
-	 * is needed, do that work in the eval_mcontext.
+	 * If we have a plan that allows the cheap validity check, and it's still
+	 * valid, we can skip the plancache entirely.  If we do not yet hold a
+	 * refcount on it in the current transaction, CachedPlanIsSimplyValid
+	 * acquires one in our resource owner.
 	 */
-	oldcontext = MemoryContextSwitchTo(get_eval_mcontext(estate));
-	cplan = SPI_plan_get_cached_plan(expr->plan);
-	MemoryContextSwitchTo(oldcontext);
+	if (expr->expr_simple_plan != NULL &&
+		CachedPlanIsSimplyValid(expr->expr_simple_plansource,
+								expr->expr_simple_plan,
+								(expr->expr_simple_plan_lxid != curlxid ?
+								 get_simple_eval_resowner() : NULL)))
+	{
+		/* Remember that we have the refcount */
+		expr->expr_simple_plan_lxid = curlxid;
+	}
+	else
+	{
+		/* Release our refcount on the stale plan, if we still hold one */
+		if (expr->expr_simple_plan != NULL &&
+			expr->expr_simple_plan_lxid == curlxid)
+		{
+			ResourceOwner saveResourceOwner = CurrentResourceOwner;
 
-	/*
-	 * We can't get a failure here, because the number of CachedPlanSources in
-	 * the SPI plan can't change from what exec_simple_check_plan saw; it's a
-	 * property of the raw parsetree generated from the query text.
-	 */
-	Assert(cplan != NULL);
+			CurrentResourceOwner = shared_simple_eval_resowner;
+			ReleaseCachedPlan(expr->expr_simple_plan, true);
+			CurrentResourceOwner = saveResourceOwner;
+		}
+		expr->expr_simple_plan = NULL;
+		expr->expr_simple_plan_lxid = InvalidLocalTransactionId;
 
-	/* If it got replanned, update our copy of the simple expression */
-	if (cplan->generation != expr->expr_simple_generation)
-	{
-		exec_save_simple_expr(expr, cplan);
-		/* better recheck r/w safety, as it could change due to inlining */
-		if (expr->rwparam >= 0)
-			exec_check_rw_parameter(expr, expr->rwparam);
+		/*
+		 * Revalidate cached plan, so that we will notice if it became stale.
+		 * (We need to hold a refcount while using the plan, anyway.)  If
+		 * replanning is needed, do that work in the eval_mcontext.
+		 */
+		oldcontext = MemoryContextSwitchTo(get_eval_mcontext(estate));
+		cplan = SPI_plan_get_cached_plan(expr->plan);
+		MemoryContextSwitchTo(oldcontext);
+
+		/*
+		 * We can't get a failure here, because the number of
+		 * CachedPlanSources in the SPI plan can't change from what
+		 * exec_simple_check_plan saw; it's a property of the raw parsetree
+		 * generated from the query text.
+		 */
+		Assert(cplan != NULL);
+
+		/* If it got replanned, update our copy of the simple expression */
+		if (cplan->generation != expr->expr_simple_generation)
+		{
+			exec_save_simple_expr(expr, cplan);
+			/* better recheck r/w safety, as it could change due to inlining */
+			if (expr->rwparam >= 0)
+				exec_check_rw_parameter(expr, expr->rwparam);
+		}
+
+		/*
+		 * If the plan qualifies for the cheap check, keep a refcount on it
+		 * until end of transaction, so that later evaluations need not come
+		 * back here.  The transient refcount we just got is still released
+		 * below, as before.
+		 */
+		if (CachedPlanAllowsSimpleValidityCheck(expr->expr_simple_plansource,
+												cplan,
+												get_simple_eval_resowner()))
+		{
+			expr->expr_simple_plan = cplan;
+			expr->expr_simple_plan_lxid = curlxid;
+		}
 	}
 
 	/*
@@ -6135,9 +6208,11 @@ exec_eval_simple_expr(PLpgSQL_execstate *estate,
 	MemoryContextSwitchTo(oldcontext);
 
 	/*
-	 * Now we can release our refcount on the cached plan.
+	 * Now we can release our transient refcount on the cached plan, if we
+	 * took one.
 	 */
-	ReleaseCachedPlan(cplan, true);
+	if (cplan)
+		ReleaseCachedPlan(cplan, true);
 
 	/*
 	 * That's it.
@@ -7767,6 +7842,9 @@ exec_simple_check_plan(PLpgSQL_execstate *estate, PLpgSQL_expr *expr)
 	 * Initialize to "not simple".
 	 */
 	expr->expr_simple_expr = NULL;
+	expr->expr_simple_plansource = NULL;
+	expr->expr_simple_plan = NULL;
+	expr->expr_simple_plan_lxid = InvalidLocalTransactionId;
 
 	/*
 	 * Check the analyzed-and-rewritten form of the query to see if we will be
@@ -7846,6 +7924,9 @@ exec_simple_check_plan(PLpgSQL_execstate *estate, PLpgSQL_expr *expr)
 	/* Share the remaining work with replan code path */
 	exec_save_simple_expr(expr, cplan);
 
+	/* Remember the plansource for CachedPlanIsSimplyValid checks */
+	expr->expr_simple_plansource = plansource;
+
 	/* Release our plan refcount */
 	ReleaseCachedPlan(cplan, true);
 }
@@ -8048,6 +8129,20 @@ exec_set_found(PLpgSQL_execstate *estate, bool state)
 	assign_simple_var(estate, var, BoolGetDatum(state), false, false);
 }
 
+/*
+ * get_simple_eval_resowner --- get the resource owner for simple-expression
+ * plan references, creating it if there's not one yet in this transaction
+ */
+static ResourceOwner
+get_simple_eval_resowner(void)
+{
+	if (shared_simple_eval_resowner == NULL)
+		shared_simple_eval_resowner =
+			ResourceOwnerCreate(TopTransactionResourceOwner,
+								"PL/pgSQL simple expressions");
+	return shared_simple_eval_resowner;
+}
+
 /*
  * plpgsql_create_econtext --- create an eval_econtext for the current function
  *
@@ -8126,30 +8221,40 @@ plpgsql_destroy_econtext(PLpgSQL_execstate *estate)
 /*
  * plpgsql_xact_cb --- post-transaction-commit-or-abort cleanup
  *
- * If a simple-expression EState was created in the current transaction,
- * it has to be cleaned up.
+ * If a simple-expression EState or resource owner was created in the current
+ * transaction, it has to be cleaned up.
  */
 void
 plpgsql_xact_cb(XactEvent event, void *arg)
 {
 	/*
-	 * If we are doing a clean transaction shutdown, free the EState (so that
-	 * any remaining resources will be released correctly). In an abort, we
-	 * expect the regular abort recovery procedures to release everything of
-	 * interest.
+	 * If we are doing a clean transaction shutdown, free the EState and
+	 * release the plan references we kept (so that any remaining resources
+	 * will be released correctly, without leak warnings).  The resource
+	 * owner itself goes away along with TopTransactionResourceOwner.  In an
+	 * abort, we expect the regular abort recovery procedures to release
+	 * everything of interest.
 	 */
-	if (event == XACT_EVENT_COMMIT || event == XACT_EVENT_PREPARE)
+	if (event == XACT_EVENT_COMMIT ||
+		event == XACT_EVENT_PARALLEL_COMMIT ||
+		event == XACT_EVENT_PREPARE)
 	{
 		simple_econtext_stack = NULL;
 
 		if (shared_simple_eval_estate)
 			FreeExecutorState(shared_simple_eval_estate);
 		shared_simple_eval_estate = NULL;
+
+		if (shared_simple_eval_resowner)
+			ResourceOwnerReleaseAllPlanCacheRefs(shared_simple_eval_resowner);
+		shared_simple_eval_resowner = NULL;
 	}
-	else if (event == XACT_EVENT_ABORT)
+	else if (event == XACT_EVENT_ABORT ||
+			 event == XACT_EVENT_PARALLEL_ABORT)
 	{
 		simple_econtext_stack = NULL;
 		shared_simple_eval_estate = NULL;
+		shared_simple_eval_resowner = NULL;
 	}
 }
 
@@ -230,6 +230,17 @@ typedef struct PLpgSQL_expr
 	Oid			expr_simple_type;	/* result type Oid, if simple */
 	int32		expr_simple_typmod; /* result typmod, if simple */
 
+	/*
+	 * If the expression was ever determined to be simple, we remember its
+	 * CachedPlanSource here.  If expr_simple_plan_lxid matches current LXID,
+	 * then we hold a refcount on expr_simple_plan in the current transaction,
+	 * by way of the shared simple-expression resource owner.  Otherwise we
+	 * need to get one before re-using expr_simple_plan.
+	 */
+	CachedPlanSource *expr_simple_plansource;
+	CachedPlan *expr_simple_plan;
+	LocalTransactionId expr_simple_plan_lxid;
+
 	/*
 	 * if expr is simple AND prepared in current transaction,
 	 * expr_simple_state and expr_simple_in_use are valid. Test validity by
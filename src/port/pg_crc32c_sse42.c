@@ -3,6 +3,14 @@
  * pg_crc32c_sse42.c
  *	  Compute CRC-32C checksum using Intel SSE 4.2 instructions.
  *
+ * On x86-64, large inputs are processed as three interleaved streams, which
+ * hides the latency of the crc32 instruction (three cycles, with a
+ * throughput of one per cycle) that otherwise limits a single dependency
+ * chain.  The three partial CRCs are combined by shifting the earlier ones
+ * past the later streams' data using precomputed tables; this approach is
+ * described in Mark Adler's answer to "Implementing SSE 4.2's CRC32C in
+ * software", https://stackoverflow.com/a/17646775.
+ *
  * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
  *
@@ -18,6 +26,59 @@
 
 #include <nmmintrin.h>
 
+#ifdef __x86_64__
+
+/*
+ * Stream lengths, in bytes, for the long and short interleaved loops.  Each
+ * must be a multiple of 8 and match the tables below.
+ */
+#define CRC32C_LONG		2048
+#define CRC32C_SHORT	256
+
+static const uint32 crc32c_long_shift[4][256];
+static const uint32 crc32c_short_shift[4][256];
+
+/*
+ * Apply a shift table to a CRC, yielding the CRC that would result from
+ * feeding that many zero bytes through it.
+ */
+static inline uint32
+crc32c_shift(const uint32 table[][256], uint32 crc)
+{
+	return table[0][crc & 0xFF] ^
+		table[1][(crc >> 8) & 0xFF] ^
+		table[2][(crc >> 16) & 0xFF] ^
+		table[3][crc >> 24];
+}
+
+/*
+ * Process 3 * "stride" bytes as three interleaved streams, returning the
+ * CRC of the whole block.
+ */
+static inline uint32
+crc32c_3way(uint32 crc0, const unsigned char *p, size_t stride,
+			const uint32 table[][256])
+{
+	const unsigned char *end = p + stride;
+	uint64		crc1 = 0;
+	uint64		crc2 = 0;
+	uint64		crc = crc0;
+
+	do
+	{
+		crc = _mm_crc32_u64(crc, *((const uint64 *) p));
+		crc1 = _mm_crc32_u64(crc1, *((const uint64 *) (p + stride)));
+		crc2 = _mm_crc32_u64(crc2, *((const uint64 *) (p + 2 * stride)));
+		p += 8;
+	} while (p < end);
+
+	crc0 = crc32c_shift(table, (uint32) crc) ^ (uint32) crc1;
+	crc0 = crc32c_shift(table, crc0) ^ (uint32) crc2;
+
+	return crc0;
+}
+#endif							/* __x86_64__ */
+
 pg_crc32c
 pg_comp_crc32c_sse42(pg_crc32c crc, const void *data, size_t len)
 {
@@ -32,6 +93,17 @@ pg_comp_crc32c_sse42(pg_crc32c crc, const void *data, size_t len)
 	 * the begin address.
 	 */
 #ifdef __x86_64__
+	while (pend - p >= 3 * CRC32C_LONG)
+	{
+		crc = crc32c_3way(crc, p, CRC32C_LONG, crc32c_long_shift);
+		p += 3 * CRC32C_LONG;
+	}
+	while (pend - p >= 3 * CRC32C_SHORT)
+	{
+		crc = crc32c_3way(crc, p, CRC32C_SHORT, crc32c_short_shift);
+		p += 3 * CRC32C_SHORT;
+	}
+
 	while (p + 8 <= pend)
 	{
 		crc = (uint32) _mm_crc32_u64(crc, *((const uint64 *) p));
@@ -66,3 +138,545 @@ pg_comp_crc32c_sse42(pg_crc32c crc, const void *data, size_t len)
 
 	return crc;
 }
+
+#ifdef __x86_64__
+
+/*
+ * Lookup tables for shifting a CRC-32C past CRC32C_LONG and CRC32C_SHORT
+ * zero bytes, respectively.  Entry [k][b] is the shifted value of a CRC
+ * that has byte b in byte position k and zeros elsewhere.
+ */
+static const uint32 crc32c_long_shift[4][256] = {
+	{
+		0x00000000, 0xF7506984, 0xEB4CA5F9, 0x1C1CCC7D,
+		0xD3753D03, 0x24255487, 0x383998FA, 0xCF69F17E,
+		0xA3060CF7, 0x54566573, 0x484AA90E, 0xBF1AC08A,
+		0x707331F4, 0x87235870, 0x9B3F940D, 0x6C6FFD89,
+		0x43E06F1F, 0xB4B0069B, 0xA8ACCAE6, 0x5FFCA362,
+		0x9095521C, 0x67C53B98, 0x7BD9F7E5, 0x8C899E61,
+		0xE0E663E8, 0x17B60A6C, 0x0BAAC611, 0xFCFAAF95,
+		0x33935EEB, 0xC4C3376F, 0xD8DFFB12, 0x2F8F9296,
+		0x87C0DE3E, 0x7090B7BA, 0x6C8C7BC7, 0x9BDC1243,
+		0x54B5E33D, 0xA3E58AB9, 0xBFF946C4, 0x48A92F40,
+		0x24C6D2C9, 0xD396BB4D, 0xCF8A7730, 0x38DA1EB4,
+		0xF7B3EFCA, 0x00E3864E, 0x1CFF4A33, 0xEBAF23B7,
+		0xC420B121, 0x3370D8A5, 0x2F6C14D8, 0xD83C7D5C,
+		0x17558C22, 0xE005E5A6, 0xFC1929DB, 0x0B49405F,
+		0x6726BDD6, 0x9076D452, 0x8C6A182F, 0x7B3A71AB,
+		0xB45380D5, 0x4303E951, 0x5F1F252C, 0xA84F4CA8,
+		0x0A6DCA8D, 0xFD3DA309, 0xE1216F74, 0x167106F0,
+		0xD918F78E, 0x2E489E0A, 0x32545277, 0xC5043BF3,
+		0xA96BC67A, 0x5E3BAFFE, 0x42276383, 0xB5770A07,
+		0x7A1EFB79, 0x8D4E92FD, 0x91525E80, 0x66023704,
+		0x498DA592, 0xBEDDCC16, 0xA2C1006B, 0x559169EF,
+		0x9AF89891, 0x6DA8F115, 0x71B43D68, 0x86E454EC,
+		0xEA8BA965, 0x1DDBC0E1, 0x01C70C9C, 0xF6976518,
+		0x39FE9466, 0xCEAEFDE2, 0xD2B2319F, 0x25E2581B,
+		0x8DAD14B3, 0x7AFD7D37, 0x66E1B14A, 0x91B1D8CE,
+		0x5ED829B0, 0xA9884034, 0xB5948C49, 0x42C4E5CD,
+		0x2EAB1844, 0xD9FB71C0, 0xC5E7BDBD, 0x32B7D439,
+		0xFDDE2547, 0x0A8E4CC3, 0x169280BE, 0xE1C2E93A,
+		0xCE4D7BAC, 0x391D1228, 0x2501DE55, 0xD251B7D1,
+		0x1D3846AF, 0xEA682F2B, 0xF674E356, 0x01248AD2,
+		0x6D4B775B, 0x9A1B1EDF, 0x8607D2A2, 0x7157BB26,
+		0xBE3E4A58, 0x496E23DC, 0x5572EFA1, 0xA2228625,
+		0x14DB951A, 0xE38BFC9E, 0xFF9730E3, 0x08C75967,
+		0xC7AEA819, 0x30FEC19D, 0x2CE20DE0, 0xDBB26464,
+		0xB7DD99ED, 0x408DF069, 0x5C913C14, 0xABC15590,
+		0x64A8A4EE, 0x93F8CD6A, 0x8FE40117, 0x78B46893,
+		0x573BFA05, 0xA06B9381, 0xBC775FFC, 0x4B273678,
+		0x844EC706, 0x731EAE82, 0x6F0262FF, 0x98520B7B,
+		0xF43DF6F2, 0x036D9F76, 0x1F71530B, 0xE8213A8F,
+		0x2748CBF1, 0xD018A275, 0xCC046E08, 0x3B54078C,
+		0x931B4B24, 0x644B22A0, 0x7857EEDD, 0x8F078759,
+		0x406E7627, 0xB73E1FA3, 0xAB22D3DE, 0x5C72BA5A,
+		0x301D47D3, 0xC74D2E57, 0xDB51E22A, 0x2C018BAE,
+		0xE3687AD0, 0x14381354, 0x0824DF29, 0xFF74B6AD,
+		0xD0FB243B, 0x27AB4DBF, 0x3BB781C2, 0xCCE7E846,
+		0x038E1938, 0xF4DE70BC, 0xE8C2BCC1, 0x1F92D545,
+		0x73FD28CC, 0x84AD4148, 0x98B18D35, 0x6FE1E4B1,
+		0xA08815CF, 0x57D87C4B, 0x4BC4B036, 0xBC94D9B2,
+		0x1EB65F97, 0xE9E63613, 0xF5FAFA6E, 0x02AA93EA,
+		0xCDC36294, 0x3A930B10, 0x268FC76D, 0xD1DFAEE9,
+		0xBDB05360, 0x4AE03AE4, 0x56FCF699, 0xA1AC9F1D,
+		0x6EC56E63, 0x999507E7, 0x8589CB9A, 0x72D9A21E,
+		0x5D563088, 0xAA06590C, 0xB61A9571, 0x414AFCF5,
+		0x8E230D8B, 0x7973640F, 0x656FA872, 0x923FC1F6,
+		0xFE503C7F, 0x090055FB, 0x151C9986, 0xE24CF002,
+		0x2D25017C, 0xDA7568F8, 0xC669A485, 0x3139CD01,
+		0x997681A9, 0x6E26E82D, 0x723A2450, 0x856A4DD4,
+		0x4A03BCAA, 0xBD53D52E, 0xA14F1953, 0x561F70D7,
+		0x3A708D5E, 0xCD20E4DA, 0xD13C28A7, 0x266C4123,
+		0xE905B05D, 0x1E55D9D9, 0x024915A4, 0xF5197C20,
+		0xDA96EEB6, 0x2DC68732, 0x31DA4B4F, 0xC68A22CB,
+		0x09E3D3B5, 0xFEB3BA31, 0xE2AF764C, 0x15FF1FC8,
+		0x7990E241, 0x8EC08BC5, 0x92DC47B8, 0x658C2E3C,
+		0xAAE5DF42, 0x5DB5B6C6, 0x41A97ABB, 0xB6F9133F
+	},
+	{
+		0x00000000, 0x29B72A34, 0x536E5468, 0x7AD97E5C,
+		0xA6DCA8D0, 0x8F6B82E4, 0xF5B2FCB8, 0xDC05D68C,
+		0x48552751, 0x61E20D65, 0x1B3B7339, 0x328C590D,
+		0xEE898F81, 0xC73EA5B5, 0xBDE7DBE9, 0x9450F1DD,
+		0x90AA4EA2, 0xB91D6496, 0xC3C41ACA, 0xEA7330FE,
+		0x3676E672, 0x1FC1CC46, 0x6518B21A, 0x4CAF982E,
+		0xD8FF69F3, 0xF14843C7, 0x8B913D9B, 0xA22617AF,
+		0x7E23C123, 0x5794EB17, 0x2D4D954B, 0x04FABF7F,
+		0x24B8EBB5, 0x0D0FC181, 0x77D6BFDD, 0x5E6195E9,
+		0x82644365, 0xABD36951, 0xD10A170D, 0xF8BD3D39,
+		0x6CEDCCE4, 0x455AE6D0, 0x3F83988C, 0x1634B2B8,
+		0xCA316434, 0xE3864E00, 0x995F305C, 0xB0E81A68,
+		0xB412A517, 0x9DA58F23, 0xE77CF17F, 0xCECBDB4B,
+		0x12CE0DC7, 0x3B7927F3, 0x41A059AF, 0x6817739B,
+		0xFC478246, 0xD5F0A872, 0xAF29D62E, 0x869EFC1A,
+		0x5A9B2A96, 0x732C00A2, 0x09F57EFE, 0x204254CA,
+		0x4971D76A, 0x60C6FD5E, 0x1A1F8302, 0x33A8A936,
+		0xEFAD7FBA, 0xC61A558E, 0xBCC32BD2, 0x957401E6,
+		0x0124F03B, 0x2893DA0F, 0x524AA453, 0x7BFD8E67,
+		0xA7F858EB, 0x8E4F72DF, 0xF4960C83, 0xDD2126B7,
+		0xD9DB99C8, 0xF06CB3FC, 0x8AB5CDA0, 0xA302E794,
+		0x7F073118, 0x56B01B2C, 0x2C696570, 0x05DE4F44,
+		0x918EBE99, 0xB83994AD, 0xC2E0EAF1, 0xEB57C0C5,
+		0x37521649, 0x1EE53C7D, 0x643C4221, 0x4D8B6815,
+		0x6DC93CDF, 0x447E16EB, 0x3EA768B7, 0x17104283,
+		0xCB15940F, 0xE2A2BE3B, 0x987BC067, 0xB1CCEA53,
+		0x259C1B8E, 0x0C2B31BA, 0x76F24FE6, 0x5F4565D2,
+		0x8340B35E, 0xAAF7996A, 0xD02EE736, 0xF999CD02,
+		0xFD63727D, 0xD4D45849, 0xAE0D2615, 0x87BA0C21,
+		0x5BBFDAAD, 0x7208F099, 0x08D18EC5, 0x2166A4F1,
+		0xB536552C, 0x9C817F18, 0xE6580144, 0xCFEF2B70,
+		0x13EAFDFC, 0x3A5DD7C8, 0x4084A994, 0x693383A0,
+		0x92E3AED4, 0xBB5484E0, 0xC18DFABC, 0xE83AD088,
+		0x343F0604, 0x1D882C30, 0x6751526C, 0x4EE67858,
+		0xDAB68985, 0xF301A3B1, 0x89D8DDED, 0xA06FF7D9,
+		0x7C6A2155, 0x55DD0B61, 0x2F04753D, 0x06B35F09,
+		0x0249E076, 0x2BFECA42, 0x5127B41E, 0x78909E2A,
+		0xA49548A6, 0x8D226292, 0xF7FB1CCE, 0xDE4C36FA,
+		0x4A1CC727, 0x63ABED13, 0x1972934F, 0x30C5B97B,
+		0xECC06FF7, 0xC57745C3, 0xBFAE3B9F, 0x961911AB,
+		0xB65B4561, 0x9FEC6F55, 0xE5351109, 0xCC823B3D,
+		0x1087EDB1, 0x3930C785, 0x43E9B9D9, 0x6A5E93ED,
+		0xFE0E6230, 0xD7B94804, 0xAD603658, 0x84D71C6C,
+		0x58D2CAE0, 0x7165E0D4, 0x0BBC9E88, 0x220BB4BC,
+		0x26F10BC3, 0x0F4621F7, 0x759F5FAB, 0x5C28759F,
+		0x802DA313, 0xA99A8927, 0xD343F77B, 0xFAF4DD4F,
+		0x6EA42C92, 0x471306A6, 0x3DCA78FA, 0x147D52CE,
+		0xC8788442, 0xE1CFAE76, 0x9B16D02A, 0xB2A1FA1E,
+		0xDB9279BE, 0xF225538A, 0x88FC2DD6, 0xA14B07E2,
+		0x7D4ED16E, 0x54F9FB5A, 0x2E208506, 0x0797AF32,
+		0x93C75EEF, 0xBA7074DB, 0xC0A90A87, 0xE91E20B3,
+		0x351BF63F, 0x1CACDC0B, 0x6675A257, 0x4FC28863,
+		0x4B38371C, 0x628F1D28, 0x18566374, 0x31E14940,
+		0xEDE49FCC, 0xC453B5F8, 0xBE8ACBA4, 0x973DE190,
+		0x036D104D, 0x2ADA3A79, 0x50034425, 0x79B46E11,
+		0xA5B1B89D, 0x8C0692A9, 0xF6DFECF5, 0xDF68C6C1,
+		0xFF2A920B, 0xD69DB83F, 0xAC44C663, 0x85F3EC57,
+		0x59F63ADB, 0x704110EF, 0x0A986EB3, 0x232F4487,
+		0xB77FB55A, 0x9EC89F6E, 0xE411E132, 0xCDA6CB06,
+		0x11A31D8A, 0x381437BE, 0x42CD49E2, 0x6B7A63D6,
+		0x6F80DCA9, 0x4637F69D, 0x3CEE88C1, 0x1559A2F5,
+		0xC95C7479, 0xE0EB5E4D, 0x9A322011, 0xB3850A25,
+		0x27D5FBF8, 0x0E62D1CC, 0x74BBAF90, 0x5D0C85A4,
+		0x81095328, 0xA8BE791C, 0xD2670740, 0xFBD02D74
+	},
+	{
+		0x00000000, 0x202B2B59, 0x405656B2, 0x607D7DEB,
+		0x80ACAD64, 0xA087863D, 0xC0FAFBD6, 0xE0D1D08F,
+		0x04B52C39, 0x249E0760, 0x44E37A8B, 0x64C851D2,
+		0x8419815D, 0xA432AA04, 0xC44FD7EF, 0xE464FCB6,
+		0x096A5872, 0x2941732B, 0x493C0EC0, 0x69172599,
+		0x89C6F516, 0xA9EDDE4F, 0xC990A3A4, 0xE9BB88FD,
+		0x0DDF744B, 0x2DF45F12, 0x4D8922F9, 0x6DA209A0,
+		0x8D73D92F, 0xAD58F276, 0xCD258F9D, 0xED0EA4C4,
+		0x12D4B0E4, 0x32FF9BBD, 0x5282E656, 0x72A9CD0F,
+		0x92781D80, 0xB25336D9, 0xD22E4B32, 0xF205606B,
+		0x16619CDD, 0x364AB784, 0x5637CA6F, 0x761CE136,
+		0x96CD31B9, 0xB6E61AE0, 0xD69B670B, 0xF6B04C52,
+		0x1BBEE896, 0x3B95C3CF, 0x5BE8BE24, 0x7BC3957D,
+		0x9B1245F2, 0xBB396EAB, 0xDB441340, 0xFB6F3819,
+		0x1F0BC4AF, 0x3F20EFF6, 0x5F5D921D, 0x7F76B944,
+		0x9FA769CB, 0xBF8C4292, 0xDFF13F79, 0xFFDA1420,
+		0x25A961C8, 0x05824A91, 0x65FF377A, 0x45D41C23,
+		0xA505CCAC, 0x852EE7F5, 0xE5539A1E, 0xC578B147,
+		0x211C4DF1, 0x013766A8, 0x614A1B43, 0x4161301A,
+		0xA1B0E095, 0x819BCBCC, 0xE1E6B627, 0xC1CD9D7E,
+		0x2CC339BA, 0x0CE812E3, 0x6C956F08, 0x4CBE4451,
+		0xAC6F94DE, 0x8C44BF87, 0xEC39C26C, 0xCC12E935,
+		0x28761583, 0x085D3EDA, 0x68204331, 0x480B6868,
+		0xA8DAB8E7, 0x88F193BE, 0xE88CEE55, 0xC8A7C50C,
+		0x377DD12C, 0x1756FA75, 0x772B879E, 0x5700ACC7,
+		0xB7D17C48, 0x97FA5711, 0xF7872AFA, 0xD7AC01A3,
+		0x33C8FD15, 0x13E3D64C, 0x739EABA7, 0x53B580FE,
+		0xB3645071, 0x934F7B28, 0xF33206C3, 0xD3192D9A,
+		0x3E17895E, 0x1E3CA207, 0x7E41DFEC, 0x5E6AF4B5,
+		0xBEBB243A, 0x9E900F63, 0xFEED7288, 0xDEC659D1,
+		0x3AA2A567, 0x1A898E3E, 0x7AF4F3D5, 0x5ADFD88C,
+		0xBA0E0803, 0x9A25235A, 0xFA585EB1, 0xDA7375E8,
+		0x4B52C390, 0x6B79E8C9, 0x0B049522, 0x2B2FBE7B,
+		0xCBFE6EF4, 0xEBD545AD, 0x8BA83846, 0xAB83131F,
+		0x4FE7EFA9, 0x6FCCC4F0, 0x0FB1B91B, 0x2F9A9242,
+		0xCF4B42CD, 0xEF606994, 0x8F1D147F, 0xAF363F26,
+		0x42389BE2, 0x6213B0BB, 0x026ECD50, 0x2245E609,
+		0xC2943686, 0xE2BF1DDF, 0x82C26034, 0xA2E94B6D,
+		0x468DB7DB, 0x66A69C82, 0x06DBE169, 0x26F0CA30,
+		0xC6211ABF, 0xE60A31E6, 0x86774C0D, 0xA65C6754,
+		0x59867374, 0x79AD582D, 0x19D025C6, 0x39FB0E9F,
+		0xD92ADE10, 0xF901F549, 0x997C88A2, 0xB957A3FB,
+		0x5D335F4D, 0x7D187414, 0x1D6509FF, 0x3D4E22A6,
+		0xDD9FF229, 0xFDB4D970, 0x9DC9A49B, 0xBDE28FC2,
+		0x50EC2B06, 0x70C7005F, 0x10BA7DB4, 0x309156ED,
+		0xD0408662, 0xF06BAD3B, 0x9016D0D0, 0xB03DFB89,
+		0x5459073F, 0x74722C66, 0x140F518D, 0x34247AD4,
+		0xD4F5AA5B, 0xF4DE8102, 0x94A3FCE9, 0xB488D7B0,
+		0x6EFBA258, 0x4ED08901, 0x2EADF4EA, 0x0E86DFB3,
+		0xEE570F3C, 0xCE7C2465, 0xAE01598E, 0x8E2A72D7,
+		0x6A4E8E61, 0x4A65A538, 0x2A18D8D3, 0x0A33F38A,
+		0xEAE22305, 0xCAC9085C, 0xAAB475B7, 0x8A9F5EEE,
+		0x6791FA2A, 0x47BAD173, 0x27C7AC98, 0x07EC87C1,
+		0xE73D574E, 0xC7167C17, 0xA76B01FC, 0x87402AA5,
+		0x6324D613, 0x430FFD4A, 0x237280A1, 0x0359ABF8,
+		0xE3887B77, 0xC3A3502E, 0xA3DE2DC5, 0x83F5069C,
+		0x7C2F12BC, 0x5C0439E5, 0x3C79440E, 0x1C526F57,
+		0xFC83BFD8, 0xDCA89481, 0xBCD5E96A, 0x9CFEC233,
+		0x789A3E85, 0x58B115DC, 0x38CC6837, 0x18E7436E,
+		0xF83693E1, 0xD81DB8B8, 0xB860C553, 0x984BEE0A,
+		0x75454ACE, 0x556E6197, 0x35131C7C, 0x15383725,
+		0xF5E9E7AA, 0xD5C2CCF3, 0xB5BFB118, 0x95949A41,
+		0x71F066F7, 0x51DB4DAE, 0x31A63045, 0x118D1B1C,
+		0xF15CCB93, 0xD177E0CA, 0xB10A9D21, 0x9121B678
+	},
+	{
+		0x00000000, 0x96A58720, 0x28A778B1, 0xBE02FF91,
+		0x514EF162, 0xC7EB7642, 0x79E989D3, 0xEF4C0EF3,
+		0xA29DE2C4, 0x343865E4, 0x8A3A9A75, 0x1C9F1D55,
+		0xF3D313A6, 0x65769486, 0xDB746B17, 0x4DD1EC37,
+		0x40D7B379, 0xD6723459, 0x6870CBC8, 0xFED54CE8,
+		0x1199421B, 0x873CC53B, 0x393E3AAA, 0xAF9BBD8A,
+		0xE24A51BD, 0x74EFD69D, 0xCAED290C, 0x5C48AE2C,
+		0xB304A0DF, 0x25A127FF, 0x9BA3D86E, 0x0D065F4E,
+		0x81AF66F2, 0x170AE1D2, 0xA9081E43, 0x3FAD9963,
+		0xD0E19790, 0x464410B0, 0xF846EF21, 0x6EE36801,
+		0x23328436, 0xB5970316, 0x0B95FC87, 0x9D307BA7,
+		0x727C7554, 0xE4D9F274, 0x5ADB0DE5, 0xCC7E8AC5,
+		0xC178D58B, 0x57DD52AB, 0xE9DFAD3A, 0x7F7A2A1A,
+		0x903624E9, 0x0693A3C9, 0xB8915C58, 0x2E34DB78,
+		0x63E5374F, 0xF540B06F, 0x4B424FFE, 0xDDE7C8DE,
+		0x32ABC62D, 0xA40E410D, 0x1A0CBE9C, 0x8CA939BC,
+		0x06B2BB15, 0x90173C35, 0x2E15C3A4, 0xB8B04484,
+		0x57FC4A77, 0xC159CD57, 0x7F5B32C6, 0xE9FEB5E6,
+		0xA42F59D1, 0x328ADEF1, 0x8C882160, 0x1A2DA640,
+		0xF561A8B3, 0x63C42F93, 0xDDC6D002, 0x4B635722,
+		0x4665086C, 0xD0C08F4C, 0x6EC270DD, 0xF867F7FD,
+		0x172BF90E, 0x818E7E2E, 0x3F8C81BF, 0xA929069F,
+		0xE4F8EAA8, 0x725D6D88, 0xCC5F9219, 0x5AFA1539,
+		0xB5B61BCA, 0x23139CEA, 0x9D11637B, 0x0BB4E45B,
+		0x871DDDE7, 0x11B85AC7, 0xAFBAA556, 0x391F2276,
+		0xD6532C85, 0x40F6ABA5, 0xFEF45434, 0x6851D314,
+		0x25803F23, 0xB325B803, 0x0D274792, 0x9B82C0B2,
+		0x74CECE41, 0xE26B4961, 0x5C69B6F0, 0xCACC31D0,
+		0xC7CA6E9E, 0x516FE9BE, 0xEF6D162F, 0x79C8910F,
+		0x96849FFC, 0x002118DC, 0xBE23E74D, 0x2886606D,
+		0x65578C5A, 0xF3F20B7A, 0x4DF0F4EB, 0xDB5573CB,
+		0x34197D38, 0xA2BCFA18, 0x1CBE0589, 0x8A1B82A9,
+		0x0D65762A, 0x9BC0F10A, 0x25C20E9B, 0xB36789BB,
+		0x5C2B8748, 0xCA8E0068, 0x748CFFF9, 0xE22978D9,
+		0xAFF894EE, 0x395D13CE, 0x875FEC5F, 0x11FA6B7F,
+		0xFEB6658C, 0x6813E2AC, 0xD6111D3D, 0x40B49A1D,
+		0x4DB2C553, 0xDB174273, 0x6515BDE2, 0xF3B03AC2,
+		0x1CFC3431, 0x8A59B311, 0x345B4C80, 0xA2FECBA0,
+		0xEF2F2797, 0x798AA0B7, 0xC7885F26, 0x512DD806,
+		0xBE61D6F5, 0x28C451D5, 0x96C6AE44, 0x00632964,
+		0x8CCA10D8, 0x1A6F97F8, 0xA46D6869, 0x32C8EF49,
+		0xDD84E1BA, 0x4B21669A, 0xF523990B, 0x63861E2B,
+		0x2E57F21C, 0xB8F2753C, 0x06F08AAD, 0x90550D8D,
+		0x7F19037E, 0xE9BC845E, 0x57BE7BCF, 0xC11BFCEF,
+		0xCC1DA3A1, 0x5AB82481, 0xE4BADB10, 0x721F5C30,
+		0x9D5352C3, 0x0BF6D5E3, 0xB5F42A72, 0x2351AD52,
+		0x6E804165, 0xF825C645, 0x462739D4, 0xD082BEF4,
+		0x3FCEB007, 0xA96B3727, 0x1769C8B6, 0x81CC4F96,
+		0x0BD7CD3F, 0x9D724A1F, 0x2370B58E, 0xB5D532AE,
+		0x5A993C5D, 0xCC3CBB7D, 0x723E44EC, 0xE49BC3CC,
+		0xA94A2FFB, 0x3FEFA8DB, 0x81ED574A, 0x1748D06A,
+		0xF804DE99, 0x6EA159B9, 0xD0A3A628, 0x46062108,
+		0x4B007E46, 0xDDA5F966, 0x63A706F7, 0xF50281D7,
+		0x1A4E8F24, 0x8CEB0804, 0x32E9F795, 0xA44C70B5,
+		0xE99D9C82, 0x7F381BA2, 0xC13AE433, 0x579F6313,
+		0xB8D36DE0, 0x2E76EAC0, 0x90741551, 0x06D19271,
+		0x8A78ABCD, 0x1CDD2CED, 0xA2DFD37C, 0x347A545C,
+		0xDB365AAF, 0x4D93DD8F, 0xF391221E, 0x6534A53E,
+		0x28E54909, 0xBE40CE29, 0x004231B8, 0x96E7B698,
+		0x79ABB86B, 0xEF0E3F4B, 0x510CC0DA, 0xC7A947FA,
+		0xCAAF18B4, 0x5C0A9F94, 0xE2086005, 0x74ADE725,
+		0x9BE1E9D6, 0x0D446EF6, 0xB3469167, 0x25E31647,
+		0x6832FA70, 0xFE977D50, 0x409582C1, 0xD63005E1,
+		0x397C0B12, 0xAFD98C32, 0x11DB73A3, 0x877EF483
+	}
+};
+
+static const uint32 crc32c_short_shift[4][256] = {
+	{
+		0x00000000, 0xDCB17AA4, 0xBC8E83B9, 0x603FF91D,
+		0x7CF17183, 0xA0400B27, 0xC07FF23A, 0x1CCE889E,
+		0xF9E2E306, 0x255399A2, 0x456C60BF, 0x99DD1A1B,
+		0x85139285, 0x59A2E821, 0x399D113C, 0xE52C6B98,
+		0xF629B0FD, 0x2A98CA59, 0x4AA73344, 0x961649E0,
+		0x8AD8C17E, 0x5669BBDA, 0x365642C7, 0xEAE73863,
+		0x0FCB53FB, 0xD37A295F, 0xB345D042, 0x6FF4AAE6,
+		0x733A2278, 0xAF8B58DC, 0xCFB4A1C1, 0x1305DB65,
+		0xE9BF170B, 0x350E6DAF, 0x553194B2, 0x8980EE16,
+		0x954E6688, 0x49FF1C2C, 0x29C0E531, 0xF5719F95,
+		0x105DF40D, 0xCCEC8EA9, 0xACD377B4, 0x70620D10,
+		0x6CAC858E, 0xB01DFF2A, 0xD0220637, 0x0C937C93,
+		0x1F96A7F6, 0xC327DD52, 0xA318244F, 0x7FA95EEB,
+		0x6367D675, 0xBFD6ACD1, 0xDFE955CC, 0x03582F68,
+		0xE67444F0, 0x3AC53E54, 0x5AFAC749, 0x864BBDED,
+		0x9A853573, 0x46344FD7, 0x260BB6CA, 0xFABACC6E,
+		0xD69258E7, 0x0A232243, 0x6A1CDB5E, 0xB6ADA1FA,
+		0xAA632964, 0x76D253C0, 0x16EDAADD, 0xCA5CD079,
+		0x2F70BBE1, 0xF3C1C145, 0x93FE3858, 0x4F4F42FC,
+		0x5381CA62, 0x8F30B0C6, 0xEF0F49DB, 0x33BE337F,
+		0x20BBE81A, 0xFC0A92BE, 0x9C356BA3, 0x40841107,
+		0x5C4A9999, 0x80FBE33D, 0xE0C41A20, 0x3C756084,
+		0xD9590B1C, 0x05E871B8, 0x65D788A5, 0xB966F201,
+		0xA5A87A9F, 0x7919003B, 0x1926F926, 0xC5978382,
+		0x3F2D4FEC, 0xE39C3548, 0x83A3CC55, 0x5F12B6F1,
+		0x43DC3E6F, 0x9F6D44CB, 0xFF52BDD6, 0x23E3C772,
+		0xC6CFACEA, 0x1A7ED64E, 0x7A412F53, 0xA6F055F7,
+		0xBA3EDD69, 0x668FA7CD, 0x06B05ED0, 0xDA012474,
+		0xC904FF11, 0x15B585B5, 0x758A7CA8, 0xA93B060C,
+		0xB5F58E92, 0x6944F436, 0x097B0D2B, 0xD5CA778F,
+		0x30E61C17, 0xEC5766B3, 0x8C689FAE, 0x50D9E50A,
+		0x4C176D94, 0x90A61730, 0xF099EE2D, 0x2C289489,
+		0xA8C8C73F, 0x7479BD9B, 0x14464486, 0xC8F73E22,
+		0xD439B6BC, 0x0888CC18, 0x68B73505, 0xB4064FA1,
+		0x512A2439, 0x8D9B5E9D, 0xEDA4A780, 0x3115DD24,
+		0x2DDB55BA, 0xF16A2F1E, 0x9155D603, 0x4DE4ACA7,
+		0x5EE177C2, 0x82500D66, 0xE26FF47B, 0x3EDE8EDF,
+		0x22100641, 0xFEA17CE5, 0x9E9E85F8, 0x422FFF5C,
+		0xA70394C4, 0x7BB2EE60, 0x1B8D177D, 0xC73C6DD9,
+		0xDBF2E547, 0x07439FE3, 0x677C66FE, 0xBBCD1C5A,
+		0x4177D034, 0x9DC6AA90, 0xFDF9538D, 0x21482929,
+		0x3D86A1B7, 0xE137DB13, 0x8108220E, 0x5DB958AA,
+		0xB8953332, 0x64244996, 0x041BB08B, 0xD8AACA2F,
+		0xC46442B1, 0x18D53815, 0x78EAC108, 0xA45BBBAC,
+		0xB75E60C9, 0x6BEF1A6D, 0x0BD0E370, 0xD76199D4,
+		0xCBAF114A, 0x171E6BEE, 0x772192F3, 0xAB90E857,
+		0x4EBC83CF, 0x920DF96B, 0xF2320076, 0x2E837AD2,
+		0x324DF24C, 0xEEFC88E8, 0x8EC371F5, 0x52720B51,
+		0x7E5A9FD8, 0xA2EBE57C, 0xC2D41C61, 0x1E6566C5,
+		0x02ABEE5B, 0xDE1A94FF, 0xBE256DE2, 0x62941746,
+		0x87B87CDE, 0x5B09067A, 0x3B36FF67, 0xE78785C3,
+		0xFB490D5D, 0x27F877F9, 0x47C78EE4, 0x9B76F440,
+		0x88732F25, 0x54C25581, 0x34FDAC9C, 0xE84CD638,
+		0xF4825EA6, 0x28332402, 0x480CDD1F, 0x94BDA7BB,
+		0x7191CC23, 0xAD20B687, 0xCD1F4F9A, 0x11AE353E,
+		0x0D60BDA0, 0xD1D1C704, 0xB1EE3E19, 0x6D5F44BD,
+		0x97E588D3, 0x4B54F277, 0x2B6B0B6A, 0xF7DA71CE,
+		0xEB14F950, 0x37A583F4, 0x579A7AE9, 0x8B2B004D,
+		0x6E076BD5, 0xB2B61171, 0xD289E86C, 0x0E3892C8,
+		0x12F61A56, 0xCE4760F2, 0xAE7899EF, 0x72C9E34B,
+		0x61CC382E, 0xBD7D428A, 0xDD42BB97, 0x01F3C133,
+		0x1D3D49AD, 0xC18C3309, 0xA1B3CA14, 0x7D02B0B0,
+		0x982EDB28, 0x449FA18C, 0x24A05891, 0xF8112235,
+		0xE4DFAAAB, 0x386ED00F, 0x58512912, 0x84E053B6
+	},
+	{
+		0x00000000, 0x547DF88F, 0xA8FBF11E, 0xFC860991,
+		0x541B94CD, 0x00666C42, 0xFCE065D3, 0xA89D9D5C,
+		0xA837299A, 0xFC4AD115, 0x00CCD884, 0x54B1200B,
+		0xFC2CBD57, 0xA85145D8, 0x54D74C49, 0x00AAB4C6,
+		0x558225C5, 0x01FFDD4A, 0xFD79D4DB, 0xA9042C54,
+		0x0199B108, 0x55E44987, 0xA9624016, 0xFD1FB899,
+		0xFDB50C5F, 0xA9C8F4D0, 0x554EFD41, 0x013305CE,
+		0xA9AE9892, 0xFDD3601D, 0x0155698C, 0x55289103,
+		0xAB044B8A, 0xFF79B305, 0x03FFBA94, 0x5782421B,
+		0xFF1FDF47, 0xAB6227C8, 0x57E42E59, 0x0399D6D6,
+		0x03336210, 0x574E9A9F, 0xABC8930E, 0xFFB56B81,
+		0x5728F6DD, 0x03550E52, 0xFFD307C3, 0xABAEFF4C,
+		0xFE866E4F, 0xAAFB96C0, 0x567D9F51, 0x020067DE,
+		0xAA9DFA82, 0xFEE0020D, 0x02660B9C, 0x561BF313,
+		0x56B147D5, 0x02CCBF5A, 0xFE4AB6CB, 0xAA374E44,
+		0x02AAD318, 0x56D72B97, 0xAA512206, 0xFE2CDA89,
+		0x53E4E1E5, 0x0799196A, 0xFB1F10FB, 0xAF62E874,
+		0x07FF7528, 0x53828DA7, 0xAF048436, 0xFB797CB9,
+		0xFBD3C87F, 0xAFAE30F0, 0x53283961, 0x0755C1EE,
+		0xAFC85CB2, 0xFBB5A43D, 0x0733ADAC, 0x534E5523,
+		0x0666C420, 0x521B3CAF, 0xAE9D353E, 0xFAE0CDB1,
+		0x527D50ED, 0x0600A862, 0xFA86A1F3, 0xAEFB597C,
+		0xAE51EDBA, 0xFA2C1535, 0x06AA1CA4, 0x52D7E42B,
+		0xFA4A7977, 0xAE3781F8, 0x52B18869, 0x06CC70E6,
+		0xF8E0AA6F, 0xAC9D52E0, 0x501B5B71, 0x0466A3FE,
+		0xACFB3EA2, 0xF886C62D, 0x0400CFBC, 0x507D3733,
+		0x50D783F5, 0x04AA7B7A, 0xF82C72EB, 0xAC518A64,
+		0x04CC1738, 0x50B1EFB7, 0xAC37E626, 0xF84A1EA9,
+		0xAD628FAA, 0xF91F7725, 0x05997EB4, 0x51E4863B,
+		0xF9791B67, 0xAD04E3E8, 0x5182EA79, 0x05FF12F6,
+		0x0555A630, 0x51285EBF, 0xADAE572E, 0xF9D3AFA1,
+		0x514E32FD, 0x0533CA72, 0xF9B5C3E3, 0xADC83B6C,
+		0xA7C9C3CA, 0xF3B43B45, 0x0F3232D4, 0x5B4FCA5B,
+		0xF3D25707, 0xA7AFAF88, 0x5B29A619, 0x0F545E96,
+		0x0FFEEA50, 0x5B8312DF, 0xA7051B4E, 0xF378E3C1,
+		0x5BE57E9D, 0x0F988612, 0xF31E8F83, 0xA763770C,
+		0xF24BE60F, 0xA6361E80, 0x5AB01711, 0x0ECDEF9E,
+		0xA65072C2, 0xF22D8A4D, 0x0EAB83DC, 0x5AD67B53,
+		0x5A7CCF95, 0x0E01371A, 0xF2873E8B, 0xA6FAC604,
+		0x0E675B58, 0x5A1AA3D7, 0xA69CAA46, 0xF2E152C9,
+		0x0CCD8840, 0x58B070CF, 0xA436795E, 0xF04B81D1,
+		0x58D61C8D, 0x0CABE402, 0xF02DED93, 0xA450151C,
+		0xA4FAA1DA, 0xF0875955, 0x0C0150C4, 0x587CA84B,
+		0xF0E13517, 0xA49CCD98, 0x581AC409, 0x0C673C86,
+		0x594FAD85, 0x0D32550A, 0xF1B45C9B, 0xA5C9A414,
+		0x0D543948, 0x5929C1C7, 0xA5AFC856, 0xF1D230D9,
+		0xF178841F, 0xA5057C90, 0x59837501, 0x0DFE8D8E,
+		0xA56310D2, 0xF11EE85D, 0x0D98E1CC, 0x59E51943,
+		0xF42D222F, 0xA050DAA0, 0x5CD6D331, 0x08AB2BBE,
+		0xA036B6E2, 0xF44B4E6D, 0x08CD47FC, 0x5CB0BF73,
+		0x5C1A0BB5, 0x0867F33A, 0xF4E1FAAB, 0xA09C0224,
+		0x08019F78, 0x5C7C67F7, 0xA0FA6E66, 0xF48796E9,
+		0xA1AF07EA, 0xF5D2FF65, 0x0954F6F4, 0x5D290E7B,
+		0xF5B49327, 0xA1C96BA8, 0x5D4F6239, 0x09329AB6,
+		0x09982E70, 0x5DE5D6FF, 0xA163DF6E, 0xF51E27E1,
+		0x5D83BABD, 0x09FE4232, 0xF5784BA3, 0xA105B32C,
+		0x5F2969A5, 0x0B54912A, 0xF7D298BB, 0xA3AF6034,
+		0x0B32FD68, 0x5F4F05E7, 0xA3C90C76, 0xF7B4F4F9,
+		0xF71E403F, 0xA363B8B0, 0x5FE5B121, 0x0B9849AE,
+		0xA305D4F2, 0xF7782C7D, 0x0BFE25EC, 0x5F83DD63,
+		0x0AAB4C60, 0x5ED6B4EF, 0xA250BD7E, 0xF62D45F1,
+		0x5EB0D8AD, 0x0ACD2022, 0xF64B29B3, 0xA236D13C,
+		0xA29C65FA, 0xF6E19D75, 0x0A6794E4, 0x5E1A6C6B,
+		0xF687F137, 0xA2FA09B8, 0x5E7C0029, 0x0A01F8A6
+	},
+	{
+		0x00000000, 0x4A7FF165, 0x94FFE2CA, 0xDE8013AF,
+		0x2C13B365, 0x666C4200, 0xB8EC51AF, 0xF293A0CA,
+		0x582766CA, 0x125897AF, 0xCCD88400, 0x86A77565,
+		0x7434D5AF, 0x3E4B24CA, 0xE0CB3765, 0xAAB4C600,
+		0xB04ECD94, 0xFA313CF1, 0x24B12F5E, 0x6ECEDE3B,
+		0x9C5D7EF1, 0xD6228F94, 0x08A29C3B, 0x42DD6D5E,
+		0xE869AB5E, 0xA2165A3B, 0x7C964994, 0x36E9B8F1,
+		0xC47A183B, 0x8E05E95E, 0x5085FAF1, 0x1AFA0B94,
+		0x6571EDD9, 0x2F0E1CBC, 0xF18E0F13, 0xBBF1FE76,
+		0x49625EBC, 0x031DAFD9, 0xDD9DBC76, 0x97E24D13,
+		0x3D568B13, 0x77297A76, 0xA9A969D9, 0xE3D698BC,
+		0x11453876, 0x5B3AC913, 0x85BADABC, 0xCFC52BD9,
+		0xD53F204D, 0x9F40D128, 0x41C0C287, 0x0BBF33E2,
+		0xF92C9328, 0xB353624D, 0x6DD371E2, 0x27AC8087,
+		0x8D184687, 0xC767B7E2, 0x19E7A44D, 0x53985528,
+		0xA10BF5E2, 0xEB740487, 0x35F41728, 0x7F8BE64D,
+		0xCAE3DBB2, 0x809C2AD7, 0x5E1C3978, 0x1463C81D,
+		0xE6F068D7, 0xAC8F99B2, 0x720F8A1D, 0x38707B78,
+		0x92C4BD78, 0xD8BB4C1D, 0x063B5FB2, 0x4C44AED7,
+		0xBED70E1D, 0xF4A8FF78, 0x2A28ECD7, 0x60571DB2,
+		0x7AAD1626, 0x30D2E743, 0xEE52F4EC, 0xA42D0589,
+		0x56BEA543, 0x1CC15426, 0xC2414789, 0x883EB6EC,
+		0x228A70EC, 0x68F58189, 0xB6759226, 0xFC0A6343,
+		0x0E99C389, 0x44E632EC, 0x9A662143, 0xD019D026,
+		0xAF92366B, 0xE5EDC70E, 0x3B6DD4A1, 0x711225C4,
+		0x8381850E, 0xC9FE746B, 0x177E67C4, 0x5D0196A1,
+		0xF7B550A1, 0xBDCAA1C4, 0x634AB26B, 0x2935430E,
+		0xDBA6E3C4, 0x91D912A1, 0x4F59010E, 0x0526F06B,
+		0x1FDCFBFF, 0x55A30A9A, 0x8B231935, 0xC15CE850,
+		0x33CF489A, 0x79B0B9FF, 0xA730AA50, 0xED4F5B35,
+		0x47FB9D35, 0x0D846C50, 0xD3047FFF, 0x997B8E9A,
+		0x6BE82E50, 0x2197DF35, 0xFF17CC9A, 0xB5683DFF,
+		0x902BC195, 0xDA5430F0, 0x04D4235F, 0x4EABD23A,
+		0xBC3872F0, 0xF6478395, 0x28C7903A, 0x62B8615F,
+		0xC80CA75F, 0x8273563A, 0x5CF34595, 0x168CB4F0,
+		0xE41F143A, 0xAE60E55F, 0x70E0F6F0, 0x3A9F0795,
+		0x20650C01, 0x6A1AFD64, 0xB49AEECB, 0xFEE51FAE,
+		0x0C76BF64, 0x46094E01, 0x98895DAE, 0xD2F6ACCB,
+		0x78426ACB, 0x323D9BAE, 0xECBD8801, 0xA6C27964,
+		0x5451D9AE, 0x1E2E28CB, 0xC0AE3B64, 0x8AD1CA01,
+		0xF55A2C4C, 0xBF25DD29, 0x61A5CE86, 0x2BDA3FE3,
+		0xD9499F29, 0x93366E4C, 0x4DB67DE3, 0x07C98C86,
+		0xAD7D4A86, 0xE702BBE3, 0x3982A84C, 0x73FD5929,
+		0x816EF9E3, 0xCB110886, 0x15911B29, 0x5FEEEA4C,
+		0x4514E1D8, 0x0F6B10BD, 0xD1EB0312, 0x9B94F277,
+		0x690752BD, 0x2378A3D8, 0xFDF8B077, 0xB7874112,
+		0x1D338712, 0x574C7677, 0x89CC65D8, 0xC3B394BD,
+		0x31203477, 0x7B5FC512, 0xA5DFD6BD, 0xEFA027D8,
+		0x5AC81A27, 0x10B7EB42, 0xCE37F8ED, 0x84480988,
+		0x76DBA942, 0x3CA45827, 0xE2244B88, 0xA85BBAED,
+		0x02EF7CED, 0x48908D88, 0x96109E27, 0xDC6F6F42,
+		0x2EFCCF88, 0x64833EED, 0xBA032D42, 0xF07CDC27,
+		0xEA86D7B3, 0xA0F926D6, 0x7E793579, 0x3406C41C,
+		0xC69564D6, 0x8CEA95B3, 0x526A861C, 0x18157779,
+		0xB2A1B179, 0xF8DE401C, 0x265E53B3, 0x6C21A2D6,
+		0x9EB2021C, 0xD4CDF379, 0x0A4DE0D6, 0x403211B3,
+		0x3FB9F7FE, 0x75C6069B, 0xAB461534, 0xE139E451,
+		0x13AA449B, 0x59D5B5FE, 0x8755A651, 0xCD2A5734,
+		0x679E9134, 0x2DE16051, 0xF36173FE, 0xB91E829B,
+		0x4B8D2251, 0x01F2D334, 0xDF72C09B, 0x950D31FE,
+		0x8FF73A6A, 0xC588CB0F, 0x1B08D8A0, 0x517729C5,
+		0xA3E4890F, 0xE99B786A, 0x371B6BC5, 0x7D649AA0,
+		0xD7D05CA0, 0x9DAFADC5, 0x432FBE6A, 0x09504F0F,
+		0xFBC3EFC5, 0xB1BC1EA0, 0x6F3C0D0F, 0x2543FC6A
+	},
+	{
+		0x00000000, 0x25BBF5DB, 0x4B77EBB6, 0x6ECC1E6D,
+		0x96EFD76C, 0xB35422B7, 0xDD983CDA, 0xF823C901,
+		0x2833D829, 0x0D882DF2, 0x6344339F, 0x46FFC644,
+		0xBEDC0F45, 0x9B67FA9E, 0xF5ABE4F3, 0xD0101128,
+		0x5067B052, 0x75DC4589, 0x1B105BE4, 0x3EABAE3F,
+		0xC688673E, 0xE33392E5, 0x8DFF8C88, 0xA8447953,
+		0x7854687B, 0x5DEF9DA0, 0x332383CD, 0x16987616,
+		0xEEBBBF17, 0xCB004ACC, 0xA5CC54A1, 0x8077A17A,
+		0xA0CF60A4, 0x8574957F, 0xEBB88B12, 0xCE037EC9,
+		0x3620B7C8, 0x139B4213, 0x7D575C7E, 0x58ECA9A5,
+		0x88FCB88D, 0xAD474D56, 0xC38B533B, 0xE630A6E0,
+		0x1E136FE1, 0x3BA89A3A, 0x55648457, 0x70DF718C,
+		0xF0A8D0F6, 0xD513252D, 0xBBDF3B40, 0x9E64CE9B,
+		0x6647079A, 0x43FCF241, 0x2D30EC2C, 0x088B19F7,
+		0xD89B08DF, 0xFD20FD04, 0x93ECE369, 0xB65716B2,
+		0x4E74DFB3, 0x6BCF2A68, 0x05033405, 0x20B8C1DE,
+		0x4472B7B9, 0x61C94262, 0x0F055C0F, 0x2ABEA9D4,
+		0xD29D60D5, 0xF726950E, 0x99EA8B63, 0xBC517EB8,
+		0x6C416F90, 0x49FA9A4B, 0x27368426, 0x028D71FD,
+		0xFAAEB8FC, 0xDF154D27, 0xB1D9534A, 0x9462A691,
+		0x141507EB, 0x31AEF230, 0x5F62EC5D, 0x7AD91986,
+		0x82FAD087, 0xA741255C, 0xC98D3B31, 0xEC36CEEA,
+		0x3C26DFC2, 0x199D2A19, 0x77513474, 0x52EAC1AF,
+		0xAAC908AE, 0x8F72FD75, 0xE1BEE318, 0xC40516C3,
+		0xE4BDD71D, 0xC10622C6, 0xAFCA3CAB, 0x8A71C970,
+		0x72520071, 0x57E9F5AA, 0x3925EBC7, 0x1C9E1E1C,
+		0xCC8E0F34, 0xE935FAEF, 0x87F9E482, 0xA2421159,
+		0x5A61D858, 0x7FDA2D83, 0x111633EE, 0x34ADC635,
+		0xB4DA674F, 0x91619294, 0xFFAD8CF9, 0xDA167922,
+		0x2235B023, 0x078E45F8, 0x69425B95, 0x4CF9AE4E,
+		0x9CE9BF66, 0xB9524ABD, 0xD79E54D0, 0xF225A10B,
+		0x0A06680A, 0x2FBD9DD1, 0x417183BC, 0x64CA7667,
+		0x88E56F72, 0xAD5E9AA9, 0xC39284C4, 0xE629711F,
+		0x1E0AB81E, 0x3BB14DC5, 0x557D53A8, 0x70C6A673,
+		0xA0D6B75B, 0x856D4280, 0xEBA15CED, 0xCE1AA936,
+		0x36396037, 0x138295EC, 0x7D4E8B81, 0x58F57E5A,
+		0xD882DF20, 0xFD392AFB, 0x93F53496, 0xB64EC14D,
+		0x4E6D084C, 0x6BD6FD97, 0x051AE3FA, 0x20A11621,
+		0xF0B10709, 0xD50AF2D2, 0xBBC6ECBF, 0x9E7D1964,
+		0x665ED065, 0x43E525BE, 0x2D293BD3, 0x0892CE08,
+		0x282A0FD6, 0x0D91FA0D, 0x635DE460, 0x46E611BB,
+		0xBEC5D8BA, 0x9B7E2D61, 0xF5B2330C, 0xD009C6D7,
+		0x0019D7FF, 0x25A22224, 0x4B6E3C49, 0x6ED5C992,
+		0x96F60093, 0xB34DF548, 0xDD81EB25, 0xF83A1EFE,
+		0x784DBF84, 0x5DF64A5F, 0x333A5432, 0x1681A1E9,
+		0xEEA268E8, 0xCB199D33, 0xA5D5835E, 0x806E7685,
+		0x507E67AD, 0x75C59276, 0x1B098C1B, 0x3EB279C0,
+		0xC691B0C1, 0xE32A451A, 0x8DE65B77, 0xA85DAEAC,
+		0xCC97D8CB, 0xE92C2D10, 0x87E0337D, 0xA25BC6A6,
+		0x5A780FA7, 0x7FC3FA7C, 0x110FE411, 0x34B411CA,
+		0xE4A400E2, 0xC11FF539, 0xAFD3EB54, 0x8A681E8F,
+		0x724BD78E, 0x57F02255, 0x393C3C38, 0x1C87C9E3,
+		0x9CF06899, 0xB94B9D42, 0xD787832F, 0xF23C76F4,
+		0x0A1FBFF5, 0x2FA44A2E, 0x41685443, 0x64D3A198,
+		0xB4C3B0B0, 0x9178456B, 0xFFB45B06, 0xDA0FAEDD,
+		0x222C67DC, 0x07979207, 0x695B8C6A, 0x4CE079B1,
+		0x6C58B86F, 0x49E34DB4, 0x272F53D9, 0x0294A602,
+		0xFAB76F03, 0xDF0C9AD8, 0xB1C084B5, 0x947B716E,
+		0x446B6046, 0x61D0959D, 0x0F1C8BF0, 0x2AA77E2B,
+		0xD284B72A, 0xF73F42F1, 0x99F35C9C, 0xBC48A947,
+		0x3C3F083D, 0x1984FDE6, 0x7748E38B, 0x52F31650,
+		0xAAD0DF51, 0x8F6B2A8A, 0xE1A734E7, 0xC41CC13C,
+		0x140CD014, 0x31B725CF, 0x5F7B3BA2, 0x7AC0CE79,
+		0x82E30778, 0xA758F2A3, 0xC994ECCE, 0xEC2F1915
+	}
+};
+#endif							/* __x86_64__ */
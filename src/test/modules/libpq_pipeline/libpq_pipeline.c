@@ -0,0 +1,382 @@
+/*-------------------------------------------------------------------------
+ *
+ * libpq_pipeline.c
+ *		Verify libpq pipeline execution functionality
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *		src/test/modules/libpq_pipeline/libpq_pipeline.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres_fe.h"
+
+#include "catalog/pg_type_d.h"
+#include "libpq-fe.h"
+
+
+static void exit_nicely(PGconn *conn) pg_attribute_noreturn();
+static void pg_fatal_impl(int line, const char *fmt,...)
+			pg_attribute_printf(2, 3) pg_attribute_noreturn();
+
+static const char *const drop_table_sql =
+"DROP TABLE IF EXISTS pq_pipeline_demo";
+static const char *const create_table_sql =
+"CREATE UNLOGGED TABLE pq_pipeline_demo(id serial primary key, itemno integer);";
+static const char *const insert_sql =
+"INSERT INTO pq_pipeline_demo(itemno) VALUES ($1) RETURNING id";
+
+/* number of commands sent in the result ordering test */
+#define NUM_ORDERED_COMMANDS	100
+
+static PGconn *conn = NULL;
+
+static void
+exit_nicely(PGconn *conn)
+{
+	PQfinish(conn);
+	exit(1);
+}
+
+/*
+ * Print an error to stderr and terminate the program.
+ */
+#define pg_fatal(...) pg_fatal_impl(__LINE__, __VA_ARGS__)
+static void
+pg_fatal_impl(int line, const char *fmt,...)
+{
+	va_list		args;
+
+	fflush(stdout);
+
+	fprintf(stderr, "\n(libpq_pipeline:%d): ", line);
+	va_start(args, fmt);
+	vfprintf(stderr, fmt, args);
+	va_end(args);
+	Assert(fmt[strlen(fmt) - 1] != '\n');
+	fprintf(stderr, "\n");
+	exit_nicely(conn);
+}
+
+/*
+ * Read the next result and check that its status is as expected.
+ */
+static PGresult *
+expect_result(ExecStatusType expected, const char *what)
+{
+	PGresult   *res = PQgetResult(conn);
+
+	if (res == NULL)
+		pg_fatal("%s: unexpected NULL result: %s", what, PQerrorMessage(conn));
+	if (PQresultStatus(res) != expected)
+		pg_fatal("%s: got status %s, expected %s: %s", what,
+				 PQresStatus(PQresultStatus(res)), PQresStatus(expected),
+				 PQerrorMessage(conn));
+	return res;
+}
+
+/*
+ * Read the NULL that ends each command's results in pipeline mode.
+ */
+static void
+expect_null(const char *what)
+{
+	PGresult   *res = PQgetResult(conn);
+
+	if (res != NULL)
+		pg_fatal("%s: expected NULL result, got %s", what,
+				 PQresStatus(PQresultStatus(res)));
+}
+
+/*
+ * The simplest case: one command and a sync point.
+ */
+static void
+test_simple_pipeline(void)
+{
+	PGresult   *res;
+	const char *dummy_params[1] = {"1"};
+	Oid			dummy_param_oids[1] = {INT4OID};
+
+	fprintf(stderr, "simple pipeline... ");
+
+	if (PQpipelineStatus(conn) != PQ_PIPELINE_OFF)
+		pg_fatal("normal mode reported as pipeline mode");
+	if (PQenterPipelineMode(conn) != 1)
+		pg_fatal("failed to enter pipeline mode: %s", PQerrorMessage(conn));
+	if (PQpipelineStatus(conn) != PQ_PIPELINE_ON)
+		pg_fatal("pipeline mode not reported after entering it");
+
+	/* the simple query protocol isn't allowed in pipeline mode */
+	if (PQsendQuery(conn, "SELECT 1") == 1)
+		pg_fatal("PQsendQuery succeeded in pipeline mode");
+
+	if (PQsendQueryParams(conn, "SELECT $1",
+						  1, dummy_param_oids, dummy_params,
+						  NULL, NULL, 0) != 1)
+		pg_fatal("dispatching SELECT failed: %s", PQerrorMessage(conn));
+
+	/* can't leave pipeline mode with a command in flight */
+	if (PQexitPipelineMode(conn) != 0)
+		pg_fatal("exiting pipeline mode with work in progress should fail");
+
+	if (PQpipelineSync(conn) != 1)
+		pg_fatal("pipeline sync failed: %s", PQerrorMessage(conn));
+
+	res = expect_result(PGRES_TUPLES_OK, "SELECT");
+	if (PQntuples(res) != 1 || strcmp(PQgetvalue(res, 0, 0), "1") != 0)
+		pg_fatal("SELECT returned wrong result");
+	PQclear(res);
+	expect_null("SELECT");
+
+	res = expect_result(PGRES_PIPELINE_SYNC, "sync");
+	PQclear(res);
+
+	if (PQexitPipelineMode(conn) != 1)
+		pg_fatal("exiting pipeline mode after sync failed: %s",
+				 PQerrorMessage(conn));
+	if (PQpipelineStatus(conn) != PQ_PIPELINE_OFF)
+		pg_fatal("pipeline mode still reported after leaving it");
+
+	fprintf(stderr, "ok\n");
+}
+
+/*
+ * A command that fails aborts the rest of the pipeline up to the next sync
+ * point; after that, new commands run again.
+ */
+static void
+test_pipeline_abort(void)
+{
+	PGresult   *res;
+	const char *dummy_params[1] = {"1"};
+	Oid			dummy_param_oids[1] = {INT4OID};
+	int			i;
+
+	fprintf(stderr, "aborted pipeline... ");
+
+	res = PQexec(conn, drop_table_sql);
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		pg_fatal("dispatching DROP TABLE failed: %s", PQerrorMessage(conn));
+	PQclear(res);
+
+	res = PQexec(conn, create_table_sql);
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		pg_fatal("dispatching CREATE TABLE failed: %s", PQerrorMessage(conn));
+	PQclear(res);
+
+	if (PQenterPipelineMode(conn) != 1)
+		pg_fatal("failed to enter pipeline mode: %s", PQerrorMessage(conn));
+
+	/* an insert that works, one that fails, and one that gets skipped */
+	dummy_params[0] = "1";
+	if (PQsendQueryParams(conn, insert_sql, 1, dummy_param_oids,
+						  dummy_params, NULL, NULL, 0) != 1)
+		pg_fatal("dispatching first INSERT failed: %s", PQerrorMessage(conn));
+
+	if (PQsendQueryParams(conn, "SELECT no_such_function($1)",
+						  1, dummy_param_oids, dummy_params,
+						  NULL, NULL, 0) != 1)
+		pg_fatal("dispatching erroneous SELECT failed: %s",
+				 PQerrorMessage(conn));
+
+	dummy_params[0] = "2";
+	if (PQsendQueryParams(conn, insert_sql, 1, dummy_param_oids,
+						  dummy_params, NULL, NULL, 0) != 1)
+		pg_fatal("dispatching second INSERT failed: %s",
+				 PQerrorMessage(conn));
+
+	if (PQpipelineSync(conn) != 1)
+		pg_fatal("pipeline sync failed: %s", PQerrorMessage(conn));
+
+	/* this one comes after the sync point, so it runs */
+	dummy_params[0] = "3";
+	if (PQsendQueryParams(conn, insert_sql, 1, dummy_param_oids,
+						  dummy_params, NULL, NULL, 0) != 1)
+		pg_fatal("dispatching third INSERT failed: %s", PQerrorMessage(conn));
+
+	if (PQpipelineSync(conn) != 1)
+		pg_fatal("second pipeline sync failed: %s", PQerrorMessage(conn));
+
+	res = expect_result(PGRES_TUPLES_OK, "first INSERT");
+	PQclear(res);
+	expect_null("first INSERT");
+
+	res = expect_result(PGRES_FATAL_ERROR, "erroneous SELECT");
+	PQclear(res);
+	expect_null("erroneous SELECT");
+
+	if (PQpipelineStatus(conn) != PQ_PIPELINE_ABORTED)
+		pg_fatal("pipeline should be flagged as aborted but isn't");
+
+	res = expect_result(PGRES_PIPELINE_ABORTED, "second INSERT");
+	PQclear(res);
+	expect_null("second INSERT");
+
+	res = expect_result(PGRES_PIPELINE_SYNC, "first sync");
+	PQclear(res);
+
+	if (PQpipelineStatus(conn) != PQ_PIPELINE_ON)
+		pg_fatal("pipeline still flagged as aborted after sync");
+
+	res = expect_result(PGRES_TUPLES_OK, "third INSERT");
+	PQclear(res);
+	expect_null("third INSERT");
+
+	res = expect_result(PGRES_PIPELINE_SYNC, "second sync");
+	PQclear(res);
+
+	if (PQexitPipelineMode(conn) != 1)
+		pg_fatal("exiting pipeline mode failed: %s", PQerrorMessage(conn));
+
+	/* the failed pipeline's transaction was rolled back */
+	res = PQexec(conn, "SELECT itemno FROM pq_pipeline_demo ORDER BY itemno");
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+		pg_fatal("SELECT failed: %s", PQerrorMessage(conn));
+	if (PQntuples(res) != 1)
+		pg_fatal("expected 1 row in pq_pipeline_demo, got %d", PQntuples(res));
+	i = atoi(PQgetvalue(res, 0, 0));
+	if (i != 3)
+		pg_fatal("expected itemno 3 in pq_pipeline_demo, got %d", i);
+	PQclear(res);
+
+	fprintf(stderr, "ok\n");
+}
+
+/*
+ * Many commands sent before reading any result: the results must come back
+ * in the order the commands were sent.
+ */
+static void
+test_result_ordering(void)
+{
+	PGresult   *res;
+	char		buf[32];
+	const char *params[1];
+	Oid			param_oids[1] = {INT4OID};
+	int			i;
+
+	fprintf(stderr, "result ordering... ");
+
+	if (PQenterPipelineMode(conn) != 1)
+		pg_fatal("failed to enter pipeline mode: %s", PQerrorMessage(conn));
+
+	if (PQsendPrepare(conn, "ordered", "SELECT $1::int * 2", 1,
+					  param_oids) != 1)
+		pg_fatal("dispatching PREPARE failed: %s", PQerrorMessage(conn));
+
+	for (i = 0; i < NUM_ORDERED_COMMANDS; i++)
+	{
+		snprintf(buf, sizeof(buf), "%d", i);
+		params[0] = buf;
+		if (PQsendQueryPrepared(conn, "ordered", 1, params,
+								NULL, NULL, 0) != 1)
+			pg_fatal("dispatching command %d failed: %s", i,
+					 PQerrorMessage(conn));
+	}
+
+	if (PQpipelineSync(conn) != 1)
+		pg_fatal("pipeline sync failed: %s", PQerrorMessage(conn));
+
+	res = expect_result(PGRES_COMMAND_OK, "PREPARE");
+	PQclear(res);
+	expect_null("PREPARE");
+
+	for (i = 0; i < NUM_ORDERED_COMMANDS; i++)
+	{
+		int			val;
+
+		res = expect_result(PGRES_TUPLES_OK, "prepared SELECT");
+		if (PQntuples(res) != 1)
+			pg_fatal("command %d returned %d rows, expected 1", i,
+					 PQntuples(res));
+		val = atoi(PQgetvalue(res, 0, 0));
+		if (val != i * 2)
+			pg_fatal("command %d returned %d, expected %d", i, val, i * 2);
+		PQclear(res);
+		expect_null("prepared SELECT");
+	}
+
+	res = expect_result(PGRES_PIPELINE_SYNC, "sync");
+	PQclear(res);
+
+	if (PQexitPipelineMode(conn) != 1)
+		pg_fatal("exiting pipeline mode failed: %s", PQerrorMessage(conn));
+
+	fprintf(stderr, "ok\n");
+}
+
+static void
+usage(const char *progname)
+{
+	fprintf(stderr, "%s tests libpq's pipeline mode.\n\n", progname);
+	fprintf(stderr, "Usage:\n");
+	fprintf(stderr, "  %s tests\n", progname);
+	fprintf(stderr, "  %s TESTNAME [CONNINFO]\n", progname);
+}
+
+static void
+print_test_list(void)
+{
+	printf("simple_pipeline\n");
+	printf("pipeline_abort\n");
+	printf("result_ordering\n");
+}
+
+int
+main(int argc, char **argv)
+{
+	const char *conninfo = "";
+	const char *testname;
+	PGresult   *res;
+
+	if (argc < 2 || argc > 3)
+	{
+		usage(argv[0]);
+		exit(1);
+	}
+
+	testname = argv[1];
+	if (strcmp(testname, "tests") == 0)
+	{
+		print_test_list();
+		exit(0);
+	}
+
+	if (argc == 3)
+		conninfo = argv[2];
+
+	/* Make a connection to the database */
+	conn = PQconnectdb(conninfo);
+	if (PQstatus(conn) != CONNECTION_OK)
+	{
+		fprintf(stderr, "Connection to database failed: %s\n",
+				PQerrorMessage(conn));
+		exit_nicely(conn);
+	}
+
+	res = PQexec(conn, "SET lc_messages TO \"C\"");
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		pg_fatal("failed to set lc_messages: %s", PQerrorMessage(conn));
+	PQclear(res);
+
+	if (strcmp(testname, "simple_pipeline") == 0)
+		test_simple_pipeline();
+	else if (strcmp(testname, "pipeline_abort") == 0)
+		test_pipeline_abort();
+	else if (strcmp(testname, "result_ordering") == 0)
+		test_result_ordering();
+	else
+	{
+		fprintf(stderr, "\"%s\" is not a recognized test name\n", testname);
+		exit(1);
+	}
+
+	/* close the connection to the database and cleanup */
+	PQfinish(conn);
+	return 0;
+}
@@ -0,0 +1,30 @@
+# Test libpq pipeline mode, using the libpq_pipeline test program
+
+use strict;
+use warnings;
+
+use IPC::Run;
+use TestLib;
+use Test::More;
+use PostgresNode;
+
+my $node = get_new_node('main');
+$node->init;
+$node->start;
+
+my $prog = "$ENV{TESTDIR}/libpq_pipeline";
+
+my ($out, $err);
+IPC::Run::run([ $prog, 'tests' ], '>', \$out, '2>', \$err)
+  or die "could not list tests: $err";
+my @tests = split(/\s+/, $out);
+
+plan tests => scalar @tests;
+
+for my $testname (@tests)
+{
+	$node->command_ok([ $prog, $testname, $node->connstr('postgres') ],
+		"libpq_pipeline $testname");
+}
+
+$node->stop('fast');
@@ -0,0 +1,5 @@
+-- TPC-H Q1 style grouped aggregation over the whole accounts table
+SELECT bid, count(*), sum(abalance), avg(abalance), min(aid), max(aid)
+  FROM pgbench_accounts
+ GROUP BY bid
+ ORDER BY bid;
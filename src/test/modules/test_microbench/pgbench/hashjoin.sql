@@ -0,0 +1,6 @@
+-- Hash join of the accounts table against its tellers
+\set bid random(1, :scale)
+SELECT t.tid, count(*), sum(a.abalance)
+  FROM pgbench_accounts a JOIN pgbench_tellers t ON a.bid = t.bid
+ WHERE t.bid = :bid
+ GROUP BY t.tid;
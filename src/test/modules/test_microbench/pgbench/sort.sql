@@ -0,0 +1,7 @@
+-- Sort of a slice of the accounts table on a non-indexed key
+\set aid random(1, 100000 * :scale - 10000)
+SELECT aid, abalance
+  FROM pgbench_accounts
+ WHERE aid BETWEEN :aid AND :aid + 10000
+ ORDER BY filler, abalance
+ OFFSET 9999;
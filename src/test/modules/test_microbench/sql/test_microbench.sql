@@ -0,0 +1,18 @@
+CREATE EXTENSION test_microbench;
+
+-- Timings vary, so only check that the benchmarks ran and what they counted
+SELECT iterations, total_ms >= 0 AS ok FROM bench_tuplesort(1000, 2);
+
+CREATE TABLE bench_tab AS SELECT g AS a, g::text AS b FROM generate_series(1, 100) g;
+CREATE INDEX bench_tab_a_idx ON bench_tab (a);
+SELECT iterations FROM bench_deform('bench_tab', 3);
+SELECT iterations, ns_per_op >= 0 AS ok FROM bench_buffer_lookup('bench_tab', 5);
+SELECT iterations FROM bench_wal_insert(10, 32);
+SELECT iterations FROM bench_query('SELECT count(*) FROM bench_tab x JOIN bench_tab y USING (a)', 2);
+
+-- Invalid arguments
+SELECT * FROM bench_tuplesort(10, 0);
+SELECT * FROM bench_deform('bench_tab_a_idx');
+SELECT * FROM bench_wal_insert(-1);
+
+DROP TABLE bench_tab;
@@ -0,0 +1,44 @@
+/* src/test/modules/test_microbench/test_microbench--1.0.sql */
+
+-- complain if script is sourced in psql, rather than via CREATE EXTENSION
+\echo Use "CREATE EXTENSION test_microbench" to load this file. \quit
+
+CREATE FUNCTION bench_tuplesort(ntuples integer,
+    loops integer DEFAULT 1,
+    OUT iterations bigint,
+    OUT total_ms float8,
+    OUT ns_per_op float8)
+RETURNS record STRICT
+AS 'MODULE_PATHNAME' LANGUAGE C;
+
+CREATE FUNCTION bench_deform(rel regclass,
+    loops integer DEFAULT 1,
+    OUT iterations bigint,
+    OUT total_ms float8,
+    OUT ns_per_op float8)
+RETURNS record STRICT
+AS 'MODULE_PATHNAME' LANGUAGE C;
+
+CREATE FUNCTION bench_buffer_lookup(rel regclass,
+    loops integer DEFAULT 1,
+    OUT iterations bigint,
+    OUT total_ms float8,
+    OUT ns_per_op float8)
+RETURNS record STRICT
+AS 'MODULE_PATHNAME' LANGUAGE C;
+
+CREATE FUNCTION bench_wal_insert(nrecords integer,
+    record_size integer DEFAULT 64,
+    OUT iterations bigint,
+    OUT total_ms float8,
+    OUT ns_per_op float8)
+RETURNS record STRICT
+AS 'MODULE_PATHNAME' LANGUAGE C;
+
+CREATE FUNCTION bench_query(query text,
+    loops integer DEFAULT 1,
+    OUT iterations bigint,
+    OUT total_ms float8,
+    OUT ns_per_op float8)
+RETURNS record STRICT
+AS 'MODULE_PATHNAME' LANGUAGE C;
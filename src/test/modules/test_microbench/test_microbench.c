@@ -0,0 +1,383 @@
+/*--------------------------------------------------------------------------
+ *
+ * test_microbench.c
+ *		Microbenchmarks of backend hot paths.
+ *
+ * Each SQL-callable function here exercises one piece of backend code in a
+ * tight loop and reports how many operations it did and how long they took,
+ * as a single (iterations, total_ms, ns_per_op) row, so that results can be
+ * collected with plain SQL and compared across builds.
+ *
+ * Copyright (c) 2019, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *		src/test/modules/test_microbench/test_microbench.c
+ *
+ * -------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/heapam.h"
+#include "access/htup_details.h"
+#include "access/xlog.h"
+#include "catalog/pg_operator.h"
+#include "catalog/pg_type.h"
+#include "executor/spi.h"
+#include "fmgr.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "portability/instr_time.h"
+#include "replication/message.h"
+#include "storage/bufmgr.h"
+#include "utils/builtins.h"
+#include "utils/rel.h"
+#include "utils/snapmgr.h"
+#include "utils/tuplesort.h"
+
+PG_MODULE_MAGIC;
+
+PG_FUNCTION_INFO_V1(bench_tuplesort);
+PG_FUNCTION_INFO_V1(bench_deform);
+PG_FUNCTION_INFO_V1(bench_buffer_lookup);
+PG_FUNCTION_INFO_V1(bench_wal_insert);
+PG_FUNCTION_INFO_V1(bench_query);
+
+
+/*
+ * Build the result row common to all benchmarks.
+ */
+static Datum
+bench_result(FunctionCallInfo fcinfo, int64 iterations, instr_time elapsed)
+{
+	TupleDesc	tupdesc;
+	Datum		values[3];
+	bool		nulls[3];
+	double		usecs = INSTR_TIME_GET_MICROSEC(elapsed);
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	MemSet(nulls, 0, sizeof(nulls));
+	values[0] = Int64GetDatum(iterations);
+	values[1] = Float8GetDatum(usecs / 1000.0);
+	values[2] = Float8GetDatum(iterations > 0 ?
+							   usecs * 1000.0 / iterations : 0.0);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
+
+static void
+check_loops(int32 loops)
+{
+	if (loops < 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("number of loops must be at least 1")));
+}
+
+/*
+ * Open a relation to benchmark, checking that it has heap storage.
+ */
+static Relation
+bench_open_heap(Oid relid)
+{
+	Relation	rel = relation_open(relid, AccessShareLock);
+
+	if (rel->rd_rel->relkind != RELKIND_RELATION &&
+		rel->rd_rel->relkind != RELKIND_MATVIEW &&
+		rel->rd_rel->relkind != RELKIND_TOASTVALUE)
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("\"%s\" is not a table, materialized view, or TOAST table",
+						RelationGetRelationName(rel))));
+
+	return rel;
+}
+
+/*
+ * bench_tuplesort(ntuples, loops)
+ *
+ * Sort ntuples pseudo-random int4 datums, loops times.  The input
+ * sequence is the same on every run.  Time covers putting, sorting and
+ * fetching the datums.
+ */
+Datum
+bench_tuplesort(PG_FUNCTION_ARGS)
+{
+	int32		ntuples = PG_GETARG_INT32(0);
+	int32		loops = PG_GETARG_INT32(1);
+	instr_time	start,
+				end,
+				elapsed;
+	int			loop;
+
+	check_loops(loops);
+	if (ntuples < 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("number of tuples must not be negative")));
+
+	INSTR_TIME_SET_ZERO(elapsed);
+
+	for (loop = 0; loop < loops; loop++)
+	{
+		Tuplesortstate *state;
+		uint32		seed = 0x2545F491;
+		int32		i;
+		Datum		val;
+		bool		isnull;
+
+		CHECK_FOR_INTERRUPTS();
+
+		INSTR_TIME_SET_CURRENT(start);
+
+		/* like a Sort node, spill to disk if work_mem is exceeded */
+		state = tuplesort_begin_datum(INT4OID, Int4LessOperator, InvalidOid,
+									  false, work_mem, NULL, false);
+
+		for (i = 0; i < ntuples; i++)
+		{
+			/* xorshift32 */
+			seed ^= seed << 13;
+			seed ^= seed >> 17;
+			seed ^= seed << 5;
+			tuplesort_putdatum(state, Int32GetDatum((int32) seed), false);
+		}
+
+		tuplesort_performsort(state);
+
+		while (tuplesort_getdatum(state, true, &val, &isnull, NULL))
+			;
+
+		tuplesort_end(state);
+
+		INSTR_TIME_SET_CURRENT(end);
+		INSTR_TIME_ACCUM_DIFF(elapsed, end, start);
+	}
+
+	return bench_result(fcinfo, (int64) ntuples * loops, elapsed);
+}
+
+/*
+ * bench_deform(rel, loops)
+ *
+ * Scan the table loops times, deforming every attribute of every visible
+ * tuple.  Each tuple deformed counts as one operation.  Time includes the
+ * scan itself; compare with a table of few columns to isolate deforming.
+ */
+Datum
+bench_deform(PG_FUNCTION_ARGS)
+{
+	Oid			relid = PG_GETARG_OID(0);
+	int32		loops = PG_GETARG_INT32(1);
+	Relation	rel;
+	TupleDesc	tupdesc;
+	Datum	   *values;
+	bool	   *isnull;
+	Snapshot	snapshot;
+	instr_time	start,
+				end,
+				elapsed;
+	int64		ntuples = 0;
+	int			loop;
+
+	check_loops(loops);
+
+	rel = bench_open_heap(relid);
+	tupdesc = RelationGetDescr(rel);
+	values = (Datum *) palloc(tupdesc->natts * sizeof(Datum));
+	isnull = (bool *) palloc(tupdesc->natts * sizeof(bool));
+	snapshot = RegisterSnapshot(GetTransactionSnapshot());
+
+	INSTR_TIME_SET_ZERO(elapsed);
+
+	for (loop = 0; loop < loops; loop++)
+	{
+		HeapScanDesc scan;
+		HeapTuple	tuple;
+
+		INSTR_TIME_SET_CURRENT(start);
+
+		scan = heap_beginscan(rel, snapshot, 0, NULL);
+		while ((tuple = heap_getnext(scan, ForwardScanDirection)) != NULL)
+		{
+			CHECK_FOR_INTERRUPTS();
+
+			heap_deform_tuple(tuple, tupdesc, values, isnull);
+			ntuples++;
+		}
+		heap_endscan(scan);
+
+		INSTR_TIME_SET_CURRENT(end);
+		INSTR_TIME_ACCUM_DIFF(elapsed, end, start);
+	}
+
+	UnregisterSnapshot(snapshot);
+	relation_close(rel, AccessShareLock);
+
+	return bench_result(fcinfo, ntuples, elapsed);
+}
+
+/*
+ * bench_buffer_lookup(rel, loops)
+ *
+ * Pin and unpin every block of the relation's main fork, loops times.  Once
+ * the relation is cached, this measures the buffer mapping lookup and pin
+ * overhead; run it twice and use the second result.
+ */
+Datum
+bench_buffer_lookup(PG_FUNCTION_ARGS)
+{
+	Oid			relid = PG_GETARG_OID(0);
+	int32		loops = PG_GETARG_INT32(1);
+	Relation	rel;
+	BlockNumber nblocks;
+	instr_time	start,
+				end,
+				elapsed;
+	int			loop;
+
+	check_loops(loops);
+
+	rel = relation_open(relid, AccessShareLock);
+	if (!RELKIND_HAS_STORAGE(rel->rd_rel->relkind))
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("\"%s\" has no storage",
+						RelationGetRelationName(rel))));
+	if (RELATION_IS_OTHER_TEMP(rel))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot access temporary tables of other sessions")));
+
+	nblocks = RelationGetNumberOfBlocks(rel);
+
+	INSTR_TIME_SET_ZERO(elapsed);
+
+	for (loop = 0; loop < loops; loop++)
+	{
+		BlockNumber blkno;
+
+		CHECK_FOR_INTERRUPTS();
+
+		INSTR_TIME_SET_CURRENT(start);
+
+		for (blkno = 0; blkno < nblocks; blkno++)
+			ReleaseBuffer(ReadBufferExtended(rel, MAIN_FORKNUM, blkno,
+											 RBM_NORMAL, NULL));
+
+		INSTR_TIME_SET_CURRENT(end);
+		INSTR_TIME_ACCUM_DIFF(elapsed, end, start);
+	}
+
+	relation_close(rel, AccessShareLock);
+
+	return bench_result(fcinfo, (int64) nblocks * loops, elapsed);
+}
+
+/*
+ * bench_wal_insert(nrecords, record_size)
+ *
+ * Insert nrecords non-transactional logical decoding messages with a payload
+ * of record_size bytes into WAL.  Nothing is flushed, so this measures WAL
+ * insertion alone.  Logical decoding plugins will see the messages under the
+ * prefix "test_microbench".
+ */
+Datum
+bench_wal_insert(PG_FUNCTION_ARGS)
+{
+	int32		nrecords = PG_GETARG_INT32(0);
+	int32		record_size = PG_GETARG_INT32(1);
+	char	   *payload;
+	instr_time	start,
+				end,
+				elapsed;
+	int32		i;
+
+	if (nrecords < 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("number of records must not be negative")));
+	if (record_size < 0 || record_size > MaxAllocSize / 2)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("record size %d is out of range", record_size)));
+	if (RecoveryInProgress())
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("recovery is in progress"),
+				 errhint("WAL control functions cannot be executed during recovery.")));
+
+	payload = palloc0(record_size);
+
+	INSTR_TIME_SET_CURRENT(start);
+
+	for (i = 0; i < nrecords; i++)
+	{
+		CHECK_FOR_INTERRUPTS();
+
+		LogLogicalMessage("test_microbench", payload, record_size, false);
+	}
+
+	INSTR_TIME_SET_CURRENT(end);
+	INSTR_TIME_SET_ZERO(elapsed);
+	INSTR_TIME_ACCUM_DIFF(elapsed, end, start);
+
+	pfree(payload);
+
+	return bench_result(fcinfo, nrecords, elapsed);
+}
+
+/*
+ * bench_query(query, loops)
+ *
+ * Plan the query once and execute it loops times via SPI, discarding its
+ * result.  Each execution counts as one operation.  This is meant for
+ * queries exercising a whole executor path, such as a hash join or a sort,
+ * without the client round trip and result transfer that pgbench includes.
+ */
+Datum
+bench_query(PG_FUNCTION_ARGS)
+{
+	char	   *query = text_to_cstring(PG_GETARG_TEXT_PP(0));
+	int32		loops = PG_GETARG_INT32(1);
+	SPIPlanPtr	plan;
+	instr_time	start,
+				end,
+				elapsed;
+	int			loop;
+
+	check_loops(loops);
+
+	if (SPI_connect() != SPI_OK_CONNECT)
+		elog(ERROR, "SPI_connect failed");
+
+	plan = SPI_prepare(query, 0, NULL);
+	if (plan == NULL)
+		elog(ERROR, "SPI_prepare(\"%s\") failed: %s",
+			 query, SPI_result_code_string(SPI_result));
+
+	INSTR_TIME_SET_ZERO(elapsed);
+
+	for (loop = 0; loop < loops; loop++)
+	{
+		int			ret;
+
+		CHECK_FOR_INTERRUPTS();
+
+		INSTR_TIME_SET_CURRENT(start);
+
+		ret = SPI_execute_plan(plan, NULL, NULL, false, 0);
+		if (ret < 0)
+			elog(ERROR, "SPI_execute_plan(\"%s\") failed: %s",
+				 query, SPI_result_code_string(ret));
+		SPI_freetuptable(SPI_tuptable);
+
+		INSTR_TIME_SET_CURRENT(end);
+		INSTR_TIME_ACCUM_DIFF(elapsed, end, start);
+	}
+
+	SPI_finish();
+
+	return bench_result(fcinfo, loops, elapsed);
+}
@@ -0,0 +1,64 @@
+# Test crash recovery from full-page images compressed with each of the
+# wal_compression methods the server was built with.
+use strict;
+use warnings;
+use PostgresNode;
+use TestLib;
+use Test::More;
+
+my $node = get_new_node('main');
+$node->init;
+$node->append_conf('postgresql.conf', "full_page_writes = on\n");
+$node->start;
+
+# Find the methods this server supports, besides "off" and its aliases.
+my @methods = grep { $_ eq 'pglz' || $_ eq 'lz4' || $_ eq 'zstd' }
+  split(
+	/,/,
+	$node->safe_psql(
+		'postgres',
+		"SELECT array_to_string(enumvals, ',') FROM pg_settings WHERE name = 'wal_compression'"
+	));
+
+plan tests => 2 * scalar @methods;
+
+foreach my $method (@methods)
+{
+	my $table = "wal_compression_$method";
+
+	$node->safe_psql('postgres',
+		"ALTER SYSTEM SET wal_compression = $method; SELECT pg_reload_conf();");
+
+	# Pages full of compressible and incompressible data.  The first update
+	# of each page after the checkpoint writes a full-page image of it.
+	$node->safe_psql(
+		'postgres', qq{
+CREATE TABLE $table (id int, compressible text, incompressible text)
+  WITH (fillfactor = 50);
+INSERT INTO $table
+  SELECT g, repeat('x', 200), md5(g::text) || md5((g + 1)::text)
+  FROM generate_series(1, 5000) g;
+CHECKPOINT;
+UPDATE $table SET id = id + 1;
+});
+
+	my $expected = $node->safe_psql('postgres',
+		"SELECT count(*), md5(string_agg(id || compressible || incompressible, ',' ORDER BY id)) FROM $table"
+	);
+
+	my $setting = $node->safe_psql('postgres',
+		"SELECT setting FROM pg_settings WHERE name = 'wal_compression'");
+	is($setting, $method, "wal_compression set to $method");
+
+	# Crash, so that recovery has to restore the pages from the images.
+	$node->stop('immediate');
+	$node->start;
+
+	my $result = $node->safe_psql('postgres',
+		"SELECT count(*), md5(string_agg(id || compressible || incompressible, ',' ORDER BY id)) FROM $table"
+	);
+	is($result, $expected,
+		"data restored from $method-compressed full-page images");
+}
+
+$node->stop;
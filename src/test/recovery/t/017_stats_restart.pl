@@ -0,0 +1,66 @@
+# Check that table and function statistics kept in shared memory survive a
+# clean restart, and are discarded by crash recovery.
+use strict;
+use warnings;
+use PostgresNode;
+use TestLib;
+use Test::More tests => 7;
+
+my $node = get_new_node('main');
+$node->init;
+$node->append_conf('postgresql.conf', 'track_functions = all');
+$node->start;
+
+$node->safe_psql(
+	'postgres', q{
+CREATE TABLE stats_tab (a int);
+INSERT INTO stats_tab SELECT generate_series(1, 100);
+UPDATE stats_tab SET a = a + 1 WHERE a <= 10;
+DELETE FROM stats_tab WHERE a > 90;
+CREATE FUNCTION stats_func() RETURNS int LANGUAGE plpgsql
+  AS $$ BEGIN RETURN 1; END $$;
+SELECT stats_func() FROM generate_series(1, 5);
+SELECT count(*) FROM stats_tab;
+});
+
+my $stats_query = q{
+SELECT n_tup_ins, n_tup_upd, n_tup_del, seq_scan > 0
+  FROM pg_stat_user_tables WHERE relname = 'stats_tab';
+};
+my $func_query = q{
+SELECT calls FROM pg_stat_user_functions WHERE funcname = 'stats_func';
+};
+
+# The counters are reported when the session ends, so wait for them.
+$node->poll_query_until('postgres', $stats_query, '100|10|10|t')
+  or die "Timed out while waiting for statistics to be reported";
+$node->poll_query_until('postgres', $func_query, '5')
+  or die "Timed out while waiting for function statistics to be reported";
+
+$node->stop;
+ok(-f $node->data_dir . '/pg_stat/objects.stat',
+	'statistics written out at shutdown');
+$node->start;
+
+is($node->safe_psql('postgres', $stats_query),
+	'100|10|10|t', 'table statistics survive clean restart');
+is($node->safe_psql('postgres', $func_query),
+	'5', 'function statistics survive clean restart');
+ok(!-f $node->data_dir . '/pg_stat/objects.stat',
+	'statistics file removed after being loaded');
+
+# More activity after the restart adds to the loaded counters.
+$node->safe_psql('postgres', 'INSERT INTO stats_tab VALUES (1)');
+ok($node->poll_query_until('postgres', $stats_query, '101|10|10|t'),
+	'counters keep going after restart');
+
+# After crash recovery, the statistics start out empty.
+$node->stop('immediate');
+$node->start;
+
+is($node->safe_psql('postgres', $stats_query),
+	'0|0|0|f', 'table statistics reset by crash recovery');
+is($node->safe_psql('postgres', $func_query),
+	'', 'function statistics reset by crash recovery');
+
+$node->stop;
@@ -0,0 +1,72 @@
+# Test crash recovery with double_write, which restores torn pages from
+# their copies in pg_dblwr instead of from full-page images.
+use strict;
+use warnings;
+use PostgresNode;
+use TestLib;
+use Test::More tests => 4;
+
+my $node = get_new_node('main');
+$node->init(extra => ['--data-checksums']);
+
+# Keep shared_buffers small, so that the update below has to write out
+# pages, and don't let a checkpoint sync them before the crash.
+$node->append_conf(
+	'postgresql.conf', qq(
+double_write = on
+shared_buffers = 1MB
+checkpoint_timeout = 1h
+max_wal_size = 1GB
+));
+$node->start;
+
+$node->safe_psql(
+	'postgres', q{
+CREATE TABLE dblwr_tab (id int, padding text) WITH (fillfactor = 50);
+INSERT INTO dblwr_tab SELECT g, repeat('x', 200) FROM generate_series(1, 20000) g;
+CHECKPOINT;
+UPDATE dblwr_tab SET id = id + 1;
+});
+
+my $expected = $node->safe_psql('postgres',
+	"SELECT count(*), md5(string_agg(id || padding, ',' ORDER BY id)) FROM dblwr_tab"
+);
+my $relpath = $node->safe_psql('postgres',
+	"SELECT pg_relation_filepath('dblwr_tab')");
+
+my $dblwr_bytes = 0;
+foreach my $file (glob($node->data_dir . '/pg_dblwr/*'))
+{
+	$dblwr_bytes += -s $file;
+}
+ok($dblwr_bytes > 0, 'page copies written to the double-write file');
+
+$node->stop('immediate');
+
+# Simulate a torn write of the first page: its first half was written, the
+# rest wasn't.  WAL has no image of the page to restore it from.
+my $file;
+open($file, '+<', $node->data_dir . "/$relpath")
+  or die "could not open relation file: $!";
+binmode $file;
+seek($file, 4096, 0);
+syswrite($file, "\0" x 4096);
+close $file;
+
+$node->start;
+
+my $result = $node->safe_psql('postgres',
+	"SELECT count(*), md5(string_agg(id || padding, ',' ORDER BY id)) FROM dblwr_tab"
+);
+is($result, $expected, 'data intact after crash with a torn page');
+
+like(
+	slurp_file($node->logfile),
+	qr/restored \d+ pages from double-write files/,
+	'pages restored from double-write files');
+
+# The restored copies were discarded, and a fresh file was started.
+my @files = glob($node->data_dir . '/pg_dblwr/*');
+is(scalar @files, 1, 'one double-write file after recovery');
+
+$node->stop;
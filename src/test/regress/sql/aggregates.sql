@@ -976,3 +976,59 @@ SELECT dense_rank(x) WITHIN GROUP (ORDER BY x) FROM (VALUES (1),(1),(2),(2),(3),
 -- 2a505161-2727-2473-7c46-591ed108ac52@email.cz
 SELECT min(x ORDER BY y) FROM (VALUES(1, NULL)) AS d(x,y);
 SELECT min(x ORDER BY y) FROM (VALUES(1, 2)) AS d(x,y);
+
+--
+-- Hash Aggregation Spill tests
+--
+-- The table isn't analyzed, so that the planner underestimates the number
+-- of groups and picks hashing, which then has to spill to disk and refill
+-- from the spilled batches.
+
+set enable_sort=false;
+set work_mem='64kB';
+
+create table agg_data_20k as select g from generate_series(0, 19999) g;
+
+explain (costs off)
+select (g % 10000) as c1, sum(g::numeric) as c2, count(*) as c3
+  from agg_data_20k group by g % 10000;
+
+create table agg_hash_1 as
+select (g % 10000) as c1, sum(g::numeric) as c2, count(*) as c3
+  from agg_data_20k group by g % 10000;
+
+create table agg_hash_2 as
+select g as c1, array_length(array_agg(g), 1) as c2
+  from agg_data_20k group by g;
+
+set enable_hashagg = false;
+set enable_sort = true;
+
+create table agg_group_1 as
+select (g % 10000) as c1, sum(g::numeric) as c2, count(*) as c3
+  from agg_data_20k group by g % 10000;
+
+create table agg_group_2 as
+select g as c1, array_length(array_agg(g), 1) as c2
+  from agg_data_20k group by g;
+
+reset enable_hashagg;
+reset enable_sort;
+reset work_mem;
+
+select count(*) from agg_hash_1;
+select count(*) from agg_hash_2;
+
+(select * from agg_hash_1 except select * from agg_group_1)
+  union all
+(select * from agg_group_1 except select * from agg_hash_1);
+
+(select * from agg_hash_2 except select * from agg_group_2)
+  union all
+(select * from agg_group_2 except select * from agg_hash_2);
+
+drop table agg_data_20k;
+drop table agg_hash_1;
+drop table agg_hash_2;
+drop table agg_group_1;
+drop table agg_group_2;
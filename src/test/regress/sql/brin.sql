@@ -460,3 +460,36 @@ VACUUM ANALYZE brin_test;
 EXPLAIN (COSTS OFF) SELECT * FROM brin_test WHERE a = 1;
 -- Ensure brin index is not used when values are not correlated
 EXPLAIN (COSTS OFF) SELECT * FROM brin_test WHERE b = 1;
+
+-- bloom opclasses
+CREATE TABLE brin_bloom_test (a INT, t TEXT);
+INSERT INTO brin_bloom_test SELECT x, md5(x::text) FROM generate_series(1,5000) x(x);
+CREATE INDEX brin_bloom_test_idx ON brin_bloom_test
+  USING brin (a int4_bloom_ops, t text_bloom_ops) WITH (pages_per_range = 4);
+INSERT INTO brin_bloom_test VALUES (NULL, NULL);
+SET enable_seqscan = off;
+SELECT count(*) FROM brin_bloom_test WHERE a = 1234;
+SELECT count(*) FROM brin_bloom_test WHERE t = md5('4321');
+SELECT count(*) FROM brin_bloom_test WHERE a = 0;
+SELECT count(*) FROM brin_bloom_test WHERE t IS NULL;
+RESET enable_seqscan;
+DROP TABLE brin_bloom_test;
+
+-- Test parallel index build.  Setting parallel_workers on the table makes the
+-- build use workers regardless of its size.
+CREATE TABLE brin_parallel_test (a INT, b TEXT)
+  WITH (parallel_workers = 2, autovacuum_enabled = off);
+INSERT INTO brin_parallel_test SELECT x, md5(x::text) FROM generate_series(1,20000) x(x);
+SET max_parallel_maintenance_workers = 2;
+CREATE INDEX brin_parallel_test_idx ON brin_parallel_test
+  USING brin (a, b) WITH (pages_per_range = 2);
+RESET max_parallel_maintenance_workers;
+-- all ranges have been summarized
+SELECT brin_summarize_new_values('brin_parallel_test_idx');
+SET enable_seqscan = off;
+EXPLAIN (COSTS OFF) SELECT count(*) FROM brin_parallel_test WHERE a = 1234;
+SELECT count(*) FROM brin_parallel_test WHERE a = 1234;
+SELECT count(*) FROM brin_parallel_test WHERE a BETWEEN 5000 AND 5999;
+SELECT count(*) FROM brin_parallel_test WHERE b = md5('4321');
+RESET enable_seqscan;
+DROP TABLE brin_parallel_test;
@@ -111,3 +111,50 @@ create index btree_idx_err on btree_test(a) with (vacuum_cleanup_index_scale_fac
 -- Simple ALTER INDEX
 alter index btree_idx1 set (vacuum_cleanup_index_scale_factor = 70.0);
 select reloptions from pg_class WHERE oid = 'btree_idx1'::regclass;
+
+--
+-- Test skip scans, for conditions on the second column only
+--
+create table btree_skip_tbl(a int, b int);
+insert into btree_skip_tbl select g % 3, g from generate_series(1, 3000) g;
+insert into btree_skip_tbl values (null, 42), (null, 43);
+create index btree_skip_idx on btree_skip_tbl (a, b);
+analyze btree_skip_tbl;
+
+set enable_seqscan to false;
+set enable_indexscan to true;
+set enable_bitmapscan to false;
+explain (costs off)
+select * from btree_skip_tbl where b = 42;
+select * from btree_skip_tbl where b = 42;
+select * from btree_skip_tbl where b < 4 order by a, b;
+select * from btree_skip_tbl where b in (2, 3, 42) order by a, b;
+set enable_indexskipscan to false;
+explain (costs off)
+select * from btree_skip_tbl where b = 42;
+reset enable_indexskipscan;
+reset enable_seqscan;
+reset enable_indexscan;
+reset enable_bitmapscan;
+
+--
+-- Test deduplication of leaf tuples with equal keys
+--
+create table btree_dedup_tbl(a int, b int);
+insert into btree_dedup_tbl select g % 10, g from generate_series(1, 10000) g;
+create index btree_dedup_idx on btree_dedup_tbl (a);
+create index btree_nodedup_idx on btree_dedup_tbl (a) with (deduplicate_items = off);
+select reloptions from pg_class WHERE oid = 'btree_nodedup_idx'::regclass;
+-- these are merged when leaf pages fill up
+insert into btree_dedup_tbl select g % 10, g from generate_series(1, 10000) g;
+select pg_relation_size('btree_dedup_idx') <
+  pg_relation_size('btree_nodedup_idx') / 2 as smaller;
+-- remove some heap TIDs of posting lists, and all of others
+delete from btree_dedup_tbl where b % 4 = 0 or a = 3;
+vacuum btree_dedup_tbl;
+set enable_seqscan to false;
+set enable_bitmapscan to false;
+select a, count(*) from btree_dedup_tbl where a between 2 and 5 group by a order by a;
+select count(*) from btree_dedup_tbl where a = 5 and b < 100;
+reset enable_seqscan;
+reset enable_bitmapscan;
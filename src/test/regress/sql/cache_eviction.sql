@@ -0,0 +1,77 @@
+--
+-- Eviction from the catalog and relation caches
+--
+do $$
+begin
+  for i in 1..100 loop
+    execute format('create table ccache_tab_%s (a int, b text)', i);
+    execute format('insert into ccache_tab_%s values (%s, %L)', i, i, 'x');
+  end loop;
+end
+$$;
+create type ccache_enum as enum ('red', 'green', 'blue');
+
+-- Sum up the contents of all the tables, opening each of them.
+create function ccache_sum() returns bigint language plpgsql as
+$$
+declare
+  total bigint := 0;
+  n bigint;
+begin
+  for i in 1..100 loop
+    execute format('select sum(a) from ccache_tab_%s', i) into n;
+    total := total + n;
+  end loop;
+  return total;
+end
+$$;
+
+create temp table ccache_base as
+  select (select sum(evictions) from pg_catalog_cache_stats) as catcache,
+         (select evictions from pg_relation_cache_stats) as relcache;
+
+-- Touch many more entries than fit in the limits.  The relcache is only
+-- trimmed at the end of the transaction.
+set catalog_cache_memory = '16kB';
+set relation_cache_memory = '16kB';
+select ccache_sum();
+select (select sum(evictions) from pg_catalog_cache_stats) > catcache as catcache_evicted,
+       (select evictions from pg_relation_cache_stats) > relcache as relcache_evicted
+  from ccache_base;
+-- evicted entries are loaded again when needed
+select ccache_sum();
+
+-- With next to no room, every new catcache entry tries to evict all the
+-- others, including those the caller still has references to, and every
+-- transaction end throws away all relcache entries that aren't in use.
+set catalog_cache_memory = '1kB';
+set relation_cache_memory = '1kB';
+select 'green'::ccache_enum;
+select 'blue'::ccache_enum > 'red'::ccache_enum as ordered;
+select ccache_sum();
+alter table ccache_tab_1 add column c int default 7;
+select * from ccache_tab_1;
+-- a relation created by the transaction that trims the cache
+begin;
+create table ccache_new (a int);
+insert into ccache_new values (1);
+select ccache_sum();
+commit;
+select * from ccache_new;
+-- cached catalog entries are still invalidated properly
+alter type ccache_enum rename value 'green' to 'yellow';
+select 'yellow'::ccache_enum;
+select 'green'::ccache_enum;
+reset catalog_cache_memory;
+reset relation_cache_memory;
+
+drop table ccache_new;
+drop function ccache_sum();
+drop type ccache_enum;
+do $$
+begin
+  for i in 1..100 loop
+    execute format('drop table ccache_tab_%s', i);
+  end loop;
+end
+$$;
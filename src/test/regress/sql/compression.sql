@@ -0,0 +1,47 @@
+--
+-- Compression of TOAST data
+--
+
+CREATE TABLE cmsource_pglz (id int, f1 text, f2 bytea);
+ALTER TABLE cmsource_pglz ALTER COLUMN f1 SET STORAGE EXTERNAL,
+  ALTER COLUMN f2 SET STORAGE EXTERNAL;
+-- a short value that isn't compressed, a compressible value that stays in
+-- line, a compressible value stored out of line, and an incompressible one
+INSERT INTO cmsource_pglz VALUES (1, 'short', '\x0102');
+INSERT INTO cmsource_pglz VALUES (2, repeat('1234567890', 1000), NULL);
+INSERT INTO cmsource_pglz
+  SELECT 3, repeat(string_agg(md5(g::text), '' ORDER BY g), 100), NULL
+  FROM generate_series(1, 50) g;
+INSERT INTO cmsource_pglz
+  SELECT 4, NULL, string_agg(sha256(g::text::bytea), '' ORDER BY g)
+  FROM generate_series(1, 100) g;
+
+CREATE TABLE cm_pglz (LIKE cmsource_pglz);
+ALTER TABLE cm_pglz ALTER COLUMN f1 SET (compression = pglz);
+ALTER TABLE cm_pglz ALTER COLUMN f2 SET (compression = pglz);
+INSERT INTO cm_pglz SELECT * FROM cmsource_pglz;
+SELECT id, pg_column_compression(f1) AS f1_cm, pg_column_compression(f2) AS f2_cm,
+       length(f1) AS f1_len, length(f2) AS f2_len
+  FROM cm_pglz ORDER BY id;
+
+-- the values must read back unchanged, whole and in slices
+SELECT c.id, c.f1 IS NOT DISTINCT FROM s.f1 AS f1_ok,
+       c.f2 IS NOT DISTINCT FROM s.f2 AS f2_ok
+  FROM cm_pglz c JOIN cmsource_pglz s USING (id) ORDER BY id;
+SELECT id, substr(f1, 1599, 4), substr(f1, 150001, 10) FROM cm_pglz
+  WHERE id IN (2, 3) ORDER BY id;
+
+-- invalid methods are rejected
+ALTER TABLE cm_pglz ALTER COLUMN f1 SET (compression = foo);
+
+-- without a column option, default_toast_compression applies
+SHOW default_toast_compression;
+SET default_toast_compression = pglz;
+CREATE TABLE cm_default (f1 text);
+INSERT INTO cm_default VALUES (repeat('1234567890', 1000));
+SELECT pg_column_compression(f1), length(f1) FROM cm_default;
+DROP TABLE cm_default;
+RESET default_toast_compression;
+
+DROP TABLE cm_pglz;
+DROP TABLE cmsource_pglz;
@@ -0,0 +1,46 @@
+--
+-- Compression of TOAST data with lz4
+--
+-- This method is optional at build time, so there's an alternative
+-- expected output for servers built without it.
+
+CREATE TABLE cmsource_lz4 (id int, f1 text, f2 bytea);
+ALTER TABLE cmsource_lz4 ALTER COLUMN f1 SET STORAGE EXTERNAL,
+  ALTER COLUMN f2 SET STORAGE EXTERNAL;
+-- a short value that isn't compressed, a compressible value that stays in
+-- line, a compressible value stored out of line, and an incompressible one
+INSERT INTO cmsource_lz4 VALUES (1, 'short', '\x0102');
+INSERT INTO cmsource_lz4 VALUES (2, repeat('1234567890', 1000), NULL);
+INSERT INTO cmsource_lz4
+  SELECT 3, repeat(string_agg(md5(g::text), '' ORDER BY g), 100), NULL
+  FROM generate_series(1, 50) g;
+INSERT INTO cmsource_lz4
+  SELECT 4, NULL, string_agg(sha256(g::text::bytea), '' ORDER BY g)
+  FROM generate_series(1, 100) g;
+
+CREATE TABLE cm_lz4 (LIKE cmsource_lz4);
+ALTER TABLE cm_lz4 ALTER COLUMN f1 SET (compression = lz4);
+ALTER TABLE cm_lz4 ALTER COLUMN f2 SET (compression = lz4);
+INSERT INTO cm_lz4 SELECT * FROM cmsource_lz4;
+SELECT id, pg_column_compression(f1) AS f1_cm, pg_column_compression(f2) AS f2_cm,
+       length(f1) AS f1_len, length(f2) AS f2_len
+  FROM cm_lz4 ORDER BY id;
+
+-- the values must read back unchanged, whole and in slices
+SELECT c.id, c.f1 IS NOT DISTINCT FROM s.f1 AS f1_ok,
+       c.f2 IS NOT DISTINCT FROM s.f2 AS f2_ok
+  FROM cm_lz4 c JOIN cmsource_lz4 s USING (id) ORDER BY id;
+SELECT id, substr(f1, 1599, 4), substr(f1, 150001, 10) FROM cm_lz4
+  WHERE id IN (2, 3) ORDER BY id;
+
+-- Existing values keep their method when the column's option changes, until
+-- VACUUM FULL rewrites the table.
+ALTER TABLE cm_lz4 ALTER COLUMN f1 SET (compression = pglz);
+SELECT id, pg_column_compression(f1) FROM cm_lz4 ORDER BY id;
+VACUUM FULL cm_lz4;
+SELECT id, pg_column_compression(f1) FROM cm_lz4 ORDER BY id;
+SELECT c.id, c.f1 IS NOT DISTINCT FROM s.f1 AS f1_ok
+  FROM cm_lz4 c JOIN cmsource_lz4 s USING (id) ORDER BY id;
+
+DROP TABLE cm_lz4;
+DROP TABLE cmsource_lz4;
@@ -0,0 +1,46 @@
+--
+-- Compression of TOAST data with zstd
+--
+-- This method is optional at build time, so there's an alternative
+-- expected output for servers built without it.
+
+CREATE TABLE cmsource_zstd (id int, f1 text, f2 bytea);
+ALTER TABLE cmsource_zstd ALTER COLUMN f1 SET STORAGE EXTERNAL,
+  ALTER COLUMN f2 SET STORAGE EXTERNAL;
+-- a short value that isn't compressed, a compressible value that stays in
+-- line, a compressible value stored out of line, and an incompressible one
+INSERT INTO cmsource_zstd VALUES (1, 'short', '\x0102');
+INSERT INTO cmsource_zstd VALUES (2, repeat('1234567890', 1000), NULL);
+INSERT INTO cmsource_zstd
+  SELECT 3, repeat(string_agg(md5(g::text), '' ORDER BY g), 100), NULL
+  FROM generate_series(1, 50) g;
+INSERT INTO cmsource_zstd
+  SELECT 4, NULL, string_agg(sha256(g::text::bytea), '' ORDER BY g)
+  FROM generate_series(1, 100) g;
+
+CREATE TABLE cm_zstd (LIKE cmsource_zstd);
+ALTER TABLE cm_zstd ALTER COLUMN f1 SET (compression = zstd);
+ALTER TABLE cm_zstd ALTER COLUMN f2 SET (compression = zstd);
+INSERT INTO cm_zstd SELECT * FROM cmsource_zstd;
+SELECT id, pg_column_compression(f1) AS f1_cm, pg_column_compression(f2) AS f2_cm,
+       length(f1) AS f1_len, length(f2) AS f2_len
+  FROM cm_zstd ORDER BY id;
+
+-- the values must read back unchanged, whole and in slices
+SELECT c.id, c.f1 IS NOT DISTINCT FROM s.f1 AS f1_ok,
+       c.f2 IS NOT DISTINCT FROM s.f2 AS f2_ok
+  FROM cm_zstd c JOIN cmsource_zstd s USING (id) ORDER BY id;
+SELECT id, substr(f1, 1599, 4), substr(f1, 150001, 10) FROM cm_zstd
+  WHERE id IN (2, 3) ORDER BY id;
+
+-- Existing values keep their method when the column's option changes, until
+-- VACUUM FULL rewrites the table.
+ALTER TABLE cm_zstd ALTER COLUMN f1 SET (compression = pglz);
+SELECT id, pg_column_compression(f1) FROM cm_zstd ORDER BY id;
+VACUUM FULL cm_zstd;
+SELECT id, pg_column_compression(f1) FROM cm_zstd ORDER BY id;
+SELECT c.id, c.f1 IS NOT DISTINCT FROM s.f1 AS f1_ok
+  FROM cm_zstd c JOIN cmsource_zstd s USING (id) ORDER BY id;
+
+DROP TABLE cm_zstd;
+DROP TABLE cmsource_zstd;
@@ -34,3 +34,18 @@ SELECT current_schema;
 SET search_path = 'pg_catalog';
 SELECT current_schema;
 RESET search_path;
+
+--
+-- Tests for = ANY (array) with enough elements to use a hash table
+--
+SELECT x IN (1, 2, 3, 4, 5, 6, 7, 8, 9) AS plain,
+       x IN (1, 2, 3, 4, 5, 6, 7, 8, NULL) AS with_null,
+       x::text IN ('1', '2', '3', '4', '5', '6', '7', '8', '9') AS text_in,
+       x
+  FROM (VALUES (1), (9), (10), (NULL::int)) v(x);
+SET plan_cache_mode = force_generic_plan;
+PREPARE saop_param(int[]) AS SELECT x = ANY($1) FROM (VALUES (1), (5)) v(x);
+EXECUTE saop_param('{1,2,3}');
+EXECUTE saop_param('{5}');
+DEALLOCATE saop_param;
+RESET plan_cache_mode;
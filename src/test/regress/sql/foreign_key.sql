@@ -1289,3 +1289,48 @@ ALTER TABLE fk_partitioned_fk ATTACH PARTITION fk_partitioned_fk_2
   FOR VALUES IN (1600);
 
 -- leave these tables around intentionally
+
+--
+-- Foreign key checks that look the key up in the referenced index directly,
+-- and those that still need the query
+--
+CREATE TABLE fkp_pk (a int, b text, c int, PRIMARY KEY (a, b) INCLUDE (c));
+INSERT INTO fkp_pk VALUES (1, 'one', 0), (2, 'two', 0), (3, 'three', 0), (4, 'four', 0);
+-- key columns in another order than in the index, one of a binary-compatible type
+CREATE TABLE fkp_fk (y varchar, x int, FOREIGN KEY (y, x) REFERENCES fkp_pk (b, a));
+INSERT INTO fkp_fk VALUES ('one', 1), ('two', 2);
+INSERT INTO fkp_fk VALUES ('one', 2);
+INSERT INTO fkp_fk VALUES (NULL, 5);
+UPDATE fkp_fk SET x = 3, y = 'three' WHERE x = 2;
+-- referenced rows deleted or updated earlier in the same transaction
+BEGIN;
+DELETE FROM fkp_pk WHERE a = 2;
+INSERT INTO fkp_fk VALUES ('two', 2);
+ROLLBACK;
+BEGIN;
+UPDATE fkp_pk SET c = 1 WHERE a = 2;
+INSERT INTO fkp_fk VALUES ('two', 2);
+COMMIT;
+BEGIN;
+UPDATE fkp_pk SET a = 40 WHERE a = 4;
+INSERT INTO fkp_fk VALUES ('four', 40);
+COMMIT;
+INSERT INTO fkp_fk VALUES ('four', 4);
+SELECT * FROM fkp_fk ORDER BY x;
+-- deferred checks
+CREATE TABLE fkp_fk2 (x int, y text,
+  FOREIGN KEY (x, y) REFERENCES fkp_pk DEFERRABLE INITIALLY DEFERRED);
+BEGIN;
+INSERT INTO fkp_fk2 VALUES (5, 'five');
+INSERT INTO fkp_pk VALUES (5, 'five', 0);
+COMMIT;
+BEGIN;
+INSERT INTO fkp_fk2 VALUES (6, 'six');
+COMMIT;
+-- an FK column that must be cast to the type of the PK column
+CREATE TABLE fkp_pk3 (a float8 PRIMARY KEY);
+INSERT INTO fkp_pk3 VALUES (1), (2.5);
+CREATE TABLE fkp_fk3 (x int REFERENCES fkp_pk3);
+INSERT INTO fkp_fk3 VALUES (1);
+INSERT INTO fkp_fk3 VALUES (2);
+DROP TABLE fkp_fk, fkp_fk2, fkp_pk, fkp_fk3, fkp_pk3;
@@ -34,3 +34,24 @@ insert into gin_test_tbl select array[1, 3, g] from generate_series(1, 1000) g;
 
 delete from gin_test_tbl where i @> array[2];
 vacuum gin_test_tbl;
+
+-- Test parallel index build.  Setting parallel_workers on the table makes the
+-- build use workers regardless of its size.
+create table gin_parallel_tbl(i int4[])
+  with (parallel_workers = 2, autovacuum_enabled = off);
+insert into gin_parallel_tbl
+  select array[g % 100, g % 7, g] from generate_series(1, 50000) g;
+set max_parallel_maintenance_workers = 2;
+create index gin_parallel_idx on gin_parallel_tbl using gin (i);
+reset max_parallel_maintenance_workers;
+
+set enable_seqscan = off;
+explain (costs off)
+select count(*) from gin_parallel_tbl where i @> array[5];
+select count(*) from gin_parallel_tbl where i @> array[5];
+select count(*) from gin_parallel_tbl where i @> array[5, 3];
+select count(*) from gin_parallel_tbl where i && array[49999, 12345];
+select count(*) from gin_parallel_tbl where i @> array[42];
+reset enable_seqscan;
+
+drop table gin_parallel_tbl;
@@ -39,6 +39,11 @@ vacuum analyze gist_point_tbl;
 alter index gist_pointidx SET (fillfactor = 40);
 reindex index gist_pointidx;
 
+-- the rebuilt index was built by sorting; check that it finds all entries
+set enable_seqscan=off;
+select count(*) from gist_point_tbl where p <@ box(point(0,0), point(200000, 200000));
+reset enable_seqscan;
+
 --
 -- Test Index-only plans on GiST indexes
 --
@@ -0,0 +1,52 @@
+--
+-- Incremental Sort
+--
+
+-- Groups of mixed sizes on the presorted key: one large group, many
+-- single-row groups, and groups of 50 rows.
+create table incsort_tbl (a int, b int);
+insert into incsort_tbl select 0, (i * 7919) % 2000 from generate_series(1, 2000) i;
+insert into incsort_tbl select i, (i * 31) % 7 from generate_series(1, 1000) i;
+insert into incsort_tbl select 1001 + i / 50, (i * 17) % 97 from generate_series(0, 4999) i;
+create index incsort_tbl_a_idx on incsort_tbl (a);
+analyze incsort_tbl;
+
+-- The index provides ordering on a, so only b needs sorting within groups.
+explain (costs off)
+select * from incsort_tbl order by a, b limit 10;
+select * from incsort_tbl order by a, b limit 10;
+
+-- A LIMIT that ends inside a small group
+select * from incsort_tbl where a >= 999 order by a, b limit 5;
+
+-- Without incremental sort, the whole input is sorted.
+set enable_incrementalsort = off;
+explain (costs off)
+select * from incsort_tbl order by a, b limit 10;
+select * from incsort_tbl order by a, b limit 10;
+reset enable_incrementalsort;
+
+-- Compare the complete output, in order, against a full sort.
+set enable_seqscan = off;
+set enable_bitmapscan = off;
+explain (costs off)
+select a, b from incsort_tbl order by a, b;
+create temp table incsort_on as
+  select row_number() over () as rn, a, b
+  from (select a, b from incsort_tbl order by a, b) s;
+set enable_incrementalsort = off;
+create temp table incsort_off as
+  select row_number() over () as rn, a, b
+  from (select a, b from incsort_tbl order by a, b) s;
+reset enable_incrementalsort;
+reset enable_seqscan;
+reset enable_bitmapscan;
+
+select count(*) from incsort_on;
+(select * from incsort_on except select * from incsort_off)
+  union all
+(select * from incsort_off except select * from incsort_on);
+
+drop table incsort_on;
+drop table incsort_off;
+drop table incsort_tbl;
@@ -455,6 +455,24 @@ select count(*) from
   (select * from tenk1 y order by y.unique2) y
   on x.thousand = y.unique2 and x.twothousand = y.hundred and x.fivethous = y.unique2;
 
+--
+-- merge join that re-seeks its inner index scan past non-matching rows
+--
+set enable_hashjoin = off;
+set enable_nestloop = off;
+set enable_mergejoin_skip = on;
+
+explain (costs off)
+select o.unique1, o.ten, t.ten from onek o join tenk1 t on t.unique1 = o.unique1
+  where o.unique1 % 100 = 7;
+
+select o.unique1, o.ten, t.ten from onek o join tenk1 t on t.unique1 = o.unique1
+  where o.unique1 % 100 = 7;
+
+reset enable_hashjoin;
+reset enable_nestloop;
+reset enable_mergejoin_skip;
+
 
 --
 -- Clean up
@@ -2273,6 +2291,10 @@ select * from hash_join_batches(
 $$
   select count(*) from simple r join extremely_skewed s using (id);
 $$);
+-- the skewed key is set aside, and the other keys can still be split
+select count(*) from simple r join
+  (select * from extremely_skewed union all select * from bigger_than_it_looks) s
+  using (id);
 rollback to settings;
 
 -- parallel with parallel-oblivious hash join
@@ -2492,3 +2514,72 @@ $$);
 rollback to settings;
 
 rollback;
+
+--
+-- Runtime Bloom filters pushed from a hash join into its outer scan
+--
+create temp table rtf_outer (a int, b text);
+create temp table rtf_inner (a int, c text);
+create temp table rtf_inner_half (a int, c text);
+insert into rtf_outer select g, 'o' || g from generate_series(1, 10000) g;
+insert into rtf_outer select null, 'null' from generate_series(1, 100);
+insert into rtf_inner select g * 100, 'i' || g from generate_series(1, 50) g;
+insert into rtf_inner_half select g, 'i' || g from generate_series(1, 5000) g;
+analyze rtf_outer;
+analyze rtf_inner;
+analyze rtf_inner_half;
+
+-- Report how many rows the outer scan of an
+-- Aggregate -> Hash Join -> Seq Scan plan returned, and how many its
+-- runtime filter removed (null if it had none).
+create function rtf_counts(query text, out scan_rows bigint, out removed bigint)
+language plpgsql as
+$$
+declare
+  plan json;
+  scan json;
+begin
+  execute 'explain (analyze, costs off, timing off, summary off, format json) '
+    || query into plan;
+  scan := plan->0->'Plan'->'Plans'->0->'Plans'->0;
+  scan_rows := (scan->>'Actual Rows')::bigint;
+  removed := (scan->>'Rows Removed by Runtime Filter')::bigint;
+end;
+$$;
+
+begin;
+set local enable_mergejoin = off;
+set local enable_nestloop = off;
+
+explain (costs off)
+select count(*) from rtf_outer o join rtf_inner i on o.a = i.a;
+select count(*) from rtf_outer o join rtf_inner i on o.a = i.a;
+-- rows without partners, including those with null keys, are filtered out,
+-- but every row with one gets through
+select scan_rows >= 50 as kept_matches, scan_rows + removed = 10100 as all_seen,
+       removed > 9000 as filtered
+  from rtf_counts('select count(*) from rtf_outer o join rtf_inner i on o.a = i.a');
+
+-- Rows that pass the filter but have no partner, as false positives do, are
+-- still checked by the join.
+select count(*) from rtf_outer o join rtf_inner i on o.a = i.a and o.b < i.c;
+select scan_rows >= 50 as kept_matches, removed > 9000 as filtered
+  from rtf_counts('select count(*) from rtf_outer o join rtf_inner i on o.a = i.a and o.b < i.c');
+
+-- semi join
+select count(*) from rtf_outer o
+  where exists (select 1 from rtf_inner i where i.a = o.a);
+
+-- A filter that rejects too few of the first rows switches itself off.
+select count(*) from rtf_outer o join rtf_inner_half i on o.a = i.a;
+select scan_rows, removed
+  from rtf_counts('select count(*) from rtf_outer o join rtf_inner_half i on o.a = i.a');
+
+-- and with enable_runtime_filter off, there's no filter at all
+set local enable_runtime_filter = off;
+select scan_rows, removed is null as no_filter
+  from rtf_counts('select count(*) from rtf_outer o join rtf_inner i on o.a = i.a');
+select count(*) from rtf_outer o join rtf_inner i on o.a = i.a;
+rollback;
+
+drop function rtf_counts(text);
@@ -1164,3 +1164,30 @@ select '12345.0000000000000000000000000000000000000000000005'::jsonb::float8;
 select '12345.0000000000000000000000000000000000000000000005'::jsonb::int2;
 select '12345.0000000000000000000000000000000000000000000005'::jsonb::int4;
 select '12345.0000000000000000000000000000000000000000000005'::jsonb::int8;
+
+-- key lookup in a large uncompressed out-of-line jsonb, which fetches slices
+create temp table test_jsonb_external (j jsonb);
+alter table test_jsonb_external alter column j set storage external;
+insert into test_jsonb_external
+  select jsonb_object_agg('key' || i, jsonb_build_object('n', i, 'pad', repeat('x', 10)))
+  from generate_series(1, 2000) i;
+select j -> 'key1234' from test_jsonb_external;
+select j -> 'key7' ->> 'n' from test_jsonb_external;
+select j ->> 'key2000' from test_jsonb_external;
+select j -> 'nokey' is null, j ->> 'key0' is null from test_jsonb_external;
+drop table test_jsonb_external;
+
+-- top-level key statistics, used to estimate ?, ?| and ?&
+create temp table test_jsonb_stats (j jsonb);
+insert into test_jsonb_stats
+  select case i % 4
+           when 0 then jsonb_build_object('a', i, 'b', i)
+           when 1 then jsonb_build_object('a', i)
+           when 2 then '["a", "c", "c"]'
+         end
+  from generate_series(1, 100) i;
+analyze test_jsonb_stats;
+select most_common_elems,
+       array(select round(f::numeric, 4) from unnest(most_common_elem_freqs) f) as freqs
+  from pg_stats where tablename = 'test_jsonb_stats';
+drop table test_jsonb_stats;
@@ -1043,3 +1043,16 @@ select scale(-13.000000000000000);
 -- cases that need carry propagation
 SELECT SUM(9999::numeric) FROM generate_series(1, 100000);
 SELECT SUM((-9999)::numeric) FROM generate_series(1, 100000);
+
+-- mixed scales and magnitudes, partly summed as 128-bit integers
+SELECT SUM(x) FROM (VALUES (1.5::numeric), (0.25), (12345678901234567890123456789012.1), (-3), (0.000000000000000001)) v(x);
+SELECT i, SUM(x) OVER (ORDER BY i ROWS BETWEEN 1 PRECEDING AND CURRENT ROW)
+  FROM (VALUES (1, 1.5::numeric), (2, 2.25), (3, -4), (4, 1e30), (5, 0.75)) v(i, x);
+
+-- arithmetic on values that fit in 128-bit integers, and ones that don't
+SELECT 1.25 + 2.5 AS r;
+SELECT 1.25 - 2.5 AS r;
+SELECT -1.25 * 2.5 AS r;
+SELECT 0.0001 * 0.00010 AS r;
+SELECT 99999999.9999 * 9999999999.99 AS r;
+SELECT 999999999999999999999999999999.99 + 0.01 AS r;
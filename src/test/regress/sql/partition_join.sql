@@ -432,3 +432,27 @@ ANALYZE prt2;
 
 EXPLAIN (COSTS OFF)
 SELECT t1.a, t1.c, t2.b, t2.c FROM prt1 t1, prt2 t2 WHERE t1.a = t2.b AND t1.b = 0 ORDER BY t1.a, t2.b;
+
+--
+-- tables whose partitions lie within those of the other table can still be
+-- joined partitionwise, as long as the smaller partitions are on the outer
+-- side of an outer join
+--
+CREATE TABLE prt1_nest (a int, b int) PARTITION BY RANGE(a);
+CREATE TABLE prt1_nest_p1 PARTITION OF prt1_nest FOR VALUES FROM (0) TO (100);
+CREATE TABLE prt1_nest_p2 PARTITION OF prt1_nest FOR VALUES FROM (100) TO (200);
+CREATE TABLE prt1_nest_p3 PARTITION OF prt1_nest FOR VALUES FROM (200) TO (300);
+INSERT INTO prt1_nest SELECT i, i % 10 FROM generate_series(0, 299) i;
+ANALYZE prt1_nest;
+
+CREATE TABLE prt2_nest (a int, b int) PARTITION BY RANGE(a);
+CREATE TABLE prt2_nest_p1 PARTITION OF prt2_nest FOR VALUES FROM (0) TO (200);
+CREATE TABLE prt2_nest_p2 PARTITION OF prt2_nest FOR VALUES FROM (200) TO (300);
+INSERT INTO prt2_nest SELECT i, i % 7 FROM generate_series(0, 299, 2) i;
+ANALYZE prt2_nest;
+
+SELECT count(*), sum(t1.b), sum(t2.b) FROM prt1_nest t1 JOIN prt2_nest t2 ON t1.a = t2.a;
+SELECT count(*), sum(t1.b), sum(t2.b) FROM prt2_nest t1 JOIN prt1_nest t2 ON t1.a = t2.a;
+SELECT count(*), count(t2.a) FROM prt1_nest t1 LEFT JOIN prt2_nest t2 ON t1.a = t2.a;
+SELECT count(*), count(t2.a) FROM prt2_nest t1 LEFT JOIN prt1_nest t2 ON t1.a = t2.a;
+SELECT count(*) FROM prt1_nest t1 WHERE NOT EXISTS (SELECT 1 FROM prt2_nest t2 WHERE t1.a = t2.a);
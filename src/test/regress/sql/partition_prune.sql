@@ -571,6 +571,17 @@ explain (analyze, costs off, summary off, timing off) execute ab_q6(1);
 -- Ensure we see just the xy_1 row.
 execute ab_q6(100);
 
+-- Ensure only the partitions surviving initial pruning get locked.
+prepare ab_q7 (int, int) as
+select a from ab where a = $1 and b = $2;
+execute ab_q7 (1, 1);
+begin;
+execute ab_q7 (2, 3);
+select relation::regclass from pg_locks
+  where pid = pg_backend_pid() and relation::regclass::text like 'ab%'
+  order by relation::regclass::text;
+commit;
+
 reset enable_bitmapscan;
 reset enable_indexscan;
 reset plan_cache_mode;
@@ -581,6 +592,7 @@ deallocate ab_q3;
 deallocate ab_q4;
 deallocate ab_q5;
 deallocate ab_q6;
+deallocate ab_q7;
 
 -- UPDATE on a partition subtree has been seen to have problems.
 insert into ab values (1,2);
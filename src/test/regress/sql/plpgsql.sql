@@ -4679,3 +4679,23 @@ BEGIN
   GET DIAGNOSTICS x = ROW_COUNT;
   RETURN;
 END; $$ LANGUAGE plpgsql;
+
+--
+-- Simple expressions must notice replacement of an inlined SQL function,
+-- even when evaluated again in the same transaction
+--
+create function simple_inlined(int) returns int
+  as 'select $1 + 1' language sql immutable;
+create function simple_caller(int) returns int as $$
+begin
+  return simple_inlined($1);
+end; $$ language plpgsql;
+begin;
+select simple_caller(1), simple_caller(2);
+create or replace function simple_inlined(int) returns int
+  as 'select $1 * 10' language sql immutable;
+select simple_caller(1), simple_caller(2);
+commit;
+select simple_caller(3);
+drop function simple_caller(int);
+drop function simple_inlined(int);
@@ -25,6 +25,19 @@ select substring('asd TO foo' from ' TO (([a-z0-9._]+|"([^"]+|"")+")+)');
 select substring('a' from '((a))+');
 select substring('a' from '((a)+)');
 
+-- Test patterns that can be matched without running the regex engine
+select 'abcdef' ~ 'cde' as t;
+select 'abcdef' ~ 'ced' as f;
+select 'abcabd' ~ 'abd' as t;
+select 'abc' ~ '' as t;
+select 'abc' ~ '^ab(c|d)$' as t;
+select 'xabc' ~ '^ab(c|d)$' as f;
+select E'x\nabc' ~ '^ab' as f;
+select E'x\nabc' ~ '(?n)^ab' as t;
+select E'x\nabc' ~ '(?w)^ab' as t;
+select E'x\nabc' ~ '(?p)^ab' as f;
+select E'x\nabc' ~ '***:(?n)^ab' as t;
+
 -- Test regexp_match()
 select regexp_match('abc', '');
 select regexp_match('abc', 'bc');
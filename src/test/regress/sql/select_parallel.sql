@@ -385,6 +385,10 @@ SET LOCAL force_parallel_mode = 1;
 select stringu1::int2 from tenk1 where unique1 = 1;
 ROLLBACK TO SAVEPOINT settings;
 
+-- test a parallel scan of a CTE, which the leader materializes
+with c as (select unique1, two from tenk1)
+  select count(*), sum(unique1) from c where two = 1;
+
 -- test interaction with set-returning functions
 SAVEPOINT settings;
 
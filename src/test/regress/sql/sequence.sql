@@ -404,5 +404,11 @@ CREATE SEQUENCE test_seq1 CACHE 10;
 SELECT nextval('test_seq1');
 SELECT nextval('test_seq1');
 SELECT nextval('test_seq1');
+-- cached values are shared, so they survive DISCARD
+DISCARD SEQUENCES;
+SELECT nextval('test_seq1');
+-- but setval discards them
+SELECT setval('test_seq1', 20);
+SELECT nextval('test_seq1');
 
 DROP SEQUENCE test_seq1;
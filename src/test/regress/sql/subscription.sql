@@ -90,6 +90,10 @@ RESET ROLE;
 ALTER SUBSCRIPTION testsub RENAME TO testsub_foo;
 ALTER SUBSCRIPTION testsub_foo SET (synchronous_commit = local);
 ALTER SUBSCRIPTION testsub_foo SET (synchronous_commit = foobar);
+ALTER SUBSCRIPTION testsub_foo SET (streaming = true);
+ALTER SUBSCRIPTION testsub_foo SET (streaming = foobar);
+ALTER SUBSCRIPTION testsub_foo SET (binary = true);
+ALTER SUBSCRIPTION testsub_foo SET (binary = foobar);
 
 \dRs+
 
@@ -26,6 +26,13 @@ select count(*) > 0 as ok from pg_hba_file_rules;
 -- There will surely be at least one active lock
 select count(*) > 0 as ok from pg_locks;
 
+-- Some LWLocks have surely been taken since startup
+select count(*) > 0 as ok from pg_stat_lwlocks;
+
+-- Client backends have surely found some blocks in shared buffers
+select sum(hits) > 0 as ok from pg_stat_io
+  where backend_type = 'client backend';
+
 -- We expect no prepared statements in this test; see also prepare.sql
 select count(*) = 0 as ok from pg_prepared_statements;
 
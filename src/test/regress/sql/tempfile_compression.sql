@@ -0,0 +1,54 @@
+--
+-- Compression of temporary files
+--
+set temp_file_compression = on;
+set work_mem = '64kB';
+-- make the sorts below read the tables rather than use their indexes
+set enable_indexscan = off;
+set enable_bitmapscan = off;
+
+-- external sort, checked for order
+select count(*) from
+(select thousand, lag(thousand) over () as lthousand,
+        tenthous, lag(tenthous) over () as ltenthous
+   from (select * from tenk1 order by thousand, tenthous) s) ss
+where row(thousand, tenthous) <= row(lthousand, ltenthous);
+
+-- random access to a sorted result on disk
+begin;
+declare tfc_cur scroll cursor for select unique1 from tenk1 order by unique1;
+fetch absolute 5000 from tfc_cur;
+fetch backward 2 from tfc_cur;
+fetch last from tfc_cur;
+fetch absolute 1 from tfc_cur;
+commit;
+
+-- hash join and hash aggregation in several batches
+set enable_mergejoin = off;
+set enable_nestloop = off;
+select count(*), sum(a.unique2) from tenk1 a join tenk1 b using (unique1);
+reset enable_mergejoin;
+reset enable_nestloop;
+set enable_sort = off;
+select count(*), sum(unique2) from (select unique1, min(unique2) as unique2
+  from tenk1 group by unique1) s;
+reset enable_sort;
+
+-- CLUSTER using an external sort
+create table tfc_clstr as select * from tenk1;
+create index tfc_clstr_sort on tfc_clstr (hundred, thousand, tenthous);
+set maintenance_work_mem = '1MB';
+cluster tfc_clstr using tfc_clstr_sort;
+select * from
+(select hundred, lag(hundred) over () as lhundred,
+        thousand, lag(thousand) over () as lthousand,
+        tenthous, lag(tenthous) over () as ltenthous from tfc_clstr) ss
+where row(hundred, thousand, tenthous) <= row(lhundred, lthousand, ltenthous);
+select count(*) from tfc_clstr;
+reset maintenance_work_mem;
+
+drop table tfc_clstr;
+reset enable_indexscan;
+reset enable_bitmapscan;
+reset work_mem;
+reset temp_file_compression;
@@ -2118,3 +2118,75 @@ drop table self_ref;
 drop function dump_insert();
 drop function dump_update();
 drop function dump_delete();
+
+--
+-- AFTER trigger events are written out to a temporary file once the queue
+-- outgrows work_mem
+--
+create table spill_tab (a int, b text);
+create table spill_log (op text, a int, old_a int);
+create function spill_log_trig() returns trigger language plpgsql as
+$$
+begin
+  if tg_op = 'INSERT' then
+    insert into spill_log values (tg_op, new.a, null);
+  elsif tg_op = 'UPDATE' then
+    insert into spill_log values (tg_op, new.a, old.a);
+  else
+    insert into spill_log values (tg_op, null, old.a);
+  end if;
+  return null;
+end
+$$;
+create trigger spill_tab_trig after insert or update on spill_tab
+  for each row execute procedure spill_log_trig();
+set work_mem = '64kB';
+
+insert into spill_tab select g, 'row ' || g from generate_series(1, 20000) g;
+update spill_tab set a = a + 1;
+select op, count(*), sum(a) as sum_a, sum(old_a) as sum_old_a
+  from spill_log group by op order by op;
+
+-- deferred events, queued by several statements and fired at commit
+truncate spill_log;
+create constraint trigger spill_tab_deferred after update on spill_tab
+  deferrable initially deferred
+  for each row execute procedure spill_log_trig();
+begin;
+update spill_tab set b = 'first';
+update spill_tab set b = 'second' where a % 2 = 0;
+select count(*) from spill_log;
+commit;
+select count(*) from spill_log;
+
+-- deferred foreign key checks
+create table spill_pk (a int primary key);
+create table spill_fk (a int references spill_pk deferrable initially deferred);
+insert into spill_pk select generate_series(1, 20000);
+begin;
+insert into spill_fk select generate_series(1, 20000);
+insert into spill_fk values (20001);
+insert into spill_fk select generate_series(1, 20000);
+commit;
+select count(*) from spill_fk;
+begin;
+insert into spill_fk select generate_series(1, 20000);
+insert into spill_fk values (20001);
+insert into spill_pk values (20001);
+commit;
+select count(*) from spill_fk;
+
+-- events queued while the queue is being fired, by cascaded deletes
+truncate spill_log;
+delete from spill_fk;
+create table spill_fk2 (a int references spill_pk on delete cascade);
+create trigger spill_fk2_trig after delete on spill_fk2
+  for each row execute procedure spill_log_trig();
+insert into spill_fk2 select generate_series(1, 20000);
+delete from spill_pk;
+select op, count(*), sum(old_a) from spill_log group by op;
+select count(*) from spill_fk2;
+
+reset work_mem;
+drop table spill_tab, spill_log, spill_fk, spill_fk2, spill_pk;
+drop function spill_log_trig();
@@ -0,0 +1,77 @@
+--
+-- Page-at-a-time evaluation of simple sequential scan quals
+--
+
+-- Columns of each supported type, with NULLs, NaNs and varlena columns
+-- in front that must be skipped over correctly when gathering a column.
+create table vscan_tbl (id int, t text, i2 int2, i4 int4, i8 int8,
+                        f4 float4, f8 float8, t2 text);
+insert into vscan_tbl
+  select g,
+         case when g % 7 = 0 then null
+              when g % 500 = 0 then repeat('y', 3000)
+              else repeat('x', g % 50) end,
+         case when g % 11 = 0 then null else (g % 100)::int2 end,
+         case when g % 13 = 0 then null else g % 1000 end,
+         case when g % 17 = 0 then null else g::int8 * 1000000 end,
+         case when g % 19 = 0 then null else (g % 500) / 4.0 end,
+         case when g % 23 = 0 then null
+              when g % 29 = 0 then 'NaN'
+              else g / 3.0 end,
+         'row ' || g
+  from generate_series(1, 5000) g;
+-- leave some dead tuples behind on every page
+delete from vscan_tbl where id % 10 = 3;
+
+-- Run a query with and without the feature, and count the rows that differ.
+create function vscan_compare(query text) returns bigint
+language plpgsql as
+$$
+declare
+    n bigint;
+begin
+    perform set_config('enable_vectorized_scan', 'on', true);
+    execute 'create temp table vscan_on as ' || query;
+    perform set_config('enable_vectorized_scan', 'off', true);
+    execute 'create temp table vscan_off as ' || query;
+    select count(*) into n from
+      ((table vscan_on except all table vscan_off)
+       union all
+       (table vscan_off except all table vscan_on)) s;
+    drop table vscan_on;
+    drop table vscan_off;
+    return n;
+end;
+$$;
+
+select vscan_compare('select * from vscan_tbl where i2 = 42');
+select vscan_compare('select * from vscan_tbl where i4 < 100');
+select vscan_compare('select * from vscan_tbl where 100 > i4');
+select vscan_compare('select * from vscan_tbl where i4 < 100::int8');
+select vscan_compare('select * from vscan_tbl where i8 >= 4000000000');
+select vscan_compare('select * from vscan_tbl where f4 <= 10.5');
+select vscan_compare('select * from vscan_tbl where f8 <> 5');
+select vscan_compare('select * from vscan_tbl where f8 > 1000');
+select vscan_compare('select id, t2 from vscan_tbl
+  where i4 between 100 and 200 and f8 > 100 and t like ''x%''');
+
+set enable_vectorized_scan = on;
+select count(*) from vscan_tbl where i2 = 42;
+select count(*) from vscan_tbl where i4 < 100;
+select count(*) from vscan_tbl where 100 > i4;
+select count(*) from vscan_tbl where i8 >= 4000000000;
+select count(*) from vscan_tbl where f4 <= 10.5;
+select count(*) from vscan_tbl where f8 <> 5;
+select count(*) from vscan_tbl where f8 > 1000;
+select count(*) from vscan_tbl
+  where i4 between 100 and 200 and f8 > 100 and t like 'x%';
+
+-- LIMIT stops the scan in the middle of a page
+select id, t2 from vscan_tbl where i4 > 990 limit 5;
+select id, length(t) from vscan_tbl where i4 = 500 and i2 = 0 limit 3;
+reset enable_vectorized_scan;
+select id, t2 from vscan_tbl where i4 > 990 limit 5;
+select id, length(t) from vscan_tbl where i4 = 500 and i2 = 0 limit 3;
+
+drop function vscan_compare(text);
+drop table vscan_tbl;
@@ -1039,3 +1039,27 @@ create temp table test (i int);
 with test as (select 42) insert into test select * from test;
 select * from test;
 drop table test;
+
+--
+-- CTE scans reading a tuplestore that has gone to disk, with several
+-- readers at different positions and rescans
+--
+set work_mem = '64kB';
+with w as (select unique1, ten, stringu1 from tenk1)
+select count(*), sum(a.unique1) from w a join w b using (unique1);
+with w as (select unique1, ten, stringu1 from tenk1)
+select t.ten,
+       (select count(*) from w where w.ten = t.ten) as cnt,
+       (select max(unique1) from w where w.ten = t.ten) as max
+  from (select distinct ten from tenk1) t order by 1;
+with recursive r(n) as (select 1 union all select n + 1 from r where n < 20000)
+select count(*), sum(n) from r;
+begin;
+declare w_cur scroll cursor for
+  with w as (select unique1 from tenk1 order by unique1) select * from w;
+fetch last from w_cur;
+fetch backward 3 from w_cur;
+fetch absolute 2 from w_cur;
+fetch relative 5000 from w_cur;
+commit;
+reset work_mem;
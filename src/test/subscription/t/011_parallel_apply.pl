@@ -0,0 +1,138 @@
+# Test parallel apply, mixed with large transactions that get streamed
+use strict;
+use warnings;
+use PostgresNode;
+use TestLib;
+use Test::More tests => 6;
+
+# setup
+
+my $node_publisher = get_new_node('publisher');
+$node_publisher->init(allows_streaming => 'logical');
+$node_publisher->append_conf('postgresql.conf',
+	'logical_decoding_work_mem = 64kB');
+$node_publisher->start;
+
+my $node_subscriber = get_new_node('subscriber');
+$node_subscriber->init(allows_streaming => 'logical');
+$node_subscriber->append_conf(
+	'postgresql.conf', qq(
+max_parallel_apply_workers_per_subscription = 2
+max_logical_replication_workers = 8
+max_worker_processes = 16
+));
+$node_subscriber->start;
+
+my $publisher_connstr = $node_publisher->connstr . ' dbname=postgres';
+
+$node_publisher->safe_psql('postgres',
+	"CREATE TABLE test_tab (a int PRIMARY KEY, b text)");
+$node_publisher->safe_psql('postgres',
+	"CREATE TABLE test_tab2 (a int PRIMARY KEY)");
+
+$node_subscriber->safe_psql('postgres',
+	"CREATE TABLE test_tab (a int PRIMARY KEY, b text)");
+$node_subscriber->safe_psql('postgres',
+	"CREATE TABLE test_tab2 (a int PRIMARY KEY)");
+
+$node_publisher->safe_psql('postgres',
+	"CREATE PUBLICATION tap_pub FOR TABLE test_tab, test_tab2");
+$node_subscriber->safe_psql('postgres',
+	"CREATE SUBSCRIPTION tap_sub CONNECTION '$publisher_connstr application_name=tap_sub' PUBLICATION tap_pub WITH (streaming = on)"
+);
+
+# Wait for initial sync
+my $synced_query =
+  "SELECT count(1) = 0 FROM pg_subscription_rel WHERE srsubstate NOT IN ('r', 's');";
+$node_subscriber->poll_query_until('postgres', $synced_query)
+  or die "Timed out while waiting for subscriber to synchronize data";
+
+my $compare_query =
+  "SELECT count(*), md5(string_agg(a::text || ':' || b, ',' ORDER BY a)) FROM test_tab";
+
+# Many small transactions, each one handed over to a parallel apply worker.
+# psql runs each statement in a transaction of its own.
+my $sql = '';
+$sql .= "INSERT INTO test_tab VALUES ($_, 'small $_');\n" foreach (1 .. 100);
+$sql .= "INSERT INTO test_tab2 VALUES ($_);\n" foreach (1 .. 100);
+$node_publisher->safe_psql('postgres', $sql);
+
+$node_subscriber->poll_query_until('postgres',
+	"SELECT count(*) >= 2 FROM pg_stat_activity WHERE backend_type = 'logical replication worker'"
+) or die "Timed out while waiting for parallel apply workers to start";
+
+# A transaction far larger than logical_decoding_work_mem is streamed before
+# it commits.  It touches rows written by the small transactions before it,
+# and the small transactions after it touch its rows, so the order in which
+# they are applied matters.
+$sql = qq{
+BEGIN;
+INSERT INTO test_tab SELECT i, repeat('x', 100) FROM generate_series(101, 10100) i;
+UPDATE test_tab SET b = 'updated by large ' || a WHERE a <= 50;
+SAVEPOINT s1;
+DELETE FROM test_tab WHERE a % 10 = 0;
+ROLLBACK TO s1;
+DELETE FROM test_tab WHERE a % 10 = 5;
+COMMIT;
+};
+$sql .= "UPDATE test_tab SET b = 'after large $_' WHERE a = $_ * 97;\n"
+  foreach (1 .. 100);
+$sql .= "DELETE FROM test_tab2 WHERE a = $_;\n" foreach (1 .. 50);
+$node_publisher->safe_psql('postgres', $sql);
+
+$node_publisher->wait_for_catchup('tap_sub');
+
+my $expected = $node_publisher->safe_psql('postgres', $compare_query);
+my $result = $node_subscriber->safe_psql('postgres', $compare_query);
+is($result, $expected, 'large streamed transaction applied in order');
+
+$result = $node_subscriber->safe_psql('postgres',
+	"SELECT count(*), min(a), max(a) FROM test_tab2");
+is($result, qq(50|51|100), 'small transactions applied');
+
+# A large transaction that is rolled back after being streamed leaves no
+# trace, and those committed around it are still applied.
+$sql = qq{
+INSERT INTO test_tab2 VALUES (1);
+BEGIN;
+INSERT INTO test_tab SELECT i, repeat('y', 100) FROM generate_series(20001, 30000) i;
+DELETE FROM test_tab WHERE a <= 1000;
+ROLLBACK;
+INSERT INTO test_tab2 VALUES (2);
+};
+$node_publisher->safe_psql('postgres', $sql);
+
+$node_publisher->wait_for_catchup('tap_sub');
+
+$result = $node_subscriber->safe_psql('postgres', $compare_query);
+is($result, $expected, 'aborted streamed transaction not applied');
+
+$result = $node_subscriber->safe_psql('postgres',
+	"SELECT count(*), min(a), max(a) FROM test_tab2");
+is($result, qq(52|1|100), 'transactions around aborted one applied');
+
+# Two large transactions committed one after the other, the second one
+# changing every row the first one inserted.
+$sql = qq{
+BEGIN;
+INSERT INTO test_tab SELECT i, repeat('z', 100) FROM generate_series(40001, 50000) i;
+COMMIT;
+BEGIN;
+UPDATE test_tab SET b = 'second ' || a WHERE a > 40000;
+DELETE FROM test_tab2;
+COMMIT;
+};
+$node_publisher->safe_psql('postgres', $sql);
+
+$node_publisher->wait_for_catchup('tap_sub');
+
+$expected = $node_publisher->safe_psql('postgres', $compare_query);
+$result = $node_subscriber->safe_psql('postgres', $compare_query);
+is($result, $expected, 'consecutive streamed transactions applied');
+
+$result =
+  $node_subscriber->safe_psql('postgres', "SELECT count(*) FROM test_tab2");
+is($result, qq(0), 'consecutive streamed transactions applied');
+
+$node_subscriber->stop('fast');
+$node_publisher->stop('fast');